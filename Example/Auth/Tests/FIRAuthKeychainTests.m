@@ -217,6 +217,25 @@ static NSError *fakeError() {
   XCTAssertNil([self passwordWithAccount:kKey service:nil]);
 }
 
+/** @fn testReadCachedData
+    @brief Tests that reads are served from the data last read or written through the instance.
+ */
+- (void)testReadCachedData {
+  [self setPassword:kData account:accountFromKey(kKey) service:kService];
+  FIRAuthKeychain *keychain = [[FIRAuthKeychain alloc] initWithService:kService];
+  XCTAssertEqualObjects([keychain dataForKey:kKey error:NULL], dataFromString(kData));
+  // Changes made behind the instance's back are not seen, since all writes go through it.
+  [self setPassword:kOtherData account:accountFromKey(kKey) service:kService];
+  NSError *error = fakeError();
+  XCTAssertEqualObjects([keychain dataForKey:kKey error:&error], dataFromString(kData));
+  XCTAssertNil(error);
+
+  XCTAssertTrue([keychain setData:dataFromString(kOtherData) forKey:kKey error:NULL]);
+  XCTAssertEqualObjects([keychain dataForKey:kKey error:NULL], dataFromString(kOtherData));
+  XCTAssertTrue([keychain removeDataForKey:kKey error:NULL]);
+  XCTAssertNil([keychain dataForKey:kKey error:NULL]);
+}
+
 /** @fn testNullErrorParameter
     @brief Tests that 'NULL' can be safely passed in.
  */
@@ -1740,6 +1740,32 @@ static const NSTimeInterval kWaitInterval = .5;
   OCMVerifyAll(_mockBackend);
 }
 
+/** @fn testConcurrentTokenRefreshesShareOneRequest
+    @brief Tests that concurrent forced token refreshes are served by a single secureToken RPC.
+ */
+- (void)testConcurrentTokenRefreshesShareOneRequest {
+  [[FIRAuth auth] signOut:NULL];
+  [self waitForSignIn];
+
+  // Only one secureToken RPC is expected; a second one would fulfill the expectation twice.
+  [self mockSecureTokenResponseWithError:nil];
+
+  static const NSUInteger kConcurrentRefreshes = 3;
+  for (NSUInteger i = 0; i < kConcurrentRefreshes; i++) {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"callback"];
+    [[FIRAuth auth].app getTokenForcingRefresh:YES withCallback:^(NSString *_Nullable token,
+                                                                   NSError *_Nullable error) {
+      XCTAssertTrue([NSThread isMainThread]);
+      XCTAssertEqualObjects(token, kNewAccessToken);
+      XCTAssertNil(error);
+      [expectation fulfill];
+    }];
+  }
+  [self waitForExpectationsWithTimeout:kExpectationTimeout handler:nil];
+  XCTAssertEqualObjects(kNewAccessToken, [FIRAuth auth].currentUser.rawAccessToken);
+  OCMVerifyAll(_mockBackend);
+}
+
 #if TARGET_OS_IOS
 /** @fn testAutomaticTokenRefreshInvalidTokenFailure
     @brief Tests that app foreground notification triggers the scheduling of an automatic token
@@ -51,6 +51,9 @@
     self.closed = YES;
 }
 
+- (void)flush {
+}
+
 - (void)saveUserOverwrite:(id<FNode>)node atPath:(FPath *)path writeId:(NSUInteger)writeId {
     FWriteRecord *writeRecord = [[FWriteRecord alloc] initWithPath:path overwrite:node writeId:writeId visible:YES];
     self.userWritesDict[@(writeId)] = writeRecord;
@@ -113,6 +116,14 @@
     return [NSJSONSerialization dataWithJSONObject:data options:0 error:nil].length;
 }
 
+- (NSUInteger)serverCacheEstimatedSizeInBytesAtPath:(FPath *)path {
+    id data = [[self serverCacheAtPath:path] valForExport:YES];
+    if (data == nil || data == [NSNull null]) {
+        return 0;
+    }
+    return [NSJSONSerialization dataWithJSONObject:@[data] options:0 error:nil].length;
+}
+
 - (void)pruneCache:(FPruneForest *)pruneForest atPath:(FPath *)prunePath {
     [self.serverCache enumerateWrites:^(FPath *absolutePath, id<FNode> node, BOOL *stop) {
         NSAssert([prunePath isEqual:absolutePath] || ![absolutePath contains:prunePath], @"Pruning at %@ but we found data higher up!", prunePath);
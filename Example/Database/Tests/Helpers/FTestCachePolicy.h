@@ -24,4 +24,7 @@
 
 - (void)pruneOnNextCheck;
 
+// Returned from bytesToPruneFromCacheWithSize:, 0 by default
+@property (nonatomic) NSUInteger bytesToPrune;
+
 @end
@@ -62,4 +62,8 @@
     return self.maxTrackedQueries;
 }
 
+- (NSUInteger)bytesToPruneFromCacheWithSize:(NSUInteger)cacheSize {
+    return self.bytesToPrune;
+}
+
 @end
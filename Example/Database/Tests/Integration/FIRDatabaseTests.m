@@ -437,6 +437,73 @@ static NSString *kFirebaseTestAltNamespace = @"https://foobar.firebaseio.com";
     [database goOffline];
 }
 
+- (void) testCoalesceQueuedOverwrites {
+    id app = [[FIRFakeApp alloc] initWithName:@"testCoalesceQueuedOverwrites" URL:self.databaseURL];
+    FIRDatabase *database = [FIRDatabase databaseForApp:app];
+    XCTAssertFalse(database.coalesceQueuedOverwrites);
+    database.coalesceQueuedOverwrites = YES;
+    XCTAssertTrue(database.coalesceQueuedOverwrites);
+
+    [database reference];  // Initialize database.
+
+    XCTAssertThrows([database setCoalesceQueuedOverwrites:NO],
+                    @"Coalescing can't be changed after initialization.");
+    XCTAssertTrue(database.coalesceQueuedOverwrites);
+    [database goOffline];
+}
+
+- (void) testCoalescedOverwritesCompleteInOrder {
+    id app = [[FIRFakeApp alloc] initWithName:@"testCoalescedOverwritesCompleteInOrder" URL:self.databaseURL];
+    FIRDatabase *database = [FIRDatabase databaseForApp:app];
+    database.coalesceQueuedOverwrites = YES;
+    FIRDatabaseReference *ref = [database.reference childByAutoId];
+
+    // A second client sees only what reaches the server.
+    FIRDatabase *otherDatabase = [self databaseForURL:self.databaseURL name:@"coalescedOverwritesObserver"];
+    FIRDatabaseReference *otherRef = [[otherDatabase reference] child:ref.key];
+    NSMutableArray *seen = [NSMutableArray array];
+    [[otherRef child:@"a"] observeEventType:FIRDataEventTypeValue withBlock:^(FIRDataSnapshot *snapshot) {
+        [seen addObject:snapshot.value];
+    }];
+    [self waitForValueOf:otherRef toBe:[NSNull null]];
+
+    [database goOffline];
+
+    NSMutableArray *order = [NSMutableArray array];
+    [[ref child:@"a"] setValue:@1 withCompletionBlock:^(NSError *error, FIRDatabaseReference *ref) {
+        XCTAssertNil(error);
+        [order addObject:@"1"];
+    }];
+    [[ref child:@"a"] setValue:@2 withCompletionBlock:^(NSError *error, FIRDatabaseReference *ref) {
+        XCTAssertNil(error);
+        [order addObject:@"2"];
+    }];
+    [[ref child:@"b"] setValue:@"x" withCompletionBlock:^(NSError *error, FIRDatabaseReference *ref) {
+        XCTAssertNil(error);
+        [order addObject:@"x"];
+    }];
+    [[ref child:@"a"] setValue:@3 withCompletionBlock:^(NSError *error, FIRDatabaseReference *ref) {
+        XCTAssertNil(error);
+        [order addObject:@"3"];
+    }];
+    [[ref child:@"a"] setValue:@4 withCompletionBlock:^(NSError *error, FIRDatabaseReference *ref) {
+        XCTAssertNil(error);
+        [order addObject:@"4"];
+    }];
+
+    [database goOnline];
+    WAIT_FOR(order.count == 5);
+
+    // The write to b sits between the writes to a, so only 1 and 2, and 3 and 4, are combined.
+    XCTAssertEqualObjects(order, (@[@"1", @"2", @"x", @"3", @"4"]));
+    [self waitForValueOf:otherRef toBe:(@{@"a" : @4, @"b" : @"x"})];
+    XCTAssertFalse([seen containsObject:@1]);
+    XCTAssertFalse([seen containsObject:@3]);
+
+    [database goOffline];
+    [otherDatabase goOffline];
+}
+
 - (FIRDatabase *) defaultDatabase {
     return [self databaseForURL:self.databaseURL];
 }
@@ -445,6 +445,35 @@
     }
 }
 
+- (void)testLookupsAndInsertsInShuffledOrder {
+    int N = SORTED_DICTIONARY_ARRAY_TO_RB_TREE_SIZE_THRESHOLD;
+    NSMutableArray* toInsert = [[NSMutableArray alloc] initWithCapacity:N];
+    for(int i = 0; i < N; i++) {
+        [toInsert addObject:[NSNumber numberWithInt:i * 2]];
+    }
+    [self shuffleArray:toInsert];
+
+    FImmutableSortedDictionary *dict = [FImmutableSortedDictionary dictionaryWithComparator:[self defaultComparator]];
+    for(int i = 0; i < N; i++) {
+        dict = [dict insertKey:toInsert[i] withValue:toInsert[i]];
+    }
+    XCTAssertTrue([dict isKindOfClass:[FArraySortedDictionary class]]);
+
+    for(int i = 0; i < N; i++) {
+        XCTAssertEqualObjects([dict get:@(i * 2)], @(i * 2));
+        XCTAssertNil([dict get:@(i * 2 + 1)]);
+        XCTAssertEqualObjects([[dict keyEnumeratorFrom:@(i * 2 - 1)] nextObject], @(i * 2));
+    }
+    XCTAssertNil([dict get:@(-1)]);
+
+    // Replacing a value with itself leaves the dictionary as it is
+    XCTAssertEqual([dict insertKey:@4 withValue:[dict get:@4]], dict);
+    FImmutableSortedDictionary *updated = [dict insertKey:@4 withValue:@"four"];
+    XCTAssertEqualObjects([updated get:@4], @"four");
+    XCTAssertEqualObjects([dict get:@4], @4);
+    XCTAssertEqual(updated.count, dict.count);
+}
+
 - (void)testConversionToTreeMap {
     int N = SORTED_DICTIONARY_ARRAY_TO_RB_TREE_SIZE_THRESHOLD + 5;
     NSMutableArray* toInsert = [[NSMutableArray alloc] initWithCapacity:N];
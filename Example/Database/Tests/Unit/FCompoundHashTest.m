@@ -21,6 +21,13 @@
 #import "FEmptyNode.h"
 #import "FStringUtilities.h"
 #import "FEmptyNode.h"
+#import "FSnapshotUtilities.h"
+
+@interface FCompoundHashBuilder (Testing)
+
+- (NSUInteger)currentHashLength;
+
+@end
 
 @interface FCompoundHashTest : XCTestCase
 
@@ -108,6 +115,41 @@ static FCompoundHashSplitStrategy NEVER_SPLIT_STRATEGY = ^BOOL(FCompoundHashBuil
     XCTAssertEqualObjects(hash.hashes, (@[expectedHash, @""]));
 }
 
+- (void)testCachedRepresentationsDontChangeDefaultSplit {
+    NSMutableDictionary *dict = [NSMutableDictionary dictionary];
+    for (int i = 0; i < 300; i++) {
+        NSMutableDictionary *child = [NSMutableDictionary dictionary];
+        for (int j = 0; j < i % 20; j++) {
+            child[[NSString stringWithFormat:@"leaf-%d", j]] = j % 2 == 0 ? @"value" : @(j);
+        }
+        child[@".priority"] = @(i);
+        child[@"nested"] = @{@"deeper": @{@"value": @YES}};
+        dict[[NSString stringWithFormat:@"%d", i]] = child;
+    }
+    id<FNode> node = NODE(dict);
+
+    // The same strategy as the default one, but opaque to the builder so that it has to process every leaf
+    FCompoundHashSplitStrategy (^sizeStrategy)(id<FNode>) = ^FCompoundHashSplitStrategy(id<FNode> forNode) {
+        NSUInteger threshold = MAX(512, (NSUInteger)sqrt([FSnapshotUtilities estimateSerializedNodeSize:forNode] * 100));
+        return ^BOOL(FCompoundHashBuilder *builder) {
+            return [builder currentHashLength] > threshold && ![[[builder currentPath] getBack] isEqualToString:@".priority"];
+        };
+    };
+
+    FCompoundHash *expected = [FCompoundHash fromNode:node splitStrategy:sizeStrategy(node)];
+    FCompoundHash *actual = [FCompoundHash fromNode:node];
+    XCTAssertGreaterThan(actual.hashes.count, 2);
+    XCTAssertEqualObjects(actual.posts, expected.posts);
+    XCTAssertEqualObjects(actual.hashes, expected.hashes);
+
+    // Most of the updated node shares its cached representations with the previous one
+    node = [node updateChild:PATH(@"150/nested/deeper/value") withNewChild:NODE(@NO)];
+    expected = [FCompoundHash fromNode:node splitStrategy:sizeStrategy(node)];
+    actual = [FCompoundHash fromNode:node];
+    XCTAssertEqualObjects(actual.posts, expected.posts);
+    XCTAssertEqualObjects(actual.hashes, expected.hashes);
+}
+
 - (void)testDefaultSplitHasSensibleAmountOfHashes {
     NSMutableDictionary *dict = [NSMutableDictionary dictionary];
     for (int i = 0; i < 500; i++) {
@@ -138,4 +180,22 @@ static FCompoundHashSplitStrategy NEVER_SPLIT_STRATEGY = ^BOOL(FCompoundHashBuil
     XCTAssertEqualWithAccuracy(hash1M.hashes.count, 150, 10);
 }
 
+- (void)testSplitThresholdScaleChangesRangeSize {
+    NSMutableDictionary *dict = [NSMutableDictionary dictionary];
+    for (int i = 0; i < 5000; i++) {
+        // roughly 15-20 bytes serialized per node, 100k total
+        dict[[NSString stringWithFormat:@"%d", i]] = @"value";
+    }
+    id<FNode> node = NODE(dict);
+
+    FCompoundHash *defaultHash = [FCompoundHash fromNode:node];
+    XCTAssertEqualObjects([FCompoundHash fromNode:node splitThresholdScale:1.0].hashes, defaultHash.hashes);
+
+    FCompoundHash *coarse = [FCompoundHash fromNode:node splitThresholdScale:4.0];
+    FCompoundHash *fine = [FCompoundHash fromNode:node splitThresholdScale:0.25];
+    XCTAssertEqualWithAccuracy(coarse.hashes.count, defaultHash.hashes.count / 4, 3);
+    XCTAssertEqualWithAccuracy(fine.hashes.count, defaultHash.hashes.count * 4, 20);
+    XCTAssertEqual(coarse.posts.count + 1, coarse.hashes.count);
+}
+
 @end
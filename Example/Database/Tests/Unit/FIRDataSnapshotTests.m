@@ -435,6 +435,26 @@
     XCTAssertEqualObjects(node, [node updateImmediateChild:@".priority" withNewChild:[FEmptyNode emptyNode]], @"Update should not affect node.");
 }
 
+- (void) testIndexedNodeKeepsIndexAcrossFirstIndexedChild {
+    id<FIndex> index = [[FPathIndex alloc] initWithPath:PATH(@"order")];
+    id<FNode> node = NODE((@{@"b": @{@"x": @1}, @"c": @{@"x": @2}, @"d": @{@"order": @1}}));
+    FIndexedNode *indexed = [FIndexedNode indexedNodeWithNode:[node updateImmediateChild:@"d" withNewChild:[FEmptyNode emptyNode]] index:index];
+    XCTAssertEqualObjects(indexed.firstChild.name, @"b");
+
+    indexed = [indexed updateChild:@"a" withNewChild:NODE(@{@"order": @2})];
+    indexed = [indexed updateChild:@"d" withNewChild:NODE(@{@"order": @1})];
+    NSMutableArray *keys = [NSMutableArray array];
+    [indexed enumerateChildrenReverse:NO usingBlock:^(NSString *key, id<FNode> child, BOOL *stop) {
+        [keys addObject:key];
+    }];
+    XCTAssertEqualObjects(keys, (@[@"b", @"c", @"d", @"a"]));
+
+    // A second indexed node for the same node and index sees the same order
+    FIndexedNode *other = [FIndexedNode indexedNodeWithNode:indexed.node index:index];
+    XCTAssertEqualObjects(other.lastChild.name, @"a");
+    XCTAssertEqualObjects(other.firstChild.name, @"b");
+}
+
 /* This was reported by a customer, which broke because 유주연 > 윤규완오빠 but also 윤규완오빠 > 유주연  with the default
  * string comparison... */
 - (void)testUnicodeEquality {
@@ -361,6 +361,67 @@
     XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], outer);
 }
 
+- (void)testLargeNodeCanBeUpdatedPiecewise {
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+
+    // Enough leaves that some children are stored in rows of their own
+    NSMutableDictionary *data = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < 500; i++) {
+        NSString *key = [NSString stringWithFormat:@"key-%lu", (unsigned long)i];
+        data[key] = @{@"index": @(i), @"name": key};
+    }
+    NSMutableDictionary *large = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < 1500; i++) {
+        large[[NSString stringWithFormat:@"leaf-%lu", (unsigned long)i]] = @(i);
+    }
+    data[@"large"] = large;
+    id<FNode> node = NODE(data);
+    [engine updateServerCache:node atPath:PATH(@"foo") merge:NO];
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], node);
+
+    [engine updateServerCache:NODE(@"replaced") atPath:PATH(@"foo/key-1") merge:NO];
+    [engine updateServerCache:NODE(nil) atPath:PATH(@"foo/key-2") merge:NO];
+    [engine updateServerCache:NODE(@"changed") atPath:PATH(@"foo/large/leaf-7") merge:NO];
+    FCompoundWrite *merge = [FCompoundWrite compoundWriteWithValueDictionary:@{@"key-3/name": @"merged", @"new": @YES}];
+    [engine updateServerCacheWithMerge:merge atPath:PATH(@"foo")];
+
+    id<FNode> expected = [[[[[node updateChild:PATH(@"key-1") withNewChild:NODE(@"replaced")]
+                             updateChild:PATH(@"key-2") withNewChild:[FEmptyNode emptyNode]]
+                            updateChild:PATH(@"large/leaf-7") withNewChild:NODE(@"changed")]
+                           updateChild:PATH(@"key-3/name") withNewChild:NODE(@"merged")]
+                          updateChild:PATH(@"new") withNewChild:NODE(@YES)];
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], expected);
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo/key-2")], [FEmptyNode emptyNode]);
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo/key-3")], [expected getChild:PATH(@"key-3")]);
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo/large/leaf-8")], NODE(@8));
+
+    NSSet *keys = [NSSet setWithObjects:@"key-1", @"key-2", @"key-4", @"large", nil];
+    id<FNode> expectedKeys = [[[[FEmptyNode emptyNode]
+                                updateImmediateChild:@"key-1" withNewChild:NODE(@"replaced")]
+                               updateImmediateChild:@"key-4" withNewChild:[expected getImmediateChild:@"key-4"]]
+                              updateImmediateChild:@"large" withNewChild:[expected getImmediateChild:@"large"]];
+    XCTAssertEqualObjects([engine serverCacheForKeys:keys atPath:PATH(@"foo")], expectedKeys);
+}
+
+- (void)testServerCacheForKeysReadsChildrenStoredInTheirOwnRows {
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+
+    // Large enough that each child is stored in rows of its own, with keys that sort differently as row keys
+    NSMutableDictionary *large = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < 1100; i++) {
+        large[[NSString stringWithFormat:@"leaf-%lu", (unsigned long)i]] = @(i);
+    }
+    NSDictionary *data = @{@"a": large, @"a0": large, @"a-b": large, @"b": @{@"c": large}, @"small": @"value"};
+    [engine updateServerCache:NODE(data) atPath:PATH(@"foo") merge:NO];
+
+    NSSet *keys = [NSSet setWithObjects:@"b", @"a-b", @"missing", @"a", @"small", nil];
+    id<FNode> expected = [FEmptyNode emptyNode];
+    for (NSString *key in @[@"a", @"a-b", @"b", @"small"]) {
+        expected = [expected updateImmediateChild:key withNewChild:NODE(data[key])];
+    }
+    XCTAssertEqualObjects([engine serverCacheForKeys:keys atPath:PATH(@"foo")], expected);
+}
+
 - (void)testPriorityWorks {
     FLevelDBStorageEngine *engine = [self cleanStorageEngine];
 
@@ -436,19 +497,33 @@
 // Well this is awkward, but NSJSONSerialization fails to deserialize JSON with tiny/huge doubles
 // It is kind of bad we raise "invalid" data, but at least we don't crash *trollface*
 - (void)testExtremeDoublesAsServerCache {
-#ifdef TARGET_OS_IOS
-    if ([[NSProcessInfo processInfo] operatingSystemVersion].majorVersion == 11) {
-        // NSJSONSerialization on iOS 11 correctly serializes small and large doubles.
-        return;
-    }
-#endif
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    [engine updateServerCache:NODE((@{@"works": @"value", @"tiny": @(2.225073858507201e-308), @"huge": @(1.7976931348623157e308)})) atPath:PATH(@"foo") merge:NO];
+
+    // The server cache doesn't go through JSON, so these read back exactly
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], NODE((@{@"works": @"value", @"tiny": @(2.225073858507201e-308), @"huge": @(1.7976931348623157e308)})));
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo/tiny")], NODE(@(2.225073858507201e-308)));
+}
 
+- (void)testLeafValuesRoundTripThroughServerCache {
     FLevelDBStorageEngine *engine = [self cleanStorageEngine];
-    [engine updateServerCache:NODE((@{@"works": @"value", @"fails": @(2.225073858507201e-308)})) atPath:PATH(@"foo") merge:NO];
+    NSDictionary *data = @{@"true": @YES,
+                           @"false": @NO,
+                           @"zero": @0,
+                           @"negative": @(-42),
+                           @"max": @(LLONG_MAX),
+                           @"min": @(LLONG_MIN),
+                           @"double": @2.47,
+                           @"empty": @"",
+                           @"unicode": @"\u00fc\U0001F600end",
+                           @"nested": @{@"deeper": @{@"value": @1.5}, @".priority": @"p"}};
+    [engine updateServerCache:NODE(data) atPath:PATH(@"foo") merge:NO];
 
-    // Will drop the tiny double
-    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], NODE(@{@"works": @"value"}));
-    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo/fails")], [FEmptyNode emptyNode]);
+    id<FNode> node = [engine serverCacheAtPath:PATH(@"foo")];
+    XCTAssertEqualObjects(node, NODE(data));
+    XCTAssertEqualObjects([[node getChild:PATH(@"true")] val], @YES);
+    XCTAssertEqualObjects([[node getChild:PATH(@"double")] val], @2.47);
+    XCTAssertEqualObjects([[node getChild:PATH(@"max")] val], @(LLONG_MAX));
 }
 
 - (void)testExtremeDoublesAsTrackedQuery {
@@ -571,6 +646,22 @@
     XCTAssertEqualObjects([engine loadTrackedQueries], @[second]);
 }
 
+- (void)testTrackedQueriesArePersistedWhenEngineCloses {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"test-db"];
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    FTrackedQuery *query1 = [[FTrackedQuery alloc] initWithId:1 query:[FQuerySpec defaultQueryAtPath:PATH(@"a")] lastUse:100 isActive:NO isComplete:NO];
+    FTrackedQuery *query2 = [[FTrackedQuery alloc] initWithId:2 query:[FQuerySpec defaultQueryAtPath:PATH(@"b")] lastUse:200 isActive:YES isComplete:NO];
+    [engine saveTrackedQuery:query1];
+    [engine saveTrackedQuery:query2];
+    [engine updateServerCache:SAMPLE_NODE atPath:PATH(@"a") merge:NO];
+    [engine saveTrackedQuery:[query2 setActiveState:NO]];
+    [engine close];
+
+    engine = [[FLevelDBStorageEngine alloc] initWithPath:path];
+    XCTAssertEqualObjects([engine loadTrackedQueries], (@[query1, [query2 setActiveState:NO]]));
+    [engine close];
+}
+
 - (void)testDeleteTrackedQuery {
     FLevelDBStorageEngine *engine = [self cleanStorageEngine];
     FTrackedQuery *query1 = [[FTrackedQuery alloc] initWithId:1 query:[FQuerySpec defaultQueryAtPath:PATH(@"a")] lastUse:100 isActive:NO isComplete:NO];
@@ -610,6 +701,32 @@
     XCTAssertEqualObjects([engine trackedQueryKeysForQuery:1], ([NSSet setWithArray:@[@"c", @"d", @"e"]]));
 }
 
+- (void)testUpdateManyTrackedQueryKeys {
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    NSMutableSet *keys = [NSMutableSet set];
+    for (int i = 0; i < 1000; i++) {
+        [keys addObject:[NSString stringWithFormat:@"key-%d", i]];
+    }
+    [engine setTrackedQueryKeys:keys forQueryId:1];
+    [engine setTrackedQueryKeys:[NSSet setWithArray:@[@"other"]] forQueryId:10];
+    XCTAssertEqualObjects([engine trackedQueryKeysForQuery:1], keys);
+
+    NSMutableSet *added = [NSMutableSet setWithArray:@[@"a-before-everything", @"zz-after-everything", @"\u2601"]];
+    NSMutableSet *removed = [NSMutableSet set];
+    for (int i = 0; i < 1000; i += 3) {
+        [added addObject:[NSString stringWithFormat:@"key-%d-new", i]];
+        [removed addObject:[NSString stringWithFormat:@"key-%d", i]];
+    }
+    [engine updateTrackedQueryKeysWithAddedKeys:added removedKeys:removed forQueryId:1];
+    [keys minusSet:removed];
+    [keys unionSet:added];
+    XCTAssertEqualObjects([engine trackedQueryKeysForQuery:1], keys);
+
+    [engine setTrackedQueryKeys:[NSSet setWithArray:@[@"key-1", @"key-2-new"]] forQueryId:1];
+    XCTAssertEqualObjects([engine trackedQueryKeysForQuery:1], ([NSSet setWithArray:@[@"key-1", @"key-2-new"]]));
+    XCTAssertEqualObjects([engine trackedQueryKeysForQuery:10], [NSSet setWithArray:@[@"other"]]);
+}
+
 - (void)testRemoveTrackedQueryRemovesTrackedQueryKeys {
     FLevelDBStorageEngine *engine = [self cleanStorageEngine];
     FTrackedQuery *query1 = [[FTrackedQuery alloc] initWithId:1 query:[FQuerySpec defaultQueryAtPath:PATH(@"a")] lastUse:100 isActive:NO isComplete:NO];
@@ -108,6 +108,22 @@
     XCTAssertFalse([[nodeOne updateImmediateChild:@"one" withNewChild:[FSnapshotUtilities nodeFrom:@2]] isEqual:nodeOne]);
 }
 
+- (void)testHashesOfUpdatedNodesMatchNewNodes {
+    id<FNode> node = [FSnapshotUtilities nodeFrom:@{ @"a": @{ @"aa": @1, @"ab": @"two" }, @"b": @{ @".value": @3, @".priority": @1 }}];
+    NSString *dataHash = [node dataHash];
+    NSUInteger hash = node.hash;
+    XCTAssertTrue([node dataHash] == dataHash, @"dataHash should be cached");
+    XCTAssertEqual(node.hash, hash);
+
+    // The children keep their cached hashes, which must not leak into the updated parent
+    id<FNode> updated = [node updateChild:[[FPath alloc] initWith:@"a/ab"] withNewChild:[FSnapshotUtilities nodeFrom:@"three"]];
+    id<FNode> expected = [FSnapshotUtilities nodeFrom:@{ @"a": @{ @"aa": @1, @"ab": @"three" }, @"b": @{ @".value": @3, @".priority": @1 }}];
+    XCTAssertEqualObjects([updated dataHash], [expected dataHash]);
+    XCTAssertEqual(updated.hash, expected.hash);
+    XCTAssertNotEqualObjects([updated dataHash], dataHash);
+    XCTAssertEqualObjects([node dataHash], dataHash);
+}
+
 - (void)testLeadingZerosWorkCorrectly {
     NSDictionary *data = @{ @"1": @1, @"01": @2, @"001": @3, @"0001": @4 };
 
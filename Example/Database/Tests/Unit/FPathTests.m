@@ -59,6 +59,21 @@
     XCTAssertNil([[[[[[FPath alloc] initWith:@"/a/b/c"] parent] parent] parent] parent], @"should be correct");
 }
 
+- (void)testPathsSharingPieces
+{
+    FPath *path = [[FPath alloc] initWith:@"/a/b/c/d"];
+    FPath *middle = [[path popFront] parent];
+    XCTAssertEqualObjects(middle, [[FPath alloc] initWith:@"/b/c"]);
+    XCTAssertEqual(middle.hash, [[FPath alloc] initWith:@"/b/c"].hash);
+    XCTAssertEqualObjects([middle toString], @"/b/c");
+    XCTAssertEqualObjects([middle getBack], @"c");
+    XCTAssertEqualObjects([middle childFromString:@"e"], [[FPath alloc] initWith:@"/b/c/e"]);
+    XCTAssertEqualObjects([middle child:[[path popFront] popFront]], [[FPath alloc] initWith:@"/b/c/c/d"]);
+    XCTAssertEqualObjects([FPath relativePathFrom:[path parent] to:path], [[FPath alloc] initWith:@"/d"]);
+    XCTAssertTrue([middle contains:[[path popFront] childFromString:@"e"]]);
+    XCTAssertFalse([[path parent] isEqual:path]);
+}
+
 - (void)testWireFormat
 {
     XCTAssertEqualObjects(@"/", [[FPath empty] wireFormat]);
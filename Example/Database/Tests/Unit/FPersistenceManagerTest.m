@@ -24,6 +24,7 @@
 #import "FPathIndex.h"
 #import "FIndexedNode.h"
 #import "FEmptyNode.h"
+#import "FWriteRecord.h"
 
 @interface FPersistenceManagerTest : XCTestCase
 
@@ -103,4 +104,27 @@
     XCTAssertEqualObjects(actual, expected);
 }
 
+- (void)testCompactedUserWritesDropsWritesReplacedByLaterOverwrites {
+    FMockStorageEngine *engine = [[FMockStorageEngine alloc] init];
+    FPersistenceManager *manager = [[FPersistenceManager alloc] initWithStorageEngine:engine
+                                                                          cachePolicy:[FNoCachePolicy noCachePolicy]];
+
+    FCompoundWrite *merge = [FCompoundWrite compoundWriteWithValueDictionary:@{@"baz": @"baz"}];
+    [manager saveUserOverwrite:NODE(@"first") atPath:PATH(@"foo/bar") writeId:1];
+    [manager saveUserMerge:merge atPath:PATH(@"foo/bar") writeId:2];
+    [manager saveUserOverwrite:NODE(@"other") atPath:PATH(@"other") writeId:3];
+    [manager saveUserOverwrite:NODE(@"child") atPath:PATH(@"foo/qux/child") writeId:4];
+    [manager saveUserOverwrite:NODE((@{@"bar": @"bar"})) atPath:PATH(@"foo") writeId:5];
+    [manager saveUserOverwrite:NODE(@"child") atPath:PATH(@"foo/bar/child") writeId:6];
+
+    NSArray *expected = @[
+        [[FWriteRecord alloc] initWithPath:PATH(@"other") overwrite:NODE(@"other") writeId:3 visible:YES],
+        [[FWriteRecord alloc] initWithPath:PATH(@"foo") overwrite:NODE((@{@"bar": @"bar"})) writeId:5 visible:YES],
+        [[FWriteRecord alloc] initWithPath:PATH(@"foo/bar/child") overwrite:NODE(@"child") writeId:6 visible:YES]
+    ];
+    XCTAssertEqualObjects([manager compactedUserWrites], expected);
+    // The replaced writes are gone from storage too
+    XCTAssertEqualObjects([manager userWrites], expected);
+}
+
 @end
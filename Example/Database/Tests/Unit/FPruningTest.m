@@ -290,4 +290,27 @@ static id<FNode> LARGE_NODE = nil;
     }];
 }
 
+// Write abc at /x, prune /x/a via PruneForest for root, at /x/a
+- (void)test230 {
+    [self runWithDb:^(id<FStorageEngine> engine) {
+        [engine updateServerCache:ABC_NODE atPath:PATH(@"x") merge:NO];
+        [engine pruneCache:[self prune:@""] atPath:PATH(@"x/a")];
+        XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"x")], BC_NODE);
+    }];
+}
+
+// Write abc at /x and large nodes at /x/a/aa, /x/b and /x/c, prune /x except a/aa and c via PruneForest for /x, at root
+- (void)test240 {
+    [self runWithDb:^(id<FStorageEngine> engine) {
+        [engine updateServerCache:ABC_NODE atPath:PATH(@"x") merge:NO];
+        [engine updateServerCache:LARGE_NODE atPath:PATH(@"x/a/aa") merge:NO];
+        [engine updateServerCache:LARGE_NODE atPath:PATH(@"x/b") merge:NO];
+        [engine updateServerCache:LARGE_NODE atPath:PATH(@"x/c") merge:NO];
+        [engine pruneCache:[self prune:@"x" exceptRelative:@[@"a/aa", @"c"]] atPath:PATH(@"")];
+        id<FNode> expected = [[[FEmptyNode emptyNode] updateChild:PATH(@"a/aa") withNewChild:LARGE_NODE]
+                                 updateImmediateChild:@"c" withNewChild:LARGE_NODE];
+        XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"x")], expected);
+    }];
+}
+
 @end
@@ -18,6 +18,8 @@
 #import <XCTest/XCTest.h>
 
 #import "FQueryParams.h"
+#import "FQuerySpec.h"
+#import "FPath.h"
 #import "FIndex.h"
 #import "FPriorityIndex.h"
 #import "FValueIndex.h"
@@ -141,6 +143,31 @@
     XCTAssertEqual(params2.hash, [FQueryParams fromQueryObject:params3.wireProtocolParams].hash);
 }
 
+- (void)testDerivedParamsDontShareCachedHash {
+    FQueryParams *params = [[FQueryParams defaultInstance] limitTo:10];
+    NSUInteger hash = params.hash;
+    FQueryParams *derived = [params startAt:[FSnapshotUtilities nodeFrom:@"value"]];
+    FQueryParams *same = [[[FQueryParams defaultInstance] limitTo:10] startAt:[FSnapshotUtilities nodeFrom:@"value"]];
+    XCTAssertEqual(params.hash, hash);
+    XCTAssertFalse([params isEqual:derived]);
+    XCTAssertEqualObjects(derived, same);
+    XCTAssertEqual(derived.hash, same.hash);
+}
+
+- (void)testQuerySpecEquals {
+    FQueryParams *params = [[FQueryParams defaultInstance] limitTo:10];
+    FQuerySpec *spec1 = [[FQuerySpec alloc] initWithPath:[[FPath alloc] initWith:@"a/b"] params:params];
+    FQuerySpec *spec2 = [[FQuerySpec alloc] initWithPath:[[FPath alloc] initWith:@"a/b"]
+                                                  params:[[FQueryParams defaultInstance] limitTo:10]];
+    FQuerySpec *spec3 = [[FQuerySpec alloc] initWithPath:[[FPath alloc] initWith:@"a/c"] params:params];
+    FQuerySpec *spec4 = [[FQuerySpec alloc] initWithPath:[[FPath alloc] initWith:@"a/b"]
+                                                  params:[FQueryParams defaultInstance]];
+    XCTAssertEqualObjects(spec1, spec2);
+    XCTAssertEqual(spec1.hash, spec2.hash);
+    XCTAssertFalse([spec1 isEqual:spec3]);
+    XCTAssertFalse([spec1 isEqual:spec4]);
+}
+
 - (void)testStartAtNullIsSerializable {
     FQueryParams *params = [FQueryParams defaultInstance];
     params = [params startAt:[FEmptyNode emptyNode] childKey:@"key"];
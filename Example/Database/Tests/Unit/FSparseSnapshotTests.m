@@ -204,4 +204,23 @@
     XCTAssertFalse(safeToRemove, @"Should not have deleted anything, nothing to remove");
 }
 
+- (void) testDeepPathsUnderAndAboveRememberedData {
+    FSparseSnapshotTree* st = [[FSparseSnapshotTree alloc] init];
+    [st rememberData:NODE(@"log") onPath:PATH(@"users/uid/devices/did/logs/1")];
+    [st rememberData:NODE(@{@"name": @"phone"}) onPath:PATH(@"users/uid/devices/other")];
+    [st rememberData:NODE(@"tablet") onPath:PATH(@"users/uid/devices/other/name")];
+
+    XCTAssertEqualObjects([[st findPath:PATH(@"users/uid/devices/did/logs/1")] val], @"log");
+    XCTAssertEqualObjects([[st findPath:PATH(@"users/uid/devices/other/name")] val], @"tablet");
+    XCTAssertNil([st findPath:PATH(@"users/uid/devices/did/logs/2")]);
+    XCTAssertNil([st findPath:PATH(@"users/uid/devices")]);
+
+    NSMutableDictionary* seen = [NSMutableDictionary dictionary];
+    [st forEachTreeAtPath:PATH(@"root") do:^(FPath *path, id<FNode> data) {
+        seen[[path toString]] = [data val];
+    }];
+    XCTAssertEqualObjects(seen, (@{@"/root/users/uid/devices/did/logs/1": @"log",
+                                   @"/root/users/uid/devices/other": @{@"name": @"tablet"}}));
+}
+
 @end
@@ -27,6 +27,8 @@
 #import "FPriorityIndex.h"
 #import "FIRDatabaseQuery_Private.h"
 #import "FSyncTree.h"
+#import "FWriteTree.h"
+#import "FTestHelpers.h"
 #import "FChange.h"
 #import "FDataEvent.h"
 #import "FIRDataSnapshot_Private.h"
@@ -85,8 +87,9 @@ typedef NSDictionary* (^fbt_nsdictionary_void)(void);
     }
 }
 
-- (void) fireEvent:(id<FEvent>)event queue:(dispatch_queue_t)queue {
+- (fbt_void_void) callbackForEvent:(id<FEvent>)event {
     [NSException raise:@"NotImplementedError" format:@"Method not implemneted."];
+    return nil;
 }
 - (FCancelEvent *) createCancelEventFromError:(NSError *)error path:(FPath *)path {
     [NSException raise:@"NotImplementedError" format:@"Method not implemneted."];
@@ -905,4 +908,29 @@ typedef NSDictionary* (^fbt_nsdictionary_void)(void);
     [self runTestForName:@"Deep update raises all events"];
 }
 
+- (void) testRemovingWritesRelayersOverlappingWrites {
+    FWriteTree *writeTree = [[FWriteTree alloc] init];
+    [writeTree addOverwriteAtPath:PATH(@"a") newData:NODE((@{@"x": @1, @"y": @2})) writeId:0 isVisible:YES];
+    FCompoundWrite *merge = [FCompoundWrite compoundWriteWithValueDictionary:@{@"a/y": @3, @"b": @4}];
+    [writeTree addMergeAtPath:[FPath empty] changedChildren:merge writeId:1];
+    [writeTree addOverwriteAtPath:PATH(@"a/x") newData:NODE(@5) writeId:2 isVisible:YES];
+    [writeTree addOverwriteAtPath:PATH(@"c/z") newData:NODE(@6) writeId:3 isVisible:YES];
+    [writeTree addOverwriteAtPath:PATH(@"c") newData:NODE(@7) writeId:4 isVisible:YES];
+
+    XCTAssertTrue([writeTree removeWriteId:0]);
+    XCTAssertNil([writeTree shadowingWriteAtPath:PATH(@"a")]);
+    XCTAssertEqualObjects([writeTree shadowingWriteAtPath:PATH(@"a/x")], NODE(@5));
+    XCTAssertEqualObjects([writeTree shadowingWriteAtPath:PATH(@"a/y")], NODE(@3));
+    XCTAssertEqualObjects([writeTree shadowingWriteAtPath:PATH(@"b")], NODE(@4));
+
+    XCTAssertTrue([writeTree removeWriteId:1]);
+    XCTAssertNil([writeTree shadowingWriteAtPath:PATH(@"a/y")]);
+    XCTAssertNil([writeTree shadowingWriteAtPath:PATH(@"b")]);
+    XCTAssertEqualObjects([writeTree shadowingWriteAtPath:PATH(@"a/x")], NODE(@5));
+
+    // The write to c/z is completely shadowed by the later write to c.
+    XCTAssertFalse([writeTree removeWriteId:3]);
+    XCTAssertEqualObjects([writeTree shadowingWriteAtPath:PATH(@"c")], NODE(@7));
+}
+
 @end
@@ -251,6 +251,32 @@
               pathsToPrune:@[@"0", @"1", @"2", @"3", @"4", @"5"]];
 }
 
+- (void) testPruneQueriesBySizeFreesOnlyRequestedBytes {
+    FTestClock *clock = [[FTestClock alloc] init];
+    FMockStorageEngine *engine = [[FMockStorageEngine alloc] init];
+    FTrackedQueryManager *manager = [[FTrackedQueryManager alloc] initWithStorageEngine:engine clock:clock];
+
+    NSString *big = [@"" stringByPaddingToLength:1000 withString:@"x" startingAtIndex:0];
+    NSDictionary *data = @{@"small": @"x", @"medium": [big substringToIndex:200], @"big1": big, @"big2": big};
+    for (NSString *key in @[@"small", @"medium", @"big1", @"big2"]) {
+        [engine updateServerCache:NODE(data[key]) atPath:PATH(key) merge:NO];
+        [manager setQueryActive:[FQuerySpec defaultQueryAtPath:PATH(key)]];
+        [manager setQueryInactive:[FQuerySpec defaultQueryAtPath:PATH(key)]];
+        [clock tick];
+    }
+
+    // The oldest queries are the smallest, but pruning one large query frees enough
+    FTestCachePolicy *policy = [[FTestCachePolicy alloc] initWithPercent:1.0 maxQueries:NSUIntegerMax];
+    policy.bytesToPrune = 500;
+    FPruneForest *forest = [manager pruneOldQueries:policy cacheSize:2300];
+    XCTAssertTrue([forest prunesAnything]);
+    XCTAssertEqual([manager numberOfPrunableQueries], 3);
+    XCTAssertNil([manager findTrackedQuery:[FQuerySpec defaultQueryAtPath:PATH(@"big1")]]);
+    XCTAssertNotNil([manager findTrackedQuery:[FQuerySpec defaultQueryAtPath:PATH(@"big2")]]);
+    XCTAssertNotNil([manager findTrackedQuery:[FQuerySpec defaultQueryAtPath:PATH(@"small")]]);
+    XCTAssertNotNil([manager findTrackedQuery:[FQuerySpec defaultQueryAtPath:PATH(@"medium")]]);
+}
+
 - (void)checkPruneForest:(FPruneForest *)pruneForest pathsToKeep:(NSArray *)toKeep pathsToPrune:(NSArray *)toPrune {
     FPruneForest *checkForest = [FPruneForest empty];
     for (NSString *path in toPrune) {
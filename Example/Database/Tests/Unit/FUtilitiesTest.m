@@ -22,6 +22,7 @@
 #import "FIRDatabaseConfig_Private.h"
 #import "FWebSocketConnection.h"
 #import "FConstants.h"
+#import "FNextPushId.h"
 
 @interface FWebSocketConnection (Tests)
 - (NSString*)userAgent;
@@ -86,6 +87,25 @@
 
 }
 
+- (void)testSplittingUTF8DataKeepsCharactersWhole {
+    NSString *string = @"ab\u00fc\u2601\U0001F600cd";
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    NSArray *ranges = [FUtilities rangesSplittingUTF8Data:data intoMaxSize:4];
+
+    NSMutableString *joined = [NSMutableString string];
+    for (NSValue *range in ranges) {
+        XCTAssertLessThanOrEqual([range rangeValue].length, 4);
+        NSString *segment = [[NSString alloc] initWithData:[data subdataWithRange:[range rangeValue]]
+                                                  encoding:NSUTF8StringEncoding];
+        XCTAssertNotNil(segment);
+        [joined appendString:segment];
+    }
+    XCTAssertEqualObjects(joined, string);
+    XCTAssertEqual(ranges.count, 4);
+
+    XCTAssertEqualObjects([FUtilities rangesSplittingUTF8Data:[NSData data] intoMaxSize:4], @[]);
+}
+
 - (void)testKeyComparison {
     NSArray *order = @[
       @"-2147483648", @"0", @"1", @"2", @"10", @"2147483647", // Treated as integers
@@ -112,4 +132,31 @@
   XCTAssertNotEqual([FUtilities compareKey:@"윤규완오빠" toKey:@"유주연"], NSOrderedSame);
 }
 
+- (void)testPushIdsAreUniqueAndOrderedAcrossThreads {
+  NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+  NSMutableArray *batches = [NSMutableArray array];
+  for (int i = 0; i < 8; i++) {
+    [batches addObject:[NSNull null]];
+  }
+  dispatch_apply(batches.count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+    NSArray *ids = [FNextPushId get:now count:100];
+    @synchronized(batches) {
+      batches[i] = ids;
+    }
+  });
+
+  NSMutableSet *allIds = [NSMutableSet set];
+  for (NSArray *ids in batches) {
+    for (NSUInteger i = 0; i < ids.count; i++) {
+      XCTAssertEqual([ids[i] length], 20);
+      if (i > 0) {
+        XCTAssertEqual([ids[i - 1] compare:ids[i]], NSOrderedAscending);
+      }
+    }
+    [allIds addObjectsFromArray:ids];
+  }
+  XCTAssertEqual(allIds.count, 800);
+  XCTAssertEqual([[FNextPushId get:now] compare:[FNextPushId get:now]], NSOrderedAscending);
+}
+
 @end
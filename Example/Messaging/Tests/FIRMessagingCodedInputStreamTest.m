@@ -76,6 +76,23 @@
   XCTAssertNil([stream readDataWithLength:length]);
 }
 
+- (void)testReadingDataWithoutCopying {
+  NSData *sampleData = [[self class] sampleData2];
+  FIRMessagingCodedInputStream *stream =
+      [[FIRMessagingCodedInputStream alloc] initWithData:sampleData];
+  int8_t tag;
+  XCTAssertTrue([stream readTag:&tag]);
+  int32_t length;
+  XCTAssertTrue([stream readLength:&length]);
+
+  NSData *data = [stream readDataNoCopyWithLength:length];
+  XCTAssertTrue([[[self class] packetDataForSampleData2] isEqualToData:data]);
+  // The packet data points into the stream's buffer, just past the tag and length
+  XCTAssertEqual(data.bytes, (const uint8_t *)sampleData.bytes + 3);
+  XCTAssertEqual(stream.offset, sampleData.length);
+  XCTAssertNil([stream readDataNoCopyWithLength:1]);
+}
+
 + (NSData *)sampleData1 {
   // tag = 2,
   // length = 4,
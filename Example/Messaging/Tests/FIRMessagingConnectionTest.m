@@ -86,6 +86,11 @@ static FIRMessagingProtoTag currentProtoSendTag;
 - (void)connectToSocket:(FIRMessagingSecureSocket *)socket;
 - (NSTimeInterval)connectionTimeoutInterval;
 - (void)sendHeartbeatPing;
++ (NSString *)heartbeatIntervalKeyForNetworkType:(int32_t)networkType;
++ (int32_t)currentNetworkType;
+- (NSTimeInterval)heartbeatInterval;
+- (void)heartbeatSurvivedIdleTime:(NSTimeInterval)idleTime;
+- (void)heartbeatTimedOut;
 
 @end
 
@@ -365,6 +370,33 @@ static FIRMessagingProtoTag currentProtoSendTag;
   XCTAssertTrue(self.didSuccessfullySendData);
 }
 
+- (void)testHeartbeatIntervalAdaptsToIdleHeartbeats {
+  NSString *key = [FIRMessagingConnection
+      heartbeatIntervalKeyForNetworkType:[FIRMessagingConnection currentNetworkType]];
+  [[NSUserDefaults standardUserDefaults] removeObjectForKey:key];
+  [self setupSuccessfulLoginRequestWithConnection:self.fakeConnection];
+  NSTimeInterval initialInterval = self.fakeConnection.heartbeatInterval;
+
+  // Heartbeats sent while the connection was busy don't stretch the interval.
+  for (int i = 0; i < 5; i++) {
+    [self.fakeConnection heartbeatSurvivedIdleTime:0];
+  }
+  XCTAssertEqual(self.fakeConnection.heartbeatInterval, initialInterval);
+
+  for (int i = 0; i < 3; i++) {
+    [self.fakeConnection heartbeatSurvivedIdleTime:self.fakeConnection.heartbeatInterval];
+  }
+  NSTimeInterval grownInterval = self.fakeConnection.heartbeatInterval;
+  XCTAssertGreaterThan(grownInterval, initialInterval);
+  XCTAssertEqual([[NSUserDefaults standardUserDefaults] doubleForKey:key], grownInterval);
+
+  [self.fakeConnection heartbeatTimedOut];
+  XCTAssertLessThan(self.fakeConnection.heartbeatInterval, grownInterval);
+  XCTAssertGreaterThanOrEqual(self.fakeConnection.heartbeatInterval, initialInterval);
+
+  [[NSUserDefaults standardUserDefaults] removeObjectForKey:key];
+}
+
 // TODO: Add tests for Selective/Stream ACK's
 
 #pragma mark - Stubs
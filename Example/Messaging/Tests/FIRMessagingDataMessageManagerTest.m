@@ -403,6 +403,27 @@ static NSString *const kRmqDatabaseName = @"gcm-dmm-test";
   OCMVerifyAll(self.mockReceiver);
 }
 
+- (void)testSendDelayedMessage_sentWithNextUrgentMessage {
+  [[[self.mockClient stub] andReturnValue:OCMOCK_VALUE(YES)] isConnectionActive];
+  [self.dataMessageManager setDeviceAuthID:@"auth-id" secretToken:@"secret-token"];
+  [self addFakeFIRMessagingRegistrationToken];
+
+  // the delayed message is sent first, on its way out with the urgent one
+  NSMutableArray *sentMessageIDs = [NSMutableArray array];
+  OCMStub([self.mockClient sendMessage:[OCMArg checkWithBlock:^BOOL(id obj) {
+    [sentMessageIDs addObject:((GtalkDataMessageStanza *)obj).id_p];
+    return YES;
+  }]]);
+
+  NSMutableDictionary *delayedMessage = [self upstreamMessageWithID:@"1" ttl:0 delay:1];
+  [self.dataMessageManager sendDataMessageStanza:delayedMessage];
+  XCTAssertEqual(sentMessageIDs.count, 0);
+
+  NSMutableDictionary *urgentMessage = [self upstreamMessageWithID:@"2" ttl:0 delay:0];
+  [self.dataMessageManager sendDataMessageStanza:urgentMessage];
+  XCTAssertEqualObjects(sentMessageIDs, (@[ @"1", @"2" ]));
+}
+
 - (void)testProcessPacket_withValidPacket {
   GtalkDataMessageStanza *message = [self validDataMessagePacket];
   NSDictionary *parsedMessage = [self.dataMessageManager processPacket:message];
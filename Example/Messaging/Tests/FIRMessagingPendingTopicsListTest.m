@@ -219,6 +219,35 @@ typedef void (^MockDelegateSubscriptionHandler)(NSString *topic,
   [self waitForExpectationsWithTimeout:5.0 handler:nil];
 }
 
+- (void)testCompletionHandlersAreCalledForEachTopicOperation {
+  FIRMessagingPendingTopicsList *pendingTopics = [[FIRMessagingPendingTopicsList alloc] init];
+  pendingTopics.delegate = self.alwaysReadyDelegate;
+
+  self.alwaysReadyDelegate.subscriptionHandler =
+      ^(NSString *topic,
+        FIRMessagingTopicAction action,
+        FIRMessagingTopicOperationCompletion completion) {
+    dispatch_async(dispatch_get_main_queue(), ^{
+      completion(FIRMessagingTopicOperationResultSucceeded, nil);
+    });
+  };
+
+  for (int i = 0; i < 3; i++) {
+    NSString *topic = [NSString stringWithFormat:@"/topics/%d", i];
+    XCTestExpectation *completionExpectation =
+        [self expectationWithDescription:[NSString stringWithFormat:@"%@ completed", topic]];
+    [pendingTopics addOperationForTopic:topic
+                             withAction:FIRMessagingTopicActionSubscribe
+                             completion:^(FIRMessagingTopicOperationResult result, NSError *error) {
+      XCTAssertEqual(result, FIRMessagingTopicOperationResultSucceeded);
+      XCTAssertNil(error);
+      [completionExpectation fulfill];
+    }];
+  }
+
+  [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
 - (void)testAddingTopicToCurrentBatchWhileCurrentBatchTopicsInFlight {
 
   FIRMessagingPendingTopicsList *pendingTopics = [[FIRMessagingPendingTopicsList alloc] init];
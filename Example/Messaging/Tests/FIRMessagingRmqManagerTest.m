@@ -138,6 +138,30 @@ static NSString *const kRmqDataMessageCategory = @"com.google.gcm-rmq-test";
                           }];
 }
 
+/**
+ *  Test that the RMQ-ID is loaded on first use if loadRmqId hasn't been called, so that messages
+ *  saved by a new manager don't reuse RMQ-ID's of the messages already in the RMQ.
+ */
+- (void)testOutgoingRmqLoadsRmqIDOnFirstUse {
+  NSString *from = @"rmq-test";
+  NSError *error;
+  GtalkDataMessageStanza *message1 = [self dataMessageWithMessageID:@"message1"
+                                                               from:from
+                                                               data:nil];
+  XCTAssertTrue([self.rmqManager saveRmqMessage:message1 error:&error]);
+  XCTAssertNil(error);
+  XCTAssertEqual(2, [self maxRmqIDInRmqStoreForD2SMessages]);
+
+  FIRMessagingRmqManager *newRmqManager =
+      [[FIRMessagingRmqManager alloc] initWithDatabaseName:kRmqDatabaseName];
+  GtalkDataMessageStanza *message2 = [self dataMessageWithMessageID:@"message2"
+                                                               from:from
+                                                               data:nil];
+  XCTAssertTrue([newRmqManager saveRmqMessage:message2 error:&error]);
+  XCTAssertNil(error);
+  XCTAssertEqual(4, [self maxRmqIDInRmqStoreForD2SMessages]);
+}
+
 /**
  *  Test that an outgoing message with different properties is correctly saved to the RMQ.
  */
@@ -297,6 +321,43 @@ static NSString *const kRmqDataMessageCategory = @"com.google.gcm-rmq-test";
   XCTAssertNil([self.rmqManager querySyncMessageWithRmqID:rmqID]);
 }
 
+/**
+ *  Test that sync messages already in the store are found by a new RMQ manager, and that
+ *  lookups for unknown messages and updates go through its in-memory cache correctly.
+ */
+- (void)testQueryingSyncMessagesSavedByAnotherManager {
+  int64_t expirationTime = FIRMessagingCurrentTimestampInSeconds() + 100;
+  for (int i = 0; i < 10; i++) {
+    NSString *rmqID = [NSString stringWithFormat:@"sync-%d", i];
+    XCTAssertTrue([self.rmqManager saveSyncMessageWithRmqID:rmqID
+                                             expirationTime:expirationTime
+                                               apnsReceived:YES
+                                                mcsReceived:NO
+                                                      error:nil]);
+  }
+
+  FIRMessagingRmqManager *newRmqManager =
+      [[FIRMessagingRmqManager alloc] initWithDatabaseName:kRmqDatabaseName];
+  for (int i = 0; i < 10; i++) {
+    NSString *rmqID = [NSString stringWithFormat:@"sync-%d", i];
+    FIRMessagingPersistentSyncMessage *persistentMessage =
+        [newRmqManager querySyncMessageWithRmqID:rmqID];
+    XCTAssertEqualObjects(persistentMessage.rmqID, rmqID);
+    XCTAssertEqual(persistentMessage.expirationTime, expirationTime);
+    XCTAssertTrue(persistentMessage.apnsReceived);
+    XCTAssertFalse(persistentMessage.mcsReceived);
+  }
+  XCTAssertNil([newRmqManager querySyncMessageWithRmqID:@"sync-unknown"]);
+
+  XCTAssertTrue([newRmqManager updateSyncMessageViaMCSWithRmqID:@"sync-0" error:nil]);
+  XCTAssertTrue([newRmqManager querySyncMessageWithRmqID:@"sync-0"].mcsReceived);
+
+  // Messages received both ways are deleted, and aren't returned from the cache afterwards
+  XCTAssertEqual([newRmqManager deleteExpiredOrFinishedSyncMessages:nil], 1);
+  XCTAssertNil([newRmqManager querySyncMessageWithRmqID:@"sync-0"]);
+  XCTAssertNotNil([newRmqManager querySyncMessageWithRmqID:@"sync-1"]);
+}
+
 #pragma mark - Private Helpers
 
 - (GtalkDataMessageStanza *)dataMessageWithMessageID:(NSString *)messageID
@@ -332,6 +332,28 @@ NSTimeInterval kFIRStorageIntegrationTestTimeout = 30;
   [self waitForExpectations];
 }
 
+- (void)testUnauthenticatedSimplePutStream {
+  XCTestExpectation *expectation =
+      [self expectationWithDescription:@"testUnauthenticatedSimplePutStream"];
+
+  FIRStorageReference *ref =
+      [self.storage referenceWithPath:@"ios/public/testUnauthenticatedSimplePutStream"];
+
+  NSData *data = [NSData
+      dataWithContentsOfFile:[[NSBundle mainBundle] pathForResource:@"1mb" ofType:@"dat"]];
+  NSInputStream *stream = [NSInputStream inputStreamWithData:data];
+
+  [ref putStream:stream
+        metadata:nil
+      completion:^(FIRStorageMetadata *metadata, NSError *error) {
+        XCTAssertNil(error, "Error should be nil");
+        XCTAssertEqual(metadata.size, (int64_t)data.length);
+        [expectation fulfill];
+      }];
+
+  [self waitForExpectations];
+}
+
 - (void)testUnauthenticatedSimplePutFileNoMetadata {
   XCTestExpectation *expectation =
       [self expectationWithDescription:@"testUnauthenticatedSimplePutFileNoMetadata"];
@@ -389,6 +411,28 @@ NSTimeInterval kFIRStorageIntegrationTestTimeout = 30;
   [self waitForExpectations];
 }
 
+- (void)testUnauthenticatedStreamingGetData {
+  XCTestExpectation *expectation =
+      [self expectationWithDescription:@"testUnauthenticatedStreamingGetData"];
+
+  FIRStorageReference *ref = [self.storage referenceWithPath:@"ios/public/1mb"];
+  NSData *expectedData = [NSData
+      dataWithContentsOfFile:[[NSBundle mainBundle] pathForResource:@"1mb" ofType:@"dat"]];
+  NSMutableData *receivedData = [NSMutableData data];
+
+  [ref dataWithMaxSize:1 * 1024 * 1024
+      dataHandler:^(NSData *data) {
+        [receivedData appendData:data];
+      }
+      completion:^(NSError *error) {
+        XCTAssertNil(error, "Error should be nil");
+        XCTAssertEqualObjects(receivedData, expectedData);
+        [expectation fulfill];
+      }];
+
+  [self waitForExpectations];
+}
+
 - (void)testUnauthenticatedSimpleGetFile {
   XCTestExpectation *expectation =
       [self expectationWithDescription:@"testUnauthenticatedSimpleGetData"];
@@ -431,6 +475,36 @@ NSTimeInterval kFIRStorageIntegrationTestTimeout = 30;
   [self waitForExpectations];
 }
 
+- (void)testChunkedGetFile {
+  XCTestExpectation *expectation = [self expectationWithDescription:@"testChunkedGetFile"];
+
+  self.storage.downloadChunkSize = 256 * 1024;
+  FIRStorageReference *ref = [self.storage referenceWithPath:@"ios/public/1mb"];
+
+  NSURL *tmpDirURL = [NSURL fileURLWithPath:NSTemporaryDirectory()];
+  NSURL *fileURL =
+      [[tmpDirURL URLByAppendingPathComponent:@"chunked"] URLByAppendingPathExtension:@"dat"];
+  NSData *expectedData = [NSData
+      dataWithContentsOfFile:[[NSBundle mainBundle] pathForResource:@"1mb" ofType:@"dat"]];
+
+  FIRStorageDownloadTask *task = [ref writeToFile:fileURL];
+
+  [task observeStatus:FIRStorageTaskStatusSuccess
+              handler:^(FIRStorageTaskSnapshot *snapshot) {
+                XCTAssertEqualObjects([NSData dataWithContentsOfURL:fileURL], expectedData);
+                XCTAssertEqual(snapshot.progress.completedUnitCount, (int64_t)expectedData.length);
+                [expectation fulfill];
+              }];
+
+  [task observeStatus:FIRStorageTaskStatusFailure
+              handler:^(FIRStorageTaskSnapshot *snapshot) {
+                XCTAssertNil(snapshot.error);
+                [expectation fulfill];
+              }];
+
+  [self waitForExpectations];
+}
+
 - (void)testCancelDownload {
   XCTestExpectation *expectation = [self expectationWithDescription:@"testCancelDownload"];
 
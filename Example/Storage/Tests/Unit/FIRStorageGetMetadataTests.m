@@ -14,6 +14,7 @@
 
 #import "FIRStorageGetMetadataTask.h"
 #import "FIRStorageTestHelpers.h"
+#import "FIRStorage_Private.h"
 
 @interface FIRStorageGetMetadataTests : XCTestCase
 
@@ -164,6 +165,42 @@
   [FIRStorageTestHelpers waitForExpectation:self];
 }
 
+- (void)testConcurrentRequestsShareOneFetch {
+  FIRStoragePath *path = [FIRStorageTestHelpers objectPath];
+  __block int completions = 0;
+  FIRStorageVoidMetadataError completion = ^(FIRStorageMetadata *metadata, NSError *error) {
+    XCTAssertEqualObjects(metadata.bucket, @"bucket");
+    completions++;
+  };
+
+  XCTAssertTrue([self.storage beginMetadataRequestForPath:path completion:completion]);
+  XCTAssertFalse([self.storage beginMetadataRequestForPath:path completion:completion]);
+  [self.storage finishMetadataRequestForPath:path metadata:self.metadata error:nil];
+  XCTAssertEqual(completions, 2);
+
+  // Caching is off by default.
+  XCTAssertNil([self.storage cachedMetadataForPath:path]);
+  XCTAssertTrue([self.storage beginMetadataRequestForPath:path completion:completion]);
+}
+
+- (void)testCachedMetadataIsInvalidatedByChanges {
+  FIRStoragePath *path = [FIRStorageTestHelpers objectPath];
+  self.storage.metadataCacheTimeout = 60;
+
+  XCTAssertTrue([self.storage beginMetadataRequestForPath:path completion:nil]);
+  [self.storage finishMetadataRequestForPath:path metadata:self.metadata error:nil];
+  XCTAssertEqualObjects([self.storage cachedMetadataForPath:path].bucket, @"bucket");
+
+  [self.storage invalidateCachedMetadataForPath:path];
+  XCTAssertNil([self.storage cachedMetadataForPath:path]);
+
+  // A fetch that was in flight while the object changed isn't cached either.
+  XCTAssertTrue([self.storage beginMetadataRequestForPath:path completion:nil]);
+  [self.storage invalidateCachedMetadataForPath:path];
+  [self.storage finishMetadataRequestForPath:path metadata:self.metadata error:nil];
+  XCTAssertNil([self.storage cachedMetadataForPath:path]);
+}
+
 - (void)testUnsuccessfulFetchBadJSON {
   XCTestExpectation *expectation =
       [self expectationWithDescription:@"testUnsuccessfulFetchBadJSON"];
@@ -16,6 +16,7 @@
 
 #import "FIRStorageReference.h"
 #import "FIRStorageReference_Private.h"
+#import "FIRStorageTaskScheduler.h"
 #import "FIRStorage_Private.h"
 
 @interface FIRStorageTests : XCTestCase
@@ -210,4 +211,60 @@
   XCTAssertEqual([storage hash], [copy hash]);
 }
 
+- (void)testReferencesInheritTaskPriority {
+  FIRStorage *storage = [FIRStorage storageForApp:self.app];
+  FIRStorageReference *ref = [storage referenceWithPath:@"path/to/object"];
+  XCTAssertEqual(ref.taskPriority, FIRStorageTaskPriorityInteractive);
+  ref.taskPriority = FIRStorageTaskPriorityBackground;
+  XCTAssertEqual([ref child:@"child"].taskPriority, FIRStorageTaskPriorityBackground);
+  XCTAssertEqual(ref.parent.taskPriority, FIRStorageTaskPriorityBackground);
+  XCTAssertEqual(ref.root.taskPriority, FIRStorageTaskPriorityBackground);
+}
+
+- (void)testTaskSchedulerLimitsConcurrentTasks {
+  XCTestExpectation *expectation =
+      [self expectationWithDescription:@"testTaskSchedulerLimitsConcurrentTasks"];
+  FIRStorageTaskScheduler *scheduler = [[FIRStorageTaskScheduler alloc] init];
+  [scheduler setMaxConcurrentTasks:1 forPriority:FIRStorageTaskPriorityBackground];
+
+  id firstTask = OCMClassMock([FIRStorageUploadTask class]);
+  __block FIRStorageVoidSnapshot firstTaskSucceeded;
+  OCMStub([firstTask observeStatus:FIRStorageTaskStatusSuccess
+                           handler:[OCMArg checkWithBlock:^BOOL(id handler) {
+                             firstTaskSucceeded = handler;
+                             return YES;
+                           }]]);
+  id secondTask = OCMClassMock([FIRStorageUploadTask class]);
+  __block BOOL secondTaskStarted = NO;
+  OCMStub([secondTask enqueue]).andDo(^(NSInvocation *invocation) {
+    secondTaskStarted = YES;
+  });
+  id interactiveTask = OCMClassMock([FIRStorageDownloadTask class]);
+
+  [scheduler scheduleTask:firstTask priority:FIRStorageTaskPriorityBackground];
+  [scheduler scheduleTask:secondTask priority:FIRStorageTaskPriorityBackground];
+  [scheduler scheduleTask:interactiveTask priority:FIRStorageTaskPriorityInteractive];
+  OCMVerify([firstTask enqueue]);
+  OCMVerify([interactiveTask enqueue]);
+  XCTAssertFalse(secondTaskStarted);
+
+  firstTaskSucceeded(nil);
+  dispatch_async(dispatch_get_main_queue(), ^{
+    XCTAssertTrue(secondTaskStarted);
+    [expectation fulfill];
+  });
+
+  [FIRStorageTestHelpers waitForExpectation:self];
+}
+
+- (void)testTaskSchedulerHoldsBackPausedPriority {
+  FIRStorageTaskScheduler *scheduler = [[FIRStorageTaskScheduler alloc] init];
+  [scheduler pauseTasksWithPriority:FIRStorageTaskPriorityBackground];
+
+  id task = OCMClassMock([FIRStorageUploadTask class]);
+  [[task reject] enqueue];
+  [scheduler scheduleTask:task priority:FIRStorageTaskPriorityBackground];
+  OCMVerifyAll(task);
+}
+
 @end
@@ -116,6 +116,36 @@
   XCTAssertEqualObjects(encodedURL, @"/v0/b/bucket/o/path%2Fto%2Fobject");
 }
 
+- (void)testUploadChunkSizeTracksThroughput {
+  // 1 MiB/s for the target duration.
+  int64_t chunkSize = [FIRStorageUtils uploadChunkSizeForBytesSent:8 * 1024 * 1024
+                                                          duration:8.0
+                                                     roundTripTime:0.1
+                                                         chunkSize:8 * 1024 * 1024];
+  XCTAssertEqual(chunkSize, 8 * 1024 * 1024);
+
+  // A fast link grows the chunk at most twofold.
+  chunkSize = [FIRStorageUtils uploadChunkSizeForBytesSent:1024 * 1024
+                                                  duration:0.1
+                                             roundTripTime:0.1
+                                                 chunkSize:1024 * 1024];
+  XCTAssertEqual(chunkSize, 2 * 1024 * 1024);
+
+  // A slow link shrinks it, but never below the upload granularity.
+  chunkSize = [FIRStorageUtils uploadChunkSizeForBytesSent:1024 * 1024
+                                                  duration:600.0
+                                             roundTripTime:0.1
+                                                 chunkSize:1024 * 1024];
+  XCTAssertEqual(chunkSize, 256 * 1024);
+
+  // A long round trip asks for longer chunks.
+  chunkSize = [FIRStorageUtils uploadChunkSizeForBytesSent:1024 * 1024
+                                                  duration:4.0
+                                             roundTripTime:1.0
+                                                 chunkSize:4 * 1024 * 1024];
+  XCTAssertEqual(chunkSize, 5 * 1024 * 1024);
+}
+
 - (void)testEncodedURLForNoPath {
   FIRStoragePath *path = [[FIRStoragePath alloc] initWithBucket:@"bucket" object:nil];
   NSString *encodedURL = [FIRStorageUtils encodedURLForPath:path];
@@ -87,8 +87,11 @@ static NSTimeInterval kMaxWaitTimeForBackoff = 16 * 60;
 
 /** @var kTokenRefreshHeadStart
     @brief The amount of time before the token expires that proactive refresh should be attempted.
+    @remarks This is longer than the five minutes before expiry at which @c FIRSecureTokenService
+        stops serving the cached token, so that the refresh completes before any token request has
+        to wait for it.
  */
-NSTimeInterval kTokenRefreshHeadStart  = 5 * 60;
+NSTimeInterval kTokenRefreshHeadStart  = 10 * 60;
 
 /** @var kUserKey
     @brief Key of user stored in the keychain. Prefixed with a Firebase app name.
@@ -1349,8 +1352,8 @@ static NSMutableDictionary *gKeychainServiceNameForAppName;
 
 /** @fn scheduleAutoTokenRefreshWithDelay:
     @brief Schedules a task to automatically refresh tokens on the current user. The token refresh
-        is scheduled 5 minutes before the  scheduled expiration time.
-    @remarks If the token expires in less than 5 minutes, schedule the token refresh immediately.
+        is scheduled 10 minutes before the  scheduled expiration time.
+    @remarks If the token expires in less than 10 minutes, schedule the token refresh immediately.
  */
 - (void)scheduleAutoTokenRefresh {
   NSTimeInterval tokenExpirationInterval =
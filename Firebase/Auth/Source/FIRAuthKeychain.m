@@ -50,6 +50,15 @@ static NSString *const kAccountPrefix = @"firebase_auth_1_";
       @remarks This dictionary is to avoid unecessary keychain operations against legacy items.
    */
   NSMutableDictionary *_legacyEntryDeletedForKey;
+
+  /** @var _cachedDataForKey
+      @brief The data last read from or written to the keychain for a particular key, or
+          @c NSNull if the key is known to have no data.
+      @remarks Keychain queries are slow and may block on securityd. All writes go through this
+          class, so the cache is kept up to date by @c setData:forKey:error: and
+          @c removeDataForKey:error: instead of being re-read.
+   */
+  NSMutableDictionary<NSString *, id> *_cachedDataForKey;
 }
 
 - (id<FIRAuthStorage>)initWithService:(NSString *)service {
@@ -71,6 +80,7 @@ static NSString *const kAccountPrefix = @"firebase_auth_1_";
   if (self) {
     _service = [service copy];
     _legacyEntryDeletedForKey = [[NSMutableDictionary alloc] init];
+    _cachedDataForKey = [[NSMutableDictionary alloc] init];
   }
   return self;
 }
@@ -81,11 +91,19 @@ static NSString *const kAccountPrefix = @"firebase_auth_1_";
                 format:@"%@", @"The key cannot be nil or empty."];
     return nil;
   }
+  id cachedData = _cachedDataForKey[key];
+  if (cachedData) {
+    if (error) {
+      *error = nil;
+    }
+    return cachedData == [NSNull null] ? nil : cachedData;
+  }
   NSData *data = [self itemWithQuery:[self genericPasswordQueryWithKey:key] error:error];
   if (error && *error) {
     return nil;
   }
   if (data) {
+    _cachedDataForKey[key] = data;
     return data;
   }
   // Check for legacy form.
@@ -99,6 +117,7 @@ static NSString *const kAccountPrefix = @"firebase_auth_1_";
   if (!data) {
     // Mark legacy data as non-existing so we don't have to query it again.
     _legacyEntryDeletedForKey[key] = @YES;
+    _cachedDataForKey[key] = [NSNull null];
     return nil;
   }
   // Move the data to current form.
@@ -119,9 +138,15 @@ static NSString *const kAccountPrefix = @"firebase_auth_1_";
     (__bridge id)kSecValueData : data,
     (__bridge id)kSecAttrAccessible : (__bridge id)kSecAttrAccessibleAfterFirstUnlockThisDeviceOnly,
   };
-  return [self setItemWithQuery:[self genericPasswordQueryWithKey:key]
-                     attributes:attributes
-                          error:error];
+  if (![self setItemWithQuery:[self genericPasswordQueryWithKey:key]
+                   attributes:attributes
+                        error:error]) {
+    // The keychain may or may not hold the old data now, read it again next time.
+    [_cachedDataForKey removeObjectForKey:key];
+    return NO;
+  }
+  _cachedDataForKey[key] = [data copy];
+  return YES;
 }
 
 - (BOOL)removeDataForKey:(NSString *)key error:(NSError **_Nullable)error {
@@ -131,11 +156,13 @@ static NSString *const kAccountPrefix = @"firebase_auth_1_";
     return NO;
   }
   if (![self deleteItemWithQuery:[self genericPasswordQueryWithKey:key] error:error]) {
+    [_cachedDataForKey removeObjectForKey:key];
     return NO;
   }
   // Legacy form item, if exists, also needs to be removed, otherwise it will be exposed when
   // current form item is removed, leading to incorrect semantics.
   [self deleteLegacyItemWithKey:key];
+  _cachedDataForKey[key] = [NSNull null];
   return YES;
 }
 
@@ -68,6 +68,13 @@ static const NSTimeInterval kFiveMinutes = 5 * 60;
       @brief The currently cached access token. Or |nil| if no token is currently cached.
    */
   NSString *_Nullable _accessToken;
+
+  /** @var _pendingFetchCallbacks
+      @brief The callbacks waiting on the access token request currently in flight, or |nil| if no
+          request is in flight.
+      @remarks The first callback is the one whose fetch started the request.
+   */
+  NSMutableArray<FIRFetchAccessTokenCallback> *_Nullable _pendingFetchCallbacks;
 }
 
 - (instancetype)init {
@@ -106,15 +113,17 @@ static const NSTimeInterval kFiveMinutes = 5 * 60;
                               callback:(FIRFetchAccessTokenCallback)callback {
   [_taskQueue enqueueTask:^(FIRAuthSerialTaskCompletionBlock complete) {
     if (!forceRefresh && [self hasValidAccessToken]) {
+      NSString *accessToken = _accessToken;
+      complete();
+      callback(accessToken, nil, NO);
+    } else if (_pendingFetchCallbacks) {
+      // A request is already in flight; its result is at least as fresh as a new one would be.
+      [_pendingFetchCallbacks addObject:[callback copy]];
       complete();
-      callback(_accessToken, nil, NO);
     } else {
-      [self requestAccessToken:^(NSString *_Nullable token,
-                                 NSError *_Nullable error,
-                                 BOOL tokenUpdated) {
-        complete();
-        callback(token, error, tokenUpdated);
-      }];
+      _pendingFetchCallbacks = [NSMutableArray arrayWithObject:[callback copy]];
+      [self requestAccessToken];
+      complete();
     }
   }];
 }
@@ -158,19 +167,19 @@ static const NSTimeInterval kFiveMinutes = 5 * 60;
 
 #pragma mark - Private methods
 
-/** @fn requestAccessToken:
+/** @fn requestAccessToken
     @brief Makes a request to STS for an access token.
     @details This handles both the case that the token has not been granted yet and that it just
         needs to be refreshed. The caller is responsible for making sure that this is occurring in
-        a @c _taskQueue task.
-    @param callback Called when the fetch is complete. Invoked asynchronously on the main thread in
-        the future.
-    @remarks Because this method is guaranteed to only be called from tasks enqueued in
-        @c _taskQueue, we do not need any @synchronized guards around access to _accessToken/etc.
-        since only one of those tasks is ever running at a time, and those tasks are the only
-        access to and mutation of these instance variables.
+        a @c _taskQueue task, and for adding the callbacks to be invoked with the result to
+        @c _pendingFetchCallbacks.
+    @remarks The response is applied in a new @c _taskQueue task rather than holding the queue for
+        the duration of the request, so that fetches which can be served from the cached token are
+        not delayed by a refresh in flight. Because all access to and mutation of _accessToken/etc.
+        happens in those tasks, and only one of them is ever running at a time, we do not need any
+        @synchronized guards around these instance variables.
  */
-- (void)requestAccessToken:(FIRFetchAccessTokenCallback)callback {
+- (void)requestAccessToken {
   FIRSecureTokenRequest *request;
   if (_refreshToken.length) {
     request = [FIRSecureTokenRequest refreshRequestWithRefreshToken:_refreshToken
@@ -182,19 +191,28 @@ static const NSTimeInterval kFiveMinutes = 5 * 60;
   [FIRAuthBackend secureToken:request
                      callback:^(FIRSecureTokenResponse *_Nullable response,
                                 NSError *_Nullable error) {
-    BOOL tokenUpdated = NO;
-    NSString *newAccessToken = response.accessToken;
-    if (newAccessToken.length && ![newAccessToken isEqualToString:_accessToken]) {
-      _accessToken = [newAccessToken copy];
-      _accessTokenExpirationDate = response.approximateExpirationDate;
-      tokenUpdated = YES;
-    }
-    NSString *newRefreshToken = response.refreshToken;
-    if (newRefreshToken.length && ![newRefreshToken isEqualToString:_refreshToken]) {
-      _refreshToken = [newRefreshToken copy];
-      tokenUpdated = YES;
-    }
-    callback(newAccessToken, error, tokenUpdated);
+    [_taskQueue enqueueTask:^(FIRAuthSerialTaskCompletionBlock complete) {
+      BOOL tokenUpdated = NO;
+      NSString *newAccessToken = response.accessToken;
+      if (newAccessToken.length && ![newAccessToken isEqualToString:_accessToken]) {
+        _accessToken = [newAccessToken copy];
+        _accessTokenExpirationDate = response.approximateExpirationDate;
+        tokenUpdated = YES;
+      }
+      NSString *newRefreshToken = response.refreshToken;
+      if (newRefreshToken.length && ![newRefreshToken isEqualToString:_refreshToken]) {
+        _refreshToken = [newRefreshToken copy];
+        tokenUpdated = YES;
+      }
+      NSArray<FIRFetchAccessTokenCallback> *callbacks = _pendingFetchCallbacks;
+      _pendingFetchCallbacks = nil;
+      complete();
+      for (NSUInteger i = 0; i < callbacks.count; i++) {
+        // Only the fetch which started the request reports the update, so that the new tokens are
+        // persisted once rather than once per waiter.
+        callbacks[i](newAccessToken, error, i == 0 && tokenUpdated);
+      }
+    }];
   }];
 }
 
@@ -86,6 +86,12 @@ static NSString *const kFirebaseAuthCoreFrameworkMarker = @"FirebaseCore-iOS";
  */
 static NSString *const kJSONContentType = @"application/json";
 
+/** @var kUnusedSessionTimeout
+    @brief How long (in seconds) the shared URL session, and with it any open connections to the
+        backend hosts, is kept after the last RPC has finished.
+ */
+static const NSTimeInterval kUnusedSessionTimeout = 5 * 60;
+
 /** @var kErrorDataKey
     @brief Key for error data in NSError returned by @c GTMSessionFetcher.
  */
@@ -482,6 +488,9 @@ static id<FIRAuthBackendImplementation> gBackendImplementation;
 
 @implementation FIRAuthBackendRPCIssuerImplementation {
   /** @var The session fetcher service.
+      @remarks All RPCs, to both the identity toolkit and the secure token hosts, are issued through
+          one URL session so that they share its connections (multiplexed over HTTP/2 where the
+          server supports it) instead of each paying for connection setup.
    */
   GTMSessionFetcherService *_fetcherService;
 }
@@ -492,6 +501,8 @@ static id<FIRAuthBackendImplementation> gBackendImplementation;
     _fetcherService = [[GTMSessionFetcherService alloc] init];
     _fetcherService.userAgent = [FIRAuthBackend authUserAgent];
     _fetcherService.callbackQueue = FIRAuthGlobalWorkQueue();
+    _fetcherService.reuseSession = YES;
+    _fetcherService.unusedSessionTimeout = kUnusedSessionTimeout;
   }
   return self;
 }
@@ -289,6 +289,15 @@ static const char *FIREBASE_SEMVER = (const char *)STR(FIRDatabase_VERSION);
     return self->_config.callbackQueue;
 }
 
+- (void)setCoalesceQueuedOverwrites:(BOOL)coalesceQueuedOverwrites {
+    [self assertUnfrozen:@"setCoalesceQueuedOverwrites"];
+    self->_config.coalesceQueuedOverwrites = coalesceQueuedOverwrites;
+}
+
+- (BOOL)coalesceQueuedOverwrites {
+    return self->_config.coalesceQueuedOverwrites;
+}
+
 - (void) assertUnfrozen:(NSString*)methodName {
     if (self.repo != nil) {
         [NSException raise:@"FIRDatabaseAlreadyInUse" format:@"Calls to %@ must be made before any other usage of "
@@ -58,6 +58,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic, strong) dispatch_queue_t callbackQueue;
 
+/**
+ * When set, an overwrite that can't be sent yet replaces the overwrite of the same path queued right before it, so
+ * that edits made while offline go out as one write. Off by default.
+ */
+@property (nonatomic) BOOL coalesceQueuedOverwrites;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -77,6 +77,11 @@
     self->_callbackQueue = callbackQueue;
 }
 
+- (void)setCoalesceQueuedOverwrites:(BOOL)coalesceQueuedOverwrites {
+    [self assertUnfrozen];
+    self->_coalesceQueuedOverwrites = coalesceQueuedOverwrites;
+}
+
 - (void)freeze {
     self->_isFrozen = YES;
 }
@@ -182,6 +182,9 @@ FOUNDATION_EXPORT const unsigned int kFirebaseMaxLeafSize;
 #pragma mark Transaction Constants
 
 FOUNDATION_EXPORT NSUInteger const kFTransactionMaxRetries;
+FOUNDATION_EXPORT float const kFTransactionRetryMinDelay;
+FOUNDATION_EXPORT float const kFTransactionRetryMaxDelay;
+FOUNDATION_EXPORT float const kFTransactionRetryMultiplier;
 FOUNDATION_EXPORT NSString *const kFTransactionTooManyRetries;
 FOUNDATION_EXPORT NSString *const kFTransactionNoData;
 FOUNDATION_EXPORT NSString *const kFTransactionSet;
@@ -177,6 +177,9 @@ const unsigned int kFirebaseMaxLeafSize = 1024 * 1024 * 10; // 10 MB
 #pragma mark Transaction Constants
 
 NSUInteger const kFTransactionMaxRetries = 25;
+float const kFTransactionRetryMinDelay = 0.1f;
+float const kFTransactionRetryMaxDelay = 2.0f;
+float const kFTransactionRetryMultiplier = 1.5f;
 NSString *const kFTransactionTooManyRetries = @"maxretry";
 NSString *const kFTransactionNoData = @"nodata";
 NSString *const kFTransactionSet = @"set";
@@ -37,4 +37,10 @@ typedef BOOL (^FCompoundHashSplitStrategy) (FCompoundHashBuilder *builder);
 + (FCompoundHash *)fromNode:(id<FNode>)node;
 + (FCompoundHash *)fromNode:(id<FNode>)node splitStrategy:(FCompoundHashSplitStrategy)strategy;
 
+/**
+* Splits the node into ranges the way fromNode: does, but with ranges that are the given factor larger (or smaller) than
+* the default. Ranges never get smaller than the default minimum.
+*/
++ (FCompoundHash *)fromNode:(id<FNode>)node splitThresholdScale:(double)scale;
+
 @end
@@ -43,12 +43,20 @@
     NSInteger currentPathDepth;
 
     BOOL needsComma;
+
+    // The hash length past which the split strategy ends a range, or 0 if it isn't known
+    NSUInteger splitThreshold;
 }
 
 - (instancetype)initWithSplitStrategy:(FCompoundHashSplitStrategy)strategy {
+    return [self initWithSplitStrategy:strategy splitThreshold:0];
+}
+
+- (instancetype)initWithSplitStrategy:(FCompoundHashSplitStrategy)strategy splitThreshold:(NSUInteger)threshold {
     self = [super init];
     if (self != nil) {
         self->_splitStrategy = strategy;
+        self->splitThreshold = threshold;
         self->optHashValueBuilder = nil;
         self->currentPath = [NSMutableArray array];
         self->lastLeafDepth = -1;
@@ -112,6 +120,37 @@
     }
 }
 
+// Appends the cached representation of the node if no range can end inside of it. This produces the same hash as
+// processing the node leaf by leaf, but reuses the work done for unchanged nodes.
+- (BOOL)appendNodeIfItFitsInRange:(id<FNode>)node {
+    [self ensureRange];
+
+    NSUInteger length = [self currentHashLength];
+    NSUInteger available = length < self->splitThreshold ? self->splitThreshold - length : 0;
+    // The estimated size never exceeds the length of the representation, and is cheaper to compute
+    if (available == 0 || [FSnapshotUtilities estimateSerializedNodeSize:node] > available) {
+        return NO;
+    }
+    NSString *representation = [(id)node compoundHashRepresentation];
+    if (representation.length > available) {
+        return NO;
+    }
+
+    [self->optHashValueBuilder appendString:representation];
+    NSArray *lastLeafKeys = [node isLeafNode] ? @[] : [(FChildrenNode *)node compoundHashLastLeafKeys];
+    for (NSUInteger i = 0; i < lastLeafKeys.count; i++) {
+        NSUInteger depth = (NSUInteger)self->currentPathDepth + i;
+        if (depth == currentPath.count) {
+            [self->currentPath addObject:lastLeafKeys[i]];
+        } else {
+            self->currentPath[depth] = lastLeafKeys[i];
+        }
+    }
+    self->lastLeafDepth = self->currentPathDepth + (NSInteger)lastLeafKeys.count;
+    self->needsComma = YES;
+    return YES;
+}
+
 - (void)startChild:(NSString *)key {
     [self ensureRange];
 
@@ -187,7 +226,7 @@
     return self;
 }
 
-+ (FCompoundHashSplitStrategy)simpleSizeSplitStrategyForNode:(id<FNode>)node {
++ (NSUInteger)simpleSizeSplitThresholdForNode:(id<FNode>)node {
     NSUInteger estimatedSize = [FSnapshotUtilities estimateSerializedNodeSize:node];
 
     // Splits for
@@ -196,8 +235,10 @@
     // 100k -> 3.2k (32 parts)
     // 500k -> 7k (71 parts)
     // 5M -> 23k (228 parts)
-    NSUInteger splitThreshold = MAX(512, (NSUInteger)sqrt(estimatedSize * 100));
+    return MAX(512, (NSUInteger)sqrt(estimatedSize * 100));
+}
 
++ (FCompoundHashSplitStrategy)simpleSizeSplitStrategyWithThreshold:(NSUInteger)splitThreshold {
     return ^BOOL(FCompoundHashBuilder *builder) {
         // Never split on priorities
         return [builder currentHashLength] > splitThreshold && ![[[builder currentPath] getBack] isEqualToString:@".priority"];
@@ -205,22 +246,38 @@
 }
 
 + (FCompoundHash *)fromNode:(id<FNode>)node {
-    return [FCompoundHash fromNode:node splitStrategy:[FCompoundHash simpleSizeSplitStrategyForNode:node]];
+    return [FCompoundHash fromNode:node splitThresholdScale:1.0];
+}
+
++ (FCompoundHash *)fromNode:(id<FNode>)node splitThresholdScale:(double)scale {
+    if ([node isEmpty]) {
+        return [[FCompoundHash alloc] initWithPosts:@[] hashes:@[@""]];
+    }
+    // Knowing where the strategy splits lets the builder reuse the representations cached on the nodes
+    NSUInteger splitThreshold = MAX(512, (NSUInteger)([FCompoundHash simpleSizeSplitThresholdForNode:node] * scale));
+    FCompoundHashSplitStrategy strategy = [FCompoundHash simpleSizeSplitStrategyWithThreshold:splitThreshold];
+    FCompoundHashBuilder *builder = [[FCompoundHashBuilder alloc] initWithSplitStrategy:strategy splitThreshold:splitThreshold];
+    return [FCompoundHash fromNode:node builder:builder];
 }
 
 + (FCompoundHash *)fromNode:(id<FNode>)node splitStrategy:(FCompoundHashSplitStrategy)strategy {
     if ([node isEmpty]) {
         return [[FCompoundHash alloc] initWithPosts:@[] hashes:@[@""]];
     } else {
-        FCompoundHashBuilder *builder = [[FCompoundHashBuilder alloc] initWithSplitStrategy:strategy];
-        [FCompoundHash processNode:node builder:builder];
-        [builder finishHashing];
-        return [[FCompoundHash alloc] initWithPosts:builder.currentPaths hashes:builder.currentHashes];
+        return [FCompoundHash fromNode:node builder:[[FCompoundHashBuilder alloc] initWithSplitStrategy:strategy]];
     }
 }
 
++ (FCompoundHash *)fromNode:(id<FNode>)node builder:(FCompoundHashBuilder *)builder {
+    [FCompoundHash processNode:node builder:builder];
+    [builder finishHashing];
+    return [[FCompoundHash alloc] initWithPosts:builder.currentPaths hashes:builder.currentHashes];
+}
+
 + (void)processNode:(id<FNode>)node builder:(FCompoundHashBuilder *)builder {
-    if ([node isLeafNode]) {
+    if ([builder appendNodeIfItFitsInRange:node]) {
+        return;
+    } else if ([node isLeafNode]) {
         [builder processLeaf:node];
     } else {
         NSAssert(![node isEmpty], @"Can't calculate hash on empty node!");
@@ -620,6 +620,27 @@ static void reachabilityCallback(SCNetworkReachabilityRef ref, SCNetworkReachabi
         [request setObject:hash forKey:kFWPRequestHash];
     }
 
+    if (self.config.coalesceQueuedOverwrites && hash == nil && [action isEqualToString:kFWPRequestActionPut] && ![self canSendWrites]) {
+        NSNumber *lastIndex = [[self.outstandingPuts allKeys] valueForKeyPath:@"@max.self"];
+        FOutstandingPut *lastPut = lastIndex != nil ? self.outstandingPuts[lastIndex] : nil;
+        // Transactions carry a hash and must go out as they are
+        if (lastPut != nil && !lastPut.sent && [lastPut.action isEqualToString:kFWPRequestActionPut] &&
+                lastPut.request[kFWPRequestHash] == nil && [lastPut.request[kFWPRequestPath] isEqualToString:pathString]) {
+            FFLog(@"I-RDB034045", @"Coalescing overwrite of %@ with queued put %@", pathString, lastIndex);
+            fbt_void_nsstring_nsstring previousOnComplete = lastPut.onCompleteBlock;
+            lastPut.request = request;
+            lastPut.onCompleteBlock = ^(NSString *status, NSString *errorReason) {
+                if (previousOnComplete != nil) {
+                    previousOnComplete(status, errorReason);
+                }
+                if (onComplete != nil) {
+                    onComplete(status, errorReason);
+                }
+            };
+            return;
+        }
+    }
+
     FOutstandingPut *put = [[FOutstandingPut alloc] init];
     put.action = action;
     put.request = request;
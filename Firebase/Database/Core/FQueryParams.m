@@ -48,7 +48,13 @@
 
 @end
 
-@implementation FQueryParams
+@implementation FQueryParams {
+    /**
+    * The hash, computed on first use, or 0 if it hasn't been yet. Params are never changed once
+    * returned from the methods building them, and each of those starts from a fresh mutableCopy.
+    */
+    NSUInteger _cachedHash;
+}
 
 + (FQueryParams *) defaultInstance {
     static FQueryParams *defaultParams = nil;
@@ -346,6 +352,8 @@
         return NO;
     }
     FQueryParams *other = (FQueryParams *)obj;
+    // The hashes are cached, so this rejects most unequal params without comparing any nodes.
+    if ([self hash] != [other hash]) return NO;
     if (self->_limitSet != other->_limitSet) return NO;
     if (self->_limit != other->_limit) return NO;
     if ((self->_index != other->_index) && ![self->_index isEqual:other->_index]) return NO;
@@ -359,6 +367,12 @@
 }
 
 - (NSUInteger) hash {
+    // A single word, so a racing reader sees either 0 or the whole hash.
+    NSUInteger cached = _cachedHash;
+    if (cached != 0) {
+        return cached;
+    }
+
     NSUInteger result = _limitSet ? _limit : 0;
     result = 31 * result + ([self isViewFromLeft] ? 1231 : 1237);
     result = 31 * result + [_indexStartKey hash];
@@ -366,7 +380,9 @@
     result = 31 * result + [_indexEndKey hash];
     result = 31 * result + [_indexEndValue hash];
     result = 31 * result + [_index hash];
-    return result;
+    // Reserve 0 to mean not computed yet.
+    _cachedHash = result != 0 ? result : 1;
+    return _cachedHash;
 }
 
 @end
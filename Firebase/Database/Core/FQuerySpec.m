@@ -24,13 +24,20 @@
 
 @end
 
-@implementation FQuerySpec
+@implementation FQuerySpec {
+    /**
+    * The hash, computed once at construction. Specs are looked up for every event registration
+    * and every tagged operation, and hashing the params may hash their start and end nodes.
+    */
+    NSUInteger _hash;
+}
 
 - (id)initWithPath:(FPath *)path params:(FQueryParams *)params {
     self = [super init];
     if (self != nil) {
         self->_path = path;
         self->_params = params;
+        self->_hash = path.hash * 31 + params.hash;
     }
     return self;
 }
@@ -67,6 +74,10 @@
 
     FQuerySpec *other = (FQuerySpec *)object;
 
+    if (self->_hash != other->_hash) {
+        return NO;
+    }
+
     if (![self.path isEqual:other.path]) {
         return NO;
     }
@@ -75,7 +86,7 @@
 }
 
 - (NSUInteger)hash {
-    return self.path.hash * 31 + self.params.hash;
+    return self->_hash;
 }
 
 - (NSString *)description {
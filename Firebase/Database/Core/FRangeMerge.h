@@ -28,6 +28,8 @@
  */
 @interface FRangeMerge : NSObject
 
+@property (nonatomic, strong, readonly) id<FNode> updates;
+
 - (instancetype)initWithStart:(FPath *)start end:(FPath *)end updates:(id<FNode>)updates;
 
 - (id<FNode>)applyToNode:(id<FNode>)node;
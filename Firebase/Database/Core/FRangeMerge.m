@@ -22,7 +22,7 @@
 
 @property (nonatomic, strong) FPath *optExclusiveStart;
 @property (nonatomic, strong) FPath *optInclusiveEnd;
-@property (nonatomic, strong) id<FNode> updates;
+@property (nonatomic, strong, readwrite) id<FNode> updates;
 
 @end
 
@@ -52,6 +52,7 @@
 #import "FIRDataSnapshot_Private.h"
 #import "FValueEventRegistration.h"
 #import "FEmptyNode.h"
+#import "FIRRetryHelper.h"
 
 #if TARGET_OS_IOS || TARGET_OS_TV
 #import <UIKit/UIKit.h>
@@ -67,6 +68,10 @@
 @property (nonatomic) NSInteger writeIdCounter;
 @property (nonatomic) BOOL hijackHash;
 @property (nonatomic, strong) FTree *transactionQueueTree;
+// Backs off resending the transactions at a path each time the server rejects them for a stale hash, so that clients
+// contending for the same data don't keep colliding. Paths are in the set while a resend is scheduled.
+@property (nonatomic, strong) NSMutableDictionary *transactionRetryHelpers;
+@property (nonatomic, strong) NSMutableSet *transactionPathsBackingOff;
 @property (nonatomic) BOOL loggedTransactionPersistenceWarning;
 
 /**
@@ -192,7 +197,7 @@
 
 
 - (void) restoreWrites {
-    NSArray *writes = self.persistenceManager.userWrites;
+    NSArray *writes = self.persistenceManager.compactedUserWrites;
 
     NSDictionary *serverValues = [FServerValues generateServerValues:self.serverClock];
     __block NSInteger lastWriteId = NSIntegerMin;
@@ -562,6 +567,7 @@
 
     NSDate *start = [NSDate date];
     dispatch_async([FIRDatabaseQuery sharedQueue], ^{
+        [self.persistenceManager flush];
         NSTimeInterval finishTime = [start timeIntervalSinceNow]*-1;
         FFLog(@"I-RDB038018", @"Background task completed.  Queue time: %f", finishTime);
         [application endBackgroundTask:bgTask];
@@ -603,6 +609,8 @@
  */
 - (void) initTransactions {
     self.transactionQueueTree = [[FTree alloc] init];
+    self.transactionRetryHelpers = [NSMutableDictionary dictionary];
+    self.transactionPathsBackingOff = [NSMutableSet set];
     self.hijackHash = NO;
     self.loggedTransactionPersistenceWarning = NO;
 }
@@ -728,8 +736,9 @@
         }];
 
         // If they're all run (and not sent), we can send them.  Else, we must wait.
-        if (notRunIndex == NSNotFound) {
-            [self sendTransactionQueue:queue atPath:node.path];
+        FPath *path = node.path;
+        if (notRunIndex == NSNotFound && ![self.transactionPathsBackingOff containsObject:path]) {
+            [self sendTransactionQueue:queue atPath:path];
         }
     } else if ([node hasChildren]) {
         [node forEachChild:^(FTree *child) {
@@ -769,6 +778,9 @@
         FFLog(@"I-RDB038022", @"Transaction put response: %@ : %@", pathToSend, status);
 
         NSMutableArray *events = [[NSMutableArray alloc] init];
+        if (![status isEqualToString:kFWPResponseForActionStatusDataStale]) {
+            [self.transactionRetryHelpers removeObjectForKey:path];
+        }
         if ([status isEqualToString:kFWPResponseForActionStatusOk]) {
             // Queue up the callbacks and fire them after cleaning up all of our transaction state, since
             // the callback could trigger more transactions or sets.
@@ -810,6 +822,7 @@
                         transaction.status = FTransactionRun;
                     }
                 }
+                [self backOffTransactionsAtPath:path];
             } else {
                 FFWarn(@"I-RDB038023", @"runTransactionBlock: at %@ failed: %@", path, status);
                 for (FTupleTransaction *transaction in queue) {
@@ -824,6 +837,27 @@
     }];
 }
 
+/**
+ * Holds back resending the transactions at the path until the retry helper for the path fires. The transactions are
+ * still rerun right away against the data that made them stale, so local events stay up to date.
+ */
+- (void) backOffTransactionsAtPath:(FPath *)path {
+    FIRRetryHelper *retryHelper = self.transactionRetryHelpers[path];
+    if (retryHelper == nil) {
+        retryHelper = [[FIRRetryHelper alloc] initWithDispatchQueue:[FIRDatabaseQuery sharedQueue]
+                                          minRetryDelayAfterFailure:kFTransactionRetryMinDelay
+                                                      maxRetryDelay:kFTransactionRetryMaxDelay
+                                                      retryExponent:kFTransactionRetryMultiplier
+                                                       jitterFactor:0.7];
+        self.transactionRetryHelpers[path] = retryHelper;
+    }
+    [self.transactionPathsBackingOff addObject:path];
+    [retryHelper retry:^{
+        [self.transactionPathsBackingOff removeObject:path];
+        [self sendAllReadyTransactions];
+    }];
+}
+
 /**
  * Finds all transactions dependent on the data at changed Path and reruns them.
  *
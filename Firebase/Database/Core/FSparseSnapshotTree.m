@@ -36,41 +36,41 @@
 }
 
 - (id<FNode>) findPath:(FPath *)path {
-    if (value != nil) {
-        return [value getChild:path];
-    } else if (![path isEmpty] && children != nil) {
-        NSString* childKey = [path getFront];
-        path = [path popFront];
-        FSparseSnapshotTree* childTree = children[childKey];
-        if (childTree != nil) {
-            return [childTree findPath:path];
-        } else {
+    FSparseSnapshotTree* tree = self;
+    while (tree != nil) {
+        if (tree->value != nil) {
+            return [tree->value getChild:path];
+        } else if ([path isEmpty] || tree->children == nil) {
             return nil;
         }
-    } else {
-        return nil;
+        tree = tree->children[[path getFront]];
+        path = [path popFront];
     }
+    return nil;
 }
 
 - (void) rememberData:(id<FNode>)data onPath:(FPath *)path {
-    if ([path isEmpty]) {
-        value = data;
-        children = nil;
-    } else if (value != nil) {
-        value = [value updateChild:path withNewChild:data];
-    } else {
-        if (children == nil) {
-            children = [[NSMutableDictionary alloc] init];
+    FSparseSnapshotTree* tree = self;
+    while (![path isEmpty] && tree->value == nil) {
+        if (tree->children == nil) {
+            tree->children = [[NSMutableDictionary alloc] init];
         }
 
         NSString* childKey = [path getFront];
-        if (children[childKey] == nil) {
-            children[childKey] = [[FSparseSnapshotTree alloc] init];
+        FSparseSnapshotTree* child = tree->children[childKey];
+        if (child == nil) {
+            child = [[FSparseSnapshotTree alloc] init];
+            tree->children[childKey] = child;
         }
-
-        FSparseSnapshotTree* child = children[childKey];
+        tree = child;
         path = [path popFront];
-        [child rememberData:data onPath:path];
+    }
+
+    if ([path isEmpty]) {
+        tree->value = data;
+        tree->children = nil;
+    } else {
+        tree->value = [tree->value updateChild:path withNewChild:data];
     }
 }
 
@@ -120,13 +120,22 @@
 }
 
 - (void) forEachTreeAtPath:(FPath *)prefixPath do:(fbt_void_path_node)func {
-    if (value != nil) {
-        func(prefixPath, value);
-    } else {
-        [self forEachChild:^(NSString* key, FSparseSnapshotTree* tree) {
-            FPath* path = [prefixPath childFromString:key];
-            [tree forEachTreeAtPath:path do:func];
-        }];
+    // Walk the tree with an explicit stack of trees and their paths rather than recursing through a block per node
+    NSMutableArray* trees = [NSMutableArray arrayWithObject:self];
+    NSMutableArray* paths = [NSMutableArray arrayWithObject:prefixPath];
+    while (trees.count > 0) {
+        FSparseSnapshotTree* tree = [trees lastObject];
+        FPath* path = [paths lastObject];
+        [trees removeLastObject];
+        [paths removeLastObject];
+        if (tree->value != nil) {
+            func(path, tree->value);
+        } else {
+            [tree->children enumerateKeysAndObjectsUsingBlock:^(NSString* key, FSparseSnapshotTree* child, BOOL *stop) {
+                [trees addObject:child];
+                [paths addObject:[path childFromString:key]];
+            }];
+        }
     }
 }
 
@@ -58,4 +58,10 @@
 
 - (id<FNode>) calcCompleteEventCacheAtPath:(FPath *)path excludeWriteIds:(NSArray *)writeIdsToExclude;
 
+/**
+* The estimated number of bytes the server didn't have to send because it could compare our compound hashes to its
+* data, summed over every range merge applied so far.
+*/
+@property (nonatomic, readonly) NSUInteger rangeMergeBytesSaved;
+
 @end
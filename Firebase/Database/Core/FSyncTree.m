@@ -53,10 +53,21 @@
 // Size after which we start including the compound hash
 static const NSUInteger kFSizeThresholdForCompoundHash = 1024;
 
+// The range size of a listen's compound hash adapts to how many of its ranges the server has to send back. When most
+// of them changed, fewer larger ranges cost less to send; when only a few did, smaller ranges resend less data.
+static const double kFCompoundHashMaxSplitScale = 16;
+static const double kFCompoundHashMinSplitScale = 1.0 / 16;
+static const double kFCompoundHashCoarsenChangedFraction = 0.5;
+static const double kFCompoundHashRefineChangedFraction = 0.125;
+
 @interface FListenContainer : NSObject<FSyncTreeHash>
 
 @property (nonatomic, strong) FView *view;
 @property (nonatomic, copy) fbt_nsarray_nsstring onComplete;
+// Scales the default range size of the compound hashes sent for this listen
+@property (nonatomic) double splitScale;
+// The number of ranges in the compound hash last sent for this listen, or 0 if there wasn't one
+@property (nonatomic) NSUInteger lastHashCount;
 
 @end
 
@@ -67,6 +78,7 @@ static const NSUInteger kFSizeThresholdForCompoundHash = 1024;
     if (self != nil) {
         self->_view = view;
         self->_onComplete = onComplete;
+        self->_splitScale = 1.0;
     }
     return self;
 }
@@ -76,7 +88,22 @@ static const NSUInteger kFSizeThresholdForCompoundHash = 1024;
 }
 
 - (FCompoundHash *)compoundHash {
-    return [FCompoundHash fromNode:[self serverCache]];
+    FCompoundHash *hash = [FCompoundHash fromNode:[self serverCache] splitThresholdScale:self.splitScale];
+    self.lastHashCount = hash.hashes.count;
+    return hash;
+}
+
+- (void)recordRangeMerges:(NSArray *)ranges {
+    if (self.lastHashCount == 0) {
+        return;
+    }
+    double changedFraction = (double)ranges.count / self.lastHashCount;
+    if (changedFraction > kFCompoundHashCoarsenChangedFraction) {
+        self.splitScale = MIN(self.splitScale * 2, kFCompoundHashMaxSplitScale);
+    } else if (changedFraction < kFCompoundHashRefineChangedFraction) {
+        self.splitScale = MAX(self.splitScale / 2, kFCompoundHashMinSplitScale);
+    }
+    self.lastHashCount = 0;
 }
 
 - (NSString *)simpleHash {
@@ -110,6 +137,9 @@ static const NSUInteger kFSizeThresholdForCompoundHash = 1024;
 @property (nonatomic, strong) FPersistenceManager *persistenceManager;
 @property (nonatomic, strong) FAtomicNumber *queryTagCounter;
 @property (nonatomic, strong) NSMutableSet *keepSyncedQueries;
+// The listen container of every view we're listening with, so range merges can tune its compound hashes
+@property (nonatomic, strong) NSMapTable *listenContainers;
+@property (nonatomic, readwrite) NSUInteger rangeMergeBytesSaved;
 
 @end
 
@@ -150,6 +180,7 @@ static const NSUInteger kFSizeThresholdForCompoundHash = 1024;
         self.persistenceManager = persistenceManager;
         self.queryTagCounter = [[FAtomicNumber alloc] init];
         self.keepSyncedQueries = [NSMutableSet set];
+        self.listenContainers = [NSMapTable weakToWeakObjectsMapTable];
     }
     return self;
 }
@@ -253,10 +284,7 @@ static const NSUInteger kFSizeThresholdForCompoundHash = 1024;
         // each have the same cache so it doesn't matter which one we use.
         FView *view = [syncPoint completeView];
         if (view != nil) {
-            id<FNode> serverNode = [view serverCache];
-            for (FRangeMerge *merge in ranges) {
-                serverNode = [merge applyToNode:serverNode];
-            }
+            id<FNode> serverNode = [self applyRangeMerges:ranges toView:view];
             return [self applyServerOverwriteAtPath:path newData:serverNode];
         } else {
             // There doesn't exist a view for this update, so it was removed and it's safe to just ignore this range
@@ -266,6 +294,25 @@ static const NSUInteger kFSizeThresholdForCompoundHash = 1024;
     }
 }
 
+- (id<FNode>) applyRangeMerges:(NSArray *)ranges toView:(FView *)view {
+    id<FNode> serverNode = [view serverCache];
+    NSUInteger receivedBytes = 0;
+    for (FRangeMerge *merge in ranges) {
+        serverNode = [merge applyToNode:serverNode];
+        receivedBytes += [FSnapshotUtilities estimateSerializedNodeSize:merge.updates];
+    }
+    NSUInteger totalBytes = [FSnapshotUtilities estimateSerializedNodeSize:serverNode];
+    NSUInteger savedBytes = totalBytes > receivedBytes ? totalBytes - receivedBytes : 0;
+    self.rangeMergeBytesSaved += savedBytes;
+
+    FListenContainer *listenContainer = [self.listenContainers objectForKey:view];
+    [listenContainer recordRangeMerges:ranges];
+    FFLog(@"I-RDB038024", @"Range merge at %@ received %lu of %lu bytes (%lu saved), next split scale %f",
+          view.query.path, (unsigned long)receivedBytes, (unsigned long)totalBytes, (unsigned long)savedBytes,
+          listenContainer.splitScale);
+    return serverNode;
+}
+
 /**
 * Apply a listen complete to a path
 * @return NSArray of FEvent to raise.
@@ -350,10 +397,7 @@ static const NSUInteger kFSizeThresholdForCompoundHash = 1024;
         NSAssert(syncPoint != nil, @"Missing sync point for query tag that we're tracking.");
         FView *view = [syncPoint viewForQuery:query];
         NSAssert(view != nil, @"Missing view for query tag that we're tracking");
-        id<FNode> serverNode = [view serverCache];
-        for (FRangeMerge *merge in ranges) {
-            serverNode = [merge applyToNode:serverNode];
-        }
+        id<FNode> serverNode = [self applyRangeMerges:ranges toView:view];
         return [self applyTaggedQueryOverwriteAtPath:path newData:serverNode tagId:tagId];
     } else {
         // We've already removed the query. No big deal, ignore the update.
@@ -703,6 +747,7 @@ static const NSUInteger kFSizeThresholdForCompoundHash = 1024;
             return [self removeEventRegistration:nil forQuery:query cancelError:error];
         }
     }];
+    [self.listenContainers setObject:listenContainer forKey:view];
 
     return listenContainer;
 }
@@ -25,6 +25,12 @@
 - initWithPath:(FPath *)path overwrite:(id<FNode>)overwrite writeId:(NSInteger)writeId visible:(BOOL)isVisible;
 - initWithPath:(FPath *)path merge:(FCompoundWrite *)merge writeId:(NSInteger)writeId;
 
+/**
+* Creates a visible write record whose overwrite (an id<FNode>) or merge (an FCompoundWrite) is only created by calling
+* the decoder the first time it's needed. Used for persisted writes, many of which are never looked at.
+*/
+- initWithPath:(FPath *)path writeId:(NSInteger)writeId isMerge:(BOOL)isMerge decoder:(id (^)(void))decoder;
+
 @property (nonatomic, readonly) NSInteger writeId;
 @property (nonatomic, strong, readonly) FPath *path;
 @property (nonatomic, strong, readonly) id<FNode> overwrite;
@@ -25,6 +25,8 @@
 @property (nonatomic, strong, readwrite) id<FNode> overwrite;
 @property (nonatomic, strong, readwrite) FCompoundWrite *merge;
 @property (nonatomic, readwrite) BOOL visible;
+@property (nonatomic, copy) id (^decoder)(void);
+@property (nonatomic) BOOL decodesToMerge;
 @end
 
 @implementation FWriteRecord
@@ -59,14 +61,50 @@
     return self;
 }
 
+- (id)initWithPath:(FPath *)path writeId:(NSInteger)writeId isMerge:(BOOL)isMerge decoder:(id (^)(void))decoder {
+    self = [super init];
+    if (self) {
+        self.path = path;
+        self.writeId = writeId;
+        self.visible = YES;
+        self.decoder = decoder;
+        self.decodesToMerge = isMerge;
+    }
+    return self;
+}
+
+- (void)decodeIfNeeded {
+    if (self->_decoder == nil) {
+        return;
+    }
+    id value = self->_decoder();
+    if (value == nil) {
+        [NSException raise:NSInternalInconsistencyException format:@"Failed to decode write record with id %ld", (long)self->_writeId];
+    }
+    if (self->_decodesToMerge) {
+        self->_merge = value;
+    } else {
+        self->_overwrite = value;
+    }
+    // Drop the decoder so whatever it captured can be freed
+    self->_decoder = nil;
+}
+
 - (id<FNode>)overwrite {
+    [self decodeIfNeeded];
     if (self->_overwrite == nil) {
         [NSException raise:NSInvalidArgumentException format:@"Can't get overwrite for merge write record!"];
     }
     return self->_overwrite;
 }
 
+- (FCompoundWrite *)merge {
+    [self decodeIfNeeded];
+    return self->_merge;
+}
+
 - (FCompoundWrite *)compoundWrite {
+    [self decodeIfNeeded];
     if (self->_merge == nil) {
         [NSException raise:NSInvalidArgumentException format:@"Can't get merge for overwrite write record!"];
     }
@@ -74,10 +112,16 @@
 }
 
 - (BOOL)isMerge {
+    if (self->_decoder != nil) {
+        return self->_decodesToMerge;
+    }
     return self->_merge != nil;
 }
 
 - (BOOL)isOverwrite {
+    if (self->_decoder != nil) {
+        return !self->_decodesToMerge;
+    }
     return self->_overwrite != nil;
 }
 
@@ -96,6 +140,8 @@
         return NO;
     }
     FWriteRecord *other = (FWriteRecord *)object;
+    [self decodeIfNeeded];
+    [other decodeIfNeeded];
     if (self->_writeId != other->_writeId) return NO;
     if (self->_path != other->_path && ![self->_path isEqual:other->_path]) return NO;
     if (self->_overwrite != other->_overwrite && ![self->_overwrite isEqual:other->_overwrite]) return NO;
@@ -106,6 +152,7 @@
 }
 
 - (NSUInteger)hash {
+    [self decodeIfNeeded];
     NSUInteger hash = self->_writeId * 17;
     hash = hash * 31 + self->_path.hash;
     hash = hash * 31 + self->_overwrite.hash;
@@ -41,6 +41,12 @@
 * Contains FWriteRecords.
 */
 @property (nonatomic, strong) NSMutableArray *allWrites;
+/**
+* An index of allWrites by the paths they write to. An overwrite is stored at its path and a merge at each of the
+* paths it changes. Used to find the writes overlapping a path without walking allWrites.
+* Contains NSArrays of FWriteRecords, in writeId order.
+*/
+@property (nonatomic, strong) FImmutableTree *writeIndex;
 @property (nonatomic) NSInteger lastWriteId;
 @end
 
@@ -59,6 +65,7 @@
     if (self) {
         self.visibleWrites = [FCompoundWrite emptyWrite];
         self.allWrites = [[NSMutableArray alloc] init];
+        self.writeIndex = [FImmutableTree empty];
         self.lastWriteId = -1;
     }
     return self;
@@ -79,6 +86,7 @@
     NSAssert(writeId > self.lastWriteId, @"Stacking an older write on top of a newer one");
     FWriteRecord *record = [[FWriteRecord alloc] initWithPath:path overwrite:newData writeId:writeId visible:visible];
     [self.allWrites addObject:record];
+    [self indexWrite:record];
 
     if (visible) {
         self.visibleWrites = [self.visibleWrites addWrite:newData atPath:path];
@@ -95,6 +103,7 @@
     NSAssert(writeId > self.lastWriteId, @"Stacking an older merge on top of newer one");
     FWriteRecord *record = [[FWriteRecord alloc] initWithPath:path merge:changedChildren writeId:writeId];
     [self.allWrites addObject:record];
+    [self indexWrite:record];
 
     self.visibleWrites = [self.visibleWrites addCompoundWrite:changedChildren atPath:path];
     self.lastWriteId = writeId;
@@ -125,40 +134,34 @@
     NSAssert(index != NSNotFound, @"[FWriteTree removeWriteId:] called with nonexistent writeId.");
     FWriteRecord *writeToRemove = self.allWrites[index];
     [self.allWrites removeObjectAtIndex:index];
+    [self unindexWrite:writeToRemove];
+
+    if (!writeToRemove.visible) {
+        return NO;
+    }
 
-    BOOL removedWriteWasVisible = writeToRemove.visible;
-    BOOL removedWriteOverlapsWithOtherWrites = NO;
-    NSInteger i = [self.allWrites count] - 1;
-
-    while (removedWriteWasVisible && i >= 0) {
-        FWriteRecord *currentWrite = [self.allWrites objectAtIndex:i];
-        if (currentWrite.visible) {
-            if (i >= index && [self record:currentWrite containsPath:writeToRemove.path]) {
-                // The removed write was completely shadowed by a subsequent write.
-                removedWriteWasVisible = NO;
-            } else if ([writeToRemove.path contains:currentWrite.path]) {
-                // Either we're covering some writes or they're covering part of us (depending on which came first).
-                removedWriteOverlapsWithOtherWrites = YES;
+    // Only writes at or above the removed write's path can shadow it, so walk down that path in the index.
+    __block BOOL removedWriteWasShadowed = NO;
+    void (^checkShadowing)(FPath *, NSArray *) = ^(FPath *writtenPath, NSArray *records) {
+        for (FWriteRecord *record in records) {
+            if (record.visible && record.writeId > writeToRemove.writeId && [self record:record containsPath:writeToRemove.path]) {
+                removedWriteWasShadowed = YES;
             }
         }
-        i--;
+    };
+    FImmutableTree *subtree = [self.writeIndex forEachOnPath:writeToRemove.path performBlock:checkShadowing];
+    if (subtree.value != nil) {
+        checkShadowing(writeToRemove.path, subtree.value);
     }
 
-    if (!removedWriteWasVisible) {
+    if (removedWriteWasShadowed) {
+        // The removed write was completely shadowed by a subsequent write.
         return NO;
-    } else if (removedWriteOverlapsWithOtherWrites) {
-        // There's some shadowing going on. Just rebuild the visible writes from scratch.
-        [self resetTree];
-        return YES;
     } else {
-        // There's no shadowing.  We can safely just remove the write(s) from visibleWrites.
-        if ([writeToRemove isOverwrite]) {
-            self.visibleWrites = [self.visibleWrites removeWriteAtPath:writeToRemove.path];
-        } else {
-            FCompoundWrite *merge = writeToRemove.merge;
-            [merge enumerateWrites:^(FPath *path, id<FNode> node, BOOL *stop) {
-                self.visibleWrites = [self.visibleWrites removeWriteAtPath:[writeToRemove.path child:path]];
-            }];
+        // Re-layer only the writes overlapping the paths the removed write changed. If nothing else overlaps, this
+        // simply removes the write from visibleWrites.
+        for (FPath *writtenPath in [FWriteTree writtenPathsForRecord:writeToRemove]) {
+            [self relayerWritesOverlappingPath:writtenPath];
         }
         return YES;
     }
@@ -168,6 +171,7 @@
     NSArray *writes = self.allWrites;
     self.visibleWrites = [FCompoundWrite emptyWrite];
     self.allWrites = [NSMutableArray array];
+    self.writeIndex = [FImmutableTree empty];
     return writes;
 }
 
@@ -217,7 +221,8 @@
                             (writeIdsToExclude == nil || ![writeIdsToExclude containsObject:[NSNumber numberWithInteger:record.writeId]]) &&
                             ([record.path contains:treePath] || [treePath contains:record.path]));
                 };
-                FCompoundWrite *mergeAtPath = [FWriteTree layerTreeFromWrites:self.allWrites filter:filter treeRoot:treePath];
+                NSArray *overlappingWrites = [self writesOverlappingPath:treePath includeAncestors:YES];
+                FCompoundWrite *mergeAtPath = [FWriteTree layerTreeFromWrites:overlappingWrites filter:filter treeRoot:treePath];
                 id<FNode> layeredCache = completeServerCache ? completeServerCache : [FEmptyNode emptyNode];
                 return [mergeAtPath applyToNode:layeredCache];
             }
@@ -381,18 +386,80 @@
 }
 
 /**
-* Re-layer the writes and merges into a tree so we can efficiently calculate event snapshots
+* The paths a write changes: the path of an overwrite, or each of the changed paths of a merge.
 */
-- (void) resetTree {
-    self.visibleWrites = [FWriteTree layerTreeFromWrites:self.allWrites filter:[FWriteTree defaultFilter] treeRoot:[FPath empty]];
-    if ([self.allWrites count] > 0) {
-        FWriteRecord *lastRecord = self.allWrites[[self.allWrites count] - 1];
-        self.lastWriteId = lastRecord.writeId;
++ (NSArray *) writtenPathsForRecord:(FWriteRecord *)record {
+    if ([record isOverwrite]) {
+        return @[record.path];
     } else {
-        self.lastWriteId = -1;
+        NSMutableArray *paths = [NSMutableArray array];
+        [record.merge enumerateWrites:^(FPath *childPath, id<FNode> node, BOOL *stop) {
+            [paths addObject:[record.path child:childPath]];
+        }];
+        return paths;
+    }
+}
+
+- (void) indexWrite:(FWriteRecord *)record {
+    for (FPath *path in [FWriteTree writtenPathsForRecord:record]) {
+        NSArray *records = [self.writeIndex valueAtPath:path];
+        records = (records != nil) ? [records arrayByAddingObject:record] : @[record];
+        self.writeIndex = [self.writeIndex setValue:records atPath:path];
+    }
+}
+
+- (void) unindexWrite:(FWriteRecord *)record {
+    for (FPath *path in [FWriteTree writtenPathsForRecord:record]) {
+        NSArray *records = [self.writeIndex valueAtPath:path];
+        NSIndexSet *remaining = [records indexesOfObjectsPassingTest:^BOOL(FWriteRecord *other, NSUInteger idx, BOOL *stop) {
+            return other.writeId != record.writeId;
+        }];
+        if (remaining.count > 0) {
+            self.writeIndex = [self.writeIndex setValue:[records objectsAtIndexes:remaining] atPath:path];
+        } else {
+            self.writeIndex = [self.writeIndex removeValueAtPath:path];
+        }
     }
 }
 
+/**
+* @return The writes changing the given path or anything below it (and, if includeAncestors is set, anything above
+* it), in writeId order.
+*/
+- (NSArray *) writesOverlappingPath:(FPath *)path includeAncestors:(BOOL)includeAncestors {
+    NSMutableDictionary *writesById = [NSMutableDictionary dictionary];
+    void (^collect)(FPath *, NSArray *) = ^(FPath *writtenPath, NSArray *records) {
+        for (FWriteRecord *record in records) {
+            writesById[@(record.writeId)] = record;
+        }
+    };
+    FImmutableTree *subtree;
+    if (includeAncestors) {
+        subtree = [self.writeIndex forEachOnPath:path performBlock:collect];
+    } else {
+        subtree = [self.writeIndex subtreeAtPath:path];
+    }
+    [subtree forEach:collect];
+    NSArray *writeIds = [writesById.allKeys sortedArrayUsingSelector:@selector(compare:)];
+    return [writesById objectsForKeys:writeIds notFoundMarker:[NSNull null]];
+}
+
+/**
+* Rebuilds visibleWrites for the subtree rooted at the highest visible write on the given path (or at the path itself
+* if there is none) from the writes in that subtree. Nothing outside that subtree can affect it.
+*/
+- (void) relayerWritesOverlappingPath:(FPath *)path {
+    FTuplePathValue *rootMost = [self.writeIndex findRootMostMatchingPath:path predicate:^BOOL(NSArray *records) {
+        return [records indexOfObjectPassingTest:^BOOL(FWriteRecord *record, NSUInteger idx, BOOL *stop) {
+            return record.visible;
+        }] != NSNotFound;
+    }];
+    FPath *layerRoot = (rootMost != nil) ? rootMost.path : path;
+    NSArray *writes = [self writesOverlappingPath:layerRoot includeAncestors:NO];
+    FCompoundWrite *layered = [FWriteTree layerTreeFromWrites:writes filter:[FWriteTree defaultFilter] treeRoot:layerRoot];
+    self.visibleWrites = [[self.visibleWrites removeWriteAtPath:layerRoot] addCompoundWrite:layered atPath:layerRoot];
+}
+
 /**
 * The default filter used when constructing the tree. Keep everything that's visible.
 */
@@ -401,7 +468,7 @@
     static dispatch_once_t filterToken;
     dispatch_once(&filterToken, ^{
         filter = ^(FWriteRecord *record) {
-            return YES;
+            return record.visible;
         };
     });
     return filter;
@@ -435,17 +502,11 @@
                     FPath *relativePath = [FPath relativePathFrom:treeRoot to:writePath];
                     compoundWrite = [compoundWrite addCompoundWrite:record.merge atPath:relativePath];
                 } else if ([writePath contains:treeRoot]) {
+                    // Take whatever part of the merge lands at or below the root path, whether it is a child of a
+                    // complete write above the root or one or more deeper writes.
                     FPath *relativePath = [FPath relativePathFrom:writePath to:treeRoot];
-                    if (relativePath.isEmpty) {
-                        compoundWrite = [compoundWrite addCompoundWrite:record.merge atPath:[FPath empty]];
-                    } else {
-                        id<FNode> child = [record.merge completeNodeAtPath:relativePath];
-                        if (child != nil) {
-                            // There exists a child in this node that matches the root path
-                            id<FNode> deepNode = [child getChild:[relativePath popFront]];
-                            compoundWrite = [compoundWrite addWrite:deepNode atPath:[FPath empty]];
-                        }
-                    }
+                    FCompoundWrite *childMerge = [record.merge childCompoundWriteAtPath:relativePath];
+                    compoundWrite = [compoundWrite addCompoundWrite:childMerge atPath:[FPath empty]];
                 } else {
                     // There is no overlap between root path and write path, ignore write
                 }
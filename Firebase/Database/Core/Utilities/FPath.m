@@ -21,7 +21,14 @@
 @interface FPath()
 
 @property (nonatomic, readwrite, assign) NSInteger pieceNum;
+/**
+* One past the index of the last piece of this path. Paths created by popFront and parent share their pieces array
+* with the path they came from and just narrow [pieceNum, pieceEnd).
+*/
+@property (nonatomic, readwrite, assign) NSInteger pieceEnd;
 @property (nonatomic, strong) NSArray * pieces;
+@property (nonatomic, strong) NSString *lazyString;
+@property (nonatomic, strong) NSNumber *lazyHashCode;
 
 @end
 
@@ -31,17 +38,46 @@
 #pragma mark Initializers
 
 + (FPath *) relativePathFrom:(FPath *)outer to:(FPath *)inner {
-    NSString* outerFront = [outer getFront];
-    NSString* innerFront = [inner getFront];
-    if (outerFront == nil) {
+    if (outer.isEmpty) {
         return inner;
-    } else if ([outerFront isEqualToString:innerFront]) {
-        return [self relativePathFrom:[outer popFront] to:[inner popFront]];
+    } else if ([outer contains:inner]) {
+        return [[FPath alloc] initWithPieces:inner.pieces start:inner.pieceNum + outer.length end:inner.pieceEnd];
     } else {
         @throw [[NSException alloc] initWithName:@"FirebaseDatabaseInternalError" reason:[NSString stringWithFormat:@"innerPath (%@) is not within outerPath (%@)", inner, outer] userInfo:nil];
     }
 }
 
+/**
+* Returns a shared instance of the given path segment, so that paths built from the same keys don't each hold their
+* own copy and compare their segments by pointer. Only short segments are interned; long ones are rarely repeated.
+*/
++ (NSString *) internedPiece:(NSString *)piece {
+    static NSCache *internedPieces;
+    static dispatch_once_t internedPiecesToken;
+    dispatch_once(&internedPiecesToken, ^{
+        internedPieces = [[NSCache alloc] init];
+        internedPieces.countLimit = 1000;
+    });
+    if (piece.length > 32) {
+        return piece;
+    }
+    NSString *interned = [internedPieces objectForKey:piece];
+    if (interned == nil) {
+        interned = [piece copy];
+        [internedPieces setObject:interned forKey:interned];
+    }
+    return interned;
+}
+
++ (void) appendPiecesOfString:(NSString *)path toArray:(NSMutableArray *)pieces {
+    NSArray *pathPieces = [path componentsSeparatedByString:@"/"];
+    for (NSString *piece in pathPieces) {
+        if (piece.length > 0) {
+            [pieces addObject:[self internedPiece:piece]];
+        }
+    }
+}
+
 + (FPath *)pathWithString:(NSString *)string
 {
     return [[FPath alloc] initWith:string];
@@ -51,26 +87,26 @@
 {
     self = [super init];
     if (self) {
-        NSArray *pathPieces = [path componentsSeparatedByString:@"/"];
         NSMutableArray *newPieces = [[NSMutableArray alloc] init];
-        for (NSInteger i = 0; i < pathPieces.count; i++) {
-            NSString *piece = [pathPieces objectAtIndex:i];
-            if (piece.length > 0) {
-                [newPieces addObject:piece];
-            }
-        }
+        [FPath appendPiecesOfString:path toArray:newPieces];
 
         self.pieces = newPieces;
         self.pieceNum = 0;
+        self.pieceEnd = newPieces.count;
     }
     return self;
 }
 
 - (id)initWithPieces:(NSArray *)somePieces andPieceNum:(NSInteger)aPieceNum {
+    return [self initWithPieces:somePieces start:aPieceNum end:somePieces.count];
+}
+
+- (id)initWithPieces:(NSArray *)somePieces start:(NSInteger)start end:(NSInteger)end {
     self = [super init];
     if (self) {
-        self.pieceNum = aPieceNum;
         self.pieces = somePieces;
+        self.pieceNum = start;
+        self.pieceEnd = end;
     }
     return self;
 }
@@ -89,7 +125,7 @@
 #pragma mark Public methods
 
 - (NSString *) getFront {
-    if(self.pieceNum >= self.pieces.count) {
+    if(self.pieceNum >= self.pieceEnd) {
         return nil;
     }
     return [self.pieces objectAtIndex:self.pieceNum];
@@ -99,20 +135,20 @@
 * @return The number of segments in this path
 */
 - (NSUInteger) length {
-    return self.pieces.count - self.pieceNum;
+    return self.pieceEnd - self.pieceNum;
 }
 
 - (FPath *) popFront {
     NSInteger newPieceNum = self.pieceNum;
-    if (newPieceNum < self.pieces.count) {
+    if (newPieceNum < self.pieceEnd) {
         newPieceNum++;
     }
-    return [[FPath alloc] initWithPieces:self.pieces andPieceNum:newPieceNum];
+    return [[FPath alloc] initWithPieces:self.pieces start:newPieceNum end:self.pieceEnd];
 }
 
 - (NSString *) getBack {
-    if(self.pieceNum < self.pieces.count) {
-        return [self.pieces lastObject];
+    if(self.pieceNum < self.pieceEnd) {
+        return [self.pieces objectAtIndex:self.pieceEnd - 1];
     }
     else {
         return nil;
@@ -120,26 +156,22 @@
 }
 
 - (NSString *) toString {
-    return [self toStringWithTrailingSlash:NO];
+    if (self.lazyString == nil) {
+        NSMutableString* pathString = [[NSMutableString alloc] init];
+        for(NSInteger i = self.pieceNum; i < self.pieceEnd; i++) {
+            [pathString appendString:@"/"];
+            [pathString appendString:[self.pieces objectAtIndex:i]];
+        }
+        self.lazyString = ([pathString length] == 0) ? @"/" : [pathString copy];
+    }
+    return self.lazyString;
 }
 
 - (NSString *) toStringWithTrailingSlash {
-    return [self toStringWithTrailingSlash:YES];
-}
-
-- (NSString *) toStringWithTrailingSlash:(BOOL)trailingSlash {
-    NSMutableString* pathString = [[NSMutableString alloc] init];
-    for(NSInteger i = self.pieceNum; i < self.pieces.count; i++) {
-        [pathString appendString:@"/"];
-        [pathString appendString:[self.pieces objectAtIndex:i]];
-    }
-    if ([pathString length] == 0) {
+    if ([self isEmpty]) {
         return @"/";
     } else {
-        if (trailingSlash) {
-            [pathString appendString:@"/"];
-        }
-        return pathString;
+        return [[self toString] stringByAppendingString:@"/"];
     }
 }
 
@@ -147,56 +179,41 @@
     if ([self isEmpty]) {
         return @"/";
     } else {
-        NSMutableString* pathString = [[NSMutableString alloc] init];
-        for (NSInteger i = self.pieceNum; i < self.pieces.count; i++) {
-            if (i > self.pieceNum) {
-                [pathString appendString:@"/"];
-            }
-            [pathString appendString:[self.pieces objectAtIndex:i]];
-        }
-        return pathString;
+        return [[self toString] substringFromIndex:1];
     }
 }
 
 - (FPath *) parent {
-    if(self.pieceNum >= self.pieces.count) {
+    if(self.pieceNum >= self.pieceEnd) {
         return nil;
     } else {
-        NSMutableArray* newPieces = [[NSMutableArray alloc] init];
-        for (NSInteger i = self.pieceNum; i < self.pieces.count - 1; i++) {
-            [newPieces addObject:[self.pieces objectAtIndex:i]];
-        }
-        return [[FPath alloc] initWithPieces:newPieces andPieceNum:0];
+        return [[FPath alloc] initWithPieces:self.pieces start:self.pieceNum end:self.pieceEnd - 1];
     }
 }
 
 - (FPath *) child:(FPath *)childPathObj {
-    NSMutableArray* newPieces = [[NSMutableArray alloc] init];
-    for (NSInteger i = self.pieceNum; i < self.pieces.count; i++) {
-        [newPieces addObject:[self.pieces objectAtIndex:i]];
+    if (childPathObj.isEmpty) {
+        return self;
+    } else if (self.isEmpty) {
+        return childPathObj;
     }
-
-    for (NSInteger i = childPathObj.pieceNum; i < childPathObj.pieces.count; i++) {
-        [newPieces addObject:[childPathObj.pieces objectAtIndex:i]];
-    }
-
+    NSMutableArray* newPieces = [[NSMutableArray alloc] initWithCapacity:self.length + childPathObj.length];
+    [newPieces addObjectsFromArray:[self.pieces subarrayWithRange:NSMakeRange(self.pieceNum, self.length)]];
+    [newPieces addObjectsFromArray:[childPathObj.pieces subarrayWithRange:NSMakeRange(childPathObj.pieceNum, childPathObj.length)]];
     return [[FPath alloc] initWithPieces:newPieces andPieceNum:0];
 }
 
 - (FPath *)childFromString:(NSString *)childPath {
-    NSMutableArray* newPieces = [[NSMutableArray alloc] init];
-    for (NSInteger i = self.pieceNum; i < self.pieces.count; i++) {
-        [newPieces addObject:[self.pieces objectAtIndex:i]];
-    }
-
-    NSArray *pathPieces = [childPath componentsSeparatedByString:@"/"];
-    for (unsigned int i = 0; i < pathPieces.count; i++) {
-        NSString *piece = [pathPieces objectAtIndex:i];
-        if (piece.length > 0) {
-            [newPieces addObject:piece];
+    NSMutableArray* newPieces = [[NSMutableArray alloc] initWithCapacity:self.length + 1];
+    [newPieces addObjectsFromArray:[self.pieces subarrayWithRange:NSMakeRange(self.pieceNum, self.length)]];
+    if ([childPath rangeOfString:@"/"].location == NSNotFound) {
+        // The common case of a single key.
+        if (childPath.length > 0) {
+            [newPieces addObject:[FPath internedPiece:childPath]];
         }
+    } else {
+        [FPath appendPiecesOfString:childPath toArray:newPieces];
     }
-
     return [[FPath alloc] initWithPieces:newPieces andPieceNum:0];
 }
 
@@ -204,7 +221,7 @@
 * @return True if there are no segments in this path
 */
 - (BOOL) isEmpty {
-    return self.pieceNum >= self.pieces.count;
+    return self.pieceNum >= self.pieceEnd;
 }
 
 /**
@@ -226,7 +243,7 @@
 
     NSInteger i = self.pieceNum;
     NSInteger j = other.pieceNum;
-    while (i < self.pieces.count) {
+    while (i < self.pieceEnd) {
         NSString* thisSeg = [self.pieces objectAtIndex:i];
         NSString* otherSeg = [other.pieces objectAtIndex:j];
         if (![thisSeg isEqualToString:otherSeg]) {
@@ -240,14 +257,14 @@
 
 - (void) enumerateComponentsUsingBlock:(void (^)(NSString *, BOOL *))block {
     BOOL stop = NO;
-    for (NSInteger i = self.pieceNum; !stop && i < self.pieces.count; i++) {
+    for (NSInteger i = self.pieceNum; !stop && i < self.pieceEnd; i++) {
         block(self.pieces[i], &stop);
     }
 }
 
 - (NSComparisonResult) compare:(FPath *)other {
-    NSInteger myCount = self.pieces.count;
-    NSInteger otherCount = other.pieces.count;
+    NSInteger myCount = self.pieceEnd;
+    NSInteger otherCount = other.pieceEnd;
     for (NSInteger i = self.pieceNum, j = other.pieceNum; i < myCount && j < otherCount; i++, j++) {
         NSComparisonResult comparison = [FUtilities compareKey:self.pieces[i] toKey:other.pieces[j]];
         if (comparison != NSOrderedSame) {
@@ -279,7 +296,10 @@
     if (self.length != otherPath.length) {
         return NO;
     }
-    for (NSUInteger i = self.pieceNum, j = otherPath.pieceNum; i < self.pieces.count; i++, j++) {
+    if (self.lazyHashCode != nil && otherPath.lazyHashCode != nil && ![self.lazyHashCode isEqualToNumber:otherPath.lazyHashCode]) {
+        return NO;
+    }
+    for (NSInteger i = self.pieceNum, j = otherPath.pieceNum; i < self.pieceEnd; i++, j++) {
         if (![self.pieces[i] isEqualToString:otherPath.pieces[j]]) {
             return NO;
         }
@@ -288,11 +308,15 @@
 }
 
 - (NSUInteger) hash {
-    NSUInteger hashCode = 0;
-    for (NSInteger i = self.pieceNum; i < self.pieces.count; i++) {
-        hashCode = hashCode * 37 + [self.pieces[i] hash];
+    // Cached, since paths are hashed over and over as dictionary keys.
+    if (self.lazyHashCode == nil) {
+        NSUInteger hashCode = 0;
+        for (NSInteger i = self.pieceNum; i < self.pieceEnd; i++) {
+            hashCode = hashCode * 37 + [self.pieces[i] hash];
+        }
+        self.lazyHashCode = @(hashCode);
     }
-    return hashCode;
+    return [self.lazyHashCode unsignedIntegerValue];
 }
 
 @end
@@ -104,16 +104,27 @@
 }
 
 - (void) forEachDescendant:(void (^)(FTree *))action includeSelf:(BOOL)incSelf childrenFirst:(BOOL)childFirst {
-    if(incSelf && !childFirst) {
-        action(self);
+    // Uses an explicit stack instead of recursing. Visiting children first runs the actions in the reverse of the
+    // parents first order, which still visits every tree after all of its descendants.
+    NSMutableArray* stack = [NSMutableArray arrayWithObject:self];
+    NSMutableArray* visited = childFirst ? [NSMutableArray array] : nil;
+    while (stack.count > 0) {
+        FTree* tree = [stack lastObject];
+        [stack removeLastObject];
+        if (tree != self || incSelf) {
+            if (childFirst) {
+                [visited addObject:tree];
+            } else {
+                action(tree);
+            }
+        }
+        [tree forEachChild:^(FTree* child) {
+            [stack addObject:child];
+        }];
     }
 
-    [self forEachChild:^(FTree* child) {
-        [child forEachDescendant:action includeSelf:YES childrenFirst:childFirst];
-    }];
-
-    if(incSelf && childFirst) {
-        action(self);
+    for (FTree* tree in [visited reverseObjectEnumerator]) {
+        action(tree);
     }
 }
 
@@ -133,14 +144,22 @@
 }
 
 - (void) forEachImmediateDescendantWithValue:(void (^)(FTree *))action {
-    [self forEachChild:^(FTree * child) {
-        if([child getValue] != nil) {
-            action(child);
+    NSMutableArray* stack = [NSMutableArray array];
+    [self forEachChild:^(FTree* child) {
+        [stack addObject:child];
+    }];
+    while (stack.count > 0) {
+        FTree* tree = [stack lastObject];
+        [stack removeLastObject];
+        if([tree getValue] != nil) {
+            action(tree);
         }
         else {
-            [child forEachImmediateDescendantWithValue:action];
+            [tree forEachChild:^(FTree* child) {
+                [stack addObject:child];
+            }];
         }
-    }];
+    }
 }
 
 - (BOOL) valueExistsAtOrAbove:(FPath *)path {
@@ -157,8 +176,14 @@
 }
 
 - (FPath *)path {
-    return [[FPath alloc] initWith:(self.parent == nil) ? self.name :
-            [NSString stringWithFormat:@"%@/%@", [self.parent path], self.name ]];
+    // Collect the names up to the root instead of building and reparsing a string for every ancestor
+    NSMutableArray* pieces = [NSMutableArray array];
+    for (FTree* tree = self; tree != nil; tree = tree.parent) {
+        if (tree.name.length > 0) {
+            [pieces addObject:tree.name];
+        }
+    }
+    return [[FPath alloc] initWithPieces:[[pieces reverseObjectEnumerator] allObjects] andPieceNum:0];
 }
 
 - (void) updateParents {
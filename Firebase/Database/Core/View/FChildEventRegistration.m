@@ -56,25 +56,26 @@
     return eventData;
 }
 
-- (void) fireEvent:(id <FEvent>)event queue:(dispatch_queue_t)queue {
+- (fbt_void_void) callbackForEvent:(id <FEvent>)event {
     if ([event isCancelEvent]) {
         FCancelEvent *cancelEvent = event;
         FFLog(@"I-RDB061001", @"Raising cancel value event on %@", event.path);
         NSAssert(self.cancelCallback != nil, @"Raising a cancel event on a listener with no cancel callback");
-        dispatch_async(queue, ^{
+        return ^{
             self.cancelCallback(cancelEvent.error);
-        });
+        };
     } else if (self.callbacks != nil) {
         FDataEvent *dataEvent = event;
         FFLog(@"I-RDB061002", @"Raising event callback (%ld) on %@", (long)dataEvent.eventType, dataEvent.path);
         fbt_void_datasnapshot_nsstring callback = [self.callbacks objectForKey:[NSNumber numberWithInteger:dataEvent.eventType]];
 
         if (callback != nil) {
-            dispatch_async(queue, ^{
+            return ^{
                 callback(dataEvent.snapshot, dataEvent.prevName);
-            });
+            };
         }
     }
+    return nil;
 }
 
 - (FCancelEvent *) createCancelEventFromError:(NSError *)error path:(FPath *)path {
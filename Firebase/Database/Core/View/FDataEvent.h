@@ -30,6 +30,11 @@
 - initWithEventType:(FIRDataEventType)type eventRegistration:(id<FEventRegistration>)eventRegistration
        dataSnapshot:(FIRDataSnapshot *)snapshot prevName:(NSString *)prevName;
 
+/**
+* Returns an event identical to this one, sharing its snapshot, but raised for the given registration.
+*/
+- (FDataEvent *) eventWithRegistration:(id<FEventRegistration>)registration;
+
 
 @property (nonatomic, strong, readonly) id<FEventRegistration> eventRegistration;
 @property (nonatomic, strong, readonly) FIRDataSnapshot * snapshot;
@@ -48,6 +48,13 @@
     return self;
 }
 
+- (FDataEvent *) eventWithRegistration:(id<FEventRegistration>)registration {
+    return [[FDataEvent alloc] initWithEventType:self.eventType
+                               eventRegistration:registration
+                                    dataSnapshot:self.snapshot
+                                        prevName:self.prevName];
+}
+
 - (FPath *) path {
     // Used for logging, so delay calculation
     FIRDatabaseReference *ref = self.snapshot.ref;
@@ -58,8 +65,8 @@
     }
 }
 
-- (void) fireEventOnQueue:(dispatch_queue_t)queue {
-    [self.eventRegistration fireEvent:self queue:queue];
+- (fbt_void_void) eventCallback {
+    return [self.eventRegistration callbackForEvent:self];
 }
 
 - (BOOL) isCancelEvent {
@@ -16,12 +16,16 @@
 
 #import <Foundation/Foundation.h>
 #import "FIRDataEventType.h"
+#import "FTypedefs.h"
 
 @class FPath;
 
 @protocol FEvent <NSObject>
 - (FPath *) path;
-- (void) fireEventOnQueue:(dispatch_queue_t)queue;
+/**
+* @return A block that calls the user's callback for this event, or nil if there is nothing to call.
+*/
+- (fbt_void_void) eventCallback;
 - (BOOL) isCancelEvent;
 - (NSString *) description;
 @end
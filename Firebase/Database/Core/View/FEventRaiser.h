@@ -28,6 +28,13 @@
 
 - (id)initWithQueue:(dispatch_queue_t)queue;
 
+/**
+* When set, events and callbacks raised while the worker queue still has work pending are held back until that work
+* is done and then dispatched together, dropping any child_changed event that a later child_changed event for the same
+* listener and child supersedes. This delays events by however long the pending work takes, so it is off by default.
+*/
+@property (nonatomic) BOOL coalesceChildChangedEvents;
+
 - (void) raiseEvents:(NSArray *)eventDataList;
 - (void) raiseCallback:(fbt_void_void)callback;
 - (void) raiseCallbacks:(NSArray *)callbackList;
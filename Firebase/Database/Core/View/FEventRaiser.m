@@ -21,10 +21,15 @@
 #import "FTupleUserCallback.h"
 #import "FRepo.h"
 #import "FRepoManager.h"
+#import "FIRDatabaseQuery_Private.h"
 
 @interface FEventRaiser ()
 
 @property (nonatomic, strong) dispatch_queue_t queue;
+/**
+* Events (id<FEvent>) and callbacks (fbt_void_void) held back until the next flush when coalescing.
+*/
+@property (nonatomic, strong) NSMutableArray *pendingEventsAndCallbacks;
 
 @end
 
@@ -48,19 +53,97 @@
 }
 
 - (void) raiseEvents:(NSArray *)eventDataList {
-    for (id<FEvent> event in eventDataList) {
-        [event fireEventOnQueue:self.queue];
+    if (self.coalesceChildChangedEvents) {
+        [self enqueueEventsAndCallbacks:eventDataList];
+    } else {
+        [self dispatchCallbacks:[FEventRaiser callbacksForEventsAndCallbacks:eventDataList]];
     }
 }
 
 - (void) raiseCallback:(fbt_void_void)callback {
-    dispatch_async(self.queue, callback);
+    if (self.coalesceChildChangedEvents) {
+        [self enqueueEventsAndCallbacks:@[callback]];
+    } else {
+        dispatch_async(self.queue, callback);
+    }
 }
 
 - (void) raiseCallbacks:(NSArray *)callbackList {
-    for (fbt_void_void callback in callbackList) {
-        dispatch_async(self.queue, callback);
+    if (self.coalesceChildChangedEvents) {
+        [self enqueueEventsAndCallbacks:callbackList];
+    } else {
+        [self dispatchCallbacks:callbackList];
+    }
+}
+
+/**
+* Dispatches the callbacks to the callback queue as a single block rather than one block each, so a large batch of
+* events doesn't flood the queue.
+*/
+- (void) dispatchCallbacks:(NSArray *)callbacks {
+    if (callbacks.count == 1) {
+        dispatch_async(self.queue, callbacks[0]);
+    } else if (callbacks.count > 1) {
+        dispatch_async(self.queue, ^{
+            for (fbt_void_void callback in callbacks) {
+                callback();
+            }
+        });
+    }
+}
+
+- (void) enqueueEventsAndCallbacks:(NSArray *)eventsAndCallbacks {
+    if (eventsAndCallbacks.count == 0) {
+        return;
+    }
+    if (self.pendingEventsAndCallbacks == nil) {
+        self.pendingEventsAndCallbacks = [NSMutableArray array];
+        // Events are raised from the worker queue, so this runs once the work already queued there is done
+        dispatch_async([FIRDatabaseQuery sharedQueue], ^{
+            [self flushPendingEventsAndCallbacks];
+        });
+    }
+    [self.pendingEventsAndCallbacks addObjectsFromArray:eventsAndCallbacks];
+}
+
+- (void) flushPendingEventsAndCallbacks {
+    NSArray *pending = self.pendingEventsAndCallbacks;
+    self.pendingEventsAndCallbacks = nil;
+
+    // Walk backwards so the last child_changed event for each listener and child is the one that's kept
+    NSMutableSet *changedChildren = [NSMutableSet set];
+    NSMutableArray *coalesced = [NSMutableArray arrayWithCapacity:pending.count];
+    for (id eventOrCallback in [pending reverseObjectEnumerator]) {
+        if ([eventOrCallback isKindOfClass:[FDataEvent class]] &&
+            ((FDataEvent *)eventOrCallback).eventType == FIRDataEventTypeChildChanged) {
+            FDataEvent *event = eventOrCallback;
+            NSString *changedChild = [NSString stringWithFormat:@"%p:%@", event.eventRegistration, event.snapshot.key];
+            if ([changedChildren containsObject:changedChild]) {
+                continue;
+            }
+            [changedChildren addObject:changedChild];
+        }
+        [coalesced addObject:eventOrCallback];
+    }
+    if (coalesced.count < pending.count) {
+        FFLog(@"I-RDB063001", @"Dropped %lu superseded child_changed events", (unsigned long)(pending.count - coalesced.count));
+    }
+    [self dispatchCallbacks:[FEventRaiser callbacksForEventsAndCallbacks:[[coalesced reverseObjectEnumerator] allObjects]]];
+}
+
++ (NSArray *) callbacksForEventsAndCallbacks:(NSArray *)eventsAndCallbacks {
+    NSMutableArray *callbacks = [NSMutableArray arrayWithCapacity:eventsAndCallbacks.count];
+    for (id eventOrCallback in eventsAndCallbacks) {
+        if ([eventOrCallback conformsToProtocol:@protocol(FEvent)]) {
+            fbt_void_void callback = [(id<FEvent>)eventOrCallback eventCallback];
+            if (callback != nil) {
+                [callbacks addObject:callback];
+            }
+        } else {
+            [callbacks addObject:eventOrCallback];
+        }
     }
+    return callbacks;
 }
 
 + (void) raiseCallbacks:(NSArray *)callbackList queue:(dispatch_queue_t)queue {
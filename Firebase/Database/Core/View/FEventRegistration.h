@@ -17,6 +17,7 @@
 #import <Foundation/Foundation.h>
 #import "FChange.h"
 #import "FIRDataEventType.h"
+#import "FTypedefs.h"
 
 @protocol FEvent;
 @class FDataEvent;
@@ -26,7 +27,7 @@
 @protocol FEventRegistration <NSObject>
 - (BOOL) responseTo:(FIRDataEventType)eventType;
 - (FDataEvent *) createEventFrom:(FChange *)change query:(FQuerySpec *)query;
-- (void) fireEvent:(id<FEvent>)event queue:(dispatch_queue_t)queue;
+- (fbt_void_void) callbackForEvent:(id<FEvent>)event;
 - (FCancelEvent *) createCancelEventFromError:(NSError *)error path:(FPath *)path;
 /**
 * Used to figure out what event registration match the event registration that needs to be removed.
@@ -40,8 +40,9 @@
     return nil;
 }
 
-- (void) fireEvent:(id<FEvent>)event queue:(dispatch_queue_t)queue {
+- (fbt_void_void) callbackForEvent:(id<FEvent>)event {
     [NSException raise:NSInternalInconsistencyException format:@"Should never raise event for FKeepSyncedEventRegistration"];
+    return nil;
 }
 
 - (FCancelEvent *) createCancelEventFromError:(NSError *)error path:(FPath *)path {
@@ -113,29 +113,40 @@
     }];
 
     for (FChange *change in filteredChanges) {
+        // The events for one change differ only in their registration, so the change is
+        // materialized once and the event (with its snapshot) is shared by the registrations of
+        // the same class. Each further registration then costs just a small event object.
+        FChange *materializedChange = nil;
+        FDataEvent *sharedEvent = nil;
         for (id<FEventRegistration> registration in registrations) {
-            if ([registration responseTo:eventType]) {
-                id<FEvent> event = [self generateEventForChange:change registration:registration eventCache:eventCache];
-                [events addObject:event];
+            if (![registration responseTo:eventType]) {
+                continue;
+            }
+            if (materializedChange == nil) {
+                materializedChange = [self materializeChange:change eventCache:eventCache];
+            }
+            if (sharedEvent != nil && [registration class] == [sharedEvent.eventRegistration class]) {
+                [events addObject:[sharedEvent eventWithRegistration:registration]];
+            } else {
+                sharedEvent = [registration createEventFrom:materializedChange query:self.query];
+                [events addObject:sharedEvent];
             }
         }
     }
 }
 
-- (id<FEvent>) generateEventForChange:(FChange *)change
-                         registration:(id<FEventRegistration>)registration
-                           eventCache:(FIndexedNode *)eventCache
+/**
+* Fills in the previous child key of a child change, based on the index ordering.
+*/
+- (FChange *) materializeChange:(FChange *)change eventCache:(FIndexedNode *)eventCache
 {
-    FChange *materializedChange;
     if (change.type == FIRDataEventTypeValue || change.type == FIRDataEventTypeChildRemoved) {
-        materializedChange = change;
-    } else {
-        NSString *prevChildKey = [eventCache predecessorForChildKey:change.childKey
-                                                          childNode:change.indexedNode.node
-                                                              index:self.query.index];
-        materializedChange = [change changeWithPrevKey:prevChildKey];
+        return change;
     }
-    return [registration createEventFrom:materializedChange query:self.query];
+    NSString *prevChildKey = [eventCache predecessorForChildKey:change.childKey
+                                                      childNode:change.indexedNode.node
+                                                          index:self.query.index];
+    return [change changeWithPrevKey:prevChildKey];
 }
 
 @end
@@ -22,6 +22,12 @@
 - (BOOL)shouldCheckCacheSize:(NSUInteger)serverUpdatesSinceLastCheck;
 - (float)percentOfQueriesToPruneAtOnce;
 - (NSUInteger)maxNumberOfQueriesToKeep;
+/**
+ * How much of a cache of the given size to free in one prune check. When this is non-zero, queries are pruned by
+ * weight (size on disk and time since last use) until roughly this many bytes are freed; when it is zero, the oldest
+ * percentOfQueriesToPruneAtOnce of queries are pruned.
+ */
+- (NSUInteger)bytesToPruneFromCacheWithSize:(NSUInteger)cacheSize;
 
 @end
 
@@ -25,6 +25,10 @@
 static const NSUInteger kFServerUpdatesBetweenCacheSizeChecks = 1000;
 static const NSUInteger kFMaxNumberOfPrunableQueriesToKeep = 1000;
 static const float kFPercentOfQueriesToPruneAtOnce = 0.2f;
+// Once over the max size, prune down to this fraction of it, so that the next few updates don't trigger another prune
+static const float kFFractionOfMaxSizeToPruneTo = 0.8f;
+// Never free more than this fraction of the cache in one check, however far over the max size it is
+static const float kFMaxFractionOfCacheToPruneAtOnce = 0.25f;
 
 @implementation FLRUCachePolicy
 
@@ -52,6 +56,14 @@ static const float kFPercentOfQueriesToPruneAtOnce = 0.2f;
     return kFMaxNumberOfPrunableQueriesToKeep;
 }
 
+- (NSUInteger)bytesToPruneFromCacheWithSize:(NSUInteger)cacheSize {
+    NSUInteger targetSize = (NSUInteger)(self.maxSize * kFFractionOfMaxSizeToPruneTo);
+    if (cacheSize <= targetSize) {
+        return 0;
+    }
+    return MIN(cacheSize - targetSize, (NSUInteger)(cacheSize * kFMaxFractionOfCacheToPruneAtOnce));
+}
+
 @end
 
 @implementation FNoCachePolicy
@@ -76,4 +88,8 @@ static const float kFPercentOfQueriesToPruneAtOnce = 0.2f;
     return NSUIntegerMax;
 }
 
+- (NSUInteger)bytesToPruneFromCacheWithSize:(NSUInteger)cacheSize {
+    return 0;
+}
+
 @end
@@ -34,11 +34,15 @@
 @property (nonatomic, strong) NSString *basePath;
 @property (nonatomic, strong) APLevelDB *writesDB;
 @property (nonatomic, strong) APLevelDB *serverCacheDB;
+// Serialized tracked queries by query id that haven't been written to disk yet
+@property (nonatomic, strong) NSMutableDictionary *pendingTrackedQueries;
 
 @end
 
 // WARNING: If you change this, you need to write a migration script
-static NSString * const kFPersistenceVersion = @"1";
+static NSString * const kFPersistenceVersion = @"2";
+// Version 1 stored server cache rows as JSON
+static NSString * const kFPersistenceVersionJSONServerCache = @"1";
 
 static NSString * const kFServerDBPath = @"server_data";
 static NSString * const kFWritesDBPath = @"writes";
@@ -65,6 +69,38 @@ static NSString * const kFTrackedQueryKeysPrefix = @"/tracked_query_keys/";
 // Failed to load JSON because a valid JSON turns out to be NaN while deserializing
 static const NSInteger kFNanFailureCode = 3840;
 
+// The server cache stores each node as a single row holding its leaves and small children. Children
+// that cost more than kFServerCacheMaxInlineCost are split out into rows of their own underneath it, so a large tree
+// takes a handful of rows rather than one row per leaf. Every leaf costs one, plus one per
+// kFServerCacheCharactersPerCost characters of string data.
+//
+// A row replaces whatever the rows above it store at its path, so writing a subtree never needs to rewrite the rows
+// of its ancestors. Rows written by older versions hold one leaf each, which reads back the same way.
+static const NSUInteger kFServerCacheMaxInlineCost = 1000;
+static const NSUInteger kFServerCacheCharactersPerCost = 64;
+
+// Row values are encoded as a tag byte followed by the value: objects as a varint count of children followed by each
+// key and child, strings as a varint length followed by UTF-8, integers as a zigzag varint and doubles as their 8 little
+// endian bytes. None of the tags are characters that JSON can start with, so rows that predate the encoding are still
+// recognized.
+static const uint8_t kFServerCacheTagObject = 1;
+static const uint8_t kFServerCacheTagString = 2;
+static const uint8_t kFServerCacheTagInteger = 3;
+static const uint8_t kFServerCacheTagDouble = 4;
+static const uint8_t kFServerCacheTagTrue = 5;
+static const uint8_t kFServerCacheTagFalse = 6;
+
+// Tracked query keys are stored in blocks of sorted keys, each row keyed by the first key of its block and holding
+// this tag followed by every key as a varint length and UTF-8. A block that grows past twice the block size is split.
+// Rows written by older versions hold just their own key as a plain string and read back as a block of one.
+static const uint8_t kFTrackedQueryKeysBlockTag = 1;
+static const NSUInteger kFTrackedQueryKeysPerBlock = 64;
+
+// Tracked queries are saved every time a query is listened to or stops being listened to, and they are only read back
+// when the client starts, so saving one doesn't touch the disk. The saves go out with the next batch the server cache
+// commits, or on their own once this many are pending or the engine is flushed or closed.
+static const NSUInteger kFTrackedQueriesMaxPending = 100;
+
 static NSString* writeRecordKey(NSUInteger writeId) {
     return [NSString stringWithFormat:@"%lu", (unsigned long)(writeId)];
 }
@@ -73,6 +109,12 @@ static NSString* serverCacheKey(FPath *path) {
     return [NSString stringWithFormat:@"%@%@", kFServerCachePrefix, ([path toStringWithTrailingSlash])];
 }
 
+// Orders keys the way leveldb's default bytewise comparator does
+static NSComparisonResult compareServerCacheKeys(NSString *key1, NSString *key2) {
+    int result = strcmp(key1.UTF8String, key2.UTF8String);
+    return result < 0 ? NSOrderedAscending : (result > 0 ? NSOrderedDescending : NSOrderedSame);
+}
+
 static NSString* trackedQueryKey(NSUInteger trackedQueryId) {
     return [NSString stringWithFormat:@"%@%lu", kFTrackedQueriesPrefix, (unsigned long)trackedQueryId];
 }
@@ -85,6 +127,171 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     return [NSString stringWithFormat:@"%@%lu/%@", kFTrackedQueryKeysPrefix, (unsigned long)trackedQueryId, key];
 }
 
+static NSArray *pathPieces(FPath *path) {
+    NSMutableArray *pieces = [NSMutableArray arrayWithCapacity:path.length];
+    [path enumerateComponentsUsingBlock:^(NSString *key, BOOL *stop) {
+        [pieces addObject:key];
+    }];
+    return pieces;
+}
+
+static id valueAtPieces(id value, NSArray *pieces) {
+    for (NSString *piece in pieces) {
+        if (![value isKindOfClass:[NSDictionary class]]) {
+            return nil;
+        }
+        value = value[piece];
+    }
+    return value;
+}
+
+// Returns the value with the given pieces replaced, copying the dictionaries on the way down unless they are in
+// owned, which holds those already copied
+static id valueBySettingValueAtPieces(id value, NSArray *pieces, NSUInteger index, id newValue, NSHashTable *owned) {
+    if (index == pieces.count) {
+        return newValue;
+    }
+    NSMutableDictionary *dictionary;
+    if ([value isKindOfClass:[NSDictionary class]] && [owned containsObject:value]) {
+        dictionary = value;
+    } else {
+        dictionary = [value isKindOfClass:[NSDictionary class]] ? [value mutableCopy] : [NSMutableDictionary dictionary];
+        [owned addObject:dictionary];
+    }
+    NSString *piece = pieces[index];
+    dictionary[piece] = valueBySettingValueAtPieces(dictionary[piece], pieces, index + 1, newValue, owned);
+    return dictionary;
+}
+
+static void appendVarint(NSMutableData *data, uint64_t value) {
+    uint8_t bytes[10];
+    NSUInteger length = 0;
+    while (value >= 0x80) {
+        bytes[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[length++] = (uint8_t)value;
+    [data appendBytes:bytes length:length];
+}
+
+static void appendString(NSMutableData *data, NSString *string) {
+    NSData *utf8 = [string dataUsingEncoding:NSUTF8StringEncoding];
+    appendVarint(data, utf8.length);
+    [data appendData:utf8];
+}
+
+static void appendServerCacheValue(NSMutableData *data, id value) {
+    uint8_t tag;
+    if ([value isKindOfClass:[NSDictionary class]]) {
+        tag = kFServerCacheTagObject;
+        [data appendBytes:&tag length:1];
+        appendVarint(data, [value count]);
+        [value enumerateKeysAndObjectsUsingBlock:^(NSString *key, id child, BOOL *stop) {
+            appendString(data, key);
+            appendServerCacheValue(data, child);
+        }];
+    } else if ([value isKindOfClass:[NSString class]]) {
+        tag = kFServerCacheTagString;
+        [data appendBytes:&tag length:1];
+        appendString(data, value);
+    } else if (value == (id)kCFBooleanTrue || value == (id)kCFBooleanFalse) {
+        tag = value == (id)kCFBooleanTrue ? kFServerCacheTagTrue : kFServerCacheTagFalse;
+        [data appendBytes:&tag length:1];
+    } else if ([value isKindOfClass:[NSNumber class]] && !CFNumberIsFloatType((CFNumberRef)value) &&
+               !(strcmp([value objCType], @encode(unsigned long long)) == 0 && [value unsignedLongLongValue] > LLONG_MAX)) {
+        tag = kFServerCacheTagInteger;
+        [data appendBytes:&tag length:1];
+        int64_t integer = [value longLongValue];
+        appendVarint(data, ((uint64_t)integer << 1) ^ (uint64_t)(integer >> 63));
+    } else if ([value isKindOfClass:[NSNumber class]]) {
+        tag = kFServerCacheTagDouble;
+        [data appendBytes:&tag length:1];
+        double number = [value doubleValue];
+        uint64_t bits;
+        memcpy(&bits, &number, sizeof(bits));
+        bits = CFSwapInt64HostToLittle(bits);
+        [data appendBytes:&bits length:sizeof(bits)];
+    } else {
+        [NSException raise:NSInternalInconsistencyException format:@"Failed to serialize value: %@", value];
+    }
+}
+
+static BOOL readVarint(const uint8_t **cursor, const uint8_t *end, uint64_t *value) {
+    uint64_t result = 0;
+    for (NSUInteger shift = 0; shift < 64; shift += 7) {
+        if (*cursor == end) {
+            return NO;
+        }
+        uint8_t byte = *(*cursor)++;
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return YES;
+        }
+    }
+    return NO;
+}
+
+static NSString *readString(const uint8_t **cursor, const uint8_t *end) {
+    uint64_t length;
+    if (!readVarint(cursor, end, &length) || length > (uint64_t)(end - *cursor)) {
+        return nil;
+    }
+    NSString *string = [[NSString alloc] initWithBytes:*cursor length:(NSUInteger)length encoding:NSUTF8StringEncoding];
+    *cursor += length;
+    return string;
+}
+
+// Returns the value at the cursor and advances past it, or nil if the data is malformed
+static id readServerCacheValue(const uint8_t **cursor, const uint8_t *end) {
+    if (*cursor == end) {
+        return nil;
+    }
+    uint8_t tag = *(*cursor)++;
+    if (tag == kFServerCacheTagObject) {
+        uint64_t count;
+        // Every child takes at least two bytes, which bounds the capacity of a malformed count
+        if (!readVarint(cursor, end, &count) || count > (uint64_t)(end - *cursor) / 2) {
+            return nil;
+        }
+        NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:(NSUInteger)count];
+        for (uint64_t i = 0; i < count; i++) {
+            NSString *key = readString(cursor, end);
+            id child = key != nil ? readServerCacheValue(cursor, end) : nil;
+            if (child == nil) {
+                return nil;
+            }
+            dictionary[key] = child;
+        }
+        return dictionary;
+    } else if (tag == kFServerCacheTagString) {
+        return readString(cursor, end);
+    } else if (tag == kFServerCacheTagInteger) {
+        uint64_t zigzag;
+        if (!readVarint(cursor, end, &zigzag)) {
+            return nil;
+        }
+        return @((int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1));
+    } else if (tag == kFServerCacheTagDouble) {
+        uint64_t bits;
+        if ((NSUInteger)(end - *cursor) < sizeof(bits)) {
+            return nil;
+        }
+        memcpy(&bits, *cursor, sizeof(bits));
+        *cursor += sizeof(bits);
+        bits = CFSwapInt64LittleToHost(bits);
+        double number;
+        memcpy(&number, &bits, sizeof(number));
+        return @(number);
+    } else if (tag == kFServerCacheTagTrue) {
+        return @YES;
+    } else if (tag == kFServerCacheTagFalse) {
+        return @NO;
+    } else {
+        return nil;
+    }
+}
+
 @implementation FLevelDBStorageEngine
 #pragma mark - Constructors
 
@@ -93,24 +300,28 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     self = [super init];
     if (self) {
         self.basePath = [[FLevelDBStorageEngine firebaseDir] stringByAppendingPathComponent:dbPath];
+        self.pendingTrackedQueries = [NSMutableDictionary dictionary];
         /* For reference:
          serverDataDB = [aPersistence createDbByName:@"server_data"];
          FPangolinDB *completenessDb = [aPersistence createDbByName:@"server_complete"];
          */
         [FLevelDBStorageEngine ensureDir:self.basePath markAsDoNotBackup:YES];
-        [self runMigration];
         [self openDatabases];
+        [self runMigration];
     }
     return self;
 }
 
 - (void)runMigration {
-    // Currently we're at version 1, so all we need to do is write that to a file
     NSString *versionFile = [self.basePath stringByAppendingPathComponent:@"version"];
     NSError *error;
     NSString *oldVersion = [NSString stringWithContentsOfFile:versionFile encoding:NSUTF8StringEncoding error:&error];
-    if (!oldVersion) {
-        // This is probably fine, we don't have a version file yet
+    if (!oldVersion || [oldVersion isEqualToString:kFPersistenceVersionJSONServerCache]) {
+        // Without a version file this is probably a new database. Rows that are still JSON read back either way, so
+        // the version is only written once they have all been converted.
+        if (oldVersion) {
+            [self migrateServerCacheFromJSON];
+        }
         BOOL success = [kFPersistenceVersion writeToFile:versionFile atomically:NO encoding:NSUTF8StringEncoding error:&error];
         if (!success) {
             FFWarn(@"I-RDB076001", @"Failed to write version for database: %@", error);
@@ -123,6 +334,31 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     }
 }
 
+- (void)migrateServerCacheFromJSON {
+    NSDate *start = [NSDate date];
+    __block NSUInteger migrated = 0;
+    __block id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    [self.serverCacheDB enumerateKeysWithPrefix:kFServerCachePrefix asData:^(NSString *key, NSData *data, BOOL *stop) {
+        id value = [self deserializePrimitive:data];
+        if (value == [NSNull null]) {
+            [batch removeKey:key];
+        } else {
+            [batch setData:[self serializePrimitive:value] forKey:key];
+        }
+        // Commit as we go so that large caches don't build up one huge batch
+        if (++migrated % 1000 == 0) {
+            [batch commit];
+            batch = [self.serverCacheDB beginWriteBatch];
+        }
+    }];
+    BOOL success = [batch commit];
+    if (!success) {
+        FFWarn(@"I-RDB076037", @"Failed to migrate server cache on disk!");
+    } else {
+        FFDebug(@"I-RDB076038", @"Migrated %lu server cache rows in %fms", (unsigned long)migrated, [start timeIntervalSinceNow]*-1000);
+    }
+}
+
 - (void)runLegacyMigration:(FRepoInfo *)info {
     NSArray *dirPaths = NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES);
     NSString *documentsDir = [dirPaths objectAtIndex:0];
@@ -200,7 +436,24 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     [self openDatabases];
 }
 
+- (void)flush {
+    if (self.pendingTrackedQueries.count == 0) {
+        return;
+    }
+    NSDate *start = [NSDate date];
+    NSUInteger count = self.pendingTrackedQueries.count;
+    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    [self addPendingTrackedQueriesToBatch:batch];
+    BOOL success = [batch commit];
+    if (!success) {
+        FFWarn(@"I-RDB076039", @"Failed to save tracked queries on disk!");
+    } else {
+        FFDebug(@"I-RDB076040", @"Saved %lu tracked queries in %fms", (unsigned long)count, [start timeIntervalSinceNow]*-1000);
+    }
+}
+
 - (void)close {
+    [self flush];
     // autoreleasepool will cause deallocation which will close the DB
     @autoreleasepool {
         [self.serverCacheDB close];
@@ -304,16 +557,22 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
         } else {
             NSInteger writeId = ((NSNumber *)writeJSON[kFUserWriteId]).integerValue;
             FPath *path = [FPath pathWithString:writeJSON[kFUserWritePath]];
+            // Building the nodes is what makes loading thousands of writes slow, so it's deferred until a write is
+            // actually replayed. Writes that get compacted away are never built at all.
             FWriteRecord *writeRecord;
-            if (writeJSON[kFUserWriteMerge] != nil) {
+            id mergeJSON = writeJSON[kFUserWriteMerge];
+            if (mergeJSON != nil) {
                 // It's a merge
-                FCompoundWrite *merge = [FCompoundWrite compoundWriteWithValueDictionary:writeJSON[kFUserWriteMerge]];
-                writeRecord = [[FWriteRecord alloc] initWithPath:path merge:merge writeId:writeId];
+                writeRecord = [[FWriteRecord alloc] initWithPath:path writeId:writeId isMerge:YES decoder:^id {
+                    return [FCompoundWrite compoundWriteWithValueDictionary:mergeJSON];
+                }];
             } else {
                 // It's an overwrite
-                NSAssert(writeJSON[kFUserWriteOverwrite] != nil, @"Persisted write did not contain merge or overwrite!");
-                id<FNode> node = [FSnapshotUtilities nodeFrom:writeJSON[kFUserWriteOverwrite]];
-                writeRecord = [[FWriteRecord alloc] initWithPath:path overwrite:node writeId:writeId visible:YES];
+                id overwriteJSON = writeJSON[kFUserWriteOverwrite];
+                NSAssert(overwriteJSON != nil, @"Persisted write did not contain merge or overwrite!");
+                writeRecord = [[FWriteRecord alloc] initWithPath:path writeId:writeId isMerge:NO decoder:^id {
+                    return [FSnapshotUtilities nodeFrom:overwriteJSON];
+                }];
             }
             [writes addObject:writeRecord];
         }
@@ -334,7 +593,7 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 
 - (id<FNode>)serverCacheAtPath:(FPath *)path {
     NSDate *start = [NSDate date];
-    id data = [self internalNestedDataForPath:path];
+    id data = [self internalNestedDataForPath:path rowCache:nil];
     id<FNode> node = [FSnapshotUtilities nodeFrom:data];
     FFDebug(@"I-RDB076015", @"Loaded node with %d children at %@ in %fms", [node numChildren], path, [start timeIntervalSinceNow]*-1000);
     return node;
@@ -342,65 +601,78 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 
 - (id<FNode>)serverCacheForKeys:(NSSet *)keys atPath:(FPath *)path {
     NSDate *start = [NSDate date];
-    __block id<FNode> node = [FEmptyNode emptyNode];
-    [keys enumerateObjectsUsingBlock:^(NSString *key, BOOL *stop) {
-        id data = [self internalNestedDataForPath:[path childFromString:key]];
-        node = [node updateImmediateChild:key withNewChild:[FSnapshotUtilities nodeFrom:data]];
+    id<FNode> node = [FEmptyNode emptyNode];
+    // All the keys share the rows at and above the path, so only load those once
+    NSMutableDictionary *rowCache = [NSMutableDictionary dictionary];
+
+    // Visit the children in the database's key order, so that reading their rows is one forward pass of a single
+    // iterator rather than a new iterator and seek for each key
+    NSMutableArray *childPaths = [NSMutableArray arrayWithCapacity:keys.count];
+    for (NSString *key in keys) {
+        [childPaths addObject:[path childFromString:key]];
+    }
+    [childPaths sortUsingComparator:^NSComparisonResult(FPath *path1, FPath *path2) {
+        return compareServerCacheKeys(serverCacheKey(path1), serverCacheKey(path2));
     }];
+    APLevelDBIterator *iterator = [APLevelDBIterator iteratorWithLevelDB:self.serverCacheDB];
+    BOOL positioned = NO;
+    for (FPath *childPath in childPaths) {
+        id data = [self internalNestedDataForPath:childPath rowCache:rowCache iterator:iterator positioned:&positioned];
+        node = [node updateImmediateChild:[childPath getBack] withNewChild:[FSnapshotUtilities nodeFrom:data]];
+    }
     FFDebug(@"I-RDB076016", @"Loaded node with %d children for %lu keys at %@ in %fms", [node numChildren], (unsigned long)keys.count, path, [start timeIntervalSinceNow]*-1000);
     return node;
 }
 
 - (void)updateServerCache:(id<FNode>)node atPath:(FPath *)path merge:(BOOL)merge {
     NSDate *start = [NSDate date];
-    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
-    // Remove any leaf nodes that might be higher up
-    [self removeAllLeafNodesOnPath:path batch:batch];
+    NSMutableDictionary *rows = [NSMutableDictionary dictionary];
     __block NSUInteger counter = 0;
     if (merge) {
         // remove any children that exist
         [node enumerateChildrenUsingBlock:^(NSString *childKey, id<FNode> childNode, BOOL *stop) {
             FPath *childPath = [path childFromString:childKey];
-            [self removeAllWithPrefix:serverCacheKey(childPath) batch:batch database:self.serverCacheDB];
-            [self saveNodeInternal:childNode atPath:childPath batch:batch counter:&counter];
+            [self removeAllWithPrefix:serverCacheKey(childPath) rows:rows];
+            [self saveNodeInternal:childNode atPath:childPath rows:rows counter:&counter];
         }];
     } else {
         // remove everything
-        [self removeAllWithPrefix:serverCacheKey(path) batch:batch database:self.serverCacheDB];
-        [self saveNodeInternal:node atPath:path batch:batch counter:&counter];
+        [self removeAllWithPrefix:serverCacheKey(path) rows:rows];
+        [self saveNodeInternal:node atPath:path rows:rows counter:&counter];
     }
-    BOOL success = [batch commit];
+    BOOL success = [self commitServerCacheRows:rows];
     if (!success) {
         FFWarn(@"I-RDB076017", @"Failed to update server cache on disk!");
     } else {
-        FFDebug(@"I-RDB076018", @"Saved %lu leaf nodes for overwrite in %fms", (unsigned long)counter, [start timeIntervalSinceNow]*-1000);
+        FFDebug(@"I-RDB076018", @"Saved %lu rows for overwrite in %fms", (unsigned long)counter, [start timeIntervalSinceNow]*-1000);
     }
 }
 
 - (void)updateServerCacheWithMerge:(FCompoundWrite *)merge atPath:(FPath *)path {
     NSDate *start = [NSDate date];
     __block NSUInteger counter = 0;
-    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
-    // Remove any leaf nodes that might be higher up
-    [self removeAllLeafNodesOnPath:path batch:batch];
+    NSMutableDictionary *rows = [NSMutableDictionary dictionary];
     [merge enumerateWrites:^(FPath *relativePath, id<FNode> node, BOOL *stop) {
         FPath *childPath = [path child:relativePath];
-        [self removeAllWithPrefix:serverCacheKey(childPath) batch:batch database:self.serverCacheDB];
-        [self saveNodeInternal:node atPath:childPath batch:batch counter:&counter];
+        [self removeAllWithPrefix:serverCacheKey(childPath) rows:rows];
+        [self saveNodeInternal:node atPath:childPath rows:rows counter:&counter];
     }];
-    BOOL success = [batch commit];
+    BOOL success = [self commitServerCacheRows:rows];
     if (!success) {
         FFWarn(@"I-RDB076019", @"Failed to update server cache on disk!");
     } else {
-        FFDebug(@"I-RDB076020", @"Saved %lu leaf nodes for merge in %fms", (unsigned long)counter, [start timeIntervalSinceNow]*-1000);
+        FFDebug(@"I-RDB076020", @"Saved %lu rows for merge in %fms", (unsigned long)counter, [start timeIntervalSinceNow]*-1000);
     }
 }
 
-- (void)saveNodeInternal:(id<FNode>)node atPath:(FPath *)path batch:(id<APLevelDBWriteBatch>)batch counter:(NSUInteger *)counter {
+- (void)saveNodeInternal:(id<FNode>)node atPath:(FPath *)path rows:(NSMutableDictionary *)rows counter:(NSUInteger *)counter {
     id data = [node valForExport:YES];
-    if(data != nil && ![data isKindOfClass:[NSNull class]]) {
-        [self internalSetNestedData:data forKey:serverCacheKey(path) withBatch:batch counter:counter];
+    if (data == nil || [data isKindOfClass:[NSNull class]]) {
+        data = @{};
     }
+    // A row at the path replaces what any higher row still holds for it, even if the new node is empty
+    BOOL needsRow = [self hasServerCacheRowAbovePath:path rows:rows];
+    [self internalSetNestedData:data forKey:serverCacheKey(path) rows:rows needsRow:needsRow counter:counter];
 }
 
 - (NSUInteger)serverCacheEstimatedSizeInBytes {
@@ -409,27 +681,38 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     return [self.serverCacheDB exactSizeFrom:kFServerCachePrefix to:kFServerCacheRangeEnd];
 }
 
-- (void)pruneCache:(FPruneForest *)pruneForest atPath:(FPath *)path {
-    // TODO: be more intelligent, don't scan entire database...
+- (NSUInteger)serverCacheEstimatedSizeInBytesAtPath:(FPath *)path {
+    // Only used to weigh queries against each other when pruning, so leveldb's cheap estimate is good enough here
+    NSString *prefix = serverCacheKey(path);
+    return [self.serverCacheDB approximateSizeFrom:prefix to:[prefix stringByAppendingFormat:@"%C", (unichar)0xFFFF]];
+}
 
-    __block NSUInteger pruned = 0;
-    __block NSUInteger kept = 0;
+- (void)pruneCache:(FPruneForest *)pruneForest atPath:(FPath *)path {
+    NSUInteger pruned = 0;
+    NSUInteger kept = 0;
     NSDate *start = [NSDate date];
 
-    NSString *prefix = serverCacheKey(path);
-    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
-
-    [self.serverCacheDB enumerateKeysWithPrefix:prefix usingBlock:^(NSString *dbKey, BOOL *stop) {
-        NSString *pathStr = [dbKey substringFromIndex:prefix.length];
-        FPath *relativePath = [[FPath alloc] initWith:pathStr];
-        if ([pruneForest shouldPruneUnkeptDescendantsAtPath:relativePath]) {
-            pruned++;
-            [batch removeKey:dbKey];
-        } else {
-            kept++;
+    NSMutableDictionary *rows = [NSMutableDictionary dictionary];
+
+    // Rows above the path may hold some of the data below it
+    FPath *ancestor = path;
+    while (!ancestor.isEmpty) {
+        ancestor = [ancestor parent];
+        NSString *dbKey = serverCacheKey(ancestor);
+        id value = [self serverCacheRowForKey:dbKey rows:rows];
+        if ([value isKindOfClass:[NSDictionary class]]) {
+            NSArray *pieces = pathPieces([FPath relativePathFrom:ancestor to:path]);
+            id subtree = valueAtPieces(value, pieces);
+            NSUInteger prunedBefore = pruned;
+            id prunedSubtree = [self prunedValue:subtree atPath:[FPath empty] pruneForest:pruneForest pruned:&pruned kept:&kept];
+            if (pruned != prunedBefore) {
+                rows[dbKey] = valueBySettingValueAtPieces(value, pieces, 0, prunedSubtree ?: @{}, nil);
+            }
         }
-    }];
-    BOOL success = [batch commit];
+    }
+
+    [self pruneServerCacheAtPath:path pruneForest:pruneForest rows:rows pruned:&pruned kept:&kept];
+    BOOL success = [self commitServerCacheRows:rows];
     if (!success) {
         FFWarn(@"I-RDB076021", @"Failed to prune cache on disk!");
     } else {
@@ -437,9 +720,107 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     }
 }
 
+// Prunes the rows at and below the path, only reading the parts of the cache that the prune forest affects
+- (void)pruneServerCacheAtPath:(FPath *)path pruneForest:(FPruneForest *)pruneForest rows:(NSMutableDictionary *)rows pruned:(NSUInteger *)pruned kept:(NSUInteger *)kept {
+    if (![pruneForest affectsPath:[FPath empty]]) {
+        return;
+    }
+    NSString *prefix = serverCacheKey(path);
+    BOOL prunesUnkeptChildren = [pruneForest shouldPruneUnkeptDescendantsAtPath:[FPath empty]];
+    if (prunesUnkeptChildren && ![pruneForest keepsAnything]) {
+        // Nothing below the path survives, so drop its rows without reading them
+        [self.serverCacheDB enumerateKeysWithPrefix:prefix usingBlock:^(NSString *dbKey, BOOL *stop) {
+            rows[dbKey] = [NSNull null];
+            (*pruned)++;
+        }];
+        return;
+    }
+
+    NSData *data = [self.serverCacheDB dataForKey:prefix];
+    if (data != nil) {
+        NSUInteger prunedBefore = *pruned;
+        id prunedValue = [self prunedValue:[self deserializePrimitive:data] atPath:[FPath empty] pruneForest:pruneForest pruned:pruned kept:kept];
+        if (*pruned != prunedBefore) {
+            if (prunedValue != nil) {
+                rows[prefix] = prunedValue;
+            } else if ([self hasServerCacheRowAbovePath:path rows:rows]) {
+                // Removing the row would expose whatever the rows above it hold for this path
+                rows[prefix] = @{};
+            } else {
+                rows[prefix] = [NSNull null];
+            }
+        }
+    }
+
+    if (!prunesUnkeptChildren) {
+        // Children the forest doesn't mention are kept, so only visit the ones it does
+        [pruneForest enumerateChildrenUsingBlock:^(NSString *childKey, FPruneForest *childForest, BOOL *stop) {
+            [self pruneServerCacheAtPath:[path childFromString:childKey] pruneForest:childForest rows:rows pruned:pruned kept:kept];
+        }];
+        return;
+    }
+
+    // Children the forest doesn't mention are pruned, so delete their rows as we come across them and seek past the
+    // rows of the ones it does mention once they have been visited
+    NSMutableDictionary *childForests = [NSMutableDictionary dictionary];
+    [pruneForest enumerateChildrenUsingBlock:^(NSString *childKey, FPruneForest *childForest, BOOL *stop) {
+        childForests[childKey] = childForest;
+    }];
+    APLevelDBIterator *iterator = [APLevelDBIterator iteratorWithLevelDB:self.serverCacheDB];
+    [iterator seekToKey:prefix];
+    NSString *dbKey = [iterator key];
+    while (dbKey != nil && [dbKey hasPrefix:prefix]) {
+        NSString *relativePath = [dbKey substringFromIndex:prefix.length];
+        NSRange separator = [relativePath rangeOfString:@"/"];
+        NSString *childKey = separator.location == NSNotFound ? relativePath : [relativePath substringToIndex:separator.location];
+        FPruneForest *childForest = childForests[childKey];
+        if (relativePath.length == 0) {
+            // The row at the path itself, handled above
+            dbKey = [iterator nextKey];
+        } else if (childForest == nil) {
+            rows[dbKey] = [NSNull null];
+            (*pruned)++;
+            dbKey = [iterator nextKey];
+        } else {
+            [self pruneServerCacheAtPath:[path childFromString:childKey] pruneForest:childForest rows:rows pruned:pruned kept:kept];
+            // '0' is the character after '/', so this is the first key past all of the child's rows
+            [iterator seekToKey:[NSString stringWithFormat:@"%@%@0", prefix, childKey]];
+            dbKey = [iterator key];
+        }
+    }
+}
+
+// Returns the part of the value stored at the path that the prune forest keeps, or nil if it prunes everything
+- (id)prunedValue:(id)value atPath:(FPath *)path pruneForest:(FPruneForest *)pruneForest pruned:(NSUInteger *)pruned kept:(NSUInteger *)kept {
+    if (value == nil) {
+        return nil;
+    } else if (![pruneForest affectsPath:path]) {
+        (*kept)++;
+        return value;
+    } else if (![value isKindOfClass:[NSDictionary class]]) {
+        if ([pruneForest shouldPruneUnkeptDescendantsAtPath:path]) {
+            (*pruned)++;
+            return nil;
+        } else {
+            (*kept)++;
+            return value;
+        }
+    }
+
+    NSMutableDictionary *result = [NSMutableDictionary dictionary];
+    [value enumerateKeysAndObjectsUsingBlock:^(NSString *childKey, id child, BOOL *stop) {
+        id prunedChild = [self prunedValue:child atPath:[path childFromString:childKey] pruneForest:pruneForest pruned:pruned kept:kept];
+        if (prunedChild != nil) {
+            result[childKey] = prunedChild;
+        }
+    }];
+    return result.count > 0 ? result : nil;
+}
+
 #pragma mark - Tracked Queries
 
 - (NSArray *)loadTrackedQueries {
+    [self flush];
     NSDate *date = [NSDate date];
     NSMutableArray *trackedQueries = [NSMutableArray array];
     [self.serverCacheDB enumerateKeysWithPrefix:kFTrackedQueriesPrefix asData:^(NSString *key, NSData *data, BOOL *stop) {
@@ -479,7 +860,9 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 
 - (void)removeTrackedQuery:(NSUInteger)queryId {
     NSDate *start = [NSDate date];
+    [self.pendingTrackedQueries removeObjectForKey:@(queryId)];
     id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    [self addPendingTrackedQueriesToBatch:batch];
     [batch removeKey:trackedQueryKey(queryId)];
     __block NSUInteger keyCount = 0;
     [self.serverCacheDB enumerateKeysWithPrefix:trackedQueryKeysKeyPrefix(queryId) usingBlock:^(NSString *key, BOOL *stop) {
@@ -499,7 +882,6 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 }
 
 - (void)saveTrackedQuery:(FTrackedQuery *)query {
-    NSDate *start = [NSDate date];
     NSDictionary *trackedQuery =
     @{
       kFTrackedQueryId: @(query.queryId),
@@ -512,43 +894,34 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     NSError *error = nil;
     NSData *data = [NSJSONSerialization dataWithJSONObject:trackedQuery options:0 error:&error];
     NSAssert(data, @"Failed to serialize tracked query (Error: %@)", error);
-    [self.serverCacheDB setData:data forKey:trackedQueryKey(query.queryId)];
-    FFDebug(@"I-RDB076028", @"Saved tracked query %lu in %fms", (unsigned long)query.queryId, [start timeIntervalSinceNow]*-1000);
+    self.pendingTrackedQueries[@(query.queryId)] = data;
+    if (self.pendingTrackedQueries.count >= kFTrackedQueriesMaxPending) {
+        [self flush];
+    }
 }
 
-- (void)setTrackedQueryKeys:(NSSet *)keys forQueryId:(NSUInteger)queryId {
-    NSDate *start = [NSDate date];
-    __block NSUInteger removed = 0;
-    __block NSUInteger added = 0;
-    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
-    NSMutableSet *seenKeys = [NSMutableSet set];
-    // First, delete any keys that might be stored and are not part of the current keys
-    [self.serverCacheDB enumerateKeysWithPrefix:trackedQueryKeysKeyPrefix(queryId) asStrings:^(NSString *dbKey, NSString *actualKey, BOOL *stop) {
-        if ([keys containsObject:actualKey]) {
-            // Already in DB
-            [seenKeys addObject:actualKey];
-        } else {
-            // Not part of set, delete key
-            [batch removeKey:dbKey];
-            removed++;
-        }
+- (void)addPendingTrackedQueriesToBatch:(id<APLevelDBWriteBatch>)batch {
+    [self.pendingTrackedQueries enumerateKeysAndObjectsUsingBlock:^(NSNumber *queryId, NSData *data, BOOL *stop) {
+        [batch setData:data forKey:trackedQueryKey(queryId.unsignedIntegerValue)];
     }];
+    [self.pendingTrackedQueries removeAllObjects];
+}
 
-    // Next add any keys that are missing in the database
-    [keys enumerateObjectsUsingBlock:^(NSString *childKey, BOOL *stop) {
-        if (![seenKeys containsObject:childKey]) {
-            [batch setString:childKey forKey:trackedQueryKeysKey(queryId, childKey)];
-            added++;
-        }
-    }];
-    BOOL success = [batch commit];
+- (void)setTrackedQueryKeys:(NSSet *)keys forQueryId:(NSUInteger)queryId {
+    NSDate *start = [NSDate date];
+    NSSet *existingKeys = [self trackedQueryKeysForQuery:queryId];
+    NSMutableSet *added = [keys mutableCopy];
+    [added minusSet:existingKeys];
+    NSMutableSet *removed = [existingKeys mutableCopy];
+    [removed minusSet:keys];
+    BOOL success = [self writeTrackedQueryKeysWithAddedKeys:added removedKeys:removed forQueryId:queryId];
     if (!success) {
         FFWarn(@"I-RDB076029", @"Failed to set tracked queries on disk!");
     } else {
         FFDebug(@"I-RDB076030", @"Set %lu tracked keys (%lu added, %lu removed) for query %lu in %fms",
                 (unsigned long)keys.count,
-                (unsigned long)added,
-                (unsigned long)removed,
+                (unsigned long)added.count,
+                (unsigned long)removed.count,
                 (unsigned long)queryId,
                 [start timeIntervalSinceNow]*-1000);
     }
@@ -556,14 +929,7 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 
 - (void)updateTrackedQueryKeysWithAddedKeys:(NSSet *)added removedKeys:(NSSet *)removed forQueryId:(NSUInteger)queryId {
     NSDate *start = [NSDate date];
-    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
-    [removed enumerateObjectsUsingBlock:^(NSString *key, BOOL *stop) {
-        [batch removeKey:trackedQueryKeysKey(queryId, key)];
-    }];
-    [added enumerateObjectsUsingBlock:^(NSString *key, BOOL *stop) {
-        [batch setString:key forKey:trackedQueryKeysKey(queryId, key)];
-    }];
-    BOOL success = [batch commit];
+    BOOL success = [self writeTrackedQueryKeysWithAddedKeys:added removedKeys:removed forQueryId:queryId];
     if (!success) {
         FFWarn(@"I-RDB076031", @"Failed to update tracked queries on disk!");
     } else {
@@ -574,105 +940,270 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 - (NSSet *)trackedQueryKeysForQuery:(NSUInteger)queryId {
     NSDate *start = [NSDate date];
     NSMutableSet *set = [NSMutableSet set];
-    [self.serverCacheDB enumerateKeysWithPrefix:trackedQueryKeysKeyPrefix(queryId) asStrings:^(NSString *dbKey, NSString *actualKey, BOOL *stop) {
-        [set addObject:actualKey];
+    NSString *prefix = trackedQueryKeysKeyPrefix(queryId);
+    [self.serverCacheDB enumerateKeysWithPrefix:prefix asData:^(NSString *dbKey, NSData *data, BOOL *stop) {
+        [set addObjectsFromArray:[self deserializeTrackedQueryKeysBlock:data firstKey:[dbKey substringFromIndex:prefix.length]]];
     }];
     FFDebug(@"I-RDB076033", @"Loaded %lu tracked keys for query %lu in %fms", (unsigned long)set.count, (unsigned long)queryId, [start timeIntervalSinceNow]*-1000);
     return set;
 }
 
+// Only reads and rewrites the blocks that hold the changed keys
+- (BOOL)writeTrackedQueryKeysWithAddedKeys:(NSSet *)added removedKeys:(NSSet *)removed forQueryId:(NSUInteger)queryId {
+    if (added.count == 0 && removed.count == 0) {
+        return YES;
+    }
+    NSString *prefix = trackedQueryKeysKeyPrefix(queryId);
+    NSComparator comparator = ^NSComparisonResult(NSString *a, NSString *b) {
+        return [a compare:b options:NSLiteralSearch];
+    };
+
+    // Each block holds the keys from its first key up to the first key of the next block
+    NSMutableArray *firstKeys = [NSMutableArray array];
+    [self.serverCacheDB enumerateKeysWithPrefix:prefix usingBlock:^(NSString *dbKey, BOOL *stop) {
+        [firstKeys addObject:[dbKey substringFromIndex:prefix.length]];
+    }];
+    [firstKeys sortUsingComparator:comparator];
+
+    // Keys sorting before every block go into the first one, or a new block if there are none
+    NSMutableDictionary *changedBlocks = [NSMutableDictionary dictionary];
+    void (^changeKey)(NSString *, BOOL) = ^(NSString *key, BOOL isAdded) {
+        NSUInteger index = [firstKeys indexOfObject:key
+                                      inSortedRange:NSMakeRange(0, firstKeys.count)
+                                            options:NSBinarySearchingInsertionIndex | NSBinarySearchingLastEqual
+                                    usingComparator:comparator];
+        NSString *firstKey = firstKeys.count == 0 ? @"" : firstKeys[index > 0 ? index - 1 : 0];
+        NSMutableSet *block = changedBlocks[firstKey];
+        if (block == nil) {
+            NSData *data = firstKeys.count == 0 ? nil : [self.serverCacheDB dataForKey:[prefix stringByAppendingString:firstKey]];
+            block = [NSMutableSet setWithArray:data != nil ? [self deserializeTrackedQueryKeysBlock:data firstKey:firstKey] : @[]];
+            changedBlocks[firstKey] = block;
+        }
+        if (isAdded) {
+            [block addObject:key];
+        } else {
+            [block removeObject:key];
+        }
+    };
+    for (NSString *key in removed) {
+        changeKey(key, NO);
+    }
+    for (NSString *key in added) {
+        changeKey(key, YES);
+    }
+
+    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    [changedBlocks enumerateKeysAndObjectsUsingBlock:^(NSString *firstKey, NSSet *block, BOOL *stop) {
+        if (firstKeys.count > 0) {
+            [batch removeKey:[prefix stringByAppendingString:firstKey]];
+        }
+        NSArray *keys = [[block allObjects] sortedArrayUsingComparator:comparator];
+        NSUInteger blockSize = keys.count > 2 * kFTrackedQueryKeysPerBlock ? kFTrackedQueryKeysPerBlock : keys.count;
+        for (NSUInteger i = 0; i < keys.count; i += blockSize) {
+            NSArray *chunk = [keys subarrayWithRange:NSMakeRange(i, MIN(blockSize, keys.count - i))];
+            [batch setData:[self serializeTrackedQueryKeysBlock:chunk] forKey:[prefix stringByAppendingString:chunk[0]]];
+        }
+    }];
+    return [batch commit];
+}
+
+- (NSData *)serializeTrackedQueryKeysBlock:(NSArray *)keys {
+    NSMutableData *data = [NSMutableData data];
+    [data appendBytes:&kFTrackedQueryKeysBlockTag length:1];
+    for (NSString *key in keys) {
+        appendString(data, key);
+    }
+    return data;
+}
+
+- (NSArray *)deserializeTrackedQueryKeysBlock:(NSData *)data firstKey:(NSString *)firstKey {
+    // A block is always longer than its first key, so a row holding exactly its key was written by an older version
+    if ([data isEqualToData:[firstKey dataUsingEncoding:NSUTF8StringEncoding]]) {
+        return @[firstKey];
+    }
+    const uint8_t *bytes = data.bytes;
+    if (data.length == 0 || bytes[0] != kFTrackedQueryKeysBlockTag) {
+        [NSException raise:NSInternalInconsistencyException format:@"Failed to deserialize tracked query keys: %@", data];
+    }
+    NSMutableArray *keys = [NSMutableArray array];
+    const uint8_t *cursor = bytes + 1;
+    const uint8_t *end = bytes + data.length;
+    while (cursor != end) {
+        NSString *key = readString(&cursor, end);
+        if (key == nil) {
+            [NSException raise:NSInternalInconsistencyException format:@"Failed to deserialize tracked query keys: %@", data];
+        }
+        [keys addObject:key];
+    }
+    return keys;
+}
+
 #pragma mark - Internal methods
 
-- (void)removeAllLeafNodesOnPath:(FPath *)path batch:(id<APLevelDBWriteBatch>)batch {
+- (void)removeAllWithPrefix:(NSString *)prefix rows:(NSMutableDictionary *)rows {
+    assert(prefix != nil);
+
+    [self.serverCacheDB enumerateKeysWithPrefix:prefix usingBlock:^(NSString *key, BOOL *stop) {
+        rows[key] = [NSNull null];
+    }];
+    // Also drop rows written earlier in the same update
+    for (NSString *key in [rows allKeys]) {
+        if ([key hasPrefix:prefix]) {
+            rows[key] = [NSNull null];
+        }
+    }
+}
+
+// Returns the value of the server cache row with the given key, as changed by the rows of the current update
+- (id)serverCacheRowForKey:(NSString *)key rows:(NSDictionary *)rows {
+    id value = rows[key];
+    if (value == nil) {
+        NSData *data = [self.serverCacheDB dataForKey:key];
+        value = data != nil ? [self deserializePrimitive:data] : nil;
+    }
+    return value == [NSNull null] ? nil : value;
+}
+
+- (BOOL)hasServerCacheRowAbovePath:(FPath *)path rows:(NSDictionary *)rows {
     while (!path.isEmpty) {
-        [batch removeKey:serverCacheKey(path)];
         path = [path parent];
+        NSString *key = serverCacheKey(path);
+        id value = rows[key];
+        if (value != nil ? value != [NSNull null] : [self.serverCacheDB dataForKey:key] != nil) {
+            return YES;
+        }
     }
-    // Make sure to delete any nodes at the root
-    [batch removeKey:serverCacheKey([FPath empty])];
+    return NO;
 }
 
-- (void)removeAllWithPrefix:(NSString *)prefix batch:(id<APLevelDBWriteBatch>)batch database:(APLevelDB *)database {
-    assert(prefix != nil);
-
-    [database enumerateKeysWithPrefix:prefix usingBlock:^(NSString *key, BOOL *stop) {
-        [batch removeKey:key];
+- (BOOL)commitServerCacheRows:(NSDictionary *)rows {
+    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    [self addPendingTrackedQueriesToBatch:batch];
+    [rows enumerateKeysAndObjectsUsingBlock:^(NSString *key, id value, BOOL *stop) {
+        if (value == [NSNull null]) {
+            [batch removeKey:key];
+        } else {
+            [batch setData:[self serializePrimitive:value] forKey:key];
+        }
     }];
+    return [batch commit];
 }
 
-#pragma mark - Internal helper methods
+// Returns the cost of storing the value, or some number larger than limit if it exceeds it
+- (NSUInteger)costOfValue:(id)value limit:(NSUInteger)limit {
+    if ([value isKindOfClass:[NSDictionary class]]) {
+        __block NSUInteger cost = 0;
+        [value enumerateKeysAndObjectsUsingBlock:^(id childKey, id child, BOOL *stop) {
+            cost += [self costOfValue:child limit:limit - cost];
+            *stop = cost > limit;
+        }];
+        return cost;
+    } else if ([value isKindOfClass:[NSString class]]) {
+        return 1 + [value length] / kFServerCacheCharactersPerCost;
+    } else {
+        return 1;
+    }
+}
 
-- (void)internalSetNestedData:(id)value forKey:(NSString *)key withBatch:(id<APLevelDBWriteBatch>)batch counter:(NSUInteger *)counter {
+- (void)internalSetNestedData:(id)value forKey:(NSString *)key rows:(NSMutableDictionary *)rows needsRow:(BOOL)needsRow counter:(NSUInteger *)counter {
     if([value isKindOfClass:[NSDictionary class]]) {
         NSDictionary* dictionary = value;
+        NSMutableDictionary *row = [NSMutableDictionary dictionary];
         [dictionary enumerateKeysAndObjectsUsingBlock:^(id childKey, id obj, BOOL *stop) {
             assert(obj != nil);
-            NSString* childPath = [NSString stringWithFormat:@"%@%@/", key, childKey];
-            [self internalSetNestedData:obj forKey:childPath withBatch:batch counter:counter];
+            if ([self costOfValue:obj limit:kFServerCacheMaxInlineCost] <= kFServerCacheMaxInlineCost) {
+                row[childKey] = obj;
+            } else {
+                NSString* childPath = [NSString stringWithFormat:@"%@%@/", key, childKey];
+                [self internalSetNestedData:obj forKey:childPath rows:rows needsRow:NO counter:counter];
+            }
         }];
+        if (row.count > 0 || needsRow) {
+            rows[key] = row;
+            (*counter)++;
+        }
     }
     else {
-        NSData *data = [self serializePrimitive:value];
-        [batch setData:data forKey:key];
+        rows[key] = value;
         (*counter)++;
     }
 }
 
-- (id)internalNestedDataForPath:(FPath *)path {
-    NSAssert(path != nil, @"Path was nil!");
-
-    NSString *baseKey = serverCacheKey(path);
+- (id)internalNestedDataForPath:(FPath *)path rowCache:(NSMutableDictionary *)rowCache {
+    return [self internalNestedDataForPath:path rowCache:rowCache iterator:nil positioned:NULL];
+}
 
-    // HACK to make sure iter is freed now to avoid race conditions (if self.db is deleted before iter, you get an access violation).
-    @autoreleasepool {
-        APLevelDBIterator* iter = [APLevelDBIterator iteratorWithLevelDB:self.serverCacheDB];
+/**
+* With an iterator, reads the rows at and below the path from it, seeking only if it isn't already positioned at or
+* before them. Paths read with the same iterator must come in key order.
+*/
+- (id)internalNestedDataForPath:(FPath *)path
+                       rowCache:(NSMutableDictionary *)rowCache
+                       iterator:(APLevelDBIterator *)iterator
+                     positioned:(BOOL *)positioned {
+    NSAssert(path != nil, @"Path was nil!");
 
-        [iter seekToKey:baseKey];
-        if (iter.key == nil || ![iter.key hasPrefix:baseKey]) {
-            // No data.
-            return nil;
-        } else {
-            return [self internalNestedDataFromIterator:iter andKeyPrefix:baseKey];
+    // Start from the lowest row above the path, since each row replaces what the ones above it hold
+    __block id result = nil;
+    NSArray *pieces = pathPieces(path);
+    FPath *ancestor = [FPath empty];
+    for (NSUInteger i = 0; i < pieces.count; i++) {
+        NSString *ancestorKey = serverCacheKey(ancestor);
+        id value = rowCache[ancestorKey];
+        if (value == nil) {
+            NSData *data = [self.serverCacheDB dataForKey:ancestorKey];
+            value = data != nil ? [self deserializePrimitive:data] : [NSNull null];
+            rowCache[ancestorKey] = value;
         }
+        if (value != [NSNull null]) {
+            result = valueAtPieces(value, [pieces subarrayWithRange:NSMakeRange(i, pieces.count - i)]);
+        }
+        ancestor = [ancestor childFromString:pieces[i]];
     }
-}
-
-- (id) internalNestedDataFromIterator:(APLevelDBIterator*)iterator andKeyPrefix:(NSString*)prefix {
-    NSString* key = iterator.key;
 
-    if ([key isEqualToString:prefix]) {
-        id result = [self deserializePrimitive:iterator.valueAsData];
-        [iterator nextKey];
-        return result;
+    // Then apply the rows at and below the path, which come in key order, so that each row precedes its descendants
+    NSString *baseKey = serverCacheKey(path);
+    NSHashTable *owned = [NSHashTable hashTableWithOptions:NSPointerFunctionsObjectPointerPersonality];
+    void (^applyRow)(NSString *, NSData *) = ^(NSString *key, NSData *data) {
+        NSString *relativePath = [key substringFromIndex:baseKey.length];
+        NSArray *relativePieces = pathPieces([[FPath alloc] initWith:relativePath]);
+        id value = [self deserializePrimitive:data];
+        result = valueBySettingValueAtPieces(result, relativePieces, 0, value, owned);
+    };
+    if (iterator == nil) {
+        [self.serverCacheDB enumerateKeysWithPrefix:baseKey asData:^(NSString *key, NSData *data, BOOL *stop) {
+            applyRow(key, data);
+        }];
     } else {
-        NSMutableDictionary *dict = [[NSMutableDictionary alloc] init];
-        while (key != nil && [key hasPrefix:prefix]) {
-            NSString *relativePath = [key substringFromIndex:prefix.length];
-            NSArray* pathPieces = [relativePath componentsSeparatedByString:@"/"];
-            assert(pathPieces.count > 0);
-            NSString *childName = pathPieces[0];
-            NSString *childPath = [NSString stringWithFormat:@"%@%@/", prefix, childName];
-            id childValue = [self internalNestedDataFromIterator:iterator andKeyPrefix:childPath];
-            [dict setValue:childValue forKey:childName];
-
-            key = iterator.key;
+        NSString *key = *positioned ? [iterator key] : nil;
+        if (!*positioned || (key != nil && compareServerCacheKeys(key, baseKey) == NSOrderedAscending)) {
+            [iterator seekToKey:baseKey];
+            key = [iterator key];
+            *positioned = YES;
+        }
+        while (key != nil && [key hasPrefix:baseKey]) {
+            applyRow(key, [iterator valueAsData]);
+            key = [iterator nextKey];
         }
-        return dict;
     }
+    return result;
 }
 
-
 - (NSData*) serializePrimitive:(id)value {
-    // HACK: The built-in serialization only works on dicts and arrays.  So we create an array and then strip off
-    // the leading / trailing byte (the [ and ]).
-    NSError *error = nil;
-    NSData *data = [NSJSONSerialization dataWithJSONObject:@[value] options:0 error:&error];
-    NSAssert(data, @"Failed to serialize primitive: %@", error);
-
-    return [data subdataWithRange:NSMakeRange(1, data.length - 2)];
+    NSMutableData *data = [NSMutableData data];
+    appendServerCacheValue(data, value);
+    return data;
 }
 
 - (id)fixDoubleParsing:(id)value {
+    if ([value isKindOfClass:[NSMutableDictionary class]]) {
+        NSMutableDictionary *dictionary = value;
+        for (NSString *key in [dictionary allKeys]) {
+            dictionary[key] = [self fixDoubleParsing:dictionary[key]];
+        }
+        return dictionary;
+    }
+
     // The parser for double values in JSONSerialization at the root takes some short-cuts and delivers wrong results
     // (wrong rounding) for some double values, including 2.47. Because we use the exact bytes for hashing on the server
     // this will lead to hash mismatches. The parser of NSNumber seems to be more in line with what the server expects,
@@ -695,8 +1226,21 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 }
 
 - (id) deserializePrimitive:(NSData*)data {
+    const uint8_t *bytes = data.bytes;
+    if (data.length > 0 && bytes[0] >= kFServerCacheTagObject && bytes[0] <= kFServerCacheTagFalse) {
+        const uint8_t *cursor = bytes;
+        id result = readServerCacheValue(&cursor, bytes + data.length);
+        if (result == nil || cursor != bytes + data.length) {
+            [NSException raise:NSInternalInconsistencyException format:@"Failed to deserialiaze primitive: %@", data];
+        }
+        return result;
+    }
+
+    // Written before the binary encoding, see migrateServerCacheFromJSON
     NSError *error = nil;
-    id result = [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingAllowFragments error:&error];
+    id result = [NSJSONSerialization JSONObjectWithData:data
+                                                options:NSJSONReadingAllowFragments | NSJSONReadingMutableContainers
+                                                  error:&error];
     if (result != nil) {
         return [self fixDoubleParsing:result];
     } else {
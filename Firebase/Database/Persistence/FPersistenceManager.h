@@ -28,6 +28,7 @@
 
 - (id)initWithStorageEngine:(id<FStorageEngine>)storageEngine cachePolicy:(id<FCachePolicy>)cachePolicy;
 - (void)close;
+- (void)flush;
 
 - (void)saveUserOverwrite:(id<FNode>)node atPath:(FPath *)path writeId:(NSUInteger)writeId;
 - (void)saveUserMerge:(FCompoundWrite *)merge atPath:(FPath *)path writeId:(NSUInteger)writeId;
@@ -35,6 +36,12 @@
 - (void)removeAllUserWrites;
 - (NSArray *)userWrites;
 
+/**
+* Returns the persisted user writes in write id order, leaving out every write that a later overwrite at the same path
+* or above it replaces entirely. The writes left out are removed from storage without being decoded.
+*/
+- (NSArray *)compactedUserWrites;
+
 - (FCacheNode *)serverCacheForQuery:(FQuerySpec *)spec;
 - (void)updateServerCacheWithNode:(id<FNode>)node forQuery:(FQuerySpec *)spec;
 - (void)updateServerCacheWithMerge:(FCompoundWrite *)merge atPath:(FPath *)path;
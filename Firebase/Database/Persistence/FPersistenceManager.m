@@ -24,6 +24,8 @@
 #import "FUtilities.h"
 #import "FPruneForest.h"
 #import "FClock.h"
+#import "FWriteRecord.h"
+#import "FImmutableTree.h"
 
 @interface FPersistenceManager ()
 
@@ -53,6 +55,10 @@
     self.trackedQueryManager = nil;
 }
 
+- (void)flush {
+    [self.storageEngine flush];
+}
+
 - (void)saveUserOverwrite:(id<FNode>)node atPath:(FPath *)path writeId:(NSUInteger)writeId {
     [self.storageEngine saveUserOverwrite:node atPath:path writeId:writeId];
 }
@@ -73,6 +79,31 @@
     return [self.storageEngine userWrites];
 }
 
+- (NSArray *)compactedUserWrites {
+    NSArray *writes = [self.storageEngine userWrites];
+    NSMutableArray *compacted = [NSMutableArray arrayWithCapacity:writes.count];
+    NSUInteger removed = 0;
+    // Walk back from the newest write, remembering where overwrites happened. An older write at or below one of those
+    // paths can't affect the final state (assuming the overwrite succeeds) so there's no point replaying it. The
+    // newest write is always kept, so the next write id handed out doesn't change.
+    FImmutableTree *overwrittenPaths = [FImmutableTree empty];
+    for (FWriteRecord *write in [writes reverseObjectEnumerator]) {
+        if ([overwrittenPaths rootMostValueOnPath:write.path] != nil) {
+            [self.storageEngine removeUserWrite:write.writeId];
+            removed++;
+        } else {
+            [compacted addObject:write];
+            if (write.isOverwrite) {
+                overwrittenPaths = [overwrittenPaths setValue:@YES atPath:write.path];
+            }
+        }
+    }
+    if (removed > 0) {
+        FFDebug(@"I-RDB078005", @"Dropped %lu persisted writes replaced by later overwrites", (unsigned long)removed);
+    }
+    return [[compacted reverseObjectEnumerator] allObjects];
+}
+
 - (FCacheNode *)serverCacheForQuery:(FQuerySpec *)query {
     NSSet *trackedKeys;
     BOOL complete;
@@ -156,19 +187,18 @@
         FFDebug(@"I-RDB078001", @"Reached prune check threshold. Checking...");
         NSDate *date = [NSDate date];
         self.serverCacheUpdatesSinceLastPruneCheck = 0;
-        BOOL canPrune = YES;
         NSUInteger cacheSize = [self.storageEngine serverCacheEstimatedSizeInBytes];
         FFDebug(@"I-RDB078002", @"Server cache size: %lu", (unsigned long)cacheSize);
-        while (canPrune && [self.cachePolicy shouldPruneCacheWithSize:cacheSize
-                                               numberOfTrackedQueries:self.trackedQueryManager.numberOfPrunableQueries]) {
-            FPruneForest *pruneForest = [self.trackedQueryManager pruneOldQueries:self.cachePolicy];
+        // Prune at most one round per check, so a single large update can't empty most of the cache. If we're still
+        // over the limit, the next check prunes some more.
+        if ([self.cachePolicy shouldPruneCacheWithSize:cacheSize
+                                numberOfTrackedQueries:self.trackedQueryManager.numberOfPrunableQueries]) {
+            FPruneForest *pruneForest = [self.trackedQueryManager pruneOldQueries:self.cachePolicy cacheSize:cacheSize];
             if (pruneForest.prunesAnything) {
                 [self.storageEngine pruneCache:pruneForest atPath:[FPath empty]];
-            } else {
-                canPrune = NO;
+                cacheSize = [self.storageEngine serverCacheEstimatedSizeInBytes];
+                FFDebug(@"I-RDB078003", @"Cache size after pruning: %lu", (unsigned long)cacheSize);
             }
-            cacheSize = [self.storageEngine serverCacheEstimatedSizeInBytes];
-            FFDebug(@"I-RDB078003", @"Cache size after pruning: %lu", (unsigned long)cacheSize);
         }
         FFDebug(@"I-RDB078004", @"Pruning round took %fms", [date timeIntervalSinceNow]*-1000);
     }
@@ -23,6 +23,7 @@
 + (FPruneForest *)empty;
 
 - (BOOL)prunesAnything;
+- (BOOL)keepsAnything;
 - (BOOL)shouldPruneUnkeptDescendantsAtPath:(FPath *)path;
 - (BOOL)shouldKeepPath:(FPath *)path;
 - (BOOL)affectsPath:(FPath *)path;
@@ -34,5 +35,7 @@
 - (FPruneForest *)pruneAll:(NSSet *)children atPath:(FPath *)path;
 
 - (void)enumarateKeptNodesUsingBlock:(void (^)(FPath *path))block;
+// Enumerates the children that have prune or keep values of their own somewhere below them
+- (void)enumerateChildrenUsingBlock:(void (^)(NSString *childKey, FPruneForest *childForest, BOOL *stop))block;
 
 @end
@@ -74,6 +74,10 @@ static BOOL (^kFKeepPredicate)(id) = ^BOOL(NSNumber *pruneValue) {
     return [self.pruneForest containsValueMatching:kFPrunePredicate];
 }
 
+- (BOOL)keepsAnything {
+    return [self.pruneForest containsValueMatching:kFKeepPredicate];
+}
+
 - (BOOL)shouldPruneUnkeptDescendantsAtPath:(FPath *)path {
     NSNumber *shouldPrune = [self.pruneForest leafMostValueOnPath:path];
     return shouldPrune != nil && [shouldPrune boolValue];
@@ -174,4 +178,10 @@ static BOOL (^kFKeepPredicate)(id) = ^BOOL(NSNumber *pruneValue) {
     }];
 }
 
+- (void)enumerateChildrenUsingBlock:(void (^)(NSString *, FPruneForest *, BOOL *))block {
+    [self.pruneForest.children enumerateKeysAndObjectsUsingBlock:^(NSString *childKey, FImmutableTree *childTree, BOOL *stop) {
+        block(childKey, [self child:childKey], stop);
+    }];
+}
+
 @end
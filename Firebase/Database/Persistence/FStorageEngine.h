@@ -26,6 +26,8 @@
 @protocol FStorageEngine <NSObject>
 
 - (void)close;
+// Writes out anything the engine has deferred, e.g. before the app is suspended
+- (void)flush;
 
 - (void)saveUserOverwrite:(id<FNode>)node atPath:(FPath *)path writeId:(NSUInteger)writeId;
 - (void)saveUserMerge:(FCompoundWrite *)merge atPath:(FPath *)path writeId:(NSUInteger)writeId;
@@ -38,6 +40,7 @@
 - (void)updateServerCache:(id<FNode>)node atPath:(FPath *)path merge:(BOOL)merge;
 - (void)updateServerCacheWithMerge:(FCompoundWrite *)merge atPath:(FPath *)path;
 - (NSUInteger)serverCacheEstimatedSizeInBytes;
+- (NSUInteger)serverCacheEstimatedSizeInBytesAtPath:(FPath *)path;
 
 - (void)pruneCache:(FPruneForest *)pruneForest atPath:(FPath *)path;
 
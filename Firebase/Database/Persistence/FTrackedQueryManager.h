@@ -42,6 +42,7 @@
 - (void)ensureCompleteTrackedQueryAtPath:(FPath *)path;
 
 - (FPruneForest *)pruneOldQueries:(id<FCachePolicy>)cachePolicy;
+- (FPruneForest *)pruneOldQueries:(id<FCachePolicy>)cachePolicy cacheSize:(NSUInteger)cacheSize;
 - (NSUInteger)numberOfPrunableQueries;
 - (NSSet *)knownCompleteChildrenAtPath:(FPath *)path;
 
@@ -192,8 +192,8 @@
     trackedDict[query.query.params] = query;
 }
 
-- (NSUInteger) numberOfQueriesToPrune:(id<FCachePolicy>)cachePolicy prunableCount:(NSUInteger)numPrunable {
-    NSUInteger numPercent = (NSUInteger)ceilf(numPrunable * [cachePolicy percentOfQueriesToPruneAtOnce]);
+- (NSUInteger) numberOfQueriesToPrune:(id<FCachePolicy>)cachePolicy prunableCount:(NSUInteger)numPrunable percent:(float)percent {
+    NSUInteger numPercent = (NSUInteger)ceilf(numPrunable * percent);
     NSUInteger maxToKeep = [cachePolicy maxNumberOfQueriesToKeep];
     NSUInteger numMax = (numPrunable > maxToKeep) ? numPrunable - maxToKeep : 0;
     // Make sure we get below number of max queries to prune
@@ -201,6 +201,10 @@
 }
 
 - (FPruneForest *)pruneOldQueries:(id<FCachePolicy>)cachePolicy {
+    return [self pruneOldQueries:cachePolicy cacheSize:0];
+}
+
+- (FPruneForest *)pruneOldQueries:(id<FCachePolicy>)cachePolicy cacheSize:(NSUInteger)cacheSize {
     NSMutableArray *pruneableQueries = [NSMutableArray array];
     NSMutableArray *unpruneableQueries = [NSMutableArray array];
     [self.trackedQueryTree forEach:^(FPath *path, NSDictionary *trackedQueries) {
@@ -212,19 +216,48 @@
             }
         }];
     }];
-    [pruneableQueries sortUsingComparator:^NSComparisonResult(FTrackedQuery *q1, FTrackedQuery *q2) {
-        if (q1.lastUse < q2.lastUse) {
-            return NSOrderedAscending;
-        } else if (q1.lastUse > q2.lastUse) {
-            return NSOrderedDescending;
-        } else {
-            return NSOrderedSame;
+
+    NSUInteger bytesToPrune = [cachePolicy bytesToPruneFromCacheWithSize:cacheSize];
+    NSUInteger numToPrune;
+    if (bytesToPrune > 0) {
+        // Prune the queries that hold the most data for the longest time unused first, and only as many as it takes
+        // to free the requested bytes (and get below the max number of queries)
+        NSTimeInterval now = [self.clock currentTime];
+        NSMutableDictionary *sizes = [NSMutableDictionary dictionaryWithCapacity:pruneableQueries.count];
+        NSMutableDictionary *weights = [NSMutableDictionary dictionaryWithCapacity:pruneableQueries.count];
+        for (FTrackedQuery *query in pruneableQueries) {
+            NSUInteger size = [self.storageEngine serverCacheEstimatedSizeInBytesAtPath:query.query.path];
+            sizes[@(query.queryId)] = @(size);
+            weights[@(query.queryId)] = @((size + 1) * (MAX(now - query.lastUse, 0) + 1));
         }
-    }];
+        [pruneableQueries sortUsingComparator:^NSComparisonResult(FTrackedQuery *q1, FTrackedQuery *q2) {
+            return [weights[@(q2.queryId)] compare:weights[@(q1.queryId)]];
+        }];
 
+        NSUInteger minToPrune = [self numberOfQueriesToPrune:cachePolicy prunableCount:pruneableQueries.count percent:0];
+        NSUInteger bytesPruned = 0;
+        numToPrune = 0;
+        while (numToPrune < pruneableQueries.count && (numToPrune < minToPrune || bytesPruned < bytesToPrune)) {
+            bytesPruned += [sizes[@([pruneableQueries[numToPrune] queryId])] unsignedIntegerValue];
+            numToPrune++;
+        }
+        FFDebug(@"I-RDB081003", @"Pruning %lu queries holding about %lu bytes", (unsigned long)numToPrune, (unsigned long)bytesPruned);
+    } else {
+        [pruneableQueries sortUsingComparator:^NSComparisonResult(FTrackedQuery *q1, FTrackedQuery *q2) {
+            if (q1.lastUse < q2.lastUse) {
+                return NSOrderedAscending;
+            } else if (q1.lastUse > q2.lastUse) {
+                return NSOrderedDescending;
+            } else {
+                return NSOrderedSame;
+            }
+        }];
+        numToPrune = [self numberOfQueriesToPrune:cachePolicy
+                                    prunableCount:pruneableQueries.count
+                                          percent:[cachePolicy percentOfQueriesToPruneAtOnce]];
+    }
 
     __block FPruneForest *pruneForest = [FPruneForest empty];
-    NSUInteger numToPrune = [self numberOfQueriesToPrune:cachePolicy prunableCount:pruneableQueries.count];
 
     // TODO: do in transaction
     for (NSUInteger i = 0; i < numToPrune; i++) {
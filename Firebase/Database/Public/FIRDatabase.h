@@ -153,6 +153,18 @@ NS_SWIFT_NAME(Database)
  */
 @property (nonatomic, strong) dispatch_queue_t callbackQueue;
 
+/**
+ * By default every `setValue:` call is sent to the server as its own write, even if the client is offline when it is
+ * made. By setting this value to `YES`, a `setValue:` that can't be sent yet replaces the data of the write queued
+ * right before it, if that write also set the value of the same location. Rapid edits made while offline then go out
+ * as a single write. Writes are still sent in the order they were made, and the completion blocks of combined writes
+ * are called in order, all with the outcome of the combined write. This means an earlier write also fails if the
+ * server rejects the data of a later one.
+ *
+ * Note that this property must be set before creating your first Database reference.
+ */
+@property (nonatomic) BOOL coalesceQueuedOverwrites;
+
 /**
  * Enables verbose diagnostic logging.
  *
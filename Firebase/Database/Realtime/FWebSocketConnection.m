@@ -30,7 +30,8 @@
 #endif
 
 @interface FWebSocketConnection () {
-    NSMutableString* frame;
+    // The UTF-8 bytes of the frames of a message received so far
+    NSMutableData* frame;
     BOOL everConnected;
     BOOL isClosed;
     NSTimer* keepAlive;
@@ -147,10 +148,9 @@
     NSData* jsonData = [NSJSONSerialization dataWithJSONObject:dictionary
                                                        options:kNilOptions error:nil];
 
-    NSString* data = [[NSString alloc] initWithData:jsonData
-                                           encoding:NSUTF8StringEncoding];
-
-    NSArray* dataSegs = [FUtilities splitString:data intoMaxSize:kWebsocketMaxFrameSize];
+    // Split the UTF-8 bytes rather than a string of the whole message, so only one segment at a time is converted. A
+    // segment of kWebsocketMaxFrameSize bytes never holds more than that many characters.
+    NSArray* dataSegs = [FUtilities rangesSplittingUTF8Data:jsonData intoMaxSize:kWebsocketMaxFrameSize];
 
     // First send the header so the server knows how many segments are forthcoming
     if (dataSegs.count > 1) {
@@ -158,8 +158,12 @@
     }
 
     // Then, actually send the segments.
-    for(NSString * segment in dataSegs) {
-        [self.webSocket send:segment];
+    const char *bytes = jsonData.bytes;
+    for(NSValue * segment in dataSegs) {
+        NSRange range = [segment rangeValue];
+        [self.webSocket send:[[NSString alloc] initWithBytes:bytes + range.location
+                                                      length:range.length
+                                                    encoding:NSUTF8StringEncoding]];
     }
 }
 
@@ -176,7 +180,7 @@
 
 - (void) handleNewFrameCount:(int) numFrames {
     self.totalFrames = numFrames;
-    frame = [[NSMutableString alloc] initWithString:@""];
+    frame = [[NSMutableData alloc] init];
     FFLog(@"I-RDB083006", @"(wsc:%@) handleNewFrameCount: %d", self.connectionId, self.totalFrames);
 }
 
@@ -193,12 +197,17 @@
 }
 
 - (void) appendFrame:(NSString *) message {
-    [frame appendString:message];
+    NSData* messageData = [message dataUsingEncoding:NSUTF8StringEncoding];
     self.totalFrames = self.totalFrames - 1;
 
     if (self.totalFrames == 0) {
-        // Call delegate and pass an immutable version of the frame
-        NSDictionary* json = [NSJSONSerialization JSONObjectWithData:[frame dataUsingEncoding:NSUTF8StringEncoding]
+        // A message that came in a single frame, the common case, is parsed without copying it into the buffer
+        NSData* data = messageData;
+        if (frame.length > 0) {
+            [frame appendData:messageData];
+            data = frame;
+        }
+        NSDictionary* json = [NSJSONSerialization JSONObjectWithData:data
                                                              options:kNilOptions
                                                                error:nil];
         frame = nil;
@@ -207,6 +216,8 @@
         @autoreleasepool {
             [self.delegate onMessage:self withMessage:json];
         }
+    } else {
+        [frame appendData:messageData];
     }
 }
 
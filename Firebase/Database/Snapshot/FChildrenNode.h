@@ -21,6 +21,8 @@
 #import "FImmutableSortedDictionary.h"
 
 @class FNamedNode;
+@class FImmutableSortedSet;
+@protocol FIndex;
 
 @interface FChildrenNode : NSObject <FNode>
 
@@ -34,6 +36,19 @@
 - (FNamedNode *) firstChild;
 - (FNamedNode *) lastChild;
 
+// The representation of this node within a range of a compound hash and the keys leading to the last leaf in it,
+// cached since nodes are immutable
+- (NSString *) compoundHashRepresentation;
+- (NSArray *) compoundHashLastLeafKeys;
+
+// See FSnapshotUtilities estimateSerializedNodeSize:
+- (NSUInteger) estimatedSerializedSize;
+
+// Sorted sets of the children built by FIndexedNode, keyed by index, so that views of the same location ordered by
+// the same index can share a single set
+- (FImmutableSortedSet *) cachedIndexedSetForIndex:(id<FIndex>)index;
+- (void) cacheIndexedSet:(FImmutableSortedSet *)indexedSet forIndex:(id<FIndex>)index;
+
 @property (nonatomic, strong) FImmutableSortedDictionary* children;
 @property (nonatomic, strong) id<FNode> priorityNode;
 
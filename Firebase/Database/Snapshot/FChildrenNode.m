@@ -25,10 +25,16 @@
 #import "FSnapshotUtilities.h"
 #import "FTransformedEnumerator.h"
 #import "FPriorityIndex.h"
+#import "FIndex.h"
 #import "FUtilities.h"
 
 @interface FChildrenNode ()
 @property (nonatomic, strong) NSString *lazyHash;
+@property (nonatomic, strong) NSNumber *lazyHashCode;
+@property (nonatomic, strong) NSString *lazyCompoundHashRepresentation;
+@property (nonatomic, strong) NSArray *lazyCompoundHashLastLeafKeys;
+@property (nonatomic, strong) NSNumber *lazyEstimatedSerializedSize;
+@property (nonatomic, strong) NSMutableDictionary *indexedSets;
 @end
 
 @implementation FChildrenNode
@@ -307,12 +313,76 @@
 }
 
 - (NSUInteger)hash {
-    __block NSUInteger hashCode = 0;
-    [self enumerateChildrenUsingBlock:^(NSString *key, id<FNode> node, BOOL *stop) {
-        hashCode = 31 * hashCode + key.hash;
-        hashCode = 17 * hashCode + node.hash;
-    }];
-    return 17 * hashCode + self.priorityNode.hash;
+    // Cached like dataHash, since this would otherwise visit the entire subtree every time
+    if (self.lazyHashCode == nil) {
+        __block NSUInteger hashCode = 0;
+        [self enumerateChildrenUsingBlock:^(NSString *key, id<FNode> node, BOOL *stop) {
+            hashCode = 31 * hashCode + key.hash;
+            hashCode = 17 * hashCode + node.hash;
+        }];
+        self.lazyHashCode = @(17 * hashCode + self.priorityNode.hash);
+    }
+    return [self.lazyHashCode unsignedIntegerValue];
+}
+
+- (NSString *) compoundHashRepresentation {
+    if (self.lazyCompoundHashRepresentation == nil) {
+        NSMutableString *representation = [[NSMutableString alloc] init];
+        __block NSString *lastKey = nil;
+        __block id<FNode> lastNode = nil;
+        [self enumerateChildrenAndPriorityUsingBlock:^(NSString *key, id<FNode> node, BOOL *stop) {
+            if (lastKey != nil) {
+                [representation appendString:@","];
+            }
+            [FSnapshotUtilities appendHashV2RepresentationForString:key toString:representation];
+            [representation appendString:@":("];
+            [representation appendString:[(id)node compoundHashRepresentation]];
+            [representation appendString:@")"];
+            lastKey = key;
+            lastNode = node;
+        }];
+        NSArray *lastLeafKeys = lastKey == nil ? @[] : @[lastKey];
+        if (lastNode != nil && ![lastNode isLeafNode]) {
+            lastLeafKeys = [lastLeafKeys arrayByAddingObjectsFromArray:[(FChildrenNode *)lastNode compoundHashLastLeafKeys]];
+        }
+        self.lazyCompoundHashLastLeafKeys = lastLeafKeys;
+        self.lazyCompoundHashRepresentation = representation;
+    }
+    return self.lazyCompoundHashRepresentation;
+}
+
+- (NSArray *) compoundHashLastLeafKeys {
+    [self compoundHashRepresentation];
+    return self.lazyCompoundHashLastLeafKeys;
+}
+
+- (NSUInteger) estimatedSerializedSize {
+    if (self.lazyEstimatedSerializedSize == nil) {
+        __block NSUInteger sum = 1; // opening brackets
+        [self enumerateChildrenAndPriorityUsingBlock:^(NSString *key, id<FNode> child, BOOL *stop) {
+            sum += key.length;
+            sum += 4; // quotes around key and colon and (comma or closing bracket)
+            sum += [FSnapshotUtilities estimateSerializedNodeSize:child];
+        }];
+        self.lazyEstimatedSerializedSize = @(sum);
+    }
+    return [self.lazyEstimatedSerializedSize unsignedIntegerValue];
+}
+
+- (FImmutableSortedSet *) cachedIndexedSetForIndex:(id<FIndex>)index {
+    // Snapshots may be enumerated off the worker queue, so guard the cache
+    @synchronized (self) {
+        return self.indexedSets[[index queryDefinition]];
+    }
+}
+
+- (void) cacheIndexedSet:(FImmutableSortedSet *)indexedSet forIndex:(id<FIndex>)index {
+    @synchronized (self) {
+        if (self.indexedSets == nil) {
+            self.indexedSets = [NSMutableDictionary dictionary];
+        }
+        self.indexedSets[[index queryDefinition]] = indexedSet;
+    }
 }
 
 - (void) enumerateChildrenAndPriorityUsingBlock:(void (^)(NSString *, id<FNode>, BOOL *))block
@@ -73,33 +73,58 @@ static FImmutableSortedSet *FALLBACK_INDEX;
     return self;
 }
 
+/**
+ * Sorts the children of a node by the given index, or returns the fallback index if the node's own key order already
+ * is the index order.
+ */
++ (FImmutableSortedSet *)indexedSetForNode:(id<FNode>)node index:(id<FIndex>)index
+{
+    if ([index isEqual:[FKeyIndex keyIndex]]) {
+        return [FIndexedNode fallbackIndex];
+    }
+    __block BOOL sawChild = NO;
+    [node enumerateChildrenUsingBlock:^(NSString *key, id<FNode> child, BOOL *stop) {
+        sawChild = sawChild || [index isDefinedOn:child];
+        *stop = sawChild;
+    }];
+    if (!sawChild) {
+        return [FIndexedNode fallbackIndex];
+    }
+    return [FIndexedNode sortedChildrenOfNode:node index:index];
+}
+
++ (FImmutableSortedSet *)sortedChildrenOfNode:(id<FNode>)node index:(id<FIndex>)index
+{
+    NSMutableDictionary *dict = [NSMutableDictionary dictionary];
+    [node enumerateChildrenUsingBlock:^(NSString *key, id<FNode> child, BOOL *stop) {
+        FNamedNode *namedNode = [[FNamedNode alloc] initWithName:key andNode:child];
+        dict[namedNode] = [NSNull null];
+    }];
+    // The comparator is retained by the set, so it must only capture the index
+    return [FImmutableSortedSet setWithKeysFromDictionary:dict
+                                               comparator:^NSComparisonResult(FNamedNode *namedNode1, FNamedNode *namedNode2) {
+        return [index compareNamedNode:namedNode1 toNamedNode:namedNode2];
+    }];
+}
+
+/**
+ * Returns the indexed set if it was already built, either by this indexed node or by another one for the same node
+ * and index, or nil otherwise.
+ */
+- (FImmutableSortedSet *)existingIndexed
+{
+    if (!self.indexed && [self.node isKindOfClass:[FChildrenNode class]]) {
+        self.indexed = [(FChildrenNode *)self.node cachedIndexedSetForIndex:self.index];
+    }
+    return self.indexed;
+}
+
 - (void)ensureIndexed
 {
-    if (!self.indexed) {
-        if ([self.index isEqual:[FKeyIndex keyIndex]]) {
-            self.indexed = [FIndexedNode fallbackIndex];
-        } else {
-            __block BOOL sawChild;
-            [self.node enumerateChildrenUsingBlock:^(NSString *key, id<FNode> node, BOOL *stop) {
-                sawChild = sawChild || [self.index isDefinedOn:node];
-                *stop = sawChild;
-            }];
-            if (sawChild) {
-                NSMutableDictionary *dict = [NSMutableDictionary dictionary];
-                [self.node enumerateChildrenUsingBlock:^(NSString *key, id<FNode> node, BOOL *stop) {
-                    FNamedNode *namedNode = [[FNamedNode alloc] initWithName:key andNode:node];
-                    dict[namedNode] = [NSNull null];
-                }];
-                // Make sure to assign index here, because the comparator will be retained and using self will cause a
-                // cycle
-                id<FIndex> index = self.index;
-                self.indexed = [FImmutableSortedSet setWithKeysFromDictionary:dict
-                                                                   comparator:^NSComparisonResult(FNamedNode *namedNode1, FNamedNode *namedNode2) {
-                    return [index compareNamedNode:namedNode1 toNamedNode:namedNode2];
-                }];
-            } else {
-                self.indexed = [FIndexedNode fallbackIndex];
-            }
+    if (![self existingIndexed]) {
+        self.indexed = [FIndexedNode indexedSetForNode:self.node index:self.index];
+        if ([self.node isKindOfClass:[FChildrenNode class]]) {
+            [(FChildrenNode *)self.node cacheIndexedSet:self.indexed forIndex:self.index];
         }
     }
 }
@@ -112,15 +137,22 @@ static FImmutableSortedSet *FALLBACK_INDEX;
 - (FIndexedNode *)updateChild:(NSString *)key withNewChild:(id<FNode>)newChildNode
 {
     id<FNode> newNode = [self.node updateImmediateChild:key withNewChild:newChildNode];
-    if (self.indexed == [FIndexedNode fallbackIndex] && ![self.index isDefinedOn:newChildNode]) {
+    FImmutableSortedSet *indexed = [self existingIndexed];
+    if (indexed == [FIndexedNode fallbackIndex] &&
+        ([self.index isEqual:[FKeyIndex keyIndex]] || ![self.index isDefinedOn:newChildNode])) {
         // doesn't affect the index, no need to create an index
         return [[FIndexedNode alloc] initWithNode:newNode index:self.index indexed:[FIndexedNode fallbackIndex]];
-    } else if (!self.indexed || self.indexed == [FIndexedNode fallbackIndex]) {
+    } else if (!indexed) {
         // No need to index yet, index lazily
         return [[FIndexedNode alloc] initWithNode:newNode index:self.index];
     } else {
+        if (indexed == [FIndexedNode fallbackIndex]) {
+            // The first child the index is defined on. Sort the existing children now so that the index is carried
+            // forward from here instead of being rebuilt after every update.
+            indexed = [FIndexedNode sortedChildrenOfNode:self.node index:self.index];
+        }
         id<FNode> oldChild = [self.node getImmediateChild:key];
-        FImmutableSortedSet *newIndexed = [self.indexed removeObject:[FNamedNode nodeWithName:key node:oldChild]];
+        FImmutableSortedSet *newIndexed = [indexed removeObject:[FNamedNode nodeWithName:key node:oldChild]];
         if (![newChildNode isEmpty]) {
             newIndexed = [newIndexed addObject:[FNamedNode nodeWithName:key node:newChildNode]];
         }
@@ -23,6 +23,9 @@
 - (id)initWithValue:(id)aValue;
 - (id)initWithValue:(id)aValue withPriority:(id<FNode>)aPriority;
 
+// The representation of this node within a range of a compound hash, cached since nodes are immutable
+- (NSString *)compoundHashRepresentation;
+
 @property (nonatomic, strong) id value;
 
 @end
@@ -26,6 +26,7 @@
 @interface FLeafNode ()
 @property (nonatomic, strong) id<FNode> priorityNode;
 @property (nonatomic, strong) NSString *lazyHash;
+@property (nonatomic, strong) NSString *lazyCompoundHashRepresentation;
 
 @end
 
@@ -196,6 +197,15 @@
     return self.lazyHash;
 }
 
+- (NSString *) compoundHashRepresentation {
+    if (self.lazyCompoundHashRepresentation == nil) {
+        NSMutableString *representation = [[NSMutableString alloc] init];
+        [FSnapshotUtilities appendHashRepresentationForLeafNode:self toString:representation hashVersion:FDataHashVersionV2];
+        self.lazyCompoundHashRepresentation = representation;
+    }
+    return self.lazyCompoundHashRepresentation;
+}
+
 - (NSComparisonResult)compare:(id <FNode>)other {
     if (other == [FEmptyNode emptyNode]) {
         return NSOrderedDescending;
@@ -288,13 +288,8 @@
         return [FSnapshotUtilities estimateLeafNodeSize:node];
     } else {
         NSAssert([node isKindOfClass:[FChildrenNode class]], @"Unexpected node type: %@", [node class]);
-        __block NSUInteger sum = 1; // opening brackets
-        [((FChildrenNode *)node) enumerateChildrenAndPriorityUsingBlock:^(NSString *key, id<FNode>child, BOOL *stop) {
-            sum += key.length;
-            sum += 4; // quotes around key and colon and (comma or closing bracket)
-            sum += [FSnapshotUtilities estimateSerializedNodeSize:child];
-        }];
-        return sum;
+        // Cached on the node, since it is immutable
+        return [((FChildrenNode *)node) estimatedSerializedSize];
     }
 }
 
@@ -19,5 +19,10 @@
 @interface FNextPushId : NSObject
 
 + (NSString *) get:(NSTimeInterval)now;
+/**
+ * Generates count consecutive push IDs at once, e.g. for a bulk insert of childByAutoId children. Safe to call from
+ * any thread; IDs are unique and ordered across all callers.
+ */
++ (NSArray *) get:(NSTimeInterval)now count:(NSUInteger)count;
 
 @end
@@ -17,47 +17,66 @@
 #import "FNextPushId.h"
 #import "FUtilities.h"
 
-static NSString *const PUSH_CHARS = @"-0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz";
+#include <stdatomic.h>
 
-@implementation FNextPushId
+static const char PUSH_CHARS[] = "-0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz";
 
-+ (NSString *) get:(NSTimeInterval)currentTime {
-    static long long lastPushTime = 0;
-    static int lastRandChars[12];
+// The generator state is a millisecond timestamp with a sequence number in the low bits, so that a single atomic
+// compare-and-swap hands out a unique, increasing (time, sequence) pair. A sequence that overflows carries into the
+// timestamp, which keeps IDs ordered at the cost of dating them slightly in the future.
+static const int kSequenceBits = 22;
+static _Atomic uint64_t lastPushState = 0;
 
-    long long now = (long long)(currentTime * 1000);
+@implementation FNextPushId
 
-    BOOL duplicateTime = now == lastPushTime;
-    lastPushTime = now;
++ (NSString *) get:(NSTimeInterval)currentTime {
+    return [self get:currentTime count:1][0];
+}
 
-    unichar timeStampChars[8];
-    for(int i = 7; i >= 0; i--) {
-        timeStampChars[i] = [PUSH_CHARS characterAtIndex:(now % 64)];
-        now = (long long)floor(now / 64);
++ (NSArray *) get:(NSTimeInterval)currentTime count:(NSUInteger)count {
+    if (count == 0) {
+        return @[];
     }
 
-    NSMutableString* id = [[NSMutableString alloc] init];
-    [id appendString:[NSString stringWithCharacters:timeStampChars length:8]];
+    uint64_t now = (uint64_t)(currentTime * 1000);
+    uint64_t state = atomic_load(&lastPushState);
+    uint64_t first;
+    do {
+        if (now > (state >> kSequenceBits)) {
+            // A new millisecond starts its sequence at a random point in the lower half of the range, which keeps
+            // IDs from different clients in the same millisecond apart while leaving room for increments.
+            first = (now << kSequenceBits) | arc4random_uniform(1 << (kSequenceBits - 1));
+        } else {
+            // Same millisecond (or the clock went backwards): continue the sequence
+            first = state + 1;
+        }
+    } while (!atomic_compare_exchange_weak(&lastPushState, &state, first + count - 1));
 
+    // The last 8 characters are independently random for each ID. 64 divides 256, so every char is equally likely.
+    uint8_t *randBytes = malloc(count * 8);
+    arc4random_buf(randBytes, count * 8);
 
-    if(!duplicateTime) {
-        for(int i = 0; i < 12; i++) {
-            lastRandChars[i] = (int)floor(arc4random() % 64);
+    NSMutableArray *ids = [NSMutableArray arrayWithCapacity:count];
+    unichar chars[20];
+    for (NSUInteger n = 0; n < count; n++) {
+        uint64_t value = first + n;
+        uint64_t time = value >> kSequenceBits;
+        uint64_t sequence = value & ((1 << kSequenceBits) - 1);
+        for (int i = 7; i >= 0; i--) {
+            chars[i] = PUSH_CHARS[time % 64];
+            time /= 64;
         }
-    }
-    else {
-        int i = 0;
-        for(i = 11; i >= 0 && lastRandChars[i] == 63; i--) {
-            lastRandChars[i] = 0;
+        for (int i = 11; i >= 8; i--) {
+            chars[i] = PUSH_CHARS[sequence % 64];
+            sequence /= 64;
         }
-        lastRandChars[i]++;
-    }
-
-    for(int i = 0; i < 12; i++) {
-        [id appendFormat:@"%C", [PUSH_CHARS characterAtIndex:lastRandChars[i]]];
+        for (int i = 12; i < 20; i++) {
+            chars[i] = PUSH_CHARS[randBytes[n * 8 + (i - 12)] % 64];
+        }
+        [ids addObject:[NSString stringWithCharacters:chars length:20]];
     }
-
-    return [NSString stringWithString:id];
+    free(randBytes);
+    return ids;
 }
 
 @end
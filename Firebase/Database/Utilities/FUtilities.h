@@ -20,6 +20,8 @@
 @interface FUtilities : NSObject
 
 + (NSArray *) splitString:(NSString *)str intoMaxSize:(const unsigned int)size;
+// Returns the ranges, as NSValues, of segments of at most size bytes that don't split any UTF-8 characters
++ (NSArray *) rangesSplittingUTF8Data:(NSData *)data intoMaxSize:(const unsigned int)size;
 + (NSNumber *) LUIDGenerator;
 + (FParsedUrl *) parseUrl:(NSString *)url;
 + (NSString *) getJavascriptType:(id)obj;
@@ -105,6 +105,23 @@ void firebaseJobsTroll(void) {
     return dataSegs;
 }
 
++ (NSArray *) rangesSplittingUTF8Data:(NSData *)data intoMaxSize:(const unsigned int)size {
+    NSAssert(size >= 4, @"Segments must be able to hold any UTF-8 character");
+    const uint8_t *bytes = data.bytes;
+    NSMutableArray *ranges = [[NSMutableArray alloc] init];
+    NSUInteger start = 0;
+    while (start < data.length) {
+        NSUInteger end = MIN(start + size, data.length);
+        // Back up to the start of the character if the segment would end in the middle of it
+        while (end < data.length && (bytes[end] & 0xC0) == 0x80) {
+            end--;
+        }
+        [ranges addObject:[NSValue valueWithRange:NSMakeRange(start, end - start)]];
+        start = end;
+    }
+    return ranges;
+}
+
 + (NSNumber *) LUIDGenerator {
     FUtilities* f = [FUtilities singleton];
     return [f.localUid getAndIncrement];
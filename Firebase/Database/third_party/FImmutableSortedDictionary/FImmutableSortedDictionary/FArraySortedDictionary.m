@@ -101,13 +101,32 @@
     return self;
 }
 
-- (NSInteger) findInsertPositionForKey:(id)key
+/*
+ * Binary searches for the position of the first key that is not less than the given key. If found is given, it is set
+ * to whether the key at that position is equal to the given key.
+ */
+- (NSInteger) findInsertPositionForKey:(id)key found:(BOOL *)found
 {
-    NSInteger newPos = 0;
-    while (newPos < self.keys.count && self.comparator(self.keys[newPos], key) < NSOrderedSame) {
-        newPos++;
+    NSArray *keys = self.keys;
+    NSInteger low = 0;
+    NSInteger high = keys.count;
+    while (low < high) {
+        NSInteger mid = (low + high) / 2;
+        if (self.comparator(keys[mid], key) == NSOrderedAscending) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (found != NULL) {
+        *found = low < keys.count && self.comparator(key, keys[low]) == NSOrderedSame;
     }
-    return newPos;
+    return low;
+}
+
+- (NSInteger) findInsertPositionForKey:(id)key
+{
+    return [self findInsertPositionForKey:key found:NULL];
 }
 
 - (NSInteger) findKey:(id)key
@@ -115,22 +134,17 @@
     if (key == nil) {
         return NSNotFound;
     }
-    for (NSInteger pos = 0; pos < self.keys.count; pos++) {
-        NSComparisonResult result = self.comparator(key, self.keys[pos]);
-        if (result == NSOrderedSame) {
-            return pos;
-        } else if (result == NSOrderedAscending) {
-            return NSNotFound;
-        }
-    }
-    return NSNotFound;
+    BOOL found;
+    NSInteger pos = [self findInsertPositionForKey:key found:&found];
+    return found ? pos : NSNotFound;
 }
 
 - (FImmutableSortedDictionary *) insertKey:(id)key withValue:(id)value
 {
-    NSInteger pos = [self findKey:key];
+    BOOL found;
+    NSInteger pos = [self findInsertPositionForKey:key found:&found];
 
-    if (pos == NSNotFound) {
+    if (!found) {
         /*
          * If we're above the threshold we want to convert it to a tree backed implementation to not have
          * degrading performance
@@ -143,19 +157,21 @@
             dict[key] = value;
             return [FTreeSortedDictionary fromDictionary:dict withComparator:self.comparator];
         } else {
-            NSMutableArray *newKeys = [NSMutableArray arrayWithArray:self.keys];
-            NSMutableArray *newValues = [NSMutableArray arrayWithArray:self.values];
-            NSInteger newPos = [self findInsertPositionForKey:key];
-            [newKeys insertObject:key atIndex:newPos];
-            [newValues insertObject:value atIndex:newPos];
+            NSMutableArray *newKeys = [NSMutableArray arrayWithCapacity:self.keys.count + 1];
+            [newKeys addObjectsFromArray:self.keys];
+            NSMutableArray *newValues = [NSMutableArray arrayWithCapacity:self.values.count + 1];
+            [newValues addObjectsFromArray:self.values];
+            [newKeys insertObject:key atIndex:pos];
+            [newValues insertObject:value atIndex:pos];
             return [[FArraySortedDictionary alloc] initWithComparator:self.comparator keys:newKeys values:newValues];
         }
+    } else if (self.values[pos] == value) {
+        return self;
     } else {
-        NSMutableArray *newKeys = [NSMutableArray arrayWithArray:self.keys];
+        // The key is equal, so only the values need copying
         NSMutableArray *newValues = [NSMutableArray arrayWithArray:self.values];
-        newKeys[pos] = key;
         newValues[pos] = value;
-        return [[FArraySortedDictionary alloc] initWithComparator:self.comparator keys:newKeys values:newValues];
+        return [[FArraySortedDictionary alloc] initWithComparator:self.comparator keys:self.keys values:newValues];
     }
 }
 
@@ -83,6 +83,7 @@ typedef NS_ENUM(NSInteger, FIRMessagingMessageCode) {
   kFIRMessagingMessageCodeConnection021 = 5021,  // I-FCM005021
   kFIRMessagingMessageCodeConnection022 = 5022,  // I-FCM005022
   kFIRMessagingMessageCodeConnection023 = 5023,  // I-FCM005023
+  kFIRMessagingMessageCodeConnection024 = 5024,  // I-FCM005024
   // FIRMessagingContextManagerService.m
   kFIRMessagingMessageCodeContextManagerService000 = 6000,  // I-FCM006000
   kFIRMessagingMessageCodeContextManagerService001 = 6001,  // I-FCM006001
@@ -137,6 +138,7 @@ typedef NS_ENUM(NSInteger, FIRMessagingMessageCode) {
   kFIRMessagingMessageCodeRmq2PersistentStoreErrorOpeningDatabase = 13008,  // I-FCM013008
   kFIRMessagingMessageCodeRmq2PersistentStoreInvalidRmqDirectory = 13009,  // I-FCM013009
   kFIRMessagingMessageCodeRmq2PersistentStoreErrorCreatingTable = 13010,  // I-FCM013010
+  kFIRMessagingMessageCodeRmq2PersistentStoreErrorConfiguringDatabase = 13011,  // I-FCM013011
   // FIRMessagingRmqManager.m
   kFIRMessagingMessageCodeRmqManager000 = 14000,  // I-FCM014000
   // FIRMessagingSecureSocket.m
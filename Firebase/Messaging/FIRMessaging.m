@@ -281,8 +281,8 @@ static NSString *const kFIRMessagingPlistAutoInitEnabled =
 }
 
 - (void)setupRmqManager {
+  // The RMQ database is opened, and the next RMQ ID loaded, on first use rather than at launch.
   self.rmq2Manager = [[FIRMessagingRmqManager alloc] initWithDatabaseName:@"rmq2"];
-  [self.rmq2Manager loadRmqId];
 }
 
 - (void)setupTopics {
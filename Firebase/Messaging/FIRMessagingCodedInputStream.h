@@ -24,5 +24,10 @@
 - (BOOL)readTag:(int8_t *)tag;
 - (BOOL)readLength:(int32_t *)length;
 - (NSData *)readDataWithLength:(uint32_t)length;
+/**
+ * Reads the next |length| bytes without copying them. The returned data points into the buffer
+ * the stream was created with, so it is only valid for as long as that buffer is left unchanged.
+ */
+- (NSData *)readDataNoCopyWithLength:(uint32_t)length;
 
 @end
@@ -23,6 +23,7 @@
 #import "FIRMessagingDataMessageManager.h"
 #import "FIRMessagingDefines.h"
 #import "FIRMessagingLogger.h"
+#import "FIRMessagingMetrics.h"
 #import "FIRMessagingRmqManager.h"
 #import "FIRMessagingSecureSocket.h"
 #import "FIRMessagingUtilities.h"
@@ -35,12 +36,20 @@ static int const kInvalidStreamId = -1;
 // Threshold for number of messages removed that we will ack, for short lived connections
 static int const kMessageRemoveAckThresholdCount = 5;
 
-static NSTimeInterval const kHeartbeatInterval = 30.0;
+// The heartbeat interval starts at the minimum and is stretched while heartbeats sent after a
+// full idle interval keep being answered. It shrinks again when such a heartbeat times out.
+static NSTimeInterval const kMinHeartbeatInterval = 30.0;
+static NSTimeInterval const kMaxHeartbeatInterval = 15 * 60.0;
+static double const kHeartbeatIntervalGrowthFactor = 1.5;
+static int const kHeartbeatSuccessesBeforeGrowing = 3;
+// Slack for the run loop firing the heartbeat timer slightly early.
+static NSTimeInterval const kHeartbeatIdleTolerance = 1.0;
 static NSTimeInterval const kConnectionTimeout = 20.0;
 static int32_t const kAckingInterval = 10;
 
 static NSString *const kUnackedS2dIdKey = @"FIRMessagingUnackedS2dIdKey";
 static NSString *const kAckedS2dIdMapKey = @"FIRMessagingAckedS2dIdMapKey";
+static NSString *const kHeartbeatIntervalKeyPrefix = @"FIRMessagingHeartbeatInterval-";
 
 static NSString *const kRemoteFromAddress = @"from";
 
@@ -104,6 +113,18 @@ static NSString *const kRemoteFromAddress = @"from";
 
 @property(nonatomic, readwrite, strong) NSRunLoop *runLoop;
 
+// When the socket was opened and the last unanswered heartbeat ping was sent, or 0
+@property(nonatomic, readwrite, assign) CFAbsoluteTime connectStartTime;
+@property(nonatomic, readwrite, assign) CFAbsoluteTime heartbeatPingSentTime;
+
+// The heartbeat interval learned for the network type the socket was opened on.
+@property(nonatomic, readwrite, assign) NSTimeInterval heartbeatInterval;
+@property(nonatomic, readwrite, copy) NSString *heartbeatIntervalKey;
+@property(nonatomic, readwrite, assign) int successfulHeartbeatCount;
+@property(nonatomic, readwrite, assign) CFAbsoluteTime lastReceivedTrafficTime;
+// How long the connection had been quiet when the outstanding heartbeat ping was sent.
+@property(nonatomic, readwrite, assign) NSTimeInterval heartbeatPingIdleTime;
+
 @end
 
 
@@ -131,6 +152,7 @@ static NSString *const kRemoteFromAddress = @"from";
     _unackedS2dIds = [NSMutableArray arrayWithArray:[_rmq2Manager unackedS2dRmqIds]];
     _ackedS2dMap = [NSMutableDictionary dictionary];
     _sendOnConnectMessages = [NSMutableArray array];
+    _heartbeatInterval = kMinHeartbeatInterval;
   }
   return self;
 }
@@ -161,6 +183,10 @@ static NSString *const kRemoteFromAddress = @"from";
 
 - (void)connectToSocket:(FIRMessagingSecureSocket *)socket {
   self.state = kFIRMessagingConnectionConnecting;
+  self.connectStartTime = CFAbsoluteTimeGetCurrent();
+  self.heartbeatPingSentTime = 0;
+  self.lastReceivedTrafficTime = 0;
+  [self loadHeartbeatInterval];
   FIRMessagingLoggerDebug(kFIRMessagingMessageCodeConnection000,
                           @"Start connecting to FIRMessaging service.");
   [socket connectToHost:self.host port:self.port onRunLoop:self.runLoop];
@@ -239,9 +265,10 @@ static NSString *const kRemoteFromAddress = @"from";
 
   // If traffic is received after a heartbeat it is safe to assume the connection is healthy.
   [self cancelConnectionTimeoutTask];
+  self.lastReceivedTrafficTime = CFAbsoluteTimeGetCurrent();
   [self performSelector:@selector(sendHeartbeatPing)
              withObject:nil
-             afterDelay:kHeartbeatInterval];
+             afterDelay:self.heartbeatInterval];
 
   [self willProcessProto:proto];
   switch (tag) {
@@ -389,6 +416,10 @@ static NSString *const kRemoteFromAddress = @"from";
                                            selector:@selector(sendHeartbeatPing)
                                              object:nil];
   [self scheduleConnectionTimeoutTask];
+  self.heartbeatPingSentTime = CFAbsoluteTimeGetCurrent();
+  self.heartbeatPingIdleTime = self.lastReceivedTrafficTime > 0
+                                   ? self.heartbeatPingSentTime - self.lastReceivedTrafficTime
+                                   : 0;
   [self sendProto:[[GtalkHeartbeatPing alloc] init]];
 }
 
@@ -444,6 +475,11 @@ static NSString *const kRemoteFromAddress = @"from";
   _FIRMessagingDevAssert(self.outStreamId == 1, @"Login should be the first stream id");
 
   self.state = kFIRMessagingConnectionSignedIn;
+  if (self.connectStartTime > 0) {
+    [FIRMessagingSharedMetrics() recordDuration:CFAbsoluteTimeGetCurrent() - self.connectStartTime
+                                      forTiming:kFIRMessagingMetricsConnect];
+    self.connectStartTime = 0;
+  }
   self.lastLoginServerTimestamp = loginResponse.serverTimestamp;
   [self.delegate didLoginWithConnection:self];
   [self sendHeartbeatPing];
@@ -460,6 +496,13 @@ static NSString *const kRemoteFromAddress = @"from";
 }
 
 - (void)didReceiveHeartbeatAck:(GtalkHeartbeatAck *)heartbeatAck {
+  if (self.heartbeatPingSentTime > 0) {
+    [FIRMessagingSharedMetrics()
+        recordDuration:CFAbsoluteTimeGetCurrent() - self.heartbeatPingSentTime
+             forTiming:kFIRMessagingMetricsHeartbeatRoundTrip];
+    self.heartbeatPingSentTime = 0;
+    [self heartbeatSurvivedIdleTime:self.heartbeatPingIdleTime];
+  }
 #if FIRMessaging_PROBER
   self.lastHeartbeatPingTimestamp = FIRMessagingCurrentTimestampInSeconds();
 #endif
@@ -678,6 +721,9 @@ static NSString *const kRemoteFromAddress = @"from";
 - (void)connectionTimedOut {
   FIRMessagingLoggerDebug(kFIRMessagingMessageCodeConnection022,
                           @"Connection to FIRMessaging service timed out.");
+  if (self.heartbeatPingSentTime > 0) {
+    [self heartbeatTimedOut];
+  }
   [self disconnect];
   [self.delegate connection:self didCloseForReason:kFIRMessagingConnectionCloseReasonTimeout];
 }
@@ -708,4 +754,55 @@ static NSString *const kRemoteFromAddress = @"from";
   return kConnectionTimeout;
 }
 
+#pragma mark - Heartbeat interval
+
++ (NSString *)heartbeatIntervalKeyForNetworkType:(int32_t)networkType {
+  return [NSString stringWithFormat:@"%@%d", kHeartbeatIntervalKeyPrefix, networkType];
+}
+
+- (void)loadHeartbeatInterval {
+  // NAT and firewall timeouts differ between carriers and WiFi networks, so each network type
+  // keeps its own interval.
+  self.heartbeatIntervalKey =
+      [[self class] heartbeatIntervalKeyForNetworkType:[[self class] currentNetworkType]];
+  NSTimeInterval interval =
+      [[NSUserDefaults standardUserDefaults] doubleForKey:self.heartbeatIntervalKey];
+  self.heartbeatInterval = MIN(MAX(interval, kMinHeartbeatInterval), kMaxHeartbeatInterval);
+  self.successfulHeartbeatCount = 0;
+}
+
+- (void)heartbeatSurvivedIdleTime:(NSTimeInterval)idleTime {
+  // A heartbeat sent while other traffic was flowing says nothing about how long an idle
+  // connection stays open.
+  if (idleTime + kHeartbeatIdleTolerance < self.heartbeatInterval) {
+    return;
+  }
+  self.successfulHeartbeatCount = self.successfulHeartbeatCount + 1;
+  if (self.successfulHeartbeatCount < kHeartbeatSuccessesBeforeGrowing) {
+    return;
+  }
+  self.successfulHeartbeatCount = 0;
+  [self updateHeartbeatInterval:self.heartbeatInterval * kHeartbeatIntervalGrowthFactor];
+}
+
+- (void)heartbeatTimedOut {
+  // Back off harder than we probe so a bad interval is abandoned after a single timeout.
+  self.successfulHeartbeatCount = 0;
+  [self updateHeartbeatInterval:self.heartbeatInterval / 2];
+}
+
+- (void)updateHeartbeatInterval:(NSTimeInterval)interval {
+  interval = MIN(MAX(interval, kMinHeartbeatInterval), kMaxHeartbeatInterval);
+  if (interval == self.heartbeatInterval) {
+    return;
+  }
+  FIRMessagingLoggerDebug(kFIRMessagingMessageCodeConnection024,
+                          @"Heartbeat interval changed from %.0fs to %.0fs.",
+                          self.heartbeatInterval, interval);
+  self.heartbeatInterval = interval;
+  if (self.heartbeatIntervalKey.length) {
+    [[NSUserDefaults standardUserDefaults] setDouble:interval forKey:self.heartbeatIntervalKey];
+  }
+}
+
 @end
@@ -104,12 +104,12 @@ typedef NS_ENUM(int8_t, UpstreamForceReconnect) {
 
 - (void)refreshDelayedMessages {
   FIRMessaging_WEAKIFY(self);
+  FIRMessagingSendDelayedMessagesHandler handler = ^(NSArray *messages) {
+    FIRMessaging_STRONGIFY(self);
+    [self sendDelayedMessages:messages];
+  };
   self.delayedMessagesQueue =
-      [[FIRMessagingDelayedMessageQueue alloc] initWithRmqScanner:self.rmq2Manager
-                              sendDelayedMessagesHandler:^(NSArray *messages) {
-                                FIRMessaging_STRONGIFY(self);
-                                [self sendDelayedMessages:messages];
-                              }];
+      [[FIRMessagingDelayedMessageQueue alloc] initWithSendDelayedMessagesHandler:handler];
 }
 
 - (NSDictionary *)processPacket:(GtalkDataMessageStanza *)dataMessage {
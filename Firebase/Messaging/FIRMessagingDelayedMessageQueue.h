@@ -17,17 +17,20 @@
 #import <Foundation/Foundation.h>
 
 @class GtalkDataMessageStanza;
-@class FIRMessagingRmqManager;
-
-@protocol FIRMessagingRmqScanner;
 
 typedef void(^FIRMessagingSendDelayedMessagesHandler)(NSArray *messages);
 
 @interface FIRMessagingDelayedMessageQueue : NSObject
 
-- (instancetype)initWithRmqScanner:(id<FIRMessagingRmqScanner>)rmqScanner
-        sendDelayedMessagesHandler:(FIRMessagingSendDelayedMessagesHandler)sendDelayedMessagesHandler;
+- (instancetype)initWithSendDelayedMessagesHandler:
+    (FIRMessagingSendDelayedMessagesHandler)sendDelayedMessagesHandler;
 
+/**
+ *  Holds on to a message until the earliest max delay of the queued messages passes, or until
+ *  they are removed to go out along with an urgent message.
+ *
+ *  @return NO if the queue is full, in which case the message should be sent right away.
+ */
 - (BOOL)queueMessage:(GtalkDataMessageStanza *)message;
 
 - (NSArray *)removeDelayedMessages;
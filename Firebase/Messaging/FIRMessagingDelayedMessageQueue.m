@@ -19,23 +19,19 @@
 #import "Protos/GtalkCore.pbobjc.h"
 
 #import "FIRMessagingDefines.h"
-#import "FIRMessagingRmqManager.h"
 #import "FIRMessagingUtilities.h"
 
 static const int kMaxQueuedMessageCount = 10;
 
 @interface FIRMessagingDelayedMessageQueue ()
 
-@property(nonatomic, readonly, weak) id<FIRMessagingRmqScanner> rmqScanner;
 @property(nonatomic, readonly, copy) FIRMessagingSendDelayedMessagesHandler sendDelayedMessagesHandler;
 
-@property(nonatomic, readwrite, assign) int persistedMessageCount;
 // the scheduled timeout or -1 if not set
 @property(nonatomic, readwrite, assign) int64_t scheduledTimeoutMilliseconds;
-// The time  of the last scan of the message DB,
-// used to avoid retrieving messages more than once.
-@property(nonatomic, readwrite, assign) int64_t lastDBScanTimestampSeconds;
 
+// All the delayed messages, in the order they were queued. Messages with a ttl are also in the RMQ,
+// but keeping them here too means sending them doesn't require scanning the RMQ.
 @property(nonatomic, readwrite, strong) NSMutableArray *messages;
 @property(nonatomic, readwrite, strong) NSTimer *sendTimer;
 
@@ -47,14 +43,13 @@ static const int kMaxQueuedMessageCount = 10;
   FIRMessagingInvalidateInitializer();
 }
 
-- (instancetype)initWithRmqScanner:(id<FIRMessagingRmqScanner>)rmqScanner
-        sendDelayedMessagesHandler:(FIRMessagingSendDelayedMessagesHandler)sendDelayedMessagesHandler {
+- (instancetype)initWithSendDelayedMessagesHandler:
+    (FIRMessagingSendDelayedMessagesHandler)sendDelayedMessagesHandler {
   _FIRMessagingDevAssert(sendDelayedMessagesHandler, @"Invalid nil callback for delayed messages");
   self = [super init];
   if (self) {
-    _rmqScanner = rmqScanner;
     _sendDelayedMessagesHandler = sendDelayedMessagesHandler;
-    _messages = [NSMutableArray arrayWithCapacity:10];
+    _messages = [NSMutableArray arrayWithCapacity:kMaxQueuedMessageCount];
     _scheduledTimeoutMilliseconds = -1;
   }
   return self;
@@ -64,12 +59,8 @@ static const int kMaxQueuedMessageCount = 10;
   if (self.messages.count >= kMaxQueuedMessageCount) {
     return NO;
   }
-  if (message.ttl == 0) {
-    // ttl=0 messages aren't persisted, add it to memory
-    [self.messages addObject:message];
-  } else {
-    self.persistedMessageCount++;
-  }
+  [self.messages addObject:message];
+  // Only the earliest deadline needs a timer, since all queued messages are sent when it fires
   int64_t timeoutMillis = [self calculateTimeoutInMillisWithDelayInSeconds:message.maxDelay];
   if (![self isTimeoutScheduled] || timeoutMillis < self.scheduledTimeoutMilliseconds) {
     [self scheduleTimeoutInMillis:timeoutMillis];
@@ -79,31 +70,12 @@ static const int kMaxQueuedMessageCount = 10;
 
 - (NSArray *)removeDelayedMessages {
   [self cancelTimeout];
-  if ([self messageCount] == 0) {
+  if (self.messages.count == 0) {
     return @[];
   }
 
-  NSMutableArray *delayedMessages = [NSMutableArray array];
-  // add the ttl=0 messages
-  if (self.messages.count) {
-    [delayedMessages addObjectsFromArray:delayedMessages];
-    [self.messages removeAllObjects];
-  }
-
-  // add persistent messages
-  if (self.persistedMessageCount > 0) {
-    FIRMessaging_WEAKIFY(self);
-    [self.rmqScanner scanWithRmqMessageHandler:nil
-                            dataMessageHandler:^(int64_t rmqId, GtalkDataMessageStanza *stanza) {
-                              FIRMessaging_STRONGIFY(self);
-                              if ([stanza hasMaxDelay] &&
-                                  [stanza sent] >= self.lastDBScanTimestampSeconds) {
-                                [delayedMessages addObject:stanza];
-                              }
-                            }];
-    self.lastDBScanTimestampSeconds = FIRMessagingCurrentTimestampInSeconds();
-    self.persistedMessageCount = 0;
-  }
+  NSArray *delayedMessages = [self.messages copy];
+  [self.messages removeAllObjects];
   return delayedMessages;
 }
 
@@ -115,10 +87,6 @@ static const int kMaxQueuedMessageCount = 10;
 
 #pragma mark - Private
 
-- (NSInteger)messageCount {
-  return self.messages.count + self.persistedMessageCount;
-}
-
 - (BOOL)isTimeoutScheduled {
   return self.scheduledTimeoutMilliseconds > 0;
 }
@@ -131,7 +99,8 @@ static const int kMaxQueuedMessageCount = 10;
   [self cancelTimeout];
   self.scheduledTimeoutMilliseconds = time;
   double delay = (time - FIRMessagingCurrentTimestampInMilliseconds()) / 1000.0;
-  [self performSelector:@selector(sendMessages) withObject:self afterDelay:delay];
+  // The argument has to match the one cancelTimeout passes for the cancellation to apply
+  [self performSelector:@selector(sendMessages) withObject:nil afterDelay:delay];
 }
 
 - (void)cancelTimeout {
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+// Timings are snapshotted as "<name>.count", "<name>.total" and "<name>.max", in seconds.
+// Time spent handing each packet read from the MCS socket to the rest of the client.
+FOUNDATION_EXPORT NSString *const kFIRMessagingMetricsPacketProcessing;
+// Time taken by RMQ store reads and writes.
+FOUNDATION_EXPORT NSString *const kFIRMessagingMetricsRmqStoreOperation;
+// Time from opening the MCS socket to being signed in.
+FOUNDATION_EXPORT NSString *const kFIRMessagingMetricsConnect;
+// Time from sending a heartbeat ping to receiving its ack.
+FOUNDATION_EXPORT NSString *const kFIRMessagingMetricsHeartbeatRoundTrip;
+
+// Counters and gauges, snapshotted under their own names.
+FOUNDATION_EXPORT NSString *const kFIRMessagingMetricsBytesReceived;
+FOUNDATION_EXPORT NSString *const kFIRMessagingMetricsOutgoingQueueDepth;
+FOUNDATION_EXPORT NSString *const kFIRMessagingMetricsOutgoingQueueDepthMax;
+
+/**
+ * Collects client side performance numbers for the MCS connection and the RMQ, so that delivery
+ * regressions can be observed. All methods are thread safe.
+ */
+@interface FIRMessagingMetrics : NSObject
+
+- (void)recordDuration:(NSTimeInterval)duration forTiming:(NSString *)timing;
+- (void)recordBytesReceived:(NSUInteger)bytes;
+- (void)recordOutgoingQueueDepth:(NSUInteger)depth;
+
+/**
+ * The values recorded since the metrics were last reset, keyed by the names above.
+ */
+- (NSDictionary<NSString *, NSNumber *> *)snapshot;
+
+- (void)reset;
+
+@end
+
+/**
+ * Returns the metrics shared by all of FIRMessaging.
+ */
+FIRMessagingMetrics *FIRMessagingSharedMetrics(void);
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "FIRMessagingMetrics.h"
+
+NSString *const kFIRMessagingMetricsPacketProcessing = @"packet_processing";
+NSString *const kFIRMessagingMetricsRmqStoreOperation = @"rmq_store_operation";
+NSString *const kFIRMessagingMetricsConnect = @"connect";
+NSString *const kFIRMessagingMetricsHeartbeatRoundTrip = @"heartbeat_round_trip";
+
+NSString *const kFIRMessagingMetricsBytesReceived = @"bytes_received";
+NSString *const kFIRMessagingMetricsOutgoingQueueDepth = @"outgoing_queue_depth";
+NSString *const kFIRMessagingMetricsOutgoingQueueDepthMax = @"outgoing_queue_depth_max";
+
+@interface FIRMessagingMetrics ()
+
+// Timing name to an array of its count, total and max
+@property(nonatomic, readonly, strong) NSMutableDictionary *timings;
+@property(nonatomic, readwrite, assign) uint64_t bytesReceived;
+@property(nonatomic, readwrite, assign) NSUInteger outgoingQueueDepth;
+@property(nonatomic, readwrite, assign) NSUInteger outgoingQueueDepthMax;
+
+@end
+
+@implementation FIRMessagingMetrics
+
+- (instancetype)init {
+  self = [super init];
+  if (self) {
+    _timings = [NSMutableDictionary dictionary];
+  }
+  return self;
+}
+
+- (void)recordDuration:(NSTimeInterval)duration forTiming:(NSString *)timing {
+  @synchronized (self) {
+    NSArray *values = self.timings[timing];
+    NSUInteger count = [values[0] unsignedIntegerValue] + 1;
+    NSTimeInterval total = [values[1] doubleValue] + duration;
+    NSTimeInterval max = MAX([values[2] doubleValue], duration);
+    self.timings[timing] = @[ @(count), @(total), @(max) ];
+  }
+}
+
+- (void)recordBytesReceived:(NSUInteger)bytes {
+  @synchronized (self) {
+    self.bytesReceived += bytes;
+  }
+}
+
+- (void)recordOutgoingQueueDepth:(NSUInteger)depth {
+  @synchronized (self) {
+    self.outgoingQueueDepth = depth;
+    self.outgoingQueueDepthMax = MAX(self.outgoingQueueDepthMax, depth);
+  }
+}
+
+- (NSDictionary<NSString *, NSNumber *> *)snapshot {
+  @synchronized (self) {
+    NSMutableDictionary *snapshot = [NSMutableDictionary dictionary];
+    for (NSString *timing in self.timings) {
+      NSArray *values = self.timings[timing];
+      snapshot[[timing stringByAppendingString:@".count"]] = values[0];
+      snapshot[[timing stringByAppendingString:@".total"]] = values[1];
+      snapshot[[timing stringByAppendingString:@".max"]] = values[2];
+    }
+    snapshot[kFIRMessagingMetricsBytesReceived] = @(self.bytesReceived);
+    snapshot[kFIRMessagingMetricsOutgoingQueueDepth] = @(self.outgoingQueueDepth);
+    snapshot[kFIRMessagingMetricsOutgoingQueueDepthMax] = @(self.outgoingQueueDepthMax);
+    return snapshot;
+  }
+}
+
+- (void)reset {
+  @synchronized (self) {
+    [self.timings removeAllObjects];
+    self.bytesReceived = 0;
+    self.outgoingQueueDepthMax = self.outgoingQueueDepth;
+  }
+}
+
+@end
+
+FIRMessagingMetrics *FIRMessagingSharedMetrics(void) {
+  static dispatch_once_t onceToken;
+  static FIRMessagingMetrics *metrics;
+  dispatch_once(&onceToken, ^{
+    metrics = [[FIRMessagingMetrics alloc] init];
+  });
+
+  return metrics;
+}
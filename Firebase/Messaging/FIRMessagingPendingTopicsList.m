@@ -161,6 +161,7 @@ NSString *const kPendingTopicsTimestampEncodingKey = @"ts";
       NSMutableArray *handlers = lastBatch.topicHandlers[topic];
       if (!handlers) {
         handlers = [NSMutableArray arrayWithCapacity:1];
+        lastBatch.topicHandlers[topic] = handlers;
       }
       [handlers addObject:completion];
     }
@@ -28,11 +28,15 @@
 
 static NSString *const kPendingSubscriptionsListKey =
     @"com.firebase.messaging.pending-subscriptions";
+// Updates to the pending topics list within this many seconds are archived together
+static const NSTimeInterval kPendingTopicsListArchiveDelay = 1.0;
 
 @interface FIRMessagingPubSub () <FIRMessagingPendingTopicsListDelegate>
 
 @property(nonatomic, readwrite, strong) FIRMessagingPendingTopicsList *pendingTopicUpdates;
 @property(nonatomic, readwrite, strong) FIRMessagingClient *client;
+// Whether an archive of the pending topics list is already on its way. Guarded by self.
+@property(nonatomic, readwrite, assign) BOOL isArchiveScheduled;
 
 @end
 
@@ -183,7 +187,22 @@ static NSString *const kPendingSubscriptionsListKey =
 }
 
 - (void)pendingTopicsListDidUpdate:(FIRMessagingPendingTopicsList *)list {
-  [self archivePendingTopicsList:list];
+  // The list changes twice for every topic it syncs, so rather than rewriting the user defaults
+  // each time, archive the list once after a burst of updates.
+  @synchronized (self) {
+    if (self.isArchiveScheduled) {
+      return;
+    }
+    self.isArchiveScheduled = YES;
+  }
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW,
+                               (int64_t)(kPendingTopicsListArchiveDelay * NSEC_PER_SEC)),
+                 dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+    @synchronized (self) {
+      self.isArchiveScheduled = NO;
+    }
+    [self archivePendingTopicsList:list];
+  });
 }
 
 - (BOOL)pendingTopicsListCanRequestTopicUpdates:(FIRMessagingPendingTopicsList *)list {
@@ -195,7 +214,11 @@ static NSString *const kPendingSubscriptionsListKey =
 
 - (void)archivePendingTopicsList:(FIRMessagingPendingTopicsList *)topicsList {
   NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
-  NSData *pendingData = [NSKeyedArchiver archivedDataWithRootObject:topicsList];
+  NSData *pendingData;
+  // The list's batches are mutated while synchronized on the list
+  @synchronized (topicsList) {
+    pendingData = [NSKeyedArchiver archivedDataWithRootObject:topicsList];
+  }
   [defaults setObject:pendingData forKey:kPendingSubscriptionsListKey];
   [defaults synchronize];
 }
@@ -179,6 +179,13 @@ extern NSString *const kTableS2DRmqIds;
  */
 - (FIRMessagingPersistentSyncMessage *)querySyncMessageWithRmqID:(NSString *)rmqID;
 
+/**
+ *  Query the rmqIDs of all the sync messages in the sync message table.
+ *
+ *  @return The rmqIDs of the persisted sync messages, in no particular order.
+ */
+- (NSArray<NSString *> *)querySyncMessageRmqIDs;
+
 /**
  *  Delete sync message with rmqID.
  *
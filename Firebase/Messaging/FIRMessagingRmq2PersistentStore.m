@@ -35,6 +35,16 @@ return return_value; \
 } while(0)
 #endif
 
+// Like _FIRMessagingRmqLogAndExit, for statements from the statement cache, which must be reset
+// rather than finalized.
+#ifndef _FIRMessagingRmqLogResetAndExit
+#define _FIRMessagingRmqLogResetAndExit(stmt, return_value)   \
+do {                              \
+[self logErrorAndResetStatement:stmt];  \
+return return_value; \
+} while(0)
+#endif
+
 typedef enum : NSUInteger {
   FIRMessagingRmqDirectoryUnknown,
   FIRMessagingRmqDirectoryDocuments,
@@ -81,6 +91,10 @@ static NSString *const kCreateTableSyncMessages =
     @"apns_recv INTEGER, "
     @"mcs_recv INTEGER)";
 
+// Sync messages are looked up by rmq_id for every incoming message
+static NSString *const kCreateIndexSyncMessagesRmqId =
+    @"create INDEX IF NOT EXISTS %@%@_rmq_id ON %@%@ (rmq_id)";
+
 static NSString *const kDropTableCommand =
     @"drop TABLE if exists %@%@";
 
@@ -114,6 +128,9 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
 
 @interface FIRMessagingRmq2PersistentStore () {
   sqlite3 *_database;
+  // Prepared statements for the store's fixed set of queries, keyed by their SQL. Each one is
+  // reset after use so it can be bound and stepped again.
+  NSMutableDictionary<NSString *, NSValue *> *_cachedStatements;
 }
 
 @property(nonatomic, readwrite, strong) NSString *databaseName;
@@ -127,19 +144,19 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
   self = [super init];
   if (self) {
     _databaseName = [databaseName copy];
+    _cachedStatements = [NSMutableDictionary dictionary];
     BOOL didMoveToApplicationSupport =
         [self moveToApplicationSupportSubDirectory:kFIRMessagingApplicationSupportSubDirectory];
 
     _currentDirectory = didMoveToApplicationSupport
                             ? FIRMessagingRmqDirectoryApplicationSupport
                             : FIRMessagingRmqDirectoryDocuments;
-
-    [self openDatabase:_databaseName];
   }
   return self;
 }
 
 - (void)dealloc {
+  [self finalizeCachedStatements];
   sqlite3_close(_database);
 }
 
@@ -183,6 +200,15 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
                               oldPlistPath, newPlistPath, moveError);
       return NO;
     }
+    // A write-ahead log left behind by a crash holds commits the database doesn't have yet
+    for (NSString *suffix in @[ @"-wal", @"-shm" ]) {
+      NSString *oldLogPath = [oldPlistPath stringByAppendingString:suffix];
+      if ([[NSFileManager defaultManager] fileExistsAtPath:oldLogPath]) {
+        [[NSFileManager defaultManager] moveItemAtPath:oldLogPath
+                                                toPath:[newPlistPath stringByAppendingString:suffix]
+                                                 error:nil];
+      }
+    }
   }
   // We moved the file if it existed, otherwise we didn't need to do anything
   return YES;
@@ -256,7 +282,7 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
 - (void)removeDatabase {
   NSString *path = [[self class] pathForDatabase:self.databaseName
                                      inDirectory:self.currentDirectory];
-  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+  [[self class] removeDatabaseFilesAtPath:path];
 }
 
 + (void)removeDatabase:(NSString *)dbName {
@@ -264,8 +290,16 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
                                          inDirectory:FIRMessagingRmqDirectoryDocuments];
   NSString *applicationSupportDirPath =
       [self pathForDatabase:dbName inDirectory:FIRMessagingRmqDirectoryApplicationSupport];
-  [[NSFileManager defaultManager] removeItemAtPath:documentsDirPath error:nil];
-  [[NSFileManager defaultManager] removeItemAtPath:applicationSupportDirPath error:nil];
+  [self removeDatabaseFilesAtPath:documentsDirPath];
+  [self removeDatabaseFilesAtPath:applicationSupportDirPath];
+}
+
+// Also removes the write-ahead log and its index, which live next to the database in WAL mode.
++ (void)removeDatabaseFilesAtPath:(NSString *)path {
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  [fileManager removeItemAtPath:path error:nil];
+  [fileManager removeItemAtPath:[path stringByAppendingString:@"-wal"] error:nil];
+  [fileManager removeItemAtPath:[path stringByAppendingString:@"-shm"] error:nil];
 }
 
 - (void)openDatabase:(NSString *)dbName {
@@ -314,8 +348,46 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
   }
 
   if (didOpenDatabase) {
+    [self configureDatabase];
     [self createTableWithName:kTableSyncMessages command:kCreateTableSyncMessages];
+    [self createSyncMessagesIndex];
+  }
+}
+
+- (void)createSyncMessagesIndex {
+  char *error;
+  NSString *createIndex = [NSString stringWithFormat:kCreateIndexSyncMessagesRmqId,
+                           kTablePrefix, kTableSyncMessages, kTablePrefix, kTableSyncMessages];
+  // Lookups still work without the index, so failing to create it isn't fatal
+  if (sqlite3_exec(_database, [createIndex UTF8String], NULL, NULL, &error) != SQLITE_OK) {
+    FIRMessagingLoggerError(kFIRMessagingMessageCodeRmq2PersistentStoreErrorCreatingTable,
+                            @"%@ Couldn't create index on %@: %s", kFCMRmqStoreTag,
+                            kTableSyncMessages, error);
+    sqlite3_free(error);
+  }
+}
+
+// Write-ahead logging lets a save append to the log instead of rewriting the database and its
+// rollback journal, and with synchronous=NORMAL the log is only synced at checkpoints. A commit
+// can then be lost on power failure, but not when the app crashes or is killed.
+- (void)configureDatabase {
+  char *error;
+  for (NSString *pragma in @[ @"PRAGMA journal_mode=WAL", @"PRAGMA synchronous=NORMAL" ]) {
+    if (sqlite3_exec(_database, [pragma UTF8String], NULL, NULL, &error) != SQLITE_OK) {
+      FIRMessagingLoggerError(kFIRMessagingMessageCodeRmq2PersistentStoreErrorConfiguringDatabase,
+                              @"%@ Couldn't run %@: %s", kFCMRmqStoreTag, pragma, error);
+      sqlite3_free(error);
+    }
+  }
+}
+
+// Opening the database creates or migrates its tables, so it is deferred from app launch, when
+// FIRMessaging starts, to the first query.
+- (sqlite3 *)database {
+  if (!_database) {
+    [self openDatabase:self.databaseName];
   }
+  return _database;
 }
 
 - (void)updateDbWithStringRmqID {
@@ -330,22 +402,21 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
   NSString *insertSQL = [NSString stringWithFormat:insertFormat,
                          kTableS2DRmqIds,
                          kRmqIdColumn];
-  sqlite3_stmt *insert_statement;
-  if (sqlite3_prepare_v2(_database, [insertSQL UTF8String], -1, &insert_statement, NULL)
-      != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(insert_statement, NO);
+  sqlite3_stmt *insert_statement = [self cachedStatementForSQL:insertSQL];
+  if (insert_statement == NULL) {
+    _FIRMessagingRmqLogResetAndExit(insert_statement, NO);
   }
   if (sqlite3_bind_text(insert_statement,
                         1,
                         [rmqId UTF8String],
                         (int)[rmqId length],
                         SQLITE_STATIC) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(insert_statement, NO);
+    _FIRMessagingRmqLogResetAndExit(insert_statement, NO);
   }
   if (sqlite3_step(insert_statement) != SQLITE_DONE) {
-    _FIRMessagingRmqLogAndExit(insert_statement, NO);
+    _FIRMessagingRmqLogResetAndExit(insert_statement, NO);
   }
-  sqlite3_finalize(insert_statement);
+  [self resetCachedStatement:insert_statement];
   return YES;
 }
 
@@ -357,30 +428,29 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
   NSString *insertSQL = [NSString stringWithFormat:insertFormat,
                          kTableOutgoingRmqMessages, // table
                          kRmqIdColumn, kProtobufTagColumn, kDataColumn /* columns */];
-  sqlite3_stmt *insert_statement;
-  if (sqlite3_prepare_v2(_database, [insertSQL UTF8String], -1, &insert_statement, NULL)
-      != SQLITE_OK) {
+  sqlite3_stmt *insert_statement = [self cachedStatementForSQL:insertSQL];
+  if (insert_statement == NULL) {
     if (error) {
       *error = [NSError errorWithDomain:[NSString stringWithFormat:@"%s", sqlite3_errmsg(_database)]
                                    code:sqlite3_errcode(_database)
                                userInfo:nil];
     }
-    _FIRMessagingRmqLogAndExit(insert_statement, NO);
+    _FIRMessagingRmqLogResetAndExit(insert_statement, NO);
   }
   if (sqlite3_bind_int64(insert_statement, 1, rmqId) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(insert_statement, NO);
+    _FIRMessagingRmqLogResetAndExit(insert_statement, NO);
   }
   if (sqlite3_bind_int(insert_statement, 2, tag) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(insert_statement, NO);
+    _FIRMessagingRmqLogResetAndExit(insert_statement, NO);
   }
   if (sqlite3_bind_blob(insert_statement, 3, [data bytes], (int)[data length], NULL) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(insert_statement, NO);
+    _FIRMessagingRmqLogResetAndExit(insert_statement, NO);
   }
   if (sqlite3_step(insert_statement) != SQLITE_DONE) {
-    _FIRMessagingRmqLogAndExit(insert_statement, NO);
+    _FIRMessagingRmqLogResetAndExit(insert_statement, NO);
   }
 
-  sqlite3_finalize(insert_statement);
+  [self resetCachedStatement:insert_statement];
   return YES;
 }
 
@@ -399,75 +469,64 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
     isRmqIDString = YES;
   }
 
-  NSMutableString *delete = [NSMutableString stringWithFormat:@"DELETE FROM %@ WHERE ", tableName];
-
-  NSString *toDeleteArgument = [NSString stringWithFormat:@"%@ = ? OR ", kRmqIdColumn];
-
   int toDelete = (int)[rmqIds count];
   if (toDelete == 0) {
     return 0;
   }
-  int maxBatchSize = 100;
-  int start = 0;
-  int deleteCount = 0;
-  while (start < toDelete) {
-
-    // construct the WHERE argument
-    int end = MIN(start + maxBatchSize, toDelete);
-    NSMutableString *whereArgument = [NSMutableString string];
-    for (int i = start; i < end; i++) {
-      [whereArgument appendString:toDeleteArgument];
-    }
-    // remove the last * OR * from argument
-    NSRange range = NSMakeRange([whereArgument length] -4, 4);
-    [whereArgument deleteCharactersInRange:range];
-    NSString *deleteQuery = [NSString stringWithFormat:@"%@ %@", delete, whereArgument];
-
-
-    // sqlite update
-    sqlite3_stmt *delete_statement;
-    if (sqlite3_prepare_v2(_database, [deleteQuery UTF8String],
-                           -1, &delete_statement, NULL) != SQLITE_OK) {
-      _FIRMessagingRmqLogAndExit(delete_statement, 0);
+  // Well below SQLite's default limit of 999 variables per statement
+  const int maxBatchSize = 500;
+  // Every batch runs the same cached statement: a lone ID uses "= ?", anything more fills in all
+  // the slots of the IN list, repeating the batch's last ID in the slots it doesn't need.
+  int batchSize = toDelete == 1 ? 1 : maxBatchSize;
+  NSString *deleteQuery;
+  if (batchSize == 1) {
+    deleteQuery =
+        [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ = ?", tableName, kRmqIdColumn];
+  } else {
+    NSMutableString *placeholders = [NSMutableString stringWithString:@"?"];
+    for (int i = 1; i < batchSize; i++) {
+      [placeholders appendString:@", ?"];
     }
+    deleteQuery = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ IN (%@)",
+                                             tableName, kRmqIdColumn, placeholders];
+  }
+  sqlite3_stmt *delete_statement = [self cachedStatementForSQL:deleteQuery];
+  if (delete_statement == NULL) {
+    _FIRMessagingRmqLogResetAndExit(delete_statement, 0);
+  }
 
-    // bind values
-    int rmqIndex = 0;
-    int placeholderIndex = 1; // placeholders in sqlite3 start with 1
-    for (NSString *rmqId in rmqIds) { // objectAtIndex: is O(n) -- would make it slow
-      if (rmqIndex < start) {
-        rmqIndex++;
-        continue;
-      } else if (rmqIndex >= end) {
-        break;
+  int deleteCount = 0;
+  // Commit all the batches at once rather than syncing the database after each of them
+  BOOL inTransaction = toDelete > batchSize && [self beginTransaction];
+  for (int start = 0; start < toDelete; start += batchSize) {
+    int end = MIN(start + batchSize, toDelete);
+    for (int placeholder = 0; placeholder < batchSize; placeholder++) {
+      NSString *rmqId = rmqIds[MIN(start + placeholder, end - 1)];
+      // placeholders in sqlite3 start with 1
+      int result;
+      if (isRmqIDString) {
+        result = sqlite3_bind_text(delete_statement, placeholder + 1, [rmqId UTF8String], -1,
+                                   SQLITE_TRANSIENT);
       } else {
-        if (isRmqIDString) {
-          if (sqlite3_bind_text(delete_statement,
-                                placeholderIndex,
-                                [rmqId UTF8String],
-                                (int)[rmqId length],
-                                SQLITE_STATIC) != SQLITE_OK) {
-            FIRMessagingLoggerDebug(kFIRMessagingMessageCodeRmq2PersistentStore003,
-                                    @"Failed to bind rmqID %@", rmqId);
-            continue;
-          }
-        } else {
-          int64_t rmqIdValue = [rmqId longLongValue];
-          sqlite3_bind_int64(delete_statement, placeholderIndex, rmqIdValue);
-        }
-        placeholderIndex++;
+        result = sqlite3_bind_int64(delete_statement, placeholder + 1, [rmqId longLongValue]);
+      }
+      if (result != SQLITE_OK) {
+        FIRMessagingLoggerDebug(kFIRMessagingMessageCodeRmq2PersistentStore003,
+                                @"Failed to bind rmqID %@", rmqId);
       }
-      rmqIndex++;
     }
     if (sqlite3_step(delete_statement) != SQLITE_DONE) {
-      _FIRMessagingRmqLogAndExit(delete_statement, deleteCount);
+      [self logErrorAndResetStatement:delete_statement];
+      break;
     }
-    sqlite3_finalize(delete_statement);
     deleteCount += sqlite3_changes(_database);
-    start = end;
+    [self resetCachedStatement:delete_statement];
+  }
+  if (inTransaction) {
+    [self commitTransaction];
   }
 
-  // if we are here all of our sqlite queries should have succeeded
+  // deleteCount only covers the batches that succeeded
   FIRMessagingLoggerDebug(kFIRMessagingMessageCodeRmq2PersistentStore004,
                           @"%@ Trying to delete %d s2D ID's, successfully deleted %d",
                           kFCMRmqStoreTag, toDelete, deleteCount);
@@ -484,15 +543,15 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
                      kRmqIdColumn, // order by column
                      1]; // limit
 
-  sqlite3_stmt *statement;
+  sqlite3_stmt *statement = [self cachedStatementForSQL:query];
   int64_t highestRmqId = 0;
-  if (sqlite3_prepare_v2(_database, [query UTF8String], -1, &statement, NULL) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(statement, highestRmqId);
+  if (statement == NULL) {
+    _FIRMessagingRmqLogResetAndExit(statement, highestRmqId);
   }
   if (sqlite3_step(statement) == SQLITE_ROW) {
     highestRmqId = sqlite3_column_int64(statement, 0);
   }
-  sqlite3_finalize(statement);
+  [self resetCachedStatement:statement];
   return highestRmqId;
 }
 
@@ -504,15 +563,15 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
                      kRmqIdColumn, // order by column
                      1]; // limit
 
-  sqlite3_stmt *statement;
+  sqlite3_stmt *statement = [self cachedStatementForSQL:query];
   int64_t lastRmqId = 0;
-  if (sqlite3_prepare_v2(_database, [query UTF8String], -1, &statement, NULL) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(statement, lastRmqId);
+  if (statement == NULL) {
+    _FIRMessagingRmqLogResetAndExit(statement, lastRmqId);
   }
   if (sqlite3_step(statement) == SQLITE_ROW) {
     lastRmqId = sqlite3_column_int64(statement, 0);
   }
-  sqlite3_finalize(statement);
+  [self resetCachedStatement:statement];
   return lastRmqId;
 }
 
@@ -521,20 +580,20 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
   NSString *query = [NSString stringWithFormat:queryFormat,
                      kTableLastRmqId, // table
                      kIdColumn, kRmqIdColumn]; // columns
-  sqlite3_stmt *statement;
-  if (sqlite3_prepare_v2(_database, [query UTF8String], -1, &statement, NULL) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(statement, NO);
+  sqlite3_stmt *statement = [self cachedStatementForSQL:query];
+  if (statement == NULL) {
+    _FIRMessagingRmqLogResetAndExit(statement, NO);
   }
   if (sqlite3_bind_int(statement, 1, 1) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(statement, NO);
+    _FIRMessagingRmqLogResetAndExit(statement, NO);
   }
   if (sqlite3_bind_int64(statement, 2, rmqID) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(statement, NO);
+    _FIRMessagingRmqLogResetAndExit(statement, NO);
   }
   if (sqlite3_step(statement) != SQLITE_DONE) {
-    _FIRMessagingRmqLogAndExit(statement, NO);
+    _FIRMessagingRmqLogResetAndExit(statement, NO);
   }
-  sqlite3_finalize(statement);
+  [self resetCachedStatement:statement];
   return YES;
 }
 
@@ -544,18 +603,18 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
                      kRmqIdColumn,
                      kTableS2DRmqIds,
                      kRmqIdColumn];
-  sqlite3_stmt *statement;
-  if (sqlite3_prepare_v2(_database, [query UTF8String], -1, &statement, NULL) != SQLITE_OK) {
+  sqlite3_stmt *statement = [self cachedStatementForSQL:query];
+  if (statement == NULL) {
     FIRMessagingLoggerDebug(kFIRMessagingMessageCodeRmq2PersistentStore005,
                             @"%@: Could not find s2d ids", kFCMRmqStoreTag);
-    _FIRMessagingRmqLogAndExit(statement, @[]);
+    _FIRMessagingRmqLogResetAndExit(statement, @[]);
   }
   NSMutableArray *rmqIDArray = [NSMutableArray array];
   while (sqlite3_step(statement) == SQLITE_ROW) {
     const char *rmqID = (char *)sqlite3_column_text(statement, 0);
     [rmqIDArray addObject:[NSString stringWithUTF8String:rmqID]];
   }
-  sqlite3_finalize(statement);
+  [self resetCachedStatement:statement];
   return rmqIDArray;
 }
 
@@ -568,8 +627,9 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
                      kTableOutgoingRmqMessages, // from table
                      kRmqIdColumn, // where
                      kRmqIdColumn]; // order by
+  // Not cached, since the handler could scan again before this scan is done with the statement
   sqlite3_stmt *statement;
-  if (sqlite3_prepare_v2(_database, [query UTF8String], -1, &statement, NULL) != SQLITE_OK) {
+  if (sqlite3_prepare_v2([self database], [query UTF8String], -1, &statement, NULL) != SQLITE_OK) {
     [self logError];
     sqlite3_finalize(statement);
     return;
@@ -597,19 +657,20 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
 - (FIRMessagingPersistentSyncMessage *)querySyncMessageWithRmqID:(NSString *)rmqID {
   _FIRMessagingDevAssert([rmqID length], @"Invalid rmqID key %@ to search in SYNC_RMQ", rmqID);
 
-  NSString *queryFormat = @"SELECT %@ FROM %@ WHERE %@ = '%@'";
+  NSString *queryFormat = @"SELECT %@ FROM %@ WHERE %@ = ?";
   NSString *query = [NSString stringWithFormat:queryFormat,
                      kSyncMessagesColumns, // SELECT (rmq_id, expiration_ts, apns_recv, mcs_recv)
                      kTableSyncMessages,   // FROM sync_rmq
-                     kRmqIdColumn,         // WHERE rmq_id
-                     rmqID];
+                     kRmqIdColumn];        // WHERE rmq_id
 
-  sqlite3_stmt *stmt;
-  if (sqlite3_prepare_v2(_database, [query UTF8String], -1, &stmt, NULL) != SQLITE_OK) {
+  sqlite3_stmt *stmt = [self cachedStatementForSQL:query];
+  if (stmt == NULL) {
     [self logError];
-    sqlite3_finalize(stmt);
     return nil;
   }
+  if (sqlite3_bind_text(stmt, 1, [rmqID UTF8String], -1, SQLITE_TRANSIENT) != SQLITE_OK) {
+    _FIRMessagingRmqLogResetAndExit(stmt, nil);
+  }
 
   const int rmqIDColumn = 0;
   const int expirationTimestampColumn = 1;
@@ -634,12 +695,31 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
 
     count++;
   }
-  sqlite3_finalize(stmt);
+  [self resetCachedStatement:stmt];
 
   _FIRMessagingDevAssert(count <= 1, @"Found multiple messages in %@ with same RMQ ID", kTableSyncMessages);
   return persistentMessage;
 }
 
+- (NSArray<NSString *> *)querySyncMessageRmqIDs {
+  NSString *query = [NSString stringWithFormat:@"SELECT %@ FROM %@", kRmqIdColumn,
+                                               kTableSyncMessages];
+  sqlite3_stmt *stmt = [self cachedStatementForSQL:query];
+  if (stmt == NULL) {
+    [self logError];
+    return @[];
+  }
+  NSMutableArray<NSString *> *rmqIDs = [NSMutableArray array];
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    const char *rmqID = (const char *)sqlite3_column_text(stmt, 0);
+    if (rmqID != NULL) {
+      [rmqIDs addObject:[NSString stringWithUTF8String:rmqID]];
+    }
+  }
+  [self resetCachedStatement:stmt];
+  return rmqIDs;
+}
+
 - (BOOL)deleteSyncMessageWithRmqID:(NSString *)rmqID {
   _FIRMessagingDevAssert([rmqID length], @"Invalid rmqID key %@ to delete in SYNC_RMQ", rmqID);
   return [self deleteMessagesFromTable:kTableSyncMessages withRmqIds:@[rmqID]] > 0;
@@ -648,24 +728,23 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
 - (int)deleteExpiredOrFinishedSyncMessages:(NSError *__autoreleasing *)error {
   int64_t now = FIRMessagingCurrentTimestampInSeconds();
   NSString *deleteSQL = @"DELETE FROM %@ "
-                        @"WHERE %@ < %lld OR "  // expirationTime < now
+                        @"WHERE %@ < ? OR "  // expirationTime < now
                         @"(%@ = 1 AND %@ = 1)";  // apns_received = 1 AND mcs_received = 1
   NSString *query = [NSString stringWithFormat:deleteSQL,
                      kTableSyncMessages,
                      kSyncMessageExpirationTimestampColumn,
-                     now,
                      kSyncMessageAPNSReceivedColumn,
                      kSyncMessageMCSReceivedColumn];
 
   NSString *errorReason = @"Failed to save delete expired sync messages from store.";
 
-  sqlite3_stmt *stmt;
-  if (sqlite3_prepare_v2(_database, [query UTF8String], -1, &stmt, NULL) != SQLITE_OK) {
+  sqlite3_stmt *stmt = [self cachedStatementForSQL:query];
+  if (stmt == NULL || sqlite3_bind_int64(stmt, 1, now) != SQLITE_OK) {
     if (error) {
       *error = [NSError fcm_errorWithCode:sqlite3_errcode(_database)
                                  userInfo:@{ @"error" : errorReason }];
     }
-    _FIRMessagingRmqLogAndExit(stmt, 0);
+    _FIRMessagingRmqLogResetAndExit(stmt, 0);
   }
 
   if (sqlite3_step(stmt) != SQLITE_DONE) {
@@ -673,10 +752,10 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
       *error = [NSError fcm_errorWithCode:sqlite3_errcode(_database)
                                  userInfo:@{ @"error" : errorReason }];
     }
-    _FIRMessagingRmqLogAndExit(stmt, 0);
+    _FIRMessagingRmqLogResetAndExit(stmt, 0);
   }
 
-  sqlite3_finalize(stmt);
+  [self resetCachedStatement:stmt];
   int deleteCount = sqlite3_changes(_database);
   return deleteCount;
 }
@@ -696,37 +775,37 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
                          kSyncMessageAPNSReceivedColumn, // apns_recv
                          kSyncMessageMCSReceivedColumn /* mcs_recv */];
 
-  sqlite3_stmt *stmt;
+  sqlite3_stmt *stmt = [self cachedStatementForSQL:insertSQL];
 
-  if (sqlite3_prepare_v2(_database, [insertSQL UTF8String], -1, &stmt, NULL) != SQLITE_OK) {
+  if (stmt == NULL) {
     if (error) {
       *error = [NSError fcm_errorWithCode:sqlite3_errcode(_database)
                                  userInfo:@{ @"error" : @"Failed to save sync message to store." }];
     }
-    _FIRMessagingRmqLogAndExit(stmt, NO);
+    _FIRMessagingRmqLogResetAndExit(stmt, NO);
   }
 
   if (sqlite3_bind_text(stmt, 1, [rmqID UTF8String], (int)[rmqID length], NULL) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(stmt, NO);
+    _FIRMessagingRmqLogResetAndExit(stmt, NO);
   }
 
   if (sqlite3_bind_int64(stmt, 2, expirationTime) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(stmt, NO);
+    _FIRMessagingRmqLogResetAndExit(stmt, NO);
   }
 
   if (sqlite3_bind_int(stmt, 3, apnsReceived ? 1 : 0) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(stmt, NO);
+    _FIRMessagingRmqLogResetAndExit(stmt, NO);
   }
 
   if (sqlite3_bind_int(stmt, 4, mcsReceived ? 1 : 0) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(stmt, NO);
+    _FIRMessagingRmqLogResetAndExit(stmt, NO);
   }
 
   if (sqlite3_step(stmt) != SQLITE_DONE) {
-    _FIRMessagingRmqLogAndExit(stmt, NO);
+    _FIRMessagingRmqLogResetAndExit(stmt, NO);
   }
 
-  sqlite3_finalize(stmt);
+  [self resetCachedStatement:stmt];
   return YES;
 }
 
@@ -761,25 +840,25 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
                      column,
                      value ? 1 : 0,
                      kRmqIdColumn];
-  sqlite3_stmt *stmt;
+  sqlite3_stmt *stmt = [self cachedStatementForSQL:query];
 
-  if (sqlite3_prepare_v2(_database, [query UTF8String], -1, &stmt, NULL) != SQLITE_OK) {
+  if (stmt == NULL) {
     if (error) {
       *error = [NSError fcm_errorWithCode:sqlite3_errcode(_database)
                                  userInfo:@{ @"error" : @"Failed to update sync message"}];
     }
-    _FIRMessagingRmqLogAndExit(stmt, NO);
+    _FIRMessagingRmqLogResetAndExit(stmt, NO);
   }
 
   if (sqlite3_bind_text(stmt, 1, [rmqID UTF8String], (int)[rmqID length], NULL) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(stmt, NO);
+    _FIRMessagingRmqLogResetAndExit(stmt, NO);
   }
 
   if (sqlite3_step(stmt) != SQLITE_DONE) {
-    _FIRMessagingRmqLogAndExit(stmt, NO);
+    _FIRMessagingRmqLogResetAndExit(stmt, NO);
   }
 
-  sqlite3_finalize(stmt);
+  [self resetCachedStatement:stmt];
   return YES;
 
 }
@@ -805,4 +884,61 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
   sqlite3_finalize(stmt);
 }
 
+- (void)logErrorAndResetStatement:(sqlite3_stmt *)stmt {
+  [self logError];
+  [self resetCachedStatement:stmt];
+}
+
+#pragma mark - Statement cache
+
+- (sqlite3_stmt *)cachedStatementForSQL:(NSString *)sql {
+  sqlite3_stmt *statement = [_cachedStatements[sql] pointerValue];
+  if (statement == NULL) {
+    if (sqlite3_prepare_v2([self database], [sql UTF8String], -1, &statement, NULL) != SQLITE_OK) {
+      sqlite3_finalize(statement);
+      return NULL;
+    }
+    _cachedStatements[sql] = [NSValue valueWithPointer:statement];
+  }
+  return statement;
+}
+
+// Resets the statement so that it can run again, and drops its bindings, which can point at
+// buffers that are only valid while the statement runs.
+- (void)resetCachedStatement:(sqlite3_stmt *)stmt {
+  if (stmt != NULL) {
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+  }
+}
+
+- (void)finalizeCachedStatements {
+  for (NSValue *statement in [_cachedStatements allValues]) {
+    sqlite3_finalize([statement pointerValue]);
+  }
+  [_cachedStatements removeAllObjects];
+}
+
+#pragma mark - Transactions
+
+- (BOOL)beginTransaction {
+  char *error;
+  if (sqlite3_exec([self database], "BEGIN TRANSACTION", NULL, NULL, &error) != SQLITE_OK) {
+    FIRMessagingLoggerDebug(kFIRMessagingMessageCodeRmq2PersistentStore006,
+                            @"%@ Couldn't begin transaction: %s", kFCMRmqStoreTag, error);
+    sqlite3_free(error);
+    return NO;
+  }
+  return YES;
+}
+
+- (void)commitTransaction {
+  char *error;
+  if (sqlite3_exec([self database], "COMMIT TRANSACTION", NULL, NULL, &error) != SQLITE_OK) {
+    FIRMessagingLoggerError(kFIRMessagingMessageCodeRmq2PersistentStore006,
+                            @"%@ Couldn't commit transaction: %s", kFCMRmqStoreTag, error);
+    sqlite3_free(error);
+  }
+}
+
 @end
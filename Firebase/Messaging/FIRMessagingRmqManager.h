@@ -61,6 +61,10 @@ typedef void(^FIRMessagingDataMessageHandler)(int64_t rmqId, GtalkDataMessageSta
 // designated initializer
 - (instancetype)initWithDatabaseName:(NSString *)databaseName;
 
+/**
+ *  Load the next RMQ ID from the store. This is done on first use, so calling it up front is only
+ *  needed to pay for the database queries at a time of the caller's choosing.
+ */
 - (void)loadRmqId;
 
 /**
@@ -21,6 +21,8 @@
 
 #import "FIRMessagingDefines.h"
 #import "FIRMessagingLogger.h"
+#import "FIRMessagingMetrics.h"
+#import "FIRMessagingPersistentSyncMessage.h"
 #import "FIRMessagingRmq2PersistentStore.h"
 #import "FIRMessagingUtilities.h"
 
@@ -34,6 +36,30 @@ do {                              \
 
 static NSString *const kFCMRmqTag = @"FIRMessagingRmq:";
 
+// The cache of recently used sync messages is emptied when it grows past this
+static const NSUInteger kMaxCachedSyncMessages = 100;
+// 64k bits with 4 hashes stay under a 1% false positive rate for the first few thousand rmqIDs
+static const NSUInteger kSyncMessageFilterBits = 64 * 1024;
+static const NSUInteger kSyncMessageFilterHashes = 4;
+// The filter is rebuilt from the store once this many rmqIDs have been added to it since it was
+// last built
+static const NSUInteger kSyncMessageFilterCapacity = 4096;
+
+// 64-bit FNV-1a hash of the rmqID's UTF-8 bytes
+static uint64_t SyncMessageFilterHash(NSString *rmqID) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (const char *byte = [rmqID UTF8String]; byte && *byte; byte++) {
+    hash ^= (uint8_t)*byte;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// The filter's bit indexes for a hash are derived from its two halves
+static NSUInteger SyncMessageFilterIndex(uint64_t hash, NSUInteger i) {
+  return ((uint32_t)hash + i * (uint32_t)(hash >> 32)) % kSyncMessageFilterBits;
+}
+
 @interface FIRMessagingRmqManager ()
 
 @property(nonatomic, readwrite, strong) FIRMessagingRmq2PersistentStore *rmq2Store;
@@ -44,6 +70,14 @@ static NSString *const kFCMRmqTag = @"FIRMessagingRmq:";
 // Outgoing RMQ persistent id
 @property(nonatomic, readwrite, assign) int64_t rmqId;
 
+// Sync messages recently saved or looked up, keyed by rmqID. The sync message methods keep these
+// in step with the store.
+@property(nonatomic, readwrite, strong) NSMutableDictionary *syncMessageCache;
+// A bloom filter over the rmqIDs of the sync messages in the store, so that lookups for messages
+// the store has never seen don't have to query it. Built on first use.
+@property(nonatomic, readwrite, strong) NSMutableData *syncMessageFilter;
+@property(nonatomic, readwrite, assign) NSUInteger syncMessageFilterCount;
+
 @end
 
 @implementation FIRMessagingRmqManager
@@ -54,6 +88,7 @@ static NSString *const kFCMRmqTag = @"FIRMessagingRmq:";
     _FIRMessagingDevAssert([databaseName length] > 0, @"RMQ: Invalid rmq db name");
     _rmq2Store = [[FIRMessagingRmq2PersistentStore alloc] initWithDatabaseName:databaseName];
     _outstandingMessages = [NSMutableDictionary dictionaryWithCapacity:2];
+    _syncMessageCache = [NSMutableDictionary dictionary];
     _rmqId = -1;
   }
   return self;
@@ -120,7 +155,10 @@ static NSString *const kFCMRmqTag = @"FIRMessagingRmq:";
                 tag:(int8_t)tag
               error:(NSError **)error {
   NSData *data = [message data];
-  return [self.rmq2Store saveMessageWithRmqId:rmqId tag:tag data:data error:error];
+  CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+  BOOL saved = [self.rmq2Store saveMessageWithRmqId:rmqId tag:tag data:data error:error];
+  [self recordStoreOperationSince:startTime];
+  return saved;
 }
 
 /**
@@ -131,7 +169,10 @@ static NSString *const kFCMRmqTag = @"FIRMessagingRmq:";
 }
 
 - (BOOL)saveS2dMessageWithRmqId:(NSString *)rmqID {
-  return [self.rmq2Store saveUnackedS2dMessageWithRmqId:rmqID];
+  CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+  BOOL saved = [self.rmq2Store saveUnackedS2dMessageWithRmqId:rmqID];
+  [self recordStoreOperationSince:startTime];
+  return saved;
 }
 
 #pragma mark - Query
@@ -203,30 +244,54 @@ static NSString *const kFCMRmqTag = @"FIRMessagingRmq:";
     }
   }
   maxRmqId++;
+  [self loadRmqId];
   if (maxRmqId >= self.rmqId) {
     [self saveLastOutgoingRmqId:maxRmqId];
   }
-  return [self.rmq2Store deleteMessagesFromTable:kTableOutgoingRmqMessages withRmqIds:rmqIds];
+  CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+  int deleteCount = [self.rmq2Store deleteMessagesFromTable:kTableOutgoingRmqMessages
+                                                 withRmqIds:rmqIds];
+  [self recordStoreOperationSince:startTime];
+  return deleteCount;
 }
 
 - (void)removeS2dIds:(NSArray *)s2dIds {
+  CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
   [self.rmq2Store deleteMessagesFromTable:kTableS2DRmqIds withRmqIds:s2dIds];
+  [self recordStoreOperationSince:startTime];
 }
 
 #pragma mark - Sync Messages
 
-// TODO: RMQManager should also have a cache for all the sync messages
-// so we don't hit the DB each time.
 - (FIRMessagingPersistentSyncMessage *)querySyncMessageWithRmqID:(NSString *)rmqID {
-  return [self.rmq2Store querySyncMessageWithRmqID:rmqID];
+  FIRMessagingPersistentSyncMessage *message = self.syncMessageCache[rmqID];
+  if (message) {
+    return message;
+  }
+  if (![self syncMessageFilterMayContainRmqID:rmqID]) {
+    return nil;
+  }
+  CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+  message = [self.rmq2Store querySyncMessageWithRmqID:rmqID];
+  [self recordStoreOperationSince:startTime];
+  if (message) {
+    [self cacheSyncMessage:message];
+  }
+  return message;
 }
 
 - (BOOL)deleteSyncMessageWithRmqID:(NSString *)rmqID {
+  // The rmqID stays in the filter, which only costs a store query if it shows up again
+  [self.syncMessageCache removeObjectForKey:rmqID];
   return [self.rmq2Store deleteSyncMessageWithRmqID:rmqID];
 }
 
 - (int)deleteExpiredOrFinishedSyncMessages:(NSError **)error {
-  return [self.rmq2Store deleteExpiredOrFinishedSyncMessages:error];
+  int deleteCount = [self.rmq2Store deleteExpiredOrFinishedSyncMessages:error];
+  // Rebuild both from the remaining messages when they are next needed
+  [self.syncMessageCache removeAllObjects];
+  self.syncMessageFilter = nil;
+  return deleteCount;
 }
 
 - (BOOL)saveSyncMessageWithRmqID:(NSString *)rmqID
@@ -234,19 +299,95 @@ static NSString *const kFCMRmqTag = @"FIRMessagingRmq:";
                     apnsReceived:(BOOL)apnsReceived
                      mcsReceived:(BOOL)mcsReceived
                            error:(NSError *__autoreleasing *)error {
-  return [self.rmq2Store saveSyncMessageWithRmqID:rmqID
-                                   expirationTime:expirationTime
-                                     apnsReceived:apnsReceived
-                                      mcsReceived:mcsReceived
-                                            error:error];
+  CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+  BOOL saved = [self.rmq2Store saveSyncMessageWithRmqID:rmqID
+                                         expirationTime:expirationTime
+                                           apnsReceived:apnsReceived
+                                            mcsReceived:mcsReceived
+                                                  error:error];
+  [self recordStoreOperationSince:startTime];
+  if (!saved) {
+    return NO;
+  }
+  FIRMessagingPersistentSyncMessage *message =
+      [[FIRMessagingPersistentSyncMessage alloc] initWithRMQID:rmqID expirationTime:expirationTime];
+  message.apnsReceived = apnsReceived;
+  message.mcsReceived = mcsReceived;
+  [self cacheSyncMessage:message];
+  [self addRmqIDToSyncMessageFilter:rmqID];
+  return YES;
 }
 
 - (BOOL)updateSyncMessageViaAPNSWithRmqID:(NSString *)rmqID error:(NSError **)error {
-  return [self.rmq2Store updateSyncMessageViaAPNSWithRmqID:rmqID error:error];
+  if (![self.rmq2Store updateSyncMessageViaAPNSWithRmqID:rmqID error:error]) {
+    return NO;
+  }
+  ((FIRMessagingPersistentSyncMessage *)self.syncMessageCache[rmqID]).apnsReceived = YES;
+  return YES;
 }
 
 - (BOOL)updateSyncMessageViaMCSWithRmqID:(NSString *)rmqID error:(NSError **)error {
-  return [self.rmq2Store updateSyncMessageViaMCSWithRmqID:rmqID error:error];
+  if (![self.rmq2Store updateSyncMessageViaMCSWithRmqID:rmqID error:error]) {
+    return NO;
+  }
+  ((FIRMessagingPersistentSyncMessage *)self.syncMessageCache[rmqID]).mcsReceived = YES;
+  return YES;
+}
+
+- (void)cacheSyncMessage:(FIRMessagingPersistentSyncMessage *)message {
+  if (self.syncMessageCache.count >= kMaxCachedSyncMessages) {
+    [self.syncMessageCache removeAllObjects];
+  }
+  self.syncMessageCache[message.rmqID] = message;
+}
+
+#pragma mark - Metrics
+
+// Only the store operations on the message delivery path are timed
+- (void)recordStoreOperationSince:(CFAbsoluteTime)startTime {
+  [FIRMessagingSharedMetrics() recordDuration:CFAbsoluteTimeGetCurrent() - startTime
+                                    forTiming:kFIRMessagingMetricsRmqStoreOperation];
+}
+
+#pragma mark - Sync Message Filter
+
+- (void)loadSyncMessageFilter {
+  self.syncMessageFilter = [NSMutableData dataWithLength:kSyncMessageFilterBits / 8];
+  self.syncMessageFilterCount = 0;
+  for (NSString *rmqID in [self.rmq2Store querySyncMessageRmqIDs]) {
+    [self addRmqIDToSyncMessageFilter:rmqID];
+  }
+  // Only count the rmqIDs added since the store was read
+  self.syncMessageFilterCount = 0;
+}
+
+- (void)addRmqIDToSyncMessageFilter:(NSString *)rmqID {
+  if (!self.syncMessageFilter) {
+    // The store is read in full when the filter is first used
+    return;
+  }
+  uint64_t hash = SyncMessageFilterHash(rmqID);
+  uint8_t *bits = self.syncMessageFilter.mutableBytes;
+  for (NSUInteger i = 0; i < kSyncMessageFilterHashes; i++) {
+    NSUInteger index = SyncMessageFilterIndex(hash, i);
+    bits[index / 8] |= (uint8_t)(1 << (index % 8));
+  }
+  self.syncMessageFilterCount++;
+}
+
+- (BOOL)syncMessageFilterMayContainRmqID:(NSString *)rmqID {
+  if (!self.syncMessageFilter || self.syncMessageFilterCount > kSyncMessageFilterCapacity) {
+    [self loadSyncMessageFilter];
+  }
+  uint64_t hash = SyncMessageFilterHash(rmqID);
+  const uint8_t *bits = self.syncMessageFilter.bytes;
+  for (NSUInteger i = 0; i < kSyncMessageFilterHashes; i++) {
+    NSUInteger index = SyncMessageFilterIndex(hash, i);
+    if (!(bits[index / 8] & (1 << (index % 8)))) {
+      return NO;
+    }
+  }
+  return YES;
 }
 
 #pragma mark - Testing
@@ -258,6 +399,7 @@ static NSString *const kFCMRmqTag = @"FIRMessagingRmq:";
 #pragma mark - Private
 
 - (int64_t)nextRmqId {
+  [self loadRmqId];
   return ++self.rmqId;
 }
 
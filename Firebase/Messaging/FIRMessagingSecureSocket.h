@@ -29,6 +29,7 @@ typedef NS_ENUM(NSUInteger, FIRMessagingSecureSocketState){
 
 @protocol FIRMessagingSecureSocketDelegate<NSObject>
 
+// |data| points into the socket's input buffer and is only valid for the duration of the call.
 - (void)secureSocket:(FIRMessagingSecureSocket *)socket
       didReceiveData:(NSData *)data
              withTag:(int8_t)tag;
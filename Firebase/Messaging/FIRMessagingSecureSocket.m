@@ -23,12 +23,14 @@
 #import "FIRMessagingCodedInputStream.h"
 #import "FIRMessagingDefines.h"
 #import "FIRMessagingLogger.h"
+#import "FIRMessagingMetrics.h"
 #import "FIRMessagingPacketQueue.h"
 
 static const NSUInteger kMaxBufferLength = 1024 * 1024;  // 1M
 static const NSUInteger kBufferLengthIncrement = 16 * 1024;  // 16k
+// Queued packets are coalesced into one write buffer of up to this size
+static const NSUInteger kMaxCoalescedWriteLength = 16 * 1024;  // 16k
 static const uint8_t kVersion = 40;
-static const uint8_t kInvalidTag = -1;
 
 typedef NS_ENUM(NSUInteger, FIRMessagingSecureSocketReadResult) {
   kFIRMessagingSecureSocketReadResultNone,
@@ -60,10 +62,17 @@ static NSUInteger SerializedSize(int32_t value) {
 @property(nonatomic, readwrite, strong) NSInputStream *inStream;
 @property(nonatomic, readwrite, strong) NSOutputStream *outStream;
 
+// Bytes [inputBufferOffset, inputBufferLength) of the input buffer have been read from the stream
+// but not yet handed to the delegate.
 @property(nonatomic, readwrite, strong) NSMutableData *inputBuffer;
+@property(nonatomic, readwrite, assign) NSUInteger inputBufferOffset;
 @property(nonatomic, readwrite, assign) NSUInteger inputBufferLength;
 @property(nonatomic, readwrite, strong) NSMutableData *outputBuffer;
 @property(nonatomic, readwrite, assign) NSUInteger outputBufferLength;
+// The packets serialized into the output buffer that haven't been fully written yet, along with
+// the offset in the buffer at which each of them ends.
+@property(nonatomic, readwrite, strong) NSMutableArray *packetsBeingSent;
+@property(nonatomic, readwrite, strong) NSMutableArray *packetEndOffsets;
 
 @property(nonatomic, readwrite, strong) FIRMessagingPacketQueue *packetQueue;
 @property(nonatomic, readwrite, assign) BOOL isVersionSent;
@@ -72,8 +81,6 @@ static NSUInteger SerializedSize(int32_t value) {
 @property(nonatomic, readwrite, assign) BOOL isOutStreamOpen;
 
 @property(nonatomic, readwrite, strong) NSRunLoop *runLoop;
-@property(nonatomic, readwrite, strong) NSString *currentRmqIdBeingSent;
-@property(nonatomic, readwrite, assign) int8_t currentProtoTypeBeingSent;
 
 @end
 
@@ -85,7 +92,8 @@ static NSUInteger SerializedSize(int32_t value) {
     _state = kFIRMessagingSecureSocketNotOpen;
     _inputBuffer = [NSMutableData dataWithLength:kBufferLengthIncrement];
     _packetQueue = [[FIRMessagingPacketQueue alloc] init];
-    _currentProtoTypeBeingSent = kInvalidTag;
+    _packetsBeingSent = [NSMutableArray array];
+    _packetEndOffsets = [NSMutableArray array];
   }
   return self;
 }
@@ -164,6 +172,7 @@ static NSUInteger SerializedSize(int32_t value) {
 
 - (void)sendData:(NSData *)data withTag:(int8_t)tag rmqId:(NSString *)rmqId {
   [self.packetQueue push:[FIRMessagingPacket packetWithTag:tag rmqId:rmqId data:data]];
+  [self recordOutgoingQueueDepth];
   if ([self.outStream hasSpaceAvailable]) {
     [self performWrite];
   }
@@ -298,6 +307,12 @@ static NSUInteger SerializedSize(int32_t value) {
       break;
     }
 
+    if (self.inputBufferLength == [self.inputBuffer length]) {
+      if (![self makeRoomInInputBuffer]) {
+        return NO;
+      }
+    }
+
     // try to read more data
     uint8_t *unusedBufferPtr = (uint8_t *)self.inputBuffer.mutableBytes + self.inputBufferLength;
     NSUInteger unusedBufferLength = [self.inputBuffer length] - self.inputBufferLength;
@@ -312,70 +327,90 @@ static NSUInteger SerializedSize(int32_t value) {
     }
     // did successfully read some more data
     self.inputBufferLength += (NSUInteger)bytesRead;
+    [FIRMessagingSharedMetrics() recordBytesReceived:(NSUInteger)bytesRead];
 
-    if ([self.inputBuffer length] <= self.inputBufferLength) {
-      // shouldn't be reading more than 1MB of data in one go
-      if ([self.inputBuffer length] + kBufferLengthIncrement > kMaxBufferLength) {
-        FIRMessagingLoggerDebug(kFIRMessagingMessageCodeSecureSocket013,
-                                @"Input buffer exceed 1M, disconnect socket");
-        return NO;
-      }
-      FIRMessagingLoggerDebug(kFIRMessagingMessageCodeSecureSocket014,
-                              @"Input buffer limit exceeded. Used input buffer size %lu, "
-                              @"Total input buffer size %lu. No unused buffer left. "
-                              @"Increase buffer size.",
-                              _FIRMessaging_UL(self.inputBufferLength),
-                              _FIRMessaging_UL([self.inputBuffer length]));
-      [self.inputBuffer increaseLengthBy:kBufferLengthIncrement];
-      _FIRMessagingDevAssert([self.inputBuffer length] > self.inputBufferLength, @"Invalid buffer size");
+    // Corrupt data encountered, stop processing. Incomplete data is kept in the buffer until more
+    // is loaded from the stream.
+    if ([self processInputBuffer] == kFIRMessagingSecureSocketReadResultCorrupt) {
+      return NO;
     }
+  }
+  return YES;
+}
 
-    while (self.inputBufferLength > 0 && [self.inputBuffer length] > 0) {
-      _FIRMessagingDevAssert([self.inputBuffer length] >= self.inputBufferLength,
-                             @"Buffer longer than length");
-      NSRange inputRange = NSMakeRange(0, self.inputBufferLength);
-      size_t protoBytes = 0;
-      // read the actual proto data coming in
-      FIRMessagingSecureSocketReadResult readResult =
-          [self processCurrentInputBuffer:[self.inputBuffer subdataWithRange:inputRange]
-                                outOffset:&protoBytes];
-      // Corrupt data encountered, stop processing.
-      if (readResult == kFIRMessagingSecureSocketReadResultCorrupt) {
-        return NO;
-        // Incomplete data, keep trying to read by loading more from the stream.
-      } else if (readResult == kFIRMessagingSecureSocketReadResultIncomplete) {
-        break;
-      }
-      _FIRMessagingDevAssert(self.inputBufferLength >= protoBytes, @"More bytes than buffer can handle");
-      // we have read (0, protoBytes) of data in the inputBuffer
-      if (protoBytes == self.inputBufferLength) {
-        // did completely read the buffer data can be reset for further processing
-        self.inputBufferLength = 0;
-      } else {
-        // delete processed bytes while maintaining the buffer size.
-        NSUInteger prevLength __unused = [self.inputBuffer length];
-        // delete the processed bytes
-        [self.inputBuffer replaceBytesInRange:NSMakeRange(0, protoBytes) withBytes:NULL length:0];
-        // reallocate more data
-        [self.inputBuffer increaseLengthBy:protoBytes];
-        _FIRMessagingDevAssert([self.inputBuffer length] == prevLength,
-                               @"Invalid input buffer size %lu. Used bytes length %lu, "
-                               @"buffer content: %@",
-                               _FIRMessaging_UL([self.inputBuffer length]),
-                               _FIRMessaging_UL(self.inputBufferLength),
-                               self.inputBuffer);
-        self.inputBufferLength -= protoBytes;
-      }
-    }
+/**
+ * Frees up space at the end of a full input buffer, either by moving the unprocessed bytes to the
+ * front or, if the whole buffer is unprocessed, by growing it.
+ *
+ * @return NO if the buffer would have to grow past kMaxBufferLength.
+ */
+- (BOOL)makeRoomInInputBuffer {
+  if (self.inputBufferOffset > 0) {
+    // Packets are parsed in place, so the leftover bytes of a partial packet are only moved once
+    // per refill rather than after every packet.
+    NSUInteger unprocessedLength = self.inputBufferLength - self.inputBufferOffset;
+    uint8_t *bytes = (uint8_t *)self.inputBuffer.mutableBytes;
+    memmove(bytes, bytes + self.inputBufferOffset, unprocessedLength);
+    self.inputBufferOffset = 0;
+    self.inputBufferLength = unprocessedLength;
+    return YES;
+  }
+  // shouldn't be reading more than 1MB of data in one go
+  if ([self.inputBuffer length] + kBufferLengthIncrement > kMaxBufferLength) {
+    FIRMessagingLoggerDebug(kFIRMessagingMessageCodeSecureSocket013,
+                            @"Input buffer exceed 1M, disconnect socket");
+    return NO;
   }
+  FIRMessagingLoggerDebug(kFIRMessagingMessageCodeSecureSocket014,
+                          @"Input buffer limit exceeded. Used input buffer size %lu, "
+                          @"Total input buffer size %lu. No unused buffer left. "
+                          @"Increase buffer size.",
+                          _FIRMessaging_UL(self.inputBufferLength),
+                          _FIRMessaging_UL([self.inputBuffer length]));
+  [self.inputBuffer increaseLengthBy:kBufferLengthIncrement];
+  _FIRMessagingDevAssert([self.inputBuffer length] > self.inputBufferLength, @"Invalid buffer size");
   return YES;
 }
 
-- (FIRMessagingSecureSocketReadResult)processCurrentInputBuffer:(NSData *)readData
-                                             outOffset:(size_t *)outOffset {
-  *outOffset = 0;
+/**
+ * Hands every complete packet in the unprocessed part of the input buffer to the delegate. The
+ * packets are parsed in place and passed on without being copied out of the buffer.
+ */
+- (FIRMessagingSecureSocketReadResult)processInputBuffer {
+  _FIRMessagingDevAssert([self.inputBuffer length] >= self.inputBufferLength,
+                         @"Buffer longer than length");
+  const uint8_t *unprocessedBytes =
+      (const uint8_t *)self.inputBuffer.bytes + self.inputBufferOffset;
+  NSUInteger unprocessedLength = self.inputBufferLength - self.inputBufferOffset;
+  NSData *unprocessedData = [NSData dataWithBytesNoCopy:(void *)unprocessedBytes
+                                                 length:unprocessedLength
+                                           freeWhenDone:NO];
+  FIRMessagingCodedInputStream *input =
+      [[FIRMessagingCodedInputStream alloc] initWithData:unprocessedData];
+
+  FIRMessagingSecureSocketReadResult readResult = kFIRMessagingSecureSocketReadResultNone;
+  size_t processedBytes = 0;
+  while (processedBytes < unprocessedLength) {
+    readResult = [self readPacketFromInputStream:input];
+    if (readResult != kFIRMessagingSecureSocketReadResultSuccess) {
+      break;
+    }
+    processedBytes = input.offset;
+  }
+  _FIRMessagingDevAssert(unprocessedLength >= processedBytes, @"More bytes than buffer can handle");
+
+  if (processedBytes == unprocessedLength) {
+    // did completely read the buffer data can be reset for further processing
+    self.inputBufferOffset = 0;
+    self.inputBufferLength = 0;
+  } else {
+    self.inputBufferOffset += processedBytes;
+  }
+  return readResult;
+}
 
-  FIRMessagingCodedInputStream *input = [[FIRMessagingCodedInputStream alloc] initWithData:readData];
+- (FIRMessagingSecureSocketReadResult)readPacketFromInputStream:
+    (FIRMessagingCodedInputStream *)input {
   int8_t rawTag;
   if (![input readTag:&rawTag]) {
     return kFIRMessagingSecureSocketReadResultIncomplete;
@@ -390,15 +425,18 @@ static NSUInteger SerializedSize(int32_t value) {
     FIRMessagingLoggerDebug(kFIRMessagingMessageCodeSecureSocket015, @"Buffer data corrupted.");
     return kFIRMessagingSecureSocketReadResultCorrupt;
   }
-  NSData *data = [input readDataWithLength:(uint32_t)length];
+  NSData *data = [input readDataNoCopyWithLength:(uint32_t)length];
   if (data == nil) {
     FIRMessagingLoggerDebug(kFIRMessagingMessageCodeSecureSocket016,
                             @"Incomplete data, buffered data length %ld, expected length %d",
-                            _FIRMessaging_UL(self.inputBufferLength), length);
+                            _FIRMessaging_UL(self.inputBufferLength - self.inputBufferOffset),
+                            length);
     return kFIRMessagingSecureSocketReadResultIncomplete;
   }
+  CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
   [self.delegate secureSocket:self didReceiveData:data withTag:rawTag];
-  *outOffset = input.offset;
+  [FIRMessagingSharedMetrics() recordDuration:CFAbsoluteTimeGetCurrent() - startTime
+                                    forTiming:kFIRMessagingMetricsPacketProcessing];
   return kFIRMessagingSecureSocketReadResultSuccess;
 }
 
@@ -411,38 +449,76 @@ static NSUInteger SerializedSize(int32_t value) {
     [self.outStream write:&versionByte maxLength:sizeof(uint8_t)];
   }
 
-  while (!self.packetQueue.isEmpty && self.outStream.hasSpaceAvailable) {
+  while ((self.outputBuffer.length > 0 || !self.packetQueue.isEmpty) &&
+         self.outStream.hasSpaceAvailable) {
     if (self.outputBuffer.length == 0) {
       // serialize new packets only when the output buffer is flushed.
-      FIRMessagingPacket *packet = [self.packetQueue pop];
-      self.currentRmqIdBeingSent = packet.rmqId;
-      self.currentProtoTypeBeingSent = packet.tag;
-      NSUInteger length = SerializedSize(packet.tag) +
-          SerializedSize((int)packet.data.length) + packet.data.length;
-      self.outputBuffer = [NSMutableData dataWithLength:length];
-      GPBCodedOutputStream *output = [GPBCodedOutputStream streamWithData:self.outputBuffer];
-      [output writeRawVarint32:packet.tag];
-      [output writeBytesNoTag:packet.data];
-      self.outputBufferLength = 0;
+      [self serializeQueuedPackets];
     }
 
-    // flush the output buffer.
+    // flush as much of the output buffer as the stream accepts.
     NSInteger written = [self.outStream write:self.outputBuffer.bytes + self.outputBufferLength
                                     maxLength:self.outputBuffer.length - self.outputBufferLength];
     if (written <= 0) {
-      continue;
+      break;
     }
     self.outputBufferLength += (NSUInteger)written;
+
+    NSMutableArray *sentPackets = [NSMutableArray array];
+    while (self.packetsBeingSent.count &&
+           [self.packetEndOffsets[0] unsignedIntegerValue] <= self.outputBufferLength) {
+      [sentPackets addObject:self.packetsBeingSent[0]];
+      [self.packetsBeingSent removeObjectAtIndex:0];
+      [self.packetEndOffsets removeObjectAtIndex:0];
+    }
     if (self.outputBufferLength >= self.outputBuffer.length) {
       self.outputBufferLength = 0;
       self.outputBuffer = nil;
-      [self.delegate secureSocket:self
-              didSendProtoWithTag:self.currentProtoTypeBeingSent
-                            rmqId:self.currentRmqIdBeingSent];
-      self.currentRmqIdBeingSent = nil;
-      self.currentProtoTypeBeingSent = kInvalidTag;
     }
+    // The delegate may queue more packets and re-enter this method, so the output buffer has to
+    // be up to date before it is told about the sent packets.
+    if (sentPackets.count) {
+      [self recordOutgoingQueueDepth];
+    }
+    for (FIRMessagingPacket *packet in sentPackets) {
+      [self.delegate secureSocket:self didSendProtoWithTag:packet.tag rmqId:packet.rmqId];
+    }
+  }
+}
+
+// Packets count towards the depth until all of their bytes have been written
+- (void)recordOutgoingQueueDepth {
+  [FIRMessagingSharedMetrics()
+      recordOutgoingQueueDepth:self.packetQueue.count + self.packetsBeingSent.count];
+}
+
+/**
+ * Moves packets from the queue into a new output buffer, until the buffer would exceed
+ * kMaxCoalescedWriteLength. A packet larger than that is serialized on its own.
+ */
+- (void)serializeQueuedPackets {
+  _FIRMessagingDevAssert(self.packetsBeingSent.count == 0, @"Output buffer not flushed");
+  NSUInteger length = 0;
+  FIRMessagingPacket *packet;
+  while ((packet = [self.packetQueue pop])) {
+    NSUInteger packetLength = SerializedSize(packet.tag) +
+        SerializedSize((int)packet.data.length) + packet.data.length;
+    if (length > 0 && length + packetLength > kMaxCoalescedWriteLength) {
+      [self.packetQueue pushHead:packet];
+      break;
+    }
+    length += packetLength;
+    [self.packetsBeingSent addObject:packet];
+    [self.packetEndOffsets addObject:@(length)];
+  }
+
+  self.outputBuffer = [NSMutableData dataWithLength:length];
+  GPBCodedOutputStream *output = [GPBCodedOutputStream streamWithData:self.outputBuffer];
+  for (packet in self.packetsBeingSent) {
+    [output writeRawVarint32:packet.tag];
+    [output writeBytesNoTag:packet.data];
   }
+  self.outputBufferLength = 0;
 }
 
 @end
@@ -15,9 +15,11 @@
 #import "FIRStorage.h"
 
 #import "FIRStorageConstants_Private.h"
+#import "FIRStorageMetadata.h"
 #import "FIRStoragePath.h"
 #import "FIRStorageReference.h"
 #import "FIRStorageReference_Private.h"
+#import "FIRStorageTaskScheduler.h"
 #import "FIRStorageTokenAuthorizer.h"
 #import "FIRStorageUtils.h"
 #import "FIRStorage_Private.h"
@@ -33,7 +35,16 @@ static NSMutableDictionary<
     NSMutableDictionary<NSString * /* bucket */, GTMSessionFetcherService *> *> *_fetcherServiceMap;
 static GTMSessionFetcherRetryBlock _retryWhenOffline;
 
-@implementation FIRStorage
+@implementation FIRStorage {
+ @private
+  // Shared by metadata requests for the same object, see -beginMetadataRequestForPath:completion:.
+  // Guarded by @synchronized(_pendingMetadataRequests).
+  NSMutableDictionary<FIRStoragePath *, NSMutableArray<FIRStorageVoidMetadataError> *>
+      *_pendingMetadataRequests;
+  NSMutableSet<FIRStoragePath *> *_staleMetadataRequests;
+  NSMutableDictionary<FIRStoragePath *, FIRStorageMetadata *> *_cachedMetadata;
+  NSMutableDictionary<FIRStoragePath *, NSDate *> *_cachedMetadataDates;
+}
 
 + (void)initialize {
   static dispatch_once_t onceToken;
@@ -138,6 +149,12 @@ static GTMSessionFetcherRetryBlock _retryWhenOffline;
     _maxDownloadRetryTime = 600.0;
     _maxOperationRetryTime = 120.0;
     _maxUploadRetryTime = 600.0;
+    _maxConcurrentDownloadChunks = 4;
+    _taskScheduler = [[FIRStorageTaskScheduler alloc] init];
+    _pendingMetadataRequests = [NSMutableDictionary dictionary];
+    _staleMetadataRequests = [NSMutableSet set];
+    _cachedMetadata = [NSMutableDictionary dictionary];
+    _cachedMetadataDates = [NSMutableDictionary dictionary];
   }
   return self;
 }
@@ -215,6 +232,86 @@ static GTMSessionFetcherRetryBlock _retryWhenOffline;
   _fetcherServiceForApp.callbackQueue = callbackQueue;
 }
 
+#pragma mark - Task scheduling
+
+- (void)setMaxConcurrentTasks:(NSUInteger)maxConcurrentTasks
+                  forPriority:(FIRStorageTaskPriority)priority {
+  [_taskScheduler setMaxConcurrentTasks:maxConcurrentTasks forPriority:priority];
+}
+
+- (void)pauseTasksWithPriority:(FIRStorageTaskPriority)priority {
+  [_taskScheduler pauseTasksWithPriority:priority];
+}
+
+- (void)resumeTasksWithPriority:(FIRStorageTaskPriority)priority {
+  [_taskScheduler resumeTasksWithPriority:priority];
+}
+
+#pragma mark - Metadata requests
+
+- (nullable FIRStorageMetadata *)cachedMetadataForPath:(FIRStoragePath *)path {
+  @synchronized(_pendingMetadataRequests) {
+    NSDate *date = _cachedMetadataDates[path];
+    if (!date) {
+      return nil;
+    }
+    if (-[date timeIntervalSinceNow] >= self.metadataCacheTimeout) {
+      [_cachedMetadata removeObjectForKey:path];
+      [_cachedMetadataDates removeObjectForKey:path];
+      return nil;
+    }
+    return [_cachedMetadata[path] copy];
+  }
+}
+
+- (BOOL)beginMetadataRequestForPath:(FIRStoragePath *)path
+                         completion:(nullable FIRStorageVoidMetadataError)completion {
+  FIRStorageVoidMetadataError callback = [completion copy];
+  if (!callback) {
+    callback = ^(FIRStorageMetadata *metadata, NSError *error) {
+    };
+  }
+  @synchronized(_pendingMetadataRequests) {
+    NSMutableArray<FIRStorageVoidMetadataError> *completions = _pendingMetadataRequests[path];
+    if (completions) {
+      [completions addObject:callback];
+      return NO;
+    }
+    _pendingMetadataRequests[path] = [NSMutableArray arrayWithObject:callback];
+    return YES;
+  }
+}
+
+- (void)finishMetadataRequestForPath:(FIRStoragePath *)path
+                            metadata:(nullable FIRStorageMetadata *)metadata
+                               error:(nullable NSError *)error {
+  NSArray<FIRStorageVoidMetadataError> *completions;
+  @synchronized(_pendingMetadataRequests) {
+    completions = _pendingMetadataRequests[path];
+    [_pendingMetadataRequests removeObjectForKey:path];
+    BOOL isStale = [_staleMetadataRequests containsObject:path];
+    [_staleMetadataRequests removeObject:path];
+    if (metadata && !isStale && self.metadataCacheTimeout > 0) {
+      _cachedMetadata[path] = [metadata copy];
+      _cachedMetadataDates[path] = [NSDate date];
+    }
+  }
+  // Every caller gets its own copy, FIRStorageMetadata is mutable.
+  for (FIRStorageVoidMetadataError completion in completions) {
+    completion([metadata copy], error);
+  }
+}
+
+- (void)invalidateCachedMetadataForPath:(FIRStoragePath *)path {
+  @synchronized(_pendingMetadataRequests) {
+    [_cachedMetadata removeObjectForKey:path];
+    [_cachedMetadataDates removeObjectForKey:path];
+    if (_pendingMetadataRequests[path]) {
+      [_staleMetadataRequests addObject:path];
+    }
+  }
+}
+
 #pragma mark - Background tasks
 
 + (void)enableBackgroundTasks:(BOOL)isEnabled {
@@ -78,6 +78,13 @@ NSString *const kFIRStorageTaskStatusFailureNotification =
 
 NSString *const kFIRStorageBundleIdentifier = @"com.google.firebase.storage";
 
+int64_t const kFIRStorageUploadChunkGranularity = 256 * 1024;
+int64_t const kFIRStorageInitialUploadChunkSize = 1024 * 1024;
+int64_t const kFIRStorageMaxUploadChunkSize = 64 * 1024 * 1024;
+NSTimeInterval const kFIRStorageUploadChunkTargetDuration = 8.0;
+double const kFIRStorageUploadChunkRoundTrips = 20.0;
+NSUInteger const kFIRStorageUploadStreamReadSize = 32 * 1024;
+
 // The STR and STR_EXPAND macro allow a numeric version passed to he compiler driver
 // with a -D to be treated as a string instead of an invalid floating point value.
 #define STR(x) STR_EXPAND(x)
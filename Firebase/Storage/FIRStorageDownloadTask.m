@@ -19,7 +19,18 @@
 #import "FIRStorageObservableTask_Private.h"
 #import "FIRStorageTask_Private.h"
 
-@implementation FIRStorageDownloadTask
+@implementation FIRStorageDownloadTask {
+ @private
+  // State of a file download that is split into parallel range requests, see
+  // -enqueueChunkedDownloadWithRequest:. The set of completed chunks survives pause and resume.
+  NSURLRequest *_chunkRequest;
+  NSFileHandle *_chunkFileHandle;
+  NSMutableIndexSet *_completedChunks;
+  NSMutableDictionary<NSNumber *, GTMSessionFetcher *> *_chunkFetchers;
+  NSString *_chunkETag;
+  int64_t _chunkSize;
+  int64_t _chunkTotalBytes;
+}
 
 @synthesize progress = _progress;
 @synthesize fetcher = _fetcher;
@@ -38,6 +49,8 @@
 
 - (void)dealloc {
   [_fetcher stopFetching];
+  [self stopChunkFetchers];
+  [_chunkFileHandle closeFile];
 }
 
 - (void)enqueue {
@@ -57,6 +70,11 @@
   [components setQuery:@"alt=media"];
   request.URL = components.URL;
 
+  if (_fileURL && (_completedChunks || self.reference.storage.downloadChunkSize > 0)) {
+    [self enqueueChunkedDownloadWithRequest:request];
+    return;
+  }
+
   GTMSessionFetcher *fetcher;
   if (resumeData) {
     fetcher = [GTMSessionFetcher fetcherWithDownloadResumeData:resumeData];
@@ -91,10 +109,25 @@
     }];
   } else {
     // Handle data downloads
+    if (_dataHandler) {
+      void (^dataHandler)(NSData *) = _dataHandler;
+      __weak GTMSessionFetcher *weakFetcher = fetcher;
+      // Bytes are handed over as they arrive instead of being accumulated by the fetcher. Error
+      // response bodies are dropped, the fetcher reports them through the completion error.
+      fetcher.accumulateDataBlock = ^(NSData *buffer) {
+        NSHTTPURLResponse *response = (NSHTTPURLResponse *)weakFetcher.response;
+        if (buffer.length > 0 && response.statusCode < 300) {
+          dataHandler(buffer);
+        }
+      };
+    }
     [fetcher setReceivedProgressBlock:^(int64_t bytesWritten, int64_t totalBytesWritten) {
+      int64_t totalLength = [[weakSelf.fetcher response] expectedContentLength];
+      if ([weakSelf cancelIfDownloadExceedsMaxSize:totalLength receivedBytes:totalBytesWritten]) {
+        return;
+      }
       weakSelf.state = FIRStorageTaskStateProgress;
       weakSelf.progress.completedUnitCount = totalBytesWritten;
-      int64_t totalLength = [[weakSelf.fetcher response] expectedContentLength];
       weakSelf.progress.totalUnitCount = totalLength;
       FIRStorageTaskSnapshot *snapshot = weakSelf.snapshot;
       [weakSelf fireHandlersForStatus:FIRStorageTaskStatusProgress snapshot:snapshot];
@@ -139,6 +172,204 @@
   }];
 }
 
+- (BOOL)cancelIfDownloadExceedsMaxSize:(int64_t)totalBytes receivedBytes:(int64_t)receivedBytes {
+  int64_t maxSize = _maxDownloadSize;
+  if (maxSize <= 0 || (totalBytes <= maxSize && receivedBytes <= maxSize)) {
+    return NO;
+  }
+  if (self.state == FIRStorageTaskStateCancelled) {
+    return YES;
+  }
+  NSDictionary *infoDictionary = @{@"totalSize" : @(totalBytes), @"maxAllowedSize" : @(maxSize)};
+  NSError *error = [FIRStorageErrors errorWithCode:FIRStorageErrorCodeDownloadSizeExceeded
+                                    infoDictionary:infoDictionary];
+  [self cancelWithError:error];
+  return YES;
+}
+
+#pragma mark - Chunked Downloads
+
+- (void)enqueueChunkedDownloadWithRequest:(NSURLRequest *)request {
+  @synchronized(self) {
+    _chunkRequest = [request copy];
+    if (!_completedChunks) {
+      _completedChunks = [NSMutableIndexSet indexSet];
+      _chunkFetchers = [NSMutableDictionary dictionary];
+      _chunkSize = self.reference.storage.downloadChunkSize;
+      _chunkTotalBytes = -1;
+    }
+    self.state = FIRStorageTaskStateRunning;
+    if (_chunkTotalBytes < 0) {
+      // The first range tells us how large the object is, the others are sized from it.
+      [self startChunk:0];
+    } else {
+      [self startPendingChunks];
+    }
+  }
+}
+
+- (NSUInteger)chunkCount {
+  if (_chunkTotalBytes <= 0) {
+    return 1;
+  }
+  return (NSUInteger)((_chunkTotalBytes + _chunkSize - 1) / _chunkSize);
+}
+
+- (void)startPendingChunks {
+  NSUInteger maxConcurrentChunks = MAX(self.reference.storage.maxConcurrentDownloadChunks, 1u);
+  NSUInteger chunkCount = [self chunkCount];
+  for (NSUInteger chunk = 0; chunk < chunkCount && _chunkFetchers.count < maxConcurrentChunks;
+       chunk++) {
+    if (![_completedChunks containsIndex:chunk] && !_chunkFetchers[@(chunk)]) {
+      [self startChunk:chunk];
+    }
+  }
+}
+
+- (void)startChunk:(NSUInteger)chunk {
+  int64_t start = (int64_t)chunk * _chunkSize;
+  NSMutableURLRequest *request = [_chunkRequest mutableCopy];
+  [request setValue:[NSString stringWithFormat:@"bytes=%lld-%lld", start, start + _chunkSize - 1]
+      forHTTPHeaderField:@"Range"];
+  if (_chunkETag) {
+    // Fail instead of stitching together ranges of different versions of the object.
+    [request setValue:_chunkETag forHTTPHeaderField:@"If-Match"];
+  }
+
+  GTMSessionFetcher *fetcher = [self.fetcherService fetcherWithRequest:request];
+  fetcher.comment = [NSString stringWithFormat:@"DownloadTask chunk %lu", (unsigned long)chunk];
+  fetcher.maxRetryInterval = self.reference.storage.maxDownloadRetryTime;
+  _chunkFetchers[@(chunk)] = fetcher;
+
+  __weak FIRStorageDownloadTask *weakSelf = self;
+  [fetcher beginFetchWithCompletionHandler:^(NSData *data, NSError *error) {
+    [weakSelf chunk:chunk ofFetcher:fetcher didFinishWithData:data error:error];
+  }];
+}
+
+- (void)stopChunkFetchers {
+  for (GTMSessionFetcher *fetcher in _chunkFetchers.allValues) {
+    [fetcher stopFetching];
+  }
+  [_chunkFetchers removeAllObjects];
+}
+
+- (void)chunk:(NSUInteger)chunk
+            ofFetcher:(GTMSessionFetcher *)fetcher
+    didFinishWithData:(NSData *)data
+                error:(NSError *)error {
+  @synchronized(self) {
+    if (_chunkFetchers[@(chunk)] != fetcher) {
+      // The task was paused or cancelled while this range was in flight.
+      return;
+    }
+    [_chunkFetchers removeObjectForKey:@(chunk)];
+
+    if (error) {
+      if (chunk == 0 && _chunkTotalBytes < 0 && error.code == 416 &&
+          [error.domain isEqualToString:kGTMSessionFetcherStatusDomain]) {
+        // Any range of an empty object is unsatisfiable.
+        data = [NSData data];
+      } else {
+        [self failChunkedDownloadWithError:[FIRStorageErrors errorWithServerError:error
+                                                                        reference:self.reference]];
+        return;
+      }
+    }
+
+    if (_chunkTotalBytes < 0) {
+      NSError *fileError;
+      if (![self prepareChunkFileForResponse:(NSHTTPURLResponse *)fetcher.response
+                                        data:data
+                                       error:&fileError]) {
+        [self failChunkedDownloadWithError:fileError];
+        return;
+      }
+    }
+
+    NSUInteger chunkCount = [self chunkCount];
+    int64_t offset = (int64_t)chunk * _chunkSize;
+    int64_t expectedLength = MIN(_chunkSize, _chunkTotalBytes - offset);
+    NSRange chunks = NSMakeRange(chunk, 1);
+    if (chunk == 0 && (int64_t)data.length == _chunkTotalBytes) {
+      // The server ignored the range and sent the whole object.
+      expectedLength = _chunkTotalBytes;
+      chunks = NSMakeRange(0, chunkCount);
+    }
+    if ((int64_t)data.length != expectedLength) {
+      [self failChunkedDownloadWithError:[FIRStorageErrors
+                                             errorWithCode:FIRStorageErrorCodeUnknown]];
+      return;
+    }
+    [_chunkFileHandle seekToFileOffset:(unsigned long long)offset];
+    [_chunkFileHandle writeData:data];
+    [_completedChunks addIndexesInRange:chunks];
+
+    // Only the last chunk may be shorter than the chunk size.
+    int64_t completedBytes = (int64_t)_completedChunks.count * _chunkSize;
+    if ([_completedChunks containsIndex:chunkCount - 1]) {
+      completedBytes -= (int64_t)chunkCount * _chunkSize - _chunkTotalBytes;
+    }
+    self.state = FIRStorageTaskStateProgress;
+    self.progress.completedUnitCount = completedBytes;
+    self.progress.totalUnitCount = _chunkTotalBytes;
+    [self fireHandlersForStatus:FIRStorageTaskStatusProgress snapshot:self.snapshot];
+
+    if (_completedChunks.count == chunkCount) {
+      [_chunkFileHandle closeFile];
+      _chunkFileHandle = nil;
+      self.state = FIRStorageTaskStateSuccess;
+      [self fireHandlersForStatus:FIRStorageTaskStatusSuccess snapshot:self.snapshot];
+      [self removeAllObservers];
+      return;
+    }
+
+    self.state = FIRStorageTaskStateRunning;
+    [self startPendingChunks];
+  }
+}
+
+- (BOOL)prepareChunkFileForResponse:(NSHTTPURLResponse *)response
+                               data:(NSData *)data
+                              error:(NSError **)error {
+  if (response.statusCode == 206) {
+    // Content-Range: bytes <first>-<last>/<total>
+    NSString *contentRange = response.allHeaderFields[@"Content-Range"];
+    NSRange slash = [contentRange rangeOfString:@"/"];
+    if (slash.location == NSNotFound) {
+      *error = [FIRStorageErrors errorWithCode:FIRStorageErrorCodeUnknown];
+      return NO;
+    }
+    _chunkTotalBytes = [[contentRange substringFromIndex:NSMaxRange(slash)] longLongValue];
+  } else {
+    _chunkTotalBytes = (int64_t)data.length;
+  }
+  _chunkETag = [response.allHeaderFields[@"ETag"] copy];
+
+  // Pre-allocate the destination so every range can be written at its final offset.
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  if (![fileManager createFileAtPath:_fileURL.path contents:nil attributes:nil]) {
+    *error = [FIRStorageErrors errorWithCode:FIRStorageErrorCodeUnknown];
+    return NO;
+  }
+  _chunkFileHandle = [NSFileHandle fileHandleForWritingToURL:_fileURL error:error];
+  if (!_chunkFileHandle) {
+    return NO;
+  }
+  [_chunkFileHandle truncateFileAtOffset:(unsigned long long)_chunkTotalBytes];
+  return YES;
+}
+
+- (void)failChunkedDownloadWithError:(NSError *)error {
+  [self stopChunkFetchers];
+  [_chunkFileHandle closeFile];
+  _chunkFileHandle = nil;
+  self.state = FIRStorageTaskStateFailed;
+  self.error = error;
+  [self fireHandlersForStatus:FIRStorageTaskStatusFailure snapshot:self.snapshot];
+  [self removeAllObservers];
+}
+
 #pragma mark - Download Management
 
 - (void)cancel {
@@ -152,6 +383,11 @@
            @"execute this method on the main queue.");
   self.state = FIRStorageTaskStateCancelled;
   [self.fetcher stopFetching];
+  @synchronized(self) {
+    [self stopChunkFetchers];
+    [_chunkFileHandle closeFile];
+    _chunkFileHandle = nil;
+  }
   self.error = error;
   [self fireHandlersForStatus:FIRStorageTaskStatusFailure snapshot:self.snapshot];
 }
@@ -162,6 +398,10 @@
            @"execute this method on the main queue.");
   self.state = FIRStorageTaskStatePausing;
   [self.fetcher stopFetching];
+  @synchronized(self) {
+    // Completed chunks are kept, resuming only fetches the missing ranges.
+    [self stopChunkFetchers];
+  }
   // Give the resume callback a chance to run (if scheduled)
   [self.fetcher waitForCompletionWithTimeout:0.001];
   self.state = FIRStorageTaskStatePaused;
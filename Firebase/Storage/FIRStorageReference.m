@@ -20,6 +20,7 @@
 #import "FIRStorageGetMetadataTask.h"
 #import "FIRStorageMetadata_Private.h"
 #import "FIRStorageReference_Private.h"
+#import "FIRStorageTaskScheduler.h"
 #import "FIRStorageTaskSnapshot.h"
 #import "FIRStorageTaskSnapshot_Private.h"
 #import "FIRStorageTask_Private.h"
@@ -58,6 +59,7 @@
 - (instancetype)copyWithZone:(NSZone *)zone {
   FIRStorageReference *copiedReference =
       [[[self class] allocWithZone:zone] initWithStorage:_storage path:_path];
+  copiedReference.taskPriority = _taskPriority;
   return copiedReference;
 }
 
@@ -122,6 +124,7 @@
   FIRStoragePath *rootPath = [_path root];
   FIRStorageReference *rootReference =
       [[FIRStorageReference alloc] initWithStorage:_storage path:rootPath];
+  rootReference.taskPriority = _taskPriority;
   return rootReference;
 }
 
@@ -133,6 +136,7 @@
 
   FIRStorageReference *parentReference =
       [[FIRStorageReference alloc] initWithStorage:_storage path:parentPath];
+  parentReference.taskPriority = _taskPriority;
   return parentReference;
 }
 
@@ -140,6 +144,7 @@
   FIRStoragePath *childPath = [_path child:path];
   FIRStorageReference *childReference =
       [[FIRStorageReference alloc] initWithStorage:_storage path:childPath];
+  childReference.taskPriority = _taskPriority;
   return childReference;
 }
 
@@ -163,6 +168,7 @@
 
   metadata.path = _path.object;
   metadata.name = [_path.object lastPathComponent];
+  [_storage invalidateCachedMetadataForPath:_path];
   FIRStorageUploadTask *task =
       [[FIRStorageUploadTask alloc] initWithReference:self
                                        fetcherService:_storage.fetcherServiceForApp
@@ -188,7 +194,7 @@
                   });
                 }];
   }
-  [task enqueue];
+  [_storage.taskScheduler scheduleTask:task priority:_taskPriority];
   return task;
 }
 
@@ -210,6 +216,7 @@
 
   metadata.path = _path.object;
   metadata.name = [_path.object lastPathComponent];
+  [_storage invalidateCachedMetadataForPath:_path];
   FIRStorageUploadTask *task =
       [[FIRStorageUploadTask alloc] initWithReference:self
                                        fetcherService:_storage.fetcherServiceForApp
@@ -235,7 +242,51 @@
                   });
                 }];
   }
-  [task enqueue];
+  [_storage.taskScheduler scheduleTask:task priority:_taskPriority];
+  return task;
+}
+
+- (FIRStorageUploadTask *)putStream:(NSInputStream *)stream
+                           metadata:(nullable FIRStorageMetadata *)metadata {
+  return [self putStream:stream metadata:metadata completion:nil];
+}
+
+- (FIRStorageUploadTask *)putStream:(NSInputStream *)stream
+                           metadata:(nullable FIRStorageMetadata *)metadata
+                         completion:(nullable FIRStorageVoidMetadataError)completion {
+  if (!metadata) {
+    metadata = [[FIRStorageMetadata alloc] init];
+  }
+
+  metadata.path = _path.object;
+  metadata.name = [_path.object lastPathComponent];
+  [_storage invalidateCachedMetadataForPath:_path];
+  FIRStorageUploadTask *task =
+      [[FIRStorageUploadTask alloc] initWithReference:self
+                                       fetcherService:_storage.fetcherServiceForApp
+                                               stream:stream
+                                             metadata:metadata];
+
+  if (completion) {
+    dispatch_queue_t callbackQueue = _storage.fetcherServiceForApp.callbackQueue;
+    if (!callbackQueue) {
+      callbackQueue = dispatch_get_main_queue();
+    }
+
+    [task observeStatus:FIRStorageTaskStatusSuccess
+                handler:^(FIRStorageTaskSnapshot *_Nonnull snapshot) {
+                  dispatch_async(callbackQueue, ^{
+                    completion(snapshot.metadata, nil);
+                  });
+                }];
+    [task observeStatus:FIRStorageTaskStatusFailure
+                handler:^(FIRStorageTaskSnapshot *_Nonnull snapshot) {
+                  dispatch_async(callbackQueue, ^{
+                    completion(nil, snapshot.error);
+                  });
+                }];
+  }
+  [_storage.taskScheduler scheduleTask:task priority:_taskPriority];
   return task;
 }
 
@@ -247,6 +298,7 @@
       [[FIRStorageDownloadTask alloc] initWithReference:self
                                          fetcherService:_storage.fetcherServiceForApp
                                                    file:nil];
+  task.maxDownloadSize = size;
 
   dispatch_queue_t callbackQueue = _storage.fetcherServiceForApp.callbackQueue;
   if (!callbackQueue) {
@@ -266,22 +318,40 @@
                   completion(nil, snapshot.error);
                 });
               }];
-  [task
-      observeStatus:FIRStorageTaskStatusProgress
-            handler:^(FIRStorageTaskSnapshot *_Nonnull snapshot) {
-              FIRStorageDownloadTask *task = snapshot.task;
-              if (task.progress.totalUnitCount > size || task.progress.completedUnitCount > size) {
-                NSDictionary *infoDictionary = @{
-                  @"totalSize" : @(task.progress.totalUnitCount),
-                  @"maxAllowedSize" : @(size)
-                };
-                NSError *error =
-                    [FIRStorageErrors errorWithCode:FIRStorageErrorCodeDownloadSizeExceeded
-                                     infoDictionary:infoDictionary];
-                [task cancelWithError:error];
-              }
-            }];
-  [task enqueue];
+  [_storage.taskScheduler scheduleTask:task priority:_taskPriority];
+  return task;
+}
+
+- (FIRStorageDownloadTask *)dataWithMaxSize:(int64_t)size
+                                dataHandler:(void (^)(NSData *data))dataHandler
+                                 completion:(nullable FIRStorageVoidError)completion {
+  FIRStorageDownloadTask *task =
+      [[FIRStorageDownloadTask alloc] initWithReference:self
+                                         fetcherService:_storage.fetcherServiceForApp
+                                                   file:nil];
+  task.maxDownloadSize = size;
+  task.dataHandler = dataHandler;
+
+  if (completion) {
+    dispatch_queue_t callbackQueue = _storage.fetcherServiceForApp.callbackQueue;
+    if (!callbackQueue) {
+      callbackQueue = dispatch_get_main_queue();
+    }
+
+    [task observeStatus:FIRStorageTaskStatusSuccess
+                handler:^(FIRStorageTaskSnapshot *_Nonnull snapshot) {
+                  dispatch_async(callbackQueue, ^{
+                    completion(nil);
+                  });
+                }];
+    [task observeStatus:FIRStorageTaskStatusFailure
+                handler:^(FIRStorageTaskSnapshot *_Nonnull snapshot) {
+                  dispatch_async(callbackQueue, ^{
+                    completion(snapshot.error);
+                  });
+                }];
+  }
+  [_storage.taskScheduler scheduleTask:task priority:_taskPriority];
   return task;
 }
 
@@ -314,7 +384,7 @@
                   });
                 }];
   }
-  [task enqueue];
+  [_storage.taskScheduler scheduleTask:task priority:_taskPriority];
   return task;
 }
 
@@ -334,15 +404,36 @@
 #pragma mark - Metadata Operations
 
 - (void)metadataWithCompletion:(FIRStorageVoidMetadataError)completion {
-  FIRStorageGetMetadataTask *task =
-      [[FIRStorageGetMetadataTask alloc] initWithReference:self
-                                            fetcherService:_storage.fetcherServiceForApp
-                                                completion:completion];
+  FIRStorageMetadata *cachedMetadata = [_storage cachedMetadataForPath:_path];
+  if (cachedMetadata) {
+    dispatch_queue_t callbackQueue = _storage.fetcherServiceForApp.callbackQueue;
+    if (!callbackQueue) {
+      callbackQueue = dispatch_get_main_queue();
+    }
+    dispatch_async(callbackQueue, ^{
+      completion(cachedMetadata, nil);
+    });
+    return;
+  }
+
+  // Requests for an object whose metadata is already being fetched share that fetch.
+  if (![_storage beginMetadataRequestForPath:_path completion:completion]) {
+    return;
+  }
+  FIRStorage *storage = _storage;
+  FIRStoragePath *path = _path;
+  FIRStorageGetMetadataTask *task = [[FIRStorageGetMetadataTask alloc]
+      initWithReference:self
+         fetcherService:_storage.fetcherServiceForApp
+             completion:^(FIRStorageMetadata *metadata, NSError *error) {
+               [storage finishMetadataRequestForPath:path metadata:metadata error:error];
+             }];
   [task enqueue];
 }
 
 - (void)updateMetadata:(FIRStorageMetadata *)metadata
             completion:(nullable FIRStorageVoidMetadataError)completion {
+  [_storage invalidateCachedMetadataForPath:_path];
   FIRStorageUpdateMetadataTask *task =
       [[FIRStorageUpdateMetadataTask alloc] initWithReference:self
                                                fetcherService:_storage.fetcherServiceForApp
@@ -354,6 +445,7 @@
 #pragma mark - Delete
 
 - (void)deleteWithCompletion:(nullable FIRStorageVoidError)completion {
+  [_storage invalidateCachedMetadataForPath:_path];
   FIRStorageDeleteTask *task =
       [[FIRStorageDeleteTask alloc] initWithReference:self
                                        fetcherService:_storage.fetcherServiceForApp
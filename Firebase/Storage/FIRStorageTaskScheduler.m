@@ -0,0 +1,144 @@
+// Copyright 2018 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "FIRStorageTaskScheduler.h"
+
+#import "FIRStorageConstants_Private.h"
+#import "FIRStorageTask_Private.h"
+
+typedef FIRStorageObservableTask<FIRStorageTaskManagement> FIRStorageScheduledTask;
+
+@implementation FIRStorageTaskScheduler {
+ @private
+  NSMutableDictionary<NSNumber *, NSMutableArray<FIRStorageScheduledTask *> *> *_queuedTasks;
+  NSMutableDictionary<NSNumber *, NSMutableArray<FIRStorageScheduledTask *> *> *_runningTasks;
+  NSMutableDictionary<NSNumber *, NSNumber *> *_maxConcurrentTasks;
+  NSMutableIndexSet *_pausedPriorities;
+  // Running tasks that were paused with their priority, as opposed to by the developer.
+  NSMutableSet<FIRStorageScheduledTask *> *_pausedTasks;
+}
+
+- (instancetype)init {
+  self = [super init];
+  if (self) {
+    _queuedTasks = [NSMutableDictionary dictionary];
+    _runningTasks = [NSMutableDictionary dictionary];
+    _maxConcurrentTasks = [NSMutableDictionary dictionary];
+    _pausedPriorities = [NSMutableIndexSet indexSet];
+    _pausedTasks = [NSMutableSet set];
+  }
+  return self;
+}
+
+- (NSMutableArray<FIRStorageScheduledTask *> *)tasks:
+    (NSMutableDictionary<NSNumber *, NSMutableArray<FIRStorageScheduledTask *> *> *)tasks
+                                          forPriority:(FIRStorageTaskPriority)priority {
+  NSMutableArray<FIRStorageScheduledTask *> *tasksForPriority = tasks[@(priority)];
+  if (!tasksForPriority) {
+    tasksForPriority = [NSMutableArray array];
+    tasks[@(priority)] = tasksForPriority;
+  }
+  return tasksForPriority;
+}
+
+- (void)scheduleTask:(FIRStorageScheduledTask *)task priority:(FIRStorageTaskPriority)priority {
+  NSAssert([NSThread isMainThread],
+           @"Tasks can only be scheduled on the main queue! Please only "
+           @"execute this method on the main queue.");
+  __weak FIRStorageTaskScheduler *weakSelf = self;
+  __weak FIRStorageScheduledTask *weakTask = task;
+  void (^taskFinished)(FIRStorageTaskSnapshot *) = ^(FIRStorageTaskSnapshot *snapshot) {
+    dispatch_async(dispatch_get_main_queue(), ^{
+      [weakSelf taskDidFinish:weakTask priority:priority];
+    });
+  };
+  [task observeStatus:FIRStorageTaskStatusSuccess handler:taskFinished];
+  // Also covers tasks cancelled while they are still queued.
+  [task observeStatus:FIRStorageTaskStatusFailure handler:taskFinished];
+
+  [[self tasks:_queuedTasks forPriority:priority] addObject:task];
+  [self startQueuedTasksWithPriority:priority];
+}
+
+- (void)setMaxConcurrentTasks:(NSUInteger)maxConcurrentTasks
+                  forPriority:(FIRStorageTaskPriority)priority {
+  NSAssert([NSThread isMainThread],
+           @"Task limits can only be changed on the main queue! Please only "
+           @"execute this method on the main queue.");
+  _maxConcurrentTasks[@(priority)] = @(MAX(maxConcurrentTasks, 1u));
+  [self startQueuedTasksWithPriority:priority];
+}
+
+- (void)pauseTasksWithPriority:(FIRStorageTaskPriority)priority {
+  NSAssert([NSThread isMainThread],
+           @"Tasks can only be paused on the main queue! Please only "
+           @"execute this method on the main queue.");
+  [_pausedPriorities addIndex:(NSUInteger)priority];
+  for (FIRStorageScheduledTask *task in [self tasks:_runningTasks forPriority:priority]) {
+    FIRStorageTaskState state = task.state;
+    if (state != FIRStorageTaskStatePaused && state != FIRStorageTaskStatePausing &&
+        [task respondsToSelector:@selector(pause)]) {
+      [task pause];
+      [_pausedTasks addObject:task];
+    }
+  }
+}
+
+- (void)resumeTasksWithPriority:(FIRStorageTaskPriority)priority {
+  NSAssert([NSThread isMainThread],
+           @"Tasks can only be resumed on the main queue! Please only "
+           @"execute this method on the main queue.");
+  [_pausedPriorities removeIndex:(NSUInteger)priority];
+  for (FIRStorageScheduledTask *task in [self tasks:_runningTasks forPriority:priority]) {
+    if ([_pausedTasks containsObject:task]) {
+      [_pausedTasks removeObject:task];
+      [task resume];
+    }
+  }
+  [self startQueuedTasksWithPriority:priority];
+}
+
+- (void)startQueuedTasksWithPriority:(FIRStorageTaskPriority)priority {
+  if ([_pausedPriorities containsIndex:(NSUInteger)priority]) {
+    return;
+  }
+  NSNumber *maxConcurrentTasks = _maxConcurrentTasks[@(priority)];
+  NSUInteger limit = maxConcurrentTasks ? maxConcurrentTasks.unsignedIntegerValue : NSUIntegerMax;
+  NSMutableArray<FIRStorageScheduledTask *> *queuedTasks =
+      [self tasks:_queuedTasks forPriority:priority];
+  NSMutableArray<FIRStorageScheduledTask *> *runningTasks =
+      [self tasks:_runningTasks forPriority:priority];
+  while (queuedTasks.count > 0 && runningTasks.count < limit) {
+    FIRStorageScheduledTask *task = queuedTasks.firstObject;
+    [queuedTasks removeObjectAtIndex:0];
+    [runningTasks addObject:task];
+    [task enqueue];
+  }
+}
+
+- (void)taskDidFinish:(FIRStorageScheduledTask *)task priority:(FIRStorageTaskPriority)priority {
+  if (!task) {
+    return;
+  }
+  [_pausedTasks removeObject:task];
+  [[self tasks:_queuedTasks forPriority:priority] removeObjectIdenticalTo:task];
+  NSMutableArray<FIRStorageScheduledTask *> *runningTasks =
+      [self tasks:_runningTasks forPriority:priority];
+  if ([runningTasks indexOfObjectIdenticalTo:task] != NSNotFound) {
+    [runningTasks removeObjectIdenticalTo:task];
+    [self startQueuedTasksWithPriority:priority];
+  }
+}
+
+@end
@@ -22,7 +22,21 @@
 
 #import "GTMSessionUploadFetcher.h"
 
-@implementation FIRStorageUploadTask
+@implementation FIRStorageUploadTask {
+ @private
+  // Adaptive chunking, see -adaptChunkSizeForTotalBytesSent:.
+  int64_t _chunkStartOffset;
+  CFAbsoluteTime _chunkStartTime;
+  CFAbsoluteTime _lastChunkEndTime;
+  NSTimeInterval _roundTripTime;
+
+  // Stream uploads, see -provideStreamDataAtOffset:length:response:. The buffer holds the bytes
+  // read from the stream starting at _streamBufferOffset that the server hasn't confirmed yet.
+  dispatch_queue_t _streamQueue;
+  NSMutableData *_streamBuffer;
+  int64_t _streamBufferOffset;
+  BOOL _streamAtEnd;
+}
 
 @synthesize progress = _progress;
 @synthesize fetcherCompletion = _fetcherCompletion;
@@ -34,6 +48,7 @@
   self = [super initWithReference:reference fetcherService:service];
   if (self) {
     _uploadMetadata = [metadata copy];
+    // Only copies NSMutableData, which the caller could change while it is being uploaded.
     _uploadData = [uploadData copy];
     _progress = [NSProgress progressWithTotalUnitCount:[_uploadData length]];
 
@@ -63,8 +78,29 @@
   return self;
 }
 
+- (instancetype)initWithReference:(FIRStorageReference *)reference
+                   fetcherService:(GTMSessionFetcherService *)service
+                           stream:(NSInputStream *)stream
+                         metadata:(FIRStorageMetadata *)metadata {
+  self = [super initWithReference:reference fetcherService:service];
+  if (self) {
+    _uploadMetadata = [metadata copy];
+    _uploadStream = stream;
+    _progress = [NSProgress progressWithTotalUnitCount:0];
+    _streamQueue =
+        dispatch_queue_create("com.google.firebase.storage.UploadStream", DISPATCH_QUEUE_SERIAL);
+    _streamBuffer = [NSMutableData data];
+
+    if (!_uploadMetadata.contentType) {
+      _uploadMetadata.contentType = @"application/octet-stream";
+    }
+  }
+  return self;
+}
+
 - (void)dealloc {
   [_uploadFetcher stopFetching];
+  [_uploadStream close];
 }
 
 - (void)enqueue {
@@ -94,10 +130,15 @@
   [components setPercentEncodedQuery:[FIRStorageUtils queryStringForDictionary:queryParams]];
   request.URL = components.URL;
 
+  BOOL adaptiveChunking = self.reference.storage.adaptiveUploadChunking;
+  // Streams of unknown length can only be uploaded in chunks.
+  int64_t chunkSize = (adaptiveChunking || _uploadStream)
+                          ? kFIRStorageInitialUploadChunkSize
+                          : kGTMSessionUploadFetcherStandardChunkSize;
   GTMSessionUploadFetcher *uploadFetcher =
       [GTMSessionUploadFetcher uploadFetcherWithRequest:request
                                          uploadMIMEType:_uploadMetadata.contentType
-                                              chunkSize:kGTMSessionUploadFetcherStandardChunkSize
+                                              chunkSize:chunkSize
                                          fetcherService:self.fetcherService];
 
   if (_uploadData) {
@@ -106,6 +147,15 @@
   } else if (_fileURL) {
     [uploadFetcher setUploadFileURL:_fileURL];
     uploadFetcher.comment = @"File UploadTask";
+  } else if (_uploadStream) {
+    __weak FIRStorageUploadTask *weakTask = self;
+    [uploadFetcher
+        setUploadDataLength:kGTMSessionUploadFetcherUnknownFileSize
+                   provider:^(int64_t offset, int64_t length,
+                              GTMSessionUploadFetcherDataProviderResponse response) {
+                     [weakTask provideStreamDataAtOffset:offset length:length response:response];
+                   }];
+    uploadFetcher.comment = @"Stream UploadTask";
   }
 
   uploadFetcher.maxRetryInterval = self.reference.storage.maxUploadRetryTime;
@@ -120,6 +170,9 @@
     weakSelf.metadata = _uploadMetadata;
     [weakSelf fireHandlersForStatus:FIRStorageTaskStatusProgress snapshot:weakSelf.snapshot];
     weakSelf.state = FIRStorageTaskStateRunning;
+    if (adaptiveChunking) {
+      [weakSelf adaptChunkSizeForTotalBytesSent:totalBytesSent];
+    }
   }];
 
   _uploadFetcher = uploadFetcher;
@@ -176,6 +229,88 @@
       }];
 }
 
+#pragma mark - Stream Uploads
+
+- (void)provideStreamDataAtOffset:(int64_t)offset
+                           length:(int64_t)length
+                         response:(GTMSessionUploadFetcherDataProviderResponse)response {
+  // Reads block until the producer has written enough, so keep them off the fetcher's queue.
+  dispatch_async(_streamQueue, ^{
+    if (self->_uploadStream.streamStatus == NSStreamStatusNotOpen) {
+      [self->_uploadStream open];
+    }
+
+    // The fetcher only asks for an offset once everything before it has been confirmed.
+    if (offset > self->_streamBufferOffset) {
+      NSUInteger confirmed = (NSUInteger)MIN(offset - self->_streamBufferOffset,
+                                             (int64_t)self->_streamBuffer.length);
+      [self->_streamBuffer replaceBytesInRange:NSMakeRange(0, confirmed) withBytes:NULL length:0];
+      self->_streamBufferOffset += confirmed;
+    }
+    if (offset < self->_streamBufferOffset) {
+      response(nil, kGTMSessionUploadFetcherUnknownFileSize,
+               [FIRStorageErrors errorWithCode:FIRStorageErrorCodeUnknown]);
+      return;
+    }
+
+    NSMutableData *readBuffer = [NSMutableData dataWithLength:kFIRStorageUploadStreamReadSize];
+    while (!self->_streamAtEnd &&
+           self->_streamBufferOffset + (int64_t)self->_streamBuffer.length < offset + length) {
+      NSInteger bytesRead = [self->_uploadStream read:readBuffer.mutableBytes
+                                                maxLength:readBuffer.length];
+      if (bytesRead < 0) {
+        NSError *error = self->_uploadStream.streamError
+                             ?: [FIRStorageErrors errorWithCode:FIRStorageErrorCodeUnknown];
+        response(nil, kGTMSessionUploadFetcherUnknownFileSize, error);
+        return;
+      }
+      if (bytesRead == 0) {
+        self->_streamAtEnd = YES;
+        [self->_uploadStream close];
+      } else {
+        [self->_streamBuffer appendBytes:readBuffer.bytes length:(NSUInteger)bytesRead];
+      }
+    }
+
+    NSUInteger start = (NSUInteger)(offset - self->_streamBufferOffset);
+    NSUInteger available =
+        self->_streamBuffer.length > start ? self->_streamBuffer.length - start : 0;
+    NSData *data = [self->_streamBuffer
+        subdataWithRange:NSMakeRange(start, MIN(available, (NSUInteger)length))];
+    int64_t fullLength = self->_streamAtEnd
+                             ? self->_streamBufferOffset + (int64_t)self->_streamBuffer.length
+                             : kGTMSessionUploadFetcherUnknownFileSize;
+    response(data, fullLength, nil);
+  });
+}
+
+#pragma mark - Adaptive Chunking
+
+- (void)adaptChunkSizeForTotalBytesSent:(int64_t)totalBytesSent {
+  CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+  if (_chunkStartTime == 0) {
+    // The gap between the end of one chunk and the first progress of the next is dominated by
+    // the round trip for the previous chunk's response.
+    _chunkStartTime = now;
+    if (_lastChunkEndTime > 0) {
+      _roundTripTime = now - _lastChunkEndTime;
+    }
+  }
+
+  int64_t chunkSize = _uploadFetcher.chunkSize;
+  int64_t bytesSent = totalBytesSent - _chunkStartOffset;
+  if (bytesSent < chunkSize) {
+    return;
+  }
+  _uploadFetcher.chunkSize = [FIRStorageUtils uploadChunkSizeForBytesSent:bytesSent
+                                                                 duration:now - _chunkStartTime
+                                                            roundTripTime:_roundTripTime
+                                                                chunkSize:chunkSize];
+  _chunkStartOffset = totalBytesSent;
+  _chunkStartTime = 0;
+  _lastChunkEndTime = now;
+}
+
 #pragma mark - Upload Management
 
 - (void)cancel {
@@ -100,6 +100,20 @@ NSString *const kGCSObjectAllowedCharacterSet =
   return [@"/" stringByAppendingString:[kFIRStorageVersionPath stringByAppendingString:urlPath]];
 }
 
++ (int64_t)uploadChunkSizeForBytesSent:(int64_t)bytes
+                              duration:(NSTimeInterval)duration
+                         roundTripTime:(NSTimeInterval)roundTripTime
+                             chunkSize:(int64_t)chunkSize {
+  int64_t nextChunkSize = chunkSize * 2;
+  if (duration > 0) {
+    NSTimeInterval targetDuration =
+        MAX(kFIRStorageUploadChunkTargetDuration, roundTripTime * kFIRStorageUploadChunkRoundTrips);
+    nextChunkSize = MIN(nextChunkSize, (int64_t)(bytes / duration * targetDuration));
+  }
+  nextChunkSize -= nextChunkSize % kFIRStorageUploadChunkGranularity;
+  return MIN(MAX(nextChunkSize, kFIRStorageUploadChunkGranularity), kFIRStorageMaxUploadChunkSize);
+}
+
 @end
 
 @implementation NSDictionary (FIRStorageNSDictionaryJSONHelpers)
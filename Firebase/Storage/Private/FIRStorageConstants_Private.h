@@ -69,6 +69,20 @@ FOUNDATION_EXPORT NSString *const kFIRStorageInvalidObserverStatus;
 
 FOUNDATION_EXPORT NSString *const kFIRStorageBundleIdentifier;
 
+/**
+ * Chunk sizes used by uploads with FIRStorage#adaptiveUploadChunking enabled.
+ */
+FOUNDATION_EXPORT int64_t const kFIRStorageUploadChunkGranularity;
+FOUNDATION_EXPORT int64_t const kFIRStorageInitialUploadChunkSize;
+FOUNDATION_EXPORT int64_t const kFIRStorageMaxUploadChunkSize;
+FOUNDATION_EXPORT NSTimeInterval const kFIRStorageUploadChunkTargetDuration;
+FOUNDATION_EXPORT double const kFIRStorageUploadChunkRoundTrips;
+
+/**
+ * Number of bytes read from an upload stream at a time.
+ */
+FOUNDATION_EXPORT NSUInteger const kFIRStorageUploadStreamReadSize;
+
 /**
  * Enum representing the internal state of an upload or download task.
  */
@@ -30,6 +30,19 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(copy, nonatomic) NSURL *fileURL;
 
+/**
+ * Maximum number of bytes to download into memory, or 0 for no limit. The download is cancelled
+ * with FIRStorageErrorCodeDownloadSizeExceeded as soon as the size announced by the server or the
+ * number of bytes received exceeds it.
+ */
+@property(nonatomic) int64_t maxDownloadSize;
+
+/**
+ * If set, bytes downloaded into memory are passed to this block as they arrive instead of being
+ * collected in downloadData.
+ */
+@property(copy, nonatomic, nullable) void (^dataHandler)(NSData *data);
+
 /**
  * Initializes a download task with a base FIRStorageReference and GTMSessionFetcherService.
  * @param reference The base FIRStorageReference which fetchers use for configuration.
@@ -24,7 +24,7 @@ NS_ASSUME_NONNULL_BEGIN
  * This class also includes helper methods to parse those URI/Ls, as well as to
  * add and remove path segments.
  */
-@interface FIRStoragePath : NSObject
+@interface FIRStoragePath : NSObject <NSCopying>
 
 /**
  * The GCS bucket in the path.
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "FIRStorageConstants.h"
+#import "FIRStorageObservableTask.h"
+#import "FIRStorageTask.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * FIRStorageTaskScheduler starts the upload and download tasks of a FIRStorage instance,
+ * holding back tasks of a priority while too many of them are running or while the priority is
+ * paused. Queued tasks start in the order they were scheduled.
+ * All methods must be called on the main queue, like the task management methods themselves.
+ */
+@interface FIRStorageTaskScheduler : NSObject
+
+/**
+ * Starts @a task now if its priority has room, or once a running task of the same priority
+ * finishes otherwise.
+ */
+- (void)scheduleTask:(FIRStorageObservableTask<FIRStorageTaskManagement> *)task
+            priority:(FIRStorageTaskPriority)priority;
+
+/**
+ * Sets the number of tasks of @a priority that may run at the same time. Defaults to no limit.
+ */
+- (void)setMaxConcurrentTasks:(NSUInteger)maxConcurrentTasks
+                  forPriority:(FIRStorageTaskPriority)priority;
+
+/**
+ * Pauses the running tasks of @a priority and holds back queued ones.
+ */
+- (void)pauseTasksWithPriority:(FIRStorageTaskPriority)priority;
+
+/**
+ * Resumes the tasks paused by pauseTasksWithPriority: and starts queued ones.
+ */
+- (void)resumeTasksWithPriority:(FIRStorageTaskPriority)priority;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -30,6 +30,11 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(readonly, copy, nonatomic, nullable) NSURL *fileURL;
 
+/**
+ * The stream to be uploaded (if uploading from a stream).
+ */
+@property(readonly, strong, nonatomic, nullable) NSInputStream *uploadStream;
+
 /**
  * The FIRStorageMetadata about the object being uploaded.
  */
@@ -64,6 +69,18 @@ NS_ASSUME_NONNULL_BEGIN
                              file:(NSURL *)fileURL
                          metadata:(FIRStorageMetadata *)metadata;
 
+/**
+ * Initializes an upload task with a base FIRStorageReference and GTMSessionFetcherService.
+ * @param reference The base FIRStorageReference which fetchers use for configuration.
+ * @param service The GTMSessionFetcherService which will create fetchers.
+ * @param stream The unopened NSInputStream to upload from.
+ * @return Returns an instance of FIRStorageUploadTask.
+ */
+- (instancetype)initWithReference:(FIRStorageReference *)reference
+                   fetcherService:(GTMSessionFetcherService *)service
+                           stream:(NSInputStream *)stream
+                         metadata:(FIRStorageMetadata *)metadata;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -66,6 +66,22 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (NSString *)encodedURLForPath:(FIRStoragePath *)path;
 
+/**
+ * Returns the size of the next chunk of an adaptively chunked upload.
+ * Chunks are sized so that they take long enough to send that the round trip between two
+ * chunks is a small fraction of the transfer time, grow at most twofold per chunk, and are a
+ * multiple of the 256 KiB granularity required by resumable uploads.
+ * @param bytes The number of bytes sent in the last chunk.
+ * @param duration The time it took to send the last chunk.
+ * @param roundTripTime The measured delay between two chunks, or 0 if unknown.
+ * @param chunkSize The size of the last chunk.
+ * @return The size in bytes to use for the next chunk.
+ */
++ (int64_t)uploadChunkSizeForBytesSent:(int64_t)bytes
+                              duration:(NSTimeInterval)duration
+                         roundTripTime:(NSTimeInterval)roundTripTime
+                             chunkSize:(int64_t)chunkSize;
+
 @end
 
 @interface NSDictionary (FIRStorageNSDictionaryJSONHelpers)
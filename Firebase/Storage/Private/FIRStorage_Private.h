@@ -14,7 +14,12 @@
  * limitations under the License.
  */
 
+#import "FIRStorageConstants.h"
+
 @class FIRApp;
+@class FIRStorageMetadata;
+@class FIRStoragePath;
+@class FIRStorageTaskScheduler;
 @class GTMSessionFetcherService;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -27,12 +32,46 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property(strong, nonatomic) NSString *storageBucket;
 
+/**
+ * Starts the upload and download tasks created by references of this instance.
+ */
+@property(strong, nonatomic, readonly) FIRStorageTaskScheduler *taskScheduler;
+
 /**
  * Enables/disables GTMSessionFetcher HTTP logging
  * @param isLoggingEnabled Boolean passed through to enable/disable GTMSessionFetcher logging
  */
 + (void)setGTMSessionFetcherLoggingEnabled:(BOOL)isLoggingEnabled;
 
+/**
+ * Returns the metadata cached for the object at @a path, or nil if there is none or it is older
+ * than metadataCacheTimeout.
+ */
+- (nullable FIRStorageMetadata *)cachedMetadataForPath:(FIRStoragePath *)path;
+
+/**
+ * Registers a completion for the metadata of the object at @a path.
+ * @return YES if no metadata request for the path is in flight, in which case the caller has to
+ * start one and report its result with -finishMetadataRequestForPath:metadata:error:. NO if the
+ * completion joined the request already in flight.
+ */
+- (BOOL)beginMetadataRequestForPath:(FIRStoragePath *)path
+                         completion:(nullable FIRStorageVoidMetadataError)completion;
+
+/**
+ * Calls every completion registered for @a path with the result of its metadata request, and
+ * caches successfully fetched metadata.
+ */
+- (void)finishMetadataRequestForPath:(FIRStoragePath *)path
+                            metadata:(nullable FIRStorageMetadata *)metadata
+                               error:(nullable NSError *)error;
+
+/**
+ * Discards the metadata cached for @a path, including the result of a request in flight, after
+ * the object at @a path was changed.
+ */
+- (void)invalidateCachedMetadataForPath:(FIRStoragePath *)path;
+
 @end
 
 NS_ASSUME_NONNULL_END
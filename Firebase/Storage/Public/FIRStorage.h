@@ -80,23 +80,82 @@ NS_SWIFT_NAME(Storage)
  */
 @property NSTimeInterval maxUploadRetryTime;
 
+/**
+ * Whether uploads are sent in chunks sized from the measured throughput and round trip time of
+ * the connection instead of in a single request. Smaller chunks lose less progress when a mobile
+ * connection drops, larger ones amortize the round trip between chunks.
+ * Defaults to NO.
+ */
+@property BOOL adaptiveUploadChunking;
+
 /**
  * Maximum time in seconds to retry a download if a failure occurs.
  * Defaults to 10 minutes (600 seconds).
  */
 @property NSTimeInterval maxDownloadRetryTime;
 
+/**
+ * Size in bytes of the ranges that downloads to a file are split into. The ranges are fetched
+ * in parallel and written directly into the destination file, and a paused download resumes
+ * from the ranges that already completed. Downloads into memory are not affected.
+ * Defaults to 0, which downloads each file with a single request.
+ */
+@property int64_t downloadChunkSize;
+
+/**
+ * Maximum number of ranges of a single file download that are fetched at the same time when
+ * downloadChunkSize is set.
+ * Defaults to 4.
+ */
+@property NSUInteger maxConcurrentDownloadChunks;
+
 /**
  * Maximum time in seconds to retry operations other than upload and download if a failure occurs.
  * Defaults to 2 minutes (120 seconds).
  */
 @property NSTimeInterval maxOperationRetryTime;
 
+/**
+ * Time in seconds for which metadata fetched by FIRStorageReference#metadataWithCompletion: and
+ * FIRStorageReference#downloadURLWithCompletion: is reused for later requests for the same
+ * object. Uploads, metadata updates and deletes made through this instance discard the cached
+ * metadata of their object. Concurrent requests for the same object always share one fetch.
+ * Defaults to 0, which disables caching.
+ */
+@property NSTimeInterval metadataCacheTimeout;
+
 /**
  * Queue that all developer callbacks are fired on. Defaults to the main queue.
  */
 @property(strong, nonatomic) dispatch_queue_t callbackQueue;
 
+/**
+ * Limits how many upload and download tasks of a priority run at the same time. Tasks started
+ * beyond the limit wait and start in order as running tasks of the same priority finish.
+ * Must be called on the main queue. Defaults to no limit.
+ * @param maxConcurrentTasks The maximum number of running tasks, at least 1.
+ * @param priority The FIRStorageTaskPriority to limit.
+ */
+- (void)setMaxConcurrentTasks:(NSUInteger)maxConcurrentTasks
+                  forPriority:(FIRStorageTaskPriority)priority
+    NS_SWIFT_NAME(setMaxConcurrentTasks(_:for:));
+
+/**
+ * Pauses the running upload and download tasks of a priority and holds back tasks of that
+ * priority started afterwards, until resumeTasksWithPriority: is called.
+ * Must be called on the main queue.
+ * @param priority The FIRStorageTaskPriority to pause.
+ */
+- (void)pauseTasksWithPriority:(FIRStorageTaskPriority)priority NS_SWIFT_NAME(pauseTasks(with:));
+
+/**
+ * Resumes the tasks paused by pauseTasksWithPriority: and starts the ones held back.
+ * Must be called on the main queue.
+ * @param priority The FIRStorageTaskPriority to resume.
+ */
+- (void)resumeTasksWithPriority:(FIRStorageTaskPriority)priority
+    NS_SWIFT_NAME(resumeTasks(with:));
+
 /**
  * Creates a FIRStorageReference initialized at the root Firebase Storage location.
  * @return An instance of FIRStorageReference initialized at the root.
@@ -109,6 +109,21 @@ typedef NS_ENUM(NSInteger, FIRStorageTaskStatus) {
   FIRStorageTaskStatusFailure
 } NS_SWIFT_NAME(StorageTaskStatus);
 
+/**
+ * Enum representing the priority classes upload and download tasks are scheduled in.
+ */
+typedef NS_ENUM(NSInteger, FIRStorageTaskPriority) {
+  /**
+   * Transfers the user is waiting for, such as images on screen. The default.
+   */
+  FIRStorageTaskPriorityInteractive,
+
+  /**
+   * Bulk transfers that should yield to interactive ones.
+   */
+  FIRStorageTaskPriorityBackground
+} NS_SWIFT_NAME(StorageTaskPriority);
+
 /**
  * Firebase Storage error domain.
  */
@@ -57,6 +57,13 @@ NS_SWIFT_NAME(StorageReference)
  */
 @property(nonatomic, readonly) NSString *name;
 
+/**
+ * The priority that uploads and downloads started from this reference are scheduled with.
+ * References obtained from it through root, parent, and child: inherit it.
+ * Defaults to FIRStorageTaskPriorityInteractive.
+ */
+@property(nonatomic) FIRStorageTaskPriority taskPriority;
+
 #pragma mark - Path Operations
 
 /**
@@ -171,6 +178,44 @@ NS_SWIFT_NAME(putData(_:metadata:));
            NS_SWIFT_NAME(putFile(from:metadata:completion:));
 // clang-format on
 
+/**
+ * Asynchronously uploads the contents of a stream to the currently specified
+ * FIRStorageReference. Bytes are sent as they become available, so the stream can be fed by an
+ * encoder or capture pipeline while it is still producing data. The upload completes once the
+ * stream reaches its end. The stream is opened and read on a background queue, and only the
+ * bytes not yet confirmed by the server are kept in memory.
+ * @param stream An unopened NSInputStream providing the bytes of the object.
+ * @param metadata FIRStorageMetadata containing additional information (MIME type, etc.)
+ * about the object being uploaded.
+ * @return An instance of FIRStorageUploadTask, which can be used to monitor or manage the upload.
+ */
+// clang-format off
+- (FIRStorageUploadTask *)putStream:(NSInputStream *)stream
+                           metadata:(nullable FIRStorageMetadata *)metadata
+             NS_SWIFT_NAME(putStream(_:metadata:));
+// clang-format on
+
+/**
+ * Asynchronously uploads the contents of a stream to the currently specified
+ * FIRStorageReference. Bytes are sent as they become available, so the stream can be fed by an
+ * encoder or capture pipeline while it is still producing data. The upload completes once the
+ * stream reaches its end. The stream is opened and read on a background queue, and only the
+ * bytes not yet confirmed by the server are kept in memory.
+ * @param stream An unopened NSInputStream providing the bytes of the object.
+ * @param metadata FIRStorageMetadata containing additional information (MIME type, etc.)
+ * about the object being uploaded.
+ * @param completion A completion block that either returns the object metadata on success,
+ * or an error on failure.
+ * @return An instance of FIRStorageUploadTask, which can be used to monitor or manage the upload.
+ */
+// clang-format off
+- (FIRStorageUploadTask *)putStream:(NSInputStream *)stream
+                           metadata:(nullable FIRStorageMetadata *)metadata
+                         completion:(nullable void (^)(FIRStorageMetadata *_Nullable metadata,
+                                                       NSError *_Nullable error))completion
+             NS_SWIFT_NAME(putStream(_:metadata:completion:));
+// clang-format on
+
 #pragma mark - Downloads
 
 /**
@@ -190,6 +235,24 @@ NS_SWIFT_NAME(putData(_:metadata:));
                      NS_SWIFT_NAME(getData(maxSize:completion:));
 // clang-format on
 
+/**
+ * Asynchronously downloads the object at the FIRStorageReference and passes its bytes to
+ * @a dataHandler as they arrive, without collecting them in memory. This allows large objects,
+ * such as images, to be decoded incrementally.
+ * @param size The maximum size in bytes to download. If the size announced by the server or the
+ * number of bytes received exceeds it, the task is cancelled and an error is returned.
+ * @param dataHandler A block that is called in order with each chunk of bytes received.
+ * @param completion A completion block that returns nil once all bytes have been passed to
+ * dataHandler, or an error on failure.
+ * @return An FIRStorageDownloadTask that can be used to monitor or manage the download.
+ */
+// clang-format off
+- (FIRStorageDownloadTask *)dataWithMaxSize:(int64_t)size
+                                dataHandler:(void (^)(NSData *data))dataHandler
+                                 completion:(nullable void (^)(NSError *_Nullable error))completion
+                     NS_SWIFT_NAME(getData(maxSize:dataHandler:completion:));
+// clang-format on
+
 /**
  * Asynchronously retrieves a long lived download URL with a revokable token.
  * This can be used to share the file with others, but can be revoked by a developer
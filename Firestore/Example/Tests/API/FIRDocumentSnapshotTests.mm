@@ -54,6 +54,29 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertNotEqual([base hash], [fromCache hash]);
 }
 
+- (void)testDataIsConvertedOnce {
+  FIRDocumentSnapshot *snapshot =
+      FSTTestDocSnapshot(@"rooms/foo", 1, @{ @"a" : @{@"b" : @"c"}, @"d" : @[ @1 ] }, NO, NO);
+  NSDictionary<NSString *, id> *data = [snapshot data];
+  XCTAssertEqualObjects(data, (@{ @"a" : @{@"b" : @"c"}, @"d" : @[ @1 ] }));
+  XCTAssertTrue([snapshot data] == data);
+
+  // Fields are looked up in the converted data.
+  XCTAssertTrue(snapshot[@"a"] == data[@"a"]);
+  XCTAssertEqualObjects(snapshot[@"a.b"], @"c");
+  XCTAssertNil(snapshot[@"a.b.c"]);
+  XCTAssertNil(snapshot[@"d.e"]);
+  XCTAssertNil(snapshot[@"e"]);
+
+  // Each server timestamp behavior gets its own conversion.
+  FIRSnapshotOptions *estimate =
+      [FIRSnapshotOptions serverTimestampBehavior:FIRServerTimestampBehaviorEstimate];
+  NSDictionary<NSString *, id> *estimateData = [snapshot dataWithOptions:estimate];
+  XCTAssertEqualObjects(estimateData, data);
+  XCTAssertTrue([snapshot dataWithOptions:estimate] == estimateData);
+  XCTAssertTrue([snapshot data] == data);
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#import <FirebaseFirestore/FIRDocumentChange.h>
+#import <FirebaseFirestore/FIRDocumentSnapshot.h>
 #import <FirebaseFirestore/FIRQuerySnapshot.h>
 
 #import <XCTest/XCTest.h>
@@ -53,6 +55,25 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertNotEqual([foo hash], [fromCache hash]);
 }
 
+- (void)testDocumentsAreCreatedOnce {
+  FIRQuerySnapshot *snapshot = FSTTestQuerySnapshot(
+      @"foo", @{}, @{ @"a" : @{@"a" : @1}, @"b" : @{@"b" : @2}, @"c" : @{@"c" : @3} }, NO, NO);
+  NSArray<FIRQueryDocumentSnapshot *> *documents = snapshot.documents;
+  XCTAssertEqual(documents.count, 3);
+  XCTAssertEqual(documents[1], documents[1]);
+  XCTAssertEqualObjects(documents[0].documentID, @"a");
+  XCTAssertEqualObjects(documents[2].documentID, @"c");
+  XCTAssertEqualObjects([documents[1] data], @{@"b" : @2});
+  XCTAssertEqualObjects(documents.lastObject.documentID, @"c");
+
+  NSArray<FIRDocumentChange *> *changes = snapshot.documentChanges;
+  XCTAssertEqual(changes.count, 3);
+  XCTAssertEqual(changes[0], changes[0]);
+  XCTAssertEqual(changes[0].type, FIRDocumentChangeTypeAdded);
+  XCTAssertEqual(changes[0].oldIndex, NSNotFound);
+  XCTAssertEqual(changes[0].newIndex, 0);
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
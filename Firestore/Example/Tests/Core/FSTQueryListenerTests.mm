@@ -25,6 +25,7 @@
 #import "Firestore/Source/Remote/FSTRemoteEvent.h"
 #import "Firestore/Source/Util/FSTAsyncQueryListener.h"
 #import "Firestore/Source/Util/FSTDispatchQueue.h"
+#import "Firestore/Source/Util/FSTSnapshotBatcher.h"
 
 #import "Firestore/Example/Tests/Util/FSTHelpers.h"
 
@@ -162,6 +163,70 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqualObjects(accum, @[ viewSnapshot1 ]);
 }
 
+- (void)testBatchesEventsAcrossListeners {
+  NSMutableArray<FSTViewSnapshot *> *accum = [NSMutableArray array];
+  NSMutableArray<FSTViewSnapshot *> *otherAccum = [NSMutableArray array];
+
+  FSTQuery *query = FSTTestQuery(@"rooms");
+  FSTDocument *doc1 = FSTTestDoc(@"rooms/Eros", 1, @{@"name" : @"Eros"}, NO);
+  FSTDocument *doc2 = FSTTestDoc(@"rooms/Hades", 2, @{@"name" : @"Hades"}, NO);
+  FSTDocument *doc2prime =
+      FSTTestDoc(@"rooms/Hades", 3, @{@"name" : @"Hades", @"owner" : @"Jonny"}, NO);
+
+  FSTDispatchQueue *workerQueue = [FSTDispatchQueue
+      queueWith:dispatch_queue_create("FSTQueryListenerTests Worker", DISPATCH_QUEUE_SERIAL)];
+  FSTSnapshotBatcher *batcher =
+      [[FSTSnapshotBatcher alloc] initWithWorkerDispatchQueue:workerQueue
+                                            userDispatchQueue:self.asyncQueue
+                                              minimumInterval:0];
+  FSTAsyncQueryListener *listener =
+      [[FSTAsyncQueryListener alloc] initWithDispatchQueue:self.asyncQueue
+                                                   batcher:batcher
+                                           snapshotHandler:^(FSTViewSnapshot *snapshot,
+                                                             NSError *error) {
+                                             [accum addObject:snapshot];
+                                           }];
+  FSTAsyncQueryListener *otherListener =
+      [[FSTAsyncQueryListener alloc] initWithDispatchQueue:self.asyncQueue
+                                                   batcher:batcher
+                                           snapshotHandler:^(FSTViewSnapshot *snapshot,
+                                                             NSError *error) {
+                                             [otherAccum addObject:snapshot];
+                                           }];
+
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:[FSTDocumentKeySet keySet]];
+  FSTViewSnapshot *snap1 = FSTTestApplyChanges(view, @[ doc1, doc2 ], nil);
+  FSTViewSnapshot *snap2 = FSTTestApplyChanges(view, @[ doc2prime ], nil);
+
+  FSTViewSnapshotHandler handler = listener.asyncSnapshotHandler;
+  FSTViewSnapshotHandler otherHandler = otherListener.asyncSnapshotHandler;
+  [workerQueue dispatchAsync:^{
+    handler(snap1, nil);
+    otherHandler(snap2, nil);
+    handler(snap2, nil);
+  }];
+
+  // Drain the worker queue, which hands the batch to the user queue, and then the user queue.
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Queues drained"];
+  [workerQueue dispatchAsync:^{
+    [self.asyncQueue dispatchAsync:^{
+      [expectation fulfill];
+    }];
+  }];
+  [self waitForExpectationsWithTimeout:4.0 handler:nil];
+
+  // The first listener gets both snapshots as one.
+  FSTDocumentViewChange *change1 =
+      [FSTDocumentViewChange changeWithDocument:doc1 type:FSTDocumentViewChangeTypeAdded];
+  FSTDocumentViewChange *change2 =
+      [FSTDocumentViewChange changeWithDocument:doc2prime type:FSTDocumentViewChangeTypeAdded];
+  XCTAssertEqual(accum.count, 1);
+  XCTAssertEqualObjects(accum[0].documents, snap2.documents);
+  XCTAssertEqualObjects(accum[0].oldDocuments, snap1.oldDocuments);
+  XCTAssertEqualObjects(accum[0].documentChanges, (@[ change1, change2 ]));
+  XCTAssertEqualObjects(otherAccum, @[ snap2 ]);
+}
+
 - (void)testDoesNotRaiseEventsForMetadataChangesUnlessSpecified {
   NSMutableArray<FSTViewSnapshot *> *filteredAccum = [NSMutableArray array];
   NSMutableArray<FSTViewSnapshot *> *fullAccum = [NSMutableArray array];
@@ -250,6 +315,90 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqualObjects(fullAccum[2].documentChanges, (@[ change4 ]));
 }
 
+- (void)testRaisesDocumentDataEventsOnlyWhenSpecified {
+  NSMutableArray<FSTViewSnapshot *> *keysAccum = [NSMutableArray array];
+  NSMutableArray<FSTViewSnapshot *> *fullAccum = [NSMutableArray array];
+
+  FSTQuery *query = FSTTestQuery(@"rooms");
+  FSTDocument *doc1 = FSTTestDoc(@"rooms/Eros", 1, @{@"name" : @"Eros"}, NO);
+  FSTDocument *doc2 = FSTTestDoc(@"rooms/Hades", 2, @{@"name" : @"Hades"}, NO);
+  FSTDocument *doc1Prime = FSTTestDoc(@"rooms/Eros", 3, @{@"name" : @"Eros2"}, NO);
+  FSTDocument *doc3 = FSTTestDoc(@"rooms/Other", 4, @{@"name" : @"Other"}, NO);
+
+  FSTListenOptions *options = [[FSTListenOptions alloc] initWithIncludeQueryMetadataChanges:NO
+                                                             includeDocumentMetadataChanges:NO
+                                                                 includeDocumentDataChanges:NO
+                                                                      waitForSyncWhenOnline:NO];
+
+  FSTQueryListener *keysListener =
+      [self listenToQuery:query options:options accumulatingSnapshots:keysAccum];
+  FSTQueryListener *fullListener = [self listenToQuery:query accumulatingSnapshots:fullAccum];
+
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:[FSTDocumentKeySet keySet]];
+  FSTViewSnapshot *snap1 = FSTTestApplyChanges(view, @[ doc1, doc2 ], nil);
+  FSTViewSnapshot *snap2 = FSTTestApplyChanges(view, @[ doc1Prime ], nil);
+  FSTViewSnapshot *snap3 = FSTTestApplyChanges(view, @[ doc3 ], nil);
+
+  FSTDocumentViewChange *change1 =
+      [FSTDocumentViewChange changeWithDocument:doc1Prime type:FSTDocumentViewChangeTypeModified];
+  FSTDocumentViewChange *change2 =
+      [FSTDocumentViewChange changeWithDocument:doc3 type:FSTDocumentViewChangeTypeAdded];
+
+  [keysListener queryDidChangeViewSnapshot:snap1];
+  [keysListener queryDidChangeViewSnapshot:snap2];
+  [keysListener queryDidChangeViewSnapshot:snap3];
+  [fullListener queryDidChangeViewSnapshot:snap1];
+  [fullListener queryDidChangeViewSnapshot:snap2];
+  [fullListener queryDidChangeViewSnapshot:snap3];
+
+  XCTAssertEqualObjects(keysAccum, (@[ snap1, snap3 ]));
+  XCTAssertEqualObjects(keysAccum[1].documentChanges, (@[ change2 ]));
+
+  XCTAssertEqualObjects(fullAccum, (@[ snap1, snap2, snap3 ]));
+  XCTAssertEqualObjects(fullAccum[1].documentChanges, (@[ change1 ]));
+  XCTAssertEqualObjects(fullAccum[2].documentChanges, (@[ change2 ]));
+}
+
+- (void)testRaisesOnlyDocumentChangesWhenSpecified {
+  NSMutableArray<FSTViewSnapshot *> *accum = [NSMutableArray array];
+
+  FSTQuery *query = FSTTestQuery(@"rooms");
+  FSTDocument *doc1 = FSTTestDoc(@"rooms/Eros", 1, @{@"name" : @"Eros"}, NO);
+  FSTDocument *doc2 = FSTTestDoc(@"rooms/Hades", 2, @{@"name" : @"Hades"}, NO);
+  FSTDocument *doc1Prime = FSTTestDoc(@"rooms/Eros", 3, @{@"name" : @"Eros2"}, NO);
+
+  FSTListenOptions *options = [[FSTListenOptions alloc] initWithIncludeQueryMetadataChanges:NO
+                                                             includeDocumentMetadataChanges:NO
+                                                                 includeDocumentDataChanges:YES
+                                                                      waitForSyncWhenOnline:NO
+                                                                        documentChangesOnly:YES];
+  FSTQueryListener *listener =
+      [self listenToQuery:query options:options accumulatingSnapshots:accum];
+
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:[FSTDocumentKeySet keySet]];
+  FSTViewSnapshot *snap1 = FSTTestApplyChanges(view, @[ doc1, doc2 ], nil);
+  FSTViewSnapshot *snap2 = FSTTestApplyChanges(view, @[ doc1Prime ], nil);
+
+  FSTDocumentViewChange *change1 =
+      [FSTDocumentViewChange changeWithDocument:doc1 type:FSTDocumentViewChangeTypeAdded];
+  FSTDocumentViewChange *change2 =
+      [FSTDocumentViewChange changeWithDocument:doc2 type:FSTDocumentViewChangeTypeAdded];
+  FSTDocumentViewChange *change3 =
+      [FSTDocumentViewChange changeWithDocument:doc1Prime type:FSTDocumentViewChangeTypeModified];
+
+  [listener queryDidChangeViewSnapshot:snap1];
+  [listener queryDidChangeViewSnapshot:snap2];
+
+  XCTAssertEqual(accum.count, 2);
+  XCTAssertEqualObjects(accum[0].documentChanges, (@[ change1, change2 ]));
+  XCTAssertEqualObjects(accum[1].documentChanges, (@[ change3 ]));
+  for (FSTViewSnapshot *snapshot in accum) {
+    XCTAssertTrue(snapshot.documents.isEmpty);
+    XCTAssertTrue(snapshot.oldDocuments.isEmpty);
+    XCTAssertEqual(snapshot.fromCache, snap2.fromCache);
+  }
+}
+
 - (void)testRaisesQueryMetadataEventsOnlyWhenHasPendingWritesOnTheQueryChanges {
   NSMutableArray<FSTViewSnapshot *> *fullAccum = [NSMutableArray array];
 
@@ -298,6 +298,30 @@ NS_ASSUME_NONNULL_BEGIN
   }];
 }
 
+- (void)testMatchesFiltersSharingAFieldPrefix {
+  FSTQuery *query = [[[[FSTTestQuery(@"collection")
+      queryByAddingFilter:FSTTestFilter(@"a.n", @">", @1)]
+      queryByAddingFilter:FSTTestFilter(@"a.n", @"<", @5)]
+      queryByAddingFilter:FSTTestFilter(@"a.s", @"==", @"x")]
+      queryByAddingSortOrder:[FSTSortOrder sortOrderWithFieldPath:FSTTestFieldPath(@"a.n")
+                                                        ascending:YES]];
+
+  FSTDocument *doc1 = FSTTestDoc(@"collection/1", 0, @{ @"a" : @{@"n" : @2, @"s" : @"x"} }, NO);
+  FSTDocument *doc2 = FSTTestDoc(@"collection/2", 0, @{ @"a" : @{@"n" : @5, @"s" : @"x"} }, NO);
+  FSTDocument *doc3 = FSTTestDoc(@"collection/3", 0, @{ @"a" : @{@"n" : @2, @"s" : @"y"} }, NO);
+  FSTDocument *doc4 = FSTTestDoc(@"collection/4", 0, @{ @"a" : @{@"s" : @"x"} }, NO);
+  FSTDocument *doc5 = FSTTestDoc(@"collection/5", 0, @{ @"a" : @2 }, NO);
+
+  // Evaluate twice so that the second pass reuses the compiled filters.
+  for (int i = 0; i < 2; i++) {
+    XCTAssertTrue([query matchesDocument:doc1]);
+    XCTAssertFalse([query matchesDocument:doc2]);
+    XCTAssertFalse([query matchesDocument:doc3]);
+    XCTAssertFalse([query matchesDocument:doc4]);
+    XCTAssertFalse([query matchesDocument:doc5]);
+  }
+}
+
 - (void)testSortsDocumentsInTheCorrectOrder {
   FSTQuery *query = FSTTestQuery(@"collection");
   query =
@@ -446,6 +470,19 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertNotEqualObjects(q51, q61);
 }
 
+- (void)testFingerprints {
+  FSTQuery *q1 = [FSTTestQuery(@"foo") queryByAddingFilter:FSTTestFilter(@"i1", @"<", @(2))];
+  FSTQuery *q2 = [FSTTestQuery(@"foo") queryByAddingFilter:FSTTestFilter(@"i1", @"<", @(2))];
+  FSTQuery *q3 = [FSTTestQuery(@"foo") queryByAddingFilter:FSTTestFilter(@"i1", @"<", @(3))];
+  FSTQuery *q4 = [FSTTestQuery(@"foo") queryBySettingLimit:10];
+
+  XCTAssertEqual(q1.fingerprint, q2.fingerprint);
+  XCTAssertEqual(q1.hash, q2.hash);
+  XCTAssertNotEqual(q1.fingerprint, q3.fingerprint);
+  XCTAssertNotEqual(q1.fingerprint, q4.fingerprint);
+  XCTAssertNotEqual(FSTTestQuery(@"foo").fingerprint, q4.fingerprint);
+}
+
 - (void)testUniqueIds {
   FSTQuery *q11 = FSTTestQuery(@"foo");
   q11 = [q11 queryByAddingFilter:FSTTestFilter(@"i1", @"<", @(2))];
@@ -393,9 +393,9 @@ NS_ASSUME_NONNULL_BEGIN
   FSTDocument *doc3 = FSTTestDoc(@"rooms/eros/messages/2", 0, @{ @"order" : @3 }, NO);
   FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:[FSTDocumentKeySet keySet]];
 
-  // Start with a full view.
+  // Start with a full view that doesn't know about doc3.
   FSTViewDocumentChanges *changes =
-      [view computeChangesWithDocuments:FSTTestDocUpdates(@[ doc1, doc2, doc3 ])];
+      [view computeChangesWithDocuments:FSTTestDocUpdates(@[ doc1, doc2 ])];
   [self assertDocSet:changes.documentSet containsDocs:@[ doc1, doc2 ]];
   XCTAssertFalse(changes.needsRefill);
   XCTAssertEqual(2, [changes.changeSet changes].count);
@@ -416,6 +416,40 @@ NS_ASSUME_NONNULL_BEGIN
   [view applyChangesToDocuments:changes];
 }
 
+- (void)testFillsLimitFromDocumentsPastTheLimit {
+  FSTQuery *query = [[self queryForMessages] queryBySettingLimit:2];
+  FSTDocument *doc1 = FSTTestDoc(@"rooms/eros/messages/0", 0, @{}, NO);
+  FSTDocument *doc2 = FSTTestDoc(@"rooms/eros/messages/1", 0, @{}, NO);
+  FSTDocument *doc3 = FSTTestDoc(@"rooms/eros/messages/2", 0, @{}, NO);
+  FSTDocument *doc4 = FSTTestDoc(@"rooms/eros/messages/3", 0, @{}, NO);
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:[FSTDocumentKeySet keySet]];
+
+  // Start with a full view.
+  FSTViewDocumentChanges *changes =
+      [view computeChangesWithDocuments:FSTTestDocUpdates(@[ doc1, doc2, doc3, doc4 ])];
+  [self assertDocSet:changes.documentSet containsDocs:@[ doc1, doc2 ]];
+  XCTAssertFalse(changes.needsRefill);
+  [view applyChangesToDocuments:changes];
+
+  // Remove one of the docs. The view already knows which doc comes next.
+  changes = [view computeChangesWithDocuments:FSTTestDocUpdates(@[ FSTTestDeletedDoc(
+                                                  @"rooms/eros/messages/0", 0) ])];
+  [self assertDocSet:changes.documentSet containsDocs:@[ doc2, doc3 ]];
+  XCTAssertFalse(changes.needsRefill);
+  XCTAssertEqual(2, [changes.changeSet changes].count);
+  [view applyChangesToDocuments:changes];
+
+  // Remove more docs than the view knows replacements for.
+  changes = [view computeChangesWithDocuments:FSTTestDocUpdates(@[
+    FSTTestDeletedDoc(@"rooms/eros/messages/1", 0), FSTTestDeletedDoc(@"rooms/eros/messages/2", 0)
+  ])];
+  XCTAssertTrue(changes.needsRefill);
+  changes = [view computeChangesWithDocuments:FSTTestDocUpdates(@[ doc4 ]) previousChanges:changes];
+  [self assertDocSet:changes.documentSet containsDocs:@[ doc4 ]];
+  XCTAssertFalse(changes.needsRefill);
+  [view applyChangesToDocuments:changes];
+}
+
 - (void)testDoesntNeedRefillOnReorderWithinLimit {
   FSTQuery *query = [self queryForMessages];
   query =
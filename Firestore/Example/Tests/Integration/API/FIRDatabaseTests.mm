@@ -90,6 +90,27 @@
   XCTAssertNil(result[@"foo"]);
 }
 
+- (void)testCanGetSeveralDocumentsAtOnce {
+  FIRCollectionReference *rooms = [self.db collectionWithPath:@"rooms"];
+  FIRDocumentReference *written = [rooms documentWithAutoID];
+  FIRDocumentReference *missing = [rooms documentWithAutoID];
+  [self writeDocumentRef:written data:@{ @"value" : @"foo" }];
+
+  XCTestExpectation *getCompletion = [self expectationWithDescription:@"getDocuments"];
+  [self.db getDocuments:@[ missing, written ]
+             completion:^(NSArray<FIRDocumentSnapshot *> *_Nullable snapshots,
+                          NSError *_Nullable error) {
+               XCTAssertNil(error);
+               XCTAssertEqual(snapshots.count, 2);
+               XCTAssertEqualObjects(snapshots[0].reference, missing);
+               XCTAssertFalse(snapshots[0].exists);
+               XCTAssertEqualObjects(snapshots[1].reference, written);
+               XCTAssertEqualObjects(snapshots[1].data, (@{ @"value" : @"foo" }));
+               [getCompletion fulfill];
+             }];
+  [self awaitExpectations];
+}
+
 - (void)testCannotUpdateNonexistentDocument {
   FIRDocumentReference *doc = [[self.db collectionWithPath:@"rooms"] documentWithAutoID];
 
@@ -939,6 +960,26 @@
   [self readSnapshotForRef:[self documentRef] requireOnline:YES];
 }
 
+- (void)testCanGetCacheSizes {
+  FIRDocumentReference *doc = [self documentRef];
+  FIRFirestore *firestore = doc.firestore;
+  [self writeDocumentRef:doc data:@{@"foo" : @"bar"}];
+
+  XCTestExpectation *sizesReported = [self expectationWithDescription:@"getCacheSizes"];
+  [firestore getCacheSizesWithCompletion:^(NSDictionary<NSString *, NSNumber *> *sizes) {
+    NSArray<NSString *> *tables = @[
+      FIRFirestoreCacheTableRemoteDocuments, FIRFirestoreCacheTableMutations,
+      FIRFirestoreCacheTableTargets, FIRFirestoreCacheTableTargetDocuments
+    ];
+    XCTAssertEqualObjects([NSSet setWithArray:sizes.allKeys], [NSSet setWithArray:tables]);
+    for (NSString *table in tables) {
+      XCTAssertGreaterThanOrEqual([sizes[table] longLongValue], 0);
+    }
+    [sizesReported fulfill];
+  }];
+  [self awaitExpectations];
+}
+
 - (void)testCanDisableNetwork {
   FIRDocumentReference *doc = [self documentRef];
   FIRFirestore *firestore = doc.firestore;
@@ -46,6 +46,55 @@
                    "(which is the main queue, returned from dispatch_get_main_queue())");
 }
 
+- (void)testNonPositivePersistenceCacheSizeFails {
+  FIRFirestoreSettings *settings = self.db.settings;
+  FSTAssertThrows(settings.persistenceCacheSizeBytes = 0,
+                  @"persistenceCacheSizeBytes setting must be positive. You should generally just "
+                   "use the default value (which is 4194304)");
+}
+
+- (void)testNonPositivePersistenceWriteBufferSizeFails {
+  FIRFirestoreSettings *settings = self.db.settings;
+  FSTAssertThrows(settings.persistenceWriteBufferSizeBytes = -1,
+                  @"persistenceWriteBufferSizeBytes setting must be positive. You should generally "
+                   "just use the default value (which is 2097152)");
+}
+
+- (void)testNonPositivePersistenceGarbageCollectionThresholdFails {
+  FIRFirestoreSettings *settings = self.db.settings;
+  FSTAssertThrows(settings.persistenceGarbageCollectionThresholdBytes = 0,
+                  @"persistenceGarbageCollectionThresholdBytes setting must be positive. You "
+                   "should generally just use the default value (which is 104857600)");
+}
+
+- (void)testNegativeMemoryGarbageCollectionThresholdFails {
+  FIRFirestoreSettings *settings = self.db.settings;
+  FSTAssertThrows(settings.memoryGarbageCollectionThresholdDocuments = -1,
+                  @"memoryGarbageCollectionThresholdDocuments setting must not be negative. Use 0 "
+                   "to remove cached documents as soon as no query needs them");
+}
+
+- (void)testNegativeSnapshotBatchingIntervalFails {
+  FIRFirestoreSettings *settings = self.db.settings;
+  FSTAssertThrows(settings.snapshotBatchingInterval = -1,
+                  @"snapshotBatchingInterval setting must not be negative. Use 0 to deliver "
+                   "batched events as soon as possible");
+}
+
+- (void)testNegativeSyncCoalescingIntervalFails {
+  FIRFirestoreSettings *settings = self.db.settings;
+  FSTAssertThrows(settings.syncCoalescingInterval = -1,
+                  @"syncCoalescingInterval setting must not be negative. Use 0 to apply updates "
+                   "from the backend as soon as they arrive");
+}
+
+- (void)testNonPositiveStreamIdleTimeoutFails {
+  FIRFirestoreSettings *settings = self.db.settings;
+  FSTAssertThrows(settings.streamIdleTimeout = 0,
+                  @"streamIdleTimeout setting must be positive. You should generally just use the "
+                   "default value (which is 60 seconds)");
+}
+
 - (void)testChangingSettingsAfterUseFails {
   FIRFirestoreSettings *settings = self.db.settings;
   [[self.db documentWithPath:@"foo/bar"] setData:@{ @"a" : @42 }];
@@ -333,4 +333,29 @@
   [self awaitExpectations];
 }
 
+- (void)testBulkWriterCommitsWritesInSeveralBatches {
+  FIRCollectionReference *collection = [self collectionRef];
+  FIRBulkWriter *writer = [collection.firestore bulkWriter];
+  int writeCount = 1200;
+  __block int completedWrites = 0;
+  for (int i = 0; i < writeCount; i++) {
+    [writer setData:@{@"i" : @(i)}
+        forDocument:[collection documentWithAutoID]
+         completion:^(NSError *_Nullable error) {
+           XCTAssertNil(error);
+           completedWrites++;
+         }];
+  }
+
+  XCTestExpectation *expectation = [self expectationWithDescription:@"bulk writer closed"];
+  [writer closeWithCompletion:^{
+    XCTAssertEqual(completedWrites, writeCount);
+    [expectation fulfill];
+  }];
+  [self awaitExpectations];
+
+  FIRQuerySnapshot *snapshot = [self readDocumentSetForRef:collection];
+  XCTAssertEqual(snapshot.count, writeCount);
+}
+
 @end
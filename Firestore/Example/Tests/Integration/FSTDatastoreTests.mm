@@ -28,8 +28,10 @@
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Core/FSTSnapshotVersion.h"
 #import "Firestore/Source/Core/FSTTimestamp.h"
+#import "Firestore/Source/Core/FSTTransaction.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
 #import "Firestore/Source/Model/FSTDatabaseID.h"
+#import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTDocumentKey.h"
 #import "Firestore/Source/Model/FSTFieldValue.h"
 #import "Firestore/Source/Model/FSTMutation.h"
@@ -102,11 +104,13 @@ NS_ASSUME_NONNULL_BEGIN
                                                                     description]]];
 }
 
-- (void)applySuccessfulWriteWithResult:(FSTMutationBatchResult *)batchResult {
-  [self.writeEvents addObject:batchResult];
-  XCTestExpectation *expectation = [self.writeEventExpectations objectAtIndex:0];
-  [self.writeEventExpectations removeObjectAtIndex:0];
-  [expectation fulfill];
+- (void)applySuccessfulWritesWithResults:(NSArray<FSTMutationBatchResult *> *)batchResults {
+  for (FSTMutationBatchResult *batchResult in batchResults) {
+    [self.writeEvents addObject:batchResult];
+    XCTestExpectation *expectation = [self.writeEventExpectations objectAtIndex:0];
+    [self.writeEventExpectations removeObjectAtIndex:0];
+    [expectation fulfill];
+  }
 }
 
 - (void)rejectFailedWriteWithBatchID:(FSTBatchID)batchID error:(NSError *)error {
@@ -126,6 +130,23 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+#pragma mark - FSTLookupCountingDatastore
+
+/** An FSTDatastore that counts the BatchGetDocuments calls it makes. */
+@interface FSTLookupCountingDatastore : FSTDatastore
+@property(nonatomic, assign) int lookupCount;
+@end
+
+@implementation FSTLookupCountingDatastore
+
+- (void)lookupDocuments:(NSArray<FSTDocumentKey *> *)keys
+             completion:(FSTVoidMaybeDocumentArrayErrorBlock)completion {
+  self.lookupCount++;
+  [super lookupDocuments:keys completion:completion];
+}
+
+@end
+
 #pragma mark - FSTDatastoreTests
 
 @interface FSTDatastoreTests : XCTestCase
@@ -137,6 +158,7 @@ NS_ASSUME_NONNULL_BEGIN
   FSTLocalStore *_localStore;
   id<FSTCredentialsProvider> _credentials;
 
+  FSTDatabaseInfo *_databaseInfo;
   FSTDatastore *_datastore;
   FSTRemoteStore *_remoteStore;
 }
@@ -157,10 +179,10 @@ NS_ASSUME_NONNULL_BEGIN
   FSTDatabaseID *databaseID =
       [FSTDatabaseID databaseIDWithProject:projectID database:kDefaultDatabaseID];
 
-  FSTDatabaseInfo *databaseInfo = [FSTDatabaseInfo databaseInfoWithDatabaseID:databaseID
-                                                               persistenceKey:@"test-key"
-                                                                         host:settings.host
-                                                                   sslEnabled:settings.sslEnabled];
+  _databaseInfo = [FSTDatabaseInfo databaseInfoWithDatabaseID:databaseID
+                                               persistenceKey:@"test-key"
+                                                         host:settings.host
+                                                   sslEnabled:settings.sslEnabled];
 
   _testWorkerQueue = [FSTDispatchQueue
       queueWith:dispatch_queue_create("com.google.firestore.FSTDatastoreTestsWorkerQueue",
@@ -168,7 +190,7 @@ NS_ASSUME_NONNULL_BEGIN
 
   _credentials = [[FSTEmptyCredentialsProvider alloc] init];
 
-  _datastore = [FSTDatastore datastoreWithDatabase:databaseInfo
+  _datastore = [FSTDatastore datastoreWithDatabase:_databaseInfo
                                workerDispatchQueue:_testWorkerQueue
                                        credentials:_credentials];
 
@@ -219,6 +241,52 @@ NS_ASSUME_NONNULL_BEGIN
   [self awaitExpectations];
 }
 
+- (void)testTransactionBatchesBackToBackLookups {
+  FSTLookupCountingDatastore *datastore =
+      [[FSTLookupCountingDatastore alloc] initWithDatabaseInfo:_databaseInfo
+                                           workerDispatchQueue:_testWorkerQueue
+                                                   credentials:_credentials];
+  FSTTransaction *transaction = [FSTTransaction transactionWithDatastore:datastore];
+  FSTDocumentKey *eros = [FSTDocumentKey keyWithPathString:@"rooms/eros"];
+  FSTDocumentKey *other = [FSTDocumentKey keyWithPathString:@"rooms/other"];
+
+  XCTestExpectation *firstLookup = [self expectationWithDescription:@"first lookup"];
+  XCTestExpectation *secondLookup = [self expectationWithDescription:@"second lookup"];
+  // Both lookups are made before the worker queue gets to send them.
+  [_testWorkerQueue dispatchAsync:^{
+    [transaction lookupDocumentsForKeys:@[ eros ]
+                             completion:^(NSArray<FSTMaybeDocument *> *_Nullable documents,
+                                          NSError *_Nullable error) {
+                               XCTAssertNil(error);
+                               XCTAssertEqualObjects(documents.firstObject.key, eros);
+                               [firstLookup fulfill];
+                             }];
+    [transaction lookupDocumentsForKeys:@[ other, eros ]
+                             completion:^(NSArray<FSTMaybeDocument *> *_Nullable documents,
+                                          NSError *_Nullable error) {
+                               XCTAssertNil(error);
+                               XCTAssertEqual(documents.count, 2);
+                               [secondLookup fulfill];
+                             }];
+  }];
+  [self awaitExpectations];
+  XCTAssertEqual(datastore.lookupCount, 1);
+
+  // Documents read already are answered by the transaction itself.
+  XCTestExpectation *reread = [self expectationWithDescription:@"re-read"];
+  [_testWorkerQueue dispatchAsync:^{
+    [transaction lookupDocumentsForKeys:@[ eros ]
+                             completion:^(NSArray<FSTMaybeDocument *> *_Nullable documents,
+                                          NSError *_Nullable error) {
+                               XCTAssertNil(error);
+                               XCTAssertEqualObjects(documents.firstObject.key, eros);
+                               [reread fulfill];
+                             }];
+  }];
+  [self awaitExpectations];
+  XCTAssertEqual(datastore.lookupCount, 1);
+}
+
 - (void)awaitExpectations {
   [self waitForExpectationsWithTimeout:4.0
                                handler:^(NSError *_Nullable expectationError) {
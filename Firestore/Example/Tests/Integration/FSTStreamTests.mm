@@ -86,6 +86,12 @@
   _expectation = nil;
 }
 
+- (void)writeStreamDidDrain {
+  [_states addObject:@"writeStreamDidDrain"];
+  [_expectation fulfill];
+  _expectation = nil;
+}
+
 - (void)watchStreamWasInterruptedWithError:(nullable NSError *)error {
   [_states addObject:@"watchStreamWasInterrupted"];
   [_expectation fulfill];
@@ -309,4 +315,42 @@
   ]];
 }
 
+- (void)testDelayedCallbacksCanBeCancelledRescheduledAndCoalesced {
+  NSMutableArray<NSString *> *ran = [NSMutableArray array];
+  XCTestExpectation *expectation = [self expectationWithDescription:@"last callback"];
+
+  FSTDelayedCallback *cancelled = [_workerDispatchQueue dispatchAfterDelay:0.1
+                                                                     block:^{
+                                                                       [ran addObject:@"cancelled"];
+                                                                     }];
+  FSTDelayedCallback *rescheduled =
+      [_workerDispatchQueue dispatchAfterDelay:0.1
+                                         block:^{
+                                           [ran addObject:@"rescheduled"];
+                                           [expectation fulfill];
+                                         }];
+  FSTDelayedCallback *coalesced = [_workerDispatchQueue dispatchAfterDelay:0.2
+                                                             coalescingTag:@"tag"
+                                                                     block:^{
+                                                                       [ran addObject:@"first"];
+                                                                     }];
+  FSTDelayedCallback *duplicate = [_workerDispatchQueue dispatchAfterDelay:0.2
+                                                             coalescingTag:@"tag"
+                                                                     block:^{
+                                                                       [ran addObject:@"second"];
+                                                                     }];
+  XCTAssertEqual(coalesced, duplicate);
+
+  [cancelled cancel];
+  XCTAssertFalse(cancelled.isPending);
+  [rescheduled rescheduleAfterDelay:0.5];
+  XCTAssertTrue(rescheduled.isPending);
+
+  [self awaitExpectations];
+  dispatch_sync(_testQueue, ^{
+    XCTAssertEqualObjects(ran, (@[ @"first", @"rescheduled" ]));
+  });
+  XCTAssertFalse(rescheduled.isPending);
+}
+
 @end
@@ -383,38 +383,78 @@
   FIRFirestore *firestore = [self firestore];
   FIRDocumentReference *doc = [[firestore collectionWithPath:@"counters"] documentWithAutoID];
   [self writeDocumentRef:doc data:@{ @"count" : @(15.0) }];
+  __block volatile int32_t attempts = 0;
   XCTestExpectation *expectation = [self expectationWithDescription:@"transaction"];
   [firestore runTransactionWithBlock:^id _Nullable(FIRTransaction *transaction, NSError **error) {
+    int32_t attempt = OSAtomicIncrement32(&attempts);
     // Get the doc once.
     FIRDocumentSnapshot *snapshot = [transaction getDocument:doc error:error];
     XCTAssertNil(*error);
-    XCTAssertEqualObjects(@(15), snapshot[@"count"]);
-    // Do a write outside of the transaction.
-    dispatch_semaphore_t writeSemaphore = dispatch_semaphore_create(0);
-    [doc setData:@{
-      @"count" : @(1234)
+    NSNumber *count = snapshot[@"count"];
+    if (attempt == 1) {
+      XCTAssertEqualObjects(@(15), count);
+      // Do a write outside of the transaction.
+      dispatch_semaphore_t writeSemaphore = dispatch_semaphore_create(0);
+      [doc setData:@{
+        @"count" : @(1234)
+      }
+          completion:^(NSError *_Nullable error) {
+            dispatch_semaphore_signal(writeSemaphore);
+          }];
+      // We can block on it, because transactions run on a background queue.
+      dispatch_semaphore_wait(writeSemaphore, DISPATCH_TIME_FOREVER);
     }
-        completion:^(NSError *_Nullable error) {
-          dispatch_semaphore_signal(writeSemaphore);
-        }];
-    // We can block on it, because transactions run on a background queue.
-    dispatch_semaphore_wait(writeSemaphore, DISPATCH_TIME_FOREVER);
-    // Get the doc again in the transaction with the new version.
+    // Get the doc again in the transaction. It's answered with the version read first, which the
+    // precondition of the commit is based on.
     snapshot = [transaction getDocument:doc error:error];
-    // The get itself will fail, because we already read an earlier version of this document.
-    // TODO(klimt): Perhaps we shouldn't fail reads for this, but should wait and fail the
-    // whole transaction? It's an edge-case anyway, as developers shouldn't be reading the same
-    // do multiple times. But they need to handle read errors anyway.
-    XCTAssertNotNil(*error);
+    XCTAssertNil(*error);
+    XCTAssertEqualObjects(count, snapshot[@"count"]);
+    [transaction setData:@{ @"count" : @(count.doubleValue + 1) } forDocument:doc];
     return nil;
   }
       completion:^(id _Nullable result, NSError *_Nullable error) {
+        XCTAssertNil(error);
         [expectation fulfill];
       }];
   [self awaitExpectations];
 
+  // The outside write fails the first commit, and the retry reads the new version.
+  XCTAssertEqual(2, (int)attempts);
   FIRDocumentSnapshot *snapshot = [self readDocumentForRef:doc];
-  XCTAssertEqualObjects(@(1234.0), snapshot[@"count"]);
+  XCTAssertEqualObjects(@(1235.0), snapshot[@"count"]);
+}
+
+- (void)testRetriesAreDelayed {
+  FIRFirestore *firestore = [self firestore];
+  FIRDocumentReference *doc = [[firestore collectionWithPath:@"counters"] documentWithAutoID];
+  NSMutableArray<NSDate *> *attemptDates = [NSMutableArray array];
+  XCTestExpectation *expectation = [self expectationWithDescription:@"transaction"];
+  [firestore runTransactionWithBlock:^id _Nullable(FIRTransaction *transaction, NSError **error) {
+    @synchronized(attemptDates) {
+      [attemptDates addObject:[NSDate date]];
+    }
+    // Reading a document without writing it fails the commit, so every attempt is retried.
+    [transaction getDocument:doc error:error];
+    return nil;
+  }
+      completion:^(id _Nullable result, NSError *_Nullable error) {
+        XCTAssertNotNil(error);
+        XCTAssertEqual(FIRFirestoreErrorCodeFailedPrecondition, error.code);
+        [expectation fulfill];
+      }];
+  [self awaitExpectations];
+
+  @synchronized(attemptDates) {
+    XCTAssertEqual(6, (int)attemptDates.count);
+    // The first retry runs right away, and later ones wait at least half of a base delay that
+    // starts at 0.1s and grows by 1.5x with each retry.
+    NSTimeInterval minimumDelay = 0.05;
+    for (NSUInteger i = 2; i < attemptDates.count; i++) {
+      XCTAssertGreaterThanOrEqual([attemptDates[i] timeIntervalSinceDate:attemptDates[i - 1]],
+                                  minimumDelay);
+      minimumDelay *= 1.5;
+    }
+  }
 }
 
 // We currently require every document read to also be written.
@@ -67,6 +67,30 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertTrue([referenceSet isEmpty]);
 }
 
+- (void)testCollectGarbageWithTimeLimit {
+  FSTEagerGarbageCollector *gc = [[FSTEagerGarbageCollector alloc] init];
+  FSTReferenceSet *referenceSet = [[FSTReferenceSet alloc] init];
+  [gc addGarbageSource:referenceSet];
+
+  FSTDocumentKey *key1 = FSTTestDocKey(@"foo/bar");
+  FSTDocumentKey *key2 = FSTTestDocKey(@"foo/baz");
+  [referenceSet addReferenceToKey:key1 forID:1];
+  [referenceSet addReferenceToKey:key2 forID:1];
+  [referenceSet removeReferencesForID:1];
+  XCTAssertTrue(gc.hasPotentialGarbage);
+
+  // Without any time to spare, each call still checks one key.
+  NSMutableSet<FSTDocumentKey *> *garbage = [NSMutableSet set];
+  [garbage unionSet:[gc collectGarbageWithTimeLimit:0]];
+  XCTAssertEqual(garbage.count, 1);
+  XCTAssertTrue(gc.hasPotentialGarbage);
+
+  [garbage unionSet:[gc collectGarbageWithTimeLimit:0]];
+  FSTAssertEqualSets(garbage, (@[ key1, key2 ]));
+  XCTAssertFalse(gc.hasPotentialGarbage);
+  FSTAssertEqualSets([gc collectGarbageWithTimeLimit:0], @[]);
+}
+
 - (void)testTwoReferenceSetsAtTheSameTime {
   FSTReferenceSet *remoteTargets = [[FSTReferenceSet alloc] init];
   FSTReferenceSet *localViews = [[FSTReferenceSet alloc] init];
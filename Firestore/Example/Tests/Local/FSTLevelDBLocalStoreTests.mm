@@ -19,10 +19,17 @@
 #import <XCTest/XCTest.h>
 
 #import "Firestore/Source/Auth/FSTUser.h"
+#import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Local/FSTEagerGarbageCollector.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
+#import "Firestore/Source/Local/FSTLocalWriteResult.h"
+#import "Firestore/Source/Local/FSTQueryData.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTMutation.h"
 
 #import "Firestore/Example/Tests/Local/FSTLocalStoreTests.h"
 #import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
+#import "Firestore/Example/Tests/Util/FSTHelpers.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -42,4 +49,156 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+/**
+ * Measures the latency of the main FSTLocalStore operations against a LevelDB populated with a
+ * configurable workload, and attaches the distributions to the test results as JSON. It only runs
+ * when the FIRESTORE_BENCHMARK environment variable is set, and is configured with:
+ *
+ *   FIRESTORE_BENCHMARK_DOCUMENTS: documents in the remote document cache (default 1000).
+ *   FIRESTORE_BENCHMARK_MUTATIONS: pending mutations in the mutation queue (default 100).
+ *   FIRESTORE_BENCHMARK_TARGETS: queries the documents are spread across (default 10).
+ *   FIRESTORE_BENCHMARK_ITERATIONS: samples taken of each operation (default 100).
+ *   FIRESTORE_BENCHMARK_OUTPUT: a file to write the results to, instead of attaching them.
+ */
+@interface FSTLevelDBLocalStoreBenchmarks : XCTestCase
+@end
+
+@implementation FSTLevelDBLocalStoreBenchmarks {
+  NSDictionary<NSString *, NSString *> *_environment;
+}
+
+- (void)setUp {
+  [super setUp];
+  _environment = [[NSProcessInfo processInfo] environment];
+}
+
+- (NSUInteger)parameter:(NSString *)name defaultValue:(NSUInteger)defaultValue {
+  NSString *value = _environment[[@"FIRESTORE_BENCHMARK_" stringByAppendingString:name]];
+  return value ? (NSUInteger)[value integerValue] : defaultValue;
+}
+
+/** Returns the minimum, maximum, mean and percentiles of the given samples, in milliseconds. */
+- (NSDictionary<NSString *, NSNumber *> *)summaryOfSamples:(NSArray<NSNumber *> *)samples {
+  NSArray<NSNumber *> *sorted = [samples sortedArrayUsingSelector:@selector(compare:)];
+  double total = 0;
+  for (NSNumber *sample in sorted) {
+    total += sample.doubleValue;
+  }
+  NSNumber * (^percentile)(double) = ^(double p) {
+    NSUInteger index = MIN(sorted.count - 1, (NSUInteger)(p * sorted.count));
+    return @(sorted[index].doubleValue * 1000);
+  };
+  return @{
+    @"count" : @(sorted.count),
+    @"min_ms" : @(sorted.firstObject.doubleValue * 1000),
+    @"mean_ms" : @(total / sorted.count * 1000),
+    @"p50_ms" : percentile(0.5),
+    @"p90_ms" : percentile(0.9),
+    @"p99_ms" : percentile(0.99),
+    @"max_ms" : @(sorted.lastObject.doubleValue * 1000),
+  };
+}
+
+- (void)testLocalStoreLatencies {
+  if (!_environment[@"FIRESTORE_BENCHMARK"]) return;
+
+  NSUInteger documents = MAX([self parameter:@"DOCUMENTS" defaultValue:1000], 1u);
+  NSUInteger mutations = [self parameter:@"MUTATIONS" defaultValue:100];
+  NSUInteger targets = MAX([self parameter:@"TARGETS" defaultValue:10], 1u);
+  NSUInteger iterations = MAX([self parameter:@"ITERATIONS" defaultValue:100], 1u);
+
+  FSTLevelDB *persistence = [FSTPersistenceTestHelpers levelDBPersistence];
+  FSTLocalStore *localStore =
+      [[FSTLocalStore alloc] initWithPersistence:persistence
+                                garbageCollector:[[FSTEagerGarbageCollector alloc] init]
+                                     initialUser:[FSTUser unauthenticatedUser]];
+  [localStore start];
+
+  // Spread the documents evenly across one collection per target, each listened to.
+  NSMutableArray<FSTQuery *> *queries = [NSMutableArray array];
+  NSMutableArray<NSNumber *> *targetIDs = [NSMutableArray array];
+  for (NSUInteger i = 0; i < targets; i++) {
+    FSTQuery *query = FSTTestQuery([NSString stringWithFormat:@"coll%lu", (unsigned long)i]);
+    [queries addObject:query];
+    [targetIDs addObject:@([localStore allocateQuery:query].targetID)];
+  }
+  NSString * (^documentPath)(NSUInteger) = ^(NSUInteger i) {
+    return [NSString
+        stringWithFormat:@"coll%lu/doc%lu", (unsigned long)(i % targets), (unsigned long)i];
+  };
+  for (NSUInteger i = 0; i < documents; i++) {
+    FSTDocument *doc = FSTTestDoc(documentPath(i), 1, @{ @"index" : @(i) }, NO);
+    [localStore applyRemoteEvent:FSTTestUpdateRemoteEvent(doc, @[ targetIDs[i % targets] ], @[])];
+  }
+  for (NSUInteger i = 0; i < mutations; i++) {
+    [localStore locallyWriteMutations:@[ FSTTestPatchMutation(documentPath(i % documents),
+                                                              @{ @"pending" : @YES }, nil) ]];
+  }
+
+  NSDictionary<NSString *, NSMutableArray<NSNumber *> *> *samples = @{
+    @"executeQuery" : [NSMutableArray array],
+    @"applyRemoteEvent" : [NSMutableArray array],
+    @"locallyWriteMutations" : [NSMutableArray array],
+    @"collectGarbage" : [NSMutableArray array],
+  };
+  for (NSUInteger i = 0; i < iterations; i++) {
+    NSDate *start = [NSDate date];
+    [localStore executeQuery:queries[i % targets]];
+    [samples[@"executeQuery"] addObject:@(-[start timeIntervalSinceNow])];
+
+    NSUInteger index = i % documents;
+    FSTDocument *doc = FSTTestDoc(documentPath(index), 2 + i, @{ @"index" : @(index) }, NO);
+    FSTRemoteEvent *event = FSTTestUpdateRemoteEvent(doc, @[ targetIDs[index % targets] ], @[]);
+    start = [NSDate date];
+    [localStore applyRemoteEvent:event];
+    [samples[@"applyRemoteEvent"] addObject:@(-[start timeIntervalSinceNow])];
+
+    NSString *path = [NSString stringWithFormat:@"writes/doc%lu", (unsigned long)i];
+    NSArray<FSTMutation *> *write = @[ FSTTestSetMutation(path, @{ @"index" : @(i) }) ];
+    start = [NSDate date];
+    [localStore locallyWriteMutations:write];
+    [samples[@"locallyWriteMutations"] addObject:@(-[start timeIntervalSinceNow])];
+
+    start = [NSDate date];
+    [localStore collectGarbage];
+    [samples[@"collectGarbage"] addObject:@(-[start timeIntervalSinceNow])];
+  }
+  [localStore shutdown];
+  [persistence shutdown];
+
+  NSMutableDictionary<NSString *, id> *results = [NSMutableDictionary dictionary];
+  results[@"parameters"] = @{
+    @"documents" : @(documents),
+    @"mutations" : @(mutations),
+    @"targets" : @(targets),
+    @"iterations" : @(iterations),
+  };
+  for (NSString *operation in samples) {
+    results[operation] = [self summaryOfSamples:samples[operation]];
+  }
+
+  NSError *error;
+  NSData *json = [NSJSONSerialization dataWithJSONObject:results
+                                                 options:NSJSONWritingPrettyPrinted
+                                                   error:&error];
+  XCTAssertNotNil(json, @"Failed to encode results: %@", error);
+  NSString *output = _environment[@"FIRESTORE_BENCHMARK_OUTPUT"];
+  if (output) {
+    XCTAssertTrue([json writeToFile:output options:NSDataWritingAtomic error:&error],
+                  @"Failed to write results to %@: %@", output, error);
+  } else {
+    [XCTContext runActivityNamed:@"Local store benchmark results"
+                           block:^(id<XCTActivity> activity) {
+                             XCTAttachment *attachment =
+                                 [XCTAttachment attachmentWithData:json
+                                             uniformTypeIdentifier:@"public.json"];
+                             attachment.name = @"results.json";
+                             attachment.lifetime = XCTAttachmentLifetimeKeepAlways;
+                             [activity addAttachment:attachment];
+                           }];
+  }
+}
+
+@end
+
 NS_ASSUME_NONNULL_END
@@ -18,10 +18,21 @@
 #include <leveldb/db.h>
 
 #import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
+#import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Local/FSTLevelDB.h"
+#import "Firestore/Source/Local/FSTLevelDBFieldIndex.h"
+#import "Firestore/Source/Local/FSTLevelDBKey.h"
 #import "Firestore/Source/Local/FSTLevelDBMigrations.h"
 #import "Firestore/Source/Local/FSTLevelDBQueryCache.h"
+#import "Firestore/Source/Local/FSTLevelDBRemoteDocumentCache.h"
+#import "Firestore/Source/Local/FSTLocalSerializer.h"
+#import "Firestore/Source/Local/FSTWriteGroup.h"
+#import "Firestore/Source/Model/FSTDatabaseID.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Remote/FSTSerializerBeta.h"
 
 #import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
+#import "Firestore/Example/Tests/Util/FSTHelpers.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -34,6 +45,7 @@ using leveldb::Status;
 
 @implementation FSTLevelDBMigrationsTests {
   std::shared_ptr<DB> _db;
+  FSTLocalSerializer *_serializer;
 }
 
 - (void)setUp {
@@ -46,6 +58,10 @@ using leveldb::Status;
   Status status = DB::Open(options, [dir UTF8String], &db);
   XCTAssert(status.ok(), @"Failed to create db: %s", status.ToString().c_str());
   _db.reset(db);
+
+  FSTDatabaseID *databaseID = [FSTDatabaseID databaseIDWithProject:@"p" database:@"d"];
+  FSTSerializerBeta *remoteSerializer = [[FSTSerializerBeta alloc] initWithDatabaseID:databaseID];
+  _serializer = [[FSTLocalSerializer alloc] initWithRemoteSerializer:remoteSerializer];
 }
 
 - (void)tearDown {
@@ -55,7 +71,7 @@ using leveldb::Status;
 - (void)testAddsTargetGlobal {
   FSTPBTargetGlobal *metadata = [FSTLevelDBQueryCache readTargetMetadataFromDB:_db];
   XCTAssertNil(metadata, @"Not expecting metadata yet, we should have an empty db");
-  [FSTLevelDBMigrations runMigrationsOnDB:_db];
+  [FSTLevelDBMigrations runMigrationsOnDB:_db serializer:_serializer];
   metadata = [FSTLevelDBQueryCache readTargetMetadataFromDB:_db];
   XCTAssertNotNil(metadata, @"Migrations should have added the metadata");
 }
@@ -65,11 +81,106 @@ using leveldb::Status;
   XCTAssertEqual(0, initial, "No version should be equivalent to 0");
 
   // Pick an arbitrary high migration number and migrate to it.
-  [FSTLevelDBMigrations runMigrationsOnDB:_db];
+  [FSTLevelDBMigrations runMigrationsOnDB:_db serializer:_serializer];
   FSTLevelDBSchemaVersion actual = [FSTLevelDBMigrations schemaVersionForDB:_db];
   XCTAssertGreaterThan(actual, 0, @"Expected to migrate to a schema version > 0");
 }
 
+- (void)testBuildsFieldIndex {
+  // Write a document, then drop its index entries to simulate a database written before the field
+  // index existed.
+  FSTLevelDBRemoteDocumentCache *remoteDocuments =
+      [[FSTLevelDBRemoteDocumentCache alloc] initWithDB:_db serializer:_serializer];
+  FSTDocument *doc = FSTTestDoc(@"rooms/abc", 1, @{ @"owner" : @"alice" }, NO);
+  FSTWriteGroup *group = [FSTWriteGroup groupWithAction:@"Add document"];
+  [remoteDocuments addEntry:doc group:group];
+  XCTAssert([group writeToDB:_db].ok());
+
+  FSTLevelDBFieldIndex *fieldIndex = [[FSTLevelDBFieldIndex alloc] initWithDB:_db];
+  group = [FSTWriteGroup groupWithAction:@"Drop index"];
+  [fieldIndex removeEntriesForDocument:doc group:group];
+  XCTAssert([group writeToDB:_db].ok());
+
+  FSTQuery *query = [FSTTestQuery(@"rooms")
+      queryByAddingFilter:FSTTestFilter(@"owner", @"==", @"alice")];
+  XCTAssertEqual([fieldIndex documentKeysMatchingQuery:query].count, 0);
+
+  [FSTLevelDBMigrations runMigrationsOnDB:_db serializer:_serializer];
+  FSTDocumentKeySet *keys = [fieldIndex documentKeysMatchingQuery:query];
+  XCTAssertEqual(keys.count, 1);
+  XCTAssertTrue([keys containsObject:doc.key]);
+}
+
+- (void)testBuildsFieldIndexInBatches {
+  NSArray<FSTDocument *> *docs = @[
+    FSTTestDoc(@"rooms/a", 1, @{ @"owner" : @"alice" }, NO),
+    FSTTestDoc(@"rooms/b", 1, @{ @"owner" : @"alice" }, NO),
+    FSTTestDoc(@"rooms/c", 1, @{ @"owner" : @"alice" }, NO)
+  ];
+  [self writeUnindexedDocuments:docs];
+
+  NSMutableArray<NSNumber *> *reports = [NSMutableArray array];
+  [FSTLevelDBMigrations runMigrationsOnDB:_db
+                               serializer:_serializer
+                        documentsPerBatch:2
+                                 progress:^(FSTLevelDBSchemaVersion version, NSUInteger processed) {
+                                   [reports addObject:@(processed)];
+                                 }];
+  XCTAssertEqualObjects(reports, (@[ @2, @3 ]));
+  XCTAssertEqual([self aliceRooms].count, 3);
+
+  // Once finished, the migration leaves no progress behind.
+  std::string progress;
+  Status status =
+      _db->Get([FSTLevelDB standardReadOptions], [FSTLevelDBMigrationProgressKey key], &progress);
+  XCTAssertTrue(status.IsNotFound());
+}
+
+- (void)testResumesInterruptedFieldIndexMigration {
+  FSTDocument *first = FSTTestDoc(@"rooms/a", 1, @{ @"owner" : @"alice" }, NO);
+  FSTDocument *second = FSTTestDoc(@"rooms/b", 1, @{ @"owner" : @"alice" }, NO);
+  [self writeUnindexedDocuments:@[ first, second ]];
+
+  // Simulate a run interrupted after indexing the first document.
+  FSTWriteGroup *group = [FSTWriteGroup groupWithAction:@"Interrupted migration"];
+  [group setData:"1" forKey:[FSTLevelDBVersionKey key]];
+  [group setData:[FSTLevelDBRemoteDocumentKey keyWithDocumentKey:first.key]
+          forKey:[FSTLevelDBMigrationProgressKey key]];
+  XCTAssert([group writeToDB:_db].ok());
+
+  [FSTLevelDBMigrations runMigrationsOnDB:_db serializer:_serializer];
+  FSTDocumentKeySet *keys = [self aliceRooms];
+  XCTAssertEqual(keys.count, 1);
+  XCTAssertTrue([keys containsObject:second.key]);
+  XCTAssertEqual([FSTLevelDBMigrations schemaVersionForDB:_db], 3);
+}
+
+/** Writes the given documents without their index entries, as written before the index existed. */
+- (void)writeUnindexedDocuments:(NSArray<FSTDocument *> *)docs {
+  FSTLevelDBRemoteDocumentCache *remoteDocuments =
+      [[FSTLevelDBRemoteDocumentCache alloc] initWithDB:_db serializer:_serializer];
+  FSTLevelDBFieldIndex *fieldIndex = [[FSTLevelDBFieldIndex alloc] initWithDB:_db];
+  for (FSTDocument *doc in docs) {
+    FSTWriteGroup *group = [FSTWriteGroup groupWithAction:@"Add document"];
+    [remoteDocuments addEntry:doc group:group];
+    XCTAssert([group writeToDB:_db].ok());
+
+    group = [FSTWriteGroup groupWithAction:@"Drop index"];
+    [fieldIndex removeEntriesForDocument:doc group:group];
+    XCTAssert([group writeToDB:_db].ok());
+  }
+  [remoteDocuments shutdown];
+  XCTAssertEqual([self aliceRooms].count, 0);
+}
+
+/** Returns the keys the field index finds for rooms owned by alice. */
+- (FSTDocumentKeySet *)aliceRooms {
+  FSTLevelDBFieldIndex *fieldIndex = [[FSTLevelDBFieldIndex alloc] initWithDB:_db];
+  FSTQuery *query = [FSTTestQuery(@"rooms")
+      queryByAddingFilter:FSTTestFilter(@"owner", @"==", @"alice")];
+  return [fieldIndex documentKeysMatchingQuery:query];
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
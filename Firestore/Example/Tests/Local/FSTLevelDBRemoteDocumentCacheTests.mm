@@ -19,9 +19,21 @@
 #include <leveldb/db.h>
 
 #import "Firestore/Source/Local/FSTLevelDB.h"
+#import "Firestore/Source/Local/FSTLevelDBDocumentSnapshots.h"
 #import "Firestore/Source/Local/FSTLevelDBKey.h"
+#import "Firestore/Source/Local/FSTLevelDBReader.h"
+#import "Firestore/Source/Local/FSTLevelDBRemoteDocumentCache.h"
+#import "Firestore/Source/Local/FSTLocalSerializer.h"
+#import "Firestore/Source/Local/FSTWriteGroup.h"
+#import "Firestore/Source/Model/FSTDatabaseID.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTDocumentDictionary.h"
+#import "Firestore/Source/Remote/FSTSerializerBeta.h"
+
+#import "Firestore/Example/Tests/Util/FSTHelpers.h"
 
 #import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
+#import "Firestore/third_party/Immutable/Tests/FSTImmutableSortedDictionary+Testing.h"
 
 #include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
 
@@ -65,6 +77,204 @@ static const char *kDummy = "1";
   [super tearDown];
 }
 
+- (void)testReusesDecodedDocuments {
+  FSTLevelDBRemoteDocumentCache *cache = (FSTLevelDBRemoteDocumentCache *)self.remoteDocumentCache;
+  FSTDocument *doc = FSTTestDoc(@"a/b", 1, @{ @"a" : @1 }, NO);
+  [self addEntry:doc];
+
+  XCTAssertEqualObjects([cache entryForKey:doc.key], doc);
+  XCTAssertEqual(cache.decodedDocumentCacheHits, 0);
+  XCTAssertEqual(cache.decodedDocumentCacheMisses, 1);
+
+  FSTMaybeDocument *first = [cache entryForKey:doc.key];
+  FSTMaybeDocument *second = [cache entryForKey:doc.key];
+  XCTAssertEqual(first, second);
+  XCTAssertEqual(cache.decodedDocumentCacheHits, 2);
+  XCTAssertEqual(cache.decodedDocumentCacheMisses, 1);
+
+  FSTDocument *updated = FSTTestDoc(@"a/b", 2, @{ @"a" : @2 }, NO);
+  [self addEntry:updated];
+  XCTAssertEqualObjects([cache entryForKey:doc.key], updated);
+  XCTAssertEqual(cache.decodedDocumentCacheMisses, 2);
+}
+
+- (void)testDecodesLargeCollections {
+  FSTLevelDBRemoteDocumentCache *cache = (FSTLevelDBRemoteDocumentCache *)self.remoteDocumentCache;
+
+  // Enough documents for several decoding batches, plus rows the query must skip.
+  const int kDocumentCount = 2500;
+  NSMutableArray<FSTDocument *> *expected = [NSMutableArray array];
+  FSTWriteGroup *group = [self.persistence startGroupWithAction:@"addEntries"];
+  for (int i = 0; i < kDocumentCount; i++) {
+    NSString *path = [NSString stringWithFormat:@"coll/doc%05d", i];
+    FSTDocument *doc = FSTTestDoc(path, 1, @{ @"index" : @(i) }, NO);
+    [self.remoteDocumentCache addEntry:doc group:group];
+    [expected addObject:doc];
+  }
+  [self.remoteDocumentCache addEntry:FSTTestDeletedDoc(@"coll/deleted", 1) group:group];
+  [self.remoteDocumentCache addEntry:FSTTestDoc(@"coll/doc00000/sub/doc", 1, @{}, NO)
+                               group:group];
+  [self.persistence commitGroup:group];
+
+  // Rows that were decoded before are reused rather than decoded again.
+  XCTAssertEqualObjects([cache entryForKey:expected[7].key], expected[7]);
+  NSUInteger missesBefore = cache.decodedDocumentCacheMisses;
+
+  FSTDocumentDictionary *results = [cache documentsMatchingQuery:FSTTestQuery(@"coll")];
+  XCTAssertEqualObjects([results values], expected);
+  XCTAssertEqual(cache.decodedDocumentCacheHits, 1);
+  XCTAssertEqual(cache.decodedDocumentCacheMisses - missesBefore, kDocumentCount);
+}
+
+- (void)testReadsLargeCollectionsFromSnapshots {
+  NSString *directory =
+      [NSTemporaryDirectory() stringByAppendingPathComponent:@"FSTLevelDBDocumentSnapshots"];
+  [[NSFileManager defaultManager] removeItemAtPath:directory error:nil];
+
+  // Enough documents for the collection to be snapshotted, plus rows the query must skip.
+  const int kDocumentCount = 600;
+  NSMutableArray<FSTDocument *> *expected = [NSMutableArray array];
+  FSTWriteGroup *group = [self.persistence startGroupWithAction:@"addEntries"];
+  for (int i = 0; i < kDocumentCount; i++) {
+    NSString *path = [NSString stringWithFormat:@"coll/doc%05d", i];
+    FSTDocument *doc = FSTTestDoc(path, 1, @{ @"index" : @(i) }, NO);
+    [self.remoteDocumentCache addEntry:doc group:group];
+    [expected addObject:doc];
+  }
+  [self.remoteDocumentCache addEntry:FSTTestDoc(@"coll/doc00000/sub/doc", 1, @{}, NO)
+                               group:group];
+  [self.remoteDocumentCache addEntry:FSTTestDoc(@"colla/doc", 1, @{}, NO) group:group];
+  [self.persistence commitGroup:group];
+
+  FSTLevelDBReader *reader = [[FSTLevelDBReader alloc] initWithDB:_db.ptr];
+  FSTLevelDBDocumentSnapshots *snapshots =
+      [[FSTLevelDBDocumentSnapshots alloc] initWithDirectory:directory reader:reader generation:0];
+  FSTLevelDBRemoteDocumentCache *cache = [self cacheWithReader:reader snapshots:snapshots];
+  FSTQuery *query = FSTTestQuery(@"coll");
+
+  // The first scan reads LevelDB and finds the collection large enough to snapshot.
+  XCTAssertEqualObjects([[cache documentsMatchingQuery:query] values], expected);
+  XCTAssertEqual(snapshots.snapshotReads, 0);
+
+  [snapshots writePendingSnapshots];
+  XCTAssertEqualObjects([[cache documentsMatchingQuery:query] values], expected);
+  XCTAssertEqual(snapshots.snapshotReads, 1);
+
+  // A later run at the same generation reads the snapshot the earlier one wrote.
+  FSTLevelDBDocumentSnapshots *reopened =
+      [[FSTLevelDBDocumentSnapshots alloc] initWithDirectory:directory reader:reader generation:0];
+  FSTLevelDBRemoteDocumentCache *reopenedCache = [self cacheWithReader:reader snapshots:reopened];
+  XCTAssertEqualObjects([[reopenedCache documentsMatchingQuery:query] values], expected);
+  XCTAssertEqual(reopened.snapshotReads, 1);
+
+  // But not at any other generation.
+  FSTLevelDBDocumentSnapshots *stale =
+      [[FSTLevelDBDocumentSnapshots alloc] initWithDirectory:directory reader:reader generation:1];
+  FSTLevelDBRemoteDocumentCache *staleCache = [self cacheWithReader:reader snapshots:stale];
+  XCTAssertEqualObjects([[staleCache documentsMatchingQuery:query] values], expected);
+  XCTAssertEqual(stale.snapshotReads, 0);
+
+  // Changing any remote document advances the generation and deletes the snapshots.
+  FSTDocument *updated = FSTTestDoc(@"coll/doc00007", 2, @{ @"index" : @-1 }, NO);
+  expected[7] = updated;
+  group = [self.persistence startGroupWithAction:@"addEntry"];
+  [cache addEntry:updated group:group];
+  [self.persistence commitGroup:group];
+  XCTAssertEqual(snapshots.generation, 1);
+  XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:directory]);
+  XCTAssertEqualObjects([[cache documentsMatchingQuery:query] values], expected);
+  XCTAssertEqual(snapshots.snapshotReads, 1);
+
+  // The collection is snapshotted again at the new generation.
+  [snapshots writePendingSnapshots];
+  XCTAssertEqualObjects([[cache documentsMatchingQuery:query] values], expected);
+  XCTAssertEqual(snapshots.snapshotReads, 2);
+
+  [cache shutdown];
+  [reopenedCache shutdown];
+  [staleCache shutdown];
+  [snapshots shutdown];
+  [reopened shutdown];
+  [stale shutdown];
+}
+
+- (void)testReadTransactionsSeeOneSnapshot {
+  FSTDocument *doc = FSTTestDoc(@"a/b", 1, @{ @"a" : @1 }, NO);
+  FSTDocument *updated = FSTTestDoc(@"a/b", 2, @{ @"a" : @2 }, NO);
+  FSTDocument *other = FSTTestDoc(@"a/c", 1, @{ @"a" : @3 }, NO);
+  [self addEntry:doc];
+
+  std::shared_ptr<leveldb::DB> db = _db.ptr;
+  [self.persistence runReadTransaction:^{
+    XCTAssertEqualObjects([self.remoteDocumentCache entryForKey:doc.key], doc);
+
+    // Writes that bypass the persistence layer aren't visible until the transaction ends.
+    FSTWriteGroup *group = [FSTWriteGroup groupWithAction:@"Write directly"];
+    [self.remoteDocumentCache addEntry:updated group:group];
+    XCTAssertTrue([group writeToDB:db].ok());
+    XCTAssertEqualObjects([self.remoteDocumentCache entryForKey:doc.key], doc);
+
+    // Committing through the persistence layer refreshes the snapshot.
+    [self addEntry:other];
+    XCTAssertEqualObjects([self.remoteDocumentCache entryForKey:doc.key], updated);
+    XCTAssertEqualObjects([self.remoteDocumentCache entryForKey:other.key], other);
+  }];
+
+  XCTAssertEqualObjects([self.remoteDocumentCache entryForKey:doc.key], updated);
+}
+
+- (void)testWritesAreVisibleAtEveryDurability {
+  NSArray<NSNumber *> *durabilities = @[
+    @(FSTWriteDurabilityAsync), @(FSTWriteDurabilityCoalescedSync), @(FSTWriteDurabilitySync)
+  ];
+  int version = 1;
+  for (NSNumber *durability in durabilities) {
+    FSTDocument *doc = FSTTestDoc(@"a/b", version++, @{ @"a" : durability }, NO);
+    FSTWriteGroup *group = [self.persistence startGroupWithAction:@"addEntry"];
+    group.durability = (FSTWriteDurability)durability.integerValue;
+    [self.remoteDocumentCache addEntry:doc group:group];
+    [self.persistence commitGroup:group];
+
+    XCTAssertEqualObjects([self.remoteDocumentCache entryForKey:doc.key], doc);
+  }
+}
+
+- (void)testReportsCommitMetrics {
+  NSMutableArray<NSString *> *actions = [NSMutableArray array];
+  __block int totalChanges = 0;
+  __block size_t totalBytes = 0;
+  _db.commitMetricsHandler = ^(NSString *action, int changes, size_t bytes,
+                               NSTimeInterval latency) {
+    [actions addObject:action];
+    totalChanges += changes;
+    totalBytes += bytes;
+    XCTAssertGreaterThanOrEqual(latency, 0);
+  };
+
+  [self addEntry:FSTTestDoc(@"a/b", 1, @{ @"a" : @1 }, NO)];
+  XCTAssertEqualObjects(actions, @[ @"addEntry" ]);
+  // The document itself and the index entry for its field.
+  XCTAssertEqual(totalChanges, 2);
+  XCTAssertGreaterThan(totalBytes, 0);
+}
+
+- (FSTLevelDBRemoteDocumentCache *)cacheWithReader:(FSTLevelDBReader *)reader
+                                         snapshots:(FSTLevelDBDocumentSnapshots *)snapshots {
+  FSTDatabaseID *databaseID = [FSTDatabaseID databaseIDWithProject:@"p" database:@"d"];
+  FSTSerializerBeta *remoteSerializer = [[FSTSerializerBeta alloc] initWithDatabaseID:databaseID];
+  FSTLocalSerializer *serializer =
+      [[FSTLocalSerializer alloc] initWithRemoteSerializer:remoteSerializer];
+  return [[FSTLevelDBRemoteDocumentCache alloc] initWithReader:reader
+                                                    serializer:serializer
+                                             documentSnapshots:snapshots];
+}
+
+- (void)addEntry:(FSTMaybeDocument *)maybeDoc {
+  FSTWriteGroup *group = [self.persistence startGroupWithAction:@"addEntry"];
+  [self.remoteDocumentCache addEntry:maybeDoc group:group];
+  [self.persistence commitGroup:group];
+}
+
 - (void)writeDummyRowWithSegments:(NSArray<NSString *> *)segments {
   std::string key;
   for (NSString *segment in segments) {
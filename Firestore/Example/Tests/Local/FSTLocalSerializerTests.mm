@@ -149,6 +149,27 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqualObjects(decoded, deletedDoc);
 }
 
+- (void)testDecodesMaybeDocumentsFromData {
+  FSTDocumentKeyReference *reference = FSTTestRef(@"project", kDefaultDatabaseID, @"other/doc");
+  NSArray<FSTMaybeDocument *> *docs = @[
+    FSTTestDoc(@"some/path", 42, @{@"foo" : @"bar", @"nested" : @{@"a" : @[ @1, @2.5 ]}}, NO),
+    FSTTestDeletedDoc(@"some/path", 42),
+    // WireDecoder can't decode references, so this one falls back to the generated protos.
+    FSTTestDoc(@"some/path", 42, @{@"ref" : reference}, NO)
+  ];
+  for (FSTMaybeDocument *doc in docs) {
+    NSData *data = [[self.serializer encodedMaybeDocument:doc] data];
+    XCTAssertEqualObjects([self.serializer decodedMaybeDocumentFromData:data], doc);
+  }
+
+  // Fields can be read before (or without) decoding the whole document.
+  NSData *data = [[self.serializer encodedMaybeDocument:docs[0]] data];
+  FSTDocument *decoded = (FSTDocument *)[self.serializer decodedMaybeDocumentFromData:data];
+  XCTAssertEqualObjects([decoded fieldForPath:FSTTestFieldPath(@"nested.a")],
+                        FSTTestFieldValue(@[ @1, @2.5 ]));
+  XCTAssertNil([decoded fieldForPath:FSTTestFieldPath(@"missing")]);
+}
+
 - (void)testEncodesQueryData {
   FSTQuery *query = FSTTestQuery(@"room");
   FSTTargetID targetID = 42;
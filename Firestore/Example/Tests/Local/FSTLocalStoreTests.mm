@@ -21,11 +21,15 @@
 #import "Firestore/Source/Auth/FSTUser.h"
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Core/FSTTimestamp.h"
+#import "Firestore/Source/Local/FSTBundle.h"
 #import "Firestore/Source/Local/FSTEagerGarbageCollector.h"
+#import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
+#import "Firestore/Source/Local/FSTLocalSerializer.h"
 #import "Firestore/Source/Local/FSTLocalWriteResult.h"
 #import "Firestore/Source/Local/FSTNoOpGarbageCollector.h"
 #import "Firestore/Source/Local/FSTPersistence.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
+#import "Firestore/Source/Model/FSTDatabaseID.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTDocumentKey.h"
 #import "Firestore/Source/Model/FSTDocumentSet.h"
@@ -33,6 +37,7 @@
 #import "Firestore/Source/Model/FSTMutationBatch.h"
 #import "Firestore/Source/Model/FSTPath.h"
 #import "Firestore/Source/Remote/FSTRemoteEvent.h"
+#import "Firestore/Source/Remote/FSTSerializerBeta.h"
 #import "Firestore/Source/Remote/FSTWatchChange.h"
 #import "Firestore/Source/Util/FSTClasses.h"
 
@@ -44,14 +49,6 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-/** Creates a document version dictionary mapping the document in @a mutation to @a version. */
-FSTDocumentVersionDictionary *FSTVersionDictionary(FSTMutation *mutation,
-                                                   FSTTestSnapshotVersion version) {
-  FSTDocumentVersionDictionary *result = [FSTDocumentVersionDictionary documentVersionDictionary];
-  result = [result dictionaryBySettingObject:FSTTestVersion(version) forKey:mutation.key];
-  return result;
-}
-
 @interface FSTLocalStoreTests ()
 
 @property(nonatomic, strong, readwrite) id<FSTPersistence> localStorePersistence;
@@ -138,17 +135,30 @@ FSTDocumentVersionDictionary *FSTVersionDictionary(FSTMutation *mutation,
 }
 
 - (void)acknowledgeMutationWithVersion:(FSTTestSnapshotVersion)documentVersion {
+  FSTMutationBatchResult *result = [self nextBatchResultWithVersion:documentVersion];
+  self.lastChanges = [self.localStore acknowledgeBatchWithResult:result];
+}
+
+/** Acknowledges the next batches all at once, one for each of the given versions. */
+- (void)acknowledgeMutationsWithVersions:(NSArray<NSNumber *> *)documentVersions {
+  NSMutableArray<FSTMutationBatchResult *> *results = [NSMutableArray array];
+  for (NSNumber *documentVersion in documentVersions) {
+    [results addObject:[self nextBatchResultWithVersion:documentVersion.longLongValue]];
+  }
+  self.lastChanges = [self.localStore acknowledgeBatchesWithResults:results];
+}
+
+- (FSTMutationBatchResult *)nextBatchResultWithVersion:(FSTTestSnapshotVersion)documentVersion {
   FSTMutationBatch *batch = [self.batches firstObject];
   [self.batches removeObjectAtIndex:0];
   XCTAssertEqual(batch.mutations.count, 1, @"Acknowledging more than one mutation not supported.");
   FSTSnapshotVersion *version = FSTTestVersion(documentVersion);
   FSTMutationResult *mutationResult =
       [[FSTMutationResult alloc] initWithVersion:version transformResults:nil];
-  FSTMutationBatchResult *result = [FSTMutationBatchResult resultWithBatch:batch
-                                                             commitVersion:version
-                                                           mutationResults:@[ mutationResult ]
-                                                               streamToken:nil];
-  self.lastChanges = [self.localStore acknowledgeBatchWithResult:result];
+  return [FSTMutationBatchResult resultWithBatch:batch
+                                   commitVersion:version
+                                 mutationResults:@[ mutationResult ]
+                                     streamToken:nil];
 }
 
 - (void)rejectMutation {
@@ -243,6 +253,25 @@ FSTDocumentVersionDictionary *FSTVersionDictionary(FSTMutation *mutation,
   FSTAssertContains(FSTTestDoc(@"foo/bar", 0, @{@"foo" : @"bar"}, NO));
 }
 
+- (void)testHandlesSetMutationsAcknowledgedTogether {
+  if ([self isTestBaseClass]) return;
+
+  [self writeMutation:FSTTestSetMutation(@"foo/bar", @{@"foo" : @"bar"})];
+  [self writeMutation:FSTTestSetMutation(@"foo/baz", @{@"foo" : @"baz"})];
+  [self writeMutation:FSTTestSetMutation(@"foo/bar", @{@"foo" : @"new"})];
+
+  [self acknowledgeMutationsWithVersions:@[ @1, @2 ]];
+  FSTAssertChanged((@[
+    FSTTestDoc(@"foo/bar", 0, @{@"foo" : @"new"}, YES),
+    FSTTestDoc(@"foo/baz", 0, @{@"foo" : @"baz"}, NO)
+  ]));
+  FSTAssertContains(FSTTestDoc(@"foo/bar", 0, @{@"foo" : @"new"}, YES));
+  FSTAssertContains(FSTTestDoc(@"foo/baz", 0, @{@"foo" : @"baz"}, NO));
+
+  [self acknowledgeMutationsWithVersions:@[ @3 ]];
+  FSTAssertChanged(@[ FSTTestDoc(@"foo/bar", 0, @{@"foo" : @"new"}, NO) ]);
+}
+
 - (void)testHandlesSetMutationThenDocument {
   if ([self isTestBaseClass]) return;
 
@@ -498,6 +527,34 @@ FSTDocumentVersionDictionary *FSTVersionDictionary(FSTMutation *mutation,
   FSTAssertContains(FSTTestDoc(@"foo/bar", 0, @{@"foo" : @"old"}, NO));
 }
 
+- (void)testReappliesPendingMutationsWhenRemoteDocumentChanges {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = FSTTestQuery(@"foo");
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+
+  [self writeMutation:FSTTestPatchMutation(@"foo/bar", @{@"a" : @"1"}, nil)];
+  [self writeMutation:FSTTestPatchMutation(@"foo/bar", @{@"b" : @"2"}, nil)];
+  FSTAssertNotContains(@"foo/bar");
+
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(FSTTestDoc(@"foo/bar", 2, @{@"c" : @"3"}, NO),
+                                                  @[ @2 ], @[])];
+  FSTAssertChanged(
+      @[ FSTTestDoc(@"foo/bar", 2, @{@"a" : @"1", @"b" : @"2", @"c" : @"3"}, YES) ]);
+  FSTAssertContains(FSTTestDoc(@"foo/bar", 2, @{@"a" : @"1", @"b" : @"2", @"c" : @"3"}, YES));
+
+  [self rejectMutation];
+  FSTAssertChanged(@[ FSTTestDoc(@"foo/bar", 2, @{@"b" : @"2", @"c" : @"3"}, YES) ]);
+  FSTAssertContains(FSTTestDoc(@"foo/bar", 2, @{@"b" : @"2", @"c" : @"3"}, YES));
+  XCTAssertEqualObjects([[self.localStore executeQuery:query] values],
+                        @[ FSTTestDoc(@"foo/bar", 2, @{@"b" : @"2", @"c" : @"3"}, YES) ]);
+
+  // A new local store must pick up the pending mutations from the mutation queue.
+  [self restartWithNoopGarbageCollector];
+  FSTAssertContains(FSTTestDoc(@"foo/bar", 2, @{@"b" : @"2", @"c" : @"3"}, YES));
+}
+
 - (void)testHandlesSetMutationsAndPatchMutationOfJustOneTogether {
   if ([self isTestBaseClass]) return;
 
@@ -569,6 +626,72 @@ FSTDocumentVersionDictionary *FSTVersionDictionary(FSTMutation *mutation,
   FSTAssertNotContains(@"foo/bar");
 }
 
+- (void)testKeepsReleasedQueriesUntilCacheExceedsThreshold {
+  if ([self isTestBaseClass]) return;
+
+  [self.localStore shutdown];
+  __block int64_t cacheSize = 0;
+  FSTLRUGarbageCollector *garbageCollector =
+      [[FSTLRUGarbageCollector alloc] initWithThreshold:1
+                                              cacheSize:^{
+                                                return cacheSize;
+                                              }];
+  self.localStore = [[FSTLocalStore alloc] initWithPersistence:self.localStorePersistence
+                                              garbageCollector:garbageCollector
+                                                   initialUser:[FSTUser unauthenticatedUser]];
+  [self.localStore start];
+
+  FSTQuery *query = FSTTestQuery(@"foo");
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+
+  FSTDocument *doc = FSTTestDoc(@"foo/bar", 2, @{@"foo" : @"bar"}, NO);
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(doc, @[ @2 ], @[])];
+  [self.localStore releaseQuery:query];
+
+  // Below the threshold the released query keeps its documents cached.
+  [self collectGarbage];
+  FSTAssertContains(doc);
+
+  cacheSize = 2;
+  [self collectGarbage];
+  FSTAssertNotContains(@"foo/bar");
+}
+
+- (void)testKeepsPinnedQueriesUntilTheyExpire {
+  if ([self isTestBaseClass]) return;
+
+  [self.localStore shutdown];
+  __block int64_t cacheSize = 2;
+  FSTLRUGarbageCollector *garbageCollector =
+      [[FSTLRUGarbageCollector alloc] initWithThreshold:1
+                                              cacheSize:^{
+                                                return cacheSize;
+                                              }];
+  self.localStore = [[FSTLocalStore alloc] initWithPersistence:self.localStorePersistence
+                                              garbageCollector:garbageCollector
+                                                   initialUser:[FSTUser unauthenticatedUser]];
+  [self.localStore start];
+
+  FSTQuery *query = FSTTestQuery(@"foo");
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+
+  FSTDocument *doc = FSTTestDoc(@"foo/bar", 2, @{@"foo" : @"bar"}, NO);
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(doc, @[ @2 ], @[])];
+  [self.localStore pinQuery:query untilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+  [self.localStore releaseQuery:query];
+
+  // The cache exceeds the threshold, but the pinned query keeps its documents cached.
+  [self collectGarbage];
+  FSTAssertContains(doc);
+
+  [NSThread sleepForTimeInterval:0.2];
+  cacheSize = 3;
+  [self collectGarbage];
+  FSTAssertNotContains(@"foo/bar");
+}
+
 - (void)testCollectsGarbageAfterAcknowledgedMutation {
   if ([self isTestBaseClass]) return;
 
@@ -729,6 +852,102 @@ FSTDocumentVersionDictionary *FSTVersionDictionary(FSTMutation *mutation,
                         ]));
 }
 
+- (void)testCanExecuteCollectionQueriesMatchedByPatches {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = [FSTTestQuery(@"foo") queryByAddingFilter:FSTTestFilter(@"a", @"==", @"c")];
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(FSTTestDoc(@"foo/bar", 10, @{@"a" : @"b"}, NO),
+                                                  @[ @2 ], @[])];
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(FSTTestDoc(@"foo/baz", 20, @{@"a" : @"b"}, NO),
+                                                  @[ @2 ], @[])];
+
+  [self.localStore locallyWriteMutations:@[
+    FSTTestPatchMutation(@"foo/bar", @{@"a" : @"c"}, nil),
+    FSTTestPatchMutation(@"foo/baz", @{@"b" : @"c"}, nil)
+  ]];
+
+  FSTDocumentDictionary *docs = [self.localStore executeQuery:query];
+  XCTAssertEqualObjects([docs values], @[ FSTTestDoc(@"foo/bar", 10, @{@"a" : @"c"}, YES) ]);
+}
+
+- (void)testCanExecuteCollectionQueriesOverDocumentsCreatedByMergeSets {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = FSTTestQuery(@"foo");
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+
+  // A set with merge is a patch that doesn't require the document to exist.
+  FSTDocumentKey *key = FSTTestDocKey(@"foo/bar");
+  FSTObjectValue *value = FSTTestObjectValue(@{@"a" : @"b"});
+  FSTFieldMask *mask = [[FSTFieldMask alloc] initWithFields:@[ FSTTestFieldPath(@"a") ]];
+  [self.localStore locallyWriteMutations:@[ [[FSTPatchMutation alloc]
+                                             initWithKey:key
+                                               fieldMask:mask
+                                                   value:value
+                                            precondition:[FSTPrecondition none]] ]];
+
+  FSTDocumentDictionary *docs = [self.localStore executeQuery:query];
+  XCTAssertEqualObjects([docs values], @[ FSTTestDoc(@"foo/bar", 0, @{@"a" : @"b"}, YES) ]);
+}
+
+- (void)testCanExecuteQueriesInReadView {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = FSTTestQuery(@"foo");
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(FSTTestDoc(@"foo/bar", 10, @{@"a" : @"b"}, NO),
+                                                  @[ @2 ], @[])];
+  [self writeMutation:FSTTestSetMutation(@"foo/baz", @{@"a" : @"c"})];
+
+  // The read view may be read off the worker queue, concurrently with other reads.
+  __block FSTDocumentDictionary *docs;
+  dispatch_sync(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    docs = [self.localStore executeQueryInReadView:query];
+  });
+  XCTAssertEqualObjects([docs values], (@[
+                          FSTTestDoc(@"foo/bar", 10, @{@"a" : @"b"}, NO),
+                          FSTTestDoc(@"foo/baz", 0, @{@"a" : @"c"}, YES)
+                        ]));
+
+  // Once the write is rejected, newer read views no longer include it.
+  [self rejectMutation];
+  XCTAssertEqualObjects([[self.localStore executeQueryInReadView:query] values],
+                        @[ FSTTestDoc(@"foo/bar", 10, @{@"a" : @"b"}, NO) ]);
+}
+
+- (void)testReadViewIncludesAllChangesSinceLastRead {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = FSTTestQuery(@"foo");
+  XCTAssertEqualObjects([[self.localStore executeQueryInReadView:query] values], @[]);
+
+  // The read view is only rebuilt when it's read, so it must pick up every write since then.
+  [self writeMutation:FSTTestSetMutation(@"foo/bar", @{@"a" : @"b"})];
+  [self writeMutation:FSTTestSetMutation(@"foo/baz", @{@"a" : @"c"})];
+  [self writeMutation:FSTTestPatchMutation(@"foo/bar", @{@"a" : @"d"}, nil)];
+  XCTAssertEqualObjects([[self.localStore executeQueryInReadView:query] values], (@[
+                          FSTTestDoc(@"foo/bar", 0, @{@"a" : @"d"}, YES),
+                          FSTTestDoc(@"foo/baz", 0, @{@"a" : @"c"}, YES)
+                        ]));
+}
+
+- (void)testReadViewIsEmptyAfterShutdown {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = FSTTestQuery(@"foo");
+  [self writeMutation:FSTTestSetMutation(@"foo/bar", @{@"a" : @"b"})];
+  XCTAssertEqual([self.localStore executeQueryInReadView:query].count, 1u);
+
+  [self.localStore shutdown];
+  XCTAssertEqualObjects([[self.localStore executeQueryInReadView:query] values], @[]);
+}
+
 - (void)testPersistsResumeTokens {
   if ([self isTestBaseClass]) return;
 
@@ -789,6 +1008,106 @@ FSTDocumentVersionDictionary *FSTVersionDictionary(FSTMutation *mutation,
   FSTAssertEqualSets(keys, (@[ FSTTestDocKey(@"foo/bar"), FSTTestDocKey(@"foo/baz") ]));
 }
 
+- (void)testCountsDocumentsFromTargetKeysAndPendingMutations {
+  if ([self isTestBaseClass]) return;
+  [self restartWithNoopGarbageCollector];
+
+  FSTQuery *query = FSTTestQuery(@"foo");
+  FSTQueryData *queryData = [self.localStore allocateQuery:query];
+  FSTBoxedTargetID *targetID = @(queryData.targetID);
+  XCTAssertEqual([self.localStore countOfDocumentsMatchingQuery:query], 0);
+
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(FSTTestDoc(@"foo/bar", 10, @{@"a" : @"b"}, NO),
+                                                  @[ targetID ], @[])];
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(FSTTestDoc(@"foo/baz", 10, @{@"a" : @"b"}, NO),
+                                                  @[ targetID ], @[])];
+
+  // Mark the target current with a resume token so the count comes from its remote keys.
+  FSTWatchChange *watchChange =
+      [FSTWatchTargetChange changeWithState:FSTWatchTargetChangeStateCurrent
+                                  targetIDs:@[ targetID ]
+                                resumeToken:FSTTestResumeTokenFromSnapshotVersion(20)];
+  FSTWatchChangeAggregator *aggregator =
+      [[FSTWatchChangeAggregator alloc] initWithSnapshotVersion:FSTTestVersion(20)
+                                                  listenTargets:@{targetID : queryData}
+                                         pendingTargetResponses:@{}];
+  [aggregator addWatchChanges:@[ watchChange ]];
+  [self applyRemoteEvent:[aggregator remoteEvent]];
+  XCTAssertEqual([self.localStore countOfDocumentsMatchingQuery:query], 2);
+
+  [self writeMutation:FSTTestSetMutation(@"foo/bonk", @{@"a" : @"b"})];
+  [self writeMutation:FSTTestSetMutation(@"bar/baz", @{@"a" : @"b"})];
+  XCTAssertEqual([self.localStore countOfDocumentsMatchingQuery:query], 3);
+
+  [self writeMutation:FSTTestDeleteMutation(@"foo/bar")];
+  XCTAssertEqual([self.localStore countOfDocumentsMatchingQuery:query], 2);
+
+  [self writeMutation:FSTTestSetMutation(@"foo/baz", @{@"a" : @"c"})];
+  XCTAssertEqual([self.localStore countOfDocumentsMatchingQuery:query], 2);
+  XCTAssertEqual([self.localStore countOfDocumentsMatchingQuery:
+                                      [query queryBySettingLimit:1]],
+                 1);
+}
+
+- (FSTLocalSerializer *)bundleSerializer {
+  FSTDatabaseID *databaseID = [FSTDatabaseID databaseIDWithProject:@"p" database:@"d"];
+  FSTSerializerBeta *remoteSerializer = [[FSTSerializerBeta alloc] initWithDatabaseID:databaseID];
+  return [[FSTLocalSerializer alloc] initWithRemoteSerializer:remoteSerializer];
+}
+
+- (void)testLoadsBundledDocumentsAndQueryResults {
+  if ([self isTestBaseClass]) return;
+  [self restartWithNoopGarbageCollector];
+
+  FSTLocalSerializer *serializer = [self bundleSerializer];
+  FSTQuery *query = FSTTestQuery(@"foo");
+  NSData *resumeToken = FSTTestResumeTokenFromSnapshotVersion(10);
+  FSTQueryData *bundledQuery = [[FSTQueryData alloc] initWithQuery:query
+                                                          targetID:0
+                                              listenSequenceNumber:0
+                                                           purpose:FSTQueryPurposeListen
+                                                   snapshotVersion:FSTTestVersion(10)
+                                                       resumeToken:resumeToken];
+  FSTDocument *bar = FSTTestDoc(@"foo/bar", 10, @{@"a" : @"b"}, NO);
+  FSTDocument *baz = FSTTestDoc(@"foo/baz", 10, @{@"a" : @"c"}, NO);
+
+  FSTBundleWriter *writer = [[FSTBundleWriter alloc] initWithSerializer:serializer];
+  [writer addQueryData:bundledQuery];
+  [writer addDocument:bar];
+  [writer addDocument:baz];
+
+  NSError *error = nil;
+  FSTBundleReader *reader = [[FSTBundleReader alloc] initWithData:writer.data
+                                                       serializer:serializer];
+  self.lastChanges = [self.localStore loadBundle:reader error:&error];
+  XCTAssertNil(error);
+  FSTAssertChanged(@[ bar, baz ]);
+  FSTAssertContains(bar);
+  FSTAssertContains(baz);
+
+  FSTQueryData *queryData = [self.localStore allocateQuery:query];
+  XCTAssertEqualObjects(queryData.resumeToken, resumeToken);
+  XCTAssertEqualObjects(queryData.snapshotVersion, FSTTestVersion(10));
+  FSTAssertEqualSets([self.localStore remoteDocumentKeysForTarget:queryData.targetID],
+                     (@[ bar.key, baz.key ]));
+}
+
+- (void)testFailsToLoadMalformedBundle {
+  if ([self isTestBaseClass]) return;
+
+  FSTLocalSerializer *serializer = [self bundleSerializer];
+  FSTBundleWriter *writer = [[FSTBundleWriter alloc] initWithSerializer:serializer];
+  [writer addDocument:FSTTestDoc(@"foo/bar", 10, @{@"a" : @"b"}, NO)];
+  NSData *truncated = [writer.data subdataWithRange:NSMakeRange(0, writer.data.length - 1)];
+
+  NSError *error = nil;
+  FSTBundleReader *reader = [[FSTBundleReader alloc] initWithData:truncated
+                                                       serializer:serializer];
+  [self.localStore loadBundle:reader error:&error];
+  XCTAssertNotNil(error);
+  FSTAssertNotContains(@"foo/bar");
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
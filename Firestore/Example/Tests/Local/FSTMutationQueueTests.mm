@@ -215,6 +215,32 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertNil(notFound);
 }
 
+- (void)testReplaceMutationsOfLastBatch {
+  if ([self isTestBaseClass]) return;
+
+  NSMutableArray<FSTMutationBatch *> *batches = [self createBatches:3];
+  FSTMutationBatch *last = batches[2];
+  FSTSetMutation *mutation = FSTTestSetMutation(@"foo/bar", @{ @"a" : @2 });
+
+  FSTWriteGroup *group = [self.persistence startGroupWithAction:NSStringFromSelector(_cmd)];
+  FSTMutationBatch *replaced = [self.mutationQueue replaceMutationsOfLastBatch:last
+                                                                 withMutations:@[ mutation ]
+                                                                         group:group];
+  [self.persistence commitGroup:group];
+
+  XCTAssertEqual(replaced.batchID, last.batchID);
+  XCTAssertEqualObjects(replaced.localWriteTime, last.localWriteTime);
+  XCTAssertEqualObjects(replaced.mutations, @[ mutation ]);
+  XCTAssertEqual([self.mutationQueue nextBatchID], last.batchID + 1);
+
+  FSTMutationBatch *found = [self.mutationQueue lookupMutationBatch:last.batchID];
+  XCTAssertEqualObjects(found.mutations, @[ mutation ]);
+  NSArray<FSTMutationBatch *> *affecting =
+      [self.mutationQueue allMutationBatchesAffectingDocumentKey:FSTTestDocKey(@"foo/bar")];
+  XCTAssertEqual(affecting.count, 3);
+  XCTAssertEqualObjects(affecting.lastObject.mutations, @[ mutation ]);
+}
+
 - (void)testAllMutationBatchesThroughBatchID {
   if ([self isTestBaseClass]) return;
 
@@ -233,6 +259,27 @@ NS_ASSUME_NONNULL_BEGIN
   }
 }
 
+- (void)testEnumerateMutationBatches {
+  if ([self isTestBaseClass]) return;
+
+  NSMutableArray<FSTMutationBatch *> *batches = [self createBatches:10];
+  [self makeHoles:@[ @2, @6, @7 ] inBatches:batches];
+
+  NSMutableArray<FSTMutationBatch *> *found = [NSMutableArray array];
+  [self.mutationQueue enumerateMutationBatchesUsingBlock:^(FSTMutationBatch *batch, BOOL *stop) {
+    [found addObject:batch];
+  }];
+  XCTAssertEqualObjects(found, batches);
+
+  // Stopping ends the scan after the current batch.
+  [found removeAllObjects];
+  [self.mutationQueue enumerateMutationBatchesUsingBlock:^(FSTMutationBatch *batch, BOOL *stop) {
+    [found addObject:batch];
+    *stop = found.count == 3;
+  }];
+  XCTAssertEqualObjects(found, [batches subarrayWithRange:NSMakeRange(0, 3)]);
+}
+
 - (void)testAllMutationBatchesAffectingDocumentKey {
   if ([self isTestBaseClass]) return;
 
@@ -270,6 +317,44 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqualObjects(matches, expected);
 }
 
+- (void)testAllMutatedDocumentKeys {
+  if ([self isTestBaseClass]) return;
+
+  XCTAssertEqualObjects([self.mutationQueue allMutatedDocumentKeys], [FSTDocumentKeySet keySet]);
+
+  NSArray<FSTMutation *> *mutations = @[
+    FSTTestSetMutation(@"foo/bar",
+                       @{ @"a" : @1 }),
+    FSTTestPatchMutation(@"foo/bar",
+                         @{ @"b" : @1 }, nil),
+    FSTTestSetMutation(@"foo/bar/suffix/key",
+                       @{ @"a" : @1 }),
+    FSTTestSetMutation(@"foo/baz",
+                       @{ @"a" : @1 })
+  ];
+
+  NSMutableArray<FSTMutationBatch *> *batches = [NSMutableArray array];
+  FSTWriteGroup *group = [self.persistence startGroupWithAction:@"New mutation batch"];
+  for (FSTMutation *mutation in mutations) {
+    FSTMutationBatch *batch =
+        [self.mutationQueue addMutationBatchWithWriteTime:[FSTTimestamp timestamp]
+                                                mutations:@[ mutation ]
+                                                    group:group];
+    [batches addObject:batch];
+  }
+  [self.persistence commitGroup:group];
+
+  FSTDocumentKeySet *expected = FSTTestDocKeySet(@[
+    FSTTestDocKey(@"foo/bar"), FSTTestDocKey(@"foo/bar/suffix/key"), FSTTestDocKey(@"foo/baz")
+  ]);
+  XCTAssertEqualObjects([self.mutationQueue allMutatedDocumentKeys], expected);
+
+  // foo/bar is still mutated by the patch after the set is removed.
+  [self removeMutationBatches:@[ batches[0], batches[3] ]];
+  expected = FSTTestDocKeySet(@[ FSTTestDocKey(@"foo/bar"), FSTTestDocKey(@"foo/bar/suffix/key") ]);
+  XCTAssertEqualObjects([self.mutationQueue allMutatedDocumentKeys], expected);
+}
+
 - (void)testAllMutationBatchesAffectingQuery {
   if ([self isTestBaseClass]) return;
 
@@ -306,6 +391,49 @@ NS_ASSUME_NONNULL_BEGIN
       [self.mutationQueue allMutationBatchesAffectingQuery:query];
 
   XCTAssertEqualObjects(matches, expected);
+
+  FSTDocumentKeySet *expectedKeys =
+      FSTTestDocKeySet(@[ FSTTestDocKey(@"foo/bar"), FSTTestDocKey(@"foo/baz") ]);
+  XCTAssertEqualObjects([self.mutationQueue mutatedDocumentKeysAffectingQuery:query], expectedKeys);
+}
+
+- (void)testAllMutationBatchesAffectingQuerySkipsSubcollections {
+  if ([self isTestBaseClass]) return;
+
+  NSArray<FSTMutation *> *mutations = @[
+    FSTTestSetMutation(@"foo/a/sub/x",
+                       @{ @"a" : @1 }),
+    FSTTestSetMutation(@"foo/b",
+                       @{ @"a" : @1 }),
+    FSTTestSetMutation(@"foo/b/sub/x/deeper/y",
+                       @{ @"a" : @1 }),
+    FSTTestPatchMutation(@"foo/b",
+                         @{ @"b" : @1 }, nil),
+    FSTTestSetMutation(@"foo/b/sub/y",
+                       @{ @"a" : @1 }),
+    FSTTestSetMutation(@"foo/c",
+                       @{ @"a" : @1 })
+  ];
+
+  NSMutableArray<FSTMutationBatch *> *batches = [NSMutableArray array];
+  FSTWriteGroup *group = [self.persistence startGroupWithAction:@"New mutation batch"];
+  for (FSTMutation *mutation in mutations) {
+    FSTMutationBatch *batch =
+        [self.mutationQueue addMutationBatchWithWriteTime:[FSTTimestamp timestamp]
+                                                mutations:@[ mutation ]
+                                                    group:group];
+    [batches addObject:batch];
+  }
+  [self.persistence commitGroup:group];
+
+  NSArray<FSTMutationBatch *> *expected = @[ batches[1], batches[3], batches[5] ];
+  NSArray<FSTMutationBatch *> *matches =
+      [self.mutationQueue allMutationBatchesAffectingQuery:FSTTestQuery(@"foo")];
+  XCTAssertEqualObjects(matches, expected);
+
+  expected = @[ batches[4] ];
+  matches = [self.mutationQueue allMutationBatchesAffectingQuery:FSTTestQuery(@"foo/b/sub")];
+  XCTAssertEqualObjects(matches, expected);
 }
 
 - (void)testRemoveMutationBatches {
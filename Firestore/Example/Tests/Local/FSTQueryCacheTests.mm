@@ -19,6 +19,7 @@
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Core/FSTSnapshotVersion.h"
 #import "Firestore/Source/Local/FSTEagerGarbageCollector.h"
+#import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
 #import "Firestore/Source/Local/FSTPersistence.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
 #import "Firestore/Source/Local/FSTWriteGroup.h"
@@ -141,6 +142,28 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertNoThrow([self removeQueryData:queryData]);
 }
 
+- (void)testQueryDataChangesAfterLookupSurviveRestart {
+  if ([self isTestBaseClass]) return;
+
+  FSTQueryData *rooms = [self queryDataWithQuery:_queryRooms];
+  [self addQueryData:rooms];
+  XCTAssertNotNil([self.queryCache queryDataForQuery:_queryRooms]);
+
+  // Change the cache after it has been read, then check the changes made it to storage.
+  FSTQuery *halls = FSTTestQuery(@"halls");
+  FSTQueryData *hallsData = [self queryDataWithQuery:halls];
+  [self addQueryData:hallsData];
+  [self removeQueryData:rooms];
+  XCTAssertEqualObjects([self.queryCache queryDataForQuery:halls], hallsData);
+  XCTAssertNil([self.queryCache queryDataForQuery:_queryRooms]);
+
+  [self.queryCache shutdown];
+  self.queryCache = [self.persistence queryCache];
+  [self.queryCache start];
+  XCTAssertEqualObjects([self.queryCache queryDataForQuery:halls], hallsData);
+  XCTAssertNil([self.queryCache queryDataForQuery:_queryRooms]);
+}
+
 - (void)testRemoveQueryRemovesMatchingKeysToo {
   if ([self isTestBaseClass]) return;
 
@@ -238,6 +261,79 @@ NS_ASSUME_NONNULL_BEGIN
   FSTAssertEqualSets([garbageCollector collectGarbage], (@[ hall1, hall2 ]));
 }
 
+- (void)testEnumerateQueryData {
+  if ([self isTestBaseClass]) return;
+
+  FSTQueryData *rooms = [self queryDataWithQuery:FSTTestQuery(@"rooms")];
+  FSTQueryData *halls = [self queryDataWithQuery:FSTTestQuery(@"halls")];
+  [self addQueryData:rooms];
+  [self addQueryData:halls];
+
+  NSMutableArray<FSTQueryData *> *result = [NSMutableArray array];
+  [self.queryCache enumerateQueryDataUsingBlock:^(FSTQueryData *queryData, BOOL *stop) {
+    [result addObject:queryData];
+  }];
+  FSTAssertEqualSets(result, (@[ rooms, halls ]));
+
+  [self removeQueryData:rooms];
+  [result removeAllObjects];
+  [self.queryCache enumerateQueryDataUsingBlock:^(FSTQueryData *queryData, BOOL *stop) {
+    [result addObject:queryData];
+  }];
+  XCTAssertEqualObjects(result, (@[ halls ]));
+}
+
+- (void)testLRUGarbageCollectorRemovesLeastRecentlyUsedQueries {
+  if ([self isTestBaseClass]) return;
+
+  __block int64_t cacheSize = 0;
+  FSTLRUGarbageCollector *garbageCollector =
+      [[FSTLRUGarbageCollector alloc] initWithThreshold:100
+                                              cacheSize:^{
+                                                return cacheSize;
+                                              }];
+  garbageCollector.maxQueriesPerPass = 1;
+  [garbageCollector addGarbageSource:self.queryCache];
+
+  FSTQueryData *rooms = [self queryDataWithQuery:FSTTestQuery(@"rooms")];
+  FSTDocumentKey *room = FSTTestDocKey(@"rooms/foo");
+  [self addQueryData:rooms];
+  [self addMatchingKey:room forTargetID:rooms.targetID];
+
+  FSTQueryData *halls = [self queryDataWithQuery:FSTTestQuery(@"halls")];
+  FSTDocumentKey *hall = FSTTestDocKey(@"halls/foo");
+  [self addQueryData:halls];
+  [self addMatchingKey:hall forTargetID:halls.targetID];
+
+  FSTQueryData *garages = [self queryDataWithQuery:FSTTestQuery(@"garages")];
+  [self addQueryData:garages];
+
+  // Nothing is removed while the cache is below the threshold.
+  [self removeInactiveQueriesWithCollector:garbageCollector liveQueries:@{}];
+  XCTAssertNotNil([self.queryCache queryDataForQuery:rooms.query]);
+  FSTAssertEqualSets([garbageCollector collectGarbage], @[]);
+
+  // Above it, the least recently used query that isn't live goes first.
+  cacheSize = 200;
+  [self removeInactiveQueriesWithCollector:garbageCollector
+                               liveQueries:@{ @(rooms.targetID) : rooms }];
+  XCTAssertNotNil([self.queryCache queryDataForQuery:rooms.query]);
+  XCTAssertNil([self.queryCache queryDataForQuery:halls.query]);
+  XCTAssertNotNil([self.queryCache queryDataForQuery:garages.query]);
+  FSTAssertEqualSets([garbageCollector collectGarbage], @[ hall ]);
+
+  // Until the measured size changes, the last pass is assumed to still be taking effect.
+  [self removeInactiveQueriesWithCollector:garbageCollector liveQueries:@{}];
+  XCTAssertNotNil([self.queryCache queryDataForQuery:garages.query]);
+
+  cacheSize = 150;
+  [self removeInactiveQueriesWithCollector:garbageCollector
+                               liveQueries:@{ @(rooms.targetID) : rooms }];
+  XCTAssertNotNil([self.queryCache queryDataForQuery:rooms.query]);
+  XCTAssertNil([self.queryCache queryDataForQuery:garages.query]);
+  FSTAssertEqualSets([garbageCollector collectGarbage], @[]);
+}
+
 - (void)testMatchingKeysForTargetID {
   if ([self isTestBaseClass]) return;
 
@@ -346,6 +442,41 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqual([self.queryCache highestTargetID], 42);
 }
 
+- (void)testReservations {
+  if ([self isTestBaseClass]) return;
+
+  FSTWriteGroup *group = [self.persistence startGroupWithAction:@"reserve"];
+  [self.queryCache reserveTargetIDsThrough:200 group:group];
+  [self.queryCache reserveListenSequenceNumbersThrough:100 group:group];
+  [self.persistence commitGroup:group];
+  XCTAssertEqual([self.queryCache highestTargetID], 200);
+  XCTAssertEqual([self.queryCache highestListenSequenceNumber], 100);
+
+  // Adding queries within the reserved ranges leaves the reservations in place.
+  FSTQueryData *queryData = [[FSTQueryData alloc] initWithQuery:FSTTestQuery(@"rooms")
+                                                       targetID:2
+                                           listenSequenceNumber:1
+                                                        purpose:FSTQueryPurposeListen];
+  [self addQueryData:queryData];
+  XCTAssertEqual([self.queryCache highestTargetID], 200);
+  XCTAssertEqual([self.queryCache highestListenSequenceNumber], 100);
+
+  // Reservations never come down.
+  group = [self.persistence startGroupWithAction:@"reserve"];
+  [self.queryCache reserveTargetIDsThrough:10 group:group];
+  [self.queryCache reserveListenSequenceNumbersThrough:10 group:group];
+  [self.persistence commitGroup:group];
+  XCTAssertEqual([self.queryCache highestTargetID], 200);
+  XCTAssertEqual([self.queryCache highestListenSequenceNumber], 100);
+
+  // Verify that the reservations survive restarts.
+  [self.queryCache shutdown];
+  self.queryCache = [self.persistence queryCache];
+  [self.queryCache start];
+  XCTAssertEqual([self.queryCache highestTargetID], 200);
+  XCTAssertEqual([self.queryCache highestListenSequenceNumber], 100);
+}
+
 - (void)testLastRemoteSnapshotVersion {
   if ([self isTestBaseClass]) return;
 
@@ -404,6 +535,16 @@ NS_ASSUME_NONNULL_BEGIN
   [self.persistence commitGroup:group];
 }
 
+/** Lets the collector remove queries from the queryCache under test, committing immediately. */
+- (void)removeInactiveQueriesWithCollector:(FSTLRUGarbageCollector *)garbageCollector
+                               liveQueries:(NSDictionary<NSNumber *, FSTQueryData *> *)liveQueries {
+  FSTWriteGroup *group = [self.persistence startGroupWithAction:@"removeInactiveQueries"];
+  [garbageCollector removeInactiveQueriesFromCache:self.queryCache
+                                       liveQueries:liveQueries
+                                             group:group];
+  [self.persistence commitGroup:group];
+}
+
 - (void)addMatchingKey:(FSTDocumentKey *)key forTargetID:(FSTTargetID)targetID {
   FSTDocumentKeySet *keys = [FSTDocumentKeySet keySet];
   keys = [keys setByAddingObject:key];
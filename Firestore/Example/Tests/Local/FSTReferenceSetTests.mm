@@ -53,6 +53,18 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertTrue([referenceSet isEmpty]);
 }
 
+- (void)testReportsMemoryUsage {
+  FSTReferenceSet *referenceSet = [[FSTReferenceSet alloc] init];
+  XCTAssertEqual([referenceSet memoryUsage].objects, 0);
+  XCTAssertEqual([referenceSet memoryUsage].bytes, 0);
+
+  [referenceSet addReferenceToKey:FSTTestDocKey(@"foo/bar") forID:1];
+  [referenceSet addReferenceToKey:FSTTestDocKey(@"foo/bar") forID:2];
+  FSTMemoryUsage usage = [referenceSet memoryUsage];
+  XCTAssertEqual(usage.objects, 2);
+  XCTAssertGreaterThan(usage.bytes, 0);
+}
+
 - (void)testRemoveAllReferencesForTargetID {
   FSTDocumentKey *key1 = FSTTestDocKey(@"foo/bar");
   FSTDocumentKey *key2 = FSTTestDocKey(@"foo/baz");
@@ -80,6 +92,31 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertFalse([referenceSet containsKey:key3]);
 }
 
+- (void)testAddAndRemoveReferencesInBatches {
+  FSTDocumentKey *key1 = FSTTestDocKey(@"foo/bar");
+  FSTDocumentKey *key2 = FSTTestDocKey(@"foo/baz");
+  FSTDocumentKey *key3 = FSTTestDocKey(@"foo/blah");
+  FSTReferenceSet *referenceSet = [[FSTReferenceSet alloc] init];
+
+  [referenceSet addReferencesToKeys:FSTTestDocKeySet(@[ key1, key2 ]) forID:1];
+  [referenceSet addReferencesToKeys:FSTTestDocKeySet(@[ key2, key3 ]) forID:2];
+  XCTAssertEqualObjects([referenceSet referencedKeysForID:1], FSTTestDocKeySet(@[ key1, key2 ]));
+  XCTAssertEqualObjects([referenceSet referencedKeysForID:2], FSTTestDocKeySet(@[ key2, key3 ]));
+
+  [referenceSet removeReferencesToKeys:FSTTestDocKeySet(@[ key1, key2 ]) forID:2];
+  XCTAssertEqualObjects([referenceSet referencedKeysForID:2], FSTTestDocKeySet(@[ key3 ]));
+  XCTAssertTrue([referenceSet containsKey:key1]);
+  XCTAssertTrue([referenceSet containsKey:key2]);
+
+  [referenceSet removeReferencesToKeys:FSTTestDocKeySet(@[ key1, key2 ]) forID:1];
+  XCTAssertFalse([referenceSet containsKey:key1]);
+  XCTAssertFalse([referenceSet containsKey:key2]);
+  XCTAssertTrue([referenceSet containsKey:key3]);
+
+  [referenceSet removeAllReferences];
+  XCTAssertTrue([referenceSet isEmpty]);
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -19,8 +19,10 @@
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTPersistence.h"
 #import "Firestore/Source/Local/FSTWriteGroup.h"
+#import "Firestore/Source/Model/FSTDatabaseID.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTDocumentKey.h"
+#import "Firestore/Source/Model/FSTDocumentKeySet.h"
 #import "Firestore/Source/Model/FSTDocumentSet.h"
 
 #import "Firestore/Example/Tests/Util/FSTHelpers.h"
@@ -94,6 +96,21 @@ static const int kVersion = 42;
   XCTAssertNil([self readEntryAtPath:kDocPath]);
 }
 
+- (void)testReportsMemoryUsageOfReadDocuments {
+  if (!self.remoteDocumentCache) return;
+
+  [self setTestDocumentAtPath:kDocPath];
+  [self readEntryAtPath:kDocPath];
+  FSTMemoryUsage usage = [self.remoteDocumentCache memoryUsage];
+  XCTAssertEqual(usage.objects, 1);
+  XCTAssertGreaterThan(usage.bytes, 0);
+
+  [self removeEntryAtPath:kDocPath];
+  usage = [self.remoteDocumentCache memoryUsage];
+  XCTAssertEqual(usage.objects, 0);
+  XCTAssertEqual(usage.bytes, 0);
+}
+
 - (void)testRemoveNonExistentDocument {
   if (!self.remoteDocumentCache) return;
 
@@ -101,6 +118,34 @@ static const int kVersion = 42;
   XCTAssertNoThrow([self removeEntryAtPath:kDocPath]);
 }
 
+- (void)testEntriesForKeys {
+  if (!self.remoteDocumentCache) return;
+
+  FSTDocument *a = [self setTestDocumentAtPath:@"a/1"];
+  FSTDeletedDocument *deleted = FSTTestDeletedDoc(@"b/1", kVersion);
+  [self addEntry:deleted];
+  FSTDocument *deep = [self setTestDocumentAtPath:@"b/1/c/1"];
+  [self setTestDocumentAtPath:@"c/1"];
+
+  FSTDocumentKeySet *keys = [FSTDocumentKeySet keySet];
+  for (NSString *path in @[ @"a/1", @"a/2", @"b/1", @"b/1/c/1", @"d/1" ]) {
+    keys = [keys setByAddingObject:FSTTestDocKey(path)];
+  }
+
+  FSTMaybeDocumentDictionary *results = [self.remoteDocumentCache entriesForKeys:keys];
+  XCTAssertEqual([results count], 3);
+  XCTAssertEqualObjects([results objectForKey:a.key], a);
+  XCTAssertEqualObjects([results objectForKey:deleted.key], deleted);
+  XCTAssertEqualObjects([results objectForKey:deep.key], deep);
+}
+
+- (void)testEntriesForNoKeys {
+  if (!self.remoteDocumentCache) return;
+
+  [self setTestDocumentAtPath:kDocPath];
+  XCTAssertTrue([[self.remoteDocumentCache entriesForKeys:[FSTDocumentKeySet keySet]] isEmpty]);
+}
+
 // TODO(mikelehen): Write more elaborate tests once we have more elaborate implementations.
 - (void)testDocumentsMatchingQuery {
   if (!self.remoteDocumentCache) return;
@@ -122,6 +167,201 @@ static const int kVersion = 42;
   }
 }
 
+- (void)testDocumentsMatchingQuerySkipsSubcollections {
+  if (!self.remoteDocumentCache) return;
+
+  [self setTestDocumentAtPath:@"a/1"];
+  [self setTestDocumentAtPath:@"a/1/b/1"];
+  [self setTestDocumentAtPath:@"a/1/b/1/c/1"];
+  [self setTestDocumentAtPath:@"a/2/b/1"];
+  [self setTestDocumentAtPath:@"a/3"];
+  [self setTestDocumentAtPath:@"a/3/b/2"];
+  [self setTestDocumentAtPath:@"b/1"];
+
+  FSTDocumentDictionary *results =
+      [self.remoteDocumentCache documentsMatchingQuery:FSTTestQuery(@"a")];
+  NSArray *expected =
+      @[ FSTTestDoc(@"a/1", kVersion, _kDocData, NO), FSTTestDoc(@"a/3", kVersion, _kDocData, NO) ];
+  XCTAssertEqual([results count], [expected count]);
+  for (FSTDocument *doc in expected) {
+    XCTAssertEqualObjects([results objectForKey:doc.key], doc);
+  }
+
+  results = [self.remoteDocumentCache documentsMatchingQuery:FSTTestQuery(@"a/1/b")];
+  XCTAssertEqual([results count], 1);
+  XCTAssertNotNil([results objectForKey:FSTTestDocKey(@"a/1/b/1")]);
+}
+
+- (void)testDocumentsMatchingQueryWithFilters {
+  if (!self.remoteDocumentCache) return;
+
+  FSTDocument *a = FSTTestDoc(@"rooms/a", kVersion, @{ @"n" : @1, @"s" : @"x" }, NO);
+  FSTDocument *b = FSTTestDoc(@"rooms/b", kVersion, @{ @"n" : @2.5, @"s" : @"y" }, NO);
+  FSTDocument *c = FSTTestDoc(@"rooms/c", kVersion, @{ @"n" : @3, @"s" : @{ @"t" : @"x" } }, NO);
+  FSTDocument *d = FSTTestDoc(@"rooms/d", kVersion, @{ @"n" : @"3" }, NO);
+  FSTDocument *nested = FSTTestDoc(@"rooms/a/sub/e", kVersion, @{ @"n" : @2 }, NO);
+  for (FSTDocument *doc in @[ a, b, c, d, nested ]) {
+    [self addEntry:doc];
+  }
+  // Replacing a document must drop the old values from consideration.
+  FSTDocument *replaced = FSTTestDoc(@"rooms/b", kVersion + 1, @{ @"n" : @5, @"s" : @"y" }, NO);
+  [self addEntry:replaced];
+
+  // Each case is a field, an operator, a value and the documents that match.
+  NSArray<NSArray *> *cases = @[
+    @[ @"n", @"==", @1, @[ a ] ],
+    @[ @"n", @">", @1, @[ replaced, c ] ],
+    @[ @"n", @"<=", @3, @[ a, c ] ],
+    @[ @"n", @"<", @2.5, @[ a ] ],
+    @[ @"s", @"==", @"x", @[ a ] ],
+    @[ @"s", @">=", @"x", @[ a, replaced ] ],
+    @[ @"s.t", @"==", @"x", @[ c ] ],
+  ];
+  for (NSArray *testCase in cases) {
+    FSTQuery *query = [FSTTestQuery(@"rooms")
+        queryByAddingFilter:FSTTestFilter(testCase[0], testCase[1], testCase[2])];
+
+    // Implementations may return extra documents, so filter them the way callers do.
+    FSTDocumentDictionary *results = [self.remoteDocumentCache documentsMatchingQuery:query];
+    NSMutableArray<FSTDocument *> *matches = [NSMutableArray array];
+    [results enumerateKeysAndObjectsUsingBlock:^(FSTDocumentKey *key, FSTDocument *doc,
+                                                 BOOL *stop) {
+      if ([query matchesDocument:doc]) {
+        [matches addObject:doc];
+      }
+    }];
+    XCTAssertEqualObjects(matches, testCase[3], @"%@", query);
+  }
+}
+
+- (void)testDocumentsMatchingQueryWithGeoBounds {
+  if (!self.remoteDocumentCache) return;
+
+  FSTDocument *paris = FSTTestDoc(@"sites/paris", kVersion,
+                                  @{ @"location" : FSTTestGeoPoint(48.8566, 2.3522) }, NO);
+  FSTDocument *london = FSTTestDoc(@"sites/london", kVersion,
+                                   @{ @"location" : FSTTestGeoPoint(51.5074, -0.1278) }, NO);
+  FSTDocument *fiji = FSTTestDoc(@"sites/fiji", kVersion,
+                                 @{ @"location" : FSTTestGeoPoint(-17.7134, 178.065) }, NO);
+  FSTDocument *samoa = FSTTestDoc(@"sites/samoa", kVersion,
+                                  @{ @"location" : FSTTestGeoPoint(-13.759, -172.1046) }, NO);
+  FSTDocument *nowhere = FSTTestDoc(@"sites/nowhere", kVersion, @{ @"location" : @"Paris" }, NO);
+  for (FSTDocument *doc in @[ paris, london, fiji, samoa, nowhere ]) {
+    [self addEntry:doc];
+  }
+
+  // Each case is a southwest corner, a northeast corner and the documents that match.
+  NSArray<NSArray *> *cases = @[
+    @[ FSTTestGeoPoint(48, 2), FSTTestGeoPoint(49, 3), @[ paris ] ],
+    @[ FSTTestGeoPoint(45, -5), FSTTestGeoPoint(55, 5), @[ london, paris ] ],
+    @[ FSTTestGeoPoint(-20, 170), FSTTestGeoPoint(-10, -170), @[ fiji, samoa ] ],
+    @[ FSTTestGeoPoint(0, 0), FSTTestGeoPoint(1, 1), @[] ],
+  ];
+  for (NSArray *testCase in cases) {
+    FSTGeoBoundsFilter *filter =
+        [[FSTGeoBoundsFilter alloc] initWithField:FSTTestFieldPath(@"location")
+                                        southWest:testCase[0]
+                                        northEast:testCase[1]];
+    FSTQuery *query = [FSTTestQuery(@"sites") queryByAddingFilter:filter];
+
+    FSTDocumentDictionary *results = [self.remoteDocumentCache documentsMatchingQuery:query];
+    NSMutableArray<FSTDocument *> *matches = [NSMutableArray array];
+    [results enumerateKeysAndObjectsUsingBlock:^(FSTDocumentKey *key, FSTDocument *doc,
+                                                 BOOL *stop) {
+      if ([query matchesDocument:doc]) {
+        [matches addObject:doc];
+      }
+    }];
+    XCTAssertEqualObjects(matches, testCase[2], @"%@", query);
+  }
+}
+
+- (void)testDocumentsMatchingQueryWithCursors {
+  if (!self.remoteDocumentCache) return;
+
+  FSTDocument *a = FSTTestDoc(@"rooms/a", kVersion, @{ @"n" : @1 }, NO);
+  FSTDocument *b = FSTTestDoc(@"rooms/b", kVersion, @{ @"n" : @2 }, NO);
+  FSTDocument *c = FSTTestDoc(@"rooms/c", kVersion, @{ @"n" : @"x" }, NO);
+  FSTDocument *d = FSTTestDoc(@"rooms/d", kVersion, @{ @"n" : [NSData data] }, NO);
+  FSTDocument *e = FSTTestDoc(@"rooms/e", kVersion, @{ @"n" : @3 }, NO);
+  for (FSTDocument *doc in @[ a, b, c, d, e ]) {
+    [self addEntry:doc];
+  }
+
+  FSTBound *(^bound)(id, BOOL) = ^FSTBound *(id value, BOOL before) {
+    return [FSTBound boundWithPosition:@[ FSTTestFieldValue(value) ] isBefore:before];
+  };
+  id (^ref)(NSString *) = ^id(NSString *path) {
+    return FSTTestRef(@"project", kDefaultDatabaseID, path);
+  };
+  FSTQuery *rooms = FSTTestQuery(@"rooms");
+  FSTQuery *byKeyDescending = [rooms queryByAddingSortOrder:FSTTestOrderBy(@"__name__", @"desc")];
+  FSTQuery *byN = [rooms queryByAddingSortOrder:FSTTestOrderBy(@"n", @"asc")];
+  FSTQuery *byNDescending = [rooms queryByAddingSortOrder:FSTTestOrderBy(@"n", @"desc")];
+
+  // Each case is a query and the documents that match, in key order.
+  NSArray<NSArray *> *cases = @[
+    @[ [rooms queryByAddingStartAt:bound(ref(@"rooms/b"), NO)], @[ c, d, e ] ],
+    @[
+      [[rooms queryByAddingStartAt:bound(ref(@"rooms/b"), YES)]
+          queryByAddingEndAt:bound(ref(@"rooms/d"), YES)],
+      @[ b, c ]
+    ],
+    @[ [byKeyDescending queryByAddingStartAt:bound(ref(@"rooms/b"), YES)], @[ a, b ] ],
+    @[ [[byN queryByAddingStartAt:bound(@2, YES)] queryByAddingEndAt:bound(@3, NO)], @[ b, e ] ],
+    // Without an end, values of types that aren't indexed, like blobs, match too.
+    @[ [byN queryByAddingStartAt:bound(@2, NO)], @[ c, d, e ] ],
+    @[ [byNDescending queryByAddingStartAt:bound(@"x", YES)], @[ a, b, c, e ] ],
+    @[
+      [[byN queryByAddingFilter:FSTTestFilter(@"n", @">", @1)]
+          queryByAddingEndAt:bound(@2, NO)],
+      @[ b ]
+    ],
+  ];
+  for (NSArray *testCase in cases) {
+    FSTQuery *query = testCase[0];
+
+    // Implementations may return extra documents, so filter them the way callers do.
+    FSTDocumentDictionary *results = [self.remoteDocumentCache documentsMatchingQuery:query];
+    NSMutableArray<FSTDocument *> *matches = [NSMutableArray array];
+    [results enumerateKeysAndObjectsUsingBlock:^(FSTDocumentKey *key, FSTDocument *doc,
+                                                 BOOL *stop) {
+      if ([query matchesDocument:doc]) {
+        [matches addObject:doc];
+      }
+    }];
+    XCTAssertEqualObjects(matches, testCase[1], @"%@", query);
+  }
+}
+
+- (void)testEnumerateDocumentsInCollection {
+  if (!self.remoteDocumentCache) return;
+
+  [self setTestDocumentAtPath:@"a/1"];
+  [self setTestDocumentAtPath:@"b/3"];
+  [self setTestDocumentAtPath:@"b/1"];
+  [self setTestDocumentAtPath:@"b/1/c/1"];
+  [self addEntry:FSTTestDeletedDoc(@"b/2", kVersion)];
+  [self setTestDocumentAtPath:@"b/4"];
+  [self setTestDocumentAtPath:@"c/1"];
+
+  NSMutableArray<FSTDocumentKey *> *keys = [NSMutableArray array];
+  [self.remoteDocumentCache enumerateDocumentsInCollection:FSTTestPath(@"b")
+                                                usingBlock:^(FSTDocument *doc, BOOL *stop) {
+                                                  [keys addObject:doc.key];
+                                                }];
+  XCTAssertEqualObjects(keys, (@[ FSTTestDocKey(@"b/1"), FSTTestDocKey(@"b/3"),
+                                  FSTTestDocKey(@"b/4") ]));
+
+  [keys removeAllObjects];
+  [self.remoteDocumentCache enumerateDocumentsInCollection:FSTTestPath(@"b")
+                                                usingBlock:^(FSTDocument *doc, BOOL *stop) {
+                                                  [keys addObject:doc.key];
+                                                  *stop = keys.count == 2;
+                                                }];
+  XCTAssertEqualObjects(keys, (@[ FSTTestDocKey(@"b/1"), FSTTestDocKey(@"b/3") ]));
+}
+
 #pragma mark - Helpers
 
 - (FSTDocument *)setTestDocumentAtPath:(NSString *)path {
@@ -82,6 +82,30 @@ NS_ASSUME_NONNULL_BEGIN
                         _kInitialBDoc);
 }
 
+- (void)testPrefetchedEntriesAreServedWithoutTheCache {
+  [_remoteDocumentBuffer
+      prefetchEntriesForKeys:[FSTDocumentKeySet keySetWithKeys:[NSSet setWithArray:@[
+        FSTTestDocKey(@"coll/a"), FSTTestDocKey(@"coll/b"), FSTTestDocKey(@"coll/c")
+      ]]]];
+
+  // Change the cache behind the buffer's back; the prefetched entries should still be returned.
+  FSTWriteGroup *group = [_db startGroupWithAction:@"Change docs"];
+  [_remoteDocumentCache addEntry:FSTTestDoc(@"coll/a", 50, @{@"other" : @"data"}, NO) group:group];
+  [_remoteDocumentCache addEntry:FSTTestDoc(@"coll/c", 50, @{@"other" : @"data"}, NO) group:group];
+  [_db commitGroup:group];
+
+  XCTAssertEqualObjects([_remoteDocumentBuffer entryForKey:FSTTestDocKey(@"coll/a")],
+                        _kInitialADoc);
+  XCTAssertEqualObjects([_remoteDocumentBuffer entryForKey:FSTTestDocKey(@"coll/b")],
+                        _kInitialBDoc);
+  XCTAssertNil([_remoteDocumentBuffer entryForKey:FSTTestDocKey(@"coll/c")]);
+
+  // Buffered changes still win over prefetched entries.
+  FSTMaybeDocument *newADoc = FSTTestDoc(@"coll/a", 43, @{@"new" : @"data"}, NO);
+  [_remoteDocumentBuffer addEntry:newADoc];
+  XCTAssertEqualObjects([_remoteDocumentBuffer entryForKey:FSTTestDocKey(@"coll/a")], newADoc);
+}
+
 - (void)testApplyChanges {
   FSTMaybeDocument *newADoc = FSTTestDoc(@"coll/a", 43, @{@"new" : @"data"}, NO);
   [_remoteDocumentBuffer addEntry:newADoc];
@@ -105,6 +129,7 @@ NS_ASSUME_NONNULL_BEGIN
 
   XCTAssertThrows([_remoteDocumentBuffer entryForKey:FSTTestDocKey(@"coll/a")]);
   XCTAssertThrows([_remoteDocumentBuffer addEntry:_kInitialADoc]);
+  XCTAssertThrows([_remoteDocumentBuffer prefetchEntriesForKeys:[FSTDocumentKeySet keySet]]);
   XCTAssertThrows([_remoteDocumentBuffer applyToWriteGroup:group]);
 }
 
@@ -18,6 +18,8 @@
 
 #import <XCTest/XCTest.h>
 #include <leveldb/db.h>
+#include <string>
+#include <utility>
 
 #import "Firestore/Protos/objc/firestore/local/Mutation.pbobjc.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
@@ -100,6 +102,61 @@ NS_ASSUME_NONNULL_BEGIN
                          "  - Delete [mutation: userID=user1 batchID=42]>");
 }
 
+- (void)testDescriptionSummarizesRunsOfRemovals {
+  FSTPBWriteBatch *message = [FSTPBWriteBatch message];
+  FSTWriteGroup *group = [FSTWriteGroup groupWithAction:@"Action"];
+  for (FSTBatchID batchID = 1; batchID <= 3; batchID++) {
+    [group removeMessageForKey:[FSTLevelDBMutationKey keyWithUserID:"user1" batchID:batchID]];
+  }
+  [group setMessage:message forKey:[FSTLevelDBMutationKey keyWithUserID:"user1" batchID:4]];
+  [group removeMessageForKey:[FSTLevelDBMutationKey keyWithUserID:"user1" batchID:5]];
+
+  XCTAssertEqualObjects(
+      [group description],
+      @"<FSTWriteGroup for Action: 5 changes (0 bytes):\n"
+       "  - Delete [mutation: userID=user1 batchID=1] through [mutation: userID=user1 batchID=3] "
+       "(3 keys)\n"
+       "  - Put [mutation: userID=user1 batchID=4] (0 bytes)\n"
+       "  - Delete [mutation: userID=user1 batchID=5]>");
+}
+
+- (void)testCommitCompactsRequestedRanges {
+  std::string start = [FSTLevelDBMutationKey keyWithUserID:"user1" batchID:1];
+  std::string end = [FSTLevelDBMutationKey keyWithUserID:"user1" batchID:3];
+
+  FSTWriteGroup *group = [_db startGroupWithAction:@"Delete"];
+  [group removeMessageForKey:start];
+  [group compactRangeFromKey:start toKey:end];
+  XCTAssertEqual([group compactionRanges].size(), 1u);
+  XCTAssertTrue([group compactionRanges][0].first == start);
+  XCTAssertTrue([group compactionRanges][0].second == end);
+  XCTAssertNoThrow([_db commitGroup:group]);
+
+  std::string value;
+  Status status = _db.ptr->Get(ReadOptions(), start, &value);
+  XCTAssertTrue(status.IsNotFound());
+}
+
+- (void)testRemovedKeyRange {
+  FSTPBWriteBatch *message = [FSTPBWriteBatch message];
+  std::string first = [FSTLevelDBMutationKey keyWithUserID:"user1" batchID:2];
+  std::string last = [FSTLevelDBMutationKey keyWithUserID:"user1" batchID:7];
+
+  FSTWriteGroup *group = [FSTWriteGroup groupWithAction:@"Action"];
+  XCTAssertTrue([group removedKeyRange].first.empty());
+
+  [group removeMessageForKey:last];
+  [group setMessage:message forKey:[FSTLevelDBMutationKey keyWithUserID:"user1" batchID:9]];
+  [group removeMessageForKey:first];
+  [group removeMessageForKey:[FSTLevelDBMutationKey keyWithUserID:"user1" batchID:4]];
+  XCTAssertEqual(group.removalCount, 3);
+
+  std::pair<std::string, std::string> range = [group removedKeyRange];
+  XCTAssertTrue(range.first == first);
+  XCTAssertTrue(range.second > last);
+  XCTAssertTrue(range.second < [FSTLevelDBMutationKey keyWithUserID:"user1" batchID:8]);
+}
+
 - (void)testCommittingWrongGroupThrows {
   // If you don't create the group through persistence, it should throw.
   FSTWriteGroup *group = [FSTWriteGroup groupWithAction:@"group"];
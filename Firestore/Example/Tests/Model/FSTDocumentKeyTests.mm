@@ -31,7 +31,17 @@ NS_ASSUME_NONNULL_BEGIN
   FSTResourcePath *path =
       [FSTResourcePath pathWithSegments:@[ @"rooms", @"firestore", @"messages", @"1" ]];
   FSTDocumentKey *key = [FSTDocumentKey keyWithPath:path];
-  XCTAssertEqual(path, key.path);
+  XCTAssertEqualObjects(path, key.path);
+}
+
+- (void)testInterning {
+  FSTDocumentKey *key1 = [FSTDocumentKey keyWithSegments:@[ @"rooms", @"eros" ]];
+  FSTDocumentKey *key2 = [FSTDocumentKey keyWithPathString:@"rooms/eros"];
+  FSTDocumentKey *key3 = [FSTDocumentKey keyWithPathString:@"rooms/other"];
+  XCTAssertEqual(key1, key2);
+  XCTAssertNotEqual(key1, key3);
+  XCTAssertEqual(key1.hash, key2.hash);
+  XCTAssertTrue([key1 isEqual:key2]);
 }
 
 - (void)testComparison {
@@ -53,6 +63,11 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqual(NSOrderedDescending, [a compare:empty]);
   XCTAssertEqual(NSOrderedDescending, [b compare:a]);
   XCTAssertEqual(NSOrderedDescending, [ab compare:a]);
+
+  // Segments compare by their UTF-8 bytes.
+  FSTDocumentKey *upper = [FSTDocumentKey keyWithSegments:@[ @"a", @"B" ]];
+  FSTDocumentKey *lower = [FSTDocumentKey keyWithSegments:@[ @"a", @"a" ]];
+  XCTAssertEqual(NSOrderedAscending, [upper compare:lower]);
 }
 
 @end
@@ -79,6 +79,30 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqualObjects([[set documentEnumerator] allObjects], (@[ _doc3, _doc1, _doc2 ]));
 }
 
+- (void)testPositionalAccess {
+  FSTDocumentSet *set = FSTTestDocSet(_comp, @[ _doc1, _doc2, _doc3 ]);
+  XCTAssertEqualObjects([set documentAtIndex:0], _doc3);
+  XCTAssertEqualObjects([set documentAtIndex:1], _doc1);
+  XCTAssertEqualObjects([set documentAtIndex:2], _doc2);
+  XCTAssertEqual([set indexOfKey:_doc3.key], 0);
+  XCTAssertEqual([set indexOfKey:_doc2.key], 2);
+  XCTAssertEqual([set indexOfKey:FSTTestDocKey(@"docs/4")], NSNotFound);
+
+  // Large enough to be backed by a tree.
+  NSMutableArray<FSTDocument *> *docs = [NSMutableArray array];
+  for (int i = 0; i < 100; i++) {
+    NSString *path = [NSString stringWithFormat:@"docs/%d", i];
+    [docs addObject:FSTTestDoc(path, 0, @{@"sort" : @(-i)}, NO)];
+  }
+  set = FSTTestDocSet(_comp, docs);
+  for (int i = 0; i < 100; i++) {
+    XCTAssertEqual([set indexOfKey:docs[i].key], 99 - i);
+    XCTAssertEqualObjects([set documentAtIndex:99 - i], docs[i]);
+  }
+  XCTAssertEqualObjects([set firstDocument], docs[99]);
+  XCTAssertEqualObjects([set lastDocument], docs[0]);
+}
+
 - (void)testDeletes {
   FSTDocumentSet *set = FSTTestDocSet(_comp, @[ _doc1, _doc2, _doc3 ]);
 
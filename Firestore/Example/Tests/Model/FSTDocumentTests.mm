@@ -61,6 +61,43 @@ NS_ASSUME_NONNULL_BEGIN
                         [FSTStringValue stringValue:@"scallywag"]);
 }
 
+- (void)testDecodesFieldsOnDemand {
+  NSDictionary<NSString *, id> *values = @{
+    @"desc" : @"Discuss all the project related stuff",
+    @"owner" : @{@"name" : @"Jonny", @"title" : @"scallywag"}
+  };
+  FSTObjectValue *data = FSTTestObjectValue(values);
+  NSMutableArray<NSString *> *decodedFields = [NSMutableArray array];
+  __block int dataDecodes = 0;
+  FSTDocument *doc = [FSTDocument documentWithKey:FSTTestDocKey(@"rooms/eros")
+      version:FSTTestVersion(1)
+      hasLocalMutations:NO
+      fieldDecoder:^FSTFieldValue *_Nullable(NSString *fieldName) {
+        [decodedFields addObject:fieldName];
+        return [data valueForPath:FSTTestFieldPath(fieldName)];
+      }
+      dataDecoder:^FSTObjectValue * {
+        dataDecodes++;
+        return data;
+      }];
+
+  XCTAssertEqualObjects([doc fieldForPath:FSTTestFieldPath(@"owner.title")],
+                        [FSTStringValue stringValue:@"scallywag"]);
+  XCTAssertEqualObjects([doc fieldForPath:FSTTestFieldPath(@"owner.name")],
+                        [FSTStringValue stringValue:@"Jonny"]);
+  XCTAssertNil([doc fieldForPath:FSTTestFieldPath(@"missing")]);
+  XCTAssertNil([doc fieldForPath:FSTTestFieldPath(@"desc.nested")]);
+  XCTAssertEqualObjects(decodedFields, (@[ @"owner", @"missing", @"desc" ]));
+  XCTAssertEqual(dataDecodes, 0);
+
+  XCTAssertEqualObjects(doc.data, data);
+  XCTAssertEqualObjects(doc, FSTTestDoc(@"rooms/eros", 1, values, NO));
+  XCTAssertEqualObjects([doc fieldForPath:FSTTestFieldPath(@"desc")],
+                        [FSTStringValue stringValue:@"Discuss all the project related stuff"]);
+  XCTAssertEqual(dataDecodes, 1);
+  XCTAssertEqual(decodedFields.count, 3);
+}
+
 - (void)testIsEqual {
   XCTAssertEqualObjects(FSTTestDoc(@"messages/first", 1,
                                    @{ @"a" : @1 }, NO),
@@ -305,6 +305,30 @@ union DoubleBits {
   XCTAssertNil([obj valueForPath:FSTTestFieldPath(@"bar.a")]);
 }
 
+- (void)testExtractsFieldsAfterRepeatedLookups {
+  FSTObjectValue *obj = FSTTestObjectValue(
+      @{ @"foo" : @{@"a" : @YES, @"b" : @{@"c" : @"string"}},
+         @"bar" : @1 });
+
+  // Repeated lookups of nested paths switch to an index of the nested fields, which must give the
+  // same results.
+  for (int i = 0; i < 20; i++) {
+    FSTAssertIsKindOfClass([obj valueForPath:FSTTestFieldPath(@"foo")], FSTObjectValue);
+    XCTAssertEqualObjects([obj valueForPath:FSTTestFieldPath(@"foo.a")],
+                          [FSTBooleanValue trueValue]);
+    FSTAssertIsKindOfClass([obj valueForPath:FSTTestFieldPath(@"foo.b")], FSTObjectValue);
+    XCTAssertEqualObjects([obj valueForPath:FSTTestFieldPath(@"foo.b.c")],
+                          [FSTStringValue stringValue:@"string"]);
+    XCTAssertEqualObjects([obj valueForPath:FSTTestFieldPath(@"bar")],
+                          [FSTIntegerValue integerValue:1]);
+
+    XCTAssertNil([obj valueForPath:FSTTestFieldPath(@"foo.a.b")]);
+    XCTAssertNil([obj valueForPath:FSTTestFieldPath(@"foo.c")]);
+    XCTAssertNil([obj valueForPath:FSTTestFieldPath(@"bar.a")]);
+    XCTAssertNil([obj valueForPath:FSTTestFieldPath(@"baz.a")]);
+  }
+}
+
 - (void)testOverwritesExistingFields {
   FSTObjectValue *old = FSTTestObjectValue(@{@"a" : @"old"});
   FSTObjectValue *mod =
@@ -408,6 +432,51 @@ union DoubleBits {
   XCTAssertEqualObjects(mod, FSTTestFieldValue(@{}));
 }
 
+- (void)testSetsManyPathsAtOnce {
+  FSTObjectValue *old = FSTTestObjectValue(@{ @"a" : @{@"b" : @"old", @"c" : @1}, @"d" : @"old" });
+  NSArray<FSTFieldPath *> *paths = @[
+    FSTTestFieldPath(@"a.b"), FSTTestFieldPath(@"d.e"), FSTTestFieldPath(@"a.f.g"),
+    FSTTestFieldPath(@"a.f"), FSTTestFieldPath(@"a.f.h")
+  ];
+  NSArray<FSTFieldValue *> *values = @[
+    FSTTestFieldValue(@"mod"), FSTTestFieldValue(@2), FSTTestFieldValue(@"hidden"),
+    FSTTestFieldValue(@{@"i" : @3}), FSTTestFieldValue(@4)
+  ];
+  FSTObjectValue *mod = [old objectBySettingValues:values forPaths:paths];
+
+  // Later paths win over earlier ones, just as when the paths are set one at a time.
+  FSTObjectValue *expected = old;
+  for (NSUInteger i = 0; i < paths.count; i++) {
+    expected = [expected objectBySettingValue:values[i] forPath:paths[i]];
+  }
+  XCTAssertEqualObjects(mod, expected);
+  XCTAssertEqualObjects(mod, FSTTestFieldValue(@{
+                          @"a" : @{@"b" : @"mod", @"c" : @1, @"f" : @{@"i" : @3, @"h" : @4}},
+                          @"d" : @{@"e" : @2}
+                        }));
+  XCTAssertEqualObjects(
+      old, FSTTestFieldValue(@{ @"a" : @{@"b" : @"old", @"c" : @1}, @"d" : @"old" }));
+}
+
+- (void)testCopiesManyPathsAtOnce {
+  FSTObjectValue *old =
+      FSTTestObjectValue(@{ @"a" : @{@"b" : @1, @"c" : @2}, @"d" : @3, @"e" : @"old" });
+  FSTObjectValue *source = FSTTestObjectValue(@{ @"a" : @{@"b" : @"mod"}, @"f" : @{@"g" : @4} });
+  FSTObjectValue *mod = [old objectByCopyingPaths:@[
+    FSTTestFieldPath(@"a.b"), FSTTestFieldPath(@"a.c"), FSTTestFieldPath(@"d"),
+    FSTTestFieldPath(@"e.x"), FSTTestFieldPath(@"f.g")
+  ]
+                                       fromObject:source];
+
+  // Paths missing from the source are deleted; deleting below a primitive leaves it alone.
+  XCTAssertEqualObjects(
+      mod, FSTTestFieldValue(@{ @"a" : @{@"b" : @"mod"}, @"e" : @"old", @"f" : @{@"g" : @4} }));
+
+  FSTObjectValue *unchanged = [old objectByCopyingPaths:@[ FSTTestFieldPath(@"x.y") ]
+                                             fromObject:source];
+  XCTAssertEqual(old, unchanged);
+}
+
 - (void)testArrays {
   FSTArrayValue *expected = [[FSTArrayValue alloc]
       initWithValueNoCopy:@[ [FSTStringValue stringValue:@"value"], [FSTBooleanValue trueValue] ]];
@@ -488,6 +557,14 @@ union DoubleBits {
   FSTAssertEqualityGroups(groups);
 }
 
+- (void)testObjectKeysCompareInUTF8Order {
+  // U+FFFF sorts before U+1F600 in UTF-8, though its UTF-16 encoding sorts after the surrogates.
+  FSTObjectValue *bmp = FSTTestObjectValue(@{@"\uFFFF" : @1});
+  FSTObjectValue *emoji = FSTTestObjectValue(@{@"\U0001F600" : @1});
+  XCTAssertEqual(NSOrderedAscending, [bmp compare:emoji]);
+  XCTAssertEqual(NSOrderedDescending, [emoji compare:bmp]);
+}
+
 - (void)testValueOrdering {
   NSArray *groups = @[
     // null first
@@ -579,4 +656,37 @@ union DoubleBits {
   }
 }
 
+- (void)testConvertsToAndFromModelValues {
+  FSTObjectValue *value = FSTTestObjectValue(@{
+    @"null" : [NSNull null],
+    @"bool" : @YES,
+    @"int" : @42,
+    @"double" : @1.5,
+    @"string" : @"hello",
+    @"date" : [NSDate dateWithTimeIntervalSince1970:1234.5],
+    @"geo" : FSTTestGeoPoint(1, 2),
+    @"blob" : FSTTestData(1, 2, 3, -1),
+    @"array" : @[ @1, @"two", @{@"three" : @3} ],
+    @"object" : @{@"nested" : @{@"deep" : @YES}}
+  });
+  FSTFieldValue *serverTimestamp = [FSTServerTimestampValue
+      serverTimestampValueWithLocalWriteTime:FSTTestTimestamp(2016, 5, 20, 10, 20, 0)
+                               previousValue:FSTTestFieldValue([NSDate date])];
+
+  for (FSTFieldValue *original in @[ value, serverTimestamp ]) {
+    firebase::firestore::model::FieldValue modelValue;
+    XCTAssertTrue([original convertToModelValue:&modelValue]);
+    XCTAssertEqualObjects([FSTFieldValue fieldValueWithModelValue:modelValue], original);
+  }
+
+  // References can't be represented in C++ yet, even when nested.
+  FSTFieldValue *reference =
+      [FSTReferenceValue referenceValue:FSTTestDocKey(@"coll/doc")
+                             databaseID:[FSTDatabaseID databaseIDWithProject:@"project"
+                                                                    database:kDefaultDatabaseID]];
+  FSTArrayValue *array = [[FSTArrayValue alloc] initWithValueNoCopy:@[ reference ]];
+  firebase::firestore::model::FieldValue modelValue;
+  XCTAssertFalse([array convertToModelValue:&modelValue]);
+}
+
 @end
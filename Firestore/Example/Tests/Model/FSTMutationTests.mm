@@ -188,6 +188,65 @@
   XCTAssertEqualObjects(patchedDoc, FSTTestDoc(@"collection/key", 0, expectedData, NO));
 }
 
+- (void)testReportsAffectedFieldPaths {
+  FSTMutation *set = FSTTestSetMutation(@"collection/key", @{@"foo" : @"bar"});
+  XCTAssertNil([set affectedFieldPaths]);
+  XCTAssertTrue([set mayAffectFieldPath:FSTTestFieldPath(@"baz")]);
+
+  FSTMutation *delete = FSTTestDeleteMutation(@"collection/key");
+  XCTAssertNil([delete affectedFieldPaths]);
+  XCTAssertTrue([delete mayAffectFieldPath:FSTTestFieldPath(@"baz")]);
+
+  FSTMutation *patch = FSTTestPatchMutation(@"collection/key", @{@"foo.bar" : @"baz"}, nil);
+  XCTAssertEqualObjects([patch affectedFieldPaths], @[ FSTTestFieldPath(@"foo.bar") ]);
+  XCTAssertTrue([patch mayAffectFieldPath:FSTTestFieldPath(@"foo")]);
+  XCTAssertTrue([patch mayAffectFieldPath:FSTTestFieldPath(@"foo.bar")]);
+  XCTAssertTrue([patch mayAffectFieldPath:FSTTestFieldPath(@"foo.bar.baz")]);
+  XCTAssertFalse([patch mayAffectFieldPath:FSTTestFieldPath(@"foo.baz")]);
+  XCTAssertFalse([patch mayAffectFieldPath:FSTTestFieldPath(@"bar")]);
+
+  FSTMutation *transform = FSTTestTransformMutation(@"collection/key", @[ @"foo.bar" ]);
+  XCTAssertEqualObjects([transform affectedFieldPaths], @[ FSTTestFieldPath(@"foo.bar") ]);
+  XCTAssertFalse([transform mayAffectFieldPath:FSTTestFieldPath(@"bar")]);
+}
+
+- (void)testSquashesMutations {
+  NSDictionary *docData = @{ @"foo" : @{@"bar" : @"bar-value"}, @"baz" : @"baz-value" };
+  FSTDocument *baseDoc = FSTTestDoc(@"collection/key", 0, docData, NO);
+
+  FSTMutation *set = FSTTestSetMutation(@"collection/key", @{@"foo" : @{@"bar" : @"set-value"}});
+  FSTMutation *patch1 = FSTTestPatchMutation(@"collection/key", @{@"foo.bar" : @"new-bar"}, nil);
+  FSTMutation *patch2 = FSTTestPatchMutation(@"collection/key", @{@"qux" : @"qux-value"}, nil);
+  FSTMutation *deletion = FSTTestDeleteMutation(@"collection/key");
+  FSTMutation *transform = FSTTestTransformMutation(@"collection/key", @[ @"foo.bar" ]);
+
+  // Squashed mutations must produce the same document as applying them one after another.
+  NSArray<NSArray<FSTMutation *> *> *squashable =
+      @[ @[ set, patch1 ], @[ patch1, patch2 ], @[ set, deletion ], @[ deletion, set ] ];
+  for (NSArray<FSTMutation *> *pair in squashable) {
+    FSTMutation *squashed = [pair[0] mutationBySquashingMutation:pair[1]];
+    XCTAssertNotNil(squashed);
+    FSTMaybeDocument *expected =
+        [pair[0] applyTo:baseDoc baseDocument:baseDoc localWriteTime:_timestamp];
+    expected = [pair[1] applyTo:expected baseDocument:baseDoc localWriteTime:_timestamp];
+    XCTAssertEqualObjects(
+        [squashed applyTo:baseDoc baseDocument:baseDoc localWriteTime:_timestamp], expected);
+  }
+
+  XCTAssertEqual([[set mutationBySquashingMutation:patch1] class], [FSTSetMutation class]);
+  FSTMutation *patches = [patch1 mutationBySquashingMutation:patch2];
+  XCTAssertEqualObjects(
+      [patches affectedFieldPaths],
+      (@[ FSTTestFieldPath(@"foo.bar"), FSTTestFieldPath(@"qux") ]));
+
+  // The precondition of a patch can't be checked once it's folded into a delete, and transforms
+  // are sent separately.
+  XCTAssertNil([patch1 mutationBySquashingMutation:deletion]);
+  XCTAssertNil([deletion mutationBySquashingMutation:patch1]);
+  XCTAssertNil([set mutationBySquashingMutation:transform]);
+  XCTAssertNil([transform mutationBySquashingMutation:patch1]);
+}
+
 #define ASSERT_VERSION_TRANSITION(mutation, base, expected)                                 \
   do {                                                                                      \
     FSTMutationResult *mutationResult =                                                     \
@@ -113,6 +113,14 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqual(NSOrderedDescending, [ab compare:a]);
 }
 
+- (void)testPathComparisonUsesUTF8Order {
+  // U+FFFF sorts before U+1F600 in UTF-8, though its UTF-16 encoding sorts after the surrogates.
+  FSTFieldPath *bmp = [FSTFieldPath pathWithSegments:@[ @"\uFFFF" ]];
+  FSTFieldPath *emoji = [FSTFieldPath pathWithSegments:@[ @"\U0001F600" ]];
+  XCTAssertEqual(NSOrderedAscending, [bmp compare:emoji]);
+  XCTAssertEqual(NSOrderedDescending, [emoji compare:bmp]);
+}
+
 - (void)testIsPrefixOfPath {
   FSTFieldPath *empty = [FSTFieldPath pathWithSegments:@[]];
   FSTFieldPath *a = [FSTFieldPath pathWithSegments:@[ @"a" ]];
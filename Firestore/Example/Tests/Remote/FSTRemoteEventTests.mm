@@ -19,6 +19,7 @@
 #import <XCTest/XCTest.h>
 
 #import "Firestore/Source/Local/FSTQueryData.h"
+#import "Firestore/Source/Model/FSTDatabaseID.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTDocumentKey.h"
 #import "Firestore/Source/Remote/FSTExistenceFilter.h"
@@ -149,6 +150,28 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqual(event.targetChanges.count, 1);
 }
 
+- (void)testWillCountDownPendingTargetResponses {
+  FSTWatchChange *change1 = [FSTWatchTargetChange changeWithState:FSTWatchTargetChangeStateRemoved
+                                                        targetIDs:@[ @1, @2 ]
+                                                            cause:nil];
+
+  FSTWatchChange *change2 = [FSTWatchTargetChange changeWithState:FSTWatchTargetChangeStateAdded
+                                                        targetIDs:@[ @1 ]
+                                                            cause:nil];
+
+  // Target 1 was unwatched and watched twice, target 2 was unwatched and target 3 gets no
+  // response in this batch.
+  NSDictionary<NSNumber *, NSNumber *> *pendingResponses = @{ @1 : @3, @2 : @1, @3 : @1 };
+
+  FSTWatchChangeAggregator *aggregator =
+      [self aggregatorWithTargets:@[ @1, @3 ]
+                      outstanding:pendingResponses
+                          changes:@[ change1, change2 ]];
+  FSTRemoteEvent *event = [aggregator remoteEvent];
+  XCTAssertEqual(event.targetChanges.count, 0);
+  XCTAssertEqualObjects(aggregator.pendingTargetResponses, (@{ @1 : @1, @3 : @1 }));
+}
+
 - (void)testWillIgnoreEventsForRemovedTargets {
   FSTDocument *doc1 = FSTTestDoc(@"docs/1", 1, @{ @"value" : @1 }, NO);
 
@@ -442,6 +465,137 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqual(event.targetChanges[@1].resumeToken.length, 0);
 }
 
+- (void)testRemoveDocumentKeyFromTarget {
+  FSTDocument *doc1 = FSTTestDoc(@"docs/1", 1, @{ @"value" : @1 }, NO);
+  FSTRemoteEvent *event =
+      [FSTRemoteEvent eventWithSnapshotVersion:FSTTestVersion(3)
+                                 targetChanges:[NSMutableDictionary dictionary]
+                               documentUpdates:[NSMutableDictionary dictionary]];
+
+  [event removeDocumentKey:doc1.key fromTargetID:@1];
+
+  FSTUpdateMapping *mapping =
+      [FSTUpdateMapping mappingWithAddedDocuments:@[] removedDocuments:@[ doc1 ]];
+  XCTAssertEqualObjects(event.targetChanges[@1].mapping, mapping);
+  XCTAssertEqualObjects(event.targetChanges[@1].snapshotVersion, FSTTestVersion(3));
+  XCTAssertEqual(event.targetChanges[@1].currentStatusUpdate, FSTCurrentStatusUpdateNone);
+}
+
+- (void)testMergeRemoteEvents {
+  FSTDocument *doc1 = FSTTestDoc(@"docs/1", 1, @{ @"value" : @1 }, NO);
+  FSTDocument *doc1b = FSTTestDoc(@"docs/1", 2, @{ @"value" : @2 }, NO);
+  FSTDocument *doc2 = FSTTestDoc(@"docs/2", 2, @{ @"value" : @2 }, NO);
+  FSTDocument *doc3 = FSTTestDoc(@"docs/3", 1, @{ @"value" : @3 }, NO);
+
+  NSMutableDictionary<FSTBoxedTargetID *, FSTTargetChange *> *targetChanges1 = [@{
+    @1 : [FSTTargetChange changeWithDocuments:@[ doc1, doc3 ]
+                          currentStatusUpdate:FSTCurrentStatusUpdateMarkCurrent],
+    @2 : [FSTTargetChange changeWithDocuments:@[ doc1 ]
+                          currentStatusUpdate:FSTCurrentStatusUpdateNone]
+  } mutableCopy];
+  FSTRemoteEvent *event1 = [FSTRemoteEvent
+      eventWithSnapshotVersion:FSTTestVersion(1)
+                 targetChanges:targetChanges1
+               documentUpdates:[@{doc1.key : doc1, doc3.key : doc3} mutableCopy]];
+
+  FSTDeletedDocument *deletedDoc3 = FSTTestDeletedDoc(@"docs/3", 2);
+  NSMutableDictionary<FSTBoxedTargetID *, FSTTargetChange *> *targetChanges2 = [@{
+    @1 : [FSTTargetChange changeWithDocuments:@[ doc2, deletedDoc3 ]
+                          currentStatusUpdate:FSTCurrentStatusUpdateNone],
+    @3 : [FSTTargetChange changeWithDocuments:@[ doc2 ]
+                          currentStatusUpdate:FSTCurrentStatusUpdateNone]
+  } mutableCopy];
+  FSTRemoteEvent *event2 = [FSTRemoteEvent
+      eventWithSnapshotVersion:FSTTestVersion(2)
+                 targetChanges:targetChanges2
+               documentUpdates:[@{doc1.key : doc1b, doc2.key : doc2, doc3.key : deletedDoc3}
+                                   mutableCopy]];
+
+  [event1 mergeRemoteEvent:event2];
+
+  XCTAssertEqualObjects(event1.snapshotVersion, FSTTestVersion(2));
+  XCTAssertEqual(event1.documentUpdates.count, 3);
+  XCTAssertEqualObjects(event1.documentUpdates[doc1.key], doc1b);
+  XCTAssertEqualObjects(event1.documentUpdates[doc3.key], deletedDoc3);
+
+  XCTAssertEqual(event1.targetChanges.count, 3);
+  FSTUpdateMapping *mapping1 =
+      [FSTUpdateMapping mappingWithAddedDocuments:@[ doc1, doc2 ] removedDocuments:@[ doc3 ]];
+  XCTAssertEqualObjects(event1.targetChanges[@1].mapping, mapping1);
+  XCTAssertEqual(event1.targetChanges[@1].currentStatusUpdate, FSTCurrentStatusUpdateMarkCurrent);
+  FSTUpdateMapping *mapping2 =
+      [FSTUpdateMapping mappingWithAddedDocuments:@[ doc1 ] removedDocuments:@[]];
+  XCTAssertEqualObjects(event1.targetChanges[@2].mapping, mapping2);
+  FSTUpdateMapping *mapping3 =
+      [FSTUpdateMapping mappingWithAddedDocuments:@[ doc2 ] removedDocuments:@[]];
+  XCTAssertEqualObjects(event1.targetChanges[@3].mapping, mapping3);
+}
+
+- (void)testExistenceFilterBloomFilter {
+  FSTDatabaseID *databaseID = [FSTDatabaseID databaseIDWithProject:@"p" database:@"d"];
+  FSTDocumentKey *key = FSTTestDocKey(@"docs/1");
+
+  FSTExistenceFilter *plain = [FSTExistenceFilter filterWithCount:1];
+  XCTAssertFalse(plain.hasBloomFilter);
+  XCTAssertTrue([plain mightContainKey:key inDatabase:databaseID]);
+
+  uint8_t zeros[4] = {0, 0, 0, 0};
+  FSTExistenceFilter *empty =
+      [FSTExistenceFilter filterWithCount:0
+                        bloomFilterBitmap:[NSData dataWithBytes:zeros length:sizeof(zeros)]
+                                  padding:0
+                                hashCount:3];
+  XCTAssertTrue(empty.hasBloomFilter);
+  XCTAssertFalse([empty mightContainKey:key inDatabase:databaseID]);
+
+  uint8_t ones[4] = {0xff, 0xff, 0xff, 0xff};
+  FSTExistenceFilter *full =
+      [FSTExistenceFilter filterWithCount:1
+                        bloomFilterBitmap:[NSData dataWithBytes:ones length:sizeof(ones)]
+                                  padding:0
+                                hashCount:3];
+  XCTAssertTrue([full mightContainKey:key inDatabase:databaseID]);
+  XCTAssertNotEqualObjects(empty, full);
+}
+
+- (void)testExistenceFilterHashesFullDocumentNames {
+  // The bits the backend sets for "projects/p/databases/d/documents/docs/1" with 3 hashes.
+  uint8_t bits[4] = {0x20, 0x02, 0x80, 0x00};
+  FSTExistenceFilter *filter =
+      [FSTExistenceFilter filterWithCount:1
+                        bloomFilterBitmap:[NSData dataWithBytes:bits length:sizeof(bits)]
+                                  padding:0
+                                hashCount:3];
+
+  FSTDatabaseID *databaseID = [FSTDatabaseID databaseIDWithProject:@"p" database:@"d"];
+  XCTAssertTrue([filter mightContainKey:FSTTestDocKey(@"docs/1") inDatabase:databaseID]);
+  XCTAssertFalse([filter mightContainKey:FSTTestDocKey(@"docs/2") inDatabase:databaseID]);
+
+  FSTDatabaseID *otherDatabaseID = [FSTDatabaseID databaseIDWithProject:@"p" database:@"other"];
+  XCTAssertFalse([filter mightContainKey:FSTTestDocKey(@"docs/1") inDatabase:otherDatabaseID]);
+}
+
+- (void)testExistenceFilterIgnoresInvalidBloomFilter {
+  FSTDocumentKey *key = FSTTestDocKey(@"docs/1");
+  FSTDatabaseID *databaseID = [FSTDatabaseID databaseIDWithProject:@"p" database:@"d"];
+  uint8_t zeros[4] = {0, 0, 0, 0};
+  NSData *bitmap = [NSData dataWithBytes:zeros length:sizeof(zeros)];
+
+  FSTExistenceFilter *badPadding =
+      [FSTExistenceFilter filterWithCount:1 bloomFilterBitmap:bitmap padding:8 hashCount:3];
+  XCTAssertFalse(badPadding.hasBloomFilter);
+  XCTAssertTrue([badPadding mightContainKey:key inDatabase:databaseID]);
+  XCTAssertEqualObjects(badPadding, [FSTExistenceFilter filterWithCount:1]);
+
+  FSTExistenceFilter *badHashCount =
+      [FSTExistenceFilter filterWithCount:1 bloomFilterBitmap:bitmap padding:0 hashCount:0];
+  XCTAssertFalse(badHashCount.hasBloomFilter);
+
+  FSTExistenceFilter *paddedEmpty =
+      [FSTExistenceFilter filterWithCount:0 bloomFilterBitmap:[NSData data] padding:1 hashCount:0];
+  XCTAssertFalse(paddedEmpty.hasBloomFilter);
+}
+
 - (void)testDocumentUpdate {
   FSTDocument *doc1 = FSTTestDoc(@"docs/1", 1, @{ @"value" : @1 }, NO);
   FSTDeletedDocument *deletedDoc1 =
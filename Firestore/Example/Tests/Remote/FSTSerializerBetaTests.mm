@@ -62,6 +62,9 @@ NS_ASSUME_NONNULL_BEGIN
     (NSArray<FSTFieldTransform *> *)fieldTransforms;
 
 - (GCFSStructuredQuery_Filter *)encodedRelationFilter:(FSTRelationFilter *)filter;
+
+- (NSString *)encodedQueryPath:(FSTResourcePath *)path;
+- (FSTResourcePath *)decodedQueryPath:(NSString *)name;
 @end
 
 @interface GCFSStructuredQuery_Order (Test)
@@ -240,6 +243,24 @@ NS_ASSUME_NONNULL_BEGIN
                            type:GCFSValue_ValueType_OneOfCase_ReferenceValue];
 }
 
+- (void)testEncodesDocumentKeysAndQueryPaths {
+  FSTDocumentKey *key = FSTTestDocKey(@"rooms/abc/messages/1");
+  NSString *name = @"projects/p/databases/d/documents/rooms/abc/messages/1";
+  XCTAssertEqualObjects([self.serializer encodedDocumentKey:key], name);
+  XCTAssertEqualObjects([self.serializer decodedDocumentKey:name], key);
+
+  FSTResourcePath *path = FSTTestPath(@"rooms/abc/messages");
+  NSString *parent = @"projects/p/databases/d/documents/rooms/abc/messages";
+  XCTAssertEqualObjects([self.serializer encodedQueryPath:path], parent);
+  XCTAssertEqualObjects([self.serializer decodedQueryPath:parent], path);
+
+  FSTResourcePath *root = FSTTestPath(@"");
+  XCTAssertEqualObjects([self.serializer encodedQueryPath:root], @"projects/p/databases/d");
+  XCTAssertEqualObjects([self.serializer decodedQueryPath:@"projects/p/databases/d"], root);
+  XCTAssertEqualObjects([self.serializer decodedQueryPath:@"projects/p/databases/d/documents"],
+                        root);
+}
+
 - (void)testEncodesArrays {
   FSTFieldValue *model = FSTTestFieldValue(@[ @YES, @"foo" ]);
 
@@ -394,6 +415,23 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqualObjects(set, decoded);
 }
 
+- (void)testEncodesMutationsOnce {
+  FSTMutation *set = FSTTestSetMutation(@"collection/key", @{@"a" : @"b"});
+  GCFSWrite *encoded = [self.serializer encodedMutation:set];
+  XCTAssertEqual([self.serializer encodedMutation:set], encoded);
+
+  // Decoded mutations reuse the proto they were decoded from.
+  FSTMutation *decoded = [self.serializer decodedMutation:encoded];
+  XCTAssertEqual([self.serializer encodedMutation:decoded], encoded);
+
+  // A serializer for another database encodes the mutation afresh.
+  FSTSerializerBeta *other = [[FSTSerializerBeta alloc]
+      initWithDatabaseID:[FSTDatabaseID databaseIDWithProject:@"p" database:@"other"]];
+  GCFSWrite *otherEncoded = [other encodedMutation:set];
+  XCTAssertNotEqual(otherEncoded, encoded);
+  XCTAssertNotEqualObjects(otherEncoded, encoded);
+}
+
 - (void)testEncodesListenRequestLabels {
   FSTQuery *query = FSTTestQuery(@"collection/key");
   FSTQueryData *queryData = [[FSTQueryData alloc] initWithQuery:query
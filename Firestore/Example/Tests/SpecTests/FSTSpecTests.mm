@@ -58,6 +58,8 @@ static NSString *const kNoIOSTag = @"no-ios";
 
 // Some config info for the currently running spec; used when restarting the driver (for doRestart).
 @property(nonatomic, assign) BOOL GCEnabled;
+@property(nonatomic, assign) BOOL targetMultiplexingEnabled;
+@property(nonatomic, strong, nullable) NSNumber *maxConcurrentLimboResolutions;
 @property(nonatomic, strong) id<FSTPersistence> driverPersistence;
 @end
 
@@ -72,11 +74,24 @@ static NSString *const kNoIOSTag = @"no-ios";
   self.driverPersistence = [self persistence];
   NSNumber *GCEnabled = config[@"useGarbageCollection"];
   self.GCEnabled = [GCEnabled boolValue];
+  NSNumber *targetMultiplexingEnabled = config[@"targetMultiplexingEnabled"];
+  self.targetMultiplexingEnabled = [targetMultiplexingEnabled boolValue];
+  self.maxConcurrentLimboResolutions = config[@"maxConcurrentLimboResolutions"];
   self.driver = [[FSTSyncEngineTestDriver alloc] initWithPersistence:self.driverPersistence
                                                     garbageCollector:self.garbageCollector];
+  [self configureDriver];
   [self.driver start];
 }
 
+/** Applies the sync engine options of the test configuration to the driver. */
+- (void)configureDriver {
+  self.driver.targetMultiplexingEnabled = self.targetMultiplexingEnabled;
+  if (self.maxConcurrentLimboResolutions) {
+    self.driver.maxConcurrentLimboResolutions =
+        [self.maxConcurrentLimboResolutions unsignedIntegerValue];
+  }
+}
+
 - (void)tearDownForSpec {
   [self.driver shutdown];
   [self.driverPersistence shutdown];
@@ -349,6 +364,7 @@ static NSString *const kNoIOSTag = @"no-ios";
                                                     garbageCollector:self.garbageCollector
                                                          initialUser:self.driver.currentUser
                                                    outstandingWrites:outstandingWrites];
+  [self configureDriver];
   [self.driver start];
 }
 
@@ -99,6 +99,12 @@ typedef NSDictionary<FSTUser *, NSArray<FSTOutstandingWrite *> *> FSTOutstanding
 
 - (instancetype)init NS_UNAVAILABLE;
 
+/** Whether the FSTSyncEngine serves all queries on a collection from one shared target. */
+@property(nonatomic, assign, getter=isTargetMultiplexingEnabled) BOOL targetMultiplexingEnabled;
+
+/** The maximum number of limbo documents the FSTSyncEngine resolves at once. */
+@property(nonatomic, assign) NSUInteger maxConcurrentLimboResolutions;
+
 /** Starts the FSTSyncEngine and its underlying components. */
 - (void)start;
 
@@ -149,6 +149,22 @@ NS_ASSUME_NONNULL_BEGIN
   [self.eventManager applyChangedOnlineState:onlineState];
 }
 
+- (BOOL)isTargetMultiplexingEnabled {
+  return self.syncEngine.isTargetMultiplexingEnabled;
+}
+
+- (void)setTargetMultiplexingEnabled:(BOOL)targetMultiplexingEnabled {
+  self.syncEngine.targetMultiplexingEnabled = targetMultiplexingEnabled;
+}
+
+- (NSUInteger)maxConcurrentLimboResolutions {
+  return self.syncEngine.maxConcurrentLimboResolutions;
+}
+
+- (void)setMaxConcurrentLimboResolutions:(NSUInteger)maxConcurrentLimboResolutions {
+  self.syncEngine.maxConcurrentLimboResolutions = maxConcurrentLimboResolutions;
+}
+
 - (void)start {
   [self.localStore start];
   [self.remoteStore start];
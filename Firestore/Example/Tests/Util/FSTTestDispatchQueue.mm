@@ -42,15 +42,18 @@ static const NSTimeInterval kTestDispatchDelay = 1.0;
   return (self = [super initWithQueue:dispatchQueue]);
 }
 
-- (void)dispatchAfterDelay:(NSTimeInterval)delay block:(void (^)(void))block {
-  [super dispatchAfterDelay:MIN(delay, kTestDispatchDelay)
-                      block:^() {
-                        block();
-                        if (delay == kIdleDispatchDelay) {
-                          [_expectation fulfill];
-                          _expectation = nil;
-                        }
-                      }];
+- (FSTDelayedCallback*)dispatchAfterDelay:(NSTimeInterval)delay
+                            coalescingTag:(NSString*)tag
+                                    block:(void (^)(void))block {
+  return [super dispatchAfterDelay:MIN(delay, kTestDispatchDelay)
+                     coalescingTag:tag
+                             block:^() {
+                               block();
+                               if (delay == kIdleDispatchDelay) {
+                                 [_expectation fulfill];
+                                 _expectation = nil;
+                               }
+                             }];
 }
 
 - (void)fulfillOnExecution:(XCTestExpectation*)expectation {
@@ -160,6 +160,7 @@ typedef GPB_ENUM(FSTPBTargetGlobal_FieldNumber) {
   FSTPBTargetGlobal_FieldNumber_HighestTargetId = 1,
   FSTPBTargetGlobal_FieldNumber_HighestListenSequenceNumber = 2,
   FSTPBTargetGlobal_FieldNumber_LastRemoteSnapshotVersion = 3,
+  FSTPBTargetGlobal_FieldNumber_RemoteDocumentGeneration = 4,
 };
 
 /**
@@ -197,6 +198,16 @@ typedef GPB_ENUM(FSTPBTargetGlobal_FieldNumber) {
 /** Test to see if @c lastRemoteSnapshotVersion has been set. */
 @property(nonatomic, readwrite) BOOL hasLastRemoteSnapshotVersion;
 
+/**
+ * The generation of the remote document cache's contents. Compacted
+ * snapshot files of the cache record the generation they were written at
+ * and are only read while it's still current.
+ *
+ * This is incremented by the first change to remote documents after a
+ * snapshot file is written.
+ **/
+@property(nonatomic, readwrite) int64_t remoteDocumentGeneration;
+
 @end
 
 NS_ASSUME_NONNULL_END
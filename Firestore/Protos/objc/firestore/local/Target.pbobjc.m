@@ -183,12 +183,14 @@ void FSTPBTarget_ClearTargetTypeOneOfCase(FSTPBTarget *message) {
 @dynamic highestTargetId;
 @dynamic highestListenSequenceNumber;
 @dynamic hasLastRemoteSnapshotVersion, lastRemoteSnapshotVersion;
+@dynamic remoteDocumentGeneration;
 
 typedef struct FSTPBTargetGlobal__storage_ {
   uint32_t _has_storage_[1];
   int32_t highestTargetId;
   GPBTimestamp *lastRemoteSnapshotVersion;
   int64_t highestListenSequenceNumber;
+  int64_t remoteDocumentGeneration;
 } FSTPBTargetGlobal__storage_;
 
 // This method is threadsafe because it is initially called
@@ -224,6 +226,15 @@ typedef struct FSTPBTargetGlobal__storage_ {
         .flags = GPBFieldOptional,
         .dataType = GPBDataTypeMessage,
       },
+      {
+        .name = "remoteDocumentGeneration",
+        .dataTypeSpecific.className = NULL,
+        .number = FSTPBTargetGlobal_FieldNumber_RemoteDocumentGeneration,
+        .hasIndex = 3,
+        .offset = (uint32_t)offsetof(FSTPBTargetGlobal__storage_, remoteDocumentGeneration),
+        .flags = GPBFieldOptional,
+        .dataType = GPBDataTypeInt64,
+      },
     };
     GPBDescriptor *localDescriptor =
         [GPBDescriptor allocDescriptorForClass:[FSTPBTargetGlobal class]
@@ -0,0 +1,271 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "Firestore/Source/API/FIRBulkWriter+Internal.h"
+
+#import "Firestore/Source/API/FIRDocumentReference+Internal.h"
+#import "Firestore/Source/API/FIRFirestore+Internal.h"
+#import "Firestore/Source/API/FIRSetOptions+Internal.h"
+#import "Firestore/Source/API/FSTUserDataConverter.h"
+#import "Firestore/Source/Core/FSTFirestoreClient.h"
+#import "Firestore/Source/Model/FSTMutation.h"
+#import "Firestore/Source/Util/FSTDispatchQueue.h"
+#import "Firestore/Source/Util/FSTUsageValidation.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef void (^FIRBulkWriterCompletion)(NSError *_Nullable error);
+
+/** The maximum number of mutations the backend accepts in one commit. */
+static const NSUInteger kMaxMutationsPerBatch = 500;
+
+/**
+ * The maximum number of batches committed locally but not yet completed. Later batches wait in
+ * memory, so that a long stream of writes doesn't fill the local mutation queue far ahead of what
+ * the write stream can send.
+ */
+static const NSUInteger kMaxOutstandingBatches = 10;
+
+#pragma mark - FIRBulkWriterBatch
+
+/** The writes committed together as one batch, along with their completion blocks. */
+@interface FIRBulkWriterBatch : NSObject
+- (instancetype)initWithNumber:(NSUInteger)number;
+@property(nonatomic, assign, readonly) NSUInteger number;
+@property(nonatomic, strong, readonly) NSMutableArray<FSTMutation *> *mutations;
+@property(nonatomic, strong, readonly) NSMutableArray<FIRBulkWriterCompletion> *completions;
+@end
+
+@implementation FIRBulkWriterBatch
+
+- (instancetype)initWithNumber:(NSUInteger)number {
+  if (self = [super init]) {
+    _number = number;
+    _mutations = [NSMutableArray array];
+    _completions = [NSMutableArray array];
+  }
+  return self;
+}
+
+@end
+
+#pragma mark - FIRBulkWriterFlush
+
+/** A flushWithCompletion: waiting for the batches numbered below batchNumber to complete. */
+@interface FIRBulkWriterFlush : NSObject
+- (instancetype)initWithBatchNumber:(NSUInteger)batchNumber completion:(void (^)(void))completion;
+@property(nonatomic, assign, readonly) NSUInteger batchNumber;
+@property(nonatomic, copy, readonly) void (^completion)(void);
+@end
+
+@implementation FIRBulkWriterFlush
+
+- (instancetype)initWithBatchNumber:(NSUInteger)batchNumber completion:(void (^)(void))completion {
+  if (self = [super init]) {
+    _batchNumber = batchNumber;
+    _completion = completion;
+  }
+  return self;
+}
+
+@end
+
+#pragma mark - FIRBulkWriter
+
+@interface FIRBulkWriter ()
+
+- (instancetype)initWithFirestore:(FIRFirestore *)firestore NS_DESIGNATED_INITIALIZER;
+
+@property(nonatomic, strong, readonly) FIRFirestore *firestore;
+@property(nonatomic, assign) BOOL closed;
+
+/** The batch that new writes are added to, or nil if none has been started. */
+@property(nonatomic, strong, nullable) FIRBulkWriterBatch *currentBatch;
+
+/** The number of the next batch to start. */
+@property(nonatomic, assign) NSUInteger nextBatchNumber;
+
+/** Full batches waiting for an outstanding batch to complete before they are committed. */
+@property(nonatomic, strong, readonly) NSMutableArray<FIRBulkWriterBatch *> *queuedBatches;
+
+/** The numbers of the batches started but not yet completed, including queued ones. */
+@property(nonatomic, strong, readonly) NSMutableIndexSet *incompleteBatchNumbers;
+
+/** The number of batches committed but not yet completed. */
+@property(nonatomic, assign) NSUInteger outstandingBatchCount;
+
+@property(nonatomic, strong, readonly) NSMutableArray<FIRBulkWriterFlush *> *pendingFlushes;
+
+@end
+
+@implementation FIRBulkWriter (Internal)
+
++ (instancetype)bulkWriterWithFirestore:(FIRFirestore *)firestore {
+  return [[FIRBulkWriter alloc] initWithFirestore:firestore];
+}
+
+@end
+
+@implementation FIRBulkWriter
+
+- (instancetype)initWithFirestore:(FIRFirestore *)firestore {
+  self = [super init];
+  if (self) {
+    _firestore = firestore;
+    _queuedBatches = [NSMutableArray array];
+    _incompleteBatchNumbers = [NSMutableIndexSet indexSet];
+    _pendingFlushes = [NSMutableArray array];
+  }
+  return self;
+}
+
+- (void)setData:(NSDictionary<NSString *, id> *)data
+    forDocument:(FIRDocumentReference *)document
+     completion:(nullable void (^)(NSError *_Nullable error))completion {
+  [self setData:data forDocument:document options:[FIRSetOptions overwrite] completion:completion];
+}
+
+- (void)setData:(NSDictionary<NSString *, id> *)data
+    forDocument:(FIRDocumentReference *)document
+        options:(FIRSetOptions *)options
+     completion:(nullable void (^)(NSError *_Nullable error))completion {
+  [self validateReference:document];
+  FSTParsedSetData *parsed = options.isMerge ? [self.firestore.dataConverter parsedMergeData:data]
+                                             : [self.firestore.dataConverter parsedSetData:data];
+  [self addMutations:[parsed mutationsWithKey:document.key precondition:[FSTPrecondition none]]
+          completion:completion];
+}
+
+- (void)updateData:(NSDictionary<id, id> *)fields
+       forDocument:(FIRDocumentReference *)document
+        completion:(nullable void (^)(NSError *_Nullable error))completion {
+  [self validateReference:document];
+  FSTParsedUpdateData *parsed = [self.firestore.dataConverter parsedUpdateData:fields];
+  [self addMutations:[parsed mutationsWithKey:document.key
+                                 precondition:[FSTPrecondition preconditionWithExists:YES]]
+          completion:completion];
+}
+
+- (void)deleteDocument:(FIRDocumentReference *)document
+            completion:(nullable void (^)(NSError *_Nullable error))completion {
+  [self validateReference:document];
+  [self addMutations:@[ [[FSTDeleteMutation alloc] initWithKey:document.key
+                                                  precondition:[FSTPrecondition none]] ]
+          completion:completion];
+}
+
+- (void)flushWithCompletion:(nullable void (^)(void))completion {
+  @synchronized(self) {
+    [self finishCurrentBatch];
+    if (completion) {
+      [self.pendingFlushes
+          addObject:[[FIRBulkWriterFlush alloc] initWithBatchNumber:self.nextBatchNumber
+                                                        completion:completion]];
+    }
+    [self completeFlushes];
+  }
+}
+
+- (void)closeWithCompletion:(nullable void (^)(void))completion {
+  @synchronized(self) {
+    self.closed = YES;
+    [self flushWithCompletion:completion];
+  }
+}
+
+#pragma mark - Private
+
+/** Adds the mutations of one write to the current batch, starting a new one if it's full. */
+- (void)addMutations:(NSArray<FSTMutation *> *)mutations
+          completion:(nullable FIRBulkWriterCompletion)completion {
+  @synchronized(self) {
+    [self verifyNotClosed];
+    if (self.currentBatch &&
+        self.currentBatch.mutations.count + mutations.count > kMaxMutationsPerBatch) {
+      [self finishCurrentBatch];
+    }
+    if (!self.currentBatch) {
+      self.currentBatch = [[FIRBulkWriterBatch alloc] initWithNumber:self.nextBatchNumber++];
+      [self.incompleteBatchNumbers addIndex:self.currentBatch.number];
+    }
+    [self.currentBatch.mutations addObjectsFromArray:mutations];
+    if (completion) {
+      [self.currentBatch.completions addObject:completion];
+    }
+    if (self.currentBatch.mutations.count >= kMaxMutationsPerBatch) {
+      [self finishCurrentBatch];
+    }
+  }
+}
+
+/** Queues the current batch to be committed and commits as many queued batches as allowed. */
+- (void)finishCurrentBatch {
+  if (self.currentBatch) {
+    [self.queuedBatches addObject:self.currentBatch];
+    self.currentBatch = nil;
+  }
+  while (self.queuedBatches.count > 0 && self.outstandingBatchCount < kMaxOutstandingBatches) {
+    FIRBulkWriterBatch *batch = self.queuedBatches.firstObject;
+    [self.queuedBatches removeObjectAtIndex:0];
+    [self commitBatch:batch];
+  }
+}
+
+- (void)commitBatch:(FIRBulkWriterBatch *)batch {
+  self.outstandingBatchCount++;
+  [self.firestore.client writeMutations:batch.mutations
+                             completion:^(NSError *_Nullable error) {
+                               for (FIRBulkWriterCompletion completion in batch.completions) {
+                                 completion(error);
+                               }
+                               @synchronized(self) {
+                                 self.outstandingBatchCount--;
+                                 [self.incompleteBatchNumbers removeIndex:batch.number];
+                                 [self finishCurrentBatch];
+                                 [self completeFlushes];
+                               }
+                             }];
+}
+
+/** Calls the completions of the flushes whose batches have all completed. */
+- (void)completeFlushes {
+  NSUInteger firstIncomplete = self.incompleteBatchNumbers.count > 0
+                                   ? self.incompleteBatchNumbers.firstIndex
+                                   : self.nextBatchNumber;
+  while (self.pendingFlushes.count > 0 &&
+         self.pendingFlushes.firstObject.batchNumber <= firstIncomplete) {
+    FIRBulkWriterFlush *flush = self.pendingFlushes.firstObject;
+    [self.pendingFlushes removeObjectAtIndex:0];
+    [self.firestore.client.userDispatchQueue dispatchAsyncAllowingSameQueue:flush.completion];
+  }
+}
+
+- (void)verifyNotClosed {
+  if (self.closed) {
+    FSTThrowInvalidUsage(@"FIRIllegalStateException",
+                         @"A bulk writer can no longer be used after close has been called.");
+  }
+}
+
+- (void)validateReference:(FIRDocumentReference *)reference {
+  if (reference.firestore != self.firestore) {
+    FSTThrowInvalidArgument(@"Provided document reference is from a different Firestore instance.");
+  }
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -28,6 +28,13 @@ NS_ASSUME_NONNULL_BEGIN
 + (NSArray<FIRDocumentChange *> *)documentChangesForSnapshot:(FSTViewSnapshot *)snapshot
                                                    firestore:(FIRFirestore *)firestore;
 
+/**
+ * Creates the array of FIRDocumentChange's for the changes in the given FSTViewSnapshot without
+ * calculating their indexes, which are all NSNotFound. The snapshot's documents aren't used.
+ */
++ (NSArray<FIRDocumentChange *> *)unindexedDocumentChangesForSnapshot:(FSTViewSnapshot *)snapshot
+                                                            firestore:(FIRFirestore *)firestore;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -22,6 +22,7 @@
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTDocumentSet.h"
 #import "Firestore/Source/Util/FSTAssert.h"
+#import "Firestore/Source/Util/FSTLazyArray.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -52,27 +53,30 @@ NS_ASSUME_NONNULL_BEGIN
 + (NSArray<FIRDocumentChange *> *)documentChangesForSnapshot:(FSTViewSnapshot *)snapshot
                                                    firestore:(FIRFirestore *)firestore {
   if (snapshot.oldDocuments.isEmpty) {
-    // Special case the first snapshot because index calculation is easy and fast
-    FSTDocument *_Nullable lastDocument = nil;
-    NSUInteger index = 0;
-    NSMutableArray<FIRDocumentChange *> *changes = [NSMutableArray array];
-    for (FSTDocumentViewChange *change in snapshot.documentChanges) {
-      FIRQueryDocumentSnapshot *document =
-          [FIRQueryDocumentSnapshot snapshotWithFirestore:firestore
-                                              documentKey:change.document.key
-                                                 document:change.document
-                                                fromCache:snapshot.isFromCache];
-      FSTAssert(change.type == FSTDocumentViewChangeTypeAdded,
-                @"Invalid event type for first snapshot");
-      FSTAssert(!lastDocument ||
-                    snapshot.query.comparator(lastDocument, change.document) == NSOrderedAscending,
-                @"Got added events in wrong order");
-      [changes addObject:[[FIRDocumentChange alloc] initWithType:FIRDocumentChangeTypeAdded
-                                                        document:document
-                                                        oldIndex:NSNotFound
-                                                        newIndex:index++]];
-    }
-    return changes;
+    // Special case the first snapshot because index calculation is easy and fast: each change adds
+    // the document at its own index, so changes are only created for the indexes accessed.
+    NSArray<FSTDocumentViewChange *> *viewChanges = snapshot.documentChanges;
+    FSTQuery *query = snapshot.query;
+    BOOL fromCache = snapshot.isFromCache;
+    return [[FSTLazyArray alloc]
+        initWithCount:viewChanges.count
+         elementBlock:^id(NSUInteger index) {
+           FSTDocumentViewChange *change = viewChanges[index];
+           FSTAssert(change.type == FSTDocumentViewChangeTypeAdded,
+                     @"Invalid event type for first snapshot");
+           FSTAssert(index == 0 || query.comparator(viewChanges[index - 1].document,
+                                                    change.document) == NSOrderedAscending,
+                     @"Got added events in wrong order");
+           FIRQueryDocumentSnapshot *document =
+               [FIRQueryDocumentSnapshot snapshotWithFirestore:firestore
+                                                   documentKey:change.document.key
+                                                      document:change.document
+                                                     fromCache:fromCache];
+           return [[FIRDocumentChange alloc] initWithType:FIRDocumentChangeTypeAdded
+                                                 document:document
+                                                 oldIndex:NSNotFound
+                                                 newIndex:index];
+         }];
   } else {
     // A DocumentSet that is updated incrementally as changes are applied to use to lookup the index
     // of a document.
@@ -107,6 +111,25 @@ NS_ASSUME_NONNULL_BEGIN
   }
 }
 
++ (NSArray<FIRDocumentChange *> *)unindexedDocumentChangesForSnapshot:(FSTViewSnapshot *)snapshot
+                                                            firestore:(FIRFirestore *)firestore {
+  NSMutableArray<FIRDocumentChange *> *changes =
+      [NSMutableArray arrayWithCapacity:snapshot.documentChanges.count];
+  for (FSTDocumentViewChange *change in snapshot.documentChanges) {
+    FIRQueryDocumentSnapshot *document =
+        [FIRQueryDocumentSnapshot snapshotWithFirestore:firestore
+                                            documentKey:change.document.key
+                                               document:change.document
+                                              fromCache:snapshot.isFromCache];
+    FIRDocumentChangeType type = [FIRDocumentChange documentChangeTypeForChange:change];
+    [changes addObject:[[FIRDocumentChange alloc] initWithType:type
+                                                      document:document
+                                                      oldIndex:NSNotFound
+                                                      newIndex:NSNotFound]];
+  }
+  return changes;
+}
+
 @end
 
 @implementation FIRDocumentChange
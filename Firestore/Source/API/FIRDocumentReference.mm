@@ -287,6 +287,7 @@ addSnapshotListenerInternalWithOptions:(FSTListenOptions *)internalOptions
 
   FSTAsyncQueryListener *asyncListener =
       [[FSTAsyncQueryListener alloc] initWithDispatchQueue:self.firestore.client.userDispatchQueue
+                                                   batcher:self.firestore.client.snapshotBatcher
                                            snapshotHandler:snapshotHandler];
 
   FSTQueryListener *internalListener =
@@ -59,8 +59,17 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+/** The number of FSTServerTimestampBehavior values, each of which converts data differently. */
+static const NSInteger kServerTimestampBehaviorCount = FSTServerTimestampBehaviorPrevious + 1;
+
 @implementation FIRDocumentSnapshot {
   FIRSnapshotMetadata *_cachedMetadata;
+
+  /**
+   * The document's data as returned by dataWithOptions:, converted at most once for each server
+   * timestamp behavior. Guarded by @synchronized(self).
+   */
+  NSDictionary<NSString *, id> *_convertedData[kServerTimestampBehaviorCount];
 }
 
 @dynamic metadata;
@@ -134,10 +143,35 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (nullable NSDictionary<NSString *, id> *)dataWithOptions:(FIRSnapshotOptions *)options {
-  return self.internalDocument == nil
-             ? nil
-             : [self convertedObject:[self.internalDocument data]
-                             options:[FSTFieldValueOptions optionsForSnapshotOptions:options]];
+  if (self.internalDocument == nil) {
+    return nil;
+  }
+
+  // Snapshots are immutable, so the converted data can be returned again on later calls, which
+  // table views make repeatedly for the same snapshots.
+  FSTFieldValueOptions *fieldValueOptions =
+      [FSTFieldValueOptions optionsForSnapshotOptions:options];
+  NSInteger behavior = fieldValueOptions.serverTimestampBehavior;
+  FSTAssert(behavior >= 0 && behavior < kServerTimestampBehaviorCount,
+            @"Unknown server timestamp behavior: %ld", (long)behavior);
+  @synchronized(self) {
+    if (!_convertedData[behavior]) {
+      _convertedData[behavior] =
+          [self convertedObject:[self.internalDocument data] options:fieldValueOptions];
+    }
+    return _convertedData[behavior];
+  }
+}
+
+/** Returns the data already converted by dataWithOptions: for the given options, if any. */
+- (nullable NSDictionary<NSString *, id> *)cachedDataWithOptions:(FSTFieldValueOptions *)options {
+  NSInteger behavior = options.serverTimestampBehavior;
+  if (behavior < 0 || behavior >= kServerTimestampBehaviorCount) {
+    return nil;
+  }
+  @synchronized(self) {
+    return _convertedData[behavior];
+  }
 }
 
 - (nullable id)valueForField:(id)field {
@@ -155,11 +189,24 @@ NS_ASSUME_NONNULL_BEGIN
     FSTThrowInvalidArgument(@"Subscript key must be an NSString or FIRFieldPath.");
   }
 
+  FSTFieldValueOptions *fieldValueOptions =
+      [FSTFieldValueOptions optionsForSnapshotOptions:options];
+  NSDictionary<NSString *, id> *data = [self cachedDataWithOptions:fieldValueOptions];
+  if (data) {
+    // Look the field up in the data that's already converted rather than converting it again.
+    FSTFieldPath *path = fieldPath.internalValue;
+    id value = data;
+    for (int i = 0; i < path.length; i++) {
+      if (![value isKindOfClass:[NSDictionary class]]) {
+        return nil;
+      }
+      value = ((NSDictionary *)value)[[path segmentAtIndex:i]];
+    }
+    return value;
+  }
+
   FSTFieldValue *fieldValue = [[self.internalDocument data] valueForPath:fieldPath.internalValue];
-  return fieldValue == nil
-             ? nil
-             : [self convertedValue:fieldValue
-                            options:[FSTFieldValueOptions optionsForSnapshotOptions:options]];
+  return fieldValue == nil ? nil : [self convertedValue:fieldValue options:fieldValueOptions];
 }
 
 - (nullable id)objectForKeyedSubscript:(id)key {
@@ -198,7 +245,8 @@ NS_ASSUME_NONNULL_BEGIN
       enumerateKeysAndObjectsUsingBlock:^(NSString *key, FSTFieldValue *value, BOOL *stop) {
         result[key] = [self convertedValue:value options:options];
       }];
-  return result;
+  // Converted values may be returned to more than one caller, so they must be immutable.
+  return [result copy];
 }
 
 - (NSArray<id> *)convertedArray:(FSTArrayValue *)arrayValue
@@ -208,7 +256,7 @@ NS_ASSUME_NONNULL_BEGIN
   [internalValue enumerateObjectsUsingBlock:^(id value, NSUInteger idx, BOOL *stop) {
     [result addObject:[self convertedValue:value options:options]];
   }];
-  return result;
+  return [result copy];
 }
 
 @end
@@ -20,10 +20,14 @@
 #import <FirebaseCore/FIRLogger.h>
 #import <FirebaseCore/FIROptions.h>
 
+#import "FIRFirestoreErrors.h"
 #import "FIRFirestoreSettings.h"
 #import "Firestore/Source/API/FIRCollectionReference+Internal.h"
+#import "Firestore/Source/API/FIRBulkWriter+Internal.h"
 #import "Firestore/Source/API/FIRDocumentReference+Internal.h"
+#import "Firestore/Source/API/FIRDocumentSnapshot+Internal.h"
 #import "Firestore/Source/API/FIRFirestore+Internal.h"
+#import "Firestore/Source/API/FIRQuery+Internal.h"
 #import "Firestore/Source/API/FIRTransaction+Internal.h"
 #import "Firestore/Source/API/FIRWriteBatch+Internal.h"
 #import "Firestore/Source/API/FSTUserDataConverter.h"
@@ -32,6 +36,8 @@
 #import "Firestore/Source/Core/FSTDatabaseInfo.h"
 #import "Firestore/Source/Core/FSTFirestoreClient.h"
 #import "Firestore/Source/Model/FSTDatabaseID.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTDocumentDictionary.h"
 #import "Firestore/Source/Model/FSTDocumentKey.h"
 #import "Firestore/Source/Model/FSTPath.h"
 #import "Firestore/Source/Util/FSTAssert.h"
@@ -202,7 +208,7 @@ extern "C" NSString *const FIRFirestoreErrorDomain = @"FIRFirestoreErrorDomain";
       FSTDispatchQueue *userDispatchQueue = [FSTDispatchQueue queueWith:_settings.dispatchQueue];
 
       _client = [FSTFirestoreClient clientWithDatabaseInfo:databaseInfo
-                                            usePersistence:_settings.persistenceEnabled
+                                                  settings:_settings
                                        credentialsProvider:_credentialsProvider
                                          userDispatchQueue:userDispatchQueue
                                        workerDispatchQueue:_workerDispatchQueue];
@@ -228,6 +234,61 @@ extern "C" NSString *const FIRFirestoreErrorDomain = @"FIRFirestoreErrorDomain";
   return [FIRDocumentReference referenceWithPath:path firestore:self];
 }
 
+- (void)getDocuments:(NSArray<FIRDocumentReference *> *)documents
+          completion:(void (^)(NSArray<FIRDocumentSnapshot *> *_Nullable snapshots,
+                               NSError *_Nullable error))completion {
+  if (!documents) {
+    FSTThrowInvalidArgument(@"Document references cannot be nil.");
+  }
+  if (!completion) {
+    FSTThrowInvalidArgument(@"Get documents completion block cannot be nil.");
+  }
+  NSMutableArray<FSTDocumentKey *> *keys = [NSMutableArray arrayWithCapacity:documents.count];
+  for (FIRDocumentReference *document in documents) {
+    if (document.firestore != self) {
+      FSTThrowInvalidArgument(@"Provided document reference is from a different Firestore "
+                               "instance.");
+    }
+    [keys addObject:document.key];
+  }
+  [self ensureClientConfigured];
+
+  [self.client
+      getDocumentsWithKeys:keys
+                completion:^(FSTMaybeDocumentDictionary *_Nullable docs, BOOL fromCache,
+                             NSError *_Nullable error) {
+                  if (error) {
+                    completion(nil, error);
+                    return;
+                  }
+
+                  NSMutableArray<FIRDocumentSnapshot *> *snapshots =
+                      [NSMutableArray arrayWithCapacity:keys.count];
+                  for (FSTDocumentKey *key in keys) {
+                    FSTMaybeDocument *doc = docs[key];
+                    FSTDocument *document =
+                        [doc isKindOfClass:[FSTDocument class]] ? (FSTDocument *)doc : nil;
+                    if (!document && fromCache) {
+                      // As for getDocumentWithCompletion:, a document missing from the cache
+                      // can't be told apart from one that doesn't exist while offline.
+                      completion(nil, [NSError errorWithDomain:FIRFirestoreErrorDomain
+                                                          code:FIRFirestoreErrorCodeUnavailable
+                                                      userInfo:@{
+                                                        NSLocalizedDescriptionKey :
+                                                            @"Failed to get documents because "
+                                                            @"the client is offline.",
+                                                      }]);
+                      return;
+                    }
+                    [snapshots addObject:[FIRDocumentSnapshot snapshotWithFirestore:self
+                                                                        documentKey:key
+                                                                           document:document
+                                                                          fromCache:fromCache]];
+                  }
+                  completion(snapshots, nil);
+                }];
+}
+
 - (void)runTransactionWithBlock:(id _Nullable (^)(FIRTransaction *, NSError **))updateBlock
                   dispatchQueue:(dispatch_queue_t)queue
                      completion:
@@ -264,6 +325,12 @@ extern "C" NSString *const FIRFirestoreErrorDomain = @"FIRFirestoreErrorDomain";
   return [FIRWriteBatch writeBatchWithFirestore:self];
 }
 
+- (FIRBulkWriter *)bulkWriter {
+  [self ensureClientConfigured];
+
+  return [FIRBulkWriter bulkWriterWithFirestore:self];
+}
+
 - (void)runTransactionWithBlock:(id _Nullable (^)(FIRTransaction *, NSError **error))updateBlock
                      completion:
                          (void (^)(id _Nullable result, NSError *_Nullable error))completion {
@@ -312,6 +379,70 @@ extern "C" NSString *const FIRFirestoreErrorDomain = @"FIRFirestoreErrorDomain";
   [self.client disableNetworkWithCompletion:completion];
 }
 
+- (void)prewarmNetwork {
+  [self ensureClientConfigured];
+  [self.client prewarmNetwork];
+}
+
+- (void)loadBundle:(NSData *)bundle
+        completion:(nullable void (^)(NSError *_Nullable error))completion {
+  if (!bundle) {
+    FSTThrowInvalidArgument(@"Bundle cannot be nil.");
+  }
+  [self ensureClientConfigured];
+  [self.client loadBundle:bundle completion:completion];
+}
+
+- (void)prefetchQuery:(FIRQuery *)query
+            untilDate:(NSDate *)expiryDate
+             progress:(nullable void (^)(NSInteger documentCount))progress
+           completion:(nullable void (^)(NSError *_Nullable error))completion {
+  if (!query) {
+    FSTThrowInvalidArgument(@"Query cannot be nil.");
+  }
+  if (!expiryDate) {
+    FSTThrowInvalidArgument(@"Prefetch expiry date cannot be nil.");
+  }
+  if (query.firestore != self) {
+    FSTThrowInvalidArgument(@"Provided query is from a different Firestore instance.");
+  }
+  [self ensureClientConfigured];
+
+  void (^progressBlock)(NSUInteger) = nil;
+  if (progress) {
+    progressBlock = ^(NSUInteger documentCount) {
+      progress((NSInteger)documentCount);
+    };
+  }
+  [self.client prefetchQuery:query.query
+                  expiryDate:expiryDate
+                    progress:progressBlock
+                  completion:completion];
+}
+
+- (void)getCacheSizesWithCompletion:
+    (void (^)(NSDictionary<NSString *, NSNumber *> *sizes))completion {
+  if (!completion) {
+    FSTThrowInvalidArgument(@"Cache sizes completion block cannot be nil.");
+  }
+  [self ensureClientConfigured];
+  [self.client getCacheSizesWithCompletion:completion];
+}
+
+- (void)getMemoryUsageWithCompletion:
+    (void (^)(NSDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *usage))completion {
+  if (!completion) {
+    FSTThrowInvalidArgument(@"Memory usage completion block cannot be nil.");
+  }
+  [self ensureClientConfigured];
+  [self.client getMemoryUsageWithCompletion:completion];
+}
+
+- (void)releaseCachedMemory {
+  [self ensureClientConfigured];
+  [self.client releaseCachedMemory];
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
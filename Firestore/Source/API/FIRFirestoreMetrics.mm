@@ -0,0 +1,63 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "FIRFirestoreMetrics.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+extern "C" NSString *const FIRFirestoreMetricWatchBytesSent = @"firestore.watch.bytes_sent";
+extern "C" NSString *const FIRFirestoreMetricWatchBytesReceived = @"firestore.watch.bytes_received";
+extern "C" NSString *const FIRFirestoreMetricWatchMessagesSent = @"firestore.watch.messages_sent";
+extern "C" NSString *const FIRFirestoreMetricWatchMessagesReceived =
+    @"firestore.watch.messages_received";
+extern "C" NSString *const FIRFirestoreMetricWatchHandshakeLatency =
+    @"firestore.watch.handshake_latency";
+
+extern "C" NSString *const FIRFirestoreMetricWriteBytesSent = @"firestore.write.bytes_sent";
+extern "C" NSString *const FIRFirestoreMetricWriteBytesReceived = @"firestore.write.bytes_received";
+extern "C" NSString *const FIRFirestoreMetricWriteMessagesSent = @"firestore.write.messages_sent";
+extern "C" NSString *const FIRFirestoreMetricWriteMessagesReceived =
+    @"firestore.write.messages_received";
+extern "C" NSString *const FIRFirestoreMetricWriteHandshakeLatency =
+    @"firestore.write.handshake_latency";
+
+extern "C" NSString *const FIRFirestoreMetricTargetSyncLatency = @"firestore.target.sync_latency";
+extern "C" NSString *const FIRFirestoreMetricStreamBackoffDelay = @"firestore.stream.backoff_delay";
+
+extern "C" NSString *const FIRFirestoreMetricStartupLatency = @"firestore.startup.latency";
+extern "C" NSString *const FIRFirestoreMetricStartupCredentialsLatency =
+    @"firestore.startup.credentials_latency";
+extern "C" NSString *const FIRFirestoreMetricStartupPersistenceLatency =
+    @"firestore.startup.persistence_latency";
+extern "C" NSString *const FIRFirestoreMetricStartupLocalStoreLatency =
+    @"firestore.startup.local_store_latency";
+extern "C" NSString *const FIRFirestoreMetricStartupRemoteStoreLatency =
+    @"firestore.startup.remote_store_latency";
+
+extern "C" NSString *const FIRFirestoreCacheTableRemoteDocuments = @"remote_documents";
+extern "C" NSString *const FIRFirestoreCacheTableMutations = @"mutations";
+extern "C" NSString *const FIRFirestoreCacheTableTargets = @"targets";
+extern "C" NSString *const FIRFirestoreCacheTableTargetDocuments = @"target_documents";
+
+extern "C" NSString *const FIRFirestoreMemoryComponentCachedDocuments = @"cached_documents";
+extern "C" NSString *const FIRFirestoreMemoryComponentListenerResults = @"listener_results";
+extern "C" NSString *const FIRFirestoreMemoryComponentReferences = @"references";
+extern "C" NSString *const FIRFirestoreMemoryComponentPendingWrites = @"pending_writes";
+extern "C" NSString *const FIRFirestoreMemoryComponentQueuedMessages = @"queued_messages";
+extern "C" NSString *const FIRFirestoreMemoryObjectCount = @"objects";
+extern "C" NSString *const FIRFirestoreMemoryApproximateBytes = @"bytes";
+
+NS_ASSUME_NONNULL_END
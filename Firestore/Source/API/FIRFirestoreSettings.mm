@@ -16,6 +16,9 @@
 
 #import "FIRFirestoreSettings.h"
 
+#import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
+#import "Firestore/Source/Local/FSTLevelDB.h"
+#import "Firestore/Source/Remote/FSTStream.h"
 #import "Firestore/Source/Util/FSTUsageValidation.h"
 
 NS_ASSUME_NONNULL_BEGIN
@@ -23,6 +26,11 @@ NS_ASSUME_NONNULL_BEGIN
 static NSString *const kDefaultHost = @"firestore.googleapis.com";
 static const BOOL kDefaultSSLEnabled = YES;
 static const BOOL kDefaultPersistenceEnabled = YES;
+static const BOOL kDefaultSnapshotBatchingEnabled = NO;
+static const BOOL kDefaultWriteCoalescingEnabled = NO;
+static const BOOL kDefaultWriteSquashingEnabled = NO;
+static const BOOL kDefaultTargetMultiplexingEnabled = NO;
+static const BOOL kDefaultCompressionEnabled = NO;
 
 @implementation FIRFirestoreSettings
 
@@ -32,6 +40,18 @@ static const BOOL kDefaultPersistenceEnabled = YES;
     _sslEnabled = kDefaultSSLEnabled;
     _dispatchQueue = dispatch_get_main_queue();
     _persistenceEnabled = kDefaultPersistenceEnabled;
+    _persistenceCacheSizeBytes = kFSTLevelDBDefaultBlockCacheSize;
+    _persistenceWriteBufferSizeBytes = kFSTLevelDBDefaultWriteBufferSize;
+    _persistenceGarbageCollectionThresholdBytes = kFSTLRUGarbageCollectorDefaultThreshold;
+    _memoryGarbageCollectionThresholdDocuments = 0;
+    _snapshotBatchingEnabled = kDefaultSnapshotBatchingEnabled;
+    _snapshotBatchingInterval = 0;
+    _writeCoalescingEnabled = kDefaultWriteCoalescingEnabled;
+    _writeSquashingEnabled = kDefaultWriteSquashingEnabled;
+    _targetMultiplexingEnabled = kDefaultTargetMultiplexingEnabled;
+    _syncCoalescingInterval = 0;
+    _compressionEnabled = kDefaultCompressionEnabled;
+    _streamIdleTimeout = kFSTStreamDefaultIdleTimeout;
   }
   return self;
 }
@@ -47,7 +67,22 @@ static const BOOL kDefaultPersistenceEnabled = YES;
   return [self.host isEqual:otherSettings.host] &&
          self.isSSLEnabled == otherSettings.isSSLEnabled &&
          self.dispatchQueue == otherSettings.dispatchQueue &&
-         self.isPersistenceEnabled == otherSettings.isPersistenceEnabled;
+         self.isPersistenceEnabled == otherSettings.isPersistenceEnabled &&
+         self.persistenceCacheSizeBytes == otherSettings.persistenceCacheSizeBytes &&
+         self.persistenceWriteBufferSizeBytes == otherSettings.persistenceWriteBufferSizeBytes &&
+         self.persistenceGarbageCollectionThresholdBytes ==
+             otherSettings.persistenceGarbageCollectionThresholdBytes &&
+         self.memoryGarbageCollectionThresholdDocuments ==
+             otherSettings.memoryGarbageCollectionThresholdDocuments &&
+         self.isSnapshotBatchingEnabled == otherSettings.isSnapshotBatchingEnabled &&
+         self.snapshotBatchingInterval == otherSettings.snapshotBatchingInterval &&
+         self.isWriteCoalescingEnabled == otherSettings.isWriteCoalescingEnabled &&
+         self.isWriteSquashingEnabled == otherSettings.isWriteSquashingEnabled &&
+         self.isTargetMultiplexingEnabled == otherSettings.isTargetMultiplexingEnabled &&
+         self.syncCoalescingInterval == otherSettings.syncCoalescingInterval &&
+         self.isCompressionEnabled == otherSettings.isCompressionEnabled &&
+         self.streamIdleTimeout == otherSettings.streamIdleTimeout &&
+         self.metricsProvider == otherSettings.metricsProvider;
 }
 
 - (NSUInteger)hash {
@@ -55,6 +90,19 @@ static const BOOL kDefaultPersistenceEnabled = YES;
   result = 31 * result + (self.isSSLEnabled ? 1231 : 1237);
   // Ignore the dispatchQueue to avoid having to deal with sizeof(dispatch_queue_t).
   result = 31 * result + (self.isPersistenceEnabled ? 1231 : 1237);
+  result = 31 * result + (NSUInteger)self.persistenceCacheSizeBytes;
+  result = 31 * result + (NSUInteger)self.persistenceWriteBufferSizeBytes;
+  result = 31 * result + (NSUInteger)self.persistenceGarbageCollectionThresholdBytes;
+  result = 31 * result + (NSUInteger)self.memoryGarbageCollectionThresholdDocuments;
+  result = 31 * result + (self.isSnapshotBatchingEnabled ? 1231 : 1237);
+  result = 31 * result + [@(self.snapshotBatchingInterval) hash];
+  result = 31 * result + (self.isWriteCoalescingEnabled ? 1231 : 1237);
+  result = 31 * result + (self.isWriteSquashingEnabled ? 1231 : 1237);
+  result = 31 * result + (self.isTargetMultiplexingEnabled ? 1231 : 1237);
+  result = 31 * result + [@(self.syncCoalescingInterval) hash];
+  result = 31 * result + (self.isCompressionEnabled ? 1231 : 1237);
+  result = 31 * result + [@(self.streamIdleTimeout) hash];
+  result = 31 * result + [self.metricsProvider hash];
   return result;
 }
 
@@ -64,6 +112,19 @@ static const BOOL kDefaultPersistenceEnabled = YES;
   copy.sslEnabled = _sslEnabled;
   copy.dispatchQueue = _dispatchQueue;
   copy.persistenceEnabled = _persistenceEnabled;
+  copy.persistenceCacheSizeBytes = _persistenceCacheSizeBytes;
+  copy.persistenceWriteBufferSizeBytes = _persistenceWriteBufferSizeBytes;
+  copy.persistenceGarbageCollectionThresholdBytes = _persistenceGarbageCollectionThresholdBytes;
+  copy.memoryGarbageCollectionThresholdDocuments = _memoryGarbageCollectionThresholdDocuments;
+  copy.snapshotBatchingEnabled = _snapshotBatchingEnabled;
+  copy.snapshotBatchingInterval = _snapshotBatchingInterval;
+  copy.writeCoalescingEnabled = _writeCoalescingEnabled;
+  copy.writeSquashingEnabled = _writeSquashingEnabled;
+  copy.targetMultiplexingEnabled = _targetMultiplexingEnabled;
+  copy.syncCoalescingInterval = _syncCoalescingInterval;
+  copy.compressionEnabled = _compressionEnabled;
+  copy.streamIdleTimeout = _streamIdleTimeout;
+  copy.metricsProvider = _metricsProvider;
   return copy;
 }
 
@@ -87,6 +148,73 @@ static const BOOL kDefaultPersistenceEnabled = YES;
   _dispatchQueue = dispatchQueue;
 }
 
+- (void)setPersistenceCacheSizeBytes:(int64_t)persistenceCacheSizeBytes {
+  if (persistenceCacheSizeBytes <= 0) {
+    FSTThrowInvalidArgument(
+        @"persistenceCacheSizeBytes setting must be positive. You should generally just use the "
+         "default value (which is %lld)",
+        kFSTLevelDBDefaultBlockCacheSize);
+  }
+  _persistenceCacheSizeBytes = persistenceCacheSizeBytes;
+}
+
+- (void)setPersistenceWriteBufferSizeBytes:(int64_t)persistenceWriteBufferSizeBytes {
+  if (persistenceWriteBufferSizeBytes <= 0) {
+    FSTThrowInvalidArgument(
+        @"persistenceWriteBufferSizeBytes setting must be positive. You should generally just use "
+         "the default value (which is %lld)",
+        kFSTLevelDBDefaultWriteBufferSize);
+  }
+  _persistenceWriteBufferSizeBytes = persistenceWriteBufferSizeBytes;
+}
+
+- (void)setPersistenceGarbageCollectionThresholdBytes:(int64_t)thresholdBytes {
+  if (thresholdBytes <= 0) {
+    FSTThrowInvalidArgument(
+        @"persistenceGarbageCollectionThresholdBytes setting must be positive. You should "
+         "generally just use the default value (which is %lld)",
+        kFSTLRUGarbageCollectorDefaultThreshold);
+  }
+  _persistenceGarbageCollectionThresholdBytes = thresholdBytes;
+}
+
+- (void)setMemoryGarbageCollectionThresholdDocuments:(int64_t)thresholdDocuments {
+  if (thresholdDocuments < 0) {
+    FSTThrowInvalidArgument(
+        @"memoryGarbageCollectionThresholdDocuments setting must not be negative. Use 0 to remove "
+         "cached documents as soon as no query needs them");
+  }
+  _memoryGarbageCollectionThresholdDocuments = thresholdDocuments;
+}
+
+- (void)setSnapshotBatchingInterval:(NSTimeInterval)snapshotBatchingInterval {
+  if (snapshotBatchingInterval < 0) {
+    FSTThrowInvalidArgument(
+        @"snapshotBatchingInterval setting must not be negative. Use 0 to deliver batched events "
+         "as soon as possible");
+  }
+  _snapshotBatchingInterval = snapshotBatchingInterval;
+}
+
+- (void)setSyncCoalescingInterval:(NSTimeInterval)syncCoalescingInterval {
+  if (syncCoalescingInterval < 0) {
+    FSTThrowInvalidArgument(
+        @"syncCoalescingInterval setting must not be negative. Use 0 to apply updates from the "
+         "backend as soon as they arrive");
+  }
+  _syncCoalescingInterval = syncCoalescingInterval;
+}
+
+- (void)setStreamIdleTimeout:(NSTimeInterval)streamIdleTimeout {
+  if (streamIdleTimeout <= 0) {
+    FSTThrowInvalidArgument(
+        @"streamIdleTimeout setting must be positive. You should generally just use the default "
+         "value (which is %.0f seconds)",
+        kFSTStreamDefaultIdleTimeout);
+  }
+  _streamIdleTimeout = streamIdleTimeout;
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
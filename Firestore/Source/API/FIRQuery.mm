@@ -17,6 +17,8 @@
 #import "FIRQuery.h"
 
 #import "FIRDocumentReference.h"
+#import "FIRGeoPoint.h"
+#import "Firestore/Source/API/FIRDocumentChange+Internal.h"
 #import "Firestore/Source/API/FIRDocumentReference+Internal.h"
 #import "Firestore/Source/API/FIRDocumentSnapshot+Internal.h"
 #import "Firestore/Source/API/FIRFieldPath+Internal.h"
@@ -44,6 +46,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (instancetype)initWithIncludeQueryMetadataChanges:(BOOL)includeQueryMetadataChanges
                      includeDocumentMetadataChanges:(BOOL)includeDocumentMetadataChanges
+                         includeDocumentDataChanges:(BOOL)includeDocumentDataChanges
     NS_DESIGNATED_INITIALIZER;
 
 @end
@@ -55,28 +58,41 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (instancetype)initWithIncludeQueryMetadataChanges:(BOOL)includeQueryMetadataChanges
-                     includeDocumentMetadataChanges:(BOOL)includeDocumentMetadataChanges {
+                     includeDocumentMetadataChanges:(BOOL)includeDocumentMetadataChanges
+                         includeDocumentDataChanges:(BOOL)includeDocumentDataChanges {
   if (self = [super init]) {
     _includeQueryMetadataChanges = includeQueryMetadataChanges;
     _includeDocumentMetadataChanges = includeDocumentMetadataChanges;
+    _includeDocumentDataChanges = includeDocumentDataChanges;
   }
   return self;
 }
 
 - (instancetype)init {
-  return [self initWithIncludeQueryMetadataChanges:NO includeDocumentMetadataChanges:NO];
+  return [self initWithIncludeQueryMetadataChanges:NO
+                    includeDocumentMetadataChanges:NO
+                        includeDocumentDataChanges:YES];
 }
 
 - (instancetype)includeQueryMetadataChanges:(BOOL)includeQueryMetadataChanges {
   return [[FIRQueryListenOptions alloc]
       initWithIncludeQueryMetadataChanges:includeQueryMetadataChanges
-           includeDocumentMetadataChanges:_includeDocumentMetadataChanges];
+           includeDocumentMetadataChanges:_includeDocumentMetadataChanges
+               includeDocumentDataChanges:_includeDocumentDataChanges];
 }
 
 - (instancetype)includeDocumentMetadataChanges:(BOOL)includeDocumentMetadataChanges {
   return [[FIRQueryListenOptions alloc]
       initWithIncludeQueryMetadataChanges:_includeQueryMetadataChanges
-           includeDocumentMetadataChanges:includeDocumentMetadataChanges];
+           includeDocumentMetadataChanges:includeDocumentMetadataChanges
+               includeDocumentDataChanges:_includeDocumentDataChanges];
+}
+
+- (instancetype)includeDocumentDataChanges:(BOOL)includeDocumentDataChanges {
+  return [[FIRQueryListenOptions alloc]
+      initWithIncludeQueryMetadataChanges:_includeQueryMetadataChanges
+           includeDocumentMetadataChanges:_includeDocumentMetadataChanges
+               includeDocumentDataChanges:includeDocumentDataChanges];
 }
 
 @end
@@ -153,6 +169,61 @@ NS_ASSUME_NONNULL_BEGIN
   dispatch_semaphore_signal(registered);
 }
 
+- (void)getDocumentsFromCacheWithCompletion:(FIRQuerySnapshotBlock)completion {
+  [self getDocumentsFromCacheMatchingQuery:self.query completion:completion];
+}
+
+/**
+ * Reads the documents matching the given query from the local cache, reporting them as the
+ * results of this query.
+ */
+- (void)getDocumentsFromCacheMatchingQuery:(FSTQuery *)localQuery
+                                completion:(FIRQuerySnapshotBlock)completion {
+  FIRFirestore *firestore = self.firestore;
+  FSTQuery *query = self.query;
+  void (^handler)(FSTViewSnapshot *) = ^(FSTViewSnapshot *snapshot) {
+    FIRSnapshotMetadata *metadata =
+        [FIRSnapshotMetadata snapshotMetadataWithPendingWrites:snapshot.hasPendingWrites
+                                                     fromCache:snapshot.fromCache];
+    completion([FIRQuerySnapshot snapshotWithFirestore:firestore
+                                         originalQuery:query
+                                              snapshot:snapshot
+                                              metadata:metadata],
+               nil);
+  };
+  [firestore.client getDocumentsFromLocalCache:localQuery completion:handler];
+}
+
+- (void)getDocumentsFromCacheWhereField:(NSString *)field
+                            inBoundsFrom:(FIRGeoPoint *)southWest
+                                      to:(FIRGeoPoint *)northEast
+                              completion:(FIRQuerySnapshotBlock)completion {
+  if (southWest.latitude > northEast.latitude) {
+    FSTThrowInvalidArgument(
+        @"Invalid bounds. The southwest corner (%f) must not be north of the northeast corner "
+         "(%f).",
+        southWest.latitude, northEast.latitude);
+  }
+  FSTFieldPath *fieldPath = [FIRFieldPath pathWithDotSeparatedString:field].internalValue;
+  if ([fieldPath isKeyFieldPath]) {
+    FSTThrowInvalidArgument(@"Invalid bounds. Document IDs aren't GeoPoints.");
+  }
+
+  // The backend can't serve the filter, so the query it's added to never escapes as a FIRQuery
+  // (not even through the snapshot) that could be listened to.
+  FSTGeoBoundsFilter *filter =
+      [[FSTGeoBoundsFilter alloc] initWithField:fieldPath southWest:southWest northEast:northEast];
+  [self getDocumentsFromCacheMatchingQuery:[self.query queryByAddingFilter:filter]
+                                completion:completion];
+}
+
+- (void)getCountFromCacheWithCompletion:(void (^)(NSInteger count))completion {
+  [self.firestore.client countDocumentsFromLocalCache:self.query
+                                           completion:^(NSUInteger count) {
+                                             completion((NSInteger)count);
+                                           }];
+}
+
 - (id<FIRListenerRegistration>)addSnapshotListener:(FIRQuerySnapshotBlock)listener {
   return [self addSnapshotListenerWithOptions:nil listener:listener];
 }
@@ -189,6 +260,7 @@ addSnapshotListenerInternalWithOptions:(FSTListenOptions *)internalOptions
 
   FSTAsyncQueryListener *asyncListener =
       [[FSTAsyncQueryListener alloc] initWithDispatchQueue:self.firestore.client.userDispatchQueue
+                                                   batcher:self.firestore.client.snapshotBatcher
                                            snapshotHandler:snapshotHandler];
 
   FSTQueryListener *internalListener =
@@ -200,6 +272,41 @@ addSnapshotListenerInternalWithOptions:(FSTListenOptions *)internalOptions
                                         internalListener:internalListener];
 }
 
+- (id<FIRListenerRegistration>)addDocumentChangesListener:(FIRDocumentChangesBlock)listener {
+  FIRFirestore *firestore = self.firestore;
+  FSTListenOptions *options = [[FSTListenOptions alloc] initWithIncludeQueryMetadataChanges:NO
+                                                             includeDocumentMetadataChanges:NO
+                                                                 includeDocumentDataChanges:YES
+                                                                      waitForSyncWhenOnline:NO
+                                                                        documentChangesOnly:YES];
+
+  FSTViewSnapshotHandler snapshotHandler = ^(FSTViewSnapshot *snapshot, NSError *error) {
+    if (error) {
+      listener(nil, nil, error);
+      return;
+    }
+
+    FIRSnapshotMetadata *metadata =
+        [FIRSnapshotMetadata snapshotMetadataWithPendingWrites:snapshot.hasPendingWrites
+                                                     fromCache:snapshot.fromCache];
+    listener([FIRDocumentChange unindexedDocumentChangesForSnapshot:snapshot firestore:firestore],
+             metadata, nil);
+  };
+
+  // The snapshot batcher isn't used: merging snapshots needs their documents.
+  FSTAsyncQueryListener *asyncListener =
+      [[FSTAsyncQueryListener alloc] initWithDispatchQueue:firestore.client.userDispatchQueue
+                                           snapshotHandler:snapshotHandler];
+
+  FSTQueryListener *internalListener =
+      [firestore.client listenToQuery:self.query
+                              options:options
+                  viewSnapshotHandler:[asyncListener asyncSnapshotHandler]];
+  return [[FSTListenerRegistration alloc] initWithClient:firestore.client
+                                           asyncListener:asyncListener
+                                        internalListener:internalListener];
+}
+
 - (FIRQuery *)queryWhereField:(NSString *)field isEqualTo:(id)value {
   return [self queryWithFilterOperator:FSTRelationFilterOperatorEqual field:field value:value];
 }
@@ -622,9 +729,12 @@ addSnapshotListenerInternalWithOptions:(FSTListenOptions *)internalOptions
 
 /** Converts the public API options object to the internal options object. */
 - (FSTListenOptions *)internalOptions:(nullable FIRQueryListenOptions *)options {
+  // A nil options object means the defaults, which include document data changes.
+  BOOL includeDocumentDataChanges = options ? options.includeDocumentDataChanges : YES;
   return [[FSTListenOptions alloc]
       initWithIncludeQueryMetadataChanges:options.includeQueryMetadataChanges
            includeDocumentMetadataChanges:options.includeDocumentMetadataChanges
+               includeDocumentDataChanges:includeDocumentDataChanges
                     waitForSyncWhenOnline:NO];
 }
 
@@ -26,6 +26,7 @@
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTDocumentSet.h"
 #import "Firestore/Source/Util/FSTAssert.h"
+#import "Firestore/Source/Util/FSTLazyArray.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -125,15 +126,16 @@ NS_ASSUME_NONNULL_BEGIN
     FIRFirestore *firestore = self.firestore;
     BOOL fromCache = self.metadata.fromCache;
 
-    NSMutableArray<FIRQueryDocumentSnapshot *> *result = [NSMutableArray array];
-    for (FSTDocument *document in documentSet.documentEnumerator) {
-      [result addObject:[FIRQueryDocumentSnapshot snapshotWithFirestore:firestore
-                                                            documentKey:document.key
-                                                               document:document
-                                                              fromCache:fromCache]];
-    }
-
-    _documents = result;
+    // Snapshots are only created for the documents actually accessed, each found in O(log n).
+    _documents = [[FSTLazyArray alloc]
+        initWithCount:documentSet.count
+         elementBlock:^id(NSUInteger index) {
+           FSTDocument *document = [documentSet documentAtIndex:index];
+           return [FIRQueryDocumentSnapshot snapshotWithFirestore:firestore
+                                                      documentKey:document.key
+                                                         document:document
+                                                        fromCache:fromCache];
+         }];
   }
   return _documents;
 }
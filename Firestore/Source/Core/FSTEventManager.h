@@ -33,17 +33,43 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (instancetype)initWithIncludeQueryMetadataChanges:(BOOL)includeQueryMetadataChanges
                      includeDocumentMetadataChanges:(BOOL)includeDocumentMetadataChanges
+                         includeDocumentDataChanges:(BOOL)includeDocumentDataChanges
                               waitForSyncWhenOnline:(BOOL)waitForSyncWhenOnline
+                                documentChangesOnly:(BOOL)documentChangesOnly
     NS_DESIGNATED_INITIALIZER;
 
+/** Creates options that raise snapshots with the full results. */
+- (instancetype)initWithIncludeQueryMetadataChanges:(BOOL)includeQueryMetadataChanges
+                     includeDocumentMetadataChanges:(BOOL)includeDocumentMetadataChanges
+                         includeDocumentDataChanges:(BOOL)includeDocumentDataChanges
+                              waitForSyncWhenOnline:(BOOL)waitForSyncWhenOnline;
+
+/** Creates options that include document data changes. */
+- (instancetype)initWithIncludeQueryMetadataChanges:(BOOL)includeQueryMetadataChanges
+                     includeDocumentMetadataChanges:(BOOL)includeDocumentMetadataChanges
+                              waitForSyncWhenOnline:(BOOL)waitForSyncWhenOnline;
+
 - (instancetype)init NS_UNAVAILABLE;
 
 @property(nonatomic, assign, readonly) BOOL includeQueryMetadataChanges;
 
 @property(nonatomic, assign, readonly) BOOL includeDocumentMetadataChanges;
 
+/**
+ * Whether changes to the contents of documents that remain in the results should raise events.
+ * Listeners that only look at which documents match can turn this off.
+ */
+@property(nonatomic, assign, readonly) BOOL includeDocumentDataChanges;
+
 @property(nonatomic, assign, readonly) BOOL waitForSyncWhenOnline;
 
+/**
+ * Whether the raised snapshots carry only their documentChanges. Their documents and oldDocuments
+ * are empty and the listener doesn't hold on to the results once the first snapshot is raised, so
+ * consumers that keep their own copy of the results only pay for what changed.
+ */
+@property(nonatomic, assign, readonly) BOOL documentChangesOnly;
+
 @end
 
 #pragma mark - FSTQueryListener
@@ -40,15 +40,39 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (instancetype)initWithIncludeQueryMetadataChanges:(BOOL)includeQueryMetadataChanges
                      includeDocumentMetadataChanges:(BOOL)includeDocumentMetadataChanges
-                              waitForSyncWhenOnline:(BOOL)waitForSyncWhenOnline {
+                         includeDocumentDataChanges:(BOOL)includeDocumentDataChanges
+                              waitForSyncWhenOnline:(BOOL)waitForSyncWhenOnline
+                                documentChangesOnly:(BOOL)documentChangesOnly {
   if (self = [super init]) {
     _includeQueryMetadataChanges = includeQueryMetadataChanges;
     _includeDocumentMetadataChanges = includeDocumentMetadataChanges;
+    _includeDocumentDataChanges = includeDocumentDataChanges;
     _waitForSyncWhenOnline = waitForSyncWhenOnline;
+    _documentChangesOnly = documentChangesOnly;
   }
   return self;
 }
 
+- (instancetype)initWithIncludeQueryMetadataChanges:(BOOL)includeQueryMetadataChanges
+                     includeDocumentMetadataChanges:(BOOL)includeDocumentMetadataChanges
+                         includeDocumentDataChanges:(BOOL)includeDocumentDataChanges
+                              waitForSyncWhenOnline:(BOOL)waitForSyncWhenOnline {
+  return [self initWithIncludeQueryMetadataChanges:includeQueryMetadataChanges
+                    includeDocumentMetadataChanges:includeDocumentMetadataChanges
+                        includeDocumentDataChanges:includeDocumentDataChanges
+                             waitForSyncWhenOnline:waitForSyncWhenOnline
+                               documentChangesOnly:NO];
+}
+
+- (instancetype)initWithIncludeQueryMetadataChanges:(BOOL)includeQueryMetadataChanges
+                     includeDocumentMetadataChanges:(BOOL)includeDocumentMetadataChanges
+                              waitForSyncWhenOnline:(BOOL)waitForSyncWhenOnline {
+  return [self initWithIncludeQueryMetadataChanges:includeQueryMetadataChanges
+                    includeDocumentMetadataChanges:includeDocumentMetadataChanges
+                        includeDocumentDataChanges:YES
+                             waitForSyncWhenOnline:waitForSyncWhenOnline];
+}
+
 - (instancetype)init {
   FSTFail(@"FSTListenOptions init not supported");
   return nil;
@@ -56,6 +80,38 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+/**
+ * Returns a copy of the snapshot that doesn't retain the results from before it. Snapshots are
+ * kept around only for their current state, and holding on to the previous results too would keep
+ * the old version of every changed document alive until the next snapshot.
+ */
+static FSTViewSnapshot *FSTSnapshotForRetaining(FSTViewSnapshot *snapshot) {
+  return [[FSTViewSnapshot alloc]
+         initWithQuery:snapshot.query
+             documents:snapshot.documents
+          oldDocuments:[FSTDocumentSet documentSetWithComparator:snapshot.query.comparator]
+       documentChanges:snapshot.documentChanges
+             fromCache:snapshot.fromCache
+      hasPendingWrites:snapshot.hasPendingWrites
+      syncStateChanged:snapshot.syncStateChanged];
+}
+
+/**
+ * Returns a copy of the snapshot with the given changes and no documents, for listeners that only
+ * want the changes.
+ */
+static FSTViewSnapshot *FSTSnapshotWithoutDocuments(FSTViewSnapshot *snapshot,
+                                                    NSArray<FSTDocumentViewChange *> *changes) {
+  FSTDocumentSet *empty = [FSTDocumentSet documentSetWithComparator:snapshot.query.comparator];
+  return [[FSTViewSnapshot alloc] initWithQuery:snapshot.query
+                                      documents:empty
+                                   oldDocuments:empty
+                                documentChanges:changes
+                                      fromCache:snapshot.fromCache
+                               hasPendingWrites:snapshot.hasPendingWrites
+                               syncStateChanged:snapshot.syncStateChanged];
+}
+
 #pragma mark - FSTQueryListenersInfo
 
 /**
@@ -119,13 +175,19 @@ NS_ASSUME_NONNULL_BEGIN
   FSTAssert(snapshot.documentChanges.count > 0 || snapshot.syncStateChanged,
             @"We got a new snapshot with no changes?");
 
-  if (!self.options.includeDocumentMetadataChanges) {
-    // Remove the metadata-only changes.
+  if (!self.options.includeDocumentMetadataChanges || !self.options.includeDocumentDataChanges) {
+    // Remove the metadata-only changes and/or the changes to documents' contents.
     NSMutableArray<FSTDocumentViewChange *> *changes = [NSMutableArray array];
     for (FSTDocumentViewChange *change in snapshot.documentChanges) {
-      if (change.type != FSTDocumentViewChangeTypeMetadata) {
-        [changes addObject:change];
+      if (change.type == FSTDocumentViewChangeTypeMetadata &&
+          !self.options.includeDocumentMetadataChanges) {
+        continue;
       }
+      if (change.type == FSTDocumentViewChangeTypeModified &&
+          !self.options.includeDocumentDataChanges) {
+        continue;
+      }
+      [changes addObject:change];
     }
     snapshot = [[FSTViewSnapshot alloc] initWithQuery:snapshot.query
                                             documents:snapshot.documents
@@ -141,10 +203,15 @@ NS_ASSUME_NONNULL_BEGIN
       [self raiseInitialEventForSnapshot:snapshot];
     }
   } else if ([self shouldRaiseEventForSnapshot:snapshot]) {
-    self.viewSnapshotHandler(snapshot, nil);
+    [self raiseEventForSnapshot:snapshot];
   }
 
-  self.snapshot = snapshot;
+  if (self.options.documentChangesOnly && self.raisedInitialEvent) {
+    // Only the sync state is needed from here on.
+    self.snapshot = FSTSnapshotWithoutDocuments(snapshot, @[]);
+  } else {
+    self.snapshot = FSTSnapshotForRetaining(snapshot);
+  }
 }
 
 - (void)queryDidError:(NSError *)error {
@@ -184,9 +251,9 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (BOOL)shouldRaiseEventForSnapshot:(FSTViewSnapshot *)snapshot {
-  // We don't need to handle includeDocumentMetadataChanges here because the Metadata only changes
-  // have already been stripped out if needed. At this point the only changes we will see are the
-  // ones we should propagate.
+  // We don't need to handle includeDocumentMetadataChanges or includeDocumentDataChanges here
+  // because the changes they exclude have already been stripped out if needed. At this point the
+  // only changes we will see are the ones we should propagate.
   if (snapshot.documentChanges.count > 0) {
     return YES;
   }
@@ -198,7 +265,7 @@ NS_ASSUME_NONNULL_BEGIN
   }
 
   // Generally we should have hit one of the cases above, but it's possible to get here if there
-  // were only metadata docChanges and they got stripped out.
+  // were only metadata or data docChanges and they got stripped out.
   return NO;
 }
 
@@ -213,6 +280,13 @@ NS_ASSUME_NONNULL_BEGIN
       hasPendingWrites:snapshot.hasPendingWrites
       syncStateChanged:YES];
   self.raisedInitialEvent = YES;
+  [self raiseEventForSnapshot:snapshot];
+}
+
+- (void)raiseEventForSnapshot:(FSTViewSnapshot *)snapshot {
+  if (self.options.documentChangesOnly) {
+    snapshot = FSTSnapshotWithoutDocuments(snapshot, snapshot.documentChanges);
+  }
   self.viewSnapshotHandler(snapshot, nil);
 }
 
@@ -304,7 +378,7 @@ NS_ASSUME_NONNULL_BEGIN
       for (FSTQueryListener *listener in queryInfo.listeners) {
         [listener queryDidChangeViewSnapshot:viewSnapshot];
       }
-      queryInfo.viewSnapshot = viewSnapshot;
+      queryInfo.viewSnapshot = FSTSnapshotForRetaining(viewSnapshot);
     }
   }
 }
@@ -18,16 +18,20 @@
 
 #import "Firestore/Source/Core/FSTTypes.h"
 #import "Firestore/Source/Core/FSTViewSnapshot.h"
+#import "Firestore/Source/Model/FSTDocumentDictionary.h"
 #import "Firestore/Source/Remote/FSTRemoteStore.h"
 
 @class FSTDatabaseID;
 @class FSTDatabaseInfo;
 @class FSTDispatchQueue;
 @class FSTDocument;
+@class FSTDocumentKey;
 @class FSTListenOptions;
 @class FSTMutation;
 @class FSTQuery;
+@class FIRFirestoreSettings;
 @class FSTQueryListener;
+@class FSTSnapshotBatcher;
 @class FSTTransaction;
 @protocol FSTCredentialsProvider;
 
@@ -46,7 +50,7 @@ NS_ASSUME_NONNULL_BEGIN
  * All callbacks and events will be triggered on the provided userDispatchQueue.
  */
 + (instancetype)clientWithDatabaseInfo:(FSTDatabaseInfo *)databaseInfo
-                        usePersistence:(BOOL)usePersistence
+                              settings:(FIRFirestoreSettings *)settings
                    credentialsProvider:(id<FSTCredentialsProvider>)credentialsProvider
                      userDispatchQueue:(FSTDispatchQueue *)userDispatchQueue
                    workerDispatchQueue:(FSTDispatchQueue *)workerDispatchQueue;
@@ -62,11 +66,67 @@ NS_ASSUME_NONNULL_BEGIN
 /** Enables the network connection and requeues all pending operations. */
 - (void)enableNetworkWithCompletion:(nullable FSTVoidErrorBlock)completion;
 
+/** Opens the connections to the backend ahead of use. */
+- (void)prewarmNetwork;
+
+/**
+ * Reports the approximate sizes of the local persistent cache, keyed by the FIRFirestoreCacheTable
+ * constants, or nothing if persistence is disabled.
+ */
+- (void)getCacheSizesWithCompletion:
+    (void (^)(NSDictionary<NSString *, NSNumber *> *sizes))completion;
+
+/**
+ * Reports the approximate memory held by each part of the client, as described in
+ * -[FIRFirestore getMemoryUsageWithCompletion:].
+ */
+- (void)getMemoryUsageWithCompletion:
+    (void (^)(NSDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *usage))completion;
+
+/** Releases the memory held by caches that can be read back from persistence. */
+- (void)releaseCachedMemory;
+
+/** Loads a bundle into the local cache, as described in -[FIRFirestore loadBundle:completion:]. */
+- (void)loadBundle:(NSData *)bundle completion:(nullable FSTVoidErrorBlock)completion;
+
+/**
+ * Fetches the results of a query into the local cache, as described in
+ * -[FIRFirestore prefetchQuery:untilDate:progress:completion:].
+ */
+- (void)prefetchQuery:(FSTQuery *)query
+           expiryDate:(NSDate *)expiryDate
+             progress:(nullable void (^)(NSUInteger documentCount))progress
+           completion:(nullable FSTVoidErrorBlock)completion;
+
 /** Starts listening to a query. */
 - (FSTQueryListener *)listenToQuery:(FSTQuery *)query
                             options:(FSTListenOptions *)options
                 viewSnapshotHandler:(FSTViewSnapshotHandler)viewSnapshotHandler;
 
+/**
+ * Reads the documents with the given keys, as described in
+ * -[FIRFirestore getDocuments:completion:]. The completion is called on the user dispatch queue.
+ */
+- (void)getDocumentsWithKeys:(NSArray<FSTDocumentKey *> *)keys
+                  completion:(void (^)(FSTMaybeDocumentDictionary *_Nullable documents,
+                                       BOOL fromCache,
+                                       NSError *_Nullable error))completion;
+
+/**
+ * Reads the documents matching a query from the local cache, without waiting for the work queued
+ * on the worker queue. The read sees the cache as of the last local write or remote event applied,
+ * and its snapshot is always fromCache.
+ */
+- (void)getDocumentsFromLocalCache:(FSTQuery *)query
+                        completion:(void (^)(FSTViewSnapshot *snapshot))completion;
+
+/**
+ * Counts the documents matching a query in the local cache, using the cached target of the query
+ * when possible so that the documents needn't be read.
+ */
+- (void)countDocumentsFromLocalCache:(FSTQuery *)query
+                          completion:(void (^)(NSUInteger count))completion;
+
 /** Stops listening to a query previously listened to. */
 - (void)removeListener:(FSTQueryListener *)listener;
 
@@ -88,6 +148,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nonatomic, strong, readonly) FSTDispatchQueue *userDispatchQueue;
 
+/**
+ * Delivers snapshot events to the userDispatchQueue in batches, if snapshot batching is enabled in
+ * the settings.
+ */
+@property(nonatomic, strong, readonly, nullable) FSTSnapshotBatcher *snapshotBatcher;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -16,17 +16,24 @@
 
 #import "Firestore/Source/Core/FSTFirestoreClient.h"
 
+#import <SystemConfiguration/SystemConfiguration.h>
+
+#import "FIRFirestoreMetrics.h"
+#import "FIRFirestoreSettings.h"
 #import "Firestore/Source/Auth/FSTCredentialsProvider.h"
 #import "Firestore/Source/Core/FSTDatabaseInfo.h"
 #import "Firestore/Source/Core/FSTEventManager.h"
 #import "Firestore/Source/Core/FSTSyncEngine.h"
 #import "Firestore/Source/Core/FSTTransaction.h"
+#import "Firestore/Source/Core/FSTView.h"
+#import "Firestore/Source/Local/FSTBundle.h"
 #import "Firestore/Source/Local/FSTEagerGarbageCollector.h"
+#import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
 #import "Firestore/Source/Local/FSTLocalSerializer.h"
 #import "Firestore/Source/Local/FSTLocalStore.h"
 #import "Firestore/Source/Local/FSTMemoryPersistence.h"
-#import "Firestore/Source/Local/FSTNoOpGarbageCollector.h"
+#import "Firestore/Source/Model/FSTDocumentKeySet.h"
 #import "Firestore/Source/Remote/FSTDatastore.h"
 #import "Firestore/Source/Remote/FSTRemoteStore.h"
 #import "Firestore/Source/Remote/FSTSerializerBeta.h"
@@ -34,12 +41,19 @@
 #import "Firestore/Source/Util/FSTClasses.h"
 #import "Firestore/Source/Util/FSTDispatchQueue.h"
 #import "Firestore/Source/Util/FSTLogger.h"
+#import "Firestore/Source/Util/FSTSnapshotBatcher.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ * How long in seconds the local store must go without a commit before the tombstones of large
+ * removals in it are compacted, so that compactions don't compete with bursts of activity.
+ */
+static const NSTimeInterval kIdleCompactionDelay = 10.0;
+
 @interface FSTFirestoreClient ()
 - (instancetype)initWithDatabaseInfo:(FSTDatabaseInfo *)databaseInfo
-                      usePersistence:(BOOL)usePersistence
+                            settings:(FIRFirestoreSettings *)settings
                  credentialsProvider:(id<FSTCredentialsProvider>)credentialsProvider
                    userDispatchQueue:(FSTDispatchQueue *)userDispatchQueue
                  workerDispatchQueue:(FSTDispatchQueue *)queue NS_DESIGNATED_INITIALIZER;
@@ -61,24 +75,57 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property(nonatomic, strong, readonly) id<FSTCredentialsProvider> credentialsProvider;
 
+/**
+ * Concurrent queue on which cache-only reads run, so that they don't wait behind the worker
+ * queue. They only touch the local store's read view, which is safe to read from any thread.
+ */
+@property(nonatomic, strong, readonly) dispatch_queue_t cacheReadQueue;
+
+/**
+ * Left once initializeWithUser:settings: has run, after which the components may be used from the
+ * cacheReadQueue.
+ */
+@property(nonatomic, strong, readonly) dispatch_group_t initialized;
+
+/** Starts watching whether the backend host is reachable. */
+- (void)startMonitoringReachability;
+
+/** Stops watching the reachability of the backend host. Idempotent. */
+- (void)stopMonitoringReachability;
+
 @end
 
-@implementation FSTFirestoreClient
+/**
+ * Called on the worker queue when the reachability of the backend host changes, so that streams
+ * backing off after connection failures retry as soon as the network returns.
+ */
+static void FSTReachabilityCallback(SCNetworkReachabilityRef reachability,
+                                    SCNetworkReachabilityFlags flags,
+                                    void *info) {
+  if (flags & kSCNetworkReachabilityFlagsReachable) {
+    FSTFirestoreClient *client = (__bridge FSTFirestoreClient *)info;
+    [client.remoteStore networkDidBecomeReachable];
+  }
+}
+
+@implementation FSTFirestoreClient {
+  SCNetworkReachabilityRef _reachability;
+}
 
 + (instancetype)clientWithDatabaseInfo:(FSTDatabaseInfo *)databaseInfo
-                        usePersistence:(BOOL)usePersistence
+                              settings:(FIRFirestoreSettings *)settings
                    credentialsProvider:(id<FSTCredentialsProvider>)credentialsProvider
                      userDispatchQueue:(FSTDispatchQueue *)userDispatchQueue
                    workerDispatchQueue:(FSTDispatchQueue *)workerDispatchQueue {
   return [[FSTFirestoreClient alloc] initWithDatabaseInfo:databaseInfo
-                                           usePersistence:usePersistence
+                                                 settings:settings
                                       credentialsProvider:credentialsProvider
                                         userDispatchQueue:userDispatchQueue
                                       workerDispatchQueue:workerDispatchQueue];
 }
 
 - (instancetype)initWithDatabaseInfo:(FSTDatabaseInfo *)databaseInfo
-                      usePersistence:(BOOL)usePersistence
+                            settings:(FIRFirestoreSettings *)settings
                  credentialsProvider:(id<FSTCredentialsProvider>)credentialsProvider
                    userDispatchQueue:(FSTDispatchQueue *)userDispatchQueue
                  workerDispatchQueue:(FSTDispatchQueue *)workerDispatchQueue {
@@ -87,15 +134,28 @@ NS_ASSUME_NONNULL_BEGIN
     _credentialsProvider = credentialsProvider;
     _userDispatchQueue = userDispatchQueue;
     _workerDispatchQueue = workerDispatchQueue;
+    _cacheReadQueue = dispatch_queue_create("com.google.firebase.firestore.cacheReads",
+                                            DISPATCH_QUEUE_CONCURRENT);
+    _initialized = dispatch_group_create();
+    dispatch_group_enter(_initialized);
+    if (settings.isSnapshotBatchingEnabled) {
+      NSTimeInterval interval = settings.snapshotBatchingInterval;
+      _snapshotBatcher = [[FSTSnapshotBatcher alloc] initWithWorkerDispatchQueue:workerDispatchQueue
+                                                               userDispatchQueue:userDispatchQueue
+                                                                 minimumInterval:interval];
+    }
 
+    NSDate *creationTime = [NSDate date];
     dispatch_semaphore_t initialUserAvailable = dispatch_semaphore_create(0);
     __block FSTUser *initialUser;
+    __block NSTimeInterval credentialsLatency = 0;
     FSTWeakify(self);
     _credentialsProvider.userChangeListener = ^(FSTUser *user) {
       FSTStrongify(self);
       if (self) {
         if (!initialUser) {
           initialUser = user;
+          credentialsLatency = -[creationTime timeIntervalSinceNow];
           dispatch_semaphore_signal(initialUserAvailable);
         } else {
           [workerDispatchQueue dispatchAsync:^{
@@ -107,29 +167,64 @@ NS_ASSUME_NONNULL_BEGIN
 
     // Defer initialization until we get the current user from the userChangeListener. This is
     // guaranteed to be synchronously dispatched onto our worker queue, so we will be initialized
-    // before any subsequently queued work runs.
+    // before any subsequently queued work runs. The local cache doesn't depend on the user, so it's
+    // opened while the initial user is still being fetched.
     [_workerDispatchQueue dispatchAsync:^{
+      id<FSTGarbageCollector> garbageCollector = [self startPersistenceWithSettings:settings];
       dispatch_semaphore_wait(initialUserAvailable, DISPATCH_TIME_FOREVER);
-
-      [self initializeWithUser:initialUser usePersistence:usePersistence];
+      [settings.metricsProvider recordValue:credentialsLatency
+                               forHistogram:FIRFirestoreMetricStartupCredentialsLatency];
+
+      [self initializeWithUser:initialUser
+                      settings:settings
+              garbageCollector:garbageCollector];
+      [settings.metricsProvider recordValue:-[creationTime timeIntervalSinceNow]
+                               forHistogram:FIRFirestoreMetricStartupLatency];
+      dispatch_group_leave(self.initialized);
     }];
+    [self startMonitoringReachability];
   }
   return self;
 }
 
-- (void)initializeWithUser:(FSTUser *)user usePersistence:(BOOL)usePersistence {
-  // Do all of our initialization on our own dispatch queue.
+- (void)dealloc {
+  [self stopMonitoringReachability];
+}
+
+- (void)startMonitoringReachability {
+  _reachability =
+      SCNetworkReachabilityCreateWithName(kCFAllocatorDefault, [self.databaseInfo.host UTF8String]);
+  if (!_reachability) {
+    FSTWarn(@"Failed to set up network reachability monitoring");
+    return;
+  }
+  SCNetworkReachabilityContext context = {0, (__bridge void *)self, NULL, NULL, NULL};
+  if (!SCNetworkReachabilitySetCallback(_reachability, FSTReachabilityCallback, &context) ||
+      !SCNetworkReachabilitySetDispatchQueue(_reachability, self.workerDispatchQueue.queue)) {
+    FSTWarn(@"Failed to set up network reachability monitoring");
+    [self stopMonitoringReachability];
+  }
+}
+
+- (void)stopMonitoringReachability {
+  if (_reachability) {
+    SCNetworkReachabilitySetCallback(_reachability, NULL, NULL);
+    SCNetworkReachabilitySetDispatchQueue(_reachability, NULL);
+    CFRelease(_reachability);
+    _reachability = NULL;
+  }
+}
+
+/**
+ * Creates and starts the persistence layer, returning the garbage collector to use with it. This
+ * doesn't depend on the user, so it can run before the initial user is known.
+ */
+- (id<FSTGarbageCollector>)startPersistenceWithSettings:(FIRFirestoreSettings *)settings {
   [self.workerDispatchQueue verifyIsCurrentQueue];
 
-  // Note: The initialization work must all be synchronous (we can't dispatch more work) since
-  // external write/listen operations could get queued to run before that subsequent work
-  // completes.
+  NSDate *startTime = [NSDate date];
   id<FSTGarbageCollector> garbageCollector;
-  if (usePersistence) {
-    // TODO(http://b/33384523): For now we just disable garbage collection when persistence is
-    // enabled.
-    garbageCollector = [[FSTNoOpGarbageCollector alloc] init];
-
+  if (settings.isPersistenceEnabled) {
     NSString *dir = [FSTLevelDB storageDirectoryForDatabaseInfo:self.databaseInfo
                                              documentsDirectory:[FSTLevelDB documentsDirectory]];
 
@@ -138,7 +233,29 @@ NS_ASSUME_NONNULL_BEGIN
     FSTLocalSerializer *serializer =
         [[FSTLocalSerializer alloc] initWithRemoteSerializer:remoteSerializer];
 
-    _persistence = [[FSTLevelDB alloc] initWithDirectory:dir serializer:serializer];
+    FSTLevelDB *leveldb =
+        [[FSTLevelDB alloc] initWithDirectory:dir
+                                   serializer:serializer
+                               blockCacheSize:settings.persistenceCacheSizeBytes
+                              writeBufferSize:settings.persistenceWriteBufferSizeBytes];
+    [leveldb enableIdleCompactionWithDelay:kIdleCompactionDelay
+                       workerDispatchQueue:self.workerDispatchQueue];
+    _persistence = leveldb;
+
+    garbageCollector = [[FSTLRUGarbageCollector alloc]
+        initWithThreshold:settings.persistenceGarbageCollectionThresholdBytes
+                cacheSize:^{
+                  return [leveldb approximateCacheSizeBytes];
+                }];
+  } else if (settings.memoryGarbageCollectionThresholdDocuments > 0) {
+    FSTMemoryPersistence *memory = [FSTMemoryPersistence persistence];
+    _persistence = memory;
+
+    garbageCollector = [[FSTLRUGarbageCollector alloc]
+        initWithThreshold:settings.memoryGarbageCollectionThresholdDocuments
+                cacheSize:^{
+                  return [memory cachedDocumentCount];
+                }];
   } else {
     garbageCollector = [[FSTEagerGarbageCollector alloc] init];
     _persistence = [FSTMemoryPersistence persistence];
@@ -152,7 +269,20 @@ NS_ASSUME_NONNULL_BEGIN
     // can't ignore.
     [NSException raise:NSInternalInconsistencyException format:@"Failed to open DB: %@", error];
   }
+  [settings.metricsProvider recordValue:-[startTime timeIntervalSinceNow]
+                           forHistogram:FIRFirestoreMetricStartupPersistenceLatency];
+  return garbageCollector;
+}
 
+- (void)initializeWithUser:(FSTUser *)user
+                  settings:(FIRFirestoreSettings *)settings
+          garbageCollector:(id<FSTGarbageCollector>)garbageCollector {
+  // Do all of our initialization on our own dispatch queue.
+  [self.workerDispatchQueue verifyIsCurrentQueue];
+
+  // Note: The initialization work must all be synchronous (we can't dispatch more work) since
+  // external write/listen operations could get queued to run before that subsequent work
+  // completes.
   _localStore = [[FSTLocalStore alloc] initWithPersistence:_persistence
                                           garbageCollector:garbageCollector
                                                initialUser:user];
@@ -160,12 +290,24 @@ NS_ASSUME_NONNULL_BEGIN
   FSTDatastore *datastore = [FSTDatastore datastoreWithDatabase:self.databaseInfo
                                             workerDispatchQueue:self.workerDispatchQueue
                                                     credentials:self.credentialsProvider];
+  datastore.compressionEnabled = settings.isCompressionEnabled;
+  datastore.streamIdleTimeout = settings.streamIdleTimeout;
+  datastore.metricsProvider = settings.metricsProvider;
 
   _remoteStore = [FSTRemoteStore remoteStoreWithLocalStore:_localStore datastore:datastore];
+  _remoteStore.writeCoalescingEnabled = settings.isWriteCoalescingEnabled;
+  [_remoteStore enableBatchedWriteAcknowledgementsWithWorkerDispatchQueue:self.workerDispatchQueue];
+  if (settings.syncCoalescingInterval > 0) {
+    [_remoteStore enableRemoteEventCoalescingWithInterval:settings.syncCoalescingInterval
+                                      workerDispatchQueue:self.workerDispatchQueue];
+  }
 
   _syncEngine = [[FSTSyncEngine alloc] initWithLocalStore:_localStore
                                               remoteStore:_remoteStore
                                               initialUser:user];
+  _syncEngine.workerDispatchQueue = self.workerDispatchQueue;
+  _syncEngine.writeSquashingEnabled = settings.isWriteSquashingEnabled;
+  _syncEngine.targetMultiplexingEnabled = settings.isTargetMultiplexingEnabled;
 
   _eventManager = [FSTEventManager eventManagerWithSyncEngine:_syncEngine];
 
@@ -176,8 +318,15 @@ NS_ASSUME_NONNULL_BEGIN
 
   // NOTE: RemoteStore depends on LocalStore (for persisting stream tokens, refilling mutation
   // queue, etc.) so must be started after LocalStore.
+  NSDate *startTime = [NSDate date];
   [_localStore start];
+  [settings.metricsProvider recordValue:-[startTime timeIntervalSinceNow]
+                           forHistogram:FIRFirestoreMetricStartupLocalStoreLatency];
+
+  startTime = [NSDate date];
   [_remoteStore start];
+  [settings.metricsProvider recordValue:-[startTime timeIntervalSinceNow]
+                           forHistogram:FIRFirestoreMetricStartupRemoteStoreLatency];
 }
 
 - (void)userDidChange:(FSTUser *)user {
@@ -214,9 +363,165 @@ NS_ASSUME_NONNULL_BEGIN
   }];
 }
 
+- (void)prewarmNetwork {
+  [self.workerDispatchQueue dispatchAsync:^{
+    [self.remoteStore prewarmStreams];
+  }];
+}
+
+- (void)getCacheSizesWithCompletion:
+    (void (^)(NSDictionary<NSString *, NSNumber *> *sizes))completion {
+  [self.workerDispatchQueue dispatchAsync:^{
+    NSDictionary<NSString *, NSNumber *> *result = @{};
+    if ([self.persistence isKindOfClass:[FSTLevelDB class]]) {
+      FSTLevelDBTableSizes sizes = [(FSTLevelDB *)self.persistence approximateTableSizes];
+      result = @{
+        FIRFirestoreCacheTableRemoteDocuments : @(sizes.remoteDocuments),
+        FIRFirestoreCacheTableMutations : @(sizes.mutations),
+        FIRFirestoreCacheTableTargets : @(sizes.targets),
+        FIRFirestoreCacheTableTargetDocuments : @(sizes.targetDocuments),
+      };
+    }
+    [self.userDispatchQueue dispatchAsync:^{
+      completion(result);
+    }];
+  }];
+}
+
+/** Converts a memory usage to its public form, as reported by getMemoryUsageWithCompletion:. */
+static NSDictionary<NSString *, NSNumber *> *FSTMemoryUsageDictionary(FSTMemoryUsage usage) {
+  return @{
+    FIRFirestoreMemoryObjectCount : @(usage.objects),
+    FIRFirestoreMemoryApproximateBytes : @(usage.bytes),
+  };
+}
+
+- (void)getMemoryUsageWithCompletion:
+    (void (^)(NSDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *usage))completion {
+  [self.workerDispatchQueue dispatchAsync:^{
+    NSMutableDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *result =
+        [NSMutableDictionary dictionary];
+    result[FIRFirestoreMemoryComponentCachedDocuments] =
+        FSTMemoryUsageDictionary([self.localStore remoteDocumentMemoryUsage]);
+    result[FIRFirestoreMemoryComponentReferences] = FSTMemoryUsageDictionary(
+        FSTMemoryUsageAdd([self.localStore localViewReferenceMemoryUsage],
+                          [self.syncEngine limboReferenceMemoryUsage]));
+    result[FIRFirestoreMemoryComponentPendingWrites] =
+        FSTMemoryUsageDictionary([self.remoteStore pendingWriteMemoryUsage]);
+    result[FIRFirestoreMemoryComponentQueuedMessages] =
+        FSTMemoryUsageDictionary([self.remoteStore queuedWatchChangeMemoryUsage]);
+
+    __block FSTMemoryUsage listenerResults{0, 0};
+    [self.syncEngine enumerateViewMemoryUsageUsingBlock:^(FSTQuery *query, FSTMemoryUsage usage) {
+      listenerResults = FSTMemoryUsageAdd(listenerResults, usage);
+      NSString *key = [NSString
+          stringWithFormat:@"%@:%@", FIRFirestoreMemoryComponentListenerResults, query.canonicalID];
+      result[key] = FSTMemoryUsageDictionary(usage);
+    }];
+    result[FIRFirestoreMemoryComponentListenerResults] = FSTMemoryUsageDictionary(listenerResults);
+
+    [self.userDispatchQueue dispatchAsync:^{
+      completion(result);
+    }];
+  }];
+}
+
+- (void)releaseCachedMemory {
+  [self.workerDispatchQueue dispatchAsync:^{
+    [self.localStore releaseCachedMemory];
+  }];
+}
+
+- (void)loadBundle:(NSData *)bundle completion:(nullable FSTVoidErrorBlock)completion {
+  [self.workerDispatchQueue dispatchAsync:^{
+    FSTSerializerBeta *remoteSerializer =
+        [[FSTSerializerBeta alloc] initWithDatabaseID:self.databaseInfo.databaseID];
+    FSTLocalSerializer *serializer =
+        [[FSTLocalSerializer alloc] initWithRemoteSerializer:remoteSerializer];
+    FSTBundleReader *reader = [[FSTBundleReader alloc] initWithData:bundle serializer:serializer];
+
+    NSError *error;
+    [self.syncEngine loadBundle:reader error:&error];
+    if (completion) {
+      [self.userDispatchQueue dispatchAsync:^{
+        completion(error);
+      }];
+    }
+  }];
+}
+
+- (void)prefetchQuery:(FSTQuery *)query
+           expiryDate:(NSDate *)expiryDate
+             progress:(nullable void (^)(NSUInteger documentCount))progress
+           completion:(nullable FSTVoidErrorBlock)completion {
+  FSTPrefetchProgressBlock progressBlock;
+  if (progress) {
+    progressBlock = ^(NSUInteger documentCount) {
+      [self.userDispatchQueue dispatchAsync:^{
+        progress(documentCount);
+      }];
+    };
+  }
+  [self.workerDispatchQueue dispatchAsync:^{
+    [self.syncEngine prefetchQuery:query
+                        expiryDate:expiryDate
+                          progress:progressBlock
+                        completion:^(NSError *_Nullable error) {
+                          if (completion) {
+                            [self.userDispatchQueue dispatchAsync:^{
+                              completion(error);
+                            }];
+                          }
+                        }];
+  }];
+}
+
+- (void)getDocumentsWithKeys:(NSArray<FSTDocumentKey *> *)keys
+                  completion:(void (^)(FSTMaybeDocumentDictionary *_Nullable documents,
+                                       BOOL fromCache,
+                                       NSError *_Nullable error))completion {
+  [self.workerDispatchQueue dispatchAsync:^{
+    [self.syncEngine lookupDocumentsWithKeys:keys
+                                  completion:^(FSTMaybeDocumentDictionary *_Nullable documents,
+                                               BOOL fromCache, NSError *_Nullable error) {
+                                    [self.userDispatchQueue dispatchAsync:^{
+                                      completion(documents, fromCache, error);
+                                    }];
+                                  }];
+  }];
+}
+
+- (void)getDocumentsFromLocalCache:(FSTQuery *)query
+                        completion:(void (^)(FSTViewSnapshot *snapshot))completion {
+  dispatch_group_notify(self.initialized, self.cacheReadQueue, ^{
+    FSTDocumentDictionary *docs = [self.localStore executeQueryInReadView:query];
+
+    // Run the results through a view to apply the limit and order, as for a listen.
+    FSTView *view =
+        [[FSTView alloc] initWithQuery:query remoteDocuments:[FSTDocumentKeySet keySet]];
+    FSTViewDocumentChanges *viewDocChanges = [view computeChangesWithDocuments:docs];
+    FSTViewChange *viewChange = [view applyChangesToDocuments:viewDocChanges];
+    FSTViewSnapshot *snapshot = viewChange.snapshot;
+    [self.userDispatchQueue dispatchAsync:^{
+      completion(snapshot);
+    }];
+  });
+}
+
+- (void)countDocumentsFromLocalCache:(FSTQuery *)query
+                          completion:(void (^)(NSUInteger count))completion {
+  [self.workerDispatchQueue dispatchAsync:^{
+    NSUInteger count = [self.localStore countOfDocumentsMatchingQuery:query];
+    [self.userDispatchQueue dispatchAsync:^{
+      completion(count);
+    }];
+  }];
+}
+
 - (void)shutdownWithCompletion:(nullable FSTVoidErrorBlock)completion {
   [self.workerDispatchQueue dispatchAsync:^{
     self.credentialsProvider.userChangeListener = nil;
+    [self stopMonitoringReachability];
 
     [self.remoteStore shutdown];
     [self.localStore shutdown];
@@ -32,6 +32,19 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (FSTListenSequenceNumber)next;
 
+/**
+ * Returns YES if the next call to next would return a number beyond the end of the last block
+ * reserved with reserveBlockOfSize:.
+ */
+- (BOOL)needsReservation;
+
+/**
+ * Reserves the next `size` sequence numbers as a block, returning the highest of them. Callers
+ * that must not reuse sequence numbers across restarts persist it before using the block and
+ * start the next sequence after it.
+ */
+- (FSTListenSequenceNumber)reserveBlockOfSize:(FSTListenSequenceNumber)size;
+
 @end
 
 NS_ASSUME_NONNULL_END
\ No newline at end of file
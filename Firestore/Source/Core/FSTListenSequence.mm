@@ -16,12 +16,16 @@
 
 #import "FSTListenSequence.h"
 
+#import "Firestore/Source/Util/FSTAssert.h"
+
 NS_ASSUME_NONNULL_BEGIN
 
 #pragma mark - FSTListenSequence
 
 @interface FSTListenSequence () {
   FSTListenSequenceNumber _previousSequenceNumber;
+  // The highest number reserved so far, or _previousSequenceNumber if none are reserved.
+  FSTListenSequenceNumber _reservedSequenceNumber;
 }
 
 @end
@@ -34,6 +38,7 @@ NS_ASSUME_NONNULL_BEGIN
   self = [super init];
   if (self) {
     _previousSequenceNumber = after;
+    _reservedSequenceNumber = after;
   }
   return self;
 }
@@ -45,6 +50,16 @@ NS_ASSUME_NONNULL_BEGIN
   return _previousSequenceNumber;
 }
 
+- (BOOL)needsReservation {
+  return _previousSequenceNumber >= _reservedSequenceNumber;
+}
+
+- (FSTListenSequenceNumber)reserveBlockOfSize:(FSTListenSequenceNumber)size {
+  FSTAssert(size > 0, @"Invalid block size: %lld", (long long)size);
+  _reservedSequenceNumber = _previousSequenceNumber + size;
+  return _reservedSequenceNumber;
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
\ No newline at end of file
@@ -16,6 +16,7 @@
 
 #import <Foundation/Foundation.h>
 
+@class FIRGeoPoint;
 @class FSTDocument;
 @class FSTDocumentKey;
 @class FSTFieldPath;
@@ -96,6 +97,25 @@ typedef NS_ENUM(NSInteger, FSTRelationFilterOperator) {
 - (instancetype)initWithField:(FSTFieldPath *)field NS_DESIGNATED_INITIALIZER;
 @end
 
+/**
+ * Filter that matches GeoPoint values within a bounding box, edges included. The box spans the
+ * antimeridian if its southwest corner is east of its northeast corner.
+ *
+ * The backend has no equivalent, so only queries evaluated against the local cache can use it.
+ */
+@interface FSTGeoBoundsFilter : NSObject <FSTFilter>
+- (instancetype)init NS_UNAVAILABLE;
+- (instancetype)initWithField:(FSTFieldPath *)field
+                    southWest:(FIRGeoPoint *)southWest
+                    northEast:(FIRGeoPoint *)northEast NS_DESIGNATED_INITIALIZER;
+
+/** The southwest corner of the box. */
+@property(nonatomic, strong, readonly) FIRGeoPoint *southWest;
+
+/** The northeast corner of the box. */
+@property(nonatomic, strong, readonly) FIRGeoPoint *northEast;
+@end
+
 /** FSTSortOrder is a field and direction to order query results by. */
 @interface FSTSortOrder : NSObject <NSCopying>
 
@@ -234,6 +254,12 @@ typedef NS_ENUM(NSInteger, FSTRelationFilterOperator) {
 /** Returns YES if the @a document matches the constraints of the receiver. */
 - (BOOL)matchesDocument:(FSTDocument *)document;
 
+/**
+ * Returns YES if a document with the given key is in the part of the database the receiver
+ * covers, i.e. if the document could match the receiver, depending on its contents.
+ */
+- (BOOL)pathMatchesKey:(FSTDocumentKey *)key;
+
 /** Returns a comparator that will sort documents according to the receiver's sort order. */
 - (NSComparator)comparator;
 
@@ -243,6 +269,19 @@ typedef NS_ENUM(NSInteger, FSTRelationFilterOperator) {
 /** Returns the first field in an order-by constraint, or nil if none. */
 - (FSTFieldPath *_Nullable)firstSortOrderField;
 
+/**
+ * If the results are ordered by document key first and a bound limits the keys from below, returns
+ * the lowest key that can match (which itself may be excluded by the bound), or nil otherwise.
+ * Lets the local store start scanning a collection at the first page that can match.
+ */
+- (FSTDocumentKey *_Nullable)lowestKeyInBounds;
+
+/**
+ * If the results are ordered by document key first and a bound limits the keys from above, returns
+ * the highest key that can match (which itself may be excluded by the bound), or nil otherwise.
+ */
+- (FSTDocumentKey *_Nullable)highestKeyInBounds;
+
 /** The base path of the query. */
 @property(nonatomic, strong, readonly) FSTResourcePath *path;
 
@@ -258,6 +297,13 @@ typedef NS_ENUM(NSInteger, FSTRelationFilterOperator) {
  */
 @property(nonatomic, strong, readonly) NSString *canonicalID;
 
+/**
+ * A 64-bit hash of the canonicalID, computed once per instance. Equivalent queries have the same
+ * fingerprint, so queries with different fingerprints are known to differ without comparing them
+ * any further.
+ */
+@property(nonatomic, assign, readonly) uint64_t fingerprint;
+
 /** An optional bound to start the query at. */
 @property(nonatomic, nullable, strong, readonly) FSTBound *startAt;
 
@@ -16,6 +16,7 @@
 
 #import "Firestore/Source/Core/FSTQuery.h"
 
+#import "FIRGeoPoint.h"
 #import "Firestore/Source/API/FIRFirestore+Internal.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTDocumentKey.h"
@@ -23,8 +24,26 @@
 #import "Firestore/Source/Model/FSTPath.h"
 #import "Firestore/Source/Util/FSTAssert.h"
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/canonical_id.h"
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+
+namespace core = firebase::firestore::core;
+namespace util = firebase::firestore::util;
+
 NS_ASSUME_NONNULL_BEGIN
 
+/** A filter that decides whether a document matches from the value of its field alone. */
+@protocol FSTValueFilter <FSTFilter>
+
+/** Returns YES if a document whose field has the given value (or nil if absent) matches. */
+- (BOOL)matchesValue:(nullable FSTFieldValue *)value;
+
+@end
+
 #pragma mark - FSTRelationFilterOperator functions
 
 /**
@@ -53,7 +72,7 @@ NSString *FSTStringFromQueryRelationOperator(FSTRelationFilterOperator filterOpe
 
 #pragma mark - FSTRelationFilter
 
-@interface FSTRelationFilter ()
+@interface FSTRelationFilter () <FSTValueFilter>
 
 /**
  * Initializes the receiver relation filter.
@@ -158,7 +177,7 @@ NSString *FSTStringFromQueryRelationOperator(FSTRelationFilterOperator filterOpe
 }
 
 /** Returns YES if receiver is true with the given value as its LHS. */
-- (BOOL)matchesValue:(FSTFieldValue *)other {
+- (BOOL)matchesValue:(nullable FSTFieldValue *)other {
   // Only compare types with matching backend order (such as double and int).
   return self.value.typeOrder == other.typeOrder &&
          [self matchesComparison:[other compare:self.value]];
@@ -185,7 +204,7 @@ NSString *FSTStringFromQueryRelationOperator(FSTRelationFilterOperator filterOpe
 
 #pragma mark - FSTNullFilter
 
-@interface FSTNullFilter ()
+@interface FSTNullFilter () <FSTValueFilter>
 @property(nonatomic, strong, readonly) FSTFieldPath *field;
 @end
 
@@ -198,7 +217,10 @@ NSString *FSTStringFromQueryRelationOperator(FSTRelationFilterOperator filterOpe
 }
 
 - (BOOL)matchesDocument:(FSTDocument *)document {
-  FSTFieldValue *fieldValue = [document fieldForPath:self.field];
+  return [self matchesValue:[document fieldForPath:self.field]];
+}
+
+- (BOOL)matchesValue:(nullable FSTFieldValue *)fieldValue {
   return fieldValue != nil && [fieldValue isEqual:[FSTNullValue nullValue]];
 }
 
@@ -225,7 +247,7 @@ NSString *FSTStringFromQueryRelationOperator(FSTRelationFilterOperator filterOpe
 
 #pragma mark - FSTNanFilter
 
-@interface FSTNanFilter ()
+@interface FSTNanFilter () <FSTValueFilter>
 @property(nonatomic, strong, readonly) FSTFieldPath *field;
 @end
 
@@ -239,7 +261,10 @@ NSString *FSTStringFromQueryRelationOperator(FSTRelationFilterOperator filterOpe
 }
 
 - (BOOL)matchesDocument:(FSTDocument *)document {
-  FSTFieldValue *fieldValue = [document fieldForPath:self.field];
+  return [self matchesValue:[document fieldForPath:self.field]];
+}
+
+- (BOOL)matchesValue:(nullable FSTFieldValue *)fieldValue {
   return fieldValue != nil && [fieldValue isEqual:[FSTDoubleValue nanValue]];
 }
 
@@ -263,6 +288,73 @@ NSString *FSTStringFromQueryRelationOperator(FSTRelationFilterOperator filterOpe
 }
 @end
 
+#pragma mark - FSTGeoBoundsFilter
+
+@interface FSTGeoBoundsFilter () <FSTValueFilter>
+@property(nonatomic, strong, readonly) FSTFieldPath *field;
+@end
+
+@implementation FSTGeoBoundsFilter
+
+- (instancetype)initWithField:(FSTFieldPath *)field
+                    southWest:(FIRGeoPoint *)southWest
+                    northEast:(FIRGeoPoint *)northEast {
+  if (self = [super init]) {
+    _field = field;
+    _southWest = southWest;
+    _northEast = northEast;
+  }
+  return self;
+}
+
+- (BOOL)matchesDocument:(FSTDocument *)document {
+  return [self matchesValue:[document fieldForPath:self.field]];
+}
+
+- (BOOL)matchesValue:(nullable FSTFieldValue *)fieldValue {
+  if (![fieldValue isKindOfClass:[FSTGeoPointValue class]]) {
+    return NO;
+  }
+  FIRGeoPoint *point = [(FSTGeoPointValue *)fieldValue value];
+  if (point.latitude < self.southWest.latitude || point.latitude > self.northEast.latitude) {
+    return NO;
+  }
+  if (self.southWest.longitude <= self.northEast.longitude) {
+    return point.longitude >= self.southWest.longitude &&
+           point.longitude <= self.northEast.longitude;
+  }
+  return point.longitude >= self.southWest.longitude ||
+         point.longitude <= self.northEast.longitude;
+}
+
+- (NSString *)canonicalID {
+  return [NSString stringWithFormat:@"%@ WITHIN [%f,%f],[%f,%f]", [self.field canonicalString],
+                                    self.southWest.latitude, self.southWest.longitude,
+                                    self.northEast.latitude, self.northEast.longitude];
+}
+
+- (NSString *)description {
+  return [self canonicalID];
+}
+
+- (BOOL)isEqual:(id)other {
+  if (other == self) return YES;
+  if (![[other class] isEqual:[self class]]) return NO;
+
+  FSTGeoBoundsFilter *otherFilter = (FSTGeoBoundsFilter *)other;
+  return [self.field isEqual:otherFilter.field] &&
+         [self.southWest isEqual:otherFilter.southWest] &&
+         [self.northEast isEqual:otherFilter.northEast];
+}
+
+- (NSUInteger)hash {
+  NSUInteger hash = [self.field hash];
+  hash = hash * 31 + [self.southWest hash];
+  hash = hash * 31 + [self.northEast hash];
+  return hash;
+}
+@end
+
 #pragma mark - FSTSortOrder
 
 @interface FSTSortOrder ()
@@ -439,11 +531,174 @@ NSString *FSTStringFromQueryRelationOperator(FSTRelationFilterOperator filterOpe
 
 @end
 
+#pragma mark - QueryMatcher
+
+namespace {
+
+/** The estimated relative cost of a check made by a QueryMatcher, cheapest first. */
+enum class CheckCost {
+  /** Compares the document key, which needs no field lookup. */
+  Key,
+  /** Tests a field for presence or for a specific type of value. */
+  Type,
+  /** Tests a field for equality with a value. */
+  Equality,
+  /** Orders a field against a value, or anything else. */
+  Other,
+};
+
+/**
+ * The filters and orderBy constraints of a query, compiled once so that matching a document
+ * doesn't redo the work for every document.
+ *
+ * The checks are ordered so that the cheapest run first, and each field they read is resolved at
+ * most once per document. Fields that share a top-level field also share its lookup, which is the
+ * part that may need to decode the document.
+ */
+class QueryMatcher {
+ public:
+  QueryMatcher(NSArray<id<FSTFilter>> *filters, NSArray<FSTSortOrder *> *explicitSortOrders);
+
+  /** Returns true if the document matches all the compiled filters and orderBy constraints. */
+  bool Matches(FSTDocument *document) const;
+
+ private:
+  static constexpr size_t kNoField = static_cast<size_t>(-1);
+
+  /** A single check of a document. */
+  struct Check {
+    CheckCost cost;
+    /** The filter to apply, or nil if the field only needs to be present. */
+    id<FSTFilter> _Nullable filter;
+    /** The index of the field in fields_, or kNoField if the filter reads the document itself. */
+    size_t field;
+  };
+
+  /** A field read by one or more checks. */
+  struct Field {
+    /** The index of the top-level field containing this field in heads_. */
+    size_t head;
+    /** The path from the top-level field to this field, or nil if this is the top-level field. */
+    FSTFieldPath *_Nullable tail;
+  };
+
+  /** Returns the index of the given field in fields_, adding it if necessary. */
+  size_t AddField(FSTFieldPath *path);
+
+  std::vector<FSTFieldPath *> heads_;
+  std::vector<FSTFieldPath *> field_paths_;
+  std::vector<Field> fields_;
+  std::vector<Check> checks_;
+};
+
+constexpr size_t QueryMatcher::kNoField;
+
+QueryMatcher::QueryMatcher(NSArray<id<FSTFilter>> *filters,
+                           NSArray<FSTSortOrder *> *explicitSortOrders) {
+  // A document must have a value for every ordering clause in order to show up in the results.
+  // Order by key always matches.
+  for (FSTSortOrder *orderBy in explicitSortOrders) {
+    if (![orderBy.field isKeyFieldPath]) {
+      checks_.push_back(Check{CheckCost::Type, nil, AddField(orderBy.field)});
+    }
+  }
+
+  for (id<FSTFilter> filter in filters) {
+    if (![filter conformsToProtocol:@protocol(FSTValueFilter)] || [filter.field isKeyFieldPath]) {
+      BOOL isKeyFilter = [filter isKindOfClass:[FSTRelationFilter class]];
+      checks_.push_back(
+          Check{isKeyFilter ? CheckCost::Key : CheckCost::Other, filter, kNoField});
+    } else if (![filter isKindOfClass:[FSTRelationFilter class]]) {
+      checks_.push_back(Check{CheckCost::Type, filter, AddField(filter.field)});
+    } else {
+      BOOL isInequality = [(FSTRelationFilter *)filter isInequality];
+      checks_.push_back(Check{isInequality ? CheckCost::Other : CheckCost::Equality, filter,
+                              AddField(filter.field)});
+    }
+  }
+
+  // All checks must pass, so they can run in any order. Keep the query's order among checks of
+  // the same cost.
+  std::stable_sort(checks_.begin(), checks_.end(),
+                   [](const Check &lhs, const Check &rhs) { return lhs.cost < rhs.cost; });
+}
+
+size_t QueryMatcher::AddField(FSTFieldPath *path) {
+  for (size_t i = 0; i < field_paths_.size(); i++) {
+    if ([field_paths_[i] isEqual:path]) {
+      return i;
+    }
+  }
+
+  NSString *firstSegment = [path firstSegment];
+  size_t head = 0;
+  while (head < heads_.size() && ![[heads_[head] firstSegment] isEqualToString:firstSegment]) {
+    head++;
+  }
+  if (head == heads_.size()) {
+    heads_.push_back([FSTFieldPath pathWithSegments:@[ firstSegment ]]);
+  }
+
+  field_paths_.push_back(path);
+  fields_.push_back(Field{head, path.length > 1 ? [path pathByRemovingFirstSegment] : nil});
+  return fields_.size() - 1;
+}
+
+bool QueryMatcher::Matches(FSTDocument *document) const {
+  // Values are resolved lazily, so a document that fails an early check never reads the fields
+  // of the later ones.
+  std::vector<FSTFieldValue *> headValues(heads_.size());
+  std::vector<bool> headsResolved(heads_.size());
+  std::vector<FSTFieldValue *> fieldValues(fields_.size());
+  std::vector<bool> fieldsResolved(fields_.size());
+
+  for (const Check &check : checks_) {
+    if (check.field == kNoField) {
+      if (![check.filter matchesDocument:document]) {
+        return false;
+      }
+      continue;
+    }
+
+    if (!fieldsResolved[check.field]) {
+      const Field &field = fields_[check.field];
+      if (!headsResolved[field.head]) {
+        headValues[field.head] = [document fieldForPath:heads_[field.head]];
+        headsResolved[field.head] = true;
+      }
+      FSTFieldValue *_Nullable value = headValues[field.head];
+      if (field.tail) {
+        value = [value isMemberOfClass:[FSTObjectValue class]]
+                    ? [(FSTObjectValue *)value valueForPath:field.tail]
+                    : nil;
+      }
+      fieldValues[check.field] = value;
+      fieldsResolved[check.field] = true;
+    }
+
+    FSTFieldValue *_Nullable value = fieldValues[check.field];
+    if (check.filter) {
+      if (![(id<FSTValueFilter>)check.filter matchesValue:value]) {
+        return false;
+      }
+    } else if (value == nil) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
 #pragma mark - FSTQuery
 
 @interface FSTQuery () {
   // Cached value of the canonicalID property.
   NSString *_canonicalID;
+  // Cached value of the fingerprint property, computed along with _canonicalID.
+  uint64_t _fingerprint;
+  // The filters and orderBy constraints compiled on first use by matchesDocument:.
+  std::unique_ptr<QueryMatcher> _matcher;
 }
 
 /**
@@ -512,11 +767,12 @@ NSString *FSTStringFromQueryRelationOperator(FSTRelationFilterOperator filterOpe
   if (![object isKindOfClass:[FSTQuery class]]) {
     return NO;
   }
-  return [self isEqualToQuery:(FSTQuery *)object];
+  FSTQuery *other = (FSTQuery *)object;
+  return self.fingerprint == other.fingerprint && [self isEqualToQuery:other];
 }
 
 - (NSUInteger)hash {
-  return [self.canonicalID hash];
+  return (NSUInteger)self.fingerprint;
 }
 
 - (instancetype)copyWithZone:(nullable NSZone *)zone {
@@ -638,8 +894,11 @@ NSString *FSTStringFromQueryRelationOperator(FSTRelationFilterOperator filterOpe
 }
 
 - (BOOL)matchesDocument:(FSTDocument *)document {
-  return [self pathMatchesDocument:document] && [self orderByMatchesDocument:document] &&
-         [self filtersMatchDocument:document] && [self boundsMatchDocument:document];
+  if (!_matcher) {
+    _matcher.reset(new QueryMatcher(self.filters, self.explicitSortOrders));
+  }
+  return [self pathMatchesDocument:document] && _matcher->Matches(document) &&
+         [self boundsMatchDocument:document];
 }
 
 - (NSComparator)comparator {
@@ -672,6 +931,28 @@ NSString *FSTStringFromQueryRelationOperator(FSTRelationFilterOperator filterOpe
   return self.explicitSortOrders.firstObject.field;
 }
 
+- (FSTDocumentKey *_Nullable)lowestKeyInBounds {
+  FSTSortOrder *sortOrder = self.sortOrders.firstObject;
+  return [self keyOfBound:(sortOrder.isAscending ? self.startAt : self.endAt)];
+}
+
+- (FSTDocumentKey *_Nullable)highestKeyInBounds {
+  FSTSortOrder *sortOrder = self.sortOrders.firstObject;
+  return [self keyOfBound:(sortOrder.isAscending ? self.endAt : self.startAt)];
+}
+
+/** Returns the key the given bound positions the results at, if they're ordered by key first. */
+- (FSTDocumentKey *_Nullable)keyOfBound:(FSTBound *_Nullable)bound {
+  if (!bound || ![self.sortOrders.firstObject.field isKeyFieldPath]) {
+    return nil;
+  }
+  FSTFieldValue *position = bound.position.firstObject;
+  if (![position isKindOfClass:[FSTReferenceValue class]]) {
+    return nil;
+  }
+  return ((FSTReferenceValue *)position).value;
+}
+
 #pragma mark - Private properties
 
 - (NSString *)canonicalID {
@@ -679,35 +960,47 @@ NSString *FSTStringFromQueryRelationOperator(FSTRelationFilterOperator filterOpe
     return _canonicalID;
   }
 
-  NSMutableString *canonicalID = [[self.path canonicalString] mutableCopy];
+  // Assemble the UTF-8 bytes once, rather than growing an NSMutableString piece by piece.
+  core::CanonicalIdBuilder builder;
+  builder.Append(util::MakeStringView([self.path canonicalString]));
 
   // Add filters.
-  [canonicalID appendString:@"|f:"];
+  builder.Append("|f:");
   for (id<FSTFilter> predicate in self.filters) {
-    [canonicalID appendFormat:@"%@", [predicate canonicalID]];
+    builder.Append(util::MakeStringView([predicate canonicalID]));
   }
 
   // Add order by.
-  [canonicalID appendString:@"|ob:"];
+  builder.Append("|ob:");
   for (FSTSortOrder *orderBy in self.sortOrders) {
-    [canonicalID appendString:orderBy.canonicalID];
+    builder.Append(util::MakeStringView(orderBy.canonicalID));
   }
 
   // Add limit.
   if (self.limit != NSNotFound) {
-    [canonicalID appendFormat:@"|l:%ld", (long)self.limit];
+    builder.Append("|l:").AppendInteger(self.limit);
   }
 
   if (self.startAt) {
-    [canonicalID appendFormat:@"|lb:%@", self.startAt.canonicalString];
+    builder.Append("|lb:").Append(util::MakeStringView(self.startAt.canonicalString));
   }
 
   if (self.endAt) {
-    [canonicalID appendFormat:@"|ub:%@", self.endAt.canonicalString];
+    builder.Append("|ub:").Append(util::MakeStringView(self.endAt.canonicalString));
   }
 
-  _canonicalID = canonicalID;
-  return canonicalID;
+  const std::string &canonicalID = builder.id();
+  _fingerprint = builder.Fingerprint();
+  _canonicalID = [[NSString alloc] initWithBytes:canonicalID.data()
+                                          length:canonicalID.size()
+                                        encoding:NSUTF8StringEncoding];
+  return _canonicalID;
+}
+
+- (uint64_t)fingerprint {
+  // The fingerprint is the CanonicalIdFingerprint of the canonicalID, computed alongside it.
+  [self canonicalID];
+  return _fingerprint;
 }
 
 #pragma mark - Private methods
@@ -721,7 +1014,11 @@ NSString *FSTStringFromQueryRelationOperator(FSTRelationFilterOperator filterOpe
 
 /* Returns YES if the document matches the path for the receiver. */
 - (BOOL)pathMatchesDocument:(FSTDocument *)document {
-  FSTResourcePath *documentPath = document.key.path;
+  return [self pathMatchesKey:document.key];
+}
+
+- (BOOL)pathMatchesKey:(FSTDocumentKey *)key {
+  FSTResourcePath *documentPath = key.path;
   if ([FSTDocumentKey isDocumentKey:self.path]) {
     // Exact match for document queries.
     return [self.path isEqual:documentPath];
@@ -731,31 +1028,6 @@ NSString *FSTStringFromQueryRelationOperator(FSTRelationFilterOperator filterOpe
   }
 }
 
-/**
- * A document must have a value for every ordering clause in order to show up in the results.
- */
-- (BOOL)orderByMatchesDocument:(FSTDocument *)document {
-  for (FSTSortOrder *orderBy in self.explicitSortOrders) {
-    FSTFieldPath *fieldPath = orderBy.field;
-    // order by key always matches
-    if (![fieldPath isEqual:[FSTFieldPath keyFieldPath]] &&
-        [document fieldForPath:fieldPath] == nil) {
-      return NO;
-    }
-  }
-  return YES;
-}
-
-/** Returns YES if the document matches all of the filters in the receiver. */
-- (BOOL)filtersMatchDocument:(FSTDocument *)document {
-  for (id<FSTFilter> filter in self.filters) {
-    if (![filter matchesDocument:document]) {
-      return NO;
-    }
-  }
-  return YES;
-}
-
 - (BOOL)boundsMatchDocument:(FSTDocument *)document {
   if (self.startAt && ![self.startAt sortsBeforeDocument:document usingSortOrder:self.sortOrders]) {
     return NO;
@@ -16,6 +16,8 @@
 
 #import <Foundation/Foundation.h>
 
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+
 NS_ASSUME_NONNULL_BEGIN
 
 @class FSTTimestamp;
@@ -38,6 +40,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property(nonatomic, strong, readonly) FSTTimestamp *timestamp;
 
+/** The C++ value of this version, which can be compared without sending any messages. */
+- (const firebase::firestore::model::SnapshotVersion &)value;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -18,9 +18,13 @@
 
 #import "Firestore/Source/Core/FSTTimestamp.h"
 
+namespace model = firebase::firestore::model;
+
 NS_ASSUME_NONNULL_BEGIN
 
-@implementation FSTSnapshotVersion
+@implementation FSTSnapshotVersion {
+  model::SnapshotVersion _value;
+}
 
 + (instancetype)noVersion {
   static FSTSnapshotVersion *min;
@@ -40,6 +44,7 @@ NS_ASSUME_NONNULL_BEGIN
   self = [super init];
   if (self) {
     _timestamp = timestamp;
+    _value = model::SnapshotVersion{model::Timestamp{timestamp.seconds, timestamp.nanos}};
   }
   return self;
 }
@@ -53,11 +58,12 @@ NS_ASSUME_NONNULL_BEGIN
   if (![object isKindOfClass:[FSTSnapshotVersion class]]) {
     return NO;
   }
-  return [self.timestamp isEqual:((FSTSnapshotVersion *)object).timestamp];
+  return _value == ((FSTSnapshotVersion *)object)->_value;
 }
 
 - (NSUInteger)hash {
-  return self.timestamp.hash;
+  const model::Timestamp &timestamp = _value.timestamp();
+  return (NSUInteger)((timestamp.seconds() >> 32) ^ timestamp.seconds() ^ timestamp.nanos());
 }
 
 - (NSString *)description {
@@ -71,8 +77,19 @@ NS_ASSUME_NONNULL_BEGIN
 
 #pragma mark - Public methods
 
+- (const model::SnapshotVersion &)value {
+  return _value;
+}
+
 - (NSComparisonResult)compare:(FSTSnapshotVersion *)other {
-  return [self.timestamp compare:other.timestamp];
+  const model::SnapshotVersion &otherValue = other->_value;
+  if (_value < otherValue) {
+    return NSOrderedAscending;
+  } else if (otherValue < _value) {
+    return NSOrderedDescending;
+  } else {
+    return NSOrderedSame;
+  }
 }
 
 @end
@@ -17,9 +17,13 @@
 #import <Foundation/Foundation.h>
 
 #import "Firestore/Source/Core/FSTTypes.h"
+#import "Firestore/Source/Model/FSTDocumentDictionary.h"
+#import "Firestore/Source/Model/FSTMemoryUsage.h"
 #import "Firestore/Source/Remote/FSTRemoteStore.h"
 
+@class FSTBundleReader;
 @class FSTDispatchQueue;
+@class FSTDocumentKey;
 @class FSTLocalStore;
 @class FSTMutation;
 @class FSTQuery;
@@ -30,6 +34,17 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/** A block called with the number of documents a prefetched query has received so far. */
+typedef void (^FSTPrefetchProgressBlock)(NSUInteger documentCount);
+
+/**
+ * A block called with the documents read by lookupDocumentsWithKeys:completion:, and whether they
+ * were read from the local store because the backend couldn't be reached.
+ */
+typedef void (^FSTDocumentLookupBlock)(FSTMaybeDocumentDictionary *_Nullable documents,
+                                       BOOL fromCache,
+                                       NSError *_Nullable error);
+
 #pragma mark - FSTSyncEngineDelegate
 
 /** A Delegate to be notified when the sync engine produces new view snapshots or errors. */
@@ -65,6 +80,38 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nonatomic, weak) id<FSTSyncEngineDelegate> delegate;
 
+/**
+ * The queue the sync engine runs on. If set, garbage is collected in short time slices scheduled on
+ * this queue once the client has been idle for a moment, rather than right after each change, so
+ * that collecting after releasing a large query doesn't hold up listener events. If nil, garbage
+ * is collected synchronously.
+ */
+@property(nonatomic, strong, nullable) FSTDispatchQueue *workerDispatchQueue;
+
+/**
+ * Whether writes may be folded into the previous write while it is still waiting to be sent, so
+ * that repeated updates to a document made offline are stored and sent as one. The completion
+ * blocks of squashed writes are called together once the combined write is acknowledged or
+ * rejected. Defaults to NO.
+ */
+@property(nonatomic, assign, getter=isWriteSquashingEnabled) BOOL writeSquashingEnabled;
+
+/**
+ * Whether listens to queries on the same collection share a single target that listens to the
+ * whole collection, with each query's view applying its filters, order and limit to the cached
+ * documents locally. This saves a target per query and the backend sending documents that match
+ * several of them once per query, at the cost of receiving the collection's documents that match
+ * none of them. Document queries always get their own target. Defaults to NO.
+ */
+@property(nonatomic, assign, getter=isTargetMultiplexingEnabled) BOOL targetMultiplexingEnabled;
+
+/**
+ * The maximum number of listens that resolve documents in limbo at once. Documents that enter
+ * limbo while this many are active wait their turn, so that reconnecting with many documents in
+ * limbo doesn't start a target for each of them at the same time. Defaults to 100.
+ */
+@property(nonatomic, assign) NSUInteger maxConcurrentLimboResolutions;
+
 /**
  * Initiates a new listen. The FSTLocalStore will be queried for initial data and the listen will
  * be sent to the FSTRemoteStore to get remote data. The registered FSTSyncEngineDelegate will be
@@ -77,6 +124,34 @@ NS_ASSUME_NONNULL_BEGIN
 /** Stops listening to a query previously listened to via listenToQuery:. */
 - (void)stopListeningToQuery:(FSTQuery *)query;
 
+/**
+ * Fetches the results of a query into the local store without computing a view of them, and keeps
+ * them from being garbage collected until the expiry date. The query's target is listened to via
+ * the FSTRemoteStore until it becomes current, and then released unless the query is also being
+ * listened to. A query that is listened to shares its target with the prefetch.
+ *
+ * @param query The query to prefetch.
+ * @param expiryDate The date until which the results are kept in the local store.
+ * @param progress A block called after each remote event that changes the target, with the number
+ *     of documents the target has received.
+ * @param completion A block called once the target is current, or with an error if the backend
+ *     rejects it.
+ */
+- (void)prefetchQuery:(FSTQuery *)query
+           expiryDate:(NSDate *)expiryDate
+             progress:(nullable FSTPrefetchProgressBlock)progress
+           completion:(FSTVoidErrorBlock)completion;
+
+/**
+ * Reads the current values of the documents with the given keys. The local store is read once for
+ * all of them, and those that a current view keeps in sync with the backend are served from it.
+ * The rest are read from the backend with a single lookup and have the pending writes applied. If
+ * the backend is unavailable, all documents are served from the local store and fromCache is set.
+ * Documents that don't exist are returned as FSTDeletedDocuments.
+ */
+- (void)lookupDocumentsWithKeys:(NSArray<FSTDocumentKey *> *)keys
+                     completion:(FSTDocumentLookupBlock)completion;
+
 /**
  * Initiates the write of local mutation batch which involves adding the writes to the mutation
  * queue, notifying the remote store about new mutations, and raising events for any changes this
@@ -100,9 +175,27 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)userDidChange:(FSTUser *)user;
 
+/**
+ * Loads a bundle into the local store and raises events for the documents it changed.
+ *
+ * @return NO if the bundle is malformed, in which case only its elements before the malformed one
+ *     have been loaded.
+ */
+- (BOOL)loadBundle:(FSTBundleReader *)bundle error:(NSError **)error;
+
 /** Applies an FSTOnlineState change to the sync engine and notifies any views of the change. */
 - (void)applyChangedOnlineState:(FSTOnlineState)onlineState;
 
+/**
+ * Calls the block with the documents in the view of each query being listened to and the
+ * approximate bytes they take up. Views share their documents with the local store's caches, so
+ * the same documents may be counted there too. This visits every document in every view.
+ */
+- (void)enumerateViewMemoryUsageUsingBlock:(void (^)(FSTQuery *query, FSTMemoryUsage usage))block;
+
+/** Returns the references that keep documents in limbo from being garbage collected. */
+- (FSTMemoryUsage)limboReferenceMemoryUsage;
+
 @end
 
 NS_ASSUME_NONNULL_END
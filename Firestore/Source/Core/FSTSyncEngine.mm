@@ -16,6 +16,8 @@
 
 #import "Firestore/Source/Core/FSTSyncEngine.h"
 
+#include <unordered_map>
+
 #import <GRPCClient/GRPCCall.h>
 
 #import "FIRFirestoreErrors.h"
@@ -35,12 +37,17 @@
 #import "Firestore/Source/Model/FSTDocumentKey.h"
 #import "Firestore/Source/Model/FSTDocumentSet.h"
 #import "Firestore/Source/Model/FSTMutationBatch.h"
+#import "Firestore/Source/Remote/FSTExponentialBackoff.h"
 #import "Firestore/Source/Remote/FSTRemoteEvent.h"
 #import "Firestore/Source/Util/FSTAssert.h"
+#import "Firestore/Source/Util/FSTClasses.h"
 #import "Firestore/Source/Util/FSTDispatchQueue.h"
 #import "Firestore/Source/Util/FSTLogger.h"
 
 #include "Firestore/core/src/firebase/firestore/core/target_id_generator.h"
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
+
+namespace util = firebase::firestore::util;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -48,6 +55,23 @@ NS_ASSUME_NONNULL_BEGIN
 // real sequence numbers.
 static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 
+/** How long the sync engine must be idle, in seconds, before garbage collection starts. */
+static const NSTimeInterval kGarbageCollectionIdleDelay = 1.0;
+
+/** The time, in seconds, that each slice of garbage collection runs before yielding the queue. */
+static const NSTimeInterval kGarbageCollectionSliceTime = 0.005;
+
+/**
+ * Failed transactions are retried after a growing delay with jitter, so that clients contending
+ * for the same documents don't keep colliding. The first retry runs right away.
+ */
+static const NSTimeInterval kTransactionRetryInitialDelay = 0.1;
+static const NSTimeInterval kTransactionRetryMaxDelay = 5.0;
+static const double kTransactionRetryBackoffFactor = 1.5;
+
+/** The default for maxConcurrentLimboResolutions. */
+static const NSUInteger kDefaultMaxConcurrentLimboResolutions = 100;
+
 #pragma mark - FSTQueryView
 
 /**
@@ -57,7 +81,9 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 @interface FSTQueryView : NSObject
 
 - (instancetype)initWithQuery:(FSTQuery *)query
+                  targetQuery:(FSTQuery *)targetQuery
                      targetID:(FSTTargetID)targetID
+                  referenceID:(FSTTargetID)referenceID
                   resumeToken:(NSData *)resumeToken
                          view:(FSTView *)view NS_DESIGNATED_INITIALIZER;
 
@@ -66,9 +92,21 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 /** The query itself. */
 @property(nonatomic, strong, readonly) FSTQuery *query;
 
-/** The targetID created by the client that is used in the watch stream to identify this query. */
+/**
+ * The query the view's target listens to. This is the query itself unless the view is served from
+ * a target shared with other queries on the same collection.
+ */
+@property(nonatomic, strong, readonly) FSTQuery *targetQuery;
+
+/** The targetID created by the client that is used in the watch stream to identify targetQuery. */
 @property(nonatomic, assign, readonly) FSTTargetID targetID;
 
+/**
+ * The ID the view's limbo documents are referenced by in the sync engine's limboDocumentRefs. This
+ * is the targetID unless another view already listens to the same target.
+ */
+@property(nonatomic, assign, readonly) FSTTargetID referenceID;
+
 /**
  * An identifier from the datastore backend that indicates the last state of the results that
  * was received. This can be used to indicate where to continue receiving new doc changes for the
@@ -88,12 +126,16 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 @implementation FSTQueryView
 
 - (instancetype)initWithQuery:(FSTQuery *)query
+                  targetQuery:(FSTQuery *)targetQuery
                      targetID:(FSTTargetID)targetID
+                  referenceID:(FSTTargetID)referenceID
                   resumeToken:(NSData *)resumeToken
                          view:(FSTView *)view {
   if (self = [super init]) {
     _query = query;
+    _targetQuery = targetQuery;
     _targetID = targetID;
+    _referenceID = referenceID;
     _resumeToken = resumeToken;
     _view = view;
   }
@@ -102,6 +144,54 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 
 @end
 
+#pragma mark - FSTQueryPrefetch
+
+/**
+ * FSTQueryPrefetch tracks a query whose results are being fetched into the local store without a
+ * view, until its target becomes current.
+ */
+@interface FSTQueryPrefetch : NSObject
+
+- (instancetype)initWithQuery:(FSTQuery *)query
+                     targetID:(FSTTargetID)targetID
+                  resumeToken:(NSData *)resumeToken NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/** The query being prefetched. */
+@property(nonatomic, strong, readonly) FSTQuery *query;
+
+/** The targetID of the listen receiving the query's results. */
+@property(nonatomic, assign, readonly) FSTTargetID targetID;
+
+/** The resume token the target was listened to with, used if a listener takes over the target. */
+@property(nonatomic, copy, readonly) NSData *resumeToken;
+
+/** The progress blocks of every prefetch of the query waiting for the target. */
+@property(nonatomic, strong, readonly) NSMutableArray<FSTPrefetchProgressBlock> *progressBlocks;
+
+/** The completion blocks of every prefetch of the query waiting for the target. */
+@property(nonatomic, strong, readonly) NSMutableArray<FSTVoidErrorBlock> *completionBlocks;
+
+@end
+
+@implementation FSTQueryPrefetch
+
+- (instancetype)initWithQuery:(FSTQuery *)query
+                     targetID:(FSTTargetID)targetID
+                  resumeToken:(NSData *)resumeToken {
+  if (self = [super init]) {
+    _query = query;
+    _targetID = targetID;
+    _resumeToken = resumeToken;
+    _progressBlocks = [NSMutableArray array];
+    _completionBlocks = [NSMutableArray array];
+  }
+  return self;
+}
+
+@end
+
 #pragma mark - FSTSyncEngine
 
 @interface FSTSyncEngine ()
@@ -116,9 +206,27 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 @property(nonatomic, strong, readonly)
     NSMutableDictionary<FSTQuery *, FSTQueryView *> *queryViewsByQuery;
 
-/** FSTQueryViews for all active queries, indexed by target ID. */
+/**
+ * FSTQueryViews for all active queries, indexed by the ID of the target they listen to. Views only
+ * share a target when target multiplexing is enabled.
+ */
+@property(nonatomic, strong, readonly)
+    NSMutableDictionary<NSNumber *, NSMutableArray<FSTQueryView *> *> *queryViewsByTarget;
+
+/** The IDs of the targets listened to for FSTQueryViews, indexed by the query each listens to. */
+@property(nonatomic, strong, readonly)
+    NSMutableDictionary<FSTQuery *, FSTBoxedTargetID *> *targetIDsByQuery;
+
+/** FSTQueryPrefetches for all queries being prefetched, indexed by query. */
+@property(nonatomic, strong, readonly)
+    NSMutableDictionary<FSTQuery *, FSTQueryPrefetch *> *prefetchesByQuery;
+
+/**
+ * FSTQueryPrefetches for all queries being prefetched, indexed by target ID. A prefetch shares
+ * its target with the query's view while the query is also listened to.
+ */
 @property(nonatomic, strong, readonly)
-    NSMutableDictionary<NSNumber *, FSTQueryView *> *queryViewsByTarget;
+    NSMutableDictionary<NSNumber *, FSTQueryPrefetch *> *prefetchesByTarget;
 
 /**
  * When a document is in limbo, we create a special listen to resolve it. This maps the
@@ -127,9 +235,12 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 @property(nonatomic, strong, readonly)
     NSMutableDictionary<FSTDocumentKey *, FSTBoxedTargetID *> *limboTargetsByKey;
 
-/** The inverse of limboTargetsByKey, a map of FSTTargetID to the key of the limbo doc. */
+/**
+ * The keys of documents in limbo whose resolution hasn't started yet because
+ * maxConcurrentLimboResolutions listens are already active, in the order they entered limbo.
+ */
 @property(nonatomic, strong, readonly)
-    NSMutableDictionary<FSTBoxedTargetID *, FSTDocumentKey *> *limboKeysByTarget;
+    NSMutableOrderedSet<FSTDocumentKey *> *enqueuedLimboResolutions;
 
 /** Used to track any documents that are currently in limbo. */
 @property(nonatomic, strong, readonly) FSTReferenceSet *limboDocumentRefs;
@@ -144,11 +255,23 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 
 @property(nonatomic, strong) FSTUser *currentUser;
 
+/** The batchID of the last write made by the current user, or kFSTBatchIDUnknown if none. */
+@property(nonatomic, assign) FSTBatchID lastWriteBatchID;
+
+/** Whether a garbage collection slice is scheduled on the workerDispatchQueue. */
+@property(nonatomic, assign, getter=isGarbageCollectionScheduled) BOOL garbageCollectionScheduled;
+
+/** When garbage collection was last requested, which postpones it until the client is idle. */
+@property(nonatomic, assign) CFAbsoluteTime lastGarbageCollectionRequest;
+
 @end
 
 @implementation FSTSyncEngine {
   /** Used for creating the FSTTargetIDs for the listens used to resolve limbo documents. */
   firebase::firestore::core::TargetIdGenerator _targetIdGenerator;
+
+  /** The inverse of limboTargetsByKey, a map of FSTTargetID to the key of the limbo doc. */
+  std::unordered_map<FSTTargetID, FSTDocumentKey *> _limboKeysByTarget;
 }
 
 - (instancetype)initWithLocalStore:(FSTLocalStore *)localStore
@@ -160,9 +283,13 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 
     _queryViewsByQuery = [NSMutableDictionary dictionary];
     _queryViewsByTarget = [NSMutableDictionary dictionary];
+    _targetIDsByQuery = [NSMutableDictionary dictionary];
+    _prefetchesByQuery = [NSMutableDictionary dictionary];
+    _prefetchesByTarget = [NSMutableDictionary dictionary];
 
     _limboTargetsByKey = [NSMutableDictionary dictionary];
-    _limboKeysByTarget = [NSMutableDictionary dictionary];
+    _enqueuedLimboResolutions = [NSMutableOrderedSet orderedSet];
+    _maxConcurrentLimboResolutions = kDefaultMaxConcurrentLimboResolutions;
     _limboCollector = [[FSTEagerGarbageCollector alloc] init];
     _limboDocumentRefs = [[FSTReferenceSet alloc] init];
     [_limboCollector addGarbageSource:_limboDocumentRefs];
@@ -171,6 +298,7 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
     _targetIdGenerator =
         firebase::firestore::core::TargetIdGenerator::SyncEngineTargetIdGenerator(0);
     _currentUser = initialUser;
+    _lastWriteBatchID = kFSTBatchIDUnknown;
   }
   return self;
 }
@@ -179,26 +307,69 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
   [self assertDelegateExistsForSelector:_cmd];
   FSTAssert(self.queryViewsByQuery[query] == nil, @"We already listen to query: %@", query);
 
-  FSTQueryData *queryData = [self.localStore allocateQuery:query];
+  // A target that other views or a prefetch already listen to is shared with them, and otherwise
+  // a new one is allocated.
+  FSTQuery *targetQuery = [self targetQueryForQuery:query];
+  FSTBoxedTargetID *sharedTargetID = self.targetIDsByQuery[targetQuery];
+  FSTQueryView *sharingView =
+      sharedTargetID ? self.queryViewsByTarget[sharedTargetID].firstObject : nil;
+  FSTQueryPrefetch *prefetch = self.prefetchesByQuery[targetQuery];
+  FSTQueryData *queryData;
+  FSTTargetID targetID;
+  FSTTargetID referenceID;
+  NSData *resumeToken;
+  if (sharingView) {
+    targetID = sharingView.targetID;
+    referenceID = _targetIdGenerator.NextId();
+    resumeToken = sharingView.resumeToken;
+  } else if (prefetch) {
+    targetID = referenceID = prefetch.targetID;
+    resumeToken = prefetch.resumeToken;
+  } else {
+    queryData = [self.localStore allocateQuery:targetQuery];
+    util::Trace(util::kTraceListen, queryData.targetID);
+    targetID = referenceID = queryData.targetID;
+    resumeToken = queryData.resumeToken;
+  }
   FSTDocumentDictionary *docs = [self.localStore executeQuery:query];
-  FSTDocumentKeySet *remoteKeys = [self.localStore remoteDocumentKeysForTarget:queryData.targetID];
+  FSTDocumentKeySet *remoteKeys = [self.localStore remoteDocumentKeysForTarget:targetID];
 
   FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:remoteKeys];
   FSTViewDocumentChanges *viewDocChanges = [view computeChangesWithDocuments:docs];
-  FSTViewChange *viewChange = [view applyChangesToDocuments:viewDocChanges];
-  FSTAssert(viewChange.limboChanges.count == 0,
+  // The backend won't mark a shared target current again, so the view starts out current if the
+  // views already sharing the target are.
+  FSTTargetChange *_Nullable targetChange = nil;
+  if (sharingView.view.isCurrent) {
+    targetChange = [FSTTargetChange changeWithDocuments:@[]
+                                    currentStatusUpdate:FSTCurrentStatusUpdateMarkCurrent];
+  }
+  FSTViewChange *viewChange =
+      [view applyChangesToDocuments:viewDocChanges targetChange:targetChange];
+  FSTAssert(targetChange || viewChange.limboChanges.count == 0,
             @"View returned limbo docs before target ack from the server.");
 
   FSTQueryView *queryView = [[FSTQueryView alloc] initWithQuery:query
-                                                       targetID:queryData.targetID
-                                                    resumeToken:queryData.resumeToken
+                                                    targetQuery:targetQuery
+                                                       targetID:targetID
+                                                    referenceID:referenceID
+                                                    resumeToken:resumeToken
                                                            view:view];
   self.queryViewsByQuery[query] = queryView;
-  self.queryViewsByTarget[@(queryData.targetID)] = queryView;
+  if (sharingView) {
+    [self.queryViewsByTarget[@(targetID)] addObject:queryView];
+  } else {
+    self.queryViewsByTarget[@(targetID)] = [NSMutableArray arrayWithObject:queryView];
+    self.targetIDsByQuery[targetQuery] = @(targetID);
+  }
+  if (viewChange.limboChanges.count > 0) {
+    [self updateTrackedLimboDocumentsWithChanges:viewChange.limboChanges referenceID:referenceID];
+  }
   [self.delegate handleViewSnapshots:@[ viewChange.snapshot ]];
 
-  [self.remoteStore listenToTargetWithQueryData:queryData];
-  return queryData.targetID;
+  if (queryData) {
+    [self.remoteStore listenToTargetWithQueryData:queryData];
+  }
+  return targetID;
 }
 
 - (void)stopListeningToQuery:(FSTQuery *)query {
@@ -207,17 +378,196 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
   FSTQueryView *queryView = self.queryViewsByQuery[query];
   FSTAssert(queryView, @"Trying to stop listening to a query not found");
 
-  [self.localStore releaseQuery:query];
-  [self.remoteStore stopListeningToTargetID:queryView.targetID];
   [self removeAndCleanupQuery:queryView];
-  [self.localStore collectGarbage];
+  if (self.queryViewsByTarget[@(queryView.targetID)]) {
+    // Other views still listen to the target.
+    return;
+  }
+  [self.targetIDsByQuery removeObjectForKey:queryView.targetQuery];
+
+  if (self.prefetchesByTarget[@(queryView.targetID)]) {
+    // Leave the target to the prefetch, which stops it once it's current.
+    return;
+  }
+
+  util::Trace(util::kTraceUnlisten, queryView.targetID);
+
+  [self.localStore releaseQuery:queryView.targetQuery];
+  [self.remoteStore stopListeningToTargetID:queryView.targetID];
+  [self scheduleGarbageCollection];
+}
+
+/**
+ * Returns the query whose target serves the given query. With target multiplexing enabled, all
+ * queries on a collection are served by a shared target listening to the whole collection, and
+ * their views apply their filters, order and limit to the cached documents locally.
+ */
+- (FSTQuery *)targetQueryForQuery:(FSTQuery *)query {
+  if (!self.targetMultiplexingEnabled || [query isDocumentQuery]) {
+    return query;
+  }
+  return [FSTQuery queryWithPath:query.path];
+}
+
+- (void)prefetchQuery:(FSTQuery *)query
+           expiryDate:(NSDate *)expiryDate
+             progress:(nullable FSTPrefetchProgressBlock)progress
+           completion:(FSTVoidErrorBlock)completion {
+  FSTQueryPrefetch *prefetch = self.prefetchesByQuery[query];
+  if (!prefetch) {
+    FSTBoxedTargetID *targetID = self.targetIDsByQuery[query];
+    FSTQueryView *queryView = targetID ? self.queryViewsByTarget[targetID].firstObject : nil;
+    if (queryView) {
+      [self.localStore pinQuery:query untilDate:expiryDate];
+      if (queryView.view.isCurrent) {
+        completion(nil);
+        return;
+      }
+      prefetch = [[FSTQueryPrefetch alloc] initWithQuery:query
+                                                targetID:queryView.targetID
+                                             resumeToken:queryView.resumeToken];
+    } else {
+      FSTQueryData *queryData = [self.localStore allocateQuery:query];
+      util::Trace(util::kTraceListen, queryData.targetID);
+      [self.localStore pinQuery:query untilDate:expiryDate];
+      [self.remoteStore listenToTargetWithQueryData:queryData];
+      prefetch = [[FSTQueryPrefetch alloc] initWithQuery:query
+                                                targetID:queryData.targetID
+                                             resumeToken:queryData.resumeToken];
+    }
+    self.prefetchesByQuery[query] = prefetch;
+    self.prefetchesByTarget[@(prefetch.targetID)] = prefetch;
+  } else {
+    [self.localStore pinQuery:query untilDate:expiryDate];
+  }
+
+  if (progress) {
+    [prefetch.progressBlocks addObject:progress];
+  }
+  [prefetch.completionBlocks addObject:completion];
+}
+
+/**
+ * Reports the progress of the prefetches whose targets the remote event changed, and completes
+ * those whose targets became current.
+ */
+- (void)updatePrefetchesWithRemoteEvent:(FSTRemoteEvent *)remoteEvent {
+  if (self.prefetchesByTarget.count == 0) {
+    return;
+  }
+
+  [remoteEvent.targetChanges enumerateKeysAndObjectsUsingBlock:^(
+                                 FSTBoxedTargetID *_Nonnull targetID,
+                                 FSTTargetChange *_Nonnull targetChange, BOOL *_Nonnull stop) {
+    FSTQueryPrefetch *prefetch = self.prefetchesByTarget[targetID];
+    if (!prefetch) {
+      return;
+    }
+
+    if (prefetch.progressBlocks.count > 0) {
+      NSUInteger count = [self.localStore remoteDocumentKeysForTarget:prefetch.targetID].count;
+      for (FSTPrefetchProgressBlock progress in prefetch.progressBlocks) {
+        progress(count);
+      }
+    }
+    if (targetChange.currentStatusUpdate == FSTCurrentStatusUpdateMarkCurrent) {
+      [self finishPrefetch:prefetch error:nil];
+    }
+  }];
+}
+
+/**
+ * Stops tracking the prefetch and calls its completion blocks. Unless the query is also listened
+ * to, its target is released, which leaves the results in the local store pinned until they
+ * expire.
+ */
+- (void)finishPrefetch:(FSTQueryPrefetch *)prefetch error:(nullable NSError *)error {
+  [self.prefetchesByQuery removeObjectForKey:prefetch.query];
+  [self.prefetchesByTarget removeObjectForKey:@(prefetch.targetID)];
+
+  if (!self.queryViewsByTarget[@(prefetch.targetID)]) {
+    util::Trace(util::kTraceUnlisten, prefetch.targetID);
+    [self.localStore releaseQuery:prefetch.query];
+    // The remote store has already removed a target the backend rejected.
+    if (!error) {
+      [self.remoteStore stopListeningToTargetID:prefetch.targetID];
+    }
+    [self scheduleGarbageCollection];
+  }
+
+  for (FSTVoidErrorBlock completion in prefetch.completionBlocks) {
+    completion(error);
+  }
+}
+
+- (void)lookupDocumentsWithKeys:(NSArray<FSTDocumentKey *> *)keys
+                     completion:(FSTDocumentLookupBlock)completion {
+  FSTDocumentKeySet *keySet = [FSTDocumentKeySet keySetWithKeys:[NSSet setWithArray:keys]];
+  FSTMaybeDocumentDictionary *localDocs = [self.localStore readDocuments:keySet];
+
+  NSMutableArray<FSTDocumentKey *> *unsyncedKeys = [NSMutableArray array];
+  [keySet enumerateObjectsUsingBlock:^(FSTDocumentKey *key, BOOL *stop) {
+    if (![self isDocumentKeySynced:key]) {
+      [unsyncedKeys addObject:key];
+    }
+  }];
+  if (unsyncedKeys.count == 0) {
+    completion(localDocs, NO, nil);
+    return;
+  }
+
+  [self.remoteStore
+      lookupDocuments:unsyncedKeys
+           completion:^(NSArray<FSTMaybeDocument *> *_Nullable remoteDocs,
+                        NSError *_Nullable error) {
+             if (error) {
+               if (error.code == FIRFirestoreErrorCodeUnavailable) {
+                 completion(localDocs, YES, nil);
+               } else {
+                 completion(nil, NO, error);
+               }
+               return;
+             }
+
+             // Pending writes may have changed while the lookup was in flight, so they're applied
+             // now rather than taken from localDocs.
+             __block FSTMaybeDocumentDictionary *result = localDocs;
+             [[self.localStore localDocumentsForRemoteDocuments:remoteDocs]
+                 enumerateKeysAndObjectsUsingBlock:^(FSTDocumentKey *key, FSTMaybeDocument *doc,
+                                                     BOOL *stop) {
+                   result = [result dictionaryBySettingObject:doc forKey:key];
+                 }];
+             completion(result, NO, nil);
+           }];
+}
+
+/** Returns YES if a current view keeps the local store's copy of the document up to date. */
+- (BOOL)isDocumentKeySynced:(FSTDocumentKey *)key {
+  __block BOOL synced = NO;
+  [self.queryViewsByQuery
+      enumerateKeysAndObjectsUsingBlock:^(FSTQuery *query, FSTQueryView *queryView, BOOL *stop) {
+        if ([queryView.view isDocumentKeySynced:key]) {
+          synced = YES;
+          *stop = YES;
+        }
+      }];
+  return synced;
 }
 
 - (void)writeMutations:(NSArray<FSTMutation *> *)mutations
             completion:(FSTVoidErrorBlock)completion {
   [self assertDelegateExistsForSelector:_cmd];
 
-  FSTLocalWriteResult *result = [self.localStore locallyWriteMutations:mutations];
+  FSTLocalWriteResult *result = nil;
+  FSTBatchID lastWriteBatchID = self.lastWriteBatchID;
+  if (self.writeSquashingEnabled && lastWriteBatchID != kFSTBatchIDUnknown &&
+      lastWriteBatchID > self.remoteStore.highestBatchIDSeen) {
+    result = [self.localStore locallySquashMutations:mutations intoBatchID:lastWriteBatchID];
+  }
+  if (!result) {
+    result = [self.localStore locallyWriteMutations:mutations];
+  }
+  self.lastWriteBatchID = result.batchID;
   [self addMutationCompletionBlock:completion batchID:result.batchID];
 
   [self emitNewSnapshotsWithChanges:result.changes remoteEvent:nil];
@@ -231,6 +581,16 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
     completionBlocks = [NSMutableDictionary dictionary];
     self.mutationCompletionBlocks[self.currentUser] = completionBlocks;
   }
+
+  // A squashed write shares its batch with earlier writes, so all of their blocks are called.
+  FSTVoidErrorBlock existing = completionBlocks[@(batchID)];
+  if (existing) {
+    FSTVoidErrorBlock added = completion;
+    completion = ^(NSError *_Nullable error) {
+      existing(error);
+      added(error);
+    };
+  }
   [completionBlocks setObject:completion forKey:@(batchID)];
 }
 
@@ -250,6 +610,23 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
            workerDispatchQueue:(FSTDispatchQueue *)workerDispatchQueue
                    updateBlock:(FSTTransactionBlock)updateBlock
                     completion:(FSTVoidIDErrorBlock)completion {
+  FSTExponentialBackoff *backoff =
+      [FSTExponentialBackoff exponentialBackoffWithDispatchQueue:workerDispatchQueue
+                                                    initialDelay:kTransactionRetryInitialDelay
+                                                   backoffFactor:kTransactionRetryBackoffFactor
+                                                        maxDelay:kTransactionRetryMaxDelay];
+  [self transactionWithRetries:retries
+           workerDispatchQueue:workerDispatchQueue
+                       backoff:backoff
+                   updateBlock:updateBlock
+                    completion:completion];
+}
+
+- (void)transactionWithRetries:(int)retries
+           workerDispatchQueue:(FSTDispatchQueue *)workerDispatchQueue
+                       backoff:(FSTExponentialBackoff *)backoff
+                   updateBlock:(FSTTransactionBlock)updateBlock
+                    completion:(FSTVoidIDErrorBlock)completion {
   [workerDispatchQueue verifyIsCurrentQueue];
   FSTAssert(retries >= 0, @"Got negative number of retries for transaction");
   FSTTransaction *transaction = [self.remoteStore transaction];
@@ -277,10 +654,13 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
           return;
         }
         [workerDispatchQueue verifyIsCurrentQueue];
-        return [self transactionWithRetries:(retries - 1)
-                        workerDispatchQueue:workerDispatchQueue
-                                updateBlock:updateBlock
-                                 completion:completion];
+        [backoff backoffAndRunBlock:^{
+          [self transactionWithRetries:(retries - 1)
+                   workerDispatchQueue:workerDispatchQueue
+                               backoff:backoff
+                           updateBlock:updateBlock
+                            completion:completion];
+        }];
       }];
     }];
   });
@@ -293,7 +673,8 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
   [remoteEvent.targetChanges enumerateKeysAndObjectsUsingBlock:^(
                                  FSTBoxedTargetID *_Nonnull targetID,
                                  FSTTargetChange *_Nonnull targetChange, BOOL *_Nonnull stop) {
-    FSTDocumentKey *limboKey = self.limboKeysByTarget[targetID];
+    auto found = _limboKeysByTarget.find(targetID.intValue);
+    FSTDocumentKey *limboKey = found != _limboKeysByTarget.end() ? found->second : nil;
     if (limboKey && targetChange.currentStatusUpdate == FSTCurrentStatusUpdateMarkCurrent &&
         remoteEvent.documentUpdates[limboKey] == nil) {
       // When listening to a query the server responds with a snapshot containing documents
@@ -302,7 +683,7 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
       // query, there will be no documents sent in the response if the document doesn't exist.
       //
       // If the snapshot arrives separately from the current marker, we handle it normally and
-      // updateTrackedLimboDocumentsWithChanges:targetID: will resolve the limbo status of the
+      // updateTrackedLimboDocumentsWithChanges:referenceID: will resolve the limbo status of the
       // document, removing it from limboDocumentRefs. This works because clients only initiate
       // limbo resolution when a target is current and because all current targets are always at a
       // consistent snapshot.
@@ -322,6 +703,7 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 
   FSTMaybeDocumentDictionary *changes = [self.localStore applyRemoteEvent:remoteEvent];
   [self emitNewSnapshotsWithChanges:changes remoteEvent:remoteEvent];
+  [self updatePrefetchesWithRemoteEvent:remoteEvent];
 }
 
 - (void)applyChangedOnlineState:(FSTOnlineState)onlineState {
@@ -342,12 +724,14 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 - (void)rejectListenWithTargetID:(FSTBoxedTargetID *)targetID error:(NSError *)error {
   [self assertDelegateExistsForSelector:_cmd];
 
-  FSTDocumentKey *limboKey = self.limboKeysByTarget[targetID];
-  if (limboKey) {
+  auto found = _limboKeysByTarget.find(targetID.intValue);
+  if (found != _limboKeysByTarget.end()) {
+    FSTDocumentKey *limboKey = found->second;
     // Since this query failed, we won't want to manually unlisten to it.
     // So go ahead and remove it from bookkeeping.
     [self.limboTargetsByKey removeObjectForKey:limboKey];
-    [self.limboKeysByTarget removeObjectForKey:targetID];
+    _limboKeysByTarget.erase(found);
+    [self pumpEnqueuedLimboResolutions];
 
     // TODO(dimond): Retry on transient errors?
 
@@ -365,23 +749,36 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
                                                      documentUpdates:docUpdate];
     [self applyRemoteEvent:event];
   } else {
-    FSTQueryView *queryView = self.queryViewsByTarget[targetID];
-    FSTAssert(queryView, @"Unknown targetId: %@", targetID);
-    [self.localStore releaseQuery:queryView.query];
-    [self removeAndCleanupQuery:queryView];
-    [self.delegate handleError:error forQuery:queryView.query];
+    FSTQueryPrefetch *prefetch = self.prefetchesByTarget[targetID];
+    NSArray<FSTQueryView *> *queryViews = [self.queryViewsByTarget[targetID] copy];
+    FSTAssert(prefetch || queryViews, @"Unknown targetId: %@", targetID);
+    if (prefetch) {
+      [self finishPrefetch:prefetch error:error];
+    }
+    if (queryViews) {
+      FSTQuery *targetQuery = queryViews.firstObject.targetQuery;
+      [self.localStore releaseQuery:targetQuery];
+      [self.targetIDsByQuery removeObjectForKey:targetQuery];
+      for (FSTQueryView *queryView in queryViews) {
+        [self removeAndCleanupQuery:queryView];
+        [self.delegate handleError:error forQuery:queryView.query];
+      }
+    }
   }
 }
 
-- (void)applySuccessfulWriteWithResult:(FSTMutationBatchResult *)batchResult {
+- (void)applySuccessfulWritesWithResults:(NSArray<FSTMutationBatchResult *> *)batchResults {
   [self assertDelegateExistsForSelector:_cmd];
 
-  // The local store may or may not be able to apply the write result and raise events immediately
+  // The local store may or may not be able to apply the write results and raise events immediately
   // (depending on whether the watcher is caught up), so we raise user callbacks first so that they
   // consistently happen before listen events.
-  [self processUserCallbacksForBatchID:batchResult.batch.batchID error:nil];
+  for (FSTMutationBatchResult *batchResult in batchResults) {
+    [self processUserCallbacksForBatchID:batchResult.batch.batchID error:nil];
+  }
 
-  FSTMaybeDocumentDictionary *changes = [self.localStore acknowledgeBatchWithResult:batchResult];
+  FSTMaybeDocumentDictionary *changes =
+      [self.localStore acknowledgeBatchesWithResults:batchResults];
   [self emitNewSnapshotsWithChanges:changes remoteEvent:nil];
 }
 
@@ -397,6 +794,38 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
   [self emitNewSnapshotsWithChanges:changes remoteEvent:nil];
 }
 
+- (BOOL)loadBundle:(FSTBundleReader *)bundle error:(NSError **)error {
+  [self assertDelegateExistsForSelector:_cmd];
+
+  NSError *loadError;
+  FSTMaybeDocumentDictionary *changes = [self.localStore loadBundle:bundle error:&loadError];
+  [self emitNewSnapshotsWithChanges:changes remoteEvent:nil];
+  if (loadError) {
+    if (error) {
+      *error = loadError;
+    }
+    return NO;
+  }
+  return YES;
+}
+
+- (void)enumerateViewMemoryUsageUsingBlock:
+    (void (^)(FSTQuery *query, FSTMemoryUsage usage))block {
+  [self.queryViewsByQuery
+      enumerateKeysAndObjectsUsingBlock:^(FSTQuery *query, FSTQueryView *queryView, BOOL *stop) {
+        FSTDocumentSet *documents = queryView.view.documentSet;
+        FSTMemoryUsage usage{static_cast<int64_t>(documents.count), 0};
+        for (FSTDocument *document in documents.documentEnumerator) {
+          usage.bytes += FSTApproximateDocumentBytes(document);
+        }
+        block(query, usage);
+      }];
+}
+
+- (FSTMemoryUsage)limboReferenceMemoryUsage {
+  return [self.limboDocumentRefs memoryUsage];
+}
+
 - (void)processUserCallbacksForBatchID:(FSTBatchID)batchID error:(NSError *_Nullable)error {
   NSMutableDictionary<NSNumber *, FSTVoidErrorBlock> *completionBlocks =
       self.mutationCompletionBlocks[self.currentUser];
@@ -420,9 +849,13 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 
 - (void)removeAndCleanupQuery:(FSTQueryView *)queryView {
   [self.queryViewsByQuery removeObjectForKey:queryView.query];
-  [self.queryViewsByTarget removeObjectForKey:@(queryView.targetID)];
+  NSMutableArray<FSTQueryView *> *sharingViews = self.queryViewsByTarget[@(queryView.targetID)];
+  [sharingViews removeObjectIdenticalTo:queryView];
+  if (sharingViews.count == 0) {
+    [self.queryViewsByTarget removeObjectForKey:@(queryView.targetID)];
+  }
 
-  [self.limboDocumentRefs removeReferencesForID:queryView.targetID];
+  [self.limboDocumentRefs removeReferencesForID:queryView.referenceID];
   [self garbageCollectLimboDocuments];
 }
 
@@ -436,6 +869,12 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 
   [self.queryViewsByQuery
       enumerateKeysAndObjectsUsingBlock:^(FSTQuery *query, FSTQueryView *queryView, BOOL *stop) {
+        // Without a remote event the changed documents are all that can affect a view, so views
+        // that none of them could belong to are left alone.
+        if (!remoteEvent && ![self documentChanges:changes couldAffectQuery:query]) {
+          return;
+        }
+
         FSTView *view = queryView.view;
         FSTViewDocumentChanges *viewDocChanges = [view computeChangesWithDocuments:changes];
         if (viewDocChanges.needsRefill) {
@@ -450,7 +889,7 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
             [queryView.view applyChangesToDocuments:viewDocChanges targetChange:targetChange];
 
         [self updateTrackedLimboDocumentsWithChanges:viewChange.limboChanges
-                                            targetID:queryView.targetID];
+                                         referenceID:queryView.referenceID];
 
         if (viewChange.snapshot) {
           [newSnapshots addObject:viewChange.snapshot];
@@ -462,22 +901,80 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 
   [self.delegate handleViewSnapshots:newSnapshots];
   [self.localStore notifyLocalViewChanges:documentChangesInAllViews];
-  [self.localStore collectGarbage];
+  [self scheduleGarbageCollection];
 }
 
-/** Updates the limbo document state for the given targetID. */
+/** Returns YES if any of the changed documents is in the part of the database the query covers. */
+- (BOOL)documentChanges:(FSTMaybeDocumentDictionary *)changes couldAffectQuery:(FSTQuery *)query {
+  __block BOOL affected = NO;
+  [changes enumerateKeysAndObjectsUsingBlock:^(FSTDocumentKey *key, FSTMaybeDocument *doc,
+                                               BOOL *stop) {
+    if ([query pathMatchesKey:key]) {
+      affected = YES;
+      *stop = YES;
+    }
+  }];
+  return affected;
+}
+
+/**
+ * Arranges for the local store to collect garbage once the client has been idle for
+ * kGarbageCollectionIdleDelay, or collects it right away if there's no workerDispatchQueue.
+ */
+- (void)scheduleGarbageCollection {
+  if (!self.workerDispatchQueue) {
+    [self.localStore collectGarbage];
+    return;
+  }
+
+  self.lastGarbageCollectionRequest = CFAbsoluteTimeGetCurrent();
+  if (!self.isGarbageCollectionScheduled) {
+    [self scheduleGarbageCollectionSliceAfterDelay:kGarbageCollectionIdleDelay];
+  }
+}
+
+- (void)scheduleGarbageCollectionSliceAfterDelay:(NSTimeInterval)delay {
+  self.garbageCollectionScheduled = YES;
+  FSTWeakify(self);
+  [self.workerDispatchQueue dispatchAfterDelay:delay
+                                         block:^{
+                                           FSTStrongify(self);
+                                           [self runGarbageCollectionSlice];
+                                         }];
+}
+
+/**
+ * Runs one slice of garbage collection and schedules the next one if garbage is left over. Work
+ * queued while the slice ran goes first, since the next slice is dispatched behind it.
+ */
+- (void)runGarbageCollectionSlice {
+  self.garbageCollectionScheduled = NO;
+
+  // Postpone collection while the client is still busy.
+  NSTimeInterval idleTime = CFAbsoluteTimeGetCurrent() - self.lastGarbageCollectionRequest;
+  if (idleTime < kGarbageCollectionIdleDelay) {
+    [self scheduleGarbageCollectionSliceAfterDelay:kGarbageCollectionIdleDelay - idleTime];
+    return;
+  }
+
+  if ([self.localStore collectGarbageWithTimeLimit:kGarbageCollectionSliceTime]) {
+    [self scheduleGarbageCollectionSliceAfterDelay:0];
+  }
+}
+
+/** Updates the limbo document state for the view with the given referenceID. */
 - (void)updateTrackedLimboDocumentsWithChanges:(NSArray<FSTLimboDocumentChange *> *)limboChanges
-                                      targetID:(FSTTargetID)targetID {
+                                   referenceID:(FSTTargetID)referenceID {
   for (FSTLimboDocumentChange *limboChange in limboChanges) {
     switch (limboChange.type) {
       case FSTLimboDocumentChangeTypeAdded:
-        [self.limboDocumentRefs addReferenceToKey:limboChange.key forID:targetID];
+        [self.limboDocumentRefs addReferenceToKey:limboChange.key forID:referenceID];
         [self trackLimboChange:limboChange];
         break;
 
       case FSTLimboDocumentChangeTypeRemoved:
         FSTLog(@"Document no longer in limbo: %@", limboChange.key);
-        [self.limboDocumentRefs removeReferenceToKey:limboChange.key forID:targetID];
+        [self.limboDocumentRefs removeReferenceToKey:limboChange.key forID:referenceID];
         break;
 
       default:
@@ -490,15 +987,31 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 - (void)trackLimboChange:(FSTLimboDocumentChange *)limboChange {
   FSTDocumentKey *key = limboChange.key;
 
-  if (!self.limboTargetsByKey[key]) {
+  if (!self.limboTargetsByKey[key] && ![self.enqueuedLimboResolutions containsObject:key]) {
     FSTLog(@"New document in limbo: %@", key);
+    [self.enqueuedLimboResolutions addObject:key];
+    [self pumpEnqueuedLimboResolutions];
+  }
+}
+
+/**
+ * Starts listens to resolve enqueued limbo documents, oldest first, until
+ * maxConcurrentLimboResolutions listens are active. Reconnecting with many documents in limbo
+ * would otherwise send a listen for every one of them at once.
+ */
+- (void)pumpEnqueuedLimboResolutions {
+  while (self.enqueuedLimboResolutions.count > 0 &&
+         self.limboTargetsByKey.count < self.maxConcurrentLimboResolutions) {
+    FSTDocumentKey *key = self.enqueuedLimboResolutions.firstObject;
+    [self.enqueuedLimboResolutions removeObjectAtIndex:0];
+
     FSTTargetID limboTargetID = _targetIdGenerator.NextId();
     FSTQuery *query = [FSTQuery queryWithPath:key.path];
     FSTQueryData *queryData = [[FSTQueryData alloc] initWithQuery:query
                                                          targetID:limboTargetID
                                              listenSequenceNumber:kIrrelevantSequenceNumber
                                                           purpose:FSTQueryPurposeLimboResolution];
-    self.limboKeysByTarget[@(limboTargetID)] = key;
+    _limboKeysByTarget[limboTargetID] = key;
     [self.remoteStore listenToTargetWithQueryData:queryData];
     self.limboTargetsByKey[key] = @(limboTargetID);
   }
@@ -508,16 +1021,22 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 - (void)garbageCollectLimboDocuments {
   NSSet<FSTDocumentKey *> *garbage = [self.limboCollector collectGarbage];
   for (FSTDocumentKey *key in garbage) {
+    if ([self.enqueuedLimboResolutions containsObject:key]) {
+      // The document left limbo before its resolution started.
+      [self.enqueuedLimboResolutions removeObject:key];
+      continue;
+    }
     FSTBoxedTargetID *limboTarget = self.limboTargetsByKey[key];
     if (!limboTarget) {
       // This target already got removed, because the query failed.
-      return;
+      continue;
     }
     FSTTargetID limboTargetID = limboTarget.intValue;
     [self.remoteStore stopListeningToTargetID:limboTargetID];
     [self.limboTargetsByKey removeObjectForKey:key];
-    [self.limboKeysByTarget removeObjectForKey:limboTarget];
+    _limboKeysByTarget.erase(limboTargetID);
   }
+  [self pumpEnqueuedLimboResolutions];
 }
 
 // Used for testing
@@ -528,6 +1047,10 @@ static const FSTListenSequenceNumber kIrrelevantSequenceNumber = -1;
 
 - (void)userDidChange:(FSTUser *)user {
   self.currentUser = user;
+  self.lastWriteBatchID = kFSTBatchIDUnknown;
+
+  // Acknowledgements still held back by the remote store belong to the old user's mutation queue.
+  [self.remoteStore flushWriteAcknowledgements];
 
   // Notify local store and emit any resulting events from swapping out the mutation queue.
   FSTMaybeDocumentDictionary *changes = [self.localStore userDidChange:user];
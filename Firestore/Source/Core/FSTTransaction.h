@@ -40,7 +40,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 /**
  * Takes a set of keys and asynchronously attempts to fetch all the documents from the backend,
- * ignoring any local changes.
+ * ignoring any local changes. Lookups made in quick succession are sent to the backend together,
+ * and documents already read in this transaction are returned as they were read without another
+ * fetch.
  */
 - (void)lookupDocumentsForKeys:(NSArray<FSTDocumentKey *> *)keys
                     completion:(FSTVoidMaybeDocumentArrayErrorBlock)completion;
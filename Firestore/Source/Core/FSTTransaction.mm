@@ -28,16 +28,51 @@
 #import "Firestore/Source/Model/FSTMutation.h"
 #import "Firestore/Source/Remote/FSTDatastore.h"
 #import "Firestore/Source/Util/FSTAssert.h"
+#import "Firestore/Source/Util/FSTDispatchQueue.h"
 #import "Firestore/Source/Util/FSTUsageValidation.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+#pragma mark - FSTPendingLookup
+
+/** A call to lookupDocumentsForKeys:completion: waiting to be sent with the next batch. */
+@interface FSTPendingLookup : NSObject
+- (instancetype)initWithKeys:(NSArray<FSTDocumentKey *> *)keys
+                  completion:(FSTVoidMaybeDocumentArrayErrorBlock)completion;
+@property(nonatomic, strong, readonly) NSArray<FSTDocumentKey *> *keys;
+@property(nonatomic, copy, readonly) FSTVoidMaybeDocumentArrayErrorBlock completion;
+@end
+
+@implementation FSTPendingLookup
+
+- (instancetype)initWithKeys:(NSArray<FSTDocumentKey *> *)keys
+                  completion:(FSTVoidMaybeDocumentArrayErrorBlock)completion {
+  if (self = [super init]) {
+    _keys = keys;
+    _completion = completion;
+  }
+  return self;
+}
+
+@end
+
 #pragma mark - FSTTransaction
 
 @interface FSTTransaction ()
 @property(nonatomic, strong, readonly) FSTDatastore *datastore;
 @property(nonatomic, strong, readonly)
     NSMutableDictionary<FSTDocumentKey *, FSTSnapshotVersion *> *readVersions;
+/**
+ * The documents read so far, which answer later lookups of the same keys without another round
+ * trip. Guarded by @synchronized(self).
+ */
+@property(nonatomic, strong, readonly)
+    NSMutableDictionary<FSTDocumentKey *, FSTMaybeDocument *> *readDocuments;
+/**
+ * The lookups made since the last batch was sent, which are sent together in one
+ * BatchGetDocuments call. Guarded by @synchronized(self).
+ */
+@property(nonatomic, strong, readonly) NSMutableArray<FSTPendingLookup *> *pendingLookups;
 @property(nonatomic, strong, readonly) NSMutableArray *mutations;
 @property(nonatomic, assign) BOOL commitCalled;
 /**
@@ -58,6 +93,8 @@ NS_ASSUME_NONNULL_BEGIN
   if (self) {
     _datastore = datastore;
     _readVersions = [NSMutableDictionary dictionary];
+    _readDocuments = [NSMutableDictionary dictionary];
+    _pendingLookups = [NSMutableArray array];
     _mutations = [NSMutableArray array];
     _commitCalled = NO;
   }
@@ -65,36 +102,20 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 /**
- * Every time a document is read, this should be called to record its version. If we read two
- * different versions of the same document, this will return an error through its out parameter.
- * When the transaction is committed, the versions recorded will be set as preconditions on the
- * writes sent to the backend.
+ * Every time a document is read, this should be called to record its version. Documents that were
+ * already read are answered from readDocuments, so each document is recorded once. When the
+ * transaction is committed, the versions recorded will be set as preconditions on the writes sent
+ * to the backend.
  */
-- (BOOL)recordVersionForDocument:(FSTMaybeDocument *)doc error:(NSError **)error {
-  FSTAssert(error != nil, @"nil error parameter");
-  *error = nil;
+- (void)recordVersionForDocument:(FSTMaybeDocument *)doc {
+  FSTAssert(!self.readVersions[doc.key], @"Document %@ was read twice in a transaction", doc.key);
   FSTSnapshotVersion *docVersion = doc.version;
   if ([doc isKindOfClass:[FSTDeletedDocument class]]) {
     // For deleted docs, we must record an explicit no version to build the right precondition
     // when writing.
     docVersion = [FSTSnapshotVersion noVersion];
   }
-  FSTSnapshotVersion *existingVersion = self.readVersions[doc.key];
-  if (existingVersion) {
-    if (error) {
-      *error =
-          [NSError errorWithDomain:FIRFirestoreErrorDomain
-                              code:FIRFirestoreErrorCodeFailedPrecondition
-                          userInfo:@{
-                            NSLocalizedDescriptionKey :
-                                @"A document cannot be read twice within a single transaction."
-                          }];
-    }
-    return NO;
-  } else {
-    self.readVersions[doc.key] = docVersion;
-    return YES;
-  }
+  self.readVersions[doc.key] = docVersion;
 }
 
 - (void)lookupDocumentsForKeys:(NSArray<FSTDocumentKey *> *)keys
@@ -104,24 +125,96 @@ NS_ASSUME_NONNULL_BEGIN
     FSTThrowInvalidUsage(@"FIRIllegalStateException",
                          @"All reads in a transaction must be done before any writes.");
   }
-  [self.datastore lookupDocuments:keys
+
+  NSArray<FSTMaybeDocument *> *_Nullable readDocuments;
+  @synchronized(self) {
+    readDocuments = [self readDocumentsForKeys:keys];
+    if (!readDocuments) {
+      [self.pendingLookups addObject:[[FSTPendingLookup alloc] initWithKeys:keys
+                                                                 completion:completion]];
+      if (self.pendingLookups.count == 1) {
+        // Lookups made before this block runs, e.g. several getDocument calls made one after the
+        // other from the update block, are sent in the same BatchGetDocuments call.
+        [self.datastore.workerDispatchQueue dispatchAsyncAllowingSameQueue:^{
+          [self sendPendingLookups];
+        }];
+      }
+    }
+  }
+  if (readDocuments) {
+    // Documents already read in this transaction are answered without a round trip, with the
+    // version that the commit's preconditions are based on.
+    completion(readDocuments, nil);
+  }
+}
+
+/** Returns the read documents for the given keys, or nil if any of them hasn't been read. */
+- (nullable NSArray<FSTMaybeDocument *> *)readDocumentsForKeys:(NSArray<FSTDocumentKey *> *)keys {
+  NSMutableArray<FSTMaybeDocument *> *documents = [NSMutableArray arrayWithCapacity:keys.count];
+  for (FSTDocumentKey *key in keys) {
+    FSTMaybeDocument *_Nullable doc = self.readDocuments[key];
+    if (!doc) {
+      return nil;
+    }
+    [documents addObject:doc];
+  }
+  return documents;
+}
+
+/** Looks up the keys of all pending lookups that haven't been read yet in one batch. */
+- (void)sendPendingLookups {
+  NSArray<FSTPendingLookup *> *lookups;
+  NSMutableOrderedSet<FSTDocumentKey *> *keys = [NSMutableOrderedSet orderedSet];
+  @synchronized(self) {
+    lookups = [self.pendingLookups copy];
+    [self.pendingLookups removeAllObjects];
+    for (FSTPendingLookup *lookup in lookups) {
+      for (FSTDocumentKey *key in lookup.keys) {
+        if (!self.readDocuments[key]) {
+          [keys addObject:key];
+        }
+      }
+    }
+  }
+  if (keys.count == 0) {
+    // Everything was read by an earlier batch in the meantime.
+    [self completeLookups:lookups error:nil];
+    return;
+  }
+
+  [self.datastore lookupDocuments:keys.array
                        completion:^(NSArray<FSTMaybeDocument *> *_Nullable documents,
                                     NSError *_Nullable error) {
-                         if (error) {
-                           completion(nil, error);
-                           return;
-                         }
-                         for (FSTMaybeDocument *doc in documents) {
-                           NSError *recordError = nil;
-                           if (![self recordVersionForDocument:doc error:&recordError]) {
-                             completion(nil, recordError);
-                             return;
+                         @synchronized(self) {
+                           for (FSTMaybeDocument *doc in documents) {
+                             if (self.readDocuments[doc.key]) {
+                               // Read meanwhile by an earlier batch, whose version is kept.
+                               continue;
+                             }
+                             [self recordVersionForDocument:doc];
+                             self.readDocuments[doc.key] = doc;
                            }
                          }
-                         completion(documents, nil);
+                         [self completeLookups:lookups error:error];
                        }];
 }
 
+/** Calls the completions of the given lookups with their read documents or the error. */
+- (void)completeLookups:(NSArray<FSTPendingLookup *> *)lookups error:(nullable NSError *)error {
+  for (FSTPendingLookup *lookup in lookups) {
+    if (error) {
+      lookup.completion(nil, error);
+      continue;
+    }
+    NSArray<FSTMaybeDocument *> *_Nullable documents;
+    @synchronized(self) {
+      documents = [self readDocumentsForKeys:lookup.keys];
+    }
+    FSTAssert(documents, @"Missing looked up documents for keys: %@", lookup.keys);
+    lookup.completion(documents, nil);
+  }
+}
+
 /** Stores mutations to be written when commitWithCompletion is called. */
 - (void)writeMutations:(NSArray<FSTMutation *> *)mutations {
   [self ensureCommitNotCalled];
@@ -96,6 +96,18 @@ typedef NS_ENUM(NSInteger, FSTLimboDocumentChangeType) {
 - (instancetype)initWithQuery:(FSTQuery *)query
               remoteDocuments:(FSTDocumentKeySet *)remoteDocuments NS_DESIGNATED_INITIALIZER;
 
+/**
+ * Whether the view is current with the backend: the backend has marked its target current and the
+ * view hasn't lost consistency with it since.
+ */
+@property(nonatomic, assign, readonly, getter=isCurrent) BOOL current;
+
+/**
+ * Returns YES if the view is current and the backend has reported the document as part of the
+ * view's target, in which case the local store's copy of the document is up to date.
+ */
+- (BOOL)isDocumentKeySynced:(FSTDocumentKey *)key;
+
 /**
  * Iterates over a set of doc changes, applies the query limit, and computes what the new results
  * should be, what the changes were, and whether we may need to go back to the local cache for
@@ -35,7 +35,15 @@ NS_ASSUME_NONNULL_BEGIN
 - (instancetype)initWithDocumentSet:(FSTDocumentSet *)documentSet
                           changeSet:(FSTDocumentViewChangeSet *)changeSet
                         needsRefill:(BOOL)needsRefill
-                        mutatedKeys:(FSTDocumentKeySet *)mutatedKeys NS_DESIGNATED_INITIALIZER;
+                        mutatedKeys:(FSTDocumentKeySet *)mutatedKeys
+                         candidates:(FSTDocumentSet *)candidates
+                  candidateCapacity:(NSUInteger)candidateCapacity NS_DESIGNATED_INITIALIZER;
+
+/** The documents known to directly follow the limit. See FSTView.candidates. */
+@property(nonatomic, strong, readonly) FSTDocumentSet *candidates;
+
+/** The maximum number of candidates the view should keep. */
+@property(nonatomic, assign, readonly) NSUInteger candidateCapacity;
 
 @end
 
@@ -44,13 +52,17 @@ NS_ASSUME_NONNULL_BEGIN
 - (instancetype)initWithDocumentSet:(FSTDocumentSet *)documentSet
                           changeSet:(FSTDocumentViewChangeSet *)changeSet
                         needsRefill:(BOOL)needsRefill
-                        mutatedKeys:(FSTDocumentKeySet *)mutatedKeys {
+                        mutatedKeys:(FSTDocumentKeySet *)mutatedKeys
+                         candidates:(FSTDocumentSet *)candidates
+                  candidateCapacity:(NSUInteger)candidateCapacity {
   self = [super init];
   if (self) {
     _documentSet = documentSet;
     _changeSet = changeSet;
     _needsRefill = needsRefill;
     _mutatedKeys = mutatedKeys;
+    _candidates = candidates;
+    _candidateCapacity = candidateCapacity;
   }
   return self;
 }
@@ -136,8 +148,11 @@ NS_ASSUME_NONNULL_BEGIN
 
 #pragma mark - FSTView
 
-static NSComparisonResult FSTCompareDocumentViewChangeTypes(FSTDocumentViewChangeType c1,
-                                                            FSTDocumentViewChangeType c2);
+/** The most candidates a view with a limit starts out keeping. */
+static const NSUInteger kInitialCandidateCapacity = 16;
+
+/** The most candidates a view with a limit ever keeps. */
+static const NSUInteger kMaxCandidateCapacity = 1000;
 
 @interface FSTView ()
 
@@ -163,6 +178,20 @@ static NSComparisonResult FSTCompareDocumentViewChangeTypes(FSTDocumentViewChang
 /** Document Keys that have local changes. */
 @property(nonatomic, strong) FSTDocumentKeySet *mutatedKeys;
 
+/**
+ * For a query with a full limit, the matching documents that directly follow the last one in the
+ * view, in query order. There are no other matching documents between the view and the last
+ * candidate, so candidates can take the place of documents that leave the view without the query
+ * having to be re-run against the local cache.
+ */
+@property(nonatomic, strong) FSTDocumentSet *candidates;
+
+/**
+ * The maximum number of candidates to keep. It grows whenever the candidates run out and the view
+ * has to be refilled.
+ */
+@property(nonatomic, assign) NSUInteger candidateCapacity;
+
 @end
 
 @implementation FSTView
@@ -176,6 +205,8 @@ static NSComparisonResult FSTCompareDocumentViewChangeTypes(FSTDocumentViewChang
     _syncedDocuments = remoteDocuments;
     _limboDocuments = [FSTDocumentKeySet keySet];
     _mutatedKeys = [FSTDocumentKeySet keySet];
+    _candidates = [FSTDocumentSet documentSetWithComparator:query.comparator];
+    _candidateCapacity = kInitialCandidateCapacity;
   }
   return self;
 }
@@ -208,8 +239,20 @@ static NSComparisonResult FSTCompareDocumentViewChangeTypes(FSTDocumentViewChang
       (self.query.limit && oldDocumentSet.count == self.query.limit) ? oldDocumentSet.lastDocument
                                                                      : nil;
 
+  // A refill starts over from the complete local results, so any candidates are dropped.
+  __block FSTDocumentSet *candidates =
+      previousChanges ? [FSTDocumentSet documentSetWithComparator:self.query.comparator]
+                      : self.candidates;
+  FSTDocument *_Nullable lastCandidate = candidates.lastDocument;
+
+  // The last of the changed documents that match the query, in query order.
+  __block FSTDocument *_Nullable lastChangedDoc = nil;
+
   [docChanges enumerateKeysAndObjectsUsingBlock:^(FSTDocumentKey *key,
                                                   FSTMaybeDocument *maybeNewDoc, BOOL *stop) {
+    // Changed documents are placed according to their new state below.
+    candidates = [candidates documentSetByRemovingKey:key];
+
     FSTDocument *_Nullable oldDoc = [oldDocumentSet documentForKey:key];
     FSTDocument *_Nullable newDoc = nil;
     if ([maybeNewDoc isKindOfClass:[FSTDocument class]]) {
@@ -223,6 +266,9 @@ static NSComparisonResult FSTCompareDocumentViewChangeTypes(FSTDocumentViewChang
       }
     }
     if (newDoc) {
+      if (!lastChangedDoc || self.query.comparator(newDoc, lastChangedDoc) > 0) {
+        lastChangedDoc = newDoc;
+      }
       newDocumentSet = [newDocumentSet documentSetByAddingDocument:newDoc];
       if (newDoc.hasLocalMutations) {
         newMutatedKeys = [newMutatedKeys setByAddingObject:key];
@@ -270,6 +316,42 @@ static NSComparisonResult FSTCompareDocumentViewChangeTypes(FSTDocumentViewChang
       }
     }
   }];
+
+  if (needsRefill && lastCandidate) {
+    // Every matching document up to the last candidate is known, so if enough of them are left the
+    // limit can be filled from the candidates.
+    FSTDocumentSet *knownDocuments = newDocumentSet;
+    for (FSTDocument *candidate in candidates.documentEnumerator) {
+      knownDocuments = [knownDocuments documentSetByAddingDocument:candidate];
+    }
+    NSMutableArray<FSTDocument *> *fillers = [NSMutableArray array];
+    NSInteger known = 0;
+    for (FSTDocument *doc in knownDocuments.documentEnumerator) {
+      if (known == self.query.limit || self.query.comparator(doc, lastCandidate) > 0) {
+        break;
+      }
+      if ([candidates containsKey:doc.key]) {
+        [fillers addObject:doc];
+      }
+      known++;
+    }
+
+    if (known == self.query.limit) {
+      for (FSTDocument *filler in fillers) {
+        newDocumentSet = [newDocumentSet documentSetByAddingDocument:filler];
+        candidates = [candidates documentSetByRemovingKey:filler.key];
+        if (filler.hasLocalMutations) {
+          newMutatedKeys = [newMutatedKeys setByAddingObject:filler.key];
+        }
+        [changeSet
+            addChange:[FSTDocumentViewChange changeWithDocument:filler
+                                                           type:FSTDocumentViewChangeTypeAdded]];
+      }
+      needsRefill = NO;
+    }
+  }
+
+  NSMutableArray<FSTDocument *> *pastLimit = [NSMutableArray array];
   if (self.query.limit) {
     // TODO(klimt): Make DocumentSet size be constant time.
     while (newDocumentSet.count > self.query.limit) {
@@ -278,16 +360,45 @@ static NSComparisonResult FSTCompareDocumentViewChangeTypes(FSTDocumentViewChang
       [changeSet
           addChange:[FSTDocumentViewChange changeWithDocument:oldDoc
                                                          type:FSTDocumentViewChangeTypeRemoved]];
+      [pastLimit addObject:oldDoc];
     }
   }
 
   FSTAssert(!needsRefill || !previousChanges,
             @"View was refilled using docs that themselves needed refilling.");
 
+  // Having to refill means the candidates ran out, so keep more of them from now on.
+  NSUInteger candidateCapacity = self.candidateCapacity;
+  if (previousChanges) {
+    candidateCapacity = MIN(candidateCapacity * 2, kMaxCandidateCapacity);
+  }
+
+  FSTDocumentSet *newCandidates = [FSTDocumentSet documentSetWithComparator:self.query.comparator];
+  if (!needsRefill) {
+    // Only documents up to this bound are known to have no unknown matching documents before them.
+    // With a full limit, that's the end of what the view knew before. Otherwise, the view holds
+    // every match and the changes either add to that or, for a refill, are the complete local
+    // results up to the last of them.
+    FSTDocument *_Nullable bound =
+        (lastDocInLimit && !previousChanges) ? (lastCandidate ?: lastDocInLimit) : lastChangedDoc;
+    if (bound) {
+      for (FSTDocument *doc in [pastLimit arrayByAddingObjectsFromArray:candidates.arrayValue]) {
+        if (self.query.comparator(doc, bound) <= 0) {
+          newCandidates = [newCandidates documentSetByAddingDocument:doc];
+        }
+      }
+      while (newCandidates.count > candidateCapacity) {
+        newCandidates = [newCandidates documentSetByRemovingKey:newCandidates.lastDocument.key];
+      }
+    }
+  }
+
   return [[FSTViewDocumentChanges alloc] initWithDocumentSet:newDocumentSet
                                                    changeSet:changeSet
                                                  needsRefill:needsRefill
-                                                 mutatedKeys:newMutatedKeys];
+                                                 mutatedKeys:newMutatedKeys
+                                                  candidates:newCandidates
+                                           candidateCapacity:candidateCapacity];
 }
 
 - (FSTViewChange *)applyChangesToDocuments:(FSTViewDocumentChanges *)docChanges {
@@ -301,6 +412,8 @@ static NSComparisonResult FSTCompareDocumentViewChangeTypes(FSTDocumentViewChang
   FSTDocumentSet *oldDocuments = self.documentSet;
   self.documentSet = docChanges.documentSet;
   self.mutatedKeys = docChanges.mutatedKeys;
+  self.candidates = docChanges.candidates;
+  self.candidateCapacity = docChanges.candidateCapacity;
 
   // Sort changes based on type and query comparator.
   NSArray<FSTDocumentViewChange *> *changes = [docChanges.changeSet changes];
@@ -347,13 +460,19 @@ static NSComparisonResult FSTCompareDocumentViewChangeTypes(FSTDocumentViewChang
                                           initWithDocumentSet:self.documentSet
                                                     changeSet:[FSTDocumentViewChangeSet changeSet]
                                                   needsRefill:NO
-                                                  mutatedKeys:self.mutatedKeys]];
+                                                  mutatedKeys:self.mutatedKeys
+                                                   candidates:self.candidates
+                                            candidateCapacity:self.candidateCapacity]];
   } else {
     // No effect, just return a no-op FSTViewChange.
     return [[FSTViewChange alloc] initWithSnapshot:nil limboChanges:@[]];
   }
 }
 
+- (BOOL)isDocumentKeySynced:(FSTDocumentKey *)key {
+  return self.isCurrent && [self.syncedDocuments containsObject:key];
+}
+
 #pragma mark - Private methods
 
 /** Returns whether the doc for the given key should be in limbo. */
@@ -445,35 +564,4 @@ static NSComparisonResult FSTCompareDocumentViewChangeTypes(FSTDocumentViewChang
 
 @end
 
-static inline int DocumentViewChangeTypePosition(FSTDocumentViewChangeType changeType) {
-  switch (changeType) {
-    case FSTDocumentViewChangeTypeRemoved:
-      return 0;
-    case FSTDocumentViewChangeTypeAdded:
-      return 1;
-    case FSTDocumentViewChangeTypeModified:
-      return 2;
-    case FSTDocumentViewChangeTypeMetadata:
-      // A metadata change is converted to a modified change at the public API layer. Since we sort
-      // by document key and then change type, metadata and modified changes must be sorted
-      // equivalently.
-      return 2;
-    default:
-      FSTCFail(@"Unknown FSTDocumentViewChangeType %lu", (unsigned long)changeType);
-  }
-}
-
-static NSComparisonResult FSTCompareDocumentViewChangeTypes(FSTDocumentViewChangeType c1,
-                                                            FSTDocumentViewChangeType c2) {
-  int pos1 = DocumentViewChangeTypePosition(c1);
-  int pos2 = DocumentViewChangeTypePosition(c2);
-  if (pos1 == pos2) {
-    return NSOrderedSame;
-  } else if (pos1 < pos2) {
-    return NSOrderedAscending;
-  } else {
-    return NSOrderedDescending;
-  }
-}
-
 NS_ASSUME_NONNULL_END
@@ -36,6 +36,13 @@ typedef NS_ENUM(NSInteger, FSTDocumentViewChangeType) {
   FSTDocumentViewChangeTypeMetadata,
 };
 
+/**
+ * Compares change types by the order in which views report them: removals first, then additions,
+ * then modifications and metadata changes.
+ */
+NSComparisonResult FSTCompareDocumentViewChangeTypes(FSTDocumentViewChangeType c1,
+                                                     FSTDocumentViewChangeType c2);
+
 /** A change to a single document's state within a view. */
 @interface FSTDocumentViewChange : NSObject
 
@@ -112,6 +119,12 @@ typedef void (^FSTViewSnapshotHandler)(FSTViewSnapshot *_Nullable snapshot,
 /** Whether the sync state changed as part of this snapshot. */
 @property(nonatomic, assign, readonly) BOOL syncStateChanged;
 
+/**
+ * Returns a snapshot that goes straight from this snapshot's old documents to the documents of the
+ * given snapshot, which must directly follow this one, with the changes of both combined.
+ */
+- (FSTViewSnapshot *)snapshotByMergingSnapshot:(FSTViewSnapshot *)snapshot;
+
 @end
 
 NS_ASSUME_NONNULL_END
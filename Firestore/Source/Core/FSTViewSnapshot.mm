@@ -27,6 +27,37 @@ NS_ASSUME_NONNULL_BEGIN
 
 #pragma mark - FSTDocumentViewChange
 
+static inline int DocumentViewChangeTypePosition(FSTDocumentViewChangeType changeType) {
+  switch (changeType) {
+    case FSTDocumentViewChangeTypeRemoved:
+      return 0;
+    case FSTDocumentViewChangeTypeAdded:
+      return 1;
+    case FSTDocumentViewChangeTypeModified:
+      return 2;
+    case FSTDocumentViewChangeTypeMetadata:
+      // A metadata change is converted to a modified change at the public API layer. Since we sort
+      // by document key and then change type, metadata and modified changes must be sorted
+      // equivalently.
+      return 2;
+    default:
+      FSTCFail(@"Unknown FSTDocumentViewChangeType %lu", (unsigned long)changeType);
+  }
+}
+
+NSComparisonResult FSTCompareDocumentViewChangeTypes(FSTDocumentViewChangeType c1,
+                                                     FSTDocumentViewChangeType c2) {
+  int pos1 = DocumentViewChangeTypePosition(c1);
+  int pos2 = DocumentViewChangeTypePosition(c2);
+  if (pos1 == pos2) {
+    return NSOrderedSame;
+  } else if (pos1 < pos2) {
+    return NSOrderedAscending;
+  } else {
+    return NSOrderedDescending;
+  }
+}
+
 @interface FSTDocumentViewChange ()
 
 + (instancetype)changeWithDocument:(FSTDocument *)document type:(FSTDocumentViewChangeType)type;
@@ -191,6 +222,37 @@ NS_ASSUME_NONNULL_BEGIN
   return self;
 }
 
+- (FSTViewSnapshot *)snapshotByMergingSnapshot:(FSTViewSnapshot *)snapshot {
+  FSTDocumentViewChangeSet *changeSet = [FSTDocumentViewChangeSet changeSet];
+  for (FSTDocumentViewChange *change in self.documentChanges) {
+    [changeSet addChange:change];
+  }
+  for (FSTDocumentViewChange *change in snapshot.documentChanges) {
+    [changeSet addChange:change];
+  }
+
+  // Keep the order in which FSTView reports changes, since API snapshots replay them in order to
+  // compute indexes.
+  FSTQuery *query = snapshot.query;
+  NSArray<FSTDocumentViewChange *> *changes = [[changeSet changes]
+      sortedArrayUsingComparator:^NSComparisonResult(FSTDocumentViewChange *c1,
+                                                     FSTDocumentViewChange *c2) {
+        NSComparisonResult typeComparison = FSTCompareDocumentViewChangeTypes(c1.type, c2.type);
+        if (typeComparison != NSOrderedSame) {
+          return typeComparison;
+        }
+        return query.comparator(c1.document, c2.document);
+      }];
+
+  return [[FSTViewSnapshot alloc] initWithQuery:query
+                                      documents:snapshot.documents
+                                   oldDocuments:self.oldDocuments
+                                documentChanges:changes
+                                      fromCache:snapshot.fromCache
+                               hasPendingWrites:snapshot.hasPendingWrites
+                               syncStateChanged:self.syncStateChanged || snapshot.syncStateChanged];
+}
+
 - (NSString *)description {
   return [NSString stringWithFormat:
                        @"<FSTViewSnapshot query:%@ documents:%@ oldDocument:%@ changes:%@ "
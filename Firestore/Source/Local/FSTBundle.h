@@ -0,0 +1,75 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class FSTLocalSerializer;
+@class FSTMaybeDocument;
+@class FSTQueryData;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A bundle holds the results of queries as read from the backend at some point, so that they can
+ * be loaded into the local cache without syncing them over the watch stream.
+ *
+ * A bundle is a sequence of length-delimited protocol buffer fields, as if it were a message with
+ * these repeated fields:
+ *
+ *   1: FSTPBTarget, starting the results of a query. Its resume_token and snapshot_version (the
+ *      read time of the results) are used to resume listening to the query. Its target_id and
+ *      last_listen_sequence_number are ignored.
+ *   2: FSTPBMaybeDocument, a document in the results of the query started most recently, or just
+ *      a document to cache if no query has been started yet.
+ */
+@interface FSTBundleReader : NSObject
+
+- (instancetype)initWithData:(NSData *)data
+                  serializer:(FSTLocalSerializer *)serializer NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/** Whether all the elements of the bundle have been read. */
+@property(nonatomic, assign, readonly, getter=isAtEnd) BOOL atEnd;
+
+/**
+ * Reads the next element of the bundle, which must not be at its end: either an FSTQueryData
+ * starting the results of a query or an FSTMaybeDocument.
+ *
+ * @return The element, or nil if the bundle is malformed, in which case nothing more can be read.
+ */
+- (nullable id)readNextElement:(NSError **)error;
+
+@end
+
+/** Builds a bundle, e.g. for a server that prepares them or for tests. */
+@interface FSTBundleWriter : NSObject
+
+- (instancetype)initWithSerializer:(FSTLocalSerializer *)serializer NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/** Starts the results of the query, which the documents added next belong to. */
+- (void)addQueryData:(FSTQueryData *)queryData;
+
+- (void)addDocument:(FSTMaybeDocument *)document;
+
+/** The encoded bundle. */
+@property(nonatomic, strong, readonly) NSData *data;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "Firestore/Source/Local/FSTBundle.h"
+
+#include <inttypes.h>
+#include <memory>
+
+#import "FIRFirestoreErrors.h"
+#import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
+#import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
+#import "Firestore/Source/Local/FSTLocalSerializer.h"
+#import "Firestore/Source/Local/FSTQueryData.h"
+
+#include "Firestore/core/src/firebase/firestore/remote/wire_reader.h"
+#include "absl/strings/string_view.h"
+
+using firebase::firestore::remote::WireReader;
+using firebase::firestore::remote::WireType;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** The field numbers of the records in a bundle. */
+static const uint32_t kBundleQueryField = 1;
+static const uint32_t kBundleDocumentField = 2;
+
+static NSError *FSTMalformedBundleError(NSString *reason) {
+  NSString *description = [NSString stringWithFormat:@"Malformed bundle: %@", reason];
+  return [NSError errorWithDomain:FIRFirestoreErrorDomain
+                             code:FIRFirestoreErrorCodeInvalidArgument
+                         userInfo:@{NSLocalizedDescriptionKey : description}];
+}
+
+#pragma mark - FSTBundleReader
+
+@implementation FSTBundleReader {
+  NSData *_data;
+  FSTLocalSerializer *_serializer;
+  std::unique_ptr<WireReader> _reader;
+}
+
+- (instancetype)initWithData:(NSData *)data serializer:(FSTLocalSerializer *)serializer {
+  if (self = [super init]) {
+    // Keep the data alive for the reader, which points into it.
+    _data = [data copy];
+    _serializer = serializer;
+    _reader.reset(
+        new WireReader{absl::string_view{static_cast<const char *>(_data.bytes), _data.length}});
+  }
+  return self;
+}
+
+- (BOOL)isAtEnd {
+  return _reader->done();
+}
+
+- (nullable id)readNextElement:(NSError **)error {
+  uint32_t fieldNumber;
+  WireType wireType;
+  absl::string_view bytes;
+  if (!_reader->ReadTag(&fieldNumber, &wireType) || wireType != WireType::LengthDelimited ||
+      !_reader->ReadLengthDelimited(&bytes)) {
+    *error = FSTMalformedBundleError(@"truncated or invalid record");
+    return nil;
+  }
+
+  if (fieldNumber == kBundleQueryField) {
+    return [self decodedQueryData:bytes error:error];
+  } else if (fieldNumber == kBundleDocumentField) {
+    return [self decodedDocument:bytes error:error];
+  } else {
+    *error = FSTMalformedBundleError(
+        [NSString stringWithFormat:@"unknown record type %" PRIu32, fieldNumber]);
+    return nil;
+  }
+}
+
+- (nullable FSTQueryData *)decodedQueryData:(absl::string_view)bytes error:(NSError **)error {
+  NSData *data = [[NSData alloc] initWithBytesNoCopy:(void *)bytes.data()
+                                              length:bytes.size()
+                                        freeWhenDone:NO];
+  FSTPBTarget *proto = [FSTPBTarget parseFromData:data error:error];
+  if (!proto) {
+    return nil;
+  }
+  if (proto.targetTypeOneOfCase == FSTPBTarget_TargetType_OneOfCase_GPBUnsetOneOfCase) {
+    *error = FSTMalformedBundleError(@"query without a target");
+    return nil;
+  }
+  return [_serializer decodedQueryData:proto];
+}
+
+- (nullable FSTMaybeDocument *)decodedDocument:(absl::string_view)bytes error:(NSError **)error {
+  NSData *data = [[NSData alloc] initWithBytesNoCopy:(void *)bytes.data()
+                                              length:bytes.size()
+                                        freeWhenDone:NO];
+  FSTPBMaybeDocument *proto = [FSTPBMaybeDocument parseFromData:data error:error];
+  if (!proto) {
+    return nil;
+  }
+  if (proto.documentTypeOneOfCase == FSTPBMaybeDocument_DocumentType_OneOfCase_GPBUnsetOneOfCase) {
+    *error = FSTMalformedBundleError(@"document without contents");
+    return nil;
+  }
+  return [_serializer decodedMaybeDocument:proto];
+}
+
+@end
+
+#pragma mark - FSTBundleWriter
+
+@implementation FSTBundleWriter {
+  FSTLocalSerializer *_serializer;
+  NSMutableData *_data;
+}
+
+- (instancetype)initWithSerializer:(FSTLocalSerializer *)serializer {
+  if (self = [super init]) {
+    _serializer = serializer;
+    _data = [NSMutableData data];
+  }
+  return self;
+}
+
+- (void)addQueryData:(FSTQueryData *)queryData {
+  [self appendRecord:[[_serializer encodedQueryData:queryData] data] fieldNumber:kBundleQueryField];
+}
+
+- (void)addDocument:(FSTMaybeDocument *)document {
+  [self appendRecord:[[_serializer encodedMaybeDocument:document] data]
+         fieldNumber:kBundleDocumentField];
+}
+
+- (NSData *)data {
+  return [_data copy];
+}
+
+- (void)appendRecord:(NSData *)record fieldNumber:(uint32_t)fieldNumber {
+  [self appendVarint:(fieldNumber << 3) | static_cast<uint32_t>(WireType::LengthDelimited)];
+  [self appendVarint:record.length];
+  [_data appendData:record];
+}
+
+- (void)appendVarint:(uint64_t)value {
+  uint8_t bytes[10];
+  size_t size = 0;
+  do {
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    bytes[size++] = value ? (byte | 0x80) : byte;
+  } while (value);
+  [_data appendBytes:bytes length:size];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
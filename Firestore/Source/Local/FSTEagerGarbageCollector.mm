@@ -62,19 +62,9 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (NSMutableSet<FSTDocumentKey *> *)collectGarbage {
-  NSMutableArray<id<FSTGarbageSource>> *sources = self.sources;
-
   NSMutableSet<FSTDocumentKey *> *actualGarbage = [NSMutableSet set];
   for (FSTDocumentKey *key in self.potentialGarbage) {
-    BOOL isGarbage = YES;
-    for (id<FSTGarbageSource> source in sources) {
-      if ([source containsKey:key]) {
-        isGarbage = NO;
-        break;
-      }
-    }
-
-    if (isGarbage) {
+    if ([self isGarbage:key]) {
       [actualGarbage addObject:key];
     }
   }
@@ -84,6 +74,42 @@ NS_ASSUME_NONNULL_BEGIN
   return actualGarbage;
 }
 
+- (NSSet<FSTDocumentKey *> *)collectGarbageWithTimeLimit:(NSTimeInterval)timeLimit {
+  CFAbsoluteTime deadline = CFAbsoluteTimeGetCurrent() + timeLimit;
+
+  NSMutableArray<FSTDocumentKey *> *checked = [NSMutableArray array];
+  NSMutableSet<FSTDocumentKey *> *actualGarbage = [NSMutableSet set];
+  for (FSTDocumentKey *key in self.potentialGarbage) {
+    if (checked.count > 0 && CFAbsoluteTimeGetCurrent() >= deadline) {
+      break;
+    }
+    [checked addObject:key];
+    if ([self isGarbage:key]) {
+      [actualGarbage addObject:key];
+    }
+  }
+
+  // The keys not checked in time stay potential garbage for the next call.
+  for (FSTDocumentKey *key in checked) {
+    [self.potentialGarbage removeObject:key];
+  }
+  return actualGarbage;
+}
+
+- (BOOL)hasPotentialGarbage {
+  return self.potentialGarbage.count > 0;
+}
+
+/** Returns whether none of the garbage sources reference the given key. */
+- (BOOL)isGarbage:(FSTDocumentKey *)key {
+  for (id<FSTGarbageSource> source in self.sources) {
+    if ([source containsKey:key]) {
+      return NO;
+    }
+  }
+  return YES;
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
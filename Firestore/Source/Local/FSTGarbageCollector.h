@@ -20,7 +20,10 @@
 
 @class FSTDocumentKey;
 @class FSTDocumentReference;
+@class FSTQueryData;
+@class FSTWriteGroup;
 @protocol FSTGarbageCollector;
+@protocol FSTQueryCache;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -90,6 +93,35 @@ NS_ASSUME_NONNULL_BEGIN
 /** Returns the contents of the garbage bin and clears it. */
 - (NSSet<FSTDocumentKey *> *)collectGarbage;
 
+/**
+ * Like -collectGarbage, but stops checking potential garbage keys once the given time has passed
+ * and keeps the unchecked keys for a later call. At least one key is checked per call, so that
+ * repeated calls always make progress.
+ *
+ * @param timeLimit The time, in seconds, to spend checking keys.
+ * @return The confirmed garbage among the keys checked.
+ */
+- (NSSet<FSTDocumentKey *> *)collectGarbageWithTimeLimit:(NSTimeInterval)timeLimit;
+
+/** Whether there are potential garbage keys that haven't been checked yet. */
+@property(nonatomic, assign, readonly) BOOL hasPotentialGarbage;
+
+@optional
+
+/**
+ * Removes queries that are no longer listened to from the query cache, if the collector's policy
+ * calls for it. Removing a query releases its matching documents, which then become potential
+ * garbage for the next -collectGarbage.
+ *
+ * @param queryCache The query cache to remove queries from.
+ * @param liveQueries The queries currently listened to, keyed by target ID. These are never
+ *     removed.
+ * @param group The write group to remove the queries in.
+ */
+- (void)removeInactiveQueriesFromCache:(id<FSTQueryCache>)queryCache
+                           liveQueries:(NSDictionary<NSNumber *, FSTQueryData *> *)liveQueries
+                                 group:(FSTWriteGroup *)group;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "Firestore/Source/Local/FSTGarbageCollector.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** The default size of the persistent cache, in bytes, above which queries are removed. */
+extern const int64_t kFSTLRUGarbageCollectorDefaultThreshold;
+
+/**
+ * A block that returns the current size of the cache managed by an FSTLRUGarbageCollector, in
+ * whatever unit its threshold is given in, such as bytes on disk or a number of documents.
+ */
+typedef int64_t (^FSTLRUCacheSizeBlock)(void);
+
+/**
+ * A garbage collector implementation that keeps queries which are no longer listened to, so that
+ * listening to them again can resume from the cached results, until the cache grows beyond a size
+ * threshold.
+ *
+ * Once the cache exceeds the threshold, -removeInactiveQueriesFromCache:liveQueries:group: removes
+ * the least recently used inactive queries, ordered by their listen sequence numbers, and
+ * -collectGarbage then returns the documents no longer referenced by any garbage source. Both
+ * work in bounded batches so that no single pass holds up the worker queue for long; a large
+ * cache is trimmed over several passes.
+ */
+@interface FSTLRUGarbageCollector : NSObject <FSTGarbageCollector>
+
+/**
+ * Initializes the collector.
+ *
+ * @param threshold The cache size above which the collector removes queries.
+ * @param cacheSize A block measuring the current size of the cache.
+ */
+- (instancetype)initWithThreshold:(int64_t)threshold
+                        cacheSize:(FSTLRUCacheSizeBlock)cacheSize NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/** The cache size, as measured by cacheSize, above which the collector removes queries. */
+@property(nonatomic, assign, readonly) int64_t threshold;
+
+/** The maximum number of queries removed in one pass. Defaults to 100. */
+@property(nonatomic, assign) NSUInteger maxQueriesPerPass;
+
+/** The maximum number of potential garbage keys checked in one pass. Defaults to 1000. */
+@property(nonatomic, assign) NSUInteger maxDocumentsPerPass;
+
+@end
+
+NS_ASSUME_NONNULL_END
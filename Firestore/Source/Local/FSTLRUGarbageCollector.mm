@@ -0,0 +1,161 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
+
+#import "Firestore/Source/Local/FSTQueryCache.h"
+#import "Firestore/Source/Local/FSTQueryData.h"
+#import "Firestore/Source/Model/FSTDocumentKey.h"
+#import "Firestore/Source/Util/FSTLogger.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+const int64_t kFSTLRUGarbageCollectorDefaultThreshold = 100 * 1024 * 1024;
+
+static const NSUInteger kDefaultMaxQueriesPerPass = 100;
+static const NSUInteger kDefaultMaxDocumentsPerPass = 1000;
+
+/** A cache size meaning that no queries have been removed yet. */
+static const int64_t kNoPass = -1;
+
+@interface FSTLRUGarbageCollector ()
+
+@property(nonatomic, copy, readonly) FSTLRUCacheSizeBlock cacheSize;
+
+/** The garbage collectible sources to double-check during garbage collection. */
+@property(nonatomic, strong, readonly) NSMutableArray<id<FSTGarbageSource>> *sources;
+
+/** A set of potentially garbage keys, carried over between passes if there are too many. */
+@property(nonatomic, strong, readonly) NSMutableSet<FSTDocumentKey *> *potentialGarbage;
+
+/**
+ * The cache size measured before the last pass that removed queries. The size only reflects the
+ * removals once they have been compacted, so until the measurement changes another pass would
+ * remove queries for no reason.
+ */
+@property(nonatomic, assign) int64_t sizeAtLastPass;
+
+@end
+
+@implementation FSTLRUGarbageCollector
+
+- (instancetype)initWithThreshold:(int64_t)threshold
+                        cacheSize:(FSTLRUCacheSizeBlock)cacheSize {
+  if (self = [super init]) {
+    _threshold = threshold;
+    _cacheSize = [cacheSize copy];
+    _sources = [NSMutableArray array];
+    _potentialGarbage = [[NSMutableSet alloc] init];
+    _sizeAtLastPass = kNoPass;
+    _maxQueriesPerPass = kDefaultMaxQueriesPerPass;
+    _maxDocumentsPerPass = kDefaultMaxDocumentsPerPass;
+  }
+  return self;
+}
+
+- (BOOL)isEager {
+  return NO;
+}
+
+- (void)addGarbageSource:(id<FSTGarbageSource>)garbageSource {
+  [self.sources addObject:garbageSource];
+  garbageSource.garbageCollector = self;
+}
+
+- (void)removeGarbageSource:(id<FSTGarbageSource>)garbageSource {
+  [self.sources removeObject:garbageSource];
+  garbageSource.garbageCollector = nil;
+}
+
+- (void)addPotentialGarbageKey:(FSTDocumentKey *)key {
+  [self.potentialGarbage addObject:key];
+}
+
+- (void)removeInactiveQueriesFromCache:(id<FSTQueryCache>)queryCache
+                           liveQueries:(NSDictionary<NSNumber *, FSTQueryData *> *)liveQueries
+                                 group:(FSTWriteGroup *)group {
+  int64_t size = self.cacheSize();
+  if (size <= self.threshold || size == self.sizeAtLastPass) {
+    return;
+  }
+
+  NSMutableArray<FSTQueryData *> *inactive = [NSMutableArray array];
+  [queryCache enumerateQueryDataUsingBlock:^(FSTQueryData *queryData, BOOL *stop) {
+    if (!liveQueries[@(queryData.targetID)]) {
+      [inactive addObject:queryData];
+    }
+  }];
+  [inactive sortUsingComparator:^NSComparisonResult(FSTQueryData *left, FSTQueryData *right) {
+    if (left.sequenceNumber == right.sequenceNumber) {
+      return NSOrderedSame;
+    }
+    return left.sequenceNumber < right.sequenceNumber ? NSOrderedAscending : NSOrderedDescending;
+  }];
+
+  NSUInteger count = MIN(inactive.count, self.maxQueriesPerPass);
+  for (NSUInteger i = 0; i < count; i++) {
+    [queryCache removeQueryData:inactive[i] group:group];
+  }
+  self.sizeAtLastPass = size;
+
+  FSTLog(@"Cache size %lld exceeds %lld: removed %lu of %lu inactive queries", size,
+         self.threshold, (unsigned long)count, (unsigned long)inactive.count);
+}
+
+- (NSSet<FSTDocumentKey *> *)collectGarbage {
+  return [self collectGarbageWithTimeLimit:DBL_MAX];
+}
+
+- (NSSet<FSTDocumentKey *> *)collectGarbageWithTimeLimit:(NSTimeInterval)timeLimit {
+  CFAbsoluteTime deadline = CFAbsoluteTimeGetCurrent() + timeLimit;
+
+  NSMutableArray<FSTDocumentKey *> *checked = [NSMutableArray array];
+  NSMutableSet<FSTDocumentKey *> *actualGarbage = [NSMutableSet set];
+  for (FSTDocumentKey *key in self.potentialGarbage) {
+    if (checked.count == self.maxDocumentsPerPass ||
+        (checked.count > 0 && CFAbsoluteTimeGetCurrent() >= deadline)) {
+      break;
+    }
+    [checked addObject:key];
+    if ([self isGarbage:key]) {
+      [actualGarbage addObject:key];
+    }
+  }
+
+  // Keys beyond the batch stay potential garbage for the next pass.
+  for (FSTDocumentKey *key in checked) {
+    [self.potentialGarbage removeObject:key];
+  }
+  return actualGarbage;
+}
+
+- (BOOL)hasPotentialGarbage {
+  return self.potentialGarbage.count > 0;
+}
+
+/** Returns whether none of the garbage sources reference the given key. */
+- (BOOL)isGarbage:(FSTDocumentKey *)key {
+  for (id<FSTGarbageSource> source in self.sources) {
+    if ([source containsKey:key]) {
+      return NO;
+    }
+  }
+  return YES;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
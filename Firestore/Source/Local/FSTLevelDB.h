@@ -22,10 +22,57 @@
 #include "leveldb/db.h"
 
 @class FSTDatabaseInfo;
+@class FSTDispatchQueue;
 @class FSTLocalSerializer;
 
 NS_ASSUME_NONNULL_BEGIN
 
+/** How FSTLevelDB verifies the checksums LevelDB stores alongside each block of data. */
+typedef NS_ENUM(NSInteger, FSTLevelDBChecksumMode) {
+  /** Every block is verified on every read. */
+  FSTLevelDBChecksumModeEveryRead,
+
+  /**
+   * The whole database is verified once as part of -[FSTLevelDB start:], after which reads skip
+   * verification.
+   */
+  FSTLevelDBChecksumModeOnStart,
+};
+
+/** The default size in bytes of the LevelDB block cache, sized for mobile devices. */
+extern const int64_t kFSTLevelDBDefaultBlockCacheSize;
+
+/** The default size in bytes of the LevelDB write buffer, sized for mobile devices. */
+extern const int64_t kFSTLevelDBDefaultWriteBufferSize;
+
+/** The approximate sizes of FSTLevelDB's tables, in bytes, grouped by what they store. */
+typedef struct {
+  /** The cached documents received from the backend. */
+  int64_t remoteDocuments;
+
+  /** The queues of pending local writes and their document index. */
+  int64_t mutations;
+
+  /** The cached queries, their canonical ID index, and the query cache metadata. */
+  int64_t targets;
+
+  /** The rows recording which cached documents match each cached query, in both directions. */
+  int64_t targetDocuments;
+} FSTLevelDBTableSizes;
+
+/**
+ * A block called after each commit with statistics about it.
+ *
+ * @param action The action description of the committed FSTWriteGroup.
+ * @param changes The number of sets and removals in the group.
+ * @param bytes The approximate size of the group as written, in bytes.
+ * @param latency How long LevelDB took to write the group, in seconds.
+ */
+typedef void (^FSTLevelDBCommitMetricsHandler)(NSString *action,
+                                               int changes,
+                                               size_t bytes,
+                                               NSTimeInterval latency);
+
 /** A LevelDB-backed instance of FSTPersistence. */
 // TODO(mikelehen): Rename to FSTLevelDBPersistence.
 @interface FSTLevelDB : NSObject <FSTPersistence>
@@ -33,9 +80,18 @@ NS_ASSUME_NONNULL_BEGIN
 /**
  * Initializes the LevelDB in the given directory. Note that all expensive startup work including
  * opening any database files is deferred until -[FSTPersistence start] is called.
+ *
+ * @param blockCacheSize The size in bytes of the in-memory cache of uncompressed table blocks.
+ * @param writeBufferSize The amount of data in bytes to buffer in memory before converting it to a
+ *     sorted on-disk file.
  */
 - (instancetype)initWithDirectory:(NSString *)directory
-                       serializer:(FSTLocalSerializer *)serializer NS_DESIGNATED_INITIALIZER;
+                       serializer:(FSTLocalSerializer *)serializer
+                   blockCacheSize:(int64_t)blockCacheSize
+                  writeBufferSize:(int64_t)writeBufferSize NS_DESIGNATED_INITIALIZER;
+
+/** Initializes the LevelDB in the given directory with the default cache and buffer sizes. */
+- (instancetype)initWithDirectory:(NSString *)directory serializer:(FSTLocalSerializer *)serializer;
 
 - (instancetype)init __attribute__((unavailable("Use -initWithDirectory: instead.")));
 
@@ -62,12 +118,26 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (BOOL)start:(NSError **)error;
 
+/**
+ * The checksum verification mode shared by all FSTLevelDB instances. Defaults to
+ * FSTLevelDBChecksumModeOnStart. Changes take effect for databases started afterwards.
+ */
++ (FSTLevelDBChecksumMode)checksumMode;
++ (void)setChecksumMode:(FSTLevelDBChecksumMode)checksumMode;
+
 // What follows is the Objective-C++ extension to the API.
 /**
- * @return A standard set of read options
+ * @return A standard set of read options, verifying checksums according to the checksumMode.
  */
 + (const leveldb::ReadOptions)standardReadOptions;
 
+/**
+ * @return Read options for one-shot scans over large parts of the database, such as migrations
+ *     and consistency checks. The blocks read aren't added to the block cache so that scanning
+ *     doesn't evict the working set.
+ */
++ (const leveldb::ReadOptions)scanReadOptions;
+
 /**
  * Creates an NSError based on the given status if the status is not ok.
  *
@@ -92,6 +162,36 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (NSString *)descriptionOfStatus:(leveldb::Status)status;
 
+/**
+ * Returns the approximate size on disk, in bytes, of each group of tables. This is cheap to compute
+ * but only counts data that LevelDB has written out to table files, so it lags behind recent writes
+ * and doesn't shrink after removals until they are compacted away.
+ */
+- (FSTLevelDBTableSizes)approximateTableSizes;
+
+/**
+ * Returns the approximate size on disk, in bytes, of the cached remote documents and queries, the
+ * part of the database that garbage collection can shrink. See -approximateTableSizes.
+ */
+- (int64_t)approximateCacheSizeBytes;
+
+/**
+ * Defers the compaction of the tombstones left by large removals, such as garbage collection or
+ * releasing a large target, until the database has gone the given delay without a commit. Until
+ * this is called they're compacted right after the removal is committed.
+ *
+ * Snapshots of large collections of remote documents are likewise written once the database has
+ * gone idle. Until this is called they aren't written at all.
+ *
+ * @param delay How long in seconds the database must go without a commit to be considered idle.
+ * @param workerDispatchQueue The queue that commits groups, on which the idle timer runs.
+ */
+- (void)enableIdleCompactionWithDelay:(NSTimeInterval)delay
+                  workerDispatchQueue:(FSTDispatchQueue *)workerDispatchQueue;
+
+/** If set, called on the committing queue after every successful commitGroup:. */
+@property(nonatomic, copy, nullable) FSTLevelDBCommitMetricsHandler commitMetricsHandler;
+
 /** The native db pointer, allocated during start. */
 @property(nonatomic, assign, readonly) std::shared_ptr<leveldb::DB> ptr;
 
@@ -16,61 +16,266 @@
 
 #import "Firestore/Source/Local/FSTLevelDB.h"
 
+#include <leveldb/cache.h>
 #include <leveldb/db.h>
+#include <leveldb/filter_policy.h>
+#include <leveldb/write_batch.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <utility>
+#include <vector>
 
 #import "FIRFirestoreErrors.h"
+#import "Firestore/Source/API/FIRFirestore+Internal.h"
+#import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
 #import "Firestore/Source/Core/FSTDatabaseInfo.h"
+#import "Firestore/Source/Local/FSTLevelDBDocumentSnapshots.h"
+#import "Firestore/Source/Local/FSTLevelDBKey.h"
 #import "Firestore/Source/Local/FSTLevelDBMigrations.h"
 #import "Firestore/Source/Local/FSTLevelDBMutationQueue.h"
 #import "Firestore/Source/Local/FSTLevelDBQueryCache.h"
+#import "Firestore/Source/Local/FSTLevelDBReader.h"
 #import "Firestore/Source/Local/FSTLevelDBRemoteDocumentCache.h"
 #import "Firestore/Source/Local/FSTWriteGroup.h"
 #import "Firestore/Source/Local/FSTWriteGroupTracker.h"
 #import "Firestore/Source/Model/FSTDatabaseID.h"
 #import "Firestore/Source/Remote/FSTSerializerBeta.h"
 #import "Firestore/Source/Util/FSTAssert.h"
+#import "Firestore/Source/Util/FSTDispatchQueue.h"
 #import "Firestore/Source/Util/FSTLogger.h"
 
+#include "Firestore/core/src/firebase/firestore/util/string_util.h"
+
 NS_ASSUME_NONNULL_BEGIN
 
 static NSString *const kReservedPathComponent = @"firestore";
 
+const int64_t kFSTLevelDBDefaultBlockCacheSize = 4 * 1024 * 1024;
+const int64_t kFSTLevelDBDefaultWriteBufferSize = 2 * 1024 * 1024;
+
+/**
+ * The number of bloom filter bits per key in each table. Ten bits give a false positive rate of
+ * about one percent, so nearly all point lookups for missing keys are answered without reading a
+ * data block from disk.
+ */
+static const int kBloomFilterBitsPerKey = 10;
+
+static FSTLevelDBChecksumMode checksumMode = FSTLevelDBChecksumModeOnStart;
+
+/**
+ * How long after an FSTWriteDurabilityCoalescedSync commit its writes are synced to disk. Every
+ * commit made in this window is covered by the same sync.
+ */
+static const int64_t kCoalescedSyncDelayMs = 100;
+
+/**
+ * The number of removals a group must make for the range they cover to be compacted, unless the
+ * group asks for specific ranges itself. Smaller removals leave few enough tombstones that
+ * LevelDB's own compactions clear them before they slow down scans noticeably.
+ */
+static const int kCompactionThreshold = 1000;
+
+/**
+ * The subdirectory of the database directory holding the snapshots of large collections. LevelDB
+ * ignores entries it didn't create, and keeping them inside means they're deleted with the data
+ * they were made from.
+ */
+static NSString *const kDocumentSnapshotsDirectory = @"snapshots";
+
+using firebase::firestore::util::PrefixSuccessor;
+using leveldb::Cache;
 using leveldb::DB;
+using leveldb::FilterPolicy;
 using leveldb::Options;
 using leveldb::ReadOptions;
 using leveldb::Status;
 using leveldb::WriteOptions;
 
+/**
+ * Syncs all writes made so far to disk. LevelDB syncs the whole log when a write requests it, so
+ * writing an empty batch is enough.
+ */
+static void SyncWrites(const std::shared_ptr<DB> &db) {
+  WriteOptions options;
+  options.sync = true;
+  leveldb::WriteBatch empty;
+  Status status = db->Write(options, &empty);
+  if (!status.ok()) {
+    FSTWarn(@"Failed to sync writes to disk: %s", status.ToString().c_str());
+  }
+}
+
+/**
+ * Returns the block cache with the given capacity, shared by all the open databases in the process
+ * that ask for that capacity. Instances with the same settings, such as one per signed-in account,
+ * then share one budget for cached blocks, which goes to whichever of them is busiest, instead of
+ * each adding a cache of their own.
+ */
+static std::shared_ptr<Cache> SharedBlockCache(size_t capacity) {
+  // Never destroyed, so that databases closed during process exit can still release their caches.
+  static std::mutex *mutex = new std::mutex();
+  static auto *caches = new std::map<size_t, std::weak_ptr<Cache>>();
+
+  std::lock_guard<std::mutex> lock(*mutex);
+  std::weak_ptr<Cache> &entry = (*caches)[capacity];
+  std::shared_ptr<Cache> cache = entry.lock();
+  if (!cache) {
+    cache.reset(leveldb::NewLRUCache(capacity));
+    entry = cache;
+  }
+  return cache;
+}
+
+/** Returns the bloom filter policy shared by all the databases in the process. It's stateless. */
+static const FilterPolicy *SharedFilterPolicy() {
+  static const FilterPolicy *policy = leveldb::NewBloomFilterPolicy(kBloomFilterBitsPerKey);
+  return policy;
+}
+
+/**
+ * Returns the queue shared by all the databases in the process for deferred syncs and
+ * compactions. LevelDB itself runs every database's background compactions on the single thread
+ * of its default Env, so serializing this work across databases as well keeps them from competing
+ * for the disk.
+ */
+static dispatch_queue_t SharedSyncQueue() {
+  static dispatch_queue_t queue;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    queue = dispatch_queue_create("com.google.firebase.firestore.leveldb.sync", NULL);
+  });
+  return queue;
+}
+
+/**
+ * Sorts the given [start, end) ranges of keys and merges those that overlap or touch, so that no
+ * table file is compacted twice.
+ */
+static std::vector<std::pair<std::string, std::string>> MergeRanges(
+    std::vector<std::pair<std::string, std::string>> ranges) {
+  std::sort(ranges.begin(), ranges.end());
+  std::vector<std::pair<std::string, std::string>> merged;
+  for (auto &range : ranges) {
+    if (!merged.empty() && range.first <= merged.back().second) {
+      merged.back().second = std::max(merged.back().second, range.second);
+    } else {
+      merged.push_back(std::move(range));
+    }
+  }
+  return merged;
+}
+
+/**
+ * Returns LevelDB's estimate of the size on disk, in bytes, of all the keys starting with any of
+ * the given prefixes.
+ */
+static int64_t ApproximateSizeOfPrefixes(DB *db, const std::vector<std::string> &prefixes) {
+  std::vector<std::string> limits;
+  for (const std::string &prefix : prefixes) {
+    limits.push_back(PrefixSuccessor(prefix));
+  }
+  std::vector<leveldb::Range> ranges;
+  for (size_t i = 0; i < prefixes.size(); i++) {
+    ranges.emplace_back(prefixes[i], limits[i]);
+  }
+
+  std::vector<uint64_t> sizes(ranges.size());
+  db->GetApproximateSizes(ranges.data(), static_cast<int>(ranges.size()), sizes.data());
+
+  int64_t total = 0;
+  for (uint64_t size : sizes) {
+    total += static_cast<int64_t>(size);
+  }
+  return total;
+}
+
 @interface FSTLevelDB ()
 
 @property(nonatomic, copy) NSString *directory;
+@property(nonatomic, assign, readonly) int64_t blockCacheSize;
+@property(nonatomic, assign, readonly) int64_t writeBufferSize;
+
+/** The reader shared by all the components vended by this instance, created during start. */
+@property(nonatomic, strong, nullable) FSTLevelDBReader *reader;
 @property(nonatomic, strong) FSTWriteGroupTracker *writeGroupTracker;
 @property(nonatomic, assign, getter=isStarted) BOOL started;
 @property(nonatomic, strong, readonly) FSTLocalSerializer *serializer;
 
+/** The queue on which compactions wait for the database to go idle, if enabled. */
+@property(nonatomic, strong, nullable) FSTDispatchQueue *idleCompactionQueue;
+@property(nonatomic, assign) NSTimeInterval idleCompactionDelay;
+
+/** The pending callback that compacts the pending ranges once the database is idle. */
+@property(nonatomic, strong, nullable) FSTDelayedCallback *idleCompaction;
+
+/** The snapshots of large collections of remote documents, created during start. */
+@property(nonatomic, strong, nullable) FSTLevelDBDocumentSnapshots *documentSnapshots;
+
 @end
 
-@implementation FSTLevelDB
+@implementation FSTLevelDB {
+  // Serializes the deferred syncs of FSTWriteDurabilityCoalescedSync commits and compactions.
+  dispatch_queue_t _syncQueue;
+
+  // Whether a deferred sync has been scheduled and not yet performed. Shared with the blocks that
+  // perform the syncs.
+  std::shared_ptr<std::atomic<bool>> _syncScheduled;
+
+  // The [start, end) ranges of keys holding tombstones of large removals that haven't been
+  // compacted yet, and the number of removals they hold.
+  std::vector<std::pair<std::string, std::string>> _pendingCompactions;
+  int _pendingCompactionRemovals;
+}
+
++ (FSTLevelDBChecksumMode)checksumMode {
+  return checksumMode;
+}
+
++ (void)setChecksumMode:(FSTLevelDBChecksumMode)mode {
+  checksumMode = mode;
+}
 
-/**
- * For now this is paranoid, but perhaps disable that in production builds.
- */
 + (const ReadOptions)standardReadOptions {
   ReadOptions options;
-  options.verify_checksums = true;
+  options.verify_checksums = checksumMode == FSTLevelDBChecksumModeEveryRead;
+  return options;
+}
+
++ (const ReadOptions)scanReadOptions {
+  ReadOptions options = [self standardReadOptions];
+  options.fill_cache = false;
   return options;
 }
 
 - (instancetype)initWithDirectory:(NSString *)directory
-                       serializer:(FSTLocalSerializer *)serializer {
+                       serializer:(FSTLocalSerializer *)serializer
+                   blockCacheSize:(int64_t)blockCacheSize
+                  writeBufferSize:(int64_t)writeBufferSize {
   if (self = [super init]) {
     _directory = [directory copy];
     _writeGroupTracker = [FSTWriteGroupTracker tracker];
     _serializer = serializer;
+    _blockCacheSize = blockCacheSize;
+    _writeBufferSize = writeBufferSize;
+    _syncQueue = SharedSyncQueue();
+    _syncScheduled = std::make_shared<std::atomic<bool>>(false);
   }
   return self;
 }
 
+- (instancetype)initWithDirectory:(NSString *)directory
+                       serializer:(FSTLocalSerializer *)serializer {
+  return [self initWithDirectory:directory
+                      serializer:serializer
+                  blockCacheSize:kFSTLevelDBDefaultBlockCacheSize
+                 writeBufferSize:kFSTLevelDBDefaultWriteBufferSize];
+}
+
 + (NSString *)documentsDirectory {
 #if TARGET_OS_IPHONE
   NSArray<NSString *> *directories =
@@ -122,12 +327,36 @@ using leveldb::WriteOptions;
     return NO;
   }
 
-  DB *database = [self createDBWithDirectory:directory error:error];
+  // The block cache must outlive the DB, which may itself outlive this object through the shared
+  // pointers held by the caches it vends, so the DB holds on to it until it's deleted.
+  std::shared_ptr<Cache> blockCache = SharedBlockCache(static_cast<size_t>(self.blockCacheSize));
+  DB *database = [self createDBWithDirectory:directory
+                                  blockCache:blockCache.get()
+                                filterPolicy:SharedFilterPolicy()
+                                       error:error];
   if (!database) {
     return NO;
   }
-  _ptr.reset(database);
-  [FSTLevelDBMigrations runMigrationsOnDB:_ptr];
+  _ptr.reset(database, [blockCache](DB *db) { delete db; });
+
+  if (checksumMode == FSTLevelDBChecksumModeOnStart && ![self verifyChecksums:error]) {
+    _ptr.reset();
+    return NO;
+  }
+  [FSTLevelDBMigrations runMigrationsOnDB:_ptr serializer:self.serializer];
+  self.reader = [[FSTLevelDBReader alloc] initWithDB:_ptr];
+
+  FSTPBTargetGlobal *metadata = [FSTLevelDBQueryCache readTargetMetadataFromDB:_ptr];
+  NSString *snapshotsDirectory =
+      [directory stringByAppendingPathComponent:kDocumentSnapshotsDirectory];
+  self.documentSnapshots =
+      [[FSTLevelDBDocumentSnapshots alloc] initWithDirectory:snapshotsDirectory
+                                                      reader:self.reader
+                                                  generation:metadata.remoteDocumentGeneration];
+  if (self.idleCompactionQueue) {
+    [self.documentSnapshots enableIdleWritesWithDelay:self.idleCompactionDelay
+                                  workerDispatchQueue:self.idleCompactionQueue];
+  }
   return YES;
 }
 
@@ -168,9 +397,15 @@ using leveldb::WriteOptions;
 }
 
 /** Opens the database within the given directory. */
-- (nullable DB *)createDBWithDirectory:(NSString *)directory error:(NSError **)error {
+- (nullable DB *)createDBWithDirectory:(NSString *)directory
+                            blockCache:(Cache *)blockCache
+                          filterPolicy:(const FilterPolicy *)filterPolicy
+                                 error:(NSError **)error {
   Options options;
   options.create_if_missing = true;
+  options.block_cache = blockCache;
+  options.filter_policy = filterPolicy;
+  options.write_buffer_size = static_cast<size_t>(self.writeBufferSize);
 
   DB *database;
   Status status = DB::Open(options, [directory UTF8String], &database);
@@ -187,18 +422,79 @@ using leveldb::WriteOptions;
   return database;
 }
 
+/**
+ * Reads every row of the open database with checksum verification so that corruption is found
+ * up front rather than on some later read.
+ */
+- (BOOL)verifyChecksums:(NSError **)error {
+  ReadOptions options = [FSTLevelDB scanReadOptions];
+  options.verify_checksums = true;
+  std::unique_ptr<leveldb::Iterator> it(_ptr->NewIterator(options));
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+  }
+
+  Status status = it->status();
+  if (!status.ok()) {
+    if (error) {
+      NSString *name = [self.directory lastPathComponent];
+      *error = [FSTLevelDB errorWithStatus:status
+                               description:@"Failed to verify database %@ at path %@", name,
+                                           self.directory];
+    }
+    return NO;
+  }
+  return YES;
+}
+
+- (FSTLevelDBTableSizes)approximateTableSizes {
+  DB *db = _ptr.get();
+  FSTLevelDBTableSizes result;
+  result.remoteDocuments = ApproximateSizeOfPrefixes(db, {[FSTLevelDBRemoteDocumentKey keyPrefix]});
+  result.mutations = ApproximateSizeOfPrefixes(
+      db, {[FSTLevelDBMutationKey keyPrefix], [FSTLevelDBDocumentMutationKey keyPrefix],
+           [FSTLevelDBMutationQueueKey keyPrefix]});
+  result.targets = ApproximateSizeOfPrefixes(
+      db, {[FSTLevelDBTargetGlobalKey key], [FSTLevelDBTargetKey keyPrefix],
+           [FSTLevelDBQueryTargetKey keyPrefix]});
+  result.targetDocuments = ApproximateSizeOfPrefixes(
+      db, {[FSTLevelDBTargetDocumentKey keyPrefix], [FSTLevelDBDocumentTargetKey keyPrefix]});
+  return result;
+}
+
+- (int64_t)approximateCacheSizeBytes {
+  FSTLevelDBTableSizes sizes = [self approximateTableSizes];
+  return sizes.remoteDocuments + sizes.targets + sizes.targetDocuments;
+}
+
 #pragma mark - Persistence Factory methods
 
 - (id<FSTMutationQueue>)mutationQueueForUser:(FSTUser *)user {
-  return [FSTLevelDBMutationQueue mutationQueueWithUser:user db:_ptr serializer:self.serializer];
+  return [FSTLevelDBMutationQueue mutationQueueWithUser:user
+                                                 reader:self.reader
+                                             serializer:self.serializer];
 }
 
 - (id<FSTQueryCache>)queryCache {
-  return [[FSTLevelDBQueryCache alloc] initWithDB:_ptr serializer:self.serializer];
+  FSTLevelDBQueryCache *queryCache =
+      [[FSTLevelDBQueryCache alloc] initWithReader:self.reader serializer:self.serializer];
+  // The query cache owns the metadata row holding the remote document generation.
+  self.documentSnapshots.queryCache = queryCache;
+  return queryCache;
 }
 
 - (id<FSTRemoteDocumentCache>)remoteDocumentCache {
-  return [[FSTLevelDBRemoteDocumentCache alloc] initWithDB:_ptr serializer:self.serializer];
+  return [[FSTLevelDBRemoteDocumentCache alloc] initWithReader:self.reader
+                                                     serializer:self.serializer
+                                              documentSnapshots:self.documentSnapshots];
+}
+
+- (id<FSTRemoteDocumentCache>)remoteDocumentCacheSnapshot {
+  // A reader of its own keeps the snapshot pinned (and the DB open) for as long as the cache lives,
+  // and keeps the cache's iterators out of the shared reader's pool. The collection snapshots
+  // reflect the latest state rather than the pinned one, so it doesn't read them.
+  FSTLevelDBReader *reader = [[FSTLevelDBReader alloc] initWithDB:_ptr];
+  [reader beginReadTransaction];
+  return [[FSTLevelDBRemoteDocumentCache alloc] initWithReader:reader serializer:self.serializer];
 }
 
 - (FSTWriteGroup *)startGroupWithAction:(NSString *)action {
@@ -208,19 +504,143 @@ using leveldb::WriteOptions;
 - (void)commitGroup:(FSTWriteGroup *)group {
   [self.writeGroupTracker endGroup:group];
 
-  NSString *description = [group description];
-  FSTLog(@"Committing %@", description);
+  // Describing a group formats every key in it, so only do so if someone will read it.
+  if ([FIRFirestore isLoggingEnabled]) {
+    FSTLog(@"Committing %@", [group description]);
+  }
 
+  auto start = std::chrono::steady_clock::now();
   Status status = [group writeToDB:_ptr];
   if (!status.ok()) {
     FSTFail(@"%@ failed with status: %s, description: %@", group.action, status.ToString().c_str(),
-            description);
+            [group description]);
+  }
+
+  FSTLevelDBCommitMetricsHandler handler = self.commitMetricsHandler;
+  if (handler) {
+    std::chrono::duration<double> latency = std::chrono::steady_clock::now() - start;
+    handler(group.action, group.changeCount, group.byteSize, latency.count());
+  }
+  if (group.durability == FSTWriteDurabilityCoalescedSync) {
+    [self scheduleSync];
+  }
+  [self trackRemovalsInGroup:group];
+  [self.documentSnapshots deferPendingWrites];
+  [self.reader refreshReadTransaction];
+}
+
+/**
+ * Records the ranges of keys the committed group left tombstones in, if there are enough of them
+ * to be worth compacting, and arranges for them to be compacted.
+ */
+- (void)trackRemovalsInGroup:(FSTWriteGroup *)group {
+  const std::vector<std::pair<std::string, std::string>> &requested = [group compactionRanges];
+  if (!requested.empty()) {
+    _pendingCompactions.insert(_pendingCompactions.end(), requested.begin(), requested.end());
+    _pendingCompactionRemovals += group.removalCount;
+  } else if (group.removalCount >= kCompactionThreshold) {
+    // Large removals that don't know their own ranges, like garbage collection, compact the span
+    // of everything they removed.
+    _pendingCompactions.push_back([group removedKeyRange]);
+    _pendingCompactionRemovals += group.removalCount;
+  }
+  if (_pendingCompactions.empty()) {
+    return;
+  }
+
+  if (!self.idleCompactionQueue) {
+    [self compactPendingRanges];
+    return;
+  }
+
+  // Every commit while compactions are pending pushes them back, so that they only run once the
+  // worker queue has gone the whole delay without writing.
+  if (self.idleCompaction.isPending) {
+    [self.idleCompaction rescheduleAfterDelay:self.idleCompactionDelay];
+  } else {
+    __weak FSTLevelDB *weakSelf = self;
+    void (^compact)(void) = ^{
+      [weakSelf compactPendingRanges];
+    };
+    self.idleCompaction =
+        [self.idleCompactionQueue dispatchAfterDelay:self.idleCompactionDelay block:compact];
+  }
+}
+
+- (void)enableIdleCompactionWithDelay:(NSTimeInterval)delay
+                  workerDispatchQueue:(FSTDispatchQueue *)workerDispatchQueue {
+  self.idleCompactionDelay = delay;
+  self.idleCompactionQueue = workerDispatchQueue;
+  [self.documentSnapshots enableIdleWritesWithDelay:delay workerDispatchQueue:workerDispatchQueue];
+}
+
+/**
+ * Compacts the pending ranges in the background. Compaction rewrites the table files overlapping
+ * each range, so it runs on the sync queue rather than the committing one.
+ */
+- (void)compactPendingRanges {
+  if (_pendingCompactions.empty() || !self.isStarted) {
+    return;
   }
+  std::vector<std::pair<std::string, std::string>> ranges =
+      MergeRanges(std::move(_pendingCompactions));
+  _pendingCompactions.clear();
+  FSTLog(@"Compacting %lu key ranges after %d removals", (unsigned long)ranges.size(),
+         _pendingCompactionRemovals);
+  _pendingCompactionRemovals = 0;
+
+  // As with syncs, a pending compaction doesn't keep the database open.
+  std::weak_ptr<DB> weakDB = _ptr;
+  dispatch_async(_syncQueue, ^{
+    std::shared_ptr<DB> db = weakDB.lock();
+    if (!db) {
+      return;
+    }
+    for (const auto &range : ranges) {
+      leveldb::Slice start = range.first;
+      leveldb::Slice end = range.second;
+      db->CompactRange(&start, &end);
+    }
+  });
+}
+
+/** Arranges for a sync of all writes so far, unless one is already scheduled. */
+- (void)scheduleSync {
+  if (_syncScheduled->exchange(true)) {
+    return;
+  }
+
+  // Don't keep the database open just to sync it: shutdown syncs any scheduled writes itself.
+  std::weak_ptr<DB> weakDB = _ptr;
+  std::shared_ptr<std::atomic<bool>> scheduled = _syncScheduled;
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, kCoalescedSyncDelayMs * NSEC_PER_MSEC),
+                 _syncQueue, ^{
+                   std::shared_ptr<DB> db = weakDB.lock();
+                   if (db && scheduled->exchange(false)) {
+                     SyncWrites(db);
+                   }
+                 });
+}
+
+- (void)runReadTransaction:(void (^)(void))block {
+  FSTLevelDBReader *reader = self.reader;
+  [reader beginReadTransaction];
+  block();
+  [reader endReadTransaction];
 }
 
 - (void)shutdown {
   FSTAssert(self.isStarted, @"FSTLevelDB shutdown without start!");
   self.started = NO;
+  [self.idleCompaction cancel];
+  self.idleCompaction = nil;
+  _pendingCompactions.clear();
+  [self.documentSnapshots shutdown];
+  self.documentSnapshots = nil;
+  self.reader = nil;
+  if (_syncScheduled->exchange(false)) {
+    SyncWrites(_ptr);
+  }
   _ptr.reset();
 }
 
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#include "leveldb/slice.h"
+
+@class FSTDispatchQueue;
+@class FSTDocumentKey;
+@class FSTLevelDBQueryCache;
+@class FSTLevelDBReader;
+@class FSTResourcePath;
+@class FSTWriteGroup;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A block passed the LevelDB row key and encoded value of a remote document, along with the key of
+ * the document. Setting `stop` ends the enumeration.
+ */
+typedef void (^FSTLevelDBDocumentRowBlock)(const leveldb::Slice &key,
+                                           const leveldb::Slice &value,
+                                           FSTDocumentKey *documentKey,
+                                           BOOL *stop);
+
+/**
+ * Compacted, memory-mapped snapshots of the remote documents in large collections, which let reads
+ * of those collections skip LevelDB.
+ *
+ * Each snapshot is a file holding the encoded rows of a collection's documents in key order and an
+ * index of their offsets, so the cost of reading a collection from it is bounded by paging in the
+ * mapped file rather than by LevelDB's seeks and block decoding.
+ *
+ * A snapshot is stamped with the remote document generation current when it was written, which is
+ * stored with the query cache metadata, and is only read while that generation is still current.
+ * The first change to a remote document after a snapshot is written advances the generation in the
+ * same write group and deletes every snapshot, so a snapshot can never disagree with LevelDB.
+ * Snapshots of the collections scans found to be large are then rewritten once the worker queue
+ * has gone idle.
+ */
+@interface FSTLevelDBDocumentSnapshots : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Creates the snapshots of the remote documents read by the given reader.
+ *
+ * @param directory The directory holding the snapshot files, created when the first is written.
+ * @param reader The reader of the LevelDB whose remote documents are snapshotted.
+ * @param generation The remote document generation currently stored in the LevelDB.
+ */
+- (instancetype)initWithDirectory:(NSString *)directory
+                           reader:(FSTLevelDBReader *)reader
+                       generation:(int64_t)generation NS_DESIGNATED_INITIALIZER;
+
+/** The current remote document generation. */
+@property(nonatomic, assign, readonly) int64_t generation;
+
+/**
+ * The query cache that stores advances of the generation. If there is none, advances are only
+ * kept in memory and the snapshots written after them won't be read after a restart.
+ */
+@property(nonatomic, weak, nullable) FSTLevelDBQueryCache *queryCache;
+
+/** The number of collection reads that were served by a snapshot. */
+@property(nonatomic, assign, readonly) NSUInteger snapshotReads;
+
+/**
+ * Calls `block` with each row of a current snapshot of the given collection, in key order, if
+ * there is one.
+ *
+ * @param fromKey If set, rows with lower keys are skipped.
+ * @param throughKey If set, the enumeration stops after the row of this key.
+ * @return YES if a snapshot of the collection was enumerated, NO if the caller must read LevelDB.
+ */
+- (BOOL)enumerateRowsInCollection:(FSTResourcePath *)collectionPath
+                          fromKey:(nullable FSTDocumentKey *)fromKey
+                       throughKey:(nullable FSTDocumentKey *)throughKey
+                       usingBlock:(FSTLevelDBDocumentRowBlock)block;
+
+/**
+ * Records that a scan of LevelDB found the given number of rows in a collection. Collections with
+ * enough rows are snapshotted once the worker queue goes idle.
+ */
+- (void)noteScanOfCollection:(FSTResourcePath *)collectionPath rowCount:(NSUInteger)rowCount;
+
+/**
+ * Invalidates every snapshot because the given group changes remote documents. Only the first
+ * change after a snapshot is written advances the generation, so this is cheap to call for each.
+ */
+- (void)invalidateInGroup:(FSTWriteGroup *)group;
+
+/**
+ * Arranges for pending snapshots to be written once the given queue has gone the given delay
+ * without a commit. Without this, they are only written by -writePendingSnapshots.
+ */
+- (void)enableIdleWritesWithDelay:(NSTimeInterval)delay
+              workerDispatchQueue:(FSTDispatchQueue *)workerDispatchQueue;
+
+/** Pushes back the writing of pending snapshots, because the database isn't idle yet. */
+- (void)deferPendingWrites;
+
+/**
+ * Writes snapshots of the large collections that don't have a current one. Must not be called
+ * while a write group that changes remote documents is open.
+ */
+- (void)writePendingSnapshots;
+
+/** Unmaps all snapshots and cancels any pending writes. */
+- (void)shutdown;
+
+@end
+
+NS_ASSUME_NONNULL_END
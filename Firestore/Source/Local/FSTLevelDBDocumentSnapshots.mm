@@ -0,0 +1,497 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "Firestore/Source/Local/FSTLevelDBDocumentSnapshots.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#import "Firestore/Source/Local/FSTLevelDBKey.h"
+#import "Firestore/Source/Local/FSTLevelDBQueryCache.h"
+#import "Firestore/Source/Local/FSTLevelDBReader.h"
+#import "Firestore/Source/Model/FSTDocumentKey.h"
+#import "Firestore/Source/Model/FSTPath.h"
+#import "Firestore/Source/Util/FSTAssert.h"
+#import "Firestore/Source/Util/FSTDispatchQueue.h"
+#import "Firestore/Source/Util/FSTLogger.h"
+
+#include "Firestore/core/src/firebase/firestore/util/string_util.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+using firebase::firestore::util::PrefixSuccessor;
+using leveldb::Slice;
+using leveldb::Status;
+
+namespace {
+
+/** Identifies snapshot files, and files written with a different byte order. */
+const uint32_t kSnapshotMagic = 0x46535344;
+
+/** The version of the snapshot file format. */
+const uint32_t kSnapshotVersion = 1;
+
+/**
+ * The number of documents a collection must hold to be snapshotted. Smaller collections are read
+ * from LevelDB about as quickly as they'd be paged in.
+ */
+const NSUInteger kSnapshotMinimumRows = 500;
+
+/** The maximum number of collections snapshotted at once, bounding the disk space they take. */
+const NSUInteger kMaximumSnapshots = 16;
+
+/**
+ * The fixed-size start of a snapshot file. It's followed by the row key prefix of the collection,
+ * then by the key and value of each row, and then, at `index_offset`, by one IndexEntry per row in
+ * key order.
+ */
+struct Header {
+  uint32_t magic;
+  uint32_t version;
+  int64_t generation;
+  uint64_t row_count;
+  uint64_t index_offset;
+  uint64_t prefix_size;
+};
+
+/** Locates a row of a snapshot: its key starts at `offset`, immediately followed by its value. */
+struct IndexEntry {
+  uint64_t offset;
+  uint32_t key_size;
+  uint32_t value_size;
+};
+
+/** A validated, read-only mapping of a snapshot file. */
+class MappedSnapshot {
+ public:
+  /**
+   * Maps the snapshot file at the given path, returning nullptr if there is none or if it isn't a
+   * well formed snapshot of the collection with the given row key prefix at the given generation.
+   */
+  static std::unique_ptr<MappedSnapshot> Open(const std::string &path,
+                                              const std::string &prefix,
+                                              int64_t generation) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+      close(fd);
+      return nullptr;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the file is closed, or even deleted.
+    close(fd);
+    if (mapping == MAP_FAILED) {
+      return nullptr;
+    }
+
+    std::unique_ptr<MappedSnapshot> snapshot(
+        new MappedSnapshot(static_cast<const char *>(mapping), size));
+    if (!snapshot->IsValid(prefix, generation)) {
+      return nullptr;
+    }
+    return snapshot;
+  }
+
+  ~MappedSnapshot() {
+    munmap(const_cast<char *>(data_), size_);
+  }
+
+  MappedSnapshot(const MappedSnapshot &) = delete;
+  MappedSnapshot &operator=(const MappedSnapshot &) = delete;
+
+  size_t row_count() const {
+    return row_count_;
+  }
+
+  Slice key(size_t row) const {
+    return Slice(data_ + index_[row].offset, index_[row].key_size);
+  }
+
+  Slice value(size_t row) const {
+    const IndexEntry &entry = index_[row];
+    return Slice(data_ + entry.offset + entry.key_size, entry.value_size);
+  }
+
+  /** Returns the first row whose key is not less than the given key. */
+  size_t LowerBound(const Slice &target) const {
+    size_t low = 0;
+    size_t high = row_count_;
+    while (low < high) {
+      size_t middle = low + (high - low) / 2;
+      if (key(middle).compare(target) < 0) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+    return low;
+  }
+
+ private:
+  MappedSnapshot(const char *data, size_t size) : data_(data), size_(size) {
+  }
+
+  /** Checks the header and that every row lies within the file, so reads need no checks. */
+  bool IsValid(const std::string &prefix, int64_t generation) {
+    Header header;
+    memcpy(&header, data_, sizeof(header));
+    if (header.magic != kSnapshotMagic || header.version != kSnapshotVersion ||
+        header.generation != generation || header.prefix_size != prefix.size()) {
+      return false;
+    }
+    uint64_t rows_start = sizeof(Header) + header.prefix_size;
+    if (rows_start > size_ || memcmp(data_ + sizeof(Header), prefix.data(), prefix.size()) != 0) {
+      return false;
+    }
+    if (header.index_offset < rows_start || header.index_offset % alignof(IndexEntry) != 0 ||
+        header.index_offset > size_ ||
+        (size_ - header.index_offset) / sizeof(IndexEntry) != header.row_count ||
+        (size_ - header.index_offset) % sizeof(IndexEntry) != 0) {
+      return false;
+    }
+
+    index_ = reinterpret_cast<const IndexEntry *>(data_ + header.index_offset);
+    row_count_ = static_cast<size_t>(header.row_count);
+    for (size_t row = 0; row < row_count_; row++) {
+      const IndexEntry &entry = index_[row];
+      uint64_t row_size = static_cast<uint64_t>(entry.key_size) + entry.value_size;
+      if (entry.offset < rows_start || entry.offset > header.index_offset ||
+          row_size > header.index_offset - entry.offset) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  const char *data_;
+  size_t size_;
+  const IndexEntry *index_ = nullptr;
+  size_t row_count_ = 0;
+};
+
+/** Returns the name of the snapshot file for the collection with the given row key prefix. */
+NSString *SnapshotFileName(const std::string &prefix) {
+  // FNV-1a. A collision only means two collections can't be snapshotted at once, since the header
+  // records the prefix of the collection the file holds.
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : prefix) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ULL;
+  }
+  return [NSString stringWithFormat:@"%016llx.snapshot", (unsigned long long)hash];
+}
+
+}  // namespace
+
+@interface FSTLevelDBDocumentSnapshots ()
+
+@property(nonatomic, copy, readonly) NSString *directory;
+
+/** The queue on which pending writes wait for the database to go idle, if enabled. */
+@property(nonatomic, strong, nullable) FSTDispatchQueue *idleWriteQueue;
+@property(nonatomic, assign) NSTimeInterval idleWriteDelay;
+
+/** The pending callback that writes the pending snapshots. */
+@property(nonatomic, strong, nullable) FSTDelayedCallback *idleWrite;
+
+@end
+
+@implementation FSTLevelDBDocumentSnapshots {
+  FSTLevelDBReader *_reader;
+
+  // The snapshots mapped so far, by the row key prefix of their collection.
+  std::unordered_map<std::string, std::unique_ptr<MappedSnapshot>> _mapped;
+
+  // The row key prefixes of collections known to have no current snapshot.
+  std::unordered_set<std::string> _missing;
+
+  // Whether a snapshot stamped with the current generation might exist on disk.
+  BOOL _mayHaveSnapshots;
+
+  // The collections deemed large enough to snapshot, and those of them without a current snapshot.
+  NSMutableSet<FSTResourcePath *> *_largeCollections;
+  NSMutableSet<FSTResourcePath *> *_pendingCollections;
+}
+
+- (instancetype)initWithDirectory:(NSString *)directory
+                           reader:(FSTLevelDBReader *)reader
+                       generation:(int64_t)generation {
+  if (self = [super init]) {
+    _directory = [directory copy];
+    _reader = reader;
+    _generation = generation;
+    _mayHaveSnapshots = [[NSFileManager defaultManager] fileExistsAtPath:directory];
+    _largeCollections = [NSMutableSet set];
+    _pendingCollections = [NSMutableSet set];
+  }
+  return self;
+}
+
+- (void)shutdown {
+  [self.idleWrite cancel];
+  self.idleWrite = nil;
+  _mapped.clear();
+  _missing.clear();
+  _reader = nil;
+}
+
+#pragma mark - Reading
+
+- (BOOL)enumerateRowsInCollection:(FSTResourcePath *)collectionPath
+                          fromKey:(nullable FSTDocumentKey *)fromKey
+                       throughKey:(nullable FSTDocumentKey *)throughKey
+                       usingBlock:(FSTLevelDBDocumentRowBlock)block {
+  MappedSnapshot *snapshot = [self snapshotOfCollection:collectionPath];
+  if (!snapshot) {
+    return NO;
+  }
+  _snapshotReads++;
+
+  size_t row = 0;
+  if (fromKey) {
+    row = snapshot->LowerBound([FSTLevelDBRemoteDocumentKey keyWithDocumentKey:fromKey]);
+  }
+  std::string endKey;
+  if (throughKey) {
+    endKey = [FSTLevelDBRemoteDocumentKey keyWithDocumentKey:throughKey];
+  }
+
+  BOOL stop = NO;
+  FSTLevelDBRemoteDocumentKey *currentKey = [[FSTLevelDBRemoteDocumentKey alloc] init];
+  for (; !stop && row < snapshot->row_count(); row++) {
+    Slice key = snapshot->key(row);
+    if (throughKey && key.compare(endKey) > 0) {
+      break;
+    }
+    if (![currentKey decodeKey:key]) {
+      FSTFail(@"Snapshot of collection (%@) holds an invalid row key", collectionPath);
+    }
+    block(key, snapshot->value(row), currentKey.documentKey, &stop);
+  }
+  return YES;
+}
+
+/** Returns the current snapshot of the given collection, mapping it if needed, or null. */
+- (nullable MappedSnapshot *)snapshotOfCollection:(FSTResourcePath *)collectionPath {
+  if (!_mayHaveSnapshots || !_reader) {
+    return nullptr;
+  }
+  std::string prefix = [FSTLevelDBRemoteDocumentKey keyPrefixWithResourcePath:collectionPath];
+  auto found = _mapped.find(prefix);
+  if (found != _mapped.end()) {
+    return found->second.get();
+  }
+  if (_missing.count(prefix) != 0) {
+    return nullptr;
+  }
+
+  NSString *path = [self.directory stringByAppendingPathComponent:SnapshotFileName(prefix)];
+  std::unique_ptr<MappedSnapshot> snapshot =
+      MappedSnapshot::Open([path fileSystemRepresentation], prefix, _generation);
+  if (!snapshot) {
+    _missing.insert(prefix);
+    return nullptr;
+  }
+
+  // Snapshots left by an earlier run are kept up to date like the ones written by this one.
+  [_largeCollections addObject:collectionPath];
+  MappedSnapshot *result = snapshot.get();
+  _mapped.emplace(prefix, std::move(snapshot));
+  return result;
+}
+
+#pragma mark - Invalidation
+
+- (void)noteScanOfCollection:(FSTResourcePath *)collectionPath rowCount:(NSUInteger)rowCount {
+  if (rowCount < kSnapshotMinimumRows || [_largeCollections containsObject:collectionPath] ||
+      _largeCollections.count >= kMaximumSnapshots) {
+    return;
+  }
+  [_largeCollections addObject:collectionPath];
+  [_pendingCollections addObject:collectionPath];
+  [self schedulePendingWrites];
+}
+
+- (void)invalidateInGroup:(FSTWriteGroup *)group {
+  if (!_mayHaveSnapshots) {
+    return;
+  }
+  _mayHaveSnapshots = NO;
+  _generation++;
+  [self.queryCache saveRemoteDocumentGeneration:_generation group:group];
+
+  // The files are deleted before the group commits so that even if the new generation is never
+  // stored, no snapshot can outlive the change.
+  _mapped.clear();
+  _missing.clear();
+  NSError *error;
+  if (![[NSFileManager defaultManager] removeItemAtPath:self.directory error:&error] &&
+      [[NSFileManager defaultManager] fileExistsAtPath:self.directory]) {
+    FSTWarn(@"Failed to delete remote document snapshots at %@: %@", self.directory, error);
+  }
+
+  [_pendingCollections unionSet:_largeCollections];
+  [self schedulePendingWrites];
+}
+
+#pragma mark - Writing
+
+- (void)enableIdleWritesWithDelay:(NSTimeInterval)delay
+              workerDispatchQueue:(FSTDispatchQueue *)workerDispatchQueue {
+  self.idleWriteDelay = delay;
+  self.idleWriteQueue = workerDispatchQueue;
+  [self schedulePendingWrites];
+}
+
+- (void)schedulePendingWrites {
+  if (_pendingCollections.count == 0 || !self.idleWriteQueue || self.idleWrite.isPending) {
+    return;
+  }
+  __weak FSTLevelDBDocumentSnapshots *weakSelf = self;
+  self.idleWrite = [self.idleWriteQueue dispatchAfterDelay:self.idleWriteDelay
+                                                     block:^{
+                                                       [weakSelf writePendingSnapshots];
+                                                     }];
+}
+
+- (void)deferPendingWrites {
+  if (self.idleWrite.isPending) {
+    [self.idleWrite rescheduleAfterDelay:self.idleWriteDelay];
+  }
+}
+
+- (void)writePendingSnapshots {
+  if (_pendingCollections.count == 0 || !_reader) {
+    return;
+  }
+  NSError *error;
+  if (![[NSFileManager defaultManager] createDirectoryAtPath:self.directory
+                                 withIntermediateDirectories:YES
+                                                  attributes:nil
+                                                       error:&error]) {
+    FSTWarn(@"Failed to create remote document snapshot directory %@: %@", self.directory, error);
+    return;
+  }
+  // Snapshots can be rebuilt from LevelDB, so like LevelDB itself they're not backed up.
+  NSURL *directoryURL = [NSURL fileURLWithPath:self.directory];
+  [directoryURL setResourceValue:@YES forKey:NSURLIsExcludedFromBackupKey error:nil];
+
+  for (FSTResourcePath *collectionPath in _pendingCollections) {
+    [self writeSnapshotOfCollection:collectionPath];
+  }
+  [_pendingCollections removeAllObjects];
+  _missing.clear();
+  _mayHaveSnapshots = YES;
+}
+
+/**
+ * Writes the rows of the documents that are immediate children of the given collection to a new
+ * snapshot file, replacing any existing one once it's complete.
+ */
+- (void)writeSnapshotOfCollection:(FSTResourcePath *)collectionPath {
+  std::string prefix = [FSTLevelDBRemoteDocumentKey keyPrefixWithResourcePath:collectionPath];
+  NSString *path = [self.directory stringByAppendingPathComponent:SnapshotFileName(prefix)];
+  std::string finalPath = [path fileSystemRepresentation];
+  std::string tempPath = finalPath + ".tmp";
+
+  FILE *file = fopen(tempPath.c_str(), "wb");
+  if (!file) {
+    FSTWarn(@"Failed to create snapshot of collection (%@): %s", collectionPath, strerror(errno));
+    return;
+  }
+
+  // The header is written last, once the offsets are known, so a file that wasn't completely
+  // written is never valid.
+  Header header{};
+  uint64_t position = sizeof(Header);
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(prefix.data(), 1, prefix.size(), file) == prefix.size();
+  position += prefix.size();
+
+  std::vector<IndexEntry> index;
+  FSTLevelDBIterator it = [_reader scanIterator];
+  it->Seek(prefix);
+  int childLength = collectionPath.length + 1;
+  FSTLevelDBRemoteDocumentKey *currentKey = [[FSTLevelDBRemoteDocumentKey alloc] init];
+  while (ok && it->Valid() && [currentKey decodeKey:it->key()]) {
+    FSTResourcePath *documentPath = currentKey.documentKey.path;
+    if (![collectionPath isPrefixOfPath:documentPath]) {
+      break;
+    }
+    if (documentPath.length > childLength) {
+      FSTResourcePath *child = [collectionPath
+          pathByAppendingSegment:[documentPath segmentAtIndex:collectionPath.length]];
+      it->Seek(PrefixSuccessor([FSTLevelDBRemoteDocumentKey keyPrefixWithResourcePath:child]));
+      continue;
+    }
+
+    Slice key = it->key();
+    Slice value = it->value();
+    index.push_back(IndexEntry{position, static_cast<uint32_t>(key.size()),
+                               static_cast<uint32_t>(value.size())});
+    ok = fwrite(key.data(), 1, key.size(), file) == key.size() &&
+         fwrite(value.data(), 1, value.size(), file) == value.size();
+    position += key.size() + value.size();
+    it->Next();
+  }
+  Status status = it->status();
+  if (!status.ok()) {
+    FSTFail(@"Snapshot of collection (%@) failed with status: %s", collectionPath,
+            status.ToString().c_str());
+  }
+
+  static const char padding[alignof(IndexEntry)] = {};
+  size_t paddingSize = (alignof(IndexEntry) - position % alignof(IndexEntry)) % alignof(IndexEntry);
+  header.magic = kSnapshotMagic;
+  header.version = kSnapshotVersion;
+  header.generation = _generation;
+  header.row_count = index.size();
+  header.index_offset = position + paddingSize;
+  header.prefix_size = prefix.size();
+  ok = ok && fwrite(padding, 1, paddingSize, file) == paddingSize &&
+       fwrite(index.data(), sizeof(IndexEntry), index.size(), file) == index.size() &&
+       fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1 &&
+       fflush(file) == 0 && fsync(fileno(file)) == 0;
+  ok = fclose(file) == 0 && ok;
+
+  if (!ok || rename(tempPath.c_str(), finalPath.c_str()) != 0) {
+    FSTWarn(@"Failed to write snapshot of collection (%@): %s", collectionPath, strerror(errno));
+    unlink(tempPath.c_str());
+    return;
+  }
+  _mapped.erase(prefix);
+  FSTLog(@"Wrote snapshot of %lu documents in collection (%@)", (unsigned long)index.size(),
+         collectionPath);
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2017 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#include <memory>
+#include <string>
+
+#import "Firestore/Source/Model/FSTDocumentKeySet.h"
+#include "leveldb/db.h"
+
+@class FSTDocument;
+@class FSTFieldValue;
+@class FSTLevelDBReader;
+@class FSTQuery;
+@class FSTWriteGroup;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A secondary index over the field values of the documents in a LevelDB remote document cache.
+ *
+ * Every field of every cached document whose value can be encoded in an order-preserving way (null,
+ * boolean, number, timestamp and string values, including those nested in maps) has an entry in
+ * the index_entry table. Queries with equality or range filters can then find candidate documents
+ * by scanning only the matching entries rather than every document in the collection.
+ *
+ * GeoPoint values are indexed by the geo cell containing them instead, so that queries with an
+ * FSTGeoBoundsFilter scan only the few ranges of cells covering their bounding box.
+ *
+ * Index entries are written in the same FSTWriteGroup as the documents themselves. Entries are a
+ * conservative superset: every document matching a filter is found, but callers must still filter
+ * the documents they read.
+ */
+@interface FSTLevelDBFieldIndex : NSObject
+
+/**
+ * Encodes the given value into a string whose byte order matches the Firestore ordering of values
+ * of the same type.
+ *
+ * Values that compare equal encode identically, except that integers and doubles are encoded
+ * through their nearest double. Distinct integers beyond 2^53 may therefore share an encoding, but
+ * the encoding never reverses their order.
+ *
+ * @return YES if the value was encoded into `result`, NO if values of this type aren't indexed.
+ */
++ (BOOL)encodeIndexValue:(FSTFieldValue *)value into:(std::string *)result;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/** Creates a field index stored in the given LevelDB. */
+- (instancetype)initWithDB:(std::shared_ptr<leveldb::DB>)db;
+
+/** Creates a field index reading through the given shared reader. */
+- (instancetype)initWithReader:(FSTLevelDBReader *)reader NS_DESIGNATED_INITIALIZER;
+
+/** Adds index entries for all the indexed fields of the given document. */
+- (void)addEntriesForDocument:(FSTDocument *)document group:(FSTWriteGroup *)group;
+
+/** Removes the index entries previously added for the given document. */
+- (void)removeEntriesForDocument:(FSTDocument *)document group:(FSTWriteGroup *)group;
+
+/**
+ * Finds the keys of the documents that could match the given collection query by scanning the
+ * index entries for one of its filters.
+ *
+ * @return A superset of the keys of the matching documents, or nil if none of the filters of the
+ *     query can be served by the index.
+ */
+- (nullable FSTDocumentKeySet *)documentKeysMatchingQuery:(FSTQuery *)query;
+
+@end
+
+NS_ASSUME_NONNULL_END
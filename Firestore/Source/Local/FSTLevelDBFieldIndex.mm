@@ -0,0 +1,508 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "Firestore/Source/Local/FSTLevelDBFieldIndex.h"
+
+#import "FIRGeoPoint.h"
+
+#include <leveldb/db.h>
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Core/FSTTimestamp.h"
+#import "Firestore/Source/Local/FSTLevelDBKey.h"
+#import "Firestore/Source/Local/FSTLevelDBReader.h"
+#import "Firestore/Source/Local/FSTWriteGroup.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTDocumentKey.h"
+#import "Firestore/Source/Model/FSTFieldValue.h"
+#import "Firestore/Source/Model/FSTPath.h"
+#import "Firestore/Source/Util/FSTAssert.h"
+
+#include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+using firebase::firestore::util::MakeStringView;
+using firebase::firestore::util::OrderedCode;
+using leveldb::DB;
+using leveldb::Iterator;
+using leveldb::ReadOptions;
+using leveldb::Status;
+
+namespace {
+
+/** A field path and the encoding of its value, as stored in an index entry key. */
+using IndexedField = std::pair<std::string, std::string>;
+
+/**
+ * A range of encoded values of a single field, both ends inclusive. Every value matching the
+ * filters the range was built from lies within it.
+ */
+struct IndexRange {
+  FSTFieldPath *field;
+  std::string lower;
+  std::string upper;
+};
+
+void AppendBigEndian(std::string *dest, uint64_t value, int bytes) {
+  for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+    dest->push_back(static_cast<char>((value >> shift) & 0xff));
+  }
+}
+
+/**
+ * Appends a double such that the byte order of the encodings matches Firestore's numeric order:
+ * NaN sorts before all other numbers and -0.0 equals 0.0.
+ */
+void AppendDouble(std::string *dest, double value) {
+  if (isnan(value)) {
+    AppendBigEndian(dest, 0, 8);
+    return;
+  }
+  if (value == 0) {
+    value = 0;
+  }
+
+  const uint64_t kSignBit = 1ULL << 63;
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  bits = (bits & kSignBit) ? ~bits : bits | kSignBit;
+  AppendBigEndian(dest, bits, 8);
+}
+
+/** Returns the encoding of the lowest possible value of the given type. */
+std::string LowestValueOfType(FSTTypeOrder typeOrder) {
+  return std::string(1, static_cast<char>(typeOrder));
+}
+
+/** Returns an encoding greater than that of any value of the given type. */
+std::string PastHighestValueOfType(FSTTypeOrder typeOrder) {
+  return std::string(1, static_cast<char>(typeOrder + 1));
+}
+
+/** The number of bits each coordinate of a GeoPoint is quantized to in its geo cell. */
+const int kGeoCoordinateBits = 32;
+
+/** The most cells scanned for one bounding box, which bounds the number of index seeks. */
+const uint64_t kMaxCoveringCells = 16;
+
+/** A range of geo cells, both ends inclusive. */
+using GeoCellRange = std::pair<uint64_t, uint64_t>;
+
+/** Maps a coordinate in [-limit, limit] onto the full range of a uint32_t, preserving order. */
+uint32_t QuantizeCoordinate(double value, double limit) {
+  double scaled = (value + limit) / (2 * limit) * 4294967296.0;
+  if (!(scaled > 0)) {
+    return 0;
+  }
+  return scaled >= 4294967295.0 ? UINT32_MAX : static_cast<uint32_t>(scaled);
+}
+
+/** Spreads the bits of the given value out to the even bits of the result. */
+uint64_t SpreadBits(uint64_t value) {
+  value = (value | (value << 16)) & 0x0000FFFF0000FFFFULL;
+  value = (value | (value << 8)) & 0x00FF00FF00FF00FFULL;
+  value = (value | (value << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  value = (value | (value << 2)) & 0x3333333333333333ULL;
+  value = (value | (value << 1)) & 0x5555555555555555ULL;
+  return value;
+}
+
+/**
+ * Interleaves quantized latitude and longitude into a geo cell (a Z-order curve, as geohashes
+ * are). Points that share a cell prefix lie in the same rectangle, so a rectangle is a single
+ * range of cells.
+ */
+uint64_t GeoCell(uint32_t latitude, uint32_t longitude) {
+  return (SpreadBits(latitude) << 1) | SpreadBits(longitude);
+}
+
+/** Returns the index encoding of the given geo cell. */
+std::string EncodeGeoCell(uint64_t cell) {
+  std::string result = LowestValueOfType(FSTTypeOrderGeoPoint);
+  OrderedCode::WriteNumIncreasing(&result, cell);
+  return result;
+}
+
+/**
+ * Appends to `ranges` the ranges of geo cells covering the given rectangle of quantized
+ * coordinates, at the finest level that needs no more than `maxCells` cells.
+ */
+void CoverRectangle(uint32_t latLo,
+                    uint32_t latHi,
+                    uint32_t lngLo,
+                    uint32_t lngHi,
+                    uint64_t maxCells,
+                    std::vector<GeoCellRange> *ranges) {
+  // Coarser levels take fewer cells: at the coarsest, the rectangle is within 2 by 2 cells.
+  int shift = 0;
+  for (; shift < kGeoCoordinateBits - 1; shift++) {
+    uint64_t rows = (latHi >> shift) - (latLo >> shift) + 1;
+    uint64_t columns = (lngHi >> shift) - (lngLo >> shift) + 1;
+    if (rows * columns <= maxCells) {
+      break;
+    }
+  }
+
+  // A cell at this level fixes all but the low 2 * shift bits.
+  uint64_t span = (1ULL << (2 * shift)) - 1;
+  for (uint64_t lat = latLo >> shift; lat <= (latHi >> shift); lat++) {
+    for (uint64_t lng = lngLo >> shift; lng <= (lngHi >> shift); lng++) {
+      uint64_t first = GeoCell(static_cast<uint32_t>(lat), static_cast<uint32_t>(lng))
+                       << (2 * shift);
+      ranges->emplace_back(first, first | span);
+    }
+  }
+}
+
+/**
+ * Returns the sorted, disjoint ranges of geo cells that together contain every point in the
+ * filter's bounding box.
+ */
+std::vector<GeoCellRange> CoverBounds(FSTGeoBoundsFilter *filter) {
+  uint32_t latLo = QuantizeCoordinate(filter.southWest.latitude, 90);
+  uint32_t latHi = QuantizeCoordinate(filter.northEast.latitude, 90);
+  uint32_t lngLo = QuantizeCoordinate(filter.southWest.longitude, 180);
+  uint32_t lngHi = QuantizeCoordinate(filter.northEast.longitude, 180);
+
+  std::vector<GeoCellRange> ranges;
+  if (latLo > latHi) {
+    return ranges;
+  }
+  if (filter.southWest.longitude <= filter.northEast.longitude) {
+    CoverRectangle(latLo, latHi, lngLo, lngHi, kMaxCoveringCells, &ranges);
+  } else {
+    // The box spans the antimeridian, so cover the parts on either side of it.
+    CoverRectangle(latLo, latHi, lngLo, UINT32_MAX, kMaxCoveringCells / 2, &ranges);
+    CoverRectangle(latLo, latHi, 0, lngHi, kMaxCoveringCells / 2, &ranges);
+  }
+
+  // Cells adjacent along the curve merge into one scan.
+  std::sort(ranges.begin(), ranges.end());
+  std::vector<GeoCellRange> merged;
+  for (const GeoCellRange &range : ranges) {
+    if (!merged.empty() && merged.back().second != UINT64_MAX &&
+        range.first <= merged.back().second + 1) {
+      merged.back().second = std::max(merged.back().second, range.second);
+    } else if (merged.empty() || merged.back().second != UINT64_MAX) {
+      merged.push_back(range);
+    }
+  }
+  return merged;
+}
+
+/** Appends an IndexedField for each indexed leaf of the given object to `result`. */
+void CollectIndexedFields(FSTObjectValue *object,
+                          FSTFieldPath *parent,
+                          std::vector<IndexedField> *result) {
+  [object.internalValue
+      enumerateKeysAndObjectsUsingBlock:^(NSString *key, FSTFieldValue *value, BOOL *stop) {
+        FSTFieldPath *path = [parent pathByAppendingSegment:key];
+        if ([value isKindOfClass:[FSTObjectValue class]]) {
+          CollectIndexedFields((FSTObjectValue *)value, path, result);
+          return;
+        }
+
+        std::string encoded;
+        if ([FSTLevelDBFieldIndex encodeIndexValue:value into:&encoded]) {
+          result->emplace_back(std::string(MakeStringView([path canonicalString])), encoded);
+        } else if ([value isKindOfClass:[FSTGeoPointValue class]]) {
+          // GeoPoints are indexed by the cell containing them, which orders them by location
+          // rather than by value, so no relation filter ever scans these entries.
+          FIRGeoPoint *point = [(FSTGeoPointValue *)value value];
+          uint64_t cell = GeoCell(QuantizeCoordinate(point.latitude, 90),
+                                  QuantizeCoordinate(point.longitude, 180));
+          result->emplace_back(std::string(MakeStringView([path canonicalString])),
+                               EncodeGeoCell(cell));
+        }
+      }];
+}
+
+std::vector<IndexedField> IndexedFields(FSTDocument *document) {
+  std::vector<IndexedField> result;
+  CollectIndexedFields(document.data, [FSTFieldPath pathWithSegments:@[]], &result);
+  return result;
+}
+
+/**
+ * Builds the range of values that can match the given filter, returning NO if the filter can't be
+ * served by the index.
+ */
+BOOL RangeForFilter(id<FSTFilter> filter, IndexRange *range) {
+  FSTFieldValue *value = nil;
+  FSTRelationFilterOperator op = FSTRelationFilterOperatorEqual;
+  if ([filter isKindOfClass:[FSTRelationFilter class]]) {
+    FSTRelationFilter *relationFilter = (FSTRelationFilter *)filter;
+    value = relationFilter.value;
+    op = relationFilter.filterOperator;
+  } else if ([filter isKindOfClass:[FSTNullFilter class]]) {
+    value = [FSTNullValue nullValue];
+  } else if ([filter isKindOfClass:[FSTNanFilter class]]) {
+    value = [FSTDoubleValue nanValue];
+  } else {
+    return NO;
+  }
+
+  std::string encoded;
+  if ([filter.field isKeyFieldPath]) {
+    return NO;
+  }
+  if (![FSTLevelDBFieldIndex encodeIndexValue:value into:&encoded]) {
+    return NO;
+  }
+
+  range->field = filter.field;
+  switch (op) {
+    case FSTRelationFilterOperatorLessThan:
+    case FSTRelationFilterOperatorLessThanOrEqual:
+      range->lower = LowestValueOfType(value.typeOrder);
+      range->upper = encoded;
+      break;
+    case FSTRelationFilterOperatorEqual:
+      range->lower = encoded;
+      range->upper = encoded;
+      break;
+    case FSTRelationFilterOperatorGreaterThanOrEqual:
+    case FSTRelationFilterOperatorGreaterThan:
+      range->lower = encoded;
+      range->upper = PastHighestValueOfType(value.typeOrder);
+      break;
+  }
+  return YES;
+}
+
+/**
+ * Builds the range of values of the query's first order-by field that its startAt and endAt
+ * bounds allow, returning NO if the query has no such bounds or they can't be encoded.
+ *
+ * @param bounded Set to whether the range has an upper end. Without one the range extends past the
+ *     indexed types: documents whose values sort after all strings (e.g. blobs) match the bounds
+ *     but have no index entries, so the range can only narrow a filter on the same field.
+ */
+BOOL RangeForBounds(FSTQuery *query, IndexRange *range, BOOL *bounded) {
+  FSTSortOrder *sortOrder = query.sortOrders.firstObject;
+  if ([sortOrder.field isKeyFieldPath]) {
+    return NO;
+  }
+  FSTBound *lowerBound = sortOrder.isAscending ? query.startAt : query.endAt;
+  FSTBound *upperBound = sortOrder.isAscending ? query.endAt : query.startAt;
+  if (!lowerBound && !upperBound) {
+    return NO;
+  }
+
+  // Bounds are inclusive here whether or not they're before or after their position, which only
+  // makes the range a superset.
+  range->field = sortOrder.field;
+  range->lower = LowestValueOfType(FSTTypeOrderNull);
+  if (lowerBound &&
+      ![FSTLevelDBFieldIndex encodeIndexValue:lowerBound.position.firstObject into:&range->lower]) {
+    return NO;
+  }
+  *bounded = upperBound != nil;
+  range->upper = PastHighestValueOfType(FSTTypeOrderString);
+  if (upperBound &&
+      ![FSTLevelDBFieldIndex encodeIndexValue:upperBound.position.firstObject into:&range->upper]) {
+    // Values of unindexed types match, so the bound can't narrow anything.
+    *bounded = NO;
+  }
+  return YES;
+}
+
+/**
+ * Picks the narrowest range the index can scan for the given query: an equality filter if there is
+ * one, otherwise the intersection of the inequality filters and the cursor bounds.
+ */
+BOOL RangeForQuery(FSTQuery *query, IndexRange *result) {
+  BOOL found = NO;
+  for (id<FSTFilter> filter in query.filters) {
+    IndexRange range;
+    if (!RangeForFilter(filter, &range)) {
+      continue;
+    }
+    if (range.lower == range.upper) {
+      *result = range;
+      return YES;
+    }
+
+    if (!found) {
+      *result = range;
+      found = YES;
+    } else if ([range.field isEqual:result->field]) {
+      if (range.lower > result->lower) {
+        result->lower = range.lower;
+      }
+      if (range.upper < result->upper) {
+        result->upper = range.upper;
+      }
+    }
+  }
+
+  IndexRange boundsRange;
+  BOOL bounded = NO;
+  if (RangeForBounds(query, &boundsRange, &bounded)) {
+    if (found && [boundsRange.field isEqual:result->field]) {
+      // The filter already limits the values to indexed types.
+      if (boundsRange.lower > result->lower) {
+        result->lower = boundsRange.lower;
+      }
+      if (bounded && boundsRange.upper < result->upper) {
+        result->upper = boundsRange.upper;
+      }
+    } else if (!found && bounded) {
+      *result = boundsRange;
+      found = YES;
+    }
+  }
+  return found;
+}
+
+}  // namespace
+
+@implementation FSTLevelDBFieldIndex {
+  // The reader is shared with all cooperating LevelDB-related objects.
+  FSTLevelDBReader *_reader;
+}
+
++ (BOOL)encodeIndexValue:(FSTFieldValue *)value into:(std::string *)result {
+  result->clear();
+  if ([value isKindOfClass:[FSTNullValue class]]) {
+    *result = LowestValueOfType(FSTTypeOrderNull);
+
+  } else if ([value isKindOfClass:[FSTBooleanValue class]]) {
+    *result = LowestValueOfType(FSTTypeOrderBoolean);
+    result->push_back([((FSTBooleanValue *)value).value boolValue] ? 1 : 0);
+
+  } else if ([value isKindOfClass:[FSTIntegerValue class]]) {
+    *result = LowestValueOfType(FSTTypeOrderNumber);
+    AppendDouble(result, static_cast<double>(((FSTIntegerValue *)value).internalValue));
+
+  } else if ([value isKindOfClass:[FSTDoubleValue class]]) {
+    *result = LowestValueOfType(FSTTypeOrderNumber);
+    AppendDouble(result, ((FSTDoubleValue *)value).internalValue);
+
+  } else if ([value isKindOfClass:[FSTTimestampValue class]]) {
+    FSTTimestamp *timestamp = ((FSTTimestampValue *)value).internalValue;
+    *result = LowestValueOfType(FSTTypeOrderTimestamp);
+    AppendBigEndian(result, static_cast<uint64_t>(timestamp.seconds) ^ (1ULL << 63), 8);
+    AppendBigEndian(result, static_cast<uint32_t>(timestamp.nanos), 4);
+
+  } else if ([value isKindOfClass:[FSTStringValue class]]) {
+    // Strings compare by their UTF-8 encoding.
+    *result = LowestValueOfType(FSTTypeOrderString);
+    absl::string_view bytes = MakeStringView(((FSTStringValue *)value).value);
+    result->append(bytes.data(), bytes.size());
+
+  } else {
+    return NO;
+  }
+  return YES;
+}
+
+- (instancetype)initWithDB:(std::shared_ptr<DB>)db {
+  return [self initWithReader:[[FSTLevelDBReader alloc] initWithDB:db]];
+}
+
+- (instancetype)initWithReader:(FSTLevelDBReader *)reader {
+  if (self = [super init]) {
+    _reader = reader;
+  }
+  return self;
+}
+
+- (void)addEntriesForDocument:(FSTDocument *)document group:(FSTWriteGroup *)group {
+  for (const IndexedField &field : IndexedFields(document)) {
+    std::string key = [FSTLevelDBIndexEntryKey keyWithDocumentKey:document.key
+                                                        fieldPath:field.first
+                                                       indexValue:field.second];
+    [group setData:"" forKey:key];
+  }
+}
+
+- (void)removeEntriesForDocument:(FSTDocument *)document group:(FSTWriteGroup *)group {
+  for (const IndexedField &field : IndexedFields(document)) {
+    std::string key = [FSTLevelDBIndexEntryKey keyWithDocumentKey:document.key
+                                                        fieldPath:field.first
+                                                       indexValue:field.second];
+    [group removeMessageForKey:key];
+  }
+}
+
+- (nullable FSTDocumentKeySet *)documentKeysMatchingQuery:(FSTQuery *)query {
+  // A bounding box is usually far more selective than the other filters of the query.
+  for (id<FSTFilter> filter in query.filters) {
+    if ([filter isKindOfClass:[FSTGeoBoundsFilter class]]) {
+      FSTDocumentKeySet *result = [FSTDocumentKeySet keySet];
+      for (const GeoCellRange &cells : CoverBounds((FSTGeoBoundsFilter *)filter)) {
+        IndexRange range{filter.field, EncodeGeoCell(cells.first), EncodeGeoCell(cells.second)};
+        result = [self addDocumentKeysInRange:range ofQuery:query toSet:result];
+      }
+      return result;
+    }
+  }
+
+  IndexRange range;
+  if (!RangeForQuery(query, &range)) {
+    return nil;
+  }
+
+  FSTDocumentKeySet *result = [FSTDocumentKeySet keySet];
+  if (range.lower > range.upper) {
+    // Contradictory filters, e.g. on values of different types.
+    return result;
+  }
+  return [self addDocumentKeysInRange:range ofQuery:query toSet:result];
+}
+
+/** Returns the given set plus the keys of the documents with an entry within the range. */
+- (FSTDocumentKeySet *)addDocumentKeysInRange:(const IndexRange &)range
+                                      ofQuery:(FSTQuery *)query
+                                        toSet:(FSTDocumentKeySet *)result {
+  NSString *fieldPath = [range.field canonicalString];
+  std::string prefix = [FSTLevelDBIndexEntryKey keyPrefixWithCollectionPath:query.path
+                                                                  fieldPath:fieldPath];
+  FSTLevelDBIterator it = [_reader iterator];
+  it->Seek([FSTLevelDBIndexEntryKey keyPrefixWithCollectionPath:query.path
+                                                      fieldPath:fieldPath
+                                                     indexValue:range.lower]);
+
+  FSTLevelDBIndexEntryKey *rowKey = [[FSTLevelDBIndexEntryKey alloc] init];
+  for (; it->Valid() && it->key().starts_with(prefix) && [rowKey decodeKey:it->key()];
+       it->Next()) {
+    if (rowKey.indexValue > range.upper) {
+      break;
+    }
+    result = [result setByAddingObject:rowKey.documentKey];
+  }
+
+  Status status = it->status();
+  if (!status.ok()) {
+    FSTFail(@"Find index entries for query (%@) failed with status: %s", query,
+            status.ToString().c_str());
+  }
+  return result;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
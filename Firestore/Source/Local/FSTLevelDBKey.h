@@ -66,6 +66,13 @@ NS_ASSUME_NONNULL_BEGIN
 // remote_documents:
 //   - tableName: string = "remote_document"
 //   - path: FSTResourcePath
+//
+// index_entries:
+//   - tableName: string = "index_entry"
+//   - collectionPath: FSTResourcePath
+//   - fieldPath: string
+//   - indexValue: string
+//   - documentID: string
 
 /** Helpers for any LevelDB key. */
 @interface FSTLevelDBKey : NSObject
@@ -86,6 +93,14 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+/** A key to a singleton row recording the progress of a migration that runs in batches. */
+@interface FSTLevelDBMigrationProgressKey : NSObject
+
+/** Returns the key pointing to the singleton migration progress row. */
++ (std::string)key;
+
+@end
+
 /** A key in the mutations table. */
 @interface FSTLevelDBMutationKey : NSObject
 
@@ -344,4 +359,56 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+/**
+ * A key in the field index table, which maps the values of fields of remote documents back to the
+ * documents containing them. Within a collection and field, keys sort by index value and then by
+ * document ID.
+ */
+@interface FSTLevelDBIndexEntryKey : NSObject
+
+/**
+ * Creates a key that contains just the index entries table prefix and points just before the
+ * first index entry.
+ */
++ (std::string)keyPrefix;
+
+/**
+ * Creates a key prefix that points just before the first entry for the given field of documents
+ * in the given collection.
+ */
++ (std::string)keyPrefixWithCollectionPath:(FSTResourcePath *)collectionPath
+                                 fieldPath:(Firestore::StringView)fieldPath;
+
+/**
+ * Creates a key prefix that points just before the first entry for the given value of the given
+ * field of documents in the given collection.
+ */
++ (std::string)keyPrefixWithCollectionPath:(FSTResourcePath *)collectionPath
+                                 fieldPath:(Firestore::StringView)fieldPath
+                                indexValue:(Firestore::StringView)indexValue;
+
+/**
+ * Creates a complete key that points to the entry for the given value of the given field of the
+ * given document.
+ */
++ (std::string)keyWithDocumentKey:(FSTDocumentKey *)documentKey
+                        fieldPath:(Firestore::StringView)fieldPath
+                       indexValue:(Firestore::StringView)indexValue;
+
+/**
+ * Decodes the contents of an index entry key into properties on this instance.
+ *
+ * @return YES if the key successfully decoded, NO otherwise. If NO is returned, the properties of
+ *     the receiver are in an undefined state until the next call to -decodeKey:.
+ */
+- (BOOL)decodeKey:(Firestore::StringView)key;
+
+/** The encoded value of the field, as encoded in the key. */
+@property(nonatomic, assign, readonly) const std::string &indexValue;
+
+/** The document containing the field, as encoded in the key. */
+@property(nonatomic, strong, readonly, nullable) FSTDocumentKey *documentKey;
+
+@end
+
 NS_ASSUME_NONNULL_END
@@ -20,10 +20,22 @@
 
 #include "leveldb/db.h"
 
+@class FSTLocalSerializer;
+
 NS_ASSUME_NONNULL_BEGIN
 
 typedef int32_t FSTLevelDBSchemaVersion;
 
+/**
+ * A block told how far a migration has got.
+ *
+ * @param version The schema version being migrated to.
+ * @param documentsProcessed The number of documents the migration has processed so far in this
+ *     run.
+ */
+typedef void (^FSTLevelDBMigrationProgressBlock)(FSTLevelDBSchemaVersion version,
+                                                 NSUInteger documentsProcessed);
+
 @interface FSTLevelDBMigrations : NSObject
 
 /**
@@ -33,8 +45,30 @@ typedef int32_t FSTLevelDBSchemaVersion;
 
 /**
  * Runs any migrations needed to bring the given database up to the current schema version
+ *
+ * @param serializer The serializer with which to decode documents already stored in the database.
+ */
++ (void)runMigrationsOnDB:(std::shared_ptr<leveldb::DB>)db
+               serializer:(FSTLocalSerializer *)serializer;
+
+/**
+ * Runs any migrations needed to bring the given database up to the current schema version.
+ *
+ * Each migration is committed separately, together with the new schema version. Migrations that
+ * rewrite every document, such as building an index, are committed in batches of
+ * documentsPerBatch documents. Each batch also records how far the migration has got, so if the
+ * process is interrupted the next run resumes after the last committed batch instead of starting
+ * over. This means a large cache never has to fit in a single write.
+ *
+ * @param serializer The serializer with which to decode documents already stored in the database.
+ * @param documentsPerBatch The maximum number of documents processed in one write. Must be
+ *     positive.
+ * @param progress A block called after each batch is committed, or nil.
  */
-+ (void)runMigrationsOnDB:(std::shared_ptr<leveldb::DB>)db;
++ (void)runMigrationsOnDB:(std::shared_ptr<leveldb::DB>)db
+               serializer:(FSTLocalSerializer *)serializer
+        documentsPerBatch:(NSUInteger)documentsPerBatch
+                 progress:(nullable FSTLevelDBMigrationProgressBlock)progress;
 
 @end
 
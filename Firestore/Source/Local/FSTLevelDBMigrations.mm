@@ -23,38 +23,109 @@
 #import "Firestore/Source/Local/FSTLevelDB.h"
 #import "Firestore/Source/Local/FSTLevelDBKey.h"
 #import "Firestore/Source/Local/FSTLevelDBQueryCache.h"
+#import "Firestore/Source/Local/FSTLevelDBRemoteDocumentCache.h"
 #import "Firestore/Source/Local/FSTWriteGroup.h"
+#import "Firestore/Source/Util/FSTAssert.h"
+#import "Firestore/Source/Util/FSTLogger.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
 // Current version of the schema defined in this file.
-static FSTLevelDBSchemaVersion kSchemaVersion = 1;
+static FSTLevelDBSchemaVersion kSchemaVersion = 3;
+
+// The default number of documents a migration processes in one write.
+static const NSUInteger kDefaultDocumentsPerBatch = 1000;
 
 using leveldb::DB;
 using leveldb::Status;
 using leveldb::Slice;
 using leveldb::WriteOptions;
 
+/**
+ * Save the given version number as the current version of the schema of the database.
+ * @param version The version to save
+ * @param group The transaction in which to save the new version number
+ */
+static void SaveVersion(FSTLevelDBSchemaVersion version, FSTWriteGroup *group) {
+  std::string key = [FSTLevelDBVersionKey key];
+  std::string version_string = std::to_string(version);
+  [group setData:version_string forKey:key];
+}
+
+/** Commits the given group, failing if it can't be written. */
+static void CommitGroup(std::shared_ptr<DB> db, FSTWriteGroup *group) {
+  Status status = [group writeToDB:db];
+  if (!status.ok()) {
+    FSTCFail(@"Migration (%@) failed with status: %s", group.action, status.ToString().c_str());
+  }
+}
+
 /**
  * Ensures that the global singleton target metadata row exists in LevelDB.
  * @param db The db in which to require the row.
+ * @param version The schema version to save along with the row.
  */
-static void EnsureTargetGlobal(std::shared_ptr<DB> db, FSTWriteGroup *group) {
+static void EnsureTargetGlobal(std::shared_ptr<DB> db, FSTLevelDBSchemaVersion version) {
+  FSTWriteGroup *group = [FSTWriteGroup groupWithAction:@"Add target global"];
   FSTPBTargetGlobal *targetGlobal = [FSTLevelDBQueryCache readTargetMetadataFromDB:db];
   if (!targetGlobal) {
     [group setMessage:[FSTPBTargetGlobal message] forKey:[FSTLevelDBTargetGlobalKey key]];
   }
+  SaveVersion(version, group);
+  CommitGroup(db, group);
 }
 
 /**
- * Save the given version number as the current version of the schema of the database.
- * @param version The version to save
- * @param group The transaction in which to save the new version number
+ * Populates the field index for the remote documents already in the database, one batch of
+ * documents per write. Each write also records the last document it indexed, so a run that is
+ * interrupted resumes after that document instead of starting over.
+ *
+ * @param db The db containing the documents.
+ * @param serializer The serializer with which to decode the documents.
+ * @param version The schema version to save once all the documents are indexed.
  */
-static void SaveVersion(FSTLevelDBSchemaVersion version, FSTWriteGroup *group) {
-  std::string key = [FSTLevelDBVersionKey key];
-  std::string version_string = std::to_string(version);
-  [group setData:version_string forKey:key];
+static void BuildFieldIndex(std::shared_ptr<DB> db,
+                            FSTLocalSerializer *serializer,
+                            FSTLevelDBSchemaVersion version,
+                            NSUInteger documentsPerBatch,
+                            FSTLevelDBMigrationProgressBlock _Nullable progress) {
+  FSTLevelDBRemoteDocumentCache *remoteDocuments =
+      [[FSTLevelDBRemoteDocumentCache alloc] initWithDB:db serializer:serializer];
+
+  // Resume after the last row indexed by an interrupted run, if any.
+  std::string progressKey = [FSTLevelDBMigrationProgressKey key];
+  std::string lastRow;
+  Status status = db->Get([FSTLevelDB standardReadOptions], progressKey, &lastRow);
+  if (!status.ok() && !status.IsNotFound()) {
+    FSTCFail(@"Reading migration progress failed with status: %s", status.ToString().c_str());
+  }
+  if (!lastRow.empty()) {
+    FSTLog(@"Resuming field index migration after %@", [FSTLevelDBKey descriptionForKey:lastRow]);
+  }
+
+  NSUInteger processed = 0;
+  for (;;) {
+    FSTWriteGroup *group = [FSTWriteGroup groupWithAction:@"Build field index"];
+    NSUInteger count = 0;
+    lastRow = [remoteDocuments addIndexEntriesForDocumentsAfterRow:lastRow
+                                                             limit:documentsPerBatch
+                                                             count:&count
+                                                             group:group];
+    processed += count;
+    if (lastRow.empty()) {
+      [group removeMessageForKey:progressKey];
+      SaveVersion(version, group);
+      CommitGroup(db, group);
+      break;
+    }
+
+    [group setData:lastRow forKey:progressKey];
+    CommitGroup(db, group);
+    if (progress) {
+      progress(version, processed);
+    }
+  }
+  [remoteDocuments shutdown];
 }
 
 @implementation FSTLevelDBMigrations
@@ -70,24 +141,39 @@ static void SaveVersion(FSTLevelDBSchemaVersion version, FSTWriteGroup *group) {
   }
 }
 
-+ (void)runMigrationsOnDB:(std::shared_ptr<DB>)db {
-  FSTWriteGroup *group = [FSTWriteGroup groupWithAction:@"Migrations"];
++ (void)runMigrationsOnDB:(std::shared_ptr<DB>)db serializer:(FSTLocalSerializer *)serializer {
+  [self runMigrationsOnDB:db
+               serializer:serializer
+        documentsPerBatch:kDefaultDocumentsPerBatch
+                 progress:nil];
+}
+
++ (void)runMigrationsOnDB:(std::shared_ptr<DB>)db
+               serializer:(FSTLocalSerializer *)serializer
+        documentsPerBatch:(NSUInteger)documentsPerBatch
+                 progress:(nullable FSTLevelDBMigrationProgressBlock)progress {
+  FSTAssert(documentsPerBatch > 0, @"Migrations must process at least one document per batch");
   FSTLevelDBSchemaVersion currentVersion = [self schemaVersionForDB:db];
   // Each case in this switch statement intentionally falls through. This lets us
   // start at the current schema version and apply any migrations that have not yet
   // been applied, to bring us up to current, as defined by the kSchemaVersion constant.
+  // Every migration saves the version it migrates to, so an interrupted run picks up
+  // with the first migration that didn't finish.
   switch (currentVersion) {
     case 0:
-      EnsureTargetGlobal(db, group);
+      EnsureTargetGlobal(db, 1);
+      // Fallthrough
+    case 1:
+    case 2:
+      // Version 3 added geo cell entries for GeoPoint fields. Building the whole index again
+      // brings either version up to date, since rewriting an existing entry changes nothing.
+      BuildFieldIndex(db, serializer, 3, documentsPerBatch, progress);
       // Fallthrough
     default:
-      if (currentVersion < kSchemaVersion) {
-        SaveVersion(kSchemaVersion, group);
-      }
-  }
-  if (!group.isEmpty) {
-    [group writeToDB:db];
+      break;
   }
+  FSTAssert([self schemaVersionForDB:db] >= kSchemaVersion,
+            @"Migrations must bring the schema up to version %d", kSchemaVersion);
 }
 
 @end
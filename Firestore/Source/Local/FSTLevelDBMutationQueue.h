@@ -22,6 +22,7 @@
 #include "leveldb/db.h"
 
 @class FSTLevelDB;
+@class FSTLevelDBReader;
 @class FSTLocalSerializer;
 @class FSTUser;
 @protocol FSTGarbageCollector;
@@ -46,6 +47,16 @@ NS_ASSUME_NONNULL_BEGIN
                                    db:(std::shared_ptr<leveldb::DB>)db
                            serializer:(FSTLocalSerializer *)serializer;
 
+/**
+ * Creates a new mutation queue for the given user, reading through the given shared reader.
+ *
+ * @param user The user for which to create a mutation queue.
+ * @param reader The reader of the LevelDB in which to create the queue.
+ */
++ (instancetype)mutationQueueWithUser:(FSTUser *)user
+                               reader:(FSTLevelDBReader *)reader
+                           serializer:(FSTLocalSerializer *)serializer;
+
 /**
  * Returns one larger than the largest batch ID that has been stored. If there are no mutations
  * returns 0. Note that batch IDs are global.
@@ -26,6 +26,7 @@
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
 #import "Firestore/Source/Local/FSTLevelDBKey.h"
+#import "Firestore/Source/Local/FSTLevelDBReader.h"
 #import "Firestore/Source/Local/FSTLocalSerializer.h"
 #import "Firestore/Source/Local/FSTWriteGroup.h"
 #import "Firestore/Source/Model/FSTDocumentKey.h"
@@ -50,7 +51,7 @@ using leveldb::WriteOptions;
 @interface FSTLevelDBMutationQueue ()
 
 - (instancetype)initWithUserID:(NSString *)userID
-                            db:(std::shared_ptr<DB>)db
+                        reader:(FSTLevelDBReader *)reader
                     serializer:(FSTLocalSerializer *)serializer NS_DESIGNATED_INITIALIZER;
 
 /** The normalized userID (e.g. nil UID => @"" userID) used in our LevelDB keys. */
@@ -72,44 +73,42 @@ using leveldb::WriteOptions;
 
 @end
 
-/**
- * Returns a standard set of read options.
- *
- * For now this is paranoid, but perhaps disable that in production builds.
- */
-static ReadOptions StandardReadOptions() {
-  ReadOptions options;
-  options.verify_checksums = true;
-  return options;
-}
-
 @implementation FSTLevelDBMutationQueue {
-  // The DB pointer is shared with all cooperating LevelDB-related objects.
-  std::shared_ptr<DB> _db;
+  // The reader is shared with all cooperating LevelDB-related objects.
+  FSTLevelDBReader *_reader;
 }
 
 + (instancetype)mutationQueueWithUser:(FSTUser *)user
                                    db:(std::shared_ptr<DB>)db
                            serializer:(FSTLocalSerializer *)serializer {
+  return [self mutationQueueWithUser:user
+                              reader:[[FSTLevelDBReader alloc] initWithDB:db]
+                          serializer:serializer];
+}
+
++ (instancetype)mutationQueueWithUser:(FSTUser *)user
+                               reader:(FSTLevelDBReader *)reader
+                           serializer:(FSTLocalSerializer *)serializer {
   FSTAssert(![user.UID isEqual:@""], @"UserID must not be an empty string.");
   NSString *userID = user.isUnauthenticated ? @"" : user.UID;
 
-  return [[FSTLevelDBMutationQueue alloc] initWithUserID:userID db:db serializer:serializer];
+  return
+      [[FSTLevelDBMutationQueue alloc] initWithUserID:userID reader:reader serializer:serializer];
 }
 
 - (instancetype)initWithUserID:(NSString *)userID
-                            db:(std::shared_ptr<DB>)db
+                        reader:(FSTLevelDBReader *)reader
                     serializer:(FSTLocalSerializer *)serializer {
   if (self = [super init]) {
     _userID = userID;
-    _db = db;
+    _reader = reader;
     _serializer = serializer;
   }
   return self;
 }
 
 - (void)startWithGroup:(FSTWriteGroup *)group {
-  FSTBatchID nextBatchID = [FSTLevelDBMutationQueue loadNextBatchIDFromDB:_db];
+  FSTBatchID nextBatchID = [FSTLevelDBMutationQueue loadNextBatchIDFromDB:_reader.db];
 
   // On restart, nextBatchId may end up lower than lastAcknowledgedBatchId since it's computed from
   // the queue contents, and there may be no mutations in the queue. In this case, we need to reset
@@ -138,11 +137,11 @@ static ReadOptions StandardReadOptions() {
 }
 
 - (void)shutdown {
-  _db.reset();
+  _reader = nil;
 }
 
 + (FSTBatchID)loadNextBatchIDFromDB:(std::shared_ptr<DB>)db {
-  std::unique_ptr<Iterator> it(db->NewIterator(StandardReadOptions()));
+  std::unique_ptr<Iterator> it(db->NewIterator([FSTLevelDB scanReadOptions]));
 
   auto tableKey = [FSTLevelDBMutationKey keyPrefix];
 
@@ -205,7 +204,7 @@ static ReadOptions StandardReadOptions() {
 - (BOOL)isEmpty {
   std::string userKey = [FSTLevelDBMutationKey keyPrefixWithUserID:self.userID];
 
-  std::unique_ptr<Iterator> it(_db->NewIterator(StandardReadOptions()));
+  FSTLevelDBIterator it = [_reader iterator];
   it->Seek(userKey);
 
   BOOL empty = YES;
@@ -256,7 +255,7 @@ static ReadOptions StandardReadOptions() {
 
 - (nullable FSTPBMutationQueue *)metadataForKey:(const std::string &)key {
   std::string value;
-  Status status = _db->Get(StandardReadOptions(), key, &value);
+  Status status = [_reader getValue:&value forKey:key];
   if (status.ok()) {
     return [self parsedMetadata:value];
   } else if (status.IsNotFound()) {
@@ -296,11 +295,28 @@ static ReadOptions StandardReadOptions() {
   return batch;
 }
 
+- (FSTMutationBatch *)replaceMutationsOfLastBatch:(FSTMutationBatch *)batch
+                                    withMutations:(NSArray<FSTMutation *> *)mutations
+                                            group:(FSTWriteGroup *)group {
+  FSTAssert(![self nextMutationBatchAfterBatchID:batch.batchID],
+            @"Only the last batch in the queue can be replaced");
+
+  FSTMutationBatch *replacement = [[FSTMutationBatch alloc] initWithBatchID:batch.batchID
+                                                             localWriteTime:batch.localWriteTime
+                                                                  mutations:mutations];
+  // The batch affects the same documents, so its document index rows stay as they are.
+  FSTAssert([[replacement keys] isEqual:[batch keys]],
+            @"Replacement mutations must affect the same documents");
+  [group setMessage:[self.serializer encodedMutationBatch:replacement]
+             forKey:[self mutationKeyForBatch:replacement]];
+  return replacement;
+}
+
 - (nullable FSTMutationBatch *)lookupMutationBatch:(FSTBatchID)batchID {
   std::string key = [self mutationKeyForBatchID:batchID];
 
   std::string value;
-  Status status = _db->Get(StandardReadOptions(), key, &value);
+  Status status = [_reader getValue:&value forKey:key];
   if (!status.ok()) {
     if (status.IsNotFound()) {
       return nil;
@@ -314,7 +330,7 @@ static ReadOptions StandardReadOptions() {
 
 - (nullable FSTMutationBatch *)nextMutationBatchAfterBatchID:(FSTBatchID)batchID {
   std::string key = [self mutationKeyForBatchID:batchID + 1];
-  std::unique_ptr<Iterator> it(_db->NewIterator(StandardReadOptions()));
+  FSTLevelDBIterator it = [_reader iterator];
   it->Seek(key);
 
   Status status = it->status();
@@ -342,7 +358,7 @@ static ReadOptions StandardReadOptions() {
   std::string userKey = [FSTLevelDBMutationKey keyPrefixWithUserID:self.userID];
   const char *userID = [self.userID UTF8String];
 
-  std::unique_ptr<Iterator> it(_db->NewIterator(StandardReadOptions()));
+  FSTLevelDBIterator it = [_reader iterator];
   it->Seek(userKey);
 
   NSMutableArray *result = [NSMutableArray array];
@@ -375,14 +391,14 @@ static ReadOptions StandardReadOptions() {
   // Scan the document-mutation index starting with a prefix starting with the given documentKey.
   std::string indexPrefix =
       [FSTLevelDBDocumentMutationKey keyPrefixWithUserID:self.userID resourcePath:documentKey.path];
-  std::unique_ptr<Iterator> indexIterator(_db->NewIterator(StandardReadOptions()));
+  FSTLevelDBIterator indexIterator = [_reader iterator];
   indexIterator->Seek(indexPrefix);
 
   // Simultaneously scan the mutation queue. This works because each (key, batchID) pair is unique
   // and ordered, so when scanning a table prefixed by exactly key, all the batchIDs encountered
   // will be unique and in order.
   std::string mutationsPrefix = [FSTLevelDBMutationKey keyPrefixWithUserID:userID];
-  std::unique_ptr<Iterator> mutationIterator(_db->NewIterator(StandardReadOptions()));
+  FSTLevelDBIterator mutationIterator = [_reader iterator];
 
   NSMutableArray *result = [NSMutableArray array];
   FSTLevelDBDocumentMutationKey *rowKey = [[FSTLevelDBDocumentMutationKey alloc] init];
@@ -421,60 +437,31 @@ static ReadOptions StandardReadOptions() {
 }
 
 - (NSArray<FSTMutationBatch *> *)allMutationBatchesAffectingQuery:(FSTQuery *)query {
-  FSTAssert(![query isDocumentQuery], @"Document queries shouldn't go down this path");
   NSString *userID = self.userID;
 
-  FSTResourcePath *queryPath = query.path;
-  int immediateChildrenPathLength = queryPath.length + 1;
-
-  // TODO(mcg): Actually implement a single-collection query
-  //
-  // This is actually executing an ancestor query, traversing the whole subtree below the
-  // collection which can be horrifically inefficient for some structures. The right way to
-  // solve this is to implement the full value index, but that's not in the cards in the near
-  // future so this is the best we can do for the moment.
-  //
   // Since we don't yet index the actual properties in the mutations, our current approach is to
   // just return all mutation batches that affect documents in the collection being queried.
   //
   // Unlike allMutationBatchesAffectingDocumentKey, this iteration will scan the document-mutation
   // index for more than a single document so the associated batchIDs will be neither necessarily
   // unique nor in order. This means an efficient simultaneous scan isn't possible.
-  std::string indexPrefix =
-      [FSTLevelDBDocumentMutationKey keyPrefixWithUserID:self.userID resourcePath:queryPath];
-  std::unique_ptr<Iterator> indexIterator(_db->NewIterator(StandardReadOptions()));
-  indexIterator->Seek(indexPrefix);
-
-  NSMutableArray *result = [NSMutableArray array];
-  FSTLevelDBDocumentMutationKey *rowKey = [[FSTLevelDBDocumentMutationKey alloc] init];
-
+  //
   // Collect up unique batchIDs encountered during a scan of the index. Use a set<FSTBatchID> to
   // accumulate batch IDs so they can be traversed in order in a scan of the main table.
   //
   // This method is faster than performing lookups of the keys with _db->Get and keeping a hash of
   // batchIDs that have already been looked up. The performance difference is minor for small
   // numbers of keys but > 30% faster for larger numbers of keys.
-  std::set<FSTBatchID> uniqueBatchIds;
-  for (; indexIterator->Valid(); indexIterator->Next()) {
-    Slice indexKey = indexIterator->key();
-
-    if (!indexKey.starts_with(indexPrefix) || ![rowKey decodeKey:indexKey]) {
-      break;
-    }
-
-    // Rows with document keys more than one segment longer than the query path can't be matches.
-    // For example, a query on 'rooms' can't match the document /rooms/abc/messages/xyx.
-    // TODO(mcg): we'll need a different scanner when we implement ancestor queries.
-    if (rowKey.documentKey.path.length != immediateChildrenPathLength) {
-      continue;
-    }
-
-    uniqueBatchIds.insert(rowKey.batchID);
-  }
+  __block std::set<FSTBatchID> uniqueBatchIds;
+  [self enumerateIndexRowsInCollectionOfQuery:query
+                                   usingBlock:^(FSTLevelDBDocumentMutationKey *rowKey) {
+                                     uniqueBatchIds.insert(rowKey.batchID);
+                                   }];
 
   // Given an ordered set of unique batchIDs perform a skipping scan over the main table to find
   // the mutation batches.
-  std::unique_ptr<Iterator> mutationIterator(_db->NewIterator(StandardReadOptions()));
+  NSMutableArray *result = [NSMutableArray array];
+  FSTLevelDBIterator mutationIterator = [_reader iterator];
 
   for (FSTBatchID batchID : uniqueBatchIds) {
     std::string mutationKey = [FSTLevelDBMutationKey keyWithUserID:userID batchID:batchID];
@@ -495,30 +482,127 @@ static ReadOptions StandardReadOptions() {
   return result;
 }
 
+- (FSTDocumentKeySet *)mutatedDocumentKeysAffectingQuery:(FSTQuery *)query {
+  // A document appears once per batch that mutates it, but its rows are adjacent.
+  __block FSTDocumentKeySet *result = [FSTDocumentKeySet keySet];
+  __block FSTDocumentKey *_Nullable lastKey = nil;
+  [self enumerateIndexRowsInCollectionOfQuery:query
+                                   usingBlock:^(FSTLevelDBDocumentMutationKey *rowKey) {
+                                     if (![rowKey.documentKey isEqual:lastKey]) {
+                                       lastKey = rowKey.documentKey;
+                                       result = [result setByAddingObject:lastKey];
+                                     }
+                                   }];
+  return result;
+}
+
+/**
+ * Calls the block with each document-mutation index row of the documents directly in the query's
+ * collection, skipping the rows of documents in subcollections.
+ */
+- (void)enumerateIndexRowsInCollectionOfQuery:(FSTQuery *)query
+                                   usingBlock:
+                                       (void (^)(FSTLevelDBDocumentMutationKey *rowKey))block {
+  FSTAssert(![query isDocumentQuery], @"Document queries shouldn't go down this path");
+  NSString *userID = self.userID;
+
+  FSTResourcePath *queryPath = query.path;
+  int immediateChildrenPathLength = queryPath.length + 1;
+
+  std::string indexPrefix =
+      [FSTLevelDBDocumentMutationKey keyPrefixWithUserID:userID resourcePath:queryPath];
+  FSTLevelDBIterator indexIterator = [_reader iterator];
+  indexIterator->Seek(indexPrefix);
+
+  FSTLevelDBDocumentMutationKey *rowKey = [[FSTLevelDBDocumentMutationKey alloc] init];
+  while (indexIterator->Valid()) {
+    Slice indexKey = indexIterator->key();
+
+    if (!indexKey.starts_with(indexPrefix) || ![rowKey decodeKey:indexKey]) {
+      break;
+    }
+
+    // Rows with document keys more than one segment longer than the query path can't be matches.
+    // For example, a query on 'rooms' can't match the document /rooms/abc/messages/xyx.
+    //
+    // A document's index rows sort before the rows of any documents nested below it, so once the
+    // scan descends into a subcollection, seek past the rest of that child's subtree.
+    // TODO(mcg): we'll need a different scanner when we implement ancestor queries.
+    FSTResourcePath *path = rowKey.documentKey.path;
+    if (path.length != immediateChildrenPathLength) {
+      FSTResourcePath *child =
+          [queryPath pathByAppendingSegment:[path segmentAtIndex:queryPath.length]];
+      indexIterator->Seek(firebase::firestore::util::PrefixSuccessor(
+          [FSTLevelDBDocumentMutationKey keyPrefixWithUserID:userID resourcePath:child]));
+      continue;
+    }
+
+    block(rowKey);
+    indexIterator->Next();
+  }
+
+  Status status = indexIterator->status();
+  if (!status.ok()) {
+    FSTFail(@"Find document-mutation index rows for query (%@) failed with status: %s", query,
+            status.ToString().c_str());
+  }
+}
+
 - (NSArray<FSTMutationBatch *> *)allMutationBatches {
+  NSMutableArray *result = [NSMutableArray array];
+  [self enumerateMutationBatchesUsingBlock:^(FSTMutationBatch *batch, BOOL *stop) {
+    [result addObject:batch];
+  }];
+  return result;
+}
+
+- (void)enumerateMutationBatchesUsingBlock:(void (^)(FSTMutationBatch *batch, BOOL *stop))block {
   std::string userKey = [FSTLevelDBMutationKey keyPrefixWithUserID:self.userID];
 
-  std::unique_ptr<Iterator> it(_db->NewIterator(StandardReadOptions()));
+  FSTLevelDBIterator it = [_reader iterator];
   it->Seek(userKey);
 
-  NSMutableArray *result = [NSMutableArray array];
-  for (; it->Valid() && it->key().starts_with(userKey); it->Next()) {
-    [result addObject:[self decodedMutationBatch:it->value()]];
+  BOOL stop = NO;
+  for (; !stop && it->Valid() && it->key().starts_with(userKey); it->Next()) {
+    // Release each batch the block doesn't keep before decoding the next.
+    @autoreleasepool {
+      block([self decodedMutationBatch:it->value()], &stop);
+    }
   }
 
   Status status = it->status();
   if (!status.ok()) {
     FSTFail(@"Find all mutation batches failed with status: %s", status.ToString().c_str());
   }
+}
 
-  return result;
+- (FSTDocumentKeySet *)allMutatedDocumentKeys {
+  std::string indexPrefix = [FSTLevelDBDocumentMutationKey keyPrefixWithUserID:self.userID];
+
+  FSTLevelDBIterator it = [_reader iterator];
+  it->Seek(indexPrefix);
+
+  // Each document appears once per batch that mutates it, so the set takes care of duplicates.
+  NSMutableSet<FSTDocumentKey *> *keys = [NSMutableSet set];
+  FSTLevelDBDocumentMutationKey *rowKey = [[FSTLevelDBDocumentMutationKey alloc] init];
+  for (; it->Valid() && it->key().starts_with(indexPrefix) && [rowKey decodeKey:it->key()];
+       it->Next()) {
+    [keys addObject:rowKey.documentKey];
+  }
+
+  Status status = it->status();
+  if (!status.ok()) {
+    FSTFail(@"Find all mutated document keys failed with status: %s", status.ToString().c_str());
+  }
+
+  return [FSTDocumentKeySet keySetWithKeys:keys];
 }
 
 - (void)removeMutationBatches:(NSArray<FSTMutationBatch *> *)batches group:(FSTWriteGroup *)group {
   NSString *userID = self.userID;
   id<FSTGarbageCollector> garbageCollector = self.garbageCollector;
 
-  std::unique_ptr<Iterator> checkIterator(_db->NewIterator(StandardReadOptions()));
+  FSTLevelDBIterator checkIterator = [_reader iterator];
 
   for (FSTMutationBatch *batch in batches) {
     FSTBatchID batchID = batch.batchID;
@@ -552,7 +636,7 @@ static ReadOptions StandardReadOptions() {
 
   // Verify that there are no entries in the document-mutation index if the queue is empty.
   std::string indexPrefix = [FSTLevelDBDocumentMutationKey keyPrefixWithUserID:self.userID];
-  std::unique_ptr<Iterator> indexIterator(_db->NewIterator(StandardReadOptions()));
+  FSTLevelDBIterator indexIterator = [_reader scanIterator];
   indexIterator->Seek(indexPrefix);
 
   NSMutableArray<NSString *> *danglingMutationReferences = [NSMutableArray array];
@@ -614,7 +698,7 @@ static ReadOptions StandardReadOptions() {
 - (BOOL)containsKey:(FSTDocumentKey *)documentKey {
   std::string indexPrefix =
       [FSTLevelDBDocumentMutationKey keyPrefixWithUserID:self.userID resourcePath:documentKey.path];
-  std::unique_ptr<Iterator> indexIterator(_db->NewIterator(StandardReadOptions()));
+  FSTLevelDBIterator indexIterator = [_reader iterator];
   indexIterator->Seek(indexPrefix);
 
   if (indexIterator->Valid()) {
@@ -21,8 +21,10 @@
 #import "Firestore/Source/Local/FSTQueryCache.h"
 #include "leveldb/db.h"
 
+@class FSTLevelDBReader;
 @class FSTLocalSerializer;
 @class FSTPBTargetGlobal;
+@class FSTWriteGroup;
 @protocol FSTGarbageCollector;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -46,7 +48,21 @@ NS_ASSUME_NONNULL_BEGIN
  * @param db The LevelDB in which to create the cache.
  */
 - (instancetype)initWithDB:(std::shared_ptr<leveldb::DB>)db
-                serializer:(FSTLocalSerializer *)serializer NS_DESIGNATED_INITIALIZER;
+                serializer:(FSTLocalSerializer *)serializer;
+
+/**
+ * Creates a new query cache reading through the given shared reader.
+ *
+ * @param reader The reader of the LevelDB in which to create the cache.
+ */
+- (instancetype)initWithReader:(FSTLevelDBReader *)reader
+                    serializer:(FSTLocalSerializer *)serializer NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Stores a new generation of the remote document cache's contents in the metadata, invalidating
+ * the snapshots of the cache written at earlier generations.
+ */
+- (void)saveRemoteDocumentGeneration:(int64_t)generation group:(FSTWriteGroup *)group;
 
 @end
 
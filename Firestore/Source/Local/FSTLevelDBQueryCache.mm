@@ -19,20 +19,34 @@
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
 #include <string>
+#include <vector>
 
 #import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Core/FSTSnapshotVersion.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
 #import "Firestore/Source/Local/FSTLevelDBKey.h"
+#import "Firestore/Source/Local/FSTLevelDBReader.h"
 #import "Firestore/Source/Local/FSTLocalSerializer.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
 #import "Firestore/Source/Local/FSTWriteGroup.h"
 #import "Firestore/Source/Model/FSTDocumentKey.h"
 #import "Firestore/Source/Util/FSTAssert.h"
 
+#include "Firestore/core/src/firebase/firestore/util/string_util.h"
+
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ * The number of rows a target must have for removing all of them to be followed by a compaction
+ * of the rows' key ranges. Smaller removals leave few enough tombstones that they don't slow down
+ * scans noticeably before LevelDB's own compactions clear them.
+ */
+static const size_t kCompactionThreshold = 1000;
+
 using Firestore::StringView;
+using firebase::firestore::util::ImmediateSuccessor;
+using firebase::firestore::util::PrefixSuccessor;
 using leveldb::DB;
 using leveldb::Iterator;
 using leveldb::ReadOptions;
@@ -47,11 +61,17 @@ using leveldb::WriteOptions;
 
 @property(nonatomic, strong, readonly) FSTLocalSerializer *serializer;
 
+/**
+ * A write-through cached copy of the query data of every target, keyed by query. It's loaded by the
+ * first lookup, after which looking up a query doesn't need to scan or decode any rows.
+ */
+@property(nonatomic, strong, nullable) NSMutableDictionary<FSTQuery *, FSTQueryData *> *queries;
+
 @end
 
 @implementation FSTLevelDBQueryCache {
-  // The DB pointer is shared with all cooperating LevelDB-related objects.
-  std::shared_ptr<DB> _db;
+  // The reader is shared with all cooperating LevelDB-related objects.
+  FSTLevelDBReader *_reader;
 
   /**
    * The last received snapshot version. This is part of `metadata` but we store it separately to
@@ -84,16 +104,21 @@ using leveldb::WriteOptions;
 }
 
 - (instancetype)initWithDB:(std::shared_ptr<DB>)db serializer:(FSTLocalSerializer *)serializer {
+  FSTAssert(db, @"db must not be NULL");
+  return [self initWithReader:[[FSTLevelDBReader alloc] initWithDB:db] serializer:serializer];
+}
+
+- (instancetype)initWithReader:(FSTLevelDBReader *)reader
+                    serializer:(FSTLocalSerializer *)serializer {
   if (self = [super init]) {
-    FSTAssert(db, @"db must not be NULL");
-    _db = db;
+    _reader = reader;
     _serializer = serializer;
   }
   return self;
 }
 
 - (void)start {
-  FSTPBTargetGlobal *metadata = [FSTLevelDBQueryCache readTargetMetadataFromDB:_db];
+  FSTPBTargetGlobal *metadata = [FSTLevelDBQueryCache readTargetMetadataFromDB:_reader.db];
   FSTAssert(
       metadata != nil,
       @"Found nil metadata, expected schema to be at version 0 which ensures metadata existence");
@@ -112,19 +137,47 @@ using leveldb::WriteOptions;
   return self.metadata.highestListenSequenceNumber;
 }
 
+- (void)reserveTargetIDsThrough:(FSTTargetID)targetID group:(FSTWriteGroup *)group {
+  FSTPBTargetGlobal *metadata = self.metadata;
+  if (targetID > metadata.highestTargetId) {
+    metadata.highestTargetId = targetID;
+    [group setMessage:metadata forKey:[FSTLevelDBTargetGlobalKey key]];
+  }
+}
+
+- (void)reserveListenSequenceNumbersThrough:(FSTListenSequenceNumber)sequenceNumber
+                                      group:(FSTWriteGroup *)group {
+  FSTPBTargetGlobal *metadata = self.metadata;
+  if (sequenceNumber > metadata.highestListenSequenceNumber) {
+    metadata.highestListenSequenceNumber = sequenceNumber;
+    [group setMessage:metadata forKey:[FSTLevelDBTargetGlobalKey key]];
+  }
+}
+
+- (void)saveRemoteDocumentGeneration:(int64_t)generation group:(FSTWriteGroup *)group {
+  FSTAssert(self.metadata, @"saveRemoteDocumentGeneration: called before start");
+  self.metadata.remoteDocumentGeneration = generation;
+  [group setMessage:self.metadata forKey:[FSTLevelDBTargetGlobalKey key]];
+}
+
 - (FSTSnapshotVersion *)lastRemoteSnapshotVersion {
   return _lastRemoteSnapshotVersion;
 }
 
 - (void)setLastRemoteSnapshotVersion:(FSTSnapshotVersion *)snapshotVersion
                                group:(FSTWriteGroup *)group {
+  // Most remote events don't move the global snapshot version forward, so skip rewriting it then.
+  if (_lastRemoteSnapshotVersion && _lastRemoteSnapshotVersion.value == snapshotVersion.value) {
+    return;
+  }
   _lastRemoteSnapshotVersion = snapshotVersion;
   self.metadata.lastRemoteSnapshotVersion = [self.serializer encodedVersion:snapshotVersion];
   [group setMessage:self.metadata forKey:[FSTLevelDBTargetGlobalKey key]];
 }
 
 - (void)shutdown {
-  _db.reset();
+  _reader = nil;
+  self.queries = nil;
 }
 
 - (void)addQueryData:(FSTQueryData *)queryData group:(FSTWriteGroup *)group {
@@ -153,6 +206,9 @@ using leveldb::WriteOptions;
   if (saveMetadata) {
     [group setMessage:metadata forKey:[FSTLevelDBTargetGlobalKey key]];
   }
+
+  // Queries are only cached once loaded; until then there's nothing to keep up to date.
+  self.queries[queryData.query] = queryData;
 }
 
 - (void)removeQueryData:(FSTQueryData *)queryData group:(FSTWriteGroup *)group {
@@ -166,6 +222,8 @@ using leveldb::WriteOptions;
   std::string indexKey =
       [FSTLevelDBQueryTargetKey keyWithCanonicalID:queryData.query.canonicalID targetID:targetID];
   [group removeMessageForKey:indexKey];
+
+  [self.queries removeObjectForKey:queryData.query];
 }
 
 /**
@@ -186,56 +244,25 @@ using leveldb::WriteOptions;
 }
 
 - (nullable FSTQueryData *)queryDataForQuery:(FSTQuery *)query {
-  // Scan the query-target index starting with a prefix starting with the given query's canonicalID.
-  // Note that this is a scan rather than a get because canonicalIDs are not required to be unique
-  // per target.
-  Slice canonicalID = StringView(query.canonicalID);
-  std::unique_ptr<Iterator> indexItererator(_db->NewIterator([FSTLevelDB standardReadOptions]));
-  std::string indexPrefix = [FSTLevelDBQueryTargetKey keyPrefixWithCanonicalID:canonicalID];
-  indexItererator->Seek(indexPrefix);
-
-  // Simultaneously scan the targets table. This works because each (canonicalID, targetID) pair is
-  // unique and ordered, so when scanning a table prefixed by exactly one canonicalID, all the
-  // targetIDs will be unique and in order.
-  std::string targetPrefix = [FSTLevelDBTargetKey keyPrefix];
-  std::unique_ptr<Iterator> targetIterator(_db->NewIterator([FSTLevelDB standardReadOptions]));
-
-  FSTLevelDBQueryTargetKey *rowKey = [[FSTLevelDBQueryTargetKey alloc] init];
-  for (; indexItererator->Valid(); indexItererator->Next()) {
-    Slice indexKey = indexItererator->key();
-
-    // Only consider rows matching exactly the specific canonicalID of interest.
-    if (!indexKey.starts_with(indexPrefix) || ![rowKey decodeKey:indexKey] ||
-        canonicalID != rowKey.canonicalID) {
-      // End of this canonicalID's possible targets.
-      break;
-    }
+  if (!self.queries) {
+    NSMutableDictionary<FSTQuery *, FSTQueryData *> *queries = [NSMutableDictionary dictionary];
+    [self enumerateQueryDataUsingBlock:^(FSTQueryData *queryData, BOOL *stop) {
+      queries[queryData.query] = queryData;
+    }];
+    self.queries = queries;
+  }
+  return self.queries[query];
+}
 
-    // Each row is a unique combination of canonicalID and targetID, so this foreign key reference
-    // can only occur once.
-    std::string targetKey = [FSTLevelDBTargetKey keyWithTargetID:rowKey.targetID];
-    targetIterator->Seek(targetKey);
-    if (!targetIterator->Valid() || targetIterator->key() != targetKey) {
-      NSString *foundKeyDescription = @"the end of the table";
-      if (targetIterator->Valid()) {
-        foundKeyDescription = [FSTLevelDBKey descriptionForKey:targetIterator->key()];
-      }
-      FSTFail(
-          @"Dangling query-target reference found: "
-          @"%@ points to %@; seeking there found %@",
-          [FSTLevelDBKey descriptionForKey:indexKey], [FSTLevelDBKey descriptionForKey:targetKey],
-          foundKeyDescription);
-    }
+- (void)enumerateQueryDataUsingBlock:(void (^)(FSTQueryData *queryData, BOOL *stop))block {
+  std::string targetPrefix = [FSTLevelDBTargetKey keyPrefix];
+  FSTLevelDBIterator it = [_reader iterator];
+  it->Seek(targetPrefix);
 
-    // Finally after finding a potential match, check that the query is actually equal to the
-    // requested query.
-    FSTQueryData *target = [self decodedTargetWithSlice:targetIterator->value()];
-    if ([target.query isEqual:query]) {
-      return target;
-    }
+  BOOL stop = NO;
+  for (; !stop && it->Valid() && it->key().starts_with(targetPrefix); it->Next()) {
+    block([self decodedTargetWithSlice:it->value()], &stop);
   }
-
-  return nil;
 }
 
 #pragma mark Matching Key tracking
@@ -270,9 +297,13 @@ using leveldb::WriteOptions;
 
 - (void)removeMatchingKeysForTargetID:(FSTTargetID)targetID group:(FSTWriteGroup *)group {
   std::string indexPrefix = [FSTLevelDBTargetDocumentKey keyPrefixWithTargetID:targetID];
-  std::unique_ptr<Iterator> indexIterator(_db->NewIterator([FSTLevelDB standardReadOptions]));
+  FSTLevelDBIterator indexIterator = [_reader iterator];
   indexIterator->Seek(indexPrefix);
 
+  // The rows of the target are contiguous and so are removed as they're found. Their inverses are
+  // spread across the documents' rows but sort in the same order, so they're collected in the same
+  // pass and removed afterwards, keeping the removals in the group in two sorted runs.
+  std::vector<std::string> inverseKeys;
   FSTLevelDBTargetDocumentKey *rowKey = [[FSTLevelDBTargetDocumentKey alloc] init];
   for (; indexIterator->Valid(); indexIterator->Next()) {
     Slice indexKey = indexIterator->key();
@@ -283,17 +314,27 @@ using leveldb::WriteOptions;
     }
     FSTDocumentKey *documentKey = rowKey.documentKey;
 
-    // Delete both index rows
     [group removeMessageForKey:indexKey];
-    [group removeMessageForKey:[FSTLevelDBDocumentTargetKey keyWithDocumentKey:documentKey
-                                                                      targetID:targetID]];
+    inverseKeys.push_back([FSTLevelDBDocumentTargetKey keyWithDocumentKey:documentKey
+                                                                 targetID:targetID]);
     [self.garbageCollector addPotentialGarbageKey:documentKey];
   }
+
+  for (const std::string &inverseKey : inverseKeys) {
+    [group removeMessageForKey:inverseKey];
+  }
+
+  // Don't leave the tombstones of a large target in the way of later scans of either index.
+  if (inverseKeys.size() >= kCompactionThreshold) {
+    [group compactRangeFromKey:indexPrefix toKey:PrefixSuccessor(indexPrefix)];
+    [group compactRangeFromKey:inverseKeys.front()
+                         toKey:ImmediateSuccessor(inverseKeys.back())];
+  }
 }
 
 - (FSTDocumentKeySet *)matchingKeysForTargetID:(FSTTargetID)targetID {
   std::string indexPrefix = [FSTLevelDBTargetDocumentKey keyPrefixWithTargetID:targetID];
-  std::unique_ptr<Iterator> indexIterator(_db->NewIterator([FSTLevelDB standardReadOptions]));
+  FSTLevelDBIterator indexIterator = [_reader iterator];
   indexIterator->Seek(indexPrefix);
 
   FSTDocumentKeySet *result = [FSTDocumentKeySet keySet];
@@ -316,7 +357,7 @@ using leveldb::WriteOptions;
 
 - (BOOL)containsKey:(FSTDocumentKey *)key {
   std::string indexPrefix = [FSTLevelDBDocumentTargetKey keyPrefixWithResourcePath:key.path];
-  std::unique_ptr<Iterator> indexIterator(_db->NewIterator([FSTLevelDB standardReadOptions]));
+  FSTLevelDBIterator indexIterator = [_reader iterator];
   indexIterator->Seek(indexPrefix);
 
   if (indexIterator->Valid()) {
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "leveldb/db.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * An iterator obtained from an FSTLevelDBReader. Destroying it hands the underlying LevelDB
+ * iterator back to the reader, which may reuse it for a later read in the same read transaction.
+ */
+using FSTLevelDBIterator =
+    std::unique_ptr<leveldb::Iterator, std::function<void(leveldb::Iterator *)>>;
+
+/**
+ * Performs the reads of the LevelDB-backed persistence components, which share a single reader.
+ *
+ * Outside of a read transaction every read sees the latest committed state of the database.
+ * Between beginReadTransaction and the matching endReadTransaction all reads instead see one
+ * LevelDB snapshot, so that the components observe a consistent view of each other, and the
+ * iterators are pooled rather than created anew for each read.
+ *
+ * Not thread-safe: all calls must be made on the same queue, like the components themselves.
+ */
+@interface FSTLevelDBReader : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/** Creates a reader for the given LevelDB. */
+- (instancetype)initWithDB:(std::shared_ptr<leveldb::DB>)db NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Starts a read transaction, pinning a snapshot of the database. Read transactions nest: only the
+ * outermost call takes a snapshot.
+ */
+- (void)beginReadTransaction;
+
+/** Ends a read transaction started with beginReadTransaction. */
+- (void)endReadTransaction;
+
+/**
+ * Replaces the snapshot of the current read transaction with a new one, so that reads see writes
+ * committed since the transaction began. Does nothing outside of a read transaction.
+ */
+- (void)refreshReadTransaction;
+
+/** @return The options to use for a read, including the snapshot of any read transaction. */
+- (leveldb::ReadOptions)readOptions;
+
+/** Reads the value stored at the given key. */
+- (leveldb::Status)getValue:(std::string *)value forKey:(const std::string &)key;
+
+/** @return An unpositioned iterator over the database. Callers must seek before using it. */
+- (FSTLevelDBIterator)iterator;
+
+/**
+ * @return An unpositioned iterator for a one-shot scan over a large part of the database, which
+ *     doesn't fill the block cache. See +[FSTLevelDB scanReadOptions].
+ */
+- (FSTLevelDBIterator)scanIterator;
+
+/** Whether a read transaction is in progress. */
+@property(nonatomic, assign, readonly, getter=isInReadTransaction) BOOL inReadTransaction;
+
+/** The database read from. */
+@property(nonatomic, assign, readonly) std::shared_ptr<leveldb::DB> db;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "Firestore/Source/Local/FSTLevelDBReader.h"
+
+#include <vector>
+
+#import "Firestore/Source/Local/FSTLevelDB.h"
+#import "Firestore/Source/Util/FSTAssert.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+using leveldb::DB;
+using leveldb::Iterator;
+using leveldb::ReadOptions;
+using leveldb::Snapshot;
+using leveldb::Status;
+
+/**
+ * The most iterators kept for reuse. LocalStore operations rarely have more than a couple of
+ * iterators open at once.
+ */
+static const size_t kMaxPooledIterators = 4;
+
+@implementation FSTLevelDBReader {
+  // The DB pointer is shared with all cooperating LevelDB-related objects.
+  std::shared_ptr<DB> _db;
+
+  // The snapshot pinned by the current read transaction, or nullptr outside of one.
+  const Snapshot *_snapshot;
+
+  // The nesting depth of beginReadTransaction calls.
+  int _depth;
+
+  // Incremented whenever _snapshot changes, so that iterators created for an earlier snapshot
+  // aren't pooled when they're returned.
+  uint64_t _generation;
+
+  // Idle iterators over _snapshot.
+  std::vector<Iterator *> _pool;
+}
+
+- (instancetype)initWithDB:(std::shared_ptr<DB>)db {
+  if (self = [super init]) {
+    _db = db;
+  }
+  return self;
+}
+
+- (void)dealloc {
+  [self releaseSnapshot];
+}
+
+- (std::shared_ptr<DB>)db {
+  return _db;
+}
+
+- (BOOL)isInReadTransaction {
+  return _depth > 0;
+}
+
+- (void)beginReadTransaction {
+  if (_depth++ == 0) {
+    _snapshot = _db->GetSnapshot();
+  }
+}
+
+- (void)endReadTransaction {
+  FSTAssert(_depth > 0, @"endReadTransaction called without beginReadTransaction");
+  if (--_depth == 0) {
+    [self releaseSnapshot];
+  }
+}
+
+- (void)refreshReadTransaction {
+  if (_depth > 0) {
+    [self releaseSnapshot];
+    _snapshot = _db->GetSnapshot();
+  }
+}
+
+- (void)releaseSnapshot {
+  for (Iterator *it : _pool) {
+    delete it;
+  }
+  _pool.clear();
+  if (_snapshot) {
+    _db->ReleaseSnapshot(_snapshot);
+    _snapshot = nullptr;
+  }
+  _generation++;
+}
+
+- (ReadOptions)readOptions {
+  ReadOptions options = [FSTLevelDB standardReadOptions];
+  options.snapshot = _snapshot;
+  return options;
+}
+
+- (Status)getValue:(std::string *)value forKey:(const std::string &)key {
+  return _db->Get([self readOptions], key, value);
+}
+
+- (FSTLevelDBIterator)iterator {
+  Iterator *it;
+  if (!_pool.empty()) {
+    it = _pool.back();
+    _pool.pop_back();
+  } else {
+    it = _db->NewIterator([self readOptions]);
+  }
+
+  uint64_t generation = _generation;
+  return FSTLevelDBIterator(it, [self, generation](Iterator *returned) {
+    [self returnIterator:returned generation:generation];
+  });
+}
+
+- (FSTLevelDBIterator)scanIterator {
+  ReadOptions options = [FSTLevelDB scanReadOptions];
+  options.snapshot = _snapshot;
+
+  // Iterators that don't fill the cache aren't pooled, since most reads want the cache filled.
+  return FSTLevelDBIterator(_db->NewIterator(options), [self](Iterator *returned) {
+    [self discardIterator:returned];
+  });
+}
+
+- (void)returnIterator:(Iterator *)it generation:(uint64_t)generation {
+  // An iterator that hit an error or was created for an earlier snapshot can't be reused.
+  if (generation == _generation && _snapshot && it->status().ok() &&
+      _pool.size() < kMaxPooledIterators) {
+    _pool.push_back(it);
+  } else {
+    [self discardIterator:it];
+  }
+}
+
+- (void)discardIterator:(Iterator *)it {
+  delete it;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
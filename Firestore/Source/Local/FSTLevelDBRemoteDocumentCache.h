@@ -17,11 +17,15 @@
 #import <Foundation/Foundation.h>
 
 #include <memory>
+#include <string>
 
 #import "Firestore/Source/Local/FSTRemoteDocumentCache.h"
 #include "leveldb/db.h"
 
+@class FSTLevelDBDocumentSnapshots;
+@class FSTLevelDBReader;
 @class FSTLocalSerializer;
+@class FSTWriteGroup;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -36,7 +40,54 @@ NS_ASSUME_NONNULL_BEGIN
  * @param db The leveldb in which to create the cache.
  */
 - (instancetype)initWithDB:(std::shared_ptr<leveldb::DB>)db
-                serializer:(FSTLocalSerializer *)serializer NS_DESIGNATED_INITIALIZER;
+                serializer:(FSTLocalSerializer *)serializer;
+
+/**
+ * Creates a new remote documents cache reading through the given shared reader.
+ *
+ * @param reader The reader of the leveldb in which to create the cache.
+ */
+- (instancetype)initWithReader:(FSTLevelDBReader *)reader
+                    serializer:(FSTLocalSerializer *)serializer;
+
+/**
+ * Creates a new remote documents cache reading through the given shared reader, which reads
+ * collections from their compacted snapshots whenever they're current.
+ *
+ * @param reader The reader of the leveldb in which to create the cache.
+ * @param documentSnapshots The snapshots of the cache's large collections, invalidated by every
+ *     change the cache makes. Caches reading a pinned snapshot of the leveldb must not use them,
+ *     since they reflect its latest state.
+ */
+- (instancetype)initWithReader:(FSTLevelDBReader *)reader
+                    serializer:(FSTLocalSerializer *)serializer
+             documentSnapshots:(nullable FSTLevelDBDocumentSnapshots *)documentSnapshots
+    NS_DESIGNATED_INITIALIZER;
+
+/**
+ * The number of reads that were satisfied by a previously decoded document rather than by parsing
+ * the stored protocol buffer.
+ */
+@property(nonatomic, assign, readonly) NSUInteger decodedDocumentCacheHits;
+
+/** The number of reads that had to parse the stored protocol buffer. */
+@property(nonatomic, assign, readonly) NSUInteger decodedDocumentCacheMisses;
+
+/**
+ * Adds field index entries for the next batch of documents in the cache, in key order. Used to
+ * populate the index for documents written before it existed, one bounded write at a time.
+ *
+ * @param startRow The LevelDB key of the last row indexed by the previous batch, or the empty
+ *     string to start with the first document.
+ * @param limit The maximum number of documents to index.
+ * @param count Set to the number of documents indexed.
+ * @return The LevelDB key of the last row indexed, from which the next batch continues, or the
+ *     empty string if no documents were left to index.
+ */
+- (std::string)addIndexEntriesForDocumentsAfterRow:(const std::string &)startRow
+                                             limit:(NSUInteger)limit
+                                             count:(NSUInteger *)count
+                                             group:(FSTWriteGroup *)group;
 
 @end
 
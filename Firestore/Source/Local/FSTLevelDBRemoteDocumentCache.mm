@@ -18,22 +18,34 @@
 
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
+#include <algorithm>
+#include <list>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Local/FSTLevelDBDocumentSnapshots.h"
+#import "Firestore/Source/Local/FSTLevelDBFieldIndex.h"
 #import "Firestore/Source/Local/FSTLevelDBKey.h"
+#import "Firestore/Source/Local/FSTLevelDBReader.h"
 #import "Firestore/Source/Local/FSTLocalSerializer.h"
 #import "Firestore/Source/Local/FSTWriteGroup.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTDocumentDictionary.h"
 #import "Firestore/Source/Model/FSTDocumentKey.h"
+#import "Firestore/Source/Model/FSTDocumentKeySet.h"
 #import "Firestore/Source/Model/FSTDocumentSet.h"
 #import "Firestore/Source/Model/FSTPath.h"
 #import "Firestore/Source/Util/FSTAssert.h"
 
+#include "Firestore/core/src/firebase/firestore/util/string_util.h"
+
 NS_ASSUME_NONNULL_BEGIN
 
+using firebase::firestore::util::PrefixSuccessor;
 using leveldb::DB;
 using leveldb::Iterator;
 using leveldb::ReadOptions;
@@ -45,104 +57,511 @@ using leveldb::WriteOptions;
 
 @property(nonatomic, strong, readonly) FSTLocalSerializer *serializer;
 
+@property(nonatomic, strong, readonly) FSTLevelDBFieldIndex *fieldIndex;
+
 @end
 
+namespace {
+
+/** The maximum number of encoded bytes whose decoded documents are retained. */
+const size_t kDecodedDocumentCacheBytes = 4 * 1024 * 1024;
+
 /**
- * Returns a standard set of read options.
+ * The number of undecoded rows a collection scan collects before decoding them together. This
+ * bounds how many encoded rows are copied out of LevelDB at once.
+ */
+const size_t kDecodeBatchSize = 1024;
+
+/**
+ * The number of rows each parallel decoding task handles. Batches with fewer rows than this are
+ * decoded serially since dispatching would cost more than it saves.
+ */
+const size_t kDecodeChunkSize = 64;
+
+/** An encoded row copied out of LevelDB, waiting to be decoded. */
+struct UndecodedRow {
+  std::string key;
+  std::string value;
+  FSTDocumentKey *documentKey;
+};
+
+/**
+ * A bounded LRU cache of decoded documents, keyed by LevelDB row key.
  *
- * For now this is paranoid, but perhaps disable that in production builds.
+ * Each entry retains the encoded row it was decoded from, and a lookup only hits if the row
+ * currently stored matches byte for byte. Comparing bytes is far cheaper than parsing the proto and
+ * running it through the serializer, and it guarantees the cache can never return a document that
+ * differs from what's on disk, even if a write group is still open when the row is read.
  */
-static ReadOptions StandardReadOptions() {
-  ReadOptions options;
-  options.verify_checksums = true;
-  return options;
-}
+class DecodedDocumentCache {
+ public:
+  explicit DecodedDocumentCache(size_t max_bytes = kDecodedDocumentCacheBytes)
+      : max_bytes_(max_bytes) {
+  }
+
+  /**
+   * Returns the document previously decoded from the given row, or nil if there is none or if the
+   * row has changed since.
+   */
+  FSTMaybeDocument *_Nullable Find(const std::string &key, Slice value) {
+    auto found = index_.find(key);
+    if (found == index_.end()) {
+      return nil;
+    }
+    auto entry = found->second;
+    if (Slice(entry->value) != value) {
+      return nil;
+    }
+    entries_.splice(entries_.begin(), entries_, entry);
+    return entry->document;
+  }
+
+  /** Remembers that the given row decodes to the given document. */
+  void Insert(const std::string &key, Slice value, FSTMaybeDocument *document) {
+    Erase(key);
+    size_t entry_bytes = key.size() + value.size();
+    if (entry_bytes > max_bytes_) {
+      return;
+    }
+
+    entries_.push_front(Entry{key, value.ToString(), document});
+    index_.emplace(key, entries_.begin());
+    bytes_ += entry_bytes;
+    while (bytes_ > max_bytes_) {
+      Entry &oldest = entries_.back();
+      bytes_ -= oldest.key.size() + oldest.value.size();
+      index_.erase(oldest.key);
+      entries_.pop_back();
+    }
+  }
+
+  /** Drops any document cached for the given row. */
+  void Erase(const std::string &key) {
+    auto found = index_.find(key);
+    if (found == index_.end()) {
+      return;
+    }
+    auto entry = found->second;
+    bytes_ -= entry->key.size() + entry->value.size();
+    index_.erase(found);
+    entries_.erase(entry);
+  }
+
+  void Clear() {
+    index_.clear();
+    entries_.clear();
+    bytes_ = 0;
+  }
+
+  size_t size() const {
+    return index_.size();
+  }
+
+  /** The encoded bytes of the cached rows, which approximate the memory used by the documents. */
+  size_t bytes() const {
+    return bytes_;
+  }
+
+ private:
+  struct Entry {
+    std::string key;
+    std::string value;
+    FSTMaybeDocument *document;
+  };
+
+  size_t max_bytes_;
+  size_t bytes_ = 0;
+
+  // Most recently used first.
+  std::list<Entry> entries_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+};
+
+}  // namespace
 
 @implementation FSTLevelDBRemoteDocumentCache {
-  // The DB pointer is shared with all cooperating LevelDB-related objects.
-  std::shared_ptr<DB> _db;
+  // The reader is shared with all cooperating LevelDB-related objects.
+  FSTLevelDBReader *_reader;
+
+  DecodedDocumentCache _decodedDocuments;
+
+  // The compacted snapshots of large collections, if this cache reads the latest state.
+  FSTLevelDBDocumentSnapshots *_Nullable _documentSnapshots;
 }
 
 - (instancetype)initWithDB:(std::shared_ptr<DB>)db serializer:(FSTLocalSerializer *)serializer {
+  return [self initWithReader:[[FSTLevelDBReader alloc] initWithDB:db] serializer:serializer];
+}
+
+- (instancetype)initWithReader:(FSTLevelDBReader *)reader
+                    serializer:(FSTLocalSerializer *)serializer {
+  return [self initWithReader:reader serializer:serializer documentSnapshots:nil];
+}
+
+- (instancetype)initWithReader:(FSTLevelDBReader *)reader
+                    serializer:(FSTLocalSerializer *)serializer
+             documentSnapshots:(nullable FSTLevelDBDocumentSnapshots *)documentSnapshots {
   if (self = [super init]) {
-    _db = db;
+    _reader = reader;
     _serializer = serializer;
+    _documentSnapshots = documentSnapshots;
+    _fieldIndex = [[FSTLevelDBFieldIndex alloc] initWithReader:reader];
   }
   return self;
 }
 
 - (void)shutdown {
-  _db.reset();
+  _reader = nil;
+  _fieldIndex = nil;
+  _documentSnapshots = nil;
+  _decodedDocuments.Clear();
+}
+
+- (FSTMemoryUsage)memoryUsage {
+  return FSTMemoryUsage{static_cast<int64_t>(_decodedDocuments.size()),
+                        static_cast<int64_t>(_decodedDocuments.bytes())};
+}
+
+- (void)releaseCachedMemory {
+  _decodedDocuments.Clear();
 }
 
 - (void)addEntry:(FSTMaybeDocument *)document group:(FSTWriteGroup *)group {
+  [self removeIndexEntriesForKey:document.key group:group];
+
   std::string key = [self remoteDocumentKey:document.key];
+  _decodedDocuments.Erase(key);
+  [_documentSnapshots invalidateInGroup:group];
   [group setMessage:[self.serializer encodedMaybeDocument:document] forKey:key];
+
+  if ([document isKindOfClass:[FSTDocument class]]) {
+    [self.fieldIndex addEntriesForDocument:(FSTDocument *)document group:group];
+  }
 }
 
 - (void)removeEntryForKey:(FSTDocumentKey *)documentKey group:(FSTWriteGroup *)group {
+  [self removeIndexEntriesForKey:documentKey group:group];
+
   std::string key = [self remoteDocumentKey:documentKey];
+  _decodedDocuments.Erase(key);
+  [_documentSnapshots invalidateInGroup:group];
   [group removeMessageForKey:key];
 }
 
+/**
+ * Removes the index entries for the currently stored version of the given document.
+ *
+ * This reads the document as last committed, so if a group writes the same document more than
+ * once, the entries for the intermediate versions survive. That only costs extra candidates in
+ * index scans, which callers filter out anyway.
+ */
+- (void)removeIndexEntriesForKey:(FSTDocumentKey *)documentKey group:(FSTWriteGroup *)group {
+  FSTMaybeDocument *existing = [self entryForKey:documentKey];
+  if ([existing isKindOfClass:[FSTDocument class]]) {
+    [self.fieldIndex removeEntriesForDocument:(FSTDocument *)existing group:group];
+  }
+}
+
+- (std::string)addIndexEntriesForDocumentsAfterRow:(const std::string &)startRow
+                                             limit:(NSUInteger)limit
+                                             count:(NSUInteger *)count
+                                             group:(FSTWriteGroup *)group {
+  std::string tablePrefix = [FSTLevelDBRemoteDocumentKey keyPrefix];
+  FSTLevelDBIterator it = [_reader scanIterator];
+  if (startRow.empty()) {
+    it->Seek(tablePrefix);
+  } else {
+    it->Seek(startRow);
+    if (it->Valid() && it->key() == startRow) {
+      it->Next();
+    }
+  }
+
+  std::string lastRow;
+  NSUInteger indexed = 0;
+  FSTLevelDBRemoteDocumentKey *currentKey = [[FSTLevelDBRemoteDocumentKey alloc] init];
+  for (; indexed < limit && it->Valid() && it->key().starts_with(tablePrefix) &&
+         [currentKey decodeKey:it->key()];
+       it->Next()) {
+    FSTMaybeDocument *maybeDoc = [self decodedMaybeDocument:it->value()
+                                                    withKey:currentKey.documentKey];
+    if ([maybeDoc isKindOfClass:[FSTDocument class]]) {
+      [self.fieldIndex addEntriesForDocument:(FSTDocument *)maybeDoc group:group];
+    }
+    lastRow = it->key().ToString();
+    indexed++;
+  }
+
+  Status status = it->status();
+  if (!status.ok()) {
+    FSTFail(@"Indexing remote documents failed with status: %s", status.ToString().c_str());
+  }
+  *count = indexed;
+  return lastRow;
+}
+
 - (nullable FSTMaybeDocument *)entryForKey:(FSTDocumentKey *)documentKey {
   std::string key = [FSTLevelDBRemoteDocumentKey keyWithDocumentKey:documentKey];
   std::string value;
-  Status status = _db->Get(StandardReadOptions(), key, &value);
+  Status status = [_reader getValue:&value forKey:key];
   if (status.IsNotFound()) {
     return nil;
   } else if (status.ok()) {
-    return [self decodedMaybeDocument:value withKey:documentKey];
+    return [self decodedMaybeDocument:value forRow:key withKey:documentKey];
   } else {
     FSTFail(@"Fetch document for key (%@) failed with status: %s", documentKey,
             status.ToString().c_str());
   }
 }
 
+- (FSTMaybeDocumentDictionary *)entriesForKeys:(FSTDocumentKeySet *)documentKeys {
+  FSTMaybeDocumentDictionary *results = [FSTMaybeDocumentDictionary maybeDocumentDictionary];
+  if (documentKeys.isEmpty) {
+    return results;
+  }
+
+  // Sort by encoded key so that a single iterator can visit every entry moving only forward.
+  std::vector<std::pair<std::string, FSTDocumentKey *>> keys;
+  keys.reserve(documentKeys.count);
+  for (FSTDocumentKey *documentKey in documentKeys.objectEnumerator) {
+    keys.emplace_back([self remoteDocumentKey:documentKey], documentKey);
+  }
+  std::sort(keys.begin(), keys.end(),
+            [](const std::pair<std::string, FSTDocumentKey *> &lhs,
+               const std::pair<std::string, FSTDocumentKey *> &rhs) {
+              return lhs.first < rhs.first;
+            });
+
+  FSTLevelDBIterator it = [_reader iterator];
+  it->Seek(keys.front().first);
+  for (const auto &key : keys) {
+    if (!it->Valid()) {
+      break;
+    }
+    // Adjacent keys are often adjacent entries too, in which case the Next() below has already
+    // positioned the iterator and no seek is needed.
+    if (it->key().compare(key.first) < 0) {
+      it->Seek(key.first);
+      if (!it->Valid()) {
+        break;
+      }
+    }
+    if (it->key() == key.first) {
+      FSTMaybeDocument *maybeDoc =
+          [self decodedMaybeDocument:it->value() forRow:key.first withKey:key.second];
+      results = [results dictionaryBySettingObject:maybeDoc forKey:key.second];
+      it->Next();
+    }
+  }
+
+  Status status = it->status();
+  if (!status.ok()) {
+    FSTFail(@"Fetch documents for %lu keys failed with status: %s",
+            (unsigned long)documentKeys.count, status.ToString().c_str());
+  }
+
+  return results;
+}
+
 - (FSTDocumentDictionary *)documentsMatchingQuery:(FSTQuery *)query {
-  FSTDocumentDictionary *results = [FSTDocumentDictionary documentDictionary];
+  __block FSTDocumentDictionary *results = [FSTDocumentDictionary documentDictionary];
+
+  // If one of the query's filters can be served by the field index, read just the candidates it
+  // finds instead of scanning the whole collection.
+  FSTDocumentKeySet *_Nullable candidates = [self.fieldIndex documentKeysMatchingQuery:query];
+  if (candidates) {
+    FSTMaybeDocumentDictionary *entries = [self entriesForKeys:candidates];
+    for (FSTDocumentKey *key in entries.keyEnumerator) {
+      FSTMaybeDocument *maybeDoc = entries[key];
+      if ([maybeDoc isKindOfClass:[FSTDocument class]]) {
+        results = [results dictionaryBySettingObject:(FSTDocument *)maybeDoc forKey:key];
+      }
+    }
+    return results;
+  }
+
+  // The whole collection is needed, so rather than decoding each row as the scan reaches it, rows
+  // that aren't cached yet are collected into batches and decoded in parallel.
+  __block std::vector<UndecodedRow> undecoded;
+  void (^addDocument)(FSTMaybeDocument *) = ^(FSTMaybeDocument *maybeDoc) {
+    if ([maybeDoc isKindOfClass:[FSTDocument class]]) {
+      results = [results dictionaryBySettingObject:(FSTDocument *)maybeDoc forKey:maybeDoc.key];
+    }
+  };
+  [self enumerateRowsInCollection:query.path
+                          fromKey:[query lowestKeyInBounds]
+                        throughKey:[query highestKeyInBounds]
+                       usingBlock:^(const Slice &key, const Slice &value,
+                                    FSTDocumentKey *documentKey, BOOL *stop) {
+                         std::string rowKey = key.ToString();
+                         FSTMaybeDocument *_Nullable cached = _decodedDocuments.Find(rowKey, value);
+                         if (cached) {
+                           _decodedDocumentCacheHits++;
+                           addDocument(cached);
+                           return;
+                         }
+                         undecoded.push_back(
+                             UndecodedRow{std::move(rowKey), value.ToString(), documentKey});
+                         if (undecoded.size() >= kDecodeBatchSize) {
+                           [self decodeRows:&undecoded usingBlock:addDocument];
+                         }
+                       }];
+  [self decodeRows:&undecoded usingBlock:addDocument];
+  return results;
+}
 
-  // Documents are ordered by key, so we can use a prefix scan to narrow down
-  // the documents we need to match the query against.
-  std::string startKey = [FSTLevelDBRemoteDocumentKey keyPrefixWithResourcePath:query.path];
-  std::unique_ptr<Iterator> it(_db->NewIterator(StandardReadOptions()));
+/**
+ * Decodes the given rows, spreading the work over the available cores, and passes the results to
+ * `block` in order on the calling thread. The rows are consumed.
+ *
+ * Decoding only parses protos and builds immutable model objects, so it's safe to run off the
+ * calling queue. Everything else, including the decoded document cache, is touched only on the
+ * calling thread, and this returns only once all rows are decoded.
+ */
+- (void)decodeRows:(std::vector<UndecodedRow> *)rows
+        usingBlock:(void (^)(FSTMaybeDocument *maybeDoc))block {
+  size_t count = rows->size();
+  if (count == 0) {
+    return;
+  }
+
+  std::vector<FSTMaybeDocument *> decoded(count);
+  const UndecodedRow *input = rows->data();
+  if (count < 2 * kDecodeChunkSize) {
+    for (size_t i = 0; i < count; i++) {
+      decoded[i] = [self decodedMaybeDocument:input[i].value withKey:input[i].documentKey];
+    }
+  } else {
+    size_t chunks = (count + kDecodeChunkSize - 1) / kDecodeChunkSize;
+    FSTMaybeDocument *__strong *output = decoded.data();
+    dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+    dispatch_apply(chunks, queue, ^(size_t chunk) {
+      size_t end = std::min(count, (chunk + 1) * kDecodeChunkSize);
+      for (size_t i = chunk * kDecodeChunkSize; i < end; i++) {
+        output[i] = [self decodedMaybeDocument:input[i].value withKey:input[i].documentKey];
+      }
+    });
+  }
+
+  _decodedDocumentCacheMisses += count;
+  for (size_t i = 0; i < count; i++) {
+    _decodedDocuments.Insert(input[i].key, input[i].value, decoded[i]);
+    block(decoded[i]);
+  }
+  rows->clear();
+}
+
+- (void)enumerateDocumentsInCollection:(FSTResourcePath *)collectionPath
+                            usingBlock:(void (^)(FSTDocument *document, BOOL *stop))block {
+  [self enumerateRowsInCollection:collectionPath
+                          fromKey:nil
+                        throughKey:nil
+                       usingBlock:^(const Slice &key, const Slice &value,
+                                    FSTDocumentKey *documentKey, BOOL *stop) {
+                         FSTMaybeDocument *maybeDoc = [self decodedMaybeDocument:value
+                                                                          forRow:key.ToString()
+                                                                         withKey:documentKey];
+                         if ([maybeDoc isKindOfClass:[FSTDocument class]]) {
+                           block((FSTDocument *)maybeDoc, stop);
+                         }
+                       }];
+}
+
+/**
+ * Calls `block` with the encoded row of each document that's an immediate child of the given
+ * collection, in key order. The rows come from the collection's snapshot if it has a current one,
+ * and from LevelDB otherwise.
+ *
+ * @param fromKey If set, the scan seeks directly to the row of this key, skipping lower keys.
+ * @param throughKey If set, the scan stops after the row of this key.
+ */
+- (void)enumerateRowsInCollection:(FSTResourcePath *)collectionPath
+                          fromKey:(nullable FSTDocumentKey *)fromKey
+                        throughKey:(nullable FSTDocumentKey *)throughKey
+                       usingBlock:(FSTLevelDBDocumentRowBlock)block {
+  if ([_documentSnapshots enumerateRowsInCollection:collectionPath
+                                            fromKey:fromKey
+                                         throughKey:throughKey
+                                         usingBlock:block]) {
+    return;
+  }
+
+  // Documents are ordered by key, so we can use a prefix scan to find the documents in the
+  // collection.
+  std::string startKey = [FSTLevelDBRemoteDocumentKey keyPrefixWithResourcePath:collectionPath];
+  if (fromKey) {
+    std::string fromRow = [FSTLevelDBRemoteDocumentKey keyWithDocumentKey:fromKey];
+    startKey = std::max(startKey, fromRow);
+  }
+  std::string endKey;
+  if (throughKey) {
+    endKey = [FSTLevelDBRemoteDocumentKey keyWithDocumentKey:throughKey];
+  }
+  FSTLevelDBIterator it = [_reader iterator];
   it->Seek(startKey);
 
+  // Only the immediate children of the collection can match. Rows for documents in nested
+  // subcollections sort directly after their parent document, so whenever the scan reaches one
+  // the whole subtree is skipped with a single seek, without decoding any of its values.
+  int childLength = collectionPath.length + 1;
+  BOOL stop = NO;
+  NSUInteger rowCount = 0;
   FSTLevelDBRemoteDocumentKey *currentKey = [[FSTLevelDBRemoteDocumentKey alloc] init];
-  for (; it->Valid() && [currentKey decodeKey:it->key()]; it->Next()) {
-    FSTMaybeDocument *maybeDoc =
-        [self decodedMaybeDocument:it->value() withKey:currentKey.documentKey];
-    if (![query.path isPrefixOfPath:maybeDoc.key.path]) {
+  while (!stop && it->Valid() && [currentKey decodeKey:it->key()]) {
+    FSTResourcePath *path = currentKey.documentKey.path;
+    if (![collectionPath isPrefixOfPath:path] ||
+        (throughKey && it->key().compare(endKey) > 0)) {
       break;
-    } else if ([maybeDoc isKindOfClass:[FSTDocument class]]) {
-      results = [results dictionaryBySettingObject:(FSTDocument *)maybeDoc forKey:maybeDoc.key];
     }
+
+    if (path.length > childLength) {
+      FSTResourcePath *child =
+          [collectionPath pathByAppendingSegment:[path segmentAtIndex:collectionPath.length]];
+      it->Seek(PrefixSuccessor([FSTLevelDBRemoteDocumentKey keyPrefixWithResourcePath:child]));
+      continue;
+    }
+
+    block(it->key(), it->value(), currentKey.documentKey, &stop);
+    rowCount++;
+    it->Next();
   }
 
   Status status = it->status();
   if (!status.ok()) {
-    FSTFail(@"Find documents matching query (%@) failed with status: %s", query,
+    FSTFail(@"Find documents in collection (%@) failed with status: %s", collectionPath,
             status.ToString().c_str());
   }
-
-  return results;
+  [_documentSnapshots noteScanOfCollection:collectionPath rowCount:rowCount];
 }
 
 - (std::string)remoteDocumentKey:(FSTDocumentKey *)key {
   return [FSTLevelDBRemoteDocumentKey keyWithDocumentKey:key];
 }
 
+/**
+ * Returns the document stored in the given row, reusing the result of an earlier decoding of the
+ * same bytes if there is one.
+ */
+- (FSTMaybeDocument *)decodedMaybeDocument:(Slice)slice
+                                    forRow:(const std::string &)rowKey
+                                   withKey:(FSTDocumentKey *)documentKey {
+  FSTMaybeDocument *_Nullable cached = _decodedDocuments.Find(rowKey, slice);
+  if (cached) {
+    _decodedDocumentCacheHits++;
+    return cached;
+  }
+
+  _decodedDocumentCacheMisses++;
+  FSTMaybeDocument *maybeDocument = [self decodedMaybeDocument:slice withKey:documentKey];
+  _decodedDocuments.Insert(rowKey, slice, maybeDocument);
+  return maybeDocument;
+}
+
 - (FSTMaybeDocument *)decodedMaybeDocument:(Slice)slice withKey:(FSTDocumentKey *)documentKey {
   NSData *data =
       [[NSData alloc] initWithBytesNoCopy:(void *)slice.data() length:slice.size() freeWhenDone:NO];
 
-  NSError *error;
-  FSTPBMaybeDocument *proto = [FSTPBMaybeDocument parseFromData:data error:&error];
-  if (!proto) {
-    FSTFail(@"FSTPBMaybeDocument failed to parse: %@", error);
-  }
-
-  FSTMaybeDocument *maybeDocument = [self.serializer decodedMaybeDocument:proto];
+  FSTMaybeDocument *maybeDocument = [self.serializer decodedMaybeDocumentFromData:data];
   FSTAssert([maybeDocument.key isEqualToKey:documentKey],
             @"Read document has key (%@) instead of expected key (%@).", maybeDocument.key,
             documentKey);
@@ -21,6 +21,7 @@
 
 @class FSTDocumentKey;
 @class FSTMaybeDocument;
+@class FSTMutationBatch;
 @class FSTQuery;
 @protocol FSTMutationQueue;
 @protocol FSTRemoteDocumentCache;
@@ -31,6 +32,10 @@ NS_ASSUME_NONNULL_BEGIN
  * A readonly view of the local state of all documents we're tracking (i.e. we have a cached
  * version in remoteDocumentCache or local mutations for the document). The view is computed by
  * applying the mutations in the FSTMutationQueue to the FSTRemoteDocumentCache.
+ *
+ * The view keeps an overlay of the pending mutation batches affecting each document, loaded from
+ * the mutation queue on first use. All later changes to the queue's batches must be reported via
+ * addMutationBatch: and removeMutationBatches: so that the overlay stays in sync with the queue.
  */
 @interface FSTLocalDocumentsView : NSObject
 
@@ -54,9 +59,36 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (FSTMaybeDocumentDictionary *)documentsForKeys:(FSTDocumentKeySet *)keys;
 
+/**
+ * Takes a remote document and applies local mutations to generate the local view of the
+ * document.
+ *
+ * @param document The base remote document to apply mutations to.
+ * @param documentKey The key of the document (necessary when remoteDocument is nil).
+ */
+- (nullable FSTMaybeDocument *)localDocument:(nullable FSTMaybeDocument *)document
+                                         key:(FSTDocumentKey *)documentKey;
+
 /** Performs a query against the local view of all documents. */
 - (FSTDocumentDictionary *)documentsMatchingQuery:(FSTQuery *)query;
 
+/**
+ * Returns a view over the given snapshot of the remote documents and a copy of this view's
+ * current overlay, so that later changes to the mutation queue don't affect it. The snapshot view
+ * never reads the mutation queue and must not be sent addMutationBatch: or
+ * removeMutationBatches:.
+ *
+ * @param remoteDocumentCache A snapshot from -[FSTPersistence remoteDocumentCacheSnapshot].
+ */
+- (FSTLocalDocumentsView *)snapshotWithRemoteDocumentCache:
+    (id<FSTRemoteDocumentCache>)remoteDocumentCache;
+
+/** Updates the overlay after `batch` has been added to the mutation queue. */
+- (void)addMutationBatch:(FSTMutationBatch *)batch;
+
+/** Updates the overlay after `batches` have been removed from the mutation queue. */
+- (void)removeMutationBatches:(NSArray<FSTMutationBatch *> *)batches;
+
 @end
 
 NS_ASSUME_NONNULL_END
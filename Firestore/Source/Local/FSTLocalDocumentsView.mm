@@ -25,19 +25,91 @@
 #import "Firestore/Source/Model/FSTDocumentKey.h"
 #import "Firestore/Source/Model/FSTMutation.h"
 #import "Firestore/Source/Model/FSTMutationBatch.h"
+#import "Firestore/Source/Model/FSTPath.h"
 #import "Firestore/Source/Util/FSTAssert.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ * The pending mutation batches affecting a single document, along with the local view computed the
+ * last time they were applied.
+ */
+@interface FSTDocumentOverlay : NSObject
+
+/**
+ * Returns the local view of the document given its remote version, reusing the last result if the
+ * remote version hasn't changed since.
+ */
+- (nullable FSTMaybeDocument *)localDocument:(nullable FSTMaybeDocument *)document
+                                         key:(FSTDocumentKey *)documentKey;
+
+/** The batches affecting the document, in batchID order. */
+@property(nonatomic, strong, readonly) NSMutableArray<FSTMutationBatch *> *batches;
+
+/** Forgets the cached local view, e.g. because the batches have changed. */
+- (void)invalidate;
+
+/** The remote document the cached local view was computed from. */
+@property(nonatomic, strong, nullable) FSTMaybeDocument *cachedBaseDocument;
+
+/** The cached local view, valid only if hasCachedDocument is set. */
+@property(nonatomic, strong, nullable) FSTMaybeDocument *cachedLocalDocument;
+
+@property(nonatomic, assign) BOOL hasCachedDocument;
+
+@end
+
+@implementation FSTDocumentOverlay
+
+- (instancetype)init {
+  if (self = [super init]) {
+    _batches = [NSMutableArray array];
+  }
+  return self;
+}
+
+- (nullable FSTMaybeDocument *)localDocument:(nullable FSTMaybeDocument *)document
+                                         key:(FSTDocumentKey *)documentKey {
+  if (self.hasCachedDocument &&
+      (self.cachedBaseDocument == document || [self.cachedBaseDocument isEqual:document])) {
+    return self.cachedLocalDocument;
+  }
+
+  FSTMaybeDocument *_Nullable localDocument = document;
+  for (FSTMutationBatch *batch in self.batches) {
+    localDocument = [batch applyTo:localDocument documentKey:documentKey];
+  }
+  self.cachedBaseDocument = document;
+  self.cachedLocalDocument = localDocument;
+  self.hasCachedDocument = YES;
+  return localDocument;
+}
+
+- (void)invalidate {
+  self.cachedBaseDocument = nil;
+  self.cachedLocalDocument = nil;
+  self.hasCachedDocument = NO;
+}
+
+@end
+
 @interface FSTLocalDocumentsView ()
 - (instancetype)initWithRemoteDocumentCache:(id<FSTRemoteDocumentCache>)remoteDocumentCache
                               mutationQueue:(id<FSTMutationQueue>)mutationQueue
     NS_DESIGNATED_INITIALIZER;
 @property(nonatomic, strong, readonly) id<FSTRemoteDocumentCache> remoteDocumentCache;
 @property(nonatomic, strong, readonly) id<FSTMutationQueue> mutationQueue;
+@property(nonatomic, strong, readonly)
+    NSMutableDictionary<FSTDocumentKey *, FSTDocumentOverlay *> *overlays;
 @end
 
-@implementation FSTLocalDocumentsView
+@implementation FSTLocalDocumentsView {
+  /**
+   * The overlay for every document with pending mutations, or nil if it hasn't been loaded from
+   * the mutation queue yet. Documents without pending mutations have no entry.
+   */
+  NSMutableDictionary<FSTDocumentKey *, FSTDocumentOverlay *> *_Nullable _overlays;
+}
 
 + (instancetype)viewWithRemoteDocumentCache:(id<FSTRemoteDocumentCache>)remoteDocumentCache
                               mutationQueue:(id<FSTMutationQueue>)mutationQueue {
@@ -54,23 +126,43 @@ NS_ASSUME_NONNULL_BEGIN
   return self;
 }
 
+- (FSTLocalDocumentsView *)snapshotWithRemoteDocumentCache:
+    (id<FSTRemoteDocumentCache>)remoteDocumentCache {
+  FSTLocalDocumentsView *snapshot =
+      [[FSTLocalDocumentsView alloc] initWithRemoteDocumentCache:remoteDocumentCache
+                                                   mutationQueue:self.mutationQueue];
+  // The batches themselves are immutable, so only the per-document arrays need copying. The
+  // cached local views are dropped since they may have been computed from newer remote documents.
+  NSMutableDictionary<FSTDocumentKey *, FSTDocumentOverlay *> *overlays =
+      [NSMutableDictionary dictionaryWithCapacity:self.overlays.count];
+  [self.overlays enumerateKeysAndObjectsUsingBlock:^(FSTDocumentKey *key,
+                                                     FSTDocumentOverlay *overlay, BOOL *stop) {
+    FSTDocumentOverlay *copy = [[FSTDocumentOverlay alloc] init];
+    [copy.batches addObjectsFromArray:overlay.batches];
+    overlays[key] = copy;
+  }];
+  snapshot->_overlays = overlays;
+  return snapshot;
+}
+
 - (nullable FSTMaybeDocument *)documentForKey:(FSTDocumentKey *)key {
   FSTMaybeDocument *_Nullable remoteDoc = [self.remoteDocumentCache entryForKey:key];
   return [self localDocument:remoteDoc key:key];
 }
 
 - (FSTMaybeDocumentDictionary *)documentsForKeys:(FSTDocumentKeySet *)keys {
-  FSTMaybeDocumentDictionary *results = [FSTMaybeDocumentDictionary maybeDocumentDictionary];
+  FSTMaybeDocumentDictionary *remoteDocs = [self.remoteDocumentCache entriesForKeys:keys];
+  NSMutableDictionary<FSTDocumentKey *, FSTMaybeDocument *> *results =
+      [NSMutableDictionary dictionaryWithCapacity:keys.count];
   for (FSTDocumentKey *key in keys.objectEnumerator) {
-    // TODO(mikelehen): PERF: Consider fetching all remote documents at once rather than one-by-one.
-    FSTMaybeDocument *maybeDoc = [self documentForKey:key];
+    FSTMaybeDocument *maybeDoc = [self localDocument:remoteDocs[key] key:key];
     // TODO(http://b/32275378): Don't conflate missing / deleted.
     if (!maybeDoc) {
       maybeDoc = [FSTDeletedDocument documentWithKey:key version:[FSTSnapshotVersion noVersion]];
     }
-    results = [results dictionaryBySettingObject:maybeDoc forKey:key];
+    results[key] = maybeDoc;
   }
-  return results;
+  return [FSTMaybeDocumentDictionary maybeDocumentDictionaryWithDictionary:results];
 }
 
 - (FSTDocumentDictionary *)documentsMatchingQuery:(FSTQuery *)query {
@@ -91,36 +183,48 @@ NS_ASSUME_NONNULL_BEGIN
   return result;
 }
 
+/**
+ * Returns YES if the first `limit` results of the query in key order are its final results, so
+ * that documentsMatchingLimitedQuery: can stop reading once it has found them.
+ */
+- (BOOL)canStopAtLimit:(FSTQuery *)query {
+  if (query.limit == NSNotFound) {
+    return NO;
+  }
+  NSArray<FSTSortOrder *> *sortOrders = query.sortOrders;
+  return sortOrders.count == 1 && [sortOrders[0].field isKeyFieldPath] && sortOrders[0].ascending;
+}
+
 - (FSTDocumentDictionary *)documentsMatchingCollectionQuery:(FSTQuery *)query {
+  if ([self canStopAtLimit:query]) {
+    return [self documentsMatchingLimitedQuery:query];
+  }
+
   // Query the remote documents and overlay mutations.
-  // TODO(mikelehen): There may be significant overlap between the mutations affecting these
-  // remote documents and the allMutationBatchesAffectingQuery mutations. Consider optimizing.
   __block FSTDocumentDictionary *results = [self.remoteDocumentCache documentsMatchingQuery:query];
   results = [self localDocuments:results];
 
-  // Now use the mutation queue to discover any other documents that may match the query after
-  // applying mutations.
+  // Now use the overlay to discover any other documents that may match the query after applying
+  // mutations.
+  NSArray<FSTFieldPath *> *queryFields = [self fieldPathsConstrainedByQuery:query];
   FSTDocumentKeySet *matchingKeys = [FSTDocumentKeySet keySet];
-  NSArray<FSTMutationBatch *> *matchingMutationBatches =
-      [self.mutationQueue allMutationBatchesAffectingQuery:query];
-  for (FSTMutationBatch *batch in matchingMutationBatches) {
-    for (FSTMutation *mutation in batch.mutations) {
-      // TODO(mikelehen): PERF: Check if this mutation actually affects the query to reduce work.
-
-      // If the key is already in the results, we can skip it.
-      if (![results containsKey:mutation.key]) {
-        matchingKeys = [matchingKeys setByAddingObject:mutation.key];
-      }
+  for (FSTDocumentKey *key in [self mutatedKeysInCollection:query.path]) {
+    // If the key is already in the results, we can skip it. Otherwise its remote document (if
+    // any) doesn't match, and mutations that leave the query's fields alone and can't create the
+    // document can't change that.
+    if (![results containsKey:key] && [self mutationsForKey:key mayAffectFields:queryFields]) {
+      matchingKeys = [matchingKeys setByAddingObject:key];
     }
   }
 
   // Now add in results for the matchingKeys.
-  for (FSTDocumentKey *key in matchingKeys.objectEnumerator) {
-    FSTMaybeDocument *doc = [self documentForKey:key];
+  FSTMaybeDocumentDictionary *matchingDocs = [self documentsForKeys:matchingKeys];
+  [matchingDocs enumerateKeysAndObjectsUsingBlock:^(FSTDocumentKey *key, FSTMaybeDocument *doc,
+                                                    BOOL *stop) {
     if ([doc isKindOfClass:[FSTDocument class]]) {
       results = [results dictionaryBySettingObject:(FSTDocument *)doc forKey:key];
     }
-  }
+  }];
 
   // Finally, filter out any documents that don't actually match the query. Note that the extra
   // reference here prevents ARC from deallocating the initial unfiltered results while we're
@@ -137,21 +241,67 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 /**
- * Takes a remote document and applies local mutations to generate the local view of the
- * document.
+ * Finds the results of a limited, key-ordered collection query while reading only as many remote
+ * documents as necessary.
  *
- * @param document The base remote document to apply mutations to.
- * @param documentKey The key of the document (necessary when remoteDocument is nil).
+ * Documents with pending mutations are evaluated separately. Every other document's local view is
+ * just its remote version, so the remote documents can be streamed in key order, stopping once
+ * `limit` of them match. Any unmutated match past that point sorts after `limit` others and can't
+ * be among the results.
  */
+- (FSTDocumentDictionary *)documentsMatchingLimitedQuery:(FSTQuery *)query {
+  FSTDocumentKeySet *mutatedKeys = [FSTDocumentKeySet keySet];
+  for (FSTDocumentKey *key in [self mutatedKeysInCollection:query.path]) {
+    mutatedKeys = [mutatedKeys setByAddingObject:key];
+  }
+
+  __block FSTDocumentDictionary *results = [FSTDocumentDictionary documentDictionary];
+  [[self documentsForKeys:mutatedKeys]
+      enumerateKeysAndObjectsUsingBlock:^(FSTDocumentKey *key, FSTMaybeDocument *doc, BOOL *stop) {
+        if ([doc isKindOfClass:[FSTDocument class]] &&
+            [query matchesDocument:(FSTDocument *)doc]) {
+          results = [results dictionaryBySettingObject:(FSTDocument *)doc forKey:key];
+        }
+      }];
+
+  __block NSInteger remaining = query.limit;
+  __block FSTDocumentKey *_Nullable lastKey = nil;
+  [self.remoteDocumentCache
+      enumerateDocumentsInCollection:query.path
+                          usingBlock:^(FSTDocument *doc, BOOL *stop) {
+                            if ([mutatedKeys containsObject:doc.key] ||
+                                ![query matchesDocument:doc]) {
+                              return;
+                            }
+                            results = [results dictionaryBySettingObject:doc forKey:doc.key];
+                            if (--remaining <= 0) {
+                              lastKey = doc.key;
+                              *stop = YES;
+                            }
+                          }];
+
+  // If the scan stopped early, mutated documents past its end may have unmutated matches before
+  // them that were never read. Drop them so the results are always a prefix of the full ones, which
+  // views rely on when keeping documents past the limit.
+  if (lastKey) {
+    FSTDocumentDictionary *unfiltered = results;
+    [unfiltered
+        enumerateKeysAndObjectsUsingBlock:^(FSTDocumentKey *key, FSTDocument *doc, BOOL *stop) {
+          if ([key compare:lastKey] == NSOrderedDescending) {
+            results = [results dictionaryByRemovingObjectForKey:key];
+          }
+        }];
+  }
+  return results;
+}
+
 - (nullable FSTMaybeDocument *)localDocument:(nullable FSTMaybeDocument *)document
                                          key:(FSTDocumentKey *)documentKey {
-  NSArray<FSTMutationBatch *> *batches =
-      [self.mutationQueue allMutationBatchesAffectingDocumentKey:documentKey];
-  for (FSTMutationBatch *batch in batches) {
-    document = [batch applyTo:document documentKey:documentKey];
+  FSTDocumentOverlay *_Nullable overlay = self.overlays[documentKey];
+  if (!overlay) {
+    return document;
   }
-
-  return document;
+  return [overlay localDocument:document key:documentKey];
 }
 
 /**
@@ -177,6 +327,121 @@ NS_ASSUME_NONNULL_BEGIN
   return result;
 }
 
+#pragma mark - Overlay
+
+/** Returns the overlay, loading it from the mutation queue the first time it's needed. */
+- (NSMutableDictionary<FSTDocumentKey *, FSTDocumentOverlay *> *)overlays {
+  if (!_overlays) {
+    _overlays = [NSMutableDictionary dictionary];
+    [self.mutationQueue enumerateMutationBatchesUsingBlock:^(FSTMutationBatch *batch, BOOL *stop) {
+      [self addBatchToOverlays:batch];
+    }];
+  }
+  return _overlays;
+}
+
+/** Returns the fields that the query's filters and sort orders depend on. */
+- (NSArray<FSTFieldPath *> *)fieldPathsConstrainedByQuery:(FSTQuery *)query {
+  NSMutableArray<FSTFieldPath *> *fields = [NSMutableArray array];
+  for (id<FSTFilter> filter in query.filters) {
+    [fields addObject:filter.field];
+  }
+  for (FSTSortOrder *sortOrder in query.sortOrders) {
+    if (![sortOrder.field isKeyFieldPath]) {
+      [fields addObject:sortOrder.field];
+    }
+  }
+  return fields;
+}
+
+/**
+ * Returns YES if any pending mutation of the document at `key` could change one of `fields` or
+ * create the document.
+ */
+- (BOOL)mutationsForKey:(FSTDocumentKey *)key mayAffectFields:(NSArray<FSTFieldPath *> *)fields {
+  for (FSTMutationBatch *batch in self.overlays[key].batches) {
+    for (FSTMutation *mutation in batch.mutations) {
+      if (![mutation.key isEqual:key]) {
+        continue;
+      }
+      // Sets and deletes replace the whole document.
+      if (![mutation affectedFieldPaths]) {
+        return YES;
+      }
+      // A patch that doesn't require the document to exist (as from a set with merge) creates it
+      // when there's no remote document, whatever fields it touches.
+      FSTPrecondition *precondition = mutation.precondition;
+      if (precondition.exists != FSTPreconditionExistsYes && !precondition.updateTime) {
+        return YES;
+      }
+      for (FSTFieldPath *field in fields) {
+        if ([mutation mayAffectFieldPath:field]) {
+          return YES;
+        }
+      }
+    }
+  }
+  return NO;
+}
+
+/** Returns the keys with pending mutations that are immediate children of `collectionPath`. */
+- (NSArray<FSTDocumentKey *> *)mutatedKeysInCollection:(FSTResourcePath *)collectionPath {
+  NSMutableArray<FSTDocumentKey *> *keys = [NSMutableArray array];
+  for (FSTDocumentKey *key in self.overlays) {
+    FSTResourcePath *path = key.path;
+    if (path.length == collectionPath.length + 1 && [collectionPath isPrefixOfPath:path]) {
+      [keys addObject:key];
+    }
+  }
+  return keys;
+}
+
+- (void)addMutationBatch:(FSTMutationBatch *)batch {
+  // Batches that arrive before the overlay is loaded will be read along with the rest.
+  if (_overlays) {
+    [self addBatchToOverlays:batch];
+  }
+}
+
+- (void)addBatchToOverlays:(FSTMutationBatch *)batch {
+  for (FSTDocumentKey *key in [batch keys].objectEnumerator) {
+    FSTDocumentOverlay *_Nullable overlay = _overlays[key];
+    if (!overlay) {
+      overlay = [[FSTDocumentOverlay alloc] init];
+      _overlays[key] = overlay;
+    }
+    FSTAssert(overlay.batches.lastObject.batchID < batch.batchID,
+              @"Mutation batches must be added in batchID order");
+    [overlay.batches addObject:batch];
+    [overlay invalidate];
+  }
+}
+
+- (void)removeMutationBatches:(NSArray<FSTMutationBatch *> *)batches {
+  if (!_overlays) {
+    return;
+  }
+  for (FSTMutationBatch *batch in batches) {
+    for (FSTDocumentKey *key in [batch keys].objectEnumerator) {
+      FSTDocumentOverlay *_Nullable overlay = _overlays[key];
+      if (!overlay) {
+        continue;
+      }
+      NSUInteger index = [overlay.batches
+          indexOfObjectPassingTest:^BOOL(FSTMutationBatch *other, NSUInteger idx, BOOL *stop) {
+            return other.batchID == batch.batchID;
+          }];
+      if (index != NSNotFound) {
+        [overlay.batches removeObjectAtIndex:index];
+        [overlay invalidate];
+      }
+      if (overlay.batches.count == 0) {
+        [_overlays removeObjectForKey:key];
+      }
+    }
+  }
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
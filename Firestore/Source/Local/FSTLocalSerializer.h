@@ -49,6 +49,13 @@ NS_ASSUME_NONNULL_BEGIN
 /** Decodes an FSTPBMaybeDocument proto to the equivalent model. */
 - (FSTMaybeDocument *)decodedMaybeDocument:(FSTPBMaybeDocument *)proto;
 
+/**
+ * Decodes the serialized bytes of an FSTPBMaybeDocument proto to the equivalent model. Documents
+ * are decoded straight from the wire format into compact C++ values where possible, so reading
+ * many rows doesn't allocate an FSTPBMaybeDocument message graph for each of them.
+ */
+- (FSTMaybeDocument *)decodedMaybeDocumentFromData:(NSData *)data;
+
 /** Encodes an FSTMutationBatch model for local storage in the mutation queue. */
 - (FSTPBWriteBatch *)encodedMutationBatch:(FSTMutationBatch *)batch;
 
@@ -18,11 +18,23 @@
 
 #include <inttypes.h>
 
+#include <string>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/model/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/remote/wire_decoder.h"
+#include "Firestore/core/src/firebase/firestore/remote/wire_reader.h"
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+#include "absl/strings/string_view.h"
+
 #import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
 #import "Firestore/Protos/objc/firestore/local/Mutation.pbobjc.h"
 #import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
 #import "Firestore/Protos/objc/google/firestore/v1beta1/Document.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Core/FSTSnapshotVersion.h"
+#import "Firestore/Source/Core/FSTTimestamp.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTFieldValue.h"
@@ -30,6 +42,34 @@
 #import "Firestore/Source/Remote/FSTSerializerBeta.h"
 #import "Firestore/Source/Util/FSTAssert.h"
 
+using firebase::firestore::model::FieldValue;
+using firebase::firestore::model::Timestamp;
+using firebase::firestore::remote::DecodedDocument;
+using firebase::firestore::remote::WireDecoder;
+using firebase::firestore::remote::WireReader;
+using firebase::firestore::remote::WireType;
+using firebase::firestore::util::MakeStringView;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** Field numbers of firestore.client.MaybeDocument and NoDocument. */
+static const uint32_t kMaybeDocumentNoDocumentField = 1;
+static const uint32_t kMaybeDocumentDocumentField = 2;
+static const uint32_t kNoDocumentNameField = 1;
+static const uint32_t kNoDocumentReadTimeField = 2;
+
+static NSString *MakeNSString(absl::string_view view) {
+  return [[NSString alloc] initWithBytes:view.data()
+                                  length:view.size()
+                                encoding:NSUTF8StringEncoding];
+}
+
+static FSTSnapshotVersion *MakeSnapshotVersion(const Timestamp &timestamp) {
+  return [FSTSnapshotVersion
+      versionWithTimestamp:[[FSTTimestamp alloc] initWithSeconds:timestamp.seconds()
+                                                           nanos:timestamp.nanos()]];
+}
+
 @interface FSTLocalSerializer ()
 
 @property(nonatomic, strong, readonly) FSTSerializerBeta *remoteSerializer;
@@ -74,6 +114,111 @@
   }
 }
 
+- (FSTMaybeDocument *)decodedMaybeDocumentFromData:(NSData *)data {
+  absl::string_view bytes{static_cast<const char *>(data.bytes), data.length};
+  FSTMaybeDocument *_Nullable maybeDocument = [self wireDecodedMaybeDocument:bytes];
+  if (maybeDocument) {
+    return maybeDocument;
+  }
+
+  // WireDecoder can't decode some values (e.g. references), so fall back to the generated protos.
+  NSError *error;
+  FSTPBMaybeDocument *proto = [FSTPBMaybeDocument parseFromData:data error:&error];
+  if (!proto) {
+    FSTFail(@"FSTPBMaybeDocument failed to parse: %@", error);
+  }
+  return [self decodedMaybeDocument:proto];
+}
+
+/**
+ * Decodes an FSTPBMaybeDocument directly from its wire format, or returns nil if WireDecoder can't
+ * handle its contents.
+ */
+- (nullable FSTMaybeDocument *)wireDecodedMaybeDocument:(absl::string_view)bytes {
+  WireReader reader{bytes};
+  FSTMaybeDocument *_Nullable result = nil;
+  while (!reader.done()) {
+    uint32_t fieldNumber;
+    WireType wireType;
+    if (!reader.ReadTag(&fieldNumber, &wireType)) {
+      return nil;
+    }
+    if (wireType == WireType::LengthDelimited && (fieldNumber == kMaybeDocumentDocumentField ||
+                                                  fieldNumber == kMaybeDocumentNoDocumentField)) {
+      absl::string_view nested;
+      if (!reader.ReadLengthDelimited(&nested)) {
+        return nil;
+      }
+      // The last member of the oneof wins, as it does for the generated protos.
+      if (fieldNumber == kMaybeDocumentDocumentField) {
+        result = [self wireDecodedDocument:nested];
+      } else {
+        result = [self wireDecodedDeletedDocument:nested];
+      }
+      if (!result) {
+        return nil;
+      }
+    } else if (!reader.SkipField(wireType)) {
+      return nil;
+    }
+  }
+  return result;
+}
+
+- (nullable FSTDocument *)wireDecodedDocument:(absl::string_view)bytes {
+  DecodedDocument document;
+  if (!WireDecoder::DecodeDocument(bytes, &document)) {
+    return nil;
+  }
+
+  FSTDocumentKey *key = [self.remoteSerializer decodedDocumentKey:MakeNSString(document.name)];
+  FSTSnapshotVersion *version = MakeSnapshotVersion(document.update_time);
+
+  // The decoded fields are compact C++ values that share their payloads when copied, so keep them
+  // and convert fields to FSTFieldValues only as they're needed.
+  FieldValue data = std::move(document.data);
+  return [FSTDocument documentWithKey:key
+      version:version
+      hasLocalMutations:NO
+      fieldDecoder:^FSTFieldValue *_Nullable(NSString *fieldName) {
+        const FieldValue::Map &fields = data.object_value();
+        auto found = fields.find(std::string{MakeStringView(fieldName)});
+        return found == fields.end() ? nil : [FSTFieldValue fieldValueWithModelValue:found->second];
+      }
+      dataDecoder:^FSTObjectValue * {
+        return (FSTObjectValue *)[FSTFieldValue fieldValueWithModelValue:data];
+      }];
+}
+
+- (nullable FSTDeletedDocument *)wireDecodedDeletedDocument:(absl::string_view)bytes {
+  WireReader reader{bytes};
+  absl::string_view name;
+  Timestamp readTime;
+  while (!reader.done()) {
+    uint32_t fieldNumber;
+    WireType wireType;
+    if (!reader.ReadTag(&fieldNumber, &wireType)) {
+      return nil;
+    }
+    if (wireType == WireType::LengthDelimited && fieldNumber == kNoDocumentNameField) {
+      if (!reader.ReadLengthDelimited(&name)) {
+        return nil;
+      }
+    } else if (wireType == WireType::LengthDelimited && fieldNumber == kNoDocumentReadTimeField) {
+      absl::string_view nested;
+      if (!reader.ReadLengthDelimited(&nested) ||
+          !WireDecoder::DecodeTimestamp(nested, &readTime)) {
+        return nil;
+      }
+    } else if (!reader.SkipField(wireType)) {
+      return nil;
+    }
+  }
+
+  FSTDocumentKey *key = [self.remoteSerializer decodedDocumentKey:MakeNSString(name)];
+  return [FSTDeletedDocument documentWithKey:key version:MakeSnapshotVersion(readTime)];
+}
+
 /**
  * Encodes a Document for local storage. This differs from the v1beta1 RPC serializer for
  * Documents in that it preserves the updateTime, which is considered an output only value by the
@@ -94,10 +239,22 @@
 - (FSTDocument *)decodedDocument:(GCFSDocument *)document {
   FSTSerializerBeta *remoteSerializer = self.remoteSerializer;
 
-  FSTObjectValue *data = [remoteSerializer decodedFields:document.fields];
   FSTDocumentKey *key = [remoteSerializer decodedDocumentKey:document.name];
   FSTSnapshotVersion *version = [remoteSerializer decodedVersion:document.updateTime];
-  return [FSTDocument documentWithData:data key:key version:version hasLocalMutations:NO];
+
+  // Queries often look at only a few fields of each document they read, so the fields are decoded
+  // as they're needed.
+  NSDictionary<NSString *, GCFSValue *> *fields = document.fields;
+  return [FSTDocument documentWithKey:key
+      version:version
+      hasLocalMutations:NO
+      fieldDecoder:^FSTFieldValue *_Nullable(NSString *fieldName) {
+        GCFSValue *_Nullable value = fields[fieldName];
+        return value ? [remoteSerializer decodedFieldValue:value] : nil;
+      }
+      dataDecoder:^FSTObjectValue * {
+        return [remoteSerializer decodedFields:fields];
+      }];
 }
 
 /** Encodes a NoDocument value to the equivalent proto. */
@@ -211,3 +368,5 @@
 }
 
 @end
+
+NS_ASSUME_NONNULL_END
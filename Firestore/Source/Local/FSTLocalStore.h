@@ -20,7 +20,9 @@
 #import "Firestore/Source/Model/FSTDocumentDictionary.h"
 #import "Firestore/Source/Model/FSTDocumentKeySet.h"
 #import "Firestore/Source/Model/FSTDocumentVersionDictionary.h"
+#import "Firestore/Source/Model/FSTMemoryUsage.h"
 
+@class FSTBundleReader;
 @class FSTLocalViewChanges;
 @class FSTLocalWriteResult;
 @class FSTMutation;
@@ -101,9 +103,35 @@ NS_ASSUME_NONNULL_BEGIN
 /** Accepts locally generated Mutations and commits them to storage. */
 - (FSTLocalWriteResult *)locallyWriteMutations:(NSArray<FSTMutation *> *)mutations;
 
+/**
+ * Folds locally generated Mutations into the existing batch with the given batchID instead of
+ * adding a new batch. This only succeeds if the batch is the last one in the queue, has not been
+ * acknowledged, and each of its mutations can absorb the corresponding new mutation (see
+ * -[FSTMutation mutationBySquashingMutation:]). The caller must ensure the batch has not been sent
+ * to the backend.
+ *
+ * @return The result of the write, or nil if the mutations could not be squashed, in which case
+ *     nothing was changed.
+ */
+- (nullable FSTLocalWriteResult *)locallySquashMutations:(NSArray<FSTMutation *> *)mutations
+                                             intoBatchID:(FSTBatchID)batchID;
+
 /** Returns the current value of a document with a given key, or nil if not found. */
 - (nullable FSTMaybeDocument *)readDocument:(FSTDocumentKey *)key;
 
+/**
+ * Returns the current values of the documents with the given keys, read in one batch. Documents
+ * that aren't found are returned as FSTDeletedDocuments.
+ */
+- (FSTMaybeDocumentDictionary *)readDocuments:(FSTDocumentKeySet *)keys;
+
+/**
+ * Applies the pending mutations to documents read from the backend outside of a listen, returning
+ * their current values as readDocuments: would if the given versions were cached.
+ */
+- (FSTMaybeDocumentDictionary *)localDocumentsForRemoteDocuments:
+    (NSArray<FSTMaybeDocument *> *)documents;
+
 /**
  * Acknowledges the given batch.
  *
@@ -119,6 +147,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (FSTMaybeDocumentDictionary *)acknowledgeBatchWithResult:(FSTMutationBatchResult *)batchResult;
 
+/**
+ * Acknowledges the given batches, in order, as if by acknowledgeBatchWithResult: but in a single
+ * write group and with a single recalculation of the affected documents.
+ *
+ * @return The resulting (modified) documents.
+ */
+- (FSTMaybeDocumentDictionary *)acknowledgeBatchesWithResults:
+    (NSArray<FSTMutationBatchResult *> *)batchResults;
+
 /**
  * Removes mutations from the MutationQueue for the specified batch. LocalDocuments will be
  * recalculated.
@@ -152,12 +189,40 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (FSTMaybeDocumentDictionary *)applyRemoteEvent:(FSTRemoteEvent *)remoteEvent;
 
+/**
+ * Loads the queries and documents of a bundle into the remote document cache and the query cache,
+ * as if they had been received from the backend at the bundle's read times. Documents replace
+ * cached ones only if they aren't older. Queries that are being listened to or that were cached
+ * at a later read time keep their results. Listens to the other bundled queries later resume from
+ * the bundle's resume tokens.
+ *
+ * The bundle is written in groups of documents rather than all at once, so if it is malformed the
+ * elements before the malformed one remain loaded.
+ *
+ * @param error Set if the bundle is malformed.
+ * @return The documents changed by the elements loaded.
+ */
+- (FSTMaybeDocumentDictionary *)loadBundle:(FSTBundleReader *)bundle
+                                     error:(NSError *_Nullable *_Nonnull)error;
+
 /**
  * Returns the keys of the documents that are associated with the given targetID in the remote
  * table.
  */
 - (FSTDocumentKeySet *)remoteDocumentKeysForTarget:(FSTTargetID)targetID;
 
+/** Returns the cached remote documents held in memory and the approximate bytes they take up. */
+- (FSTMemoryUsage)remoteDocumentMemoryUsage;
+
+/** Returns the references from local views that keep documents from being garbage collected. */
+- (FSTMemoryUsage)localViewReferenceMemoryUsage;
+
+/**
+ * Drops whatever is held in memory that can be read back from persistence, e.g. in response to a
+ * memory warning.
+ */
+- (void)releaseCachedMemory;
+
 /**
  * Collects garbage if necessary.
  *
@@ -166,6 +231,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)collectGarbage;
 
+/**
+ * Collects garbage for at most about the given time, leaving the rest for later calls, so that
+ * collecting a lot of garbage doesn't hold up other work. Does nothing after -shutdown.
+ *
+ * @param timeLimit The time, in seconds, to spend checking potential garbage.
+ * @return Whether there is potential garbage left to check.
+ */
+- (BOOL)collectGarbageWithTimeLimit:(NSTimeInterval)timeLimit;
+
 /**
  * Assigns @a query an internal ID so that its results can be pinned so they don't get GC'd.
  * A query must be allocated in the local store before the store can be used to manage its view.
@@ -175,9 +249,34 @@ NS_ASSUME_NONNULL_BEGIN
 /** Unpin all the documents associated with @a query. */
 - (void)releaseQuery:(FSTQuery *)query;
 
+/**
+ * Keeps the cached results of @a query from being garbage collected until @a expiryDate, even
+ * once it's released, so that it can still be read offline. The query must have been allocated.
+ * Pinning an already pinned query only ever extends its pin. Pins last until the store is shut
+ * down; they are not persisted.
+ */
+- (void)pinQuery:(FSTQuery *)query untilDate:(NSDate *)expiryDate;
+
 /** Runs @a query against all the documents in the local store and returns the results. */
 - (FSTDocumentDictionary *)executeQuery:(FSTQuery *)query;
 
+/**
+ * Returns the number of documents in the local store that match @a query. If the query has no
+ * limit and its target is cached with a consistent snapshot from the backend, the count is based
+ * on the target's remote keys, and only the documents that pending mutations affect are read.
+ * Otherwise the query is run against all the documents in the local store.
+ */
+- (NSUInteger)countOfDocumentsMatchingQuery:(FSTQuery *)query;
+
+/**
+ * Runs @a query against a snapshot of the local documents, taken on the first call after an
+ * operation changed them, and returns the results. Unlike the other methods this may be called on
+ * any queue, so that reads of the cache don't wait behind queued writes and remote events; they
+ * may miss those, though, and wait for an operation that's changing documents to finish. Returns
+ * no results until the store has started or after it's shut down.
+ */
+- (FSTDocumentDictionary *)executeQueryInReadView:(FSTQuery *)query;
+
 /** Notify the local store of the changed views to locally pin / unpin documents. */
 - (void)notifyLocalViewChanges:(NSArray<FSTLocalViewChanges *> *)viewChanges;
 
@@ -21,6 +21,7 @@
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Core/FSTSnapshotVersion.h"
 #import "Firestore/Source/Core/FSTTimestamp.h"
+#import "Firestore/Source/Local/FSTBundle.h"
 #import "Firestore/Source/Local/FSTGarbageCollector.h"
 #import "Firestore/Source/Local/FSTLocalDocumentsView.h"
 #import "Firestore/Source/Local/FSTLocalViewChanges.h"
@@ -32,6 +33,7 @@
 #import "Firestore/Source/Local/FSTReferenceSet.h"
 #import "Firestore/Source/Local/FSTRemoteDocumentCache.h"
 #import "Firestore/Source/Local/FSTRemoteDocumentChangeBuffer.h"
+#import "Firestore/Source/Local/FSTWriteGroup.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTDocumentDictionary.h"
 #import "Firestore/Source/Model/FSTDocumentKey.h"
@@ -42,9 +44,22 @@
 #import "Firestore/Source/Util/FSTLogger.h"
 
 #include "Firestore/core/src/firebase/firestore/core/target_id_generator.h"
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
+
+namespace model = firebase::firestore::model;
+namespace util = firebase::firestore::util;
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ * The number of target IDs and listen sequence numbers reserved at a time. Each reservation is
+ * persisted in the query cache metadata, so new targets only rewrite it once per block.
+ */
+static const int kReservationBlockSize = 100;
+
+/** The number of bundled documents written to persistence together. */
+static const NSUInteger kBundleDocumentsPerGroup = 1000;
+
 @interface FSTLocalStore ()
 
 /** Manages our in-memory or durable persistence. */
@@ -75,8 +90,17 @@ NS_ASSUME_NONNULL_BEGIN
 /** Maps a targetID to data about its query. */
 @property(nonatomic, strong) NSMutableDictionary<NSNumber *, FSTQueryData *> *targetIDs;
 
+/** The queries kept from garbage collection by pinQuery:untilDate:, indexed by target ID. */
+@property(nonatomic, strong) NSMutableDictionary<NSNumber *, FSTQueryData *> *pinnedQueries;
+
+/** The dates until which the queries in pinnedQueries are kept, indexed by target ID. */
+@property(nonatomic, strong) NSMutableDictionary<NSNumber *, NSDate *> *pinExpiryDates;
+
 @property(nonatomic, strong) FSTListenSequence *listenSequence;
 
+/** Whether -shutdown has been called, after which time-sliced garbage collection does nothing. */
+@property(nonatomic, assign, getter=isShutDown) BOOL shutDown;
+
 /**
  * A heldBatchResult is a mutation batch result (from a write acknowledgement) that arrived before
  * the watch stream got notified of a snapshot that includes the write.  So we "hold" it until
@@ -88,6 +112,26 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nonatomic, strong) NSMutableArray<FSTMutationBatchResult *> *heldBatchResults;
 
+/**
+ * Guards readView and readViewIsStale, which executeQueryInReadView: reads on other queues. Every
+ * operation that changes documents holds it throughout, so that the read view is never built
+ * from a partially applied change.
+ */
+@property(nonatomic, strong, readonly) NSObject *readViewLock;
+
+/**
+ * A snapshot of localDocuments for executeQueryInReadView:, built on the first read after an
+ * operation changed documents rather than after every change. The snapshot itself is read under
+ * @synchronized on it. Guarded by readViewLock.
+ */
+@property(nonatomic, strong, nullable) FSTLocalDocumentsView *readView;
+
+/** The remote document cache snapshot read by readView. Guarded by readViewLock. */
+@property(nonatomic, strong, nullable) id<FSTRemoteDocumentCache> readViewDocumentCache;
+
+/** Whether documents have changed since readView was built. Guarded by readViewLock. */
+@property(nonatomic, assign) BOOL readViewIsStale;
+
 @end
 
 @implementation FSTLocalStore {
@@ -113,7 +157,10 @@ NS_ASSUME_NONNULL_BEGIN
     [_garbageCollector addGarbageSource:_mutationQueue];
 
     _targetIDs = [NSMutableDictionary dictionary];
+    _pinnedQueries = [NSMutableDictionary dictionary];
+    _pinExpiryDates = [NSMutableDictionary dictionary];
     _heldBatchResults = [NSMutableArray array];
+    _readViewLock = [[NSObject alloc] init];
 
     _targetIDGenerator =
         firebase::firestore::core::TargetIdGenerator::LocalStoreTargetIdGenerator(0);
@@ -124,6 +171,9 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)start {
   [self startMutationQueue];
   [self startQueryCache];
+  @synchronized(self.readViewLock) {
+    [self publishReadView];
+  }
 }
 
 - (void)startMutationQueue {
@@ -161,99 +211,194 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (void)shutdown {
+  FSTLocalDocumentsView *_Nullable readView;
+  id<FSTRemoteDocumentCache> _Nullable readViewDocumentCache;
+  @synchronized(self.readViewLock) {
+    self.shutDown = YES;
+    readView = self.readView;
+    readViewDocumentCache = self.readViewDocumentCache;
+    self.readView = nil;
+    self.readViewDocumentCache = nil;
+  }
+  if (readView) {
+    // Wait for any read in progress, then drop the snapshot so it doesn't keep the database open.
+    @synchronized(readView) {
+      [readViewDocumentCache shutdown];
+    }
+  }
   [self.mutationQueue shutdown];
   [self.remoteDocumentCache shutdown];
   [self.queryCache shutdown];
 }
 
 - (FSTMaybeDocumentDictionary *)userDidChange:(FSTUser *)user {
-  // Swap out the mutation queue, grabbing the pending mutation batches before and after.
-  NSArray<FSTMutationBatch *> *oldBatches = [self.mutationQueue allMutationBatches];
+  __block FSTMaybeDocumentDictionary *result;
+  [self runDocumentChange:^{
+    // Swap out the mutation queue, grabbing the keys of the pending mutations before and after.
+    // These come straight from the document-mutation index, without decoding any batches.
+    FSTDocumentKeySet *oldKeys = [self.mutationQueue allMutatedDocumentKeys];
 
-  [self.mutationQueue shutdown];
-  [self.garbageCollector removeGarbageSource:self.mutationQueue];
+    [self.mutationQueue shutdown];
+    [self.garbageCollector removeGarbageSource:self.mutationQueue];
 
-  self.mutationQueue = [self.persistence mutationQueueForUser:user];
-  [self.garbageCollector addGarbageSource:self.mutationQueue];
+    self.mutationQueue = [self.persistence mutationQueueForUser:user];
+    [self.garbageCollector addGarbageSource:self.mutationQueue];
 
-  [self startMutationQueue];
+    [self startMutationQueue];
 
-  NSArray<FSTMutationBatch *> *newBatches = [self.mutationQueue allMutationBatches];
+    FSTDocumentKeySet *newKeys = [self.mutationQueue allMutatedDocumentKeys];
 
-  // Recreate our LocalDocumentsView using the new MutationQueue.
-  self.localDocuments = [FSTLocalDocumentsView viewWithRemoteDocumentCache:self.remoteDocumentCache
-                                                             mutationQueue:self.mutationQueue];
+    // Recreate our LocalDocumentsView using the new MutationQueue.
+    self.localDocuments =
+        [FSTLocalDocumentsView viewWithRemoteDocumentCache:self.remoteDocumentCache
+                                             mutationQueue:self.mutationQueue];
 
-  // Union the old/new changed keys.
-  FSTDocumentKeySet *changedKeys = [FSTDocumentKeySet keySet];
-  for (NSArray<FSTMutationBatch *> *batches in @[ oldBatches, newBatches ]) {
-    for (FSTMutationBatch *batch in batches) {
-      for (FSTMutation *mutation in batch.mutations) {
-        changedKeys = [changedKeys setByAddingObject:mutation.key];
-      }
+    // Union the old/new changed keys. A key both users have mutated may still read differently,
+    // so it can't be dropped just because it appears on both sides.
+    NSMutableSet<FSTDocumentKey *> *changedKeys = [NSMutableSet set];
+    for (FSTDocumentKeySet *keys in @[ oldKeys, newKeys ]) {
+      [keys enumerateObjectsUsingBlock:^(FSTDocumentKey *key, BOOL *stop) {
+        [changedKeys addObject:key];
+      }];
     }
-  }
 
-  // Return the set of all (potentially) changed documents as the result of the user change.
-  return [self.localDocuments documentsForKeys:changedKeys];
+    // Return the set of all (potentially) changed documents as the result of the user change.
+    result = [self.localDocuments documentsForKeys:[FSTDocumentKeySet keySetWithKeys:changedKeys]];
+
+    // Build the read view now: this loads the new view's overlay from the mutation queue, which
+    // executeQueryInReadView: can't read.
+    [self publishReadView];
+  }];
+  return result;
 }
 
 - (FSTLocalWriteResult *)locallyWriteMutations:(NSArray<FSTMutation *> *)mutations {
-  FSTWriteGroup *group = [self.persistence startGroupWithAction:@"Locally write mutations"];
-  FSTTimestamp *localWriteTime = [FSTTimestamp timestamp];
-  FSTMutationBatch *batch = [self.mutationQueue addMutationBatchWithWriteTime:localWriteTime
-                                                                    mutations:mutations
-                                                                        group:group];
-  [self.persistence commitGroup:group];
+  util::Trace(util::kTraceLocalWriteStart, (int64_t)mutations.count);
+  __block FSTLocalWriteResult *result;
+  [self runDocumentChange:^{
+    FSTWriteGroup *group = [self.persistence startGroupWithAction:@"Locally write mutations"];
+    // Until the server acknowledges them, local writes exist nowhere else, so make sure they reach
+    // the disk. Syncing is coalesced so that bursts of writes share a sync.
+    group.durability = FSTWriteDurabilityCoalescedSync;
+    FSTTimestamp *localWriteTime = [FSTTimestamp timestamp];
+    FSTMutationBatch *batch = [self.mutationQueue addMutationBatchWithWriteTime:localWriteTime
+                                                                      mutations:mutations
+                                                                          group:group];
+    [self.persistence commitGroup:group];
+    [self.localDocuments addMutationBatch:batch];
+
+    FSTDocumentKeySet *keys = [batch keys];
+    FSTMaybeDocumentDictionary *changedDocuments = [self.localDocuments documentsForKeys:keys];
+    result = [FSTLocalWriteResult resultForBatchID:batch.batchID changes:changedDocuments];
+  }];
+  util::Trace(util::kTraceLocalWriteFinish, result.batchID);
+  return result;
+}
+
+- (nullable FSTLocalWriteResult *)locallySquashMutations:(NSArray<FSTMutation *> *)mutations
+                                             intoBatchID:(FSTBatchID)batchID {
+  __block FSTLocalWriteResult *result;
+  [self runDocumentChange:^{
+    id<FSTMutationQueue> mutationQueue = self.mutationQueue;
+    FSTMutationBatch *existing = [mutationQueue lookupMutationBatch:batchID];
+    if (!existing || batchID <= [mutationQueue highestAcknowledgedBatchID] ||
+        [mutationQueue nextMutationBatchAfterBatchID:batchID] ||
+        existing.mutations.count != mutations.count) {
+      return;
+    }
+
+    NSMutableArray<FSTMutation *> *squashed = [NSMutableArray arrayWithCapacity:mutations.count];
+    for (NSUInteger i = 0; i < mutations.count; i++) {
+      FSTMutation *previous = existing.mutations[i];
+      if (![previous.key isEqual:mutations[i].key]) {
+        return;
+      }
+      FSTMutation *mutation = [previous mutationBySquashingMutation:mutations[i]];
+      if (!mutation) {
+        return;
+      }
+      [squashed addObject:mutation];
+    }
 
-  FSTDocumentKeySet *keys = [batch keys];
-  FSTMaybeDocumentDictionary *changedDocuments = [self.localDocuments documentsForKeys:keys];
-  return [FSTLocalWriteResult resultForBatchID:batch.batchID changes:changedDocuments];
+    FSTWriteGroup *group = [self.persistence startGroupWithAction:@"Locally squash mutations"];
+    group.durability = FSTWriteDurabilityCoalescedSync;
+    FSTMutationBatch *batch =
+        [mutationQueue replaceMutationsOfLastBatch:existing withMutations:squashed group:group];
+    [self.persistence commitGroup:group];
+    [self.localDocuments removeMutationBatches:@[ existing ]];
+    [self.localDocuments addMutationBatch:batch];
+
+    FSTDocumentKeySet *keys = [batch keys];
+    FSTMaybeDocumentDictionary *changedDocuments = [self.localDocuments documentsForKeys:keys];
+    result = [FSTLocalWriteResult resultForBatchID:batch.batchID changes:changedDocuments];
+  }];
+  return result;
 }
 
 - (FSTMaybeDocumentDictionary *)acknowledgeBatchWithResult:(FSTMutationBatchResult *)batchResult {
-  FSTWriteGroup *group = [self.persistence startGroupWithAction:@"Acknowledge batch"];
-  id<FSTMutationQueue> mutationQueue = self.mutationQueue;
+  return [self acknowledgeBatchesWithResults:@[ batchResult ]];
+}
 
-  [mutationQueue acknowledgeBatch:batchResult.batch
-                      streamToken:batchResult.streamToken
-                            group:group];
+- (FSTMaybeDocumentDictionary *)acknowledgeBatchesWithResults:
+    (NSArray<FSTMutationBatchResult *> *)batchResults {
+  __block FSTMaybeDocumentDictionary *result;
+  [self runDocumentChange:^{
+    FSTWriteGroup *group = [self.persistence startGroupWithAction:@"Acknowledge batches"];
+    id<FSTMutationQueue> mutationQueue = self.mutationQueue;
+
+    NSMutableArray<FSTMutationBatchResult *> *toRelease = [NSMutableArray array];
+    for (FSTMutationBatchResult *batchResult in batchResults) {
+      [mutationQueue acknowledgeBatch:batchResult.batch
+                          streamToken:batchResult.streamToken
+                                group:group];
+
+      // Once one result is held, all the ones after it are too, so they're released in order.
+      if ([self shouldHoldBatchResultWithVersion:batchResult.commitVersion]) {
+        [self.heldBatchResults addObject:batchResult];
+      } else {
+        [toRelease addObject:batchResult];
+      }
+    }
 
-  FSTDocumentKeySet *affected;
-  if ([self shouldHoldBatchResultWithVersion:batchResult.commitVersion]) {
-    [self.heldBatchResults addObject:batchResult];
-    affected = [FSTDocumentKeySet keySet];
-  } else {
-    FSTRemoteDocumentChangeBuffer *remoteDocuments =
-        [FSTRemoteDocumentChangeBuffer changeBufferWithCache:self.remoteDocumentCache];
+    FSTDocumentKeySet *affected;
+    if (toRelease.count == 0) {
+      affected = [FSTDocumentKeySet keySet];
+    } else {
+      FSTRemoteDocumentChangeBuffer *remoteDocuments =
+          [FSTRemoteDocumentChangeBuffer changeBufferWithCache:self.remoteDocumentCache];
 
-    affected =
-        [self releaseBatchResults:@[ batchResult ] group:group remoteDocuments:remoteDocuments];
+      affected = [self releaseBatchResults:toRelease group:group remoteDocuments:remoteDocuments];
 
-    [remoteDocuments applyToWriteGroup:group];
-  }
+      [remoteDocuments applyToWriteGroup:group];
+    }
 
-  [self.persistence commitGroup:group];
-  [self.mutationQueue performConsistencyCheck];
+    [self.persistence commitGroup:group];
+    [self.mutationQueue performConsistencyCheck];
 
-  return [self.localDocuments documentsForKeys:affected];
+    result = [self.localDocuments documentsForKeys:affected];
+  }];
+  return result;
 }
 
 - (FSTMaybeDocumentDictionary *)rejectBatchID:(FSTBatchID)batchID {
-  FSTWriteGroup *group = [self.persistence startGroupWithAction:@"Reject batch"];
+  __block FSTMaybeDocumentDictionary *result;
+  [self runDocumentChange:^{
+    FSTWriteGroup *group = [self.persistence startGroupWithAction:@"Reject batch"];
 
-  FSTMutationBatch *toReject = [self.mutationQueue lookupMutationBatch:batchID];
-  FSTAssert(toReject, @"Attempt to reject nonexistent batch!");
+    FSTMutationBatch *toReject = [self.mutationQueue lookupMutationBatch:batchID];
+    FSTAssert(toReject, @"Attempt to reject nonexistent batch!");
 
-  FSTBatchID lastAcked = [self.mutationQueue highestAcknowledgedBatchID];
-  FSTAssert(batchID > lastAcked, @"Acknowledged batches can't be rejected.");
+    FSTBatchID lastAcked = [self.mutationQueue highestAcknowledgedBatchID];
+    FSTAssert(batchID > lastAcked, @"Acknowledged batches can't be rejected.");
 
-  FSTDocumentKeySet *affected = [self removeMutationBatch:toReject group:group];
+    FSTDocumentKeySet *affected = [self removeMutationBatch:toReject group:group];
 
-  [self.persistence commitGroup:group];
-  [self.mutationQueue performConsistencyCheck];
+    [self.persistence commitGroup:group];
+    [self.mutationQueue performConsistencyCheck];
 
-  return [self.localDocuments documentsForKeys:affected];
+    result = [self.localDocuments documentsForKeys:affected];
+  }];
+  return result;
 }
 
 - (nullable NSData *)lastStreamToken {
@@ -272,100 +417,219 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (FSTMaybeDocumentDictionary *)applyRemoteEvent:(FSTRemoteEvent *)remoteEvent {
-  id<FSTQueryCache> queryCache = self.queryCache;
+  util::Trace(util::kTraceRemoteEventStart, (int64_t)remoteEvent.documentUpdates.count);
+  __block FSTMaybeDocumentDictionary *result;
+  [self runDocumentChange:^{
+    id<FSTQueryCache> queryCache = self.queryCache;
+
+    FSTWriteGroup *group = [self.persistence startGroupWithAction:@"Apply remote event"];
+    FSTRemoteDocumentChangeBuffer *remoteDocuments =
+        [FSTRemoteDocumentChangeBuffer changeBufferWithCache:self.remoteDocumentCache];
 
-  FSTWriteGroup *group = [self.persistence startGroupWithAction:@"Apply remote event"];
-  FSTRemoteDocumentChangeBuffer *remoteDocuments =
-      [FSTRemoteDocumentChangeBuffer changeBufferWithCache:self.remoteDocumentCache];
+    [remoteEvent.targetChanges enumerateKeysAndObjectsUsingBlock:^(
+                                   NSNumber *targetIDNumber, FSTTargetChange *change, BOOL *stop) {
+      FSTTargetID targetID = targetIDNumber.intValue;
 
-  [remoteEvent.targetChanges enumerateKeysAndObjectsUsingBlock:^(
-                                 NSNumber *targetIDNumber, FSTTargetChange *change, BOOL *stop) {
-    FSTTargetID targetID = targetIDNumber.intValue;
+      // Do not ref/unref unassigned targetIDs - it may lead to leaks.
+      FSTQueryData *queryData = self.targetIDs[targetIDNumber];
+      if (!queryData) {
+        return;
+      }
 
-    // Do not ref/unref unassigned targetIDs - it may lead to leaks.
-    FSTQueryData *queryData = self.targetIDs[targetIDNumber];
-    if (!queryData) {
-      return;
-    }
+      FSTTargetMapping *mapping = change.mapping;
+      if (mapping) {
+        // First make sure that all references are deleted.
+        if ([mapping isKindOfClass:[FSTResetMapping class]]) {
+          FSTResetMapping *reset = (FSTResetMapping *)mapping;
+          [queryCache removeMatchingKeysForTargetID:targetID group:group];
+          [queryCache addMatchingKeys:reset.documents forTargetID:targetID group:group];
 
-    FSTTargetMapping *mapping = change.mapping;
-    if (mapping) {
-      // First make sure that all references are deleted.
-      if ([mapping isKindOfClass:[FSTResetMapping class]]) {
-        FSTResetMapping *reset = (FSTResetMapping *)mapping;
-        [queryCache removeMatchingKeysForTargetID:targetID group:group];
-        [queryCache addMatchingKeys:reset.documents forTargetID:targetID group:group];
+        } else if ([mapping isKindOfClass:[FSTUpdateMapping class]]) {
+          FSTUpdateMapping *update = (FSTUpdateMapping *)mapping;
+          [queryCache removeMatchingKeys:update.removedDocuments forTargetID:targetID group:group];
+          [queryCache addMatchingKeys:update.addedDocuments forTargetID:targetID group:group];
 
-      } else if ([mapping isKindOfClass:[FSTUpdateMapping class]]) {
-        FSTUpdateMapping *update = (FSTUpdateMapping *)mapping;
-        [queryCache removeMatchingKeys:update.removedDocuments forTargetID:targetID group:group];
-        [queryCache addMatchingKeys:update.addedDocuments forTargetID:targetID group:group];
+        } else {
+          FSTFail(@"Unknown mapping type: %@", mapping);
+        }
+      }
 
+      // Update the resume token if the change includes one. Don't clear any preexisting value.
+      NSData *resumeToken = change.resumeToken;
+      if (resumeToken.length > 0) {
+        queryData = [queryData queryDataByReplacingSnapshotVersion:change.snapshotVersion
+                                                       resumeToken:resumeToken];
+        self.targetIDs[targetIDNumber] = queryData;
+        [self.queryCache addQueryData:queryData group:group];
+      }
+    }];
+
+    // Collect the changed keys in a mutable set and sort them only once they're all known.
+    NSMutableSet<FSTDocumentKey *> *changedDocKeys =
+        [NSMutableSet setWithArray:remoteEvent.documentUpdates.allKeys];
+
+    // Read the cached versions of all the updated documents in one sorted pass over the cache
+    // rather than one lookup per document.
+    [remoteDocuments prefetchEntriesForKeys:[FSTDocumentKeySet keySetWithKeys:changedDocKeys]];
+
+    [remoteEvent.documentUpdates enumerateKeysAndObjectsUsingBlock:^(
+                                     FSTDocumentKey *key, FSTMaybeDocument *doc, BOOL *stop) {
+      FSTMaybeDocument *existingDoc = [remoteDocuments entryForKey:key];
+      // Make sure we don't apply an old document version to the remote cache, though we
+      // make an exception for [SnapshotVersion noVersion] which can happen for manufactured
+      // events (e.g. in the case of a limbo document resolution failing).
+      model::SnapshotVersion version = doc.version.value;
+      if (!existingDoc || version == model::SnapshotVersion::None() ||
+          version >= existingDoc.version.value) {
+        [remoteDocuments addEntry:doc];
       } else {
-        FSTFail(@"Unknown mapping type: %@", mapping);
+        FSTLog(
+            @"FSTLocalStore Ignoring outdated watch update for %@. "
+             "Current version: %@  Watch version: %@",
+            key, existingDoc.version, doc.version);
       }
-    }
 
-    // Update the resume token if the change includes one. Don't clear any preexisting value.
-    NSData *resumeToken = change.resumeToken;
-    if (resumeToken.length > 0) {
-      queryData = [queryData queryDataByReplacingSnapshotVersion:change.snapshotVersion
-                                                     resumeToken:resumeToken];
-      self.targetIDs[targetIDNumber] = queryData;
-      [self.queryCache addQueryData:queryData group:group];
+      // The document might be garbage because it was unreferenced by everything.
+      // Make sure to mark it as garbage if it is...
+      [self.garbageCollector addPotentialGarbageKey:key];
+    }];
+
+    // HACK: The only reason we allow omitting snapshot version is so we can synthesize remote
+    // events when we get permission denied errors while trying to resolve the state of a locally
+    // cached document that is in limbo.
+    FSTSnapshotVersion *lastRemoteVersion = [self.queryCache lastRemoteSnapshotVersion];
+    FSTSnapshotVersion *remoteVersion = remoteEvent.snapshotVersion;
+    if (remoteVersion.value != model::SnapshotVersion::None()) {
+      FSTAssert(remoteVersion.value >= lastRemoteVersion.value,
+                @"Watch stream reverted to previous snapshot?? (%@ < %@)", remoteVersion,
+                lastRemoteVersion);
+      [self.queryCache setLastRemoteSnapshotVersion:remoteVersion group:group];
     }
+
+    FSTDocumentKeySet *releasedWriteKeys =
+        [self releaseHeldBatchResultsWithGroup:group remoteDocuments:remoteDocuments];
+
+    [remoteDocuments applyToWriteGroup:group];
+
+    [self.persistence commitGroup:group];
+
+    // Union the two key sets.
+    [releasedWriteKeys enumerateObjectsUsingBlock:^(FSTDocumentKey *key, BOOL *stop) {
+      [changedDocKeys addObject:key];
+    }];
+
+    FSTDocumentKeySet *keysToRecalc = [FSTDocumentKeySet keySetWithKeys:changedDocKeys];
+    result = [self.localDocuments documentsForKeys:keysToRecalc];
   }];
+  util::Trace(util::kTraceRemoteEventFinish);
+  return result;
+}
 
-  // TODO(klimt): This could probably be an NSMutableDictionary.
-  __block FSTDocumentKeySet *changedDocKeys = [FSTDocumentKeySet keySet];
-  [remoteEvent.documentUpdates
-      enumerateKeysAndObjectsUsingBlock:^(FSTDocumentKey *key, FSTMaybeDocument *doc, BOOL *stop) {
-        changedDocKeys = [changedDocKeys setByAddingObject:key];
-        FSTMaybeDocument *existingDoc = [remoteDocuments entryForKey:key];
-        // Make sure we don't apply an old document version to the remote cache, though we
-        // make an exception for [SnapshotVersion noVersion] which can happen for manufactured
-        // events (e.g. in the case of a limbo document resolution failing).
-        if (!existingDoc || [doc.version isEqual:[FSTSnapshotVersion noVersion]] ||
-            [doc.version compare:existingDoc.version] != NSOrderedAscending) {
-          [remoteDocuments addEntry:doc];
-        } else {
-          FSTLog(
-              @"FSTLocalStore Ignoring outdated watch update for %@. "
-               "Current version: %@  Watch version: %@",
-              key, existingDoc.version, doc.version);
-        }
+- (FSTMaybeDocumentDictionary *)loadBundle:(FSTBundleReader *)bundle
+                                     error:(NSError *_Nullable *_Nonnull)error {
+  NSMutableSet<FSTDocumentKey *> *changedDocKeys = [NSMutableSet set];
+  __block NSError *readError = nil;
+  __block FSTMaybeDocumentDictionary *result;
+  [self runDocumentChange:^{
+    FSTWriteGroup *group = [self.persistence startGroupWithAction:@"Load bundle"];
+    FSTRemoteDocumentChangeBuffer *remoteDocuments =
+        [FSTRemoteDocumentChangeBuffer changeBufferWithCache:self.remoteDocumentCache];
+    NSUInteger documentsInGroup = 0;
+
+    // The query whose results are being read, unless the cache keeps its own results for it, and
+    // the keys of its documents read since they were last written.
+    FSTQueryData *_Nullable bundledQuery = nil;
+    NSMutableSet<FSTDocumentKey *> *matchingKeys = [NSMutableSet set];
+
+    while (!bundle.isAtEnd) {
+      NSError *elementError;
+      id element = [bundle readNextElement:&elementError];
+      if (!element) {
+        readError = elementError;
+        break;
+      }
 
-        // The document might be garbage because it was unreferenced by everything.
-        // Make sure to mark it as garbage if it is...
-        [self.garbageCollector addPotentialGarbageKey:key];
-      }];
+      if ([element isKindOfClass:[FSTQueryData class]]) {
+        [self addMatchingKeys:matchingKeys forQueryData:bundledQuery group:group];
+        bundledQuery = [self queryDataForBundledQuery:element group:group];
+        continue;
+      }
 
-  // HACK: The only reason we allow omitting snapshot version is so we can synthesize remote events
-  // when we get permission denied errors while trying to resolve the state of a locally cached
-  // document that is in limbo.
-  FSTSnapshotVersion *lastRemoteVersion = [self.queryCache lastRemoteSnapshotVersion];
-  FSTSnapshotVersion *remoteVersion = remoteEvent.snapshotVersion;
-  if (![remoteVersion isEqual:[FSTSnapshotVersion noVersion]]) {
-    FSTAssert([remoteVersion compare:lastRemoteVersion] != NSOrderedAscending,
-              @"Watch stream reverted to previous snapshot?? (%@ < %@)", remoteVersion,
-              lastRemoteVersion);
-    [self.queryCache setLastRemoteSnapshotVersion:remoteVersion group:group];
-  }
+      FSTMaybeDocument *doc = element;
+      [changedDocKeys addObject:doc.key];
+      FSTMaybeDocument *existingDoc = [remoteDocuments entryForKey:doc.key];
+      if (!existingDoc || doc.version.value >= existingDoc.version.value) {
+        [remoteDocuments addEntry:doc];
+      }
+      [self.garbageCollector addPotentialGarbageKey:doc.key];
+      if (bundledQuery && [doc isKindOfClass:[FSTDocument class]]) {
+        [matchingKeys addObject:doc.key];
+      }
 
-  FSTDocumentKeySet *releasedWriteKeys =
-      [self releaseHeldBatchResultsWithGroup:group remoteDocuments:remoteDocuments];
+      if (++documentsInGroup == kBundleDocumentsPerGroup) {
+        [self addMatchingKeys:matchingKeys forQueryData:bundledQuery group:group];
+        [remoteDocuments applyToWriteGroup:group];
+        [self.persistence commitGroup:group];
 
-  [remoteDocuments applyToWriteGroup:group];
+        group = [self.persistence startGroupWithAction:@"Load bundle"];
+        remoteDocuments =
+            [FSTRemoteDocumentChangeBuffer changeBufferWithCache:self.remoteDocumentCache];
+        documentsInGroup = 0;
+      }
+    }
 
-  [self.persistence commitGroup:group];
+    [self addMatchingKeys:matchingKeys forQueryData:bundledQuery group:group];
+    [remoteDocuments applyToWriteGroup:group];
+    [self.persistence commitGroup:group];
 
-  // Union the two key sets.
-  __block FSTDocumentKeySet *keysToRecalc = changedDocKeys;
-  [releasedWriteKeys enumerateObjectsUsingBlock:^(FSTDocumentKey *key, BOOL *stop) {
-    keysToRecalc = [keysToRecalc setByAddingObject:key];
+    FSTDocumentKeySet *keysToRecalc = [FSTDocumentKeySet keySetWithKeys:changedDocKeys];
+    result = [self.localDocuments documentsForKeys:keysToRecalc];
   }];
+  *error = readError;
+  return result;
+}
+
+/**
+ * Records a query read from a bundle in the query cache, replacing the cached results for it.
+ *
+ * @return The cached query data for the query, or nil if the cache keeps its own results for it
+ *     because they are at least as recent as the bundled ones or it is being listened to.
+ */
+- (nullable FSTQueryData *)queryDataForBundledQuery:(FSTQueryData *)bundled
+                                              group:(FSTWriteGroup *)group {
+  FSTQueryData *cached = [self.queryCache queryDataForQuery:bundled.query];
+  FSTQueryData *queryData;
+  if (cached) {
+    if (self.targetIDs[@(cached.targetID)] ||
+        [cached.snapshotVersion compare:bundled.snapshotVersion] != NSOrderedAscending) {
+      return nil;
+    }
+    queryData = [cached queryDataByReplacingSnapshotVersion:bundled.snapshotVersion
+                                                resumeToken:bundled.resumeToken];
+    [self.queryCache removeMatchingKeysForTargetID:cached.targetID group:group];
+  } else {
+    FSTListenSequenceNumber sequenceNumber = [self nextListenSequenceNumberWithGroup:group];
+    queryData = [[FSTQueryData alloc] initWithQuery:bundled.query
+                                           targetID:[self nextTargetIDWithGroup:group]
+                               listenSequenceNumber:sequenceNumber
+                                            purpose:FSTQueryPurposeListen
+                                    snapshotVersion:bundled.snapshotVersion
+                                        resumeToken:bundled.resumeToken];
+  }
+  [self.queryCache addQueryData:queryData group:group];
+  return queryData;
+}
 
-  return [self.localDocuments documentsForKeys:keysToRecalc];
+/** Writes the keys of a bundled query's results read so far, and clears them. */
+- (void)addMatchingKeys:(NSMutableSet<FSTDocumentKey *> *)keys
+           forQueryData:(nullable FSTQueryData *)queryData
+                  group:(FSTWriteGroup *)group {
+  if (queryData && keys.count > 0) {
+    [self.queryCache addMatchingKeys:[FSTDocumentKeySet keySetWithKeys:keys]
+                         forTargetID:queryData.targetID
+                               group:group];
+  }
+  [keys removeAllObjects];
 }
 
 - (void)notifyLocalViewChanges:(NSArray<FSTLocalViewChanges *> *)viewChanges {
@@ -384,21 +648,58 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (nullable FSTMaybeDocument *)readDocument:(FSTDocumentKey *)key {
-  return [self.localDocuments documentForKey:key];
+  __block FSTMaybeDocument *result;
+  [self.persistence runReadTransaction:^{
+    result = [self.localDocuments documentForKey:key];
+  }];
+  return result;
+}
+
+- (FSTMaybeDocumentDictionary *)readDocuments:(FSTDocumentKeySet *)keys {
+  __block FSTMaybeDocumentDictionary *result;
+  [self.persistence runReadTransaction:^{
+    result = [self.localDocuments documentsForKeys:keys];
+  }];
+  return result;
+}
+
+- (FSTMaybeDocumentDictionary *)localDocumentsForRemoteDocuments:
+    (NSArray<FSTMaybeDocument *> *)documents {
+  NSMutableDictionary<FSTDocumentKey *, FSTMaybeDocument *> *results =
+      [NSMutableDictionary dictionaryWithCapacity:documents.count];
+  [self.persistence runReadTransaction:^{
+    for (FSTMaybeDocument *document in documents) {
+      FSTDocumentKey *key = document.key;
+      FSTMaybeDocument *localDocument = [self.localDocuments localDocument:document key:key];
+      if (!localDocument) {
+        localDocument = [FSTDeletedDocument documentWithKey:key
+                                                    version:[FSTSnapshotVersion noVersion]];
+      }
+      results[key] = localDocument;
+    }
+  }];
+  return [FSTMaybeDocumentDictionary maybeDocumentDictionaryWithDictionary:results];
 }
 
 - (FSTQueryData *)allocateQuery:(FSTQuery *)query {
   FSTQueryData *cached = [self.queryCache queryDataForQuery:query];
   FSTTargetID targetID;
-  FSTListenSequenceNumber sequenceNumber = [self.listenSequence next];
   if (cached) {
-    // This query has been listened to previously, so reuse the previous targetID.
-    // TODO(mcg): freshen last accessed date?
+    // This query has been listened to previously, so reuse the previous targetID, but record that
+    // it's in use again so that the garbage collector keeps it around.
+    FSTWriteGroup *group = [self.persistence startGroupWithAction:@"Reuse query"];
+
+    FSTListenSequenceNumber sequenceNumber = [self nextListenSequenceNumberWithGroup:group];
     targetID = cached.targetID;
+    cached = [cached queryDataByReplacingListenSequenceNumber:sequenceNumber];
+    [self.queryCache addQueryData:cached group:group];
+
+    [self.persistence commitGroup:group];
   } else {
     FSTWriteGroup *group = [self.persistence startGroupWithAction:@"Allocate query"];
 
-    targetID = _targetIDGenerator.NextId();
+    FSTListenSequenceNumber sequenceNumber = [self nextListenSequenceNumberWithGroup:group];
+    targetID = [self nextTargetIDWithGroup:group];
     cached = [[FSTQueryData alloc] initWithQuery:query
                                         targetID:targetID
                             listenSequenceNumber:sequenceNumber
@@ -416,15 +717,50 @@ NS_ASSUME_NONNULL_BEGIN
   return cached;
 }
 
+/** Returns a new target ID, first persisting a new block of reserved IDs if needed. */
+- (FSTTargetID)nextTargetIDWithGroup:(FSTWriteGroup *)group {
+  if (_targetIDGenerator.NeedsReservation()) {
+    FSTTargetID reserved = _targetIDGenerator.ReserveBlock(kReservationBlockSize);
+    [self.queryCache reserveTargetIDsThrough:reserved group:group];
+  }
+  return _targetIDGenerator.NextId();
+}
+
+/** Returns a new listen sequence number, first persisting a new block of them if needed. */
+- (FSTListenSequenceNumber)nextListenSequenceNumberWithGroup:(FSTWriteGroup *)group {
+  if ([self.listenSequence needsReservation]) {
+    FSTListenSequenceNumber reserved =
+        [self.listenSequence reserveBlockOfSize:kReservationBlockSize];
+    [self.queryCache reserveListenSequenceNumbersThrough:reserved group:group];
+  }
+  return [self.listenSequence next];
+}
+
 - (void)releaseQuery:(FSTQuery *)query {
+  @synchronized(self.readViewLock) {
+    [self releaseQueryLocked:query];
+    if ([self.targetIDs count] == 0) {
+      // Releasing the held batch results may have changed documents.
+      self.readViewIsStale = YES;
+    }
+  }
+}
+
+- (void)releaseQueryLocked:(FSTQuery *)query {
   FSTWriteGroup *group = [self.persistence startGroupWithAction:@"Release query"];
 
   FSTQueryData *queryData = [self.queryCache queryDataForQuery:query];
   FSTAssert(queryData, @"Tried to release nonexistent query: %@", query);
 
   [self.localViewReferences removeReferencesForID:queryData.targetID];
-  if (self.garbageCollector.isEager) {
+  if (self.garbageCollector.isEager && !self.pinnedQueries[@(queryData.targetID)]) {
     [self.queryCache removeQueryData:queryData group:group];
+  } else {
+    // Record when the query was last used so that the least recently used queries can be removed
+    // first.
+    FSTListenSequenceNumber sequenceNumber = [self nextListenSequenceNumberWithGroup:group];
+    queryData = [queryData queryDataByReplacingListenSequenceNumber:sequenceNumber];
+    [self.queryCache addQueryData:queryData group:group];
   }
   [self.targetIDs removeObjectForKey:@(queryData.targetID)];
 
@@ -442,19 +778,198 @@ NS_ASSUME_NONNULL_BEGIN
   [self.persistence commitGroup:group];
 }
 
+- (void)pinQuery:(FSTQuery *)query untilDate:(NSDate *)expiryDate {
+  FSTQueryData *queryData = [self.queryCache queryDataForQuery:query];
+  FSTAssert(queryData, @"Tried to pin nonexistent query: %@", query);
+
+  FSTBoxedTargetID *targetID = @(queryData.targetID);
+  NSDate *previous = self.pinExpiryDates[targetID];
+  if (!previous || [previous compare:expiryDate] == NSOrderedAscending) {
+    self.pinnedQueries[targetID] = queryData;
+    self.pinExpiryDates[targetID] = expiryDate;
+  }
+}
+
 - (FSTDocumentDictionary *)executeQuery:(FSTQuery *)query {
-  return [self.localDocuments documentsMatchingQuery:query];
+  __block FSTDocumentDictionary *result;
+  [self.persistence runReadTransaction:^{
+    result = [self.localDocuments documentsMatchingQuery:query];
+  }];
+  return result;
+}
+
+- (NSUInteger)countOfDocumentsMatchingQuery:(FSTQuery *)query {
+  __block NSUInteger result;
+  [self.persistence runReadTransaction:^{
+    FSTQueryData *_Nullable queryData = [self.queryCache queryDataForQuery:query];
+    if (!queryData || queryData.resumeToken.length == 0 || query.limit != NSNotFound) {
+      // Without a synced target there are no remote keys to count, and a limit applies to the
+      // local results, which only running the query accounts for.
+      result = [self.localDocuments documentsMatchingQuery:query].count;
+      if (query.limit != NSNotFound) {
+        result = MIN(result, (NSUInteger)query.limit);
+      }
+      return;
+    }
+
+    // Pending mutations can move documents into or out of the results, so those documents are
+    // read and matched; every other remote key still matches.
+    FSTDocumentKeySet *remoteKeys = [self.queryCache matchingKeysForTargetID:queryData.targetID];
+    FSTDocumentKeySet *mutatedKeys = [self.mutationQueue mutatedDocumentKeysAffectingQuery:query];
+
+    NSInteger count = remoteKeys.count;
+    for (FSTDocumentKey *key in [mutatedKeys objectEnumerator]) {
+      FSTMaybeDocument *_Nullable doc = [self.localDocuments documentForKey:key];
+      BOOL matches = [doc isKindOfClass:[FSTDocument class]] &&
+                     [query matchesDocument:(FSTDocument *)doc];
+      count += (matches ? 1 : 0) - ([remoteKeys containsObject:key] ? 1 : 0);
+    }
+    result = (NSUInteger)count;
+  }];
+  return result;
+}
+
+- (FSTDocumentDictionary *)executeQueryInReadView:(FSTQuery *)query {
+  FSTLocalDocumentsView *_Nullable readView;
+  @synchronized(self.readViewLock) {
+    if (self.isShutDown) {
+      return [FSTDocumentDictionary documentDictionary];
+    }
+    if (self.readViewIsStale) {
+      [self publishReadView];
+    }
+    readView = self.readView;
+  }
+  @synchronized(readView) {
+    // shutdown may have closed the view's cache while this waited for another read.
+    if (self.isShutDown) {
+      return [FSTDocumentDictionary documentDictionary];
+    }
+    return [readView documentsMatchingQuery:query];
+  }
+}
+
+/**
+ * Runs the given block, which changes documents, in a read transaction. The read view is rebuilt
+ * from the changed documents the next time it's read.
+ */
+- (void)runDocumentChange:(void (^)(void))block {
+  @synchronized(self.readViewLock) {
+    self.readViewIsStale = YES;
+    [self.persistence runReadTransaction:block];
+  }
+}
+
+/**
+ * Replaces readView with a snapshot of the current local documents. Must be called with
+ * readViewLock held, after the group of any operation that changes documents has been committed.
+ */
+- (void)publishReadView {
+  self.readViewDocumentCache = [self.persistence remoteDocumentCacheSnapshot];
+  self.readView = [self.localDocuments snapshotWithRemoteDocumentCache:self.readViewDocumentCache];
+  self.readViewIsStale = NO;
 }
 
 - (FSTDocumentKeySet *)remoteDocumentKeysForTarget:(FSTTargetID)targetID {
   return [self.queryCache matchingKeysForTargetID:targetID];
 }
 
+- (FSTMemoryUsage)remoteDocumentMemoryUsage {
+  return [self.remoteDocumentCache memoryUsage];
+}
+
+- (FSTMemoryUsage)localViewReferenceMemoryUsage {
+  return [self.localViewReferences memoryUsage];
+}
+
+- (void)releaseCachedMemory {
+  if (self.isShutDown) {
+    return;
+  }
+  [self.remoteDocumentCache releaseCachedMemory];
+  // The read view reads through a cache of its own, so drop it; the next read builds a new one
+  // that starts out empty.
+  @synchronized(self.readViewLock) {
+    self.readView = nil;
+    self.readViewDocumentCache = nil;
+    self.readViewIsStale = YES;
+  }
+}
+
 - (void)collectGarbage {
   // Call collectGarbage regardless of whether isGCEnabled so the referenceSet doesn't continue to
   // accumulate the garbage keys.
-  NSSet<FSTDocumentKey *> *garbage = [self.garbageCollector collectGarbage];
-  if (garbage.count > 0) {
+  [self removeInactiveQueries];
+  [self removeGarbage:[self.garbageCollector collectGarbage]];
+}
+
+- (BOOL)collectGarbageWithTimeLimit:(NSTimeInterval)timeLimit {
+  if (self.isShutDown) {
+    return NO;
+  }
+
+  [self removeInactiveQueries];
+  [self removeGarbage:[self.garbageCollector collectGarbageWithTimeLimit:timeLimit]];
+  return self.garbageCollector.hasPotentialGarbage;
+}
+
+/** Lets the garbage collector remove inactive queries from the query cache, if it does so. */
+- (void)removeInactiveQueries {
+  BOOL removesQueries = [self.garbageCollector
+      respondsToSelector:@selector(removeInactiveQueriesFromCache:liveQueries:group:)];
+  if (!removesQueries && self.pinnedQueries.count == 0) {
+    return;
+  }
+
+  FSTWriteGroup *group = [self.persistence startGroupWithAction:@"Remove inactive queries"];
+  NSDictionary<NSNumber *, FSTQueryData *> *liveQueries = [self queriesToKeepWithGroup:group];
+  if (removesQueries) {
+    [self.garbageCollector removeInactiveQueriesFromCache:self.queryCache
+                                              liveQueries:liveQueries
+                                                    group:group];
+  }
+  [self.persistence commitGroup:group];
+}
+
+/**
+ * Returns the queries that are listened to or pinned, indexed by target ID, after unpinning the
+ * queries whose pins have expired. An eager garbage collector doesn't remove inactive queries
+ * itself, so the expired queries that aren't listened to are removed here instead, as
+ * releaseQuery: would have done.
+ */
+- (NSDictionary<NSNumber *, FSTQueryData *> *)queriesToKeepWithGroup:(FSTWriteGroup *)group {
+  if (self.pinnedQueries.count == 0) {
+    return self.targetIDs;
+  }
+
+  NSMutableDictionary<NSNumber *, FSTQueryData *> *result = [self.targetIDs mutableCopy];
+  NSDate *now = [NSDate date];
+  for (FSTBoxedTargetID *targetID in [self.pinExpiryDates allKeys]) {
+    if ([self.pinExpiryDates[targetID] compare:now] == NSOrderedDescending) {
+      result[targetID] = self.pinnedQueries[targetID];
+      continue;
+    }
+
+    FSTQuery *query = self.pinnedQueries[targetID].query;
+    [self.pinnedQueries removeObjectForKey:targetID];
+    [self.pinExpiryDates removeObjectForKey:targetID];
+    if (self.garbageCollector.isEager && !self.targetIDs[targetID]) {
+      FSTQueryData *queryData = [self.queryCache queryDataForQuery:query];
+      if (queryData) {
+        [self.queryCache removeQueryData:queryData group:group];
+      }
+    }
+  }
+  return result;
+}
+
+/** Removes the given garbage documents from the remote document cache. */
+- (void)removeGarbage:(NSSet<FSTDocumentKey *> *)garbage {
+  if (garbage.count == 0) {
+    return;
+  }
+  // The read view doesn't change, but building one reads the cache that this changes.
+  @synchronized(self.readViewLock) {
     FSTWriteGroup *group = [self.persistence startGroupWithAction:@"Garbage Collection"];
     for (FSTDocumentKey *key in garbage) {
       [self.remoteDocumentCache removeEntryForKey:key group:group];
@@ -490,7 +1005,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (BOOL)isRemoteUpToVersion:(FSTSnapshotVersion *)version {
   // If there are no watch targets, then we won't get remote snapshots, and are always "up-to-date."
-  return [version compare:self.queryCache.lastRemoteSnapshotVersion] != NSOrderedDescending ||
+  return version.value <= self.queryCache.lastRemoteSnapshotVersion.value ||
          self.targetIDs.count == 0;
 }
 
@@ -518,19 +1033,17 @@ NS_ASSUME_NONNULL_BEGIN
 /** Removes all the mutation batches named in the given array. */
 - (FSTDocumentKeySet *)removeMutationBatches:(NSArray<FSTMutationBatch *> *)batches
                                        group:(FSTWriteGroup *)group {
-  // TODO(klimt): Could this be an NSMutableDictionary?
-  __block FSTDocumentKeySet *affectedDocs = [FSTDocumentKeySet keySet];
-
+  NSMutableSet<FSTDocumentKey *> *affectedDocs = [NSMutableSet set];
   for (FSTMutationBatch *batch in batches) {
     for (FSTMutation *mutation in batch.mutations) {
-      FSTDocumentKey *key = mutation.key;
-      affectedDocs = [affectedDocs setByAddingObject:key];
+      [affectedDocs addObject:mutation.key];
     }
   }
 
   [self.mutationQueue removeMutationBatches:batches group:group];
+  [self.localDocuments removeMutationBatches:batches];
 
-  return affectedDocs;
+  return [FSTDocumentKeySet keySetWithKeys:affectedDocs];
 }
 
 - (void)applyBatchResult:(FSTMutationBatchResult *)batchResult
@@ -540,9 +1053,9 @@ NS_ASSUME_NONNULL_BEGIN
   [docKeys enumerateObjectsUsingBlock:^(FSTDocumentKey *docKey, BOOL *stop) {
     FSTMaybeDocument *_Nullable remoteDoc = [remoteDocuments entryForKey:docKey];
     FSTMaybeDocument *_Nullable doc = remoteDoc;
-    FSTSnapshotVersion *ackVersion = batchResult.docVersions[docKey];
+    const model::SnapshotVersion *ackVersion = batchResult.docVersions.find(docKey);
     FSTAssert(ackVersion, @"docVersions should contain every doc in the write.");
-    if (!doc || [doc.version compare:ackVersion] == NSOrderedAscending) {
+    if (!doc || doc.version.value < *ackVersion) {
       doc = [batch applyTo:doc documentKey:docKey mutationBatchResult:batchResult];
       if (!doc) {
         FSTAssert(!remoteDoc, @"Mutation batch %@ applied to document %@ resulted in nil.", batch,
@@ -16,42 +16,62 @@
 
 #import "Firestore/Source/Local/FSTMemoryMutationQueue.h"
 
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+
 #import "Firestore/Source/Core/FSTQuery.h"
-#import "Firestore/Source/Local/FSTDocumentReference.h"
 #import "Firestore/Source/Model/FSTDocumentKey.h"
 #import "Firestore/Source/Model/FSTMutation.h"
 #import "Firestore/Source/Model/FSTMutationBatch.h"
 #import "Firestore/Source/Model/FSTPath.h"
 #import "Firestore/Source/Util/FSTAssert.h"
 
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+
+using firebase::firestore::immutable::SortedMap;
+
 NS_ASSUME_NONNULL_BEGIN
 
-static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left, NSNumber *right) {
-  return [left compare:right];
+namespace {
+
+/** A reference from a document to a batch that mutates it. */
+struct BatchReference {
+  BatchReference() : key(nil), encodedPath(&EmptyPath()), batchID(0) {
+  }
+
+  BatchReference(FSTDocumentKey *key, FSTBatchID batchID)
+      : key(key), encodedPath(&[key encodedPath]), batchID(batchID) {
+  }
+
+  static const std::string &EmptyPath() {
+    static const std::string *empty = new std::string();
+    return *empty;
+  }
+
+  FSTDocumentKey *_Nullable key;
+
+  /** The key's encoded path, kept here so that comparisons don't have to message the key. */
+  const std::string *encodedPath;
+
+  FSTBatchID batchID;
 };
 
-@interface FSTMemoryMutationQueue ()
+/** Sorts references by key then batchID. */
+struct BatchReferenceByKey {
+  bool operator()(const BatchReference &lhs, const BatchReference &rhs) const {
+    int result = lhs.encodedPath->compare(*rhs.encodedPath);
+    return result < 0 || (result == 0 && lhs.batchID < rhs.batchID);
+  }
+};
 
-/**
- * A FIFO queue of all mutations to apply to the backend. Mutations are added to the end of the
- * queue as they're written, and removed from the front of the queue as the mutations become
- * visible or are rejected.
- *
- * When successfully applied, mutations must be acknowledged by the write stream and made visible
- * on the watch stream. It's possible for the watch stream to fall behind in which case the batches
- * at the head of the queue will be acknowledged but held until the watch stream sees the changes.
- *
- * If a batch is rejected while there are held write acknowledgements at the head of the queue
- * the rejected batch is converted to a tombstone: its mutations are removed but the batch remains
- * in the queue. This maintains a simple consecutive ordering of batches in the queue.
- *
- * Once the held write acknowledgements become visible they are removed from the head of the queue
- * along with any tombstones that follow.
- */
-@property(nonatomic, strong, readonly) NSMutableArray<FSTMutationBatch *> *queue;
+// The map is used as a set: only the keys matter.
+using BatchReferences = SortedMap<BatchReference, bool, BatchReferenceByKey>;
+
+}  // namespace
 
-/** An ordered mapping between documents and the mutation batch IDs. */
-@property(nonatomic, strong) FSTImmutableSortedSet<FSTDocumentReference *> *batchesByDocumentKey;
+@interface FSTMemoryMutationQueue ()
 
 /** The next value to use when assigning sequential IDs to each mutation batch. */
 @property(nonatomic, assign) FSTBatchID nextBatchID;
@@ -68,7 +88,30 @@ static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left,
 
 @end
 
-@implementation FSTMemoryMutationQueue
+@implementation FSTMemoryMutationQueue {
+  /**
+   * A FIFO queue of all mutations to apply to the backend. Mutations are added to the end of the
+   * queue as they're written, and removed from the front of the queue as the mutations become
+   * visible or are rejected. Batch IDs in the queue are consecutive, so a batch is found by its
+   * offset from the ID of the first batch.
+   *
+   * When successfully applied, mutations must be acknowledged by the write stream and made visible
+   * on the watch stream. It's possible for the watch stream to fall behind in which case the
+   * batches at the head of the queue will be acknowledged but held until the watch stream sees the
+   * changes.
+   *
+   * If a batch is rejected while there are held write acknowledgements at the head of the queue
+   * the rejected batch is converted to a tombstone: its mutations are removed but the batch
+   * remains in the queue. This maintains a simple consecutive ordering of batches in the queue.
+   *
+   * Once the held write acknowledgements become visible they are removed from the head of the
+   * queue along with any tombstones that follow.
+   */
+  std::deque<FSTMutationBatch *> _queue;
+
+  /** An ordered mapping between documents and the mutation batch IDs. */
+  BatchReferences _batchesByDocumentKey;
+}
 
 + (instancetype)mutationQueue {
   return [[FSTMemoryMutationQueue alloc] init];
@@ -76,10 +119,6 @@ static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left,
 
 - (instancetype)init {
   if (self = [super init]) {
-    _queue = [NSMutableArray array];
-    _batchesByDocumentKey =
-        [FSTImmutableSortedSet setWithComparator:FSTDocumentReferenceComparatorByKey];
-
     _nextBatchID = 1;
     _highestAcknowledgedBatchID = kFSTBatchIDUnknown;
   }
@@ -107,7 +146,7 @@ static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left,
 - (BOOL)isEmpty {
   // If the queue has any entries at all, the first entry must not be a tombstone (otherwise it
   // would have been removed already).
-  return self.queue.count == 0;
+  return _queue.empty();
 }
 
 - (FSTBatchID)highestAcknowledgedBatchID {
@@ -117,16 +156,14 @@ static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left,
 - (void)acknowledgeBatch:(FSTMutationBatch *)batch
              streamToken:(nullable NSData *)streamToken
                    group:(__unused FSTWriteGroup *)group {
-  NSMutableArray<FSTMutationBatch *> *queue = self.queue;
-
   FSTBatchID batchID = batch.batchID;
   FSTAssert(batchID > self.highestAcknowledgedBatchID,
             @"Mutation batchIDs must be acknowledged in order");
 
-  NSInteger batchIndex = [self indexOfExistingBatchID:batchID action:@"acknowledged"];
+  NSUInteger batchIndex = [self indexOfExistingBatchID:batchID action:@"acknowledged"];
 
   // Verify that the batch in the queue is the one to be acknowledged.
-  FSTMutationBatch *check = queue[(NSUInteger)batchIndex];
+  FSTMutationBatch *check = _queue[batchIndex];
   FSTAssert(batchID == check.batchID, @"Queue ordering failure: expected batch %d, got batch %d",
             batchID, check.batchID);
   FSTAssert(![check isTombstone], @"Can't acknowledge a previously removed batch");
@@ -147,44 +184,56 @@ static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left,
   FSTBatchID batchID = self.nextBatchID;
   self.nextBatchID += 1;
 
-  NSMutableArray<FSTMutationBatch *> *queue = self.queue;
-  if (queue.count > 0) {
-    FSTMutationBatch *prior = queue[queue.count - 1];
+  if (!_queue.empty()) {
+    FSTMutationBatch *prior = _queue.back();
     FSTAssert(prior.batchID < batchID, @"Mutation batchIDs must be monotonically increasing order");
   }
 
   FSTMutationBatch *batch = [[FSTMutationBatch alloc] initWithBatchID:batchID
                                                        localWriteTime:localWriteTime
                                                             mutations:mutations];
-  [queue addObject:batch];
+  _queue.push_back(batch);
 
   // Track references by document key.
-  FSTImmutableSortedSet<FSTDocumentReference *> *references = self.batchesByDocumentKey;
-  for (FSTMutation *mutation in batch.mutations) {
-    references = [references
-        setByAddingObject:[[FSTDocumentReference alloc] initWithKey:mutation.key ID:batchID]];
+  BatchReferences::Builder references{_batchesByDocumentKey};
+  references.reserve(mutations.count);
+  for (FSTMutation *mutation in mutations) {
+    references.insert(BatchReference(mutation.key, batchID), true);
   }
-  self.batchesByDocumentKey = references;
+  _batchesByDocumentKey = references.Build();
 
   return batch;
 }
 
-- (nullable FSTMutationBatch *)lookupMutationBatch:(FSTBatchID)batchID {
-  NSMutableArray<FSTMutationBatch *> *queue = self.queue;
+- (FSTMutationBatch *)replaceMutationsOfLastBatch:(FSTMutationBatch *)batch
+                                    withMutations:(NSArray<FSTMutation *> *)mutations
+                                            group:(FSTWriteGroup *)group {
+  FSTAssert(!_queue.empty() && _queue.back().batchID == batch.batchID,
+            @"Only the last batch in the queue can be replaced");
+
+  FSTMutationBatch *replacement = [[FSTMutationBatch alloc] initWithBatchID:batch.batchID
+                                                             localWriteTime:batch.localWriteTime
+                                                                  mutations:mutations];
+  // The batch affects the same documents, so _batchesByDocumentKey stays as it is.
+  FSTAssert([[replacement keys] isEqual:[batch keys]],
+            @"Replacement mutations must affect the same documents");
+  _queue.back() = replacement;
+  return replacement;
+}
 
+- (nullable FSTMutationBatch *)lookupMutationBatch:(FSTBatchID)batchID {
   NSInteger index = [self indexOfBatchID:batchID];
-  if (index < 0 || index >= queue.count) {
+  if (index < 0 || index >= (NSInteger)_queue.size()) {
     return nil;
   }
 
-  FSTMutationBatch *batch = queue[(NSUInteger)index];
+  FSTMutationBatch *batch = _queue[(NSUInteger)index];
   FSTAssert(batch.batchID == batchID, @"If found batch must match");
   return [batch isTombstone] ? nil : batch;
 }
 
 - (nullable FSTMutationBatch *)nextMutationBatchAfterBatchID:(FSTBatchID)batchID {
-  NSMutableArray<FSTMutationBatch *> *queue = self.queue;
-  NSUInteger count = queue.count;
+  NSUInteger count = _queue.size();
 
   // All batches with batchID <= self.highestAcknowledgedBatchID have been acknowledged so the
   // first unacknowledged batch after batchID will have a batchID larger than both of these values.
@@ -196,7 +245,7 @@ static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left,
 
   // Finally return the first non-tombstone batch.
   for (; index < count; index++) {
-    FSTMutationBatch *batch = queue[index];
+    FSTMutationBatch *batch = _queue[index];
     if (![batch isTombstone]) {
       return batch;
     }
@@ -206,12 +255,28 @@ static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left,
 }
 
 - (NSArray<FSTMutationBatch *> *)allMutationBatches {
-  return [self allLiveMutationBatchesBeforeIndex:self.queue.count];
+  return [self allLiveMutationBatchesBeforeIndex:_queue.size()];
+}
+
+- (void)enumerateMutationBatchesUsingBlock:(void (^)(FSTMutationBatch *batch, BOOL *stop))block {
+  BOOL stop = NO;
+  for (auto it = _queue.begin(); !stop && it != _queue.end(); ++it) {
+    if (![*it isTombstone]) {
+      block(*it, &stop);
+    }
+  }
+}
+
+- (FSTDocumentKeySet *)allMutatedDocumentKeys {
+  NSMutableSet<FSTDocumentKey *> *keys = [NSMutableSet set];
+  for (const auto &entry : _batchesByDocumentKey) {
+    [keys addObject:entry.first.key];
+  }
+  return [FSTDocumentKeySet keySetWithKeys:keys];
 }
 
 - (NSArray<FSTMutationBatch *> *)allMutationBatchesThroughBatchID:(FSTBatchID)batchID {
-  NSMutableArray<FSTMutationBatch *> *queue = self.queue;
-  NSUInteger count = queue.count;
+  NSInteger count = (NSInteger)_queue.size();
 
   NSInteger endIndex = [self indexOfBatchID:batchID];
   if (endIndex < 0) {
@@ -228,25 +293,59 @@ static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left,
 
 - (NSArray<FSTMutationBatch *> *)allMutationBatchesAffectingDocumentKey:
     (FSTDocumentKey *)documentKey {
-  FSTDocumentReference *start = [[FSTDocumentReference alloc] initWithKey:documentKey ID:0];
+  NSMutableArray<FSTMutationBatch *> *result = [NSMutableArray array];
+  for (auto iter = _batchesByDocumentKey.lower_bound(BatchReference(documentKey, 0));
+       iter != _batchesByDocumentKey.end() && [documentKey isEqualToKey:iter->first.key]; ++iter) {
+    FSTMutationBatch *batch = [self lookupMutationBatch:iter->first.batchID];
+    FSTAssert(batch, @"Batches in the index must exist in the main table");
+    [result addObject:batch];
+  }
+  return result;
+}
 
+- (NSArray<FSTMutationBatch *> *)allMutationBatchesAffectingQuery:(FSTQuery *)query {
+  // Find unique batchIDs referenced by all documents potentially matching the query.
+  __block std::vector<FSTBatchID> batchIDs;
+  [self enumerateReferencesInCollectionOfQuery:query
+                                    usingBlock:^(const BatchReference &reference) {
+                                      batchIDs.push_back(reference.batchID);
+                                    }];
+  std::sort(batchIDs.begin(), batchIDs.end());
+  batchIDs.erase(std::unique(batchIDs.begin(), batchIDs.end()), batchIDs.end());
+
+  // Construct an array of matching batches, sorted by batchID to ensure that multiple mutations
+  // affecting the same document key are applied in order.
   NSMutableArray<FSTMutationBatch *> *result = [NSMutableArray array];
-  FSTDocumentReferenceBlock block = ^(FSTDocumentReference *reference, BOOL *stop) {
-    if (![documentKey isEqualToKey:reference.key]) {
-      *stop = YES;
-      return;
+  for (FSTBatchID batchID : batchIDs) {
+    FSTMutationBatch *batch = [self lookupMutationBatch:batchID];
+    if (batch) {
+      [result addObject:batch];
     }
+  }
 
-    FSTMutationBatch *batch = [self lookupMutationBatch:reference.ID];
-    FSTAssert(batch, @"Batches in the index must exist in the main table");
-    [result addObject:batch];
-  };
+  return result;
+}
 
-  [self.batchesByDocumentKey enumerateObjectsFrom:start to:nil usingBlock:block];
+- (FSTDocumentKeySet *)mutatedDocumentKeysAffectingQuery:(FSTQuery *)query {
+  // A document appears once per batch that mutates it, but its references are adjacent.
+  __block FSTDocumentKeySet *result = [FSTDocumentKeySet keySet];
+  __block FSTDocumentKey *_Nullable lastKey = nil;
+  [self enumerateReferencesInCollectionOfQuery:query
+                                    usingBlock:^(const BatchReference &reference) {
+                                      if (![reference.key isEqual:lastKey]) {
+                                        lastKey = reference.key;
+                                        result = [result setByAddingObject:lastKey];
+                                      }
+                                    }];
   return result;
 }
 
-- (NSArray<FSTMutationBatch *> *)allMutationBatchesAffectingQuery:(FSTQuery *)query {
+/**
+ * Calls the block with each reference in the index to a document directly in the query's
+ * collection, in key order.
+ */
+- (void)enumerateReferencesInCollectionOfQuery:(FSTQuery *)query
+                                    usingBlock:(void (^)(const BatchReference &reference))block {
   // Use the query path as a prefix for testing if a document matches the query.
   FSTResourcePath *prefix = query.path;
   int immediateChildrenPathLength = prefix.length + 1;
@@ -258,41 +357,24 @@ static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left,
   if (![FSTDocumentKey isDocumentKey:startPath]) {
     startPath = [startPath pathByAppendingSegment:@""];
   }
-  FSTDocumentReference *start =
-      [[FSTDocumentReference alloc] initWithKey:[FSTDocumentKey keyWithPath:startPath] ID:0];
+  BatchReference start([FSTDocumentKey keyWithPath:startPath], 0);
 
-  // Find unique batchIDs referenced by all documents potentially matching the query.
-  __block FSTImmutableSortedSet<NSNumber *> *uniqueBatchIDs =
-      [FSTImmutableSortedSet setWithComparator:NumberComparator];
-  FSTDocumentReferenceBlock block = ^(FSTDocumentReference *reference, BOOL *stop) {
-    FSTResourcePath *rowKeyPath = reference.key.path;
+  for (auto iter = _batchesByDocumentKey.lower_bound(start); iter != _batchesByDocumentKey.end();
+       ++iter) {
+    FSTResourcePath *rowKeyPath = iter->first.key.path;
     if (![prefix isPrefixOfPath:rowKeyPath]) {
-      *stop = YES;
-      return;
+      break;
     }
 
     // Rows with document keys more than one segment longer than the query path can't be matches.
     // For example, a query on 'rooms' can't match the document /rooms/abc/messages/xyx.
     // TODO(mcg): we'll need a different scanner when we implement ancestor queries.
     if (rowKeyPath.length != immediateChildrenPathLength) {
-      return;
-    }
-
-    uniqueBatchIDs = [uniqueBatchIDs setByAddingObject:@(reference.ID)];
-  };
-  [self.batchesByDocumentKey enumerateObjectsFrom:start to:nil usingBlock:block];
-
-  // Construct an array of matching batches, sorted by batchID to ensure that multiple mutations
-  // affecting the same document key are applied in order.
-  NSMutableArray<FSTMutationBatch *> *result = [NSMutableArray array];
-  [uniqueBatchIDs enumerateObjectsUsingBlock:^(NSNumber *batchID, BOOL *stop) {
-    FSTMutationBatch *batch = [self lookupMutationBatch:[batchID intValue]];
-    if (batch) {
-      [result addObject:batch];
+      continue;
     }
-  }];
 
-  return result;
+    block(iter->first);
+  }
 }
 
 - (void)removeMutationBatches:(NSArray<FSTMutationBatch *> *)batches group:(FSTWriteGroup *)group {
@@ -301,19 +383,18 @@ static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left,
 
   FSTBatchID firstBatchID = batches[0].batchID;
 
-  NSMutableArray<FSTMutationBatch *> *queue = self.queue;
-  NSUInteger queueCount = queue.count;
+  NSUInteger queueCount = _queue.size();
 
   // Find the position of the first batch for removal. This need not be the first entry in the
   // queue.
   NSUInteger startIndex = [self indexOfExistingBatchID:firstBatchID action:@"removed"];
-  FSTAssert(queue[startIndex].batchID == firstBatchID, @"Removed batches must exist in the queue");
+  FSTAssert(_queue[startIndex].batchID == firstBatchID, @"Removed batches must exist in the queue");
 
   // Check that removed batches are contiguous (while excluding tombstones).
   NSUInteger batchIndex = 1;
   NSUInteger queueIndex = startIndex + 1;
   while (batchIndex < batchCount && queueIndex < queueCount) {
-    FSTMutationBatch *batch = queue[queueIndex];
+    FSTMutationBatch *batch = _queue[queueIndex];
     if ([batch isTombstone]) {
       queueIndex++;
       continue;
@@ -329,41 +410,40 @@ static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left,
   // may have left tombstones in the queue, so expand the removal range to include any tombstones.
   if (startIndex == 0) {
     for (; queueIndex < queueCount; queueIndex++) {
-      FSTMutationBatch *batch = queue[queueIndex];
+      FSTMutationBatch *batch = _queue[queueIndex];
       if (![batch isTombstone]) {
         break;
       }
     }
 
-    NSUInteger length = queueIndex - startIndex;
-    [queue removeObjectsInRange:NSMakeRange(startIndex, length)];
+    // Erasing from the front of a deque takes time proportional to the number of batches erased,
+    // not to the length of the queue.
+    _queue.erase(_queue.begin(), _queue.begin() + queueIndex);
 
   } else {
     // Mark tombstones
     for (NSUInteger i = startIndex; i < queueIndex; i++) {
-      queue[i] = [queue[i] toTombstone];
+      _queue[i] = [_queue[i] toTombstone];
     }
   }
 
-  // Remove entries from the index too.
+  // Remove entries from the index too, applying all the removals at once.
   id<FSTGarbageCollector> garbageCollector = self.garbageCollector;
-  FSTImmutableSortedSet<FSTDocumentReference *> *references = self.batchesByDocumentKey;
+  BatchReferences::Builder references{_batchesByDocumentKey};
   for (FSTMutationBatch *batch in batches) {
     FSTBatchID batchID = batch.batchID;
     for (FSTMutation *mutation in batch.mutations) {
       FSTDocumentKey *key = mutation.key;
       [garbageCollector addPotentialGarbageKey:key];
-
-      FSTDocumentReference *reference = [[FSTDocumentReference alloc] initWithKey:key ID:batchID];
-      references = [references setByRemovingObject:reference];
+      references.erase(BatchReference(key, batchID));
     }
   }
-  self.batchesByDocumentKey = references;
+  _batchesByDocumentKey = references.Build();
 }
 
 - (void)performConsistencyCheck {
-  if (self.queue.count == 0) {
-    FSTAssert([self.batchesByDocumentKey isEmpty],
+  if (_queue.empty()) {
+    FSTAssert(_batchesByDocumentKey.empty(),
               @"Document leak -- detected dangling mutation references when queue is empty.");
   }
 }
@@ -373,12 +453,8 @@ static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left,
 - (BOOL)containsKey:(FSTDocumentKey *)key {
   // Create a reference with a zero ID as the start position to find any document reference with
   // this key.
-  FSTDocumentReference *reference = [[FSTDocumentReference alloc] initWithKey:key ID:0];
-
-  NSEnumerator<FSTDocumentReference *> *enumerator =
-      [self.batchesByDocumentKey objectEnumeratorFrom:reference];
-  FSTDocumentKey *_Nullable firstKey = [enumerator nextObject].key;
-  return [firstKey isEqual:key];
+  auto found = _batchesByDocumentKey.lower_bound(BatchReference(key, 0));
+  return found != _batchesByDocumentKey.end() && [found->first.key isEqualToKey:key];
 }
 
 #pragma mark - Helpers
@@ -389,16 +465,12 @@ static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left,
  */
 - (NSArray<FSTMutationBatch *> *)allLiveMutationBatchesBeforeIndex:(NSUInteger)endIndex {
   NSMutableArray<FSTMutationBatch *> *result = [NSMutableArray arrayWithCapacity:endIndex];
-
-  NSUInteger index = 0;
-  for (FSTMutationBatch *batch in self.queue) {
-    if (index++ >= endIndex) break;
-
+  for (NSUInteger index = 0; index < endIndex; index++) {
+    FSTMutationBatch *batch = _queue[index];
     if (![batch isTombstone]) {
       [result addObject:batch];
     }
   }
-
   return result;
 }
 
@@ -410,9 +482,7 @@ static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left,
  *     the queue or past the end of the queue if the batchID is larger than the last added batch.
  */
 - (NSInteger)indexOfBatchID:(FSTBatchID)batchID {
-  NSMutableArray<FSTMutationBatch *> *queue = self.queue;
-  NSUInteger count = queue.count;
-  if (count == 0) {
+  if (_queue.empty()) {
     // As an index this is past the end of the queue
     return 0;
   }
@@ -420,8 +490,7 @@ static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left,
   // Examine the front of the queue to figure out the difference between the batchID and indexes
   // in the array. Note that since the queue is ordered by batchID, if the first batch has a larger
   // batchID then the requested batchID doesn't exist in the queue.
-  FSTMutationBatch *firstBatch = queue[0];
-  FSTBatchID firstBatchID = firstBatch.batchID;
+  FSTBatchID firstBatchID = _queue.front().batchID;
   return batchID - firstBatchID;
 }
 
@@ -435,7 +504,8 @@ static const NSComparator NumberComparator = ^NSComparisonResult(NSNumber *left,
  */
 - (NSUInteger)indexOfExistingBatchID:(FSTBatchID)batchID action:(NSString *)action {
   NSInteger index = [self indexOfBatchID:batchID];
-  FSTAssert(index >= 0 && index < self.queue.count, @"Batches must exist to be %@", action);
+  FSTAssert(index >= 0 && index < (NSInteger)_queue.size(), @"Batches must exist to be %@",
+            action);
   return (NSUInteger)index;
 }
 
@@ -28,6 +28,12 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (instancetype)persistence;
 
+/**
+ * Returns the number of documents in the remote document cache, which is how the size of the
+ * cache is measured for garbage collection.
+ */
+- (int64_t)cachedDocumentCount;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -75,6 +75,10 @@ NS_ASSUME_NONNULL_BEGIN
   self.started = NO;
 }
 
+- (int64_t)cachedDocumentCount {
+  return (int64_t)[_remoteDocumentCache count];
+}
+
 - (id<FSTMutationQueue>)mutationQueueForUser:(FSTUser *)user {
   id<FSTMutationQueue> queue = self.mutationQueues[user];
   if (!queue) {
@@ -92,6 +96,10 @@ NS_ASSUME_NONNULL_BEGIN
   return _remoteDocumentCache;
 }
 
+- (id<FSTRemoteDocumentCache>)remoteDocumentCacheSnapshot {
+  return [_remoteDocumentCache snapshot];
+}
+
 - (FSTWriteGroup *)startGroupWithAction:(NSString *)action {
   return [self.writeGroupTracker startGroupWithAction:action];
 }
@@ -102,6 +110,11 @@ NS_ASSUME_NONNULL_BEGIN
   FSTAssert(group.isEmpty, @"Memory persistence shouldn't use write groups: %@", group.action);
 }
 
+- (void)runReadTransaction:(void (^)(void))block {
+  // Reads of in-memory storage are always consistent since nothing else can write concurrently.
+  block();
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
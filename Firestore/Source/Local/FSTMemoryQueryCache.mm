@@ -71,6 +71,19 @@ NS_ASSUME_NONNULL_BEGIN
   return _highestListenSequenceNumber;
 }
 
+- (void)reserveTargetIDsThrough:(FSTTargetID)targetID group:(__unused FSTWriteGroup *)group {
+  if (targetID > self.highestTargetID) {
+    self.highestTargetID = targetID;
+  }
+}
+
+- (void)reserveListenSequenceNumbersThrough:(FSTListenSequenceNumber)sequenceNumber
+                                      group:(__unused FSTWriteGroup *)group {
+  if (sequenceNumber > self.highestListenSequenceNumber) {
+    self.highestListenSequenceNumber = sequenceNumber;
+  }
+}
+
 - (FSTSnapshotVersion *)lastRemoteSnapshotVersion {
   return _lastRemoteSnapshotVersion;
 }
@@ -99,6 +112,13 @@ NS_ASSUME_NONNULL_BEGIN
   return self.queries[query];
 }
 
+- (void)enumerateQueryDataUsingBlock:(void (^)(FSTQueryData *queryData, BOOL *stop))block {
+  [self.queries
+      enumerateKeysAndObjectsUsingBlock:^(FSTQuery *query, FSTQueryData *queryData, BOOL *stop) {
+        block(queryData, stop);
+      }];
+}
+
 #pragma mark Reference tracking
 
 - (void)addMatchingKeys:(FSTDocumentKeySet *)keys
@@ -24,6 +24,15 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (instancetype)init NS_DESIGNATED_INITIALIZER;
 
+/**
+ * Returns a cache holding the documents held by this one now. Since the documents are stored
+ * in an immutable dictionary, this takes constant time.
+ */
+- (FSTMemoryRemoteDocumentCache *)snapshot;
+
+/** Returns the number of documents in the cache, in constant time. */
+- (NSUInteger)count;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -20,6 +20,7 @@
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTDocumentDictionary.h"
 #import "Firestore/Source/Model/FSTDocumentKey.h"
+#import "Firestore/Source/Model/FSTDocumentKeySet.h"
 #import "Firestore/Source/Model/FSTPath.h"
 
 NS_ASSUME_NONNULL_BEGIN
@@ -31,7 +32,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
-@implementation FSTMemoryRemoteDocumentCache
+@implementation FSTMemoryRemoteDocumentCache {
+  // The approximate bytes held by the documents in docs, updated as they're added and removed.
+  int64_t _bytes;
+}
 
 - (instancetype)init {
   if (self = [super init]) {
@@ -40,30 +44,90 @@ NS_ASSUME_NONNULL_BEGIN
   return self;
 }
 
+- (FSTMemoryRemoteDocumentCache *)snapshot {
+  FSTMemoryRemoteDocumentCache *snapshot = [[FSTMemoryRemoteDocumentCache alloc] init];
+  snapshot.docs = self.docs;
+  snapshot->_bytes = _bytes;
+  return snapshot;
+}
+
+- (NSUInteger)count {
+  return self.docs.count;
+}
+
 - (void)shutdown {
 }
 
+- (FSTMemoryUsage)memoryUsage {
+  return FSTMemoryUsage{static_cast<int64_t>(self.docs.count), _bytes};
+}
+
+- (void)releaseCachedMemory {
+  // Every document is held only here, so there's nothing that can be read again.
+}
+
 - (void)addEntry:(FSTMaybeDocument *)document group:(FSTWriteGroup *)group {
+  FSTMaybeDocument *_Nullable existing = self.docs[document.key];
+  if (existing) {
+    _bytes -= FSTApproximateDocumentBytes(existing);
+  }
+  _bytes += FSTApproximateDocumentBytes(document);
   self.docs = [self.docs dictionaryBySettingObject:document forKey:document.key];
 }
 
 - (void)removeEntryForKey:(FSTDocumentKey *)key group:(FSTWriteGroup *)group {
-  self.docs = [self.docs dictionaryByRemovingObjectForKey:key];
+  FSTMaybeDocument *_Nullable existing = self.docs[key];
+  if (existing) {
+    _bytes -= FSTApproximateDocumentBytes(existing);
+    self.docs = [self.docs dictionaryByRemovingObjectForKey:key];
+  }
 }
 
 - (nullable FSTMaybeDocument *)entryForKey:(FSTDocumentKey *)key {
   return self.docs[key];
 }
 
+- (FSTMaybeDocumentDictionary *)entriesForKeys:(FSTDocumentKeySet *)keys {
+  FSTMaybeDocumentDictionary *results = [FSTMaybeDocumentDictionary maybeDocumentDictionary];
+  if (keys.isEmpty) {
+    return results;
+  }
+
+  // Both the requested keys and the cached documents are sorted by key, so merge the two
+  // sequences rather than looking up each requested key from the root.
+  NSEnumerator<FSTDocumentKey *> *cachedKeys = [self.docs keyEnumeratorFrom:keys.firstObject];
+  FSTDocumentKey *_Nullable cachedKey = [cachedKeys nextObject];
+  for (FSTDocumentKey *key in keys.objectEnumerator) {
+    while (cachedKey && [cachedKey compare:key] == NSOrderedAscending) {
+      cachedKey = [cachedKeys nextObject];
+    }
+    if (!cachedKey) {
+      break;
+    }
+    if ([cachedKey isEqualToKey:key]) {
+      results = [results dictionaryBySettingObject:self.docs[cachedKey] forKey:cachedKey];
+      cachedKey = [cachedKeys nextObject];
+    }
+  }
+  return results;
+}
+
 - (FSTDocumentDictionary *)documentsMatchingQuery:(FSTQuery *)query {
   FSTDocumentDictionary *result = [FSTDocumentDictionary documentDictionary];
 
   // Documents are ordered by key, so we can use a prefix scan to narrow down the documents
-  // we need to match the query against.
-  FSTDocumentKey *prefix = [FSTDocumentKey keyWithPath:[query.path pathByAppendingSegment:@""]];
-  NSEnumerator<FSTDocumentKey *> *enumerator = [self.docs keyEnumeratorFrom:prefix];
+  // we need to match the query against. If the query is bounded by cursors on the key, the scan
+  // covers just the keys between them.
+  FSTDocumentKey *start = [FSTDocumentKey keyWithPath:[query.path pathByAppendingSegment:@""]];
+  FSTDocumentKey *_Nullable lowestKey = [query lowestKeyInBounds];
+  if (lowestKey && [lowestKey compare:start] == NSOrderedDescending) {
+    start = lowestKey;
+  }
+  FSTDocumentKey *_Nullable highestKey = [query highestKeyInBounds];
+  NSEnumerator<FSTDocumentKey *> *enumerator = [self.docs keyEnumeratorFrom:start];
   for (FSTDocumentKey *key in enumerator) {
-    if (![query.path isPrefixOfPath:key.path]) {
+    if (![query.path isPrefixOfPath:key.path] ||
+        (highestKey && [key compare:highestKey] == NSOrderedDescending)) {
       break;
     }
     FSTMaybeDocument *maybeDoc = self.docs[key];
@@ -79,6 +143,26 @@ NS_ASSUME_NONNULL_BEGIN
   return result;
 }
 
+- (void)enumerateDocumentsInCollection:(FSTResourcePath *)collectionPath
+                            usingBlock:(void (^)(FSTDocument *document, BOOL *stop))block {
+  FSTDocumentKey *prefix = [FSTDocumentKey keyWithPath:[collectionPath pathByAppendingSegment:@""]];
+  int childLength = collectionPath.length + 1;
+  BOOL stop = NO;
+  for (FSTDocumentKey *key in [self.docs keyEnumeratorFrom:prefix]) {
+    if (![collectionPath isPrefixOfPath:key.path]) {
+      break;
+    }
+    FSTMaybeDocument *maybeDoc = self.docs[key];
+    if (key.path.length != childLength || ![maybeDoc isKindOfClass:[FSTDocument class]]) {
+      continue;
+    }
+    block((FSTDocument *)maybeDoc, &stop);
+    if (stop) {
+      break;
+    }
+  }
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
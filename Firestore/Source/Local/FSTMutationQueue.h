@@ -18,6 +18,7 @@
 
 #import "Firestore/Source/Core/FSTTypes.h"
 #import "Firestore/Source/Local/FSTGarbageCollector.h"
+#import "Firestore/Source/Model/FSTDocumentKeySet.h"
 
 @class FSTDocumentKey;
 @class FSTMutation;
@@ -79,6 +80,17 @@ NS_ASSUME_NONNULL_BEGIN
                                           mutations:(NSArray<FSTMutation *> *)mutations
                                               group:(FSTWriteGroup *)group;
 
+/**
+ * Replaces the mutations of the last batch in this queue, keeping its batchID and local write
+ * time. The new mutations must affect the same documents as the old ones. The batch must not have
+ * been sent to the backend yet.
+ *
+ * @return The updated batch.
+ */
+- (FSTMutationBatch *)replaceMutationsOfLastBatch:(FSTMutationBatch *)batch
+                                    withMutations:(NSArray<FSTMutation *> *)mutations
+                                            group:(FSTWriteGroup *)group;
+
 /** Loads the mutation batch with the given batchID. */
 - (nullable FSTMutationBatch *)lookupMutationBatch:(FSTBatchID)batchID;
 
@@ -94,10 +106,23 @@ NS_ASSUME_NONNULL_BEGIN
 - (nullable FSTMutationBatch *)nextMutationBatchAfterBatchID:(FSTBatchID)batchID;
 
 /** Gets all mutation batches in the mutation queue. */
-// TODO(mikelehen): PERF: Current consumer only needs mutated keys; if we can provide that
-// cheaply, we should replace this.
 - (NSArray<FSTMutationBatch *> *)allMutationBatches;
 
+/**
+ * Calls the block with each mutation batch in the mutation queue, in batchID order. Unlike
+ * allMutationBatches, batches are read and decoded one at a time as the scan reaches them, so
+ * only the batches the block keeps stay in memory.
+ *
+ * @param block The block to call, which can set `*stop` to YES to end the scan.
+ */
+- (void)enumerateMutationBatchesUsingBlock:(void (^)(FSTMutationBatch *batch, BOOL *stop))block;
+
+/**
+ * Gets the keys of all documents mutated by batches in the mutation queue. The keys come from the
+ * document-mutation index, so none of the batches need to be read or decoded.
+ */
+- (FSTDocumentKeySet *)allMutatedDocumentKeys;
+
 /**
  * Finds all mutations with a batchID less than or equal to the given batchID.
  *
@@ -140,6 +165,13 @@ NS_ASSUME_NONNULL_BEGIN
 // loading them all in memory.
 - (NSArray<FSTMutationBatch *> *)allMutationBatchesAffectingQuery:(FSTQuery *)query;
 
+/**
+ * Gets the keys of the documents in the query's collection (but not its subcollections) that are
+ * mutated by batches in the mutation queue. Like allMutatedDocumentKeys, this reads just the
+ * document-mutation index.
+ */
+- (FSTDocumentKeySet *)mutatedDocumentKeysAffectingQuery:(FSTQuery *)query;
+
 /**
  * Removes the given mutation batches from the queue. This is useful in two circumstances:
  *
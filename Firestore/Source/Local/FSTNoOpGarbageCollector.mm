@@ -40,6 +40,14 @@ NS_ASSUME_NONNULL_BEGIN
   return [NSSet set];
 }
 
+- (NSSet<FSTDocumentKey *> *)collectGarbageWithTimeLimit:(NSTimeInterval)timeLimit {
+  return [NSSet set];
+}
+
+- (BOOL)hasPotentialGarbage {
+  return NO;
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -83,6 +83,13 @@ NS_ASSUME_NONNULL_BEGIN
 /** Creates an FSTRemoteDocumentCache representing the persisted cache of remote documents. */
 - (id<FSTRemoteDocumentCache>)remoteDocumentCache;
 
+/**
+ * Creates a read-only FSTRemoteDocumentCache over the remote documents as they are now, which
+ * writes committed later don't affect. Unlike the other components, the snapshot may be read on
+ * any queue, though only on one at a time. It must not be written to.
+ */
+- (id<FSTRemoteDocumentCache>)remoteDocumentCacheSnapshot;
+
 /**
  * Creates an FSTWriteGroup with the specified action description.
  *
@@ -98,6 +105,16 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)commitGroup:(FSTWriteGroup *)group;
 
+/**
+ * Runs the given block as a read transaction: all the reads it makes through the components
+ * vended by this persistence layer see a single consistent view of storage. The view is refreshed
+ * whenever a group is committed within the block, so that the block can still read its own
+ * writes once they're committed. Read transactions may be nested.
+ *
+ * @param block The block to run. It is run synchronously.
+ */
+- (void)runReadTransaction:(void (^)(void))block;
+
 @end
 
 NS_ASSUME_NONNULL_END
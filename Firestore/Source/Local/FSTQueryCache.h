@@ -57,6 +57,20 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (FSTListenSequenceNumber)highestListenSequenceNumber;
 
+/**
+ * Records that target IDs up to and including the given one may be in use, so that
+ * highestTargetID returns at least that ID from now on, including after restarts. Reserving IDs
+ * in blocks this way saves addQueryData:group: from rewriting the metadata for every new target.
+ */
+- (void)reserveTargetIDsThrough:(FSTTargetID)targetID group:(FSTWriteGroup *)group;
+
+/**
+ * Records that listen sequence numbers up to and including the given one may be in use, so that
+ * highestListenSequenceNumber returns at least that number from now on, including after restarts.
+ */
+- (void)reserveListenSequenceNumbersThrough:(FSTListenSequenceNumber)sequenceNumber
+                                      group:(FSTWriteGroup *)group;
+
 /**
  * A global snapshot version representing the last consistent snapshot we received from the
  * backend. This is monotonically increasing and any snapshots received from the backend prior to
@@ -98,6 +112,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (nullable FSTQueryData *)queryDataForQuery:(FSTQuery *)query;
 
+/**
+ * Calls the given block once for every FSTQueryData entry in the cache, in no particular order.
+ * The block can set `*stop` to YES to end the enumeration early.
+ */
+- (void)enumerateQueryDataUsingBlock:(void (^)(FSTQueryData *queryData, BOOL *stop))block;
+
 /** Adds the given document keys to cached query results of the given target ID. */
 - (void)addMatchingKeys:(FSTDocumentKeySet *)keys
             forTargetID:(FSTTargetID)targetID
@@ -57,6 +57,9 @@ typedef NS_ENUM(NSInteger, FSTQueryPurpose) {
 - (instancetype)queryDataByReplacingSnapshotVersion:(FSTSnapshotVersion *)snapshotVersion
                                         resumeToken:(NSData *)resumeToken;
 
+/** Creates a new query data instance with an updated listen sequence number. */
+- (instancetype)queryDataByReplacingListenSequenceNumber:(FSTListenSequenceNumber)sequenceNumber;
+
 /** The query being listened to. */
 @property(nonatomic, strong, readonly) FSTQuery *query;
 
@@ -93,6 +93,15 @@ NS_ASSUME_NONNULL_BEGIN
                                  resumeToken:resumeToken];
 }
 
+- (instancetype)queryDataByReplacingListenSequenceNumber:(FSTListenSequenceNumber)sequenceNumber {
+  return [[FSTQueryData alloc] initWithQuery:self.query
+                                    targetID:self.targetID
+                        listenSequenceNumber:sequenceNumber
+                                     purpose:self.purpose
+                             snapshotVersion:self.snapshotVersion
+                                 resumeToken:self.resumeToken];
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -19,6 +19,7 @@
 #import "Firestore/Source/Core/FSTTypes.h"
 #import "Firestore/Source/Local/FSTGarbageCollector.h"
 #import "Firestore/Source/Model/FSTDocumentKeySet.h"
+#import "Firestore/Source/Model/FSTMemoryUsage.h"
 
 @class FSTDocumentKey;
 
@@ -29,10 +30,12 @@ NS_ASSUME_NONNULL_BEGIN
  * batchID). As references are added to or removed from the set corresponding events are emitted to
  * a registered garbage collector.
  *
- * Each reference is represented by a FSTDocumentReference object. Each of them contains enough
- * information to uniquely identify the reference. They are all stored primarily in a set sorted
- * by key. A document is considered garbage if there's no references in that set (this can be
- * efficiently checked thanks to sorting by key).
+ * Each reference is a (key, ID) pair, which is enough to uniquely identify it. They are all stored
+ * primarily in a set sorted by key. A document is considered garbage if there's no references in
+ * that set (this can be efficiently checked thanks to sorting by key).
+ *
+ * Adding or removing references for a batch of keys is applied to each set as a single sorted
+ * merge.
  *
  * FSTReferenceSet also keeps a secondary set that contains references sorted by IDs. This one is
  * used to efficiently implement removal of all references by some target ID.
@@ -45,6 +48,9 @@ NS_ASSUME_NONNULL_BEGIN
 /** Returns YES if the reference set contains no references. */
 - (BOOL)isEmpty;
 
+/** Returns the number of references in the set and the approximate bytes they take up. */
+- (FSTMemoryUsage)memoryUsage;
+
 /** Adds a reference to the given document key for the given ID. */
 - (void)addReferenceToKey:(FSTDocumentKey *)key forID:(int)ID;
 
@@ -16,118 +16,200 @@
 
 #import "Firestore/Source/Local/FSTReferenceSet.h"
 
-#import "Firestore/Source/Local/FSTDocumentReference.h"
+#include <climits>
+#include <string>
+#include <vector>
+
 #import "Firestore/Source/Model/FSTDocumentKey.h"
 
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+
+using firebase::firestore::immutable::SortedMap;
+
 NS_ASSUME_NONNULL_BEGIN
 
-#pragma mark - FSTReferenceSet
+namespace {
 
-@interface FSTReferenceSet ()
+/** A reference to a document from a target ID or batch ID. */
+struct Reference {
+  Reference() : Reference(nil, 0) {
+  }
 
-/** A set of outstanding references to a document sorted by key. */
-@property(nonatomic, strong) FSTImmutableSortedSet<FSTDocumentReference *> *referencesByKey;
+  Reference(FSTDocumentKey *_Nullable key, int ID)
+      : key(key), encodedPath(key ? &[key encodedPath] : &EmptyPath()), ID(ID) {
+  }
 
-/** A set of outstanding references to a document sorted by target ID (or batch ID). */
-@property(nonatomic, strong) FSTImmutableSortedSet<FSTDocumentReference *> *referencesByID;
+  /** The smallest reference with the given ID. */
+  static Reference Min(int ID) {
+    return Reference(nil, ID);
+  }
 
-@end
+  static const std::string &EmptyPath() {
+    static const std::string *empty = new std::string();
+    return *empty;
+  }
 
-@implementation FSTReferenceSet
+  FSTDocumentKey *_Nullable key;
 
-#pragma mark - Initializer
+  /** The key's encoded path, kept here so that comparisons don't have to message the key. */
+  const std::string *encodedPath;
 
-- (instancetype)init {
-  self = [super init];
-  if (self) {
-    _referencesByKey =
-        [FSTImmutableSortedSet setWithComparator:FSTDocumentReferenceComparatorByKey];
-    _referencesByID = [FSTImmutableSortedSet setWithComparator:FSTDocumentReferenceComparatorByID];
+  int ID;
+};
+
+/** Sorts references by key then ID. */
+struct ReferenceByKey {
+  bool operator()(const Reference &lhs, const Reference &rhs) const {
+    int result = lhs.encodedPath->compare(*rhs.encodedPath);
+    return result < 0 || (result == 0 && lhs.ID < rhs.ID);
+  }
+};
+
+/** Sorts references by ID then key. */
+struct ReferenceByID {
+  bool operator()(const Reference &lhs, const Reference &rhs) const {
+    if (lhs.ID != rhs.ID) {
+      return lhs.ID < rhs.ID;
+    }
+    return *lhs.encodedPath < *rhs.encodedPath;
   }
-  return self;
+};
+
+// The maps are used as sets: only the keys matter.
+using ReferencesByKey = SortedMap<Reference, bool, ReferenceByKey>;
+using ReferencesByID = SortedMap<Reference, bool, ReferenceByID>;
+
+}  // namespace
+
+#pragma mark - FSTReferenceSet
+
+@implementation FSTReferenceSet {
+  /** A set of outstanding references to a document sorted by key. */
+  ReferencesByKey _referencesByKey;
+
+  /** A set of outstanding references to a document sorted by target ID (or batch ID). */
+  ReferencesByID _referencesByID;
 }
 
 #pragma mark - Testing helper methods
 
 - (BOOL)isEmpty {
-  return [self.referencesByKey isEmpty];
+  return _referencesByKey.empty();
 }
 
 - (NSUInteger)count {
-  return self.referencesByKey.count;
+  return _referencesByKey.size();
 }
 
 #pragma mark - Public methods
 
+- (FSTMemoryUsage)memoryUsage {
+  // Each reference is a node in both maps, which besides the reference holds its children, its
+  // color and the size of its subtree.
+  const int64_t bytesPerReference = 2 * (sizeof(Reference) + 4 * sizeof(void *));
+  int64_t count = static_cast<int64_t>(_referencesByKey.size());
+  return FSTMemoryUsage{count, count * bytesPerReference};
+}
+
 - (void)addReferenceToKey:(FSTDocumentKey *)key forID:(int)ID {
-  FSTDocumentReference *reference = [[FSTDocumentReference alloc] initWithKey:key ID:ID];
-  self.referencesByKey = [self.referencesByKey setByAddingObject:reference];
-  self.referencesByID = [self.referencesByID setByAddingObject:reference];
+  Reference reference(key, ID);
+  _referencesByKey = _referencesByKey.insert(reference, true);
+  _referencesByID = _referencesByID.insert(reference, true);
 }
 
 - (void)addReferencesToKeys:(FSTDocumentKeySet *)keys forID:(int)ID {
-  [keys enumerateObjectsUsingBlock:^(FSTDocumentKey *key, BOOL *stop) {
-    [self addReferenceToKey:key forID:ID];
-  }];
+  // Apply the whole batch as one sorted merge into each set rather than one insertion per key.
+  ReferencesByKey::Builder byKey{_referencesByKey};
+  ReferencesByID::Builder byID{_referencesByID};
+  byKey.reserve(keys.count);
+  byID.reserve(keys.count);
+  for (FSTDocumentKey *key in keys.objectEnumerator) {
+    Reference reference(key, ID);
+    byKey.insert(reference, true);
+    byID.insert(reference, true);
+  }
+  _referencesByKey = byKey.Build();
+  _referencesByID = byID.Build();
 }
 
 - (void)removeReferenceToKey:(FSTDocumentKey *)key forID:(int)ID {
-  [self removeReference:[[FSTDocumentReference alloc] initWithKey:key ID:ID]];
+  Reference reference(key, ID);
+  _referencesByKey = _referencesByKey.erase(reference);
+  _referencesByID = _referencesByID.erase(reference);
+  [self.garbageCollector addPotentialGarbageKey:key];
 }
 
 - (void)removeReferencesToKeys:(FSTDocumentKeySet *)keys forID:(int)ID {
-  [keys enumerateObjectsUsingBlock:^(FSTDocumentKey *key, BOOL *stop) {
-    [self removeReferenceToKey:key forID:ID];
-  }];
+  std::vector<Reference> references;
+  references.reserve(keys.count);
+  for (FSTDocumentKey *key in keys.objectEnumerator) {
+    references.emplace_back(key, ID);
+  }
+  [self removeReferences:references];
 }
 
 - (void)removeReferencesForID:(int)ID {
-  FSTDocumentKey *emptyKey = [FSTDocumentKey keyWithSegments:@[]];
-  FSTDocumentReference *start = [[FSTDocumentReference alloc] initWithKey:emptyKey ID:ID];
-  FSTDocumentReference *end = [[FSTDocumentReference alloc] initWithKey:emptyKey ID:(ID + 1)];
-
-  [self.referencesByID enumerateObjectsFrom:start
-                                         to:end
-                                 usingBlock:^(FSTDocumentReference *reference, BOOL *stop) {
-                                   [self removeReference:reference];
-                                 }];
+  [self removeReferences:[self referencesForID:ID]];
 }
 
 - (void)removeAllReferences {
-  for (FSTDocumentReference *reference in self.referencesByKey.objectEnumerator) {
-    [self removeReference:reference];
+  std::vector<Reference> references;
+  references.reserve(_referencesByKey.size());
+  for (const auto &entry : _referencesByKey) {
+    references.push_back(entry.first);
+  }
+  _referencesByKey = ReferencesByKey{};
+  _referencesByID = ReferencesByID{};
+  for (const Reference &reference : references) {
+    [self.garbageCollector addPotentialGarbageKey:reference.key];
   }
-}
-
-- (void)removeReference:(FSTDocumentReference *)reference {
-  self.referencesByKey = [self.referencesByKey setByRemovingObject:reference];
-  self.referencesByID = [self.referencesByID setByRemovingObject:reference];
-  [self.garbageCollector addPotentialGarbageKey:reference.key];
 }
 
 - (FSTDocumentKeySet *)referencedKeysForID:(int)ID {
-  FSTDocumentKey *emptyKey = [FSTDocumentKey keyWithSegments:@[]];
-  FSTDocumentReference *start = [[FSTDocumentReference alloc] initWithKey:emptyKey ID:ID];
-  FSTDocumentReference *end = [[FSTDocumentReference alloc] initWithKey:emptyKey ID:(ID + 1)];
-
-  __block FSTDocumentKeySet *keys = [FSTDocumentKeySet keySet];
-  [self.referencesByID enumerateObjectsFrom:start
-                                         to:end
-                                 usingBlock:^(FSTDocumentReference *reference, BOOL *stop) {
-                                   keys = [keys setByAddingObject:reference.key];
-                                 }];
+  FSTDocumentKeySet *keys = [FSTDocumentKeySet keySet];
+  for (const Reference &reference : [self referencesForID:ID]) {
+    keys = [keys setByAddingObject:reference.key];
+  }
   return keys;
 }
 
 - (BOOL)containsKey:(FSTDocumentKey *)key {
-  // Create a reference with a zero ID as the start position to find any document reference with
-  // this key.
-  FSTDocumentReference *reference = [[FSTDocumentReference alloc] initWithKey:key ID:0];
-
-  NSEnumerator<FSTDocumentReference *> *enumerator =
-      [self.referencesByKey objectEnumeratorFrom:reference];
-  FSTDocumentKey *_Nullable firstKey = [enumerator nextObject].key;
-  return [firstKey isEqual:reference.key];
+  // Use the smallest possible ID as the start position to find any reference with this key.
+  auto found = _referencesByKey.lower_bound(Reference(key, INT_MIN));
+  return found != _referencesByKey.end() && [found->first.key isEqualToKey:key];
+}
+
+#pragma mark - Private methods
+
+/** Returns all the references with the given ID, sorted by key. */
+- (std::vector<Reference>)referencesForID:(int)ID {
+  std::vector<Reference> references;
+  for (auto iter = _referencesByID.lower_bound(Reference::Min(ID));
+       iter != _referencesByID.end() && iter->first.ID == ID; ++iter) {
+    references.push_back(iter->first);
+  }
+  return references;
+}
+
+/** Removes the given references in one batch and reports their keys as potential garbage. */
+- (void)removeReferences:(const std::vector<Reference> &)references {
+  if (references.empty()) {
+    return;
+  }
+  ReferencesByKey::Builder byKey{_referencesByKey};
+  ReferencesByID::Builder byID{_referencesByID};
+  byKey.reserve(references.size());
+  byID.reserve(references.size());
+  for (const Reference &reference : references) {
+    byKey.erase(reference);
+    byID.erase(reference);
+  }
+  _referencesByKey = byKey.Build();
+  _referencesByID = byID.Build();
+
+  for (const Reference &reference : references) {
+    [self.garbageCollector addPotentialGarbageKey:reference.key];
+  }
 }
 
 @end
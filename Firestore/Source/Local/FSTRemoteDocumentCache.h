@@ -17,10 +17,14 @@
 #import <Foundation/Foundation.h>
 
 #import "Firestore/Source/Model/FSTDocumentDictionary.h"
+#import "Firestore/Source/Model/FSTDocumentKeySet.h"
+#import "Firestore/Source/Model/FSTMemoryUsage.h"
 
+@class FSTDocument;
 @class FSTDocumentKey;
 @class FSTMaybeDocument;
 @class FSTQuery;
+@class FSTResourcePath;
 @class FSTWriteGroup;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -58,6 +62,18 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (nullable FSTMaybeDocument *)entryForKey:(FSTDocumentKey *)documentKey;
 
+/**
+ * Looks up a set of entries in the cache.
+ *
+ * This is equivalent to calling entryForKey: for each key, but implementations can take advantage
+ * of the keys being sorted to avoid a separate lookup per key.
+ *
+ * @param documentKeys The keys of the entries to look up.
+ * @return A dictionary of the cached FSTDocument or FSTDeletedDocument entries. Keys for which
+ * nothing is cached are absent from the result.
+ */
+- (FSTMaybeDocumentDictionary *)entriesForKeys:(FSTDocumentKeySet *)documentKeys;
+
 /**
  * Executes a query against the cached FSTDocument entries
  *
@@ -71,6 +87,27 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (FSTDocumentDictionary *)documentsMatchingQuery:(FSTQuery *)query;
 
+/**
+ * Enumerates the cached FSTDocument entries that are immediate children of the given collection,
+ * in key order, until the block sets `stop` to YES. Cached FSTDeletedDocument entries are skipped.
+ *
+ * Unlike documentsMatchingQuery:, this reads only as many documents as the caller consumes.
+ */
+- (void)enumerateDocumentsInCollection:(FSTResourcePath *)collectionPath
+                            usingBlock:(void (^)(FSTDocument *document, BOOL *stop))block;
+
+/**
+ * Returns the documents this cache holds in memory and the approximate bytes they take up, which
+ * implementations keep track of as entries change.
+ */
+- (FSTMemoryUsage)memoryUsage;
+
+/**
+ * Drops whatever this cache holds in memory that can be read again from storage, e.g. in response
+ * to a memory warning.
+ */
+- (void)releaseCachedMemory;
+
 @end
 
 NS_ASSUME_NONNULL_END
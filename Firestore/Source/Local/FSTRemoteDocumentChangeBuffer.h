@@ -16,6 +16,8 @@
 
 #import <Foundation/Foundation.h>
 
+#import "Firestore/Source/Model/FSTDocumentKeySet.h"
+
 NS_ASSUME_NONNULL_BEGIN
 
 @protocol FSTRemoteDocumentCache;
@@ -55,6 +57,13 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (nullable FSTMaybeDocument *)entryForKey:(FSTDocumentKey *)documentKey;
 
+/**
+ * Reads the entries for all the given keys with a single `FSTRemoteDocumentCache entriesForKeys:`
+ * call, so that later `entryForKey:` lookups of any of them are answered without going back to
+ * the cache. Buffered changes still take precedence over what was read.
+ */
+- (void)prefetchEntriesForKeys:(FSTDocumentKeySet *)documentKeys;
+
 /**
  * Applies buffered changes to the underlying FSTRemoteDocumentCache, using the provided
  * FSTWriteGroup.
@@ -18,6 +18,7 @@
 
 #import "Firestore/Source/Local/FSTRemoteDocumentCache.h"
 #import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTDocumentDictionary.h"
 #import "Firestore/Source/Model/FSTDocumentKey.h"
 #import "Firestore/Source/Util/FSTAssert.h"
 
@@ -34,6 +35,12 @@ NS_ASSUME_NONNULL_BEGIN
 @property(nonatomic, strong, nullable)
     NSMutableDictionary<FSTDocumentKey *, FSTMaybeDocument *> *changes;
 
+/** The keys read by prefetchEntriesForKeys:, including the ones with nothing cached. */
+@property(nonatomic, strong) FSTDocumentKeySet *prefetchedKeys;
+
+/** The cached entries for prefetchedKeys. */
+@property(nonatomic, strong) FSTMaybeDocumentDictionary *prefetchedEntries;
+
 @end
 
 @implementation FSTRemoteDocumentChangeBuffer
@@ -46,6 +53,8 @@ NS_ASSUME_NONNULL_BEGIN
   if (self = [super init]) {
     _remoteDocumentCache = cache;
     _changes = [NSMutableDictionary dictionary];
+    _prefetchedKeys = [FSTDocumentKeySet keySet];
+    _prefetchedEntries = [FSTMaybeDocumentDictionary maybeDocumentDictionary];
   }
   return self;
 }
@@ -62,11 +71,20 @@ NS_ASSUME_NONNULL_BEGIN
   FSTMaybeDocument *bufferedEntry = self.changes[documentKey];
   if (bufferedEntry) {
     return bufferedEntry;
+  } else if ([self.prefetchedKeys containsObject:documentKey]) {
+    return self.prefetchedEntries[documentKey];
   } else {
     return [self.remoteDocumentCache entryForKey:documentKey];
   }
 }
 
+- (void)prefetchEntriesForKeys:(FSTDocumentKeySet *)documentKeys {
+  [self assertValid];
+
+  self.prefetchedKeys = documentKeys;
+  self.prefetchedEntries = [self.remoteDocumentCache entriesForKeys:documentKeys];
+}
+
 - (void)applyToWriteGroup:(FSTWriteGroup *)group {
   [self assertValid];
 
@@ -77,6 +95,8 @@ NS_ASSUME_NONNULL_BEGIN
 
   // We should not be used to buffer any more changes.
   self.changes = nil;
+  self.prefetchedKeys = [FSTDocumentKeySet keySet];
+  self.prefetchedEntries = [FSTMaybeDocumentDictionary maybeDocumentDictionary];
 }
 
 - (void)assertValid {
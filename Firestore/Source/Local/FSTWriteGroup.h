@@ -17,6 +17,9 @@
 #import <Foundation/Foundation.h>
 
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "Firestore/Source/Local/StringView.h"
 #include "leveldb/db.h"
@@ -25,6 +28,25 @@ NS_ASSUME_NONNULL_BEGIN
 
 @class GPBMessage;
 
+/** How durably the writes in an FSTWriteGroup are persisted when the group is committed. */
+typedef NS_ENUM(NSInteger, FSTWriteDurability) {
+  /**
+   * The writes are handed to the operating system without waiting for them to reach the disk.
+   * They survive the app crashing but may be lost if the device loses power.
+   */
+  FSTWriteDurabilityAsync,
+
+  /**
+   * The writes are committed like FSTWriteDurabilityAsync, and then synced to disk shortly
+   * afterwards, together with any other writes committed in the meantime. This amortizes the cost
+   * of syncing across bursts of commits.
+   */
+  FSTWriteDurabilityCoalescedSync,
+
+  /** The writes have been synced to disk by the time the commit completes. */
+  FSTWriteDurabilitySync,
+};
+
 /**
  * A group of writes that will be applied together atomically to persistent storage.
  *
@@ -51,9 +73,21 @@ NS_ASSUME_NONNULL_BEGIN
 /** The action description assigned to this write group. */
 @property(nonatomic, copy, readonly) NSString *action;
 
+/** The durability with which the group is committed. Defaults to FSTWriteDurabilityAsync. */
+@property(nonatomic, assign) FSTWriteDurability durability;
+
 /** Returns YES if the write group has no messages in it. */
 - (BOOL)isEmpty;
 
+/** The number of sets and removals in the group. */
+@property(nonatomic, assign, readonly) int changeCount;
+
+/** The number of removals in the group. */
+@property(nonatomic, assign, readonly) int removalCount;
+
+/** The approximate size of the group's contents when written, in bytes. */
+@property(nonatomic, assign, readonly) size_t byteSize;
+
 /**
  * Marks the given key for deletion.
  *
@@ -78,7 +112,27 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)setData:(Firestore::StringView)data forKey:(Firestore::StringView)key;
 
-/** Writes the contents to the given LevelDB. */
+/**
+ * Asks for the rows with keys in [startKey, endKey) to be compacted in the background once the
+ * group has been committed. LevelDB keeps the tombstones of removed rows until they're compacted,
+ * and every later scan of the range has to step over them, so a group that removes a large range
+ * of rows should follow up with a compaction of that range.
+ */
+- (void)compactRangeFromKey:(Firestore::StringView)startKey toKey:(Firestore::StringView)endKey;
+
+/** The ranges of keys, as [start, end) pairs, to compact once the group has been committed. */
+- (const std::vector<std::pair<std::string, std::string>> &)compactionRanges;
+
+/**
+ * Returns the smallest range of keys, as a [start, end) pair, that holds every key the group
+ * removes. This scans the whole group, so it's meant for groups with many removals.
+ */
+- (std::pair<std::string, std::string>)removedKeyRange;
+
+/**
+ * Writes the contents to the given LevelDB, syncing them to disk if the durability is
+ * FSTWriteDurabilitySync. Syncing FSTWriteDurabilityCoalescedSync writes is up to the caller.
+ */
 - (leveldb::Status)writeToDB:(std::shared_ptr<leveldb::DB>)db;
 
 @end
@@ -19,11 +19,17 @@
 #import <Protobuf/GPBProtocolBuffers.h>
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
+#include <string>
+#include <utility>
+#include <vector>
 
 #import "Firestore/Source/Local/FSTLevelDBKey.h"
 #import "Firestore/Source/Util/FSTAssert.h"
 
+#include "Firestore/core/src/firebase/firestore/util/string_util.h"
+
 using Firestore::StringView;
+using firebase::firestore::util::ImmediateSuccessor;
 using leveldb::DB;
 using leveldb::Slice;
 using leveldb::Status;
@@ -47,7 +53,8 @@ class BatchDescription : public WriteBatch::Handler {
   virtual void Delete(const Slice &key);
 
   // Converts the batch to a printable string description of it
-  NSString *ToString() const {
+  NSString *ToString() {
+    EndDeleteRun();
     return [NSString
         stringWithFormat:@"%d changes (%lu bytes):%@", ops_, (unsigned long)size_, message_];
   }
@@ -59,15 +66,24 @@ class BatchDescription : public WriteBatch::Handler {
   BatchDescription &operator=(BatchDescription &&) = delete;
 
  private:
+  // Describes the run of consecutive deletes seen since the last put, if any, as a single line.
+  void EndDeleteRun();
+
   int ops_;
   size_t size_;
   NSMutableString *message_;
+
+  // The first and last keys of the current run of deletes, and its length.
+  std::string first_deleted_;
+  std::string last_deleted_;
+  int deletes_in_run_ = 0;
 };
 
 BatchDescription::~BatchDescription() {
 }
 
 void BatchDescription::Put(const Slice &key, const Slice &value) {
+  EndDeleteRun();
   ops_ += 1;
   size_ += value.size();
 
@@ -78,9 +94,54 @@ void BatchDescription::Put(const Slice &key, const Slice &value) {
 void BatchDescription::Delete(const Slice &key) {
   ops_ += 1;
 
-  [message_ appendFormat:@"\n  - Delete %@", [FSTLevelDBKey descriptionForKey:key]];
+  // Bulk removals delete thousands of rows at once, so only their ends are worth formatting.
+  if (deletes_in_run_ == 0) {
+    first_deleted_ = key.ToString();
+  } else {
+    last_deleted_ = key.ToString();
+  }
+  deletes_in_run_ += 1;
+}
+
+void BatchDescription::EndDeleteRun() {
+  if (deletes_in_run_ == 1) {
+    [message_ appendFormat:@"\n  - Delete %@", [FSTLevelDBKey descriptionForKey:first_deleted_]];
+  } else if (deletes_in_run_ > 1) {
+    [message_ appendFormat:@"\n  - Delete %@ through %@ (%d keys)",
+                           [FSTLevelDBKey descriptionForKey:first_deleted_],
+                           [FSTLevelDBKey descriptionForKey:last_deleted_], deletes_in_run_];
+  }
+  deletes_in_run_ = 0;
 }
 
+/** A WriteBatch::Handler that finds the smallest and largest keys deleted by a batch. */
+class DeletedKeyRange : public WriteBatch::Handler {
+ public:
+  void Put(const Slice &key, const Slice &value) override {
+  }
+
+  void Delete(const Slice &key) override {
+    if (first_.empty() || key.compare(first_) < 0) {
+      first_ = key.ToString();
+    }
+    if (last_.empty() || key.compare(last_) > 0) {
+      last_ = key.ToString();
+    }
+  }
+
+  // Returns the range as a [start, end) pair, which is empty if there were no deletes.
+  std::pair<std::string, std::string> ToRange() const {
+    if (first_.empty()) {
+      return {};
+    }
+    return {first_, ImmediateSuccessor(last_)};
+  }
+
+ private:
+  std::string first_;
+  std::string last_;
+};
+
 }  // namespace Firestore
 
 @interface FSTWriteGroup ()
@@ -89,7 +150,9 @@ void BatchDescription::Delete(const Slice &key) {
 
 @implementation FSTWriteGroup {
   int _changes;
+  int _removals;
   WriteBatch _contents;
+  std::vector<std::pair<std::string, std::string>> _compactionRanges;
 }
 
 + (instancetype)groupWithAction:(NSString *)action {
@@ -116,6 +179,7 @@ void BatchDescription::Delete(const Slice &key) {
 - (void)removeMessageForKey:(StringView)key {
   _contents.Delete(key);
   _changes += 1;
+  _removals += 1;
 }
 
 - (void)setMessage:(GPBMessage *)message forKey:(StringView)key {
@@ -131,14 +195,47 @@ void BatchDescription::Delete(const Slice &key) {
   _changes += 1;
 }
 
+- (void)compactRangeFromKey:(StringView)startKey toKey:(StringView)endKey {
+  Slice start = startKey;
+  Slice end = endKey;
+  _compactionRanges.emplace_back(start.ToString(), end.ToString());
+}
+
+- (const std::vector<std::pair<std::string, std::string>> &)compactionRanges {
+  return _compactionRanges;
+}
+
+- (std::pair<std::string, std::string>)removedKeyRange {
+  Firestore::DeletedKeyRange range;
+  Status status = _contents.Iterate(&range);
+  if (!status.ok()) {
+    FSTFail(@"Iterate over write batch should not fail");
+  }
+  return range.ToRange();
+}
+
 - (leveldb::Status)writeToDB:(std::shared_ptr<leveldb::DB>)db {
-  return db->Write(leveldb::WriteOptions(), &_contents);
+  WriteOptions options;
+  options.sync = self.durability == FSTWriteDurabilitySync;
+  return db->Write(options, &_contents);
 }
 
 - (BOOL)isEmpty {
   return _changes == 0;
 }
 
+- (int)changeCount {
+  return _changes;
+}
+
+- (int)removalCount {
+  return _removals;
+}
+
+- (size_t)byteSize {
+  return _contents.ApproximateSize();
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
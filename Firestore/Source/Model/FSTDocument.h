@@ -35,12 +35,29 @@ NS_ASSUME_NONNULL_BEGIN
 @property(nonatomic, readonly) FSTSnapshotVersion *version;
 @end
 
+/** Decodes the top-level field with the given name, or returns nil if the document lacks it. */
+typedef FSTFieldValue *_Nullable (^FSTDocumentFieldDecoder)(NSString *fieldName);
+
+/** Decodes all of a document's fields. */
+typedef FSTObjectValue *_Nonnull (^FSTDocumentDataDecoder)(void);
+
 @interface FSTDocument : FSTMaybeDocument
 + (instancetype)documentWithData:(FSTObjectValue *)data
                              key:(FSTDocumentKey *)key
                          version:(FSTSnapshotVersion *)version
                hasLocalMutations:(BOOL)mutations;
 
+/**
+ * Creates a document whose fields stay in their encoded form until they're read. fieldForPath:
+ * decodes just the top-level field the path starts with, and the whole document is decoded only
+ * once `data` is read. Both decoders are released after that.
+ */
++ (instancetype)documentWithKey:(FSTDocumentKey *)key
+                        version:(FSTSnapshotVersion *)version
+              hasLocalMutations:(BOOL)mutations
+                   fieldDecoder:(FSTDocumentFieldDecoder)fieldDecoder
+                    dataDecoder:(FSTDocumentDataDecoder)dataDecoder;
+
 - (nullable FSTFieldValue *)fieldForPath:(FSTFieldPath *)path;
 
 @property(nonatomic, strong, readonly) FSTObjectValue *data;
@@ -50,7 +50,16 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
-@implementation FSTDocument
+@implementation FSTDocument {
+  // All guarded by @synchronized(self) until the data has been decoded. Documents are shared
+  // between threads, so reads may race to decode them.
+  FSTObjectValue *_Nullable _data;
+  FSTDocumentFieldDecoder _Nullable _fieldDecoder;
+  FSTDocumentDataDecoder _Nullable _dataDecoder;
+
+  /** The top-level fields decoded so far, with NSNull marking known-missing fields. */
+  NSMutableDictionary<NSString *, id> *_Nullable _decodedFields;
+}
 
 + (instancetype)documentWithData:(FSTObjectValue *)data
                              key:(FSTDocumentKey *)key
@@ -60,7 +69,19 @@ NS_ASSUME_NONNULL_BEGIN
       [[FSTDocument alloc] initWithData:data key:key version:version hasLocalMutations:mutations];
 }
 
-- (instancetype)initWithData:(FSTObjectValue *)data
++ (instancetype)documentWithKey:(FSTDocumentKey *)key
+                        version:(FSTSnapshotVersion *)version
+              hasLocalMutations:(BOOL)mutations
+                   fieldDecoder:(FSTDocumentFieldDecoder)fieldDecoder
+                    dataDecoder:(FSTDocumentDataDecoder)dataDecoder {
+  FSTDocument *document =
+      [[FSTDocument alloc] initWithData:nil key:key version:version hasLocalMutations:mutations];
+  document->_fieldDecoder = fieldDecoder;
+  document->_dataDecoder = dataDecoder;
+  return document;
+}
+
+- (instancetype)initWithData:(nullable FSTObjectValue *)data
                          key:(FSTDocumentKey *)key
                      version:(FSTSnapshotVersion *)version
            hasLocalMutations:(BOOL)mutations {
@@ -72,6 +93,18 @@ NS_ASSUME_NONNULL_BEGIN
   return self;
 }
 
+- (FSTObjectValue *)data {
+  @synchronized(self) {
+    if (!_data) {
+      _data = _dataDecoder();
+      _dataDecoder = nil;
+      _fieldDecoder = nil;
+      _decodedFields = nil;
+    }
+    return _data;
+  }
+}
+
 - (BOOL)isEqual:(id)other {
   if (other == self) {
     return YES;
@@ -100,7 +133,31 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (nullable FSTFieldValue *)fieldForPath:(FSTFieldPath *)path {
-  return [_data valueForPath:path];
+  FSTFieldValue *_Nullable field;
+  @synchronized(self) {
+    if (_data || path.length == 0) {
+      return [self.data valueForPath:path];
+    }
+
+    NSString *fieldName = [path firstSegment];
+    if (!_decodedFields) {
+      _decodedFields = [NSMutableDictionary dictionary];
+    }
+    id _Nullable decoded = _decodedFields[fieldName];
+    if (!decoded) {
+      decoded = _fieldDecoder(fieldName) ?: [NSNull null];
+      _decodedFields[fieldName] = decoded;
+    }
+    field = decoded == [NSNull null] ? nil : decoded;
+  }
+
+  if (path.length == 1 || !field) {
+    return field;
+  }
+  if (![field isMemberOfClass:[FSTObjectValue class]]) {
+    return nil;
+  }
+  return [(FSTObjectValue *)field valueForPath:[path pathByRemovingFirstSegment]];
 }
 
 @end
@@ -36,6 +36,14 @@ typedef FSTImmutableSortedDictionary<FSTDocumentKey *, FSTDocument *> FSTDocumen
 /** Returns a new set using the DocumentKeyComparator. */
 + (FSTMaybeDocumentDictionary *)maybeDocumentDictionary;
 
+/**
+ * Returns a new dictionary using the DocumentKeyComparator, containing the given entries. Sorting
+ * happens once, so accumulating entries in an NSMutableDictionary and calling this is cheaper than
+ * setting them in an immutable dictionary one at a time.
+ */
++ (FSTMaybeDocumentDictionary *)maybeDocumentDictionaryWithDictionary:
+    (NSDictionary<FSTDocumentKey *, FSTMaybeDocument *> *)dictionary;
+
 /** Returns a new set using the DocumentKeyComparator. */
 + (FSTDocumentDictionary *)documentDictionary;
 
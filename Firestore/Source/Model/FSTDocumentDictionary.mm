@@ -28,6 +28,12 @@ NS_ASSUME_NONNULL_BEGIN
   return [FSTDocumentDictionary documentDictionary];
 }
 
++ (instancetype)maybeDocumentDictionaryWithDictionary:
+    (NSDictionary<FSTDocumentKey *, FSTMaybeDocument *> *)dictionary {
+  return [FSTMaybeDocumentDictionary dictionaryWithDictionary:dictionary
+                                                   comparator:FSTDocumentKeyComparator];
+}
+
 + (instancetype)documentDictionary {
   static FSTDocumentDictionary *singleton;
   static dispatch_once_t onceToken;
@@ -16,6 +16,8 @@
 
 #import <Foundation/Foundation.h>
 
+#include <string>
+
 @class FSTResourcePath;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -56,6 +58,12 @@ NS_ASSUME_NONNULL_BEGIN
 /** The path to the document. */
 @property(strong, nonatomic, readonly) FSTResourcePath *path;
 
+/**
+ * The path to the document encoded as in LevelDB keys. Encoded paths compare bytewise in the same
+ * order as the keys.
+ */
+- (const std::string &)encodedPath;
+
 @end
 
 extern const NSComparator FSTDocumentKeyComparator;
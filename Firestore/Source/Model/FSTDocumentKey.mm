@@ -16,21 +16,114 @@
 
 #import "Firestore/Source/Model/FSTDocumentKey.h"
 
+#include <algorithm>
+#include <functional>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+#include <utility>
+
 #import "Firestore/Source/Core/FSTFirestoreClient.h"
 #import "Firestore/Source/Model/FSTPath.h"
 #import "Firestore/Source/Util/FSTAssert.h"
 
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+
+namespace util = firebase::firestore::util;
+using firebase::firestore::local::EncodeResourcePath;
+using firebase::firestore::local::PathSegments;
+
 NS_ASSUME_NONNULL_BEGIN
 
+namespace {
+
+/** The number of entries at which the intern table is first swept for deallocated keys. */
+const size_t kMinInternTableSweepSize = 1024;
+
+/**
+ * All the live document keys, by encoded path. Entries are weak so that the table doesn't keep
+ * keys alive; entries for deallocated keys are swept out as the table grows.
+ */
+class InternTable {
+ public:
+  FSTDocumentKey *_Nullable Find(const std::string &encodedPath) {
+    auto found = keys_.find(encodedPath);
+    return found == keys_.end() ? nil : found->second;
+  }
+
+  void Insert(const std::string &encodedPath, FSTDocumentKey *key) {
+    keys_[encodedPath] = key;
+    if (keys_.size() >= next_sweep_size_) {
+      Sweep();
+    }
+  }
+
+  std::mutex &mutex() {
+    return mutex_;
+  }
+
+ private:
+  void Sweep() {
+    for (auto iter = keys_.begin(); iter != keys_.end();) {
+      if (iter->second == nil) {
+        iter = keys_.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+    next_sweep_size_ = std::max(kMinInternTableSweepSize, keys_.size() * 2);
+  }
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, __weak FSTDocumentKey *> keys_;
+  size_t next_sweep_size_ = kMinInternTableSweepSize;
+};
+
+InternTable &SharedInternTable() {
+  static InternTable *table = new InternTable();
+  return *table;
+}
+
+/** Returns the path encoded as in LevelDB keys, which sorts bytewise in path order. */
+std::string EncodePath(FSTResourcePath *path) {
+  PathSegments segments;
+  segments.reserve(path.length);
+  for (int i = 0; i < path.length; ++i) {
+    segments.push_back(util::MakeStringView([path segmentAtIndex:i]));
+  }
+  return EncodeResourcePath(segments);
+}
+
+}  // namespace
+
 @interface FSTDocumentKey ()
 /** The path to the document. */
 @property(strong, nonatomic, readwrite) FSTResourcePath *path;
 @end
 
-@implementation FSTDocumentKey
+@implementation FSTDocumentKey {
+  /** The path encoded as in LevelDB keys; comparing keys compares these bytes. */
+  std::string _encodedPath;
+
+  NSUInteger _hash;
+}
 
 + (instancetype)keyWithPath:(FSTResourcePath *)path {
-  return [[FSTDocumentKey alloc] initWithPath:path];
+  FSTAssert([FSTDocumentKey isDocumentKey:path], @"invalid document key path: %@", path);
+
+  // Keys are interned, so keys with equal paths are usually the same object and comparing them
+  // for equality doesn't have to look at the path at all.
+  std::string encodedPath = EncodePath(path);
+  InternTable &table = SharedInternTable();
+  std::lock_guard<std::mutex> lock(table.mutex());
+  FSTDocumentKey *key = table.Find(encodedPath);
+  if (!key) {
+    key = [[FSTDocumentKey alloc] initWithPath:path encodedPath:encodedPath];
+    table.Insert(encodedPath, key);
+  }
+  return key;
 }
 
 + (instancetype)keyWithSegments:(NSArray<NSString *> *)segments {
@@ -43,11 +136,11 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 /** Designated initializer. */
-- (instancetype)initWithPath:(FSTResourcePath *)path {
-  FSTAssert([FSTDocumentKey isDocumentKey:path], @"invalid document key path: %@", path);
-
+- (instancetype)initWithPath:(FSTResourcePath *)path encodedPath:(std::string)encodedPath {
   if (self = [super init]) {
     _path = path;
+    _encodedPath = std::move(encodedPath);
+    _hash = std::hash<std::string>{}(_encodedPath);
   }
   return self;
 }
@@ -63,7 +156,7 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (NSUInteger)hash {
-  return self.path.hash;
+  return _hash;
 }
 
 - (NSString *)description {
@@ -76,11 +169,20 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (BOOL)isEqualToKey:(FSTDocumentKey *)other {
-  return FSTDocumentKeyComparator(self, other) == NSOrderedSame;
+  // A key that was deallocating while an equal one was interned can still be compared against,
+  // so fall back to the path when the pointers differ.
+  return self == other || (_hash == other->_hash && _encodedPath == other->_encodedPath);
 }
 
 - (NSComparisonResult)compare:(FSTDocumentKey *)other {
-  return FSTDocumentKeyComparator(self, other);
+  if (self == other) {
+    return NSOrderedSame;
+  }
+  return util::WrapCompare<absl::string_view>(_encodedPath, other->_encodedPath);
+}
+
+- (const std::string &)encodedPath {
+  return _encodedPath;
 }
 
 + (NSComparator)comparator {
@@ -97,7 +199,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 const NSComparator FSTDocumentKeyComparator =
     ^NSComparisonResult(FSTDocumentKey *key1, FSTDocumentKey *key2) {
-      return [key1.path compare:key2.path];
+      return [key1 compare:key2];
     };
 
 NSString *const kDocumentKeyPath = @"__name__";
@@ -30,6 +30,13 @@ typedef FSTImmutableSortedSet<FSTDocumentKey *> FSTDocumentKeySet;
 /** Returns a new set using the DocumentKeyComparator. */
 + (FSTDocumentKeySet *)keySet;
 
+/**
+ * Returns a new set using the DocumentKeyComparator, containing the given keys. Sorting happens
+ * once, so accumulating keys in an NSMutableSet and calling this is cheaper than adding them to an
+ * immutable set one at a time.
+ */
++ (FSTDocumentKeySet *)keySetWithKeys:(NSSet<FSTDocumentKey *> *)keys;
+
 @end
 
 NS_ASSUME_NONNULL_END
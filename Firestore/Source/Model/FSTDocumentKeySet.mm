@@ -26,6 +26,15 @@ NS_ASSUME_NONNULL_BEGIN
   return [FSTDocumentKeySet setWithComparator:FSTDocumentKeyComparator];
 }
 
++ (instancetype)keySetWithKeys:(NSSet<FSTDocumentKey *> *)keys {
+  NSMutableDictionary<FSTDocumentKey *, id> *entries =
+      [NSMutableDictionary dictionaryWithCapacity:keys.count];
+  for (FSTDocumentKey *key in keys) {
+    entries[key] = [NSNull null];
+  }
+  return [FSTDocumentKeySet setWithKeysFromDictionary:entries comparator:FSTDocumentKeyComparator];
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
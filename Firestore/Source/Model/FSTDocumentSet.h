@@ -48,19 +48,25 @@ NS_ASSUME_NONNULL_BEGIN
 
 /**
  * Returns the first document in the set according to its built in ordering, or nil if the set
- * is empty.
+ * is empty. This is O(log n) on the size of the set.
  */
 - (FSTDocument *_Nullable)firstDocument;
 
 /**
  * Returns the last document in the set according to its built in ordering, or nil if the set
- * is empty.
+ * is empty. This is O(log n) on the size of the set.
  */
 - (FSTDocument *_Nullable)lastDocument;
 
+/**
+ * Returns the document at the given position in the set's ordering, which must be less than
+ * count. This is O(log n) on the size of the set.
+ */
+- (FSTDocument *)documentAtIndex:(NSUInteger)index;
+
 /**
  * Returns the index of the document with the provided key in the document set. Returns NSNotFound
- * if the key is not present.
+ * if the key is not present. This is O(log n) on the size of the set.
  */
 - (NSUInteger)indexOfKey:(FSTDocumentKey *)key;
 
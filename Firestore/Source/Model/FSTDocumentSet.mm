@@ -18,25 +18,78 @@
 
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTDocumentKey.h"
-#import "Firestore/third_party/Immutable/FSTImmutableSortedSet.h"
+#import "Firestore/Source/Util/FSTAssert.h"
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+
+using firebase::firestore::immutable::SortedMap;
 
 NS_ASSUME_NONNULL_BEGIN
 
+namespace {
+
+/** Adapts the NSComparator of an FSTDocumentSet to the less-than comparison of a SortedMap. */
+struct DocumentComparator {
+  DocumentComparator() = default;
+
+  explicit DocumentComparator(NSComparator comparator) : comparator(comparator) {
+  }
+
+  bool operator()(FSTDocument *lhs, FSTDocument *rhs) const {
+    return comparator(lhs, rhs) == NSOrderedAscending;
+  }
+
+  NSComparator comparator;
+};
+
+/**
+ * The type of the main collection of documents in an FSTDocumentSet, used as a set: only the keys
+ * matter. Its tree nodes know the sizes of their subtrees, so positional lookups take O(log n).
+ */
+using DocumentMap = SortedMap<FSTDocument *, bool, DocumentComparator>;
+
+}  // namespace
+
 /**
  * The type of the index of the documents in an FSTDocumentSet.
  * @see FSTDocumentSet#index
  */
 typedef FSTImmutableSortedDictionary<FSTDocumentKey *, FSTDocument *> IndexType;
 
-/**
- * The type of the main collection of documents in an FSTDocumentSet.
- * @see FSTDocumentSet#sortedSet
- */
-typedef FSTImmutableSortedSet<FSTDocument *> SetType;
+/** Enumerates the documents of an FSTDocumentSet in order. */
+@interface FSTDocumentSetEnumerator : NSEnumerator<FSTDocument *>
+- (instancetype)initWithDocuments:(const DocumentMap &)documents;
+@end
+
+@implementation FSTDocumentSetEnumerator {
+  // A copy of the set's documents, which shares its storage and keeps it alive while enumerating.
+  DocumentMap _documents;
+  DocumentMap::const_iterator _current;
+}
+
+- (instancetype)initWithDocuments:(const DocumentMap &)documents {
+  if (self = [super init]) {
+    _documents = documents;
+    _current = _documents.begin();
+  }
+  return self;
+}
+
+- (nullable FSTDocument *)nextObject {
+  if (_current == _documents.end()) {
+    return nil;
+  }
+  FSTDocument *document = _current->first;
+  ++_current;
+  return document;
+}
+
+@end
 
 @interface FSTDocumentSet ()
 
-- (instancetype)initWithIndex:(IndexType *)index set:(SetType *)sortedSet NS_DESIGNATED_INITIALIZER;
+- (instancetype)initWithIndex:(IndexType *)index
+                    documents:(DocumentMap)documents NS_DESIGNATED_INITIALIZER;
 
 /**
  * An index of the documents in the FSTDocumentSet, indexed by document key. The index
@@ -44,29 +97,29 @@ typedef FSTImmutableSortedSet<FSTDocument *> SetType;
  * of documents by key.
  */
 @property(nonatomic, strong, readonly) IndexType *index;
-
-/**
- * The main collection of documents in the FSTDocumentSet. The documents are ordered by a
- * comparator supplied from a query. The SetType collection exists in addition to the index to
- * allow ordered traversal of the FSTDocumentSet.
- */
-@property(nonatomic, strong, readonly) SetType *sortedSet;
 @end
 
-@implementation FSTDocumentSet
+@implementation FSTDocumentSet {
+  /**
+   * The main collection of documents in the FSTDocumentSet. The documents are ordered by a
+   * comparator supplied from a query. It exists in addition to the index to allow ordered and
+   * positional traversal of the FSTDocumentSet.
+   */
+  DocumentMap _documents;
+}
 
 + (instancetype)documentSetWithComparator:(NSComparator)comparator {
   IndexType *index =
       [FSTImmutableSortedDictionary dictionaryWithComparator:FSTDocumentKeyComparator];
-  SetType *set = [FSTImmutableSortedSet setWithComparator:comparator];
-  return [[FSTDocumentSet alloc] initWithIndex:index set:set];
+  DocumentMap documents{DocumentComparator{comparator}};
+  return [[FSTDocumentSet alloc] initWithIndex:index documents:std::move(documents)];
 }
 
-- (instancetype)initWithIndex:(IndexType *)index set:(SetType *)sortedSet {
+- (instancetype)initWithIndex:(IndexType *)index documents:(DocumentMap)documents {
   self = [super init];
   if (self) {
     _index = index;
-    _sortedSet = sortedSet;
+    _documents = std::move(documents);
   }
   return self;
 }
@@ -84,31 +137,36 @@ typedef FSTImmutableSortedSet<FSTDocument *> SetType;
     return NO;
   }
 
-  NSEnumerator<FSTDocument *> *selfIter = [self.sortedSet objectEnumerator];
-  NSEnumerator<FSTDocument *> *otherIter = [otherSet.sortedSet objectEnumerator];
-
-  FSTDocument *selfDoc = [selfIter nextObject];
-  FSTDocument *otherDoc = [otherIter nextObject];
-  while (selfDoc) {
-    if (![selfDoc isEqual:otherDoc]) {
+  auto otherIter = otherSet->_documents.begin();
+  for (const auto &entry : _documents) {
+    if (![entry.first isEqual:otherIter->first]) {
       return NO;
     }
-    selfDoc = [selfIter nextObject];
-    otherDoc = [otherIter nextObject];
+    ++otherIter;
   }
   return YES;
 }
 
 - (NSUInteger)hash {
   NSUInteger hash = 0;
-  for (FSTDocument *doc in self.sortedSet.objectEnumerator) {
-    hash = 31 * hash + [doc hash];
+  for (const auto &entry : _documents) {
+    hash = 31 * hash + [entry.first hash];
   }
   return hash;
 }
 
 - (NSString *)description {
-  return [self.sortedSet description];
+  NSMutableString *str = [NSMutableString stringWithString:@"FSTDocumentSet ( "];
+  BOOL first = YES;
+  for (const auto &entry : _documents) {
+    if (!first) {
+      [str appendString:@", "];
+    }
+    first = NO;
+    [str appendFormat:@"%@", entry.first];
+  }
+  [str appendString:@" )"];
+  return str;
 }
 
 - (NSUInteger)count {
@@ -128,26 +186,36 @@ typedef FSTImmutableSortedSet<FSTDocument *> SetType;
 }
 
 - (FSTDocument *_Nullable)firstDocument {
-  return [self.sortedSet firstObject];
+  return _documents.empty() ? nil : _documents.at_index(0).first;
 }
 
 - (FSTDocument *_Nullable)lastDocument {
-  return [self.sortedSet lastObject];
+  return _documents.empty() ? nil : _documents.at_index(_documents.size() - 1).first;
+}
+
+- (FSTDocument *)documentAtIndex:(NSUInteger)index {
+  FSTAssert(index < _documents.size(), @"Index %lu out of bounds for document set of size %lu",
+            (unsigned long)index, (unsigned long)_documents.size());
+  return _documents.at_index(static_cast<DocumentMap::size_type>(index)).first;
 }
 
 - (NSUInteger)indexOfKey:(FSTDocumentKey *)key {
   FSTDocument *doc = [self.index objectForKey:key];
-  return doc ? [self.sortedSet indexOfObject:doc] : NSNotFound;
+  if (!doc) {
+    return NSNotFound;
+  }
+  DocumentMap::size_type index = _documents.find_index(doc);
+  return index == DocumentMap::npos ? NSNotFound : index;
 }
 
 - (NSEnumerator<FSTDocument *> *)documentEnumerator {
-  return [self.sortedSet objectEnumerator];
+  return [[FSTDocumentSetEnumerator alloc] initWithDocuments:_documents];
 }
 
 - (NSArray *)arrayValue {
   NSMutableArray<FSTDocument *> *result = [NSMutableArray arrayWithCapacity:self.count];
-  for (FSTDocument *doc in self.documentEnumerator) {
-    [result addObject:doc];
+  for (const auto &entry : _documents) {
+    [result addObject:entry.first];
   }
   return result;
 }
@@ -162,13 +230,13 @@ typedef FSTImmutableSortedSet<FSTDocument *> SetType;
     return self;
   }
 
-  // Remove any prior mapping of the document's key before adding, preventing sortedSet from
+  // Remove any prior mapping of the document's key before adding, preventing the documents from
   // accumulating values that aren't in the index.
   FSTDocumentSet *removed = [self documentSetByRemovingKey:document.key];
 
   IndexType *index = [removed.index dictionaryBySettingObject:document forKey:document.key];
-  SetType *set = [removed.sortedSet setByAddingObject:document];
-  return [[FSTDocumentSet alloc] initWithIndex:index set:set];
+  return [[FSTDocumentSet alloc] initWithIndex:index
+                                     documents:removed->_documents.insert(document, true)];
 }
 
 - (instancetype)documentSetByRemovingKey:(FSTDocumentKey *)key {
@@ -178,8 +246,7 @@ typedef FSTImmutableSortedSet<FSTDocument *> SetType;
   }
 
   IndexType *index = [self.index dictionaryByRemovingObjectForKey:key];
-  SetType *set = [self.sortedSet setByRemovingObject:doc];
-  return [[FSTDocumentSet alloc] initWithIndex:index set:set];
+  return [[FSTDocumentSet alloc] initWithIndex:index documents:_documents.erase(doc)];
 }
 
 @end
@@ -16,25 +16,38 @@
 
 #import <Foundation/Foundation.h>
 
-#import "Firestore/third_party/Immutable/FSTImmutableSortedDictionary.h"
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 
 @class FSTDocumentKey;
-@class FSTSnapshotVersion;
 
 NS_ASSUME_NONNULL_BEGIN
 
-/** A map of key to version number. */
-typedef FSTImmutableSortedDictionary<FSTDocumentKey *, FSTSnapshotVersion *>
-    FSTDocumentVersionDictionary;
-
 /**
- * Extension to FSTImmutableSortedDictionary that allows natural construction of
- * FSTDocumentVersionDictionary.
+ * A map of key to version, stored as one array of entries sorted by key. A mutation batch only
+ * touches a handful of documents, so this takes a single allocation, where an
+ * FSTImmutableSortedDictionary of boxed FSTSnapshotVersions needs several objects per entry.
  */
-@interface FSTImmutableSortedDictionary (FSTDocumentVersionDictionary)
+class FSTDocumentVersionDictionary {
+ public:
+  using value_type = std::pair<FSTDocumentKey *, firebase::firestore::model::SnapshotVersion>;
+
+  FSTDocumentVersionDictionary() = default;
+
+  /** Creates a dictionary of the given entries. If a key appears more than once, the last wins. */
+  explicit FSTDocumentVersionDictionary(std::vector<value_type> entries);
+
+  /** Returns the version of the given key, or nullptr if the dictionary doesn't contain it. */
+  const firebase::firestore::model::SnapshotVersion *_Nullable find(FSTDocumentKey *key) const;
 
-+ (instancetype)documentVersionDictionary;
+  size_t size() const {
+    return entries_.size();
+  }
 
-@end
+ private:
+  std::vector<value_type> entries_;
+};
 
 NS_ASSUME_NONNULL_END
@@ -16,22 +16,49 @@
 
 #import "Firestore/Source/Model/FSTDocumentVersionDictionary.h"
 
-#import "Firestore/Source/Core/FSTSnapshotVersion.h"
+#include <algorithm>
+
 #import "Firestore/Source/Model/FSTDocumentKey.h"
 
+namespace model = firebase::firestore::model;
+
 NS_ASSUME_NONNULL_BEGIN
 
-@implementation FSTImmutableSortedDictionary (FSTDocumentVersionDictionary)
+namespace {
 
-+ (instancetype)documentVersionDictionary {
-  static FSTDocumentVersionDictionary *singleton;
-  static dispatch_once_t onceToken;
-  dispatch_once(&onceToken, ^{
-    singleton = [FSTDocumentVersionDictionary dictionaryWithComparator:FSTDocumentKeyComparator];
-  });
-  return singleton;
+bool KeyLess(const FSTDocumentVersionDictionary::value_type &lhs,
+             const FSTDocumentVersionDictionary::value_type &rhs) {
+  return FSTDocumentKeyComparator(lhs.first, rhs.first) == NSOrderedAscending;
 }
 
-@end
+}  // namespace
+
+FSTDocumentVersionDictionary::FSTDocumentVersionDictionary(std::vector<value_type> entries)
+    : entries_(std::move(entries)) {
+  std::stable_sort(entries_.begin(), entries_.end(), KeyLess);
+
+  // Keep only the last of each run of equal keys.
+  auto out = entries_.begin();
+  for (auto iter = entries_.begin(); iter != entries_.end(); ++iter) {
+    auto next = iter + 1;
+    if (next == entries_.end() || KeyLess(*iter, *next)) {
+      if (out != iter) {
+        *out = std::move(*iter);
+      }
+      ++out;
+    }
+  }
+  entries_.erase(out, entries_.end());
+}
+
+const model::SnapshotVersion *_Nullable FSTDocumentVersionDictionary::find(
+    FSTDocumentKey *key) const {
+  value_type probe{key, model::SnapshotVersion::None()};
+  auto found = std::lower_bound(entries_.begin(), entries_.end(), probe, KeyLess);
+  if (found == entries_.end() || KeyLess(probe, *found)) {
+    return nullptr;
+  }
+  return &found->second;
+}
 
 NS_ASSUME_NONNULL_END
@@ -16,6 +16,8 @@
 
 #import <Foundation/Foundation.h>
 
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+
 #import "Firestore/third_party/Immutable/FSTImmutableSortedDictionary.h"
 
 @class FSTDatabaseID;
@@ -110,6 +112,16 @@ typedef NS_ENUM(NSInteger, FSTServerTimestampBehavior) {
 /** Compares against another FSTFieldValue. */
 - (NSComparisonResult)compare:(FSTFieldValue *)other;
 
+/**
+ * Converts this value to its C++ representation. Returns NO, leaving result in an unspecified
+ * state, if the value contains something model::FieldValue can't represent yet: a reference, or a
+ * server timestamp whose previous value isn't a timestamp.
+ */
+- (BOOL)convertToModelValue:(firebase::firestore::model::FieldValue *)result;
+
+/** Creates the FSTFieldValue equivalent to the given C++ value. */
++ (FSTFieldValue *)fieldValueWithModelValue:(const firebase::firestore::model::FieldValue &)value;
+
 @end
 
 /**
@@ -253,6 +265,22 @@ typedef NS_ENUM(NSInteger, FSTServerTimestampBehavior) {
  * path does not exist within this object's structure, no change is performed.
  */
 - (FSTObjectValue *)objectByDeletingPath:(FSTFieldPath *)fieldPath;
+
+/**
+ * Returns a new object where each of the given paths is set to the value at the same index in
+ * `values`. Equivalent to calling objectBySettingValue:forPath: for each path in turn, except that
+ * the object tree is walked once and only the objects along the given paths are copied.
+ */
+- (FSTObjectValue *)objectBySettingValues:(NSArray<FSTFieldValue *> *)values
+                                 forPaths:(NSArray<FSTFieldPath *> *)fieldPaths;
+
+/**
+ * Returns a new object where each of the given paths is set to the value at that path in `source`,
+ * or deleted if `source` has no value there. Like objectBySettingValues:forPaths:, this rebuilds
+ * each touched object once, however many of the paths pass through it.
+ */
+- (FSTObjectValue *)objectByCopyingPaths:(NSArray<FSTFieldPath *> *)fieldPaths
+                              fromObject:(FSTObjectValue *)source;
 @end
 
 /**
@@ -16,6 +16,16 @@
 
 #import "Firestore/Source/Model/FSTFieldValue.h"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/geo_point.h"
+#include "Firestore/core/src/firebase/firestore/model/timestamp.h"
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 
@@ -28,7 +38,10 @@
 #import "Firestore/Source/Util/FSTAssert.h"
 #import "Firestore/Source/Util/FSTClasses.h"
 
-using firebase::firestore::util::Comparator;
+using firebase::firestore::GeoPoint;
+using firebase::firestore::model::FieldValue;
+using firebase::firestore::model::ServerTimestamp;
+using firebase::firestore::model::Timestamp;
 using firebase::firestore::util::CompareMixedNumber;
 using firebase::firestore::util::DoubleBitwiseEquals;
 using firebase::firestore::util::DoubleBitwiseHash;
@@ -38,6 +51,14 @@ using firebase::firestore::util::WrapCompare;
 
 NS_ASSUME_NONNULL_BEGIN
 
+static Timestamp MakeTimestamp(FSTTimestamp *timestamp) {
+  return Timestamp{timestamp.seconds, timestamp.nanos};
+}
+
+static FSTTimestamp *MakeFSTTimestamp(const Timestamp &timestamp) {
+  return [[FSTTimestamp alloc] initWithSeconds:timestamp.seconds() nanos:timestamp.nanos()];
+}
+
 #pragma mark - FSTFieldValueOptions
 
 @implementation FSTFieldValueOptions
@@ -117,6 +138,73 @@ NS_ASSUME_NONNULL_BEGIN
   }
 }
 
+- (BOOL)convertToModelValue:(FieldValue *)result {
+  @throw FSTAbstractMethodException();  // NOLINT
+}
+
++ (FSTFieldValue *)fieldValueWithModelValue:(const FieldValue &)value {
+  switch (value.type()) {
+    case FieldValue::Type::Null:
+      return [FSTNullValue nullValue];
+    case FieldValue::Type::Boolean:
+      return [FSTBooleanValue booleanValue:value.boolean_value()];
+    case FieldValue::Type::Long:
+      return [FSTIntegerValue integerValue:value.integer_value()];
+    case FieldValue::Type::Double:
+      return [FSTDoubleValue doubleValue:value.double_value()];
+    case FieldValue::Type::Timestamp:
+      return [FSTTimestampValue timestampValue:MakeFSTTimestamp(value.timestamp_value())];
+    case FieldValue::Type::ServerTimestamp: {
+      const ServerTimestamp &serverTimestamp = value.server_timestamp_value();
+      FSTFieldValue *previousValue =
+          serverTimestamp.has_previous_value_
+              ? [FSTTimestampValue timestampValue:MakeFSTTimestamp(serverTimestamp.previous_value)]
+              : nil;
+      return [FSTServerTimestampValue
+          serverTimestampValueWithLocalWriteTime:MakeFSTTimestamp(serverTimestamp.local_write_time)
+                                   previousValue:previousValue];
+    }
+    case FieldValue::Type::String: {
+      absl::string_view string = value.string_value();
+      return [FSTStringValue stringValue:[[NSString alloc] initWithBytes:string.data()
+                                                                  length:string.size()
+                                                                encoding:NSUTF8StringEncoding]];
+    }
+    case FieldValue::Type::Blob:
+      return [FSTBlobValue blobValue:[NSData dataWithBytes:value.blob_data()
+                                                    length:value.blob_size()]];
+    case FieldValue::Type::GeoPoint: {
+      const GeoPoint &geoPoint = value.geo_point_value();
+      FIRGeoPoint *point =
+          [[FIRGeoPoint alloc] initWithLatitude:geoPoint.latitude() longitude:geoPoint.longitude()];
+      return [FSTGeoPointValue geoPointValue:point];
+    }
+    case FieldValue::Type::Array: {
+      const std::vector<FieldValue> &elements = value.array_value();
+      NSMutableArray<FSTFieldValue *> *array = [NSMutableArray arrayWithCapacity:elements.size()];
+      for (const FieldValue &element : elements) {
+        [array addObject:[FSTFieldValue fieldValueWithModelValue:element]];
+      }
+      return [[FSTArrayValue alloc] initWithValueNoCopy:array];
+    }
+    case FieldValue::Type::Object: {
+      const FieldValue::Map &fields = value.object_value();
+      NSMutableDictionary<NSString *, FSTFieldValue *> *dictionary =
+          [NSMutableDictionary dictionaryWithCapacity:fields.size()];
+      for (const auto &field : fields) {
+        NSString *name = [[NSString alloc] initWithBytes:field.first.data()
+                                                  length:field.first.size()
+                                                encoding:NSUTF8StringEncoding];
+        dictionary[name] = [FSTFieldValue fieldValueWithModelValue:field.second];
+      }
+      return [[FSTObjectValue alloc] initWithDictionary:dictionary];
+    }
+    case FieldValue::Type::Reference:
+      break;
+  }
+  FSTFail(@"Unexpected C++ field value type: %d", static_cast<int>(value.type()));
+}
+
 @end
 
 #pragma mark - FSTNullValue
@@ -157,6 +245,11 @@ NS_ASSUME_NONNULL_BEGIN
   }
 }
 
+- (BOOL)convertToModelValue:(FieldValue *)result {
+  *result = FieldValue::NullValue();
+  return YES;
+}
+
 @end
 
 #pragma mark - FSTBooleanValue
@@ -224,6 +317,11 @@ NS_ASSUME_NONNULL_BEGIN
   }
 }
 
+- (BOOL)convertToModelValue:(FieldValue *)result {
+  *result = FieldValue::BooleanValue(self.internalValue);
+  return YES;
+}
+
 @end
 
 #pragma mark - FSTNumberValue
@@ -301,6 +399,11 @@ NS_ASSUME_NONNULL_BEGIN
 
 // NOTE: compare: is implemented in NumberValue.
 
+- (BOOL)convertToModelValue:(FieldValue *)result {
+  *result = FieldValue::IntegerValue(self.internalValue);
+  return YES;
+}
+
 @end
 
 #pragma mark - FSTDoubleValue
@@ -356,21 +459,15 @@ NS_ASSUME_NONNULL_BEGIN
 
 // NOTE: compare: is implemented in NumberValue.
 
+- (BOOL)convertToModelValue:(FieldValue *)result {
+  *result = FieldValue::DoubleValue(self.internalValue);
+  return YES;
+}
+
 @end
 
 #pragma mark - FSTStringValue
 
-/**
- * Specialization of Comparator for NSStrings.
- */
-template <>
-struct Comparator<NSString *> {
-  bool operator()(NSString *left, NSString *right) const {
-    Comparator<absl::string_view> lessThan;
-    return lessThan(MakeStringView(left), MakeStringView(right));
-  }
-};
-
 @interface FSTStringValue ()
 @property(nonatomic, copy, readonly) NSString *internalValue;
 @end
@@ -415,6 +512,11 @@ struct Comparator<NSString *> {
   }
 }
 
+- (BOOL)convertToModelValue:(FieldValue *)result {
+  *result = FieldValue::StringValue(MakeStringView(self.internalValue));
+  return YES;
+}
+
 @end
 
 #pragma mark - FSTTimestampValue
@@ -466,6 +568,11 @@ struct Comparator<NSString *> {
   }
 }
 
+- (BOOL)convertToModelValue:(FieldValue *)result {
+  *result = FieldValue::TimestampValue(MakeTimestamp(self.internalValue));
+  return YES;
+}
+
 @end
 
 #pragma mark - FSTServerTimestampValue
@@ -529,6 +636,21 @@ struct Comparator<NSString *> {
   }
 }
 
+- (BOOL)convertToModelValue:(FieldValue *)result {
+  Timestamp localWriteTime = MakeTimestamp(self.localWriteTime);
+  if (!self.previousValue) {
+    *result = FieldValue::ServerTimestampValue(localWriteTime);
+    return YES;
+  }
+  // model::ServerTimestamp can only remember a previous Timestamp.
+  if (![self.previousValue isKindOfClass:[FSTTimestampValue class]]) {
+    return NO;
+  }
+  FSTTimestamp *previousValue = ((FSTTimestampValue *)self.previousValue).internalValue;
+  *result = FieldValue::ServerTimestampValue(localWriteTime, MakeTimestamp(previousValue));
+  return YES;
+}
+
 @end
 
 #pragma mark - FSTGeoPointValue
@@ -576,6 +698,12 @@ struct Comparator<NSString *> {
   }
 }
 
+- (BOOL)convertToModelValue:(FieldValue *)result {
+  *result = FieldValue::GeoPointValue(
+      GeoPoint{self.internalValue.latitude, self.internalValue.longitude});
+  return YES;
+}
+
 @end
 
 #pragma mark - FSTBlobValue
@@ -640,6 +768,12 @@ static NSComparisonResult CompareBytes(NSData *left, NSData *right) {
   }
 }
 
+- (BOOL)convertToModelValue:(FieldValue *)result {
+  *result = FieldValue::BlobValue(static_cast<const uint8_t *>(self.internalValue.bytes),
+                                  self.internalValue.length);
+  return YES;
+}
+
 @end
 
 #pragma mark - FSTReferenceValue
@@ -700,10 +834,51 @@ static NSComparisonResult CompareBytes(NSData *left, NSData *right) {
   }
 }
 
+- (BOOL)convertToModelValue:(FieldValue *)result {
+  // model::FieldValue has no storage for references yet.
+  return NO;
+}
+
 @end
 
 #pragma mark - FSTObjectValue
 
+namespace {
+
+/** A pending write of a value to a path within an FSTObjectValue, or a delete if value is nil. */
+struct FieldUpdate {
+  FSTFieldPath *path;
+  FSTFieldValue *_Nullable value;
+};
+
+struct FieldPathHash {
+  size_t operator()(FSTFieldPath *path) const {
+    return [path hash];
+  }
+};
+
+struct FieldPathEqual {
+  bool operator()(FSTFieldPath *lhs, FSTFieldPath *rhs) const {
+    return [lhs isEqual:rhs];
+  }
+};
+
+/** Maps each nested path within an FSTObjectValue, of two or more segments, to its value. */
+using FieldIndex =
+    std::unordered_map<FSTFieldPath *, FSTFieldValue *, FieldPathHash, FieldPathEqual>;
+
+/**
+ * The number of lookups of nested paths after which an FSTObjectValue builds its FieldIndex. Most
+ * objects are only looked into a few times, but documents evaluated against many queries and
+ * filters look up the same nested fields over and over.
+ */
+const int kFieldIndexLookupThreshold = 8;
+
+/** Objects with more nested fields than this are never indexed, to bound the index's memory. */
+const size_t kMaxFieldIndexSize = 1000;
+
+}  // namespace
+
 static const NSComparator StringComparator = ^NSComparisonResult(NSString *left, NSString *right) {
   return WrapCompare(left, right);
 };
@@ -713,7 +888,16 @@ static const NSComparator StringComparator = ^NSComparisonResult(NSString *left,
     FSTImmutableSortedDictionary<NSString *, FSTFieldValue *> *internalValue;
 @end
 
-@implementation FSTObjectValue
+@implementation FSTObjectValue {
+  /** The number of lookups of nested paths so far, which decides when to build _fieldIndex. */
+  std::atomic<int> _nestedLookups;
+
+  /**
+   * The index of this object's nested fields, built after kFieldIndexLookupThreshold lookups of
+   * nested paths. Objects are read from several queues, so it's accessed with std::atomic_load.
+   */
+  std::shared_ptr<const FieldIndex> _fieldIndex;
+}
 
 + (instancetype)objectValue {
   static FSTObjectValue *sharedEmptyInstance = nil;
@@ -780,7 +964,8 @@ static const NSComparator StringComparator = ^NSComparisonResult(NSString *left,
     NSString *key1 = [enumerator1 nextObject];
     NSString *key2 = [enumerator2 nextObject];
     while (key1 && key2) {
-      NSComparisonResult keyCompare = [key1 compare:key2];
+      // Keys are compared by their UTF-8 bytes, matching the dictionary's StringComparator.
+      NSComparisonResult keyCompare = WrapCompare(key1, key2);
       if (keyCompare != NSOrderedSame) {
         return keyCompare;
       }
@@ -799,6 +984,18 @@ static const NSComparator StringComparator = ^NSComparisonResult(NSString *left,
 }
 
 - (nullable FSTFieldValue *)valueForPath:(FSTFieldPath *)fieldPath {
+  if (fieldPath.length > 1) {
+    std::shared_ptr<const FieldIndex> index = std::atomic_load(&_fieldIndex);
+    if (!index && ++_nestedLookups == kFieldIndexLookupThreshold) {
+      index = [self buildFieldIndex];
+      std::atomic_store(&_fieldIndex, index);
+    }
+    if (index) {
+      auto found = index->find(fieldPath);
+      return found != index->end() ? found->second : nil;
+    }
+  }
+
   FSTFieldValue *value = self;
   for (int i = 0, max = fieldPath.length; value && i < max; i++) {
     if (![value isMemberOfClass:[FSTObjectValue class]]) {
@@ -812,6 +1009,50 @@ static const NSComparator StringComparator = ^NSComparisonResult(NSString *left,
   return value;
 }
 
+/**
+ * Returns an index of all the nested fields of this object, or nullptr if there are more than
+ * kMaxFieldIndexSize of them.
+ */
+- (std::shared_ptr<const FieldIndex>)buildFieldIndex {
+  auto index = std::make_shared<FieldIndex>();
+  __block BOOL complete = YES;
+  [self.internalValue
+      enumerateKeysAndObjectsUsingBlock:^(NSString *key, FSTFieldValue *value, BOOL *stop) {
+        if ([value isMemberOfClass:[FSTObjectValue class]]) {
+          FSTFieldPath *path = [FSTFieldPath pathWithSegments:@[ key ]];
+          if (![(FSTObjectValue *)value addFieldsToIndex:index.get() underPath:path]) {
+            complete = NO;
+            *stop = YES;
+          }
+        }
+      }];
+  return complete ? index : nullptr;
+}
+
+/**
+ * Adds the fields of this object, nested under the given path, to the index. Returns NO if the
+ * index would exceed kMaxFieldIndexSize entries.
+ */
+- (BOOL)addFieldsToIndex:(FieldIndex *)index underPath:(FSTFieldPath *)parentPath {
+  __block BOOL complete = YES;
+  [self.internalValue
+      enumerateKeysAndObjectsUsingBlock:^(NSString *key, FSTFieldValue *value, BOOL *stop) {
+        if (index->size() >= kMaxFieldIndexSize) {
+          complete = NO;
+          *stop = YES;
+          return;
+        }
+        FSTFieldPath *path = [parentPath pathByAppendingSegment:key];
+        (*index)[path] = value;
+        if ([value isMemberOfClass:[FSTObjectValue class]] &&
+            ![(FSTObjectValue *)value addFieldsToIndex:index underPath:path]) {
+          complete = NO;
+          *stop = YES;
+        }
+      }];
+  return complete;
+}
+
 - (FSTObjectValue *)objectBySettingValue:(FSTFieldValue *)value forPath:(FSTFieldPath *)fieldPath {
   FSTAssert([fieldPath length] > 0, @"Cannot set value with an empty path");
 
@@ -856,11 +1097,124 @@ static const NSComparator StringComparator = ^NSComparisonResult(NSString *left,
   }
 }
 
+- (FSTObjectValue *)objectBySettingValues:(NSArray<FSTFieldValue *> *)values
+                                 forPaths:(NSArray<FSTFieldPath *> *)fieldPaths {
+  FSTAssert(values.count == fieldPaths.count, @"Values and paths length mismatch.");
+  std::vector<FieldUpdate> updates;
+  updates.reserve(fieldPaths.count);
+  for (NSUInteger i = 0; i < fieldPaths.count; i++) {
+    updates.push_back(FieldUpdate{fieldPaths[i], values[i]});
+  }
+  return [self objectByApplyingUpdates:updates];
+}
+
+- (FSTObjectValue *)objectByCopyingPaths:(NSArray<FSTFieldPath *> *)fieldPaths
+                              fromObject:(FSTObjectValue *)source {
+  std::vector<FieldUpdate> updates;
+  updates.reserve(fieldPaths.count);
+  for (FSTFieldPath *fieldPath in fieldPaths) {
+    updates.push_back(FieldUpdate{fieldPath, [source valueForPath:fieldPath]});
+  }
+  return [self objectByApplyingUpdates:updates];
+}
+
+- (FSTObjectValue *)objectByApplyingUpdates:(const std::vector<FieldUpdate> &)updates {
+  std::vector<const FieldUpdate *> pending;
+  pending.reserve(updates.size());
+  for (const FieldUpdate &update : updates) {
+    FSTAssert(update.path.length > 0, @"Cannot update an empty path");
+    pending.push_back(&update);
+  }
+  return [self objectByApplyingUpdates:std::move(pending) depth:0];
+}
+
+/**
+ * Applies the given updates, in order, to this object, where the first `depth` segments of each
+ * update's path lead to this object. Updates are grouped by their segment at `depth` so that each
+ * child is rebuilt once, with a single recursive call for all the updates below it.
+ */
+- (FSTObjectValue *)objectByApplyingUpdates:(std::vector<const FieldUpdate *>)updates
+                                      depth:(int)depth {
+  // A stable sort keeps the updates to each child in their original order.
+  std::stable_sort(updates.begin(), updates.end(),
+                   [depth](const FieldUpdate *lhs, const FieldUpdate *rhs) {
+                     return WrapCompare<NSString *>(lhs->path[depth], rhs->path[depth]) ==
+                            NSOrderedAscending;
+                   });
+
+  FSTImmutableSortedDictionary<NSString *, FSTFieldValue *> *result = _internalValue;
+  auto groupBegin = updates.begin();
+  while (groupBegin != updates.end()) {
+    NSString *childName = (*groupBegin)->path[depth];
+    auto groupEnd = std::find_if(groupBegin, updates.end(), [&](const FieldUpdate *update) {
+      return ![update->path[depth] isEqualToString:childName];
+    });
+
+    // An update that replaces (or deletes) the child outright hides all the updates before it.
+    FSTFieldValue *existing = _internalValue[childName];
+    FSTFieldValue *child = existing;
+    auto nestedBegin = groupBegin;
+    for (auto it = groupBegin; it != groupEnd; ++it) {
+      if ((*it)->path.length == depth + 1) {
+        child = (*it)->value;
+        nestedBegin = it + 1;
+      }
+    }
+
+    if (![child isKindOfClass:[FSTObjectValue class]]) {
+      // Deleting below a missing or primitive value does nothing, while setting below one first
+      // replaces it with an empty object.
+      while (nestedBegin != groupEnd && !(*nestedBegin)->value) {
+        ++nestedBegin;
+      }
+      if (nestedBegin != groupEnd) {
+        child = [FSTObjectValue objectValue];
+      }
+    }
+    if (nestedBegin != groupEnd) {
+      child = [(FSTObjectValue *)child
+          objectByApplyingUpdates:std::vector<const FieldUpdate *>(nestedBegin, groupEnd)
+                            depth:depth + 1];
+    }
+
+    if (child != existing) {
+      result = child ? [result dictionaryBySettingObject:child forKey:childName]
+                     : [result dictionaryByRemovingObjectForKey:childName];
+    }
+    groupBegin = groupEnd;
+  }
+
+  if (result == _internalValue) {
+    return self;
+  }
+  return [[FSTObjectValue alloc] initWithImmutableDictionary:result];
+}
+
 - (FSTObjectValue *)objectBySettingValue:(FSTFieldValue *)value forField:(NSString *)field {
   return [[FSTObjectValue alloc]
       initWithImmutableDictionary:[_internalValue dictionaryBySettingObject:value forKey:field]];
 }
 
+- (BOOL)convertToModelValue:(FieldValue *)result {
+  FieldValue::Map::Builder builder;
+  __block BOOL converted = YES;
+  [self.internalValue
+      enumerateKeysAndObjectsUsingBlock:^(NSString *key, FSTFieldValue *obj, BOOL *stop) {
+        FieldValue child;
+        if (![obj convertToModelValue:&child]) {
+          converted = NO;
+          *stop = YES;
+          return;
+        }
+        builder.insert(std::string{MakeStringView(key)}, child);
+      }];
+  if (!converted) {
+    return NO;
+  }
+  *result = FieldValue::ObjectValue(builder.Build());
+  return YES;
+}
+
 @end
 
 @interface FSTArrayValue ()
@@ -926,6 +1280,20 @@ static const NSComparator StringComparator = ^NSComparisonResult(NSString *left,
   }
 }
 
+- (BOOL)convertToModelValue:(FieldValue *)result {
+  std::vector<FieldValue> elements;
+  elements.reserve(self.internalValue.count);
+  for (FSTFieldValue *element in self.internalValue) {
+    FieldValue child;
+    if (![element convertToModelValue:&child]) {
+      return NO;
+    }
+    elements.push_back(std::move(child));
+  }
+  *result = FieldValue::ArrayValue(std::move(elements));
+  return YES;
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class FSTFieldValue;
+@class FSTMaybeDocument;
+@class FSTMutationBatch;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** The approximate memory held by some part of the client, as reported for diagnostics. */
+typedef struct {
+  /** The number of objects held, e.g. documents or references. */
+  int64_t objects;
+
+  /** The approximate number of bytes the objects hold. */
+  int64_t bytes;
+} FSTMemoryUsage;
+
+/** Returns the sum of two memory usages. */
+FSTMemoryUsage FSTMemoryUsageAdd(FSTMemoryUsage lhs, FSTMemoryUsage rhs);
+
+/**
+ * Estimates the bytes held by a field value, counting the contents of strings and blobs and a
+ * fixed overhead per value. Nested values are visited, so this takes time linear in their number.
+ */
+int64_t FSTApproximateFieldValueBytes(FSTFieldValue *value);
+
+/** Estimates the bytes held by a document with its key and data, or by a deleted document. */
+int64_t FSTApproximateDocumentBytes(FSTMaybeDocument *document);
+
+/** Estimates the bytes held by a batch of mutations with their keys and values. */
+int64_t FSTApproximateMutationBatchBytes(FSTMutationBatch *batch);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "Firestore/Source/Model/FSTMemoryUsage.h"
+
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTDocumentKey.h"
+#import "Firestore/Source/Model/FSTFieldValue.h"
+#import "Firestore/Source/Model/FSTMutation.h"
+#import "Firestore/Source/Model/FSTMutationBatch.h"
+#import "Firestore/Source/Model/FSTPath.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * The bytes assumed for each object, covering its header, its fields and the node or slot holding
+ * it in its container. Only the order of magnitude matters for diagnostics.
+ */
+static const int64_t kObjectOverheadBytes = 32;
+
+FSTMemoryUsage FSTMemoryUsageAdd(FSTMemoryUsage lhs, FSTMemoryUsage rhs) {
+  return FSTMemoryUsage{lhs.objects + rhs.objects, lhs.bytes + rhs.bytes};
+}
+
+int64_t FSTApproximateFieldValueBytes(FSTFieldValue *value) {
+  int64_t bytes = kObjectOverheadBytes;
+  if ([value isKindOfClass:[FSTStringValue class]]) {
+    bytes += ((FSTStringValue *)value).value.length;
+  } else if ([value isKindOfClass:[FSTBlobValue class]]) {
+    bytes += ((FSTBlobValue *)value).value.length;
+  } else if ([value isKindOfClass:[FSTObjectValue class]]) {
+    [((FSTObjectValue *)value).internalValue
+        enumerateKeysAndObjectsUsingBlock:^(NSString *key, FSTFieldValue *child, BOOL *stop) {
+          bytes += key.length + FSTApproximateFieldValueBytes(child);
+        }];
+  } else if ([value isKindOfClass:[FSTArrayValue class]]) {
+    for (FSTFieldValue *child in ((FSTArrayValue *)value).internalValue) {
+      bytes += FSTApproximateFieldValueBytes(child);
+    }
+  }
+  return bytes;
+}
+
+/** Estimates the bytes held by a document key, whose path segments are strings. */
+static int64_t FSTApproximateKeyBytes(FSTDocumentKey *key) {
+  int64_t bytes = kObjectOverheadBytes;
+  FSTResourcePath *path = key.path;
+  for (int i = 0; i < path.length; i++) {
+    bytes += kObjectOverheadBytes + [path segmentAtIndex:i].length;
+  }
+  return bytes;
+}
+
+int64_t FSTApproximateDocumentBytes(FSTMaybeDocument *document) {
+  int64_t bytes = kObjectOverheadBytes + FSTApproximateKeyBytes(document.key);
+  if ([document isKindOfClass:[FSTDocument class]]) {
+    bytes += FSTApproximateFieldValueBytes(((FSTDocument *)document).data);
+  }
+  return bytes;
+}
+
+int64_t FSTApproximateMutationBatchBytes(FSTMutationBatch *batch) {
+  int64_t bytes = kObjectOverheadBytes;
+  for (FSTMutation *mutation in batch.mutations) {
+    bytes += kObjectOverheadBytes + FSTApproximateKeyBytes(mutation.key);
+    if ([mutation isKindOfClass:[FSTSetMutation class]]) {
+      bytes += FSTApproximateFieldValueBytes(((FSTSetMutation *)mutation).value);
+    } else if ([mutation isKindOfClass:[FSTPatchMutation class]]) {
+      bytes += FSTApproximateFieldValueBytes(((FSTPatchMutation *)mutation).value);
+    }
+  }
+  return bytes;
+}
+
+NS_ASSUME_NONNULL_END
@@ -216,6 +216,34 @@ typedef NS_ENUM(NSUInteger, FSTPreconditionExists) {
 /** The precondition for this mutation. */
 @property(nonatomic, strong, readonly) FSTPrecondition *precondition;
 
+/**
+ * The fields this mutation can change, or nil if it can change the whole document (as sets and
+ * deletes do).
+ */
+- (nullable NSArray<FSTFieldPath *> *)affectedFieldPaths;
+
+/**
+ * Returns YES if applying this mutation could change the value at `fieldPath`, i.e. if it can
+ * change the whole document or one of its affected fields is `fieldPath`, a parent of it, or a
+ * child of it.
+ */
+- (BOOL)mayAffectFieldPath:(FSTFieldPath *)fieldPath;
+
+/**
+ * Returns a single mutation with the same effect as applying this mutation followed by `mutation`,
+ * which must be for the same document, or nil if there is none. Mutations only squash when the
+ * backend would accept or reject the squashed mutation exactly when it would accept `mutation`
+ * after this one, i.e. when this mutation can't fail on its own:
+ *
+ * - A set or delete without a precondition replaces any mutation without a precondition.
+ * - A patch applies on top of a set without a precondition, giving a set.
+ * - Two patches combine their field masks if the first has no precondition, or if both require
+ *   the document to exist.
+ *
+ * Transforms never squash, since their results depend on when the backend applies them.
+ */
+- (nullable FSTMutation *)mutationBySquashingMutation:(FSTMutation *)mutation;
+
 @end
 
 #pragma mark - FSTSetMutation
@@ -250,6 +250,77 @@ NS_ASSUME_NONNULL_BEGIN
       [self applyTo:maybeDoc baseDocument:baseDoc localWriteTime:localWriteTime mutationResult:nil];
 }
 
+- (nullable NSArray<FSTFieldPath *> *)affectedFieldPaths {
+  return nil;
+}
+
+- (BOOL)mayAffectFieldPath:(FSTFieldPath *)fieldPath {
+  NSArray<FSTFieldPath *> *_Nullable affectedFieldPaths = [self affectedFieldPaths];
+  if (!affectedFieldPaths) {
+    return YES;
+  }
+  for (FSTFieldPath *affected in affectedFieldPaths) {
+    if ([affected isPrefixOfPath:fieldPath] || [fieldPath isPrefixOfPath:affected]) {
+      return YES;
+    }
+  }
+  return NO;
+}
+
+- (nullable FSTMutation *)mutationBySquashingMutation:(FSTMutation *)mutation {
+  FSTAssert([mutation.key isEqual:self.key], @"Can only squash mutations of the same document");
+  Class selfClass = [self class];
+  Class mutationClass = [mutation class];
+  if (selfClass == [FSTTransformMutation class] || mutationClass == [FSTTransformMutation class]) {
+    return nil;
+  }
+
+  if (mutationClass == [FSTSetMutation class] || mutationClass == [FSTDeleteMutation class]) {
+    // The later mutation replaces the document outright.
+    return self.precondition.isNone && mutation.precondition.isNone ? mutation : nil;
+  }
+
+  FSTAssert(mutationClass == [FSTPatchMutation class], @"Unknown mutation type %@",
+            NSStringFromClass(mutationClass));
+  FSTPatchMutation *patch = (FSTPatchMutation *)mutation;
+  NSArray<FSTFieldPath *> *patchedFields = patch.fieldMask.fields;
+  if (selfClass == [FSTSetMutation class]) {
+    if (!self.precondition.isNone) {
+      return nil;
+    }
+    // The set creates the document, so the patch's precondition is sure to hold.
+    FSTSetMutation *set = (FSTSetMutation *)self;
+    return [[FSTSetMutation alloc]
+         initWithKey:self.key
+               value:[set.value objectByCopyingPaths:patchedFields fromObject:patch.value]
+        precondition:self.precondition];
+
+  } else if (selfClass == [FSTPatchMutation class]) {
+    // If the first patch can fail, the second must fail along with it. (An update time
+    // precondition, on the other hand, stops holding once the first patch is applied.)
+    FSTPrecondition *exists = [FSTPrecondition preconditionWithExists:YES];
+    if (!self.precondition.isNone &&
+        !([self.precondition isEqual:exists] && [patch.precondition isEqual:exists])) {
+      return nil;
+    }
+    FSTPatchMutation *earlier = (FSTPatchMutation *)self;
+    NSMutableArray<FSTFieldPath *> *fields = [earlier.fieldMask.fields mutableCopy];
+    for (FSTFieldPath *field in patchedFields) {
+      if (![fields containsObject:field]) {
+        [fields addObject:field];
+      }
+    }
+    return [[FSTPatchMutation alloc]
+         initWithKey:self.key
+           fieldMask:[[FSTFieldMask alloc] initWithFields:fields]
+               value:[earlier.value objectByCopyingPaths:patchedFields fromObject:patch.value]
+        precondition:self.precondition];
+  }
+
+  // A patch can't follow a delete: the backend would reject it.
+  return nil;
+}
+
 @end
 
 #pragma mark - FSTSetMutation
@@ -366,6 +437,10 @@ NS_ASSUME_NONNULL_BEGIN
                                     self.key, self.fieldMask, self.value, self.precondition];
 }
 
+- (nullable NSArray<FSTFieldPath *> *)affectedFieldPaths {
+  return self.fieldMask.fields;
+}
+
 - (nullable FSTMaybeDocument *)applyTo:(nullable FSTMaybeDocument *)maybeDoc
                           baseDocument:(nullable FSTMaybeDocument *)baseDoc
                         localWriteTime:(FSTTimestamp *)localWriteTime
@@ -403,16 +478,7 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (FSTObjectValue *)patchObjectValue:(FSTObjectValue *)objectValue {
-  FSTObjectValue *result = objectValue;
-  for (FSTFieldPath *fieldPath in self.fieldMask.fields) {
-    FSTFieldValue *newValue = [self.value valueForPath:fieldPath];
-    if (newValue) {
-      result = [result objectBySettingValue:newValue forPath:fieldPath];
-    } else {
-      result = [result objectByDeletingPath:fieldPath];
-    }
-  }
-  return result;
+  return [objectValue objectByCopyingPaths:self.fieldMask.fields fromObject:self.value];
 }
 
 @end
@@ -456,6 +522,14 @@ NS_ASSUME_NONNULL_BEGIN
                                     self.key, self.fieldTransforms, self.precondition];
 }
 
+- (nullable NSArray<FSTFieldPath *> *)affectedFieldPaths {
+  NSMutableArray<FSTFieldPath *> *paths = [NSMutableArray array];
+  for (FSTFieldTransform *fieldTransform in self.fieldTransforms) {
+    [paths addObject:fieldTransform.path];
+  }
+  return paths;
+}
+
 - (nullable FSTMaybeDocument *)applyTo:(nullable FSTMaybeDocument *)maybeDoc
                           baseDocument:(nullable FSTMaybeDocument *)baseDoc
                         localWriteTime:(FSTTimestamp *)localWriteTime
@@ -525,17 +599,17 @@ NS_ASSUME_NONNULL_BEGIN
   FSTAssert(transformResults.count == self.fieldTransforms.count,
             @"Transform results length mismatch.");
 
-  for (NSUInteger i = 0; i < self.fieldTransforms.count; i++) {
-    FSTFieldTransform *fieldTransform = self.fieldTransforms[i];
+  NSMutableArray<FSTFieldPath *> *fieldPaths =
+      [NSMutableArray arrayWithCapacity:self.fieldTransforms.count];
+  for (FSTFieldTransform *fieldTransform in self.fieldTransforms) {
     id<FSTTransformOperation> transform = fieldTransform.transform;
-    FSTFieldPath *fieldPath = fieldTransform.path;
     if ([transform isKindOfClass:[FSTServerTimestampTransform class]]) {
-      objectValue = [objectValue objectBySettingValue:transformResults[i] forPath:fieldPath];
+      [fieldPaths addObject:fieldTransform.path];
     } else {
       FSTFail(@"Encountered unknown transform: %@", transform);
     }
   }
-  return objectValue;
+  return [objectValue objectBySettingValues:transformResults forPaths:fieldPaths];
 }
 
 @end
@@ -112,7 +112,9 @@ extern const FSTBatchID kFSTBatchIDUnknown;
 @property(nonatomic, strong, readonly) FSTSnapshotVersion *commitVersion;
 @property(nonatomic, strong, readonly) NSArray<FSTMutationResult *> *mutationResults;
 @property(nonatomic, strong, readonly, nullable) NSData *streamToken;
-@property(nonatomic, strong, readonly) FSTDocumentVersionDictionary *docVersions;
+
+/** The version each document in the batch was acknowledged at. */
+- (const FSTDocumentVersionDictionary &)docVersions;
 
 @end
 
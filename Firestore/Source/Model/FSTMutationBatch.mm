@@ -16,6 +16,9 @@
 
 #import "Firestore/Source/Model/FSTMutationBatch.h"
 
+#include <utility>
+#include <vector>
+
 #import "Firestore/Source/Core/FSTSnapshotVersion.h"
 #import "Firestore/Source/Core/FSTTimestamp.h"
 #import "Firestore/Source/Model/FSTDocument.h"
@@ -107,13 +110,12 @@ const FSTBatchID kFSTBatchIDUnknown = -1;
                                          mutations:@[]];
 }
 
-// TODO(klimt): This could use NSMutableDictionary instead.
 - (FSTDocumentKeySet *)keys {
-  FSTDocumentKeySet *set = [FSTDocumentKeySet keySet];
+  NSMutableSet<FSTDocumentKey *> *keys = [NSMutableSet setWithCapacity:self.mutations.count];
   for (FSTMutation *mutation in self.mutations) {
-    set = [set setByAddingObject:mutation.key];
+    [keys addObject:mutation.key];
   }
-  return set;
+  return [FSTDocumentKeySet keySetWithKeys:keys];
 }
 
 @end
@@ -125,26 +127,32 @@ const FSTBatchID kFSTBatchIDUnknown = -1;
                 commitVersion:(FSTSnapshotVersion *)commitVersion
               mutationResults:(NSArray<FSTMutationResult *> *)mutationResults
                   streamToken:(nullable NSData *)streamToken
-                  docVersions:(FSTDocumentVersionDictionary *)docVersions NS_DESIGNATED_INITIALIZER;
+                  docVersions:(FSTDocumentVersionDictionary)docVersions NS_DESIGNATED_INITIALIZER;
 @end
 
-@implementation FSTMutationBatchResult
+@implementation FSTMutationBatchResult {
+  FSTDocumentVersionDictionary _docVersions;
+}
 
 - (instancetype)initWithBatch:(FSTMutationBatch *)batch
                 commitVersion:(FSTSnapshotVersion *)commitVersion
               mutationResults:(NSArray<FSTMutationResult *> *)mutationResults
                   streamToken:(nullable NSData *)streamToken
-                  docVersions:(FSTDocumentVersionDictionary *)docVersions {
+                  docVersions:(FSTDocumentVersionDictionary)docVersions {
   if (self = [super init]) {
     _batch = batch;
     _commitVersion = commitVersion;
     _mutationResults = mutationResults;
     _streamToken = streamToken;
-    _docVersions = docVersions;
+    _docVersions = std::move(docVersions);
   }
   return self;
 }
 
+- (const FSTDocumentVersionDictionary &)docVersions {
+  return _docVersions;
+}
+
 + (instancetype)resultWithBatch:(FSTMutationBatch *)batch
                   commitVersion:(FSTSnapshotVersion *)commitVersion
                 mutationResults:(NSArray<FSTMutationResult *> *)mutationResults
@@ -153,9 +161,9 @@ const FSTBatchID kFSTBatchIDUnknown = -1;
             @"Mutations sent %lu must equal results received %lu",
             (unsigned long)batch.mutations.count, (unsigned long)mutationResults.count);
 
-  FSTDocumentVersionDictionary *docVersions =
-      [FSTDocumentVersionDictionary documentVersionDictionary];
+  std::vector<FSTDocumentVersionDictionary::value_type> versions;
   NSArray<FSTMutation *> *mutations = batch.mutations;
+  versions.reserve(mutations.count);
   for (NSUInteger i = 0; i < mutations.count; i++) {
     FSTSnapshotVersion *_Nullable version = mutationResults[i].version;
     if (!version) {
@@ -164,14 +172,15 @@ const FSTBatchID kFSTBatchIDUnknown = -1;
       version = commitVersion;
     }
 
-    docVersions = [docVersions dictionaryBySettingObject:version forKey:mutations[i].key];
+    versions.emplace_back(mutations[i].key, version.value);
   }
 
   return [[FSTMutationBatchResult alloc] initWithBatch:batch
                                          commitVersion:commitVersion
                                        mutationResults:mutationResults
                                            streamToken:streamToken
-                                           docVersions:docVersions];
+                                           docVersions:FSTDocumentVersionDictionary{
+                                                           std::move(versions)}];
 }
 
 @end
@@ -21,6 +21,10 @@
 #import "Firestore/Source/Util/FSTClasses.h"
 #import "Firestore/Source/Util/FSTUsageValidation.h"
 
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
+
+namespace util = firebase::firestore::util;
+
 NS_ASSUME_NONNULL_BEGIN
 
 @interface FSTPath ()
@@ -101,7 +105,8 @@ NS_ASSUME_NONNULL_BEGIN
   for (int i = 0; i < length; ++i) {
     NSString *left = [self segmentAtIndex:i];
     NSString *right = [other segmentAtIndex:i];
-    NSComparisonResult result = [left compare:right];
+    // Segments are ordered by their UTF-8 bytes, as on the backend.
+    NSComparisonResult result = util::WrapCompare(left, right);
     if (result != NSOrderedSame) {
       return result;
     }
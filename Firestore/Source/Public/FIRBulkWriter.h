@@ -0,0 +1,123 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FIRDocumentReference;
+@class FIRSetOptions;
+
+/**
+ * A bulk writer performs a large number of independent writes, such as those of a data migration.
+ *
+ * A `FIRBulkWriter` can be acquired by calling [FIRFirestore bulkWriter]. Unlike a
+ * `FIRWriteBatch`, it takes any number of writes: they are committed in batches as they are
+ * added, and a limited number of batches is sent to the backend at a time. Writes are not
+ * atomic with each other, except that all writes in the same batch succeed or fail together.
+ *
+ * A bulk writer can be used from any thread. Its completion blocks are called on the
+ * `dispatchQueue` of the settings.
+ */
+NS_SWIFT_NAME(BulkWriter)
+@interface FIRBulkWriter : NSObject
+
+/** :nodoc: */
+- (id)init __attribute__((unavailable("FIRBulkWriter cannot be created directly.")));
+
+/**
+ * Writes to the document referred to by `document`. If the document doesn't yet exist,
+ * this method creates it and then sets the data. If the document exists, this method overwrites
+ * the document data with the new values.
+ *
+ * @param data An `NSDictionary` that contains the fields and data to write to the document.
+ * @param document A reference to the document whose data should be overwritten.
+ * @param completion A block to be called once the batch containing the write has been committed
+ *     to the backend, or has failed.
+ */
+// clang-format off
+- (void)setData:(NSDictionary<NSString *, id> *)data
+    forDocument:(FIRDocumentReference *)document
+     completion:(nullable void (^)(NSError *_Nullable error))completion
+    NS_SWIFT_NAME(setData(_:forDocument:completion:));
+// clang-format on
+
+/**
+ * Writes to the document referred to by `document`. If the document doesn't yet exist,
+ * this method creates it and then sets the data. If you pass `FIRSetOptions`, the provided data
+ * will be merged into an existing document.
+ *
+ * @param data An `NSDictionary` that contains the fields and data to write to the document.
+ * @param document A reference to the document whose data should be overwritten.
+ * @param options A `FIRSetOptions` used to configure the set behavior.
+ * @param completion A block to be called once the batch containing the write has been committed
+ *     to the backend, or has failed.
+ */
+// clang-format off
+- (void)setData:(NSDictionary<NSString *, id> *)data
+    forDocument:(FIRDocumentReference *)document
+        options:(FIRSetOptions *)options
+     completion:(nullable void (^)(NSError *_Nullable error))completion
+    NS_SWIFT_NAME(setData(_:forDocument:options:completion:));
+// clang-format on
+
+/**
+ * Updates fields in the document referred to by `document`. If the document does not exist, the
+ * batch containing the update fails.
+ *
+ * @param fields An `NSDictionary` containing the fields (expressed as an `NSString` or
+ *     `FIRFieldPath`) and values with which to update the document.
+ * @param document A reference to the document whose data should be updated.
+ * @param completion A block to be called once the batch containing the write has been committed
+ *     to the backend, or has failed.
+ */
+// clang-format off
+- (void)updateData:(NSDictionary<id, id> *)fields
+       forDocument:(FIRDocumentReference *)document
+        completion:(nullable void (^)(NSError *_Nullable error))completion
+    NS_SWIFT_NAME(updateData(_:forDocument:completion:));
+// clang-format on
+
+/**
+ * Deletes the document referred to by `document`.
+ *
+ * @param document A reference to the document that should be deleted.
+ * @param completion A block to be called once the batch containing the write has been committed
+ *     to the backend, or has failed.
+ */
+// clang-format off
+- (void)deleteDocument:(FIRDocumentReference *)document
+            completion:(nullable void (^)(NSError *_Nullable error))completion
+    NS_SWIFT_NAME(deleteDocument(_:completion:));
+// clang-format on
+
+/**
+ * Commits the writes added so far without waiting for their batch to fill up.
+ *
+ * @param completion A block to be called once all writes added before this call have completed.
+ */
+- (void)flushWithCompletion:(nullable void (^)(void))completion;
+
+/**
+ * Flushes the writes added so far and prevents any more writes from being added.
+ *
+ * @param completion A block to be called once all writes have completed.
+ */
+- (void)closeWithCompletion:(nullable void (^)(void))completion;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -18,8 +18,11 @@
 
 @class FIRApp;
 @class FIRCollectionReference;
+@class FIRBulkWriter;
 @class FIRDocumentReference;
+@class FIRDocumentSnapshot;
 @class FIRFirestoreSettings;
+@class FIRQuery;
 @class FIRTransaction;
 @class FIRWriteBatch;
 
@@ -91,6 +94,24 @@ NS_SWIFT_NAME(Firestore)
  */
 - (FIRDocumentReference *)documentWithPath:(NSString *)documentPath NS_SWIFT_NAME(document(_:));
 
+/**
+ * Reads the documents referred to by several `FIRDocumentReference`s at once. Documents the cache
+ * is kept in sync with by an active listener are read from the cache, and the rest are read from
+ * the backend in a single request, so that getting many known documents takes one round trip
+ * rather than one per document. Like `getDocumentWithCompletion:`, the snapshots reflect pending
+ * writes, and if the client is offline they're served from the cache, failing if any of the
+ * documents isn't cached.
+ *
+ * @param documents The references of the documents to read. They must belong to this Firestore
+ *     instance.
+ * @param completion A block called on the `dispatchQueue` of the settings with a snapshot for
+ *     each reference, in the same order, or with an error.
+ */
+- (void)getDocuments:(NSArray<FIRDocumentReference *> *)documents
+          completion:(void (^)(NSArray<FIRDocumentSnapshot *> *_Nullable snapshots,
+                               NSError *_Nullable error))completion
+    NS_SWIFT_NAME(getDocuments(_:completion:));
+
 #pragma mark - Transactions and Write Batches
 
 /**
@@ -133,6 +154,13 @@ NS_SWIFT_NAME(Firestore)
  */
 - (FIRWriteBatch *)batch;
 
+/**
+ * Creates a bulk writer, used for performing a large number of writes that need not be atomic,
+ * such as those of a data migration. The writes are committed in batches of limited size, and only
+ * a limited number of batches is sent to the backend at a time.
+ */
+- (FIRBulkWriter *)bulkWriter;
+
 #pragma mark - Logging
 
 /** Enables or disables logging from the Firestore client. */
@@ -156,6 +184,85 @@ NS_SWIFT_NAME(Firestore)
  */
 - (void)disableNetworkWithCompletion:(nullable void (^)(NSError *_Nullable error))completion;
 
+/**
+ * Connects to the backend ahead of use, e.g. when the app comes to the foreground, so that the
+ * first listener or write doesn't wait for the connection to be set up. Connections that go unused
+ * are closed again after `FIRFirestoreSettings.streamIdleTimeout`. Does nothing while the network
+ * is disabled.
+ */
+- (void)prewarmNetwork;
+
+#pragma mark - Bundles
+
+/**
+ * Loads a bundle of prebuilt query results into the local cache, e.g. to give a new install the
+ * documents every user needs without syncing them one by one. The documents are cached as of the
+ * time the bundle was read from the backend, and listens to its queries only fetch what changed
+ * since. Cached documents and query results that are more recent than the bundle's are kept.
+ *
+ * The bundle must have been built for this database.
+ *
+ * @param bundle The encoded bundle.
+ * @param completion A block called on the `dispatchQueue` of the settings once the bundle is
+ *     loaded, with an error if it is malformed. Part of a malformed bundle may have been loaded.
+ */
+- (void)loadBundle:(NSData *)bundle
+        completion:(nullable void (^)(NSError *_Nullable error))completion
+    NS_SWIFT_NAME(loadBundle(_:completion:));
+
+/**
+ * Fetches the documents matching a query into the local cache, e.g. before going offline, without
+ * attaching a listener or building snapshots of the results. The results are kept in the cache
+ * until the expiry date even if the cache grows past its size threshold, so that listens and
+ * reads of the query can be served from the cache offline. Pins are kept in memory only, so they
+ * end when the app is restarted.
+ *
+ * @param query The query to prefetch. It must belong to this Firestore instance.
+ * @param expiryDate The date until which the results are kept in the cache.
+ * @param progress A block called on the `dispatchQueue` of the settings as results arrive, with
+ *     the number of documents received so far.
+ * @param completion A block called on the `dispatchQueue` of the settings once the cache is in
+ *     sync with the backend for the query, or with an error if the query is rejected.
+ */
+- (void)prefetchQuery:(FIRQuery *)query
+            untilDate:(NSDate *)expiryDate
+             progress:(nullable void (^)(NSInteger documentCount))progress
+           completion:(nullable void (^)(NSError *_Nullable error))completion
+    NS_SWIFT_NAME(prefetch(_:until:progress:completion:));
+
+#pragma mark - Diagnostics
+
+/**
+ * Reports the approximate size on disk, in bytes, of each part of the local persistent cache,
+ * keyed by the `FIRFirestoreCacheTable` constants. The sizes are cheap to compute but lag behind
+ * recent changes. Persistence must be enabled; otherwise the dictionary is empty.
+ *
+ * @param completion A block called on the `dispatchQueue` of the settings with the sizes.
+ */
+- (void)getCacheSizesWithCompletion:
+    (void (^)(NSDictionary<NSString *, NSNumber *> *sizes))completion
+    NS_SWIFT_NAME(getCacheSizes(completion:));
+
+/**
+ * Reports the approximate memory held by each part of the client, keyed by the
+ * `FIRFirestoreMemoryComponent` constants, to find out e.g. which listeners hold the most when the
+ * app receives a memory warning. Each component's usage is a dictionary with its
+ * `FIRFirestoreMemoryObjectCount` and `FIRFirestoreMemoryApproximateBytes`. The same document may
+ * be counted by more than one component.
+ *
+ * @param completion A block called on the `dispatchQueue` of the settings with the usage.
+ */
+- (void)getMemoryUsageWithCompletion:
+    (void (^)(NSDictionary<NSString *, NSDictionary<NSString *, NSNumber *> *> *usage))completion
+    NS_SWIFT_NAME(getMemoryUsage(completion:));
+
+/**
+ * Releases the memory held by caches that can be read back from local persistent storage, e.g.
+ * from `didReceiveMemoryWarning`. Documents that are only held in memory, such as the results of
+ * active listeners, are kept.
+ */
+- (void)releaseCachedMemory;
+
 @end
 
 NS_ASSUME_NONNULL_END
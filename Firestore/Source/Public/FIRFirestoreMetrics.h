@@ -0,0 +1,198 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** Bytes sent to the backend on the stream used to listen to queries. */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricWatchBytesSent
+    NS_SWIFT_NAME(FirestoreMetricWatchBytesSent);
+
+/** Bytes received from the backend on the stream used to listen to queries. */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricWatchBytesReceived
+    NS_SWIFT_NAME(FirestoreMetricWatchBytesReceived);
+
+/** Messages sent to the backend on the stream used to listen to queries. */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricWatchMessagesSent
+    NS_SWIFT_NAME(FirestoreMetricWatchMessagesSent);
+
+/** Messages received from the backend on the stream used to listen to queries. */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricWatchMessagesReceived
+    NS_SWIFT_NAME(FirestoreMetricWatchMessagesReceived);
+
+/**
+ * Histogram of the time, in seconds, from starting the stream used to listen to queries until the
+ * first message arrives from the backend.
+ */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricWatchHandshakeLatency
+    NS_SWIFT_NAME(FirestoreMetricWatchHandshakeLatency);
+
+/** Bytes sent to the backend on the stream used to commit writes. */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricWriteBytesSent
+    NS_SWIFT_NAME(FirestoreMetricWriteBytesSent);
+
+/** Bytes received from the backend on the stream used to commit writes. */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricWriteBytesReceived
+    NS_SWIFT_NAME(FirestoreMetricWriteBytesReceived);
+
+/** Messages sent to the backend on the stream used to commit writes. */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricWriteMessagesSent
+    NS_SWIFT_NAME(FirestoreMetricWriteMessagesSent);
+
+/** Messages received from the backend on the stream used to commit writes. */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricWriteMessagesReceived
+    NS_SWIFT_NAME(FirestoreMetricWriteMessagesReceived);
+
+/**
+ * Histogram of the time, in seconds, from starting the stream used to commit writes until the
+ * first message arrives from the backend.
+ */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricWriteHandshakeLatency
+    NS_SWIFT_NAME(FirestoreMetricWriteHandshakeLatency);
+
+/**
+ * Histogram of the time, in seconds, from starting to listen to a query until the backend reports
+ * that the query's results are up to date.
+ */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricTargetSyncLatency
+    NS_SWIFT_NAME(FirestoreMetricTargetSyncLatency);
+
+/**
+ * Histogram of the delays, in seconds, waited before reconnecting a stream to the backend after an
+ * error.
+ */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricStreamBackoffDelay
+    NS_SWIFT_NAME(FirestoreMetricStreamBackoffDelay);
+
+/**
+ * Histogram of the time, in seconds, from creating a client until all of its components have
+ * started and it can serve queries and writes.
+ */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricStartupLatency
+    NS_SWIFT_NAME(FirestoreMetricStartupLatency);
+
+/**
+ * Histogram of the time, in seconds, from creating a client until the credentials provider reports
+ * the initial user.
+ */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricStartupCredentialsLatency
+    NS_SWIFT_NAME(FirestoreMetricStartupCredentialsLatency);
+
+/**
+ * Histogram of the time, in seconds, taken to open the local cache at startup, including any
+ * migration of its schema.
+ */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricStartupPersistenceLatency
+    NS_SWIFT_NAME(FirestoreMetricStartupPersistenceLatency);
+
+/**
+ * Histogram of the time, in seconds, taken at startup to load the queued writes and cached query
+ * metadata from the local cache.
+ */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricStartupLocalStoreLatency
+    NS_SWIFT_NAME(FirestoreMetricStartupLocalStoreLatency);
+
+/** Histogram of the time, in seconds, taken at startup to start the connection to the backend. */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMetricStartupRemoteStoreLatency
+    NS_SWIFT_NAME(FirestoreMetricStartupRemoteStoreLatency);
+
+/** Key for the size of the cached documents in the sizes reported by `getCacheSizes`. */
+FOUNDATION_EXPORT NSString *const FIRFirestoreCacheTableRemoteDocuments
+    NS_SWIFT_NAME(FirestoreCacheTableRemoteDocuments);
+
+/** Key for the size of the queued local writes in the sizes reported by `getCacheSizes`. */
+FOUNDATION_EXPORT NSString *const FIRFirestoreCacheTableMutations
+    NS_SWIFT_NAME(FirestoreCacheTableMutations);
+
+/** Key for the size of the cached queries in the sizes reported by `getCacheSizes`. */
+FOUNDATION_EXPORT NSString *const FIRFirestoreCacheTableTargets
+    NS_SWIFT_NAME(FirestoreCacheTableTargets);
+
+/**
+ * Key for the size of the records of which cached documents match each cached query in the sizes
+ * reported by `getCacheSizes`.
+ */
+FOUNDATION_EXPORT NSString *const FIRFirestoreCacheTableTargetDocuments
+    NS_SWIFT_NAME(FirestoreCacheTableTargetDocuments);
+
+/**
+ * Key for the cached documents held in memory in the usage reported by `getMemoryUsage`. With
+ * persistence enabled, these are the recently read documents kept decoded.
+ */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMemoryComponentCachedDocuments
+    NS_SWIFT_NAME(FirestoreMemoryComponentCachedDocuments);
+
+/**
+ * Key for the documents in the results of all active listeners in the usage reported by
+ * `getMemoryUsage`. The results of each listened-to query are also reported separately, under
+ * this key followed by a colon and a description of the query.
+ */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMemoryComponentListenerResults
+    NS_SWIFT_NAME(FirestoreMemoryComponentListenerResults);
+
+/**
+ * Key for the references that keep documents used by listeners in the cache in the usage reported
+ * by `getMemoryUsage`.
+ */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMemoryComponentReferences
+    NS_SWIFT_NAME(FirestoreMemoryComponentReferences);
+
+/**
+ * Key for the batches of local writes being sent to the backend in the usage reported by
+ * `getMemoryUsage`.
+ */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMemoryComponentPendingWrites
+    NS_SWIFT_NAME(FirestoreMemoryComponentPendingWrites);
+
+/**
+ * Key for the documents received from the backend but not yet applied in the usage reported by
+ * `getMemoryUsage`.
+ */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMemoryComponentQueuedMessages
+    NS_SWIFT_NAME(FirestoreMemoryComponentQueuedMessages);
+
+/** Key for the number of objects a component holds in the usage reported by `getMemoryUsage`. */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMemoryObjectCount
+    NS_SWIFT_NAME(FirestoreMemoryObjectCount);
+
+/**
+ * Key for the approximate number of bytes a component holds in the usage reported by
+ * `getMemoryUsage`.
+ */
+FOUNDATION_EXPORT NSString *const FIRFirestoreMemoryApproximateBytes
+    NS_SWIFT_NAME(FirestoreMemoryApproximateBytes);
+
+/**
+ * Receives measurements of Firestore's network traffic and latencies, including the time each
+ * phase of startup takes, e.g. to feed an app's own monitoring. The names passed in are the
+ * `FIRFirestoreMetric` constants.
+ *
+ * Methods are called on Firestore's internal queue, in the middle of handling network traffic;
+ * implementations must return quickly and must not call back into Firestore.
+ */
+NS_SWIFT_NAME(FirestoreMetricsProvider)
+@protocol FIRFirestoreMetricsProvider <NSObject>
+
+/** Adds `amount` to the counter with the given name. */
+- (void)incrementCounter:(NSString *)name by:(int64_t)amount;
+
+/** Records a single sample in the histogram with the given name. */
+- (void)recordValue:(double)value forHistogram:(NSString *)name;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -16,6 +16,8 @@
 
 #import <Foundation/Foundation.h>
 
+@protocol FIRFirestoreMetricsProvider;
+
 NS_ASSUME_NONNULL_BEGIN
 
 /** Settings used to configure a `FIRFirestore` instance. */
@@ -44,6 +46,109 @@ NS_SWIFT_NAME(FirestoreSettings)
 /** Set to false to disable local persistent storage. */
 @property(nonatomic, getter=isPersistenceEnabled) BOOL persistenceEnabled;
 
+/**
+ * The size, in bytes, of the in-memory cache of recently read data from local persistent storage.
+ * Larger values make repeated reads faster at the cost of memory. Must be positive. Defaults to
+ * 4 MB. Has no effect if persistence is disabled.
+ */
+@property(nonatomic, assign) int64_t persistenceCacheSizeBytes;
+
+/**
+ * The amount of written data, in bytes, that local persistent storage buffers in memory before
+ * writing it out to a new file on disk. Larger values speed up bulk writes at the cost of memory
+ * and of a longer startup after the app is terminated. Must be positive. Defaults to 2 MB. Has no
+ * effect if persistence is disabled.
+ */
+@property(nonatomic, assign) int64_t persistenceWriteBufferSizeBytes;
+
+/**
+ * The size, in bytes, that the cached documents and queries in local persistent storage may grow
+ * to before the least recently used queries that are no longer listened to are removed, together
+ * with the documents only they matched. The size is measured approximately, so the cache can
+ * briefly exceed it. Must be positive. Defaults to 100 MB. Has no effect if persistence is
+ * disabled.
+ */
+@property(nonatomic, assign) int64_t persistenceGarbageCollectionThresholdBytes;
+
+/**
+ * If persistence is disabled, the number of documents that may be cached in memory before the
+ * least recently used queries that are no longer listened to are removed, together with the
+ * documents only they matched. Documents that active queries or pending writes depend on are never
+ * removed, so the cache can exceed this number. Must not be negative. Defaults to 0, which removes
+ * the cached results of a query as soon as it is no longer listened to. Has no effect if
+ * persistence is enabled.
+ */
+@property(nonatomic, assign) int64_t memoryGarbageCollectionThresholdDocuments;
+
+/**
+ * Set to true to deliver snapshot events in batches: all the events raised for one change, such as
+ * a batch of updates from the backend affecting many queries, are dispatched to `dispatchQueue`
+ * together instead of one at a time. Defaults to false.
+ */
+@property(nonatomic, getter=isSnapshotBatchingEnabled) BOOL snapshotBatchingEnabled;
+
+/**
+ * With snapshot batching enabled, the minimum time, in seconds, between two deliveries of snapshot
+ * events. A listener whose query changes several times in between gets a single snapshot with all
+ * the changes. Must not be negative. Defaults to 0, which delivers events as soon as possible. Has
+ * no effect if snapshot batching is disabled.
+ */
+@property(nonatomic, assign) NSTimeInterval snapshotBatchingInterval;
+
+/**
+ * Set to true to send consecutive pending writes to the backend together, which drains large
+ * numbers of queued writes faster on slow connections. Coalesced writes are committed together, so
+ * their completion handlers run at the same time. Defaults to false.
+ */
+@property(nonatomic, getter=isWriteCoalescingEnabled) BOOL writeCoalescingEnabled;
+
+/**
+ * Set to true to fold a write into the previous one while that one is still waiting to be sent to
+ * the backend, so that repeated updates to a document made offline are stored and sent as a single
+ * write. Squashed writes succeed or fail together, so their completion handlers run at the same
+ * time. Defaults to false.
+ */
+@property(nonatomic, getter=isWriteSquashingEnabled) BOOL writeSquashingEnabled;
+
+/**
+ * Set to true to serve all listeners on queries of the same collection from a single listen to the
+ * whole collection, applying each query's filters, ordering and limit on the device. This suits
+ * screens with many similar listeners on a small collection, since the backend then tracks and
+ * sends each document once, but every document in the collection is downloaded. Defaults to false.
+ */
+@property(nonatomic, getter=isTargetMultiplexingEnabled) BOOL targetMultiplexingEnabled;
+
+/**
+ * While queries are catching up with the backend, such as during an initial sync, the time, in
+ * seconds, to wait for further updates from the backend before applying the ones received so far.
+ * Applying many small updates together saves local storage and listener work at the cost of
+ * latency during the sync. Must not be negative. Defaults to 0, which applies every update as soon
+ * as it arrives.
+ */
+@property(nonatomic, assign) NSTimeInterval syncCoalescingInterval;
+
+/**
+ * Set to true to gzip-compress the data sent to the backend, including writes and the queries to
+ * listen to. This saves bandwidth on metered connections for data that compresses well, such as
+ * large text fields, at the cost of CPU time. Defaults to false.
+ */
+@property(nonatomic, getter=isCompressionEnabled) BOOL compressionEnabled;
+
+/**
+ * The time, in seconds, that a connection to the backend with no active listeners or pending
+ * writes stays open before it is closed. Larger values keep connections warm for the next listener
+ * or write at the cost of battery and backend resources; smaller values close them sooner. Must be
+ * positive. Defaults to 60 seconds.
+ */
+@property(nonatomic, assign) NSTimeInterval streamIdleTimeout;
+
+/**
+ * An object that receives measurements of network traffic and latencies, such as the bytes sent
+ * on each stream to the backend and the time queries take to sync. Defaults to nil, which turns
+ * off measuring.
+ */
+@property(nonatomic, strong, nullable) id<FIRFirestoreMetricsProvider> metricsProvider;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -18,10 +18,13 @@
 
 #import "FIRListenerRegistration.h"
 
+@class FIRDocumentChange;
 @class FIRFieldPath;
 @class FIRFirestore;
+@class FIRGeoPoint;
 @class FIRQuerySnapshot;
 @class FIRDocumentSnapshot;
+@class FIRSnapshotMetadata;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -63,11 +66,29 @@ NS_SWIFT_NAME(QueryListenOptions)
 - (instancetype)includeDocumentMetadataChanges:(BOOL)includeDocumentMetadataChanges
     NS_SWIFT_NAME(includeDocumentMetadataChanges(_:));
 
+@property(nonatomic, assign, readonly) BOOL includeDocumentDataChanges;
+
+/**
+ * Sets the includeDocumentDataChanges option which controls whether changes to the contents of
+ * documents that remain in the query results should trigger snapshot events. Listeners that only
+ * use which documents match (e.g. to count them or read their IDs) can set this to NO so that they
+ * are only notified when documents are added or removed. Default is YES.
+ *
+ * @param includeDocumentDataChanges Whether to raise events for changes to document contents.
+ * @return The receiver is returned for optional method chaining.
+ */
+- (instancetype)includeDocumentDataChanges:(BOOL)includeDocumentDataChanges
+    NS_SWIFT_NAME(includeDocumentDataChanges(_:));
+
 @end
 
 typedef void (^FIRQuerySnapshotBlock)(FIRQuerySnapshot *_Nullable snapshot,
                                       NSError *_Nullable error);
 
+typedef void (^FIRDocumentChangesBlock)(NSArray<FIRDocumentChange *> *_Nullable changes,
+                                        FIRSnapshotMetadata *_Nullable metadata,
+                                        NSError *_Nullable error);
+
 /**
  * A `FIRQuery` refers to a Query which you can read or listen to. You can also construct
  * refined `FIRQuery` objects by adding filters and ordering.
@@ -90,6 +111,47 @@ NS_SWIFT_NAME(Query)
 - (void)getDocumentsWithCompletion:(FIRQuerySnapshotBlock)completion
     NS_SWIFT_NAME(getDocuments(completion:));
 
+/**
+ * Reads the documents matching this query from the local cache only. The read doesn't wait for
+ * the backend, nor for pending local work such as applying a large batch of changes from the
+ * backend, so it may not reflect the very latest writes. The snapshot's metadata is always
+ * `fromCache`.
+ *
+ * @param completion a block to execute with the documents read from the cache.
+ */
+- (void)getDocumentsFromCacheWithCompletion:(FIRQuerySnapshotBlock)completion
+    NS_SWIFT_NAME(getDocumentsFromCache(completion:));
+
+/**
+ * Reads the documents matching this query from the local cache only, as
+ * `getDocumentsFromCacheWithCompletion:` does, keeping those whose GeoPoint value for the given
+ * field lies within a bounding box. The cache finds them through an index of GeoPoint fields, so
+ * the read doesn't examine every cached document in the collection.
+ *
+ * The box includes its edges, and spans the antimeridian if `southWest` is east of `northEast`.
+ *
+ * @param field The name of the field holding GeoPoint values.
+ * @param southWest The southwest corner of the box.
+ * @param northEast The northeast corner of the box, no further south than `southWest`.
+ * @param completion a block to execute with the documents read from the cache.
+ */
+- (void)getDocumentsFromCacheWhereField:(NSString *)field
+                            inBoundsFrom:(FIRGeoPoint *)southWest
+                                      to:(FIRGeoPoint *)northEast
+                              completion:(FIRQuerySnapshotBlock)completion
+    NS_SWIFT_NAME(getDocumentsFromCache(whereField:inBoundsFrom:to:completion:));
+
+/**
+ * Counts the documents matching this query in the local cache. This is much cheaper than reading
+ * the documents: if this query has been listened to before, the count is based on which documents
+ * matched it when it was last in sync with the backend, adjusted for pending local writes, and
+ * only the documents those writes affect are read.
+ *
+ * @param completion a block to execute with the number of documents in the cache that match.
+ */
+- (void)getCountFromCacheWithCompletion:(void (^)(NSInteger count))completion
+    NS_SWIFT_NAME(getCountFromCache(completion:));
+
 /**
  * Attaches a listener for QuerySnapshot events.
  *
@@ -115,6 +177,22 @@ NS_SWIFT_NAME(Query)
     NS_SWIFT_NAME(addSnapshotListener(options:listener:));
 // clang-format on
 
+/**
+ * Attaches a listener that receives only the changes to the documents matching this query. The
+ * first event adds every matching document and later events carry what changed since the previous
+ * one. No copy of the results is kept for the listener, so this suits keeping a large replica of
+ * the results elsewhere: the listener only pays for the changes.
+ *
+ * Since there is no result set, the `oldIndex` and `newIndex` of the changes are `NSNotFound`.
+ * Events aren't raised for metadata-only changes.
+ *
+ * @param listener The listener to attach.
+ *
+ * @return A FIRListenerRegistration that can be used to remove this listener.
+ */
+- (id<FIRListenerRegistration>)addDocumentChangesListener:(FIRDocumentChangesBlock)listener
+    NS_SWIFT_NAME(addDocumentChangesListener(_:));
+
 #pragma mark - Filtering Data
 /**
  * Creates and returns a new `FIRQuery` with the additional filter that documents must
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#import "FIRBulkWriter.h"
 #import "FIRCollectionReference.h"
 #import "FIRDocumentChange.h"
 #import "FIRDocumentReference.h"
@@ -22,6 +23,7 @@
 #import "FIRFieldValue.h"
 #import "FIRFirestore.h"
 #import "FIRFirestoreErrors.h"
+#import "FIRFirestoreMetrics.h"
 #import "FIRFirestoreSettings.h"
 #import "FIRGeoPoint.h"
 #import "FIRListenerRegistration.h"
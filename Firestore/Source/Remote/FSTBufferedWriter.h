@@ -28,6 +28,11 @@ NS_ASSUME_NONNULL_BEGIN
  * GRXWriterStatePaused. Once the channel is ready to accept more messages GRPC sets the state of
  * the writer to GRXWriterStateStarted.
  *
+ * The buffer itself is unbounded since messages can't be dropped, so it relies on its senders to
+ * stop writing while it reports that it is full: once the buffered messages reach a high
+ * watermark, -isFull returns YES until the channel has drained them down to a low watermark, at
+ * which point the drainHandler is called.
+ *
  * This class is NOT thread safe, even though it is accessed from multiple threads. To conform with
  * the contract GRPC uses, all method calls on the FSTBufferedWriter must be @synchronized on the
  * receiver.
@@ -39,6 +44,21 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)writeValue:(id)value;
 
+/** The total size in bytes of the messages waiting in the buffer. */
+@property(nonatomic, assign, readonly) NSUInteger bufferedByteCount;
+
+/**
+ * Returns YES if senders should stop writing into the buffer until the drainHandler is called.
+ * Must be called inside an @synchronized block on the receiver.
+ */
+@property(nonatomic, assign, readonly, getter=isFull) BOOL full;
+
+/**
+ * A block called once a full buffer has drained down to its low watermark. It is called on
+ * GRPC's queue, inside the @synchronized block GRPC holds on the receiver.
+ */
+@property(nonatomic, copy, nullable) void (^drainHandler)(void);
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -16,13 +16,21 @@
 
 #import <Protobuf/GPBProtocolBuffers.h>
 
+#include <deque>
+
 #import "Firestore/Source/Remote/FSTBufferedWriter.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+/** The buffered size in bytes at which the writer starts to report that it is full. */
+static const NSUInteger kHighWatermarkBytes = 1024 * 1024;
+
+/** The buffered size in bytes a full writer must drain down to before accepting writes again. */
+static const NSUInteger kLowWatermarkBytes = 256 * 1024;
+
 @implementation FSTBufferedWriter {
   GRXWriterState _state;
-  NSMutableArray<NSData *> *_queue;
+  std::deque<NSData *> _queue;
 
   id<GRXWriteable> _writeable;
 }
@@ -30,7 +38,6 @@ NS_ASSUME_NONNULL_BEGIN
 - (instancetype)init {
   if (self = [super init]) {
     _state = GRXWriterStateNotStarted;
-    _queue = [[NSMutableArray alloc] init];
   }
   return self;
 }
@@ -39,13 +46,17 @@ NS_ASSUME_NONNULL_BEGIN
 
 /** Push the next value of the sequence to the receiving object. */
 - (void)writeValue:(id)value {
-  if (_state == GRXWriterStateStarted && _queue.count == 0) {
+  if (_state == GRXWriterStateStarted && _queue.empty()) {
     // Skip the queue.
     [_writeable writeValue:value];
-  } else {
+  } else if (_state != GRXWriterStateFinished) {
     // Buffer the new value. Note that the value is assumed to be transient and doesn't need to
     // be copied.
-    [_queue addObject:value];
+    _queue.push_back(value);
+    _bufferedByteCount += [value length];
+    if (_bufferedByteCount >= kHighWatermarkBytes) {
+      _full = YES;
+    }
   }
 }
 
@@ -94,7 +105,8 @@ NS_ASSUME_NONNULL_BEGIN
       _state = newState;
       // Per GRXWriter's contract, setting the state to Finished manually means one doesn't wish the
       // writeable to be messaged anymore.
-      _queue = nil;
+      _queue.clear();
+      _bufferedByteCount = 0;
       _writeable = nil;
       return;
     case GRXWriterStatePaused:
@@ -117,9 +129,10 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (void)writeBufferedMessages {
-  while (_state == GRXWriterStateStarted && _queue.count > 0) {
-    id value = _queue[0];
-    [_queue removeObjectAtIndex:0];
+  while (_state == GRXWriterStateStarted && !_queue.empty()) {
+    NSData *value = _queue.front();
+    _queue.pop_front();
+    _bufferedByteCount -= value.length;
 
     // In addition to writing the value here GRPC will apply backpressure by pausing the GRXWriter
     // wrapping this buffer. That writer must call -pauseMessages which will cause this loop to
@@ -127,6 +140,13 @@ NS_ASSUME_NONNULL_BEGIN
     // writeValue implementation.
     [_writeable writeValue:value];
   }
+
+  if (_full && _bufferedByteCount <= kLowWatermarkBytes) {
+    _full = NO;
+    if (_drainHandler) {
+      _drainHandler();
+    }
+  }
 }
 
 @end
@@ -32,6 +32,7 @@
 @class GRPCCall;
 @class GRXWriter;
 
+@protocol FIRFirestoreMetricsProvider;
 @protocol FSTCredentialsProvider;
 @class FSTDatabaseID;
 
@@ -101,6 +102,21 @@ NS_ASSUME_NONNULL_BEGIN
 /** The name of the database and the backend. */
 @property(nonatomic, strong, readonly) FSTDatabaseInfo *databaseInfo;
 
+/** The queue that RPC completions are called on. */
+@property(nonatomic, strong, readonly) FSTDispatchQueue *workerDispatchQueue;
+
+/**
+ * Whether requests to the backend are gzip-compressed. This applies to every RPC to the backend's
+ * host, including both streams, and should be set before the first RPC is started.
+ */
+@property(nonatomic, assign, getter=isCompressionEnabled) BOOL compressionEnabled;
+
+/** The idle timeout of the streams created after it is set. */
+@property(nonatomic, assign) NSTimeInterval streamIdleTimeout;
+
+/** If set, receives the measurements of the streams created after it is set. */
+@property(nonatomic, strong, nullable) id<FIRFirestoreMetricsProvider> metricsProvider;
+
 @end
 
 NS_ASSUME_NONNULL_END
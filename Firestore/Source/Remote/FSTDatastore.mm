@@ -16,6 +16,7 @@
 
 #import "Firestore/Source/Remote/FSTDatastore.h"
 
+#import <GRPCClient/GRPCCall+ChannelArg.h>
 #import <GRPCClient/GRPCCall+OAuth2.h>
 #import <ProtoRPC/ProtoRPC.h>
 
@@ -60,8 +61,6 @@ typedef GRPCProtoCall * (^RPCFactory)(void);
 /** The GRPC service for Firestore. */
 @property(nonatomic, strong, readonly) GCFSFirestore *service;
 
-@property(nonatomic, strong, readonly) FSTDispatchQueue *workerDispatchQueue;
-
 /** An object for getting an auth token before each request. */
 @property(nonatomic, strong, readonly) id<FSTCredentialsProvider> credentials;
 
@@ -92,6 +91,7 @@ typedef GRPCProtoCall * (^RPCFactory)(void);
     _workerDispatchQueue = workerDispatchQueue;
     _credentials = credentials;
     _serializer = [[FSTSerializerBeta alloc] initWithDatabaseID:databaseInfo.databaseID];
+    _streamIdleTimeout = kFSTStreamDefaultIdleTimeout;
   }
   return self;
 }
@@ -306,18 +306,31 @@ typedef GRPCProtoCall * (^RPCFactory)(void);
                   }];
 }
 
+- (void)setCompressionEnabled:(BOOL)compressionEnabled {
+  _compressionEnabled = compressionEnabled;
+  // GRPC configures compression per host so this can't be narrowed to specific RPCs.
+  [GRPCCall setDefaultCompressMethod:(compressionEnabled ? GRPCCompressGzip : GRPCCompressNone)
+                             forhost:self.databaseInfo.host];
+}
+
 - (FSTWatchStream *)createWatchStream {
-  return [[FSTWatchStream alloc] initWithDatabase:_databaseInfo
-                              workerDispatchQueue:_workerDispatchQueue
-                                      credentials:_credentials
-                                       serializer:_serializer];
+  FSTWatchStream *stream = [[FSTWatchStream alloc] initWithDatabase:_databaseInfo
+                                                workerDispatchQueue:_workerDispatchQueue
+                                                        credentials:_credentials
+                                                         serializer:_serializer];
+  stream.idleTimeout = self.streamIdleTimeout;
+  stream.metricsProvider = self.metricsProvider;
+  return stream;
 }
 
 - (FSTWriteStream *)createWriteStream {
-  return [[FSTWriteStream alloc] initWithDatabase:_databaseInfo
-                              workerDispatchQueue:_workerDispatchQueue
-                                      credentials:_credentials
-                                       serializer:_serializer];
+  FSTWriteStream *stream = [[FSTWriteStream alloc] initWithDatabase:_databaseInfo
+                                                workerDispatchQueue:_workerDispatchQueue
+                                                        credentials:_credentials
+                                                         serializer:_serializer];
+  stream.idleTimeout = self.streamIdleTimeout;
+  stream.metricsProvider = self.metricsProvider;
+  return stream;
 }
 
 /** Adds headers to the RPC including any OAuth access token if provided .*/
@@ -16,16 +16,47 @@
 
 #import <Foundation/Foundation.h>
 
+@class FSTDatabaseID;
+@class FSTDocumentKey;
+
 NS_ASSUME_NONNULL_BEGIN
 
 @interface FSTExistenceFilter : NSObject
 
 + (instancetype)filterWithCount:(int32_t)count;
 
+/**
+ * Creates an existence filter that also carries a Bloom filter of the keys of the documents
+ * matching the target. The Bloom filter's parameters come from the backend; if they don't describe
+ * a valid filter, the existence filter carries only the count.
+ *
+ * @param count The number of documents matching the target.
+ * @param bitmap The bits of the Bloom filter, least significant bit first within each byte.
+ * @param padding The number of unused bits at the end of the bitmap's last byte.
+ * @param hashCount The number of bits set for each document key.
+ */
++ (instancetype)filterWithCount:(int32_t)count
+              bloomFilterBitmap:(NSData *)bitmap
+                        padding:(int32_t)padding
+                      hashCount:(int32_t)hashCount;
+
 - (instancetype)init __attribute__((unavailable("Use a static constructor")));
 
 @property(nonatomic, assign, readonly) int32_t count;
 
+/** Whether this filter carries a Bloom filter of the matching document keys. */
+@property(nonatomic, assign, readonly) BOOL hasBloomFilter;
+
+/**
+ * Returns NO if the given document definitely does not match the target, YES if it might. Always
+ * returns YES if this filter carries no Bloom filter.
+ *
+ * @param key The key of the document to check.
+ * @param databaseID The database the document lives in. The backend builds the Bloom filter over
+ *     full document names, so the key is checked as a name in this database.
+ */
+- (BOOL)mightContainKey:(FSTDocumentKey *)key inDatabase:(FSTDatabaseID *)databaseID;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -16,25 +16,78 @@
 
 #import "Firestore/Source/Remote/FSTExistenceFilter.h"
 
-@interface FSTExistenceFilter ()
+#include <memory>
+#include <utility>
+#include <vector>
 
-- (instancetype)initWithCount:(int32_t)count NS_DESIGNATED_INITIALIZER;
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+
+#import "Firestore/Source/Model/FSTDatabaseID.h"
+#import "Firestore/Source/Model/FSTDocumentKey.h"
+#import "Firestore/Source/Model/FSTPath.h"
+#import "Firestore/Source/Util/FSTLogger.h"
+
+using firebase::firestore::remote::BloomFilter;
+using firebase::firestore::util::MakeStringView;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface FSTExistenceFilter () {
+  /** The Bloom filter of matching document keys, if the backend sent one. */
+  std::unique_ptr<BloomFilter> _bloomFilter;
+}
+
+- (instancetype)initWithCount:(int32_t)count
+                  bloomFilter:(std::unique_ptr<BloomFilter>)bloomFilter NS_DESIGNATED_INITIALIZER;
 
 @end
 
 @implementation FSTExistenceFilter
 
 + (instancetype)filterWithCount:(int32_t)count {
-  return [[FSTExistenceFilter alloc] initWithCount:count];
+  return [[FSTExistenceFilter alloc] initWithCount:count bloomFilter:nullptr];
 }
 
-- (instancetype)initWithCount:(int32_t)count {
++ (instancetype)filterWithCount:(int32_t)count
+              bloomFilterBitmap:(NSData *)bitmap
+                        padding:(int32_t)padding
+                      hashCount:(int32_t)hashCount {
+  if (!BloomFilter::IsValid(bitmap.length, padding, hashCount)) {
+    // Fall back to comparing counts rather than trusting a malformed filter.
+    FSTWarn(@"Ignoring invalid Bloom filter: %lu bytes, padding %d, hash count %d",
+            (unsigned long)bitmap.length, padding, hashCount);
+    return [FSTExistenceFilter filterWithCount:count];
+  }
+  const uint8_t *bytes = static_cast<const uint8_t *>(bitmap.bytes);
+  std::vector<uint8_t> bits(bytes, bytes + bitmap.length);
+  std::unique_ptr<BloomFilter> bloomFilter(new BloomFilter(std::move(bits), padding, hashCount));
+  return [[FSTExistenceFilter alloc] initWithCount:count bloomFilter:std::move(bloomFilter)];
+}
+
+- (instancetype)initWithCount:(int32_t)count
+                  bloomFilter:(std::unique_ptr<BloomFilter>)bloomFilter {
   if (self = [super init]) {
     _count = count;
+    _bloomFilter = std::move(bloomFilter);
   }
   return self;
 }
 
+- (BOOL)hasBloomFilter {
+  return _bloomFilter != nullptr;
+}
+
+- (BOOL)mightContainKey:(FSTDocumentKey *)key inDatabase:(FSTDatabaseID *)databaseID {
+  if (!_bloomFilter) {
+    return YES;
+  }
+  NSString *name = [NSString stringWithFormat:@"projects/%@/databases/%@/documents/%@",
+                                              databaseID.projectID, databaseID.databaseID,
+                                              key.path.canonicalString];
+  return _bloomFilter->MightContain(MakeStringView(name));
+}
+
 - (BOOL)isEqual:(id)other {
   if (other == self) {
     return YES;
@@ -43,7 +96,17 @@
     return NO;
   }
 
-  return _count == ((FSTExistenceFilter *)other).count;
+  FSTExistenceFilter *otherFilter = (FSTExistenceFilter *)other;
+  if (_count != otherFilter.count || self.hasBloomFilter != otherFilter.hasBloomFilter) {
+    return NO;
+  }
+  if (!_bloomFilter) {
+    return YES;
+  }
+  const BloomFilter &otherBloomFilter = *otherFilter->_bloomFilter;
+  return _bloomFilter->bitmap() == otherBloomFilter.bitmap() &&
+         _bloomFilter->padding() == otherBloomFilter.padding() &&
+         _bloomFilter->hash_count() == otherBloomFilter.hash_count();
 }
 
 - (NSUInteger)hash {
@@ -51,3 +114,5 @@
 }
 
 @end
+
+NS_ASSUME_NONNULL_END
@@ -17,6 +17,7 @@
 #import <Foundation/Foundation.h>
 
 @class FSTDispatchQueue;
+@protocol FIRFirestoreMetricsProvider;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -74,6 +75,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)backoffAndRunBlock:(void (^)(void))block;
 
+/**
+ * Cancels the block scheduled by the last backoffAndRunBlock:, if it hasn't run yet. The backoff
+ * delay is left as is.
+ */
+- (void)cancel;
+
+/** If set, receives each delay waited by backoffAndRunBlock:. */
+@property(nonatomic, strong, nullable) id<FIRFirestoreMetricsProvider> metricsProvider;
+
 @end
 
 NS_ASSUME_NONNULL_END
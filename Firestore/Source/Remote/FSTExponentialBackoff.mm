@@ -20,6 +20,7 @@
 
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
 
+#import "FIRFirestoreMetrics.h"
 #import "Firestore/Source/Util/FSTDispatchQueue.h"
 #import "Firestore/Source/Util/FSTLogger.h"
 
@@ -36,6 +37,9 @@ using firebase::firestore::util::SecureRandom;
 @property(nonatomic) NSTimeInterval initialDelay;
 @property(nonatomic) NSTimeInterval maxDelay;
 @property(nonatomic) NSTimeInterval currentBase;
+
+/** The block scheduled by the last backoffAndRunBlock:, if any. */
+@property(nonatomic, strong, nullable) FSTDelayedCallback *timerCallback;
 @end
 
 @implementation FSTExponentialBackoff {
@@ -82,8 +86,10 @@ using firebase::firestore::util::SecureRandom;
     FSTLog(@"Backing off for %.2f seconds (base delay: %.2f seconds)", delayWithJitter,
            _currentBase);
   }
+  [self.metricsProvider recordValue:delayWithJitter
+                       forHistogram:FIRFirestoreMetricStreamBackoffDelay];
 
-  [self.dispatchQueue dispatchAfterDelay:delayWithJitter block:block];
+  self.timerCallback = [self.dispatchQueue dispatchAfterDelay:delayWithJitter block:block];
 
   // Apply backoff factor to determine next delay and ensure it is within bounds.
   _currentBase *= _backoffFactor;
@@ -95,6 +101,11 @@ using firebase::firestore::util::SecureRandom;
   }
 }
 
+- (void)cancel {
+  [self.timerCallback cancel];
+  self.timerCallback = nil;
+}
+
 /** Returns a random value in the range [-currentBase/2, currentBase/2] */
 - (NSTimeInterval)jitterDelay {
   std::uniform_real_distribution<double> dist;
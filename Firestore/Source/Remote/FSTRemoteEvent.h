@@ -167,6 +167,18 @@ eventWithSnapshotVersion:(FSTSnapshotVersion *)snapshotVersion
 /** Adds a document update to this remote event */
 - (void)addDocumentUpdate:(FSTMaybeDocument *)document;
 
+/**
+ * Updates this event to include the effects of a later event, as if both had been applied in
+ * order. The later event must not be used afterwards.
+ */
+- (void)mergeRemoteEvent:(FSTRemoteEvent *)other;
+
+/**
+ * Removes a document from the given target's mapping, e.g. because an existence filter showed
+ * that the document no longer matches the target.
+ */
+- (void)removeDocumentKey:(FSTDocumentKey *)documentKey fromTargetID:(FSTBoxedTargetID *)targetID;
+
 /** Handles an existence filter mismatch */
 - (void)handleExistenceFilterMismatchForTargetID:(FSTBoxedTargetID *)targetID;
 
@@ -190,7 +202,7 @@ initWithSnapshotVersion:(FSTSnapshotVersion *)snapshotVersion
 
 /** The number of pending responses that are being waited on from watch */
 @property(nonatomic, strong, readonly)
-    NSMutableDictionary<FSTBoxedTargetID *, NSNumber *> *pendingTargetResponses;
+    NSDictionary<FSTBoxedTargetID *, NSNumber *> *pendingTargetResponses;
 
 /** Aggregates a watch change into the current state */
 - (void)addWatchChange:(FSTWatchChange *)watchChange;
@@ -16,6 +16,8 @@
 
 #import "Firestore/Source/Remote/FSTRemoteEvent.h"
 
+#include <unordered_map>
+
 #import "Firestore/Source/Core/FSTSnapshotVersion.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTDocumentKey.h"
@@ -177,6 +179,9 @@ NS_ASSUME_NONNULL_BEGIN
 @property(nonatomic, strong, nullable) FSTTargetMapping *mapping;
 @property(nonatomic, strong) FSTSnapshotVersion *snapshotVersion;
 @property(nonatomic, strong) NSData *resumeToken;
+
+/** Updates this change to include the effects of a later change to the same target. */
+- (void)mergeTargetChange:(FSTTargetChange *)other;
 @end
 
 @implementation FSTTargetChange
@@ -223,6 +228,30 @@ NS_ASSUME_NONNULL_BEGIN
   return _mapping;
 }
 
+- (void)mergeTargetChange:(FSTTargetChange *)other {
+  FSTTargetMapping *otherMapping = other.mapping;
+  if ([otherMapping isKindOfClass:[FSTResetMapping class]]) {
+    self.mapping = otherMapping;
+  } else {
+    FSTAssert([otherMapping isKindOfClass:[FSTUpdateMapping class]],
+              @"Expected either reset or update mapping but got something else %@", otherMapping);
+    FSTUpdateMapping *update = (FSTUpdateMapping *)otherMapping;
+    FSTTargetMapping *mapping = self.mapping;
+    [update.addedDocuments enumerateObjectsUsingBlock:^(FSTDocumentKey *key, BOOL *stop) {
+      [mapping addDocumentKey:key];
+    }];
+    [update.removedDocuments enumerateObjectsUsingBlock:^(FSTDocumentKey *key, BOOL *stop) {
+      [mapping removeDocumentKey:key];
+    }];
+  }
+
+  if (other.currentStatusUpdate != FSTCurrentStatusUpdateNone) {
+    self.currentStatusUpdate = other.currentStatusUpdate;
+  }
+  self.snapshotVersion = other.snapshotVersion;
+  self.resumeToken = other.resumeToken;
+}
+
 /**
  * Sets the resume token but only when it has a new value. Empty resumeTokens are
  * discarded.
@@ -291,6 +320,31 @@ initWithSnapshotVersion:(FSTSnapshotVersion *)snapshotVersion
   _documentUpdates[document.key] = document;
 }
 
+- (void)mergeRemoteEvent:(FSTRemoteEvent *)other {
+  self.snapshotVersion = other.snapshotVersion;
+  [other.targetChanges enumerateKeysAndObjectsUsingBlock:^(FSTBoxedTargetID *targetID,
+                                                           FSTTargetChange *change, BOOL *stop) {
+    FSTTargetChange *existing = _targetChanges[targetID];
+    if (existing) {
+      [existing mergeTargetChange:change];
+    } else {
+      _targetChanges[targetID] = change;
+    }
+  }];
+  [_documentUpdates addEntriesFromDictionary:other.documentUpdates];
+}
+
+- (void)removeDocumentKey:(FSTDocumentKey *)documentKey fromTargetID:(FSTBoxedTargetID *)targetID {
+  FSTTargetChange *targetChange = _targetChanges[targetID];
+  if (!targetChange) {
+    targetChange = [FSTTargetChange changeWithMapping:[[FSTUpdateMapping alloc] init]
+                                      snapshotVersion:self.snapshotVersion
+                                  currentStatusUpdate:FSTCurrentStatusUpdateNone];
+    _targetChanges[targetID] = targetChange;
+  }
+  [targetChange.mapping removeDocumentKey:documentKey];
+}
+
 /** Handles an existence filter mismatch */
 - (void)handleExistenceFilterMismatchForTargetID:(FSTBoxedTargetID *)targetID {
   // An existence filter mismatch will reset the query and we need to reset the mapping to contain
@@ -320,10 +374,6 @@ initWithSnapshotVersion:(FSTSnapshotVersion *)snapshotVersion
 /** The snapshot version for every target change this creates. */
 @property(nonatomic, strong, readonly) FSTSnapshotVersion *snapshotVersion;
 
-/** Keeps track of the current target mappings */
-@property(nonatomic, strong, readonly)
-    NSMutableDictionary<FSTBoxedTargetID *, FSTTargetChange *> *targetChanges;
-
 /** Keeps track of document to update */
 @property(nonatomic, strong, readonly)
     NSMutableDictionary<FSTDocumentKey *, FSTMaybeDocument *> *documentUpdates;
@@ -338,7 +388,16 @@ initWithSnapshotVersion:(FSTSnapshotVersion *)snapshotVersion
 @end
 
 @implementation FSTWatchChangeAggregator {
-  NSMutableDictionary<FSTBoxedTargetID *, FSTExistenceFilter *> *_existenceFilters;
+  // The per-target state is keyed by the unboxed target ID so that looking up a target doesn't
+  // have to hash an NSNumber. Watch messages may touch hundreds of targets each.
+
+  /** Keeps track of the current target mappings */
+  std::unordered_map<FSTTargetID, FSTTargetChange *> _targetChanges;
+
+  /** The number of pending responses that are being waited on from watch, by target. */
+  std::unordered_map<FSTTargetID, int> _pendingTargetResponses;
+
+  std::unordered_map<FSTTargetID, FSTExistenceFilter *> _existenceFilters;
 }
 
 - (instancetype)
@@ -350,26 +409,40 @@ initWithSnapshotVersion:(FSTSnapshotVersion *)snapshotVersion
     _snapshotVersion = snapshotVersion;
 
     _frozen = NO;
-    _targetChanges = [NSMutableDictionary dictionary];
     _listenTargets = listenTargets;
-    _pendingTargetResponses = [NSMutableDictionary dictionaryWithDictionary:pendingTargetResponses];
+    [pendingTargetResponses enumerateKeysAndObjectsUsingBlock:^(FSTBoxedTargetID *targetID,
+                                                                NSNumber *count, BOOL *stop) {
+      _pendingTargetResponses[targetID.intValue] = count.intValue;
+    }];
 
-    _existenceFilters = [NSMutableDictionary dictionary];
     _documentUpdates = [NSMutableDictionary dictionary];
   }
   return self;
 }
 
+- (NSDictionary<FSTBoxedTargetID *, NSNumber *> *)pendingTargetResponses {
+  NSMutableDictionary<FSTBoxedTargetID *, NSNumber *> *result =
+      [NSMutableDictionary dictionaryWithCapacity:_pendingTargetResponses.size()];
+  for (const auto &entry : _pendingTargetResponses) {
+    result[@(entry.first)] = @(entry.second);
+  }
+  return result;
+}
+
 - (NSDictionary<FSTBoxedTargetID *, FSTExistenceFilter *> *)existenceFilters {
-  return static_cast<NSDictionary<FSTBoxedTargetID *, FSTExistenceFilter *> *>(_existenceFilters);
+  NSMutableDictionary<FSTBoxedTargetID *, FSTExistenceFilter *> *result =
+      [NSMutableDictionary dictionaryWithCapacity:_existenceFilters.size()];
+  for (const auto &entry : _existenceFilters) {
+    result[@(entry.first)] = entry.second;
+  }
+  return result;
 }
 
-- (FSTTargetChange *)targetChangeForTargetID:(FSTBoxedTargetID *)targetID {
-  FSTTargetChange *change = self.targetChanges[targetID];
+- (FSTTargetChange *)targetChangeForTargetID:(FSTTargetID)targetID {
+  FSTTargetChange *&change = _targetChanges[targetID];
   if (!change) {
     change = [[FSTTargetChange alloc] init];
     change.snapshotVersion = self.snapshotVersion;
-    self.targetChanges[targetID] = change;
   }
   return change;
 }
@@ -399,7 +472,7 @@ initWithSnapshotVersion:(FSTSnapshotVersion *)snapshotVersion
 
   for (FSTBoxedTargetID *targetID in docChange.updatedTargetIDs) {
     if ([self isActiveTarget:targetID]) {
-      FSTTargetChange *change = [self targetChangeForTargetID:targetID];
+      FSTTargetChange *change = [self targetChangeForTargetID:targetID.intValue];
       [change.mapping addDocumentKey:docChange.documentKey];
       relevant = YES;
     }
@@ -407,7 +480,7 @@ initWithSnapshotVersion:(FSTSnapshotVersion *)snapshotVersion
 
   for (FSTBoxedTargetID *targetID in docChange.removedTargetIDs) {
     if ([self isActiveTarget:targetID]) {
-      FSTTargetChange *change = [self targetChangeForTargetID:targetID];
+      FSTTargetChange *change = [self targetChangeForTargetID:targetID.intValue];
       [change.mapping removeDocumentKey:docChange.documentKey];
       relevant = YES;
     }
@@ -422,7 +495,7 @@ initWithSnapshotVersion:(FSTSnapshotVersion *)snapshotVersion
 
 - (void)addTargetChange:(FSTWatchTargetChange *)targetChange {
   for (FSTBoxedTargetID *targetID in targetChange.targetIDs) {
-    FSTTargetChange *change = [self targetChangeForTargetID:targetID];
+    FSTTargetChange *change = [self targetChangeForTargetID:targetID.intValue];
     switch (targetChange.state) {
       case FSTWatchTargetChangeStateNoChange:
         if ([self isActiveTarget:targetID]) {
@@ -431,21 +504,21 @@ initWithSnapshotVersion:(FSTSnapshotVersion *)snapshotVersion
         }
         break;
       case FSTWatchTargetChangeStateAdded:
-        [self recordResponseForTargetID:targetID];
-        if (![self.pendingTargetResponses objectForKey:targetID]) {
+        [self recordResponseForTargetID:targetID.intValue];
+        if (_pendingTargetResponses.find(targetID.intValue) == _pendingTargetResponses.end()) {
           // We have a freshly added target, so we need to reset any state that we had previously
           // This can happen e.g. when remove and add back a target for existence filter
           // mismatches.
           change.mapping = nil;
           change.currentStatusUpdate = FSTCurrentStatusUpdateNone;
-          [_existenceFilters removeObjectForKey:targetID];
+          _existenceFilters.erase(targetID.intValue);
         }
         change.resumeToken = targetChange.resumeToken;
         break;
       case FSTWatchTargetChangeStateRemoved:
         // We need to keep track of removed targets to we can post-filter and remove any target
         // changes.
-        [self recordResponseForTargetID:targetID];
+        [self recordResponseForTargetID:targetID.intValue];
         FSTAssert(!targetChange.cause, @"WatchChangeAggregator does not handle errored targets.");
         break;
       case FSTWatchTargetChangeStateCurrent:
@@ -472,13 +545,13 @@ initWithSnapshotVersion:(FSTSnapshotVersion *)snapshotVersion
  * Records that we got a watch target add/remove by decrementing the number of pending target
  * responses that we have.
  */
-- (void)recordResponseForTargetID:(FSTBoxedTargetID *)targetID {
-  NSNumber *count = [self.pendingTargetResponses objectForKey:targetID];
-  int newCount = count ? [count intValue] - 1 : -1;
+- (void)recordResponseForTargetID:(FSTTargetID)targetID {
+  auto found = _pendingTargetResponses.find(targetID);
+  int newCount = found != _pendingTargetResponses.end() ? found->second - 1 : -1;
   if (newCount == 0) {
-    [self.pendingTargetResponses removeObjectForKey:targetID];
+    _pendingTargetResponses.erase(found);
   } else {
-    [self.pendingTargetResponses setObject:[NSNumber numberWithInt:newCount] forKey:targetID];
+    _pendingTargetResponses[targetID] = newCount;
   }
 }
 
@@ -492,30 +565,28 @@ initWithSnapshotVersion:(FSTSnapshotVersion *)snapshotVersion
  */
 - (BOOL)isActiveTarget:(FSTBoxedTargetID *)targetID {
   return [self.listenTargets objectForKey:targetID] &&
-         ![self.pendingTargetResponses objectForKey:targetID];
+         _pendingTargetResponses.find(targetID.intValue) == _pendingTargetResponses.end();
 }
 
 - (void)addExistenceFilterChange:(FSTExistenceFilterWatchChange *)existenceFilterChange {
-  FSTBoxedTargetID *targetID = @(existenceFilterChange.targetID);
-  if ([self isActiveTarget:targetID]) {
+  FSTTargetID targetID = existenceFilterChange.targetID;
+  if ([self isActiveTarget:@(targetID)]) {
     _existenceFilters[targetID] = existenceFilterChange.filter;
   }
 }
 
 - (FSTRemoteEvent *)remoteEvent {
-  NSMutableDictionary<FSTBoxedTargetID *, FSTTargetChange *> *targetChanges = self.targetChanges;
+  NSMutableDictionary<FSTBoxedTargetID *, FSTTargetChange *> *targetChanges =
+      [NSMutableDictionary dictionaryWithCapacity:_targetChanges.size()];
 
-  NSMutableArray *targetsToRemove = [NSMutableArray array];
-
-  // Apply any inactive targets.
-  for (FSTBoxedTargetID *targetID in [targetChanges keyEnumerator]) {
-    if (![self isActiveTarget:targetID]) {
-      [targetsToRemove addObject:targetID];
+  // Drop the changes for any inactive targets.
+  for (const auto &entry : _targetChanges) {
+    FSTBoxedTargetID *targetID = @(entry.first);
+    if ([self isActiveTarget:targetID]) {
+      targetChanges[targetID] = entry.second;
     }
   }
 
-  [targetChanges removeObjectsForKeys:targetsToRemove];
-
   // Mark this aggregator as frozen so no further modifications are made.
   self.frozen = YES;
   return [FSTRemoteEvent eventWithSnapshotVersion:self.snapshotVersion
@@ -18,9 +18,11 @@
 
 #import "Firestore/Source/Core/FSTTypes.h"
 #import "Firestore/Source/Model/FSTDocumentVersionDictionary.h"
+#import "Firestore/Source/Model/FSTMemoryUsage.h"
 
 @class FSTDatabaseInfo;
 @class FSTDatastore;
+@class FSTDispatchQueue;
 @class FSTDocumentKey;
 @class FSTLocalStore;
 @class FSTMutationBatch;
@@ -61,11 +63,11 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)rejectListenWithTargetID:(FSTBoxedTargetID *)targetID error:(NSError *)error;
 
 /**
- * Applies the result of a successful write of a mutation batch to the sync engine, emitting
- * snapshots in any views that the mutation applies to, and removing the batch from the mutation
- * queue.
+ * Applies the results of successful writes of one or more mutation batches to the sync engine, in
+ * order, emitting snapshots in any views that the mutations apply to, and removing the batches
+ * from the mutation queue.
  */
-- (void)applySuccessfulWriteWithResult:(FSTMutationBatchResult *)batchResult;
+- (void)applySuccessfulWritesWithResults:(NSArray<FSTMutationBatchResult *> *)batchResults;
 
 /**
  * Rejects the batch, removing the batch from the mutation queue, recomputing the local view of
@@ -104,6 +106,49 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property(nonatomic, weak) id<FSTOnlineStateDelegate> onlineStateDelegate;
 
+/**
+ * Whether to send consecutive mutation batches together in one write request, up to the backend's
+ * limit on writes per commit. Defaults to NO.
+ */
+@property(nonatomic, assign, getter=isWriteCoalescingEnabled) BOOL writeCoalescingEnabled;
+
+/**
+ * The highest batchID ever handed to the write pipeline, or kFSTBatchIDUnknown if none. Unlike the
+ * position the pipeline resumes from, this never moves backwards when the write stream restarts, so
+ * batches with higher IDs are known never to have been sent to the backend.
+ */
+@property(nonatomic, assign, readonly) FSTBatchID highestBatchIDSeen;
+
+/**
+ * Enables coalescing of remote events while targets are catching up with the backend. Instead of
+ * raising a remote event for every consistent snapshot from the watch stream, the remote store
+ * merges consecutive snapshots and raises them as one event once none has arrived for the given
+ * interval, enough documents have changed, or every target is current.
+ *
+ * @param interval The quiet period, in seconds, after which coalesced changes are raised. Pass 0
+ *     to disable coalescing, which is the default.
+ * @param workerDispatchQueue The queue the remote store runs on.
+ */
+- (void)enableRemoteEventCoalescingWithInterval:(NSTimeInterval)interval
+                            workerDispatchQueue:(FSTDispatchQueue *)workerDispatchQueue;
+
+/**
+ * Enables batching of write acknowledgements. Instead of handing every write response to the sync
+ * engine as it arrives, the remote store collects the responses received during one turn of the
+ * worker queue and applies them together, so a burst of acknowledgements costs one local store
+ * commit and one round of snapshots. Disabled by default.
+ *
+ * @param workerDispatchQueue The queue the remote store runs on.
+ */
+- (void)enableBatchedWriteAcknowledgementsWithWorkerDispatchQueue:
+    (FSTDispatchQueue *)workerDispatchQueue;
+
+/**
+ * Applies any write acknowledgements held back for batching right away. Must be called before the
+ * mutation queue they belong to changes, e.g. when the user changes.
+ */
+- (void)flushWriteAcknowledgements;
+
 /** Starts up the remote store, creating streams, restoring state from LocalStore, etc. */
 - (void)start;
 
@@ -116,6 +161,19 @@ NS_ASSUME_NONNULL_BEGIN
 /** Re-enables the network. Only to be called as the counterpart to 'disableNetwork:'. */
 - (void)enableNetwork;
 
+/**
+ * Starts the watch and write streams if they aren't already, so that connecting and fetching
+ * credentials is done ahead of the next listen or write. Streams left unused close after their
+ * idle timeout. Does nothing while the network is disabled.
+ */
+- (void)prewarmStreams;
+
+/**
+ * Tells the FSTRemoteStore that the network has become reachable, so that streams backing off
+ * after connection failures retry right away instead of waiting out their backoff delay.
+ */
+- (void)networkDidBecomeReachable;
+
 /**
  * Tells the FSTRemoteStore that the currently authenticated user has changed.
  *
@@ -144,6 +202,24 @@ NS_ASSUME_NONNULL_BEGIN
 /** Returns a new transaction backed by this remote store. */
 - (FSTTransaction *)transaction;
 
+/**
+ * Reads the documents from the backend with a single BatchGetDocuments RPC, outside of any
+ * transaction or listen. The documents are returned in the order of the keys, with
+ * FSTDeletedDocuments for those that don't exist, and aren't applied to the local store.
+ */
+- (void)lookupDocuments:(NSArray<FSTDocumentKey *> *)keys
+             completion:(FSTVoidMaybeDocumentArrayErrorBlock)completion;
+
+/** Returns the mutation batches in the write pipeline and the approximate bytes they take up. */
+- (FSTMemoryUsage)pendingWriteMemoryUsage;
+
+/**
+ * Returns the documents received over the watch stream that haven't been raised to the sync engine
+ * yet, because the stream hasn't reached a consistent snapshot or their remote event is being
+ * coalesced, and the approximate bytes they take up.
+ */
+- (FSTMemoryUsage)queuedWatchChangeMemoryUsage;
+
 @end
 
 NS_ASSUME_NONNULL_END
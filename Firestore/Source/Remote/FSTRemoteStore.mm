@@ -18,6 +18,8 @@
 
 #include <inttypes.h>
 
+#import "FIRFirestoreMetrics.h"
+#import "Firestore/Source/Core/FSTDatabaseInfo.h"
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Core/FSTSnapshotVersion.h"
 #import "Firestore/Source/Core/FSTTransaction.h"
@@ -33,15 +35,39 @@
 #import "Firestore/Source/Remote/FSTStream.h"
 #import "Firestore/Source/Remote/FSTWatchChange.h"
 #import "Firestore/Source/Util/FSTAssert.h"
+#import "Firestore/Source/Util/FSTClasses.h"
+#import "Firestore/Source/Util/FSTDispatchQueue.h"
 #import "Firestore/Source/Util/FSTLogger.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
 /**
- * The maximum number of pending writes to allow.
- * TODO(bjornick): Negotiate this value with the backend.
+ * The number of write requests allowed in flight when the write stream starts out, and the fewest
+ * it ever allows. The write window grows past this while the backend keeps up with it.
  */
-static const int kMaxPendingWrites = 10;
+static const NSUInteger kMinPendingWrites = 10;
+
+/** The most write requests ever allowed in flight. */
+static const NSUInteger kMaxPendingWrites = 100;
+
+/**
+ * The write window grows while fewer than this many requests are estimated to be queued at the
+ * backend, and shrinks when more than kMaxQueuedWrites are.
+ */
+static const double kMinQueuedWrites = 2;
+static const double kMaxQueuedWrites = 4;
+
+/**
+ * The most mutations to send in one write request when coalescing batches. This matches the
+ * backend's limit on the number of writes in a commit.
+ */
+static const NSUInteger kMaxCoalescedMutations = 500;
+
+/**
+ * The most document updates to hold back in a coalesced remote event before raising it anyway, so
+ * that a long initial sync still surfaces results as it goes.
+ */
+static const NSUInteger kMaxCoalescedDocumentUpdates = 1000;
 
 /**
  * The FSTRemoteStore notifies an onlineStateDelegate with FSTOnlineStateFailed if we fail to
@@ -51,6 +77,110 @@ static const int kMaxPendingWrites = 10;
  */
 static const int kOnlineAttemptsBeforeFailure = 2;
 
+#pragma mark - FSTPendingWrite
+
+/** A write request in the write pipeline, holding one or more consecutive mutation batches. */
+@interface FSTPendingWrite : NSObject
+
+- (instancetype)initWithBatches:(NSArray<FSTMutationBatch *> *)batches NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@property(nonatomic, strong, readonly) NSArray<FSTMutationBatch *> *batches;
+
+/** The mutations of all the batches, in order. */
+@property(nonatomic, strong, readonly) NSArray<FSTMutation *> *mutations;
+
+/** When the request was last written to the stream, or nil if it hasn't been yet. */
+@property(nonatomic, strong, nullable) NSDate *sentTime;
+
+@end
+
+@implementation FSTPendingWrite
+
+- (instancetype)initWithBatches:(NSArray<FSTMutationBatch *> *)batches {
+  if (self = [super init]) {
+    _batches = batches;
+    if (batches.count == 1) {
+      _mutations = batches[0].mutations;
+    } else {
+      NSMutableArray<FSTMutation *> *mutations = [NSMutableArray array];
+      for (FSTMutationBatch *batch in batches) {
+        [mutations addObjectsFromArray:batch.mutations];
+      }
+      _mutations = mutations;
+    }
+  }
+  return self;
+}
+
+@end
+
+#pragma mark - FSTWriteWindow
+
+/**
+ * Sizes the write pipeline from the latency of write acknowledgements, in the manner of TCP Vegas:
+ * the lowest latency seen estimates the cost of a request that doesn't wait behind others, so
+ * comparing the window against the throughput it actually achieves estimates how many requests are
+ * queued at the backend. Once per window's worth of acknowledgements the window grows by one if
+ * few are, and shrinks by one if many are. Transient stream failures halve it.
+ */
+@interface FSTWriteWindow : NSObject
+
+/** The number of write requests currently allowed in flight. */
+@property(nonatomic, assign, readonly) NSUInteger size;
+
+- (void)recordAcknowledgementWithLatency:(NSTimeInterval)latency;
+
+- (void)recordFailure;
+
+@end
+
+@implementation FSTWriteWindow {
+  /** The lowest acknowledgement latency seen so far, or 0 before the first one. */
+  NSTimeInterval _baseLatency;
+  /** The lowest acknowledgement latency seen in the current round. */
+  NSTimeInterval _roundLatency;
+  /** The number of acknowledgements in the current round. */
+  NSUInteger _roundAcknowledgements;
+}
+
+- (instancetype)init {
+  if (self = [super init]) {
+    _size = kMinPendingWrites;
+  }
+  return self;
+}
+
+- (void)recordAcknowledgementWithLatency:(NSTimeInterval)latency {
+  if (_baseLatency == 0 || latency < _baseLatency) {
+    _baseLatency = latency;
+  }
+  if (_roundAcknowledgements == 0 || latency < _roundLatency) {
+    _roundLatency = latency;
+  }
+  if (++_roundAcknowledgements < _size) {
+    return;
+  }
+
+  if (_roundLatency > 0) {
+    double queued = _size * (1 - _baseLatency / _roundLatency);
+    if (queued < kMinQueuedWrites) {
+      _size = MIN(_size + 1, kMaxPendingWrites);
+    } else if (queued > kMaxQueuedWrites) {
+      _size = MAX(_size - 1, kMinPendingWrites);
+    }
+  }
+  _roundAcknowledgements = 0;
+}
+
+- (void)recordFailure {
+  _size = MAX(_size / 2, kMinPendingWrites);
+  _roundAcknowledgements = 0;
+}
+
+@end
+
 #pragma mark - FSTRemoteStore
 
 @interface FSTRemoteStore () <FSTWatchStreamDelegate, FSTWriteStreamDelegate>
@@ -102,6 +232,39 @@ static const int kOnlineAttemptsBeforeFailure = 2;
 
 @property(nonatomic, strong) NSMutableArray<FSTWatchChange *> *accumulatedChanges;
 @property(nonatomic, assign) FSTBatchID lastBatchSeen;
+@property(nonatomic, assign, readwrite) FSTBatchID highestBatchIDSeen;
+
+/** The quiet period after which coalesced remote events are raised, or 0 if not coalescing. */
+@property(nonatomic, assign) NSTimeInterval remoteEventCoalescingInterval;
+
+@property(nonatomic, strong, nullable) FSTDispatchQueue *workerDispatchQueue;
+
+/** Whether write acknowledgements are applied once per worker queue turn. */
+@property(nonatomic, assign) BOOL batchesWriteAcknowledgements;
+
+/**
+ * The results of acknowledged writes not yet applied to the sync engine, in order. Only used when
+ * batching write acknowledgements.
+ */
+@property(nonatomic, strong, readonly)
+    NSMutableArray<FSTMutationBatchResult *> *pendingBatchResults;
+
+/** The remote events merged since the last one raised to the sync engine, if any. */
+@property(nonatomic, strong, nullable) FSTRemoteEvent *coalescedRemoteEvent;
+
+/**
+ * The pending flush of coalescedRemoteEvent, pushed back whenever another event is coalesced so
+ * that it only runs once the watch stream has been quiet for the coalescing interval.
+ */
+@property(nonatomic, strong, nullable) FSTDelayedCallback *remoteEventCoalescingCallback;
+
+/**
+ * The targets that have been sent to watch but not yet marked current since, i.e. that are still
+ * catching up, mapped to when they were sent. Remote events are only coalesced while there are
+ * any.
+ */
+@property(nonatomic, strong, readonly)
+    NSMutableDictionary<FSTBoxedTargetID *, NSDate *> *catchingUpTargetIDs;
 
 /**
  * The online state of the watch stream. The state is set to healthy if and only if there are
@@ -131,7 +294,10 @@ static const int kOnlineAttemptsBeforeFailure = 2;
  * writeMutations, not from the point of view from the Datastore itself. In particular, these
  * requests may not have been sent to the Datastore server if the write stream is not yet running.
  */
-@property(nonatomic, strong, readonly) NSMutableArray<FSTMutationBatch *> *pendingWrites;
+@property(nonatomic, strong, readonly) NSMutableArray<FSTPendingWrite *> *pendingWrites;
+
+/** Limits the number of pendingWrites. */
+@property(nonatomic, strong, readonly) FSTWriteWindow *writeWindow;
 @end
 
 @implementation FSTRemoteStore
@@ -148,15 +314,31 @@ static const int kOnlineAttemptsBeforeFailure = 2;
     _listenTargets = [NSMutableDictionary dictionary];
     _pendingTargetResponses = [NSMutableDictionary dictionary];
     _accumulatedChanges = [NSMutableArray array];
+    _catchingUpTargetIDs = [NSMutableDictionary dictionary];
 
     _lastBatchSeen = kFSTBatchIDUnknown;
+    _highestBatchIDSeen = kFSTBatchIDUnknown;
     _watchStreamOnlineState = FSTOnlineStateUnknown;
     _shouldWarnOffline = YES;
     _pendingWrites = [NSMutableArray array];
+    _writeWindow = [[FSTWriteWindow alloc] init];
+    _pendingBatchResults = [NSMutableArray array];
   }
   return self;
 }
 
+- (void)enableRemoteEventCoalescingWithInterval:(NSTimeInterval)interval
+                            workerDispatchQueue:(FSTDispatchQueue *)workerDispatchQueue {
+  self.remoteEventCoalescingInterval = interval;
+  self.workerDispatchQueue = workerDispatchQueue;
+}
+
+- (void)enableBatchedWriteAcknowledgementsWithWorkerDispatchQueue:
+    (FSTDispatchQueue *)workerDispatchQueue {
+  self.batchesWriteAcknowledgements = YES;
+  self.workerDispatchQueue = workerDispatchQueue;
+}
+
 - (void)start {
   // For now, all setup is handled by enableNetwork(). We might expand on this in the future.
   [self enableNetwork];
@@ -253,11 +435,38 @@ static const int kOnlineAttemptsBeforeFailure = 2;
     [self cleanUpWatchStreamState];
     [self cleanUpWriteStreamState];
 
+    // The backend has committed these writes regardless of what happens to the stream.
+    [self flushWriteAcknowledgements];
+
     self.writeStream = nil;
     self.watchStream = nil;
   }
 }
 
+- (void)prewarmStreams {
+  if (![self isNetworkEnabled]) {
+    return;
+  }
+
+  // Streams opened without targets or writes to send mark themselves idle once they're ready.
+  if (![self.watchStream isStarted]) {
+    [self.watchStream startWithDelegate:self];
+  }
+  if (![self.writeStream isStarted]) {
+    [self.writeStream startWithDelegate:self];
+  }
+}
+
+- (void)networkDidBecomeReachable {
+  if (![self isNetworkEnabled]) {
+    return;
+  }
+
+  FSTLog(@"FSTRemoteStore %p network became reachable", (__bridge void *)self);
+  [self.watchStream skipBackoff];
+  [self.writeStream skipBackoff];
+}
+
 #pragma mark Shutdown
 
 - (void)shutdown {
@@ -304,6 +513,7 @@ static const int kOnlineAttemptsBeforeFailure = 2;
 
 - (void)sendWatchRequestWithQueryData:(FSTQueryData *)queryData {
   [self recordPendingRequestForTargetID:@(queryData.targetID)];
+  self.catchingUpTargetIDs[@(queryData.targetID)] = [NSDate date];
   [self.watchStream watchQuery:queryData];
 }
 
@@ -323,6 +533,7 @@ static const int kOnlineAttemptsBeforeFailure = 2;
 
 - (void)sendUnwatchRequestForTargetID:(FSTBoxedTargetID *)targetID {
   [self recordPendingRequestForTargetID:targetID];
+  [self.catchingUpTargetIDs removeObjectForKey:targetID];
   [self.watchStream unwatchTargetID:[targetID intValue]];
 }
 
@@ -341,6 +552,11 @@ static const int kOnlineAttemptsBeforeFailure = 2;
 }
 
 - (void)cleanUpWatchStreamState {
+  // Any coalesced events are complete snapshots whose resume tokens have already been recorded in
+  // listenTargets, so they must be raised rather than dropped.
+  [self raiseCoalescedRemoteEvent];
+  [self.catchingUpTargetIDs removeAllObjects];
+
   // If the connection is closed then we'll never get a snapshot version for the accumulated
   // changes and so we'll never be able to complete the batch. When we start up again the server
   // is going to resend these changes anyway, so just toss the accumulated state.
@@ -353,6 +569,9 @@ static const int kOnlineAttemptsBeforeFailure = 2;
   for (FSTQueryData *queryData in [self.listenTargets objectEnumerator]) {
     [self sendWatchRequestWithQueryData:queryData];
   }
+  if (self.listenTargets.count == 0) {
+    [self.watchStream markIdle];
+  }
 }
 
 - (void)watchStreamDidChange:(FSTWatchChange *)change
@@ -363,6 +582,18 @@ static const int kOnlineAttemptsBeforeFailure = 2;
   FSTWatchTargetChange *watchTargetChange =
       [change isKindOfClass:[FSTWatchTargetChange class]] ? (FSTWatchTargetChange *)change : nil;
 
+  if (watchTargetChange && watchTargetChange.state == FSTWatchTargetChangeStateCurrent) {
+    id<FIRFirestoreMetricsProvider> metricsProvider = self.datastore.metricsProvider;
+    for (FSTBoxedTargetID *targetID in watchTargetChange.targetIDs) {
+      NSDate *watchTime = self.catchingUpTargetIDs[targetID];
+      if (watchTime) {
+        [metricsProvider recordValue:-[watchTime timeIntervalSinceNow]
+                        forHistogram:FIRFirestoreMetricTargetSyncLatency];
+        [self.catchingUpTargetIDs removeObjectForKey:targetID];
+      }
+    }
+  }
+
   if (watchTargetChange && watchTargetChange.state == FSTWatchTargetChangeStateRemoved &&
       watchTargetChange.cause) {
     // There was an error on a target, don't wait for a consistent snapshot to raise events
@@ -420,10 +651,17 @@ static const int kOnlineAttemptsBeforeFailure = 2;
   [self.pendingTargetResponses removeAllObjects];
   [self.pendingTargetResponses setDictionary:aggregator.pendingTargetResponses];
 
+  // Existence filters are checked against the documents the local store has for each target, so
+  // bring it up to date first.
+  NSDictionary<FSTBoxedTargetID *, FSTExistenceFilter *> *existenceFilters =
+      aggregator.existenceFilters;
+  if (existenceFilters.count > 0) {
+    [self raiseCoalescedRemoteEvent];
+  }
+
   // Handle existence filters and existence filter mismatches
-  [aggregator.existenceFilters enumerateKeysAndObjectsUsingBlock:^(FSTBoxedTargetID *target,
-                                                                   FSTExistenceFilter *filter,
-                                                                   BOOL *stop) {
+  [existenceFilters enumerateKeysAndObjectsUsingBlock:^(FSTBoxedTargetID *target,
+                                                         FSTExistenceFilter *filter, BOOL *stop) {
     FSTTargetID targetID = target.intValue;
 
     FSTQueryData *queryData = self.listenTargets[target];
@@ -463,6 +701,21 @@ static const int kOnlineAttemptsBeforeFailure = 2;
         }
       }
 
+      if (trackedRemote.count != (NSUInteger)filter.count && filter.hasBloomFilter) {
+        // The Bloom filter tells us which of the tracked documents no longer match the target.
+        // Drop just those and let limbo resolution confirm their deletion; only re-run the whole
+        // query if that doesn't account for the mismatch.
+        FSTDatabaseID *databaseID = self.datastore.databaseInfo.databaseID;
+        __block FSTDocumentKeySet *remaining = trackedRemote;
+        [trackedRemote enumerateObjectsUsingBlock:^(FSTDocumentKey *key, BOOL *stop) {
+          if (![filter mightContainKey:key inDatabase:databaseID]) {
+            [remoteEvent removeDocumentKey:key fromTargetID:target];
+            remaining = [remaining setByRemovingObject:key];
+          }
+        }];
+        trackedRemote = remaining;
+      }
+
       if (trackedRemote.count != (NSUInteger)filter.count) {
         FSTLog(@"Existence filter mismatch, resetting mapping");
 
@@ -511,11 +764,62 @@ static const int kOnlineAttemptsBeforeFailure = 2;
   }];
 
   // Finally handle remote event
-  [self.syncEngine applyRemoteEvent:remoteEvent];
+  [self raiseRemoteEvent:remoteEvent];
+}
+
+/**
+ * Raises the remote event to the sync engine or, while coalescing, merges it with the events
+ * held back so far.
+ */
+- (void)raiseRemoteEvent:(FSTRemoteEvent *)remoteEvent {
+  if (self.remoteEventCoalescingInterval <= 0) {
+    [self.syncEngine applyRemoteEvent:remoteEvent];
+    return;
+  }
+
+  if (self.coalescedRemoteEvent) {
+    [self.coalescedRemoteEvent mergeRemoteEvent:remoteEvent];
+  } else {
+    self.coalescedRemoteEvent = remoteEvent;
+  }
+
+  if (self.catchingUpTargetIDs.count == 0 ||
+      self.coalescedRemoteEvent.documentUpdates.count >= kMaxCoalescedDocumentUpdates) {
+    [self raiseCoalescedRemoteEvent];
+    return;
+  }
+
+  // Wait until the watch stream has been quiet for the coalescing interval.
+  if (self.remoteEventCoalescingCallback.isPending) {
+    [self.remoteEventCoalescingCallback rescheduleAfterDelay:self.remoteEventCoalescingInterval];
+  } else {
+    FSTWeakify(self);
+    self.remoteEventCoalescingCallback =
+        [self.workerDispatchQueue dispatchAfterDelay:self.remoteEventCoalescingInterval
+                                               block:^{
+                                                 FSTStrongify(self);
+                                                 [self raiseCoalescedRemoteEvent];
+                                               }];
+  }
+}
+
+/** Raises the coalesced remote event, if any, to the sync engine. */
+- (void)raiseCoalescedRemoteEvent {
+  [self.remoteEventCoalescingCallback cancel];
+  self.remoteEventCoalescingCallback = nil;
+
+  FSTRemoteEvent *remoteEvent = self.coalescedRemoteEvent;
+  if (remoteEvent) {
+    self.coalescedRemoteEvent = nil;
+    [self.syncEngine applyRemoteEvent:remoteEvent];
+  }
 }
 
 /** Process a target error and passes the error along to SyncEngine. */
 - (void)processTargetErrorForWatchChange:(FSTWatchTargetChange *)change {
+  // Raise what came before the error first, so the sync engine sees events in order.
+  [self raiseCoalescedRemoteEvent];
+
   FSTAssert(change.cause, @"Handling target error without a cause");
   // Ignore targets that have been removed already.
   for (FSTBoxedTargetID *targetID in change.targetIDs) {
@@ -552,12 +856,30 @@ static const int kOnlineAttemptsBeforeFailure = 2;
 
 - (void)fillWritePipeline {
   if ([self isNetworkEnabled]) {
+    FSTMutationBatch *_Nullable batch = nil;
     while ([self canWriteMutations]) {
-      FSTMutationBatch *batch = [self.localStore nextMutationBatchAfterBatchID:self.lastBatchSeen];
       if (!batch) {
-        break;
+        batch = [self.localStore nextMutationBatchAfterBatchID:self.lastBatchSeen];
+        if (!batch) {
+          break;
+        }
       }
-      [self commitBatch:batch];
+
+      NSMutableArray<FSTMutationBatch *> *batches = [NSMutableArray arrayWithObject:batch];
+      NSUInteger mutationCount = batch.mutations.count;
+      batch = nil;
+      if (self.writeCoalescingEnabled) {
+        // Keep the first batch that doesn't fit for the next request.
+        while ((batch = [self.localStore
+                    nextMutationBatchAfterBatchID:batches.lastObject.batchID])) {
+          if (mutationCount + batch.mutations.count > kMaxCoalescedMutations) {
+            break;
+          }
+          [batches addObject:batch];
+          mutationCount += batch.mutations.count;
+        }
+      }
+      [self commitBatches:batches];
     }
 
     if ([self.pendingWrites count] == 0) {
@@ -572,28 +894,36 @@ static const int kOnlineAttemptsBeforeFailure = 2;
  * When sending mutations to the write stream (e.g. in -fillWritePipeline), call this method first
  * to check if more mutations can be sent.
  *
- * Currently the only thing that can prevent the backend from accepting write requests is if
- * there are too many requests already outstanding. As writes complete the backend will be able
- * to accept more.
+ * Write requests aren't accepted if there are too many requests already outstanding, or if the
+ * write stream can't send requests as fast as they're written into it. As writes complete and the
+ * stream drains the backend will be able to accept more.
  */
 - (BOOL)canWriteMutations {
-  return [self isNetworkEnabled] && self.pendingWrites.count < kMaxPendingWrites;
+  return [self isNetworkEnabled] && self.pendingWrites.count < self.writeWindow.size &&
+         ![self.writeStream isWriteBufferFull];
 }
 
-/** Given mutations to commit, actually commits them to the backend. */
-- (void)commitBatch:(FSTMutationBatch *)batch {
-  FSTAssert([self canWriteMutations], @"commitBatch called when mutations can't be written");
-  self.lastBatchSeen = batch.batchID;
+/** Given consecutive batches to commit, actually commits them to the backend in one request. */
+- (void)commitBatches:(NSArray<FSTMutationBatch *> *)batches {
+  FSTAssert([self canWriteMutations], @"commitBatches called when mutations can't be written");
+  self.lastBatchSeen = batches.lastObject.batchID;
+  self.highestBatchIDSeen = MAX(self.highestBatchIDSeen, self.lastBatchSeen);
 
-  [self.pendingWrites addObject:batch];
+  FSTPendingWrite *write = [[FSTPendingWrite alloc] initWithBatches:batches];
+  [self.pendingWrites addObject:write];
 
   if ([self shouldStartWriteStream]) {
     [self startWriteStream];
   } else if ([self isNetworkEnabled] && self.writeStream.handshakeComplete) {
-    [self.writeStream writeMutations:batch.mutations];
+    [self sendWrite:write];
   }
 }
 
+- (void)sendWrite:(FSTPendingWrite *)write {
+  write.sentTime = [NSDate date];
+  [self.writeStream writeMutations:write.mutations];
+}
+
 - (void)writeStreamDidOpen {
   self.writeStreamOpenTime = [NSDate date];
 
@@ -618,8 +948,11 @@ static const int kOnlineAttemptsBeforeFailure = 2;
   // since writes can't be added to the pendingWrites array when canWriteMutations is NO. If the
   // limits imposed by canWriteMutations actually protect us from DOSing ourselves then those limits
   // won't be exceeded here and we'll continue to make progress.
-  for (FSTMutationBatch *write in self.pendingWrites) {
-    [self.writeStream writeMutations:write.mutations];
+  for (FSTPendingWrite *write in self.pendingWrites) {
+    [self sendWrite:write];
+  }
+  if (self.pendingWrites.count == 0) {
+    [self.writeStream markIdle];
   }
 }
 
@@ -628,21 +961,64 @@ static const int kOnlineAttemptsBeforeFailure = 2;
                                  mutationResults:(NSArray<FSTMutationResult *> *)results {
   // This is a response to a write containing mutations and should be correlated to the first
   // pending write.
-  NSMutableArray *pendingWrites = self.pendingWrites;
-  FSTMutationBatch *batch = pendingWrites[0];
+  NSMutableArray<FSTPendingWrite *> *pendingWrites = self.pendingWrites;
+  FSTPendingWrite *write = pendingWrites[0];
   [pendingWrites removeObjectAtIndex:0];
 
-  FSTMutationBatchResult *batchResult =
-      [FSTMutationBatchResult resultWithBatch:batch
-                                commitVersion:commitVersion
-                              mutationResults:results
-                                  streamToken:self.writeStream.lastStreamToken];
-  [self.syncEngine applySuccessfulWriteWithResult:batchResult];
+  if (write.sentTime) {
+    [self.writeWindow recordAcknowledgementWithLatency:-[write.sentTime timeIntervalSinceNow]];
+  }
+
+  // A coalesced request gets one result per mutation of all its batches, in order.
+  FSTAssert(results.count == write.mutations.count,
+            @"Write response has %lu results for %lu mutations", (unsigned long)results.count,
+            (unsigned long)write.mutations.count);
+  NSMutableArray<FSTMutationBatchResult *> *batchResults =
+      [NSMutableArray arrayWithCapacity:write.batches.count];
+  NSUInteger offset = 0;
+  for (FSTMutationBatch *batch in write.batches) {
+    NSRange range = NSMakeRange(offset, batch.mutations.count);
+    offset += range.length;
+    [batchResults addObject:[FSTMutationBatchResult
+                                resultWithBatch:batch
+                                  commitVersion:commitVersion
+                                mutationResults:[results subarrayWithRange:range]
+                                    streamToken:self.writeStream.lastStreamToken]];
+  }
+
+  if (self.batchesWriteAcknowledgements) {
+    // Responses that arrive back to back are all delivered before the block below runs.
+    BOOL flushScheduled = self.pendingBatchResults.count > 0;
+    [self.pendingBatchResults addObjectsFromArray:batchResults];
+    if (!flushScheduled) {
+      FSTWeakify(self);
+      [self.workerDispatchQueue dispatchAsyncAllowingSameQueue:^{
+        FSTStrongify(self);
+        [self flushWriteAcknowledgements];
+      }];
+    }
+  } else {
+    [self.syncEngine applySuccessfulWritesWithResults:batchResults];
+  }
 
   // It's possible that with the completion of this mutation another slot has freed up.
   [self fillWritePipeline];
 }
 
+- (void)flushWriteAcknowledgements {
+  if (self.pendingBatchResults.count == 0) {
+    return;
+  }
+  NSArray<FSTMutationBatchResult *> *batchResults = [self.pendingBatchResults copy];
+  [self.pendingBatchResults removeAllObjects];
+  [self.syncEngine applySuccessfulWritesWithResults:batchResults];
+}
+
+/** Handles the write stream catching up with the requests written into it. */
+- (void)writeStreamDidDrain {
+  [self fillWritePipeline];
+}
+
 /**
  * Handles the closing of the StreamingWrite RPC, either because of an error or because the RPC
  * has been terminated by the client or the server.
@@ -651,9 +1027,23 @@ static const int kOnlineAttemptsBeforeFailure = 2;
   FSTAssert([self isNetworkEnabled],
             @"writeStreamDidClose: should only be called when the network is enabled");
 
+  // Apply what was acknowledged before the error first, so the sync engine sees results in order.
+  [self flushWriteAcknowledgements];
+
+  // Responses to writes sent on this stream may have been lost, and resuming the stream could
+  // deliver results for writes we're about to send again. Only resume streams that have nothing
+  // in flight.
+  if (self.writeStream.handshakeComplete && self.pendingWrites.count > 0) {
+    self.writeStream.lastStreamID = nil;
+  }
+
   // If the write stream closed due to an error, invoke the error callbacks if there are pending
   // writes.
   if (error != nil && self.pendingWrites.count > 0) {
+    if (![FSTDatastore isPermanentWriteError:error]) {
+      // The backend or the connection may be overloaded, so back off on the pipelining as well.
+      [self.writeWindow recordFailure];
+    }
     if (self.writeStream.handshakeComplete) {
       // This error affects the actual writes.
       [self handleWriteError:error];
@@ -678,6 +1068,7 @@ static const int kOnlineAttemptsBeforeFailure = 2;
     FSTLog(@"FSTRemoteStore %p error before completed handshake; resetting stream token %@: %@",
            (__bridge void *)self, token, error);
     self.writeStream.lastStreamToken = nil;
+    self.writeStream.lastStreamID = nil;
     [self.localStore setLastStreamToken:nil];
   }
 }
@@ -690,14 +1081,27 @@ static const int kOnlineAttemptsBeforeFailure = 2;
 
   // If this was a permanent error, the request itself was the problem so it's not going to
   // succeed if we resend it.
-  FSTMutationBatch *batch = self.pendingWrites[0];
+  FSTPendingWrite *write = self.pendingWrites[0];
   [self.pendingWrites removeObjectAtIndex:0];
 
   // In this case it's also unlikely that the server itself is melting down--this was just a
   // bad request so inhibit backoff on the next restart.
   [self.writeStream inhibitBackoff];
 
-  [self.syncEngine rejectFailedWriteWithBatchID:batch.batchID error:error];
+  if (write.batches.count > 1) {
+    // Any one of the coalesced batches may be the problem; resend them one by one so that only
+    // that batch gets rejected.
+    NSMutableArray<FSTPendingWrite *> *splitWrites = [NSMutableArray array];
+    for (FSTMutationBatch *batch in write.batches) {
+      [splitWrites addObject:[[FSTPendingWrite alloc] initWithBatches:@[ batch ]]];
+    }
+    [self.pendingWrites
+        insertObjects:splitWrites
+            atIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, splitWrites.count)]];
+    return;
+  }
+
+  [self.syncEngine rejectFailedWriteWithBatchID:write.batches[0].batchID error:error];
 
   // It's possible that with the completion of this mutation another slot has freed up.
   [self fillWritePipeline];
@@ -707,6 +1111,42 @@ static const int kOnlineAttemptsBeforeFailure = 2;
   return [FSTTransaction transactionWithDatastore:self.datastore];
 }
 
+- (void)lookupDocuments:(NSArray<FSTDocumentKey *> *)keys
+             completion:(FSTVoidMaybeDocumentArrayErrorBlock)completion {
+  [self.datastore lookupDocuments:keys completion:completion];
+}
+
+#pragma mark Diagnostics
+
+- (FSTMemoryUsage)pendingWriteMemoryUsage {
+  FSTMemoryUsage usage{0, 0};
+  for (FSTPendingWrite *write in self.pendingWrites) {
+    for (FSTMutationBatch *batch in write.batches) {
+      usage.objects += 1;
+      usage.bytes += FSTApproximateMutationBatchBytes(batch);
+    }
+  }
+  return usage;
+}
+
+- (FSTMemoryUsage)queuedWatchChangeMemoryUsage {
+  FSTMemoryUsage usage{0, 0};
+  for (FSTWatchChange *change in self.accumulatedChanges) {
+    if ([change isKindOfClass:[FSTDocumentWatchChange class]]) {
+      FSTMaybeDocument *_Nullable document = ((FSTDocumentWatchChange *)change).document;
+      if (document) {
+        usage.objects += 1;
+        usage.bytes += FSTApproximateDocumentBytes(document);
+      }
+    }
+  }
+  for (FSTMaybeDocument *document in self.coalescedRemoteEvent.documentUpdates.objectEnumerator) {
+    usage.objects += 1;
+    usage.bytes += FSTApproximateDocumentBytes(document);
+  }
+  return usage;
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -74,6 +74,11 @@ NS_ASSUME_NONNULL_BEGIN
 - (GCFSValue *)encodedFieldValue:(FSTFieldValue *)fieldValue;
 - (FSTFieldValue *)decodedFieldValue:(GCFSValue *)valueProto;
 
+/**
+ * Encodes a mutation. The encoding is cached on the mutation, and decodedMutation: caches the proto
+ * it was given, so a mutation written to the local queue is sent on the write stream without
+ * being encoded again. The returned proto may be shared and must not be modified.
+ */
 - (GCFSWrite *)encodedMutation:(FSTMutation *)mutation;
 - (FSTMutation *)decodedMutation:(GCFSWrite *)mutation;
 
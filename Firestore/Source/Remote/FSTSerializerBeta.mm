@@ -19,6 +19,7 @@
 #include <inttypes.h>
 
 #import <GRPCClient/GRPCCall.h>
+#import <objc/runtime.h>
 
 #import "Firestore/Protos/objc/google/firestore/v1beta1/Common.pbobjc.h"
 #import "Firestore/Protos/objc/google/firestore/v1beta1/Document.pbobjc.h"
@@ -47,16 +48,51 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@interface FSTSerializerBeta ()
+@interface FSTSerializerBeta () {
+  // The encoded name of databaseID, "projects/<project>/databases/<database>".
+  NSString *_encodedDatabaseID;
+  // The names of documents in databaseID start with this, followed by a slash and the path.
+  NSString *_encodedDocumentsPrefix;
+}
 @property(nonatomic, strong, readonly) FSTDatabaseID *databaseID;
 @end
 
+/**
+ * The GCFSWrite encoding of an FSTMutation, attached to the mutation so that it is encoded only
+ * once even though it's written both to the local mutation queue and to the write stream.
+ */
+@interface FSTEncodedMutation : NSObject
+- (instancetype)initWithDatabaseID:(FSTDatabaseID *)databaseID
+                             proto:(GCFSWrite *)proto NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+@property(nonatomic, strong, readonly) FSTDatabaseID *databaseID;
+@property(nonatomic, strong, readonly) GCFSWrite *proto;
+@end
+
+@implementation FSTEncodedMutation
+
+- (instancetype)initWithDatabaseID:(FSTDatabaseID *)databaseID proto:(GCFSWrite *)proto {
+  if (self = [super init]) {
+    _databaseID = databaseID;
+    _proto = proto;
+  }
+  return self;
+}
+
+@end
+
+/** The associated object key for a mutation's FSTEncodedMutation. */
+static const char kEncodedMutationKey = 0;
+
 @implementation FSTSerializerBeta
 
 - (instancetype)initWithDatabaseID:(FSTDatabaseID *)databaseID {
   self = [super init];
   if (self) {
     _databaseID = databaseID;
+    _encodedDatabaseID = [[self encodedResourcePathForDatabaseID:databaseID] canonicalString];
+    _encodedDocumentsPrefix = [_encodedDatabaseID stringByAppendingString:@"/documents"];
   }
   return self;
 }
@@ -102,6 +138,11 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (FSTDocumentKey *)decodedDocumentKey:(NSString *)name {
+  FSTResourcePath *_Nullable localPath = [self localResourcePathForName:name];
+  if (localPath) {
+    return [FSTDocumentKey keyWithPath:localPath];
+  }
+
   FSTResourcePath *path = [self decodedResourcePathWithDatabaseID:name];
   FSTAssert([[path segmentAtIndex:1] isEqualToString:self.databaseID.projectID],
             @"Tried to deserialize key from different project.");
@@ -112,8 +153,30 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (NSString *)encodedResourcePathForDatabaseID:(FSTDatabaseID *)databaseID
                                           path:(FSTResourcePath *)path {
-  return [[[[self encodedResourcePathForDatabaseID:databaseID] pathByAppendingSegment:@"documents"]
-      pathByAppendingPath:path] canonicalString];
+  NSString *prefix = databaseID == self.databaseID || [databaseID isEqual:self.databaseID]
+                         ? _encodedDocumentsPrefix
+                         : [[[self encodedResourcePathForDatabaseID:databaseID]
+                               pathByAppendingSegment:@"documents"] canonicalString];
+  NSMutableString *result = [NSMutableString stringWithString:prefix];
+  for (int i = 0; i < path.length; i++) {
+    [result appendString:@"/"];
+    [result appendString:path[i]];
+  }
+  return result;
+}
+
+/**
+ * Returns the path of the document or collection with the given name if the name is in this
+ * serializer's database, skipping the encoded database prefix without splitting it into segments.
+ * Returns nil otherwise, including for the name of the database itself.
+ */
+- (nullable FSTResourcePath *)localResourcePathForName:(NSString *)name {
+  NSUInteger prefixLength = _encodedDocumentsPrefix.length;
+  if (name.length <= prefixLength + 1 || [name characterAtIndex:prefixLength] != '/' ||
+      ![name hasPrefix:_encodedDocumentsPrefix]) {
+    return nil;
+  }
+  return [FSTResourcePath pathWithString:[name substringFromIndex:prefixLength + 1]];
 }
 
 - (FSTResourcePath *)decodedResourcePathWithDatabaseID:(NSString *)name {
@@ -131,6 +194,13 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (FSTResourcePath *)decodedQueryPath:(NSString *)name {
+  FSTResourcePath *_Nullable localPath = [self localResourcePathForName:name];
+  if (localPath) {
+    return localPath;
+  } else if ([name isEqualToString:_encodedDatabaseID]) {
+    return [FSTResourcePath pathWithSegments:@[]];
+  }
+
   FSTResourcePath *resource = [self decodedResourcePathWithDatabaseID:name];
   if (resource.length == 4) {
     return [FSTResourcePath pathWithSegments:@[]];
@@ -157,7 +227,7 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (NSString *)encodedDatabaseID {
-  return [[self encodedResourcePathForDatabaseID:self.databaseID] canonicalString];
+  return _encodedDatabaseID;
 }
 
 #pragma mark - FSTFieldValue <=> Value proto
@@ -303,6 +373,12 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (FSTReferenceValue *)decodedReferenceValue:(NSString *)resourceName {
+  FSTResourcePath *_Nullable localPath = [self localResourcePathForName:resourceName];
+  if (localPath) {
+    return [FSTReferenceValue referenceValue:[FSTDocumentKey keyWithPath:localPath]
+                                  databaseID:self.databaseID];
+  }
+
   FSTResourcePath *path = [self decodedResourcePathWithDatabaseID:resourceName];
   NSString *project = [path segmentAtIndex:1];
   NSString *database = [path segmentAtIndex:3];
@@ -416,6 +492,31 @@ NS_ASSUME_NONNULL_BEGIN
 #pragma mark - FSTMutation => GCFSWrite proto
 
 - (GCFSWrite *)encodedMutation:(FSTMutation *)mutation {
+  FSTEncodedMutation *encoded = objc_getAssociatedObject(mutation, &kEncodedMutationKey);
+  if (encoded && [encoded.databaseID isEqual:self.databaseID]) {
+    return encoded.proto;
+  }
+
+  GCFSWrite *proto = [self encodedMutationWithoutCache:mutation];
+  [self cacheEncodedMutation:proto forMutation:mutation];
+  return proto;
+}
+
+- (FSTMutation *)decodedMutation:(GCFSWrite *)mutation {
+  FSTMutation *result = [self decodedMutationWithoutCache:mutation];
+  // The proto is exactly what encodedMutation: would produce, so it can be sent as is.
+  [self cacheEncodedMutation:mutation forMutation:result];
+  return result;
+}
+
+- (void)cacheEncodedMutation:(GCFSWrite *)proto forMutation:(FSTMutation *)mutation {
+  FSTEncodedMutation *encoded =
+      [[FSTEncodedMutation alloc] initWithDatabaseID:self.databaseID proto:proto];
+  objc_setAssociatedObject(mutation, &kEncodedMutationKey, encoded,
+                           OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
+- (GCFSWrite *)encodedMutationWithoutCache:(FSTMutation *)mutation {
   GCFSWrite *proto = [GCFSWrite message];
 
   Class mutationClass = [mutation class];
@@ -454,7 +555,7 @@ NS_ASSUME_NONNULL_BEGIN
   return proto;
 }
 
-- (FSTMutation *)decodedMutation:(GCFSWrite *)mutation {
+- (FSTMutation *)decodedMutationWithoutCache:(GCFSWrite *)mutation {
   FSTPrecondition *precondition = [mutation hasCurrentDocument]
                                       ? [self decodedPrecondition:mutation.currentDocument]
                                       : [FSTPrecondition none];
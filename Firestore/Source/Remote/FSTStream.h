@@ -32,12 +32,16 @@
 @class GRPCCall;
 @class GRXWriter;
 
+@protocol FIRFirestoreMetricsProvider;
 @protocol FSTCredentialsProvider;
 @protocol FSTWatchStreamDelegate;
 @protocol FSTWriteStreamDelegate;
 
 NS_ASSUME_NONNULL_BEGIN
 
+/** The default time in seconds a stream stays open after it is marked idle. */
+extern const NSTimeInterval kFSTStreamDefaultIdleTimeout;
+
 /**
  * An FSTStream is an abstract base class that represents a restartable streaming RPC to the
  * Firestore backend. It's built on top of GRPC's own support for streaming RPCs, and adds several
@@ -73,6 +77,9 @@ NS_ASSUME_NONNULL_BEGIN
  *   - `notifyStreamOpen`, should call through to the stream-specific streamDidOpen method.
  *   - `notifyStreamInterrupted`, calls through to the stream-specific streamWasInterrupted method.
  *
+ * Subclasses may also implement `decodedMessage:` to deserialize responses on the stream's decode
+ * queue, in which case `handleStreamMessage` receives its result instead of the proto.
+ *
  * Additionally, beyond these required methods, subclasses will want to implement methods that
  * take request models, serialize them, and write them to using writeRequest:. Implementation
  * specific cleanup logic can be added to tearDown:.
@@ -115,6 +122,12 @@ NS_ASSUME_NONNULL_BEGIN
 /** Returns YES if the underlying RPC is open and the stream is ready for outbound requests. */
 - (BOOL)isOpen;
 
+/**
+ * Returns YES if requests are being written faster than the RPC can send them. Senders that can
+ * hold off should do so until the stream reports that it has drained.
+ */
+- (BOOL)isWriteBufferFull;
+
 /**
  * Starts the RPC. Only allowed if isStarted returns NO. The stream is not immediately ready for
  * use: the delegate's watchStreamDidOpen method will be invoked when the RPC is ready for outbound
@@ -141,11 +154,14 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)stop;
 
 /**
- * Initializes the idle timer. If no write takes place within one minute, the GRPC stream will be
+ * Initializes the idle timer. If no write takes place within idleTimeout, the GRPC stream will be
  * closed.
  */
 - (void)markIdle;
 
+/** The time in seconds the stream stays open after it is marked idle. */
+@property(nonatomic, assign) NSTimeInterval idleTimeout;
+
 /**
  * After an error the stream will usually back off on the next attempt to start it. If the error
  * warrants an immediate restart of the stream, the sender can use this to indicate that the
@@ -156,6 +172,19 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)inhibitBackoff;
 
+/**
+ * If the stream is waiting out its backoff delay after an error, cancels the wait and restarts the
+ * stream right away, e.g. because the network has become reachable again. In any case the backoff
+ * delay is reset, so the next attempt after an error is also made without delay.
+ */
+- (void)skipBackoff;
+
+/**
+ * If set, receives the traffic on this stream, the time it takes to open it and the delays spent
+ * backing off between attempts.
+ */
+@property(nonatomic, strong, nullable) id<FIRFirestoreMetricsProvider> metricsProvider;
+
 @end
 
 #pragma mark - FSTWatchStream
@@ -251,6 +280,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)writeStreamWasInterruptedWithError:(nullable NSError *)error;
 
+/**
+ * Called by the FSTWriteStream once it has sent enough of the requests written into it that
+ * -isWriteBufferFull no longer returns YES.
+ */
+- (void)writeStreamDidDrain;
+
 @end
 
 /**
@@ -308,6 +343,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nonatomic, strong, nullable) NSData *lastStreamToken;
 
+/**
+ * The ID the server assigned to the last write stream. When set along with lastStreamToken, the
+ * next handshake resumes that stream rather than creating a new one.
+ *
+ * FSTWriteStream captures this from the handshake response. Clear it to force the next handshake
+ * to create a new stream, e.g. when responses to writes sent on the old stream may have been lost.
+ */
+@property(nonatomic, copy, nullable) NSString *lastStreamID;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -20,6 +20,7 @@
 #import <GRPCClient/GRPCCall.h>
 
 #import "FIRFirestoreErrors.h"
+#import "FIRFirestoreMetrics.h"
 #import "Firestore/Source/API/FIRFirestore+Internal.h"
 #import "Firestore/Source/Auth/FSTCredentialsProvider.h"
 #import "Firestore/Source/Core/FSTDatabaseInfo.h"
@@ -37,6 +38,10 @@
 
 #import "Firestore/Protos/objc/google/firestore/v1beta1/Firestore.pbrpc.h"
 
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
+
+namespace util = firebase::firestore::util;
+
 /**
  * Initial backoff time in seconds after an error.
  * Set to 1s according to https://cloud.google.com/apis/design/errors.
@@ -45,6 +50,15 @@ static const NSTimeInterval kBackoffInitialDelay = 1;
 static const NSTimeInterval kBackoffMaxDelay = 60.0;
 static const double kBackoffFactor = 1.5;
 
+const NSTimeInterval kFSTStreamDefaultIdleTimeout = 60.0;
+
+/**
+ * The number of decoded responses that may wait for the worker queue at once. Once this many are
+ * waiting, the decode queue stops decoding until the worker queue catches up, so a slow worker
+ * queue doesn't accumulate decoded responses, which take far more memory than the encoded ones.
+ */
+static const long kMaxPendingDecodedMessages = 16;
+
 #pragma mark - FSTStream
 
 /** The state of a stream. */
@@ -108,10 +122,15 @@ typedef NS_ENUM(NSInteger, FSTStreamState) {
 @interface FSTStream ()
 
 @property(nonatomic, getter=isIdle) BOOL idle;
+
+/** The pending idle close timer, scheduled by markIdle and cancelled by cancelIdleCheck. */
+@property(nonatomic, strong, nullable) FSTDelayedCallback *idleTimer;
 @property(nonatomic, weak, readwrite, nullable) id delegate;
 
 @end
 
+@class FSTCallbackFilter;
+
 @interface FSTStream () <GRXWriteable>
 
 @property(nonatomic, strong, readonly) FSTDatabaseInfo *databaseInfo;
@@ -120,9 +139,25 @@ typedef NS_ENUM(NSInteger, FSTStreamState) {
 @property(nonatomic, unsafe_unretained, readonly) Class responseMessageClass;
 @property(nonatomic, strong, readonly) FSTExponentialBackoff *backoff;
 
+/** The delegate the stream is restarted with once it is done backing off. */
+@property(nonatomic, strong, nullable) id backoffDelegate;
+
 /** A flag tracking whether the stream received a message from the backend. */
 @property(nonatomic, assign) BOOL messageReceived;
 
+/** When the stream was last started, used to measure the time until the first message arrives. */
+@property(nonatomic, strong, nullable) NSDate *startTime;
+
+/** The names of the metrics reported for this stream. Set by subclasses. */
+@property(nonatomic, copy) NSString *bytesSentMetric;
+@property(nonatomic, copy) NSString *bytesReceivedMetric;
+@property(nonatomic, copy) NSString *messagesSentMetric;
+@property(nonatomic, copy) NSString *messagesReceivedMetric;
+@property(nonatomic, copy) NSString *handshakeLatencyMetric;
+
+/** Identifies this stream in trace events. Set by subclasses. */
+@property(nonatomic, assign) util::TraceStream traceStream;
+
 /**
  * Stream state as exposed to consumers of FSTStream. This differs from GRXWriter's notion of the
  * state of the stream.
@@ -132,6 +167,12 @@ typedef NS_ENUM(NSInteger, FSTStreamState) {
 /** The RPC handle. Used for cancellation. */
 @property(nonatomic, strong, nullable) GRPCCall *rpc;
 
+/** Receives a response of the RPC whose callbacks pass through the given filter. */
+- (void)receiveValue:(NSData *)value callbackFilter:(nullable FSTCallbackFilter *)filter;
+
+/** Receives the final state of the RPC whose callbacks pass through the given filter. */
+- (void)receiveError:(nullable NSError *)error callbackFilter:(nullable FSTCallbackFilter *)filter;
+
 /**
  * The send-side of the RPC stream in which to submit requests, but only once the underlying RPC has
  * started.
@@ -169,13 +210,13 @@ typedef NS_ENUM(NSInteger, FSTStreamState) {
 
 - (void)writeValue:(id)value {
   if (_callbacksEnabled) {
-    [self.stream writeValue:value];
+    [self.stream receiveValue:value callbackFilter:self];
   }
 }
 
 - (void)writesFinishedWithError:(NSError *)errorOrNil {
   if (_callbacksEnabled) {
-    [self.stream writesFinishedWithError:errorOrNil];
+    [self.stream receiveError:errorOrNil callbackFilter:self];
   }
 }
 
@@ -189,10 +230,14 @@ typedef NS_ENUM(NSInteger, FSTStreamState) {
 
 @end
 
-@implementation FSTStream
+@implementation FSTStream {
+  // Parses and decodes responses in the order they're received, then hands them to the worker
+  // queue.
+  dispatch_queue_t _decodeQueue;
 
-/** The time a stream stays open after it is marked idle. */
-static const NSTimeInterval kIdleTimeout = 60.0;
+  // Counts the decoded responses that may still be handed to the worker queue.
+  dispatch_semaphore_t _decodedMessageSlots;
+}
 
 - (instancetype)initWithDatabase:(FSTDatabaseInfo *)database
              workerDispatchQueue:(FSTDispatchQueue *)workerDispatchQueue
@@ -208,11 +253,20 @@ static const NSTimeInterval kIdleTimeout = 60.0;
                                                              initialDelay:kBackoffInitialDelay
                                                             backoffFactor:kBackoffFactor
                                                                  maxDelay:kBackoffMaxDelay];
+    _idleTimeout = kFSTStreamDefaultIdleTimeout;
     _state = FSTStreamStateInitial;
+    _decodeQueue = dispatch_queue_create("com.google.firebase.firestore.stream.decode",
+                                         DISPATCH_QUEUE_SERIAL);
+    _decodedMessageSlots = dispatch_semaphore_create(kMaxPendingDecodedMessages);
   }
   return self;
 }
 
+- (void)setMetricsProvider:(nullable id<FIRFirestoreMetricsProvider>)metricsProvider {
+  _metricsProvider = metricsProvider;
+  self.backoff.metricsProvider = metricsProvider;
+}
+
 - (BOOL)isStarted {
   [self.workerDispatchQueue verifyIsCurrentQueue];
   FSTStreamState state = self.state;
@@ -225,6 +279,13 @@ static const NSTimeInterval kIdleTimeout = 60.0;
   return self.state == FSTStreamStateOpen;
 }
 
+- (BOOL)isWriteBufferFull {
+  FSTBufferedWriter *requestsWriter = self.requestsWriter;
+  @synchronized(requestsWriter) {
+    return requestsWriter.isFull;
+  }
+}
+
 - (GRPCCall *)createRPCWithRequestsWriter:(GRXWriter *)requestsWriter {
   @throw FSTAbstractMethodException();  // NOLINT
 }
@@ -241,6 +302,8 @@ static const NSTimeInterval kIdleTimeout = 60.0;
   FSTAssert(self.state == FSTStreamStateInitial, @"Already started");
 
   self.state = FSTStreamStateAuth;
+  self.startTime = [NSDate date];
+  util::Trace(util::kTraceStreamStart, self.traceStream);
   FSTAssert(_delegate == nil, @"Delegate must be nil");
   _delegate = delegate;
 
@@ -273,7 +336,19 @@ static const NSTimeInterval kIdleTimeout = 60.0;
     return;
   }
 
-  self.requestsWriter = [[FSTBufferedWriter alloc] init];
+  FSTBufferedWriter *requestsWriter = [[FSTBufferedWriter alloc] init];
+  FSTWeakify(self);
+  __weak FSTBufferedWriter *weakRequestsWriter = requestsWriter;
+  requestsWriter.drainHandler = ^{
+    FSTStrongify(self);
+    [self.workerDispatchQueue dispatchAsyncAllowingSameQueue:^{
+      // Ignore writers left behind by an earlier RPC.
+      if (self.requestsWriter && self.requestsWriter == weakRequestsWriter) {
+        [self notifyStreamDrained];
+      }
+    }];
+  };
+  self.requestsWriter = requestsWriter;
   _rpc = [self createRPCWithRequestsWriter:self.requestsWriter];
   [FSTDatastore prepareHeadersForRPC:_rpc
                           databaseID:self.databaseInfo.databaseID
@@ -293,16 +368,23 @@ static const NSTimeInterval kIdleTimeout = 60.0;
 
   FSTAssert(self.state == FSTStreamStateError, @"Should only perform backoff in an error case");
   self.state = FSTStreamStateBackoff;
+  self.backoffDelegate = delegate;
+  [self scheduleResumeStartFromBackoff];
+}
 
+/** Schedules the stream to resume starting once the current backoff delay has passed. */
+- (void)scheduleResumeStartFromBackoff {
   FSTWeakify(self);
   [self.backoff backoffAndRunBlock:^{
     FSTStrongify(self);
-    [self resumeStartFromBackoffWithDelegate:delegate];
+    [self resumeStartFromBackoff];
   }];
 }
 
 /** Resumes stream start after backing off. */
-- (void)resumeStartFromBackoffWithDelegate:(id)delegate {
+- (void)resumeStartFromBackoff {
+  id delegate = self.backoffDelegate;
+  self.backoffDelegate = nil;
   if (self.state == FSTStreamStateStopped) {
     // Streams can be stopped while waiting for backoff to complete.
     return;
@@ -345,7 +427,11 @@ static const NSTimeInterval kIdleTimeout = 60.0;
             @"Can't provide an error when not in an error state.");
 
   [self.workerDispatchQueue verifyIsCurrentQueue];
+  util::Trace(util::kTraceStreamClose, self.traceStream, error.code);
   [self cancelIdleCheck];
+  // A stream stopped while backing off must not be restarted by the pending backoff block.
+  [self.backoff cancel];
+  self.backoffDelegate = nil;
 
   if (finalState != FSTStreamStateError) {
     // If this is an intentional close ensure we don't delay our next connection attempt.
@@ -408,6 +494,18 @@ static const NSTimeInterval kIdleTimeout = 60.0;
   [self.backoff reset];
 }
 
+- (void)skipBackoff {
+  [self.workerDispatchQueue verifyIsCurrentQueue];
+
+  [self.backoff reset];
+  if (self.state == FSTStreamStateBackoff) {
+    FSTLog(@"%@ %p skipping backoff", NSStringFromClass([self class]), (__bridge void *)self);
+    // The reset backoff runs the rescheduled block without delay (but still asynchronously).
+    [self.backoff cancel];
+    [self scheduleResumeStartFromBackoff];
+  }
+}
+
 /** Called by the idle timer when the stream should close due to inactivity. */
 - (void)handleIdleCloseTimer {
   [self.workerDispatchQueue verifyIsCurrentQueue];
@@ -422,16 +520,22 @@ static const NSTimeInterval kIdleTimeout = 60.0;
   [self.workerDispatchQueue verifyIsCurrentQueue];
   if (self.state == FSTStreamStateOpen) {
     self.idle = YES;
-    [self.workerDispatchQueue dispatchAfterDelay:kIdleTimeout
-                                           block:^() {
-                                             [self handleIdleCloseTimer];
-                                           }];
+    // Marking an already idle stream idle again keeps the timer that's already running, rather
+    // than scheduling another one per call.
+    if (!self.idleTimer.isPending) {
+      self.idleTimer = [self.workerDispatchQueue dispatchAfterDelay:self.idleTimeout
+                                                              block:^() {
+                                                                [self handleIdleCloseTimer];
+                                                              }];
+    }
   }
 }
 
 - (void)cancelIdleCheck {
   [self.workerDispatchQueue verifyIsCurrentQueue];
   self.idle = NO;
+  [self.idleTimer cancel];
+  self.idleTimer = nil;
 }
 
 /**
@@ -471,6 +575,10 @@ static const NSTimeInterval kIdleTimeout = 60.0;
 
   [self cancelIdleCheck];
 
+  id<FIRFirestoreMetricsProvider> metricsProvider = self.metricsProvider;
+  [metricsProvider incrementCounter:self.bytesSentMetric by:(int64_t)data.length];
+  [metricsProvider incrementCounter:self.messagesSentMetric by:1];
+
   FSTBufferedWriter *requestsWriter = self.requestsWriter;
   @synchronized(requestsWriter) {
     [requestsWriter writeValue:data];
@@ -498,6 +606,15 @@ static const NSTimeInterval kIdleTimeout = 60.0;
 - (void)notifyStreamInterruptedWithError:(nullable NSError *)error {
 }
 
+/**
+ * Called by the stream once a full write buffer has drained.
+ *
+ * Subclasses should relay to their stream-specific delegate if appropriate. Calling [super
+ * notifyStreamDrained] is not required.
+ */
+- (void)notifyStreamDrained {
+}
+
 /**
  * Called by the stream for each incoming protocol message coming from the server.
  *
@@ -507,6 +624,18 @@ static const NSTimeInterval kIdleTimeout = 60.0;
 - (void)handleStreamMessage:(id)value {
 }
 
+/**
+ * Called on the stream's decode queue with each parsed response proto, before the result is passed
+ * to handleStreamMessage on the worker queue. Decoding for the next response overlaps with handling
+ * of the previous one, so subclasses should deserialize here whatever can be done without state
+ * owned by the worker queue.
+ *
+ * The default implementation returns the proto unchanged.
+ */
+- (id)decodedMessage:(id)proto {
+  return proto;
+}
+
 /**
  * Called by the stream when the underlying RPC has been closed for whatever reason.
  */
@@ -526,64 +655,140 @@ static const NSTimeInterval kIdleTimeout = 60.0;
 }
 
 #pragma mark GRXWriteable implementation
-// The GRXWriteable implementation defines the receive side of the RPC stream.
+// The GRXWriteable implementation defines the receive side of the RPC stream. GRPC calls the
+// callback filter of the current RPC, which forwards to receiveValue: and receiveError: along with
+// itself, so that callbacks of an RPC that has since been closed can be told apart.
+
+- (void)writeValue:(id)value __used {
+  [self receiveValue:value callbackFilter:self.callbackFilter];
+}
+
+- (void)writesFinishedWithError:(nullable NSError *)error __used {
+  [self receiveError:error callbackFilter:self.callbackFilter];
+}
 
 /**
- * Called by GRPC when it publishes a value. It is called from GRPC's own queue so we immediately
- * redispatch back onto our own worker queue.
+ * Called by GRPC when it publishes a value, on GRPC's own queue.
  */
-- (void)writeValue:(id)value __used {
+- (void)receiveValue:(NSData *)value callbackFilter:(nullable FSTCallbackFilter *)filter {
   // TODO(mcg): remove the double-dispatch once GRPCCall at head is released.
-  // Once released we can set the responseDispatchQueue property on the GRPCCall and then this
-  // method can call handleStreamMessage directly.
+  // Once released we can set the responseDispatchQueue property on the GRPCCall to the decode
+  // queue.
+  //
+  // Responses are parsed and decoded on the decode queue, in order, and handed to the worker queue
+  // in that same order, so that decoding one response overlaps with applying the previous one.
   FSTWeakify(self);
-  [self.workerDispatchQueue dispatchAsync:^{
+  FSTDispatchQueue *workerDispatchQueue = self.workerDispatchQueue;
+  dispatch_semaphore_t slots = _decodedMessageSlots;
+  Class responseMessageClass = self.responseMessageClass;
+  dispatch_async(_decodeQueue, ^{
     FSTStrongify(self);
-    if (![self isStarted]) {
-      FSTLog(@"%@ Ignoring stream message from inactive stream.", NSStringFromClass([self class]));
+    if (!self || !filter.callbacksEnabled) {
+      return;
     }
+    NSError *error;
+    id proto = [self parseProto:responseMessageClass data:value error:&error];
+    id _Nullable decoded = proto ? [self decodedMessage:proto] : nil;
+
+    dispatch_semaphore_wait(slots, DISPATCH_TIME_FOREVER);
+    [workerDispatchQueue dispatchAsync:^{
+      dispatch_semaphore_signal(slots);
+      [self handleValue:value decodedMessage:decoded error:error callbackFilter:filter];
+    }];
+  });
+}
 
-    if (!self.messageReceived) {
-      self.messageReceived = YES;
-      if ([FIRFirestore isLoggingEnabled]) {
-        FSTLog(@"%@ %p headers (whitelisted): %@", NSStringFromClass([self class]),
-               (__bridge void *)self,
-               [FSTDatastore extractWhiteListedHeaders:self.rpc.responseHeaders]);
-      }
+/** Handles a response of the stream's RPC on the worker queue, once it has been decoded. */
+- (void)handleValue:(NSData *)value
+     decodedMessage:(nullable id)decoded
+              error:(nullable NSError *)error
+     callbackFilter:(nullable FSTCallbackFilter *)filter {
+  // Responses decoded after the stream was closed belong to an RPC that's gone.
+  if (!filter.callbacksEnabled || ![self isStarted]) {
+    FSTLog(@"%@ Ignoring stream message from inactive stream.", NSStringFromClass([self class]));
+    return;
+  }
+
+  util::Trace(util::kTraceStreamMessage, self.traceStream, (int64_t)[value length]);
+  id<FIRFirestoreMetricsProvider> metricsProvider = self.metricsProvider;
+  [metricsProvider incrementCounter:self.bytesReceivedMetric by:(int64_t)[value length]];
+  [metricsProvider incrementCounter:self.messagesReceivedMetric by:1];
+
+  if (!self.messageReceived) {
+    self.messageReceived = YES;
+    if (self.startTime) {
+      [metricsProvider recordValue:-[self.startTime timeIntervalSinceNow]
+                      forHistogram:self.handshakeLatencyMetric];
     }
-    NSError *error;
-    id proto = [self parseProto:self.responseMessageClass data:value error:&error];
-    if (proto) {
-      [self handleStreamMessage:proto];
-    } else {
-      [_rpc finishWithError:error];
+    if ([FIRFirestore isLoggingEnabled]) {
+      FSTLog(@"%@ %p headers (whitelisted): %@", NSStringFromClass([self class]),
+             (__bridge void *)self,
+             [FSTDatastore extractWhiteListedHeaders:self.rpc.responseHeaders]);
     }
-  }];
+  }
+  if (decoded) {
+    [self handleStreamMessage:decoded];
+  } else {
+    [_rpc finishWithError:error];
+  }
 }
 
 /**
  * Called by GRPC when it closed the stream with an error representing the final state of the
  * stream.
  *
- * Do not call directly, since it dispatches via the worker queue. Call handleStreamClose to
- * directly inform stream-specific logic, or call stop to tear down the stream.
+ * Do not call directly, since it dispatches via the decode and worker queues. Call
+ * handleStreamClose to directly inform stream-specific logic, or call stop to tear down the stream.
  */
-- (void)writesFinishedWithError:(nullable NSError *)error __used {
+- (void)receiveError:(nullable NSError *)error callbackFilter:(nullable FSTCallbackFilter *)filter {
   error = [FSTDatastore firestoreErrorForError:error];
   FSTWeakify(self);
-  [self.workerDispatchQueue dispatchAsync:^{
-    FSTStrongify(self);
-    if (!self || self.state == FSTStreamStateStopped) {
-      return;
-    }
-    [self handleStreamClose:error];
-  }];
+  FSTDispatchQueue *workerDispatchQueue = self.workerDispatchQueue;
+  // Passing through the decode queue keeps the close behind the responses that preceded it.
+  dispatch_async(_decodeQueue, ^{
+    [workerDispatchQueue dispatchAsync:^{
+      FSTStrongify(self);
+      if (!self || self.state == FSTStreamStateStopped || !filter.callbacksEnabled) {
+        return;
+      }
+      [self handleStreamClose:error];
+    }];
+  });
 }
 
 @end
 
 #pragma mark - FSTWatchStream
 
+/** A listen response along with the models decoded from it on the decode queue. */
+@interface FSTDecodedListenResponse : NSObject
+
+- (instancetype)initWithProto:(GCFSListenResponse *)proto
+                  watchChange:(FSTWatchChange *)watchChange
+              snapshotVersion:(FSTSnapshotVersion *)snapshotVersion NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+@property(nonatomic, strong, readonly) GCFSListenResponse *proto;
+@property(nonatomic, strong, readonly) FSTWatchChange *watchChange;
+@property(nonatomic, strong, readonly) FSTSnapshotVersion *snapshotVersion;
+
+@end
+
+@implementation FSTDecodedListenResponse
+
+- (instancetype)initWithProto:(GCFSListenResponse *)proto
+                  watchChange:(FSTWatchChange *)watchChange
+              snapshotVersion:(FSTSnapshotVersion *)snapshotVersion {
+  if (self = [super init]) {
+    _proto = proto;
+    _watchChange = watchChange;
+    _snapshotVersion = snapshotVersion;
+  }
+  return self;
+}
+
+@end
+
 @interface FSTWatchStream ()
 
 @property(nonatomic, strong, readonly) FSTSerializerBeta *serializer;
@@ -602,6 +807,12 @@ static const NSTimeInterval kIdleTimeout = 60.0;
             responseMessageClass:[GCFSListenResponse class]];
   if (self) {
     _serializer = serializer;
+    self.bytesSentMetric = FIRFirestoreMetricWatchBytesSent;
+    self.bytesReceivedMetric = FIRFirestoreMetricWatchBytesReceived;
+    self.messagesSentMetric = FIRFirestoreMetricWatchMessagesSent;
+    self.messagesReceivedMetric = FIRFirestoreMetricWatchMessagesReceived;
+    self.handshakeLatencyMetric = FIRFirestoreMetricWatchHandshakeLatency;
+    self.traceStream = util::kTraceStreamWatch;
   }
   return self;
 }
@@ -648,19 +859,31 @@ static const NSTimeInterval kIdleTimeout = 60.0;
 }
 
 /**
- * Receives an inbound message from GRPC, deserializes, and then passes that on to the delegate's
+ * Deserializes an inbound message from GRPC on the decode queue. Decoding the documents of a
+ * large initial sync dominates the cost of handling it, so this keeps that work off the worker
+ * queue. The serializer holds no mutable state, so it's safe to use here.
+ */
+- (id)decodedMessage:(GCFSListenResponse *)proto {
+  FSTWatchChange *change = [_serializer decodedWatchChange:proto];
+  FSTSnapshotVersion *snap = [_serializer versionFromListenResponse:proto];
+  return [[FSTDecodedListenResponse alloc] initWithProto:proto
+                                             watchChange:change
+                                         snapshotVersion:snap];
+}
+
+/**
+ * Receives a decoded inbound message and passes it on to the delegate's
  * watchStreamDidChange:snapshotVersion: callback.
  */
-- (void)handleStreamMessage:(GCFSListenResponse *)proto {
-  FSTLog(@"FSTWatchStream %p response: %@", (__bridge void *)self, proto);
+- (void)handleStreamMessage:(FSTDecodedListenResponse *)response {
+  FSTLog(@"FSTWatchStream %p response: %@", (__bridge void *)self, response.proto);
   [self.workerDispatchQueue verifyIsCurrentQueue];
 
   // A successful response means the stream is healthy.
   [self.backoff reset];
 
-  FSTWatchChange *change = [_serializer decodedWatchChange:proto];
-  FSTSnapshotVersion *snap = [_serializer versionFromListenResponse:proto];
-  [self.delegate watchStreamDidChange:change snapshotVersion:snap];
+  [self.delegate watchStreamDidChange:response.watchChange
+                      snapshotVersion:response.snapshotVersion];
 }
 
 @end
@@ -685,6 +908,12 @@ static const NSTimeInterval kIdleTimeout = 60.0;
             responseMessageClass:[GCFSWriteResponse class]];
   if (self) {
     _serializer = serializer;
+    self.bytesSentMetric = FIRFirestoreMetricWriteBytesSent;
+    self.bytesReceivedMetric = FIRFirestoreMetricWriteBytesReceived;
+    self.messagesSentMetric = FIRFirestoreMetricWriteMessagesSent;
+    self.messagesReceivedMetric = FIRFirestoreMetricWriteMessagesReceived;
+    self.handshakeLatencyMetric = FIRFirestoreMetricWriteHandshakeLatency;
+    self.traceStream = util::kTraceStreamWrite;
   }
   return self;
 }
@@ -710,6 +939,10 @@ static const NSTimeInterval kIdleTimeout = 60.0;
   [delegate writeStreamWasInterruptedWithError:error];
 }
 
+- (void)notifyStreamDrained {
+  [self.delegate writeStreamDidDrain];
+}
+
 - (void)tearDown {
   if ([self isHandshakeComplete]) {
     // Send an empty write request to the backend to indicate imminent stream closure. This allows
@@ -726,8 +959,12 @@ static const NSTimeInterval kIdleTimeout = 60.0;
 
   GCFSWriteRequest *request = [GCFSWriteRequest message];
   request.database = [_serializer encodedDatabaseID];
-  // TODO(dimond): Support stream resumption. We intentionally do not set the stream token on the
-  // handshake, ignoring any stream token we might have.
+  // Resume the previous stream if we know both its ID and our position in it. Otherwise, leave
+  // the stream token unset to create a new stream.
+  if (self.lastStreamID.length > 0 && self.lastStreamToken.length > 0) {
+    request.streamId = self.lastStreamID;
+    request.streamToken = self.lastStreamToken;
+  }
 
   FSTLog(@"FSTWriteStream %p initial request: %@", (__bridge void *)self, request);
   [self writeRequest:request];
@@ -759,8 +996,11 @@ static const NSTimeInterval kIdleTimeout = 60.0;
   FSTLog(@"FSTWriteStream %p response: %@", (__bridge void *)self, response);
   [self.workerDispatchQueue verifyIsCurrentQueue];
 
-  // Always capture the last stream token.
+  // Always capture the last stream token. The stream ID is only sent when a new stream is created.
   self.lastStreamToken = response.streamToken;
+  if (response.streamId.length > 0) {
+    self.lastStreamID = response.streamId;
+  }
 
   if (!self.isHandshakeComplete) {
     // The first response is the handshake response
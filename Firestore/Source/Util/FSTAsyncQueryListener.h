@@ -22,16 +22,25 @@ NS_ASSUME_NONNULL_BEGIN
 
 @class FSTDispatchQueue;
 @class FSTQueryListener;
+@class FSTSnapshotBatcher;
 
 /**
  * A wrapper class around FSTQueryListener that dispatches events asynchronously.
  */
 @interface FSTAsyncQueryListener : NSObject
 
+/**
+ * Creates a listener that dispatches events to the given queue, either one at a time or, if a
+ * batcher is given, together with the events of other listeners sharing the batcher.
+ */
 - (instancetype)initWithDispatchQueue:(FSTDispatchQueue *)dispatchQueue
+                              batcher:(nullable FSTSnapshotBatcher *)batcher
                       snapshotHandler:(FSTViewSnapshotHandler)snapshotHandler
     NS_DESIGNATED_INITIALIZER;
 
+- (instancetype)initWithDispatchQueue:(FSTDispatchQueue *)dispatchQueue
+                      snapshotHandler:(FSTViewSnapshotHandler)snapshotHandler;
+
 - (instancetype)init NS_UNAVAILABLE;
 
 /**
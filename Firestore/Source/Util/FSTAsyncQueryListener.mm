@@ -16,24 +16,50 @@
 
 #import "Firestore/Source/Util/FSTAsyncQueryListener.h"
 
+#import "Firestore/Source/Util/FSTAssert.h"
 #import "Firestore/Source/Util/FSTDispatchQueue.h"
+#import "Firestore/Source/Util/FSTSnapshotBatcher.h"
 
 @implementation FSTAsyncQueryListener {
   volatile BOOL _muted;
   FSTViewSnapshotHandler _snapshotHandler;
   FSTDispatchQueue *_dispatchQueue;
+  FSTSnapshotBatcher *_batcher;
 }
 
 - (instancetype)initWithDispatchQueue:(FSTDispatchQueue *)dispatchQueue
+                              batcher:(nullable FSTSnapshotBatcher *)batcher
                       snapshotHandler:(FSTViewSnapshotHandler)snapshotHandler {
   if (self = [super init]) {
+    FSTAssert(!batcher || batcher.userDispatchQueue == dispatchQueue,
+              @"Batcher delivers to a different queue than the listener's");
     _dispatchQueue = dispatchQueue;
+    _batcher = batcher;
     _snapshotHandler = snapshotHandler;
   }
   return self;
 }
 
+- (instancetype)initWithDispatchQueue:(FSTDispatchQueue *)dispatchQueue
+                      snapshotHandler:(FSTViewSnapshotHandler)snapshotHandler {
+  return [self initWithDispatchQueue:dispatchQueue batcher:nil snapshotHandler:snapshotHandler];
+}
+
 - (FSTViewSnapshotHandler)asyncSnapshotHandler {
+  if (_batcher) {
+    return ^(FSTViewSnapshot *_Nullable snapshot, NSError *_Nullable error) {
+      [_batcher enqueueSnapshot:snapshot
+                          error:error
+                    forListener:self
+                        handler:^(FSTViewSnapshot *_Nullable batchedSnapshot,
+                                  NSError *_Nullable batchedError) {
+                          if (!_muted) {
+                            _snapshotHandler(batchedSnapshot, batchedError);
+                          }
+                        }];
+    };
+  }
+
   return ^(FSTViewSnapshot *_Nullable snapshot, NSError *_Nullable error) {
     [_dispatchQueue dispatchAsync:^{
       if (!_muted) {
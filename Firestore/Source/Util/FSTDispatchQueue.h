@@ -18,6 +18,28 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ * A handle to a block scheduled with -[FSTDispatchQueue dispatchAfterDelay:...], which can cancel
+ * or reschedule the block until it has run.
+ */
+@interface FSTDelayedCallback : NSObject
+
+- (instancetype)init __attribute__((unavailable("Use FSTDispatchQueue dispatchAfterDelay:...")));
+
+/** Cancels the callback if it hasn't run yet. Calling this more than once is harmless. */
+- (void)cancel;
+
+/**
+ * Moves the callback to run once the given delay (in seconds) has passed, counted from now. Does
+ * nothing if the callback has already run or been cancelled.
+ */
+- (void)rescheduleAfterDelay:(NSTimeInterval)delay;
+
+/** Whether the callback is still waiting to run, i.e. it has neither run nor been cancelled. */
+@property(nonatomic, assign, readonly, getter=isPending) BOOL pending;
+
+@end
+
 @interface FSTDispatchQueue : NSObject
 
 /** Creates and returns an FSTDispatchQueue wrapping the specified dispatch_queue_t. */
@@ -58,10 +80,27 @@ NS_ASSUME_NONNULL_BEGIN
  * Unlike dispatchAsync: this method does not require you to dispatch to a different queue than
  * the current one (thus it is equivalent to a raw dispatch_after()).
  *
+ * All the callbacks of a queue share a single timer, which is armed for the earliest one, so
+ * callbacks that are cancelled or rescheduled don't leave timers behind to wake up the CPU.
+ *
  * @param block The block to run.
  * @param delay The delay (in seconds) after which to run the block.
+ * @return A handle that can cancel or reschedule the callback.
+ */
+- (FSTDelayedCallback *)dispatchAfterDelay:(NSTimeInterval)delay block:(void (^)(void))block;
+
+/**
+ * Like dispatchAfterDelay:block:, but coalesces callbacks by tag: if a callback with the same tag
+ * is still pending, it's returned and the new block is dropped.
+ *
+ * @param delay The delay (in seconds) after which to run the block.
+ * @param tag Identifies callbacks that should be coalesced, or nil to never coalesce.
+ * @param block The block to run.
+ * @return A handle to the pending callback with the tag.
  */
-- (void)dispatchAfterDelay:(NSTimeInterval)delay block:(void (^)(void))block;
+- (FSTDelayedCallback *)dispatchAfterDelay:(NSTimeInterval)delay
+                             coalescingTag:(nullable NSString *)tag
+                                     block:(void (^)(void))block;
 
 /** The underlying wrapped dispatch_queue_t */
 @property(nonatomic, strong, readonly) dispatch_queue_t queue;
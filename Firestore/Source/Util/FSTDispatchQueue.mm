@@ -21,11 +21,95 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ * The leeway granted to the shared timer, as a fraction of the time until it's due, so the system
+ * can fire it together with other work instead of waking up just for it.
+ */
+static const double kFSTTimerLeewayFraction = 0.1;
+
+/** Returns a monotonic clock reading, in seconds, for scheduling delayed callbacks. */
+static NSTimeInterval FSTMonotonicTime() {
+  return [NSProcessInfo processInfo].systemUptime;
+}
+
+#pragma mark - FSTDelayedCallback
+
+@interface FSTDelayedCallback ()
+
+- (instancetype)initWithQueue:(FSTDispatchQueue *)queue
+                          tag:(nullable NSString *)tag
+                   targetTime:(NSTimeInterval)targetTime
+                        block:(void (^)(void))block NS_DESIGNATED_INITIALIZER;
+
+@property(nonatomic, weak, readonly) FSTDispatchQueue *queue;
+@property(nonatomic, copy, readonly, nullable) NSString *tag;
+
+// The following are guarded by @synchronized on the queue.
+
+/** When the callback is due, according to FSTMonotonicTime(). */
+@property(nonatomic, assign) NSTimeInterval targetTime;
+
+/** The block to run; nil once the callback has run or been cancelled. */
+@property(nonatomic, copy, nullable) void (^block)(void);
+
+@end
+
 @interface FSTDispatchQueue ()
 - (instancetype)initWithQueue:(dispatch_queue_t)queue NS_DESIGNATED_INITIALIZER;
+- (void)cancelCallback:(FSTDelayedCallback *)callback;
+- (void)rescheduleCallback:(FSTDelayedCallback *)callback afterDelay:(NSTimeInterval)delay;
 @end
 
-@implementation FSTDispatchQueue
+@implementation FSTDelayedCallback
+
+- (instancetype)initWithQueue:(FSTDispatchQueue *)queue
+                          tag:(nullable NSString *)tag
+                   targetTime:(NSTimeInterval)targetTime
+                        block:(void (^)(void))block {
+  if (self = [super init]) {
+    _queue = queue;
+    _tag = [tag copy];
+    _targetTime = targetTime;
+    _block = [block copy];
+  }
+  return self;
+}
+
+- (void)cancel {
+  [self.queue cancelCallback:self];
+}
+
+- (void)rescheduleAfterDelay:(NSTimeInterval)delay {
+  [self.queue rescheduleCallback:self afterDelay:delay];
+}
+
+- (BOOL)isPending {
+  FSTDispatchQueue *queue = self.queue;
+  if (!queue) {
+    return NO;
+  }
+  @synchronized(queue) {
+    return self.block != nil;
+  }
+}
+
+@end
+
+#pragma mark - FSTDispatchQueue
+
+@implementation FSTDispatchQueue {
+  /**
+   * The pending delayed callbacks, sorted by target time. Callbacks with equal target times are in
+   * the order they were scheduled in. Guarded by @synchronized on self.
+   */
+  NSMutableArray<FSTDelayedCallback *> *_delayedCallbacks;
+
+  /** The pending delayed callbacks that have tags, by tag. Guarded by @synchronized on self. */
+  NSMutableDictionary<NSString *, FSTDelayedCallback *> *_delayedCallbacksByTag;
+
+  /** The timer shared by all delayed callbacks, created on first use. */
+  dispatch_source_t _Nullable _timer;
+}
 
 + (instancetype)queueWith:(dispatch_queue_t)dispatchQueue {
   return [[FSTDispatchQueue alloc] initWithQueue:dispatchQueue];
@@ -34,10 +118,18 @@ NS_ASSUME_NONNULL_BEGIN
 - (instancetype)initWithQueue:(dispatch_queue_t)queue {
   if (self = [super init]) {
     _queue = queue;
+    _delayedCallbacks = [NSMutableArray array];
+    _delayedCallbacksByTag = [NSMutableDictionary dictionary];
   }
   return self;
 }
 
+- (void)dealloc {
+  if (_timer) {
+    dispatch_source_cancel(_timer);
+  }
+}
+
 - (void)verifyIsCurrentQueue {
   FSTAssert([self onTargetQueue],
             @"We are running on the wrong dispatch queue. Expected '%@' Actual: '%@'",
@@ -56,9 +148,143 @@ NS_ASSUME_NONNULL_BEGIN
   dispatch_async(self.queue, block);
 }
 
-- (void)dispatchAfterDelay:(NSTimeInterval)delay block:(void (^)(void))block {
-  dispatch_time_t delayNs = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC));
-  dispatch_after(delayNs, self.queue, block);
+- (FSTDelayedCallback *)dispatchAfterDelay:(NSTimeInterval)delay block:(void (^)(void))block {
+  return [self dispatchAfterDelay:delay coalescingTag:nil block:block];
+}
+
+- (FSTDelayedCallback *)dispatchAfterDelay:(NSTimeInterval)delay
+                             coalescingTag:(nullable NSString *)tag
+                                     block:(void (^)(void))block {
+  @synchronized(self) {
+    if (tag) {
+      FSTDelayedCallback *existing = _delayedCallbacksByTag[tag];
+      if (existing) {
+        return existing;
+      }
+    }
+
+    FSTDelayedCallback *callback =
+        [[FSTDelayedCallback alloc] initWithQueue:self
+                                              tag:tag
+                                       targetTime:FSTMonotonicTime() + MAX(delay, 0)
+                                            block:block];
+    [self insertCallback:callback];
+    if (tag) {
+      _delayedCallbacksByTag[tag] = callback;
+    }
+    [self armTimer];
+    return callback;
+  }
+}
+
+#pragma mark - Delayed callbacks
+
+- (void)cancelCallback:(FSTDelayedCallback *)callback {
+  @synchronized(self) {
+    if (!callback.block) {
+      return;
+    }
+    callback.block = nil;
+    [self removeCallback:callback];
+    [self armTimer];
+  }
+}
+
+- (void)rescheduleCallback:(FSTDelayedCallback *)callback afterDelay:(NSTimeInterval)delay {
+  @synchronized(self) {
+    if (!callback.block) {
+      return;
+    }
+    [self removeCallback:callback];
+    callback.targetTime = FSTMonotonicTime() + MAX(delay, 0);
+    [self insertCallback:callback];
+    if (callback.tag) {
+      _delayedCallbacksByTag[callback.tag] = callback;
+    }
+    [self armTimer];
+  }
+}
+
+/** Inserts the callback after all the callbacks due no later than it. Must hold the lock. */
+- (void)insertCallback:(FSTDelayedCallback *)callback {
+  NSUInteger index = [_delayedCallbacks
+      indexOfObject:callback
+      inSortedRange:NSMakeRange(0, _delayedCallbacks.count)
+            options:NSBinarySearchingInsertionIndex | NSBinarySearchingLastEqual
+    usingComparator:^NSComparisonResult(FSTDelayedCallback *left, FSTDelayedCallback *right) {
+      if (left.targetTime < right.targetTime) {
+        return NSOrderedAscending;
+      } else if (left.targetTime > right.targetTime) {
+        return NSOrderedDescending;
+      }
+      return NSOrderedSame;
+    }];
+  [_delayedCallbacks insertObject:callback atIndex:index];
+}
+
+/** Removes the callback from the pending callbacks, if it's there. Must hold the lock. */
+- (void)removeCallback:(FSTDelayedCallback *)callback {
+  NSUInteger index = [_delayedCallbacks indexOfObjectIdenticalTo:callback];
+  if (index != NSNotFound) {
+    [_delayedCallbacks removeObjectAtIndex:index];
+  }
+  if (callback.tag && _delayedCallbacksByTag[callback.tag] == callback) {
+    [_delayedCallbacksByTag removeObjectForKey:callback.tag];
+  }
+}
+
+/** Arms the shared timer for the earliest pending callback, if any. Must hold the lock. */
+- (void)armTimer {
+  FSTDelayedCallback *first = _delayedCallbacks.firstObject;
+  if (!first) {
+    if (_timer) {
+      dispatch_source_set_timer(_timer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+    }
+    return;
+  }
+
+  if (!_timer) {
+    _timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self.queue);
+    __weak FSTDispatchQueue *weakSelf = self;
+    dispatch_source_set_event_handler(_timer, ^{
+      [weakSelf runDueCallbacks];
+    });
+    dispatch_resume(_timer);
+  }
+
+  NSTimeInterval delay = MAX(first.targetTime - FSTMonotonicTime(), 0);
+  dispatch_time_t start = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC));
+  dispatch_source_set_timer(_timer, start, DISPATCH_TIME_FOREVER,
+                            (uint64_t)(delay * kFSTTimerLeewayFraction * NSEC_PER_SEC));
+}
+
+/** Runs, in order, the callbacks that are due. Called by the timer on the queue. */
+- (void)runDueCallbacks {
+  NSMutableArray<FSTDelayedCallback *> *due = [NSMutableArray array];
+  @synchronized(self) {
+    NSTimeInterval now = FSTMonotonicTime();
+    while (_delayedCallbacks.count > 0 && _delayedCallbacks[0].targetTime <= now) {
+      FSTDelayedCallback *callback = _delayedCallbacks[0];
+      [_delayedCallbacks removeObjectAtIndex:0];
+      if (callback.tag && _delayedCallbacksByTag[callback.tag] == callback) {
+        [_delayedCallbacksByTag removeObjectForKey:callback.tag];
+      }
+      [due addObject:callback];
+    }
+    [self armTimer];
+  }
+
+  for (FSTDelayedCallback *callback in due) {
+    // A callback that ran earlier in this batch may have cancelled this one.
+    void (^block)(void);
+    @synchronized(self) {
+      block = callback.block;
+      callback.block = nil;
+    }
+    if (block) {
+      block();
+    }
+  }
 }
 
 #pragma mark - Private Methods
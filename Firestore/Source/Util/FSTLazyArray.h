@@ -0,0 +1,41 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** Creates the element at the given index of an FSTLazyArray. */
+typedef id _Nonnull (^FSTLazyArrayElementBlock)(NSUInteger index);
+
+/**
+ * An immutable NSArray whose elements are created on first access, so that callers that only look
+ * at the count or at a few elements don't pay for creating the rest. Each element is created at
+ * most once, and the array is safe to use from any thread.
+ */
+@interface FSTLazyArray<ObjectType> : NSArray<ObjectType>
+
+/**
+ * Creates an array of the given number of elements.
+ *
+ * @param elementBlock Creates the element at an index, called at most once per index. It may be
+ *     called on any thread that accesses the array.
+ */
+- (instancetype)initWithCount:(NSUInteger)count elementBlock:(FSTLazyArrayElementBlock)elementBlock;
+
+@end
+
+NS_ASSUME_NONNULL_END
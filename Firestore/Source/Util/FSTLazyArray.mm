@@ -0,0 +1,71 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "Firestore/Source/Util/FSTLazyArray.h"
+
+#include <vector>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation FSTLazyArray {
+  NSUInteger _count;
+  FSTLazyArrayElementBlock _elementBlock;
+
+  /** The elements created so far, nil where not yet created. Guarded by @synchronized(self). */
+  std::vector<id> _elements;
+}
+
+- (instancetype)initWithCount:(NSUInteger)count
+                 elementBlock:(FSTLazyArrayElementBlock)elementBlock {
+  if (self = [super init]) {
+    _count = count;
+    _elementBlock = [elementBlock copy];
+  }
+  return self;
+}
+
+- (NSUInteger)count {
+  return _count;
+}
+
+- (id)objectAtIndex:(NSUInteger)index {
+  if (index >= _count) {
+    NSString *reason = [NSString stringWithFormat:@"Index %lu beyond bounds of array of count %lu",
+                                                  (unsigned long)index, (unsigned long)_count];
+    @throw [NSException exceptionWithName:NSRangeException reason:reason userInfo:nil];
+  }
+
+  @synchronized(self) {
+    if (_elements.empty()) {
+      _elements.resize(_count);
+    }
+    id element = _elements[index];
+    if (!element) {
+      element = _elementBlock(index);
+      _elements[index] = element;
+    }
+    return element;
+  }
+}
+
+/** Implements NSCopying without copying, which would create every element, since it's immutable. */
+- (id)copyWithZone:(nullable NSZone *)zone {
+  return self;
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
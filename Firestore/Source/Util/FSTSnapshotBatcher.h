@@ -0,0 +1,67 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "Firestore/Source/Core/FSTViewSnapshot.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class FSTDispatchQueue;
+
+/**
+ * FSTSnapshotBatcher collects the snapshot events raised on the worker queue and delivers them to
+ * the user queue together: all events raised while processing one change (e.g. a remote event
+ * affecting many queries) arrive in a single dispatch.
+ *
+ * Optionally, deliveries can be throttled to at most one per interval. Snapshots raised for the
+ * same listener in the meantime are merged into one, so the listener goes straight from the last
+ * results it saw to the latest ones.
+ */
+@interface FSTSnapshotBatcher : NSObject
+
+/**
+ * Creates a new batcher.
+ *
+ * @param workerDispatchQueue The queue events are raised on.
+ * @param userDispatchQueue The queue events are delivered on.
+ * @param minimumInterval The minimum time between deliveries, in seconds. Zero delivers as soon as
+ *     the current worker queue task finishes.
+ */
+- (instancetype)initWithWorkerDispatchQueue:(FSTDispatchQueue *)workerDispatchQueue
+                          userDispatchQueue:(FSTDispatchQueue *)userDispatchQueue
+                            minimumInterval:(NSTimeInterval)minimumInterval
+    NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Queues an event for delivery to the given handler. Must be called on the worker queue.
+ *
+ * @param listener Identifies the listener the event is for. Its snapshots are merged while waiting
+ *     to be delivered, and nothing more is delivered to it after an error.
+ * @param handler The handler to deliver the event to. Called on the user queue.
+ */
+- (void)enqueueSnapshot:(nullable FSTViewSnapshot *)snapshot
+                  error:(nullable NSError *)error
+            forListener:(id)listener
+                handler:(FSTViewSnapshotHandler)handler;
+
+@property(nonatomic, strong, readonly) FSTDispatchQueue *userDispatchQueue;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "Firestore/Source/Util/FSTSnapshotBatcher.h"
+
+#import "Firestore/Source/Util/FSTDispatchQueue.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+#pragma mark - FSTPendingSnapshotEvent
+
+/** The events waiting to be delivered to one listener. */
+@interface FSTPendingSnapshotEvent : NSObject
+
+- (instancetype)initWithHandler:(FSTViewSnapshotHandler)handler NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@property(nonatomic, copy, readonly) FSTViewSnapshotHandler handler;
+
+/** All the snapshots raised since the last delivery, merged into one. */
+@property(nonatomic, strong, nullable) FSTViewSnapshot *snapshot;
+
+/** An error to deliver after the snapshot. */
+@property(nonatomic, strong, nullable) NSError *error;
+
+@end
+
+@implementation FSTPendingSnapshotEvent
+
+- (instancetype)initWithHandler:(FSTViewSnapshotHandler)handler {
+  if (self = [super init]) {
+    _handler = handler;
+  }
+  return self;
+}
+
+@end
+
+#pragma mark - FSTSnapshotBatcher
+
+@interface FSTSnapshotBatcher ()
+
+@property(nonatomic, strong, readonly) FSTDispatchQueue *workerDispatchQueue;
+@property(nonatomic, assign, readonly) NSTimeInterval minimumInterval;
+
+/** The pending events by listener, compared by identity. */
+@property(nonatomic, strong, readonly) NSMapTable<id, FSTPendingSnapshotEvent *> *pendingEvents;
+
+/** The listeners with pending events, in the order their first event was raised. */
+@property(nonatomic, strong, readonly) NSMutableArray<id> *pendingListeners;
+
+@property(nonatomic, assign) BOOL deliveryScheduled;
+
+@property(nonatomic, strong, nullable) NSDate *lastDeliveryDate;
+
+@end
+
+@implementation FSTSnapshotBatcher
+
+- (instancetype)initWithWorkerDispatchQueue:(FSTDispatchQueue *)workerDispatchQueue
+                          userDispatchQueue:(FSTDispatchQueue *)userDispatchQueue
+                            minimumInterval:(NSTimeInterval)minimumInterval {
+  if (self = [super init]) {
+    _workerDispatchQueue = workerDispatchQueue;
+    _userDispatchQueue = userDispatchQueue;
+    _minimumInterval = minimumInterval;
+    _pendingEvents = [NSMapTable
+        mapTableWithKeyOptions:NSPointerFunctionsStrongMemory |
+                               NSPointerFunctionsObjectPointerPersonality
+                  valueOptions:NSPointerFunctionsStrongMemory];
+    _pendingListeners = [NSMutableArray array];
+  }
+  return self;
+}
+
+- (void)enqueueSnapshot:(nullable FSTViewSnapshot *)snapshot
+                  error:(nullable NSError *)error
+            forListener:(id)listener
+                handler:(FSTViewSnapshotHandler)handler {
+  [self.workerDispatchQueue verifyIsCurrentQueue];
+
+  FSTPendingSnapshotEvent *event = [self.pendingEvents objectForKey:listener];
+  if (!event) {
+    event = [[FSTPendingSnapshotEvent alloc] initWithHandler:handler];
+    [self.pendingEvents setObject:event forKey:listener];
+    [self.pendingListeners addObject:listener];
+  }
+
+  if (event.error) {
+    // Listeners raise nothing after an error.
+    return;
+  } else if (error) {
+    event.error = error;
+  } else if (event.snapshot) {
+    event.snapshot = [event.snapshot snapshotByMergingSnapshot:snapshot];
+  } else {
+    event.snapshot = snapshot;
+  }
+
+  [self scheduleDelivery];
+}
+
+- (void)scheduleDelivery {
+  if (self.deliveryScheduled) {
+    return;
+  }
+  self.deliveryScheduled = YES;
+
+  // Delivering from a separate task lets everything raised by the current one join the batch.
+  void (^deliver)(void) = ^{
+    [self deliverPendingEvents];
+  };
+  NSTimeInterval delay = 0;
+  if (self.minimumInterval > 0 && self.lastDeliveryDate) {
+    delay = self.minimumInterval + [self.lastDeliveryDate timeIntervalSinceNow];
+  }
+  if (delay > 0) {
+    [self.workerDispatchQueue dispatchAfterDelay:delay block:deliver];
+  } else {
+    [self.workerDispatchQueue dispatchAsyncAllowingSameQueue:deliver];
+  }
+}
+
+- (void)deliverPendingEvents {
+  self.deliveryScheduled = NO;
+  self.lastDeliveryDate = [NSDate date];
+
+  NSMutableArray<FSTPendingSnapshotEvent *> *events = [NSMutableArray array];
+  for (id listener in self.pendingListeners) {
+    [events addObject:[self.pendingEvents objectForKey:listener]];
+  }
+  [self.pendingEvents removeAllObjects];
+  [self.pendingListeners removeAllObjects];
+
+  [self.userDispatchQueue dispatchAsync:^{
+    for (FSTPendingSnapshotEvent *event in events) {
+      if (event.snapshot) {
+        event.handler(event.snapshot, nil);
+      }
+      if (event.error) {
+        event.handler(nil, event.error);
+      }
+    }
+  }];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
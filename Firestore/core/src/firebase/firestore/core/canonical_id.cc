@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/canonical_id.h"
+
+#include <stdarg.h>
+
+#include "Firestore/core/src/firebase/firestore/util/string_printf.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+namespace {
+
+const uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+const uint64_t kFnvPrime = 1099511628211ULL;
+
+}  // namespace
+
+uint64_t CanonicalIdFingerprint(absl::string_view canonical_id) {
+  uint64_t fingerprint = kFnvOffsetBasis;
+  for (char c : canonical_id) {
+    fingerprint ^= static_cast<uint8_t>(c);
+    fingerprint *= kFnvPrime;
+  }
+  return fingerprint;
+}
+
+CanonicalIdBuilder& CanonicalIdBuilder::AppendInteger(int64_t value) {
+  // Format backwards into a buffer large enough for any int64_t, working with
+  // the magnitude as unsigned so that the minimum value doesn't overflow.
+  char buf[20];
+  char* end = buf + sizeof(buf);
+  char* start = end;
+  uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value)
+                                 : static_cast<uint64_t>(value);
+  do {
+    *--start = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+
+  if (value < 0) {
+    id_.push_back('-');
+  }
+  id_.append(start, end);
+  return *this;
+}
+
+void CanonicalIdBuilder::AppendF(const char* format, ...) {
+  va_list ap;
+  va_start(ap, format);
+  util::StringAppendV(&id_, format, ap);
+  va_end(ap);
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_CANONICAL_ID_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_CANONICAL_ID_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "absl/base/attributes.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * Returns a stable 64-bit hash of a canonical ID: the 64-bit FNV-1a hash of
+ * its bytes. The result does not vary across processes or platforms, so it is
+ * safe to persist.
+ */
+uint64_t CanonicalIdFingerprint(absl::string_view canonical_id);
+
+/**
+ * Assembles a canonical ID, the string that names everything about a query
+ * that determines its results, by appending pieces to a buffer that can be
+ * reused for the next ID.
+ *
+ * Not thread-safe.
+ */
+class CanonicalIdBuilder {
+ public:
+  CanonicalIdBuilder() = default;
+
+  /** Discards the ID built so far, keeping the buffer for the next one. */
+  void Clear() {
+    id_.clear();
+  }
+
+  /** Appends the given piece verbatim. */
+  CanonicalIdBuilder& Append(absl::string_view piece) {
+    id_.append(piece.data(), piece.size());
+    return *this;
+  }
+
+  /** Appends an integer in decimal. */
+  CanonicalIdBuilder& AppendInteger(int64_t value);
+
+  /** Appends printf-style formatted output. */
+  void AppendF(const char* format, ...) ABSL_PRINTF_ATTRIBUTE(2, 3);
+
+  /** Returns the ID built so far. */
+  const std::string& id() const {
+    return id_;
+  }
+
+  /** Returns the CanonicalIdFingerprint of the ID built so far. */
+  uint64_t Fingerprint() const {
+    return CanonicalIdFingerprint(id_);
+  }
+
+ private:
+  std::string id_;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_CANONICAL_ID_H_
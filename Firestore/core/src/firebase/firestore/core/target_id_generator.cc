@@ -16,12 +16,16 @@
 
 #include "Firestore/core/src/firebase/firestore/core/target_id_generator.h"
 
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
 namespace firebase {
 namespace firestore {
 namespace core {
 
 TargetIdGenerator::TargetIdGenerator(const TargetIdGenerator& value)
-    : generator_id_(value.generator_id_), previous_id_(value.previous_id_) {
+    : generator_id_(value.generator_id_),
+      previous_id_(value.previous_id_),
+      reserved_id_(value.reserved_id_) {
 }
 
 TargetIdGenerator::TargetIdGenerator(TargetIdGeneratorId generator_id,
@@ -50,6 +54,7 @@ TargetIdGenerator::TargetIdGenerator(TargetIdGeneratorId generator_id,
     //   next = 0b1011
     previous_id_ = (after_without_generator | generator) - (1 << kReservedBits);
   }
+  reserved_id_ = previous_id_;
 }
 
 TargetId TargetIdGenerator::NextId() {
@@ -57,6 +62,13 @@ TargetId TargetIdGenerator::NextId() {
   return previous_id_;
 }
 
+TargetId TargetIdGenerator::ReserveBlock(int count) {
+  FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(count > 0, count > 0,
+                                          "Invalid block size: %d", count);
+  reserved_id_ = previous_id_ + (count << kReservedBits);
+  return reserved_id_;
+}
+
 }  // namespace core
 }  // namespace firestore
 }  // namespace firebase
@@ -33,6 +33,11 @@ enum class TargetIdGeneratorId { LocalStore = 0, SyncEngine = 1 };
  * the same ID. This is useful, because sometimes the backend may group IDs from
  * separate parts of the client into the same ID space.
  *
+ * Generators whose IDs must not be reused across restarts can hand them out
+ * from reserved blocks (hi/lo allocation): the caller persists the end of each
+ * block returned by ReserveBlock() and seeds the next generator with it, which
+ * costs one write per block instead of one per ID.
+ *
  * Not thread-safe.
  */
 class TargetIdGenerator {
@@ -68,10 +73,28 @@ class TargetIdGenerator {
 
   TargetId NextId();
 
+  /**
+   * Returns true if the next call to NextId() would return an ID beyond the
+   * end of the last block reserved with ReserveBlock().
+   */
+  bool NeedsReservation() const {
+    return previous_id_ >= reserved_id_;
+  }
+
+  /**
+   * Reserves the next `count` IDs as a block.
+   *
+   * @return The highest ID in the block, which must be persisted before any of
+   *     the block's IDs are used.
+   */
+  TargetId ReserveBlock(int count);
+
  private:
   TargetIdGenerator(TargetIdGeneratorId generator_id, TargetId after);
   TargetIdGeneratorId generator_id_;
   TargetId previous_id_;
+  // The highest ID reserved so far, or previous_id_ if none are reserved.
+  TargetId reserved_id_;
 
   static const int kReservedBits = 1;
 };
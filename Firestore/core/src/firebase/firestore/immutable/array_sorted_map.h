@@ -18,13 +18,16 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_ARRAY_SORTED_MAP_H_
 
 #include <algorithm>
-#include <array>
 #include <cassert>
 #include <functional>
+#include <iterator>
 #include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/immutable/map_entry.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map_base.h"
 
 namespace firebase {
 namespace firestore {
@@ -32,36 +35,6 @@ namespace immutable {
 
 namespace impl {
 
-/**
- * A base class for implementing ArraySortedMap, containing types and constants
- * that don't depend upon the template parameters to the main class.
- *
- * Note that this exists as a base class rather than as just a namespace in
- * order to make it possible for users of ArraySortedMap to avoid needing to
- * declare storage for each instantiation of the template.
- */
-class ArraySortedMapBase {
- public:
-  /**
-   * The type of size() methods on immutable collections. Note that this is not
-   * size_t specifically to save space in the TreeSortedMap implementation.
-   */
-  using size_type = uint32_t;
-
-  /**
-   * The maximum size of an ArraySortedMap.
-   *
-   * This is the size threshold where we use a tree backed sorted map instead of
-   * an array backed sorted map. This is a more or less arbitrary chosen value,
-   * that was chosen to be large enough to fit most of object kind of Firebase
-   * data, but small enough to not notice degradation in performance for
-   * inserting and lookups. Feel free to empirically determine this constant,
-   * but don't expect much gain in real world performance.
-   */
-  // TODO(wilhuff): actually use this for switching implementations.
-  static constexpr size_type kFixedSize = 25;
-};
-
 /**
  * A bounded-size array that allocates its contents directly in itself. This
  * saves a heap allocation when compared with std::vector (though std::vector
@@ -69,7 +42,8 @@ class ArraySortedMapBase {
  *
  * Unlike std::array, FixedArray keeps track of its size and grows up to the
  * fixed_size limit. Inserting more elements than fixed_size will trigger an
- * assertion failure.
+ * assertion failure. Only the elements actually in the array are constructed
+ * (and later destroyed): the rest of its storage is left uninitialized.
  *
  * ArraySortedMap does not actually contain its array: it contains a shared_ptr
  * to a FixedArray.
@@ -77,13 +51,14 @@ class ArraySortedMapBase {
  * @tparam T The type of an element in the array.
  * @tparam fixed_size the fixed size to use in creating the FixedArray.
  */
-template <typename T, ArraySortedMapBase::size_type fixed_size>
+template <typename T, SortedMapBase::size_type fixed_size>
 class FixedArray {
  public:
-  using size_type = ArraySortedMapBase::size_type;
-  using array_type = std::array<T, fixed_size>;
-  using iterator = typename array_type::iterator;
-  using const_iterator = typename array_type::const_iterator;
+  using size_type = SortedMapBase::size_type;
+  using storage_type =
+      typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+  using iterator = T*;
+  using const_iterator = const T*;
 
   FixedArray() {
   }
@@ -93,6 +68,15 @@ class FixedArray {
     append(src_begin, src_end);
   }
 
+  FixedArray(const FixedArray&) = delete;
+  FixedArray& operator=(const FixedArray&) = delete;
+
+  ~FixedArray() {
+    for (iterator iter = begin(); iter != end(); ++iter) {
+      iter->~T();
+    }
+  }
+
   /**
    * Appends to this array, copying from the given src_begin up to but not
    * including the src_end.
@@ -103,23 +87,35 @@ class FixedArray {
     size_type new_size = size_ + appending;
     assert(new_size <= fixed_size);
 
-    std::copy(src_begin, src_end, end());
-    size_ = new_size;
+    for (; src_begin != src_end; ++src_begin) {
+      emplace(*src_begin);
+    }
   }
 
   /**
    * Appends a single value to the array.
    */
   void append(T&& value) {
+    emplace(std::move(value));
+  }
+
+  /**
+   * Appends a single value to the array, constructing it in place from the
+   * given arguments.
+   */
+  template <typename... Args>
+  void emplace(Args&&... args) {
     size_type new_size = size_ + 1;
     assert(new_size <= fixed_size);
 
-    *end() = std::move(value);
+    new (end()) T(std::forward<Args>(args)...);
+    // Only count the element once it's constructed so that the destructor
+    // doesn't destroy it if its constructor throws.
     size_ = new_size;
   }
 
   const_iterator begin() const {
-    return contents_.begin();
+    return reinterpret_cast<const T*>(contents_);
   }
 
   const_iterator end() const {
@@ -132,25 +128,44 @@ class FixedArray {
 
  private:
   iterator begin() {
-    return contents_.begin();
+    return reinterpret_cast<T*>(contents_);
   }
 
   iterator end() {
     return begin() + size_;
   }
 
-  array_type contents_;
+  storage_type contents_[fixed_size];
   size_type size_ = 0;
 };
 
+/**
+ * Chooses how ArraySortedMap searches for keys of type K. An ArraySortedMap
+ * holds at most kFixedSize entries, so for keys that are cheap to compare a
+ * linear scan (which is branch-predictor and prefetcher friendly) beats a
+ * binary search. Keys with more expensive comparisons, such as strings, still
+ * use a binary search to keep the number of comparisons down.
+ *
+ * Specialize this for other key types that should be scanned linearly.
+ */
+template <typename K>
+struct UseLinearSearch
+    : std::integral_constant<bool,
+                             std::is_arithmetic<K>::value ||
+                                 std::is_enum<K>::value> {};
+
 }  // namespace impl
 
 /**
  * ArraySortedMap is a value type containing a map. It is immutable, but has
  * methods to efficiently create new maps that are mutations of it.
+ *
+ * If the comparator C is transparent (i.e. declares an is_transparent member
+ * type), find() and the bound functions also accept any key-like value that C
+ * can compare with a K, e.g. an absl::string_view for a map of std::strings.
  */
 template <typename K, typename V, typename C = std::less<K>>
-class ArraySortedMap : public impl::ArraySortedMapBase {
+class ArraySortedMap : public impl::SortedMapBase {
  public:
   using key_comparator_type = KeyComparator<K, V, C>;
 
@@ -163,7 +178,15 @@ class ArraySortedMap : public impl::ArraySortedMapBase {
    * The type of the fixed-size array containing entries of value_type.
    */
   using array_type = impl::FixedArray<value_type, kFixedSize>;
-  using const_iterator = typename array_type::const_iterator;
+
+  /**
+   * The type of iterators over the map. This is spelled out (rather than
+   * taken from array_type) so that naming an ArraySortedMap does not require
+   * value_type to be complete, which allows e.g. a FieldValue to contain a
+   * map of FieldValues.
+   */
+  using const_iterator = const value_type*;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
   using array_pointer = std::shared_ptr<const array_type>;
 
@@ -183,6 +206,20 @@ class ArraySortedMap : public impl::ArraySortedMapBase {
         key_comparator_(comparator) {
   }
 
+  /**
+   * Creates an ArraySortedMap containing the entries in the given range,
+   * copying them exactly once. The entries must already be sorted by key
+   * according to the comparator, must not contain duplicate keys, and must
+   * number no more than kFixedSize.
+   */
+  template <typename Iterator>
+  static ArraySortedMap CreateFromSorted(Iterator begin,
+                                         Iterator end,
+                                         const C& comparator = C()) {
+    return ArraySortedMap{std::make_shared<array_type>(begin, end),
+                          key_comparator_type{comparator}};
+  }
+
   /**
    * Creates a new map identical to this one, but with a key-value pair added or
    * updated.
@@ -192,33 +229,15 @@ class ArraySortedMap : public impl::ArraySortedMapBase {
    * @return A new dictionary with the added/updated value.
    */
   ArraySortedMap insert(const K& key, const V& value) const {
-    const_iterator current_end = end();
-    const_iterator pos = LowerBound(key);
-    bool replacing_entry = false;
-
-    if (pos != current_end) {
-      // LowerBound found an entry where pos->first >= pair.first. Reversing the
-      // argument order here tests pair.first < pos->first.
-      replacing_entry = !key_comparator_(key, *pos);
-      if (replacing_entry && value == pos->second) {
-        return *this;
-      }
-    }
-
-    // Copy the segment before the found position. If not found, this is
-    // everything.
-    auto copy = std::make_shared<array_type>(begin(), pos);
-
-    // Copy the value to be inserted.
-    copy->append(value_type(key, value));
+    return Insert(key, value);
+  }
 
-    if (replacing_entry) {
-      // Skip the thing at pos because it compares the same as the pair above.
-      copy->append(pos + 1, current_end);
-    } else {
-      copy->append(pos, current_end);
-    }
-    return wrap(copy);
+  /**
+   * Creates a new map identical to this one, but with a key-value pair added or
+   * updated, moving the key and value into the new map.
+   */
+  ArraySortedMap insert(K&& key, V&& value) const {
+    return Insert(std::move(key), std::move(value));
   }
 
   /**
@@ -251,16 +270,90 @@ class ArraySortedMap : public impl::ArraySortedMapBase {
    *     not found.
    */
   const_iterator find(const K& key) const {
-    const_iterator not_found = end();
-    const_iterator lower_bound = LowerBound(key);
-    if (lower_bound != not_found && !key_comparator_(key, *lower_bound)) {
-      return lower_bound;
-    } else {
-      return not_found;
+    return Find(key);
+  }
+
+  /**
+   * Finds a value in the map by a key-like value. Only available if the
+   * comparator is transparent.
+   */
+  template <typename KK,
+            typename CC = C,
+            typename = typename CC::is_transparent>
+  const_iterator find(const KK& key) const {
+    return Find(key);
+  }
+
+  /**
+   * Finds the first entry in the map whose key is not less than the given key.
+   *
+   * @param key The key to look up.
+   * @return An iterator pointing to the entry, or end() if all keys in the map
+   *     are less than the given key.
+   */
+  const_iterator lower_bound(const K& key) const {
+    return LowerBound(key);
+  }
+
+  template <typename KK,
+            typename CC = C,
+            typename = typename CC::is_transparent>
+  const_iterator lower_bound(const KK& key) const {
+    return LowerBound(key);
+  }
+
+  /**
+   * Finds the first entry in the map whose key is greater than the given key.
+   *
+   * @param key The key to look up.
+   * @return An iterator pointing to the entry, or end() if no key in the map
+   *     is greater than the given key.
+   */
+  const_iterator upper_bound(const K& key) const {
+    return UpperBound(key);
+  }
+
+  template <typename KK,
+            typename CC = C,
+            typename = typename CC::is_transparent>
+  const_iterator upper_bound(const KK& key) const {
+    return UpperBound(key);
+  }
+
+  /**
+   * Finds the last entry in the map whose key is not greater than the given
+   * key.
+   *
+   * @return A reverse iterator pointing to the entry, or rend() if all keys in
+   *     the map are greater than the given key.
+   */
+  const_reverse_iterator reverse_upper_bound(const K& key) const {
+    return const_reverse_iterator{upper_bound(key)};
+  }
+
+  /**
+   * Finds the position of a key in the map.
+   *
+   * @param key The key to look up.
+   * @return The number of entries whose keys are less than the key, or npos if
+   *     the key isn't in the map.
+   */
+  size_type find_index(const K& key) const {
+    const_iterator found = find(key);
+    if (found == end()) {
+      return npos;
     }
+    return static_cast<size_type>(found - begin());
   }
 
-  // TODO(wilhuff): indexof
+  /**
+   * Returns the entry at the given position in key order, which must be less
+   * than size().
+   */
+  const value_type& at_index(size_type index) const {
+    assert(index < size());
+    return begin()[index];
+  }
 
   /** Returns true if the map contains no elements. */
   bool empty() const {
@@ -272,6 +365,11 @@ class ArraySortedMap : public impl::ArraySortedMapBase {
     return array_->size();
   }
 
+  /** Returns the comparator used to order keys in this map. */
+  const C& comparator() const {
+    return key_comparator_.comparator();
+  }
+
   /**
    * Returns an iterator pointing to the first entry in the map. If there are
    * no entries in the map, begin() == end().
@@ -287,6 +385,20 @@ class ArraySortedMap : public impl::ArraySortedMapBase {
     return array_->end();
   }
 
+  /**
+   * Returns a reverse iterator pointing to the last entry in the map.
+   */
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator{end()};
+  }
+
+  /**
+   * Returns a reverse iterator pointing before the first entry in the map.
+   */
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator{begin()};
+  }
+
  private:
   static array_pointer EmptyArray() {
     static const array_pointer kEmptyArray =
@@ -303,10 +415,94 @@ class ArraySortedMap : public impl::ArraySortedMapBase {
     return ArraySortedMap(array, key_comparator_);
   }
 
-  const_iterator LowerBound(const K& key) const {
+  /**
+   * Implements both insert overloads: KK and VV are K and V as const
+   * references or rvalues.
+   */
+  template <typename KK, typename VV>
+  ArraySortedMap Insert(KK&& key, VV&& value) const {
+    const_iterator current_end = end();
+    const_iterator pos = LowerBound(key);
+    bool replacing_entry = false;
+
+    if (pos != current_end) {
+      // LowerBound found an entry where pos->first >= pair.first. Reversing the
+      // argument order here tests pair.first < pos->first.
+      replacing_entry = !key_comparator_(key, *pos);
+      if (replacing_entry && value == pos->second) {
+        return *this;
+      }
+    }
+
+    // Copy the segment before the found position. If not found, this is
+    // everything.
+    auto copy = std::make_shared<array_type>(begin(), pos);
+
+    // Construct the entry to be inserted in place.
+    copy->emplace(std::forward<KK>(key), std::forward<VV>(value));
+
+    if (replacing_entry) {
+      // Skip the thing at pos because it compares the same as the pair above.
+      copy->append(pos + 1, current_end);
+    } else {
+      copy->append(pos, current_end);
+    }
+    return wrap(copy);
+  }
+
+  using linear_search = typename impl::UseLinearSearch<K>::type;
+
+  template <typename KK>
+  const_iterator Find(const KK& key) const {
+    const_iterator not_found = end();
+    const_iterator lower_bound = LowerBound(key);
+    if (lower_bound != not_found && !key_comparator_(key, *lower_bound)) {
+      return lower_bound;
+    } else {
+      return not_found;
+    }
+  }
+
+  template <typename KK>
+  const_iterator LowerBound(const KK& key) const {
+    return LowerBound(key, linear_search{});
+  }
+
+  template <typename KK>
+  const_iterator LowerBound(const KK& key, std::true_type) const {
+    const_iterator iter = begin();
+    const_iterator last = end();
+    while (iter != last && key_comparator_(*iter, key)) {
+      ++iter;
+    }
+    return iter;
+  }
+
+  template <typename KK>
+  const_iterator LowerBound(const KK& key, std::false_type) const {
     return std::lower_bound(begin(), end(), key, key_comparator_);
   }
 
+  template <typename KK>
+  const_iterator UpperBound(const KK& key) const {
+    return UpperBound(key, linear_search{});
+  }
+
+  template <typename KK>
+  const_iterator UpperBound(const KK& key, std::true_type) const {
+    const_iterator iter = begin();
+    const_iterator last = end();
+    while (iter != last && !key_comparator_(key, *iter)) {
+      ++iter;
+    }
+    return iter;
+  }
+
+  template <typename KK>
+  const_iterator UpperBound(const KK& key, std::false_type) const {
+    return std::upper_bound(begin(), end(), key, key_comparator_);
+  }
+
   array_pointer array_;
   key_comparator_type key_comparator_;
 };
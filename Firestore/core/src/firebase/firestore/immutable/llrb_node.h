@@ -0,0 +1,541 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map_base.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * A node in a left-leaning red-black tree.
+ *
+ * LlrbNode is a value type that holds a shared_ptr to its contents. Nodes are
+ * immutable once they're reachable from a TreeSortedMap, so copying a node is
+ * cheap and mutations return a new node that shares all unmodified subtrees
+ * with the original.
+ *
+ * This is a port of the Objective-C FSTLLRBValueNode/FSTLLRBEmptyNode pair,
+ * which is in turn a port of the Java/JavaScript LLRB implementations.
+ *
+ * @tparam K The type of the keys in the tree.
+ * @tparam V The type of the values in the tree.
+ * @tparam A The allocator used to allocate node contents. It must be
+ *     stateless: instances are default constructed as needed and rebound to
+ *     node-sized types. See SlabAllocator.
+ */
+template <typename K, typename V, typename A = std::allocator<K>>
+class LlrbNode : public SortedMapBase {
+ public:
+  using first_type = K;
+  using second_type = V;
+  using allocator_type = A;
+
+  /**
+   * The type of the entries stored in the tree.
+   */
+  using value_type = std::pair<K, V>;
+
+  /**
+   * The color of a tree node.
+   */
+  enum Color : unsigned int {
+    Black = 0u,
+    Red = 1u,
+  };
+
+  /**
+   * Constructs an empty node.
+   */
+  LlrbNode() : LlrbNode(EmptyRep()) {
+  }
+
+  /** Returns the number of elements at this node or beneath it in the tree. */
+  size_type size() const {
+    return rep_->size_;
+  }
+
+  /** Returns true if this is an empty node--a leaf node in the tree. */
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /** Returns true if this node is red (as opposed to black). */
+  bool red() const {
+    return static_cast<bool>(rep_->color_);
+  }
+
+  Color color() const {
+    return static_cast<Color>(rep_->color_);
+  }
+
+  const value_type& entry() const {
+    return rep_->entry_;
+  }
+  const K& key() const {
+    return entry().first;
+  }
+  const V& value() const {
+    return entry().second;
+  }
+
+  const LlrbNode& left() const {
+    return rep_->left_;
+  }
+  const LlrbNode& right() const {
+    return rep_->right_;
+  }
+
+  /**
+   * Returns the left-most descendant of this node, which contains the smallest
+   * key. Must not be called on an empty node.
+   */
+  const LlrbNode& min() const {
+    const LlrbNode* node = this;
+    while (!node->left().empty()) {
+      node = &node->left();
+    }
+    return *node;
+  }
+
+  /**
+   * Returns the right-most descendant of this node, which contains the largest
+   * key. Must not be called on an empty node.
+   */
+  const LlrbNode& max() const {
+    const LlrbNode* node = this;
+    while (!node->right().empty()) {
+      node = &node->right();
+    }
+    return *node;
+  }
+
+  /**
+   * Returns a tree node with the given key-value pair set/updated. The
+   * returned node is always black, suitable for use as the root of a tree.
+   */
+  template <typename Comparator>
+  LlrbNode insert(const K& key,
+                  const V& value,
+                  const Comparator& comparator) const {
+    LlrbNode root = InnerInsert(key, value, comparator);
+    // The root must always be black
+    if (root.red()) {
+      root.set_color(Color::Black);
+    }
+    return root;
+  }
+
+  /**
+   * Returns a tree node with the given key removed. The key must be present
+   * in the tree rooted at this node; callers should check with a lookup
+   * first. The returned node is always black, suitable for use as the root of
+   * a tree.
+   */
+  template <typename Comparator>
+  LlrbNode erase(const K& key, const Comparator& comparator) const {
+    LlrbNode root = InnerErase(key, comparator);
+    if (root.red()) {
+      root.set_color(Color::Black);
+    }
+    return root;
+  }
+
+  /**
+   * Builds a tree containing the entries in the given range in O(n) time,
+   * without any rebalancing.
+   *
+   * The entries must be sorted by key and must not contain duplicate keys.
+   * Iterator must be a random access iterator over value_type.
+   *
+   * This uses the algorithm described in "Constructing Red-Black Trees" by
+   * Ralf Hinze: the entries are split into a sequence of "pennants" (a node
+   * whose right child is a perfectly balanced black tree) whose sizes follow
+   * the digits of n + 1 written in base {1, 2}.
+   */
+  template <typename Iterator>
+  static LlrbNode BuildFromSorted(Iterator begin, Iterator end);
+
+ private:
+  struct Rep;
+
+  using rep_allocator_type =
+      typename std::allocator_traits<A>::template rebind_alloc<Rep>;
+
+  explicit LlrbNode(const std::shared_ptr<Rep>& rep) : rep_(rep) {
+  }
+
+  LlrbNode(const value_type& entry,
+           Color color,
+           const LlrbNode& left,
+           const LlrbNode& right)
+      : rep_(std::allocate_shared<Rep>(rep_allocator_type(),
+                                       entry,
+                                       color,
+                                       left,
+                                       right)) {
+  }
+
+  /**
+   * Returns an empty node with no entries, whose left and right links also
+   * point to the empty node.
+   */
+  static const std::shared_ptr<Rep>& EmptyRep();
+
+  /**
+   * Returns a shallow copy of this node: the new node shares its children
+   * with this one but is otherwise independently modifiable. The mutators
+   * below must only be called on nodes produced this way.
+   */
+  LlrbNode Clone() const {
+    return LlrbNode(std::allocate_shared<Rep>(rep_allocator_type(), *rep_));
+  }
+
+  void set_entry(const value_type& entry) {
+    rep_->entry_ = entry;
+  }
+
+  void set_value(const V& value) {
+    rep_->entry_.second = value;
+  }
+
+  void set_color(Color color) {
+    rep_->color_ = color;
+  }
+
+  void set_left(LlrbNode&& left) {
+    rep_->left_ = std::move(left);
+    rep_->UpdateSize();
+  }
+
+  void set_right(LlrbNode&& right) {
+    rep_->right_ = std::move(right);
+    rep_->UpdateSize();
+  }
+
+  template <typename Comparator>
+  LlrbNode InnerInsert(const K& key,
+                       const V& value,
+                       const Comparator& comparator) const;
+
+  template <typename Comparator>
+  LlrbNode InnerErase(const K& key, const Comparator& comparator) const;
+
+  LlrbNode RemoveMin() const;
+
+  void FixUp();
+  void MoveRedLeft();
+  void MoveRedRight();
+  void RotateLeft();
+  void RotateRight();
+  void FlipColor();
+
+  template <typename Iterator>
+  static LlrbNode BuildBalanced(Iterator begin, size_type length);
+
+  static Color OppositeColor(Color color) {
+    return color == Color::Black ? Color::Red : Color::Black;
+  }
+
+  std::shared_ptr<Rep> rep_;
+};
+
+/**
+ * The contents of an LlrbNode.
+ */
+template <typename K, typename V, typename A>
+struct LlrbNode<K, V, A>::Rep {
+  // Only used to construct the empty Rep. The links are filled in by
+  // EmptyRep() once the Rep exists.
+  Rep() : size_(0), color_(Color::Black), left_(nullptr), right_(nullptr) {
+  }
+
+  Rep(const value_type& entry,
+      Color color,
+      const LlrbNode& left,
+      const LlrbNode& right)
+      : entry_(entry),
+        size_(left.size() + 1 + right.size()),
+        color_(color),
+        left_(left),
+        right_(right) {
+  }
+
+  void UpdateSize() {
+    size_ = left_.size() + 1 + right_.size();
+  }
+
+  value_type entry_;
+
+  // Store the size and color together to save space on 64-bit platforms.
+  size_type size_ : 31;
+  unsigned int color_ : 1;
+
+  LlrbNode left_;
+  LlrbNode right_;
+};
+
+template <typename K, typename V, typename A>
+const std::shared_ptr<typename LlrbNode<K, V, A>::Rep>&
+LlrbNode<K, V, A>::EmptyRep() {
+  static const std::shared_ptr<Rep> kEmptyRep = [] {
+    auto empty = std::allocate_shared<Rep>(rep_allocator_type());
+
+    // Set up the empty Rep such that you can traverse infinitely down left and
+    // right links. This intentionally creates a cycle that is never freed.
+    empty->left_.rep_ = empty;
+    empty->right_.rep_ = empty;
+    return empty;
+  }();
+  return kEmptyRep;
+}
+
+template <typename K, typename V, typename A>
+template <typename Iterator>
+LlrbNode<K, V, A> LlrbNode<K, V, A>::BuildFromSorted(Iterator begin,
+                                                     Iterator end) {
+  auto length = static_cast<size_type>(end - begin);
+
+  // Compute the base {1, 2} representation of length + 1: digit_count is the
+  // number of digits and bit i of digits is 0 wherever the corresponding
+  // digit is a 2.
+  uint64_t n = static_cast<uint64_t>(length) + 1;
+  int digit_count = 0;
+  while ((n >> (digit_count + 1)) != 0) {
+    digit_count++;
+  }
+  uint64_t digits = n & ((uint64_t{1} << digit_count) - 1);
+
+  // Build the pennants from the largest entries down. Each pennant becomes
+  // the left child of the one before it.
+  std::vector<LlrbNode> pennants;
+  size_type index = length;
+  auto build_pennant = [&](Color color, size_type chunk_size) {
+    index -= chunk_size;
+    LlrbNode child = BuildBalanced(begin + index + 1, chunk_size - 1);
+    pennants.push_back(
+        LlrbNode(*(begin + index), color, LlrbNode(), std::move(child)));
+  };
+
+  for (int i = digit_count - 1; i >= 0; i--) {
+    auto chunk_size = static_cast<size_type>(uint64_t{1} << i);
+    bool is_one = (digits & (uint64_t{1} << i)) == 0;
+    build_pennant(Color::Black, chunk_size);
+    if (!is_one) {
+      build_pennant(Color::Red, chunk_size);
+    }
+  }
+
+  // Link the pennants together from the bottom up, so that sizes of the
+  // upper pennants account for everything beneath them.
+  LlrbNode root;
+  for (auto iter = pennants.rbegin(); iter != pennants.rend(); ++iter) {
+    if (!root.empty()) {
+      iter->set_left(std::move(root));
+    }
+    root = std::move(*iter);
+  }
+  return root;
+}
+
+template <typename K, typename V, typename A>
+template <typename Iterator>
+LlrbNode<K, V, A> LlrbNode<K, V, A>::BuildBalanced(Iterator begin,
+                                                   size_type length) {
+  if (length == 0) {
+    return LlrbNode();
+  }
+
+  size_type middle = length / 2;
+  LlrbNode left = BuildBalanced(begin, middle);
+  LlrbNode right = BuildBalanced(begin + middle + 1, length - middle - 1);
+  return LlrbNode(*(begin + middle), Color::Black, left, right);
+}
+
+template <typename K, typename V, typename A>
+template <typename Comparator>
+LlrbNode<K, V, A> LlrbNode<K, V, A>::InnerInsert(
+    const K& key, const V& value, const Comparator& comparator) const {
+  if (empty()) {
+    return LlrbNode(value_type(key, value), Color::Red, *this, *this);
+  }
+
+  LlrbNode result = Clone();
+  if (comparator(key, this->key())) {
+    result.set_left(left().InnerInsert(key, value, comparator));
+  } else if (comparator(this->key(), key)) {
+    result.set_right(right().InnerInsert(key, value, comparator));
+  } else {
+    result.set_value(value);
+  }
+  result.FixUp();
+  return result;
+}
+
+template <typename K, typename V, typename A>
+template <typename Comparator>
+LlrbNode<K, V, A> LlrbNode<K, V, A>::InnerErase(
+    const K& key, const Comparator& comparator) const {
+  if (empty()) {
+    return *this;
+  }
+
+  LlrbNode n = Clone();
+  if (comparator(key, n.key())) {
+    if (!n.left().empty() && !n.left().red() && !n.left().left().red()) {
+      n.MoveRedLeft();
+    }
+    n.set_left(n.left().InnerErase(key, comparator));
+
+  } else {
+    if (n.left().red()) {
+      n.RotateRight();
+    }
+
+    if (!n.right().empty() && !n.right().red() && !n.right().left().red()) {
+      n.MoveRedRight();
+    }
+
+    if (!comparator(key, n.key()) && !comparator(n.key(), key)) {
+      if (n.right().empty()) {
+        return LlrbNode();
+      }
+
+      // Replace this node's entry with its successor's and then remove the
+      // successor from the right subtree.
+      n.set_entry(n.right().min().entry());
+      n.set_right(n.right().RemoveMin());
+
+    } else {
+      n.set_right(n.right().InnerErase(key, comparator));
+    }
+  }
+  n.FixUp();
+  return n;
+}
+
+template <typename K, typename V, typename A>
+LlrbNode<K, V, A> LlrbNode<K, V, A>::RemoveMin() const {
+  if (left().empty()) {
+    return LlrbNode();
+  }
+
+  LlrbNode n = Clone();
+  if (!n.left().red() && !n.left().left().red()) {
+    n.MoveRedLeft();
+  }
+  n.set_left(n.left().RemoveMin());
+  n.FixUp();
+  return n;
+}
+
+template <typename K, typename V, typename A>
+void LlrbNode<K, V, A>::FixUp() {
+  if (right().red() && !left().red()) {
+    RotateLeft();
+  }
+  if (left().red() && left().left().red()) {
+    RotateRight();
+  }
+  if (left().red() && right().red()) {
+    FlipColor();
+  }
+}
+
+template <typename K, typename V, typename A>
+void LlrbNode<K, V, A>::MoveRedLeft() {
+  FlipColor();
+  if (right().left().red()) {
+    LlrbNode new_right = right().Clone();
+    new_right.RotateRight();
+    set_right(std::move(new_right));
+    RotateLeft();
+    FlipColor();
+  }
+}
+
+template <typename K, typename V, typename A>
+void LlrbNode<K, V, A>::MoveRedRight() {
+  FlipColor();
+  if (left().left().red()) {
+    RotateRight();
+    FlipColor();
+  }
+}
+
+template <typename K, typename V, typename A>
+void LlrbNode<K, V, A>::RotateLeft() {
+  // This node is uniquely owned, so it can be reused as the new left child
+  // rather than being copied again.
+  LlrbNode new_this = right().Clone();
+  LlrbNode new_left = std::move(*this);
+  Color color = new_left.color();
+
+  new_left.set_right(LlrbNode(new_this.left()));
+  new_left.set_color(Color::Red);
+
+  new_this.set_left(std::move(new_left));
+  new_this.set_color(color);
+  *this = std::move(new_this);
+}
+
+template <typename K, typename V, typename A>
+void LlrbNode<K, V, A>::RotateRight() {
+  LlrbNode new_this = left().Clone();
+  LlrbNode new_right = std::move(*this);
+  Color color = new_right.color();
+
+  new_right.set_left(LlrbNode(new_this.right()));
+  new_right.set_color(Color::Red);
+
+  new_this.set_right(std::move(new_right));
+  new_this.set_color(color);
+  *this = std::move(new_this);
+}
+
+template <typename K, typename V, typename A>
+void LlrbNode<K, V, A>::FlipColor() {
+  if (!left().empty()) {
+    LlrbNode new_left = left().Clone();
+    new_left.set_color(OppositeColor(left().color()));
+    set_left(std::move(new_left));
+  }
+
+  if (!right().empty()) {
+    LlrbNode new_right = right().Clone();
+    new_right.set_color(OppositeColor(right().color()));
+    set_right(std::move(new_right));
+  }
+
+  set_color(OppositeColor(color()));
+}
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_H_
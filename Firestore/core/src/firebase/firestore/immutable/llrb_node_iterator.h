@@ -0,0 +1,211 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_ITERATOR_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_ITERATOR_H_
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * A forward iterator for traversing LlrbNodes in order, or in reverse order
+ * for iterators created by ReverseBegin() or ReverseUpperBound().
+ *
+ * LlrbNodes have no parent pointers, so the iterator keeps an explicit stack
+ * of the nodes whose entries have yet to be visited. The top of the stack is
+ * the current node. The iterator is at the end when the stack is empty.
+ *
+ * Iterators remain valid only as long as the tree they point into.
+ *
+ * @tparam N The type of the node, an instantiation of LlrbNode.
+ */
+template <typename N>
+class LlrbNodeIterator {
+ public:
+  using node_type = N;
+  using value_type = typename N::value_type;
+
+  using iterator_category = std::forward_iterator_tag;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+  using difference_type = std::ptrdiff_t;
+
+  /**
+   * Creates an iterator in the end state.
+   */
+  LlrbNodeIterator() {
+  }
+
+  /**
+   * Returns an iterator pointing to the smallest entry in the tree rooted at
+   * the given node.
+   */
+  static LlrbNodeIterator Begin(const node_type* root) {
+    LlrbNodeIterator result;
+    result.PushLeftmostPath(root);
+    return result;
+  }
+
+  /**
+   * Returns an iterator pointing past the largest entry in the tree.
+   */
+  static LlrbNodeIterator End() {
+    return LlrbNodeIterator();
+  }
+
+  /**
+   * Returns an iterator pointing to the largest entry in the tree rooted at
+   * the given node, which visits the remaining entries in descending order.
+   */
+  static LlrbNodeIterator ReverseBegin(const node_type* root) {
+    LlrbNodeIterator result;
+    result.reverse_ = true;
+    result.PushRightmostPath(root);
+    return result;
+  }
+
+  /**
+   * Returns an iterator pointing to the first entry in the tree rooted at the
+   * given node whose key is not less than the given key, or the end iterator
+   * if there is no such entry.
+   *
+   * @param comparator A comparator for keys that is consistent with the order
+   *     of the tree.
+   */
+  template <typename K, typename Comparator>
+  static LlrbNodeIterator LowerBound(const node_type* root,
+                                     const K& key,
+                                     const Comparator& comparator) {
+    LlrbNodeIterator result;
+    const node_type* node = root;
+    while (!node->empty()) {
+      if (comparator(node->key(), key)) {
+        // The entire left subtree and this node precede the key.
+        node = &node->right();
+      } else {
+        // This node is a candidate, but there may be a smaller one on the
+        // left. Entries on the stack are visited after their left subtrees.
+        result.stack_.push_back(node);
+        node = &node->left();
+      }
+    }
+    return result;
+  }
+
+  /**
+   * Returns an iterator pointing to the last entry in the tree rooted at the
+   * given node whose key is not greater than the given key, which visits the
+   * remaining entries in descending order. Returns the end iterator if there
+   * is no such entry.
+   *
+   * @param comparator A comparator for keys that is consistent with the order
+   *     of the tree.
+   */
+  template <typename K, typename Comparator>
+  static LlrbNodeIterator ReverseUpperBound(const node_type* root,
+                                            const K& key,
+                                            const Comparator& comparator) {
+    LlrbNodeIterator result;
+    result.reverse_ = true;
+    const node_type* node = root;
+    while (!node->empty()) {
+      if (comparator(key, node->key())) {
+        // The entire right subtree and this node follow the key.
+        node = &node->left();
+      } else {
+        // This node is a candidate, but there may be a larger one on the
+        // right. Entries on the stack are visited after their right subtrees.
+        result.stack_.push_back(node);
+        node = &node->right();
+      }
+    }
+    return result;
+  }
+
+  reference operator*() const {
+    return stack_.back()->entry();
+  }
+
+  pointer operator->() const {
+    return &stack_.back()->entry();
+  }
+
+  LlrbNodeIterator& operator++() {
+    const node_type* current = stack_.back();
+    stack_.pop_back();
+    if (reverse_) {
+      PushRightmostPath(&current->left());
+    } else {
+      PushLeftmostPath(&current->right());
+    }
+    return *this;
+  }
+
+  LlrbNodeIterator operator++(int) {
+    LlrbNodeIterator original = *this;
+    ++(*this);
+    return original;
+  }
+
+  /** Returns true if this iterator is at the end of the traversal. */
+  bool is_end() const {
+    return stack_.empty();
+  }
+
+  friend bool operator==(const LlrbNodeIterator& lhs,
+                         const LlrbNodeIterator& rhs) {
+    if (lhs.is_end()) {
+      return rhs.is_end();
+    }
+    return !rhs.is_end() && lhs.stack_.back() == rhs.stack_.back();
+  }
+
+  friend bool operator!=(const LlrbNodeIterator& lhs,
+                         const LlrbNodeIterator& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  void PushLeftmostPath(const node_type* node) {
+    while (!node->empty()) {
+      stack_.push_back(node);
+      node = &node->left();
+    }
+  }
+
+  void PushRightmostPath(const node_type* node) {
+    while (!node->empty()) {
+      stack_.push_back(node);
+      node = &node->right();
+    }
+  }
+
+  std::vector<const node_type*> stack_;
+  bool reverse_ = false;
+};
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_ITERATOR_H_
@@ -27,6 +27,10 @@ namespace immutable {
 /**
  * Compares two keys out of a map entry.
  *
+ * If C is transparent (i.e. declares an is_transparent member type) then map
+ * entries can also be compared against any value C accepts, which allows
+ * looking up entries without first converting the value to a K.
+ *
  * @tparam K The type of the first value in the pair.
  * @tparam V The type of the second value in the pair.
  * @tparam C The comparator for use for values of type K
@@ -51,6 +55,24 @@ struct KeyComparator {
     return key_comparator_(lhs.first, rhs.first);
   }
 
+  template <typename T,
+            typename CC = C,
+            typename = typename CC::is_transparent>
+  bool operator()(const T& lhs, const pair_type& rhs) const noexcept {
+    return key_comparator_(lhs, rhs.first);
+  }
+
+  template <typename T,
+            typename CC = C,
+            typename = typename CC::is_transparent>
+  bool operator()(const pair_type& lhs, const T& rhs) const noexcept {
+    return key_comparator_(lhs.first, rhs);
+  }
+
+  const C& comparator() const {
+    return key_comparator_;
+  }
+
  private:
   C key_comparator_;
 };
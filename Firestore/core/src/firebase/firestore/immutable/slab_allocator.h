@@ -0,0 +1,170 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SLAB_ALLOCATOR_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SLAB_ALLOCATOR_H_
+
+#include <cstddef>
+#include <mutex>  // NOLINT(build/c++11)
+#include <new>
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+namespace impl {
+
+/**
+ * A free list of fixed-size memory blocks, carved out of larger slabs.
+ *
+ * Slabs are never returned to the system: freed blocks go back on the free
+ * list for reuse by later allocations of the same size. This trades peak
+ * memory for avoiding a trip through the general-purpose heap for every tree
+ * node.
+ *
+ * Blocks may be freed on a different thread than the one that allocated them
+ * (e.g. when the last snapshot referencing a node is released on the user's
+ * thread) so the free list is guarded by a mutex. All mutation happens on the
+ * Firestore worker queue, so the lock is almost never contended.
+ *
+ * @tparam block_size The size of each block, which must be a multiple of the
+ *     alignment of std::max_align_t.
+ */
+template <std::size_t block_size>
+class FreeList {
+ public:
+  static_assert(block_size % alignof(std::max_align_t) == 0,
+                "block_size must preserve std::max_align_t alignment");
+
+  /** The number of blocks to carve out of each slab. */
+  static constexpr std::size_t kBlocksPerSlab = 256;
+
+  /**
+   * Returns the process-wide free list for blocks of this size. The list is
+   * intentionally leaked so that blocks freed during static destruction
+   * remain valid.
+   */
+  static FreeList& Instance() {
+    static FreeList* instance = new FreeList();
+    return *instance;
+  }
+
+  void* Allocate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (head_ != nullptr) {
+      Block* result = head_;
+      head_ = head_->next;
+      return result;
+    }
+
+    if (slab_next_ == slab_end_) {
+      slab_next_ = static_cast<char*>(
+          ::operator new(kBlocksPerSlab * block_size));
+      slab_end_ = slab_next_ + kBlocksPerSlab * block_size;
+    }
+    void* result = slab_next_;
+    slab_next_ += block_size;
+    return result;
+  }
+
+  void Deallocate(void* pointer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Block* block = static_cast<Block*>(pointer);
+    block->next = head_;
+    head_ = block;
+  }
+
+ private:
+  struct Block {
+    Block* next;
+  };
+
+  FreeList() {
+  }
+
+  std::mutex mutex_;
+  Block* head_ = nullptr;
+  char* slab_next_ = nullptr;
+  char* slab_end_ = nullptr;
+};
+
+/** Rounds the given size up to a multiple of alignof(std::max_align_t). */
+constexpr std::size_t AlignedBlockSize(std::size_t size) {
+  return (size + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) *
+         alignof(std::max_align_t);
+}
+
+}  // namespace impl
+
+/**
+ * A stateless allocator that serves single-object allocations out of pooled
+ * slabs shared by all allocations of the same (rounded) size.
+ *
+ * This is intended for use as the allocator of the nodes of a TreeSortedMap,
+ * whose insert() and erase() allocate O(log n) small nodes that are all the
+ * same size. Requests for more than one object at a time fall back to
+ * ::operator new.
+ */
+template <typename T>
+class SlabAllocator {
+ public:
+  using value_type = T;
+
+  SlabAllocator() {
+  }
+
+  template <typename U>
+  SlabAllocator(const SlabAllocator<U>&) {  // NOLINT(runtime/explicit)
+  }
+
+  T* allocate(std::size_t n) {
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "SlabAllocator does not support over-aligned types");
+    if (n != 1) {
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    return static_cast<T*>(free_list().Allocate());
+  }
+
+  void deallocate(T* pointer, std::size_t n) {
+    if (n != 1) {
+      ::operator delete(pointer);
+      return;
+    }
+    free_list().Deallocate(pointer);
+  }
+
+  friend bool operator==(const SlabAllocator&, const SlabAllocator&) {
+    return true;
+  }
+
+  friend bool operator!=(const SlabAllocator&, const SlabAllocator&) {
+    return false;
+  }
+
+ private:
+  using free_list_type = impl::FreeList<impl::AlignedBlockSize(sizeof(T))>;
+
+  static free_list_type& free_list() {
+    return free_list_type::Instance();
+  }
+};
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SLAB_ALLOCATOR_H_
@@ -0,0 +1,665 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/array_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map_base.h"
+#include "Firestore/core/src/firebase/firestore/immutable/tree_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/util/iterator_adaptors.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+namespace impl {
+
+/**
+ * A forward iterator over a SortedMap, wrapping the iterator of whichever
+ * implementation currently backs the map.
+ *
+ * @tparam A The iterator type of the array-backed implementation.
+ * @tparam T The iterator type of the tree-backed implementation.
+ */
+template <typename A, typename T>
+class SortedMapIterator {
+ public:
+  using value_type = typename std::iterator_traits<A>::value_type;
+
+  using iterator_category = std::forward_iterator_tag;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+  using difference_type = std::ptrdiff_t;
+
+  explicit SortedMapIterator(A array_iter)
+      : tree_(false), array_iter_(array_iter) {
+  }
+
+  explicit SortedMapIterator(T tree_iter)
+      : tree_(true), tree_iter_(std::move(tree_iter)) {
+  }
+
+  reference operator*() const {
+    return tree_ ? *tree_iter_ : *array_iter_;
+  }
+
+  pointer operator->() const {
+    return &**this;
+  }
+
+  SortedMapIterator& operator++() {
+    if (tree_) {
+      ++tree_iter_;
+    } else {
+      ++array_iter_;
+    }
+    return *this;
+  }
+
+  SortedMapIterator operator++(int) {
+    SortedMapIterator original = *this;
+    ++(*this);
+    return original;
+  }
+
+  friend bool operator==(const SortedMapIterator& lhs,
+                         const SortedMapIterator& rhs) {
+    if (lhs.tree_ != rhs.tree_) {
+      return false;
+    }
+    return lhs.tree_ ? lhs.tree_iter_ == rhs.tree_iter_
+                     : lhs.array_iter_ == rhs.array_iter_;
+  }
+
+  friend bool operator!=(const SortedMapIterator& lhs,
+                         const SortedMapIterator& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  bool tree_;
+
+  // Only the iterator matching tree_ is meaningful. The tree iterator is
+  // default constructed (and does not allocate) when the array iterator is in
+  // use.
+  A array_iter_{};
+  T tree_iter_;
+};
+
+}  // namespace impl
+
+/**
+ * SortedMap is a value type containing a map. It is immutable, but has methods
+ * to efficiently create new maps that are mutations of it.
+ *
+ * SortedMap is backed by an ArraySortedMap while it is small and switches to a
+ * TreeSortedMap once it grows beyond kFixedSize entries.
+ *
+ * @tparam A The allocator for the nodes of the TreeSortedMap. It must be
+ *     stateless.
+ */
+template <typename K,
+          typename V,
+          typename C = std::less<K>,
+          typename A = std::allocator<K>>
+class SortedMap : public impl::SortedMapBase {
+ public:
+  /**
+   * The type of the entries stored in the map.
+   */
+  using value_type = std::pair<K, V>;
+  using array_type = ArraySortedMap<K, V, C>;
+  using tree_type = TreeSortedMap<K, V, C, A>;
+
+  using const_iterator =
+      impl::SortedMapIterator<typename array_type::const_iterator,
+                              typename tree_type::const_iterator>;
+  using const_reverse_iterator =
+      impl::SortedMapIterator<typename array_type::const_reverse_iterator,
+                              typename tree_type::const_reverse_iterator>;
+
+  class Builder;
+
+  /**
+   * Creates an empty SortedMap.
+   */
+  explicit SortedMap(const C& comparator = C())
+      : SortedMap(array_type{comparator}) {
+  }
+
+  /**
+   * Creates a SortedMap containing the given entries, which need not be in
+   * any particular order.
+   */
+  SortedMap(std::initializer_list<value_type> entries,
+            const C& comparator = C())
+      : SortedMap(comparator) {
+    for (auto&& entry : entries) {
+      *this = insert(entry.first, entry.second);
+    }
+  }
+
+  /**
+   * Creates a SortedMap containing the entries in the given range, choosing
+   * the implementation based on the number of entries. The entries must
+   * already be sorted by key and must not contain duplicate keys.
+   *
+   * @param begin A random access iterator pointing to the first entry.
+   * @param end An iterator pointing past the last entry.
+   */
+  template <typename Iterator>
+  static SortedMap CreateFromSorted(Iterator begin,
+                                    Iterator end,
+                                    const C& comparator = C()) {
+    if (end - begin <= static_cast<std::ptrdiff_t>(kFixedSize)) {
+      return SortedMap{array_type::CreateFromSorted(begin, end, comparator)};
+    } else {
+      return SortedMap{tree_type::CreateFromSorted(begin, end, comparator)};
+    }
+  }
+
+  explicit SortedMap(const array_type& array) : tag_(Tag::Array) {
+    new (&array_) array_type(array);
+  }
+
+  explicit SortedMap(const tree_type& tree) : tag_(Tag::Tree) {
+    new (&tree_) tree_type(tree);
+  }
+
+  SortedMap(const SortedMap& other) : tag_(other.tag_) {
+    switch (tag_) {
+      case Tag::Array:
+        new (&array_) array_type(other.array_);
+        break;
+      case Tag::Tree:
+        new (&tree_) tree_type(other.tree_);
+        break;
+    }
+  }
+
+  SortedMap(SortedMap&& other) : tag_(other.tag_) {
+    switch (tag_) {
+      case Tag::Array:
+        new (&array_) array_type(std::move(other.array_));
+        break;
+      case Tag::Tree:
+        new (&tree_) tree_type(std::move(other.tree_));
+        break;
+    }
+  }
+
+  ~SortedMap() {
+    switch (tag_) {
+      case Tag::Array:
+        array_.~array_type();
+        break;
+      case Tag::Tree:
+        tree_.~tree_type();
+        break;
+    }
+  }
+
+  SortedMap& operator=(const SortedMap& other) {
+    if (this != &other) {
+      this->~SortedMap();
+      new (this) SortedMap(other);
+    }
+    return *this;
+  }
+
+  SortedMap& operator=(SortedMap&& other) {
+    if (this != &other) {
+      this->~SortedMap();
+      new (this) SortedMap(std::move(other));
+    }
+    return *this;
+  }
+
+  /**
+   * Creates a new map identical to this one, but with a key-value pair added or
+   * updated.
+   *
+   * @param key The key to insert/update.
+   * @param value The value to associate with the key.
+   * @return A new dictionary with the added/updated value.
+   */
+  SortedMap insert(const K& key, const V& value) const {
+    return Insert(key, value);
+  }
+
+  /**
+   * Creates a new map identical to this one, but with a key-value pair added or
+   * updated, moving the key and value into the new map where its
+   * implementation allows.
+   */
+  SortedMap insert(K&& key, V&& value) const {
+    return Insert(std::move(key), std::move(value));
+  }
+
+  /**
+   * Creates a new map identical to this one, but with a key removed from it.
+   *
+   * @param key The key to remove.
+   * @return A new dictionary without that value.
+   */
+  SortedMap erase(const K& key) const {
+    switch (tag_) {
+      case Tag::Array:
+        return SortedMap{array_.erase(key)};
+      case Tag::Tree:
+        return SortedMap{tree_.erase(key)};
+    }
+    return *this;
+  }
+
+  /**
+   * Finds a value in the map.
+   *
+   * @param key The key to look up.
+   * @return An iterator pointing to the entry containing the key, or end() if
+   *     not found.
+   */
+  const_iterator find(const K& key) const {
+    switch (tag_) {
+      case Tag::Array:
+        return const_iterator{array_.find(key)};
+      case Tag::Tree:
+        return const_iterator{tree_.find(key)};
+    }
+    return end();
+  }
+
+  /**
+   * Finds the first entry in the map whose key is not less than the given key.
+   *
+   * @param key The key to look up.
+   * @return An iterator pointing to the entry, or end() if all keys in the map
+   *     are less than the given key.
+   */
+  const_iterator lower_bound(const K& key) const {
+    switch (tag_) {
+      case Tag::Array:
+        return const_iterator{array_.lower_bound(key)};
+      case Tag::Tree:
+        return const_iterator{tree_.lower_bound(key)};
+    }
+    return end();
+  }
+
+  /**
+   * Finds the first entry in the map whose key is greater than the given key.
+   *
+   * @param key The key to look up.
+   * @return An iterator pointing to the entry, or end() if no key in the map
+   *     is greater than the given key.
+   */
+  const_iterator upper_bound(const K& key) const {
+    switch (tag_) {
+      case Tag::Array:
+        return const_iterator{array_.upper_bound(key)};
+      case Tag::Tree:
+        return const_iterator{tree_.upper_bound(key)};
+    }
+    return end();
+  }
+
+  /**
+   * Finds the last entry in the map whose key is not greater than the given
+   * key.
+   *
+   * @return A reverse iterator pointing to the entry, or rend() if all keys in
+   *     the map are greater than the given key.
+   */
+  const_reverse_iterator reverse_upper_bound(const K& key) const {
+    switch (tag_) {
+      case Tag::Array:
+        return const_reverse_iterator{array_.reverse_upper_bound(key)};
+      case Tag::Tree:
+        return const_reverse_iterator{tree_.reverse_upper_bound(key)};
+    }
+    return rend();
+  }
+
+  /**
+   * Returns a view of the entries whose keys are not less than the given key,
+   * in ascending order.
+   */
+  util::iterator_range<const_iterator> range_from(const K& start) const {
+    return util::make_iterator_range(lower_bound(start), end());
+  }
+
+  /**
+   * Returns a view of the entries whose keys are not less than start and less
+   * than end, in ascending order.
+   */
+  util::iterator_range<const_iterator> range(const K& start,
+                                             const K& end) const {
+    const C& comparator = this->comparator();
+    if (!comparator(start, end)) {
+      return util::make_iterator_range(this->end(), this->end());
+    }
+    return util::make_iterator_range(lower_bound(start), lower_bound(end));
+  }
+
+  /**
+   * Returns a view of all the entries in descending order.
+   */
+  util::iterator_range<const_reverse_iterator> reversed() const {
+    return util::make_iterator_range(rbegin(), rend());
+  }
+
+  /**
+   * Returns a view of the entries whose keys are not greater than the given
+   * key, in descending order.
+   */
+  util::iterator_range<const_reverse_iterator> reverse_range_from(
+      const K& start) const {
+    return util::make_iterator_range(reverse_upper_bound(start), rend());
+  }
+
+  /**
+   * Finds the position of a key in the map, in O(log n) time.
+   *
+   * @param key The key to look up.
+   * @return The number of entries whose keys are less than the key, or npos if
+   *     the key isn't in the map.
+   */
+  size_type find_index(const K& key) const {
+    switch (tag_) {
+      case Tag::Array:
+        return array_.find_index(key);
+      case Tag::Tree:
+        return tree_.find_index(key);
+    }
+    return npos;
+  }
+
+  /**
+   * Returns the entry at the given position in key order, in O(log n) time.
+   * The index must be less than size().
+   */
+  const value_type& at_index(size_type index) const {
+    return tag_ == Tag::Array ? array_.at_index(index) : tree_.at_index(index);
+  }
+
+  /** Returns true if the map contains no elements. */
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /** Returns the number of items in this map. */
+  size_type size() const {
+    switch (tag_) {
+      case Tag::Array:
+        return array_.size();
+      case Tag::Tree:
+        return tree_.size();
+    }
+    return 0;
+  }
+
+  /**
+   * Returns an iterator pointing to the first entry in the map. If there are
+   * no entries in the map, begin() == end().
+   */
+  const_iterator begin() const {
+    switch (tag_) {
+      case Tag::Array:
+        return const_iterator{array_.begin()};
+      case Tag::Tree:
+        return const_iterator{tree_.begin()};
+    }
+    return end();
+  }
+
+  /**
+   * Returns an iterator pointing past the last entry in the map.
+   */
+  const_iterator end() const {
+    switch (tag_) {
+      case Tag::Array:
+        return const_iterator{array_.end()};
+      case Tag::Tree:
+        return const_iterator{tree_.end()};
+    }
+    return const_iterator{typename tree_type::const_iterator{}};
+  }
+
+  /**
+   * Returns a reverse iterator pointing to the last entry in the map. If there
+   * are no entries in the map, rbegin() == rend().
+   */
+  const_reverse_iterator rbegin() const {
+    switch (tag_) {
+      case Tag::Array:
+        return const_reverse_iterator{array_.rbegin()};
+      case Tag::Tree:
+        return const_reverse_iterator{tree_.rbegin()};
+    }
+    return rend();
+  }
+
+  /**
+   * Returns a reverse iterator pointing before the first entry in the map.
+   */
+  const_reverse_iterator rend() const {
+    switch (tag_) {
+      case Tag::Array:
+        return const_reverse_iterator{array_.rend()};
+      case Tag::Tree:
+        return const_reverse_iterator{tree_.rend()};
+    }
+    return const_reverse_iterator{
+        typename tree_type::const_reverse_iterator{}};
+  }
+
+  /** Returns the comparator used to order keys in this map. */
+  const C& comparator() const {
+    return tag_ == Tag::Array ? array_.comparator() : tree_.comparator();
+  }
+
+  /** Returns true if this map is currently backed by a TreeSortedMap. */
+  bool is_tree() const {
+    return tag_ == Tag::Tree;
+  }
+
+ private:
+  enum class Tag {
+    Array,
+    Tree,
+  };
+
+  /**
+   * Implements both insert overloads: KK and VV are K and V as const
+   * references or rvalues. The tree implementation always copies them.
+   */
+  template <typename KK, typename VV>
+  SortedMap Insert(KK&& key, VV&& value) const {
+    switch (tag_) {
+      case Tag::Array:
+        if (array_.size() >= kFixedSize && array_.find(key) == array_.end()) {
+          // The array is full and the key is new: switch to the tree
+          // implementation, which has no upper bound on its size.
+          tree_type tree = tree_type::CreateFromSorted(
+              array_.begin(), array_.end(), array_.comparator());
+          return SortedMap{tree.insert(key, value)};
+        }
+        return SortedMap{
+            array_.insert(std::forward<KK>(key), std::forward<VV>(value))};
+      case Tag::Tree:
+        return SortedMap{tree_.insert(key, value)};
+    }
+    return *this;
+  }
+
+  Tag tag_;
+  union {
+    array_type array_;
+    tree_type tree_;
+  };
+};
+
+/**
+ * Accumulates a batch of insertions and removals and applies them to a
+ * SortedMap all at once.
+ *
+ * Calling SortedMap::insert() repeatedly copies the backing array (or the path
+ * to the modified tree node) for every entry. A Builder instead sorts the
+ * batch once, merges it with the entries of the base map and builds the
+ * result directly, as an array or a tree depending on its size.
+ *
+ * Operations are applied in the order they were recorded: a later insert or
+ * erase of a key replaces any earlier operation on the same key.
+ */
+template <typename K, typename V, typename C, typename A>
+class SortedMap<K, V, C, A>::Builder {
+ public:
+  /** Creates a Builder that starts from an empty map. */
+  explicit Builder(const C& comparator = C()) : base_(comparator) {
+  }
+
+  /** Creates a Builder whose operations apply to the given map. */
+  explicit Builder(const SortedMap& base) : base_(base) {
+  }
+
+  /** Reserves space for the given number of operations. */
+  void reserve(size_type count) {
+    ops_.reserve(count);
+  }
+
+  /** Records that the given key should map to the given value. */
+  Builder& insert(const K& key, const V& value) {
+    ops_.push_back(Op{value_type(key, value), false});
+    return *this;
+  }
+
+  /** Records that the given key should be absent from the result. */
+  Builder& erase(const K& key) {
+    ops_.push_back(Op{value_type(key, V()), true});
+    return *this;
+  }
+
+  /** Applies all the recorded operations, returning the resulting map. */
+  SortedMap Build();
+
+ private:
+  struct Op {
+    value_type entry;
+    bool erase;
+  };
+
+  /**
+   * Sorts the operations by key and drops all but the last operation for each
+   * key.
+   */
+  void SortOps(const C& comparator);
+
+  SortedMap base_;
+  std::vector<Op> ops_;
+};
+
+template <typename K, typename V, typename C, typename A>
+SortedMap<K, V, C, A> SortedMap<K, V, C, A>::Builder::Build() {
+  if (ops_.empty()) {
+    return base_;
+  }
+
+  const C& comparator = base_.comparator();
+  SortOps(comparator);
+
+  // A handful of changes to a large tree are cheaper to apply individually
+  // (O(m log n)) than by merging and rebuilding the whole tree (O(n + m)).
+  size_type base_size = base_.size();
+  size_type depth = 1;
+  while ((base_size >> depth) != 0) {
+    depth++;
+  }
+  if (base_.is_tree() && ops_.size() * depth < base_size) {
+    SortedMap result = base_;
+    for (const Op& op : ops_) {
+      const K& key = op.entry.first;
+      if (op.erase) {
+        result = result.erase(key);
+      } else {
+        result = result.insert(key, op.entry.second);
+      }
+    }
+    return result;
+  }
+
+  std::vector<value_type> merged;
+  merged.reserve(base_size + ops_.size());
+
+  const_iterator base_iter = base_.begin();
+  const_iterator base_end = base_.end();
+  for (const Op& op : ops_) {
+    const K& key = op.entry.first;
+    while (base_iter != base_end && comparator(base_iter->first, key)) {
+      merged.push_back(*base_iter);
+      ++base_iter;
+    }
+
+    // Skip any existing entry this operation replaces or removes.
+    if (base_iter != base_end && !comparator(key, base_iter->first)) {
+      ++base_iter;
+    }
+    if (!op.erase) {
+      merged.push_back(op.entry);
+    }
+  }
+  for (; base_iter != base_end; ++base_iter) {
+    merged.push_back(*base_iter);
+  }
+
+  return CreateFromSorted(merged.begin(), merged.end(), comparator);
+}
+
+template <typename K, typename V, typename C, typename A>
+void SortedMap<K, V, C, A>::Builder::SortOps(const C& comparator) {
+  auto by_key = [&comparator](const Op& lhs, const Op& rhs) {
+    return comparator(lhs.entry.first, rhs.entry.first);
+  };
+  std::stable_sort(ops_.begin(), ops_.end(), by_key);
+
+  // The sort is stable, so the last of a run of equal keys is the latest.
+  size_t out = 0;
+  for (size_t i = 0; i < ops_.size(); i++) {
+    if (out > 0 && !by_key(ops_[out - 1], ops_[i])) {
+      ops_[out - 1] = std::move(ops_[i]);
+    } else {
+      if (out != i) {
+        ops_[out] = std::move(ops_[i]);
+      }
+      out++;
+    }
+  }
+  ops_.erase(ops_.begin() + out, ops_.end());
+}
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_H_
@@ -0,0 +1,378 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_SET_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_SET_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map_base.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+namespace impl {
+
+/** The placeholder value stored alongside each key of a SortedSet. */
+struct Empty {
+  friend bool operator==(Empty, Empty) {
+    return true;
+  }
+};
+
+/**
+ * A forward iterator over the keys of a SortedSet, wrapping the iterator of
+ * the SortedMap backing the set.
+ */
+template <typename I>
+class SortedSetIterator {
+ public:
+  using value_type =
+      typename std::iterator_traits<I>::value_type::first_type;
+
+  using iterator_category = std::forward_iterator_tag;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+  using difference_type = std::ptrdiff_t;
+
+  explicit SortedSetIterator(I iter) : iter_(std::move(iter)) {
+  }
+
+  reference operator*() const {
+    return iter_->first;
+  }
+
+  pointer operator->() const {
+    return &iter_->first;
+  }
+
+  SortedSetIterator& operator++() {
+    ++iter_;
+    return *this;
+  }
+
+  SortedSetIterator operator++(int) {
+    SortedSetIterator original = *this;
+    ++iter_;
+    return original;
+  }
+
+  friend bool operator==(const SortedSetIterator& lhs,
+                         const SortedSetIterator& rhs) {
+    return lhs.iter_ == rhs.iter_;
+  }
+
+  friend bool operator!=(const SortedSetIterator& lhs,
+                         const SortedSetIterator& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  I iter_;
+};
+
+/**
+ * An output iterator that appends each key assigned through it to a vector of
+ * SortedMap entries, so that the std:: set algorithms can build the entries of
+ * a SortedSet directly.
+ */
+template <typename K>
+class EntryInserter {
+ public:
+  using iterator_category = std::output_iterator_tag;
+  using value_type = void;
+  using pointer = void;
+  using reference = void;
+  using difference_type = void;
+
+  explicit EntryInserter(std::vector<std::pair<K, Empty>>* entries)
+      : entries_(entries) {
+  }
+
+  EntryInserter& operator=(const K& key) {
+    entries_->emplace_back(key, Empty());
+    return *this;
+  }
+
+  EntryInserter& operator*() {
+    return *this;
+  }
+
+  EntryInserter& operator++() {
+    return *this;
+  }
+
+  EntryInserter& operator++(int) {
+    return *this;
+  }
+
+ private:
+  std::vector<std::pair<K, Empty>>* entries_;
+};
+
+}  // namespace impl
+
+/**
+ * SortedSet is a value type containing a set of keys. It is immutable, but has
+ * methods to efficiently create new sets that are mutations of it.
+ *
+ * SortedSet is backed by a SortedMap, so small sets are stored inline in a
+ * sorted array and only larger sets pay for a tree. Union(), Difference() and
+ * Intersection() merge the sorted keys of both sets and build the result in
+ * one pass rather than inserting or erasing one key at a time.
+ */
+template <typename K,
+          typename C = std::less<K>,
+          typename A = std::allocator<K>>
+class SortedSet : public impl::SortedMapBase {
+ public:
+  using value_type = K;
+  using map_type = SortedMap<K, impl::Empty, C, A>;
+  using entry_type = typename map_type::value_type;
+  using const_iterator =
+      impl::SortedSetIterator<typename map_type::const_iterator>;
+
+  /**
+   * Creates an empty SortedSet.
+   */
+  explicit SortedSet(const C& comparator = C()) : map_(comparator) {
+  }
+
+  /**
+   * Creates a SortedSet containing the given keys, which need not be in any
+   * particular order.
+   */
+  SortedSet(std::initializer_list<K> keys, const C& comparator = C())
+      : map_(comparator) {
+    typename map_type::Builder builder{map_};
+    builder.reserve(keys.size());
+    for (const K& key : keys) {
+      builder.insert(key, impl::Empty());
+    }
+    map_ = builder.Build();
+  }
+
+  /**
+   * Creates a new set identical to this one, but with a key added to it.
+   */
+  SortedSet insert(const K& key) const {
+    return SortedSet(map_.insert(key, impl::Empty()));
+  }
+
+  /**
+   * Creates a new set identical to this one, but with a key removed from it.
+   */
+  SortedSet erase(const K& key) const {
+    return SortedSet(map_.erase(key));
+  }
+
+  /** Returns true if the set contains the given key. */
+  bool contains(const K& key) const {
+    return map_.find(key) != map_.end();
+  }
+
+  /**
+   * Finds a key in the set.
+   *
+   * @return An iterator pointing to the key, or end() if not found.
+   */
+  const_iterator find(const K& key) const {
+    return const_iterator{map_.find(key)};
+  }
+
+  /**
+   * Finds the position of a key in the set, in O(log n) time.
+   *
+   * @return The number of keys less than the key, or npos if the key isn't in
+   *     the set.
+   */
+  size_type find_index(const K& key) const {
+    return map_.find_index(key);
+  }
+
+  /**
+   * Creates a new set containing the keys of both this set and the other one.
+   *
+   * Combining sets of similar size is a single O(n + m) merge that builds the
+   * result in one pass. Adding a handful of keys to a large tree instead
+   * inserts them individually, in O(m log n).
+   */
+  SortedSet Union(const SortedSet& other) const {
+    const SortedSet& larger = size() >= other.size() ? *this : other;
+    const SortedSet& smaller = size() >= other.size() ? other : *this;
+    if (smaller.empty()) {
+      return larger;
+    }
+
+    if (larger.PrefersIncremental(smaller.size())) {
+      map_type result = larger.map_;
+      for (const K& key : smaller) {
+        result = result.insert(key, impl::Empty());
+      }
+      return SortedSet(std::move(result));
+    }
+
+    std::vector<entry_type> merged;
+    merged.reserve(size() + other.size());
+    std::set_union(begin(), end(), other.begin(), other.end(),
+                   impl::EntryInserter<K>(&merged), comparator());
+    return FromSorted(merged);
+  }
+
+  /**
+   * Creates a new set containing the keys of this set that are not in the
+   * other one.
+   *
+   * Like Union(), this is a linear merge unless only a few keys are to be
+   * removed from a large tree.
+   */
+  SortedSet Difference(const SortedSet& other) const {
+    if (empty() || other.empty()) {
+      return *this;
+    }
+
+    if (PrefersIncremental(other.size())) {
+      map_type result = map_;
+      for (const K& key : other) {
+        result = result.erase(key);
+      }
+      return SortedSet(std::move(result));
+    }
+
+    std::vector<entry_type> kept;
+    kept.reserve(size());
+    std::set_difference(begin(), end(), other.begin(), other.end(),
+                        impl::EntryInserter<K>(&kept), comparator());
+    if (kept.size() == size()) {
+      return *this;
+    }
+    return FromSorted(kept);
+  }
+
+  /**
+   * Creates a new set containing only the keys that are in both this set and
+   * the other one, in a single O(n + m) merge.
+   */
+  SortedSet Intersection(const SortedSet& other) const {
+    if (empty() || other.empty()) {
+      return SortedSet(comparator());
+    }
+
+    std::vector<entry_type> common;
+    common.reserve(std::min(size(), other.size()));
+    std::set_intersection(begin(), end(), other.begin(), other.end(),
+                          impl::EntryInserter<K>(&common), comparator());
+    if (common.size() == size()) {
+      return *this;
+    }
+    return FromSorted(common);
+  }
+
+  /** Returns true if the set contains no keys. */
+  bool empty() const {
+    return map_.empty();
+  }
+
+  /** Returns the number of keys in this set. */
+  size_type size() const {
+    return map_.size();
+  }
+
+  /** Returns the comparator used to order keys in this set. */
+  const C& comparator() const {
+    return map_.comparator();
+  }
+
+  /** Returns true if this set is currently backed by a tree. */
+  bool is_tree() const {
+    return map_.is_tree();
+  }
+
+  /**
+   * Returns an iterator pointing to the first key in the set. If the set is
+   * empty, begin() == end().
+   */
+  const_iterator begin() const {
+    return const_iterator{map_.begin()};
+  }
+
+  /**
+   * Returns an iterator pointing past the last key in the set.
+   */
+  const_iterator end() const {
+    return const_iterator{map_.end()};
+  }
+
+  friend bool operator==(const SortedSet& lhs, const SortedSet& rhs) {
+    if (lhs.size() != rhs.size()) {
+      return false;
+    }
+    const C& comparator = lhs.comparator();
+    auto rhs_iter = rhs.begin();
+    for (const K& key : lhs) {
+      if (comparator(key, *rhs_iter) || comparator(*rhs_iter, key)) {
+        return false;
+      }
+      ++rhs_iter;
+    }
+    return true;
+  }
+
+  friend bool operator!=(const SortedSet& lhs, const SortedSet& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  explicit SortedSet(map_type&& map) : map_(std::move(map)) {
+  }
+
+  SortedSet FromSorted(const std::vector<entry_type>& entries) const {
+    return SortedSet(map_type::CreateFromSorted(entries.begin(), entries.end(),
+                                                comparator()));
+  }
+
+  /**
+   * Returns true if applying the given number of changes to this set one at a
+   * time (O(m log n)) is cheaper than merging and rebuilding it (O(n + m)).
+   */
+  bool PrefersIncremental(size_type changes) const {
+    if (!is_tree()) {
+      return false;
+    }
+    size_type depth = 1;
+    while ((size() >> depth) != 0) {
+      depth++;
+    }
+    return changes * depth < size();
+  }
+
+  map_type map_;
+};
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_SET_H_
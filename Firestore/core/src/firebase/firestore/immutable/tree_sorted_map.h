@@ -0,0 +1,299 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_TREE_SORTED_MAP_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_TREE_SORTED_MAP_H_
+
+#include <cassert>
+#include <functional>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/immutable/llrb_node.h"
+#include "Firestore/core/src/firebase/firestore/immutable/llrb_node_iterator.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map_base.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+/**
+ * TreeSortedMap is a value type containing a map. It is immutable, but has
+ * methods to efficiently create new maps that are mutations of it.
+ *
+ * TreeSortedMap is backed by a left-leaning red-black tree whose nodes are
+ * shared between the maps derived from one another: insert() and erase()
+ * allocate O(log n) new nodes and leave the rest of the tree untouched.
+ *
+ * @tparam A The allocator for tree nodes, e.g. SlabAllocator. It must be
+ *     stateless.
+ */
+template <typename K,
+          typename V,
+          typename C = std::less<K>,
+          typename A = std::allocator<K>>
+class TreeSortedMap : public impl::SortedMapBase {
+ public:
+  /**
+   * The type of the entries stored in the map.
+   */
+  using value_type = std::pair<K, V>;
+
+  /**
+   * The type of the node containing entries of value_type.
+   */
+  using node_type = impl::LlrbNode<K, V, A>;
+  using const_iterator = impl::LlrbNodeIterator<node_type>;
+  using const_reverse_iterator = const_iterator;
+
+  /**
+   * Creates an empty TreeSortedMap.
+   */
+  explicit TreeSortedMap(const C& comparator = C())
+      : comparator_(comparator) {
+  }
+
+  /**
+   * Creates a TreeSortedMap containing the given entries, which need not be
+   * in any particular order.
+   */
+  TreeSortedMap(std::initializer_list<value_type> entries,
+                const C& comparator = C())
+      : comparator_(comparator) {
+    for (auto&& entry : entries) {
+      root_ = root_.insert(entry.first, entry.second, comparator_);
+    }
+  }
+
+  /**
+   * Creates a TreeSortedMap containing all the entries in the given range,
+   * which need not be in any particular order.
+   *
+   * @param range Any type with begin() and end() that yield value_types.
+   */
+  template <typename Range>
+  static TreeSortedMap Create(const Range& range, const C& comparator) {
+    TreeSortedMap result{comparator};
+    for (auto&& entry : range) {
+      result.root_ =
+          result.root_.insert(entry.first, entry.second, result.comparator_);
+    }
+    return result;
+  }
+
+  /**
+   * Creates a TreeSortedMap containing the entries in the given range in O(n)
+   * time. The entries must already be sorted by key according to the
+   * comparator and must not contain duplicate keys.
+   *
+   * @param begin A random access iterator pointing to the first entry, e.g.
+   *     an ArraySortedMap or std::vector iterator.
+   * @param end An iterator pointing past the last entry.
+   */
+  template <typename Iterator>
+  static TreeSortedMap CreateFromSorted(Iterator begin,
+                                        Iterator end,
+                                        const C& comparator = C()) {
+    return TreeSortedMap{node_type::BuildFromSorted(begin, end), comparator};
+  }
+
+  /**
+   * Creates a new map identical to this one, but with a key-value pair added or
+   * updated.
+   *
+   * @param key The key to insert/update.
+   * @param value The value to associate with the key.
+   * @return A new dictionary with the added/updated value.
+   */
+  TreeSortedMap insert(const K& key, const V& value) const {
+    return TreeSortedMap{root_.insert(key, value, comparator_), comparator_};
+  }
+
+  /**
+   * Creates a new map identical to this one, but with a key removed from it.
+   *
+   * @param key The key to remove.
+   * @return A new dictionary without that value.
+   */
+  TreeSortedMap erase(const K& key) const {
+    if (find(key) == end()) {
+      return *this;
+    }
+    return TreeSortedMap{root_.erase(key, comparator_), comparator_};
+  }
+
+  /**
+   * Finds a value in the map.
+   *
+   * @param key The key to look up.
+   * @return An iterator pointing to the entry containing the key, or end() if
+   *     not found.
+   */
+  const_iterator find(const K& key) const {
+    const_iterator result = LowerBound(key);
+    if (!result.is_end() && !comparator_(key, result->first)) {
+      return result;
+    }
+    return end();
+  }
+
+  /**
+   * Finds the first entry in the map whose key is not less than the given key.
+   *
+   * @param key The key to look up.
+   * @return An iterator pointing to the entry, or end() if all keys in the map
+   *     are less than the given key.
+   */
+  const_iterator lower_bound(const K& key) const {
+    return LowerBound(key);
+  }
+
+  /**
+   * Finds the first entry in the map whose key is greater than the given key.
+   *
+   * @param key The key to look up.
+   * @return An iterator pointing to the entry, or end() if no key in the map
+   *     is greater than the given key.
+   */
+  const_iterator upper_bound(const K& key) const {
+    const_iterator result = LowerBound(key);
+    if (!result.is_end() && !comparator_(key, result->first)) {
+      ++result;
+    }
+    return result;
+  }
+
+  /**
+   * Finds the last entry in the map whose key is not greater than the given
+   * key.
+   *
+   * @return A reverse iterator pointing to the entry, or rend() if all keys in
+   *     the map are greater than the given key.
+   */
+  const_reverse_iterator reverse_upper_bound(const K& key) const {
+    return const_iterator::ReverseUpperBound(&root_, key, comparator_);
+  }
+
+  /**
+   * Finds the position of a key in the map in O(log n) time, using the sizes
+   * of the subtrees skipped on the way down.
+   *
+   * @param key The key to look up.
+   * @return The number of entries whose keys are less than the key, or npos if
+   *     the key isn't in the map.
+   */
+  size_type find_index(const K& key) const {
+    size_type preceding = 0;
+    const node_type* node = &root_;
+    while (!node->empty()) {
+      if (comparator_(key, node->key())) {
+        node = &node->left();
+      } else if (comparator_(node->key(), key)) {
+        preceding += node->left().size() + 1;
+        node = &node->right();
+      } else {
+        return preceding + node->left().size();
+      }
+    }
+    return npos;
+  }
+
+  /**
+   * Returns the entry at the given position in key order in O(log n) time. The
+   * index must be less than size().
+   */
+  const value_type& at_index(size_type index) const {
+    assert(index < size());
+    const node_type* node = &root_;
+    for (;;) {
+      size_type left_size = node->left().size();
+      if (index < left_size) {
+        node = &node->left();
+      } else if (index > left_size) {
+        index -= left_size + 1;
+        node = &node->right();
+      } else {
+        return node->entry();
+      }
+    }
+  }
+
+  /** Returns true if the map contains no elements. */
+  bool empty() const {
+    return root_.empty();
+  }
+
+  /** Returns the number of items in this map. */
+  size_type size() const {
+    return root_.size();
+  }
+
+  /** Returns the comparator used to order keys in this map. */
+  const C& comparator() const {
+    return comparator_;
+  }
+
+  /** Returns the root node of the tree backing this map. */
+  const node_type& root() const {
+    return root_;
+  }
+
+  /**
+   * Returns an iterator pointing to the first entry in the map. If there are
+   * no entries in the map, begin() == end().
+   */
+  const_iterator begin() const {
+    return const_iterator::Begin(&root_);
+  }
+
+  /**
+   * Returns an iterator pointing past the last entry in the map.
+   */
+  const_iterator end() const {
+    return const_iterator::End();
+  }
+
+  /**
+   * Returns a reverse iterator pointing to the last entry in the map.
+   */
+  const_reverse_iterator rbegin() const {
+    return const_iterator::ReverseBegin(&root_);
+  }
+
+  /**
+   * Returns a reverse iterator pointing before the first entry in the map.
+   */
+  const_reverse_iterator rend() const {
+    return const_iterator::End();
+  }
+
+ private:
+  TreeSortedMap(node_type&& root, const C& comparator) noexcept
+      : root_(std::move(root)), comparator_(comparator) {
+  }
+
+  const_iterator LowerBound(const K& key) const {
+    return const_iterator::LowerBound(&root_, key, comparator_);
+  }
+
+  node_type root_;
+  C comparator_;
+};
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_TREE_SORTED_MAP_H_
@@ -0,0 +1,833 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+
+#include <stdint.h>
+
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+#include "Firestore/core/src/firebase/firestore/util/string_printf.h"
+
+using firebase::firestore::model::BatchId;
+using firebase::firestore::model::TargetId;
+using firebase::firestore::util::OrderedCode;
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+const char* kVersionGlobalTable = "version";
+const char* kMigrationProgressTable = "migration_progress";
+const char* kMutationsTable = "mutation";
+const char* kDocumentMutationsTable = "document_mutation";
+const char* kMutationQueuesTable = "mutation_queue";
+const char* kTargetGlobalTable = "target_global";
+const char* kTargetsTable = "target";
+const char* kQueryTargetsTable = "query_target";
+const char* kTargetDocumentsTable = "target_document";
+const char* kDocumentTargetsTable = "document_target";
+const char* kRemoteDocumentsTable = "remote_document";
+const char* kIndexEntriesTable = "index_entry";
+
+/**
+ * Labels for the components of keys. These serve to make keys
+ * self-describing.
+ *
+ * These are intended to sort similarly to keys in the server storage format.
+ *
+ * Note that the server writes component labels using the equivalent to
+ * OrderedCode::WriteSignedNumDecreasing. This means that despite the higher
+ * numeric value, a terminator sorts before a path segment. In order to avoid
+ * needing the WriteSignedNumDecreasing code just for these values, this enum's
+ * values are in the reverse order to the server side.
+ *
+ * Most server-side values don't apply here. For example, the server embeds
+ * projects, databases, namespaces and similar values in its entity keys where
+ * the clients just open a different leveldb. Similarly, many of these values
+ * don't apply to the server since the server is backed by spanner which
+ * natively has concepts of tables and indexes. Where there's overlap, a
+ * comment denotes the server value from the storage_format_internal.proto.
+ */
+enum class ComponentLabel : int64_t {
+  /**
+   * A terminator is the final component of a key. All complete keys have a
+   * terminator and a key is known to be a key prefix if it doesn't have a
+   * terminator.
+   */
+  Terminator = 0,  // TERMINATOR_COMPONENT = 63, server-side
+
+  /**
+   * A table name component names the logical table to which the key belongs.
+   */
+  TableName = 5,
+
+  /** A component containing the batch ID of a mutation. */
+  BatchId = 10,
+
+  /** A component containing the canonical ID of a query. */
+  CanonicalId = 11,
+
+  /** A component containing the target ID of a query. */
+  TargetId = 12,
+
+  /** A component containing a user ID. */
+  UserId = 13,
+
+  /** A component containing the canonical path of a field in a document. */
+  FieldPath = 14,
+
+  /** A component containing the encoded value of an indexed field. */
+  IndexValue = 15,
+
+  /** A component containing the ID of a document within its collection. */
+  DocumentId = 16,
+
+  /**
+   * A path segment describes just a single segment in a resource path. Path
+   * segments that occur sequentially in a key represent successive segments
+   * in a single path.
+   *
+   * This value must be greater than Terminator to ensure that longer paths
+   * sort after paths that are prefixes of them.
+   *
+   * This value must also be larger than other separators so that path
+   * suffixes sort after other key components.
+   */
+  PathSegment = 62,  // PATH = 60, server-side
+
+  /**
+   * The maximum value that can be encoded by WriteSignedNumIncreasing in a
+   * single byte.
+   */
+  Unknown = 63,
+};
+
+void WriteComponentLabel(std::string* dest, ComponentLabel label) {
+  OrderedCode::WriteSignedNumIncreasing(dest, static_cast<int64_t>(label));
+}
+
+void WriteLabeledString(std::string* dest,
+                        ComponentLabel label,
+                        absl::string_view value) {
+  WriteComponentLabel(dest, label);
+  OrderedCode::WriteString(dest, value);
+}
+
+void WriteLabeledInt32(std::string* dest, ComponentLabel label, int32_t value) {
+  WriteComponentLabel(dest, label);
+  OrderedCode::WriteSignedNumIncreasing(dest, value);
+}
+
+void WriteTerminator(std::string* dest) {
+  WriteComponentLabel(dest, ComponentLabel::Terminator);
+}
+
+void WriteTableName(std::string* dest, const char* table_name) {
+  WriteLabeledString(dest, ComponentLabel::TableName, table_name);
+}
+
+void WriteBatchId(std::string* dest, BatchId batch_id) {
+  WriteLabeledInt32(dest, ComponentLabel::BatchId, batch_id);
+}
+
+void WriteCanonicalId(std::string* dest, absl::string_view canonical_id) {
+  WriteLabeledString(dest, ComponentLabel::CanonicalId, canonical_id);
+}
+
+void WriteTargetId(std::string* dest, TargetId target_id) {
+  WriteLabeledInt32(dest, ComponentLabel::TargetId, target_id);
+}
+
+void WriteUserId(std::string* dest, absl::string_view user_id) {
+  WriteLabeledString(dest, ComponentLabel::UserId, user_id);
+}
+
+void WriteFieldPath(std::string* dest, absl::string_view field_path) {
+  WriteLabeledString(dest, ComponentLabel::FieldPath, field_path);
+}
+
+void WriteIndexValue(std::string* dest, absl::string_view index_value) {
+  WriteLabeledString(dest, ComponentLabel::IndexValue, index_value);
+}
+
+void WriteDocumentId(std::string* dest, absl::string_view document_id) {
+  WriteLabeledString(dest, ComponentLabel::DocumentId, document_id);
+}
+
+/**
+ * For each segment in the given resource path writes a PathSegment component
+ * label and a string containing the path segment.
+ */
+void WriteResourcePath(std::string* dest, const PathSegments& path) {
+  for (absl::string_view segment : path) {
+    WriteLabeledString(dest, ComponentLabel::PathSegment, segment);
+  }
+}
+
+/**
+ * Reads the components of a key one at a time. Each Read method returns
+ * false and leaves the reader unchanged if the next component can't be read
+ * or isn't what the caller expected; otherwise it advances past the
+ * component.
+ *
+ * Strings are read in place where possible. Those that need unescaping are
+ * appended to a caller-supplied buffer, which is reserved up front to the
+ * size of the whole key: an unescaped string is never longer than its
+ * encoding, so the buffer never reallocates and views into it remain valid.
+ */
+class Reader {
+ public:
+  Reader(absl::string_view src, std::string* buffer)
+      : src_(src), buffer_(buffer) {
+    buffer_->clear();
+    buffer_->reserve(src.size());
+  }
+
+  bool empty() const {
+    return src_.empty();
+  }
+
+  absl::string_view remaining() const {
+    return src_;
+  }
+
+  /** Reads the next component label, whatever it is. */
+  bool ReadComponentLabel(ComponentLabel* label) {
+    int64_t raw_result = 0;
+    absl::string_view tmp = src_;
+    if (OrderedCode::ReadSignedNumIncreasing(&tmp, &raw_result)) {
+      if (raw_result >= static_cast<int64_t>(ComponentLabel::Terminator) &&
+          raw_result <= static_cast<int64_t>(ComponentLabel::Unknown)) {
+        *label = static_cast<ComponentLabel>(raw_result);
+        src_ = tmp;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /** Reads the next component label, which must be expected_label. */
+  bool ReadComponentLabelMatching(ComponentLabel expected_label) {
+    int64_t raw_result = 0;
+    absl::string_view tmp = src_;
+    if (OrderedCode::ReadSignedNumIncreasing(&tmp, &raw_result)) {
+      if (raw_result == static_cast<int64_t>(expected_label)) {
+        src_ = tmp;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool ReadLabeledString(ComponentLabel expected_label,
+                         absl::string_view* value) {
+    absl::string_view original = src_;
+    if (ReadComponentLabelMatching(expected_label) &&
+        OrderedCode::ReadStringView(&src_, value, buffer_)) {
+      return true;
+    }
+    src_ = original;
+    return false;
+  }
+
+  bool ReadLabeledStringMatching(ComponentLabel expected_label,
+                                 absl::string_view expected_value) {
+    absl::string_view original = src_;
+    absl::string_view value;
+    if (ReadLabeledString(expected_label, &value) && value == expected_value) {
+      return true;
+    }
+    src_ = original;
+    return false;
+  }
+
+  bool ReadLabeledInt32(ComponentLabel expected_label, int32_t* value) {
+    absl::string_view original = src_;
+    int64_t raw_result = 0;
+    if (ReadComponentLabelMatching(expected_label) &&
+        OrderedCode::ReadSignedNumIncreasing(&src_, &raw_result) &&
+        raw_result >= INT32_MIN && raw_result <= INT32_MAX) {
+      *value = static_cast<int32_t>(raw_result);
+      return true;
+    }
+    src_ = original;
+    return false;
+  }
+
+  bool ReadTerminator() {
+    return ReadComponentLabelMatching(ComponentLabel::Terminator);
+  }
+
+  bool ReadTableNameMatching(const char* expected_table_name) {
+    return ReadLabeledStringMatching(ComponentLabel::TableName,
+                                     expected_table_name);
+  }
+
+  bool ReadTableName(absl::string_view* table_name) {
+    return ReadLabeledString(ComponentLabel::TableName, table_name);
+  }
+
+  bool ReadBatchId(BatchId* batch_id) {
+    return ReadLabeledInt32(ComponentLabel::BatchId, batch_id);
+  }
+
+  bool ReadCanonicalId(absl::string_view* canonical_id) {
+    return ReadLabeledString(ComponentLabel::CanonicalId, canonical_id);
+  }
+
+  bool ReadTargetId(TargetId* target_id) {
+    return ReadLabeledInt32(ComponentLabel::TargetId, target_id);
+  }
+
+  bool ReadUserId(absl::string_view* user_id) {
+    return ReadLabeledString(ComponentLabel::UserId, user_id);
+  }
+
+  bool ReadFieldPath(absl::string_view* field_path) {
+    return ReadLabeledString(ComponentLabel::FieldPath, field_path);
+  }
+
+  bool ReadIndexValue(absl::string_view* index_value) {
+    return ReadLabeledString(ComponentLabel::IndexValue, index_value);
+  }
+
+  bool ReadDocumentId(absl::string_view* document_id) {
+    return ReadLabeledString(ComponentLabel::DocumentId, document_id);
+  }
+
+  /**
+   * Reads consecutive path segments until it finds a component label other
+   * than PathSegment. The path must have at least one segment.
+   */
+  bool ReadResourcePath(PathSegments* path) {
+    path->clear();
+    absl::string_view segment;
+    while (ReadLabeledString(ComponentLabel::PathSegment, &segment)) {
+      path->push_back(segment);
+    }
+    return !path->empty();
+  }
+
+  /**
+   * Reads consecutive path segments until it finds a component label other
+   * than PathSegment. The segments must form a valid document key, i.e. a
+   * non-empty path with an even number of segments.
+   */
+  bool ReadDocumentKey(PathSegments* document_key) {
+    absl::string_view original = src_;
+    if (ReadResourcePath(document_key) && document_key->size() % 2 == 0) {
+      return true;
+    }
+    src_ = original;
+    return false;
+  }
+
+ private:
+  absl::string_view src_;
+  std::string* buffer_;
+};
+
+/** Returns the path segments joined by slashes, as in a canonical path. */
+std::string CanonicalPath(const PathSegments& path) {
+  std::string result;
+  for (size_t i = 0; i < path.size(); i++) {
+    if (i > 0) {
+      result += '/';
+    }
+    result.append(path[i].data(), path[i].size());
+  }
+  return result;
+}
+
+/** Encodes the given bytes with standard, padded base64. */
+std::string Base64Encode(absl::string_view bytes) {
+  static const char kAlphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  std::string result;
+  result.reserve((bytes.size() + 2) / 3 * 4);
+  size_t i = 0;
+  for (; i + 2 < bytes.size(); i += 3) {
+    uint32_t triple = static_cast<uint8_t>(bytes[i]) << 16 |
+                      static_cast<uint8_t>(bytes[i + 1]) << 8 |
+                      static_cast<uint8_t>(bytes[i + 2]);
+    result += kAlphabet[(triple >> 18) & 0x3f];
+    result += kAlphabet[(triple >> 12) & 0x3f];
+    result += kAlphabet[(triple >> 6) & 0x3f];
+    result += kAlphabet[triple & 0x3f];
+  }
+  if (i < bytes.size()) {
+    uint32_t triple = static_cast<uint8_t>(bytes[i]) << 16;
+    if (i + 1 < bytes.size()) {
+      triple |= static_cast<uint8_t>(bytes[i + 1]) << 8;
+    }
+    result += kAlphabet[(triple >> 18) & 0x3f];
+    result += kAlphabet[(triple >> 12) & 0x3f];
+    result += i + 1 < bytes.size() ? kAlphabet[(triple >> 6) & 0x3f] : '=';
+    result += '=';
+  }
+  return result;
+}
+
+}  // namespace
+
+std::string EncodeResourcePath(const PathSegments& path) {
+  std::string result;
+  WriteResourcePath(&result, path);
+  return result;
+}
+
+std::string DescribeKey(absl::string_view key) {
+  std::string buffer;
+  Reader reader{key, &buffer};
+  bool is_terminated = false;
+
+  std::string description = "[";
+  while (!reader.empty()) {
+    // Peek at the label, since all the different read routines expect to see
+    // the label first.
+    Reader tmp = reader;
+    ComponentLabel label = ComponentLabel::Unknown;
+    if (!tmp.ReadComponentLabel(&label)) {
+      break;
+    }
+
+    if (label == ComponentLabel::Terminator) {
+      is_terminated = true;
+      reader = tmp;
+      break;
+    }
+
+    if (label == ComponentLabel::PathSegment) {
+      PathSegments path;
+      if (!reader.ReadResourcePath(&path)) {
+        break;
+      }
+      std::string canonical_path = CanonicalPath(path);
+      util::StringAppendFWithHint(&description, canonical_path.size() + 6,
+                                  " %s=%s",
+                                  path.size() % 2 == 0 ? "key" : "path",
+                                  canonical_path.c_str());
+
+    } else if (label == ComponentLabel::TableName) {
+      absl::string_view table;
+      if (!reader.ReadTableName(&table)) {
+        break;
+      }
+      util::StringAppendF(&description, "%.*s:", static_cast<int>(table.size()),
+                          table.data());
+
+    } else if (label == ComponentLabel::BatchId) {
+      BatchId batch_id;
+      if (!reader.ReadBatchId(&batch_id)) {
+        break;
+      }
+      util::StringAppendF(&description, " batchID=%d", batch_id);
+
+    } else if (label == ComponentLabel::CanonicalId) {
+      absl::string_view canonical_id;
+      if (!reader.ReadCanonicalId(&canonical_id)) {
+        break;
+      }
+      util::StringAppendFWithHint(&description, canonical_id.size() + 13,
+                                  " canonicalID=%.*s",
+                                  static_cast<int>(canonical_id.size()),
+                                  canonical_id.data());
+
+    } else if (label == ComponentLabel::TargetId) {
+      TargetId target_id;
+      if (!reader.ReadTargetId(&target_id)) {
+        break;
+      }
+      util::StringAppendF(&description, " targetID=%d", target_id);
+
+    } else if (label == ComponentLabel::UserId) {
+      absl::string_view user_id;
+      if (!reader.ReadUserId(&user_id)) {
+        break;
+      }
+      util::StringAppendF(&description, " userID=%.*s",
+                          static_cast<int>(user_id.size()), user_id.data());
+
+    } else if (label == ComponentLabel::FieldPath) {
+      absl::string_view field_path;
+      if (!reader.ReadFieldPath(&field_path)) {
+        break;
+      }
+      util::StringAppendF(&description, " fieldPath=%.*s",
+                          static_cast<int>(field_path.size()),
+                          field_path.data());
+
+    } else if (label == ComponentLabel::IndexValue) {
+      absl::string_view index_value;
+      if (!reader.ReadIndexValue(&index_value)) {
+        break;
+      }
+      util::StringAppendF(&description, " indexValue=<%s>",
+                          Base64Encode(index_value).c_str());
+
+    } else if (label == ComponentLabel::DocumentId) {
+      absl::string_view document_id;
+      if (!reader.ReadDocumentId(&document_id)) {
+        break;
+      }
+      util::StringAppendF(&description, " documentID=%.*s",
+                          static_cast<int>(document_id.size()),
+                          document_id.data());
+
+    } else {
+      util::StringAppendF(&description, " unknown label=%d",
+                          static_cast<int>(label));
+      break;
+    }
+  }
+
+  if (!reader.empty()) {
+    util::StringAppendF(&description, " invalid key=<%s>",
+                        Base64Encode(key).c_str());
+
+  } else if (!is_terminated) {
+    description += " incomplete key";
+  }
+
+  description += "]";
+  return description;
+}
+
+std::string LevelDbVersionKey::Key() {
+  std::string result;
+  WriteTableName(&result, kVersionGlobalTable);
+  WriteTerminator(&result);
+  return result;
+}
+
+std::string LevelDbMigrationProgressKey::Key() {
+  std::string result;
+  WriteTableName(&result, kMigrationProgressTable);
+  WriteTerminator(&result);
+  return result;
+}
+
+std::string LevelDbMutationKey::KeyPrefix() {
+  std::string result;
+  WriteTableName(&result, kMutationsTable);
+  return result;
+}
+
+std::string LevelDbMutationKey::KeyPrefix(absl::string_view user_id) {
+  std::string result;
+  WriteTableName(&result, kMutationsTable);
+  WriteUserId(&result, user_id);
+  return result;
+}
+
+std::string LevelDbMutationKey::Key(absl::string_view user_id,
+                                    BatchId batch_id) {
+  std::string result;
+  WriteTableName(&result, kMutationsTable);
+  WriteUserId(&result, user_id);
+  WriteBatchId(&result, batch_id);
+  WriteTerminator(&result);
+  return result;
+}
+
+bool LevelDbMutationKey::Decode(absl::string_view key) {
+  Reader reader{key, &buffer_};
+  return reader.ReadTableNameMatching(kMutationsTable) &&
+         reader.ReadUserId(&user_id_) && reader.ReadBatchId(&batch_id_) &&
+         reader.ReadTerminator();
+}
+
+std::string LevelDbDocumentMutationKey::KeyPrefix() {
+  std::string result;
+  WriteTableName(&result, kDocumentMutationsTable);
+  return result;
+}
+
+std::string LevelDbDocumentMutationKey::KeyPrefix(absl::string_view user_id) {
+  std::string result;
+  WriteTableName(&result, kDocumentMutationsTable);
+  WriteUserId(&result, user_id);
+  return result;
+}
+
+std::string LevelDbDocumentMutationKey::KeyPrefix(
+    absl::string_view user_id, const PathSegments& resource_path) {
+  std::string result;
+  WriteTableName(&result, kDocumentMutationsTable);
+  WriteUserId(&result, user_id);
+  WriteResourcePath(&result, resource_path);
+  return result;
+}
+
+std::string LevelDbDocumentMutationKey::Key(absl::string_view user_id,
+                                            const PathSegments& document_key,
+                                            BatchId batch_id) {
+  std::string result;
+  WriteTableName(&result, kDocumentMutationsTable);
+  WriteUserId(&result, user_id);
+  WriteResourcePath(&result, document_key);
+  WriteBatchId(&result, batch_id);
+  WriteTerminator(&result);
+  return result;
+}
+
+bool LevelDbDocumentMutationKey::Decode(absl::string_view key) {
+  Reader reader{key, &buffer_};
+  return reader.ReadTableNameMatching(kDocumentMutationsTable) &&
+         reader.ReadUserId(&user_id_) &&
+         reader.ReadDocumentKey(&document_key_) &&
+         reader.ReadBatchId(&batch_id_) && reader.ReadTerminator();
+}
+
+std::string LevelDbMutationQueueKey::KeyPrefix() {
+  std::string result;
+  WriteTableName(&result, kMutationQueuesTable);
+  return result;
+}
+
+std::string LevelDbMutationQueueKey::Key(absl::string_view user_id) {
+  std::string result;
+  WriteTableName(&result, kMutationQueuesTable);
+  WriteUserId(&result, user_id);
+  WriteTerminator(&result);
+  return result;
+}
+
+bool LevelDbMutationQueueKey::Decode(absl::string_view key) {
+  Reader reader{key, &buffer_};
+  return reader.ReadTableNameMatching(kMutationQueuesTable) &&
+         reader.ReadUserId(&user_id_) && reader.ReadTerminator();
+}
+
+std::string LevelDbTargetGlobalKey::Key() {
+  std::string result;
+  WriteTableName(&result, kTargetGlobalTable);
+  WriteTerminator(&result);
+  return result;
+}
+
+bool LevelDbTargetGlobalKey::Decode(absl::string_view key) {
+  Reader reader{key, &buffer_};
+  return reader.ReadTableNameMatching(kTargetGlobalTable) &&
+         reader.ReadTerminator();
+}
+
+std::string LevelDbTargetKey::KeyPrefix() {
+  std::string result;
+  WriteTableName(&result, kTargetsTable);
+  return result;
+}
+
+std::string LevelDbTargetKey::Key(TargetId target_id) {
+  std::string result;
+  WriteTableName(&result, kTargetsTable);
+  WriteTargetId(&result, target_id);
+  WriteTerminator(&result);
+  return result;
+}
+
+bool LevelDbTargetKey::Decode(absl::string_view key) {
+  Reader reader{key, &buffer_};
+  return reader.ReadTableNameMatching(kTargetsTable) &&
+         reader.ReadTargetId(&target_id_) && reader.ReadTerminator();
+}
+
+std::string LevelDbQueryTargetKey::KeyPrefix() {
+  std::string result;
+  WriteTableName(&result, kQueryTargetsTable);
+  return result;
+}
+
+std::string LevelDbQueryTargetKey::KeyPrefix(absl::string_view canonical_id) {
+  std::string result;
+  WriteTableName(&result, kQueryTargetsTable);
+  WriteCanonicalId(&result, canonical_id);
+  return result;
+}
+
+std::string LevelDbQueryTargetKey::Key(absl::string_view canonical_id,
+                                       TargetId target_id) {
+  std::string result;
+  WriteTableName(&result, kQueryTargetsTable);
+  WriteCanonicalId(&result, canonical_id);
+  WriteTargetId(&result, target_id);
+  WriteTerminator(&result);
+  return result;
+}
+
+bool LevelDbQueryTargetKey::Decode(absl::string_view key) {
+  Reader reader{key, &buffer_};
+  return reader.ReadTableNameMatching(kQueryTargetsTable) &&
+         reader.ReadCanonicalId(&canonical_id_) &&
+         reader.ReadTargetId(&target_id_) && reader.ReadTerminator();
+}
+
+std::string LevelDbTargetDocumentKey::KeyPrefix() {
+  std::string result;
+  WriteTableName(&result, kTargetDocumentsTable);
+  return result;
+}
+
+std::string LevelDbTargetDocumentKey::KeyPrefix(TargetId target_id) {
+  std::string result;
+  WriteTableName(&result, kTargetDocumentsTable);
+  WriteTargetId(&result, target_id);
+  return result;
+}
+
+std::string LevelDbTargetDocumentKey::Key(TargetId target_id,
+                                          const PathSegments& document_key) {
+  std::string result;
+  WriteTableName(&result, kTargetDocumentsTable);
+  WriteTargetId(&result, target_id);
+  WriteResourcePath(&result, document_key);
+  WriteTerminator(&result);
+  return result;
+}
+
+bool LevelDbTargetDocumentKey::Decode(absl::string_view key) {
+  Reader reader{key, &buffer_};
+  return reader.ReadTableNameMatching(kTargetDocumentsTable) &&
+         reader.ReadTargetId(&target_id_) &&
+         reader.ReadDocumentKey(&document_key_) && reader.ReadTerminator();
+}
+
+std::string LevelDbDocumentTargetKey::KeyPrefix() {
+  std::string result;
+  WriteTableName(&result, kDocumentTargetsTable);
+  return result;
+}
+
+std::string LevelDbDocumentTargetKey::KeyPrefix(
+    const PathSegments& resource_path) {
+  std::string result;
+  WriteTableName(&result, kDocumentTargetsTable);
+  WriteResourcePath(&result, resource_path);
+  return result;
+}
+
+std::string LevelDbDocumentTargetKey::Key(const PathSegments& document_key,
+                                          TargetId target_id) {
+  std::string result;
+  WriteTableName(&result, kDocumentTargetsTable);
+  WriteResourcePath(&result, document_key);
+  WriteTargetId(&result, target_id);
+  WriteTerminator(&result);
+  return result;
+}
+
+bool LevelDbDocumentTargetKey::Decode(absl::string_view key) {
+  Reader reader{key, &buffer_};
+  return reader.ReadTableNameMatching(kDocumentTargetsTable) &&
+         reader.ReadDocumentKey(&document_key_) &&
+         reader.ReadTargetId(&target_id_) && reader.ReadTerminator();
+}
+
+std::string LevelDbRemoteDocumentKey::KeyPrefix() {
+  std::string result;
+  WriteTableName(&result, kRemoteDocumentsTable);
+  return result;
+}
+
+std::string LevelDbRemoteDocumentKey::KeyPrefix(
+    const PathSegments& resource_path) {
+  std::string result;
+  WriteTableName(&result, kRemoteDocumentsTable);
+  WriteResourcePath(&result, resource_path);
+  return result;
+}
+
+std::string LevelDbRemoteDocumentKey::Key(const PathSegments& document_key) {
+  std::string result;
+  WriteTableName(&result, kRemoteDocumentsTable);
+  WriteResourcePath(&result, document_key);
+  WriteTerminator(&result);
+  return result;
+}
+
+std::string LevelDbRemoteDocumentKey::KeyWithEncodedPath(
+    absl::string_view encoded_document_key) {
+  std::string result;
+  WriteTableName(&result, kRemoteDocumentsTable);
+  result.append(encoded_document_key.data(), encoded_document_key.size());
+  WriteTerminator(&result);
+  return result;
+}
+
+bool LevelDbRemoteDocumentKey::Decode(absl::string_view key) {
+  Reader reader{key, &buffer_};
+  return reader.ReadTableNameMatching(kRemoteDocumentsTable) &&
+         reader.ReadDocumentKey(&document_key_) && reader.ReadTerminator();
+}
+
+std::string LevelDbIndexEntryKey::KeyPrefix() {
+  std::string result;
+  WriteTableName(&result, kIndexEntriesTable);
+  return result;
+}
+
+std::string LevelDbIndexEntryKey::KeyPrefix(const PathSegments& collection_path,
+                                            absl::string_view field_path) {
+  std::string result;
+  WriteTableName(&result, kIndexEntriesTable);
+  WriteResourcePath(&result, collection_path);
+  WriteFieldPath(&result, field_path);
+  return result;
+}
+
+std::string LevelDbIndexEntryKey::KeyPrefix(const PathSegments& collection_path,
+                                            absl::string_view field_path,
+                                            absl::string_view index_value) {
+  std::string result;
+  WriteTableName(&result, kIndexEntriesTable);
+  WriteResourcePath(&result, collection_path);
+  WriteFieldPath(&result, field_path);
+  WriteIndexValue(&result, index_value);
+  return result;
+}
+
+std::string LevelDbIndexEntryKey::Key(const PathSegments& collection_path,
+                                      absl::string_view field_path,
+                                      absl::string_view index_value,
+                                      absl::string_view document_id) {
+  std::string result;
+  WriteTableName(&result, kIndexEntriesTable);
+  WriteResourcePath(&result, collection_path);
+  WriteFieldPath(&result, field_path);
+  WriteIndexValue(&result, index_value);
+  WriteDocumentId(&result, document_id);
+  WriteTerminator(&result);
+  return result;
+}
+
+bool LevelDbIndexEntryKey::Decode(absl::string_view key) {
+  Reader reader{key, &buffer_};
+  return reader.ReadTableNameMatching(kIndexEntriesTable) &&
+         reader.ReadResourcePath(&collection_path_) &&
+         collection_path_.size() % 2 == 1 &&
+         reader.ReadFieldPath(&field_path_) &&
+         reader.ReadIndexValue(&index_value_) &&
+         reader.ReadDocumentId(&document_id_) && reader.ReadTerminator();
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
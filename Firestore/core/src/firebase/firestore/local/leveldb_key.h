@@ -0,0 +1,575 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_KEY_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_KEY_H_
+
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+// Key encoding and decoding for all the LevelDB logical tables. The key
+// structure of each table is:
+//
+// mutations:
+//   - table_name: string = "mutation"
+//   - user_id: string
+//   - batch_id: model::BatchId
+//
+// document_mutations:
+//   - table_name: string = "document_mutation"
+//   - user_id: string
+//   - path: ResourcePath
+//   - batch_id: model::BatchId
+//
+// mutation_queues:
+//   - table_name: string = "mutation_queue"
+//   - user_id: string
+//
+// targets:
+//   - table_name: string = "target"
+//   - target_id: model::TargetId
+//
+// target_globals:
+//   - table_name: string = "target_global"
+//
+// query_targets:
+//   - table_name: string = "query_target"
+//   - canonical_id: string
+//   - target_id: model::TargetId
+//
+// target_documents:
+//   - table_name: string = "target_document"
+//   - target_id: model::TargetId
+//   - path: ResourcePath
+//
+// document_targets:
+//   - table_name: string = "document_target"
+//   - path: ResourcePath
+//   - target_id: model::TargetId
+//
+// remote_documents:
+//   - table_name: string = "remote_document"
+//   - path: ResourcePath
+//
+// index_entries:
+//   - table_name: string = "index_entry"
+//   - collection_path: ResourcePath
+//   - field_path: string
+//   - index_value: string
+//   - document_id: string
+//
+// Each key type has static functions to encode complete keys and key
+// prefixes, and can be instantiated as a decoder for complete keys. Decoders
+// are meant to be reused across all the rows of a scan: decoded strings and
+// path segments point either into the key being decoded or into a buffer
+// owned by the decoder, so decoding a key usually performs no allocations.
+// Consequently, decoded values are only valid as long as the key is, and
+// until the next call to Decode(). Decoders are not copyable for the same
+// reason.
+
+/** The segments of a resource path, e.g. {"rooms", "abc"}. */
+using PathSegments = std::vector<absl::string_view>;
+
+/**
+ * Parses the given key and returns a human readable description of its
+ * contents, suitable for error messages and logging.
+ */
+std::string DescribeKey(absl::string_view key);
+
+/**
+ * Encodes the segments of a resource path the way they appear in keys. The
+ * encodings of two paths compare bytewise in the same order as the paths
+ * themselves, so callers can keep the encoding around to compare paths with a
+ * single memcmp and to build keys without re-encoding the path.
+ */
+std::string EncodeResourcePath(const PathSegments& path);
+
+namespace impl {
+
+/** Common state shared by all key decoders. */
+class LevelDbKeyDecoder {
+ public:
+  LevelDbKeyDecoder() {
+  }
+
+  LevelDbKeyDecoder(const LevelDbKeyDecoder&) = delete;
+  LevelDbKeyDecoder& operator=(const LevelDbKeyDecoder&) = delete;
+
+ protected:
+  // Holds the unescaped contents of any strings that can't be referenced in
+  // place in the key.
+  std::string buffer_;
+};
+
+}  // namespace impl
+
+/** A key to a singleton row storing the version of the schema. */
+class LevelDbVersionKey {
+ public:
+  /** Returns the key pointing to the singleton row storing the version. */
+  static std::string Key();
+};
+
+/**
+ * A key to a singleton row recording how far a schema migration that is run
+ * in several batches has got, so that it can resume after an interruption.
+ */
+class LevelDbMigrationProgressKey {
+ public:
+  /** Returns the key pointing to the singleton migration progress row. */
+  static std::string Key();
+};
+
+/** A key in the mutations table. */
+class LevelDbMutationKey : public impl::LevelDbKeyDecoder {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a key prefix that points just before the first key for user_id. */
+  static std::string KeyPrefix(absl::string_view user_id);
+
+  /** Creates a complete key that points to a specific user_id and batch_id. */
+  static std::string Key(absl::string_view user_id, model::BatchId batch_id);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   *     returned, this instance is in an undefined state until the next call
+   *     to Decode().
+   */
+  bool Decode(absl::string_view key);
+
+  /** The user that owns the mutation batches. */
+  absl::string_view user_id() const {
+    return user_id_;
+  }
+
+  /** The batch_id of the batch. */
+  model::BatchId batch_id() const {
+    return batch_id_;
+  }
+
+ private:
+  absl::string_view user_id_;
+  model::BatchId batch_id_ = 0;
+};
+
+/**
+ * A key in the document mutations index, which stores the batches in which
+ * documents are mutated.
+ */
+class LevelDbDocumentMutationKey : public impl::LevelDbKeyDecoder {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a key prefix that points just before the first key for user_id. */
+  static std::string KeyPrefix(absl::string_view user_id);
+
+  /**
+   * Creates a key prefix that points just before the first key for the user_id
+   * and resource path.
+   *
+   * Note that this uses a resource path rather than a document key in order
+   * to allow prefix scans over a collection. However a naive scan over those
+   * results isn't useful since it would match both immediate children of the
+   * collection and any subcollections.
+   */
+  static std::string KeyPrefix(absl::string_view user_id,
+                               const PathSegments& resource_path);
+
+  /**
+   * Creates a complete key that points to a specific user_id, document key,
+   * and batch_id.
+   */
+  static std::string Key(absl::string_view user_id,
+                         const PathSegments& document_key,
+                         model::BatchId batch_id);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   *     returned, this instance is in an undefined state until the next call
+   *     to Decode().
+   */
+  bool Decode(absl::string_view key);
+
+  /** The user that owns the mutation batches. */
+  absl::string_view user_id() const {
+    return user_id_;
+  }
+
+  /** The path to the document, as encoded in the key. */
+  const PathSegments& document_key() const {
+    return document_key_;
+  }
+
+  /** The batch_id in which the document participates. */
+  model::BatchId batch_id() const {
+    return batch_id_;
+  }
+
+ private:
+  absl::string_view user_id_;
+  PathSegments document_key_;
+  model::BatchId batch_id_ = 0;
+};
+
+/**
+ * A key in the mutation_queues table.
+ *
+ * Note that where mutation_queues contains one row about each queue,
+ * mutations contains the actual mutation batches themselves.
+ */
+class LevelDbMutationQueueKey : public impl::LevelDbKeyDecoder {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a complete key that points to a specific mutation queue entry for
+   * the given user_id.
+   */
+  static std::string Key(absl::string_view user_id);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   *     returned, this instance is in an undefined state until the next call
+   *     to Decode().
+   */
+  bool Decode(absl::string_view key);
+
+  absl::string_view user_id() const {
+    return user_id_;
+  }
+
+ private:
+  absl::string_view user_id_;
+};
+
+/**
+ * A key in the target globals table, a record of global values across all
+ * targets.
+ */
+class LevelDbTargetGlobalKey : public impl::LevelDbKeyDecoder {
+ public:
+  /** Creates a key that points to the single target global row. */
+  static std::string Key();
+
+  /**
+   * Decodes the contents of a target global key, essentially just verifying
+   * that the key has the correct table name.
+   */
+  bool Decode(absl::string_view key);
+};
+
+/** A key in the targets table. */
+class LevelDbTargetKey : public impl::LevelDbKeyDecoder {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a complete key that points to a specific target, by target_id. */
+  static std::string Key(model::TargetId target_id);
+
+  /**
+   * Decodes the contents of a target key into properties on this instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   *     returned, this instance is in an undefined state until the next call
+   *     to Decode().
+   */
+  bool Decode(absl::string_view key);
+
+  /** The target_id identifying a target. */
+  model::TargetId target_id() const {
+    return target_id_;
+  }
+
+ private:
+  model::TargetId target_id_ = 0;
+};
+
+/**
+ * A key in the query targets table, an index of canonical_ids to the targets
+ * they may match. This is not a unique mapping because canonical_id does not
+ * promise a unique name for all possible queries.
+ */
+class LevelDbQueryTargetKey : public impl::LevelDbKeyDecoder {
+ public:
+  /**
+   * Creates a key that contains just the query targets table prefix and
+   * points just before the first key.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key that points to the first query-target association for a
+   * canonical_id.
+   */
+  static std::string KeyPrefix(absl::string_view canonical_id);
+
+  /** Creates a key that points to a specific query-target entry. */
+  static std::string Key(absl::string_view canonical_id,
+                         model::TargetId target_id);
+
+  /** Decodes the contents of a query target key into this instance. */
+  bool Decode(absl::string_view key);
+
+  /** The canonical_id derived from the query. */
+  absl::string_view canonical_id() const {
+    return canonical_id_;
+  }
+
+  /** The target_id identifying a target. */
+  model::TargetId target_id() const {
+    return target_id_;
+  }
+
+ private:
+  absl::string_view canonical_id_;
+  model::TargetId target_id_ = 0;
+};
+
+/**
+ * A key in the target documents table, an index of target_ids to the
+ * documents they contain.
+ */
+class LevelDbTargetDocumentKey : public impl::LevelDbKeyDecoder {
+ public:
+  /**
+   * Creates a key that contains just the target documents table prefix and
+   * points just before the first key.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key that points to the first target-document association for a
+   * target_id.
+   */
+  static std::string KeyPrefix(model::TargetId target_id);
+
+  /** Creates a key that points to a specific target-document entry. */
+  static std::string Key(model::TargetId target_id,
+                         const PathSegments& document_key);
+
+  /** Decodes the contents of a target document key into this instance. */
+  bool Decode(absl::string_view key);
+
+  /** The target_id identifying a target. */
+  model::TargetId target_id() const {
+    return target_id_;
+  }
+
+  /** The path to the document, as encoded in the key. */
+  const PathSegments& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  model::TargetId target_id_ = 0;
+  PathSegments document_key_;
+};
+
+/**
+ * A key in the document targets table, an index from documents to the
+ * targets that contain them.
+ */
+class LevelDbDocumentTargetKey : public impl::LevelDbKeyDecoder {
+ public:
+  /**
+   * Creates a key that contains just the document targets table prefix and
+   * points just before the first key.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key that points to the first document-target association for
+   * the document at the given resource path.
+   */
+  static std::string KeyPrefix(const PathSegments& resource_path);
+
+  /** Creates a key that points to a specific document-target entry. */
+  static std::string Key(const PathSegments& document_key,
+                         model::TargetId target_id);
+
+  /** Decodes the contents of a document target key into this instance. */
+  bool Decode(absl::string_view key);
+
+  /** The target_id identifying a target. */
+  model::TargetId target_id() const {
+    return target_id_;
+  }
+
+  /** The path to the document, as encoded in the key. */
+  const PathSegments& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  PathSegments document_key_;
+  model::TargetId target_id_ = 0;
+};
+
+/** A key in the remote documents table. */
+class LevelDbRemoteDocumentKey : public impl::LevelDbKeyDecoder {
+ public:
+  /**
+   * Creates a key that contains just the remote documents table prefix and
+   * points just before the first remote document key.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that contains a part of a document path. Odd numbers
+   * of segments create a collection key prefix, while an even number of
+   * segments create a document key prefix. Note that a document key prefix
+   * will match the document itself and any documents that exist in its
+   * subcollections.
+   */
+  static std::string KeyPrefix(const PathSegments& resource_path);
+
+  /**
+   * Creates a complete key that points to a specific document. The
+   * document_key must have an even number of path segments.
+   */
+  static std::string Key(const PathSegments& document_key);
+
+  /**
+   * Creates a complete key that points to a specific document, given the
+   * result of EncodeResourcePath() for a document key.
+   */
+  static std::string KeyWithEncodedPath(absl::string_view encoded_document_key);
+
+  /**
+   * Decodes the contents of a remote document key into this instance. This
+   * can only decode complete document paths (i.e. the result of Key()).
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   *     returned, this instance is in an undefined state until the next call
+   *     to Decode().
+   */
+  bool Decode(absl::string_view key);
+
+  /** The path to the document, as encoded in the key. */
+  const PathSegments& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  PathSegments document_key_;
+};
+
+/**
+ * A key in the field index table, which maps values of the fields of remote
+ * documents back to the documents containing them.
+ *
+ * The index value is an opaque, order-preserving encoding of a field value
+ * chosen by the caller; keys for a given collection and field sort by index
+ * value and then by document ID.
+ */
+class LevelDbIndexEntryKey : public impl::LevelDbKeyDecoder {
+ public:
+  /**
+   * Creates a key that contains just the index entries table prefix and
+   * points just before the first index entry.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first entry for the
+   * given field of documents in the given collection.
+   */
+  static std::string KeyPrefix(const PathSegments& collection_path,
+                               absl::string_view field_path);
+
+  /**
+   * Creates a key prefix that points just before the first entry for the
+   * given value of a field of documents in the given collection, i.e. to the
+   * entry with the lowest document ID. Entries with index values that have
+   * this value as a prefix sort after it.
+   */
+  static std::string KeyPrefix(const PathSegments& collection_path,
+                               absl::string_view field_path,
+                               absl::string_view index_value);
+
+  /**
+   * Creates a complete key that points to the entry for the given value of a
+   * field of the given document in the given collection.
+   */
+  static std::string Key(const PathSegments& collection_path,
+                         absl::string_view field_path,
+                         absl::string_view index_value,
+                         absl::string_view document_id);
+
+  /** Decodes the contents of an index entry key into this instance. */
+  bool Decode(absl::string_view key);
+
+  /** The path to the collection containing the document. */
+  const PathSegments& collection_path() const {
+    return collection_path_;
+  }
+
+  /** The canonical form of the path to the indexed field. */
+  absl::string_view field_path() const {
+    return field_path_;
+  }
+
+  /** The encoded value of the field, as passed to Key(). */
+  absl::string_view index_value() const {
+    return index_value_;
+  }
+
+  /** The ID of the document within the collection. */
+  absl::string_view document_id() const {
+    return document_id_;
+  }
+
+ private:
+  PathSegments collection_path_;
+  absl::string_view field_path_;
+  absl::string_view index_value_;
+  absl::string_view document_id_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_KEY_H_
@@ -0,0 +1,254 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_BASE_PATH_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_BASE_PATH_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+namespace impl {
+
+/**
+ * BasePath represents a path sequence in the Firestore database. It is composed
+ * of an ordered sequence of string segments.
+ *
+ * BasePath is immutable. The segments are kept in a vector shared by all the
+ * paths derived from one another by removing segments from either end, so
+ * PopFirst() and PopLast() are O(1) and copying a path never copies its
+ * segments. Appending creates a new vector.
+ *
+ * Paths compare segment by segment by the UTF-8 bytes of the segments, without
+ * involving any platform string type.
+ *
+ * Subclasses use the curiously recurring template pattern: T is the subclass,
+ * which must make BasePath<T> a friend and provide constructors taking
+ * `SegmentsType&&` and `(std::shared_ptr<const SegmentsType>, size_t begin,
+ * size_t end)`.
+ */
+template <typename T>
+class BasePath {
+ protected:
+  using SegmentsType = std::vector<std::string>;
+
+ public:
+  using const_iterator = SegmentsType::const_iterator;
+
+  /** Returns i-th segment of the path. */
+  const std::string& operator[](const size_t index) const {
+    FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(index < size(), index < size(),
+                                            "index %u out of range",
+                                            static_cast<unsigned>(index));
+    return (*segments_)[begin_ + index];
+  }
+
+  /** Returns the first segment of the path. */
+  const std::string& first_segment() const {
+    FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+        !empty(), !empty(), "Cannot call first_segment on empty path");
+    return (*this)[0];
+  }
+
+  /** Returns the last segment of the path. */
+  const std::string& last_segment() const {
+    FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+        !empty(), !empty(), "Cannot call last_segment on empty path");
+    return (*this)[size() - 1];
+  }
+
+  size_t size() const {
+    return end_ - begin_;
+  }
+
+  bool empty() const {
+    return begin_ == end_;
+  }
+
+  const_iterator begin() const {
+    return segments_->begin() + begin_;
+  }
+
+  const_iterator end() const {
+    return segments_->begin() + end_;
+  }
+
+  /**
+   * Returns a new path which is the result of concatenating this path with an
+   * additional segment.
+   */
+  T Append(const std::string& segment) const {
+    SegmentsType appended{begin(), end()};
+    appended.push_back(segment);
+    return T{std::move(appended)};
+  }
+
+  T Append(std::string&& segment) const {
+    SegmentsType appended{begin(), end()};
+    appended.push_back(std::move(segment));
+    return T{std::move(appended)};
+  }
+
+  /**
+   * Returns a new path which is the result of concatenating this path with
+   * another path.
+   */
+  T Append(const T& path) const {
+    SegmentsType appended{begin(), end()};
+    appended.insert(appended.end(), path.begin(), path.end());
+    return T{std::move(appended)};
+  }
+
+  /**
+   * Returns a new path which is the result of omitting the first n segments of
+   * this path. Shares this path's segments, so takes constant time.
+   */
+  T PopFirst(const size_t n = 1) const {
+    FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+        n <= size(), n <= size(),
+        "Cannot call PopFirst(%u) on path of length %u",
+        static_cast<unsigned>(n), static_cast<unsigned>(size()));
+    return T{segments_, begin_ + n, end_};
+  }
+
+  /**
+   * Returns a new path which is the result of omitting the last segment of
+   * this path. Shares this path's segments, so takes constant time.
+   */
+  T PopLast() const {
+    FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+        !empty(), !empty(), "Cannot call PopLast() on empty path");
+    return T{segments_, begin_, end_ - 1};
+  }
+
+  /**
+   * Returns true if this path is a prefix of the given path.
+   *
+   * Empty path is a prefix of any path. Any path is a prefix of itself.
+   */
+  bool IsPrefixOf(const T& rhs) const {
+    return size() <= rhs.size() && std::equal(begin(), end(), rhs.begin());
+  }
+
+  /**
+   * Three-way comparison: returns a negative number, zero or a positive number
+   * if this path sorts before, equal to or after the given path.
+   */
+  int CompareTo(const T& rhs) const {
+    size_t length = std::min(size(), rhs.size());
+    for (size_t i = 0; i < length; ++i) {
+      int result = (*this)[i].compare(rhs[i]);
+      if (result != 0) {
+        return result < 0 ? -1 : 1;
+      }
+    }
+    if (size() == rhs.size()) {
+      return 0;
+    }
+    return size() < rhs.size() ? -1 : 1;
+  }
+
+  /** Returns a hash of the path's segments, consistent with equality. */
+  size_t Hash() const {
+    size_t result = 0;
+    std::hash<std::string> hash;
+    for (const std::string& segment : *this) {
+      result = 31 * result + hash(segment);
+    }
+    return result;
+  }
+
+  bool operator==(const BasePath& rhs) const {
+    return size() == rhs.size() && std::equal(begin(), end(), rhs.begin());
+  }
+  bool operator!=(const BasePath& rhs) const {
+    return !(*this == rhs);
+  }
+  bool operator<(const BasePath& rhs) const {
+    return Compare(rhs) < 0;
+  }
+  bool operator>(const BasePath& rhs) const {
+    return Compare(rhs) > 0;
+  }
+  bool operator<=(const BasePath& rhs) const {
+    return Compare(rhs) <= 0;
+  }
+  bool operator>=(const BasePath& rhs) const {
+    return Compare(rhs) >= 0;
+  }
+
+ protected:
+  BasePath() : segments_{EmptySegments()} {
+  }
+
+  template <typename IterT>
+  BasePath(const IterT begin, const IterT end)
+      : BasePath{std::make_shared<SegmentsType>(begin, end)} {
+  }
+
+  BasePath(std::initializer_list<std::string> list)
+      : BasePath{list.begin(), list.end()} {
+  }
+
+  explicit BasePath(SegmentsType&& segments)
+      : BasePath{std::make_shared<SegmentsType>(std::move(segments))} {
+  }
+
+  explicit BasePath(std::shared_ptr<const SegmentsType> segments)
+      : segments_{std::move(segments)}, begin_{0}, end_{segments_->size()} {
+  }
+
+  BasePath(std::shared_ptr<const SegmentsType> segments,
+           size_t begin,
+           size_t end)
+      : segments_{std::move(segments)}, begin_{begin}, end_{end} {
+  }
+
+  ~BasePath() = default;
+
+ private:
+  /** All empty paths share one vector, so creating them doesn't allocate. */
+  static const std::shared_ptr<const SegmentsType>& EmptySegments() {
+    static const auto* empty = new std::shared_ptr<const SegmentsType>(
+        std::make_shared<SegmentsType>());
+    return *empty;
+  }
+
+  int Compare(const BasePath& rhs) const {
+    return CompareTo(static_cast<const T&>(rhs));
+  }
+
+  std::shared_ptr<const SegmentsType> segments_;
+  size_t begin_ = 0;
+  size_t end_ = 0;
+};
+
+}  // namespace impl
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_BASE_PATH_H_
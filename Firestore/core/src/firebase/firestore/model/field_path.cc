@@ -0,0 +1,168 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+namespace {
+
+/**
+ * Returns true if the string could be used as a segment in a field path
+ * without escaping. Valid identifiers follow the regex
+ * [a-zA-Z_][a-zA-Z_0-9]*.
+ */
+bool IsValidIdentifier(const std::string& segment) {
+  if (segment.empty()) {
+    return false;
+  }
+
+  // Note: strictly speaking, only digits are guaranteed by the Standard to
+  // be a contiguous range, while alphabetic characters may have gaps. Ignoring
+  // this peculiarity, because it doesn't affect the platforms that Firestore
+  // supports.
+  const unsigned char first = segment.front();
+  if (first != '_' && (first < 'a' || first > 'z') &&
+      (first < 'A' || first > 'Z')) {
+    return false;
+  }
+  for (size_t i = 1; i < segment.size(); ++i) {
+    const unsigned char c = segment[i];
+    if (c != '_' && (c < 'a' || c > 'z') && (c < 'A' || c > 'Z') &&
+        (c < '0' || c > '9')) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace
+
+constexpr const char* FieldPath::kDocumentKeyPath;
+
+FieldPath FieldPath::FromServerFormat(const absl::string_view path) {
+  // TODO(b/37244157): Once we move to v1beta1, we should make this more
+  // strict. Right now, it allows non-identifier path components, even if they
+  // aren't escaped. Technically, this will mangle paths with backticks in them
+  // used in v1alpha1, but that's fine.
+
+  SegmentsType segments;
+  std::string segment;
+  segment.reserve(path.size());
+
+  const auto finish_segment = [&segments, &segment, &path] {
+    FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+        !segment.empty(), !segment.empty(),
+        "Invalid field path (%s). Paths must not be empty, begin with "
+        "'.', end with '.', or contain '..'",
+        std::string{path}.c_str());
+    segments.push_back(std::move(segment));
+    segment.clear();
+  };
+
+  // If we're inside '`' backticks, then we should ignore '.' dots.
+  bool inside_backticks = false;
+
+  size_t i = 0;
+  while (i < path.size()) {
+    const char c = path[i];
+    switch (c) {
+      case '.':
+        if (!inside_backticks) {
+          finish_segment();
+        } else {
+          segment += c;
+        }
+        break;
+
+      case '`':
+        inside_backticks = !inside_backticks;
+        break;
+
+      case '\\':
+        // TODO(b/37244157): Make this a user-facing exception once we
+        // finalize field escaping.
+        FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+            i + 1 != path.size(), i + 1 != path.size(),
+            "Trailing escape characters not allowed in %s",
+            std::string{path}.c_str());
+        ++i;
+        segment += path[i];
+        break;
+
+      default:
+        segment += c;
+        break;
+    }
+    ++i;
+  }
+  finish_segment();
+
+  FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(!inside_backticks, !inside_backticks,
+                                          "Unterminated ` in path %s",
+                                          std::string{path}.c_str());
+
+  return FieldPath{std::move(segments)};
+}
+
+const FieldPath& FieldPath::EmptyPath() {
+  static const FieldPath* empty_path = new FieldPath{};
+  return *empty_path;
+}
+
+const FieldPath& FieldPath::KeyFieldPath() {
+  static const FieldPath* key_field_path = new FieldPath{kDocumentKeyPath};
+  return *key_field_path;
+}
+
+bool FieldPath::IsKeyFieldPath() const {
+  return size() == 1 && first_segment() == kDocumentKeyPath;
+}
+
+std::string FieldPath::CanonicalString() const {
+  std::string result;
+  for (auto iter = begin(); iter != end(); ++iter) {
+    if (iter != begin()) {
+      result += '.';
+    }
+
+    std::string escaped;
+    escaped.reserve(iter->size());
+    for (const char c : *iter) {
+      if (c == '\\' || c == '`') {
+        escaped += '\\';
+      }
+      escaped += c;
+    }
+    if (!IsValidIdentifier(escaped)) {
+      escaped = '`' + escaped + '`';
+    }
+
+    result += escaped;
+  }
+  return result;
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -17,17 +17,23 @@
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 
 #include <math.h>
+#include <string.h>
 
 #include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <map>
 #include <memory>
+#include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
 #include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
 
-using firebase::firestore::util::Comparator;
-
 namespace firebase {
 namespace firestore {
 namespace model {
@@ -56,21 +62,297 @@ bool Comparable(Type lhs, Type rhs) {
   }
 }
 
+constexpr double kInt64MinValueAsDouble =
+    static_cast<double>(std::numeric_limits<int64_t>::min());
+constexpr double kInt64MaxValueAsDouble =
+    static_cast<double>(std::numeric_limits<int64_t>::max());
+
+uint32_t CombineHash(uint32_t hash, size_t value) {
+  return 31 * hash + static_cast<uint32_t>(value ^ (value >> 16 >> 16));
+}
+
+uint32_t Int64Hash(int64_t value) {
+  auto bits = static_cast<uint64_t>(value);
+  return static_cast<uint32_t>(bits ^ (bits >> 32));
+}
+
+/**
+ * Hashes a double such that it collides with the hash of any int64_t it
+ * compares equal to, and such that -0.0 and 0.0 (and all NaNs) hash the same.
+ */
+uint32_t DoubleHash(double value) {
+  if (value >= kInt64MinValueAsDouble && value < kInt64MaxValueAsDouble &&
+      value == floor(value)) {
+    return Int64Hash(static_cast<int64_t>(value));
+  }
+  return static_cast<uint32_t>(util::DoubleBitwiseHash(value));
+}
+
+uint32_t TimestampHash(const Timestamp& value) {
+  return CombineHash(Int64Hash(value.seconds()),
+                     static_cast<uint32_t>(value.nanos()));
+}
+
+/**
+ * Performs a three-way comparison of two values using their operator<. Unlike
+ * util::Compare this doesn't require a util::Comparator specialization.
+ */
+template <typename T>
+ComparisonResult CompareValues(const T& lhs, const T& rhs) {
+  if (lhs < rhs) {
+    return ComparisonResult::Ascending;
+  } else if (rhs < lhs) {
+    return ComparisonResult::Descending;
+  } else {
+    return ComparisonResult::Same;
+  }
+}
+
+ComparisonResult CompareTimestamps(const Timestamp& lhs, const Timestamp& rhs) {
+  ComparisonResult result = CompareValues(lhs.seconds(), rhs.seconds());
+  if (result != ComparisonResult::Same) {
+    return result;
+  }
+  return CompareValues(lhs.nanos(), rhs.nanos());
+}
+
+ComparisonResult CompareBytes(absl::string_view lhs, absl::string_view rhs) {
+  return CompareValues(lhs.compare(rhs), 0);
+}
+
+uint32_t BytesHash(absl::string_view bytes) {
+  uint32_t hash = 0;
+  for (char byte : bytes) {
+    hash = CombineHash(hash, static_cast<uint8_t>(byte));
+  }
+  return hash;
+}
+
+/**
+ * Lexicographically compares two ranges, visiting each pair of elements once
+ * with the given three-way comparison.
+ */
+template <typename Iterator, typename ThreeWayCompare>
+ComparisonResult CompareRanges(Iterator lhs_begin,
+                               Iterator lhs_end,
+                               Iterator rhs_begin,
+                               Iterator rhs_end,
+                               const ThreeWayCompare& compare) {
+  for (; lhs_begin != lhs_end && rhs_begin != rhs_end;
+       ++lhs_begin, ++rhs_begin) {
+    ComparisonResult result = compare(*lhs_begin, *rhs_begin);
+    if (result != ComparisonResult::Same) {
+      return result;
+    }
+  }
+  if (lhs_begin != lhs_end) {
+    return ComparisonResult::Descending;
+  } else if (rhs_begin != rhs_end) {
+    return ComparisonResult::Ascending;
+  } else {
+    return ComparisonResult::Same;
+  }
+}
+
+template <Type type>
+using TypeTag = FieldValue::TypeTag<type>;
+
+/** Combines the hash of a FieldValue's payload into a seed, via Visit(). */
+class PayloadHasher {
+ public:
+  explicit PayloadHasher(uint32_t seed) : seed_(seed) {
+  }
+
+  uint32_t operator()(TypeTag<Type::Null>, std::nullptr_t) const {
+    return seed_;
+  }
+
+  uint32_t operator()(TypeTag<Type::Boolean>, bool value) const {
+    return CombineHash(seed_, value);
+  }
+
+  uint32_t operator()(TypeTag<Type::Long>, int64_t value) const {
+    return CombineHash(seed_, Int64Hash(value));
+  }
+
+  uint32_t operator()(TypeTag<Type::Double>, double value) const {
+    return CombineHash(seed_, DoubleHash(value));
+  }
+
+  uint32_t operator()(TypeTag<Type::Timestamp>, const Timestamp& value) const {
+    return CombineHash(seed_, TimestampHash(value));
+  }
+
+  uint32_t operator()(TypeTag<Type::ServerTimestamp>,
+                      const ServerTimestamp& value) const {
+    // Only the local write time takes part in comparisons.
+    return CombineHash(seed_, TimestampHash(value.local_write_time));
+  }
+
+  uint32_t operator()(TypeTag<Type::String>, absl::string_view value) const {
+    return CombineHash(seed_, BytesHash(value));
+  }
+
+  uint32_t operator()(TypeTag<Type::Blob>, absl::string_view value) const {
+    return CombineHash(seed_, BytesHash(value));
+  }
+
+  uint32_t operator()(TypeTag<Type::GeoPoint>, const GeoPoint& value) const {
+    uint32_t hash = CombineHash(seed_, DoubleHash(value.latitude()));
+    return CombineHash(hash, DoubleHash(value.longitude()));
+  }
+
+  uint32_t operator()(TypeTag<Type::Array>,
+                      const std::vector<FieldValue>& value) const {
+    uint32_t hash = seed_;
+    for (const FieldValue& element : value) {
+      hash = CombineHash(hash, element.Hash());
+    }
+    return hash;
+  }
+
+  uint32_t operator()(TypeTag<Type::Object>,
+                      const FieldValue::Map& value) const {
+    uint32_t hash = seed_;
+    for (const auto& entry : value) {
+      hash = CombineHash(hash, std::hash<std::string>()(entry.first));
+      hash = CombineHash(hash, entry.second.Hash());
+    }
+    return hash;
+  }
+
+ private:
+  uint32_t seed_;
+};
+
+// ServerTimestamp is the largest of the trivially copyable payloads, so
+// copying its bytes copies whichever of them is active.
+static_assert(sizeof(ServerTimestamp) >= sizeof(int64_t) &&
+                  sizeof(ServerTimestamp) >= sizeof(double) &&
+                  sizeof(ServerTimestamp) >= sizeof(Timestamp) &&
+                  sizeof(ServerTimestamp) >= sizeof(GeoPoint),
+              "ServerTimestamp must be the largest trivial payload");
+static_assert(std::is_trivially_copyable<Timestamp>::value &&
+                  std::is_trivially_copyable<ServerTimestamp>::value &&
+                  std::is_trivially_copyable<GeoPoint>::value,
+              "Payloads marked IsTriviallyCopyable must be so");
+
+/** Tests two doubles for equality, treating all NaNs as equal. */
+bool DoubleEquals(double lhs, double rhs) {
+  return lhs == rhs || (isnan(lhs) && isnan(rhs));
+}
+
 }  // namespace
 
-FieldValue::FieldValue(const FieldValue& value) {
+constexpr size_t FieldValue::CompactString::kInlineCapacity;
+constexpr uint8_t FieldValue::CompactString::kHeap;
+
+FieldValue::CompactString::CompactString(const char* data, size_t size)
+    : inline_size_(0) {
+  if (size <= kInlineCapacity) {
+    if (size > 0) {
+      memcpy(inline_, data, size);
+    }
+    inline_size_ = static_cast<uint8_t>(size);
+  } else {
+    new (&heap_) std::shared_ptr<const std::string>(
+        std::make_shared<const std::string>(data, size));
+    inline_size_ = kHeap;
+  }
+}
+
+FieldValue::CompactString::CompactString(std::string&& value)
+    : inline_size_(0) {
+  if (value.size() <= kInlineCapacity) {
+    memcpy(inline_, value.data(), value.size());
+    inline_size_ = static_cast<uint8_t>(value.size());
+  } else {
+    // Take over the string's own buffer rather than copying it.
+    new (&heap_) std::shared_ptr<const std::string>(
+        std::make_shared<const std::string>(std::move(value)));
+    inline_size_ = kHeap;
+  }
+}
+
+FieldValue::CompactString::CompactString(const CompactString& other)
+    : inline_size_(0) {
+  *this = other;
+}
+
+FieldValue::CompactString::CompactString(CompactString&& other)
+    : inline_size_(0) {
+  *this = std::move(other);
+}
+
+FieldValue::CompactString::~CompactString() {
+  Reset();
+}
+
+FieldValue::CompactString& FieldValue::CompactString::operator=(
+    const CompactString& other) {
+  if (this == &other) {
+    return *this;
+  }
+  Reset();
+  if (other.is_inline()) {
+    memcpy(inline_, other.inline_, other.inline_size_);
+  } else {
+    new (&heap_) std::shared_ptr<const std::string>(other.heap_);
+  }
+  inline_size_ = other.inline_size_;
+  return *this;
+}
+
+FieldValue::CompactString& FieldValue::CompactString::operator=(
+    CompactString&& other) {
+  if (this == &other) {
+    return *this;
+  }
+  if (other.is_inline()) {
+    return *this = other;
+  }
+  Reset();
+  new (&heap_) std::shared_ptr<const std::string>(std::move(other.heap_));
+  inline_size_ = kHeap;
+  other.Reset();
+  return *this;
+}
+
+void FieldValue::CompactString::Reset() {
+  if (!is_inline()) {
+    heap_.~shared_ptr();
+  }
+  inline_size_ = 0;
+}
+
+FieldValue::FieldValue(const FieldValue& value) : tag_(Type::Null), hash_(0) {
   *this = value;
 }
 
-FieldValue::FieldValue(FieldValue&& value) {
+FieldValue::FieldValue(FieldValue&& value) : tag_(Type::Null), hash_(0) {
   *this = std::move(value);
 }
 
 FieldValue::~FieldValue() {
-  SwitchTo(Type::Null);
+  if (!IsTriviallyCopyable(tag_)) {
+    SwitchTo(Type::Null);
+  }
 }
 
 FieldValue& FieldValue::operator=(const FieldValue& value) {
+  if (IsTriviallyCopyable(tag_) && IsTriviallyCopyable(value.tag_)) {
+    // Neither payload needs to be destroyed or constructed, so skip SwitchTo
+    // and copy the union bytewise.
+    if (this != &value) {
+      tag_ = value.tag_;
+      memcpy(&server_timestamp_value_, &value.server_timestamp_value_,
+             sizeof(ServerTimestamp));
+      hash_.store(value.hash_.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+    }
+    return *this;
+  }
+
   SwitchTo(value.tag_);
   switch (tag_) {
     case Type::Null:
@@ -91,58 +373,62 @@ FieldValue& FieldValue::operator=(const FieldValue& value) {
       server_timestamp_value_ = value.server_timestamp_value_;
       break;
     case Type::String:
+      // Heap-allocated payloads are immutable, so copies share them.
       string_value_ = value.string_value_;
       break;
-    case Type::Blob: {
-      // copy-and-swap
-      std::vector<uint8_t> tmp = value.blob_value_;
-      std::swap(blob_value_, tmp);
+    case Type::Blob:
+      blob_value_ = value.blob_value_;
       break;
-    }
     case Type::GeoPoint:
       geo_point_value_ = value.geo_point_value_;
       break;
-    case Type::Array: {
-      // copy-and-swap
-      std::vector<FieldValue> tmp = value.array_value_;
-      std::swap(array_value_, tmp);
+    case Type::Array:
+      array_value_ = value.array_value_;
       break;
-    }
-    case Type::Object: {
-      // copy-and-swap
-      std::map<const std::string, const FieldValue> tmp = value.object_value_;
-      std::swap(object_value_, tmp);
+    case Type::Object:
+      // Copying the immutable map just shares its contents.
+      object_value_ = value.object_value_;
       break;
-    }
     default:
       FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
           false, lhs.type(), "Unsupported type %d", value.type());
   }
+  hash_.store(value.hash_.load(std::memory_order_relaxed),
+              std::memory_order_relaxed);
   return *this;
 }
 
 FieldValue& FieldValue::operator=(FieldValue&& value) {
+  // The moved-from payloads are left empty, so moved-from values of these
+  // types revert to Null rather than holding a null payload pointer.
+  uint32_t hash = value.hash_.load(std::memory_order_relaxed);
   switch (value.tag_) {
     case Type::String:
       SwitchTo(Type::String);
-      string_value_.swap(value.string_value_);
-      return *this;
+      string_value_ = std::move(value.string_value_);
+      value.SwitchTo(Type::Null);
+      break;
     case Type::Blob:
       SwitchTo(Type::Blob);
-      std::swap(blob_value_, value.blob_value_);
-      return *this;
+      blob_value_ = std::move(value.blob_value_);
+      value.SwitchTo(Type::Null);
+      break;
     case Type::Array:
       SwitchTo(Type::Array);
-      std::swap(array_value_, value.array_value_);
-      return *this;
+      array_value_.swap(value.array_value_);
+      value.SwitchTo(Type::Null);
+      break;
     case Type::Object:
       SwitchTo(Type::Object);
       std::swap(object_value_, value.object_value_);
-      return *this;
+      value.hash_.store(0, std::memory_order_relaxed);
+      break;
     default:
       // We just copy over POD union types.
       return *this = value;
   }
+  hash_.store(hash, std::memory_order_relaxed);
+  return *this;
 }
 
 const FieldValue& FieldValue::NullValue() {
@@ -209,27 +495,38 @@ FieldValue FieldValue::ServerTimestampValue(const Timestamp& local_write_time) {
 }
 
 FieldValue FieldValue::StringValue(const char* value) {
-  std::string copy(value);
-  return StringValue(std::move(copy));
+  FieldValue result;
+  result.SwitchTo(Type::String);
+  result.string_value_ = CompactString(value, strlen(value));
+  return result;
 }
 
 FieldValue FieldValue::StringValue(const std::string& value) {
-  std::string copy(value);
-  return StringValue(std::move(copy));
+  FieldValue result;
+  result.SwitchTo(Type::String);
+  result.string_value_ = CompactString(value.data(), value.size());
+  return result;
 }
 
 FieldValue FieldValue::StringValue(std::string&& value) {
   FieldValue result;
   result.SwitchTo(Type::String);
-  result.string_value_.swap(value);
+  result.string_value_ = CompactString(std::move(value));
+  return result;
+}
+
+FieldValue FieldValue::StringValue(absl::string_view value) {
+  FieldValue result;
+  result.SwitchTo(Type::String);
+  result.string_value_ = CompactString(value.data(), value.size());
   return result;
 }
 
 FieldValue FieldValue::BlobValue(const uint8_t* source, size_t size) {
   FieldValue result;
   result.SwitchTo(Type::Blob);
-  std::vector<uint8_t> copy(source, source + size);
-  std::swap(result.blob_value_, copy);
+  result.blob_value_ =
+      CompactString(reinterpret_cast<const char*>(source), size);
   return result;
 }
 
@@ -248,79 +545,321 @@ FieldValue FieldValue::ArrayValue(const std::vector<FieldValue>& value) {
 FieldValue FieldValue::ArrayValue(std::vector<FieldValue>&& value) {
   FieldValue result;
   result.SwitchTo(Type::Array);
-  std::swap(result.array_value_, value);
+  result.array_value_ =
+      std::make_shared<const std::vector<FieldValue>>(std::move(value));
   return result;
 }
 
-FieldValue FieldValue::ObjectValue(
-    const std::map<const std::string, const FieldValue>& value) {
-  std::map<const std::string, const FieldValue> copy(value);
+FieldValue FieldValue::ObjectValue(const Map& value) {
+  Map copy(value);
   return ObjectValue(std::move(copy));
 }
 
-FieldValue FieldValue::ObjectValue(
-    std::map<const std::string, const FieldValue>&& value) {
+FieldValue FieldValue::ObjectValue(Map&& value) {
   FieldValue result;
   result.SwitchTo(Type::Object);
   std::swap(result.object_value_, value);
   return result;
 }
 
-bool operator<(const FieldValue& lhs, const FieldValue& rhs) {
+FieldValue FieldValue::ObjectValue(
+    const std::map<const std::string, const FieldValue>& value) {
+  // std::map is already sorted by key so the contents can be copied directly.
+  std::vector<Map::value_type> entries(value.begin(), value.end());
+  return ObjectValue(Map::CreateFromSorted(entries.begin(), entries.end()));
+}
+
+bool FieldValue::boolean_value() const {
+  FIREBASE_ASSERT(tag_ == Type::Boolean);
+  return boolean_value_;
+}
+
+int64_t FieldValue::integer_value() const {
+  FIREBASE_ASSERT(tag_ == Type::Long);
+  return integer_value_;
+}
+
+double FieldValue::double_value() const {
+  FIREBASE_ASSERT(tag_ == Type::Double);
+  return double_value_;
+}
+
+const Timestamp& FieldValue::timestamp_value() const {
+  FIREBASE_ASSERT(tag_ == Type::Timestamp);
+  return timestamp_value_;
+}
+
+const ServerTimestamp& FieldValue::server_timestamp_value() const {
+  FIREBASE_ASSERT(tag_ == Type::ServerTimestamp);
+  return server_timestamp_value_;
+}
+
+const GeoPoint& FieldValue::geo_point_value() const {
+  FIREBASE_ASSERT(tag_ == Type::GeoPoint);
+  return geo_point_value_;
+}
+
+absl::string_view FieldValue::string_value() const {
+  FIREBASE_ASSERT(tag_ == Type::String);
+  return string_value_.view();
+}
+
+const uint8_t* FieldValue::blob_data() const {
+  FIREBASE_ASSERT(tag_ == Type::Blob);
+  return reinterpret_cast<const uint8_t*>(blob_value_.data());
+}
+
+size_t FieldValue::blob_size() const {
+  FIREBASE_ASSERT(tag_ == Type::Blob);
+  return blob_value_.size();
+}
+
+const std::vector<FieldValue>& FieldValue::array_value() const {
+  FIREBASE_ASSERT(tag_ == Type::Array);
+  return *array_value_;
+}
+
+const FieldValue::Map& FieldValue::object_value() const {
+  FIREBASE_ASSERT(tag_ == Type::Object);
+  return object_value_;
+}
+
+FieldValue FieldValue::SetField(const std::string& name,
+                                const FieldValue& value) const {
+  return ObjectValue(object_value().insert(name, value));
+}
+
+FieldValue FieldValue::DeleteField(const std::string& name) const {
+  return ObjectValue(object_value().erase(name));
+}
+
+const FieldValue* FieldValue::Get(const FieldPath& field_path) const {
+  FIREBASE_ASSERT(tag_ == Type::Object);
+  const FieldValue* value = this;
+  for (const std::string& segment : field_path) {
+    if (value->tag_ != Type::Object) {
+      return nullptr;
+    }
+    auto found = value->object_value_.find(segment);
+    if (found == value->object_value_.end()) {
+      return nullptr;
+    }
+    value = &found->second;
+  }
+  return value;
+}
+
+FieldValue FieldValue::Set(const FieldPath& field_path,
+                           const FieldValue& value) const {
+  FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(!field_path.empty(),
+                                          !field_path.empty(),
+                                          "Cannot set value with an empty path");
+  return Set(field_path.begin(), field_path.end(), value);
+}
+
+FieldValue FieldValue::Set(PathIterator begin,
+                           PathIterator end,
+                           const FieldValue& value) const {
+  const std::string& child_name = *begin;
+  if (std::next(begin) == end) {
+    return SetField(child_name, value);
+  }
+
+  auto found = object_value().find(child_name);
+  FieldValue new_child;
+  if (found != object_value_.end() && found->second.tag_ == Type::Object) {
+    new_child = found->second.Set(std::next(begin), end, value);
+  } else {
+    // Pretend an empty Object lives wherever the path is missing or runs
+    // through a primitive value.
+    new_child = ObjectValue(Map{}).Set(std::next(begin), end, value);
+  }
+  return SetField(child_name, new_child);
+}
+
+FieldValue FieldValue::Delete(const FieldPath& field_path) const {
+  FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(!field_path.empty(),
+                                          !field_path.empty(),
+                                          "Cannot delete an empty path");
+  return Delete(field_path.begin(), field_path.end());
+}
+
+FieldValue FieldValue::Delete(PathIterator begin, PathIterator end) const {
+  const std::string& child_name = *begin;
+  if (std::next(begin) == end) {
+    return DeleteField(child_name);
+  }
+
+  auto found = object_value().find(child_name);
+  if (found == object_value_.end() || found->second.tag_ != Type::Object) {
+    return *this;
+  }
+  return SetField(child_name, found->second.Delete(std::next(begin), end));
+}
+
+size_t FieldValue::Hash() const {
+  uint32_t hash = hash_.load(std::memory_order_relaxed);
+  if (hash == 0) {
+    // Zero marks the cache as empty, so remap the (unlikely) real zero hash.
+    hash = ComputeHash();
+    if (hash == 0) {
+      hash = 1;
+    }
+    hash_.store(hash, std::memory_order_relaxed);
+  }
+  return hash;
+}
+
+uint32_t FieldValue::ComputeHash() const {
+  // Long and Double values can compare equal, so they share a seed.
+  Type seed = tag_ == Type::Double ? Type::Long : tag_;
+  return Visit(*this, PayloadHasher{static_cast<uint32_t>(seed)});
+}
+
+bool operator==(const FieldValue& lhs, const FieldValue& rhs) {
+  if (&lhs == &rhs) {
+    return true;
+  }
+
+  // Only consult hashes that are already cached: computing them would cost at
+  // least as much as the comparison itself.
+  uint32_t lhs_hash = lhs.hash_.load(std::memory_order_relaxed);
+  uint32_t rhs_hash = rhs.hash_.load(std::memory_order_relaxed);
+  if (lhs_hash != 0 && rhs_hash != 0 && lhs_hash != rhs_hash) {
+    return false;
+  }
+
   if (!Comparable(lhs.type(), rhs.type())) {
-    return lhs.type() < rhs.type();
+    return false;
   }
 
   switch (lhs.type()) {
     case Type::Null:
-      return false;
+      return true;
     case Type::Boolean:
-      return Comparator<bool>()(lhs.boolean_value_, rhs.boolean_value_);
+      return lhs.boolean_value_ == rhs.boolean_value_;
     case Type::Long:
       if (rhs.type() == Type::Long) {
-        return Comparator<int64_t>()(lhs.integer_value_, rhs.integer_value_);
+        return lhs.integer_value_ == rhs.integer_value_;
       } else {
         return util::CompareMixedNumber(rhs.double_value_,
                                         lhs.integer_value_) ==
-               ComparisonResult::Descending;
+               ComparisonResult::Same;
       }
     case Type::Double:
       if (rhs.type() == Type::Double) {
-        return Comparator<double>()(lhs.double_value_, rhs.double_value_);
+        return DoubleEquals(lhs.double_value_, rhs.double_value_);
       } else {
         return util::CompareMixedNumber(lhs.double_value_,
                                         rhs.integer_value_) ==
-               ComparisonResult::Ascending;
+               ComparisonResult::Same;
+      }
+    case Type::Timestamp:
+      return rhs.type() == Type::Timestamp &&
+             lhs.timestamp_value_ == rhs.timestamp_value_;
+    case Type::ServerTimestamp:
+      return rhs.type() == Type::ServerTimestamp &&
+             lhs.server_timestamp_value_.local_write_time ==
+                 rhs.server_timestamp_value_.local_write_time;
+    case Type::String:
+      return lhs.string_value_.SharesBufferWith(rhs.string_value_) ||
+             lhs.string_value_.view() == rhs.string_value_.view();
+    case Type::Blob:
+      return lhs.blob_value_.SharesBufferWith(rhs.blob_value_) ||
+             lhs.blob_value_.view() == rhs.blob_value_.view();
+    case Type::GeoPoint:
+      return lhs.geo_point_value_ == rhs.geo_point_value_;
+    case Type::Array:
+      return lhs.array_value_ == rhs.array_value_ ||
+             *lhs.array_value_ == *rhs.array_value_;
+    case Type::Object:
+      return lhs.object_value_.size() == rhs.object_value_.size() &&
+             std::equal(lhs.object_value_.begin(), lhs.object_value_.end(),
+                        rhs.object_value_.begin());
+    default:
+      FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+          false, lhs.type(), "Unsupported type %d", lhs.type());
+      return true;
+  }
+}
+
+ComparisonResult Compare(const FieldValue& lhs, const FieldValue& rhs) {
+  if (!Comparable(lhs.type(), rhs.type())) {
+    return CompareValues(lhs.type(), rhs.type());
+  }
+
+  switch (lhs.type()) {
+    case Type::Null:
+      return ComparisonResult::Same;
+    case Type::Boolean:
+      return CompareValues(lhs.boolean_value_, rhs.boolean_value_);
+    case Type::Long:
+      if (rhs.type() == Type::Long) {
+        return CompareValues(lhs.integer_value_, rhs.integer_value_);
+      } else {
+        return util::ReverseOrder(
+            util::CompareMixedNumber(rhs.double_value_, lhs.integer_value_));
+      }
+    case Type::Double:
+      if (rhs.type() == Type::Double) {
+        return util::Compare<double>(lhs.double_value_, rhs.double_value_);
+      } else {
+        return util::CompareMixedNumber(lhs.double_value_, rhs.integer_value_);
       }
     case Type::Timestamp:
       if (rhs.type() == Type::Timestamp) {
-        return lhs.timestamp_value_ < rhs.timestamp_value_;
+        return CompareTimestamps(lhs.timestamp_value_, rhs.timestamp_value_);
       } else {
-        return true;
+        return ComparisonResult::Ascending;
       }
     case Type::ServerTimestamp:
       if (rhs.type() == Type::ServerTimestamp) {
-        return lhs.server_timestamp_value_.local_write_time <
-               rhs.server_timestamp_value_.local_write_time;
+        return CompareTimestamps(lhs.server_timestamp_value_.local_write_time,
+                                 rhs.server_timestamp_value_.local_write_time);
       } else {
-        return false;
+        return ComparisonResult::Descending;
       }
     case Type::String:
-      return lhs.string_value_.compare(rhs.string_value_) < 0;
+      if (lhs.string_value_.SharesBufferWith(rhs.string_value_)) {
+        return ComparisonResult::Same;
+      }
+      return CompareBytes(lhs.string_value_.view(), rhs.string_value_.view());
     case Type::Blob:
-      return lhs.blob_value_ < rhs.blob_value_;
+      if (lhs.blob_value_.SharesBufferWith(rhs.blob_value_)) {
+        return ComparisonResult::Same;
+      }
+      return CompareBytes(lhs.blob_value_.view(), rhs.blob_value_.view());
     case Type::GeoPoint:
-      return lhs.geo_point_value_ < rhs.geo_point_value_;
+      return CompareValues(lhs.geo_point_value_, rhs.geo_point_value_);
     case Type::Array:
-      return lhs.array_value_ < rhs.array_value_;
+      if (lhs.array_value_ == rhs.array_value_) {
+        return ComparisonResult::Same;
+      }
+      return CompareRanges(
+          lhs.array_value_->begin(), lhs.array_value_->end(),
+          rhs.array_value_->begin(), rhs.array_value_->end(),
+          [](const FieldValue& left, const FieldValue& right) {
+            return Compare(left, right);
+          });
     case Type::Object:
-      return lhs.object_value_ < rhs.object_value_;
+      return CompareRanges(
+          lhs.object_value_.begin(), lhs.object_value_.end(),
+          rhs.object_value_.begin(), rhs.object_value_.end(),
+          [](const FieldValue::Map::value_type& left,
+             const FieldValue::Map::value_type& right) {
+            ComparisonResult result =
+                CompareValues(left.first.compare(right.first), 0);
+            if (result != ComparisonResult::Same) {
+              return result;
+            }
+            return Compare(left.second, right.second);
+          });
     default:
       FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
           false, lhs.type(), "Unsupported type %d", lhs.type());
-      // return false if assertion does not abort the program. We will say
+      // return Same if assertion does not abort the program. We will say
       // each unsupported type takes only one value thus everything is equal.
-      return false;
+      return ComparisonResult::Same;
   }
 }
 
@@ -328,6 +867,8 @@ void FieldValue::SwitchTo(const Type type) {
   if (tag_ == type) {
     return;
   }
+  // The cached hash belongs to the old value.
+  hash_.store(0, std::memory_order_relaxed);
   // Not same type. Destruct old type first and then initialize new type.
   // Must call destructor explicitly for any non-POD type.
   switch (tag_) {
@@ -338,19 +879,19 @@ void FieldValue::SwitchTo(const Type type) {
       server_timestamp_value_.~ServerTimestamp();
       break;
     case Type::String:
-      string_value_.~basic_string();
+      string_value_.~CompactString();
       break;
     case Type::Blob:
-      blob_value_.~vector();
+      blob_value_.~CompactString();
       break;
     case Type::GeoPoint:
       geo_point_value_.~GeoPoint();
       break;
     case Type::Array:
-      array_value_.~vector();
+      array_value_.~shared_ptr();
       break;
     case Type::Object:
-      object_value_.~map();
+      object_value_.~Map();
       break;
     default: {}  // The other types where there is nothing to worry about.
   }
@@ -364,20 +905,19 @@ void FieldValue::SwitchTo(const Type type) {
       new (&server_timestamp_value_) ServerTimestamp();
       break;
     case Type::String:
-      new (&string_value_) std::string();
+      new (&string_value_) CompactString();
       break;
     case Type::Blob:
-      // Do not even bother to allocate a new array of size 0.
-      new (&blob_value_) std::vector<uint8_t>();
+      new (&blob_value_) CompactString();
       break;
     case Type::GeoPoint:
       new (&geo_point_value_) GeoPoint();
       break;
     case Type::Array:
-      new (&array_value_) std::vector<FieldValue>();
+      new (&array_value_) std::shared_ptr<const std::vector<FieldValue>>();
       break;
     case Type::Object:
-      new (&object_value_) std::map<const std::string, const FieldValue>();
+      new (&object_value_) Map();
       break;
     default: {}  // The other types where there is nothing to worry about.
   }
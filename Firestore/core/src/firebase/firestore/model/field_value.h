@@ -19,13 +19,20 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "Firestore/core/include/firebase/firestore/geo_point.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+#include "absl/strings/string_view.h"
 
 namespace firebase {
 namespace firestore {
@@ -69,7 +76,32 @@ class FieldValue {
     // position instead, see the doc comment above.
   };
 
-  FieldValue() : tag_(Type::Null) {
+  /**
+   * The representation of an Object value: an immutable map from field name to
+   * value, sorted by field name. Copying the map is O(1) and modifying it
+   * shares all unmodified entries (or tree nodes) with the original.
+   */
+  using Map = immutable::SortedMap<std::string, FieldValue>;
+
+  /**
+   * Identifies the type of a payload passed to a Visit() visitor, so that
+   * visitors can overload on it and tell apart types with the same payload
+   * (e.g. String and Blob).
+   */
+  template <Type type>
+  using TypeTag = std::integral_constant<Type, type>;
+
+  /**
+   * Returns true if values of the given type have trivially copyable payloads,
+   * which need no construction or destruction and can be copied bytewise.
+   */
+  static constexpr bool IsTriviallyCopyable(Type type) {
+    return type == Type::Null || type == Type::Boolean || type == Type::Long ||
+           type == Type::Double || type == Type::Timestamp ||
+           type == Type::ServerTimestamp || type == Type::GeoPoint;
+  }
+
+  FieldValue() : tag_(Type::Null), hash_(0) {
   }
 
   // Do not inline these ctor/dtor below, which contain call to non-trivial
@@ -87,6 +119,75 @@ class FieldValue {
     return tag_;
   }
 
+  /**
+   * Accessors for the payloads of the scalar types. Each must only be called
+   * on a value of the corresponding type.
+   */
+  bool boolean_value() const;
+  int64_t integer_value() const;
+  double double_value() const;
+  const Timestamp& timestamp_value() const;
+  const ServerTimestamp& server_timestamp_value() const;
+  const GeoPoint& geo_point_value() const;
+
+  /**
+   * Accessors for the payloads of the String, Blob and Array types. Each must
+   * only be called on a value of the corresponding type. Short strings and
+   * blobs are stored inline, so the returned views are only valid for as long
+   * as this FieldValue is alive and unmodified.
+   */
+  absl::string_view string_value() const;
+  const uint8_t* blob_data() const;
+  size_t blob_size() const;
+  const std::vector<FieldValue>& array_value() const;
+
+  /** Returns the fields of an Object value. Must only be called on Objects. */
+  const Map& object_value() const;
+
+  /**
+   * Returns a new Object value identical to this one but with the given
+   * top-level field set to the given value. Only the modified entry is copied;
+   * all other fields are shared with this value. Must only be called on
+   * Objects.
+   */
+  FieldValue SetField(const std::string& name, const FieldValue& value) const;
+
+  /**
+   * Returns a new Object value identical to this one but without the given
+   * top-level field. Must only be called on Objects.
+   */
+  FieldValue DeleteField(const std::string& name) const;
+
+  /**
+   * Returns the value at the given path within this Object, or nullptr if
+   * there is none (including when the path runs through a non-Object value).
+   * An empty path returns this value. Must only be called on Objects.
+   */
+  const FieldValue* Get(const FieldPath& field_path) const;
+
+  /**
+   * Returns a new Object value identical to this one but with the given value
+   * set at the given (non-empty) path. Missing or non-Object intermediate
+   * values are replaced with Objects. Only the Objects along the path are
+   * copied. Must only be called on Objects.
+   */
+  FieldValue Set(const FieldPath& field_path, const FieldValue& value) const;
+
+  /**
+   * Returns a new Object value identical to this one but without the value at
+   * the given (non-empty) path. If the path runs through a missing or
+   * non-Object value, the result is unchanged. Must only be called on Objects.
+   */
+  FieldValue Delete(const FieldPath& field_path) const;
+
+  /**
+   * Returns a hash of this value, consistent with operator==: values that
+   * compare equal (including e.g. 1 and 1.0) produce the same hash. The hash
+   * is computed on first use and cached, so hashing a value repeatedly (or
+   * any of its copies made afterwards) is O(1).
+   */
+  size_t Hash() const;
+
   /** factory methods. */
   static const FieldValue& NullValue();
   static const FieldValue& TrueValue();
@@ -102,28 +203,104 @@ class FieldValue {
   static FieldValue StringValue(const char* value);
   static FieldValue StringValue(const std::string& value);
   static FieldValue StringValue(std::string&& value);
+  static FieldValue StringValue(absl::string_view value);
   static FieldValue BlobValue(const uint8_t* source, size_t size);
   // static FieldValue ReferenceValue();
   static FieldValue GeoPointValue(const GeoPoint& value);
   static FieldValue ArrayValue(const std::vector<FieldValue>& value);
   static FieldValue ArrayValue(std::vector<FieldValue>&& value);
+  static FieldValue ObjectValue(const Map& value);
+  static FieldValue ObjectValue(Map&& value);
   static FieldValue ObjectValue(
       const std::map<const std::string, const FieldValue>& value);
-  static FieldValue ObjectValue(
-      std::map<const std::string, const FieldValue>&& value);
 
-  friend bool operator<(const FieldValue& lhs, const FieldValue& rhs);
+  friend util::ComparisonResult Compare(const FieldValue& lhs,
+                                        const FieldValue& rhs);
+  friend bool operator==(const FieldValue& lhs, const FieldValue& rhs);
 
  private:
-  explicit FieldValue(bool value) : tag_(Type::Boolean), boolean_value_(value) {
+  explicit FieldValue(bool value)
+      : tag_(Type::Boolean), hash_(0), boolean_value_(value) {
   }
 
+  /**
+   * Storage for the contents of String and Blob values. Contents of up to
+   * kInlineCapacity bytes are stored inline, without a heap allocation;
+   * longer contents live in an immutable heap buffer shared between copies.
+   */
+  class CompactString {
+   public:
+    static constexpr size_t kInlineCapacity = 23;
+
+    CompactString() : inline_size_(0) {
+    }
+
+    CompactString(const char* data, size_t size);
+    explicit CompactString(std::string&& value);
+
+    CompactString(const CompactString& other);
+    CompactString(CompactString&& other);
+    ~CompactString();
+
+    CompactString& operator=(const CompactString& other);
+    CompactString& operator=(CompactString&& other);
+
+    const char* data() const {
+      return is_inline() ? inline_ : heap_->data();
+    }
+
+    size_t size() const {
+      return is_inline() ? inline_size_ : heap_->size();
+    }
+
+    absl::string_view view() const {
+      return absl::string_view{data(), size()};
+    }
+
+    /** Returns true if this and other share the same heap buffer. */
+    bool SharesBufferWith(const CompactString& other) const {
+      return !is_inline() && !other.is_inline() && heap_ == other.heap_;
+    }
+
+   private:
+    // The value of inline_size_ when the contents are on the heap.
+    static constexpr uint8_t kHeap = 0xFF;
+
+    bool is_inline() const {
+      return inline_size_ != kHeap;
+    }
+
+    void Reset();
+
+    union {
+      char inline_[kInlineCapacity];
+      std::shared_ptr<const std::string> heap_;
+    };
+    uint8_t inline_size_;
+  };
+
+  using PathIterator = FieldPath::const_iterator;
+
+  FieldValue Set(PathIterator begin,
+                 PathIterator end,
+                 const FieldValue& value) const;
+  FieldValue Delete(PathIterator begin, PathIterator end) const;
+
+  /** Computes the hash of this value, without consulting the cache. */
+  uint32_t ComputeHash() const;
+
   /**
    * Switch to the specified type, if different from the current type.
    */
   void SwitchTo(const Type type);
 
   Type tag_;
+
+  // The cached result of Hash(), or zero if it hasn't been computed yet. Const
+  // values can be hashed concurrently from several threads, hence the atomic.
+  // It's 32 bits so that it fits in the padding after tag_.
+  mutable std::atomic<uint32_t> hash_;
+
   union {
     // There is no null type as tag_ alone is enough for Null FieldValue.
     bool boolean_value_;
@@ -131,16 +308,84 @@ class FieldValue {
     double double_value_;
     Timestamp timestamp_value_;
     ServerTimestamp server_timestamp_value_;
-    std::string string_value_;
-    std::vector<uint8_t> blob_value_;
+    // Heap-backed payloads are immutable and shared between copies.
+    CompactString string_value_;
+    CompactString blob_value_;
     GeoPoint geo_point_value_;
-    std::vector<FieldValue> array_value_;
-    std::map<const std::string, const FieldValue> object_value_;
+    std::shared_ptr<const std::vector<FieldValue>> array_value_;
+    Map object_value_;
   };
 };
 
+/**
+ * Calls the visitor with the type and payload of the given value and returns
+ * its result. The visitor is called as visitor(FieldValue::TypeTag<type>{},
+ * payload) and must handle every type; the payloads are:
+ *
+ *   * Null: nullptr
+ *   * Boolean, Long, Double: bool, int64_t, double
+ *   * Timestamp, ServerTimestamp, GeoPoint: a const reference to it
+ *   * String, Blob: an absl::string_view of the contents
+ *   * Array, Object: a const reference to the vector or FieldValue::Map
+ *
+ * All overloads must return the same type.
+ */
+template <typename F>
+auto Visit(const FieldValue& value, F&& visitor)
+    -> decltype(visitor(FieldValue::TypeTag<FieldValue::Type::Null>{},
+                        nullptr)) {
+  using Type = FieldValue::Type;
+  switch (value.type()) {
+    case Type::Null:
+      break;
+    case Type::Boolean:
+      return visitor(FieldValue::TypeTag<Type::Boolean>{},
+                     value.boolean_value());
+    case Type::Long:
+      return visitor(FieldValue::TypeTag<Type::Long>{}, value.integer_value());
+    case Type::Double:
+      return visitor(FieldValue::TypeTag<Type::Double>{},
+                     value.double_value());
+    case Type::Timestamp:
+      return visitor(FieldValue::TypeTag<Type::Timestamp>{},
+                     value.timestamp_value());
+    case Type::ServerTimestamp:
+      return visitor(FieldValue::TypeTag<Type::ServerTimestamp>{},
+                     value.server_timestamp_value());
+    case Type::String:
+      return visitor(FieldValue::TypeTag<Type::String>{},
+                     value.string_value());
+    case Type::Blob:
+      return visitor(
+          FieldValue::TypeTag<Type::Blob>{},
+          absl::string_view{reinterpret_cast<const char*>(value.blob_data()),
+                            value.blob_size()});
+    case Type::GeoPoint:
+      return visitor(FieldValue::TypeTag<Type::GeoPoint>{},
+                     value.geo_point_value());
+    case Type::Array:
+      return visitor(FieldValue::TypeTag<Type::Array>{}, value.array_value());
+    case Type::Object:
+      return visitor(FieldValue::TypeTag<Type::Object>{},
+                     value.object_value());
+    default:
+      FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+          false, value.type(), "Unsupported type %d", value.type());
+  }
+  return visitor(FieldValue::TypeTag<Type::Null>{}, nullptr);
+}
+
+/**
+ * Performs a three-way comparison of two FieldValues, in the order defined by
+ * the Firestore backend. Arrays and objects are compared element by element in
+ * a single pass, so nested values are visited at most once.
+ */
+util::ComparisonResult Compare(const FieldValue& lhs, const FieldValue& rhs);
+
 /** Compares against another FieldValue. */
-bool operator<(const FieldValue& lhs, const FieldValue& rhs);
+inline bool operator<(const FieldValue& lhs, const FieldValue& rhs) {
+  return Compare(lhs, rhs) == util::ComparisonResult::Ascending;
+}
 
 inline bool operator>(const FieldValue& lhs, const FieldValue& rhs) {
   return rhs < lhs;
@@ -154,12 +399,16 @@ inline bool operator<=(const FieldValue& lhs, const FieldValue& rhs) {
   return !(lhs > rhs);
 }
 
-inline bool operator!=(const FieldValue& lhs, const FieldValue& rhs) {
-  return lhs < rhs || lhs > rhs;
-}
+/**
+ * Tests two FieldValues for equality in a single pass, consistent with
+ * operator<: two values are equal iff neither is less than the other. Shared
+ * payloads are compared by identity, and values whose cached hashes differ are
+ * unequal without examining their contents.
+ */
+bool operator==(const FieldValue& lhs, const FieldValue& rhs);
 
-inline bool operator==(const FieldValue& lhs, const FieldValue& rhs) {
-  return !(lhs != rhs);
+inline bool operator!=(const FieldValue& lhs, const FieldValue& rhs) {
+  return !(lhs == rhs);
 }
 
 }  // namespace model
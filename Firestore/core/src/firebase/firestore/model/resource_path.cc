@@ -0,0 +1,73 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+ResourcePath ResourcePath::FromString(const absl::string_view path) {
+  // NOTE: The client is ignorant of any path segments containing escape
+  // sequences (e.g. __id123__) and just passes them through raw (they exist
+  // for legacy reasons and should not be used frequently).
+
+  FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+      path.find("//") == absl::string_view::npos,
+      path.find("//") == absl::string_view::npos,
+      "Invalid path (%s). Paths must not contain // in them.",
+      std::string{path}.c_str());
+
+  // We may still have an empty segment at the beginning or end if they had a
+  // leading or trailing slash (which we allow).
+  SegmentsType segments;
+  size_t start = 0;
+  while (start <= path.size()) {
+    size_t slash = path.find('/', start);
+    if (slash == absl::string_view::npos) {
+      slash = path.size();
+    }
+    if (slash > start) {
+      segments.emplace_back(path.substr(start, slash - start));
+    }
+    start = slash + 1;
+  }
+
+  return ResourcePath{std::move(segments)};
+}
+
+std::string ResourcePath::CanonicalString() const {
+  // NOTE: The client is ignorant of any path segments containing escape
+  // sequences (e.g. __id123__) and just passes them through raw (they exist
+  // for legacy reasons and should not be used frequently).
+
+  std::string result;
+  for (auto iter = begin(); iter != end(); ++iter) {
+    if (iter != begin()) {
+      result += '/';
+    }
+    result += *iter;
+  }
+  return result;
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
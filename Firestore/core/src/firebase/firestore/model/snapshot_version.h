@@ -0,0 +1,89 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_SNAPSHOT_VERSION_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_SNAPSHOT_VERSION_H_
+
+#include "Firestore/core/src/firebase/firestore/model/timestamp.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+/**
+ * A version of a document in Firestore. This corresponds to the version
+ * timestamp, such as update_time or read_time.
+ *
+ * SnapshotVersion is a plain value: copying or comparing one never allocates.
+ */
+class SnapshotVersion {
+ public:
+  /** Creates a version that is smaller than all other versions. */
+  constexpr SnapshotVersion() : timestamp_() {
+  }
+
+  explicit constexpr SnapshotVersion(const Timestamp& timestamp)
+      : timestamp_(timestamp) {
+  }
+
+  /** Returns a version that is smaller than all other versions. */
+  static constexpr SnapshotVersion None() {
+    return SnapshotVersion{};
+  }
+
+  constexpr const Timestamp& timestamp() const {
+    return timestamp_;
+  }
+
+ private:
+  Timestamp timestamp_;
+};
+
+constexpr bool operator<(const SnapshotVersion& lhs,
+                         const SnapshotVersion& rhs) {
+  return lhs.timestamp() < rhs.timestamp();
+}
+
+constexpr bool operator>(const SnapshotVersion& lhs,
+                         const SnapshotVersion& rhs) {
+  return rhs < lhs;
+}
+
+constexpr bool operator>=(const SnapshotVersion& lhs,
+                          const SnapshotVersion& rhs) {
+  return !(lhs < rhs);
+}
+
+constexpr bool operator<=(const SnapshotVersion& lhs,
+                          const SnapshotVersion& rhs) {
+  return !(lhs > rhs);
+}
+
+constexpr bool operator!=(const SnapshotVersion& lhs,
+                          const SnapshotVersion& rhs) {
+  return lhs < rhs || lhs > rhs;
+}
+
+constexpr bool operator==(const SnapshotVersion& lhs,
+                          const SnapshotVersion& rhs) {
+  return !(lhs != rhs);
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_SNAPSHOT_VERSION_H_
@@ -42,9 +42,6 @@ Timestamp::Timestamp(int64_t seconds, int32_t nanos)
       "timestamp seconds out of range: %lld", seconds);
 }
 
-Timestamp::Timestamp() : seconds_(0), nanos_(0) {
-}
-
 Timestamp Timestamp::Now() {
   return Timestamp(time(nullptr), 0);
 }
@@ -35,7 +35,8 @@ class Timestamp {
    * PORTING NOTE: This does NOT set to current timestamp by default. To get the
    * current timestamp, call Timestamp::Now().
    */
-  Timestamp();
+  constexpr Timestamp() : seconds_(0), nanos_(0) {
+  }
 
   /**
    * Creates a new timestamp.
@@ -48,11 +49,11 @@ class Timestamp {
   /** Returns a timestamp with the current date / time. */
   static Timestamp Now();
 
-  int64_t seconds() const {
+  constexpr int64_t seconds() const {
     return seconds_;
   }
 
-  int32_t nanos() const {
+  constexpr int32_t nanos() const {
     return nanos_;
   }
 
@@ -62,28 +63,28 @@ class Timestamp {
 };
 
 /** Compares against another Timestamp. */
-inline bool operator<(const Timestamp& lhs, const Timestamp& rhs) {
+constexpr bool operator<(const Timestamp& lhs, const Timestamp& rhs) {
   return lhs.seconds() < rhs.seconds() ||
          (lhs.seconds() == rhs.seconds() && lhs.nanos() < rhs.nanos());
 }
 
-inline bool operator>(const Timestamp& lhs, const Timestamp& rhs) {
+constexpr bool operator>(const Timestamp& lhs, const Timestamp& rhs) {
   return rhs < lhs;
 }
 
-inline bool operator>=(const Timestamp& lhs, const Timestamp& rhs) {
+constexpr bool operator>=(const Timestamp& lhs, const Timestamp& rhs) {
   return !(lhs < rhs);
 }
 
-inline bool operator<=(const Timestamp& lhs, const Timestamp& rhs) {
+constexpr bool operator<=(const Timestamp& lhs, const Timestamp& rhs) {
   return !(lhs > rhs);
 }
 
-inline bool operator!=(const Timestamp& lhs, const Timestamp& rhs) {
+constexpr bool operator!=(const Timestamp& lhs, const Timestamp& rhs) {
   return lhs < rhs || lhs > rhs;
 }
 
-inline bool operator==(const Timestamp& lhs, const Timestamp& rhs) {
+constexpr bool operator==(const Timestamp& lhs, const Timestamp& rhs) {
   return !(lhs != rhs);
 }
 
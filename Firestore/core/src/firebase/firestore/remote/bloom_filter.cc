@@ -0,0 +1,124 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/md5.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+/** The largest bitmap whose bit count fits in an int32_t. */
+const size_t kMaxBitmapSize =
+    static_cast<size_t>(std::numeric_limits<int32_t>::max() / 8);
+
+/**
+ * Computes the two 64-bit hashes the backend derives from a key: the first and
+ * second halves of its MD5 digest, each read as a little-endian integer.
+ */
+std::pair<uint64_t, uint64_t> HashKey(absl::string_view key) {
+  std::array<uint8_t, 16> digest = util::CalcMd5(key);
+  uint64_t hash1 = 0;
+  uint64_t hash2 = 0;
+  for (int i = 7; i >= 0; i--) {
+    hash1 = (hash1 << 8) | digest[i];
+    hash2 = (hash2 << 8) | digest[i + 8];
+  }
+  return {hash1, hash2};
+}
+
+}  // namespace
+
+BloomFilter::BloomFilter(std::vector<uint8_t> bitmap,
+                         int32_t padding,
+                         int32_t hash_count)
+    : bitmap_(std::move(bitmap)), padding_(padding), hash_count_(hash_count) {
+  FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+      IsValid(bitmap_.size(), padding, hash_count),
+      IsValid(bitmap_.size(), padding, hash_count),
+      "Invalid Bloom filter: %zu bytes, padding %d, hash count %d",
+      bitmap_.size(), padding, hash_count);
+  bit_count_ = static_cast<int32_t>(bitmap_.size() * 8) - padding;
+}
+
+bool BloomFilter::IsValid(size_t bitmap_size,
+                          int32_t padding,
+                          int32_t hash_count) {
+  if (bitmap_size == 0) {
+    return padding == 0 && hash_count >= 0;
+  }
+  return bitmap_size <= kMaxBitmapSize && padding >= 0 && padding < 8 &&
+         hash_count > 0;
+}
+
+BloomFilter BloomFilter::WithExpectedCount(int32_t expected_count) {
+  // For a false positive rate p, the optimal filter has n * -ln(p) / ln(2)^2
+  // bits and sets (bits / n) * ln(2) of them per key; for p = 1% that's about
+  // 9.6 bits and 7 hashes per key.
+  int32_t bit_count = std::max(expected_count, 1) * 10;
+  int32_t byte_count = (bit_count + 7) / 8;
+  return BloomFilter(std::vector<uint8_t>(byte_count),
+                     byte_count * 8 - bit_count, 7);
+}
+
+void BloomFilter::Insert(absl::string_view key) {
+  if (bit_count_ == 0) {
+    return;
+  }
+  std::pair<uint64_t, uint64_t> hashes = HashKey(key);
+  for (int32_t i = 0; i < hash_count_; i++) {
+    int32_t index = BitIndex(hashes.first, hashes.second, i);
+    bitmap_[index / 8] |= static_cast<uint8_t>(1 << (index % 8));
+  }
+}
+
+bool BloomFilter::MightContain(absl::string_view key) const {
+  // An empty filter holds nothing.
+  if (bit_count_ == 0) {
+    return false;
+  }
+  std::pair<uint64_t, uint64_t> hashes = HashKey(key);
+  for (int32_t i = 0; i < hash_count_; i++) {
+    if (!IsBitSet(BitIndex(hashes.first, hashes.second, i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int32_t BloomFilter::BitIndex(uint64_t hash1,
+                              uint64_t hash2,
+                              int32_t i) const {
+  uint64_t combined = hash1 + static_cast<uint64_t>(i) * hash2;
+  return static_cast<int32_t>(combined % static_cast<uint64_t>(bit_count_));
+}
+
+bool BloomFilter::IsBitSet(int32_t index) const {
+  return (bitmap_[index / 8] & (1 << (index % 8))) != 0;
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BLOOM_FILTER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BLOOM_FILTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * A Bloom filter over document keys, as carried by an existence filter. A key
+ * that was inserted is always reported as possibly present; a key that wasn't
+ * is reported as absent except for the occasional false positive.
+ *
+ * The filter's bits are packed least significant bit first: bit i is bit
+ * (i % 8) of byte (i / 8) of the bitmap. The last `padding` bits of the final
+ * byte are unused. Each key sets `hash_count` bits, chosen by double hashing
+ * of the key's MD5 digest, the same way the backend builds the filter. Keys
+ * are full document resource names, e.g.
+ * "projects/p/databases/d/documents/rooms/abc".
+ */
+class BloomFilter {
+ public:
+  /**
+   * Creates a filter over the given bitmap. The parameters must satisfy
+   * IsValid().
+   *
+   * @param bitmap The packed bits of the filter.
+   * @param padding The number of unused bits in the final byte, in [0, 8).
+   *     Must be 0 if the bitmap is empty.
+   * @param hash_count The number of bits each key sets. Must be positive
+   *     unless the bitmap is empty.
+   */
+  BloomFilter(std::vector<uint8_t> bitmap, int32_t padding, int32_t hash_count);
+
+  /**
+   * Returns whether the given filter parameters describe a usable filter.
+   * These come from the backend, so check them before constructing a filter.
+   */
+  static bool IsValid(size_t bitmap_size, int32_t padding, int32_t hash_count);
+
+  /**
+   * Creates an empty filter sized for the given number of keys with about a
+   * 1% false positive rate.
+   */
+  static BloomFilter WithExpectedCount(int32_t expected_count);
+
+  /** Adds a key to the filter. */
+  void Insert(absl::string_view key);
+
+  /**
+   * Returns false if the key was definitely never inserted, true if it might
+   * have been.
+   */
+  bool MightContain(absl::string_view key) const;
+
+  /** The number of usable bits in the filter. */
+  int32_t bit_count() const {
+    return bit_count_;
+  }
+
+  int32_t padding() const {
+    return padding_;
+  }
+
+  int32_t hash_count() const {
+    return hash_count_;
+  }
+
+  const std::vector<uint8_t>& bitmap() const {
+    return bitmap_;
+  }
+
+ private:
+  /** Returns the index of the `i`th bit for the key with the given hashes. */
+  int32_t BitIndex(uint64_t hash1, uint64_t hash2, int32_t i) const;
+
+  bool IsBitSet(int32_t index) const;
+
+  std::vector<uint8_t> bitmap_;
+  int32_t padding_;
+  int32_t hash_count_;
+  int32_t bit_count_;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BLOOM_FILTER_H_
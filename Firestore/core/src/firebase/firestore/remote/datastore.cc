@@ -16,14 +16,82 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/datastore.h"
 
+#include <grpc/support/time.h>
+
+#include <algorithm>
+#include <utility>
+
 namespace firebase {
 namespace firestore {
 namespace remote {
 
-Datastore::Datastore() {
+namespace {
+
+const char* const kListenPath = "/google.firestore.v1beta1.Firestore/Listen";
+const char* const kWritePath = "/google.firestore.v1beta1.Firestore/Write";
+const char* const kCommitPath = "/google.firestore.v1beta1.Firestore/Commit";
+
+}  // namespace
+
+Datastore::Datastore(grpc_channel* channel, Executor executor)
+    : channel_(channel), executor_(std::move(executor)) {
 }
 
 Datastore::~Datastore() {
+  {
+    std::lock_guard<std::mutex> lock(calls_mutex_);
+    for (const std::weak_ptr<GrpcCall>& weak_call : calls_) {
+      if (std::shared_ptr<GrpcCall> call = weak_call.lock()) {
+        call->Cancel();
+      }
+    }
+    calls_.clear();
+  }
+
+  queue_.Shutdown();
+  grpc_channel_destroy(channel_);
+}
+
+std::shared_ptr<GrpcStream> Datastore::CreateWatchStream(
+    const GrpcMetadata& metadata, GrpcStreamObserver* observer) {
+  auto stream = std::make_shared<GrpcStream>(CreateCall(kListenPath), &queue_,
+                                             metadata, executor_, observer);
+  Register(stream);
+  return stream;
+}
+
+std::shared_ptr<GrpcStream> Datastore::CreateWriteStream(
+    const GrpcMetadata& metadata, GrpcStreamObserver* observer) {
+  auto stream = std::make_shared<GrpcStream>(CreateCall(kWritePath), &queue_,
+                                             metadata, executor_, observer);
+  Register(stream);
+  return stream;
+}
+
+void Datastore::Commit(const std::string& request,
+                       const GrpcMetadata& metadata,
+                       GrpcUnaryCall::Callback callback) {
+  auto call = std::make_shared<GrpcUnaryCall>(CreateCall(kCommitPath),
+                                              &queue_, metadata, executor_);
+  Register(call);
+  call->Start(request, std::move(callback));
+}
+
+grpc_call* Datastore::CreateCall(const char* path) {
+  return grpc_channel_create_call(
+      channel_, nullptr, GRPC_PROPAGATE_DEFAULTS, queue_.queue(),
+      grpc_slice_from_static_string(path), nullptr,
+      gpr_inf_future(GPR_CLOCK_REALTIME), nullptr);
+}
+
+void Datastore::Register(const std::shared_ptr<GrpcCall>& call) {
+  std::lock_guard<std::mutex> lock(calls_mutex_);
+  calls_.erase(std::remove_if(calls_.begin(), calls_.end(),
+                              [](const std::weak_ptr<GrpcCall>& weak_call) {
+                                return weak_call.expired();
+                              }),
+               calls_.end());
+  calls_.push_back(call);
 }
 
 }  // namespace remote
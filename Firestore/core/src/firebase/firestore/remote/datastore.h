@@ -17,13 +17,46 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_DATASTORE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_DATASTORE_H_
 
+#include <grpc/grpc.h>
+
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_call.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion_queue.h"
+
 namespace firebase {
 namespace firestore {
 namespace remote {
 
+/**
+ * Datastore represents the Firestore backend's RPCs. Requests and responses
+ * are the serialized bytes of the google.firestore.v1beta1 protos; the wire
+ * decoder reads the responses.
+ *
+ * All RPCs run on a single gRPC completion queue polled by a thread owned by
+ * the Datastore. Completions are handed directly from that thread to the
+ * executor, so each event takes one hop to reach the caller's queue.
+ */
 class Datastore {
  public:
-  Datastore();
+  /**
+   * Creates a Datastore sending RPCs on the given channel. gRPC must have
+   * been initialized with grpc_init() and stay so until the Datastore is
+   * destroyed.
+   *
+   * @param channel A channel to the backend, set up with the credentials the
+   *     platform requires. The Datastore takes ownership of it.
+   * @param executor The executor to run the callbacks of all RPCs on.
+   */
+  Datastore(grpc_channel* channel, Executor executor);
+
+  /**
+   * Cancels any RPCs still running and waits for the polling thread to exit.
+   * Streams and calls returned by this Datastore must not be used afterwards.
+   */
   ~Datastore();
 
   Datastore(const Datastore& other) = delete;
@@ -31,6 +64,30 @@ class Datastore {
 
   Datastore& operator=(const Datastore& other) = delete;
   Datastore& operator=(Datastore&& other) = delete;
+
+  /** Creates a stream for the Listen RPC. Call Start() on it to begin. */
+  std::shared_ptr<GrpcStream> CreateWatchStream(const GrpcMetadata& metadata,
+                                                GrpcStreamObserver* observer);
+
+  /** Creates a stream for the Write RPC. Call Start() on it to begin. */
+  std::shared_ptr<GrpcStream> CreateWriteStream(const GrpcMetadata& metadata,
+                                                GrpcStreamObserver* observer);
+
+  /** Sends the given CommitRequest, running the callback once it finishes. */
+  void Commit(const std::string& request,
+              const GrpcMetadata& metadata,
+              GrpcUnaryCall::Callback callback);
+
+ private:
+  grpc_call* CreateCall(const char* path);
+  void Register(const std::shared_ptr<GrpcCall>& call);
+
+  grpc_channel* channel_;
+  Executor executor_;
+  GrpcCompletionQueue queue_;
+
+  std::mutex calls_mutex_;
+  std::vector<std::weak_ptr<GrpcCall>> calls_;
 };
 
 }  // namespace remote
@@ -0,0 +1,280 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_call.h"
+
+#include <grpc/byte_buffer.h>
+#include <grpc/byte_buffer_reader.h>
+#include <grpc/slice.h>
+
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+GrpcCall::GrpcCall(grpc_call* call,
+                   GrpcCompletionQueue* queue,
+                   const GrpcMetadata& metadata,
+                   Executor executor)
+    : call_(call),
+      queue_(queue),
+      executor_(std::move(executor)),
+      status_details_(grpc_empty_slice()) {
+  for (const auto& entry : metadata) {
+    grpc_metadata element{};
+    element.key = grpc_slice_from_copied_string(entry.first.c_str());
+    element.value = grpc_slice_from_copied_buffer(entry.second.data(),
+                                                  entry.second.size());
+    metadata_.push_back(element);
+  }
+  grpc_metadata_array_init(&initial_metadata_);
+  grpc_metadata_array_init(&trailing_metadata_);
+}
+
+GrpcCall::~GrpcCall() {
+  grpc_call_unref(call_);
+  for (grpc_metadata& element : metadata_) {
+    grpc_slice_unref(element.key);
+    grpc_slice_unref(element.value);
+  }
+  grpc_metadata_array_destroy(&initial_metadata_);
+  grpc_metadata_array_destroy(&trailing_metadata_);
+  grpc_slice_unref(status_details_);
+}
+
+void GrpcCall::Cancel() {
+  grpc_call_cancel(call_, nullptr);
+}
+
+void GrpcCall::StartBatch(const grpc_op* ops,
+                          size_t count,
+                          std::function<void(bool ok)> on_complete) {
+  void* tag = queue_->NewTag(std::move(on_complete));
+  grpc_call_error error =
+      grpc_call_start_batch(call_, ops, count, tag, nullptr);
+  FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+      error == GRPC_CALL_OK, error == GRPC_CALL_OK,
+      "Failed to start a batch of gRPC operations (error %d)", error);
+}
+
+grpc_op GrpcCall::SendInitialMetadataOp() {
+  grpc_op op{};
+  op.op = GRPC_OP_SEND_INITIAL_METADATA;
+  op.data.send_initial_metadata.count = metadata_.size();
+  op.data.send_initial_metadata.metadata = metadata_.data();
+  return op;
+}
+
+grpc_op GrpcCall::ReceiveInitialMetadataOp() {
+  grpc_op op{};
+  op.op = GRPC_OP_RECV_INITIAL_METADATA;
+  op.data.recv_initial_metadata.recv_initial_metadata = &initial_metadata_;
+  return op;
+}
+
+grpc_op GrpcCall::ReceiveStatusOp() {
+  grpc_op op{};
+  op.op = GRPC_OP_RECV_STATUS_ON_CLIENT;
+  op.data.recv_status_on_client.trailing_metadata = &trailing_metadata_;
+  op.data.recv_status_on_client.status = &status_;
+  op.data.recv_status_on_client.status_details = &status_details_;
+  return op;
+}
+
+std::string GrpcCall::TakeBytes(grpc_byte_buffer* buffer) {
+  grpc_byte_buffer_reader reader;
+  grpc_byte_buffer_reader_init(&reader, buffer);
+  grpc_slice slice = grpc_byte_buffer_reader_readall(&reader);
+  std::string bytes{reinterpret_cast<const char*>(GRPC_SLICE_START_PTR(slice)),
+                    GRPC_SLICE_LENGTH(slice)};
+  grpc_slice_unref(slice);
+  grpc_byte_buffer_reader_destroy(&reader);
+  grpc_byte_buffer_destroy(buffer);
+  return bytes;
+}
+
+grpc_byte_buffer* GrpcCall::MakeByteBuffer(const std::string& bytes) {
+  grpc_slice slice = grpc_slice_from_copied_buffer(bytes.data(), bytes.size());
+  grpc_byte_buffer* buffer = grpc_raw_byte_buffer_create(&slice, 1);
+  grpc_slice_unref(slice);
+  return buffer;
+}
+
+std::string GrpcCall::status_details() const {
+  return std::string{
+      reinterpret_cast<const char*>(GRPC_SLICE_START_PTR(status_details_)),
+      GRPC_SLICE_LENGTH(status_details_)};
+}
+
+void GrpcUnaryCall::Start(const std::string& request, Callback callback) {
+  grpc_byte_buffer* request_buffer = MakeByteBuffer(request);
+
+  grpc_op ops[6];
+  ops[0] = SendInitialMetadataOp();
+  ops[1] = grpc_op{};
+  ops[1].op = GRPC_OP_SEND_MESSAGE;
+  ops[1].data.send_message.send_message = request_buffer;
+  ops[2] = grpc_op{};
+  ops[2].op = GRPC_OP_SEND_CLOSE_FROM_CLIENT;
+  ops[3] = ReceiveInitialMetadataOp();
+  ops[4] = grpc_op{};
+  ops[4].op = GRPC_OP_RECV_MESSAGE;
+  ops[4].data.recv_message.recv_message = &response_;
+  ops[5] = ReceiveStatusOp();
+
+  std::shared_ptr<GrpcUnaryCall> self = shared_from_this();
+  StartBatch(ops, 6, [self, request_buffer, callback](bool) {
+    grpc_byte_buffer_destroy(request_buffer);
+
+    std::string response;
+    if (self->response_) {
+      response = TakeBytes(self->response_);
+      self->response_ = nullptr;
+    }
+    grpc_status_code status = self->status();
+    std::string error_message = self->status_details();
+    self->Execute([callback, status, error_message, response] {
+      callback(status, error_message, response);
+    });
+  });
+}
+
+GrpcStream::GrpcStream(grpc_call* call,
+                       GrpcCompletionQueue* queue,
+                       const GrpcMetadata& metadata,
+                       Executor executor,
+                       GrpcStreamObserver* observer)
+    : GrpcCall(call, queue, metadata, std::move(executor)),
+      observer_(observer) {
+}
+
+void GrpcStream::Start() {
+  std::shared_ptr<GrpcStream> self = shared_from_this();
+
+  grpc_op send_ops[1] = {SendInitialMetadataOp()};
+  StartBatch(send_ops, 1, [self](bool ok) {
+    if (ok) {
+      self->Notify([](GrpcStreamObserver* observer) {
+        observer->OnStreamOpen();
+      });
+    }
+  });
+
+  // The first read also receives the backend's metadata. Reading right away
+  // rather than after the stream opens means that a failure to open is
+  // reported through OnStreamFinish() like any other.
+  grpc_op read_ops[2];
+  read_ops[0] = ReceiveInitialMetadataOp();
+  read_ops[1] = grpc_op{};
+  read_ops[1].op = GRPC_OP_RECV_MESSAGE;
+  read_ops[1].data.recv_message.recv_message = &read_buffer_;
+  StartBatch(read_ops, 2, [self](bool ok) { self->HandleRead(ok); });
+}
+
+void GrpcStream::Write(std::string message) {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  if (write_failed_) {
+    // The stream is broken, which reads report on their own.
+    return;
+  }
+  pending_writes_.push_back(std::move(message));
+  if (!write_in_flight_) {
+    WriteNext();
+  }
+}
+
+void GrpcStream::Finish() {
+  finished_ = true;
+  Cancel();
+}
+
+void GrpcStream::Read() {
+  grpc_op op{};
+  op.op = GRPC_OP_RECV_MESSAGE;
+  op.data.recv_message.recv_message = &read_buffer_;
+  std::shared_ptr<GrpcStream> self = shared_from_this();
+  StartBatch(&op, 1, [self](bool ok) { self->HandleRead(ok); });
+}
+
+void GrpcStream::HandleRead(bool ok) {
+  if (!ok || !read_buffer_) {
+    // The backend closed the stream or the call failed.
+    ReceiveStatus();
+    return;
+  }
+
+  std::string message = TakeBytes(read_buffer_);
+  read_buffer_ = nullptr;
+  Notify([message](GrpcStreamObserver* observer) {
+    observer->OnStreamRead(message);
+  });
+  Read();
+}
+
+void GrpcStream::WriteNext() {
+  write_in_flight_ = true;
+  grpc_byte_buffer* buffer = MakeByteBuffer(pending_writes_.front());
+  pending_writes_.pop_front();
+
+  grpc_op op{};
+  op.op = GRPC_OP_SEND_MESSAGE;
+  op.data.send_message.send_message = buffer;
+  std::shared_ptr<GrpcStream> self = shared_from_this();
+  StartBatch(&op, 1, [self, buffer](bool ok) {
+    grpc_byte_buffer_destroy(buffer);
+    self->HandleWrite(ok);
+  });
+}
+
+void GrpcStream::HandleWrite(bool ok) {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  write_in_flight_ = false;
+  if (!ok) {
+    write_failed_ = true;
+    pending_writes_.clear();
+    return;
+  }
+  if (!pending_writes_.empty()) {
+    WriteNext();
+  }
+}
+
+void GrpcStream::ReceiveStatus() {
+  grpc_op op = ReceiveStatusOp();
+  std::shared_ptr<GrpcStream> self = shared_from_this();
+  StartBatch(&op, 1, [self](bool) {
+    grpc_status_code status = self->status();
+    std::string error_message = self->status_details();
+    self->Notify([self, status, error_message](GrpcStreamObserver* observer) {
+      self->finished_ = true;
+      observer->OnStreamFinish(status, error_message);
+    });
+  });
+}
+
+void GrpcStream::Notify(std::function<void(GrpcStreamObserver*)> event) {
+  std::shared_ptr<GrpcStream> self = shared_from_this();
+  Execute([self, event] {
+    if (!self->finished_) {
+      event(self->observer_);
+    }
+  });
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
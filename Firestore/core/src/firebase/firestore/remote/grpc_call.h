@@ -0,0 +1,229 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_CALL_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_CALL_H_
+
+#include <grpc/grpc.h>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion_queue.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/** Metadata sent at the start of an RPC, e.g. the authorization header. */
+using GrpcMetadata = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * Runs the callbacks of RPCs, e.g. on Firestore's worker queue. Tasks must be
+ * run one at a time, in the order in which they were submitted.
+ */
+using Executor = std::function<void(std::function<void()>)>;
+
+/**
+ * The state shared by all kinds of RPCs: the underlying grpc_call and the
+ * metadata sent with it.
+ */
+class GrpcCall {
+ public:
+  /**
+   * Takes ownership of the given call.
+   *
+   * @param call A call created on the given completion queue.
+   * @param queue The completion queue to start the call's operations on.
+   * @param metadata The metadata to send once the call starts.
+   * @param executor The executor to run callbacks for the call on.
+   */
+  GrpcCall(grpc_call* call,
+           GrpcCompletionQueue* queue,
+           const GrpcMetadata& metadata,
+           Executor executor);
+  virtual ~GrpcCall();
+
+  GrpcCall(const GrpcCall& other) = delete;
+  GrpcCall& operator=(const GrpcCall& other) = delete;
+
+  /**
+   * Cancels the call. Any operations still pending complete as failed and
+   * the call finishes with GRPC_STATUS_CANCELLED. Safe to call from any
+   * thread, and more than once.
+   */
+  void Cancel();
+
+ protected:
+  /**
+   * Starts the given batch of operations. on_complete is called on the thread
+   * polling the completion queue once the batch finishes.
+   */
+  void StartBatch(const grpc_op* ops,
+                  size_t count,
+                  std::function<void(bool ok)> on_complete);
+
+  /** Returns an operation sending the call's metadata. */
+  grpc_op SendInitialMetadataOp();
+
+  /** Returns an operation receiving the metadata the backend responds with. */
+  grpc_op ReceiveInitialMetadataOp();
+
+  /** Returns an operation receiving the call's final status. */
+  grpc_op ReceiveStatusOp();
+
+  /** Copies the contents of the given byte buffer and destroys it. */
+  static std::string TakeBytes(grpc_byte_buffer* buffer);
+
+  /** Returns a new byte buffer holding a copy of the given bytes. */
+  static grpc_byte_buffer* MakeByteBuffer(const std::string& bytes);
+
+  /** Runs the given task on the call's executor. */
+  void Execute(std::function<void()> task) {
+    executor_(std::move(task));
+  }
+
+  grpc_status_code status() const {
+    return status_;
+  }
+
+  /** Returns the error message the call finished with, if any. */
+  std::string status_details() const;
+
+ private:
+  grpc_call* call_;
+  GrpcCompletionQueue* queue_;
+  Executor executor_;
+  std::vector<grpc_metadata> metadata_;
+
+  grpc_metadata_array initial_metadata_;
+  grpc_metadata_array trailing_metadata_;
+  grpc_status_code status_ = GRPC_STATUS_UNKNOWN;
+  grpc_slice status_details_;
+};
+
+/**
+ * A call that sends a single request and receives a single response, such as
+ * Commit.
+ */
+class GrpcUnaryCall : public GrpcCall,
+                      public std::enable_shared_from_this<GrpcUnaryCall> {
+ public:
+  /**
+   * Called with the status the call finished with, an error message if it
+   * failed, and the bytes of the response if it succeeded.
+   */
+  using Callback = std::function<void(grpc_status_code status,
+                                      const std::string& error_message,
+                                      const std::string& response)>;
+
+  using GrpcCall::GrpcCall;
+
+  /**
+   * Sends the given request. The callback is run on the executor once the
+   * call finishes. The call keeps itself alive until then.
+   */
+  void Start(const std::string& request, Callback callback);
+
+ private:
+  grpc_byte_buffer* response_ = nullptr;
+};
+
+/** Receives the events of a GrpcStream. All methods run on its executor. */
+class GrpcStreamObserver {
+ public:
+  virtual ~GrpcStreamObserver() {
+  }
+
+  /** Called once the stream is ready to have messages written into it. */
+  virtual void OnStreamOpen() = 0;
+
+  /** Called with the bytes of each message received from the backend. */
+  virtual void OnStreamRead(const std::string& message) = 0;
+
+  /**
+   * Called once the stream has closed, with the status the call finished with
+   * and an error message if it failed. No further events follow.
+   */
+  virtual void OnStreamFinish(grpc_status_code status,
+                              const std::string& error_message) = 0;
+};
+
+/**
+ * A bidirectional streaming call, such as Listen or Write. Messages are read
+ * continuously from the moment the stream starts; messages written while an
+ * earlier one is still being sent are queued and sent in order.
+ */
+class GrpcStream : public GrpcCall,
+                   public std::enable_shared_from_this<GrpcStream> {
+ public:
+  /**
+   * @param observer The observer to notify of events on the stream. It must
+   *     stay alive until the stream has finished or Finish() is called.
+   */
+  GrpcStream(grpc_call* call,
+             GrpcCompletionQueue* queue,
+             const GrpcMetadata& metadata,
+             Executor executor,
+             GrpcStreamObserver* observer);
+
+  /** Starts the call. Must be called once, before any other method. */
+  void Start();
+
+  /** Sends the given message, once any messages written before are sent. */
+  void Write(std::string message);
+
+  /**
+   * Closes the stream. Unlike the stream finishing by itself, this emits no
+   * further events on the observer, including OnStreamFinish(). Must be
+   * called on the executor.
+   */
+  void Finish();
+
+ private:
+  void Read();
+  void HandleRead(bool ok);
+  void WriteNext();
+  void HandleWrite(bool ok);
+  void ReceiveStatus();
+
+  /** Runs the given event on the executor unless the stream has finished. */
+  void Notify(std::function<void(GrpcStreamObserver*)> event);
+
+  GrpcStreamObserver* observer_;
+
+  // Only touched on the executor.
+  bool finished_ = false;
+
+  // Only touched by reads, which never run concurrently.
+  grpc_byte_buffer* read_buffer_ = nullptr;
+
+  std::mutex write_mutex_;
+  std::deque<std::string> pending_writes_;
+  bool write_in_flight_ = false;
+  bool write_failed_ = false;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_CALL_H_
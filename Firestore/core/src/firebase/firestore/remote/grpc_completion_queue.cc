@@ -0,0 +1,88 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion_queue.h"
+
+#include <grpc/support/time.h>
+
+#include <utility>
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+/** The tag of a batch: the callback to run once it finishes. */
+using Completion = std::function<void(bool ok)>;
+
+}  // namespace
+
+GrpcCompletionQueue::GrpcCompletionQueue()
+    : queue_(grpc_completion_queue_create_for_next(nullptr)) {
+  polling_thread_ = std::thread([this] { Poll(); });
+}
+
+GrpcCompletionQueue::~GrpcCompletionQueue() {
+  Shutdown();
+  grpc_completion_queue_destroy(queue_);
+}
+
+void* GrpcCompletionQueue::NewTag(std::function<void(bool ok)> on_complete) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_batches_ += 1;
+  return new Completion(std::move(on_complete));
+}
+
+void GrpcCompletionQueue::Shutdown() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (shut_down_) {
+      return;
+    }
+    // Completions can start more batches, which gRPC rejects once the queue
+    // is shutting down, so only shut down once none are left.
+    drained_.wait(lock, [this] { return pending_batches_ == 0; });
+    shut_down_ = true;
+  }
+
+  grpc_completion_queue_shutdown(queue_);
+  polling_thread_.join();
+}
+
+void GrpcCompletionQueue::Poll() {
+  for (;;) {
+    grpc_event event = grpc_completion_queue_next(
+        queue_, gpr_inf_future(GPR_CLOCK_REALTIME), nullptr);
+    if (event.type == GRPC_QUEUE_SHUTDOWN) {
+      return;
+    }
+
+    auto* completion = static_cast<Completion*>(event.tag);
+    (*completion)(event.success != 0);
+    delete completion;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_batches_ -= 1;
+    if (pending_batches_ == 0) {
+      drained_.notify_all();
+    }
+  }
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
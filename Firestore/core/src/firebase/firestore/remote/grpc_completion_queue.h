@@ -0,0 +1,81 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_COMPLETION_QUEUE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_COMPLETION_QUEUE_H_
+
+#include <grpc/grpc.h>
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <functional>
+#include <mutex>   // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * A gRPC completion queue together with the thread that polls it. Each batch
+ * of operations started on the queue is tagged with a callback, which the
+ * polling thread runs once the batch finishes.
+ */
+class GrpcCompletionQueue {
+ public:
+  GrpcCompletionQueue();
+
+  /** Shuts down the queue if Shutdown() hasn't been called yet. */
+  ~GrpcCompletionQueue();
+
+  GrpcCompletionQueue(const GrpcCompletionQueue& other) = delete;
+  GrpcCompletionQueue& operator=(const GrpcCompletionQueue& other) = delete;
+
+  grpc_completion_queue* queue() const {
+    return queue_;
+  }
+
+  /**
+   * Returns a tag for a new batch of operations. on_complete runs on the
+   * polling thread once the batch finishes; ok is false if it failed, e.g.
+   * because its call was cancelled.
+   */
+  void* NewTag(std::function<void(bool ok)> on_complete);
+
+  /**
+   * Waits for all the batches started on the queue to finish, including any
+   * started by the callbacks of others, then shuts down the queue and joins
+   * the polling thread. The calls using the queue must have been cancelled or
+   * complete by themselves, or this never returns.
+   */
+  void Shutdown();
+
+ private:
+  void Poll();
+
+  grpc_completion_queue* queue_;
+  std::thread polling_thread_;
+
+  std::mutex mutex_;
+  std::condition_variable drained_;
+  int pending_batches_ = 0;
+  bool shut_down_ = false;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_COMPLETION_QUEUE_H_
@@ -0,0 +1,516 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/wire_decoder.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <string>
+#include <utility>
+
+#include "Firestore/core/include/firebase/firestore/geo_point.h"
+#include "Firestore/core/src/firebase/firestore/remote/wire_reader.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using model::FieldValue;
+using model::Timestamp;
+
+namespace {
+
+// Field numbers of google.firestore.v1beta1.Value.
+const uint32_t kValueBoolean = 1;
+const uint32_t kValueInteger = 2;
+const uint32_t kValueDouble = 3;
+const uint32_t kValueReference = 5;
+const uint32_t kValueMap = 6;
+const uint32_t kValueGeoPoint = 8;
+const uint32_t kValueArray = 9;
+const uint32_t kValueTimestamp = 10;
+const uint32_t kValueNull = 11;
+const uint32_t kValueString = 17;
+const uint32_t kValueBytes = 18;
+
+// Field numbers of ArrayValue, MapValue and their map entries.
+const uint32_t kArrayValues = 1;
+const uint32_t kMapFields = 1;
+const uint32_t kMapEntryKey = 1;
+const uint32_t kMapEntryValue = 2;
+
+// Field numbers of google.firestore.v1beta1.Document.
+const uint32_t kDocumentName = 1;
+const uint32_t kDocumentFields = 2;
+const uint32_t kDocumentUpdateTime = 4;
+
+// Field numbers of google.firestore.v1beta1.DocumentChange.
+const uint32_t kDocumentChangeDocument = 1;
+const uint32_t kDocumentChangeTargetIds = 5;
+const uint32_t kDocumentChangeRemovedTargetIds = 6;
+
+// Field numbers of the response_type oneof of ListenResponse.
+const uint32_t kListenResponseTargetChange = 2;
+const uint32_t kListenResponseDocumentChange = 3;
+const uint32_t kListenResponseDocumentDelete = 4;
+const uint32_t kListenResponseFilter = 5;
+const uint32_t kListenResponseDocumentRemove = 6;
+
+// Field numbers of google.protobuf.Timestamp and google.type.LatLng.
+const uint32_t kTimestampSeconds = 1;
+const uint32_t kTimestampNanos = 2;
+const uint32_t kLatLngLatitude = 1;
+const uint32_t kLatLngLongitude = 2;
+
+// How deeply arrays and maps may nest within a value, matching protobuf's
+// default recursion limit. Deeper input is rejected rather than risk running
+// out of stack.
+const int kMaxNestingDepth = 100;
+
+// The range of timestamps Firestore supports: 0001-01-01 to 9999-12-31.
+const int64_t kMinTimestampSeconds = -62135596800L;
+const int64_t kMaxTimestampSeconds = 253402300800L;
+
+bool ReadDouble(WireReader* reader, WireType wire_type, double* result) {
+  uint64_t bits;
+  if (wire_type != WireType::Fixed64 || !reader->ReadFixed64(&bits)) {
+    return false;
+  }
+  memcpy(result, &bits, sizeof(bits));
+  return true;
+}
+
+bool ReadBytes(WireReader* reader,
+               WireType wire_type,
+               absl::string_view* result) {
+  return wire_type == WireType::LengthDelimited &&
+         reader->ReadLengthDelimited(result);
+}
+
+bool ReadVarint(WireReader* reader, WireType wire_type, uint64_t* result) {
+  return wire_type == WireType::Varint && reader->ReadVarint(result);
+}
+
+/**
+ * Reads one int32 or, for a packed repeated field, all of them, appending
+ * them to the result.
+ */
+bool ReadInt32s(WireReader* reader,
+                WireType wire_type,
+                std::vector<int32_t>* result) {
+  uint64_t value;
+  if (wire_type == WireType::Varint) {
+    if (!reader->ReadVarint(&value)) {
+      return false;
+    }
+    result->push_back(static_cast<int32_t>(value));
+    return true;
+  }
+
+  absl::string_view packed;
+  if (!ReadBytes(reader, wire_type, &packed)) {
+    return false;
+  }
+  WireReader packed_reader{packed};
+  while (!packed_reader.done()) {
+    if (!packed_reader.ReadVarint(&value)) {
+      return false;
+    }
+    result->push_back(static_cast<int32_t>(value));
+  }
+  return true;
+}
+
+bool DecodeValueAtDepth(absl::string_view bytes,
+                        int depth,
+                        FieldValue* result);
+
+bool DecodeGeoPoint(absl::string_view bytes, FieldValue* result) {
+  double latitude = 0;
+  double longitude = 0;
+  WireReader reader{bytes};
+  while (!reader.done()) {
+    uint32_t field;
+    WireType wire_type;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return false;
+    }
+    bool ok;
+    switch (field) {
+      case kLatLngLatitude:
+        ok = ReadDouble(&reader, wire_type, &latitude);
+        break;
+      case kLatLngLongitude:
+        ok = ReadDouble(&reader, wire_type, &longitude);
+        break;
+      default:
+        ok = reader.SkipField(wire_type);
+        break;
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+
+  if (isnan(latitude) || latitude < -90 || latitude > 90 || isnan(longitude) ||
+      longitude < -180 || longitude > 180) {
+    return false;
+  }
+  *result = FieldValue::GeoPointValue(GeoPoint{latitude, longitude});
+  return true;
+}
+
+/**
+ * Decodes a map entry, as repeated in MapValue.fields and Document.fields.
+ * The entry's value sits at the given nesting depth.
+ */
+bool DecodeMapEntry(absl::string_view bytes,
+                    int depth,
+                    FieldValue::Map::Builder* fields) {
+  absl::string_view key;
+  absl::string_view value_bytes;
+  bool has_value = false;
+  WireReader reader{bytes};
+  while (!reader.done()) {
+    uint32_t field;
+    WireType wire_type;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return false;
+    }
+    bool ok;
+    switch (field) {
+      case kMapEntryKey:
+        ok = ReadBytes(&reader, wire_type, &key);
+        break;
+      case kMapEntryValue:
+        ok = ReadBytes(&reader, wire_type, &value_bytes);
+        has_value = true;
+        break;
+      default:
+        ok = reader.SkipField(wire_type);
+        break;
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+
+  FieldValue value;
+  if (!has_value || !DecodeValueAtDepth(value_bytes, depth, &value)) {
+    return false;
+  }
+  fields->insert(std::string{key.data(), key.size()}, value);
+  return true;
+}
+
+/** Decodes a MapValue whose values sit at the given depth. */
+bool DecodeMap(absl::string_view bytes, int depth, FieldValue* result) {
+  FieldValue::Map::Builder fields;
+  WireReader reader{bytes};
+  while (!reader.done()) {
+    uint32_t field;
+    WireType wire_type;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return false;
+    }
+    if (field == kMapFields) {
+      absl::string_view entry;
+      if (!ReadBytes(&reader, wire_type, &entry) ||
+          !DecodeMapEntry(entry, depth, &fields)) {
+        return false;
+      }
+    } else if (!reader.SkipField(wire_type)) {
+      return false;
+    }
+  }
+  *result = FieldValue::ObjectValue(fields.Build());
+  return true;
+}
+
+/** Decodes an ArrayValue whose values sit at the given depth. */
+bool DecodeArray(absl::string_view bytes, int depth, FieldValue* result) {
+  std::vector<FieldValue> values;
+  WireReader reader{bytes};
+  while (!reader.done()) {
+    uint32_t field;
+    WireType wire_type;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return false;
+    }
+    if (field == kArrayValues) {
+      absl::string_view value_bytes;
+      FieldValue value;
+      if (!ReadBytes(&reader, wire_type, &value_bytes) ||
+          !DecodeValueAtDepth(value_bytes, depth, &value)) {
+        return false;
+      }
+      values.push_back(std::move(value));
+    } else if (!reader.SkipField(wire_type)) {
+      return false;
+    }
+  }
+  *result = FieldValue::ArrayValue(std::move(values));
+  return true;
+}
+
+/**
+ * Decodes a Value nested inside `depth` arrays and maps, failing if that's
+ * more than kMaxNestingDepth.
+ */
+bool DecodeValueAtDepth(absl::string_view bytes,
+                        int depth,
+                        FieldValue* result) {
+  if (depth > kMaxNestingDepth) {
+    return false;
+  }
+
+  // The value is a oneof, and the last member on the wire wins.
+  bool has_value = false;
+  WireReader reader{bytes};
+  while (!reader.done()) {
+    uint32_t field;
+    WireType wire_type;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return false;
+    }
+
+    uint64_t varint = 0;
+    double number = 0;
+    absl::string_view nested;
+    Timestamp timestamp;
+    bool ok;
+    switch (field) {
+      case kValueNull:
+        ok = ReadVarint(&reader, wire_type, &varint);
+        *result = FieldValue::NullValue();
+        break;
+      case kValueBoolean:
+        ok = ReadVarint(&reader, wire_type, &varint);
+        *result = FieldValue::BooleanValue(varint != 0);
+        break;
+      case kValueInteger:
+        ok = ReadVarint(&reader, wire_type, &varint);
+        *result = FieldValue::IntegerValue(static_cast<int64_t>(varint));
+        break;
+      case kValueDouble:
+        ok = ReadDouble(&reader, wire_type, &number);
+        *result = FieldValue::DoubleValue(number);
+        break;
+      case kValueTimestamp:
+        ok = ReadBytes(&reader, wire_type, &nested) &&
+             WireDecoder::DecodeTimestamp(nested, &timestamp);
+        *result = FieldValue::TimestampValue(timestamp);
+        break;
+      case kValueString:
+        ok = ReadBytes(&reader, wire_type, &nested);
+        *result = FieldValue::StringValue(nested);
+        break;
+      case kValueBytes:
+        ok = ReadBytes(&reader, wire_type, &nested);
+        *result = FieldValue::BlobValue(
+            reinterpret_cast<const uint8_t*>(nested.data()), nested.size());
+        break;
+      case kValueGeoPoint:
+        ok = ReadBytes(&reader, wire_type, &nested) &&
+             DecodeGeoPoint(nested, result);
+        break;
+      case kValueArray:
+        ok = ReadBytes(&reader, wire_type, &nested) &&
+             DecodeArray(nested, depth + 1, result);
+        break;
+      case kValueMap:
+        ok = ReadBytes(&reader, wire_type, &nested) &&
+             DecodeMap(nested, depth + 1, result);
+        break;
+      case kValueReference:
+        // FieldValue can't represent references yet.
+        return false;
+      default:
+        if (!reader.SkipField(wire_type)) {
+          return false;
+        }
+        continue;
+    }
+    if (!ok) {
+      return false;
+    }
+    has_value = true;
+  }
+  return has_value;
+}
+
+}  // namespace
+
+bool WireDecoder::DecodeValue(absl::string_view bytes, FieldValue* result) {
+  return DecodeValueAtDepth(bytes, 0, result);
+}
+
+bool WireDecoder::DecodeDocument(absl::string_view bytes,
+                                 DecodedDocument* result) {
+  FieldValue::Map::Builder fields;
+  absl::string_view name;
+  Timestamp update_time;
+  WireReader reader{bytes};
+  while (!reader.done()) {
+    uint32_t field;
+    WireType wire_type;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return false;
+    }
+    absl::string_view nested;
+    bool ok;
+    switch (field) {
+      case kDocumentName:
+        ok = ReadBytes(&reader, wire_type, &name);
+        break;
+      case kDocumentFields:
+        ok = ReadBytes(&reader, wire_type, &nested) &&
+             DecodeMapEntry(nested, 0, &fields);
+        break;
+      case kDocumentUpdateTime:
+        ok = ReadBytes(&reader, wire_type, &nested) &&
+             DecodeTimestamp(nested, &update_time);
+        break;
+      default:
+        ok = reader.SkipField(wire_type);
+        break;
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+
+  result->name = name;
+  result->data = FieldValue::ObjectValue(fields.Build());
+  result->update_time = update_time;
+  return true;
+}
+
+bool WireDecoder::DecodeDocumentChange(absl::string_view bytes,
+                                       DecodedDocumentChange* result) {
+  DecodedDocumentChange change;
+  WireReader reader{bytes};
+  while (!reader.done()) {
+    uint32_t field;
+    WireType wire_type;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return false;
+    }
+    absl::string_view nested;
+    bool ok;
+    switch (field) {
+      case kDocumentChangeDocument:
+        ok = ReadBytes(&reader, wire_type, &nested) &&
+             DecodeDocument(nested, &change.document);
+        break;
+      case kDocumentChangeTargetIds:
+        ok = ReadInt32s(&reader, wire_type, &change.target_ids);
+        break;
+      case kDocumentChangeRemovedTargetIds:
+        ok = ReadInt32s(&reader, wire_type, &change.removed_target_ids);
+        break;
+      default:
+        ok = reader.SkipField(wire_type);
+        break;
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+  *result = std::move(change);
+  return true;
+}
+
+bool WireDecoder::DecodeListenResponse(absl::string_view bytes,
+                                       DecodedDocumentChange* result,
+                                       bool* is_document_change) {
+  absl::string_view document_change;
+  bool found = false;
+  WireReader reader{bytes};
+  while (!reader.done()) {
+    uint32_t field;
+    WireType wire_type;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return false;
+    }
+    switch (field) {
+      case kListenResponseDocumentChange:
+        if (!ReadBytes(&reader, wire_type, &document_change)) {
+          return false;
+        }
+        found = true;
+        continue;
+      case kListenResponseTargetChange:
+      case kListenResponseDocumentDelete:
+      case kListenResponseFilter:
+      case kListenResponseDocumentRemove:
+        // Any later member of the response_type oneof replaces the change.
+        found = false;
+        break;
+      default:
+        break;
+    }
+    if (!reader.SkipField(wire_type)) {
+      return false;
+    }
+  }
+
+  *is_document_change = found;
+  return !found || DecodeDocumentChange(document_change, result);
+}
+
+bool WireDecoder::DecodeTimestamp(absl::string_view bytes, Timestamp* result) {
+  int64_t seconds = 0;
+  int64_t nanos = 0;
+  WireReader reader{bytes};
+  while (!reader.done()) {
+    uint32_t field;
+    WireType wire_type;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return false;
+    }
+    uint64_t varint;
+    bool ok;
+    switch (field) {
+      case kTimestampSeconds:
+        ok = ReadVarint(&reader, wire_type, &varint);
+        seconds = static_cast<int64_t>(varint);
+        break;
+      case kTimestampNanos:
+        ok = ReadVarint(&reader, wire_type, &varint);
+        nanos = static_cast<int64_t>(varint);
+        break;
+      default:
+        ok = reader.SkipField(wire_type);
+        break;
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+
+  if (seconds < kMinTimestampSeconds || seconds >= kMaxTimestampSeconds ||
+      nanos < 0 || nanos >= 1000000000) {
+    return false;
+  }
+  *result = Timestamp{seconds, static_cast<int32_t>(nanos)};
+  return true;
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
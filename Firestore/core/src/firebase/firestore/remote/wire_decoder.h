@@ -0,0 +1,98 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WIRE_DECODER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WIRE_DECODER_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/model/timestamp.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * A google.firestore.v1beta1.Document decoded by WireDecoder. The name is a
+ * view into the buffer it was decoded from, which must outlive it.
+ */
+struct DecodedDocument {
+  absl::string_view name;
+
+  /** The fields of the document, as an Object value. */
+  model::FieldValue data;
+
+  model::Timestamp update_time;
+};
+
+/** A google.firestore.v1beta1.DocumentChange decoded by WireDecoder. */
+struct DecodedDocumentChange {
+  DecodedDocument document;
+  std::vector<int32_t> target_ids;
+  std::vector<int32_t> removed_target_ids;
+};
+
+/**
+ * Decodes the Firestore protos that carry document data straight from their
+ * wire format into model types, without materializing an intermediate
+ * message. Field values are decoded directly into model::FieldValue; only the
+ * bytes of field names and values are copied out of the buffer.
+ *
+ * Each Decode method returns false if its input is malformed, nests arrays and
+ * maps more than 100 deep, or holds values the model can't represent
+ * (currently reference values), in which case the caller should fall back to
+ * the generated protos. Unknown fields are skipped.
+ */
+class WireDecoder {
+ public:
+  /** Decodes a google.firestore.v1beta1.Value. */
+  static bool DecodeValue(absl::string_view bytes, model::FieldValue* result);
+
+  /** Decodes a google.firestore.v1beta1.Document. */
+  static bool DecodeDocument(absl::string_view bytes, DecodedDocument* result);
+
+  /** Decodes a google.firestore.v1beta1.DocumentChange. */
+  static bool DecodeDocumentChange(absl::string_view bytes,
+                                   DecodedDocumentChange* result);
+
+  /**
+   * Decodes a google.firestore.v1beta1.ListenResponse if it's a document
+   * change, the bulk of an initial sync.
+   *
+   * @param bytes The encoded ListenResponse.
+   * @param result Receives the decoded document change, if there is one.
+   * @param is_document_change Set to whether the response was a document
+   *     change. If not, result is untouched and the response should be
+   *     decoded through the generated protos.
+   */
+  static bool DecodeListenResponse(absl::string_view bytes,
+                                   DecodedDocumentChange* result,
+                                   bool* is_document_change);
+
+  /** Decodes a google.protobuf.Timestamp. */
+  static bool DecodeTimestamp(absl::string_view bytes,
+                              model::Timestamp* result);
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WIRE_DECODER_H_
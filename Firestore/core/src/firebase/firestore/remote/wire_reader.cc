@@ -0,0 +1,110 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/wire_reader.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+bool WireReader::ReadTag(uint32_t* field_number, WireType* wire_type) {
+  uint64_t tag;
+  if (!ReadVarint(&tag) || tag > UINT32_MAX) {
+    return false;
+  }
+  *field_number = static_cast<uint32_t>(tag >> 3);
+  *wire_type = static_cast<WireType>(tag & 0x7);
+  return *field_number != 0;
+}
+
+bool WireReader::ReadVarint(uint64_t* result) {
+  uint64_t value = 0;
+  // A 64-bit varint has at most 10 bytes of 7 bits each.
+  for (int shift = 0; shift < 70; shift += 7) {
+    if (remaining_.empty()) {
+      return false;
+    }
+    uint8_t byte = static_cast<uint8_t>(remaining_[0]);
+    remaining_.remove_prefix(1);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *result = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WireReader::ReadFixed64(uint64_t* result) {
+  if (remaining_.size() < 8) {
+    return false;
+  }
+  uint64_t value = 0;
+  for (int i = 7; i >= 0; i--) {
+    value = (value << 8) | static_cast<uint8_t>(remaining_[i]);
+  }
+  remaining_.remove_prefix(8);
+  *result = value;
+  return true;
+}
+
+bool WireReader::ReadFixed32(uint32_t* result) {
+  if (remaining_.size() < 4) {
+    return false;
+  }
+  uint32_t value = 0;
+  for (int i = 3; i >= 0; i--) {
+    value = (value << 8) | static_cast<uint8_t>(remaining_[i]);
+  }
+  remaining_.remove_prefix(4);
+  *result = value;
+  return true;
+}
+
+bool WireReader::ReadLengthDelimited(absl::string_view* result) {
+  uint64_t length;
+  if (!ReadVarint(&length) || length > remaining_.size()) {
+    return false;
+  }
+  *result = remaining_.substr(0, static_cast<size_t>(length));
+  remaining_.remove_prefix(static_cast<size_t>(length));
+  return true;
+}
+
+bool WireReader::SkipField(WireType wire_type) {
+  uint64_t unused64;
+  uint32_t unused32;
+  absl::string_view unused_view;
+  switch (wire_type) {
+    case WireType::Varint:
+      return ReadVarint(&unused64);
+    case WireType::Fixed64:
+      return ReadFixed64(&unused64);
+    case WireType::LengthDelimited:
+      return ReadLengthDelimited(&unused_view);
+    case WireType::Fixed32:
+      return ReadFixed32(&unused32);
+    case WireType::StartGroup:
+    case WireType::EndGroup:
+      // Groups are deprecated and never used by the Firestore protos.
+      return false;
+  }
+  return false;
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WIRE_READER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WIRE_READER_H_
+
+#include <stdint.h>
+
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/** The wire types of the protocol buffer encoding. */
+enum class WireType {
+  Varint = 0,
+  Fixed64 = 1,
+  LengthDelimited = 2,
+  StartGroup = 3,
+  EndGroup = 4,
+  Fixed32 = 5,
+};
+
+/**
+ * Reads the fields of a protocol buffer message directly from its encoded
+ * bytes, without allocating. Length-delimited fields are returned as views
+ * into the original buffer, which must outlive them.
+ *
+ * All the Read methods return false if the input is malformed, after which
+ * the reader must not be used any further.
+ */
+class WireReader {
+ public:
+  explicit WireReader(absl::string_view buffer) : remaining_(buffer) {
+  }
+
+  /** Returns true if all fields of the message have been read. */
+  bool done() const {
+    return remaining_.empty();
+  }
+
+  /** Reads the tag that starts the next field. */
+  bool ReadTag(uint32_t* field_number, WireType* wire_type);
+
+  /** Reads a varint field, as used for int32, int64, uint64, bool and enum. */
+  bool ReadVarint(uint64_t* result);
+
+  /** Reads a fixed64 field, as used for double. */
+  bool ReadFixed64(uint64_t* result);
+
+  /** Reads a fixed32 field, as used for float. */
+  bool ReadFixed32(uint32_t* result);
+
+  /**
+   * Reads a length-delimited field (string, bytes, embedded message or packed
+   * repeated field) as a view into the buffer.
+   */
+  bool ReadLengthDelimited(absl::string_view* result);
+
+  /** Skips over the value of a field of the given type. */
+  bool SkipField(WireType wire_type);
+
+ private:
+  absl::string_view remaining_;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WIRE_READER_H_
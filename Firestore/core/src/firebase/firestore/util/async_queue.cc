@@ -0,0 +1,87 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+AsyncQueue::AsyncQueue(std::unique_ptr<Executor> executor,
+                       WorkStealingPool* background_pool)
+    : executor_(std::move(executor)), background_pool_(background_pool) {
+}
+
+void AsyncQueue::VerifyIsCurrentQueue() const {
+  FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+      executor_->IsCurrentExecutor() && is_operation_in_progress_,
+      executor_->IsCurrentExecutor() && is_operation_in_progress_,
+      "VerifyIsCurrentQueue called outside of an operation of the queue");
+}
+
+void AsyncQueue::Enqueue(Operation&& operation) {
+  FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+      !executor_->IsCurrentExecutor(), !executor_->IsCurrentExecutor(),
+      "Enqueue called when we are already running on the target queue; use "
+      "EnqueueAllowingSameQueue if this is intended");
+  executor_->Execute(Wrap(std::move(operation)));
+}
+
+void AsyncQueue::EnqueueAllowingSameQueue(Operation&& operation) {
+  executor_->Execute(Wrap(std::move(operation)));
+}
+
+void AsyncQueue::EnqueueAfterDelay(const Milliseconds delay,
+                                   Operation&& operation) {
+  executor_->ExecuteAfter(delay, Wrap(std::move(operation)));
+}
+
+void AsyncQueue::RunInBackground(Operation&& work, Operation&& then) {
+  if (!background_pool_) {
+    EnqueueAllowingSameQueue([work, then] {
+      work();
+      then();
+    });
+    return;
+  }
+
+  // std::function must be copyable, so move the operations in through a
+  // shared pointer rather than capturing them by copy.
+  auto operations =
+      std::make_shared<std::pair<Operation, Operation>>(std::move(work),
+                                                        std::move(then));
+  background_pool_->Submit([this, operations] {
+    operations->first();
+    EnqueueAllowingSameQueue(std::move(operations->second));
+  });
+}
+
+AsyncQueue::Operation AsyncQueue::Wrap(Operation&& operation) {
+  auto shared = std::make_shared<Operation>(std::move(operation));
+  return [this, shared] {
+    is_operation_in_progress_ = true;
+    (*shared)();
+    is_operation_in_progress_ = false;
+  };
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
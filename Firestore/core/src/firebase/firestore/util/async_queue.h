@@ -0,0 +1,100 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ASYNC_QUEUE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ASYNC_QUEUE_H_
+
+#include <atomic>
+#include <memory>
+
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/work_stealing_pool.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * A serial queue that all the operations of a Firestore client run on, with
+ * the same guarantees as FSTDispatchQueue: operations run one at a time, in
+ * order, and enqueueing onto the queue from the queue itself is flagged as a
+ * bug unless explicitly allowed.
+ *
+ * The queue is backed by an Executor, so it can run on libdispatch or on a
+ * plain thread. Optionally, it can hand CPU-bound work to a WorkStealingPool
+ * and continue on the queue with the result; see RunInBackground().
+ */
+class AsyncQueue {
+ public:
+  using Operation = Executor::Operation;
+  using Milliseconds = Executor::Milliseconds;
+
+  /**
+   * Creates a queue that runs its operations on the given executor and its
+   * background work on the given pool, if any, which must outlive the queue.
+   */
+  explicit AsyncQueue(std::unique_ptr<Executor> executor,
+                      WorkStealingPool* background_pool = nullptr);
+
+  /**
+   * Asserts that the caller is running an operation of this queue.
+   */
+  void VerifyIsCurrentQueue() const;
+
+  /**
+   * Schedules the operation to run asynchronously. Asserts that the caller
+   * isn't already on the queue, since this generally indicates a bug (and can
+   * lead to re-ordering of operations, etc).
+   */
+  void Enqueue(Operation&& operation);
+
+  /**
+   * Like Enqueue() but doesn't require the caller to be off the queue. This is
+   * useful e.g. for operations scheduled from user API calls, which may or
+   * may not be made on the queue.
+   */
+  void EnqueueAllowingSameQueue(Operation&& operation);
+
+  /**
+   * Schedules the operation to run once the given delay has passed. May be
+   * called from the queue itself.
+   */
+  void EnqueueAfterDelay(Milliseconds delay, Operation&& operation);
+
+  /**
+   * Runs work on the background pool, then enqueues then onto this queue.
+   * work must not touch state owned by the queue; it passes its results to
+   * then through state they share, e.g. a captured std::shared_ptr. Without a
+   * background pool, both run on the queue, one after the other.
+   *
+   * The queue must outlive the work.
+   */
+  void RunInBackground(Operation&& work, Operation&& then);
+
+ private:
+  /** Wraps the operation so that the queue knows when it's running one. */
+  Operation Wrap(Operation&& operation);
+
+  std::unique_ptr<Executor> executor_;
+  WorkStealingPool* background_pool_;
+  std::atomic<bool> is_operation_in_progress_{false};
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ASYNC_QUEUE_H_
@@ -16,8 +16,11 @@
 
 #include "Firestore/core/src/firebase/firestore/util/autoid.h"
 
-#include <random>
+#include <stdint.h>
+
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
 
@@ -27,28 +30,64 @@ namespace util {
 
 namespace {
 
-const int kAutoIdLength = 20;
+const size_t kAutoIdLength = 20;
 const char kAutoIdAlphabet[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
 
-SecureRandom shared_random;
+// -1 here because sizeof(kAutoIdAlphabet) includes the trailing null
+// terminator.
+const size_t kAlphabetSize = sizeof(kAutoIdAlphabet) - 1;
+
+// Random bytes at or above the largest multiple of the alphabet size that fits
+// in a byte are discarded, so that every character is equally likely.
+const size_t kRejectionThreshold = 256 / kAlphabetSize * kAlphabetSize;
+
+// The most random bytes drawn at a time.
+const size_t kBlockSize = 256;
+
+/**
+ * Returns `count` characters chosen uniformly at random from kAutoIdAlphabet.
+ *
+ * Random bytes are drawn a block at a time rather than once per character.
+ * Nothing is shared between calls, so concurrent callers don't contend.
+ */
+std::string RandomAlphabetChars(size_t count) {
+  std::string result;
+  result.reserve(count);
+
+  SecureRandom random;
+  uint8_t block[kBlockSize];
+  while (result.size() < count) {
+    // About 3% of bytes are discarded, so ask for a few more than needed to
+    // make drawing a second block unlikely.
+    size_t needed = count - result.size();
+    size_t size = std::min(kBlockSize, needed + needed / 16 + 4);
+    random.Fill(block, size);
+
+    for (size_t i = 0; i < size && result.size() < count; i++) {
+      if (block[i] < kRejectionThreshold) {
+        result.push_back(kAutoIdAlphabet[block[i] % kAlphabetSize]);
+      }
+    }
+  }
+  return result;
+}
 
 }  // namespace
 
 std::string CreateAutoId() {
-  std::string auto_id;
-  auto_id.reserve(kAutoIdLength);
+  return RandomAlphabetChars(kAutoIdLength);
+}
 
-  // -2 here because:
-  //   * sizeof(kAutoIdAlphabet) includes the trailing null terminator
-  //   * uniform_int_distribution is inclusive on both sizes
-  std::uniform_int_distribution<int> letters(0, sizeof(kAutoIdAlphabet) - 2);
+std::vector<std::string> CreateAutoIds(size_t count) {
+  std::string chars = RandomAlphabetChars(count * kAutoIdLength);
 
-  for (int i = 0; i < kAutoIdLength; i++) {
-    int rand_index = letters(shared_random);
-    auto_id.append(1, kAutoIdAlphabet[rand_index]);
+  std::vector<std::string> auto_ids;
+  auto_ids.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    auto_ids.push_back(chars.substr(i * kAutoIdLength, kAutoIdLength));
   }
-  return auto_id;
+  return auto_ids;
 }
 
 }  // namespace util
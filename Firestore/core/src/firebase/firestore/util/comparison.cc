@@ -17,7 +17,9 @@
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
 
 #include <math.h>
+#include <string.h>
 
+#include <algorithm>
 #include <limits>
 
 namespace firebase {
@@ -27,7 +29,21 @@ namespace util {
 bool Comparator<absl::string_view>::operator()(
     const absl::string_view& left, const absl::string_view& right) const {
   // TODO(wilhuff): truncation aware comparison
-  return left < right;
+  return CompareUtf8(left, right) == ComparisonResult::Ascending;
+}
+
+ComparisonResult CompareUtf8(absl::string_view left, absl::string_view right) {
+  // Comparing bytes as unsigned values, as memcmp does, orders UTF-8 strings
+  // by code point.
+  size_t common = std::min(left.size(), right.size());
+  int result = common == 0 ? 0 : memcmp(left.data(), right.data(), common);
+  if (result < 0 || (result == 0 && left.size() < right.size())) {
+    return ComparisonResult::Ascending;
+  } else if (result > 0 || left.size() > right.size()) {
+    return ComparisonResult::Descending;
+  } else {
+    return ComparisonResult::Same;
+  }
 }
 
 bool Comparator<double>::operator()(double left, double right) const {
@@ -79,13 +79,38 @@ struct Comparator {
   // By default comparison is not defined
 };
 
-/** Compares two strings. */
+/**
+ * Compares two strings by their UTF-8 bytes, which is how the backend orders
+ * strings.
+ *
+ * The comparator is transparent: std::strings and C strings are compared as
+ * string_views, so maps with string keys can be searched without building a
+ * std::string first.
+ */
 template <>
 struct Comparator<absl::string_view> {
+  using is_transparent = void;
+
   bool operator()(const absl::string_view& left,
                   const absl::string_view& right) const;
 };
 
+#if __OBJC__
+/**
+ * Compares two NSStrings by their UTF-8 bytes, like the backend. This differs
+ * from -[NSString compare:], which orders by UTF-16 code units and is
+ * therefore inconsistent with the backend for characters outside the Basic
+ * Multilingual Plane.
+ */
+template <>
+struct Comparator<NSString*> {
+  bool operator()(NSString* left, NSString* right) const {
+    Comparator<absl::string_view> less_than;
+    return less_than(MakeStringView(left), MakeStringView(right));
+  }
+};
+#endif
+
 /** Compares two bools: false < true. */
 template <>
 struct Comparator<bool> : public std::less<bool> {};
@@ -126,7 +151,28 @@ ComparisonResult Compare(const T& left, const T& right) {
   }
 }
 
+/**
+ * Performs a three-way comparison of two strings by their UTF-8 bytes in a
+ * single pass. The common prefix is compared with memcmp, which the C
+ * libraries of all supported platforms vectorize.
+ */
+ComparisonResult CompareUtf8(absl::string_view left, absl::string_view right);
+
+/** Compares strings with CompareUtf8 rather than two less-than comparisons. */
+template <>
+inline ComparisonResult Compare<absl::string_view>(
+    const absl::string_view& left, const absl::string_view& right) {
+  return CompareUtf8(left, right);
+}
+
 #if __OBJC__
+/** Compares NSStrings with CompareUtf8. */
+template <>
+inline ComparisonResult Compare<NSString*>(NSString* const& left,
+                                           NSString* const& right) {
+  return CompareUtf8(MakeStringView(left), MakeStringView(right));
+}
+
 /**
  * Returns true if the given ComparisonResult and NSComparisonResult have the
  * same integer values (at compile time).
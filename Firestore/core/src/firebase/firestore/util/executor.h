@@ -0,0 +1,63 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_EXECUTOR_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_EXECUTOR_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <functional>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * An interface to a platform-specific executor of asynchronous operations
+ * (called tasks on other platforms).
+ *
+ * Operations submitted to an executor run serially: each one runs to
+ * completion before the next starts, in the order they were scheduled for.
+ * Executors are thread-safe.
+ */
+class Executor {
+ public:
+  using Operation = std::function<void()>;
+  using Milliseconds = std::chrono::milliseconds;
+
+  virtual ~Executor() {
+  }
+
+  /** Schedules the operation to run as soon as possible. */
+  virtual void Execute(Operation&& operation) = 0;
+
+  /**
+   * Schedules the operation to run once the given delay has passed. Operations
+   * scheduled for the same time run in the order they were scheduled.
+   */
+  virtual void ExecuteAfter(Milliseconds delay, Operation&& operation) = 0;
+
+  /**
+   * Returns true if the caller is running an operation of this executor,
+   * i.e. it's on the executor's thread.
+   */
+  virtual bool IsCurrentExecutor() const = 0;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_EXECUTOR_H_
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+ExecutorStd::ExecutorStd() {
+  worker_thread_ = std::thread([this] { Run(); });
+}
+
+ExecutorStd::~ExecutorStd() {
+  FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+      !IsCurrentExecutor(), !IsCurrentExecutor(),
+      "ExecutorStd must not be destroyed from its own thread");
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutting_down_ = true;
+  }
+  changed_.notify_one();
+  worker_thread_.join();
+}
+
+void ExecutorStd::Execute(Operation&& operation) {
+  Schedule(Clock::now(), std::move(operation));
+}
+
+void ExecutorStd::ExecuteAfter(const Milliseconds delay,
+                               Operation&& operation) {
+  Schedule(Clock::now() + delay, std::move(operation));
+}
+
+bool ExecutorStd::IsCurrentExecutor() const {
+  return std::this_thread::get_id() == worker_thread_.get_id();
+}
+
+bool ExecutorStd::RunsAfter(const Entry& lhs, const Entry& rhs) {
+  if (lhs.target_time != rhs.target_time) {
+    return lhs.target_time > rhs.target_time;
+  }
+  return lhs.id > rhs.id;
+}
+
+void ExecutorStd::Schedule(const Clock::time_point target_time,
+                           Operation&& operation) {
+  // Notify while holding the lock: once the operation can run, the executor
+  // may be destroyed, e.g. by the operation itself signalling its owner.
+  std::lock_guard<std::mutex> lock(mutex_);
+  schedule_.push_back(Entry{target_time, next_id_++, std::move(operation)});
+  std::push_heap(schedule_.begin(), schedule_.end(), RunsAfter);
+  changed_.notify_one();
+}
+
+void ExecutorStd::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    if (shutting_down_) {
+      return;
+    }
+    if (schedule_.empty()) {
+      changed_.wait(lock);
+      continue;
+    }
+
+    // Wake up again if an earlier entry is scheduled in the meantime.
+    Clock::time_point target_time = schedule_.front().target_time;
+    if (target_time > Clock::now()) {
+      changed_.wait_until(lock, target_time);
+      continue;
+    }
+
+    std::pop_heap(schedule_.begin(), schedule_.end(), RunsAfter);
+    Operation operation = std::move(schedule_.back().operation);
+    schedule_.pop_back();
+
+    lock.unlock();
+    operation();
+    lock.lock();
+  }
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
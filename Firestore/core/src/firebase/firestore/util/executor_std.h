@@ -0,0 +1,84 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_EXECUTOR_STD_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_EXECUTOR_STD_H_
+
+#include <chrono>              // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <mutex>   // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * An Executor that runs its operations on a dedicated thread, using only the
+ * C++ standard library, so that it works on platforms without libdispatch.
+ */
+class ExecutorStd : public Executor {
+ public:
+  ExecutorStd();
+
+  /**
+   * Stops the executor thread. Operations that haven't started yet are
+   * dropped; an operation that is running is allowed to finish. Must not be
+   * called from the executor's own thread.
+   */
+  ~ExecutorStd() override;
+
+  ExecutorStd(const ExecutorStd& other) = delete;
+  ExecutorStd& operator=(const ExecutorStd& other) = delete;
+
+  void Execute(Operation&& operation) override;
+  void ExecuteAfter(Milliseconds delay, Operation&& operation) override;
+  bool IsCurrentExecutor() const override;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry {
+    Clock::time_point target_time;
+    /** Breaks ties between entries with equal target times in FIFO order. */
+    uint64_t id;
+    Operation operation;
+  };
+
+  /** Orders the schedule as a min-heap on (target_time, id). */
+  static bool RunsAfter(const Entry& lhs, const Entry& rhs);
+
+  void Schedule(Clock::time_point target_time, Operation&& operation);
+  void Run();
+
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::vector<Entry> schedule_;
+  uint64_t next_id_ = 0;
+  bool shutting_down_ = false;
+
+  std::thread worker_thread_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_EXECUTOR_STD_H_
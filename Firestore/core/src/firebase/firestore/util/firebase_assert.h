@@ -69,7 +69,7 @@
   do {                                                                      \
     if (!(condition)) {                                                     \
       firebase::firestore::util::LogError(                                  \
-          FIREBASE_EXPAND_STRINGIFY(expression));                           \
+          "%s", FIREBASE_EXPAND_STRINGIFY(expression));                     \
       firebase::firestore::util::FailAssert(__FILE__, __PRETTY_FUNCTION__,  \
                                             __LINE__, __VA_ARGS__);         \
     }                                                                       \
@@ -22,6 +22,7 @@
 #include <iterator>
 #include <memory>
 #include <type_traits>
+#include <utility>
 
 #include "absl/base/port.h"
 #include "absl/meta/type_traits.h"
@@ -805,6 +806,231 @@ typename reversed_view_type<const C>::type reversed_view(const C& c) {
   return typename reversed_view_type<const C>::type(c);
 }
 
+// A pair of iterators usable in range based for loops, e.g. to iterate over
+// part of a container without copying it.
+//
+// Example:
+//   SortedMap<int, string> map;
+//   for (const auto& entry : make_iterator_range(map.lower_bound(5),
+//                                                map.end())) {
+//     ...
+//   }
+
+template <typename It>
+class iterator_range {
+ public:
+  using iterator = It;
+  using const_iterator = It;
+  using value_type = typename std::iterator_traits<It>::value_type;
+
+  iterator_range(It begin, It end)
+      : begin_(std::move(begin)), end_(std::move(end)) {
+  }
+
+  It begin() const {
+    return begin_;
+  }
+  It end() const {
+    return end_;
+  }
+  bool empty() const {
+    return begin_ == end_;
+  }
+
+ private:
+  It begin_;
+  It end_;
+};
+
+template <typename It>
+iterator_range<It> make_iterator_range(It begin, It end) {
+  return iterator_range<It>(std::move(begin), std::move(end));
+}
+
+// An iterator that skips the elements of an underlying range for which a
+// predicate returns false. The predicate is evaluated lazily, as the iterator
+// advances, and is shared by all the iterators copied from one another.
+template <typename It, typename Pred>
+class filtered_iterator {
+ public:
+  using value_type = typename std::iterator_traits<It>::value_type;
+  using reference = typename std::iterator_traits<It>::reference;
+  using pointer = typename std::iterator_traits<It>::pointer;
+  using difference_type = typename std::iterator_traits<It>::difference_type;
+  using iterator_category = std::forward_iterator_tag;
+
+  filtered_iterator(It current, It end, std::shared_ptr<const Pred> pred)
+      : current_(std::move(current)),
+        end_(std::move(end)),
+        pred_(std::move(pred)) {
+    SkipRejected();
+  }
+
+  reference operator*() const {
+    return *current_;
+  }
+  pointer operator->() const {
+    return &*current_;
+  }
+
+  filtered_iterator& operator++() {
+    ++current_;
+    SkipRejected();
+    return *this;
+  }
+  filtered_iterator operator++(int) {
+    filtered_iterator original = *this;
+    ++(*this);
+    return original;
+  }
+
+  friend bool operator==(const filtered_iterator& lhs,
+                         const filtered_iterator& rhs) {
+    return lhs.current_ == rhs.current_;
+  }
+  friend bool operator!=(const filtered_iterator& lhs,
+                         const filtered_iterator& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  void SkipRejected() {
+    while (current_ != end_ && !(*pred_)(*current_)) {
+      ++current_;
+    }
+  }
+
+  It current_;
+  It end_;
+  std::shared_ptr<const Pred> pred_;
+};
+
+// An iterator that yields the result of applying a function to each element
+// of an underlying range. The function is applied lazily, on dereference, and
+// is shared by all the iterators copied from one another.
+template <typename It, typename Fn>
+class transformed_iterator {
+ public:
+  using reference = decltype(std::declval<const Fn&>()(
+      std::declval<typename std::iterator_traits<It>::reference>()));
+  using value_type = absl::decay_t<reference>;
+  using pointer = void;
+  using difference_type = typename std::iterator_traits<It>::difference_type;
+  using iterator_category = std::input_iterator_tag;
+
+  transformed_iterator(It current, std::shared_ptr<const Fn> fn)
+      : current_(std::move(current)), fn_(std::move(fn)) {
+  }
+
+  reference operator*() const {
+    return (*fn_)(*current_);
+  }
+
+  transformed_iterator& operator++() {
+    ++current_;
+    return *this;
+  }
+  transformed_iterator operator++(int) {
+    transformed_iterator original = *this;
+    ++current_;
+    return original;
+  }
+
+  friend bool operator==(const transformed_iterator& lhs,
+                         const transformed_iterator& rhs) {
+    return lhs.current_ == rhs.current_;
+  }
+  friend bool operator!=(const transformed_iterator& lhs,
+                         const transformed_iterator& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  It current_;
+  std::shared_ptr<const Fn> fn_;
+};
+
+// Views over a range that lazily filter or transform its elements. Nothing is
+// copied: the view holds only the underlying iterators and the function.
+//
+// Example:
+//   for (const auto& key : transformed_view(
+//            filtered_view(map.range_from(start), IsPending),
+//            [](const Entry& entry) { return entry.first; })) {
+//     ...
+//   }
+//
+// Note: The views hold iterators into the underlying container, so the
+// container must outlive them, as with key_view and value_view.
+
+template <typename It, typename Pred>
+class filtered_view_type {
+ public:
+  using iterator = filtered_iterator<It, Pred>;
+  using const_iterator = iterator;
+  using value_type = typename iterator::value_type;
+
+  filtered_view_type(const It& begin, const It& end, Pred pred)
+      : begin_(begin, end, std::make_shared<const Pred>(std::move(pred))),
+        end_(end, end, nullptr) {
+  }
+
+  iterator begin() const {
+    return begin_;
+  }
+  iterator end() const {
+    return end_;
+  }
+  bool empty() const {
+    return begin_ == end_;
+  }
+
+ private:
+  iterator begin_;
+  iterator end_;
+};
+
+template <typename It, typename Fn>
+class transformed_view_type {
+ public:
+  using iterator = transformed_iterator<It, Fn>;
+  using const_iterator = iterator;
+  using value_type = typename iterator::value_type;
+
+  transformed_view_type(const It& begin, const It& end, Fn fn)
+      : begin_(begin, std::make_shared<const Fn>(std::move(fn))),
+        end_(end, nullptr) {
+  }
+
+  iterator begin() const {
+    return begin_;
+  }
+  iterator end() const {
+    return end_;
+  }
+  bool empty() const {
+    return begin_ == end_;
+  }
+
+ private:
+  iterator begin_;
+  iterator end_;
+};
+
+template <typename Range, typename Pred>
+filtered_view_type<typename Range::const_iterator, Pred> filtered_view(
+    const Range& range, Pred pred) {
+  return filtered_view_type<typename Range::const_iterator, Pred>(
+      range.begin(), range.end(), std::move(pred));
+}
+
+template <typename Range, typename Fn>
+transformed_view_type<typename Range::const_iterator, Fn> transformed_view(
+    const Range& range, Fn fn) {
+  return transformed_view_type<typename Range::const_iterator, Fn>(
+      range.begin(), range.end(), std::move(fn));
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
@@ -19,6 +19,8 @@
 
 #include <stdarg.h>
 
+#include "absl/base/attributes.h"
+
 namespace firebase {
 namespace firestore {
 namespace util {
@@ -43,21 +45,45 @@ enum LogLevel {
 void LogSetLevel(LogLevel level);
 // Get the currently set log level.
 LogLevel LogGetLevel();
+// Returns true if messages at the given level are displayed.
+bool LogIsLoggable(LogLevel level);
 // Log a debug message to the system log.
-void LogDebug(const char* format, ...);
+void LogDebug(const char* format, ...) ABSL_PRINTF_ATTRIBUTE(1, 2);
 // Log an info message to the system log.
-void LogInfo(const char* format, ...);
+void LogInfo(const char* format, ...) ABSL_PRINTF_ATTRIBUTE(1, 2);
 // Log a warning to the system log.
-void LogWarning(const char* format, ...);
+void LogWarning(const char* format, ...) ABSL_PRINTF_ATTRIBUTE(1, 2);
 // Log an error to the system log.
-void LogError(const char* format, ...);
+void LogError(const char* format, ...) ABSL_PRINTF_ATTRIBUTE(1, 2);
 // Log a firebase message (implemented by the platform specific logger).
-void LogMessageV(LogLevel log_level, const char* format, va_list args);
+void LogMessageV(LogLevel log_level, const char* format, va_list args)
+    ABSL_PRINTF_ATTRIBUTE(2, 0);
 // Log a firebase message via LogMessageV().
-void LogMessage(LogLevel log_level, const char* format, ...);
+void LogMessage(LogLevel log_level, const char* format, ...)
+    ABSL_PRINTF_ATTRIBUTE(2, 3);
 
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
 
+// Log a message at the given level, if messages at that level are displayed.
+// Unlike calling LogMessage() directly, the arguments are only evaluated and
+// formatted if the message is displayed, so a disabled LOG_DEBUG in a hot loop
+// costs no more than a check of the level.
+#define LOG_AT_LEVEL(level, ...)                                 \
+  do {                                                           \
+    if (firebase::firestore::util::LogIsLoggable(level)) {       \
+      firebase::firestore::util::LogMessage(level, __VA_ARGS__); \
+    }                                                            \
+  } while (0)
+
+#define LOG_DEBUG(...) \
+  LOG_AT_LEVEL(firebase::firestore::util::kLogLevelDebug, __VA_ARGS__)
+#define LOG_INFO(...) \
+  LOG_AT_LEVEL(firebase::firestore::util::kLogLevelInfo, __VA_ARGS__)
+#define LOG_WARNING(...) \
+  LOG_AT_LEVEL(firebase::firestore::util::kLogLevelWarning, __VA_ARGS__)
+#define LOG_ERROR(...) \
+  LOG_AT_LEVEL(firebase::firestore::util::kLogLevelError, __VA_ARGS__)
+
 #endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_LOG_H_
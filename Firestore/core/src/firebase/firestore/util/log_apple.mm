@@ -74,6 +74,10 @@ LogLevel LogGetLevel() {
   }
 }
 
+bool LogIsLoggable(LogLevel level) {
+  return FIRIsLoggableLevel(ToFIRLoggerLevel(level), NO);
+}
+
 void LogDebug(const char* format, ...) {
   va_list list;
   va_start(list, format);
@@ -33,6 +33,10 @@ LogLevel LogGetLevel() {
   return g_log_level;
 }
 
+bool LogIsLoggable(LogLevel level) {
+  return level >= g_log_level;
+}
+
 void LogDebug(const char* format, ...) {
   va_list list;
   va_start(list, format);
@@ -62,7 +66,7 @@ void LogError(const char* format, ...) {
 }
 
 void LogMessageV(LogLevel log_level, const char* format, va_list args) {
-  if (log_level < g_log_level) {
+  if (!LogIsLoggable(log_level)) {
     return;
   }
   switch (log_level) {
@@ -23,6 +23,12 @@
 #include "Firestore/core/src/firebase/firestore/util/bits.h"
 #include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #define UNALIGNED_LOAD32 ABSL_INTERNAL_UNALIGNED_LOAD32
 #define UNALIGNED_LOAD64 ABSL_INTERNAL_UNALIGNED_LOAD64
 #define UNALIGNED_STORE32 ABSL_INTERNAL_UNALIGNED_STORE32
@@ -119,16 +125,17 @@ inline static int AdvanceIfNoSpecialBytes(uint32_t v_32, const char* p) {
 }
 
 /**
- * Return a pointer to the first byte in the range "[start..limit)"
- * whose value is 0 or 255 (kEscape1 or kEscape2).  If no such byte
- * exists in the range, returns "limit".
+ * The portable implementation of SkipToNextSpecialByte, which tests 8 bytes
+ * at a time. Also used to find the special byte within the block the vector
+ * implementations stop at.
  */
-inline static const char* SkipToNextSpecialByte(const char* start,
-                                                const char* limit) {
+inline static const char* SkipToNextSpecialBytePortable(const char* start,
+                                                        const char* limit) {
   // If these constants were ever changed, this routine needs to change
   FIREBASE_ASSERT(kEscape1 == 0);
   FIREBASE_ASSERT((kEscape2 & 0xff) == 255);
   const char* p = start;
+
   while (p + 8 <= limit) {
     // Find out if any of the next 8 bytes are either 0 or 255 (our
     // two characters that require special handling).  We do this using
@@ -180,12 +187,62 @@ inline static const char* SkipToNextSpecialByte(const char* start,
   return p;
 }
 
+/**
+ * Return a pointer to the first byte in the range "[start..limit)"
+ * whose value is 0 or 255 (kEscape1 or kEscape2).  If no such byte
+ * exists in the range, returns "limit".
+ */
+inline static const char* SkipToNextSpecialByte(const char* start,
+                                                const char* limit) {
+  const char* p = start;
+
+#if defined(__SSE2__)
+  // Test 16 bytes at a time, then use the resulting bit mask to find the
+  // position of the first special byte directly.
+  const __m128i zeros = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi8(static_cast<char>(0xff));
+  while (p + 16 <= limit) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i special =
+        _mm_or_si128(_mm_cmpeq_epi8(v, zeros), _mm_cmpeq_epi8(v, ones));
+    int mask = _mm_movemask_epi8(special);
+    if (mask != 0) {
+      return p + __builtin_ctz(static_cast<unsigned int>(mask));
+    }
+    p += 16;
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  // Test 16 bytes at a time using the same (x + 1) < 2 test as the portable
+  // implementation. NEON
+  // has no cheap equivalent of movemask, so once a block contains a special
+  // byte, fall back to the 8-byte loop to find it.
+  const uint8x16_t one = vdupq_n_u8(1);
+  const uint8x16_t two = vdupq_n_u8(2);
+  while (p + 16 <= limit) {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    uint64x2_t special =
+        vreinterpretq_u64_u8(vcltq_u8(vaddq_u8(v, one), two));
+    if ((vgetq_lane_u64(special, 0) | vgetq_lane_u64(special, 1)) != 0) {
+      break;
+    }
+    p += 16;
+  }
+#endif
+
+  return SkipToNextSpecialBytePortable(p, limit);
+}
+
 // Expose SkipToNextSpecialByte for testing purposes
 const char* OrderedCode::TEST_SkipToNextSpecialByte(const char* start,
                                                     const char* limit) {
   return SkipToNextSpecialByte(start, limit);
 }
 
+const char* OrderedCode::TEST_SkipToNextSpecialBytePortable(
+    const char* start, const char* limit) {
+  return SkipToNextSpecialBytePortable(start, limit);
+}
+
 /**
  * Helper routine to encode "s" and append to "*dest", escaping special
  * characters.
@@ -349,6 +406,40 @@ bool OrderedCode::ReadString(absl::string_view* src, std::string* result) {
   return ReadStringInternal(src, result);
 }
 
+bool OrderedCode::ReadStringView(absl::string_view* src,
+                                 absl::string_view* result,
+                                 std::string* buffer) {
+  if (src->size() < 2) {
+    return false;  // Not enough bytes for the terminator
+  }
+
+  // Fast path: if the first special byte starts the terminator, nothing
+  // needs unescaping and the result can refer to the source.
+  const char* start = src->data();
+  const char* limit = start + src->size() - 1;
+  const char* special = SkipToNextSpecialByte(start, limit);
+  if (special < limit && special[0] == kEscape1 && special[1] == kSeparator) {
+    if (result) {
+      *result = absl::string_view(start, static_cast<size_t>(special - start));
+    }
+    src->remove_prefix(static_cast<size_t>(special + 2 - start));
+    return true;
+  }
+
+  if (!result) {
+    return ReadStringInternal(src, nullptr);
+  }
+
+  FIREBASE_ASSERT(buffer != nullptr);
+  size_t offset = buffer->size();
+  if (!ReadStringInternal(src, buffer)) {
+    buffer->resize(offset);
+    return false;
+  }
+  *result = absl::string_view(buffer->data() + offset, buffer->size() - offset);
+  return true;
+}
+
 bool OrderedCode::ReadNumIncreasing(absl::string_view* src, uint64_t* result) {
   if (src->empty()) {
     return false;  // Not enough bytes
@@ -91,6 +91,20 @@ class OrderedCode {
   static bool ReadNumIncreasing(absl::string_view* src, uint64_t* result);
   static bool ReadSignedNumIncreasing(absl::string_view* src, int64_t* result);
 
+  /**
+   * Reads a string encoded by WriteString() without necessarily copying it.
+   * If the encoded string contains no escaped bytes, "*result" is set to
+   * point directly into "*src". Otherwise the unescaped string is appended to
+   * "*buffer" and "*result" points at the appended bytes, so it is only valid
+   * until "*buffer" is next modified. Either way, "*result" must not outlive
+   * the storage it refers to.
+   *
+   * REQUIRES: buffer is non-NULL if result is non-NULL.
+   */
+  static bool ReadStringView(absl::string_view* src,
+                             absl::string_view* result,
+                             std::string* buffer);
+
   static bool ReadInfinity(absl::string_view* src);
   static bool ReadTrailingString(absl::string_view* src, std::string* result);
 
@@ -115,6 +129,14 @@ class OrderedCode {
   static const char* TEST_SkipToNextSpecialByte(const char* start,
                                                 const char* limit);
 
+  /**
+   * Helper for testing and benchmarking: the same as
+   * TEST_SkipToNextSpecialByte, but always using the portable 8-byte-at-a-time
+   * scan rather than SSE2 or NEON.
+   */
+  static const char* TEST_SkipToNextSpecialBytePortable(const char* start,
+                                                        const char* limit);
+
   // Not an instantiable class, but the class exists to make it easy to
   // use with a single using statement.
   OrderedCode() = delete;
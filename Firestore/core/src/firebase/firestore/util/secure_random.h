@@ -17,8 +17,11 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_SECURE_RANDOM_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_SECURE_RANDOM_H_
 
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
+#include <algorithm>
 #include <limits>
 
 namespace firebase {
@@ -35,7 +38,9 @@ namespace util {
 //
 // The implementation satisfies the C++11 UniformRandomBitGenerator concept and
 // delegates to an implementation that generates high quality random values
-// quickly with periodic reseeding.
+// quickly with periodic reseeding. Values are drawn from the implementation a
+// buffer at a time, so an instance must not be used from more than one thread
+// at once.
 class SecureRandom {
  public:
   // C++11 UniformRandomBitGenerator interface
@@ -49,7 +54,37 @@ class SecureRandom {
     return std::numeric_limits<result_type>::max();
   }
 
-  result_type operator()();
+  result_type operator()() {
+    result_type result;
+    Fill(&result, sizeof(result));
+    return result;
+  }
+
+  /**
+   * Fills the given buffer with random bytes. Requests smaller than the
+   * internal buffer are served from it, refilling it from the underlying
+   * generator as needed, so that small requests don't each pay for a call
+   * into the generator.
+   */
+  void Fill(void* dest, size_t size) {
+    if (size >= kBufferSize) {
+      FillFromSource(dest, size);
+      return;
+    }
+
+    uint8_t* out = static_cast<uint8_t*>(dest);
+    while (size > 0) {
+      if (available_ == 0) {
+        FillFromSource(buffer_, kBufferSize);
+        available_ = kBufferSize;
+      }
+      size_t chunk = std::min(size, available_);
+      memcpy(out, buffer_ + kBufferSize - available_, chunk);
+      available_ -= chunk;
+      out += chunk;
+      size -= chunk;
+    }
+  }
 
   /** Returns a uniformly distributed pseudorandom integer in [0, n). */
   inline result_type Uniform(result_type n) {
@@ -66,6 +101,17 @@ class SecureRandom {
   inline bool OneIn(result_type n) {
     return Uniform(n) == 0;
   }
+
+ private:
+  static constexpr size_t kBufferSize = 64;
+
+  // Fills the given buffer directly from the platform's generator.
+  void FillFromSource(void* dest, size_t size);
+
+  uint8_t buffer_[kBufferSize];
+
+  // The number of bytes at the end of buffer_ that haven't been handed out.
+  size_t available_ = 0;
 };
 
 }  // namespace util
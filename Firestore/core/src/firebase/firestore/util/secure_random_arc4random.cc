@@ -26,8 +26,8 @@ namespace firebase {
 namespace firestore {
 namespace util {
 
-SecureRandom::result_type SecureRandom::operator()() {
-  return arc4random();
+void SecureRandom::FillFromSource(void* dest, size_t size) {
+  arc4random_buf(dest, size);
 }
 
 }  // namespace util
@@ -27,16 +27,14 @@ namespace firebase {
 namespace firestore {
 namespace util {
 
-SecureRandom::result_type SecureRandom::operator()() {
-  result_type result;
-  int rc = RAND_bytes(reinterpret_cast<uint8_t*>(&result), sizeof(result));
+void SecureRandom::FillFromSource(void* dest, size_t size) {
+  int rc = RAND_bytes(static_cast<uint8_t*>(dest), static_cast<int>(size));
   if (rc <= 0) {
     // OpenSSL's RAND_bytes can fail if there's not enough entropy. BoringSSL
     // won't fail this way.
     ERR_print_errors_fp(stderr);
     abort();
   }
-  return result;
 }
 
 }  // namespace util
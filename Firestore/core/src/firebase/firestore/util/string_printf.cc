@@ -18,13 +18,85 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+
 namespace firebase {
 namespace firestore {
 namespace util {
 
+namespace {
+
+// The size of the stack buffer StringAppendV tries first.
+const int kSpaceLength = 1024;
+
+}  // namespace
+
+void StringAppendVWithHint(std::string* dst,
+                           size_t size_hint,
+                           const char* format,
+                           va_list ap) {
+  size_t initial_size = dst->size();
+
+  // Make room for the hinted output plus vsnprintf's closing \0, growing
+  // geometrically so that repeated appends stay amortized linear.
+  size_t wanted = initial_size + size_hint + 1;
+  if (dst->capacity() < wanted) {
+    dst->reserve(std::max(wanted, 2 * dst->capacity()));
+  }
+
+  // Format straight into all of the spare capacity.
+  dst->resize(dst->capacity());
+  size_t buf_remain = dst->size() - initial_size;
+
+  va_list backup_ap;
+  va_copy(backup_ap, ap);
+  int result = vsnprintf(&(*dst)[initial_size], buf_remain, format, backup_ap);
+  va_end(backup_ap);
+
+#ifdef _MSC_VER
+  if (result < 0) {
+    // Error or MSVC running out of space; ask for the space needed.
+    va_copy(backup_ap, ap);
+    result = vsnprintf(nullptr, 0, format, backup_ap);
+    va_end(backup_ap);
+  }
+#endif
+
+  if (result < 0) {
+    // Just an error. Leave the original string unchanged.
+    dst->resize(initial_size);
+    return;
+  }
+  size_t result_size = static_cast<size_t>(result);
+  if (result_size < buf_remain) {
+    // Normal case -- everything fit.
+    dst->resize(initial_size + result_size);
+    return;
+  }
+
+  // The hint was too small, but now the exact size is known: format again
+  // into space sized to fit, plus one for the closing \0.
+  dst->resize(initial_size + result_size + 1);
+  va_copy(backup_ap, ap);
+  result = vsnprintf(&(*dst)[initial_size], result_size + 1, format, backup_ap);
+  va_end(backup_ap);
+
+  if (result >= 0 && static_cast<size_t>(result) == result_size) {
+    dst->resize(initial_size + result_size);
+  } else {
+    dst->resize(initial_size);
+  }
+}
+
 void StringAppendV(std::string* dst, const char* format, va_list ap) {
+  if (dst->capacity() - dst->size() >= static_cast<size_t>(kSpaceLength)) {
+    // The string's spare capacity holds at least as much as the stack buffer
+    // would, so format into it directly and skip the copy.
+    StringAppendVWithHint(dst, 0, format, ap);
+    return;
+  }
+
   // First try with a small fixed size buffer
-  static const int kSpaceLength = 1024;
   char space[kSpaceLength];
 
   // It's possible for methods that use a va_list to invalidate
@@ -97,6 +169,16 @@ void StringAppendF(std::string* dst, const char* format, ...) {
   va_end(ap);
 }
 
+void StringAppendFWithHint(std::string* dst,
+                           size_t size_hint,
+                           const char* format,
+                           ...) {
+  va_list ap;
+  va_start(ap, format);
+  StringAppendVWithHint(dst, size_hint, format, ap);
+  va_end(ap);
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_STRING_PRINTF_H_
 
 #include <stdarg.h>
+#include <stddef.h>
 
 #include <string>
 
@@ -34,12 +35,31 @@ std::string StringPrintf(const char* format, ...) ABSL_PRINTF_ATTRIBUTE(1, 2);
 void StringAppendF(std::string* dst, const char* format, ...)
     ABSL_PRINTF_ATTRIBUTE(2, 3);
 
+/**
+ * Appends the result to a supplied string, formatting directly into the
+ * string's spare capacity rather than through an intermediate buffer.
+ *
+ * @param size_hint The expected length of the formatted output. If the string
+ *     lacks room for that many more characters it grows geometrically, so
+ *     that output no longer than the hint is formatted in a single pass.
+ */
+void StringAppendFWithHint(std::string* dst,
+                           size_t size_hint,
+                           const char* format,
+                           ...) ABSL_PRINTF_ATTRIBUTE(3, 4);
+
 /**
  * Lower-level routine that takes a va_list and appends to a specified
  * string.  All other routines are just convenience wrappers around it.
  */
 void StringAppendV(std::string* dst, const char* format, va_list ap);
 
+/** The va_list counterpart of StringAppendFWithHint. */
+void StringAppendVWithHint(std::string* dst,
+                           size_t size_hint,
+                           const char* format,
+                           va_list ap);
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2017 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+std::atomic<TraceBuffer*> trace_buffer{nullptr};
+
+int64_t NowMicros() {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  using std::chrono::system_clock;
+  return duration_cast<microseconds>(system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+TraceBuffer::TraceBuffer(size_t capacity)
+    : capacity_(capacity), slots_(new Slot[capacity]) {
+  FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+      capacity > 0, capacity > 0, "TraceBuffer must hold at least one record");
+}
+
+void TraceBuffer::Record(uint32_t event,
+                         int64_t arg0,
+                         int64_t arg1,
+                         int64_t arg2) {
+  uint64_t index = next_.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = slots_[index % capacity_];
+
+  slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot.timestamp_micros.store(NowMicros(), std::memory_order_relaxed);
+  slot.event.store(event, std::memory_order_relaxed);
+  slot.args[0].store(arg0, std::memory_order_relaxed);
+  slot.args[1].store(arg1, std::memory_order_relaxed);
+  slot.args[2].store(arg2, std::memory_order_relaxed);
+
+  // Indexes start at zero, so a complete record's sequence is never zero.
+  slot.sequence.store(index * 2 + 2, std::memory_order_release);
+}
+
+std::vector<TraceRecord> TraceBuffer::Snapshot() const {
+  uint64_t end = next_.load(std::memory_order_acquire);
+  uint64_t begin = end > capacity_ ? end - capacity_ : 0;
+
+  std::vector<TraceRecord> result;
+  result.reserve(static_cast<size_t>(end - begin));
+  for (uint64_t index = begin; index < end; index++) {
+    const Slot& slot = slots_[index % capacity_];
+    uint64_t expected = index * 2 + 2;
+    if (slot.sequence.load(std::memory_order_acquire) != expected) {
+      continue;
+    }
+
+    TraceRecord record;
+    record.timestamp_micros =
+        slot.timestamp_micros.load(std::memory_order_relaxed);
+    record.event = slot.event.load(std::memory_order_relaxed);
+    for (int i = 0; i < 3; i++) {
+      record.args[i] = slot.args[i].load(std::memory_order_relaxed);
+    }
+
+    // If the slot was claimed by a newer record while reading, the fields may
+    // be a mix of both records.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) == expected) {
+      result.push_back(record);
+    }
+  }
+  return result;
+}
+
+bool TraceBuffer::WriteTo(FILE* file) const {
+  std::vector<TraceRecord> records = Snapshot();
+  if (records.empty()) {
+    return true;
+  }
+  return fwrite(records.data(), sizeof(TraceRecord), records.size(), file) ==
+         records.size();
+}
+
+void SetTraceBuffer(TraceBuffer* buffer) {
+  trace_buffer.store(buffer, std::memory_order_release);
+}
+
+TraceBuffer* GetTraceBuffer() {
+  return trace_buffer.load(std::memory_order_acquire);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2017 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/** The events that Firestore components record with Trace(). */
+enum TraceEvent : uint32_t {
+  /** A stream started connecting. arg0: the TraceStream. */
+  kTraceStreamStart = 1,
+  /** A stream received a message. arg0: the TraceStream, arg1: its size. */
+  kTraceStreamMessage,
+  /** A stream closed. arg0: the TraceStream, arg1: the error code or 0. */
+  kTraceStreamClose,
+
+  /** The local store started writing a batch. arg0: the mutation count. */
+  kTraceLocalWriteStart,
+  /** The local store finished writing a batch. arg0: the batch ID. */
+  kTraceLocalWriteFinish,
+  /** The local store started applying a remote event. arg0: the doc count. */
+  kTraceRemoteEventStart,
+  /** The local store finished applying a remote event. */
+  kTraceRemoteEventFinish,
+
+  /** The sync engine started listening to a query. arg0: the target ID. */
+  kTraceListen,
+  /** The sync engine stopped listening to a query. arg0: the target ID. */
+  kTraceUnlisten,
+};
+
+/** The streams identified in stream events. */
+enum TraceStream : int64_t {
+  kTraceStreamWatch = 0,
+  kTraceStreamWrite = 1,
+};
+
+/** A fixed-size binary record of a traced event. */
+struct TraceRecord {
+  /** When the event happened, in microseconds since the Unix epoch. */
+  int64_t timestamp_micros;
+  /** The TraceEvent. */
+  uint32_t event;
+  /** Event-specific arguments, or zero when unused. */
+  int64_t args[3];
+};
+
+/**
+ * A ring buffer of the most recent TraceRecords.
+ *
+ * Recording is lock-free and safe from any thread: writers claim a slot with
+ * a single atomic increment, and each slot carries a sequence number so that
+ * readers skip records that are being overwritten, in the manner of a
+ * seqlock. Once the buffer is full, new records overwrite the oldest ones.
+ */
+class TraceBuffer {
+ public:
+  static const size_t kDefaultCapacity = 4096;
+
+  explicit TraceBuffer(size_t capacity = kDefaultCapacity);
+
+  /** Records an event with the current time. */
+  void Record(uint32_t event,
+              int64_t arg0 = 0,
+              int64_t arg1 = 0,
+              int64_t arg2 = 0);
+
+  /**
+   * Returns the records currently in the buffer, oldest first. Records being
+   * written concurrently are left out.
+   */
+  std::vector<TraceRecord> Snapshot() const;
+
+  /**
+   * Writes the records returned by Snapshot() to the given file, as the
+   * in-memory bytes of each TraceRecord. Returns false if writing fails.
+   */
+  bool WriteTo(FILE* file) const;
+
+ private:
+  struct Slot {
+    // Twice the index of the record in the slot, plus one while the record
+    // is being written. Zero for a slot that was never written.
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<int64_t> timestamp_micros{0};
+    std::atomic<uint32_t> event{0};
+    std::atomic<int64_t> args[3];
+  };
+
+  size_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<uint64_t> next_{0};
+};
+
+/**
+ * Sets the buffer that Trace() records into, or nullptr to stop tracing,
+ * which is the default. The buffer is not owned, and must stay alive until no
+ * Trace() call that may have seen it can still be running.
+ */
+void SetTraceBuffer(TraceBuffer* buffer);
+
+/** Returns the buffer set by SetTraceBuffer(), if any. */
+TraceBuffer* GetTraceBuffer();
+
+/**
+ * Records an event in the current trace buffer. When tracing is off, this
+ * costs a single atomic load.
+ */
+inline void Trace(uint32_t event,
+                  int64_t arg0 = 0,
+                  int64_t arg1 = 0,
+                  int64_t arg2 = 0) {
+  TraceBuffer* buffer = GetTraceBuffer();
+  if (buffer) {
+    buffer->Record(event, arg0, arg1, arg2);
+  }
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACE_H_
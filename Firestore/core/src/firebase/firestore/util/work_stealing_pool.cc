@@ -0,0 +1,133 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/work_stealing_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/firebase_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+constexpr size_t WorkStealingPool::kNotAWorker;
+
+WorkStealingPool::WorkStealingPool(size_t thread_count) {
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  workers_.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; ++i) {
+    workers_.emplace_back(new Worker());
+  }
+  threads_.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads_.emplace_back([this, i] { Run(i); });
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  FIREBASE_ASSERT_MESSAGE_WITH_EXPRESSION(
+      CurrentWorker() == kNotAWorker, CurrentWorker() == kNotAWorker,
+      "WorkStealingPool must not be destroyed from one of its threads");
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutting_down_ = true;
+  }
+  available_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkStealingPool::Submit(Task&& task) {
+  size_t index = CurrentWorker();
+  if (index == kNotAWorker) {
+    index = next_worker_.fetch_add(1) % workers_.size();
+  }
+  {
+    Worker& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tasks.push_back(std::move(task));
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  unclaimed_tasks_ += 1;
+  available_.notify_one();
+}
+
+size_t WorkStealingPool::CurrentWorker() const {
+  // Pools are small, so a linear search beats the alternatives, which include
+  // thread_local, unavailable before iOS 9.
+  std::thread::id current = std::this_thread::get_id();
+  for (size_t i = 0; i < threads_.size(); ++i) {
+    if (threads_[i].get_id() == current) {
+      return i;
+    }
+  }
+  return kNotAWorker;
+}
+
+void WorkStealingPool::Run(const size_t index) {
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      available_.wait(
+          lock, [this] { return unclaimed_tasks_ > 0 || shutting_down_; });
+      if (unclaimed_tasks_ == 0) {
+        return;
+      }
+      unclaimed_tasks_ -= 1;
+    }
+
+    // Every claim is backed by a task that was pushed before it was counted,
+    // and only claimed tasks are taken, so this finds one.
+    Task task;
+    while (!TryTake(index, &task)) {
+      std::this_thread::yield();
+    }
+    task();
+  }
+}
+
+bool WorkStealingPool::TryTake(const size_t index, Task* task) {
+  {
+    Worker& own = *workers_[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      *task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    Worker& victim = *workers_[(index + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      *task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_WORK_STEALING_POOL_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_WORK_STEALING_POOL_H_
+
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>   // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * A fixed-size pool of threads for CPU-bound tasks that don't need to run
+ * serially, such as decoding protos or matching documents against queries.
+ *
+ * Each thread has its own deque of tasks. A task submitted from one of the
+ * pool's threads goes to that thread's deque, where it's likely to find warm
+ * caches; other tasks are spread over the deques round-robin. Threads run
+ * their own tasks newest first and, once their deque is empty, steal the
+ * oldest tasks of the other threads.
+ *
+ * Tasks must not block waiting for other tasks in the pool.
+ */
+class WorkStealingPool {
+ public:
+  using Task = std::function<void()>;
+
+  /**
+   * Creates a pool with the given number of threads, or one per hardware
+   * thread if zero.
+   */
+  explicit WorkStealingPool(size_t thread_count = 0);
+
+  /**
+   * Runs the tasks that have been submitted but haven't started yet, then
+   * joins the threads. Must not be called from one of the pool's threads.
+   */
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool& other) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool& other) = delete;
+
+  /** Schedules the task to run on one of the pool's threads. */
+  void Submit(Task&& task);
+
+  size_t thread_count() const {
+    return threads_.size();
+  }
+
+ private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  static constexpr size_t kNotAWorker = static_cast<size_t>(-1);
+
+  /** Returns the index of the current thread in the pool, or kNotAWorker. */
+  size_t CurrentWorker() const;
+
+  void Run(size_t index);
+
+  /**
+   * Takes a task from the back of the given worker's deque or, failing that,
+   * from the front of another's.
+   */
+  bool TryTake(size_t index, Task* task);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  std::atomic<size_t> next_worker_{0};
+
+  std::mutex mutex_;
+  std::condition_variable available_;
+  /** The number of submitted tasks no thread has claimed yet. */
+  size_t unclaimed_tasks_ = 0;
+  bool shutting_down_ = false;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_WORK_STEALING_POOL_H_
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/immutable/array_sorted_map.h"
+
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+using IntMap = ArraySortedMap<int, int>;
+
+/** Returns a map of the even numbers in [0, 2 * size), each mapped to itself. */
+static IntMap EvenMap(int size) {
+  std::vector<std::pair<int, int>> entries;
+  for (int i = 0; i < size; i++) {
+    entries.emplace_back(i * 2, i * 2);
+  }
+  return IntMap::CreateFromSorted(entries.begin(), entries.end());
+}
+
+// Builds a map one insert at a time, up to the fixed capacity of an
+// ArraySortedMap.
+static void BM_ArraySortedMapInsert(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    IntMap map;
+    for (int i = 0; i < size; i++) {
+      map = map.insert(i, i);
+    }
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_ArraySortedMapInsert)->Arg(1)->Arg(8)->Arg(IntMap::kFixedSize);
+
+static void BM_ArraySortedMapFind(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  IntMap map = EvenMap(size);
+  for (auto _ : state) {
+    // Look up every key that's present and every key between them.
+    for (int i = 0; i < size * 2; i++) {
+      benchmark::DoNotOptimize(map.find(i));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * size * 2);
+}
+BENCHMARK(BM_ArraySortedMapFind)->Arg(1)->Arg(8)->Arg(IntMap::kFixedSize);
+
+static void BM_ArraySortedMapErase(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  IntMap map = EvenMap(size);
+  for (auto _ : state) {
+    for (int i = 0; i < size; i++) {
+      IntMap erased = map.erase(i * 2);
+      benchmark::DoNotOptimize(erased);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_ArraySortedMapErase)->Arg(1)->Arg(8)->Arg(IntMap::kFixedSize);
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
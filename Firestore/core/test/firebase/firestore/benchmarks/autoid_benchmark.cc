@@ -0,0 +1,48 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/autoid.h"
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+static void BM_CreateAutoId(benchmark::State& state) {
+  for (auto _ : state) {
+    std::string auto_id = CreateAutoId();
+    benchmark::DoNotOptimize(auto_id);
+  }
+}
+BENCHMARK(BM_CreateAutoId);
+
+static void BM_CreateAutoIds(benchmark::State& state) {
+  size_t count = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    std::vector<std::string> auto_ids = CreateAutoIds(count);
+    benchmark::DoNotOptimize(auto_ids);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CreateAutoIds)->Arg(10)->Arg(1000);
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+/** Returns an object value with `size` string fields. */
+static FieldValue MakeObject(int size) {
+  FieldValue::Map map;
+  for (int i = 0; i < size; i++) {
+    map = map.insert("field" + std::to_string(i),
+                     FieldValue::StringValue("value" + std::to_string(i)));
+  }
+  return FieldValue::ObjectValue(map);
+}
+
+/** Returns an array value with `size` integer elements. */
+static FieldValue MakeArray(int size) {
+  std::vector<FieldValue> values;
+  for (int i = 0; i < size; i++) {
+    values.push_back(FieldValue::IntegerValue(i));
+  }
+  return FieldValue::ArrayValue(std::move(values));
+}
+
+static void BM_FieldValueIntegerValue(benchmark::State& state) {
+  int64_t i = 0;
+  for (auto _ : state) {
+    FieldValue value = FieldValue::IntegerValue(i++);
+    benchmark::DoNotOptimize(value);
+  }
+}
+BENCHMARK(BM_FieldValueIntegerValue);
+
+static void BM_FieldValueStringValue(benchmark::State& state) {
+  std::string str(static_cast<size_t>(state.range(0)), 'a');
+  for (auto _ : state) {
+    FieldValue value = FieldValue::StringValue(str);
+    benchmark::DoNotOptimize(value);
+  }
+}
+BENCHMARK(BM_FieldValueStringValue)->Arg(8)->Arg(1024);
+
+static void BM_FieldValueObjectValue(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    FieldValue value = MakeObject(size);
+    benchmark::DoNotOptimize(value);
+  }
+}
+BENCHMARK(BM_FieldValueObjectValue)->Arg(1)->Arg(10)->Arg(100);
+
+static void BM_FieldValueCopyArray(benchmark::State& state) {
+  FieldValue original = MakeArray(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    FieldValue copy = original;
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_FieldValueCopyArray)->Arg(1)->Arg(10)->Arg(100);
+
+static void BM_FieldValueCopyObject(benchmark::State& state) {
+  FieldValue original = MakeObject(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    FieldValue copy = original;
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(BM_FieldValueCopyObject)->Arg(1)->Arg(10)->Arg(100);
+
+// Compares two equal values, so that every element has to be visited.
+static void BM_FieldValueCompareArray(benchmark::State& state) {
+  FieldValue lhs = MakeArray(static_cast<int>(state.range(0)));
+  FieldValue rhs = MakeArray(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs < rhs);
+  }
+}
+BENCHMARK(BM_FieldValueCompareArray)->Arg(1)->Arg(10)->Arg(100);
+
+static void BM_FieldValueCompareObject(benchmark::State& state) {
+  FieldValue lhs = MakeObject(static_cast<int>(state.range(0)));
+  FieldValue rhs = MakeObject(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs < rhs);
+  }
+}
+BENCHMARK(BM_FieldValueCompareObject)->Arg(1)->Arg(10)->Arg(100);
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+
+#include <cstdint>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+static void BM_OrderedCodeWriteString(benchmark::State& state) {
+  std::string value(static_cast<size_t>(state.range(0)), 'a');
+  for (auto _ : state) {
+    std::string dest;
+    OrderedCode::WriteString(&dest, value);
+    benchmark::DoNotOptimize(dest);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OrderedCodeWriteString)->Arg(8)->Arg(64)->Arg(1024);
+
+static void BM_OrderedCodeReadString(benchmark::State& state) {
+  std::string encoded;
+  OrderedCode::WriteString(
+      &encoded, std::string(static_cast<size_t>(state.range(0)), 'a'));
+  for (auto _ : state) {
+    absl::string_view src = encoded;
+    std::string result;
+    bool ok = OrderedCode::ReadString(&src, &result);
+    benchmark::DoNotOptimize(ok);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OrderedCodeReadString)->Arg(8)->Arg(64)->Arg(1024);
+
+// Scans a run of ordinary bytes, the inner loop of ReadString. Compare with
+// BM_OrderedCodeSkipToNextSpecialBytePortable to see what the SSE2 or NEON
+// scan gains on this machine.
+static void BM_OrderedCodeSkipToNextSpecialByte(benchmark::State& state) {
+  std::string value(static_cast<size_t>(state.range(0)), 'a');
+  const char* limit = value.data() + value.size();
+  for (auto _ : state) {
+    const char* p =
+        OrderedCode::TEST_SkipToNextSpecialByte(value.data(), limit);
+    benchmark::DoNotOptimize(p);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OrderedCodeSkipToNextSpecialByte)->Arg(16)->Arg(64)->Arg(1024);
+
+static void BM_OrderedCodeSkipToNextSpecialBytePortable(
+    benchmark::State& state) {
+  std::string value(static_cast<size_t>(state.range(0)), 'a');
+  const char* limit = value.data() + value.size();
+  for (auto _ : state) {
+    const char* p =
+        OrderedCode::TEST_SkipToNextSpecialBytePortable(value.data(), limit);
+    benchmark::DoNotOptimize(p);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OrderedCodeSkipToNextSpecialBytePortable)
+    ->Arg(16)
+    ->Arg(64)
+    ->Arg(1024);
+
+static void BM_OrderedCodeWriteSignedNumIncreasing(benchmark::State& state) {
+  int64_t value = state.range(0);
+  for (auto _ : state) {
+    std::string dest;
+    OrderedCode::WriteSignedNumIncreasing(&dest, value);
+    benchmark::DoNotOptimize(dest);
+  }
+}
+BENCHMARK(BM_OrderedCodeWriteSignedNumIncreasing)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(INT32_MAX);
+
+static void BM_OrderedCodeReadSignedNumIncreasing(benchmark::State& state) {
+  std::string encoded;
+  OrderedCode::WriteSignedNumIncreasing(&encoded, state.range(0));
+  for (auto _ : state) {
+    absl::string_view src = encoded;
+    int64_t result;
+    bool ok = OrderedCode::ReadSignedNumIncreasing(&src, &result);
+    benchmark::DoNotOptimize(ok);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_OrderedCodeReadSignedNumIncreasing)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(INT32_MAX);
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
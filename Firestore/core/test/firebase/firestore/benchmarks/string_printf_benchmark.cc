@@ -0,0 +1,63 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/string_printf.h"
+
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+static void BM_StringPrintfShort(benchmark::State& state) {
+  for (auto _ : state) {
+    std::string result = StringPrintf("%s/%d", "rooms", 42);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_StringPrintfShort);
+
+// Formats string arguments of increasing length. Results that don't fit in
+// StringPrintf's stack buffer are formatted a second time into the heap.
+static void BM_StringPrintfLong(benchmark::State& state) {
+  std::string arg(static_cast<size_t>(state.range(0)), 'a');
+  for (auto _ : state) {
+    std::string result = StringPrintf("value: %s", arg.c_str());
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StringPrintfLong)->Arg(16)->Arg(1024)->Arg(64 * 1024);
+
+// Formats the same arguments as BM_StringPrintfLong, but with a hint that lets
+// long results be formatted once, directly into the string.
+static void BM_StringAppendFWithHint(benchmark::State& state) {
+  size_t size = static_cast<size_t>(state.range(0));
+  std::string arg(size, 'a');
+  for (auto _ : state) {
+    std::string result;
+    StringAppendFWithHint(&result, size + 7, "value: %s", arg.c_str());
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StringAppendFWithHint)->Arg(16)->Arg(1024)->Arg(64 * 1024);
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
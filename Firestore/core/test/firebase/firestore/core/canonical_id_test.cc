@@ -0,0 +1,65 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/canonical_id.h"
+
+#include <limits>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+TEST(CanonicalIdFingerprint, MatchesFnv1a) {
+  EXPECT_EQ(14695981039346656037ULL, CanonicalIdFingerprint(""));
+  EXPECT_EQ(0xaf63dc4c8601ec8cULL, CanonicalIdFingerprint("a"));
+  EXPECT_EQ(0x85944171f73967e8ULL, CanonicalIdFingerprint("foobar"));
+}
+
+TEST(CanonicalIdBuilder, Appends) {
+  CanonicalIdBuilder builder;
+  builder.Append("rooms/eros").Append("|f:").Append("a==");
+  builder.AppendInteger(1);
+  builder.AppendF("|l:%d", 10);
+  EXPECT_EQ("rooms/eros|f:a==1|l:10", builder.id());
+  EXPECT_EQ(CanonicalIdFingerprint(builder.id()), builder.Fingerprint());
+}
+
+TEST(CanonicalIdBuilder, AppendsIntegers) {
+  CanonicalIdBuilder builder;
+  builder.AppendInteger(0).Append(",").AppendInteger(-42).Append(",");
+  builder.AppendInteger(std::numeric_limits<int64_t>::max()).Append(",");
+  builder.AppendInteger(std::numeric_limits<int64_t>::min());
+  EXPECT_EQ("0,-42,9223372036854775807,-9223372036854775808", builder.id());
+}
+
+TEST(CanonicalIdBuilder, ClearReusesBuffer) {
+  CanonicalIdBuilder builder;
+  builder.Append(std::string(100, 'a'));
+  size_t capacity = builder.id().capacity();
+
+  builder.Clear();
+  EXPECT_EQ("", builder.id());
+  builder.Append("rooms");
+  EXPECT_EQ("rooms", builder.id());
+  EXPECT_EQ(capacity, builder.id().capacity());
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
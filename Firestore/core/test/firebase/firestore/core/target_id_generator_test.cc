@@ -75,6 +75,32 @@ TEST(TargetIdGenerator, Increment) {
   EXPECT_EQ(53, d.NextId());
 }
 
+TEST(TargetIdGenerator, ReservesBlocks) {
+  TargetIdGenerator a = TargetIdGenerator::LocalStoreTargetIdGenerator(0);
+  EXPECT_TRUE(a.NeedsReservation());
+  EXPECT_EQ(6, a.ReserveBlock(3));
+  EXPECT_FALSE(a.NeedsReservation());
+  EXPECT_EQ(2, a.NextId());
+  EXPECT_EQ(4, a.NextId());
+  EXPECT_FALSE(a.NeedsReservation());
+  EXPECT_EQ(6, a.NextId());
+  EXPECT_TRUE(a.NeedsReservation());
+  EXPECT_EQ(10, a.ReserveBlock(2));
+  EXPECT_EQ(8, a.NextId());
+
+  // A generator seeded with the end of the last block skips its unused IDs.
+  TargetIdGenerator b = TargetIdGenerator::LocalStoreTargetIdGenerator(10);
+  EXPECT_TRUE(b.NeedsReservation());
+  EXPECT_EQ(14, b.ReserveBlock(2));
+  EXPECT_EQ(12, b.NextId());
+
+  TargetIdGenerator c = TargetIdGenerator::SyncEngineTargetIdGenerator(0);
+  EXPECT_EQ(3, c.ReserveBlock(2));
+  EXPECT_EQ(1, c.NextId());
+  EXPECT_EQ(3, c.NextId());
+  EXPECT_TRUE(c.NeedsReservation());
+}
+
 }  //  namespace core
 }  //  namespace firestore
 }  //  namespace firebase
@@ -18,8 +18,12 @@
 
 #include <numeric>
 #include <random>
+#include <string>
 
-#include "Firestore/core/src/firebase/firestore/util/secure_random.h"
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/test/firebase/firestore/immutable/testutil.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_counter.h"
+#include "absl/strings/string_view.h"
 #include "gtest/gtest.h"
 
 namespace firebase {
@@ -29,122 +33,49 @@ namespace immutable {
 typedef ArraySortedMap<int, int> IntMap;
 constexpr IntMap::size_type kFixedSize = IntMap::kFixedSize;
 
-template <typename K, typename V>
-testing::AssertionResult NotFound(const ArraySortedMap<K, V>& set,
-                                  const K& key) {
-  auto found = set.find(key);
-  if (found == set.end()) {
-    return testing::AssertionSuccess();
-  } else {
-    return testing::AssertionFailure()
-           << "Should not have found (" << found->first << ", " << found->second
-           << ") @ " << found;
-  }
-}
-
-template <typename K, typename V>
-testing::AssertionResult Found(const ArraySortedMap<K, V>& map,
-                               const K& key,
-                               const V& expected) {
-  auto found = map.find(key);
-  if (found == map.end()) {
-    return testing::AssertionFailure() << "Did not find key " << key;
-  }
-  if (found->second == expected) {
-    return testing::AssertionSuccess();
-  } else {
-    return testing::AssertionFailure() << "Found entry was (" << found->first
-                                       << ", " << found->second << ")";
-  }
-}
-
 /**
- * Creates a vector containing a sequence of integers from the given starting
- * element up to, but not including, the given end element, with values
- * incremented by the given step.
- *
- * If step is negative the sequence is in descending order (but still starting
- * at start and ending before end).
+ * Creates an ArraySortedMap by inserting a pair for each value in the vector.
+ * Each pair will have the same key and value.
  */
-std::vector<int> Sequence(int start, int end, int step = 1) {
-  std::vector<int> result;
-  if (step > 0) {
-    for (int i = start; i < end; i += step) {
-      result.push_back(i);
-    }
-  } else {
-    for (int i = start; i > end; i += step) {
-      result.push_back(i);
-    }
-  }
-  return result;
+IntMap ToMap(const std::vector<int>& values) {
+  return immutable::ToMap<IntMap>(values);
 }
 
-/**
- * Creates a vector containing a sequence of integers with the given number of
- * elements, from zero up to, but not including the given value.
- */
-std::vector<int> Sequence(int num_elements) {
-  return Sequence(0, num_elements);
-}
+/** A value that keeps count of its live instances and of its copies. */
+class Counted {
+ public:
+  explicit Counted(int value) : value_(value) {
+    ++live;
+  }
 
-/**
- * Creates a copy of the given vector with contents shuffled randomly.
- */
-std::vector<int> Shuffled(const std::vector<int>& values) {
-  std::vector<int> result(values);
-  util::SecureRandom rng;
-  std::shuffle(result.begin(), result.end(), rng);
-  return result;
-}
+  Counted(const Counted& other) : value_(other.value_) {
+    ++live;
+    ++copies;
+  }
 
-/**
- * Creates a copy of the given vector with contents sorted.
- */
-std::vector<int> Sorted(const std::vector<int>& values) {
-  std::vector<int> result(values);
-  std::sort(result.begin(), result.end());
-  return result;
-}
+  Counted(Counted&& other) : value_(other.value_) {
+    ++live;
+  }
 
-/**
- * Creates a vector of pairs where each pair has the same first and second
- * corresponding to an element in the given vector.
- */
-std::vector<std::pair<int, int>> Pairs(const std::vector<int>& values) {
-  std::vector<std::pair<int, int>> result;
-  for (auto&& value : values) {
-    result.emplace_back(value, value);
+  ~Counted() {
+    --live;
   }
-  return result;
-}
 
-/**
- * Creates an ArraySortedMap by inserting a pair for each value in the vector.
- * Each pair will have the same key and value.
- */
-IntMap ToMap(const std::vector<int>& values) {
-  IntMap result;
-  for (auto&& value : values) {
-    result = result.insert(value, value);
+  bool operator==(const Counted& other) const {
+    return value_ == other.value_;
   }
-  return result;
-}
 
-/**
- * Appends the contents of the given container to a new vector.
- */
-template <typename Container>
-std::vector<typename Container::value_type> Append(const Container& container) {
-  std::vector<typename Container::value_type> result;
-  result.insert(result.begin(), container.begin(), container.end());
-  return result;
-}
+  static int live;
+  static int copies;
 
-// TODO(wilhuff): ReverseTraversal
+ private:
+  int value_;
+};
 
-#define ASSERT_SEQ_EQ(x, y) ASSERT_EQ((x), Append(y));
-#define EXPECT_SEQ_EQ(x, y) EXPECT_EQ((x), Append(y));
+int Counted::live = 0;
+int Counted::copies = 0;
+
+// TODO(wilhuff): ReverseTraversal
 
 TEST(ArraySortedMap, SearchForSpecificKey) {
   IntMap map{{1, 3}, {2, 4}};
@@ -305,6 +236,13 @@ TEST(ArraySortedMap, BalanceProblem) {
 
 // TODO(wilhuff): IndexOf
 
+TEST(ArraySortedMap, CreateFromSorted) {
+  std::vector<std::pair<int, int>> entries = Pairs(Sequence(kFixedSize));
+  IntMap map = IntMap::CreateFromSorted(entries.begin(), entries.end());
+  ASSERT_EQ(kFixedSize, map.size());
+  ASSERT_SEQ_EQ(entries, map);
+}
+
 TEST(ArraySortedMap, AvoidsCopying) {
   IntMap map = IntMap().insert(10, 20);
   auto found = map.find(10);
@@ -321,6 +259,82 @@ TEST(ArraySortedMap, AvoidsCopying) {
   EXPECT_EQ(found, duped_found);
 }
 
+TEST(ArraySortedMap, ConstructsOnlyLiveEntries) {
+  Counted::live = 0;
+  {
+    ArraySortedMap<int, Counted> map;
+    EXPECT_EQ(0, Counted::live);
+
+    map = map.insert(1, Counted(1));
+    EXPECT_EQ(1, Counted::live);
+
+    map = map.insert(2, Counted(2)).insert(3, Counted(3)).erase(2);
+    EXPECT_EQ(2, Counted::live);
+  }
+  EXPECT_EQ(0, Counted::live);
+}
+
+TEST(ArraySortedMap, MovesInsertedEntries) {
+  Counted::copies = 0;
+  ArraySortedMap<int, Counted> map = ArraySortedMap<int, Counted>().insert(
+      1, Counted(1));
+  EXPECT_EQ(0, Counted::copies);
+
+  // Entries already in the map are copied into the new one.
+  map = map.insert(2, Counted(2));
+  EXPECT_EQ(1, Counted::copies);
+
+  Counted value(3);
+  map = map.insert(3, value);
+  EXPECT_EQ(4, Counted::copies);
+}
+
+TEST(ArraySortedMap, InsertAllocatesOnce) {
+  IntMap map = ToMap(Sequence(10));
+
+  // The new array and its shared_ptr control block share one allocation, and
+  // trivially copyable entries are copied in place.
+  testutil::AllocationCounter counter;
+  IntMap inserted = map.insert(100, 100);
+  EXPECT_EQ(1u, counter.allocations());
+  EXPECT_EQ(0u, counter.deallocations());
+
+  // Replacing an entry with an equal value shares the existing array.
+  counter.Reset();
+  IntMap same = inserted.insert(100, 100);
+  EXPECT_EQ(0u, counter.allocations());
+  EXPECT_EQ(inserted.begin(), same.begin());
+}
+
+TEST(ArraySortedMap, BoundsMatchBinarySearch) {
+  // Int keys are searched linearly; the results must match std::lower_bound
+  // and std::upper_bound over the same entries.
+  std::vector<int> keys{0, 2, 4, 6, 8};
+  IntMap map = ToMap(keys);
+  for (int key = -1; key <= 9; ++key) {
+    auto lower = std::lower_bound(keys.begin(), keys.end(), key);
+    auto upper = std::upper_bound(keys.begin(), keys.end(), key);
+    EXPECT_EQ(lower - keys.begin(), map.lower_bound(key) - map.begin());
+    EXPECT_EQ(upper - keys.begin(), map.upper_bound(key) - map.begin());
+  }
+}
+
+TEST(ArraySortedMap, FindsByKeyLikeValue) {
+  using StringMap =
+      ArraySortedMap<std::string, int, util::Comparator<absl::string_view>>;
+  StringMap map{{"a", 1}, {"b", 2}, {"d", 4}};
+
+  absl::string_view b = "b";
+  auto found = map.find(b);
+  ASSERT_NE(map.end(), found);
+  EXPECT_EQ(2, found->second);
+
+  EXPECT_EQ(map.end(), map.find(absl::string_view{"c"}));
+  EXPECT_EQ("d", map.lower_bound("c")->first);
+  EXPECT_EQ("d", map.upper_bound(b)->first);
+  EXPECT_EQ(map.find(std::string{"a"}), map.find("a"));
+}
+
 }  // namespace immutable
 }  // namespace firestore
 }  // namespace firebase
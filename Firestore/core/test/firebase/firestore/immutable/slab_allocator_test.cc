@@ -0,0 +1,128 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/immutable/slab_allocator.h"
+
+#include <memory>
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/tree_sorted_map.h"
+#include "Firestore/core/test/firebase/firestore/immutable/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+namespace {
+
+int allocations = 0;
+int deallocations = 0;
+
+/** A stateless allocator that counts calls through to std::allocator. */
+template <typename T>
+class CountingAllocator {
+ public:
+  using value_type = T;
+
+  CountingAllocator() {
+  }
+
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>&) {  // NOLINT(runtime/explicit)
+  }
+
+  T* allocate(std::size_t n) {
+    allocations++;
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* pointer, std::size_t n) {
+    deallocations++;
+    std::allocator<T>().deallocate(pointer, n);
+  }
+
+  friend bool operator==(const CountingAllocator&, const CountingAllocator&) {
+    return true;
+  }
+
+  friend bool operator!=(const CountingAllocator&, const CountingAllocator&) {
+    return false;
+  }
+};
+
+}  // namespace
+
+TEST(SlabAllocator, ReusesFreedBlocks) {
+  SlabAllocator<int64_t> allocator;
+  int64_t* first = allocator.allocate(1);
+  allocator.deallocate(first, 1);
+
+  int64_t* second = allocator.allocate(1);
+  EXPECT_EQ(first, second);
+  allocator.deallocate(second, 1);
+}
+
+TEST(SlabAllocator, HandlesArrays) {
+  SlabAllocator<int> allocator;
+  int* values = allocator.allocate(10);
+  for (int i = 0; i < 10; i++) {
+    values[i] = i;
+  }
+  allocator.deallocate(values, 10);
+}
+
+TEST(SlabAllocator, BacksTreeSortedMap) {
+  using IntMap = TreeSortedMap<int, int, std::less<int>, SlabAllocator<int>>;
+
+  std::vector<int> to_insert = Shuffled(Sequence(1000));
+  IntMap map = ToMap<IntMap>(to_insert);
+  ASSERT_SEQ_EQ(Pairs(Sorted(to_insert)), map);
+
+  for (int i : Shuffled(to_insert)) {
+    map = map.erase(i);
+    ASSERT_TRUE(NotFound(map, i));
+  }
+  ASSERT_TRUE(map.empty());
+}
+
+TEST(SlabAllocator, BacksSortedMap) {
+  using IntMap = SortedMap<int, int, std::less<int>, SlabAllocator<int>>;
+
+  IntMap map = ToMap<IntMap>(Sequence(100));
+  EXPECT_TRUE(map.is_tree());
+  ASSERT_SEQ_EQ(Pairs(Sequence(100)), map);
+}
+
+TEST(SlabAllocator, TreeNodesUseTheGivenAllocator) {
+  using IntMap =
+      TreeSortedMap<int, int, std::less<int>, CountingAllocator<int>>;
+
+  // Force creation of the shared empty node before counting.
+  IntMap().insert(0, 0);
+  allocations = 0;
+  deallocations = 0;
+
+  {
+    IntMap map = ToMap<IntMap>(Sequence(100));
+    EXPECT_GE(allocations, 100);
+  }
+  EXPECT_EQ(allocations, deallocations);
+}
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+
+#include "Firestore/core/test/firebase/firestore/immutable/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+typedef SortedMap<int, int> IntMap;
+constexpr IntMap::size_type kFixedSize = IntMap::kFixedSize;
+
+TEST(SortedMap, EmptyBehavior) {
+  IntMap map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(0u, map.size());
+  EXPECT_FALSE(map.is_tree());
+  EXPECT_TRUE(NotFound(map, 1));
+  EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(SortedMap, StaysArrayUpToFixedSize) {
+  int n = static_cast<int>(kFixedSize);
+  IntMap map = ToMap<IntMap>(Shuffled(Sequence(n)));
+  EXPECT_EQ(kFixedSize, map.size());
+  EXPECT_FALSE(map.is_tree());
+
+  // Replacing an existing entry must not trigger a switch.
+  map = map.insert(5, 10);
+  EXPECT_FALSE(map.is_tree());
+  EXPECT_TRUE(Found(map, 5, 10));
+}
+
+TEST(SortedMap, SwitchesToTreeBeyondFixedSize) {
+  int n = static_cast<int>(kFixedSize);
+  IntMap array_map = ToMap<IntMap>(Sequence(n));
+  ASSERT_FALSE(array_map.is_tree());
+
+  IntMap tree_map = array_map.insert(n, n);
+  EXPECT_TRUE(tree_map.is_tree());
+  EXPECT_EQ(kFixedSize + 1, tree_map.size());
+  ASSERT_SEQ_EQ(Pairs(Sequence(n + 1)), tree_map);
+
+  // The original is unaffected.
+  EXPECT_FALSE(array_map.is_tree());
+  EXPECT_TRUE(NotFound(array_map, n));
+}
+
+TEST(SortedMap, InsertionAndRemovalOfManyItems) {
+  int n = 1000;
+  std::vector<int> to_insert = Shuffled(Sequence(n));
+  std::vector<int> to_remove = Shuffled(to_insert);
+
+  IntMap map = ToMap<IntMap>(to_insert);
+  ASSERT_EQ(static_cast<IntMap::size_type>(n), map.size());
+  ASSERT_SEQ_EQ(Pairs(Sorted(to_insert)), map);
+
+  for (int i : to_remove) {
+    ASSERT_TRUE(Found(map, i, i));
+    map = map.erase(i);
+    ASSERT_TRUE(NotFound(map, i));
+  }
+  ASSERT_EQ(0u, map.size());
+}
+
+TEST(SortedMap, InitializerListNeedNotBeSorted) {
+  IntMap map{{3, 3}, {1, 1}, {2, 2}};
+  ASSERT_SEQ_EQ(Pairs(Sequence(1, 4)), map);
+}
+
+TEST(SortedMap, CopiesAndMoves) {
+  IntMap tree_map = ToMap<IntMap>(Sequence(100));
+  IntMap array_map = ToMap<IntMap>(Sequence(10));
+
+  IntMap copy = tree_map;
+  EXPECT_TRUE(copy.is_tree());
+  EXPECT_EQ(100u, copy.size());
+
+  copy = array_map;
+  EXPECT_FALSE(copy.is_tree());
+  EXPECT_EQ(10u, copy.size());
+
+  IntMap moved = std::move(tree_map);
+  EXPECT_TRUE(moved.is_tree());
+  EXPECT_EQ(100u, moved.size());
+}
+
+TEST(SortedMap, LowerBound) {
+  // Only even keys, so that odd keys fall between entries.
+  IntMap array_map = ToMap<IntMap>(Sequence(0, 10, 2));
+  IntMap tree_map = ToMap<IntMap>(Sequence(0, 200, 2));
+  ASSERT_FALSE(array_map.is_tree());
+  ASSERT_TRUE(tree_map.is_tree());
+
+  for (const IntMap& map : {array_map, tree_map}) {
+    EXPECT_EQ(map.begin(), map.lower_bound(-1));
+    EXPECT_EQ(0, map.lower_bound(0)->first);
+    EXPECT_EQ(4, map.lower_bound(3)->first);
+    EXPECT_EQ(4, map.lower_bound(4)->first);
+    EXPECT_EQ(map.end(), map.lower_bound(1000));
+  }
+}
+
+TEST(SortedMap, FindIndexAndAtIndex) {
+  IntMap array_map = ToMap<IntMap>(Sequence(0, 10, 2));
+  IntMap tree_map = ToMap<IntMap>(Sequence(0, 200, 2));
+  ASSERT_FALSE(array_map.is_tree());
+  ASSERT_TRUE(tree_map.is_tree());
+
+  for (const IntMap& map : {array_map, tree_map}) {
+    for (IntMap::size_type i = 0; i < map.size(); i++) {
+      EXPECT_EQ(i, map.find_index(static_cast<int>(i * 2)));
+      EXPECT_EQ(static_cast<int>(i * 2), map.at_index(i).first);
+    }
+    EXPECT_EQ(IntMap::npos, map.find_index(-1));
+    EXPECT_EQ(IntMap::npos, map.find_index(3));
+    EXPECT_EQ(IntMap::npos, map.find_index(1000));
+  }
+}
+
+TEST(SortedMap, BuilderAcceptsUnsortedInput) {
+  std::vector<int> to_insert = Shuffled(Sequence(100));
+
+  IntMap::Builder builder;
+  for (int i : to_insert) {
+    builder.insert(i, i);
+  }
+  IntMap map = builder.Build();
+  EXPECT_TRUE(map.is_tree());
+  ASSERT_SEQ_EQ(Pairs(Sequence(100)), map);
+}
+
+TEST(SortedMap, BuilderBuildsArraysForSmallInputs) {
+  IntMap::Builder builder;
+  builder.insert(3, 3).insert(1, 1).insert(2, 2);
+  IntMap map = builder.Build();
+  EXPECT_FALSE(map.is_tree());
+  ASSERT_SEQ_EQ(Pairs(Sequence(1, 4)), map);
+}
+
+TEST(SortedMap, BuilderLastOperationWins) {
+  IntMap::Builder builder;
+  builder.insert(1, 1).insert(2, 2).insert(1, 10).erase(2).insert(3, 3);
+  builder.erase(3).insert(3, 30);
+
+  IntMap map = builder.Build();
+  EXPECT_EQ(2u, map.size());
+  EXPECT_TRUE(Found(map, 1, 10));
+  EXPECT_TRUE(NotFound(map, 2));
+  EXPECT_TRUE(Found(map, 3, 30));
+}
+
+TEST(SortedMap, BuilderAppliesBatchToExistingMap) {
+  IntMap base = ToMap<IntMap>(Sequence(0, 20, 2));
+
+  IntMap::Builder builder{base};
+  for (int i : Shuffled(Sequence(1, 60, 2))) {
+    builder.insert(i, i);
+  }
+  builder.erase(0).erase(18).erase(1000);
+  IntMap map = builder.Build();
+
+  std::vector<int> expected;
+  for (int i = 1; i < 60; i++) {
+    if (i % 2 == 1 || (i < 18 && i != 0)) {
+      expected.push_back(i);
+    }
+  }
+  EXPECT_TRUE(map.is_tree());
+  ASSERT_SEQ_EQ(Pairs(expected), map);
+
+  // The base is unaffected.
+  ASSERT_SEQ_EQ(Pairs(Sequence(0, 20, 2)), base);
+}
+
+TEST(SortedMap, BuilderAppliesSmallBatchToLargeTree) {
+  IntMap base = ToMap<IntMap>(Sequence(1000));
+
+  IntMap::Builder builder{base};
+  builder.erase(5).insert(2000, 2000).insert(7, 70);
+  IntMap map = builder.Build();
+
+  EXPECT_EQ(1000u, map.size());
+  EXPECT_TRUE(NotFound(map, 5));
+  EXPECT_TRUE(Found(map, 7, 70));
+  EXPECT_TRUE(Found(map, 2000, 2000));
+}
+
+TEST(SortedMap, BuilderCanShrinkToArray) {
+  IntMap base = ToMap<IntMap>(Sequence(100));
+  ASSERT_TRUE(base.is_tree());
+
+  IntMap::Builder builder{base};
+  for (int i = 10; i < 100; i++) {
+    builder.erase(i);
+  }
+  IntMap map = builder.Build();
+  EXPECT_FALSE(map.is_tree());
+  ASSERT_SEQ_EQ(Pairs(Sequence(10)), map);
+}
+
+TEST(SortedMap, BoundsAndRanges) {
+  // Exercise both implementations with the even numbers 0, 2, ..., 2n - 2.
+  for (int n : {10, 100}) {
+    IntMap map = ToMap<IntMap>(Shuffled(Sequence(0, 2 * n, 2)));
+    ASSERT_EQ(n > static_cast<int>(kFixedSize), map.is_tree());
+
+    EXPECT_EQ(4, map.lower_bound(4)->first);
+    EXPECT_EQ(6, map.upper_bound(4)->first);
+    EXPECT_EQ(6, map.upper_bound(5)->first);
+    EXPECT_EQ(map.end(), map.upper_bound(2 * n - 2));
+    EXPECT_EQ(4, map.reverse_upper_bound(4)->first);
+    EXPECT_EQ(4, map.reverse_upper_bound(5)->first);
+    EXPECT_EQ(map.rend(), map.reverse_upper_bound(-1));
+
+    EXPECT_SEQ_EQ(Pairs(Sequence(6, 2 * n, 2)), map.range_from(5));
+    EXPECT_SEQ_EQ(Pairs(Sequence(4, 10, 2)), map.range(4, 10));
+    EXPECT_TRUE(map.range(10, 4).empty());
+    EXPECT_SEQ_EQ(Pairs(Sequence(2 * n - 2, -1, -2)), map.reversed());
+    EXPECT_SEQ_EQ(Pairs(Sequence(6, -1, -2)), map.reverse_range_from(7));
+    EXPECT_TRUE(map.reverse_range_from(-1).empty());
+  }
+}
+
+TEST(SortedMap, ReverseIterationOfEmptyMap) {
+  IntMap map;
+  EXPECT_EQ(map.rbegin(), map.rend());
+  EXPECT_TRUE(map.reversed().empty());
+}
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
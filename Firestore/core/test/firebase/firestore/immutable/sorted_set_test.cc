@@ -0,0 +1,141 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
+
+#include <vector>
+
+#include "Firestore/core/test/firebase/firestore/immutable/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+typedef SortedSet<int> IntSet;
+constexpr IntSet::size_type kFixedSize = IntSet::kFixedSize;
+
+IntSet ToSet(const std::vector<int>& values) {
+  IntSet result;
+  for (int value : values) {
+    result = result.insert(value);
+  }
+  return result;
+}
+
+TEST(SortedSet, EmptyBehavior) {
+  IntSet set;
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(0u, set.size());
+  EXPECT_FALSE(set.is_tree());
+  EXPECT_FALSE(set.contains(1));
+  EXPECT_EQ(set.begin(), set.end());
+}
+
+TEST(SortedSet, InsertAndErase) {
+  IntSet set = IntSet{}.insert(3).insert(1).insert(2).insert(1);
+  EXPECT_SEQ_EQ((std::vector<int>{1, 2, 3}), set);
+  EXPECT_TRUE(set.contains(2));
+  EXPECT_EQ(1u, set.find_index(2));
+
+  IntSet erased = set.erase(2);
+  EXPECT_SEQ_EQ((std::vector<int>{1, 3}), erased);
+  EXPECT_FALSE(erased.contains(2));
+  EXPECT_TRUE(set.contains(2));
+}
+
+TEST(SortedSet, SwitchesToTreeBeyondFixedSize) {
+  int n = static_cast<int>(kFixedSize);
+  IntSet set = ToSet(Shuffled(Sequence(n)));
+  EXPECT_FALSE(set.is_tree());
+
+  set = set.insert(n);
+  EXPECT_TRUE(set.is_tree());
+  EXPECT_SEQ_EQ(Sequence(n + 1), set);
+}
+
+TEST(SortedSet, Union) {
+  IntSet evens = ToSet(Sequence(0, 100, 2));
+  IntSet low = ToSet(Sequence(0, 10));
+
+  IntSet result = evens.Union(low);
+  std::vector<int> expected = Sequence(0, 10);
+  for (int i : Sequence(10, 100, 2)) {
+    expected.push_back(i);
+  }
+  EXPECT_SEQ_EQ(expected, result);
+  EXPECT_EQ(result, low.Union(evens));
+
+  EXPECT_EQ(evens, evens.Union(IntSet{}));
+  EXPECT_EQ(evens, IntSet{}.Union(evens));
+}
+
+TEST(SortedSet, UnionStaysSmallWhenPossible) {
+  IntSet result = IntSet{1, 3}.Union(IntSet{2, 3, 4});
+  EXPECT_SEQ_EQ((std::vector<int>{1, 2, 3, 4}), result);
+  EXPECT_FALSE(result.is_tree());
+}
+
+TEST(SortedSet, Difference) {
+  IntSet all = ToSet(Shuffled(Sequence(100)));
+  IntSet evens = ToSet(Sequence(0, 100, 2));
+
+  EXPECT_SEQ_EQ(Sequence(1, 100, 2), all.Difference(evens));
+  EXPECT_TRUE(evens.Difference(all).empty());
+
+  IntSet few{5, 6, 200};
+  EXPECT_SEQ_EQ((std::vector<int>{200}), few.Difference(all));
+  EXPECT_EQ(few, few.Difference(evens.Difference(IntSet{6})));
+  EXPECT_EQ(all, all.Difference(IntSet{}));
+}
+
+TEST(SortedSet, Intersection) {
+  IntSet threes = ToSet(Sequence(0, 300, 3));
+  IntSet fives = ToSet(Shuffled(Sequence(0, 300, 5)));
+
+  EXPECT_SEQ_EQ(Sequence(0, 300, 15), threes.Intersection(fives));
+  EXPECT_EQ(threes.Intersection(fives), fives.Intersection(threes));
+  EXPECT_EQ(threes, threes.Intersection(ToSet(Sequence(300))));
+  EXPECT_TRUE(threes.Intersection(IntSet{}).empty());
+  EXPECT_TRUE(threes.Intersection(IntSet{1, 2, 4}).empty());
+}
+
+TEST(SortedSet, MergesLargeSets) {
+  int n = 5000;
+  IntSet evens = ToSet(Shuffled(Sequence(0, n, 2)));
+  IntSet odds = ToSet(Shuffled(Sequence(1, n, 2)));
+
+  IntSet all = evens.Union(odds);
+  EXPECT_TRUE(all.is_tree());
+  EXPECT_SEQ_EQ(Sequence(n), all);
+  EXPECT_EQ(evens, all.Difference(odds));
+  EXPECT_EQ(odds, all.Intersection(odds));
+
+  // A small change to a large set gives the same result as a merge.
+  IntSet few{1, 2, n + 1};
+  EXPECT_EQ(all.insert(n + 1), all.Union(few));
+  EXPECT_EQ(all.erase(1).erase(2), all.Difference(few));
+}
+
+TEST(SortedSet, Equality) {
+  EXPECT_EQ(IntSet({1, 2, 3}), ToSet({3, 2, 1}));
+  EXPECT_NE(IntSet({1, 2, 3}), IntSet({1, 2}));
+  EXPECT_NE(IntSet({1, 2, 3}), IntSet({1, 2, 4}));
+}
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,263 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/immutable/tree_sorted_map.h"
+
+#include "Firestore/core/test/firebase/firestore/immutable/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+typedef TreeSortedMap<int, int> IntMap;
+
+/**
+ * Verifies the left-leaning red-black invariants of the tree rooted at the
+ * given node, returning its black height (or -1 if the invariants are
+ * violated).
+ */
+int BlackHeight(const IntMap::node_type& node) {
+  if (node.empty()) {
+    return 0;
+  }
+  if (node.right().red()) {
+    return -1;
+  }
+  if (node.red() && node.left().red()) {
+    return -1;
+  }
+  if (node.size() != node.left().size() + 1 + node.right().size()) {
+    return -1;
+  }
+
+  int left = BlackHeight(node.left());
+  int right = BlackHeight(node.right());
+  if (left < 0 || left != right) {
+    return -1;
+  }
+  return left + (node.red() ? 0 : 1);
+}
+
+testing::AssertionResult Balanced(const IntMap& map) {
+  if (map.root().red()) {
+    return testing::AssertionFailure() << "Root is red";
+  }
+  if (BlackHeight(map.root()) < 0) {
+    return testing::AssertionFailure() << "Tree is not a valid LLRB tree";
+  }
+  return testing::AssertionSuccess();
+}
+
+TEST(TreeSortedMap, EmptyBehavior) {
+  IntMap map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(0u, map.size());
+  EXPECT_TRUE(NotFound(map, 1));
+  EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(TreeSortedMap, SearchForSpecificKey) {
+  IntMap map{{1, 3}, {2, 4}};
+
+  ASSERT_TRUE(Found(map, 1, 3));
+  ASSERT_TRUE(Found(map, 2, 4));
+  ASSERT_TRUE(NotFound(map, 3));
+}
+
+TEST(TreeSortedMap, RemoveKeyValuePair) {
+  IntMap map{{1, 3}, {2, 4}};
+
+  IntMap new_map = map.erase(1);
+  ASSERT_TRUE(Found(new_map, 2, 4));
+  ASSERT_TRUE(NotFound(new_map, 1));
+
+  // Make sure the original one is not mutated
+  ASSERT_TRUE(Found(map, 1, 3));
+  ASSERT_TRUE(Found(map, 2, 4));
+}
+
+TEST(TreeSortedMap, MoreRemovals) {
+  IntMap map = IntMap()
+                   .insert(1, 1)
+                   .insert(50, 50)
+                   .insert(3, 3)
+                   .insert(4, 4)
+                   .insert(7, 7)
+                   .insert(9, 9)
+                   .insert(1, 20)
+                   .insert(18, 18)
+                   .insert(3, 2)
+                   .insert(4, 71)
+                   .insert(7, 42)
+                   .insert(9, 88);
+
+  ASSERT_TRUE(Found(map, 7, 42));
+  ASSERT_TRUE(Found(map, 3, 2));
+  ASSERT_TRUE(Found(map, 1, 20));
+
+  IntMap s1 = map.erase(7);
+  IntMap s2 = map.erase(3);
+  IntMap s3 = map.erase(1);
+
+  ASSERT_TRUE(NotFound(s1, 7));
+  ASSERT_TRUE(Found(s1, 3, 2));
+  ASSERT_TRUE(Found(s1, 1, 20));
+
+  ASSERT_TRUE(Found(s2, 7, 42));
+  ASSERT_TRUE(NotFound(s2, 3));
+  ASSERT_TRUE(Found(s2, 1, 20));
+
+  ASSERT_TRUE(Found(s3, 7, 42));
+  ASSERT_TRUE(Found(s3, 3, 2));
+  ASSERT_TRUE(NotFound(s3, 1));
+}
+
+TEST(TreeSortedMap, Override) {
+  IntMap map = IntMap().insert(10, 10).insert(10, 8);
+
+  ASSERT_TRUE(Found(map, 10, 8));
+  ASSERT_FALSE(Found(map, 10, 10));
+  ASSERT_EQ(1u, map.size());
+}
+
+TEST(TreeSortedMap, EraseMissingKeyReturnsSameMap) {
+  IntMap map{{1, 1}, {2, 2}};
+  IntMap same = map.erase(3);
+
+  EXPECT_EQ(2u, same.size());
+  EXPECT_EQ(&*map.find(1), &*same.find(1));
+}
+
+TEST(TreeSortedMap, IncreasingAndDecreasing) {
+  std::vector<int> to_insert = Sequence(500);
+  IntMap map = ToMap<IntMap>(to_insert);
+  ASSERT_EQ(500u, map.size());
+  ASSERT_TRUE(Balanced(map));
+
+  for (int i = 499; i >= 0; i--) {
+    map = map.erase(i);
+    ASSERT_TRUE(Balanced(map));
+  }
+  ASSERT_EQ(0u, map.size());
+}
+
+TEST(TreeSortedMap, InsertionAndRemovalOfManyItems) {
+  int n = 1000;
+  std::vector<int> to_insert = Shuffled(Sequence(n));
+  std::vector<int> to_remove = Shuffled(to_insert);
+
+  IntMap map = ToMap<IntMap>(to_insert);
+  ASSERT_EQ(static_cast<IntMap::size_type>(n), map.size());
+  ASSERT_TRUE(Balanced(map));
+
+  // check the order is correct
+  ASSERT_SEQ_EQ(Pairs(Sorted(to_insert)), map);
+
+  for (int i : to_remove) {
+    map = map.erase(i);
+    ASSERT_TRUE(NotFound(map, i));
+    ASSERT_TRUE(Balanced(map));
+  }
+  ASSERT_EQ(0u, map.size());
+}
+
+TEST(TreeSortedMap, BalanceProblem) {
+  std::vector<int> to_insert{1, 7, 8, 5, 2, 6, 4, 0, 3};
+
+  IntMap map = ToMap<IntMap>(to_insert);
+  ASSERT_SEQ_EQ(Pairs(Sorted(to_insert)), map);
+  ASSERT_TRUE(Balanced(map));
+}
+
+TEST(TreeSortedMap, StructuralSharing) {
+  IntMap original = ToMap<IntMap>(Sequence(100));
+  IntMap modified = original.insert(1000, 1000);
+
+  // Entries outside the path to the new key must be shared between the two
+  // maps.
+  EXPECT_EQ(&*original.find(0), &*modified.find(0));
+  EXPECT_EQ(100u, original.size());
+  EXPECT_EQ(101u, modified.size());
+  EXPECT_TRUE(NotFound(original, 1000));
+}
+
+TEST(TreeSortedMap, FindPositionsIterator) {
+  IntMap map = ToMap<IntMap>(Sequence(0, 100, 2));
+
+  auto iter = map.find(50);
+  ASSERT_NE(map.end(), iter);
+
+  std::vector<int> rest;
+  for (; iter != map.end(); ++iter) {
+    rest.push_back(iter->first);
+  }
+  EXPECT_EQ(Sequence(50, 100, 2), rest);
+}
+
+TEST(TreeSortedMap, FindIndexAndAtIndex) {
+  // Build through random insertions and removals so the tree isn't perfectly
+  // balanced.
+  IntMap map = ToMap<IntMap>(Shuffled(Sequence(0, 400, 2)));
+  for (int i : Shuffled(Sequence(0, 400, 8))) {
+    map = map.erase(i);
+  }
+  std::vector<int> keys;
+  for (const auto& entry : map) {
+    keys.push_back(entry.first);
+  }
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    auto index = static_cast<IntMap::size_type>(i);
+    EXPECT_EQ(index, map.find_index(keys[i]));
+    EXPECT_EQ(keys[i], map.at_index(index).first);
+  }
+  EXPECT_EQ(IntMap::npos, map.find_index(1));
+  EXPECT_EQ(IntMap::npos, map.find_index(8));
+  EXPECT_EQ(IntMap::npos, IntMap{}.find_index(0));
+}
+
+TEST(TreeSortedMap, CreateFromSorted) {
+  for (int n = 0; n < 300; n++) {
+    std::vector<std::pair<int, int>> entries = Pairs(Sequence(n));
+    IntMap map = IntMap::CreateFromSorted(entries.begin(), entries.end());
+
+    ASSERT_EQ(static_cast<IntMap::size_type>(n), map.size());
+    ASSERT_TRUE(Balanced(map)) << "n = " << n;
+    ASSERT_SEQ_EQ(entries, map);
+  }
+}
+
+TEST(TreeSortedMap, CreateFromSortedCanBeModified) {
+  std::vector<std::pair<int, int>> entries = Pairs(Sequence(0, 200, 2));
+  IntMap map = IntMap::CreateFromSorted(entries.begin(), entries.end());
+
+  for (int i : Shuffled(Sequence(1, 200, 2))) {
+    map = map.insert(i, i);
+    ASSERT_TRUE(Balanced(map));
+  }
+  ASSERT_SEQ_EQ(Pairs(Sequence(200)), map);
+
+  for (int i : Shuffled(Sequence(200))) {
+    map = map.erase(i);
+    ASSERT_TRUE(Balanced(map));
+  }
+  ASSERT_TRUE(map.empty());
+}
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,462 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+bool StartsWith(const std::string& value, const std::string& prefix) {
+  return value.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::string RemoteDocKey(const PathSegments& path) {
+  return LevelDbRemoteDocumentKey::Key(path);
+}
+
+std::string RemoteDocKeyPrefix(const PathSegments& path) {
+  return LevelDbRemoteDocumentKey::KeyPrefix(path);
+}
+
+std::string DocMutationKey(absl::string_view user_id,
+                           const PathSegments& path,
+                           model::BatchId batch_id) {
+  return LevelDbDocumentMutationKey::Key(user_id, path, batch_id);
+}
+
+std::string TargetDocKey(model::TargetId target_id, const PathSegments& path) {
+  return LevelDbTargetDocumentKey::Key(target_id, path);
+}
+
+std::string DocTargetKey(const PathSegments& path, model::TargetId target_id) {
+  return LevelDbDocumentTargetKey::Key(path, target_id);
+}
+
+}  // namespace
+
+#define ASSERT_KEY_LESS_THAN(left, right)                                    \
+  do {                                                                       \
+    std::string left_key = (left);                                           \
+    std::string right_key = (right);                                         \
+    ASSERT_LT(left_key, right_key) << "Expected " << DescribeKey(left_key)   \
+                                   << " to be less than "                    \
+                                   << DescribeKey(right_key);                \
+  } while (0)
+
+TEST(LevelDbMutationKeyTest, Prefixing) {
+  auto table_key = LevelDbMutationKey::KeyPrefix();
+  auto empty_user_key = LevelDbMutationKey::KeyPrefix("");
+  auto foo_user_key = LevelDbMutationKey::KeyPrefix("foo");
+
+  auto foo2_key = LevelDbMutationKey::Key("foo", 2);
+
+  ASSERT_TRUE(StartsWith(empty_user_key, table_key));
+
+  // This is critical: prefixes of the a value don't convert into prefixes of
+  // the key.
+  ASSERT_TRUE(StartsWith(foo_user_key, table_key));
+  ASSERT_FALSE(StartsWith(foo_user_key, empty_user_key));
+
+  // However whole segments in common are prefixes.
+  ASSERT_TRUE(StartsWith(foo2_key, table_key));
+  ASSERT_TRUE(StartsWith(foo2_key, foo_user_key));
+}
+
+TEST(LevelDbMutationKeyTest, EncodeDecodeCycle) {
+  LevelDbMutationKey key;
+  std::string user("foo");
+
+  for (model::BatchId batch_id : {0, 1, 100, -1, INT32_MIN, INT32_MAX}) {
+    auto encoded = LevelDbMutationKey::Key(user, batch_id);
+
+    ASSERT_TRUE(key.Decode(encoded));
+    ASSERT_EQ(user, key.user_id());
+    ASSERT_EQ(batch_id, key.batch_id());
+  }
+}
+
+TEST(LevelDbMutationKeyTest, Description) {
+  ASSERT_EQ("[mutation: incomplete key]",
+            DescribeKey(LevelDbMutationKey::KeyPrefix()));
+
+  ASSERT_EQ("[mutation: userID=user1 incomplete key]",
+            DescribeKey(LevelDbMutationKey::KeyPrefix("user1")));
+
+  auto key = LevelDbMutationKey::Key("user1", 42);
+  ASSERT_EQ("[mutation: userID=user1 batchID=42]", DescribeKey(key));
+
+  ASSERT_EQ(
+      "[mutation: userID=user1 batchID=42 invalid "
+      "key=<hW11dGF0aW9uAAGNdXNlcjEAAYqqgCBleHRyYQ==>]",
+      DescribeKey(key + " extra"));
+
+  // Truncate the key so that it's missing its terminator.
+  key.resize(key.size() - 1);
+  ASSERT_EQ("[mutation: userID=user1 batchID=42 incomplete key]",
+            DescribeKey(key));
+}
+
+TEST(LevelDbDocumentMutationKeyTest, Prefixing) {
+  auto table_key = LevelDbDocumentMutationKey::KeyPrefix();
+  auto empty_user_key = LevelDbDocumentMutationKey::KeyPrefix("");
+  auto foo_user_key = LevelDbDocumentMutationKey::KeyPrefix("foo");
+
+  PathSegments document_key{"foo", "bar"};
+  auto foo2_key = LevelDbDocumentMutationKey::Key("foo", document_key, 2);
+
+  ASSERT_TRUE(StartsWith(empty_user_key, table_key));
+
+  // While we want a key with whole segments in common be considered a prefix
+  // it's vital that partial segments in common not be prefixes.
+  ASSERT_TRUE(StartsWith(foo_user_key, table_key));
+
+  // Here even though "" is a prefix of "foo" that prefix is within a segment
+  // so keys derived from those segments cannot be prefixes of each other.
+  ASSERT_FALSE(StartsWith(foo_user_key, empty_user_key));
+  ASSERT_FALSE(StartsWith(empty_user_key, foo_user_key));
+
+  // However whole segments in common are prefixes.
+  ASSERT_TRUE(StartsWith(foo2_key, table_key));
+  ASSERT_TRUE(StartsWith(foo2_key, foo_user_key));
+}
+
+TEST(LevelDbDocumentMutationKeyTest, EncodeDecodeCycle) {
+  LevelDbDocumentMutationKey key;
+  std::string user("foo");
+
+  std::vector<PathSegments> document_keys{{"a", "b"}, {"a", "b", "c", "d"}};
+
+  for (model::BatchId batch_id : {0, 1, 100, -1, INT32_MIN, INT32_MAX}) {
+    for (auto&& document_key : document_keys) {
+      auto encoded =
+          LevelDbDocumentMutationKey::Key(user, document_key, batch_id);
+
+      ASSERT_TRUE(key.Decode(encoded));
+      ASSERT_EQ(user, key.user_id());
+      ASSERT_EQ(document_key, key.document_key());
+      ASSERT_EQ(batch_id, key.batch_id());
+    }
+  }
+}
+
+TEST(LevelDbDocumentMutationKeyTest, Ordering) {
+  // Different user:
+  ASSERT_KEY_LESS_THAN(DocMutationKey("1", {"foo", "bar"}, 0),
+                       DocMutationKey("10", {"foo", "bar"}, 0));
+  ASSERT_KEY_LESS_THAN(DocMutationKey("1", {"foo", "bar"}, 0),
+                       DocMutationKey("2", {"foo", "bar"}, 0));
+
+  // Different paths:
+  ASSERT_KEY_LESS_THAN(DocMutationKey("1", {"foo", "bar"}, 0),
+                       DocMutationKey("1", {"foo", "baz"}, 0));
+  ASSERT_KEY_LESS_THAN(DocMutationKey("1", {"foo", "bar"}, 0),
+                       DocMutationKey("1", {"foo", "bar2"}, 0));
+  ASSERT_KEY_LESS_THAN(DocMutationKey("1", {"foo", "bar"}, 0),
+                       DocMutationKey("1", {"foo", "bar", "suffix", "key"}, 0));
+  ASSERT_KEY_LESS_THAN(DocMutationKey("1", {"foo", "bar", "suffix", "key"}, 0),
+                       DocMutationKey("1", {"foo", "bar2"}, 0));
+
+  // Different batch_id:
+  ASSERT_KEY_LESS_THAN(DocMutationKey("1", {"foo", "bar"}, -1),
+                       DocMutationKey("1", {"foo", "bar"}, 0));
+  ASSERT_KEY_LESS_THAN(DocMutationKey("1", {"foo", "bar"}, 0),
+                       DocMutationKey("1", {"foo", "bar"}, 1));
+}
+
+TEST(LevelDbDocumentMutationKeyTest, Description) {
+  ASSERT_EQ("[document_mutation: incomplete key]",
+            DescribeKey(LevelDbDocumentMutationKey::KeyPrefix()));
+
+  ASSERT_EQ("[document_mutation: userID=user1 incomplete key]",
+            DescribeKey(LevelDbDocumentMutationKey::KeyPrefix("user1")));
+
+  auto key = LevelDbDocumentMutationKey::KeyPrefix("user1", {"foo", "bar"});
+  ASSERT_EQ("[document_mutation: userID=user1 key=foo/bar incomplete key]",
+            DescribeKey(key));
+
+  key = LevelDbDocumentMutationKey::Key("user1", {"foo", "bar"}, 42);
+  ASSERT_EQ("[document_mutation: userID=user1 key=foo/bar batchID=42]",
+            DescribeKey(key));
+}
+
+TEST(LevelDbMigrationProgressKeyTest, Description) {
+  ASSERT_EQ("[migration_progress:]",
+            DescribeKey(LevelDbMigrationProgressKey::Key()));
+}
+
+TEST(LevelDbTargetGlobalKeyTest, EncodeDecodeCycle) {
+  LevelDbTargetGlobalKey key;
+
+  auto encoded = LevelDbTargetGlobalKey::Key();
+  ASSERT_TRUE(key.Decode(encoded));
+  ASSERT_FALSE(key.Decode(LevelDbTargetKey::Key(1)));
+}
+
+TEST(LevelDbTargetKeyTest, EncodeDecodeCycle) {
+  LevelDbTargetKey key;
+  model::TargetId target_id = 42;
+
+  auto encoded = LevelDbTargetKey::Key(42);
+  ASSERT_TRUE(key.Decode(encoded));
+  ASSERT_EQ(target_id, key.target_id());
+}
+
+TEST(LevelDbQueryTargetKeyTest, EncodeDecodeCycle) {
+  LevelDbQueryTargetKey key;
+  std::string canonical_id("foo");
+  model::TargetId target_id = 42;
+
+  auto encoded = LevelDbQueryTargetKey::Key(canonical_id, 42);
+  ASSERT_TRUE(key.Decode(encoded));
+  ASSERT_EQ(canonical_id, key.canonical_id());
+  ASSERT_EQ(target_id, key.target_id());
+}
+
+TEST(LevelDbQueryTargetKeyTest, Description) {
+  ASSERT_EQ("[query_target: canonicalID=foo targetID=42]",
+            DescribeKey(LevelDbQueryTargetKey::Key("foo", 42)));
+}
+
+TEST(LevelDbTargetDocumentKeyTest, EncodeDecodeCycle) {
+  LevelDbTargetDocumentKey key;
+
+  auto encoded = LevelDbTargetDocumentKey::Key(42, {"foo", "bar"});
+  ASSERT_TRUE(key.Decode(encoded));
+  ASSERT_EQ(42, key.target_id());
+  ASSERT_EQ((PathSegments{"foo", "bar"}), key.document_key());
+}
+
+TEST(LevelDbTargetDocumentKeyTest, Ordering) {
+  // Different target_id:
+  ASSERT_KEY_LESS_THAN(TargetDocKey(1, {"foo", "bar"}),
+                       TargetDocKey(2, {"foo", "bar"}));
+  ASSERT_KEY_LESS_THAN(TargetDocKey(2, {"foo", "bar"}),
+                       TargetDocKey(10, {"foo", "bar"}));
+  ASSERT_KEY_LESS_THAN(TargetDocKey(10, {"foo", "bar"}),
+                       TargetDocKey(100, {"foo", "bar"}));
+
+  // Different paths:
+  ASSERT_KEY_LESS_THAN(TargetDocKey(1, {"foo", "bar"}),
+                       TargetDocKey(1, {"foo", "baz"}));
+  ASSERT_KEY_LESS_THAN(TargetDocKey(1, {"foo", "bar"}),
+                       TargetDocKey(1, {"foo", "bar2"}));
+  ASSERT_KEY_LESS_THAN(TargetDocKey(1, {"foo", "bar"}),
+                       TargetDocKey(1, {"foo", "bar", "suffix", "key"}));
+  ASSERT_KEY_LESS_THAN(TargetDocKey(1, {"foo", "bar", "suffix", "key"}),
+                       TargetDocKey(1, {"foo", "bar2"}));
+}
+
+TEST(LevelDbTargetDocumentKeyTest, Description) {
+  auto key = LevelDbTargetDocumentKey::Key(42, {"foo", "bar"});
+  ASSERT_EQ("[target_document: targetID=42 key=foo/bar]", DescribeKey(key));
+}
+
+TEST(LevelDbDocumentTargetKeyTest, EncodeDecodeCycle) {
+  LevelDbDocumentTargetKey key;
+
+  auto encoded = LevelDbDocumentTargetKey::Key({"foo", "bar"}, 42);
+  ASSERT_TRUE(key.Decode(encoded));
+  ASSERT_EQ((PathSegments{"foo", "bar"}), key.document_key());
+  ASSERT_EQ(42, key.target_id());
+}
+
+TEST(LevelDbDocumentTargetKeyTest, Description) {
+  auto key = LevelDbDocumentTargetKey::Key({"foo", "bar"}, 42);
+  ASSERT_EQ("[document_target: key=foo/bar targetID=42]", DescribeKey(key));
+}
+
+TEST(LevelDbDocumentTargetKeyTest, Ordering) {
+  // Different paths:
+  ASSERT_KEY_LESS_THAN(DocTargetKey({"foo", "bar"}, 1),
+                       DocTargetKey({"foo", "baz"}, 1));
+  ASSERT_KEY_LESS_THAN(DocTargetKey({"foo", "bar"}, 1),
+                       DocTargetKey({"foo", "bar2"}, 1));
+  ASSERT_KEY_LESS_THAN(DocTargetKey({"foo", "bar"}, 1),
+                       DocTargetKey({"foo", "bar", "suffix", "key"}, 1));
+  ASSERT_KEY_LESS_THAN(DocTargetKey({"foo", "bar", "suffix", "key"}, 1),
+                       DocTargetKey({"foo", "bar2"}, 1));
+
+  // Different target_id:
+  ASSERT_KEY_LESS_THAN(DocTargetKey({"foo", "bar"}, 1),
+                       DocTargetKey({"foo", "bar"}, 2));
+  ASSERT_KEY_LESS_THAN(DocTargetKey({"foo", "bar"}, 2),
+                       DocTargetKey({"foo", "bar"}, 10));
+  ASSERT_KEY_LESS_THAN(DocTargetKey({"foo", "bar"}, 10),
+                       DocTargetKey({"foo", "bar"}, 100));
+  ASSERT_KEY_LESS_THAN(DocTargetKey({"foo", "bar"}, 42),
+                       DocTargetKey({"foo", "bar"}, 100));
+}
+
+TEST(LevelDbRemoteDocumentKeyTest, Prefixing) {
+  auto table_key = LevelDbRemoteDocumentKey::KeyPrefix();
+
+  ASSERT_TRUE(StartsWith(RemoteDocKey({"foo", "bar"}), table_key));
+
+  // This is critical: foo/bar2 should not contain foo/bar.
+  ASSERT_FALSE(
+      StartsWith(RemoteDocKey({"foo", "bar2"}), RemoteDocKey({"foo", "bar"})));
+
+  // Prefixes must be encoded specially
+  ASSERT_FALSE(StartsWith(RemoteDocKey({"foo", "bar", "baz", "quu"}),
+                          RemoteDocKey({"foo", "bar"})));
+  ASSERT_TRUE(StartsWith(RemoteDocKey({"foo", "bar", "baz", "quu"}),
+                         RemoteDocKeyPrefix({"foo", "bar"})));
+  ASSERT_TRUE(StartsWith(RemoteDocKeyPrefix({"foo", "bar", "baz", "quu"}),
+                         RemoteDocKeyPrefix({"foo", "bar"})));
+  ASSERT_TRUE(StartsWith(RemoteDocKeyPrefix({"foo", "bar", "baz"}),
+                         RemoteDocKeyPrefix({"foo", "bar"})));
+  ASSERT_TRUE(StartsWith(RemoteDocKeyPrefix({"foo", "bar"}),
+                         RemoteDocKeyPrefix({"foo"})));
+}
+
+TEST(LevelDbRemoteDocumentKeyTest, Ordering) {
+  ASSERT_KEY_LESS_THAN(RemoteDocKey({"foo", "bar"}),
+                       RemoteDocKey({"foo", "bar2"}));
+  ASSERT_KEY_LESS_THAN(RemoteDocKey({"foo", "bar"}),
+                       RemoteDocKey({"foo", "bar", "foo", "bar"}));
+}
+
+TEST(LevelDbRemoteDocumentKeyTest, EncodeDecodeCycle) {
+  LevelDbRemoteDocumentKey key;
+
+  std::vector<PathSegments> paths{
+      {"foo", "bar"}, {"foo", "bar2"}, {"foo", "bar", "baz", "quux"}};
+  for (auto&& path : paths) {
+    auto encoded = RemoteDocKey(path);
+    ASSERT_TRUE(key.Decode(encoded));
+    ASSERT_EQ(path, key.document_key());
+  }
+}
+
+TEST(LevelDbRemoteDocumentKeyTest, RejectsNonDocumentPaths) {
+  LevelDbRemoteDocumentKey key;
+  ASSERT_FALSE(key.Decode(RemoteDocKey({"foo"})));
+  ASSERT_FALSE(key.Decode(RemoteDocKey({})));
+  ASSERT_FALSE(key.Decode(RemoteDocKeyPrefix({"foo", "bar"})));
+  ASSERT_FALSE(key.Decode(LevelDbTargetDocumentKey::Key(1, {"foo", "bar"})));
+}
+
+TEST(LevelDbRemoteDocumentKeyTest, DecodesSegmentsInPlace) {
+  LevelDbRemoteDocumentKey key;
+
+  // Segments without special bytes point into the key itself.
+  auto encoded = RemoteDocKey({"rooms", "abc"});
+  ASSERT_TRUE(key.Decode(encoded));
+  for (absl::string_view segment : key.document_key()) {
+    ASSERT_GE(segment.data(), encoded.data());
+    ASSERT_LE(segment.data() + segment.size(), encoded.data() + encoded.size());
+  }
+
+  // Segments that need unescaping are still decoded correctly, and stay valid
+  // alongside segments decoded in place.
+  std::string escaped_1("a\0b", 3);
+  std::string escaped_2("\xff\xff", 2);
+  PathSegments path{escaped_1, "plain", escaped_2, "other"};
+  encoded = RemoteDocKey(path);
+  ASSERT_TRUE(key.Decode(encoded));
+  ASSERT_EQ(path, key.document_key());
+}
+
+TEST(LevelDbRemoteDocumentKeyTest, KeyWithEncodedPath) {
+  std::vector<PathSegments> paths{
+      {"foo", "bar"}, {"foo", "bar2"}, {"foo", "bar", "baz", "quux"}};
+  for (auto&& path : paths) {
+    ASSERT_EQ(RemoteDocKey(path),
+              LevelDbRemoteDocumentKey::KeyWithEncodedPath(
+                  EncodeResourcePath(path)));
+  }
+}
+
+TEST(EncodeResourcePathTest, Ordering) {
+  // Encoded paths order the same way as the paths, segment by segment, with
+  // prefixes first.
+  std::vector<PathSegments> paths{{},
+                                  {"a"},
+                                  {"a", "b"},
+                                  {"a", "b", "a"},
+                                  {"a", "c"},
+                                  {"ab"},
+                                  {"b"}};
+  for (size_t i = 0; i + 1 < paths.size(); ++i) {
+    ASSERT_LT(EncodeResourcePath(paths[i]), EncodeResourcePath(paths[i + 1]));
+  }
+
+  std::string with_nul("a\0b", 3);
+  ASSERT_LT(EncodeResourcePath({"a"}), EncodeResourcePath({with_nul}));
+  ASSERT_LT(EncodeResourcePath({with_nul}), EncodeResourcePath({"ab"}));
+}
+
+TEST(LevelDbRemoteDocumentKeyTest, Description) {
+  ASSERT_EQ("[remote_document: key=foo/bar/baz/quux]",
+            DescribeKey(RemoteDocKey({"foo", "bar", "baz", "quux"})));
+}
+
+TEST(LevelDbIndexEntryKeyTest, EncodeDecodeCycle) {
+  LevelDbIndexEntryKey key;
+
+  std::string value("\x02\x00\xff", 3);
+  auto encoded = LevelDbIndexEntryKey::Key({"rooms", "abc", "messages"},
+                                           "author.name", value, "xyz");
+  ASSERT_TRUE(key.Decode(encoded));
+  ASSERT_EQ((PathSegments{"rooms", "abc", "messages"}), key.collection_path());
+  ASSERT_EQ("author.name", key.field_path());
+  ASSERT_EQ(value, key.index_value());
+  ASSERT_EQ("xyz", key.document_id());
+
+  ASSERT_FALSE(key.Decode(LevelDbIndexEntryKey::Key({"rooms", "abc"}, "a",
+                                                    value, "xyz")));
+  ASSERT_FALSE(key.Decode(
+      LevelDbIndexEntryKey::KeyPrefix({"rooms"}, "author.name", value)));
+}
+
+TEST(LevelDbIndexEntryKeyTest, Ordering) {
+  auto entry = [](absl::string_view value, absl::string_view document_id) {
+    return LevelDbIndexEntryKey::Key({"rooms"}, "a", value, document_id);
+  };
+
+  // Entries sort by value first, then by document.
+  ASSERT_KEY_LESS_THAN(entry("a", "z"), entry("b", "a"));
+  ASSERT_KEY_LESS_THAN(entry("a", "a"), entry("a", "b"));
+  ASSERT_KEY_LESS_THAN(entry("a", "z"), entry("ab", "a"));
+  ASSERT_KEY_LESS_THAN(entry(std::string("a\0", 2), "z"), entry("a\x01", "a"));
+
+  // Prefixes for a value sort before all of its entries, and after entries for
+  // lesser values.
+  auto value_prefix = LevelDbIndexEntryKey::KeyPrefix({"rooms"}, "a", "b");
+  ASSERT_KEY_LESS_THAN(entry("a", "z"), value_prefix);
+  ASSERT_KEY_LESS_THAN(value_prefix, entry("b", ""));
+  ASSERT_TRUE(StartsWith(entry("b", "x"),
+                         LevelDbIndexEntryKey::KeyPrefix({"rooms"}, "a")));
+  ASSERT_FALSE(StartsWith(entry("b", "x"),
+                          LevelDbIndexEntryKey::KeyPrefix({"rooms"}, "ab")));
+}
+
+TEST(LevelDbIndexEntryKeyTest, Description) {
+  ASSERT_EQ(
+      "[index_entry: path=rooms fieldPath=a indexValue=<YWI=> documentID=x]",
+      DescribeKey(LevelDbIndexEntryKey::Key({"rooms"}, "a", "ab", "x")));
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
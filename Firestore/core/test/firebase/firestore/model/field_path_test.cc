@@ -0,0 +1,74 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+TEST(FieldPath, PopFirstAndPopLast) {
+  const FieldPath path{"a", "b", "c"};
+
+  EXPECT_EQ(FieldPath({"b", "c"}), path.PopFirst());
+  EXPECT_EQ(FieldPath({"a", "b"}), path.PopLast());
+  EXPECT_EQ(FieldPath({"b"}), path.PopFirst().PopLast());
+  EXPECT_TRUE(path.PopFirst(3).empty());
+}
+
+TEST(FieldPath, FromServerFormat) {
+  EXPECT_EQ(FieldPath({"foo"}), FieldPath::FromServerFormat("foo"));
+  EXPECT_EQ(FieldPath({"foo", "bar", "baz"}),
+            FieldPath::FromServerFormat("foo.bar.baz"));
+  EXPECT_EQ(FieldPath({"foo.bar", "baz"}),
+            FieldPath::FromServerFormat("`foo.bar`.baz"));
+  EXPECT_EQ(FieldPath({"a`b", "c\\d"}),
+            FieldPath::FromServerFormat("a\\`b.c\\\\d"));
+
+  EXPECT_ANY_THROW(FieldPath::FromServerFormat(""));
+  EXPECT_ANY_THROW(FieldPath::FromServerFormat(".foo"));
+  EXPECT_ANY_THROW(FieldPath::FromServerFormat("foo."));
+  EXPECT_ANY_THROW(FieldPath::FromServerFormat("foo..bar"));
+  EXPECT_ANY_THROW(FieldPath::FromServerFormat("foo\\"));
+  EXPECT_ANY_THROW(FieldPath::FromServerFormat("`foo"));
+}
+
+TEST(FieldPath, CanonicalString) {
+  EXPECT_EQ("foo.bar", FieldPath({"foo", "bar"}).CanonicalString());
+  EXPECT_EQ("_a1", FieldPath({"_a1"}).CanonicalString());
+  EXPECT_EQ("`1a`", FieldPath({"1a"}).CanonicalString());
+  EXPECT_EQ("`foo.bar`.baz", FieldPath({"foo.bar", "baz"}).CanonicalString());
+  EXPECT_EQ("`a\\`b`", FieldPath({"a`b"}).CanonicalString());
+  EXPECT_EQ("`c\\\\d`", FieldPath({"c\\d"}).CanonicalString());
+
+  // Canonical strings round-trip through the server format.
+  const FieldPath path{"foo.bar", "a`b", "c\\d", "plain"};
+  EXPECT_EQ(path, FieldPath::FromServerFormat(path.CanonicalString()));
+}
+
+TEST(FieldPath, KeyFieldPath) {
+  EXPECT_TRUE(FieldPath::KeyFieldPath().IsKeyFieldPath());
+  EXPECT_TRUE(FieldPath({FieldPath::kDocumentKeyPath}).IsKeyFieldPath());
+  EXPECT_FALSE(FieldPath({"foo"}).IsKeyFieldPath());
+  EXPECT_FALSE(FieldPath::EmptyPath().IsKeyFieldPath());
+  EXPECT_TRUE(FieldPath::EmptyPath().empty());
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -17,9 +17,14 @@
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 
 #include <limits.h>
+#include <math.h>
+#include <string.h>
 
+#include <cstddef>
+#include <string>
 #include <vector>
 
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_counter.h"
 #include "gtest/gtest.h"
 
 namespace firebase {
@@ -34,6 +39,40 @@ const uint8_t* Bytes(const char* value) {
   return reinterpret_cast<const uint8_t*>(value);
 }
 
+/** Describes a FieldValue's type and payload, to test Visit. */
+struct Describer {
+  std::string operator()(FieldValue::TypeTag<Type::Null>,
+                         std::nullptr_t) const {
+    return "null";
+  }
+
+  std::string operator()(FieldValue::TypeTag<Type::Long>,
+                         int64_t value) const {
+    return "long " + std::to_string(value);
+  }
+
+  std::string operator()(FieldValue::TypeTag<Type::String>,
+                         absl::string_view value) const {
+    return "string " + std::string{value};
+  }
+
+  std::string operator()(FieldValue::TypeTag<Type::Blob>,
+                         absl::string_view value) const {
+    return "blob " + std::string{value};
+  }
+
+  std::string operator()(FieldValue::TypeTag<Type::Array>,
+                         const std::vector<FieldValue>& value) const {
+    return "array of " + std::to_string(value.size());
+  }
+
+  // The remaining types aren't exercised.
+  template <Type type, typename T>
+  std::string operator()(FieldValue::TypeTag<type>, const T&) const {
+    return "other";
+  }
+};
+
 }  // namespace
 
 TEST(FieldValue, NullType) {
@@ -128,9 +167,11 @@ TEST(FieldValue, StringType) {
   std::string xyz("xyz");
   const FieldValue b = FieldValue::StringValue(xyz);
   const FieldValue c = FieldValue::StringValue(std::move(xyz));
+  const FieldValue d = FieldValue::StringValue(absl::string_view("abcd", 3));
   EXPECT_EQ(Type::String, a.type());
   EXPECT_EQ(Type::String, b.type());
   EXPECT_EQ(Type::String, c.type());
+  EXPECT_EQ(a, d);
   EXPECT_TRUE(a < b);
   EXPECT_FALSE(a < a);
 }
@@ -197,6 +238,99 @@ TEST(FieldValue, ObjectType) {
   EXPECT_FALSE(large < small);
 }
 
+TEST(FieldValue, ObjectSetAndDeleteField) {
+  const FieldValue empty = FieldValue::ObjectValue(FieldValue::Map());
+  const FieldValue one = empty.SetField("a", FieldValue::TrueValue());
+  const FieldValue two = one.SetField("b", FieldValue::IntegerValue(1));
+  const FieldValue replaced = two.SetField("a", FieldValue::FalseValue());
+  const FieldValue deleted = replaced.DeleteField("b");
+
+  EXPECT_EQ(0u, empty.object_value().size());
+  EXPECT_EQ(1u, one.object_value().size());
+  EXPECT_EQ(2u, two.object_value().size());
+  EXPECT_EQ(
+      FieldValue::ObjectValue(std::map<const std::string, const FieldValue>{
+          {"a", FieldValue::FalseValue()},
+          {"b", FieldValue::IntegerValue(1)}}),
+      replaced);
+  EXPECT_EQ(
+      FieldValue::ObjectValue(std::map<const std::string, const FieldValue>{
+          {"a", FieldValue::FalseValue()}}),
+      deleted);
+
+  // The original values are unaffected.
+  EXPECT_EQ(FieldValue::TrueValue(), one.object_value().find("a")->second);
+  EXPECT_EQ(deleted.object_value().end(), deleted.object_value().find("b"));
+  EXPECT_NE(two.object_value().end(), two.object_value().find("b"));
+}
+
+TEST(FieldValue, LargeObjectSharesUnmodifiedFields) {
+  FieldValue::Map::Builder builder;
+  for (int i = 0; i < 1000; i++) {
+    builder.insert("field" + std::to_string(i), FieldValue::IntegerValue(i));
+  }
+  const FieldValue large = FieldValue::ObjectValue(builder.Build());
+  const FieldValue copy = large;
+  const FieldValue patched = large.SetField("field5", FieldValue::NullValue());
+
+  EXPECT_EQ(large, copy);
+  EXPECT_NE(large, patched);
+  EXPECT_EQ(1000u, patched.object_value().size());
+
+  // Copies and patches share untouched entries with the original.
+  EXPECT_EQ(&*large.object_value().find("field500"),
+            &*copy.object_value().find("field500"));
+  EXPECT_EQ(&*large.object_value().find("field500"),
+            &*patched.object_value().find("field500"));
+}
+
+TEST(FieldValue, ObjectGetSetAndDeletePath) {
+  const FieldValue empty = FieldValue::ObjectValue(FieldValue::Map());
+  const FieldValue nested =
+      empty.Set(FieldPath{"a", "b", "c"}, FieldValue::IntegerValue(1))
+          .Set(FieldPath{"a", "d"}, FieldValue::TrueValue())
+          .Set(FieldPath{"e"}, FieldValue::StringValue("f"));
+
+  EXPECT_EQ(&nested, nested.Get(FieldPath{}));
+  EXPECT_EQ(FieldValue::IntegerValue(1), *nested.Get(FieldPath{"a", "b", "c"}));
+  EXPECT_EQ(FieldValue::TrueValue(), *nested.Get(FieldPath{"a", "d"}));
+  EXPECT_EQ(FieldValue::Type::Object, nested.Get(FieldPath{"a"})->type());
+  EXPECT_EQ(nullptr, nested.Get(FieldPath{"a", "x"}));
+  EXPECT_EQ(nullptr, nested.Get(FieldPath{"e", "f"}));
+
+  // Setting through a primitive replaces it with an Object.
+  const FieldValue replaced =
+      nested.Set(FieldPath{"e", "g"}, FieldValue::NullValue());
+  EXPECT_EQ(FieldValue::NullValue(), *replaced.Get(FieldPath{"e", "g"}));
+  EXPECT_EQ(FieldValue::StringValue("f"), *nested.Get(FieldPath{"e"}));
+
+  const FieldValue deleted = nested.Delete(FieldPath{"a", "b", "c"});
+  EXPECT_EQ(nullptr, deleted.Get(FieldPath{"a", "b", "c"}));
+  EXPECT_EQ(0u, deleted.Get(FieldPath{"a", "b"})->object_value().size());
+  EXPECT_EQ(FieldValue::IntegerValue(1), *nested.Get(FieldPath{"a", "b", "c"}));
+
+  // Deleting through a missing or primitive value changes nothing.
+  EXPECT_EQ(nested, nested.Delete(FieldPath{"x", "y"}));
+  EXPECT_EQ(nested, nested.Delete(FieldPath{"e", "f"}));
+}
+
+TEST(FieldValue, ScalarAccessors) {
+  EXPECT_TRUE(FieldValue::TrueValue().boolean_value());
+  EXPECT_EQ(42, FieldValue::IntegerValue(42).integer_value());
+  EXPECT_EQ(1.5, FieldValue::DoubleValue(1.5).double_value());
+  EXPECT_EQ(Timestamp(100, 7),
+            FieldValue::TimestampValue(Timestamp(100, 7)).timestamp_value());
+  const FieldValue server_timestamp_value =
+      FieldValue::ServerTimestampValue(Timestamp(1, 2), Timestamp(3, 4));
+  const ServerTimestamp& server_timestamp =
+      server_timestamp_value.server_timestamp_value();
+  EXPECT_EQ(Timestamp(1, 2), server_timestamp.local_write_time);
+  EXPECT_TRUE(server_timestamp.has_previous_value_);
+  EXPECT_EQ(Timestamp(3, 4), server_timestamp.previous_value);
+  EXPECT_EQ(GeoPoint(1, 2),
+            FieldValue::GeoPointValue(GeoPoint(1, 2)).geo_point_value());
+}
+
 TEST(FieldValue, Copy) {
   FieldValue clone = FieldValue::TrueValue();
   const FieldValue null_value = FieldValue::NullValue();
@@ -330,6 +464,98 @@ TEST(FieldValue, Copy) {
   EXPECT_EQ(FieldValue::NullValue(), clone);
 }
 
+TEST(FieldValue, CopiesSharePayloads) {
+  const std::string long_string(100, 'x');
+  const FieldValue string_value = FieldValue::StringValue(long_string);
+  const FieldValue string_copy = string_value;
+  EXPECT_EQ(string_value.string_value().data(),
+            string_copy.string_value().data());
+
+  const FieldValue blob_value =
+      FieldValue::BlobValue(Bytes(long_string.c_str()), long_string.size());
+  FieldValue blob_copy;
+  blob_copy = blob_value;
+  EXPECT_EQ(blob_value.blob_data(), blob_copy.blob_data());
+
+  const FieldValue array_value = FieldValue::ArrayValue(
+      std::vector<FieldValue>(1000, FieldValue::StringValue(long_string)));
+  const FieldValue array_copy = array_value;
+  EXPECT_EQ(&array_value.array_value(), &array_copy.array_value());
+  EXPECT_EQ(array_value.array_value()[999].string_value().data(),
+            array_copy.array_value()[999].string_value().data());
+}
+
+TEST(FieldValue, ShortStringsAndBlobsAreInline) {
+  auto is_inline = [](const FieldValue& value, const void* data) {
+    auto begin = reinterpret_cast<const char*>(&value);
+    auto pointer = static_cast<const char*>(data);
+    return pointer >= begin && pointer < begin + sizeof(FieldValue);
+  };
+
+  // An auto-generated document ID.
+  const FieldValue short_string =
+      FieldValue::StringValue("0123456789abcdefghij");
+  EXPECT_TRUE(is_inline(short_string, short_string.string_value().data()));
+  EXPECT_EQ("0123456789abcdefghij", short_string.string_value());
+
+  const FieldValue short_blob = FieldValue::BlobValue(Bytes("abc"), 4);
+  EXPECT_TRUE(is_inline(short_blob, short_blob.blob_data()));
+  EXPECT_EQ(4u, short_blob.blob_size());
+  EXPECT_EQ(0, memcmp("abc", short_blob.blob_data(), 4));
+
+  const FieldValue empty_blob = FieldValue::BlobValue(nullptr, 0);
+  EXPECT_EQ(0u, empty_blob.blob_size());
+  EXPECT_EQ(FieldValue::BlobValue(Bytes(""), 0), empty_blob);
+
+  // Strings on either side of the inline limit compare and copy correctly.
+  for (size_t size = 20; size < 28; size++) {
+    std::string contents(size, 'a');
+    FieldValue value = FieldValue::StringValue(std::string(contents));
+    FieldValue copy = value;
+    EXPECT_EQ(contents, copy.string_value());
+    EXPECT_EQ(FieldValue::StringValue(contents), copy);
+
+    std::string longer = contents + "a";
+    EXPECT_LT(copy, FieldValue::StringValue(longer));
+    EXPECT_EQ(FieldValue::StringValue(longer).Hash(),
+              FieldValue::StringValue(longer.c_str()).Hash());
+
+    FieldValue moved = std::move(copy);
+    EXPECT_EQ(contents, moved.string_value());
+  }
+}
+
+TEST(FieldValue, MovedFromHeapValuesAreNull) {
+  FieldValue string_value = FieldValue::StringValue("abc");
+  FieldValue clone = std::move(string_value);
+  EXPECT_EQ(FieldValue::StringValue("abc"), clone);
+  EXPECT_EQ(Type::Null, string_value.type());  // NOLINT: use after move
+}
+
+TEST(FieldValue, MovesDoNotAllocate) {
+  const std::string long_string(100, 'x');
+  std::vector<FieldValue> values{
+      FieldValue::NullValue(),
+      FieldValue::IntegerValue(1),
+      FieldValue::StringValue("abc"),
+      FieldValue::StringValue(long_string),
+      FieldValue::BlobValue(Bytes(long_string.c_str()), long_string.size()),
+      FieldValue::ArrayValue(
+          std::vector<FieldValue>(10, FieldValue::StringValue(long_string))),
+      FieldValue::ObjectValue(std::map<const std::string, const FieldValue>{
+          {"a", FieldValue::StringValue(long_string)}}),
+  };
+
+  for (FieldValue& value : values) {
+    testutil::AllocationCounter counter;
+    FieldValue moved = std::move(value);
+    value = std::move(moved);
+    FieldValue assigned = FieldValue::NullValue();
+    assigned = std::move(value);
+    EXPECT_EQ(0u, counter.allocations()) << static_cast<int>(assigned.type());
+  }
+}
+
 TEST(FieldValue, Move) {
   FieldValue clone = FieldValue::TrueValue();
 
@@ -430,6 +656,53 @@ TEST(FieldValue, CompareMixedType) {
   EXPECT_TRUE(array_value < object_value);
 }
 
+TEST(FieldValue, ThreeWayCompare) {
+  using util::ComparisonResult;
+  const std::vector<FieldValue> ordered = {
+      FieldValue::NullValue(),
+      FieldValue::TrueValue(),
+      FieldValue::NanValue(),
+      FieldValue::IntegerValue(-1),
+      FieldValue::DoubleValue(0.5),
+      FieldValue::IntegerValue(1),
+      FieldValue::TimestampValue({100, 200}),
+      FieldValue::TimestampValue({100, 300}),
+      FieldValue::ServerTimestampValue({1, 2}),
+      FieldValue::StringValue(""),
+      FieldValue::StringValue("a"),
+      FieldValue::StringValue("ab"),
+      FieldValue::BlobValue(Bytes("a"), 1),
+      FieldValue::BlobValue(Bytes("a"), 2),
+      FieldValue::BlobValue(Bytes("b"), 1),
+      FieldValue::GeoPointValue({1, 2}),
+      FieldValue::ArrayValue(std::vector<FieldValue>()),
+      FieldValue::ArrayValue({FieldValue::IntegerValue(1)}),
+      FieldValue::ArrayValue(
+          {FieldValue::IntegerValue(1), FieldValue::NullValue()}),
+      FieldValue::ArrayValue({FieldValue::IntegerValue(2)}),
+      FieldValue::ObjectValue(FieldValue::Map{}),
+      FieldValue::ObjectValue(
+          FieldValue::Map{{"a", FieldValue::IntegerValue(1)}}),
+      FieldValue::ObjectValue(
+          FieldValue::Map{{"a", FieldValue::IntegerValue(2)}}),
+      FieldValue::ObjectValue(
+          FieldValue::Map{{"b", FieldValue::IntegerValue(0)}}),
+  };
+  for (size_t i = 0; i < ordered.size(); i++) {
+    for (size_t j = 0; j < ordered.size(); j++) {
+      ComparisonResult expected =
+          i < j ? ComparisonResult::Ascending
+                : (i > j ? ComparisonResult::Descending
+                         : ComparisonResult::Same);
+      EXPECT_EQ(expected, Compare(ordered[i], ordered[j]))
+          << "i=" << i << " j=" << j;
+      EXPECT_EQ(i < j, ordered[i] < ordered[j]);
+    }
+  }
+  EXPECT_EQ(ComparisonResult::Same, Compare(FieldValue::IntegerValue(1),
+                                            FieldValue::DoubleValue(1.0)));
+}
+
 TEST(FieldValue, CompareWithOperator) {
   const FieldValue small = FieldValue::NullValue();
   const FieldValue large = FieldValue::TrueValue();
@@ -457,6 +730,121 @@ TEST(FieldValue, CompareWithOperator) {
   EXPECT_FALSE(small == large);
 }
 
+TEST(FieldValue, EqualityAgreesWithOrdering) {
+  const std::vector<FieldValue> values = {
+      FieldValue::NullValue(),
+      FieldValue::FalseValue(),
+      FieldValue::TrueValue(),
+      FieldValue::NanValue(),
+      FieldValue::DoubleValue(-0.0),
+      FieldValue::IntegerValue(0),
+      FieldValue::DoubleValue(0.0),
+      FieldValue::DoubleValue(1.5),
+      FieldValue::IntegerValue(2),
+      FieldValue::DoubleValue(2.0),
+      FieldValue::DoubleValue(1e100),
+      FieldValue::TimestampValue({100, 200}),
+      FieldValue::ServerTimestampValue({100, 200}),
+      FieldValue::ServerTimestampValue({100, 200}, {1, 2}),
+      FieldValue::StringValue("abc"),
+      FieldValue::StringValue("abd"),
+      FieldValue::BlobValue(Bytes("abc"), 4),
+      FieldValue::GeoPointValue({1, 2}),
+      FieldValue::ArrayValue({FieldValue::IntegerValue(1)}),
+      FieldValue::ArrayValue({FieldValue::DoubleValue(1.0)}),
+      FieldValue::ObjectValue(
+          FieldValue::Map{{"a", FieldValue::IntegerValue(1)}}),
+      FieldValue::ObjectValue(
+          FieldValue::Map{{"a", FieldValue::StringValue("1")}}),
+  };
+  for (const FieldValue& lhs : values) {
+    for (const FieldValue& rhs : values) {
+      bool equal = !(lhs < rhs) && !(rhs < lhs);
+      EXPECT_EQ(equal, lhs == rhs);
+      EXPECT_EQ(!equal, lhs != rhs);
+      if (equal) {
+        EXPECT_EQ(lhs.Hash(), rhs.Hash());
+      }
+    }
+  }
+  // Repeat now that every hash is cached.
+  for (const FieldValue& lhs : values) {
+    for (const FieldValue& rhs : values) {
+      EXPECT_EQ(!(lhs < rhs) && !(rhs < lhs), lhs == rhs);
+    }
+  }
+}
+
+TEST(FieldValue, HashIsConsistentForNumbers) {
+  EXPECT_EQ(FieldValue::IntegerValue(42).Hash(),
+            FieldValue::DoubleValue(42.0).Hash());
+  EXPECT_EQ(FieldValue::DoubleValue(0.0).Hash(),
+            FieldValue::DoubleValue(-0.0).Hash());
+  EXPECT_EQ(FieldValue::NanValue().Hash(),
+            FieldValue::DoubleValue(-NAN).Hash());
+}
+
+TEST(FieldValue, HashSurvivesCopyAndMove) {
+  FieldValue value = FieldValue::ArrayValue(
+      {FieldValue::StringValue("abc"), FieldValue::IntegerValue(1)});
+  size_t hash = value.Hash();
+
+  FieldValue copy = value;
+  EXPECT_EQ(hash, copy.Hash());
+
+  FieldValue moved = std::move(copy);
+  EXPECT_EQ(hash, moved.Hash());
+  EXPECT_EQ(FieldValue::NullValue().Hash(), copy.Hash());
+
+  // Reassigning to a different type must not reuse the stale hash.
+  moved = FieldValue::IntegerValue(1);
+  EXPECT_EQ(FieldValue::IntegerValue(1).Hash(), moved.Hash());
+
+  FieldValue object = FieldValue::ObjectValue(FieldValue::Map{{"a", value}});
+  size_t object_hash = object.Hash();
+  FieldValue other = FieldValue::ObjectValue(FieldValue::Map{{"b", value}});
+  other = std::move(object);
+  EXPECT_EQ(object_hash, other.Hash());
+  // The moved-from object holds some other map, so must not keep the hash.
+  EXPECT_EQ(FieldValue::ObjectValue(object.object_value()).Hash(),
+            object.Hash());
+}
+
+TEST(FieldValue, Visit) {
+  EXPECT_EQ("null", Visit(FieldValue::NullValue(), Describer{}));
+  EXPECT_EQ("long 42", Visit(FieldValue::IntegerValue(42), Describer{}));
+  EXPECT_EQ("string abc", Visit(FieldValue::StringValue("abc"), Describer{}));
+  EXPECT_EQ("blob abc",
+            Visit(FieldValue::BlobValue(Bytes("abc"), 3), Describer{}));
+  EXPECT_EQ("array of 2",
+            Visit(FieldValue::ArrayValue(
+                      {FieldValue::TrueValue(), FieldValue::FalseValue()}),
+                  Describer{}));
+  EXPECT_EQ("other", Visit(FieldValue::DoubleValue(1.5), Describer{}));
+}
+
+TEST(FieldValue, CopiesBetweenTriviallyCopyableTypes) {
+  EXPECT_TRUE(FieldValue::IsTriviallyCopyable(Type::GeoPoint));
+  EXPECT_FALSE(FieldValue::IsTriviallyCopyable(Type::String));
+
+  FieldValue value = FieldValue::GeoPointValue({1.5, -2.25});
+  const FieldValue timestamp = FieldValue::ServerTimestampValue(
+      Timestamp(100, 200), Timestamp(300, 400));
+  value = timestamp;
+  EXPECT_EQ(timestamp, value);
+  EXPECT_EQ(300, value.server_timestamp_value().previous_value.seconds());
+
+  const FieldValue geo_point = FieldValue::GeoPointValue({1.5, -2.25});
+  value = geo_point;
+  EXPECT_EQ(Type::GeoPoint, value.type());
+  EXPECT_EQ(-2.25, value.geo_point_value().longitude());
+  EXPECT_EQ(geo_point.Hash(), value.Hash());
+
+  const FieldValue& self = value;
+  value = self;
+  EXPECT_EQ(geo_point, value);
+}
+
 }  //  namespace model
 }  //  namespace firestore
 }  //  namespace firebase
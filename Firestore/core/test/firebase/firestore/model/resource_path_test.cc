@@ -0,0 +1,163 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+TEST(ResourcePath, Constructor) {
+  const ResourcePath empty_path;
+  EXPECT_TRUE(empty_path.empty());
+  EXPECT_EQ(0u, empty_path.size());
+  EXPECT_TRUE(empty_path.begin() == empty_path.end());
+
+  const ResourcePath path_from_list{{"rooms", "Eros", "messages"}};
+  EXPECT_FALSE(path_from_list.empty());
+  EXPECT_EQ(3u, path_from_list.size());
+
+  const std::vector<std::string> segments{"rooms", "Eros", "messages"};
+  const ResourcePath path_from_segments{segments.begin(), segments.end()};
+  EXPECT_EQ(path_from_list, path_from_segments);
+}
+
+TEST(ResourcePath, Indexing) {
+  const ResourcePath path{"rooms", "Eros", "messages"};
+
+  EXPECT_EQ("rooms", path.first_segment());
+  EXPECT_EQ("rooms", path[0]);
+  EXPECT_EQ("Eros", path[1]);
+  EXPECT_EQ("messages", path[2]);
+  EXPECT_EQ("messages", path.last_segment());
+}
+
+TEST(ResourcePath, PopFirst) {
+  const ResourcePath path{"rooms", "Eros", "messages"};
+
+  EXPECT_EQ(ResourcePath({"Eros", "messages"}), path.PopFirst());
+  EXPECT_EQ(ResourcePath({"messages"}), path.PopFirst().PopFirst());
+  EXPECT_EQ(ResourcePath{}, path.PopFirst(3));
+  EXPECT_EQ(ResourcePath({"messages"}), path.PopFirst(2));
+
+  // The original path is unchanged.
+  EXPECT_EQ(ResourcePath({"rooms", "Eros", "messages"}), path);
+}
+
+TEST(ResourcePath, PopLast) {
+  const ResourcePath path{"rooms", "Eros", "messages"};
+
+  EXPECT_EQ(ResourcePath({"rooms", "Eros"}), path.PopLast());
+  EXPECT_EQ(ResourcePath({"rooms"}), path.PopLast().PopLast());
+  EXPECT_TRUE(path.PopLast().PopLast().PopLast().empty());
+  EXPECT_EQ(ResourcePath({"Eros"}), path.PopFirst().PopLast());
+}
+
+TEST(ResourcePath, Append) {
+  const ResourcePath path{"rooms"};
+  const ResourcePath appended = path.Append("Eros");
+  EXPECT_EQ(ResourcePath({"rooms", "Eros"}), appended);
+  EXPECT_EQ(ResourcePath({"rooms"}), path);
+
+  // Appending to a sliced path only keeps the sliced segments.
+  EXPECT_EQ(ResourcePath({"Eros", "messages"}),
+            appended.PopFirst().Append("messages"));
+  EXPECT_EQ(ResourcePath({"rooms", "Eros", "messages", "1"}),
+            appended.Append(ResourcePath{"messages", "1"}));
+}
+
+TEST(ResourcePath, Comparison) {
+  const ResourcePath abc{"a", "b", "c"};
+  const ResourcePath abc2{"a", "b", "c"};
+  const ResourcePath xyz{"x", "y", "z"};
+  EXPECT_EQ(abc, abc2);
+  EXPECT_NE(abc, xyz);
+  EXPECT_EQ(0, abc.CompareTo(abc2));
+
+  const ResourcePath empty;
+  const ResourcePath a{"a"};
+  const ResourcePath b{"b"};
+  const ResourcePath ab{"a", "b"};
+
+  EXPECT_TRUE(empty < a);
+  EXPECT_TRUE(a < b);
+  EXPECT_TRUE(a < ab);
+  EXPECT_TRUE(a > empty);
+  EXPECT_TRUE(b > a);
+  EXPECT_TRUE(ab > a);
+  EXPECT_LE(a, a);
+  EXPECT_GE(a, a);
+  EXPECT_EQ(-1, a.CompareTo(ab));
+  EXPECT_EQ(1, b.CompareTo(ab));
+
+  // Slices compare by their own segments.
+  EXPECT_EQ(b, ab.PopFirst());
+  EXPECT_EQ(a.Hash(), ab.PopLast().Hash());
+
+  // Comparison is by UTF-8 bytes, so uppercase sorts before lowercase.
+  EXPECT_TRUE(ResourcePath{"B"} < ResourcePath{"a"});
+}
+
+TEST(ResourcePath, IsPrefixOf) {
+  const ResourcePath empty;
+  const ResourcePath a{"a"};
+  const ResourcePath ab{"a", "b"};
+  const ResourcePath abc{"a", "b", "c"};
+  const ResourcePath b{"b"};
+  const ResourcePath ba{"b", "a"};
+
+  EXPECT_TRUE(empty.IsPrefixOf(empty));
+  EXPECT_TRUE(empty.IsPrefixOf(a));
+  EXPECT_TRUE(a.IsPrefixOf(a));
+  EXPECT_TRUE(a.IsPrefixOf(ab));
+  EXPECT_TRUE(ab.IsPrefixOf(abc));
+  EXPECT_TRUE(b.IsPrefixOf(abc.PopFirst()));
+
+  EXPECT_FALSE(a.IsPrefixOf(empty));
+  EXPECT_FALSE(b.IsPrefixOf(a));
+  EXPECT_FALSE(ab.IsPrefixOf(a));
+  EXPECT_FALSE(a.IsPrefixOf(ba));
+  EXPECT_FALSE(ba.IsPrefixOf(abc));
+}
+
+TEST(ResourcePath, FromString) {
+  EXPECT_EQ(ResourcePath({"rooms", "eros", "1"}),
+            ResourcePath::FromString("rooms/eros/1"));
+  EXPECT_EQ(ResourcePath({"rooms", "eros", "1"}),
+            ResourcePath::FromString("/rooms/eros/1/"));
+  EXPECT_EQ(ResourcePath({"a"}), ResourcePath::FromString("a"));
+  EXPECT_EQ(ResourcePath{}, ResourcePath::FromString(""));
+  EXPECT_EQ(ResourcePath{}, ResourcePath::FromString("/"));
+
+  EXPECT_ANY_THROW(ResourcePath::FromString("rooms//eros"));
+}
+
+TEST(ResourcePath, CanonicalString) {
+  EXPECT_EQ("rooms/eros/1",
+            ResourcePath::FromString("rooms/eros/1").CanonicalString());
+  EXPECT_EQ("", ResourcePath{}.CanonicalString());
+  EXPECT_EQ("eros/1", ResourcePath::FromString("rooms/eros/1")
+                          .PopFirst()
+                          .CanonicalString());
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+static_assert(SnapshotVersion::None() == SnapshotVersion(),
+              "None() should be the default version");
+static_assert(!(SnapshotVersion::None() < SnapshotVersion::None()),
+              "versions should be comparable at compile time");
+
+TEST(SnapshotVersion, Getter) {
+  const SnapshotVersion version(Timestamp(123, 456));
+  EXPECT_EQ(Timestamp(123, 456), version.timestamp());
+
+  EXPECT_EQ(Timestamp(), SnapshotVersion::None().timestamp());
+}
+
+TEST(SnapshotVersion, Comparison) {
+  EXPECT_TRUE(SnapshotVersion::None() < SnapshotVersion(Timestamp(0, 1)));
+  EXPECT_TRUE(SnapshotVersion(Timestamp(1, 2)) <
+              SnapshotVersion(Timestamp(2, 1)));
+  EXPECT_TRUE(SnapshotVersion(Timestamp(2, 1)) <
+              SnapshotVersion(Timestamp(2, 2)));
+  EXPECT_TRUE(SnapshotVersion(Timestamp(2, 2)) ==
+              SnapshotVersion(Timestamp(2, 2)));
+  EXPECT_TRUE(SnapshotVersion(Timestamp(2, 2)) !=
+              SnapshotVersion(Timestamp(2, 3)));
+  EXPECT_TRUE(SnapshotVersion(Timestamp(2, 3)) >=
+              SnapshotVersion(Timestamp(2, 2)));
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+TEST(BloomFilter, EmptyFilterContainsNothing) {
+  BloomFilter filter({}, 0, 0);
+  EXPECT_EQ(0, filter.bit_count());
+  EXPECT_FALSE(filter.MightContain(""));
+  EXPECT_FALSE(filter.MightContain("rooms/abc"));
+}
+
+TEST(BloomFilter, BitCountExcludesPadding) {
+  BloomFilter filter(std::vector<uint8_t>(4), 3, 2);
+  EXPECT_EQ(29, filter.bit_count());
+}
+
+TEST(BloomFilter, ValidatesParameters) {
+  EXPECT_TRUE(BloomFilter::IsValid(0, 0, 0));
+  EXPECT_TRUE(BloomFilter::IsValid(1, 7, 1));
+  EXPECT_FALSE(BloomFilter::IsValid(0, 1, 0));
+  EXPECT_FALSE(BloomFilter::IsValid(0, 0, -1));
+  EXPECT_FALSE(BloomFilter::IsValid(1, 8, 1));
+  EXPECT_FALSE(BloomFilter::IsValid(1, -1, 1));
+  EXPECT_FALSE(BloomFilter::IsValid(1, 0, 0));
+}
+
+TEST(BloomFilter, ZeroedFilterContainsNothing) {
+  BloomFilter filter(std::vector<uint8_t>(16), 0, 5);
+  EXPECT_FALSE(filter.MightContain("rooms/abc"));
+}
+
+TEST(BloomFilter, FullFilterContainsEverything) {
+  BloomFilter filter(std::vector<uint8_t>(16, 0xff), 0, 5);
+  EXPECT_TRUE(filter.MightContain("rooms/abc"));
+}
+
+// A filter built by the backend over the single key "ÀÒ∑": 11 bits, 8 hashes.
+TEST(BloomFilter, MatchesBackendHashing) {
+  BloomFilter filter({237, 5}, 5, 8);
+  EXPECT_TRUE(filter.MightContain(u8"\u00c0\u00d2\u2211"));
+  EXPECT_FALSE(filter.MightContain(u8"\u00d2\u2211\u00c0"));
+
+  BloomFilter rebuilt({0, 0}, 5, 8);
+  rebuilt.Insert(u8"\u00c0\u00d2\u2211");
+  EXPECT_EQ(filter.bitmap(), rebuilt.bitmap());
+}
+
+TEST(BloomFilter, ContainsInsertedKeys) {
+  BloomFilter filter = BloomFilter::WithExpectedCount(100);
+  for (int i = 0; i < 100; i++) {
+    filter.Insert("rooms/" + std::to_string(i));
+  }
+  for (int i = 0; i < 100; i++) {
+    EXPECT_TRUE(filter.MightContain("rooms/" + std::to_string(i)));
+  }
+}
+
+TEST(BloomFilter, HasFewFalsePositives) {
+  BloomFilter filter = BloomFilter::WithExpectedCount(1000);
+  for (int i = 0; i < 1000; i++) {
+    filter.Insert("rooms/" + std::to_string(i));
+  }
+  int false_positives = 0;
+  for (int i = 1000; i < 11000; i++) {
+    if (filter.MightContain("rooms/" + std::to_string(i))) {
+      false_positives++;
+    }
+  }
+  // The filter is sized for 1%; allow some slack.
+  EXPECT_LT(false_positives, 300);
+}
+
+TEST(BloomFilter, RoundTripsThroughBitmap) {
+  BloomFilter filter = BloomFilter::WithExpectedCount(10);
+  filter.Insert("rooms/a");
+  BloomFilter copy(filter.bitmap(), filter.padding(), filter.hash_count());
+  EXPECT_TRUE(copy.MightContain("rooms/a"));
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
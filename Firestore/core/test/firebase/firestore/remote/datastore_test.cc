@@ -17,12 +17,176 @@
 #include "Firestore/core/src/firebase/firestore/remote/datastore.h"
 
 #include <grpc/grpc.h>
+
+#include <chrono>              // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <vector>
+
 #include <gtest/gtest.h>
 
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+/** An executor whose tasks run on the test's thread when it asks for them. */
+class TestExecutor {
+ public:
+  Executor executor() {
+    return [this](std::function<void()> task) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back(std::move(task));
+      condition_.notify_one();
+    };
+  }
+
+  /** Runs tasks as they arrive until done() returns true. */
+  void RunUntil(const std::function<bool()>& done) {
+    while (!done()) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        bool has_task = condition_.wait_for(lock, std::chrono::seconds(10),
+                                            [this] { return !tasks_.empty(); });
+        ASSERT_TRUE(has_task) << "Timed out waiting for a callback";
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+  /** Runs the tasks that have already arrived. */
+  void RunPending() {
+    std::deque<std::function<void()>> tasks;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks.swap(tasks_);
+    }
+    for (const auto& task : tasks) {
+      task();
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<std::function<void()>> tasks_;
+};
+
+class RecordingObserver : public GrpcStreamObserver {
+ public:
+  void OnStreamOpen() override {
+    events.push_back("open");
+  }
+
+  void OnStreamRead(const std::string& message) override {
+    events.push_back("read " + message);
+  }
+
+  void OnStreamFinish(grpc_status_code status,
+                      const std::string& error_message) override {
+    events.push_back("finish");
+    finished = true;
+    finish_status = status;
+    finish_message = error_message;
+  }
+
+  std::vector<std::string> events;
+  bool finished = false;
+  grpc_status_code finish_status = GRPC_STATUS_OK;
+  std::string finish_message;
+};
+
+/** Returns a channel whose calls all fail with UNAVAILABLE. */
+grpc_channel* UnavailableChannel() {
+  return grpc_lame_client_channel_create("firestore.googleapis.com",
+                                         GRPC_STATUS_UNAVAILABLE,
+                                         "Backend unavailable");
+}
+
+class DatastoreTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    grpc_init();
+  }
+
+  void TearDown() override {
+    grpc_shutdown();
+  }
+
+  TestExecutor executor_;
+};
+
+}  // namespace
+
 TEST(Datastore, CanLinkToGrpc) {
   // This test doesn't actually do anything interesting as far as actually
   // using gRPC is concerned but that it can run at all is proof that all the
   // libraries required for gRPC to work are actually linked correctly into the
   // test.
   grpc_init();
+  grpc_shutdown();
+}
+
+TEST_F(DatastoreTest, CommitReportsFailures) {
+  Datastore datastore{UnavailableChannel(), executor_.executor()};
+
+  bool called = false;
+  grpc_status_code status = GRPC_STATUS_OK;
+  std::string error_message;
+  datastore.Commit("request", {{"authorization", "Bearer owner"}},
+                   [&](grpc_status_code call_status,
+                       const std::string& call_error_message,
+                       const std::string& response) {
+                     called = true;
+                     status = call_status;
+                     error_message = call_error_message;
+                     EXPECT_EQ("", response);
+                   });
+
+  executor_.RunUntil([&] { return called; });
+  EXPECT_EQ(GRPC_STATUS_UNAVAILABLE, status);
+  EXPECT_EQ("Backend unavailable", error_message);
 }
+
+TEST_F(DatastoreTest, StreamReportsFailures) {
+  Datastore datastore{UnavailableChannel(), executor_.executor()};
+
+  RecordingObserver observer;
+  std::shared_ptr<GrpcStream> stream =
+      datastore.CreateWatchStream({}, &observer);
+  stream->Start();
+  stream->Write("request");
+
+  executor_.RunUntil([&] { return observer.finished; });
+  EXPECT_EQ(GRPC_STATUS_UNAVAILABLE, observer.finish_status);
+  EXPECT_EQ("Backend unavailable", observer.finish_message);
+  EXPECT_EQ("finish", observer.events.back());
+}
+
+TEST_F(DatastoreTest, FinishedStreamEmitsNoEvents) {
+  RecordingObserver observer;
+  {
+    Datastore datastore{UnavailableChannel(), executor_.executor()};
+    std::shared_ptr<GrpcStream> stream =
+        datastore.CreateWriteStream({}, &observer);
+    stream->Start();
+    stream->Finish();
+    stream->Write("request");
+  }
+
+  // Destroying the Datastore drains all of the stream's operations.
+  executor_.RunPending();
+  EXPECT_TRUE(observer.events.empty());
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,198 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/wire_decoder.h"
+
+#include <string.h>
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using model::FieldValue;
+using model::Timestamp;
+
+namespace {
+
+std::string Varint(uint64_t value) {
+  std::string result;
+  while (value >= 0x80) {
+    result.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  result.push_back(static_cast<char>(value));
+  return result;
+}
+
+std::string Tag(uint32_t field, int wire_type) {
+  return Varint((field << 3) | wire_type);
+}
+
+std::string VarintField(uint32_t field, uint64_t value) {
+  return Tag(field, 0) + Varint(value);
+}
+
+std::string DoubleField(uint32_t field, double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  std::string result = Tag(field, 1);
+  for (int i = 0; i < 8; i++) {
+    result.push_back(static_cast<char>(bits >> (8 * i)));
+  }
+  return result;
+}
+
+std::string BytesField(uint32_t field, const std::string& value) {
+  return Tag(field, 2) + Varint(value.size()) + value;
+}
+
+std::string MapEntry(const std::string& key, const std::string& value) {
+  return BytesField(1, key) + BytesField(2, value);
+}
+
+/** Wraps an integer value in `depth` arrays, alternating with maps. */
+std::string NestedValue(int depth) {
+  std::string value = VarintField(2, 1);
+  for (int i = 0; i < depth; i++) {
+    if (i % 2 == 0) {
+      value = BytesField(9, BytesField(1, value));
+    } else {
+      value = BytesField(6, BytesField(1, MapEntry("a", value)));
+    }
+  }
+  return value;
+}
+
+FieldValue Decode(const std::string& bytes) {
+  FieldValue result;
+  EXPECT_TRUE(WireDecoder::DecodeValue(bytes, &result));
+  return result;
+}
+
+}  // namespace
+
+TEST(WireDecoder, DecodesScalars) {
+  EXPECT_EQ(FieldValue::NullValue(), Decode(VarintField(11, 0)));
+  EXPECT_EQ(FieldValue::TrueValue(), Decode(VarintField(1, 1)));
+  EXPECT_EQ(FieldValue::FalseValue(), Decode(VarintField(1, 0)));
+  EXPECT_EQ(FieldValue::IntegerValue(-1),
+            Decode(VarintField(2, static_cast<uint64_t>(-1))));
+  EXPECT_EQ(FieldValue::DoubleValue(1.5), Decode(DoubleField(3, 1.5)));
+  EXPECT_EQ(FieldValue::StringValue("hello"),
+            Decode(BytesField(17, "hello")));
+
+  const uint8_t blob[] = {0, 1, 2};
+  EXPECT_EQ(FieldValue::BlobValue(blob, sizeof(blob)),
+            Decode(BytesField(18, std::string("\0\1\2", 3))));
+}
+
+TEST(WireDecoder, DecodesTimestampsAndGeoPoints) {
+  std::string timestamp = VarintField(1, 100) + VarintField(2, 5);
+  EXPECT_EQ(FieldValue::TimestampValue(Timestamp{100, 5}),
+            Decode(BytesField(10, timestamp)));
+
+  std::string lat_lng = DoubleField(1, 1.5) + DoubleField(2, -2.5);
+  EXPECT_EQ(FieldValue::GeoPointValue(GeoPoint{1.5, -2.5}),
+            Decode(BytesField(8, lat_lng)));
+}
+
+TEST(WireDecoder, DecodesArraysAndMaps) {
+  std::string array =
+      BytesField(1, VarintField(2, 1)) + BytesField(1, BytesField(17, "a"));
+  EXPECT_EQ(FieldValue::ArrayValue(
+                {FieldValue::IntegerValue(1), FieldValue::StringValue("a")}),
+            Decode(BytesField(9, array)));
+
+  // Entries aren't sorted on the wire.
+  std::string map = BytesField(1, MapEntry("b", VarintField(2, 2))) +
+                    BytesField(1, MapEntry("a", VarintField(2, 1)));
+  FieldValue::Map expected{{"a", FieldValue::IntegerValue(1)},
+                           {"b", FieldValue::IntegerValue(2)}};
+  EXPECT_EQ(FieldValue::ObjectValue(expected), Decode(BytesField(6, map)));
+}
+
+TEST(WireDecoder, RejectsUnsupportedAndMalformedValues) {
+  FieldValue value;
+  EXPECT_FALSE(WireDecoder::DecodeValue(BytesField(5, "projects/p"), &value));
+  EXPECT_FALSE(WireDecoder::DecodeValue("", &value));
+  EXPECT_FALSE(WireDecoder::DecodeValue(Tag(17, 2) + Varint(10), &value));
+  EXPECT_FALSE(WireDecoder::DecodeValue(VarintField(17, 1), &value));
+
+  std::string bad_nanos = VarintField(2, 1000000000);
+  EXPECT_FALSE(WireDecoder::DecodeValue(BytesField(10, bad_nanos), &value));
+}
+
+TEST(WireDecoder, LimitsNestingDepth) {
+  FieldValue value;
+  EXPECT_TRUE(WireDecoder::DecodeValue(NestedValue(100), &value));
+  EXPECT_FALSE(WireDecoder::DecodeValue(NestedValue(101), &value));
+  EXPECT_FALSE(WireDecoder::DecodeValue(NestedValue(10000), &value));
+
+  DecodedDocument document;
+  std::string fields = BytesField(2, MapEntry("a", NestedValue(100)));
+  EXPECT_TRUE(WireDecoder::DecodeDocument(fields, &document));
+  fields = BytesField(2, MapEntry("a", NestedValue(101)));
+  EXPECT_FALSE(WireDecoder::DecodeDocument(fields, &document));
+}
+
+TEST(WireDecoder, SkipsUnknownFields) {
+  EXPECT_EQ(FieldValue::IntegerValue(3),
+            Decode(BytesField(100, "future") + VarintField(2, 3)));
+}
+
+TEST(WireDecoder, DecodesListenResponseDocumentChanges) {
+  std::string name = "projects/p/databases/d/documents/rooms/a";
+  std::string document = BytesField(1, name) +
+                         BytesField(2, MapEntry("n", VarintField(2, 1))) +
+                         BytesField(4, VarintField(1, 7));
+  std::string packed_targets = Varint(1) + Varint(2);
+  std::string change = BytesField(1, document) + BytesField(5, packed_targets) +
+                       VarintField(6, 3);
+  std::string response = BytesField(3, change);
+
+  DecodedDocumentChange decoded;
+  bool is_document_change;
+  ASSERT_TRUE(WireDecoder::DecodeListenResponse(response, &decoded,
+                                                &is_document_change));
+  ASSERT_TRUE(is_document_change);
+  EXPECT_EQ(name, decoded.document.name);
+  FieldValue::Map expected{{"n", FieldValue::IntegerValue(1)}};
+  EXPECT_EQ(FieldValue::ObjectValue(expected), decoded.document.data);
+  EXPECT_EQ(7, decoded.document.update_time.seconds());
+  EXPECT_EQ((std::vector<int32_t>{1, 2}), decoded.target_ids);
+  EXPECT_EQ((std::vector<int32_t>{3}), decoded.removed_target_ids);
+
+  // The name points into the response rather than being copied.
+  EXPECT_GE(decoded.document.name.data(), response.data());
+  EXPECT_LT(decoded.document.name.data(), response.data() + response.size());
+}
+
+TEST(WireDecoder, IgnoresOtherListenResponses) {
+  std::string target_change = BytesField(2, VarintField(1, 1));
+  DecodedDocumentChange decoded;
+  bool is_document_change = true;
+  ASSERT_TRUE(WireDecoder::DecodeListenResponse(target_change, &decoded,
+                                                &is_document_change));
+  EXPECT_FALSE(is_document_change);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
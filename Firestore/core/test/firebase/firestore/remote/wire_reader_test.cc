@@ -0,0 +1,101 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/wire_reader.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+TEST(WireReader, ReadsVarints) {
+  // 1, 300 and UINT64_MAX.
+  std::string bytes{"\x01\xac\x02\xff\xff\xff\xff\xff\xff\xff\xff\xff\x01", 13};
+  WireReader reader{bytes};
+  uint64_t value;
+  ASSERT_TRUE(reader.ReadVarint(&value));
+  EXPECT_EQ(1u, value);
+  ASSERT_TRUE(reader.ReadVarint(&value));
+  EXPECT_EQ(300u, value);
+  ASSERT_TRUE(reader.ReadVarint(&value));
+  EXPECT_EQ(UINT64_MAX, value);
+  EXPECT_TRUE(reader.done());
+}
+
+TEST(WireReader, RejectsTruncatedVarints) {
+  WireReader reader{absl::string_view{"\xac", 1}};
+  uint64_t value;
+  EXPECT_FALSE(reader.ReadVarint(&value));
+}
+
+TEST(WireReader, ReadsTagsAndFixedFields) {
+  // Field 1, fixed64 1; field 2, fixed32 2.
+  std::string bytes{"\x09\x01\x00\x00\x00\x00\x00\x00\x00\x15\x02\x00\x00\x00",
+                    14};
+  WireReader reader{bytes};
+  uint32_t field;
+  WireType wire_type;
+  ASSERT_TRUE(reader.ReadTag(&field, &wire_type));
+  EXPECT_EQ(1u, field);
+  EXPECT_EQ(WireType::Fixed64, wire_type);
+  uint64_t fixed64;
+  ASSERT_TRUE(reader.ReadFixed64(&fixed64));
+  EXPECT_EQ(1u, fixed64);
+
+  ASSERT_TRUE(reader.ReadTag(&field, &wire_type));
+  EXPECT_EQ(2u, field);
+  EXPECT_EQ(WireType::Fixed32, wire_type);
+  uint32_t fixed32;
+  ASSERT_TRUE(reader.ReadFixed32(&fixed32));
+  EXPECT_EQ(2u, fixed32);
+  EXPECT_TRUE(reader.done());
+}
+
+TEST(WireReader, ReadsLengthDelimitedFieldsAsViews) {
+  std::string bytes{"\x03" "abcd"};
+  WireReader reader{bytes};
+  absl::string_view value;
+  ASSERT_TRUE(reader.ReadLengthDelimited(&value));
+  EXPECT_EQ("abc", value);
+  EXPECT_EQ(bytes.data() + 1, value.data());
+  EXPECT_FALSE(reader.done());
+}
+
+TEST(WireReader, RejectsOverlongLengths) {
+  WireReader reader{absl::string_view{"\x05" "abc"}};
+  absl::string_view value;
+  EXPECT_FALSE(reader.ReadLengthDelimited(&value));
+}
+
+TEST(WireReader, SkipsFields) {
+  // Field 1, string "ab"; then field 2, varint 7.
+  std::string bytes{"\x0a\x02" "ab" "\x10\x07"};
+  WireReader reader{bytes};
+  uint32_t field;
+  WireType wire_type;
+  ASSERT_TRUE(reader.ReadTag(&field, &wire_type));
+  ASSERT_TRUE(reader.SkipField(wire_type));
+  ASSERT_TRUE(reader.ReadTag(&field, &wire_type));
+  EXPECT_EQ(2u, field);
+  EXPECT_FALSE(reader.SkipField(WireType::StartGroup));
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace firebase {
+namespace firestore {
+namespace testutil {
+namespace {
+
+// Plain thread_local integers need no dynamic initialization, so they are safe
+// to touch from operator new even before main() runs.
+thread_local size_t allocation_count = 0;
+thread_local size_t allocated_bytes = 0;
+thread_local size_t deallocation_count = 0;
+
+}  // namespace
+
+AllocationCounter::AllocationCounter() {
+  Reset();
+}
+
+size_t AllocationCounter::allocations() const {
+  return allocation_count - start_allocations_;
+}
+
+size_t AllocationCounter::bytes() const {
+  return allocated_bytes - start_bytes_;
+}
+
+size_t AllocationCounter::deallocations() const {
+  return deallocation_count - start_deallocations_;
+}
+
+void AllocationCounter::Reset() {
+  start_allocations_ = allocation_count;
+  start_bytes_ = allocated_bytes;
+  start_deallocations_ = deallocation_count;
+}
+
+namespace {
+
+void* CountedAllocate(size_t size) {
+  allocation_count++;
+  allocated_bytes += size;
+  void* result = std::malloc(size == 0 ? 1 : size);
+  if (!result) {
+    throw std::bad_alloc();
+  }
+  return result;
+}
+
+void CountedFree(void* ptr) {
+  if (ptr) {
+    deallocation_count++;
+    std::free(ptr);
+  }
+}
+
+}  // namespace
+}  // namespace testutil
+}  // namespace firestore
+}  // namespace firebase
+
+// The standard library's array and nothrow forms of operator new and delete
+// forward to these, so replacing the two basic forms counts every allocation
+// made through new expressions and std::allocator.
+
+void* operator new(size_t size) {
+  return firebase::firestore::testutil::CountedAllocate(size);
+}
+
+void* operator new[](size_t size) {
+  return firebase::firestore::testutil::CountedAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  firebase::firestore::testutil::CountedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  firebase::firestore::testutil::CountedFree(ptr);
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_TESTUTIL_ALLOCATION_COUNTER_H_
+#define FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_TESTUTIL_ALLOCATION_COUNTER_H_
+
+#include <cstddef>
+
+namespace firebase {
+namespace firestore {
+namespace testutil {
+
+/**
+ * Counts the heap allocations made by the current thread while it is alive.
+ *
+ * Linking firebase_firestore_testutil_allocations into a test binary replaces
+ * the global operator new and operator delete with versions that keep per
+ * thread totals; an AllocationCounter reports how far those totals have moved
+ * since it was constructed. Counters may be nested, and allocations made on
+ * other threads are never included.
+ *
+ * Typical use:
+ *
+ *     AllocationCounter counter;
+ *     auto result = map.insert(1, 2);
+ *     EXPECT_EQ(1, counter.allocations());
+ */
+class AllocationCounter {
+ public:
+  AllocationCounter();
+
+  AllocationCounter(const AllocationCounter&) = delete;
+  AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+  /** Returns the number of calls to operator new since construction. */
+  size_t allocations() const;
+
+  /** Returns the total number of bytes requested since construction. */
+  size_t bytes() const;
+
+  /** Returns the number of calls to operator delete since construction. */
+  size_t deallocations() const;
+
+  /** Restarts counting from zero. */
+  void Reset();
+
+ private:
+  size_t start_allocations_;
+  size_t start_bytes_;
+  size_t start_deallocations_;
+};
+
+}  // namespace testutil
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_TESTUTIL_ALLOCATION_COUNTER_H_
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+const auto kTimeout = std::chrono::seconds(5);
+
+class AsyncQueueTest : public ::testing::Test {
+ public:
+  AsyncQueueTest() : queue{std::unique_ptr<Executor>(new ExecutorStd())} {
+  }
+
+  /** Waits until the future is ready; returns false on timeout. */
+  template <typename T>
+  static bool WaitFor(const std::future<T>& future) {
+    return future.wait_for(kTimeout) == std::future_status::ready;
+  }
+
+  AsyncQueue queue;
+};
+
+}  // namespace
+
+TEST_F(AsyncQueueTest, Enqueue) {
+  std::promise<void> signal;
+  queue.Enqueue([&signal] { signal.set_value(); });
+  EXPECT_TRUE(WaitFor(signal.get_future()));
+}
+
+TEST_F(AsyncQueueTest, EnqueueDisallowsNesting) {
+  std::promise<void> signal;
+  queue.Enqueue([&] {
+    EXPECT_ANY_THROW(queue.Enqueue([] {}));
+    signal.set_value();
+  });
+  EXPECT_TRUE(WaitFor(signal.get_future()));
+}
+
+TEST_F(AsyncQueueTest, EnqueueAllowingSameQueueOnNonEmptyQueue) {
+  std::string steps;
+  std::promise<void> signal;
+  queue.Enqueue([&] {
+    steps += '1';
+    queue.EnqueueAllowingSameQueue([&] {
+      steps += '3';
+      signal.set_value();
+    });
+    steps += '2';
+  });
+  EXPECT_TRUE(WaitFor(signal.get_future()));
+  EXPECT_EQ("123", steps);
+}
+
+TEST_F(AsyncQueueTest, EnqueueAfterDelayRunsInOrderOfDeadline) {
+  std::string steps;
+  std::promise<void> signal;
+  queue.Enqueue([&] {
+    queue.EnqueueAfterDelay(AsyncQueue::Milliseconds(20), [&] {
+      steps += '3';
+      signal.set_value();
+    });
+    queue.EnqueueAfterDelay(AsyncQueue::Milliseconds(10),
+                            [&] { steps += '2'; });
+    queue.EnqueueAllowingSameQueue([&] { steps += '1'; });
+  });
+  EXPECT_TRUE(WaitFor(signal.get_future()));
+  EXPECT_EQ("123", steps);
+}
+
+TEST_F(AsyncQueueTest, VerifyIsCurrentQueue) {
+  EXPECT_ANY_THROW(queue.VerifyIsCurrentQueue());
+
+  std::promise<void> signal;
+  queue.Enqueue([&] {
+    EXPECT_NO_THROW(queue.VerifyIsCurrentQueue());
+    signal.set_value();
+  });
+  EXPECT_TRUE(WaitFor(signal.get_future()));
+}
+
+TEST_F(AsyncQueueTest, RunInBackgroundJoinsBackOnQueue) {
+  WorkStealingPool pool{2};
+  AsyncQueue background_queue{std::unique_ptr<Executor>(new ExecutorStd()),
+                              &pool};
+
+  auto result = std::make_shared<int>(0);
+  std::promise<void> signal;
+  background_queue.RunInBackground(
+      [result] { *result = 42; },
+      [&, result] {
+        EXPECT_NO_THROW(background_queue.VerifyIsCurrentQueue());
+        EXPECT_EQ(42, *result);
+        signal.set_value();
+      });
+  EXPECT_TRUE(WaitFor(signal.get_future()));
+}
+
+TEST_F(AsyncQueueTest, RunInBackgroundWithoutPoolRunsOnQueue) {
+  std::promise<void> signal;
+  queue.RunInBackground([&] { EXPECT_NO_THROW(queue.VerifyIsCurrentQueue()); },
+                        [&] { signal.set_value(); });
+  EXPECT_TRUE(WaitFor(signal.get_future()));
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -18,9 +18,14 @@
 
 #include <ctype.h>
 
+#include <set>
+#include <string>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 using firebase::firestore::util::CreateAutoId;
+using firebase::firestore::util::CreateAutoIds;
 
 TEST(AutoId, IsSane) {
   for (int i = 0; i < 50; i++) {
@@ -34,3 +39,22 @@ TEST(AutoId, IsSane) {
     }
   }
 }
+
+TEST(AutoId, CreatesManyAtOnce) {
+  std::vector<std::string> auto_ids = CreateAutoIds(100);
+  ASSERT_EQ(100u, auto_ids.size());
+
+  std::set<std::string> unique;
+  for (const std::string& auto_id : auto_ids) {
+    EXPECT_EQ(20u, auto_id.length());
+    for (char c : auto_id) {
+      EXPECT_TRUE(isalpha(c) || isdigit(c))
+          << "Should be printable ascii character: '" << c << "' in \""
+          << auto_id << "\"";
+    }
+    unique.insert(auto_id);
+  }
+  EXPECT_EQ(auto_ids.size(), unique.size());
+
+  EXPECT_TRUE(CreateAutoIds(0).empty());
+}
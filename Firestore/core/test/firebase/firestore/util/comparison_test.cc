@@ -63,6 +63,31 @@ TEST(Comparison, StringCompare) {
   ASSERT_SAME(Compare<absl::string_view>("a", "a"));
 }
 
+TEST(Comparison, Utf8Compare) {
+  // Bytes compare as unsigned, so multi-byte sequences sort after ASCII.
+  ASSERT_ASCENDING(CompareUtf8("\x7f", "\x80"));
+  ASSERT_ASCENDING(CompareUtf8("z", "\xc3\xa9"));  // U+00E9
+
+  // U+FFFF sorts before U+1F600, which UTF-16 would encode as a surrogate pair
+  // starting with 0xD83D and sort first.
+  ASSERT_ASCENDING(CompareUtf8("\xef\xbf\xbf", "\xf0\x9f\x98\x80"));
+  ASSERT_DESCENDING(CompareUtf8("\xf0\x9f\x98\x80", "\xef\xbf\xbf"));
+
+  // Embedded NULs are compared like any other byte.
+  ASSERT_DESCENDING(CompareUtf8(absl::string_view("a\0b", 3), "a"));
+  ASSERT_ASCENDING(CompareUtf8(absl::string_view("a\0b", 3), "ab"));
+  ASSERT_SAME(CompareUtf8(absl::string_view("a\0b", 3),
+                          absl::string_view("a\0b", 3)));
+
+  ASSERT_SAME(CompareUtf8("", ""));
+  ASSERT_ASCENDING(CompareUtf8("rooms/a", "rooms/b"));
+  ASSERT_ASCENDING(CompareUtf8("rooms", "rooms/a"));
+
+  Comparator<absl::string_view> less_than;
+  ASSERT_TRUE(less_than("\xef\xbf\xbf", "\xf0\x9f\x98\x80"));
+  ASSERT_FALSE(less_than("a", "a"));
+}
+
 TEST(Comparison, BooleanCompare) {
   ASSERT_SAME(Compare<bool>(false, false));
   ASSERT_SAME(Compare<bool>(true, true));
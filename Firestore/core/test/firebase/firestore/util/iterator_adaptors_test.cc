@@ -1274,4 +1274,67 @@ TEST_F(IteratorAdaptorTest, BaseIterDanglingRefSecond) {
   EXPECT_EQ(&iter2.base()->second.d, &iter2->d);
 }
 
+TEST_F(IteratorAdaptorTest, IteratorRange) {
+  using firebase::firestore::util::make_iterator_range;
+
+  std::vector<int> vec = {0, 1, 2, 3, 4};
+  EXPECT_THAT(make_iterator_range(vec.begin() + 1, vec.end() - 1),
+              ElementsAre(1, 2, 3));
+  EXPECT_TRUE(make_iterator_range(vec.begin(), vec.begin()).empty());
+}
+
+TEST_F(IteratorAdaptorTest, FilteredView) {
+  using firebase::firestore::util::filtered_view;
+
+  std::vector<int> vec = {0, 1, 2, 3, 4, 5, 6};
+  auto is_odd = [](int i) { return i % 2 == 1; };
+  EXPECT_THAT(filtered_view(vec, is_odd), ElementsAre(1, 3, 5));
+  EXPECT_TRUE(filtered_view(vec, [](int i) { return i > 6; }).empty());
+
+  std::map<int, std::string> map = {{1, "a"}, {2, "b"}, {3, "c"}};
+  auto odd_keys = [](const std::pair<const int, std::string>& entry) {
+    return entry.first % 2 == 1;
+  };
+  EXPECT_THAT(filtered_view(map, odd_keys),
+              ElementsAre(Pair(1, "a"), Pair(3, "c")));
+}
+
+TEST_F(IteratorAdaptorTest, FilteredViewEvaluatesPredicateAsItAdvances) {
+  using firebase::firestore::util::filtered_view;
+
+  std::vector<int> vec = {0, 1, 2, 3, 4, 5, 6};
+  int calls = 0;
+  auto view = filtered_view(vec, [&calls](int i) {
+    calls++;
+    return i >= 2;
+  });
+
+  // Finding the first match stops at 2.
+  auto iter = view.begin();
+  EXPECT_EQ(2, *iter);
+  EXPECT_EQ(3, calls);
+
+  ++iter;
+  EXPECT_EQ(3, *iter);
+  EXPECT_EQ(4, calls);
+}
+
+TEST_F(IteratorAdaptorTest, TransformedView) {
+  using firebase::firestore::util::filtered_view;
+  using firebase::firestore::util::transformed_view;
+
+  std::vector<int> vec = {0, 1, 2, 3};
+  EXPECT_THAT(transformed_view(vec, [](int i) { return i * 10; }),
+              ElementsAre(0, 10, 20, 30));
+
+  // Views compose without copying the underlying container.
+  typedef std::pair<const int, std::string> Entry;
+  std::map<int, std::string> map = {{1, "a"}, {2, "b"}, {3, "c"}};
+  auto values = transformed_view(
+      filtered_view(map, [](const Entry& entry) { return entry.first > 1; }),
+      [](const Entry& entry) -> const std::string& { return entry.second; });
+  EXPECT_THAT(values, ElementsAre("b", "c"));
+  EXPECT_EQ(&map[2], &*values.begin());
+}
+
 }  // namespace
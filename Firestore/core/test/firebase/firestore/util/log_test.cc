@@ -56,6 +56,28 @@ TEST(Log, LogAllKinds) {
   LogMessage(kLogLevelError, "test va-args %s %c %d", "abc", ':', 123);
 }
 
+TEST(Log, IsLoggable) {
+  LogSetLevel(kLogLevelWarning);
+  EXPECT_FALSE(LogIsLoggable(kLogLevelDebug));
+  EXPECT_FALSE(LogIsLoggable(kLogLevelInfo));
+  EXPECT_TRUE(LogIsLoggable(kLogLevelWarning));
+  EXPECT_TRUE(LogIsLoggable(kLogLevelError));
+}
+
+TEST(Log, MacrosOnlyEvaluateArgumentsWhenLoggable) {
+  int evaluated = 0;
+  auto count = [&evaluated] { return ++evaluated; };
+
+  LogSetLevel(kLogLevelWarning);
+  LOG_DEBUG("test debug macro %d", count());
+  LOG_INFO("test info macro %d", count());
+  EXPECT_EQ(0, evaluated);
+
+  LOG_WARNING("test warning macro %d", count());
+  LOG_ERROR("test error macro %d", count());
+  EXPECT_EQ(2, evaluated);
+}
+
 }  //  namespace util
 }  //  namespace firestore
 }  //  namespace firebase
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2017 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/md5.h"
+
+#include <stdio.h>
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+std::string HexDigest(absl::string_view data) {
+  std::array<uint8_t, 16> digest = CalcMd5(data);
+  std::string result;
+  for (uint8_t byte : digest) {
+    char hex[3];
+    snprintf(hex, sizeof(hex), "%02x", byte);
+    result += hex;
+  }
+  return result;
+}
+
+}  // namespace
+
+// The test suite from RFC 1321.
+TEST(Md5Test, MatchesReferenceDigests) {
+  EXPECT_EQ("d41d8cd98f00b204e9800998ecf8427e", HexDigest(""));
+  EXPECT_EQ("0cc175b9c0f1b6a831c399e269772661", HexDigest("a"));
+  EXPECT_EQ("900150983cd24fb0d6963f7d28e17f72", HexDigest("abc"));
+  EXPECT_EQ("f96b697d7cb7938d525a2f31aaf161d0", HexDigest("message digest"));
+  EXPECT_EQ("c3fcd3d76192e4007dfb496cca67e13b",
+            HexDigest("abcdefghijklmnopqrstuvwxyz"));
+  EXPECT_EQ("d174ab98d277d9f5a5611c2c9f419d9f",
+            HexDigest("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+                      "0123456789"));
+  EXPECT_EQ("57edf4a22be3c955ac49da2e2107b67a",
+            HexDigest("1234567890123456789012345678901234567890"
+                      "1234567890123456789012345678901234567890"));
+}
+
+// Messages whose padding does or doesn't spill into a second block.
+TEST(Md5Test, HandlesBlockBoundaries) {
+  EXPECT_EQ("ef1772b6dff9a122358552954ad0df65",
+            HexDigest(std::string(55, 'a')));
+  EXPECT_EQ("3b0c8ac703f828b04c6c197006d17218",
+            HexDigest(std::string(56, 'a')));
+  EXPECT_EQ("014842d480b571495a4a0363793f7367",
+            HexDigest(std::string(64, 'a')));
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
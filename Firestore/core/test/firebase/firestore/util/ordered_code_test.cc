@@ -20,6 +20,7 @@
 #include <limits>
 
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
+#include "Firestore/core/test/firebase/firestore/testutil/allocation_counter.h"
 #include "gtest/gtest.h"
 
 namespace firebase {
@@ -217,6 +218,7 @@ static size_t FindSpecial(const std::string& x) {
   const char* p = x.data();
   const char* limit = p + x.size();
   const char* result = OrderedCode::TEST_SkipToNextSpecialByte(p, limit);
+  EXPECT_EQ(result, OrderedCode::TEST_SkipToNextSpecialBytePortable(p, limit));
   return static_cast<size_t>(result - p);
 }
 
@@ -306,6 +308,27 @@ TEST(OrderedCodeInt64, Ordering) {
   TestNumberOrdering<int64_t>();
 }
 
+TEST(OrderedCodeUint64, ReadDoesNotAllocate) {
+  std::string encoded;
+  OrderedCode::WriteNumIncreasing(&encoded, 0);
+  OrderedCode::WriteNumIncreasing(&encoded, 12345);
+  OrderedCode::WriteNumIncreasing(&encoded,
+                                  std::numeric_limits<uint64_t>::max());
+  OrderedCode::WriteSignedNumIncreasing(&encoded, -12345);
+
+  testutil::AllocationCounter counter;
+  absl::string_view src = encoded;
+  uint64_t value = 0;
+  int64_t signed_value = 0;
+  ASSERT_TRUE(OrderedCode::ReadNumIncreasing(&src, &value));
+  ASSERT_TRUE(OrderedCode::ReadNumIncreasing(&src, &value));
+  ASSERT_TRUE(OrderedCode::ReadNumIncreasing(&src, &value));
+  ASSERT_TRUE(OrderedCode::ReadSignedNumIncreasing(&src, &signed_value));
+  EXPECT_EQ(0u, counter.allocations());
+  EXPECT_EQ(std::numeric_limits<uint64_t>::max(), value);
+  EXPECT_EQ(-12345, signed_value);
+}
+
 // Returns the bitwise complement of s.
 static inline std::string StrNot(const std::string& s) {
   std::string result;
@@ -454,6 +477,59 @@ TEST(OrderedCodeString, EncodeDecode) {
   }
 }
 
+TEST(OrderedCodeString, ReadStringView) {
+  SecureRandom rnd;
+  for (int len = 0; len < 256; len++) {
+    const std::string a = RandomString(&rnd, len);
+    const std::string b = RandomString(&rnd, len % 64);
+    std::string out;
+    OrderedCode::WriteString(&out, a);
+    OrderedCode::WriteString(&out, b);
+
+    std::string buffer;
+    absl::string_view s = out;
+    absl::string_view a2;
+    ASSERT_TRUE(OrderedCode::ReadStringView(&s, &a2, &buffer));
+    EXPECT_EQ(a, a2);
+
+    // Reading without a result must consume the same bytes.
+    absl::string_view skipped = out;
+    ASSERT_TRUE(OrderedCode::ReadStringView(&skipped, nullptr, nullptr));
+    EXPECT_EQ(s, skipped);
+
+    bool escaped = a.find('\0') != std::string::npos ||
+                   a.find('\xff') != std::string::npos;
+    if (escaped) {
+      EXPECT_EQ(buffer.data(), a2.data());
+    } else {
+      EXPECT_EQ(out.data(), a2.data());
+      EXPECT_TRUE(buffer.empty());
+    }
+
+    // Later strings that need unescaping are appended to the buffer.
+    absl::string_view b2;
+    std::string previous = buffer;
+    ASSERT_TRUE(OrderedCode::ReadStringView(&s, &b2, &buffer));
+    EXPECT_EQ(b, b2);
+    EXPECT_TRUE(s.empty());
+    EXPECT_EQ(previous, buffer.substr(0, previous.size()));
+
+    // Proper prefixes of the encoding are rejected, leaving the buffer and
+    // source untouched.
+    std::string encoded_a;
+    OrderedCode::WriteString(&encoded_a, a);
+    for (size_t i = 0; i + 1 < encoded_a.size(); i++) {
+      absl::string_view prefix(encoded_a.data(), i);
+      std::string prefix_buffer = "x";
+      absl::string_view result;
+      EXPECT_FALSE(
+          OrderedCode::ReadStringView(&prefix, &result, &prefix_buffer));
+      EXPECT_EQ(i, prefix.size());
+      EXPECT_EQ("x", prefix_buffer);
+    }
+  }
+}
+
 // 'str' is a static C-style string that may contain '\0'
 #define STATIC_STR(str) absl::string_view((str), sizeof(str) - 1)
 
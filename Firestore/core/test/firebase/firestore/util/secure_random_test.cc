@@ -16,6 +16,9 @@
 
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
 
+#include <algorithm>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 using firebase::firestore::util::SecureRandom;
@@ -55,3 +58,39 @@ TEST(SecureRandomTest, OneIn) {
   EXPECT_LT(50, count) << count;
   EXPECT_GT(150, count) << count;
 }
+
+TEST(SecureRandomTest, Fill) {
+  SecureRandom rng;
+  uint8_t bytes[1000] = {};
+  rng.Fill(bytes, sizeof(bytes));
+
+  int count[4] = {0, 0, 0, 0};
+  for (uint8_t byte : bytes) {
+    count[byte / 64]++;
+  }
+  for (int i = 0; i < 4; i++) {
+    // Practically, each count should be close to 250.
+    EXPECT_LT(150, count[i]) << count[i];
+  }
+}
+
+TEST(SecureRandomTest, FillMixesBufferedAndDirectRequests) {
+  SecureRandom rng;
+  std::vector<uint8_t> small(3);
+  std::vector<uint8_t> large(1000);
+
+  // Interleave requests served from the buffer with ones that bypass it, and
+  // check that every request is filled completely.
+  for (int i = 0; i < 100; i++) {
+    std::fill(small.begin(), small.end(), 0);
+    rng.Fill(small.data(), small.size());
+    rng();
+    rng.Fill(large.data(), large.size());
+  }
+  int zeros = 0;
+  for (uint8_t byte : large) {
+    if (byte == 0) zeros++;
+  }
+  // Practically, zeros should be close to 4.
+  EXPECT_GT(40, zeros) << zeros;
+}
@@ -73,6 +73,45 @@ TEST(StringPrintf, LargeBuf) {
   delete[] buf;
 }
 
+TEST(StringAppendFTest, LargeBufIntoSpareCapacity) {
+  // Check that formatting directly into a string with enough room is handled
+  // correctly.
+  std::string large(2048, ' ');
+  std::string value("Hello");
+  value.reserve(4096);
+  StringAppendF(&value, "%s!", large.c_str());
+  EXPECT_EQ("Hello" + large + "!", value);
+}
+
+TEST(StringAppendFWithHintTest, Empty) {
+  std::string value("Hello");
+  StringAppendFWithHint(&value, 0, "%s", "");
+  EXPECT_EQ("Hello", value);
+}
+
+TEST(StringAppendFWithHintTest, HintTooSmall) {
+  std::string large(2048, 'a');
+  std::string value("Hello");
+  StringAppendFWithHint(&value, 1, " %s", large.c_str());
+  EXPECT_EQ("Hello " + large, value);
+}
+
+TEST(StringAppendFWithHintTest, ExactHint) {
+  std::string value("Hello");
+  StringAppendFWithHint(&value, 6, " %s", "World");
+  EXPECT_EQ("Hello World", value);
+}
+
+TEST(StringAppendFWithHintTest, ReservesGeometrically) {
+  std::string value;
+  for (int i = 0; i < 1000; i++) {
+    StringAppendFWithHint(&value, 4, "%04d", i);
+  }
+  EXPECT_EQ(4000u, value.size());
+  EXPECT_EQ("0000", value.substr(0, 4));
+  EXPECT_EQ("0999", value.substr(3996));
+}
+
 }  //  namespace util
 }  //  namespace firestore
 }  //  namespace firebase
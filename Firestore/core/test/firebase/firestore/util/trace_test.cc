@@ -0,0 +1,120 @@
+/*
+ * Copyright 2017 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
+
+#include <stdio.h>
+
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+TEST(TraceBufferTest, RecordsEventsInOrder) {
+  TraceBuffer buffer{8};
+  buffer.Record(kTraceListen, 2);
+  buffer.Record(kTraceUnlisten, 2);
+  buffer.Record(kTraceStreamMessage, kTraceStreamWatch, 100, 7);
+
+  std::vector<TraceRecord> records = buffer.Snapshot();
+  ASSERT_EQ(3u, records.size());
+  EXPECT_EQ(kTraceListen, records[0].event);
+  EXPECT_EQ(2, records[0].args[0]);
+  EXPECT_EQ(0, records[0].args[1]);
+  EXPECT_EQ(kTraceUnlisten, records[1].event);
+  EXPECT_EQ(kTraceStreamMessage, records[2].event);
+  EXPECT_EQ(kTraceStreamWatch, records[2].args[0]);
+  EXPECT_EQ(100, records[2].args[1]);
+  EXPECT_EQ(7, records[2].args[2]);
+  EXPECT_LE(records[0].timestamp_micros, records[2].timestamp_micros);
+}
+
+TEST(TraceBufferTest, KeepsMostRecentRecords) {
+  TraceBuffer buffer{4};
+  for (int64_t i = 0; i < 10; i++) {
+    buffer.Record(kTraceListen, i);
+  }
+
+  std::vector<TraceRecord> records = buffer.Snapshot();
+  ASSERT_EQ(4u, records.size());
+  for (int64_t i = 0; i < 4; i++) {
+    EXPECT_EQ(6 + i, records[i].args[0]);
+  }
+}
+
+TEST(TraceBufferTest, RecordsFromManyThreads) {
+  TraceBuffer buffer{1000};
+  std::vector<std::thread> threads;
+  for (int64_t t = 0; t < 4; t++) {
+    threads.emplace_back([&buffer, t] {
+      for (int64_t i = 0; i < 250; i++) {
+        buffer.Record(kTraceListen, t, i);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  std::vector<TraceRecord> records = buffer.Snapshot();
+  ASSERT_EQ(1000u, records.size());
+  int64_t last_index[4] = {-1, -1, -1, -1};
+  for (const TraceRecord& record : records) {
+    // Each thread's records appear in the order it recorded them.
+    int64_t thread = record.args[0];
+    EXPECT_LT(last_index[thread], record.args[1]);
+    last_index[thread] = record.args[1];
+  }
+}
+
+TEST(TraceBufferTest, WritesRecordsToFile) {
+  TraceBuffer buffer{8};
+  buffer.Record(kTraceListen, 1);
+  buffer.Record(kTraceUnlisten, 1);
+
+  FILE* file = tmpfile();
+  ASSERT_NE(nullptr, file);
+  EXPECT_TRUE(buffer.WriteTo(file));
+
+  rewind(file);
+  TraceRecord records[3];
+  EXPECT_EQ(2u, fread(records, sizeof(TraceRecord), 3, file));
+  EXPECT_EQ(kTraceListen, records[0].event);
+  EXPECT_EQ(kTraceUnlisten, records[1].event);
+  fclose(file);
+}
+
+TEST(TraceTest, RecordsOnlyWhenBufferSet) {
+  TraceBuffer buffer{8};
+  Trace(kTraceListen, 1);
+
+  SetTraceBuffer(&buffer);
+  Trace(kTraceListen, 2);
+  SetTraceBuffer(nullptr);
+  Trace(kTraceListen, 3);
+
+  std::vector<TraceRecord> records = buffer.Snapshot();
+  ASSERT_EQ(1u, records.size());
+  EXPECT_EQ(2, records[0].args[0]);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
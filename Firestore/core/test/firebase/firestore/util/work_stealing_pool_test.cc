@@ -0,0 +1,93 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/work_stealing_pool.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <functional>
+#include <future>  // NOLINT(build/c++11)
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+TEST(WorkStealingPoolTest, DefaultsToOneThreadPerHardwareThread) {
+  WorkStealingPool pool;
+  EXPECT_LE(1u, pool.thread_count());
+}
+
+TEST(WorkStealingPoolTest, RunsAllTasks) {
+  std::atomic<int> count{0};
+  {
+    WorkStealingPool pool{4};
+    for (int i = 0; i < 1000; ++i) {
+      pool.Submit([&count] { count += 1; });
+    }
+    // Destroying the pool runs the remaining tasks.
+  }
+  EXPECT_EQ(1000, count);
+}
+
+TEST(WorkStealingPoolTest, TasksCanSubmitTasks) {
+  std::atomic<int> count{0};
+  std::promise<void> done;
+  WorkStealingPool* pool = nullptr;
+
+  // A tree of tasks: each of the first levels fans out to two children.
+  std::function<void(int)> spawn = [&](int depth) {
+    if (depth < 9) {
+      pool->Submit([&spawn, depth] { spawn(depth + 1); });
+      pool->Submit([&spawn, depth] { spawn(depth + 1); });
+    }
+    if (count.fetch_add(1) + 1 == (1 << 10) - 1) {
+      done.set_value();
+    }
+  };
+
+  {
+    WorkStealingPool tasks_pool{3};
+    pool = &tasks_pool;
+    pool->Submit([&spawn] { spawn(0); });
+    EXPECT_EQ(std::future_status::ready,
+              done.get_future().wait_for(std::chrono::seconds(5)));
+  }
+  EXPECT_EQ((1 << 10) - 1, count);
+}
+
+TEST(WorkStealingPoolTest, IdleThreadsStealWork) {
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::promise<void> stolen;
+  WorkStealingPool pool{2};
+
+  // The first task blocks its thread and submits a second task to its own
+  // deque, so only the other thread can run the second one.
+  pool.Submit([&] {
+    pool.Submit([&stolen] { stolen.set_value(); });
+    released.wait();
+  });
+
+  EXPECT_EQ(std::future_status::ready,
+            stolen.get_future().wait_for(std::chrono::seconds(5)));
+  release.set_value();
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -1,8 +1,7 @@
 #import "Firestore/third_party/Immutable/FSTImmutableSortedDictionary.h"
 
-#import "Firestore/third_party/Immutable/FSTArraySortedDictionary.h"
 #import "Firestore/Source/Util/FSTClasses.h"
-#import "Firestore/third_party/Immutable/FSTTreeSortedDictionary.h"
+#import "Firestore/third_party/Immutable/FSTSortedMapDictionary.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -11,16 +10,12 @@ const int kSortedDictionaryArrayToRBTreeSizeThreshold = 25;
 @implementation FSTImmutableSortedDictionary
 
 + (FSTImmutableSortedDictionary *)dictionaryWithComparator:(NSComparator)comparator {
-  return [[FSTArraySortedDictionary alloc] initWithComparator:comparator];
+  return [[FSTSortedMapDictionary alloc] initWithComparator:comparator];
 }
 
 + (FSTImmutableSortedDictionary *)dictionaryWithDictionary:(NSDictionary *)dictionary
                                                 comparator:(NSComparator)comparator {
-  if (dictionary.count <= kSortedDictionaryArrayToRBTreeSizeThreshold) {
-    return [FSTArraySortedDictionary dictionaryWithDictionary:dictionary comparator:comparator];
-  } else {
-    return [FSTTreeSortedDictionary dictionaryWithDictionary:dictionary comparator:comparator];
-  }
+  return [FSTSortedMapDictionary dictionaryWithDictionary:dictionary comparator:comparator];
 }
 
 - (FSTImmutableSortedDictionary *)dictionaryBySettingObject:(id)aValue forKey:(id)aKey {
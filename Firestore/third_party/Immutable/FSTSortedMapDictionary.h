@@ -0,0 +1,32 @@
+#import <Foundation/Foundation.h>
+
+#import "Firestore/third_party/Immutable/FSTImmutableSortedDictionary.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * FSTSortedMapDictionary is an implementation of FSTImmutableSortedDictionary backed by the C++
+ * immutable::SortedMap, which keeps small dictionaries in a single shared array and larger ones in
+ * a left-leaning red-black tree of plain C++ nodes.
+ *
+ * You should not use this class directly. You should use FSTImmutableSortedDictionary.
+ *
+ * Unlike FSTArraySortedDictionary and FSTTreeSortedDictionary, setting or removing a key allocates
+ * one array or O(log n) tree nodes without creating an Objective-C object for each of them, and
+ * lookups don't send a message per node visited.
+ */
+@interface FSTSortedMapDictionary <KeyType, ValueType> :
+    FSTImmutableSortedDictionary<KeyType, ValueType>
+
++ (FSTSortedMapDictionary<KeyType, ValueType> *)
+    dictionaryWithDictionary:(NSDictionary<KeyType, ValueType> *)dictionary
+                  comparator:(NSComparator)comparator;
+
+- (id)init __attribute__((unavailable("Use initWithComparator: instead.")));
+
+/** Initializes an empty dictionary ordered by the given comparator. */
+- (instancetype)initWithComparator:(NSComparator)comparator;
+
+@end
+
+NS_ASSUME_NONNULL_END
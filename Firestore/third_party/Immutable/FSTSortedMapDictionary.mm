@@ -0,0 +1,266 @@
+#import "Firestore/third_party/Immutable/FSTSortedMapDictionary.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+
+namespace {
+
+/** Adapts an NSComparator to the less-than comparator the C++ immutable collections expect. */
+struct BlockComparator {
+  bool operator()(id lhs, id rhs) const {
+    return comparator(lhs, rhs) == NSOrderedAscending;
+  }
+
+  NSComparator comparator;
+};
+
+using ObjCSortedMap = firebase::firestore::immutable::SortedMap<id, id, BlockComparator>;
+
+/**
+ * A map and a position within it. The iterators point into the map (rather than the one the
+ * cursor was created from, which may go away first), so cursors are only ever held by pointer.
+ */
+template <typename Iterator>
+struct Cursor {
+  Cursor(const Cursor &) = delete;
+  Cursor &operator=(const Cursor &) = delete;
+
+  template <typename Begin>
+  Cursor(const ObjCSortedMap &source, Begin begin_fn, Iterator (ObjCSortedMap::*end_fn)() const)
+      : map(source), current(begin_fn(map)), end((map.*end_fn)()) {
+  }
+
+  ObjCSortedMap map;
+  Iterator current;
+  Iterator end;
+};
+
+using ForwardCursor = Cursor<ObjCSortedMap::const_iterator>;
+using ReverseCursor = Cursor<ObjCSortedMap::const_reverse_iterator>;
+
+}  // namespace
+
+NS_ASSUME_NONNULL_BEGIN
+
+#pragma mark - FSTSortedMapKeyEnumerator
+
+/** Enumerates the keys of an FSTSortedMapDictionary in ascending order, up to an optional key. */
+@interface FSTSortedMapKeyEnumerator : NSEnumerator
+
+- (instancetype)initWithCursor:(std::unique_ptr<ForwardCursor>)cursor
+                        endKey:(nullable id)endKey NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+@implementation FSTSortedMapKeyEnumerator {
+  std::unique_ptr<ForwardCursor> _cursor;
+
+  /** If set, the enumerator stops before the first key not less than this one. */
+  id _Nullable _endKey;
+}
+
+- (instancetype)initWithCursor:(std::unique_ptr<ForwardCursor>)cursor endKey:(nullable id)endKey {
+  if (self = [super init]) {
+    _cursor = std::move(cursor);
+    _endKey = endKey;
+  }
+  return self;
+}
+
+- (nullable id)nextObject {
+  ForwardCursor &cursor = *_cursor;
+  if (cursor.current == cursor.end) {
+    return nil;
+  }
+  id key = cursor.current->first;
+  if (_endKey && !cursor.map.comparator()(key, _endKey)) {
+    cursor.current = cursor.end;
+    return nil;
+  }
+  ++cursor.current;
+  return key;
+}
+
+@end
+
+#pragma mark - FSTSortedMapReverseKeyEnumerator
+
+/** Enumerates the keys of an FSTSortedMapDictionary in descending order. */
+@interface FSTSortedMapReverseKeyEnumerator : NSEnumerator
+
+- (instancetype)initWithCursor:(std::unique_ptr<ReverseCursor>)cursor NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+@implementation FSTSortedMapReverseKeyEnumerator {
+  std::unique_ptr<ReverseCursor> _cursor;
+}
+
+- (instancetype)initWithCursor:(std::unique_ptr<ReverseCursor>)cursor {
+  if (self = [super init]) {
+    _cursor = std::move(cursor);
+  }
+  return self;
+}
+
+- (nullable id)nextObject {
+  ReverseCursor &cursor = *_cursor;
+  if (cursor.current == cursor.end) {
+    return nil;
+  }
+  id key = cursor.current->first;
+  ++cursor.current;
+  return key;
+}
+
+@end
+
+#pragma mark - FSTSortedMapDictionary
+
+@interface FSTSortedMapDictionary ()
+
+- (instancetype)initWithMap:(ObjCSortedMap)map NS_DESIGNATED_INITIALIZER;
+
+@end
+
+@implementation FSTSortedMapDictionary {
+  ObjCSortedMap _map;
+}
+
++ (FSTSortedMapDictionary *)dictionaryWithDictionary:(NSDictionary *)dictionary
+                                          comparator:(NSComparator)comparator {
+  BlockComparator less{[comparator copy]};
+
+  // Sort the entries once and build the map directly, rather than inserting them one at a time.
+  std::vector<std::pair<id, id>> entries;
+  entries.reserve(dictionary.count);
+  [dictionary enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+    entries.emplace_back(key, obj);
+  }];
+  std::sort(entries.begin(), entries.end(),
+            [&less](const std::pair<id, id> &lhs, const std::pair<id, id> &rhs) {
+              return less(lhs.first, rhs.first);
+            });
+
+  return [[FSTSortedMapDictionary alloc]
+      initWithMap:ObjCSortedMap::CreateFromSorted(entries.begin(), entries.end(), less)];
+}
+
+- (instancetype)initWithComparator:(NSComparator)comparator {
+  return [self initWithMap:ObjCSortedMap{BlockComparator{[comparator copy]}}];
+}
+
+- (instancetype)initWithMap:(ObjCSortedMap)map {
+  if (self = [super init]) {
+    _map = std::move(map);
+  }
+  return self;
+}
+
+- (FSTImmutableSortedDictionary *)dictionaryBySettingObject:(id)aValue forKey:(id)aKey {
+  return [[FSTSortedMapDictionary alloc] initWithMap:_map.insert(aKey, aValue)];
+}
+
+- (FSTImmutableSortedDictionary *)dictionaryByRemovingObjectForKey:(id)aKey {
+  if (_map.find(aKey) == _map.end()) {
+    return self;
+  }
+  return [[FSTSortedMapDictionary alloc] initWithMap:_map.erase(aKey)];
+}
+
+- (nullable id)objectForKey:(id)key {
+  auto found = _map.find(key);
+  return found != _map.end() ? found->second : nil;
+}
+
+- (NSUInteger)indexOfKey:(id)key {
+  ObjCSortedMap::size_type index = _map.find_index(key);
+  return index != ObjCSortedMap::npos ? index : NSNotFound;
+}
+
+- (BOOL)isEmpty {
+  return _map.empty();
+}
+
+- (NSUInteger)count {
+  return _map.size();
+}
+
+- (id)minKey {
+  return _map.empty() ? nil : _map.begin()->first;
+}
+
+- (id)maxKey {
+  return _map.empty() ? nil : _map.rbegin()->first;
+}
+
+- (void)enumerateKeysAndObjectsUsingBlock:(void (^)(id, id, BOOL *))block {
+  [self enumerateKeysAndObjectsReverse:NO usingBlock:block];
+}
+
+- (void)enumerateKeysAndObjectsReverse:(BOOL)reverse usingBlock:(void (^)(id, id, BOOL *))block {
+  BOOL stop = NO;
+  if (reverse) {
+    for (auto iter = _map.rbegin(); !stop && iter != _map.rend(); ++iter) {
+      block(iter->first, iter->second, &stop);
+    }
+  } else {
+    for (auto iter = _map.begin(); !stop && iter != _map.end(); ++iter) {
+      block(iter->first, iter->second, &stop);
+    }
+  }
+}
+
+- (BOOL)containsKey:(id)key {
+  return _map.find(key) != _map.end();
+}
+
+- (NSEnumerator *)keyEnumerator {
+  return [self enumeratorFrom:nil to:nil];
+}
+
+- (NSEnumerator *)keyEnumeratorFrom:(id)startKey {
+  return [self enumeratorFrom:startKey to:nil];
+}
+
+- (NSEnumerator *)keyEnumeratorFrom:(id)startKey to:(nullable id)endKey {
+  return [self enumeratorFrom:startKey to:endKey];
+}
+
+/** Enumerates the keys in [startKey, endKey), where a nil key means no bound on that side. */
+- (NSEnumerator *)enumeratorFrom:(nullable id)startKey to:(nullable id)endKey {
+  auto begin = [startKey](const ObjCSortedMap &map) {
+    return startKey ? map.lower_bound(startKey) : map.begin();
+  };
+  std::unique_ptr<ForwardCursor> cursor{new ForwardCursor(_map, begin, &ObjCSortedMap::end)};
+  return [[FSTSortedMapKeyEnumerator alloc] initWithCursor:std::move(cursor) endKey:endKey];
+}
+
+- (NSEnumerator *)reverseKeyEnumerator {
+  return [self reverseEnumeratorFrom:nil];
+}
+
+- (NSEnumerator *)reverseKeyEnumeratorFrom:(id)startKey {
+  return [self reverseEnumeratorFrom:startKey];
+}
+
+/** Enumerates the keys not greater than startKey in descending order, or all keys if it's nil. */
+- (NSEnumerator *)reverseEnumeratorFrom:(nullable id)startKey {
+  auto begin = [startKey](const ObjCSortedMap &map) {
+    return startKey ? map.reverse_upper_bound(startKey) : map.rbegin();
+  };
+  std::unique_ptr<ReverseCursor> cursor{new ReverseCursor(_map, begin, &ObjCSortedMap::rend)};
+  return [[FSTSortedMapReverseKeyEnumerator alloc] initWithCursor:std::move(cursor)];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
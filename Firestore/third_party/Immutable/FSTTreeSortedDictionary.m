@@ -18,12 +18,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (FSTTreeSortedDictionary *)dictionaryWithDictionary:(NSDictionary *)dictionary
                                            comparator:(NSComparator)comparator {
-  __block FSTTreeSortedDictionary *dict =
-      [[FSTTreeSortedDictionary alloc] initWithComparator:comparator];
-  [dictionary enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
-    dict = [dict dictionaryBySettingObject:obj forKey:key];
-  }];
-  return dict;
+  // Sort the keys once and build the balanced tree directly, rather than inserting (and
+  // rebalancing) one entry at a time.
+  return (FSTTreeSortedDictionary *)[self fromDictionary:dictionary withComparator:comparator];
 }
 
 - (id)initWithComparator:(NSComparator)aComparator {
@@ -191,7 +188,12 @@ typedef struct {
 } Base12List;
 
 unsigned int LogBase2(unsigned int num) {
-  return (unsigned int)(log(num) / log(2));
+  // Count the bits directly: log(num) / log(2) can round down for exact powers of two.
+  unsigned int result = 0;
+  while (num >>= 1) {
+    result++;
+  }
+  return result;
 }
 
 /**
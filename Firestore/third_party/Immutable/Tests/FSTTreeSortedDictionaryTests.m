@@ -3,6 +3,7 @@
 #import "Firestore/third_party/Immutable/FSTLLRBEmptyNode.h"
 #import "Firestore/third_party/Immutable/FSTLLRBNode.h"
 #import "Firestore/third_party/Immutable/FSTLLRBValueNode.h"
+#import "Firestore/third_party/Immutable/FSTSortedMapDictionary.h"
 #import "Firestore/third_party/Immutable/FSTTreeSortedDictionary.h"
 #import "Firestore/Source/Util/FSTAssert.h"
 
@@ -394,6 +395,36 @@
   XCTAssertEqual(map.count, 0, @"Check we removed all of the items");
 }
 
+- (void)testBuildsValidTreesFromDictionaries {
+  for (NSUInteger n = 0; n <= 130; n++) {
+    NSMutableDictionary *entries = [NSMutableDictionary dictionaryWithCapacity:n];
+    for (NSUInteger i = 0; i < n; i++) {
+      entries[@(i)] = @(i * 2);
+    }
+
+    FSTTreeSortedDictionary *map = (FSTTreeSortedDictionary *)[FSTTreeSortedDictionary
+        dictionaryWithDictionary:entries
+                      comparator:[self defaultComparator]];
+    XCTAssertEqual(map.count, n);
+    if (n > 0) {
+      XCTAssertTrue([(FSTLLRBValueNode *)map.root checkMaxDepth], @"Invalid tree for %lu",
+                    (unsigned long)n);
+    }
+
+    __block NSUInteger next = 0;
+    [map enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
+      XCTAssertEqualObjects(key, @(next));
+      XCTAssertEqualObjects(value, @(next * 2));
+      next++;
+    }];
+    XCTAssertEqual(next, n);
+
+    // The built tree must stay valid as it's modified.
+    map = [map dictionaryBySettingObject:@0 forKey:@(n)];
+    XCTAssertTrue([(FSTLLRBValueNode *)map.root checkMaxDepth]);
+  }
+}
+
 - (void)shuffleArray:(NSMutableArray *)array {
   NSUInteger count = array.count;
   for (NSUInteger i = 0; i < count; i++) {
@@ -633,4 +664,61 @@
   XCTAssertEqual([map indexOfKey:@50], 5);
 }
 
+- (void)testSortedMapDictionaryMatchesTreeDictionary {
+  NSUInteger n = 100;
+  NSMutableArray *toInsert = [NSMutableArray arrayWithCapacity:n];
+  NSMutableArray *toRemove = [NSMutableArray arrayWithCapacity:n / 2];
+  for (int i = 0; i < n; i++) {
+    [toInsert addObject:@(i * 2)];
+    if (i % 2 == 0) {
+      [toRemove addObject:@(i * 2)];
+    }
+  }
+  [self shuffleArray:toInsert];
+  [self shuffleArray:toRemove];
+
+  FSTImmutableSortedDictionary *tree =
+      [[FSTTreeSortedDictionary alloc] initWithComparator:[self defaultComparator]];
+  FSTImmutableSortedDictionary *map =
+      [FSTImmutableSortedDictionary dictionaryWithComparator:[self defaultComparator]];
+  XCTAssertTrue([map isKindOfClass:FSTSortedMapDictionary.class]);
+
+  // Insert enough entries to switch from an array to a tree, then remove half of them.
+  for (NSNumber *key in toInsert) {
+    tree = [tree dictionaryBySettingObject:key forKey:key];
+    map = [map dictionaryBySettingObject:key forKey:key];
+  }
+  for (NSNumber *key in toRemove) {
+    tree = [tree dictionaryByRemovingObjectForKey:key];
+    map = [map dictionaryByRemovingObjectForKey:key];
+  }
+  XCTAssertEqualObjects(map, tree);
+  XCTAssertEqual(map.count, n / 2);
+  XCTAssertEqualObjects(map.minKey, tree.minKey);
+  XCTAssertEqualObjects(map.maxKey, tree.maxKey);
+
+  for (int i = -1; i <= (int)n * 2; i++) {
+    XCTAssertEqualObjects(map[@(i)], tree[@(i)]);
+    XCTAssertEqual([map indexOfKey:@(i)], [tree indexOfKey:@(i)]);
+    XCTAssertEqualObjects([[map keyEnumeratorFrom:@(i)] allObjects],
+                          [[tree keyEnumeratorFrom:@(i)] allObjects]);
+    XCTAssertEqualObjects([[map keyEnumeratorFrom:@(i) to:@(i + 9)] allObjects],
+                          [[tree keyEnumeratorFrom:@(i) to:@(i + 9)] allObjects]);
+    XCTAssertEqualObjects([[map reverseKeyEnumeratorFrom:@(i)] allObjects],
+                          [[tree reverseKeyEnumeratorFrom:@(i)] allObjects]);
+  }
+  XCTAssertEqualObjects([[map reverseKeyEnumerator] allObjects],
+                        [[tree reverseKeyEnumerator] allObjects]);
+
+  // Building from a dictionary gives the same result as inserting one entry at a time.
+  NSMutableDictionary *entries = [NSMutableDictionary dictionary];
+  [tree enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
+    entries[key] = value;
+  }];
+  XCTAssertEqualObjects(
+      [FSTImmutableSortedDictionary dictionaryWithDictionary:entries
+                                                  comparator:[self defaultComparator]],
+      tree);
+}
+
 @end
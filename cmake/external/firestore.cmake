@@ -19,6 +19,7 @@ ExternalProject_Add(
   DEPENDS
     FirebaseCore
     googletest
+    benchmark
     leveldb
     grpc
 